@@ -28,12 +28,38 @@
 
 #ifdef HAVE_EXIF
 #include <libexif/exif-data.h>
+#include <libexif/exif-loader.h>
 #endif
 
 
 
-static void thunar_apr_image_page_file_changed  (ThunarAprAbstractPage    *abstract_page,
-                                                 ThunarxFileInfo          *file);
+/* the number of bytes read at most from the start of an image */
+#define THUNAR_APR_IMAGE_PAGE_HEADER_SIZE (256 * 1024)
+
+/* the number of probed images to remember */
+#define THUNAR_APR_IMAGE_PAGE_CACHE_SIZE (16)
+
+
+
+typedef struct _ThunarAprImageInfo  ThunarAprImageInfo;
+typedef struct _ThunarAprImageProbe ThunarAprImageProbe;
+
+
+
+static void                thunar_apr_image_page_dispose         (GObject                  *object);
+static void                thunar_apr_image_page_file_changed    (ThunarAprAbstractPage    *abstract_page,
+                                                                  ThunarxFileInfo          *file);
+static void                thunar_apr_image_page_apply           (ThunarAprImagePage       *image_page,
+                                                                  const ThunarAprImageInfo *info);
+static void                thunar_apr_image_page_probe_thread    (GTask                    *task,
+                                                                  gpointer                  source_object,
+                                                                  gpointer                  task_data,
+                                                                  GCancellable             *cancellable);
+static void                thunar_apr_image_page_probe_ready     (GObject                  *object,
+                                                                  GAsyncResult             *result,
+                                                                  gpointer                  user_data);
+static void                thunar_apr_image_page_probe_free      (gpointer                  data);
+static void                thunar_apr_image_info_free            (gpointer                  data);
 
 
 
@@ -77,8 +103,38 @@ struct _ThunarAprImagePage
 #ifdef HAVE_EXIF
   GtkWidget            *exif_labels[G_N_ELEMENTS (TAIP_EXIF)];
 #endif
+
+  /* the running probe of the image */
+  GCancellable         *cancellable;
+};
+
+/* the details of an image, determined in a worker thread */
+struct _ThunarAprImageInfo
+{
+  gchar    *type;
+  gint      width;
+  gint      height;
+  gboolean  prepared;
+#ifdef HAVE_EXIF
+  gchar    *exif[G_N_ELEMENTS (TAIP_EXIF)];
+#endif
 };
 
+struct _ThunarAprImageProbe
+{
+  GFile *file;
+  gchar *key;
+};
+
+
+
+/* the recently probed images (key -> ThunarAprImageInfo), their keys
+ * are the modification time and the URI, so changed files are probed
+ * again; the queue holds the keys in insertion order for expiration
+ */
+static GHashTable *image_info_cache;
+static GQueue      image_info_cache_keys = G_QUEUE_INIT;
+
 
 
 THUNARX_DEFINE_TYPE (ThunarAprImagePage,
@@ -91,6 +147,10 @@ static void
 thunar_apr_image_page_class_init (ThunarAprImagePageClass *klass)
 {
   ThunarAprAbstractPageClass *thunarapr_abstract_page_class;
+  GObjectClass               *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->dispose = thunar_apr_image_page_dispose;
 
   thunarapr_abstract_page_class = THUNAR_APR_ABSTRACT_PAGE_CLASS (klass);
   thunarapr_abstract_page_class->file_changed = thunar_apr_image_page_file_changed;
@@ -211,101 +271,331 @@ thunar_apr_image_page_init (ThunarAprImagePage *image_page)
 
 
 
+static void
+thunar_apr_image_page_dispose (GObject *object)
+{
+  ThunarAprImagePage *image_page = THUNAR_APR_IMAGE_PAGE (object);
+
+  /* stop probing the image */
+  if (image_page->cancellable != NULL)
+    {
+      g_cancellable_cancel (image_page->cancellable);
+      g_object_unref (image_page->cancellable);
+      image_page->cancellable = NULL;
+    }
+
+  (*G_OBJECT_CLASS (thunar_apr_image_page_parent_class)->dispose) (object);
+}
+
+
+
 static void
 thunar_apr_image_page_file_changed (ThunarAprAbstractPage *abstract_page,
                                     ThunarxFileInfo       *file)
 {
-  ThunarAprImagePage *image_page = THUNAR_APR_IMAGE_PAGE (abstract_page);
-  GdkPixbufFormat    *format;
-  gchar              *filename;
-  gchar              *text;
-  gchar              *uri;
-  gint                height;
-  gint                width;
-#ifdef HAVE_EXIF
-  ExifEntry          *exif_entry;
-  ExifData           *exif_data;
-  gchar               exif_buffer[1024];
-  guint               n;
-#endif
+  ThunarAprImagePage  *image_page = THUNAR_APR_IMAGE_PAGE (abstract_page);
+  ThunarAprImageProbe *probe;
+  ThunarAprImageInfo  *info;
+  GFileInfo           *file_info;
+  guint64              mtime = 0;
+  GTask               *task;
+  gchar               *key;
+  gchar               *uri;
+
+  /* cancel the probe of the previous state of the file */
+  if (image_page->cancellable != NULL)
+    {
+      g_cancellable_cancel (image_page->cancellable);
+      g_object_unref (image_page->cancellable);
+      image_page->cancellable = NULL;
+    }
 
   /* determine the URI for the file */
   uri = thunarx_file_info_get_uri (file);
   if (G_UNLIKELY (uri == NULL))
     return;
 
-  /* determine the local path of the file */
-  filename = g_filename_from_uri (uri, NULL, NULL);
-  if (G_LIKELY (filename != NULL))
+  /* determine the modification time of the file */
+  file_info = thunarx_file_info_get_file_info (file);
+  if (G_LIKELY (file_info != NULL))
     {
-      /* determine the pixbuf format */
-      format = gdk_pixbuf_get_file_info (filename, &width, &height);
-      if (G_LIKELY (format != NULL))
-        {
-          /* update the "Image Type" label */
-          text = g_strdup_printf ("%s (%s)", gdk_pixbuf_format_get_name (format), gdk_pixbuf_format_get_description (format));
-          gtk_label_set_text (GTK_LABEL (image_page->type_label), text);
-          g_free (text);
+      mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      g_object_unref (file_info);
+    }
+
+  /* check if we probed this version of the file already */
+  key = g_strdup_printf ("%" G_GUINT64_FORMAT " %s", mtime, uri);
+  info = (image_info_cache != NULL) ? g_hash_table_lookup (image_info_cache, key) : NULL;
+  if (G_LIKELY (info != NULL))
+    {
+      thunar_apr_image_page_apply (image_page, info);
+      g_free (key);
+      g_free (uri);
+      return;
+    }
+
+  /* probe the image in a thread, it may be large or on a slow share */
+  probe = g_slice_new (ThunarAprImageProbe);
+  probe->file = g_file_new_for_uri (uri);
+  probe->key = key;
+
+  image_page->cancellable = g_cancellable_new ();
+  task = g_task_new (image_page, image_page->cancellable, thunar_apr_image_page_probe_ready, NULL);
+  g_task_set_task_data (task, probe, thunar_apr_image_page_probe_free);
+  g_task_run_in_thread (task, thunar_apr_image_page_probe_thread);
+  g_object_unref (task);
+
+  /* cleanup */
+  g_free (uri);
+}
+
 
-          /* update the "Image Size" label */
-          text = g_strdup_printf (ngettext ("%dx%d pixel", "%dx%d pixels", width + height), width, height);
-          gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), text);
-          g_free (text);
 
+static void
+thunar_apr_image_page_apply (ThunarAprImagePage       *image_page,
+                             const ThunarAprImageInfo *info)
+{
+  gchar *text;
 #ifdef HAVE_EXIF
-          /* hide all Exif labels (will be shown again if data is available) */
-          for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
-            gtk_widget_hide (image_page->exif_labels[n]);
+  guint  n;
+
+  /* hide all Exif labels (will be shown again if data is available) */
+  for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+    gtk_widget_hide (image_page->exif_labels[n]);
+#endif
+
+  if (G_LIKELY (info != NULL && info->type != NULL))
+    {
+      /* update the "Image Type" label */
+      gtk_label_set_text (GTK_LABEL (image_page->type_label), info->type);
+
+      /* update the "Image Size" label */
+      text = g_strdup_printf (ngettext ("%dx%d pixel", "%dx%d pixels", info->width + info->height), info->width, info->height);
+      gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), text);
+      g_free (text);
+
+#ifdef HAVE_EXIF
+      /* update all Exif labels */
+      for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+        if (info->exif[n] != NULL)
+          {
+            gtk_label_set_text (GTK_LABEL (image_page->exif_labels[n]), info->exif[n]);
+            gtk_widget_show (image_page->exif_labels[n]);
+          }
+#endif
+    }
+  else
+    {
+      /* tell the user that we're unable to determine the file info */
+      gtk_label_set_text (GTK_LABEL (image_page->type_label), _("Unknown"));
+      gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), _("Unknown"));
+    }
+}
+
+
+
+static void
+thunar_apr_image_page_size_prepared (GdkPixbufLoader    *loader,
+                                     gint                width,
+                                     gint                height,
+                                     ThunarAprImageInfo *info)
+{
+  info->width = width;
+  info->height = height;
+  info->prepared = TRUE;
+}
+
 
-          /* try to load the Exif data for the file */
-          exif_data = exif_data_new_from_file (filename);
-          if (G_LIKELY (exif_data != NULL))
+
+static void
+thunar_apr_image_page_probe_thread (GTask        *task,
+                                    gpointer      source_object,
+                                    gpointer      task_data,
+                                    GCancellable *cancellable)
+{
+  ThunarAprImageProbe *probe = task_data;
+  ThunarAprImageInfo  *info;
+  GFileInputStream    *stream;
+  GdkPixbufFormat     *format;
+  GdkPixbufLoader     *loader;
+  gboolean             loader_done = FALSE;
+  GError              *error = NULL;
+  guchar               buffer[8192];
+  gchar               *description;
+  gchar               *name;
+  gssize               n_read;
+  gsize                n_total = 0;
+#ifdef HAVE_EXIF
+  ExifLoader          *exif_loader;
+  ExifEntry           *exif_entry;
+  ExifData            *exif_data;
+  gboolean             exif_done = FALSE;
+  gchar                exif_buffer[1024];
+  guint                n;
+#else
+  gboolean             exif_done = TRUE;
+#endif
+
+  stream = g_file_read (probe->file, cancellable, &error);
+  if (G_UNLIKELY (stream == NULL))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  info = g_slice_new0 (ThunarAprImageInfo);
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (G_OBJECT (loader), "size-prepared", G_CALLBACK (thunar_apr_image_page_size_prepared), info);
+#ifdef HAVE_EXIF
+  exif_loader = exif_loader_new ();
+#endif
+
+  /* feed the start of the file to the loaders, until both know enough */
+  while (n_total < THUNAR_APR_IMAGE_PAGE_HEADER_SIZE && !(loader_done && exif_done))
+    {
+      n_read = g_input_stream_read (G_INPUT_STREAM (stream), buffer, sizeof (buffer), cancellable, &error);
+      if (n_read <= 0)
+        break;
+      n_total += n_read;
+
+      if (!loader_done)
+        loader_done = !gdk_pixbuf_loader_write (loader, buffer, n_read, NULL) || info->prepared;
+
+#ifdef HAVE_EXIF
+      if (!exif_done)
+        exif_done = !exif_loader_write (exif_loader, buffer, n_read);
+#endif
+    }
+  g_object_unref (stream);
+
+  /* some formats only know their size once all data was seen */
+  gdk_pixbuf_loader_close (loader, NULL);
+
+  format = gdk_pixbuf_loader_get_format (loader);
+  if (G_LIKELY (format != NULL && info->prepared))
+    {
+      name = gdk_pixbuf_format_get_name (format);
+      description = gdk_pixbuf_format_get_description (format);
+      info->type = g_strdup_printf ("%s (%s)", name, description);
+      g_free (description);
+      g_free (name);
+
+#ifdef HAVE_EXIF
+      /* determine the Exif values */
+      exif_data = exif_loader_get_data (exif_loader);
+      if (G_LIKELY (exif_data != NULL))
+        {
+          for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
             {
-              /* update all Exif labels */
-              for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+              /* lookup the entry for the tag */
+              exif_entry = exif_data_get_entry (exif_data, TAIP_EXIF[n].tag);
+              if (G_LIKELY (exif_entry != NULL))
                 {
-                  /* lookup the entry for the tag */
-                  exif_entry = exif_data_get_entry (exif_data, TAIP_EXIF[n].tag);
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        {
-                          /* setup the label text */
-                          text = (g_utf8_validate (exif_buffer, -1, NULL)) ? g_strdup (exif_buffer) : g_filename_display_name (exif_buffer);
-                          gtk_label_set_text (GTK_LABEL (image_page->exif_labels[n]), text);
-                          g_free (text);
-
-                          /* show the label */
-                          gtk_widget_show (image_page->exif_labels[n]);
-                        }
-                    }
+                  /* determine the value */
+                  if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+                    info->exif[n] = (g_utf8_validate (exif_buffer, -1, NULL)) ? g_strdup (exif_buffer) : g_filename_display_name (exif_buffer);
                 }
-
-              /* cleanup */
-              exif_data_free (exif_data);
             }
-#endif
+
+          exif_data_unref (exif_data);
         }
-      else
-        {
-          /* tell the user that we're unable to determine the file info */
-          gtk_label_set_text (GTK_LABEL (image_page->type_label), _("Unknown"));
-          gtk_label_set_text (GTK_LABEL (image_page->dimensions_label), _("Unknown"));
+#endif
+    }
 
 #ifdef HAVE_EXIF
-          /* hide all Exif labels */
-          for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
-            gtk_widget_hide (image_page->exif_labels[n]);
+  exif_loader_unref (exif_loader);
 #endif
+  g_object_unref (loader);
+
+  if (G_UNLIKELY (error != NULL))
+    {
+      thunar_apr_image_info_free (info);
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_pointer (task, info, thunar_apr_image_info_free);
+}
+
+
+
+static void
+thunar_apr_image_page_probe_ready (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  ThunarAprImagePage  *image_page = THUNAR_APR_IMAGE_PAGE (object);
+  ThunarAprImageProbe *probe = g_task_get_task_data (G_TASK (result));
+  ThunarAprImageInfo  *cached;
+  ThunarAprImageInfo  *info;
+  GError              *error = NULL;
+  gchar               *key;
+
+  info = g_task_propagate_pointer (G_TASK (result), &error);
+  if (G_UNLIKELY (info == NULL))
+    {
+      /* nothing to do if a newer probe replaced this one or the page is gone */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_clear_object (&image_page->cancellable);
+          thunar_apr_image_page_apply (image_page, NULL);
         }
+      g_error_free (error);
+      return;
     }
 
-  /* cleanup */
-  g_free (filename);
-  g_free (uri);
+  g_clear_object (&image_page->cancellable);
+
+  if (G_UNLIKELY (image_info_cache == NULL))
+    image_info_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_apr_image_info_free);
+
+  /* another page may have probed the same image meanwhile */
+  cached = g_hash_table_lookup (image_info_cache, probe->key);
+  if (G_UNLIKELY (cached != NULL))
+    {
+      thunar_apr_image_info_free (info);
+      info = cached;
+    }
+  else
+    {
+      /* remember the image, forget the oldest one if the cache is full */
+      if (g_queue_get_length (&image_info_cache_keys) >= THUNAR_APR_IMAGE_PAGE_CACHE_SIZE)
+        g_hash_table_remove (image_info_cache, g_queue_pop_head (&image_info_cache_keys));
+
+      key = g_strdup (probe->key);
+      g_hash_table_insert (image_info_cache, key, info);
+      g_queue_push_tail (&image_info_cache_keys, key);
+    }
+
+  thunar_apr_image_page_apply (image_page, info);
 }
 
 
 
+static void
+thunar_apr_image_page_probe_free (gpointer data)
+{
+  ThunarAprImageProbe *probe = data;
 
+  g_object_unref (probe->file);
+  g_free (probe->key);
+  g_slice_free (ThunarAprImageProbe, probe);
+}
+
+
+
+static void
+thunar_apr_image_info_free (gpointer data)
+{
+  ThunarAprImageInfo *info = data;
+#ifdef HAVE_EXIF
+  guint               n;
+
+  for (n = 0; n < G_N_ELEMENTS (TAIP_EXIF); ++n)
+    g_free (info->exif[n]);
+#endif
+
+  g_free (info->type);
+  g_slice_free (ThunarAprImageInfo, info);
+}
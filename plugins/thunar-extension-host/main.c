@@ -0,0 +1,618 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#include <gtk/gtk.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunarx/thunarx.h>
+#include <thunar/thunar-extension-protocol.h>
+
+
+
+/* number of answered menus whose items can still be activated */
+#define THEH_MAX_MENUS (32)
+
+
+
+typedef struct _ThehFileClass ThehFileClass;
+typedef struct _ThehFile      ThehFile;
+
+#define THEH_TYPE_FILE (theh_file_get_type ())
+#define THEH_FILE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), THEH_TYPE_FILE, ThehFile))
+
+typedef struct
+{
+  guint32  header;
+  guint8  *body;
+  gsize    size;
+} ThehRead;
+
+
+
+static GType        theh_file_get_type            (void) G_GNUC_CONST;
+static void         theh_file_info_init           (ThunarxFileInfoIface *iface);
+static void         theh_file_finalize            (GObject              *object);
+static gchar       *theh_file_get_name            (ThunarxFileInfo      *file_info);
+static gchar       *theh_file_get_uri             (ThunarxFileInfo      *file_info);
+static gchar       *theh_file_get_parent_uri      (ThunarxFileInfo      *file_info);
+static gchar       *theh_file_get_uri_scheme      (ThunarxFileInfo      *file_info);
+static gchar       *theh_file_get_mime_type       (ThunarxFileInfo      *file_info);
+static gboolean     theh_file_has_mime_type       (ThunarxFileInfo      *file_info,
+                                                   const gchar          *mime_type);
+static gboolean     theh_file_is_directory        (ThunarxFileInfo      *file_info);
+static GFileInfo   *theh_file_get_file_info       (ThunarxFileInfo      *file_info);
+static GFileInfo   *theh_file_get_filesystem_info (ThunarxFileInfo      *file_info);
+static GFile       *theh_file_get_location        (ThunarxFileInfo      *file_info);
+static const gchar *theh_file_peek_name           (ThunarxFileInfo      *file_info);
+static const gchar *theh_file_peek_mime_type      (ThunarxFileInfo      *file_info);
+static void         theh_read_header              (void);
+
+
+
+struct _ThehFileClass
+{
+  GObjectClass __parent__;
+};
+
+/* snapshot of a file selected in Thunar, as sent with a menu request */
+struct _ThehFile
+{
+  GObject __parent__;
+
+  gchar   *uri;
+  gchar   *name;
+  gchar   *mime_type;
+  gboolean is_directory;
+  GFile   *location;
+};
+
+
+
+G_DEFINE_TYPE_WITH_CODE (ThehFile, theh_file, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE (THUNARX_TYPE_FILE_INFO, theh_file_info_init))
+
+
+
+static GInputStream  *theh_input;
+static GOutputStream *theh_output;
+static GtkWidget     *theh_window;           /* hidden parent for the menu providers */
+static GList         *theh_providers;        /* ThunarxMenuProviders of all modules */
+static GHashTable    *theh_items;            /* item id -> ThunarxMenuItem */
+static GQueue         theh_menus = G_QUEUE_INIT; /* GArrays of the item ids of each answered menu */
+static guint32        theh_next_item_id = 1;
+
+
+
+static void
+theh_file_class_init (ThehFileClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = theh_file_finalize;
+}
+
+
+
+static void
+theh_file_init (ThehFile *file)
+{
+}
+
+
+
+static void
+theh_file_info_init (ThunarxFileInfoIface *iface)
+{
+  iface->get_name = theh_file_get_name;
+  iface->get_uri = theh_file_get_uri;
+  iface->get_parent_uri = theh_file_get_parent_uri;
+  iface->get_uri_scheme = theh_file_get_uri_scheme;
+  iface->get_mime_type = theh_file_get_mime_type;
+  iface->has_mime_type = theh_file_has_mime_type;
+  iface->is_directory = theh_file_is_directory;
+  iface->get_file_info = theh_file_get_file_info;
+  iface->get_filesystem_info = theh_file_get_filesystem_info;
+  iface->get_location = theh_file_get_location;
+  iface->peek_name = theh_file_peek_name;
+  iface->peek_mime_type = theh_file_peek_mime_type;
+}
+
+
+
+static void
+theh_file_finalize (GObject *object)
+{
+  ThehFile *file = THEH_FILE (object);
+
+  g_free (file->uri);
+  g_free (file->name);
+  g_free (file->mime_type);
+  g_object_unref (file->location);
+
+  (*G_OBJECT_CLASS (theh_file_parent_class)->finalize) (object);
+}
+
+
+
+static gchar *
+theh_file_get_name (ThunarxFileInfo *file_info)
+{
+  return g_strdup (THEH_FILE (file_info)->name);
+}
+
+
+
+static gchar *
+theh_file_get_uri (ThunarxFileInfo *file_info)
+{
+  return g_strdup (THEH_FILE (file_info)->uri);
+}
+
+
+
+static gchar *
+theh_file_get_parent_uri (ThunarxFileInfo *file_info)
+{
+  GFile *parent;
+  gchar *uri = NULL;
+
+  parent = g_file_get_parent (THEH_FILE (file_info)->location);
+  if (G_LIKELY (parent != NULL))
+    {
+      uri = g_file_get_uri (parent);
+      g_object_unref (parent);
+    }
+
+  return uri;
+}
+
+
+
+static gchar *
+theh_file_get_uri_scheme (ThunarxFileInfo *file_info)
+{
+  return g_file_get_uri_scheme (THEH_FILE (file_info)->location);
+}
+
+
+
+static gchar *
+theh_file_get_mime_type (ThunarxFileInfo *file_info)
+{
+  return g_strdup (THEH_FILE (file_info)->mime_type);
+}
+
+
+
+static gboolean
+theh_file_has_mime_type (ThunarxFileInfo *file_info,
+                         const gchar     *mime_type)
+{
+  ThehFile *file = THEH_FILE (file_info);
+
+  if (*file->mime_type == '\0')
+    return FALSE;
+
+  return g_content_type_is_a (file->mime_type, mime_type);
+}
+
+
+
+static gboolean
+theh_file_is_directory (ThunarxFileInfo *file_info)
+{
+  return THEH_FILE (file_info)->is_directory;
+}
+
+
+
+static GFileInfo *
+theh_file_get_file_info (ThunarxFileInfo *file_info)
+{
+  /* only the extensions that ask for it pay for the query */
+  return g_file_query_info (THEH_FILE (file_info)->location, THUNARX_FILE_INFO_NAMESPACE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+}
+
+
+
+static GFileInfo *
+theh_file_get_filesystem_info (ThunarxFileInfo *file_info)
+{
+  return g_file_query_filesystem_info (THEH_FILE (file_info)->location,
+                                       THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                       NULL, NULL);
+}
+
+
+
+static GFile *
+theh_file_get_location (ThunarxFileInfo *file_info)
+{
+  return g_object_ref (THEH_FILE (file_info)->location);
+}
+
+
+
+static const gchar *
+theh_file_peek_name (ThunarxFileInfo *file_info)
+{
+  return THEH_FILE (file_info)->name;
+}
+
+
+
+static const gchar *
+theh_file_peek_mime_type (ThunarxFileInfo *file_info)
+{
+  ThehFile *file = THEH_FILE (file_info);
+
+  return (*file->mime_type != '\0') ? file->mime_type : NULL;
+}
+
+
+
+static gint
+theh_take_fd (gint         fd,
+              const gchar *replacement)
+{
+  gint protocol_fd;
+  gint replacement_fd;
+
+  /* move the protocol pipe to a private descriptor that is neither
+   * inherited by processes the extensions spawn, nor written to by
+   * extensions printing to stdout */
+  protocol_fd = fcntl (fd, F_DUPFD_CLOEXEC, 3);
+  if (G_UNLIKELY (protocol_fd < 0))
+    return -1;
+
+  if (replacement != NULL)
+    {
+      replacement_fd = open (replacement, O_RDONLY);
+      if (G_LIKELY (replacement_fd >= 0))
+        {
+          dup2 (replacement_fd, fd);
+          close (replacement_fd);
+        }
+    }
+  else
+    {
+      dup2 (STDERR_FILENO, fd);
+    }
+
+  return protocol_fd;
+}
+
+
+
+static void
+theh_load_module (ThunarxProviderFactory *factory,
+                  const gchar            *name)
+{
+  /* the module stays loaded for the lifetime of the host */
+  theh_providers = g_list_concat (theh_providers,
+                                  thunarx_provider_factory_load_module (factory, name, THUNARX_TYPE_MENU_PROVIDER));
+}
+
+
+
+static GVariant *
+theh_serialize_item (ThunarxMenuItem *item,
+                     GArray          *ids)
+{
+  GVariantBuilder builder;
+  ThunarxMenu    *menu;
+  GVariant       *variant;
+  gboolean        sensitive;
+  gboolean        priority;
+  guint32         id;
+  GList          *children;
+  GList          *lp;
+  gchar          *name, *label, *tooltip, *icon;
+
+  g_object_get (G_OBJECT (item),
+                "name", &name,
+                "label", &label,
+                "tooltip", &tooltip,
+                "icon", &icon,
+                "sensitive", &sensitive,
+                "priority", &priority,
+                "menu", &menu,
+                NULL);
+
+  /* remember the item, so Thunar can activate it later */
+  id = theh_next_item_id++;
+  g_hash_table_insert (theh_items, GUINT_TO_POINTER (id), g_object_ref (item));
+  g_array_append_val (ids, id);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+  if (menu != NULL)
+    {
+      children = thunarx_menu_get_items (menu);
+      for (lp = children; lp != NULL; lp = lp->next)
+        g_variant_builder_add (&builder, "v", theh_serialize_item (lp->data, ids));
+      thunarx_menu_item_list_free (children);
+      g_object_unref (menu);
+    }
+
+  variant = g_variant_new (THUNAR_EXTENSION_PROTOCOL_ITEM, id,
+                           name != NULL ? name : "",
+                           label != NULL ? label : "",
+                           tooltip != NULL ? tooltip : "",
+                           icon != NULL ? icon : "",
+                           sensitive, priority, &builder);
+
+  g_free (name);
+  g_free (label);
+  g_free (tooltip);
+  g_free (icon);
+
+  return variant;
+}
+
+
+
+static GVariant *
+theh_handle_menu (GVariant *arguments)
+{
+  GVariantBuilder builder;
+  GVariantIter    iter;
+  ThehFile       *file;
+  const gchar    *uri, *name, *mime_type;
+  gboolean        is_directory;
+  GArray         *ids;
+  GList          *files = NULL;
+  GList          *items;
+  GList          *lp;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_ITEMS));
+
+  if (!g_variant_is_of_type (arguments, G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_FILES)))
+    return g_variant_builder_end (&builder);
+
+  g_variant_iter_init (&iter, arguments);
+  while (g_variant_iter_next (&iter, "(&s&s&sb)", &uri, &name, &mime_type, &is_directory))
+    {
+      file = g_object_new (THEH_TYPE_FILE, NULL);
+      file->uri = g_strdup (uri);
+      file->name = g_strdup (name);
+      file->mime_type = g_strdup (mime_type);
+      file->is_directory = is_directory;
+      file->location = g_file_new_for_uri (uri);
+      files = g_list_prepend (files, file);
+    }
+  files = g_list_reverse (files);
+
+  if (files != NULL)
+    {
+      ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+      for (lp = theh_providers; lp != NULL; lp = lp->next)
+        {
+          items = thunarx_menu_provider_get_file_menu_items (lp->data, theh_window, files);
+          for (; items != NULL; items = g_list_delete_link (items, items))
+            {
+              g_variant_builder_add_value (&builder, theh_serialize_item (items->data, ids));
+              g_object_unref (items->data);
+            }
+        }
+
+      /* forget the items of the oldest menu */
+      g_queue_push_tail (&theh_menus, ids);
+      while (g_queue_get_length (&theh_menus) > THEH_MAX_MENUS)
+        {
+          ids = g_queue_pop_head (&theh_menus);
+          for (guint n = 0; n < ids->len; ++n)
+            g_hash_table_remove (theh_items, GUINT_TO_POINTER (g_array_index (ids, guint32, n)));
+          g_array_free (ids, TRUE);
+        }
+    }
+
+  g_list_free_full (files, g_object_unref);
+
+  return g_variant_builder_end (&builder);
+}
+
+
+
+static void
+theh_handle_request (GVariant *request)
+{
+  ThunarxMenuItem *item;
+  const gchar     *command;
+  GVariant        *arguments;
+  GVariant        *result;
+  GVariant        *reply;
+  GError          *error = NULL;
+  guint32          serial;
+  guint32          size;
+
+  g_variant_get (request, "(u&sv)", &serial, &command, &arguments);
+
+  if (g_strcmp0 (command, THUNAR_EXTENSION_PROTOCOL_MENU) == 0)
+    {
+      result = theh_handle_menu (arguments);
+
+      reply = g_variant_ref_sink (g_variant_new (THUNAR_EXTENSION_PROTOCOL_REPLY, serial, result));
+      size = GUINT32_TO_LE (g_variant_get_size (reply));
+      if (!g_output_stream_write_all (theh_output, &size, sizeof (size), NULL, NULL, &error)
+          || !g_output_stream_write_all (theh_output, g_variant_get_data (reply), g_variant_get_size (reply), NULL, NULL, &error))
+        {
+          /* Thunar went away */
+          g_error_free (error);
+          gtk_main_quit ();
+        }
+      g_variant_unref (reply);
+    }
+  else if (g_strcmp0 (command, THUNAR_EXTENSION_PROTOCOL_ACTIVATE) == 0
+           && g_variant_is_of_type (arguments, G_VARIANT_TYPE_UINT32))
+    {
+      item = g_hash_table_lookup (theh_items, GUINT_TO_POINTER (g_variant_get_uint32 (arguments)));
+      if (G_LIKELY (item != NULL))
+        thunarx_menu_item_activate (item);
+    }
+
+  g_variant_unref (arguments);
+}
+
+
+
+static void
+theh_read_body_ready (GObject      *object,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  ThehRead *read = user_data;
+  GVariant *request;
+  gsize     bytes_read;
+
+  if (!g_input_stream_read_all_finish (G_INPUT_STREAM (object), result, &bytes_read, NULL)
+      || bytes_read != read->size)
+    {
+      g_free (read->body);
+      g_free (read);
+      gtk_main_quit ();
+      return;
+    }
+
+  request = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_REQUEST),
+                                                         read->body, read->size, FALSE, g_free, read->body));
+  g_free (read);
+
+  theh_handle_request (request);
+  g_variant_unref (request);
+
+  theh_read_header ();
+}
+
+
+
+static void
+theh_read_header_ready (GObject      *object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  ThehRead *read = user_data;
+  gsize     bytes_read;
+
+  if (!g_input_stream_read_all_finish (G_INPUT_STREAM (object), result, &bytes_read, NULL)
+      || bytes_read != sizeof (read->header)
+      || GUINT32_FROM_LE (read->header) > THUNAR_EXTENSION_PROTOCOL_MAX_SIZE)
+    {
+      /* Thunar closed our standard input */
+      g_free (read);
+      gtk_main_quit ();
+      return;
+    }
+
+  read->size = GUINT32_FROM_LE (read->header);
+  read->body = g_malloc (read->size);
+  g_input_stream_read_all_async (theh_input, read->body, read->size, G_PRIORITY_DEFAULT,
+                                 NULL, theh_read_body_ready, read);
+}
+
+
+
+static void
+theh_read_header (void)
+{
+  ThehRead *read;
+
+  read = g_new0 (ThehRead, 1);
+  g_input_stream_read_all_async (theh_input, &read->header, sizeof (read->header), G_PRIORITY_DEFAULT,
+                                 NULL, theh_read_header_ready, read);
+}
+
+
+
+int
+main (int argc, char **argv)
+{
+  ThunarxProviderFactory *factory;
+  gint                    input_fd;
+  gint                    output_fd;
+  gint                    n;
+
+  /* take the protocol pipes before any extension code runs */
+  input_fd = theh_take_fd (STDIN_FILENO, "/dev/null");
+  output_fd = theh_take_fd (STDOUT_FILENO, NULL);
+  if (G_UNLIKELY (input_fd < 0 || output_fd < 0))
+    {
+      g_printerr ("thunar-extension-host: Failed to set up the protocol pipes\n");
+      return EXIT_FAILURE;
+    }
+
+  /* setup translation domain */
+  xfce_textdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
+
+  /* the extensions may open dialogs when their items are activated */
+  if (!gtk_init_check (&argc, &argv))
+    {
+      g_printerr ("thunar-extension-host: Failed to open display\n");
+      return EXIT_FAILURE;
+    }
+
+  factory = thunarx_provider_factory_get_default ();
+  for (n = 1; n < argc; ++n)
+    theh_load_module (factory, argv[n]);
+  g_object_unref (factory);
+
+  if (G_UNLIKELY (theh_providers == NULL))
+    {
+      g_printerr ("thunar-extension-host: No menu providers found\n");
+      return EXIT_FAILURE;
+    }
+
+  theh_window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  theh_items = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
+
+  theh_input = g_unix_input_stream_new (input_fd, TRUE);
+  theh_output = g_unix_output_stream_new (output_fd, TRUE);
+
+  theh_read_header ();
+  gtk_main ();
+
+  g_object_unref (theh_input);
+  g_object_unref (theh_output);
+
+  return EXIT_SUCCESS;
+}
@@ -264,6 +264,7 @@ thunar_sbr_case_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_CASE_RENAMER,
                        "name", _("Uppercase / Lowercase"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
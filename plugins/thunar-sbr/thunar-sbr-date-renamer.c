@@ -356,7 +356,7 @@ static gchar *
 thunar_sbr_get_time_string (guint64      file_time,
                             const gchar *format)
 {
-  struct tm *tm;
+  struct tm  tm;
   time_t     _time;
   gchar     *converted;
   gchar      buffer[1024];
@@ -364,14 +364,14 @@ thunar_sbr_get_time_string (guint64      file_time,
 
   _time = (time_t) file_time;
 
-  /* determine the local file time */
-  tm = localtime (&_time);
+  /* determine the local file time (reentrant, the renamer is thread-safe) */
+  localtime_r (&_time, &tm);
 
   /* conver the format to the current locale */
   converted = g_locale_from_utf8 (format, -1, NULL, NULL, NULL);
 
   /* parse the format */
-  length = strftime (buffer, sizeof (buffer), converted, tm);
+  length = strftime (buffer, sizeof (buffer), converted, &tm);
 
   /* cleanup */
   g_free (converted);
@@ -591,6 +591,7 @@ thunar_sbr_date_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_DATE_RENAMER,
                        "name", _("Insert Date / Time"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
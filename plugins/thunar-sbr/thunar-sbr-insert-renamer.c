@@ -384,6 +384,7 @@ thunar_sbr_insert_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_INSERT_RENAMER,
                        "name", _("Insert / Overwrite"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
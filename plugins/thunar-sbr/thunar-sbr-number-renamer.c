@@ -516,6 +516,7 @@ thunar_sbr_number_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_NUMBER_RENAMER,
                        "name", _("Numbering"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
@@ -411,6 +411,7 @@ thunar_sbr_remove_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_REMOVE_RENAMER,
                        "name", _("Remove Characters"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
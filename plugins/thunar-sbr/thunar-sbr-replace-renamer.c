@@ -40,6 +40,14 @@
 
 
 
+#ifdef HAVE_PCRE2
+/* initial and maximum size of the JIT stacks */
+#define TSRR_JIT_STACK_START (32 * 1024)
+#define TSRR_JIT_STACK_MAX   (512 * 1024)
+#endif
+
+
+
 /* Property identifiers */
 enum
 {
@@ -70,6 +78,20 @@ static gchar *thunar_sbr_replace_renamer_process      (ThunarxRenamer
 static gchar *thunar_sbr_replace_renamer_pcre_exec    (ThunarSbrReplaceRenamer      *replace_renamer,
                                                        const gchar                  *text);
 static void   thunar_sbr_replace_renamer_pcre_update  (ThunarSbrReplaceRenamer      *replace_renamer);
+static void   thunar_sbr_replace_renamer_pcre_clear   (ThunarSbrReplaceRenamer      *replace_renamer);
+#endif
+
+
+
+#ifdef HAVE_PCRE2
+/* per-call matching state, kept around so each thread running
+ * the renamer reuses its match data and JIT stack */
+typedef struct
+{
+  pcre2_match_data    *match_data;
+  pcre2_match_context *match_context;
+  pcre2_jit_stack     *jit_stack;
+} TsrrScratch;
 #endif
 
 
@@ -95,6 +117,10 @@ struct _ThunarSbrReplaceRenamer
 #ifdef HAVE_PCRE2
   pcre2_code    *pcre_pattern;
   gint           pcre_capture_count;
+
+  /* unused scratches for the pattern */
+  GMutex         pcre_scratch_lock;
+  GSList        *pcre_scratch;
 #endif
 };
 
@@ -192,6 +218,8 @@ thunar_sbr_replace_renamer_init (ThunarSbrReplaceRenamer *replace_renamer)
   replace_renamer->utf8_regexp_supported = FALSE;
 
 #ifdef HAVE_PCRE2
+  g_mutex_init (&replace_renamer->pcre_scratch_lock);
+
   /* check if PCRE supports UTF-8 */
   if (pcre2_config (PCRE2_CONFIG_COMPILED_WIDTHS, &pcre2_compiled_widths) >= 0)
   {
@@ -275,8 +303,8 @@ thunar_sbr_replace_renamer_finalize (GObject *object)
 
   /* release the PCRE pattern (if any) */
 #ifdef HAVE_PCRE2
-  if (G_UNLIKELY (replace_renamer->pcre_pattern != NULL))
-    pcre2_code_free (replace_renamer->pcre_pattern);
+  thunar_sbr_replace_renamer_pcre_clear (replace_renamer);
+  g_mutex_clear (&replace_renamer->pcre_scratch_lock);
 #endif
 
   /* release the strings */
@@ -450,59 +478,112 @@ thunar_sbr_replace_renamer_process (ThunarxRenamer  *renamer,
 
 
 #ifdef HAVE_PCRE2
+static void
+tsrr_scratch_free (gpointer data)
+{
+  TsrrScratch *scratch = data;
+
+  pcre2_match_data_free (scratch->match_data);
+  pcre2_match_context_free (scratch->match_context);
+  pcre2_jit_stack_free (scratch->jit_stack);
+  g_slice_free (TsrrScratch, scratch);
+}
+
+
+
 static gchar*
 thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
                                       const gchar             *subject)
 {
-  GString     *result;
-  int          error;
-  PCRE2_SIZE   erroffset;
+  TsrrScratch *scratch;
   gchar        output[1024];
-  pcre2_code  *compiled_pattern;
+  gchar       *buffer = output;
+  gchar       *result;
   PCRE2_SIZE   outlen;
   int          n_substitutions;  /* number of substitutions that were carried out */
 
-  result = g_string_sized_new (32);
+  /* grab an unused scratch, or set up one for this thread */
+  g_mutex_lock (&replace_renamer->pcre_scratch_lock);
+  scratch = (replace_renamer->pcre_scratch != NULL) ? replace_renamer->pcre_scratch->data : NULL;
+  replace_renamer->pcre_scratch = g_slist_delete_link (replace_renamer->pcre_scratch, replace_renamer->pcre_scratch);
+  g_mutex_unlock (&replace_renamer->pcre_scratch_lock);
+  if (G_UNLIKELY (scratch == NULL))
+    {
+      scratch = g_slice_new (TsrrScratch);
+      scratch->match_data = pcre2_match_data_create_from_pattern (replace_renamer->pcre_pattern, NULL);
+      scratch->match_context = pcre2_match_context_create (NULL);
+      scratch->jit_stack = pcre2_jit_stack_create (TSRR_JIT_STACK_START, TSRR_JIT_STACK_MAX, NULL);
+      pcre2_jit_stack_assign (scratch->match_context, NULL, scratch->jit_stack);
+    }
 
-  compiled_pattern = pcre2_compile_8 ((PCRE2_SPTR)replace_renamer->pattern,
-                                      PCRE2_ZERO_TERMINATED,
-                                      0,
-                                      &error,
-                                      &erroffset,
-                                      0);
-  if (compiled_pattern == NULL)
-    return g_strdup (subject);
-
-  pcre2_jit_compile (compiled_pattern, PCRE2_JIT_COMPLETE);
-
-  outlen = sizeof (output) / sizeof(PCRE2_UCHAR);
-  
-  n_substitutions = pcre2_substitute (compiled_pattern,
-                                      (PCRE2_SPTR)subject,
+  /* file names are valid UTF-8 already, so skip the check; if the
+   * result does not fit, PCRE2 tells us the size it needs */
+  outlen = sizeof (output);
+  n_substitutions = pcre2_substitute (replace_renamer->pcre_pattern,
+                                      (PCRE2_SPTR) subject,
                                       PCRE2_ZERO_TERMINATED,
                                       0,
-                                      PCRE2_SUBSTITUTE_GLOBAL | PCRE2_SUBSTITUTE_EXTENDED,
-                                      0,
-                                      0,
-                                      (PCRE2_SPTR)replace_renamer->replacement,
+                                      PCRE2_SUBSTITUTE_GLOBAL | PCRE2_SUBSTITUTE_EXTENDED
+                                      | PCRE2_SUBSTITUTE_OVERFLOW_LENGTH | PCRE2_NO_UTF_CHECK,
+                                      scratch->match_data,
+                                      scratch->match_context,
+                                      (PCRE2_SPTR) replace_renamer->replacement,
                                       PCRE2_ZERO_TERMINATED,
-                                      (PCRE2_UCHAR *)output,
+                                      (PCRE2_UCHAR *) buffer,
                                       &outlen);
+  if (G_UNLIKELY (n_substitutions == PCRE2_ERROR_NOMEMORY))
+    {
+      buffer = g_malloc (outlen);
+      n_substitutions = pcre2_substitute (replace_renamer->pcre_pattern,
+                                          (PCRE2_SPTR) subject,
+                                          PCRE2_ZERO_TERMINATED,
+                                          0,
+                                          PCRE2_SUBSTITUTE_GLOBAL | PCRE2_SUBSTITUTE_EXTENDED | PCRE2_NO_UTF_CHECK,
+                                          scratch->match_data,
+                                          scratch->match_context,
+                                          (PCRE2_SPTR) replace_renamer->replacement,
+                                          PCRE2_ZERO_TERMINATED,
+                                          (PCRE2_UCHAR *) buffer,
+                                          &outlen);
+    }
+
+  /* give the scratch back for the next call */
+  g_mutex_lock (&replace_renamer->pcre_scratch_lock);
+  replace_renamer->pcre_scratch = g_slist_prepend (replace_renamer->pcre_scratch, scratch);
+  g_mutex_unlock (&replace_renamer->pcre_scratch_lock);
 
   if (n_substitutions < 0)
     {
-      PCRE2_UCHAR buffer[256];
-      pcre2_get_error_message (error, buffer, sizeof(buffer));
-      g_warning ("PCRE2 substitution failed at offset %d: %s\n", (int)erroffset, buffer);
-      return g_strdup (subject);
+      PCRE2_UCHAR message[256];
+      pcre2_get_error_message (n_substitutions, message, sizeof (message));
+      g_warning ("PCRE2 substitution failed: %s\n", message);
+      result = g_strdup (subject);
+    }
+  else
+    {
+      result = g_strndup (buffer, outlen);
     }
 
-  pcre2_code_free (compiled_pattern);
+  if (buffer != output)
+    g_free (buffer);
 
-  for (size_t i = 0; i < outlen; i++)
-    g_string_append_c (result, output[i]);
+  return result;
+}
 
-  return g_string_free (result, FALSE);
+
+
+static void
+thunar_sbr_replace_renamer_pcre_clear (ThunarSbrReplaceRenamer *replace_renamer)
+{
+  /* the scratches are sized for the current pattern */
+  g_slist_free_full (replace_renamer->pcre_scratch, tsrr_scratch_free);
+  replace_renamer->pcre_scratch = NULL;
+
+  if (replace_renamer->pcre_pattern != NULL)
+    {
+      pcre2_code_free (replace_renamer->pcre_pattern);
+      replace_renamer->pcre_pattern = NULL;
+    }
 }
 
 
@@ -522,11 +603,12 @@ thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer
   if (G_UNLIKELY (replace_renamer->regexp))
     {
       /* release the previous pattern (if any) */
-      if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
-        pcre2_code_free (replace_renamer->pcre_pattern);
+      thunar_sbr_replace_renamer_pcre_clear (replace_renamer);
 
-      /* try to compile the new pattern */
-      replace_renamer->pcre_pattern = pcre2_compile ((PCRE2_SPTR)replace_renamer->pattern, PCRE2_ZERO_TERMINATED, 0, &error, &erroffset, 0);
+      /* try to compile the new pattern, once for all files */
+      replace_renamer->pcre_pattern = pcre2_compile ((PCRE2_SPTR) replace_renamer->pattern, PCRE2_ZERO_TERMINATED,
+                                                     PCRE2_UTF | (replace_renamer->case_sensitive ? 0 : PCRE2_CASELESS),
+                                                     &error, &erroffset, NULL);
 
       if (replace_renamer->pcre_pattern == NULL)
         {
@@ -534,6 +616,11 @@ thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer
           pcre2_get_error_message (error, buffer, sizeof(buffer));
           g_warning ("PCRE2 compilation failed at offset %d: %s\n", (int)erroffset, buffer);
         }
+      else
+        {
+          /* the JIT is optional, matching falls back to the interpreter */
+          pcre2_jit_compile (replace_renamer->pcre_pattern, PCRE2_JIT_COMPLETE);
+        }
     }
 
   /* check if there was an error compiling the pattern */
@@ -589,6 +676,7 @@ thunar_sbr_replace_renamer_new (void)
 {
   return g_object_new (THUNAR_SBR_TYPE_REPLACE_RENAMER,
                        "name", _("Search & Replace"),
+                       "thread-safe", TRUE,
                        NULL);
 }
 
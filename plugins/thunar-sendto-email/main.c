@@ -25,9 +25,6 @@
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
-#ifdef HAVE_SYS_WAIT_H
-#include <sys/wait.h>
-#endif
 
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
@@ -35,9 +32,6 @@
 #ifdef HAVE_MEMORY_H
 #include <memory.h>
 #endif
-#ifdef HAVE_SIGNAL_H
-#include <signal.h>
-#endif
 #ifdef HAVE_STDARG_H
 #include <stdarg.h>
 #endif
@@ -64,9 +58,12 @@
 
 #include <libxfce4util/libxfce4util.h>
 
+#include <thunar-sendto-email/tse-zip.h>
 
 
-typedef struct _TseData TseData;
+
+typedef struct _TseData     TseData;
+typedef struct _TseProgress TseProgress;
 
 struct _TseData
 {
@@ -74,6 +71,14 @@ struct _TseData
   GFile     *file;
 };
 
+struct _TseProgress
+{
+  TseZipProgress zip;
+  GList         *files;
+  const gchar   *zipfile;
+  GtkWidget     *bar;
+};
+
 
 
 /* well known archive types */
@@ -260,46 +265,65 @@ tse_ask_compress (GList *infos)
 
 
 static void
-tse_child_watch (GPid     pid,
-                 gint     status,
-                 gpointer user_data)
+tse_progress_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  TseProgress *progress = task_data;
+  GError      *error = NULL;
+
+  if (tse_zip_write (progress->files, progress->zipfile, &progress->zip, cancellable, &error))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+}
+
+
+
+static void
+tse_progress_ready (GObject      *source_object,
+                    GAsyncResult *result,
+                    gpointer      user_data)
 {
-  g_object_set_data (G_OBJECT (user_data), I_("tse-child-status"), GINT_TO_POINTER (status));
   gtk_dialog_response (GTK_DIALOG (user_data), GTK_RESPONSE_YES);
 }
 
 
 
 static gboolean
-tse_progress_cb(gpointer user_data)
+tse_progress_cb (gpointer user_data)
 {
-  GtkWidget *pulse = user_data;
+  TseProgress *progress = user_data;
+  gdouble      fraction = 0.0;
+
+  g_mutex_lock (&progress->zip.mutex);
+  if (progress->zip.total_size > 0)
+    fraction = (gdouble) progress->zip.completed_size / progress->zip.total_size;
+  g_mutex_unlock (&progress->zip.mutex);
 
-  gtk_progress_bar_pulse(GTK_PROGRESS_BAR(pulse));
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (progress->bar), CLAMP (fraction, 0.0, 1.0));
   return TRUE;
 }
 
+
+
 static gboolean
-tse_progress (const gchar *working_directory,
-              gchar      **argv,
+tse_progress (GList       *files,
+              const gchar *zipfile,
               GError     **error)
 {
-  GtkWidget *progress;
-  GtkWidget *dialog;
-  GtkWidget *image;
-  GtkWidget *label;
-  GtkWidget *hbox;
-  GtkWidget *vbox;
-  gboolean   succeed = FALSE;
-  GPid       pid;
-  guint      pulse_timer_id;
-  gint       watch_id;
-  gint       response;
-  gint       status;
-
-  /* try to run the command */
-  if (!g_spawn_async (working_directory, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH, NULL, NULL, &pid, error))
-    return FALSE;
+  GCancellable *cancellable;
+  TseProgress   progress;
+  GtkWidget    *dialog;
+  GtkWidget    *image;
+  GtkWidget    *label;
+  GtkWidget    *hbox;
+  GtkWidget    *vbox;
+  gboolean      succeed;
+  GError       *err = NULL;
+  GTask        *task;
+  guint         progress_timer_id;
 
   /* allocate the progress dialog */
   dialog = gtk_dialog_new_with_buttons (_("Compressing files..."),
@@ -334,43 +358,51 @@ tse_progress (const gchar *working_directory,
   gtk_widget_show (label);
 
   /* setup the progress bar */
-  progress = gtk_progress_bar_new ();
-  gtk_box_pack_start (GTK_BOX (vbox), progress, FALSE, FALSE, 0);
-  gtk_widget_show (progress);
+  progress.bar = gtk_progress_bar_new ();
+  gtk_box_pack_start (GTK_BOX (vbox), progress.bar, FALSE, FALSE, 0);
+  gtk_widget_show (progress.bar);
 
-  /* start the child watch */
-  watch_id = g_child_watch_add (pid, tse_child_watch, dialog);
+  /* write the archive in a thread, the dialog stays responsive */
+  progress.files = files;
+  progress.zipfile = zipfile;
+  progress.zip.total_size = 0;
+  progress.zip.completed_size = 0;
+  g_mutex_init (&progress.zip.mutex);
 
-  /* start the pulse timer */
-  pulse_timer_id = g_timeout_add (125, tse_progress_cb, progress);
+  cancellable = g_cancellable_new ();
+  task = g_task_new (NULL, cancellable, tse_progress_ready, dialog);
+  g_task_set_task_data (task, &progress, NULL);
+  g_task_run_in_thread (task, tse_progress_thread);
+
+  /* start the progress timer */
+  progress_timer_id = g_timeout_add (125, tse_progress_cb, &progress);
 
   /* run the dialog */
-  response = gtk_dialog_run (GTK_DIALOG (dialog));
-  if (response == GTK_RESPONSE_YES)
+  if (gtk_dialog_run (GTK_DIALOG (dialog)) != GTK_RESPONSE_YES)
     {
-      /* check if the command failed */
-      status = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (dialog), I_("tse-child-status")));
-      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
-        {
-          /* tell the user that the command failed */
-          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, _("ZIP command terminated with error %d"), status);
-        }
-      else
-        {
-          /* the command succeed */
-          succeed = TRUE;
-        }
-    }
-  else
-    {
-      /* terminate the ZIP command */
-      kill (pid, SIGQUIT);
+      /* stop the thread and wait for it to release the files */
+      g_cancellable_cancel (cancellable);
+      while (!g_task_get_completed (task))
+        g_main_context_iteration (NULL, TRUE);
     }
 
   /* cleanup */
-  g_source_remove (pulse_timer_id);
+  g_source_remove (progress_timer_id);
   gtk_widget_destroy (dialog);
-  g_source_remove (watch_id);
+
+  /* a cancelled archive is no error to tell the user about */
+  succeed = g_task_propagate_boolean (task, &err);
+  if (G_UNLIKELY (err != NULL))
+    {
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_error_free (err);
+      else
+        g_propagate_error (error, err);
+    }
+
+  g_object_unref (cancellable);
+  g_object_unref (task);
+  g_mutex_clear (&progress.zip.mutex);
 
   return succeed;
 }
@@ -421,19 +453,17 @@ tse_compress (GList  *infos,
               gchar **zipfile_return)
 {
   TseData       *tse_data;
-  gboolean       succeed = TRUE;
+  gboolean       succeed;
   GError        *error = NULL;
   GFile         *parent;
   GFile         *parent_parent;
-  gchar        **argv;
   gchar         *base_name;
   gchar         *zipfile;
-  gchar         *tmppath;
   gchar         *tmpdir;
   gchar         *path;
   gchar         *dot;
+  GList         *files = NULL;
   GList         *lp;
-  gint           n;
 
   /* create a temporary directory */
   tmpdir = g_strdup ("/tmp/thunar-sendto-email.XXXXXX");
@@ -488,78 +518,39 @@ tse_compress (GList  *infos,
       g_object_unref (parent);
     }
 
-  /* generate the argument list for the ZIP command */
-  argv = g_new0 (gchar *, g_list_length (infos) + 5);
-  argv[0] = g_strdup ("zip");
-  argv[1] = g_strdup ("-q");
-  argv[2] = g_strdup ("-r");
-  argv[3] = g_strdup (zipfile);
-  for (lp = infos, n = 4; lp != NULL && succeed; lp = lp->next, ++n)
-    {
-      /* create a symlink for the file to the tmp dir */
-      tse_data = (TseData *) lp->data;
-      path = g_file_get_path (tse_data->file);
+  /* the files are read in place, no need to link them into the tmp dir */
+  for (lp = infos; lp != NULL; lp = lp->next)
+    files = g_list_prepend (files, ((TseData *) lp->data)->file);
+  files = g_list_reverse (files);
 
-      if (path == NULL)
+  /* try to write the ZIP file */
+  succeed = tse_progress (files, zipfile, &error);
+  if (G_UNLIKELY (!succeed))
+    {
+      /* check if we failed or the user cancelled */
+      if (G_LIKELY (error != NULL))
         {
-          error = g_error_new_literal (G_FILE_ERROR, g_file_error_from_errno (ENOTSUP), g_strerror (errno));
-          tse_error (error, _("Failed to create symbolic link for \"%s\""), g_file_info_get_display_name (tse_data->info));
+          /* tell the user that we failed to compress the file(s) */
+          tse_error (error, ngettext ("Failed to compress %d file",
+                                      "Failed to compress %d files",
+                                      g_list_length (infos)),
+                     g_list_length (infos));
           g_error_free (error);
         }
-      else
-        {
-          tmppath = g_build_filename (tmpdir, g_file_get_basename (tse_data->file), NULL);
-          succeed = (symlink (path, tmppath) == 0);
-          if (G_UNLIKELY (!succeed))
-            {
-              /* tell the user that we failed to create a symlink for this file */
-              error = g_error_new_literal (G_FILE_ERROR, g_file_error_from_errno (errno), g_strerror (errno));
-              tse_error (error, _("Failed to create symbolic link for \"%s\""), g_file_info_get_display_name (tse_data->info));
-              g_error_free (error);
-            }
-          else
-            {
-              /* add the file to the ZIP command line */
-              argv[n] = g_path_get_basename (tmppath);
-            }
-          g_free (tmppath);
-          g_free (path);
-        }
-    }
 
-  /* check if we succeed up to this point */
-  if (G_LIKELY (succeed))
+      /* delete the temporary directory, the archive is already removed */
+      g_unlink (zipfile);
+      g_rmdir (tmpdir);
+    }
+  else
     {
-      /* try to run the ZIP command */
-      succeed = tse_progress (tmpdir, argv, &error);
-      if (G_UNLIKELY (!succeed))
-        {
-          /* check if we failed or the user cancelled */
-          if (G_LIKELY (error != NULL))
-            {
-              /* tell the user that we failed to compress the file(s) */
-              tse_error (error, ngettext ("Failed to compress %d file",
-                                          "Failed to compress %d files",
-                                          g_list_length (infos)),
-                         g_list_length (infos));
-              g_error_free (error);
-            }
-
-          /* delete the temporary directory */
-          dot = g_strdup_printf ("rm -rf '%s'", tmpdir);
-          g_spawn_command_line_sync (dot, NULL, NULL, NULL, NULL);
-          g_free (dot);
-        }
-      else
-        {
-          /* return the path to the compressed file */
-          *zipfile_return = zipfile;
-          zipfile = NULL;
-        }
+      /* return the path to the compressed file */
+      *zipfile_return = zipfile;
+      zipfile = NULL;
     }
 
   /* cleanup */
-  g_strfreev (argv);
+  g_list_free (files);
   g_free (zipfile);
   g_free (tmpdir);
 
@@ -0,0 +1,642 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gi18n-lib.h>
+
+#include <thunar-sendto-email/tse-zip.h>
+
+
+
+/* size of the blocks read from the files, and of the compressed output */
+#define TSE_ZIP_BUFFER_SIZE (64 * 1024)
+
+/* the fields of a ZIP archive are at most 32 bits wide without ZIP64 */
+#define TSE_ZIP_MAX_SIZE G_GUINT64_CONSTANT (0xffffffff)
+
+/* general purpose flags: sizes follow the data, names are UTF-8 */
+#define TSE_ZIP_FLAG_DATA_DESCRIPTOR (1 << 3)
+#define TSE_ZIP_FLAG_UTF8            (1 << 11)
+
+#define TSE_ZIP_METHOD_STORE   0
+#define TSE_ZIP_METHOD_DEFLATE 8
+
+/* "made by" unix (for the file modes) and the version needed for deflate */
+#define TSE_ZIP_VERSION_MADE_BY ((3 << 8) | 20)
+#define TSE_ZIP_VERSION_NEEDED  20
+
+#define TSE_ZIP_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                           G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+                           G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                           G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                           G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+                           G_FILE_ATTRIBUTE_UNIX_MODE
+
+
+
+typedef struct
+{
+  gchar   *name;
+  guint16  flags;
+  guint16  method;
+  guint16  time;
+  guint16  date;
+  guint32  crc;
+  guint64  compressed_size;
+  guint64  size;
+  guint64  offset;
+  guint32  mode;
+} TseZipEntry;
+
+typedef struct
+{
+  GOutputStream  *stream;
+  guint64         offset;
+  GPtrArray      *entries;
+  TseZipProgress *progress;
+  GCancellable   *cancellable;
+  guchar         *input;
+  guchar         *output;
+} TseZipWriter;
+
+
+
+static guint32 tse_zip_crc_table[256];
+
+
+
+static void
+tse_zip_crc_init (void)
+{
+  static gsize initialized = 0;
+  guint32      crc;
+  guint        n, k;
+
+  if (g_once_init_enter (&initialized))
+    {
+      /* the CRC-32 of ZIP, with the reversed polynomial */
+      for (n = 0; n < 256; ++n)
+        {
+          for (crc = n, k = 0; k < 8; ++k)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : (crc >> 1);
+          tse_zip_crc_table[n] = crc;
+        }
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+
+
+static guint32
+tse_zip_crc_update (guint32       crc,
+                    const guchar *data,
+                    gsize         length)
+{
+  crc = ~crc;
+  while (length-- > 0)
+    crc = tse_zip_crc_table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+
+
+static void
+tse_zip_entry_free (gpointer data)
+{
+  TseZipEntry *entry = data;
+
+  g_free (entry->name);
+  g_slice_free (TseZipEntry, entry);
+}
+
+
+
+static void
+tse_zip_put16 (GByteArray *array,
+               guint16     value)
+{
+  guint8 bytes[2] = { value & 0xff, value >> 8 };
+
+  g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+
+
+static void
+tse_zip_put32 (GByteArray *array,
+               guint32     value)
+{
+  guint8 bytes[4] = { value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24 };
+
+  g_byte_array_append (array, bytes, sizeof (bytes));
+}
+
+
+
+static gboolean
+tse_zip_write_bytes (TseZipWriter  *writer,
+                     gconstpointer  data,
+                     gsize          length,
+                     GError       **error)
+{
+  if (!g_output_stream_write_all (writer->stream, data, length, NULL, writer->cancellable, error))
+    return FALSE;
+
+  writer->offset += length;
+  return TRUE;
+}
+
+
+
+static gboolean
+tse_zip_write_array (TseZipWriter  *writer,
+                     GByteArray    *array,
+                     GError       **error)
+{
+  gboolean succeed;
+
+  succeed = tse_zip_write_bytes (writer, array->data, array->len, error);
+  g_byte_array_free (array, TRUE);
+
+  return succeed;
+}
+
+
+
+static gboolean
+tse_zip_check_size (guint64   size,
+                    GError  **error)
+{
+  if (G_LIKELY (size <= TSE_ZIP_MAX_SIZE))
+    return TRUE;
+
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, _("The files are too large for a ZIP archive"));
+  return FALSE;
+}
+
+
+
+static void
+tse_zip_progress_add (TseZipWriter *writer,
+                      guint64       size)
+{
+  g_mutex_lock (&writer->progress->mutex);
+  writer->progress->completed_size += size;
+  g_mutex_unlock (&writer->progress->mutex);
+}
+
+
+
+static TseZipEntry*
+tse_zip_entry_new (const gchar *name,
+                   GFileInfo   *info,
+                   guint64      offset)
+{
+  TseZipEntry *entry;
+  GDateTime   *date_time = NULL;
+  guint64      mtime;
+
+  entry = g_slice_new0 (TseZipEntry);
+  entry->name = g_strdup (name);
+  entry->flags = TSE_ZIP_FLAG_UTF8;
+  entry->offset = offset;
+  entry->mode = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE);
+
+  /* ZIP keeps the modification time as local MS-DOS time */
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  if (mtime > 0)
+    date_time = g_date_time_new_from_unix_local (mtime);
+  if (date_time != NULL && g_date_time_get_year (date_time) >= 1980)
+    {
+      entry->date = ((g_date_time_get_year (date_time) - 1980) << 9)
+                  | (g_date_time_get_month (date_time) << 5)
+                  | g_date_time_get_day_of_month (date_time);
+      entry->time = (g_date_time_get_hour (date_time) << 11)
+                  | (g_date_time_get_minute (date_time) << 5)
+                  | (g_date_time_get_second (date_time) / 2);
+    }
+  else
+    {
+      /* 1980-01-01 */
+      entry->date = (1 << 5) | 1;
+    }
+  if (date_time != NULL)
+    g_date_time_unref (date_time);
+
+  return entry;
+}
+
+
+
+static GByteArray*
+tse_zip_local_header (TseZipEntry *entry)
+{
+  GByteArray *array;
+  gsize       name_length = strlen (entry->name);
+
+  array = g_byte_array_sized_new (30 + name_length);
+  tse_zip_put32 (array, 0x04034b50);
+  tse_zip_put16 (array, TSE_ZIP_VERSION_NEEDED);
+  tse_zip_put16 (array, entry->flags);
+  tse_zip_put16 (array, entry->method);
+  tse_zip_put16 (array, entry->time);
+  tse_zip_put16 (array, entry->date);
+
+  /* the crc and the sizes follow the data in the data descriptor (or are zero) */
+  tse_zip_put32 (array, 0);
+  tse_zip_put32 (array, 0);
+  tse_zip_put32 (array, 0);
+  tse_zip_put16 (array, name_length);
+  tse_zip_put16 (array, 0);
+  g_byte_array_append (array, (const guint8 *) entry->name, name_length);
+
+  return array;
+}
+
+
+
+static gboolean
+tse_zip_deflate (TseZipWriter     *writer,
+                 TseZipEntry      *entry,
+                 GConverter       *converter,
+                 const guchar     *data,
+                 gsize             length,
+                 gboolean          at_end,
+                 GError          **error)
+{
+  GConverterResult result;
+  gsize            bytes_read;
+  gsize            bytes_written;
+
+  do
+    {
+      result = g_converter_convert (converter, data, length,
+                                    writer->output, TSE_ZIP_BUFFER_SIZE,
+                                    at_end ? G_CONVERTER_INPUT_AT_END : G_CONVERTER_NO_FLAGS,
+                                    &bytes_read, &bytes_written, error);
+      if (result == G_CONVERTER_ERROR)
+        return FALSE;
+
+      if (!tse_zip_write_bytes (writer, writer->output, bytes_written, error))
+        return FALSE;
+
+      entry->compressed_size += bytes_written;
+      data += bytes_read;
+      length -= bytes_read;
+    }
+  while (length > 0 || (at_end && result != G_CONVERTER_FINISHED));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+tse_zip_add_file (TseZipWriter  *writer,
+                  GFile         *file,
+                  GFileInfo     *info,
+                  const gchar   *name,
+                  GError       **error)
+{
+  GFileInputStream *input;
+  TseZipEntry      *entry;
+  GByteArray       *array;
+  GConverter       *converter;
+  gboolean          succeed = TRUE;
+  gssize            n;
+
+  input = g_file_read (file, writer->cancellable, error);
+  if (G_UNLIKELY (input == NULL))
+    return FALSE;
+
+  entry = tse_zip_entry_new (name, info, writer->offset);
+  entry->flags |= TSE_ZIP_FLAG_DATA_DESCRIPTOR;
+  entry->method = TSE_ZIP_METHOD_DEFLATE;
+  g_ptr_array_add (writer->entries, entry);
+
+  succeed = tse_zip_check_size (entry->offset, error)
+         && tse_zip_write_array (writer, tse_zip_local_header (entry), error);
+
+  /* compress the file while reading it, straight into the archive */
+  converter = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+  while (succeed)
+    {
+      n = g_input_stream_read (G_INPUT_STREAM (input), writer->input, TSE_ZIP_BUFFER_SIZE, writer->cancellable, error);
+      if (G_UNLIKELY (n < 0))
+        {
+          succeed = FALSE;
+          break;
+        }
+
+      entry->crc = tse_zip_crc_update (entry->crc, writer->input, n);
+      entry->size += n;
+
+      succeed = tse_zip_deflate (writer, entry, converter, writer->input, n, n == 0, error);
+      tse_zip_progress_add (writer, n);
+
+      if (n == 0)
+        break;
+    }
+  g_object_unref (converter);
+  g_object_unref (input);
+
+  if (G_UNLIKELY (!succeed))
+    return FALSE;
+
+  if (!tse_zip_check_size (entry->size, error) || !tse_zip_check_size (entry->compressed_size, error))
+    return FALSE;
+
+  /* the data descriptor */
+  array = g_byte_array_sized_new (16);
+  tse_zip_put32 (array, 0x08074b50);
+  tse_zip_put32 (array, entry->crc);
+  tse_zip_put32 (array, entry->compressed_size);
+  tse_zip_put32 (array, entry->size);
+
+  return tse_zip_write_array (writer, array, error);
+}
+
+
+
+static gboolean
+tse_zip_add (TseZipWriter  *writer,
+             GFile         *file,
+             GFileInfo     *info,
+             const gchar   *name,
+             GError       **error)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *child_info;
+  TseZipEntry     *entry;
+  gboolean         succeed = TRUE;
+  GError          *err = NULL;
+  GFile           *child;
+  gchar           *child_name;
+  gchar           *dir_name;
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+    return tse_zip_add_file (writer, file, info, name, error);
+
+  /* folders are entries without data, with a trailing slash */
+  dir_name = g_strconcat (name, "/", NULL);
+  entry = tse_zip_entry_new (dir_name, info, writer->offset);
+  g_ptr_array_add (writer->entries, entry);
+  g_free (dir_name);
+
+  if (!tse_zip_check_size (entry->offset, error)
+      || !tse_zip_write_array (writer, tse_zip_local_header (entry), error))
+    return FALSE;
+
+  enumerator = g_file_enumerate_children (file, TSE_ZIP_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, writer->cancellable, error);
+  if (G_UNLIKELY (enumerator == NULL))
+    return FALSE;
+
+  while (succeed)
+    {
+      child_info = g_file_enumerator_next_file (enumerator, writer->cancellable, &err);
+      if (child_info == NULL)
+        {
+          /* no error means the end of the folder */
+          if (G_UNLIKELY (err != NULL))
+            {
+              g_propagate_error (error, err);
+              succeed = FALSE;
+            }
+          break;
+        }
+
+      child = g_file_get_child (file, g_file_info_get_name (child_info));
+      child_name = g_strconcat (name, "/", g_file_info_get_display_name (child_info), NULL);
+      succeed = tse_zip_add (writer, child, child_info, child_name, error);
+      g_free (child_name);
+      g_object_unref (child);
+      g_object_unref (child_info);
+    }
+  g_object_unref (enumerator);
+
+  return succeed;
+}
+
+
+
+static guint64
+tse_zip_count (GFile        *file,
+               GFileInfo    *info,
+               GCancellable *cancellable)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *child_info;
+  GFile           *child;
+  guint64          size = 0;
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+    return g_file_info_get_size (info);
+
+  enumerator = g_file_enumerate_children (file, TSE_ZIP_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+  if (G_UNLIKELY (enumerator == NULL))
+    return 0;
+
+  while ((child_info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+    {
+      child = g_file_get_child (file, g_file_info_get_name (child_info));
+      size += tse_zip_count (child, child_info, cancellable);
+      g_object_unref (child);
+      g_object_unref (child_info);
+    }
+  g_object_unref (enumerator);
+
+  return size;
+}
+
+
+
+static gboolean
+tse_zip_write_central_directory (TseZipWriter  *writer,
+                                 GError       **error)
+{
+  TseZipEntry *entry;
+  GByteArray  *array;
+  guint64      start;
+  guint32      length;
+  gsize        name_length;
+  guint        n;
+
+  start = writer->offset;
+  if (!tse_zip_check_size (start, error) || !tse_zip_check_size (writer->entries->len, error))
+    return FALSE;
+
+  array = g_byte_array_new ();
+  for (n = 0; n < writer->entries->len; ++n)
+    {
+      entry = g_ptr_array_index (writer->entries, n);
+      name_length = strlen (entry->name);
+
+      tse_zip_put32 (array, 0x02014b50);
+      tse_zip_put16 (array, TSE_ZIP_VERSION_MADE_BY);
+      tse_zip_put16 (array, TSE_ZIP_VERSION_NEEDED);
+      tse_zip_put16 (array, entry->flags);
+      tse_zip_put16 (array, entry->method);
+      tse_zip_put16 (array, entry->time);
+      tse_zip_put16 (array, entry->date);
+      tse_zip_put32 (array, entry->crc);
+      tse_zip_put32 (array, entry->compressed_size);
+      tse_zip_put32 (array, entry->size);
+      tse_zip_put16 (array, name_length);
+      tse_zip_put16 (array, 0); /* extra field */
+      tse_zip_put16 (array, 0); /* comment */
+      tse_zip_put16 (array, 0); /* disk */
+      tse_zip_put16 (array, 0); /* internal attributes */
+      tse_zip_put32 (array, entry->mode << 16);
+      tse_zip_put32 (array, entry->offset);
+      g_byte_array_append (array, (const guint8 *) entry->name, name_length);
+    }
+
+  /* the end of central directory record */
+  length = array->len;
+  if (!tse_zip_check_size (start + length, error))
+    {
+      g_byte_array_free (array, TRUE);
+      return FALSE;
+    }
+  tse_zip_put32 (array, 0x06054b50);
+  tse_zip_put16 (array, 0);
+  tse_zip_put16 (array, 0);
+  tse_zip_put16 (array, MIN (writer->entries->len, G_MAXUINT16));
+  tse_zip_put16 (array, MIN (writer->entries->len, G_MAXUINT16));
+  tse_zip_put32 (array, length);
+  tse_zip_put32 (array, start);
+  tse_zip_put16 (array, 0);
+
+  return tse_zip_write_array (writer, array, error);
+}
+
+
+
+/**
+ * tse_zip_write:
+ * @files       : a #GList of #GFile<!---->s to put into the archive.
+ * @filename    : the path of the ZIP archive to create.
+ * @progress    : a #TseZipProgress, updated while writing.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Writes the @files, and the contents of folders among them, into
+ * a new ZIP archive at @filename. The files are compressed while
+ * they are read, straight into the archive, so this may run in a
+ * thread and report through @progress.
+ *
+ * Return value: %TRUE if the archive was written.
+ **/
+gboolean
+tse_zip_write (GList          *files,
+               const gchar    *filename,
+               TseZipProgress *progress,
+               GCancellable   *cancellable,
+               GError        **error)
+{
+  TseZipWriter       writer;
+  GFileOutputStream *output;
+  GFileInfo         *info;
+  GFile             *archive;
+  gboolean           succeed = TRUE;
+  guint64            total_size = 0;
+  GList             *lp;
+  GList             *lq;
+  GList             *infos = NULL;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (progress != NULL, FALSE);
+
+  tse_zip_crc_init ();
+
+  /* count the bytes first, for the progress */
+  for (lp = files; lp != NULL && succeed; lp = lp->next)
+    {
+      info = g_file_query_info (lp->data, TSE_ZIP_ATTRIBUTES, G_FILE_QUERY_INFO_NONE, cancellable, error);
+      if (G_UNLIKELY (info == NULL))
+        succeed = FALSE;
+      else
+        {
+          total_size += tse_zip_count (lp->data, info, cancellable);
+          infos = g_list_prepend (infos, info);
+        }
+    }
+
+  if (G_UNLIKELY (!succeed))
+    {
+      g_list_free_full (infos, g_object_unref);
+      return FALSE;
+    }
+
+  infos = g_list_reverse (infos);
+
+  g_mutex_lock (&progress->mutex);
+  progress->total_size = total_size;
+  g_mutex_unlock (&progress->mutex);
+
+  archive = g_file_new_for_path (filename);
+  output = g_file_create (archive, G_FILE_CREATE_PRIVATE, cancellable, error);
+  if (G_UNLIKELY (output == NULL))
+    {
+      g_list_free_full (infos, g_object_unref);
+      g_object_unref (archive);
+      return FALSE;
+    }
+
+  writer.stream = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (output), TSE_ZIP_BUFFER_SIZE);
+  writer.offset = 0;
+  writer.entries = g_ptr_array_new_with_free_func (tse_zip_entry_free);
+  writer.progress = progress;
+  writer.cancellable = cancellable;
+  writer.input = g_malloc (TSE_ZIP_BUFFER_SIZE);
+  writer.output = g_malloc (TSE_ZIP_BUFFER_SIZE);
+  g_object_unref (output);
+
+  /* the files are the top level of the archive */
+  for (lp = files, lq = infos; lp != NULL && succeed; lp = lp->next, lq = lq->next)
+    succeed = tse_zip_add (&writer, lp->data, lq->data, g_file_info_get_display_name (lq->data), error);
+
+  if (G_LIKELY (succeed))
+    succeed = tse_zip_write_central_directory (&writer, error);
+
+  /* close even when failed, to release the file */
+  if (!g_output_stream_close (writer.stream, NULL, succeed ? error : NULL))
+    succeed = FALSE;
+
+  /* do not leave half an archive */
+  if (G_UNLIKELY (!succeed))
+    g_file_delete (archive, NULL, NULL);
+
+  g_free (writer.input);
+  g_free (writer.output);
+  g_ptr_array_unref (writer.entries);
+  g_object_unref (writer.stream);
+  g_object_unref (archive);
+  g_list_free_full (infos, g_object_unref);
+
+  return succeed;
+}
@@ -0,0 +1,53 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TSE_ZIP_H__
+#define __TSE_ZIP_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _TseZipProgress TseZipProgress;
+
+/**
+ * TseZipProgress:
+ * @mutex          : protects the other members.
+ * @total_size     : the number of bytes of all files, once they are counted.
+ * @completed_size : the number of bytes written to the archive so far.
+ *
+ * Lets another thread follow tse_zip_write().
+ **/
+struct _TseZipProgress
+{
+  GMutex  mutex;
+  guint64 total_size;
+  guint64 completed_size;
+};
+
+gboolean tse_zip_write (GList          *files,
+                        const gchar    *filename,
+                        TseZipProgress *progress,
+                        GCancellable   *cancellable,
+                        GError        **error);
+
+G_END_DECLS;
+
+#endif /* !__TSE_ZIP_H__ */
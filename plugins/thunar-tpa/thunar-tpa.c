@@ -87,6 +87,10 @@ static gboolean thunar_tpa_leave_notify_event  (GtkWidget           *button,
                                                 ThunarTpa           *plugin);
 static void     thunar_tpa_on_trash_changed    (thunarTPATrash      *proxy,
                                                 gpointer             user_data);
+static void     thunar_tpa_on_trash_state_changed (thunarTPATrash   *proxy,
+                                                   gboolean          full,
+                                                   guint             item_count,
+                                                   gpointer          user_data);
 static void     thunar_tpa_display_trash       (ThunarTpa           *plugin);
 static void     thunar_tpa_empty_trash         (ThunarTpa           *plugin);
 static gboolean thunar_tpa_move_to_trash       (ThunarTpa           *plugin,
@@ -114,6 +118,10 @@ struct _ThunarTpa
   GCancellable   *cancellable_empty_trash;
   GCancellable   *cancellable_move_to_trash;
   GCancellable   *cancellable_query_trash;
+
+  /* whether the file manager sends the trash state with its signals,
+   * older versions only tell that it changed and have to be queried */
+  gboolean        state_pushed;
 };
 
 /* Target types for dropping to the trash can */
@@ -187,6 +195,7 @@ thunar_tpa_init (ThunarTpa *plugin)
     thunar_tpa_error (plugin, error);
 
   g_signal_connect (plugin->proxy, "trash_changed", G_CALLBACK (thunar_tpa_on_trash_changed), plugin);
+  g_signal_connect (plugin->proxy, "trash_state_changed", G_CALLBACK (thunar_tpa_on_trash_state_changed), plugin);
 }
 
 static void
@@ -326,8 +335,9 @@ thunar_tpa_empty_trash_reply (GObject      *source_object,
   success = thunar_tpa_trash_call_empty_trash_finish (proxy, result, &error);
   if (G_LIKELY (success))
     {
-      /* query the new state of the trash */
-      thunar_tpa_query_trash (plugin);
+      /* query the new state of the trash, unless the file manager sends it */
+      if (!plugin->state_pushed)
+        thunar_tpa_query_trash (plugin);
     }
   else
     {
@@ -353,8 +363,9 @@ thunar_tpa_move_to_trash_reply (GObject      *source_object,
   success = thunar_tpa_trash_call_move_to_trash_finish (proxy, result, &error);
   if (G_LIKELY (success))
     {
-      /* query the new state of the trash */
-      thunar_tpa_query_trash (plugin);
+      /* query the new state of the trash, unless the file manager sends it */
+      if (!plugin->state_pushed)
+        thunar_tpa_query_trash (plugin);
     }
   else
     {
@@ -436,8 +447,9 @@ thunar_tpa_enter_notify_event (GtkWidget        *button,
   g_return_val_if_fail (THUNAR_IS_TPA (plugin), FALSE);
   g_return_val_if_fail (plugin->button == button, FALSE);
 
-  /* query the new state of the trash */
-  thunar_tpa_query_trash (plugin);
+  /* query the new state of the trash, unless the file manager sends it */
+  if (!plugin->state_pushed)
+    thunar_tpa_query_trash (plugin);
 
   return FALSE;
 }
@@ -452,8 +464,9 @@ thunar_tpa_leave_notify_event (GtkWidget        *button,
   g_return_val_if_fail (THUNAR_IS_TPA (plugin), FALSE);
   g_return_val_if_fail (plugin->button == button, FALSE);
 
-  /* query the new state of the trash */
-  thunar_tpa_query_trash (plugin);
+  /* query the new state of the trash, unless the file manager sends it */
+  if (!plugin->state_pushed)
+    thunar_tpa_query_trash (plugin);
 
   return FALSE;
 }
@@ -469,8 +482,29 @@ thunar_tpa_on_trash_changed (thunarTPATrash *proxy,
   g_return_if_fail (THUNAR_IS_TPA (plugin));
   g_return_if_fail (plugin->proxy == proxy);
 
-  /* update the state of the trash plugin */
-  thunar_tpa_query_trash (plugin);
+  /* update the state of the trash plugin, it came with "trash-state-changed" already */
+  if (!plugin->state_pushed)
+    thunar_tpa_query_trash (plugin);
+}
+
+
+
+static void
+thunar_tpa_on_trash_state_changed (thunarTPATrash *proxy,
+                                   gboolean        full,
+                                   guint           item_count,
+                                   gpointer        user_data)
+{
+  ThunarTpa *plugin = THUNAR_TPA (user_data);
+
+  g_return_if_fail (THUNAR_IS_TPA (plugin));
+  g_return_if_fail (plugin->proxy == proxy);
+
+  /* the file manager sends the state, stop querying it */
+  plugin->state_pushed = TRUE;
+
+  /* update the tooltip/plugin accordingly */
+  thunar_tpa_state (plugin, full);
 }
 
 
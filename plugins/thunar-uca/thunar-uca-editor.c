@@ -69,6 +69,7 @@ struct _ThunarUcaEditor
   GtkWidget   *command_entry;
   GtkWidget   *shortcut_button;
   GtkWidget   *sn_button;
+  GtkWidget   *parallel_jobs_spin;
   GtkWidget   *patterns_entry;
   GtkWidget   *range_entry;
   GtkWidget   *directories_button;
@@ -118,6 +119,7 @@ thunar_uca_editor_class_init (ThunarUcaEditorClass *klass)
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, command_entry);
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, shortcut_button);
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, sn_button);
+  gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, parallel_jobs_spin);
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, patterns_entry);
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, range_entry);
   gtk_widget_class_bind_template_child (widget_class, ThunarUcaEditor, directories_button);
@@ -582,6 +584,7 @@ thunar_uca_editor_load (ThunarUcaEditor *uca_editor,
   gchar         *unique_id;
   gchar         *accel_label = NULL;
   gboolean       startup_notify;
+  guint          parallel_jobs;
   GtkAccelKey    key;
 
   g_return_if_fail (THUNAR_UCA_IS_EDITOR (uca_editor));
@@ -599,6 +602,7 @@ thunar_uca_editor_load (ThunarUcaEditor *uca_editor,
                       THUNAR_UCA_MODEL_COLUMN_NAME, &name,
                       THUNAR_UCA_MODEL_COLUMN_SUB_MENU, &submenu,
                       THUNAR_UCA_MODEL_COLUMN_STARTUP_NOTIFY, &startup_notify,
+                      THUNAR_UCA_MODEL_COLUMN_PARALLEL_JOBS, &parallel_jobs,
                       THUNAR_UCA_MODEL_COLUMN_UNIQUE_ID, &unique_id,
                       -1);
 
@@ -626,6 +630,7 @@ thunar_uca_editor_load (ThunarUcaEditor *uca_editor,
   gtk_entry_set_text (GTK_ENTRY (uca_editor->sub_menu_entry), (submenu != NULL) ? submenu : "");
   gtk_button_set_label (GTK_BUTTON (uca_editor->shortcut_button), (accel_label != NULL) ? accel_label : _("None"));
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (uca_editor->sn_button), startup_notify);
+  gtk_spin_button_set_value (GTK_SPIN_BUTTON (uca_editor->parallel_jobs_spin), parallel_jobs);
 
   /* cleanup */
   g_free (description);
@@ -680,6 +685,7 @@ thunar_uca_editor_save (ThunarUcaEditor *uca_editor,
                            gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (uca_editor->sn_button)),
                            gtk_entry_get_text (GTK_ENTRY (uca_editor->patterns_entry)),
                            gtk_entry_get_text (GTK_ENTRY (uca_editor->range_entry)),
+                           gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (uca_editor->parallel_jobs_spin)),
                            thunar_uca_editor_get_types (uca_editor),
                            uca_editor->accel_key,
                            uca_editor->accel_mods);
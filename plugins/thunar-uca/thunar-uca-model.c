@@ -79,6 +79,7 @@ typedef enum
   PARSER_STARTUP_NOTIFY,
   PARSER_PATTERNS,
   PARSER_RANGE,
+  PARSER_PARALLEL_JOBS,
   PARSER_DESCRIPTION,
   PARSER_DIRECTORIES,
   PARSER_AUDIO_FILES,
@@ -126,6 +127,9 @@ static gboolean           thunar_uca_model_load_from_file   (ThunarUcaModel
                                                              const gchar          *filename,
                                                              GError              **error);
 static void               thunar_uca_model_item_reset       (ThunarUcaModelItem   *item);
+static void               thunar_uca_model_item_compile     (ThunarUcaModelItem   *item);
+static gboolean           thunar_uca_model_item_match_name  (ThunarUcaModelItem   *item,
+                                                             const gchar          *name);
 static void               thunar_uca_model_item_free        (gpointer              data);
 static void               start_element_handler             (GMarkupParseContext  *context,
                                                              const gchar          *element_name,
@@ -170,10 +174,20 @@ struct _ThunarUcaModelItem
   guint          startup_notify : 1;
   gchar        **patterns;
   gchar         *range;
+  guint          parallel_jobs;
   ThunarUcaTypes types;
 
   /* derived attributes */
   guint          multiple_selection : 1;
+
+  /* the range and patterns, prepared for thunar_uca_model_match() */
+  guint          has_range : 1;
+  guint          matches_all : 1;
+  gint           range_lower;
+  gint           range_upper;
+  GHashTable    *literals;
+  GHashTable    *suffixes;
+  gchar        **globs;
 };
 
 typedef XFCE_GENERIC_STACK(ParserState) ParserStack;
@@ -193,6 +207,7 @@ typedef struct
   GString        *patterns;
   GString        *description;
   GString        *range;
+  GString        *parallel_jobs;
   gboolean        startup_notify;
   gboolean        description_use;
   guint           description_match;
@@ -343,6 +358,9 @@ thunar_uca_model_get_column_type (GtkTreeModel *tree_model,
     case THUNAR_UCA_MODEL_COLUMN_RANGE:
       return G_TYPE_STRING;
 
+    case THUNAR_UCA_MODEL_COLUMN_PARALLEL_JOBS:
+      return G_TYPE_UINT;
+
     case THUNAR_UCA_MODEL_COLUMN_TYPES:
       return G_TYPE_UINT;
 
@@ -460,6 +478,10 @@ thunar_uca_model_get_value (GtkTreeModel *tree_model,
       g_value_set_static_string (value, item->range);
       break;
 
+    case THUNAR_UCA_MODEL_COLUMN_PARALLEL_JOBS:
+      g_value_set_uint (value, item->parallel_jobs);
+      break;
+
     case THUNAR_UCA_MODEL_COLUMN_TYPES:
       g_value_set_uint (value, item->types);
       break;
@@ -594,6 +616,7 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
   parser.command = g_string_new (NULL);
   parser.patterns = g_string_new (NULL);
   parser.range = g_string_new (NULL);
+  parser.parallel_jobs = g_string_new (NULL);
   parser.description = g_string_new (NULL);
   parser.startup_notify = FALSE;
   parser.unique_id_generated = FALSE;
@@ -608,6 +631,7 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
   g_markup_parse_context_free (context);
   g_string_free (parser.description, TRUE);
   g_string_free (parser.patterns, TRUE);
+  g_string_free (parser.parallel_jobs, TRUE);
   g_string_free (parser.range, TRUE);
   g_string_free (parser.command, TRUE);
   g_string_free (parser.icon_name, TRUE);
@@ -644,12 +668,101 @@ thunar_uca_model_item_reset (ThunarUcaModelItem *item)
   if (item->gicon != NULL)
     g_object_unref (item->gicon);
 
+  /* the compiled patterns point into item->patterns */
+  if (item->literals != NULL)
+    g_hash_table_destroy (item->literals);
+  if (item->suffixes != NULL)
+    g_hash_table_destroy (item->suffixes);
+  g_free (item->globs);
+
   /* ...and reset the item memory */
   memset (item, 0, sizeof (*item));
 }
 
 
 
+static void
+thunar_uca_model_item_compile (ThunarUcaModelItem *item)
+{
+  const gchar  *pattern;
+  GPtrArray    *globs;
+  gchar       **limits;
+  guint         n;
+
+  /* parse the range once, instead of on every match */
+  if (item->range != NULL)
+    {
+      limits = g_strsplit (item->range, "-", 2);
+      if (limits[0] != NULL && limits[1] != NULL)
+        {
+          item->has_range = TRUE;
+          item->range_lower = g_strtod (limits[0], NULL);
+          item->range_upper = g_strtod (limits[1], NULL);
+        }
+      g_strfreev (limits);
+    }
+
+  /* sort the patterns into the ones that can be looked up
+   * in a hash table and the remaining globs */
+  globs = g_ptr_array_new ();
+  for (n = 0; item->patterns[n] != NULL; ++n)
+    {
+      pattern = item->patterns[n];
+      if (strcmp (pattern, "*") == 0)
+        {
+          item->matches_all = TRUE;
+        }
+      else if (strpbrk (pattern, "*?") == NULL)
+        {
+          if (item->literals == NULL)
+            item->literals = g_hash_table_new (g_str_hash, g_str_equal);
+          g_hash_table_add (item->literals, (gpointer) pattern);
+        }
+      else if (pattern[0] == '*' && pattern[1] == '.' && strpbrk (pattern + 1, "*?") == NULL)
+        {
+          /* "*.ext", the suffix is looked up at every dot of a name */
+          if (item->suffixes == NULL)
+            item->suffixes = g_hash_table_new (g_str_hash, g_str_equal);
+          g_hash_table_add (item->suffixes, (gpointer) (pattern + 1));
+        }
+      else
+        {
+          g_ptr_array_add (globs, (gpointer) pattern);
+        }
+    }
+  g_ptr_array_add (globs, NULL);
+  item->globs = (gchar **) g_ptr_array_free (globs, FALSE);
+}
+
+
+
+static gboolean
+thunar_uca_model_item_match_name (ThunarUcaModelItem *item,
+                                  const gchar        *name)
+{
+  const gchar *dot;
+  guint        n;
+
+  if (item->matches_all)
+    return TRUE;
+
+  if (item->literals != NULL && g_hash_table_contains (item->literals, name))
+    return TRUE;
+
+  if (item->suffixes != NULL)
+    for (dot = strchr (name, '.'); dot != NULL; dot = strchr (dot + 1, '.'))
+      if (g_hash_table_contains (item->suffixes, dot))
+        return TRUE;
+
+  for (n = 0; item->globs != NULL && item->globs[n] != NULL; ++n)
+    if (g_pattern_match_simple (item->globs[n], name))
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
 static void
 thunar_uca_model_item_free (gpointer data)
 {
@@ -694,6 +807,7 @@ start_element_handler (GMarkupParseContext *context,
           g_string_truncate (parser->command, 0);
           g_string_truncate (parser->patterns, 0);
           g_string_truncate (parser->range, 0);
+          g_string_truncate (parser->parallel_jobs, 0);
           g_string_truncate (parser->description, 0);
           xfce_stack_push (parser->stack, PARSER_ACTION);
         }
@@ -761,6 +875,11 @@ start_element_handler (GMarkupParseContext *context,
           g_string_truncate (parser->range, 0);
           xfce_stack_push (parser->stack, PARSER_RANGE);
         }
+      else if (strcmp (element_name, "parallel-jobs") == 0)
+        {
+          g_string_truncate (parser->parallel_jobs, 0);
+          xfce_stack_push (parser->stack, PARSER_PARALLEL_JOBS);
+        }
       else if (strcmp (element_name, "description") == 0)
         {
           for (n = 0; attribute_names[n] != NULL; ++n)
@@ -871,6 +990,7 @@ end_element_handler (GMarkupParseContext *context,
                                    parser->startup_notify,
                                    parser->patterns->str,
                                    parser->range->str,
+                                   MIN (g_ascii_strtoull (parser->parallel_jobs->str, NULL, 10), THUNAR_UCA_MODEL_MAX_PARALLEL_JOBS),
                                    parser->types,
                                    0, 0);
 
@@ -917,6 +1037,11 @@ end_element_handler (GMarkupParseContext *context,
         goto unknown_element;
       break;
 
+    case PARSER_PARALLEL_JOBS:
+      if (strcmp (element_name, "parallel-jobs") != 0)
+        goto unknown_element;
+      break;
+
     case PARSER_DESCRIPTION:
       if (strcmp (element_name, "description") != 0)
         goto unknown_element;
@@ -1015,6 +1140,10 @@ text_handler (GMarkupParseContext *context,
       g_string_append_len (parser->range, text, text_len);
       break;
 
+    case PARSER_PARALLEL_JOBS:
+      g_string_append_len (parser->parallel_jobs, text, text_len);
+      break;
+
     case PARSER_DESCRIPTION:
       if (parser->description_use)
         g_string_append_len (parser->description, text, text_len);
@@ -1122,116 +1251,79 @@ types_from_mime_type (const gchar *mime_type)
  * </programlisting></informalexample>
  *
  * Return value: the list of #GtkTreePath<!---->s to items
- *               that match @file_infos.
+ *               that match @snapshot.
  **/
 GList*
-thunar_uca_model_match (ThunarUcaModel *uca_model,
-                        GList          *file_infos)
+thunar_uca_model_match (ThunarUcaModel                *uca_model,
+                        const ThunarxFileInfoSnapshot *snapshot)
 {
   typedef struct
   {
-    gchar          *name;
-    ThunarUcaTypes  types;
-  } ThunarUcaFile;
+    ThunarUcaModelItem *item;
+    gint                index;
+  } ThunarUcaCandidate;
 
+  ThunarUcaCandidate *candidates;
   ThunarUcaModelItem *item;
-  ThunarUcaFile      *files;
-  GFile              *location;
-  gchar              *mime_type;
-  gboolean            matches;
+  ThunarUcaTypes      types;
   GList              *paths = NULL;
   GList              *lp;
+  gint                n_candidates;
   gint                n_files;
   gint                i, m, n;
-  gint                upper, lower;
-  gchar              *path_test;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), NULL);
-  g_return_val_if_fail (file_infos != NULL, NULL);
+  g_return_val_if_fail (snapshot != NULL, NULL);
 
   /* special case to avoid overhead */
   if (G_UNLIKELY (uca_model->items == NULL))
     return NULL;
 
-  /* determine the ThunarUcaFile's for the given file_infos */
-  n_files = g_list_length (file_infos);
-  files = g_new (ThunarUcaFile, n_files);
-  for (lp = file_infos, n = 0; lp != NULL; lp = lp->next, ++n)
-    {
-      location = thunarx_file_info_get_location (lp->data);
-
-      path_test = g_file_get_path (location);
-      if (path_test == NULL)
-        {
-          /* cannot handle non-local files */
-          g_object_unref (location);
-          g_free (files);
-          return NULL;
-        }
-      g_free (path_test);
-
-      g_object_unref (location);
-
-      mime_type = thunarx_file_info_get_mime_type (lp->data);
-
-      files[n].name = thunarx_file_info_get_name (lp->data);
-      files[n].types = types_from_mime_type (mime_type);
-
-      if (G_UNLIKELY (files[n].types == 0))
-        files[n].types = THUNAR_UCA_TYPE_OTHER_FILES;
-
-      g_free (mime_type);
-    }
-
-  /* lookup the matching items */
-  for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
+  /* collect the items which accept the number of files */
+  n_files = thunarx_file_info_snapshot_get_n_files (snapshot);
+  candidates = g_new (ThunarUcaCandidate, g_list_length (uca_model->items));
+  for (i = 0, n_candidates = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
     {
-      /* check if we can just ignore this item */
       item = (ThunarUcaModelItem *) lp->data;
-      upper = n_files;
-      lower = n_files;
-
-      if (item->range != NULL)
-        {
-          gchar **limits = g_strsplit (item->range, "-", 2);
-          if (limits[0] != NULL && limits[1] != NULL)
-            {
-              lower = g_strtod (limits[0], NULL);
-              upper = g_strtod (limits[1], NULL);
-            }
-          g_strfreev (limits);
-        }
 
-      if ((n_files > upper) || (n_files < lower))
+      if (item->has_range && (n_files > item->range_upper || n_files < item->range_lower))
         continue;
       if (!item->multiple_selection && n_files > 1)
         continue;
 
-      /* match the specified files */
-      for (n = 0; n < n_files; ++n)
-        {
-          /* verify that we support this type of file */
-          if ((files[n].types & item->types) == 0)
-            break;
-
-          /* atleast on pattern must match the file name */
-          for (m = 0, matches = FALSE; item->patterns[m] != NULL && !matches; ++m)
-            matches = g_pattern_match_simple (item->patterns[m], files[n].name);
+      candidates[n_candidates].item = item;
+      candidates[n_candidates].index = i;
+      n_candidates++;
+    }
 
-          /* no need to continue if none of the patterns match */
-          if (!matches)
-            break;
+  /* a single pass over the files, dropping the items whose type or
+   * patterns don't match, until no item is left */
+  for (i = 0; i < n_files && n_candidates > 0; ++i)
+    {
+      /* cannot handle non-local files */
+      if (thunarx_file_info_snapshot_get_path (snapshot, i) == NULL)
+        {
+          n_candidates = 0;
+          break;
         }
 
-      /* add the path if all files match one of the patterns */
-      if (G_UNLIKELY (n == n_files))
-        paths = g_list_append (paths, gtk_tree_path_new_from_indices (i, -1));
+      types = types_from_mime_type (thunarx_file_info_snapshot_get_mime_type (snapshot, i));
+      if (G_UNLIKELY (types == 0))
+        types = THUNAR_UCA_TYPE_OTHER_FILES;
+
+      /* atleast one pattern must match the file name */
+      for (m = n = 0; n < n_candidates; ++n)
+        if ((types & candidates[n].item->types) != 0
+            && thunar_uca_model_item_match_name (candidates[n].item, thunarx_file_info_snapshot_get_name (snapshot, i)))
+          candidates[m++] = candidates[n];
+      n_candidates = m;
     }
 
-  /* cleanup */
-  for (n = 0; n < n_files; ++n)
-    g_free (files[n].name);
-  g_free (files);
+  /* add the paths of the items that match all files */
+  for (n = n_candidates; n > 0; --n)
+    paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (candidates[n - 1].index, -1));
+
+  g_free (candidates);
 
   return paths;
 }
@@ -1381,6 +1473,9 @@ thunar_uca_model_remove (ThunarUcaModel *uca_model,
  * @icon               : the icon for the item.
  * @command            : the command of the item.
  * @patterns           : the patterns to match files for this item.
+ * @range              : the number of selected files the item applies to.
+ * @parallel_jobs      : run the command once per file, at most this many
+ *                       at a time, or 0 to run it once for all files.
  * @types              : where to apply this item.
  *
  * Updates the @uca_model item at @iter with the given values.
@@ -1397,6 +1492,7 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
                          gboolean        startup_notify,
                          const gchar    *patterns,
                          const gchar    *range,
+                         guint           parallel_jobs,
                          ThunarUcaTypes  types,
                          guint           accel_key,
                          GdkModifierType accel_mods)
@@ -1428,6 +1524,7 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
     item->description = g_strdup (description);
   item->types = types;
   item->startup_notify = startup_notify;
+  item->parallel_jobs = MIN (parallel_jobs, THUNAR_UCA_MODEL_MAX_PARALLEL_JOBS);
 
   /* set the unique id once */
   if (item->unique_id == NULL)
@@ -1449,6 +1546,9 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
     }
   item->patterns[n] = NULL;
 
+  /* prepare the range and patterns for matching */
+  thunar_uca_model_item_compile (item);
+
   /* check if this item will work for multiple files */
   item->multiple_selection = (command != NULL && (strstr (command, "%F") != NULL
                                                || strstr (command, "%D") != NULL
@@ -1548,6 +1648,8 @@ thunar_uca_model_save (ThunarUcaModel *uca_model,
       g_free (escaped);
       if (item->startup_notify)
         fprintf (fp, "\t<startup-notify/>\n");
+      if (item->parallel_jobs > 0)
+        fprintf (fp, "\t<parallel-jobs>%u</parallel-jobs>\n", item->parallel_jobs);
       if ((item->types & THUNAR_UCA_TYPE_DIRECTORIES) != 0)
         fprintf (fp, "\t<directories/>\n");
       if ((item->types & THUNAR_UCA_TYPE_AUDIO_FILES) != 0)
@@ -1593,7 +1695,7 @@ done:
  * thunar_uca_model_parse_argv:
  * @uca_model   : a #ThunarUcaModel.
  * @iter        : the #GtkTreeIter of the item.
- * @file_infos  : the #GList of #ThunarxFileInfo<!---->s to pass to the item.
+ * @snapshot    : the #ThunarxFileInfoSnapshot of the files to pass to the item.
  * @argcp       : return location for number of args.
  * @argvp       : return location for array of args.
  * @error       : return location for errors or %NULL.
@@ -1601,27 +1703,29 @@ done:
  * Return value: %TRUE on success, %FALSE if @error is set.
  **/
 gboolean
-thunar_uca_model_parse_argv (ThunarUcaModel *uca_model,
-                             GtkTreeIter    *iter,
-                             GList          *file_infos,
-                             gint           *argcp,
-                             gchar        ***argvp,
-                             GError        **error)
+thunar_uca_model_parse_argv (ThunarUcaModel                *uca_model,
+                             GtkTreeIter                   *iter,
+                             const ThunarxFileInfoSnapshot *snapshot,
+                             gint                          *argcp,
+                             gchar                       ***argvp,
+                             GError                       **error)
 {
   ThunarUcaModelItem *item;
   const gchar        *p;
+  const gchar        *path;
   GString            *command_line = g_string_new (NULL);
-  GList              *lp;
   GSList             *uri_list = NULL;
   gchar              *dirname;
-  gchar              *path;
   gchar              *expanded;
-  GFile              *location;
+  guint               n_files;
+  guint               n;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), FALSE);
   g_return_val_if_fail (iter->stamp == uca_model->stamp, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
+  n_files = thunarx_file_info_snapshot_get_n_files (snapshot);
+
   /* verify that a command is set for the item */
   item = (ThunarUcaModelItem *) ((GList *) iter->user_data)->data;
   if (item->command == NULL || *item->command == '\0')
@@ -1638,60 +1742,46 @@ thunar_uca_model_parse_argv (ThunarUcaModel *uca_model,
           switch (*++p)
             {
             case 'd':
-              if (G_LIKELY (file_infos != NULL))
+              if (G_LIKELY (n_files > 0))
                 {
-                  location = thunarx_file_info_get_location (file_infos->data);
-                  path = g_file_get_path (location);
-                  g_object_unref (location);
-
+                  path = thunarx_file_info_snapshot_get_path (snapshot, 0);
                   if (G_UNLIKELY (path == NULL))
                     goto error;
 
                   dirname = g_path_get_dirname (path);
                   xfce_g_string_append_quoted (command_line, dirname);
                   g_free (dirname);
-                  g_free (path);
                 }
               break;
 
             case 'D':
-              for (lp = file_infos; lp != NULL; lp = lp->next)
+              for (n = 0; n < n_files; ++n)
                 {
-                  if (G_LIKELY (lp != file_infos))
+                  if (G_LIKELY (n > 0))
                     g_string_append_c (command_line, ' ');
 
-                  location = thunarx_file_info_get_location (lp->data);
-                  path = g_file_get_path (location);
-                  g_object_unref (location);
-
+                  path = thunarx_file_info_snapshot_get_path (snapshot, n);
                   if (G_UNLIKELY (path == NULL))
                     goto error;
 
                   dirname = g_path_get_dirname (path);
                   xfce_g_string_append_quoted (command_line, dirname);
                   g_free (dirname);
-                  g_free (path);
                 }
               break;
 
             case 'n':
-              if (G_LIKELY (file_infos != NULL))
-                {
-                  path = thunarx_file_info_get_name (file_infos->data);
-                  xfce_g_string_append_quoted (command_line, path);
-                  g_free (path);
-                }
+              if (G_LIKELY (n_files > 0))
+                xfce_g_string_append_quoted (command_line, thunarx_file_info_snapshot_get_name (snapshot, 0));
               break;
 
             case 'N':
-              for (lp = file_infos; lp != NULL; lp = lp->next)
+              for (n = 0; n < n_files; ++n)
                 {
-                  if (G_LIKELY (lp != file_infos))
+                  if (G_LIKELY (n > 0))
                     g_string_append_c (command_line, ' ');
 
-                  path = thunarx_file_info_get_name (lp->data);
-                  xfce_g_string_append_quoted (command_line, path);
-                  g_free (path);
+                  xfce_g_string_append_quoted (command_line, thunarx_file_info_snapshot_get_name (snapshot, n));
                 }
               break;
 
@@ -1707,15 +1797,14 @@ thunar_uca_model_parse_argv (ThunarUcaModel *uca_model,
         }
     }
 
-  /* expand the non deprecated field codes */
-  for (lp = file_infos; lp != NULL; lp = lp->next)
-    uri_list = g_slist_prepend (uri_list, thunarx_file_info_get_uri (lp->data));
-  uri_list = g_slist_reverse (uri_list);
+  /* expand the non deprecated field codes, the uris are owned by the snapshot */
+  for (n = n_files; n > 0; --n)
+    uri_list = g_slist_prepend (uri_list, (gchar *) thunarx_file_info_snapshot_get_uri (snapshot, n - 1));
 
   expanded = xfce_expand_desktop_entry_field_codes (command_line->str, uri_list,
                                                     NULL, NULL, NULL, FALSE);
   g_string_free (command_line, TRUE);
-  g_slist_free_full (uri_list, g_free);
+  g_slist_free (uri_list);
 
   /* we run the command using the bourne shell (or the systems
    * replacement for the bourne shell), so environment variables
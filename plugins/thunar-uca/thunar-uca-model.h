@@ -25,6 +25,9 @@
 
 G_BEGIN_DECLS;
 
+/* upper limit for the number of commands an action runs at a time */
+#define THUNAR_UCA_MODEL_MAX_PARALLEL_JOBS 64
+
 typedef struct _ThunarUcaModelClass ThunarUcaModelClass;
 typedef struct _ThunarUcaModel      ThunarUcaModel;
 
@@ -47,6 +50,7 @@ typedef enum
   THUNAR_UCA_MODEL_COLUMN_STARTUP_NOTIFY,
   THUNAR_UCA_MODEL_COLUMN_PATTERNS,
   THUNAR_UCA_MODEL_COLUMN_RANGE,
+  THUNAR_UCA_MODEL_COLUMN_PARALLEL_JOBS,
   THUNAR_UCA_MODEL_COLUMN_TYPES,
   THUNAR_UCA_MODEL_COLUMN_STOCK_LABEL,
   THUNAR_UCA_MODEL_N_COLUMNS,
@@ -76,8 +80,8 @@ void            thunar_uca_model_register_type  (ThunarxProviderPlugin  *plugin)
 
 ThunarUcaModel *thunar_uca_model_get_default    (void);
 
-GList          *thunar_uca_model_match          (ThunarUcaModel         *uca_model,
-                                                 GList                  *file_infos);
+GList          *thunar_uca_model_match          (ThunarUcaModel                *uca_model,
+                                                 const ThunarxFileInfoSnapshot *snapshot);
 
 void            thunar_uca_model_append         (ThunarUcaModel         *uca_model,
                                                  GtkTreeIter            *iter);
@@ -100,6 +104,7 @@ void            thunar_uca_model_update         (ThunarUcaModel         *uca_mod
                                                  gboolean                startup_notify,
                                                  const gchar            *patterns,
                                                  const gchar            *range,
+                                                 guint                   parallel_jobs,
                                                  ThunarUcaTypes          types,
                                                  guint                   accel_key,
                                                  GdkModifierType         accel_mods);
@@ -107,12 +112,12 @@ void            thunar_uca_model_update         (ThunarUcaModel         *uca_mod
 gboolean        thunar_uca_model_save           (ThunarUcaModel         *uca_model,
                                                  GError                **error);
 
-gboolean        thunar_uca_model_parse_argv     (ThunarUcaModel         *uca_model,
-                                                 GtkTreeIter            *iter,
-                                                 GList                  *file_infos,
-                                                 gint                   *argcp,
-                                                 gchar                ***argvp,
-                                                 GError                **error);
+gboolean        thunar_uca_model_parse_argv     (ThunarUcaModel                *uca_model,
+                                                 GtkTreeIter                   *iter,
+                                                 const ThunarxFileInfoSnapshot *snapshot,
+                                                 gint                          *argcp,
+                                                 gchar                       ***argvp,
+                                                 GError                       **error);
 
 G_END_DECLS;
 
@@ -33,26 +33,34 @@
 #include <thunar-uca/thunar-uca-model.h>
 #include <thunar-uca/thunar-uca-private.h>
 #include <thunar-uca/thunar-uca-provider.h>
-
-
-
-static void   thunar_uca_provider_menu_provider_init        (ThunarxMenuProviderIface         *iface);
-static void   thunar_uca_provider_preferences_provider_init (ThunarxPreferencesProviderIface  *iface);
-static void   thunar_uca_provider_finalize                  (GObject                          *object);
-static GList *thunar_uca_provider_get_menu_items            (ThunarxPreferencesProvider       *preferences_provider,
-                                                             GtkWidget                        *window);
-static GList *thunar_uca_provider_get_file_menu_items       (ThunarxMenuProvider              *menu_provider,
-                                                             GtkWidget                        *window,
-                                                             GList                            *files);
-static GList *thunar_uca_provider_get_folder_menu_items     (ThunarxMenuProvider              *menu_provider,
-                                                             GtkWidget                        *window,
-                                                             ThunarxFileInfo                  *folder);
-static void   thunar_uca_provider_activated                 (ThunarUcaProvider                *uca_provider,
-                                                             ThunarxMenuItem                  *item);
-static void   thunar_uca_provider_child_watch               (ThunarUcaProvider                *uca_provider,
-                                                             gint                              exit_status);
-static void   thunar_uca_provider_child_watch_destroy       (gpointer                          user_data,
-                                                             GClosure                         *closure);
+#include <thunar-uca/thunar-uca-runner.h>
+
+
+
+static void     thunar_uca_provider_menu_provider_init        (ThunarxMenuProviderIface         *iface);
+static void     thunar_uca_provider_preferences_provider_init (ThunarxPreferencesProviderIface  *iface);
+static void     thunar_uca_provider_finalize                  (GObject                          *object);
+static GList   *thunar_uca_provider_get_menu_items            (ThunarxPreferencesProvider       *preferences_provider,
+                                                               GtkWidget                        *window);
+static GList   *thunar_uca_provider_get_file_menu_items       (ThunarxMenuProvider              *menu_provider,
+                                                               GtkWidget                        *window,
+                                                               GList                            *files);
+static GList   *thunar_uca_provider_get_folder_menu_items     (ThunarxMenuProvider              *menu_provider,
+                                                               GtkWidget                        *window,
+                                                               ThunarxFileInfo                  *folder);
+static void     thunar_uca_provider_activated                 (ThunarUcaProvider                *uca_provider,
+                                                               ThunarxMenuItem                  *item);
+static gboolean thunar_uca_provider_run_each                  (ThunarUcaProvider                *uca_provider,
+                                                               ThunarxMenuItem                  *item,
+                                                               GtkTreeIter                      *iter,
+                                                               GtkWidget                        *window,
+                                                               GList                            *files,
+                                                               guint                             max_jobs,
+                                                               GError                          **error);
+static void     thunar_uca_provider_child_watch               (ThunarUcaProvider                *uca_provider,
+                                                               gint                              exit_status);
+static void     thunar_uca_provider_child_watch_destroy       (gpointer                          user_data,
+                                                               GClosure                         *closure);
 
 
 
@@ -238,19 +246,23 @@ thunar_uca_provider_get_file_menu_items (ThunarxMenuProvider *menu_provider,
                                          GtkWidget           *window,
                                          GList               *files)
 {
-  GtkTreeRowReference *row;
-  ThunarUcaProvider   *uca_provider = THUNAR_UCA_PROVIDER (menu_provider);
-  ThunarUcaContext    *uca_context = NULL;
-  GtkTreeIter          iter;
-  ThunarxMenuItem     *menu_item;
-  ThunarxMenuItem     *item;
-  GList               *items = NULL;
-  GList               *paths;
-  GList               *lp;
-  ThunarxMenu         *submenu;
-  ThunarxMenu         *parent_menu = NULL;
-
-  paths = thunar_uca_model_match (uca_provider->model, files);
+  ThunarxFileInfoSnapshot *snapshot;
+  GtkTreeRowReference     *row;
+  ThunarUcaProvider       *uca_provider = THUNAR_UCA_PROVIDER (menu_provider);
+  ThunarUcaContext        *uca_context = NULL;
+  GtkTreeIter              iter;
+  ThunarxMenuItem         *menu_item;
+  ThunarxMenuItem         *item;
+  GList                   *items = NULL;
+  GList                   *paths;
+  GList                   *lp;
+  ThunarxMenu             *submenu;
+  ThunarxMenu             *parent_menu = NULL;
+
+  /* look at all files in one go */
+  snapshot = thunarx_file_info_snapshot_new (files);
+  paths = thunar_uca_model_match (uca_provider->model, snapshot);
+  thunarx_file_info_snapshot_unref (snapshot);
 
   for (lp = g_list_last (paths); lp != NULL; lp = lp->prev)
     {
@@ -405,24 +417,25 @@ static void
 thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
                                ThunarxMenuItem   *item)
 {
-  GtkTreeRowReference *row;
-  ThunarUcaContext    *uca_context;
-  GtkTreePath         *path;
-  GtkTreeIter          iter;
-  GtkWidget           *dialog;
-  GtkWidget           *window;
-  gboolean             succeed;
-  GError              *error = NULL;
-  GList               *files;
-  gchar              **argv;
-  gchar               *working_directory = NULL;
-  gchar               *filename;
-  gchar               *label;
-  GFile               *location;
-  gint                 argc;
-  gchar               *icon_name = NULL;
-  gboolean             startup_notify;
-  GClosure            *child_watch;
+  ThunarxFileInfoSnapshot *snapshot;
+  GtkTreeRowReference     *row;
+  ThunarUcaContext        *uca_context;
+  GtkTreePath             *path;
+  GtkTreeIter              iter;
+  GtkWidget               *dialog;
+  GtkWidget               *window;
+  gboolean                 succeed;
+  GError                  *error = NULL;
+  GList                   *files;
+  gchar                  **argv;
+  gchar                   *working_directory = NULL;
+  const gchar             *filename;
+  gchar                   *label;
+  gint                     argc;
+  gchar                   *icon_name = NULL;
+  gboolean                 startup_notify;
+  guint                    parallel_jobs;
+  GClosure                *child_watch;
 
   g_return_if_fail (THUNAR_UCA_IS_PROVIDER (uca_provider));
   g_return_if_fail (THUNARX_IS_MENU_ITEM (item));
@@ -442,8 +455,19 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
   window = thunar_uca_context_get_window (uca_context);
   files = thunar_uca_context_get_files (uca_context);
 
+  /* check whether the command should be run once per file */
+  gtk_tree_model_get (GTK_TREE_MODEL (uca_provider->model), &iter,
+                      THUNAR_UCA_MODEL_COLUMN_PARALLEL_JOBS, &parallel_jobs,
+                      -1);
+  if (parallel_jobs > 0 && files != NULL && files->next != NULL)
+    {
+      succeed = thunar_uca_provider_run_each (uca_provider, item, &iter, window, files, parallel_jobs, &error);
+      goto done;
+    }
+
   /* determine the argc/argv for the item */
-  succeed = thunar_uca_model_parse_argv (uca_provider->model, &iter, files, &argc, &argv, &error);
+  snapshot = thunarx_file_info_snapshot_new (files);
+  succeed = thunar_uca_model_parse_argv (uca_provider->model, &iter, snapshot, &argc, &argv, &error);
   if (G_LIKELY (succeed))
     {
       /* get the icon name and whether startup notification is active */
@@ -453,26 +477,18 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
                           -1);
 
       /* determine the working from the first file */
-      if (G_LIKELY (files != NULL))
+      if (G_LIKELY (thunarx_file_info_snapshot_get_n_files (snapshot) > 0))
         {
           /* determine the filename of the first selected file */
-          location = thunarx_file_info_get_location (files->data);
-          filename = g_file_get_path (location);
+          filename = thunarx_file_info_snapshot_get_path (snapshot, 0);
           if (G_LIKELY (filename != NULL))
             {
               /* if this is a folder menu item, we just use the filename as working directory */
               if (g_object_get_qdata (G_OBJECT (item), thunar_uca_folder_quark) != NULL)
-                {
-                  working_directory = filename;
-                  filename = NULL;
-                }
+                working_directory = g_strdup (filename);
               else
-                {
-                  working_directory = g_path_get_dirname (filename);
-                }
+                working_directory = g_path_get_dirname (filename);
             }
-          g_free (filename);
-          g_object_unref (location);
         }
 
       /* build closre for child watch */
@@ -516,6 +532,9 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
       g_free (icon_name);
     }
 
+  thunarx_file_info_snapshot_unref (snapshot);
+
+done:
   /* present error message to the user */
   if (G_UNLIKELY (!succeed))
     {
@@ -537,6 +556,55 @@ thunar_uca_provider_activated (ThunarUcaProvider *uca_provider,
 
 
 
+static gboolean
+thunar_uca_provider_run_each (ThunarUcaProvider *uca_provider,
+                              ThunarxMenuItem   *item,
+                              GtkTreeIter       *iter,
+                              GtkWidget         *window,
+                              GList             *files,
+                              guint              max_jobs,
+                              GError           **error)
+{
+  ThunarxFileInfoSnapshot *snapshot;
+  ThunarUcaRunner         *runner;
+  const gchar             *filename;
+  gboolean                 succeed = TRUE;
+  GList                    file_list = { NULL, NULL, NULL };
+  GList                   *lp;
+  gchar                  **argv;
+  gchar                   *label;
+  gint                     argc;
+
+  g_object_get (G_OBJECT (item), "label", &label, NULL);
+  runner = thunar_uca_runner_new (window, label, max_jobs);
+  g_free (label);
+
+  /* expand the command for every file on its own */
+  for (lp = files; succeed && lp != NULL; lp = lp->next)
+    {
+      file_list.data = lp->data;
+      snapshot = thunarx_file_info_snapshot_new (&file_list);
+      succeed = thunar_uca_model_parse_argv (uca_provider->model, iter, snapshot, &argc, &argv, error);
+      if (G_LIKELY (succeed))
+        {
+          /* run each command in the folder of its file */
+          filename = thunarx_file_info_snapshot_get_path (snapshot, 0);
+          thunar_uca_runner_add (runner, argv, (filename != NULL) ? g_path_get_dirname (filename) : NULL);
+        }
+      thunarx_file_info_snapshot_unref (snapshot);
+    }
+
+  /* the runner releases itself once all commands are done */
+  if (G_LIKELY (succeed))
+    thunar_uca_runner_start (runner);
+  else
+    thunar_uca_runner_free (runner);
+
+  return succeed;
+}
+
+
+
 static void
 thunar_uca_provider_child_watch (ThunarUcaProvider *uca_provider,
                                  gint               exit_status)
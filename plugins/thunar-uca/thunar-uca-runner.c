@@ -0,0 +1,435 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+
+#include <glib/gi18n-lib.h>
+
+#include <thunar-uca/thunar-uca-runner.h>
+
+
+
+typedef struct _ThunarUcaRunnerJob ThunarUcaRunnerJob;
+
+
+
+static void     thunar_uca_runner_job_free    (ThunarUcaRunnerJob *job);
+static void     thunar_uca_runner_response    (ThunarUcaRunner    *runner,
+                                               gint                response_id);
+static void     thunar_uca_runner_cancel      (ThunarUcaRunner    *runner);
+static void     thunar_uca_runner_spawn_next  (ThunarUcaRunner    *runner);
+static void     thunar_uca_runner_child_watch (GPid                pid,
+                                               gint                status,
+                                               gpointer            user_data);
+static void     thunar_uca_runner_update      (ThunarUcaRunner    *runner);
+static void     thunar_uca_runner_finish      (ThunarUcaRunner    *runner);
+
+
+
+struct _ThunarUcaRunner
+{
+  GtkWidget  *window;
+  GtkWidget  *dialog;
+  GtkWidget  *progress_bar;
+  gchar      *label;
+
+  /* jobs waiting for a free slot and jobs currently running */
+  GQueue      pending;
+  GList      *running;
+  guint       max_jobs;
+
+  guint       n_jobs;
+  guint       n_finished;
+  guint       n_failed;
+  GError     *error;
+
+  /* working directories to refresh once we're done */
+  GHashTable *directories;
+
+  guint       cancelled : 1;
+};
+
+struct _ThunarUcaRunnerJob
+{
+  ThunarUcaRunner *runner;
+  gchar          **argv;
+  gchar           *working_directory;
+  GPid             pid;
+};
+
+
+
+/**
+ * thunar_uca_runner_new:
+ * @window   : the #GtkWindow the action was started from.
+ * @label    : the label of the action.
+ * @max_jobs : the maximum number of commands running at a time.
+ *
+ * Allocates a new #ThunarUcaRunner, which runs the commands
+ * queued with thunar_uca_runner_add(), at most @max_jobs of
+ * them at the same time.
+ *
+ * The runner frees itself once all commands have finished
+ * or the user cancelled the action, it must not be used
+ * after thunar_uca_runner_start() was called.
+ *
+ * Return value: the newly allocated #ThunarUcaRunner.
+ **/
+ThunarUcaRunner*
+thunar_uca_runner_new (GtkWidget   *window,
+                       const gchar *label,
+                       guint        max_jobs)
+{
+  ThunarUcaRunner *runner;
+
+  g_return_val_if_fail (window == NULL || GTK_IS_WINDOW (window), NULL);
+  g_return_val_if_fail (max_jobs > 0, NULL);
+
+  runner = g_new0 (ThunarUcaRunner, 1);
+  runner->window = window;
+  runner->label = g_strdup (label);
+  runner->max_jobs = max_jobs;
+  runner->directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_queue_init (&runner->pending);
+
+  /* add a weak reference on the window */
+  if (G_LIKELY (runner->window != NULL))
+    g_object_add_weak_pointer (G_OBJECT (runner->window), (gpointer) &runner->window);
+
+  return runner;
+}
+
+
+
+/**
+ * thunar_uca_runner_add:
+ * @runner            : a #ThunarUcaRunner.
+ * @argv              : the command line to run.
+ * @working_directory : the working directory for @argv or %NULL.
+ *
+ * Queues @argv to be run by @runner. The @runner takes over
+ * ownership of both @argv and @working_directory.
+ **/
+void
+thunar_uca_runner_add (ThunarUcaRunner *runner,
+                       gchar          **argv,
+                       gchar           *working_directory)
+{
+  ThunarUcaRunnerJob *job;
+
+  g_return_if_fail (runner != NULL);
+  g_return_if_fail (argv != NULL);
+
+  job = g_new0 (ThunarUcaRunnerJob, 1);
+  job->runner = runner;
+  job->argv = argv;
+  job->working_directory = working_directory;
+  g_queue_push_tail (&runner->pending, job);
+  runner->n_jobs += 1;
+}
+
+
+
+/**
+ * thunar_uca_runner_free:
+ * @runner : a #ThunarUcaRunner.
+ *
+ * Releases a @runner that was never started, along
+ * with all the commands queued on it.
+ **/
+void
+thunar_uca_runner_free (ThunarUcaRunner *runner)
+{
+  ThunarUcaRunnerJob *job;
+
+  g_return_if_fail (runner != NULL);
+  g_return_if_fail (runner->running == NULL);
+
+  while ((job = g_queue_pop_head (&runner->pending)) != NULL)
+    thunar_uca_runner_job_free (job);
+
+  /* drop the weak ref on the window */
+  if (G_LIKELY (runner->window != NULL))
+    g_object_remove_weak_pointer (G_OBJECT (runner->window), (gpointer) &runner->window);
+
+  g_hash_table_destroy (runner->directories);
+  g_clear_error (&runner->error);
+  g_free (runner->label);
+  g_free (runner);
+}
+
+
+
+/**
+ * thunar_uca_runner_start:
+ * @runner : a #ThunarUcaRunner.
+ *
+ * Shows the progress dialog for @runner and starts running
+ * the queued commands.
+ **/
+void
+thunar_uca_runner_start (ThunarUcaRunner *runner)
+{
+  GtkWidget *content_area;
+
+  g_return_if_fail (runner != NULL);
+
+  /* setup the progress dialog */
+  runner->dialog = gtk_dialog_new_with_buttons (runner->label, (GtkWindow *) runner->window,
+                                                GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                _("_Cancel"), GTK_RESPONSE_CANCEL,
+                                                NULL);
+  gtk_window_set_default_size (GTK_WINDOW (runner->dialog), 350, -1);
+  g_object_add_weak_pointer (G_OBJECT (runner->dialog), (gpointer) &runner->dialog);
+  g_signal_connect_swapped (G_OBJECT (runner->dialog), "response", G_CALLBACK (thunar_uca_runner_response), runner);
+
+  content_area = gtk_dialog_get_content_area (GTK_DIALOG (runner->dialog));
+  gtk_container_set_border_width (GTK_CONTAINER (content_area), 12);
+
+  runner->progress_bar = gtk_progress_bar_new ();
+  gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (runner->progress_bar), TRUE);
+  gtk_box_pack_start (GTK_BOX (content_area), runner->progress_bar, FALSE, FALSE, 0);
+  gtk_widget_show_all (runner->dialog);
+
+  /* fill the available slots */
+  thunar_uca_runner_spawn_next (runner);
+}
+
+
+
+static void
+thunar_uca_runner_job_free (ThunarUcaRunnerJob *job)
+{
+  g_strfreev (job->argv);
+  g_free (job->working_directory);
+  g_free (job);
+}
+
+
+
+static void
+thunar_uca_runner_response (ThunarUcaRunner *runner,
+                            gint             response_id)
+{
+  /* both the cancel button and closing the dialog stop the action */
+  thunar_uca_runner_cancel (runner);
+}
+
+
+
+static void
+thunar_uca_runner_cancel (ThunarUcaRunner *runner)
+{
+  ThunarUcaRunnerJob *job;
+  GList              *lp;
+
+  if (runner->cancelled)
+    return;
+
+  runner->cancelled = TRUE;
+
+  /* drop the commands that did not start yet */
+  while ((job = g_queue_pop_head (&runner->pending)) != NULL)
+    thunar_uca_runner_job_free (job);
+
+  /* ask the running commands to terminate, their child
+   * watches will finish the runner once they are gone */
+  for (lp = runner->running; lp != NULL; lp = lp->next)
+    {
+      job = lp->data;
+      kill ((pid_t) job->pid, SIGTERM);
+    }
+
+  if (G_LIKELY (runner->dialog != NULL))
+    gtk_dialog_set_response_sensitive (GTK_DIALOG (runner->dialog), GTK_RESPONSE_CANCEL, FALSE);
+
+  if (runner->running == NULL)
+    thunar_uca_runner_finish (runner);
+}
+
+
+
+static void
+thunar_uca_runner_spawn_next (ThunarUcaRunner *runner)
+{
+  ThunarUcaRunnerJob *job;
+  GError             *error = NULL;
+
+  while (!runner->cancelled && g_list_length (runner->running) < runner->max_jobs)
+    {
+      job = g_queue_pop_head (&runner->pending);
+      if (job == NULL)
+        break;
+
+      if (g_spawn_async (job->working_directory, job->argv, NULL,
+                         G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+                         NULL, NULL, &job->pid, &error))
+        {
+          g_child_watch_add (job->pid, thunar_uca_runner_child_watch, job);
+          runner->running = g_list_prepend (runner->running, job);
+        }
+      else
+        {
+          /* remember the first error for the final report */
+          if (runner->error == NULL)
+            runner->error = error;
+          else
+            g_error_free (error);
+          error = NULL;
+
+          runner->n_failed += 1;
+          runner->n_finished += 1;
+          thunar_uca_runner_job_free (job);
+        }
+    }
+
+  thunar_uca_runner_update (runner);
+
+  if (runner->running == NULL && g_queue_is_empty (&runner->pending))
+    thunar_uca_runner_finish (runner);
+}
+
+
+
+static void
+thunar_uca_runner_child_watch (GPid     pid,
+                               gint     status,
+                               gpointer user_data)
+{
+  ThunarUcaRunnerJob *job = user_data;
+  ThunarUcaRunner    *runner = job->runner;
+  GError             *error = NULL;
+
+  g_spawn_close_pid (pid);
+
+  runner->running = g_list_remove (runner->running, job);
+  runner->n_finished += 1;
+
+  /* a command killed by cancelling the action did not fail */
+  if (!g_spawn_check_exit_status (status, &error))
+    {
+      if (!runner->cancelled)
+        {
+          runner->n_failed += 1;
+          if (runner->error == NULL)
+            runner->error = g_error_copy (error);
+        }
+      g_error_free (error);
+    }
+
+  /* the command may have changed the folder of the file */
+  if (job->working_directory != NULL)
+    {
+      g_hash_table_add (runner->directories, job->working_directory);
+      job->working_directory = NULL;
+    }
+
+  thunar_uca_runner_job_free (job);
+
+  if (runner->cancelled)
+    {
+      if (runner->running == NULL)
+        thunar_uca_runner_finish (runner);
+    }
+  else
+    {
+      thunar_uca_runner_spawn_next (runner);
+    }
+}
+
+
+
+static void
+thunar_uca_runner_update (ThunarUcaRunner *runner)
+{
+  gchar *text;
+
+  /* the dialog may have been destroyed together with the window */
+  if (G_UNLIKELY (runner->dialog == NULL))
+    return;
+
+  /* TRANSLATORS: progress of an action run for every selected file */
+  text = g_strdup_printf (_("%u of %u files"), runner->n_finished, runner->n_jobs);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (runner->progress_bar), text);
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (runner->progress_bar),
+                                 (gdouble) runner->n_finished / MAX (runner->n_jobs, 1));
+  g_free (text);
+}
+
+
+
+static void
+thunar_uca_runner_finish (ThunarUcaRunner *runner)
+{
+  GFileMonitor  *monitor;
+  GHashTableIter iter;
+  GtkWidget     *dialog;
+  gpointer       key;
+  GFile         *file;
+
+  /* close the progress dialog, unless it went away with the window */
+  if (G_LIKELY (runner->dialog != NULL))
+    {
+      g_object_remove_weak_pointer (G_OBJECT (runner->dialog), (gpointer) &runner->dialog);
+      gtk_widget_destroy (runner->dialog);
+    }
+
+  /* schedule a changed notification on the folders we ran in */
+  g_hash_table_iter_init (&iter, runner->directories);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      file = g_file_new_for_path (key);
+      monitor = g_file_monitor (file, G_FILE_MONITOR_NONE, NULL, NULL);
+      if (monitor != NULL)
+        {
+          g_file_monitor_emit_event (monitor, file, file, G_FILE_MONITOR_EVENT_CHANGED);
+          g_object_unref (monitor);
+        }
+      g_object_unref (file);
+    }
+
+  /* present error message to the user */
+  if (G_UNLIKELY (runner->n_failed > 0))
+    {
+      dialog = gtk_message_dialog_new ((GtkWindow *) runner->window,
+                                       GTK_DIALOG_DESTROY_WITH_PARENT
+                                       | GTK_DIALOG_MODAL,
+                                       GTK_MESSAGE_ERROR,
+                                       GTK_BUTTONS_CLOSE,
+                                       _("Action \"%s\" failed for %u of %u files."),
+                                       runner->label, runner->n_failed, runner->n_jobs);
+      gtk_window_set_title (GTK_WINDOW (dialog), _("Error"));
+      if (runner->error != NULL)
+        gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s.", runner->error->message);
+      gtk_dialog_run (GTK_DIALOG (dialog));
+      gtk_widget_destroy (dialog);
+    }
+
+  thunar_uca_runner_free (runner);
+}
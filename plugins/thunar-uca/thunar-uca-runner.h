@@ -0,0 +1,44 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __THUNAR_UCA_RUNNER_H__
+#define __THUNAR_UCA_RUNNER_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarUcaRunner ThunarUcaRunner;
+
+ThunarUcaRunner *thunar_uca_runner_new   (GtkWidget       *window,
+                                          const gchar     *label,
+                                          guint            max_jobs);
+
+void             thunar_uca_runner_add   (ThunarUcaRunner *runner,
+                                          gchar          **argv,
+                                          gchar           *working_directory);
+
+void             thunar_uca_runner_free  (ThunarUcaRunner *runner);
+
+void             thunar_uca_runner_start (ThunarUcaRunner *runner);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_UCA_RUNNER_H__ */
@@ -34,6 +34,13 @@
 
 
 
+/* number of items from which all items get the same size,
+ * see thunar_abstract_icon_view_uniform_layout_idle() */
+#define THUNAR_ABSTRACT_ICON_VIEW_UNIFORM_MIN_ITEMS 5000
+
+
+
+static void         thunar_abstract_icon_view_finalize                (GObject                      *object);
 static void         thunar_abstract_icon_view_style_set               (GtkWidget                    *widget,
                                                                        GtkStyle                     *previous_style);
 static GList       *thunar_abstract_icon_view_get_selected_items      (ThunarStandardView           *standard_view);
@@ -81,6 +88,8 @@ static void         thunar_abstract_icon_view_item_activated          (ExoIconVi
                                                                        ThunarAbstractIconView       *abstract_icon_view);
 static void         thunar_abstract_icon_view_zoom_level_changed      (ThunarAbstractIconView       *abstract_icon_view);
 static void         thunar_abstract_icon_view_queue_redraw            (ThunarStandardView           *standard_view);
+static void         thunar_abstract_icon_view_queue_uniform_layout    (ThunarAbstractIconView       *abstract_icon_view);
+static gboolean     thunar_abstract_icon_view_uniform_layout_idle     (gpointer                      data);
 
 
 
@@ -96,6 +105,10 @@ struct _ThunarAbstractIconViewPrivate
   gulong gesture_release_id;
 
   gboolean button_pressed;
+
+  /* number of text lines every item is sized for, 0 if the items are measured */
+  gint     uniform_lines;
+  guint    uniform_layout_idle_id;
 };
 
 
@@ -108,6 +121,10 @@ thunar_abstract_icon_view_class_init (ThunarAbstractIconViewClass *klass)
 {
   ThunarStandardViewClass *thunarstandard_view_class;
   GtkWidgetClass          *gtkwidget_class;
+  GObjectClass            *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_abstract_icon_view_finalize;
 
   gtkwidget_class = GTK_WIDGET_CLASS (klass);
   gtkwidget_class->style_set = thunar_abstract_icon_view_style_set;
@@ -177,6 +194,7 @@ thunar_abstract_icon_view_init (ThunarAbstractIconView *abstract_icon_view)
 
   /* initialize the abstract icon view properties */
   exo_icon_view_set_enable_search (EXO_ICON_VIEW (view), TRUE);
+  exo_icon_view_set_search_equal_func (EXO_ICON_VIEW (view), thunar_standard_view_search_equal, NULL, NULL);
   exo_icon_view_set_selection_mode (EXO_ICON_VIEW (view), GTK_SELECTION_MULTIPLE);
 
   /* add the abstract icon renderer */
@@ -198,6 +216,32 @@ thunar_abstract_icon_view_init (ThunarAbstractIconView *abstract_icon_view)
    * we can probably remove this in the future. */
   g_signal_connect_swapped (G_OBJECT (abstract_icon_view), "size-allocate",
                             G_CALLBACK (gtk_widget_queue_resize), view);
+
+  /* measuring every single name of a very large folder takes long,
+   * so such folders switch to items of the same size */
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "row-inserted",
+                           G_CALLBACK (thunar_abstract_icon_view_queue_uniform_layout), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->model), "row-deleted",
+                           G_CALLBACK (thunar_abstract_icon_view_queue_uniform_layout), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (THUNAR_STANDARD_VIEW (abstract_icon_view)->preferences), "notify::misc-icon-view-fast-layout",
+                           G_CALLBACK (thunar_abstract_icon_view_queue_uniform_layout), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (view), "notify::orientation",
+                           G_CALLBACK (thunar_abstract_icon_view_queue_uniform_layout), abstract_icon_view, G_CONNECT_SWAPPED);
+  g_signal_connect_object (G_OBJECT (view), "notify::layout-mode",
+                           G_CALLBACK (thunar_abstract_icon_view_queue_uniform_layout), abstract_icon_view, G_CONNECT_SWAPPED);
+}
+
+
+
+static void
+thunar_abstract_icon_view_finalize (GObject *object)
+{
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (object);
+
+  if (abstract_icon_view->priv->uniform_layout_idle_id != 0)
+    g_source_remove (abstract_icon_view->priv->uniform_layout_idle_id);
+
+  (*G_OBJECT_CLASS (thunar_abstract_icon_view_parent_class)->finalize) (object);
 }
 
 
@@ -675,3 +719,56 @@ thunar_abstract_icon_view_queue_redraw (ThunarStandardView *standard_view)
   _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (standard_view));
   gtk_widget_queue_draw (gtk_bin_get_child (GTK_BIN (standard_view)));
 }
+
+
+
+static void
+thunar_abstract_icon_view_queue_uniform_layout (ThunarAbstractIconView *abstract_icon_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (abstract_icon_view));
+
+  /* run before the icon view lays out the new items */
+  if (abstract_icon_view->priv->uniform_layout_idle_id == 0)
+    abstract_icon_view->priv->uniform_layout_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_abstract_icon_view_uniform_layout_idle, abstract_icon_view, NULL);
+}
+
+
+
+static gboolean
+thunar_abstract_icon_view_uniform_layout_idle (gpointer data)
+{
+  ThunarAbstractIconView *abstract_icon_view = THUNAR_ABSTRACT_ICON_VIEW (data);
+  ThunarStandardView     *standard_view = THUNAR_STANDARD_VIEW (abstract_icon_view);
+  ExoIconView            *view = EXO_ICON_VIEW (gtk_bin_get_child (GTK_BIN (abstract_icon_view)));
+  gboolean                enabled;
+  gint                    n_items;
+  gint                    lines = 0;
+
+  abstract_icon_view->priv->uniform_layout_idle_id = 0;
+
+  g_object_get (G_OBJECT (standard_view->preferences), "misc-icon-view-fast-layout", &enabled, NULL);
+  n_items = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (standard_view->model), NULL);
+
+  /* the uniform height is the number of lines a name usually takes in the view:
+   * one in the compact view, a few wrapped lines below or beside the icons */
+  if (enabled && n_items >= THUNAR_ABSTRACT_ICON_VIEW_UNIFORM_MIN_ITEMS)
+    {
+      if (exo_icon_view_get_layout_mode (view) == EXO_ICON_VIEW_LAYOUT_COLS)
+        lines = 1;
+      else if (exo_icon_view_get_orientation (view) == GTK_ORIENTATION_VERTICAL)
+        lines = 3;
+      else
+        lines = 2;
+    }
+
+  if (abstract_icon_view->priv->uniform_lines != lines)
+    {
+      abstract_icon_view->priv->uniform_lines = lines;
+      g_object_set (G_OBJECT (standard_view->name_renderer), "uniform-lines", lines, NULL);
+
+      /* resetting the cell data function makes the icon view measure its items again */
+      thunar_abstract_icon_view_zoom_level_changed (abstract_icon_view);
+    }
+
+  return FALSE;
+}
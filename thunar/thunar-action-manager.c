@@ -36,6 +36,7 @@
 #include <thunar/thunar-chooser-dialog.h>
 #include <thunar/thunar-clipboard-manager.h>
 #include <thunar/thunar-dialogs.h>
+#include <thunar/thunar-extension-host.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
@@ -85,7 +86,17 @@
 
 
 
-typedef struct _ThunarActionManagerPokeData ThunarActionManagerPokeData;
+/* milliseconds an asynchronous menu provider may take before its placeholder is dropped */
+#define THUNAR_ACTION_MANAGER_PROVIDER_TIMEOUT    (3 * 1000)
+
+/* microseconds the menu items of an asynchronous menu provider are reused for the same files */
+#define THUNAR_ACTION_MANAGER_PROVIDER_CACHE_AGE  (30 * G_USEC_PER_SEC)
+
+
+
+typedef struct _ThunarActionManagerPokeData        ThunarActionManagerPokeData;
+typedef struct _ThunarActionManagerProviderItems   ThunarActionManagerProviderItems;
+typedef struct _ThunarActionManagerProviderRequest ThunarActionManagerProviderRequest;
 
 
 
@@ -129,6 +140,7 @@ static void                    thunar_action_manager_set_current_directory
                                                                                  ThunarFile                     *current_directory);
 static void                    thunar_action_manager_set_selected_files         (ThunarComponent                *component,
                                                                                  GList                          *selected_files);
+static void                    thunar_action_manager_analyze_files              (ThunarActionManager            *action_mgr);
 static void                    thunar_action_manager_execute_files              (ThunarActionManager            *action_mgr,
                                                                                  GList                          *files);
 static void                    thunar_action_manager_open_files                 (ThunarActionManager            *action_mgr,
@@ -202,8 +214,27 @@ static gboolean                thunar_action_manager_action_create_folder
 static gboolean                thunar_action_manager_action_create_document     (ThunarActionManager            *action_mgr,
                                                                                  GtkWidget                      *menu_item);
 static GtkWidget              *thunar_action_manager_create_document_submenu_new(ThunarActionManager            *action_mgr);
+static void                    thunar_action_manager_templates_refresh          (void);
+static void                    thunar_action_manager_templates_changed          (GFileMonitor                   *monitor,
+                                                                                 GFile                          *file,
+                                                                                 GFile                          *other_file,
+                                                                                 GFileMonitorEvent               event_type,
+                                                                                 gpointer                        user_data);
 static void                    thunar_action_manager_new_files_created          (ThunarActionManager            *action_mgr,
                                                                                  GList                          *new_thunar_files);
+static void                    thunar_action_manager_provider_items_free        (gpointer                        data);
+static gchar                  *thunar_action_manager_files_signature            (ThunarActionManager            *action_mgr);
+static void                    thunar_action_manager_insert_provider_items      (GList                          *items,
+                                                                                 GtkMenuShell                   *menu,
+                                                                                 gint                            position);
+static gboolean                thunar_action_manager_provider_request_timeout   (gpointer                        user_data);
+static void                    thunar_action_manager_provider_request_ready     (GObject                        *object,
+                                                                                 GAsyncResult                   *result,
+                                                                                 gpointer                        user_data);
+static gboolean                thunar_action_manager_append_provider_items      (ThunarActionManager            *action_mgr,
+                                                                                 ThunarxMenuProvider            *provider,
+                                                                                 GtkWidget                      *window,
+                                                                                 GtkMenuShell                   *menu);
 
 
 
@@ -222,10 +253,14 @@ struct _ThunarActionManager
   ThunarDevice           *device_to_process;   /* Device to work with */
   GFile                  *location_to_process; /* Location to work with (might be not reachable) */
 
+  /* properties of the files to process, only determined by
+   * thunar_action_manager_analyze_files() once they are needed */
+  gboolean                files_to_process_analyzed;
   gint                    n_files_to_process;
   gint                    n_directories_to_process;
   gint                    n_regulars_to_process;
   gboolean                files_to_process_trashable;
+  gboolean                files_to_process_trashed;   /* at least one of the files is in the trash */
   gboolean                files_are_selected;
   gboolean                files_are_all_executable;
   gboolean                single_directory_to_process;
@@ -243,6 +278,12 @@ struct _ThunarActionManager
 
   /* TRUE if the active view is displaying search results or actively searching for files */
   gboolean                is_searching;
+
+  /* ThunarxMenuProvider -> ThunarActionManagerProviderItems, for asynchronous providers */
+  GHashTable             *provider_items;
+
+  /* menu provider for the out-of-process extensions, or NULL */
+  ThunarExtensionHost    *extension_host;
 };
 
 static GQuark thunar_action_manager_appinfo_quark;
@@ -251,6 +292,36 @@ static GQuark thunar_action_manager_file_quark;
 
 static guint action_manager_signals[LAST_SIGNAL];
 
+/* snapshot of the templates tree for the "Create Document" menus of all
+ * action managers, refreshed in the background when the tree changes */
+static struct
+{
+  GFile     *directory;   /* the templates folder of the snapshot */
+  guint      max_files;   /* misc-max-number-of-templates of the snapshot */
+  GList     *files;       /* ThunarFiles of the tree, sorted for the menu */
+  gboolean   exceeded;    /* whether the tree holds more than max_files */
+  GList     *monitors;    /* GFileMonitors of the folders in the tree */
+  ThunarJob *job;         /* rescanning the tree, or NULL */
+  gboolean   stale;       /* whether the tree changed during the rescan */
+} templates;
+
+struct _ThunarActionManagerProviderItems
+{
+  gchar        *signature;     /* URIs of the files the items were requested for */
+  GList        *items;         /* List of ThunarxMenuItems */
+  gint64        timestamp;     /* monotonic time the items arrived */
+  gboolean      pending;       /* TRUE while a request for signature is running */
+};
+
+struct _ThunarActionManagerProviderRequest
+{
+  ThunarActionManager *action_mgr;
+  ThunarxMenuProvider *provider;
+  gchar               *signature;
+  GtkWidget           *placeholder;
+  guint                timeout_id;
+};
+
 struct _ThunarActionManagerPokeData
 {
   GList        *files_to_poke; /* List of thunar-files */
@@ -470,6 +541,11 @@ thunar_action_manager_init (ThunarActionManager *action_mgr)
   g_closure_sink (action_mgr->new_files_created_closure);
 
   action_mgr->is_searching = FALSE;
+
+  action_mgr->provider_items = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref,
+                                                      thunar_action_manager_provider_items_free);
+
+  action_mgr->extension_host = thunar_extension_host_get_default ();
 }
 
 
@@ -516,6 +592,11 @@ thunar_action_manager_finalize (GObject *object)
   /* release the preferences reference */
   g_object_unref (action_mgr->preferences);
 
+  /* drop the cached menu provider items */
+  g_hash_table_destroy (action_mgr->provider_items);
+  if (action_mgr->extension_host != NULL)
+    g_object_unref (action_mgr->extension_host);
+
   (*G_OBJECT_CLASS (thunar_action_manager_parent_class)->finalize) (object);
 }
 
@@ -625,7 +706,6 @@ thunar_action_manager_set_selected_files (ThunarComponent *component,
                                           GList           *selected_files)
 {
   ThunarActionManager *action_mgr = THUNAR_ACTION_MANAGER (component);
-  GList               *lp;
 
   /* That happens at startup for some reason */
   if (action_mgr->current_directory == NULL)
@@ -644,11 +724,40 @@ thunar_action_manager_set_selected_files (ThunarComponent *component,
     g_object_unref (action_mgr->parent_folder);
   action_mgr->parent_folder = NULL;
 
-  action_mgr->files_are_selected = TRUE;
-  if (selected_files == NULL || g_list_length (selected_files) == 0)
-    action_mgr->files_are_selected = FALSE;
+  action_mgr->files_are_selected = (selected_files != NULL);
+
+  /* if nothing is selected, the current directory is the folder to use for all menus */
+  if (action_mgr->files_are_selected)
+    action_mgr->files_to_process = thunar_g_list_copy_deep (selected_files);
+  else
+    action_mgr->files_to_process = g_list_append (action_mgr->files_to_process, g_object_ref (action_mgr->current_directory));
+
+  /* selections change much more often than menus are built */
+  action_mgr->files_to_process_analyzed = FALSE;
+
+  if (action_mgr->files_to_process != NULL)
+    {
+      /* just grab the folder of the first selected item */
+      action_mgr->parent_folder = thunar_file_get_parent (THUNAR_FILE (action_mgr->files_to_process->data), NULL);
+    }
+}
+
+
+
+static void
+thunar_action_manager_analyze_files (ThunarActionManager *action_mgr)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr));
+
+  if (action_mgr->files_to_process_analyzed)
+    return;
+
+  action_mgr->files_to_process_analyzed = TRUE;
 
   action_mgr->files_to_process_trashable  = TRUE;
+  action_mgr->files_to_process_trashed    = FALSE;
   action_mgr->n_files_to_process          = 0;
   action_mgr->n_directories_to_process    = 0;
   action_mgr->n_regulars_to_process       = 0;
@@ -656,11 +765,6 @@ thunar_action_manager_set_selected_files (ThunarComponent *component,
   action_mgr->single_directory_to_process = FALSE;
   action_mgr->single_folder               = NULL;
 
-  /* if nothing is selected, the current directory is the folder to use for all menus */
-  if (action_mgr->files_are_selected)
-    action_mgr->files_to_process = thunar_g_list_copy_deep (selected_files);
-  else
-    action_mgr->files_to_process = g_list_append (action_mgr->files_to_process, g_object_ref (action_mgr->current_directory));
 
   /* determine the number of files/directories/executables */
   for (lp = action_mgr->files_to_process; lp != NULL; lp = lp->next, ++action_mgr->n_files_to_process)
@@ -681,6 +785,9 @@ thunar_action_manager_set_selected_files (ThunarComponent *component,
 
       if (!thunar_file_can_be_trashed (lp->data))
         action_mgr->files_to_process_trashable = FALSE;
+
+      if (G_UNLIKELY (thunar_file_is_trashed (lp->data)))
+        action_mgr->files_to_process_trashed = TRUE;
     }
 
   action_mgr->single_directory_to_process = (action_mgr->n_directories_to_process == 1 && action_mgr->n_files_to_process == 1);
@@ -689,12 +796,6 @@ thunar_action_manager_set_selected_files (ThunarComponent *component,
       /* grab the folder of the first selected item */
       action_mgr->single_folder = THUNAR_FILE (action_mgr->files_to_process->data);
     }
-
-  if (action_mgr->files_to_process != NULL)
-    {
-      /* just grab the folder of the first selected item */
-      action_mgr->parent_folder = thunar_file_get_parent (THUNAR_FILE (action_mgr->files_to_process->data), NULL);
-    }
 }
 
 
@@ -808,7 +909,8 @@ thunar_action_manager_execute_files (ThunarActionManager *action_mgr,
 static guint
 thunar_action_manager_g_app_info_hash (gconstpointer app_info)
 {
-  return 0;
+  /* equal applications are those with the same name, see thunar_g_app_info_equal() */
+  return g_str_hash (g_app_info_get_name (G_APP_INFO (app_info)));
 }
 
 
@@ -818,16 +920,19 @@ thunar_action_manager_open_files (ThunarActionManager *action_mgr,
                                   GList               *files,
                                   GAppInfo            *application_to_use)
 {
-  GHashTable *applications;
-  GAppInfo   *app_info;
-  GList      *lp;
+  GHashTableIter iter;
+  GHashTable    *applications;
+  GAppInfo      *app_info;
+  gpointer       key;
+  gpointer       file_list;
+  GList         *lp;
 
   /* allocate a hash table to associate applications to URIs. since GIO allocates
-   * new GAppInfo objects every time, g_direct_hash does not work. we therefore use
-   * a fake hash function to always hit the collision list of the hash table and
-   * avoid storing multiple equal GAppInfos by means of g_app_info_equal(). */
+   * new GAppInfo objects every time, g_direct_hash does not work. we therefore hash
+   * the names and avoid storing multiple equal GAppInfos by means of
+   * thunar_g_app_info_equal(). */
   applications = g_hash_table_new_full (thunar_action_manager_g_app_info_hash,
-                                        (GEqualFunc) g_app_info_equal,
+                                        (GEqualFunc) thunar_g_app_info_equal,
                                         (GDestroyNotify) g_object_unref,
                                         (GDestroyNotify) thunar_g_list_free_full);
 
@@ -852,30 +957,17 @@ thunar_action_manager_open_files (ThunarActionManager *action_mgr,
       /* check if we have an application here */
       if (G_LIKELY (app_info != NULL))
         {
-          /* check if we have that application already */
-          /* Not possibly to check via g_hash_table_lookup directly, since that will only compare pointers */
-          GList *keys      = g_hash_table_get_keys (applications);
-          GList *file_list = NULL;
-
-          for (GList *lp_keys = keys;  lp_keys != NULL; lp_keys = lp_keys->next)
+          /* check if we have that application already, and take over its list */
+          file_list = NULL;
+          if (g_hash_table_steal_extended (applications, app_info, &key, &file_list))
             {
-              if (thunar_g_app_info_equal (lp_keys->data, app_info))
-                {
-                  /* Reuse the existing appinfo instead of adding the new one to the list*/
-                  g_object_unref (app_info);
-                  app_info = g_object_ref (lp_keys->data);
-
-                  file_list = g_hash_table_lookup (applications, app_info);
-
-                  /* take a copy of the list as the old one will be dropped by the insert */
-                  file_list = thunar_g_list_copy_deep (file_list);
-                }
+              /* Reuse the existing appinfo instead of adding the new one to the list*/
+              g_object_unref (app_info);
+              app_info = key;
             }
 
-          g_list_free (keys);
-
-          /* append our new URI to the list */
-          file_list = thunar_g_list_append_deep (file_list, thunar_file_get_file (lp->data));
+          /* prepend our new URI to the list, the lists are reversed below */
+          file_list = g_list_prepend (file_list, g_object_ref (thunar_file_get_file (lp->data)));
 
           /* (re)insert the URI list for the application */
           g_hash_table_insert (applications, app_info, file_list);
@@ -888,8 +980,16 @@ thunar_action_manager_open_files (ThunarActionManager *action_mgr,
         }
     }
 
-  /* run all collected applications */
-  g_hash_table_foreach (applications, (GHFunc) thunar_action_manager_open_paths, action_mgr);
+  /* run all collected applications, with the files in the order they were given */
+  g_hash_table_iter_init (&iter, applications);
+  while (g_hash_table_iter_next (&iter, &key, &file_list))
+    {
+      g_hash_table_iter_steal (&iter);
+      file_list = g_list_reverse (file_list);
+      thunar_action_manager_open_paths (key, file_list, action_mgr);
+      thunar_g_list_free_full (file_list);
+      g_object_unref (key);
+    }
 
   /* drop the applications hash table */
   g_hash_table_destroy (applications);
@@ -1444,6 +1544,8 @@ thunar_action_manager_action_open_with_other (ThunarActionManager *action_mgr)
 {
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   if (action_mgr->n_files_to_process == 1)
     thunar_show_chooser_dialog (action_mgr->widget, action_mgr->files_to_process->data, TRUE, FALSE);
 
@@ -1464,6 +1566,8 @@ thunar_action_manager_action_set_default_app (ThunarActionManager *action_mgr)
 {
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   if (action_mgr->n_files_to_process == 1)
     thunar_show_chooser_dialog (action_mgr->widget, action_mgr->files_to_process->data, TRUE, TRUE);
 
@@ -1540,6 +1644,8 @@ thunar_action_manager_append_menu_item (ThunarActionManager       *action_mgr,
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), NULL);
   _thunar_return_val_if_fail (action_entry != NULL, NULL);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   /* This may occur when the thunar-window is build */
   if (G_UNLIKELY (action_mgr->files_to_process == NULL) && action_mgr->device_to_process == NULL)
     return NULL;
@@ -2027,7 +2133,6 @@ static GtkWidget*
 thunar_action_manager_build_sendto_submenu (ThunarActionManager *action_mgr)
 {
   GList                    *lp;
-  gboolean                  linkable = TRUE;
   gchar                    *label_text;
   gchar                    *tooltip_text;
   GtkWidget                *image;
@@ -2064,13 +2169,8 @@ thunar_action_manager_build_sendto_submenu (ThunarActionManager *action_mgr)
         }
     }
 
-  /* Check whether at least one files is located in the trash (to en-/disable the "sendto-desktop" action). */
-  for (lp = action_mgr->files_to_process; lp != NULL; lp = lp->next)
-    {
-      if (G_UNLIKELY (thunar_file_is_trashed (lp->data)))
-        linkable = FALSE;
-    }
-  if (linkable)
+  /* files located in the trash cannot be linked (to en-/disable the "sendto-desktop" action) */
+  if (!action_mgr->files_to_process_trashed)
     {
       action_entry = get_action_entry (THUNAR_ACTION_MANAGER_ACTION_SENDTO_DESKTOP);
       if (action_entry != NULL)
@@ -2212,8 +2312,10 @@ thunar_action_manager_action_make_link (ThunarActionManager *action_mgr)
 
   for (lp = action_mgr->files_to_process; lp != NULL; lp = lp->next)
     {
-      g_files = g_list_append (g_files, thunar_file_get_file (lp->data));
+      g_files = g_list_prepend (g_files, thunar_file_get_file (lp->data));
     }
+  g_files = g_list_reverse (g_files);
+
   /* link the selected files into the current directory, which effectively
    * creates new unique links for the files.
    */
@@ -2264,6 +2366,205 @@ thunar_action_manager_action_duplicate (ThunarActionManager *action_mgr)
 
 
 
+static void
+thunar_action_manager_provider_items_free (gpointer data)
+{
+  ThunarActionManagerProviderItems *provider_items = data;
+
+  g_free (provider_items->signature);
+  thunarx_menu_item_list_free (provider_items->items);
+  g_slice_free (ThunarActionManagerProviderItems, provider_items);
+}
+
+
+
+static gchar *
+thunar_action_manager_files_signature (ThunarActionManager *action_mgr)
+{
+  GString *signature;
+  GList   *lp;
+  gchar   *uri;
+
+  signature = g_string_new (NULL);
+  for (lp = action_mgr->files_to_process; lp != NULL; lp = lp->next)
+    {
+      uri = thunar_file_dup_uri (lp->data);
+      g_string_append (signature, uri);
+      g_string_append_c (signature, '\n');
+      g_free (uri);
+    }
+
+  return g_string_free (signature, FALSE);
+}
+
+
+
+static void
+thunar_action_manager_insert_provider_items (GList        *items,
+                                             GtkMenuShell *menu,
+                                             gint          position)
+{
+  GtkWidget *gtk_menu_item;
+  GList     *lp;
+
+  for (lp = items; lp != NULL; lp = lp->next)
+    {
+      gtk_menu_item = thunar_gtk_menu_thunarx_menu_item_new (lp->data, menu);
+
+      /* the cache keeps its own reference, the menu item holds another one */
+      g_object_ref (lp->data);
+      g_signal_connect_swapped (G_OBJECT (gtk_menu_item), "destroy", G_CALLBACK (g_object_unref), lp->data);
+
+      if (position >= 0)
+        gtk_menu_reorder_child (GTK_MENU (menu), gtk_menu_item, position++);
+    }
+}
+
+
+
+static gboolean
+thunar_action_manager_provider_request_timeout (gpointer user_data)
+{
+  ThunarActionManagerProviderRequest *request = user_data;
+
+  /* give up on this menu, the items will be cached for the next one */
+  request->timeout_id = 0;
+  if (request->placeholder != NULL)
+    gtk_widget_destroy (request->placeholder);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_action_manager_provider_request_ready (GObject      *object,
+                                              GAsyncResult *result,
+                                              gpointer      user_data)
+{
+  ThunarActionManagerProviderRequest *request = user_data;
+  ThunarActionManagerProviderItems   *provider_items;
+  GtkWidget                          *menu;
+  GError                             *error = NULL;
+  GList                              *items;
+  GList                              *children;
+  gint                                position;
+
+  items = thunarx_menu_provider_get_file_menu_items_finish (request->provider, result, &error);
+  if (G_UNLIKELY (error != NULL))
+    {
+      g_warning ("Failed to load menu items: %s", error->message);
+      g_error_free (error);
+    }
+
+  /* remember the items, unless a newer request replaced this one */
+  provider_items = g_hash_table_lookup (request->action_mgr->provider_items, request->provider);
+  if (provider_items != NULL && provider_items->pending
+      && g_strcmp0 (provider_items->signature, request->signature) == 0)
+    {
+      provider_items->items = items;
+      provider_items->timestamp = g_get_monotonic_time ();
+      provider_items->pending = FALSE;
+    }
+  else
+    {
+      thunarx_menu_item_list_free (items);
+      items = NULL;
+    }
+
+  /* replace the placeholder if the menu is still open */
+  if (request->placeholder != NULL)
+    {
+      menu = gtk_widget_get_parent (request->placeholder);
+      children = gtk_container_get_children (GTK_CONTAINER (menu));
+      position = g_list_index (children, request->placeholder);
+      g_list_free (children);
+
+      thunar_action_manager_insert_provider_items (items, GTK_MENU_SHELL (menu), position);
+
+      g_object_remove_weak_pointer (G_OBJECT (request->placeholder), (gpointer *) &request->placeholder);
+      gtk_widget_destroy (request->placeholder);
+    }
+
+  if (request->timeout_id != 0)
+    g_source_remove (request->timeout_id);
+
+  g_object_unref (request->provider);
+  g_object_unref (request->action_mgr);
+  g_free (request->signature);
+  g_slice_free (ThunarActionManagerProviderRequest, request);
+}
+
+
+
+static gboolean
+thunar_action_manager_append_provider_items (ThunarActionManager *action_mgr,
+                                             ThunarxMenuProvider *provider,
+                                             GtkWidget           *window,
+                                             GtkMenuShell        *menu)
+{
+  ThunarActionManagerProviderRequest *request;
+  ThunarActionManagerProviderItems   *provider_items;
+  gchar                              *signature;
+
+  _thunar_return_val_if_fail (THUNARX_IS_MENU_PROVIDER (provider), FALSE);
+
+  signature = thunar_action_manager_files_signature (action_mgr);
+
+  provider_items = g_hash_table_lookup (action_mgr->provider_items, provider);
+  if (provider_items != NULL && g_strcmp0 (provider_items->signature, signature) == 0)
+    {
+      /* a request for these files is still running, its items show up next time */
+      if (provider_items->pending)
+        {
+          g_free (signature);
+          return FALSE;
+        }
+
+      /* reuse recent items for the same files */
+      if (g_get_monotonic_time () - provider_items->timestamp < THUNAR_ACTION_MANAGER_PROVIDER_CACHE_AGE)
+        {
+          g_free (signature);
+          thunar_action_manager_insert_provider_items (provider_items->items, menu, -1);
+          return (provider_items->items != NULL);
+        }
+    }
+
+  if (provider_items == NULL)
+    {
+      provider_items = g_slice_new0 (ThunarActionManagerProviderItems);
+      g_hash_table_insert (action_mgr->provider_items, g_object_ref (provider), provider_items);
+    }
+
+  /* forget the old items and wait for the new ones */
+  g_free (provider_items->signature);
+  provider_items->signature = signature;
+  thunarx_menu_item_list_free (provider_items->items);
+  provider_items->items = NULL;
+  provider_items->pending = TRUE;
+
+  request = g_slice_new0 (ThunarActionManagerProviderRequest);
+  request->action_mgr = g_object_ref (action_mgr);
+  request->provider = g_object_ref (provider);
+  request->signature = g_strdup (signature);
+
+  /* keep the place of the items in the menu until they arrive */
+  request->placeholder = gtk_menu_item_new_with_label (_("Loading..."));
+  gtk_widget_set_sensitive (request->placeholder, FALSE);
+  gtk_menu_shell_append (menu, request->placeholder);
+  gtk_widget_show (request->placeholder);
+  g_object_add_weak_pointer (G_OBJECT (request->placeholder), (gpointer *) &request->placeholder);
+
+  request->timeout_id = g_timeout_add (THUNAR_ACTION_MANAGER_PROVIDER_TIMEOUT, thunar_action_manager_provider_request_timeout, request);
+
+  thunarx_menu_provider_get_file_menu_items_async (provider, window, action_mgr->files_to_process, NULL,
+                                                   thunar_action_manager_provider_request_ready, request);
+
+  return TRUE;
+}
+
+
+
 /**
  * thunar_action_manager_append_custom_actions:
  * @action_mgr: a #ThunarActionManager instance
@@ -2297,6 +2598,10 @@ thunar_action_manager_append_custom_actions (ThunarActionManager *action_mgr,
   providers = thunarx_provider_factory_list_providers (provider_factory, THUNARX_TYPE_MENU_PROVIDER);
   g_object_unref (provider_factory);
 
+  /* the items of the out-of-process extensions come last */
+  if (action_mgr->extension_host != NULL)
+    providers = g_list_append (providers, g_object_ref (action_mgr->extension_host));
+
   if (G_UNLIKELY (providers == NULL))
     return FALSE;
 
@@ -2307,6 +2612,15 @@ thunar_action_manager_append_custom_actions (ThunarActionManager *action_mgr,
   /* load the menu items offered by the menu providers */
   for (lp_provider = providers; lp_provider != NULL; lp_provider = lp_provider->next)
     {
+      /* providers which can answer asynchronously must not block the menu */
+      if (action_mgr->files_are_selected
+          && THUNARX_MENU_PROVIDER_GET_IFACE (lp_provider->data)->get_file_menu_items_async != NULL)
+        {
+          if (thunar_action_manager_append_provider_items (action_mgr, lp_provider->data, window, menu))
+            uca_added = TRUE;
+          continue;
+        }
+
       if (action_mgr->files_are_selected == FALSE)
         thunarx_menu_items = thunarx_menu_provider_get_folder_menu_items (lp_provider->data, window, THUNARX_FILE_INFO (action_mgr->current_directory));
       else
@@ -2431,7 +2745,9 @@ thunar_action_manager_action_rename (ThunarActionManager *action_mgr)
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
-  if (action_mgr->files_to_process == NULL || g_list_length (action_mgr->files_to_process) == 0)
+  thunar_action_manager_analyze_files (action_mgr);
+
+  if (action_mgr->files_to_process == NULL)
     return TRUE;
   if (action_mgr->files_are_selected == FALSE || thunar_file_is_trash (action_mgr->current_directory))
     return TRUE;
@@ -2440,7 +2756,7 @@ thunar_action_manager_action_rename (ThunarActionManager *action_mgr)
   window = gtk_widget_get_toplevel (action_mgr->widget);
 
   /* start renaming if we have exactly one selected file */
-  if (g_list_length (action_mgr->files_to_process) == 1)
+  if (action_mgr->n_files_to_process == 1)
     {
       /* run the rename dialog */
       job = thunar_dialogs_show_rename_file (GTK_WINDOW (window), THUNAR_FILE (action_mgr->files_to_process->data), THUNAR_OPERATION_LOG_OPERATIONS);
@@ -2615,6 +2931,8 @@ thunar_action_manager_action_create_folder (ThunarActionManager *action_mgr)
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   if (thunar_file_is_trash (action_mgr->current_directory) || action_mgr->is_searching)
     return TRUE;
 
@@ -2666,6 +2984,8 @@ thunar_action_manager_action_create_document (ThunarActionManager *action_mgr,
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   if (thunar_file_is_trash (action_mgr->current_directory) || action_mgr->is_searching)
     return TRUE;
 
@@ -2771,6 +3091,187 @@ thunar_action_manager_create_document_submenu_templates_find_parent_menu (Thunar
 
 
 
+static void
+thunar_action_manager_templates_clear (void)
+{
+  GList *lp;
+
+  for (lp = templates.monitors; lp != NULL; lp = lp->next)
+    {
+      g_signal_handlers_disconnect_by_func (lp->data, thunar_action_manager_templates_changed, NULL);
+      g_file_monitor_cancel (lp->data);
+      g_object_unref (lp->data);
+    }
+  g_list_free (templates.monitors);
+  templates.monitors = NULL;
+
+  thunar_g_list_free_full (templates.files);
+  templates.files = NULL;
+}
+
+
+
+/* takes the files of the templates tree and watches its folders */
+static void
+thunar_action_manager_templates_install (GList    *files,
+                                         gboolean  exceeded)
+{
+  GFileMonitor *monitor;
+  GList        *lp;
+
+  thunar_action_manager_templates_clear ();
+
+  /* sort items so that directories come before files and ancestors come
+   * before descendants, see thunar_action_manager_create_document_submenu_templates() */
+  templates.files = g_list_sort (files, (GCompareFunc) (void (*)(void)) thunar_file_compare_by_type);
+  templates.exceeded = exceeded;
+
+  monitor = g_file_monitor_directory (templates.directory, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+  if (monitor != NULL)
+    templates.monitors = g_list_prepend (templates.monitors, monitor);
+
+  for (lp = templates.files; lp != NULL; lp = lp->next)
+    {
+      if (!thunar_file_is_directory (lp->data))
+        continue;
+
+      monitor = g_file_monitor_directory (thunar_file_get_file (lp->data), G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+      if (monitor != NULL)
+        templates.monitors = g_list_prepend (templates.monitors, monitor);
+    }
+
+  for (lp = templates.monitors; lp != NULL; lp = lp->next)
+    g_signal_connect (lp->data, "changed", G_CALLBACK (thunar_action_manager_templates_changed), NULL);
+}
+
+
+
+static gboolean
+thunar_action_manager_templates_scan (ThunarJob  *job,
+                                      GArray     *param_values,
+                                      GError    **error)
+{
+  GFile *directory;
+  GList *files;
+  guint  file_scan_limit;
+
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  file_scan_limit = g_value_get_uint (&g_array_index (param_values, GValue, 1));
+
+  files = thunar_io_scan_directory (job, directory, G_FILE_QUERY_INFO_NONE, TRUE, FALSE, TRUE, &file_scan_limit, NULL);
+
+  /* picked up in the main thread once the job finished */
+  g_object_set_data_full (G_OBJECT (job), "thunar-templates-files", files, (GDestroyNotify) thunar_g_list_free_full);
+  g_object_set_data (G_OBJECT (job), "thunar-templates-exceeded", GUINT_TO_POINTER (file_scan_limit == 0));
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_action_manager_templates_scan_finished (ThunarJob *job)
+{
+  GList    *files;
+  gboolean  exceeded;
+
+  _thunar_return_if_fail (templates.job == job);
+
+  if (!exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      files = g_object_steal_data (G_OBJECT (job), "thunar-templates-files");
+      exceeded = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (job), "thunar-templates-exceeded"));
+      thunar_action_manager_templates_install (files, exceeded);
+    }
+
+  g_signal_handlers_disconnect_by_func (job, thunar_action_manager_templates_scan_finished, NULL);
+  g_object_unref (job);
+  templates.job = NULL;
+
+  /* the tree changed again while it was scanned */
+  if (templates.stale)
+    thunar_action_manager_templates_refresh ();
+}
+
+
+
+/* rescans the templates tree in the background, the menus keep using
+ * the previous snapshot until it is done */
+static void
+thunar_action_manager_templates_refresh (void)
+{
+  templates.stale = TRUE;
+
+  if (templates.job != NULL || templates.directory == NULL)
+    return;
+
+  templates.stale = FALSE;
+  templates.job = thunar_simple_job_new (thunar_action_manager_templates_scan, 2,
+                                         G_TYPE_FILE, templates.directory,
+                                         G_TYPE_UINT, templates.max_files);
+  g_signal_connect (templates.job, "finished", G_CALLBACK (thunar_action_manager_templates_scan_finished), NULL);
+  thunar_job_launch (templates.job);
+}
+
+
+
+static void
+thunar_action_manager_templates_changed (GFileMonitor      *monitor,
+                                         GFile             *file,
+                                         GFile             *other_file,
+                                         GFileMonitorEvent  event_type,
+                                         gpointer           user_data)
+{
+  /* editing a template doesn't change the menu */
+  if (event_type == G_FILE_MONITOR_EVENT_CHANGED
+      || event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+    return;
+
+  thunar_action_manager_templates_refresh ();
+}
+
+
+
+/* returns the snapshot of the templates tree in directory, scanning it
+ * right away if there is none yet for directory or file_scan_limit */
+static GList*
+thunar_action_manager_templates_get (GFile    *directory,
+                                     guint     file_scan_limit,
+                                     gboolean *exceeded)
+{
+  GList *files;
+  guint  n_files_max = file_scan_limit;
+
+  if (templates.directory == NULL
+      || templates.max_files != file_scan_limit
+      || !g_file_equal (templates.directory, directory))
+    {
+      /* a refresh of the previous snapshot is of no use anymore */
+      if (templates.job != NULL)
+        {
+          exo_job_cancel (EXO_JOB (templates.job));
+          g_signal_handlers_disconnect_by_func (templates.job, thunar_action_manager_templates_scan_finished, NULL);
+          g_object_unref (templates.job);
+          templates.job = NULL;
+        }
+
+      if (templates.directory != NULL)
+        g_object_unref (templates.directory);
+      templates.directory = g_object_ref (directory);
+      templates.max_files = file_scan_limit;
+      templates.stale = FALSE;
+
+      files = thunar_io_scan_directory (NULL, directory, G_FILE_QUERY_INFO_NONE, TRUE, FALSE, TRUE, &n_files_max, NULL);
+      thunar_action_manager_templates_install (files, n_files_max == 0);
+    }
+
+  *exceeded = templates.exceeded;
+
+  return templates.files;
+}
+
+
+
 /* recursive helper method in order to create menu items for all available templates */
 static gboolean
 thunar_action_manager_create_document_submenu_templates (ThunarActionManager *action_mgr,
@@ -2797,10 +3298,8 @@ thunar_action_manager_create_document_submenu_templates (ThunarActionManager *ac
   /* get the icon factory */
   icon_factory = thunar_icon_factory_get_default ();
 
-  /* sort items so that directories come before files and ancestors come
-   * before descendants */
-  files = g_list_sort (files, (GCompareFunc) (void (*)(void)) thunar_file_compare_by_type);
-
+  /* the items are sorted so that directories come before files and
+   * ancestors come before descendants, see thunar_action_manager_templates_install() */
   for (lp = g_list_first (files); lp != NULL; lp = lp->next)
     {
       file = lp->data;
@@ -2872,6 +3371,7 @@ thunar_action_manager_create_document_submenu_new (ThunarActionManager *action_m
   GtkWidget       *submenu;
   GtkWidget       *item;
   guint            file_scan_limit;
+  gboolean         exceeded = FALSE;
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), NULL);
 
@@ -2893,8 +3393,8 @@ thunar_action_manager_create_document_submenu_new (ThunarActionManager *action_m
 
   if (G_LIKELY (templates_dir != NULL))
     {
-      /* load the ThunarFiles */
-      files = thunar_io_scan_directory (NULL, templates_dir, G_FILE_QUERY_INFO_NONE, TRUE, FALSE, TRUE, &file_scan_limit, NULL);
+      /* the ThunarFiles of the templates, scanned on first use */
+      files = thunar_action_manager_templates_get (templates_dir, file_scan_limit, &exceeded);
     }
 
   submenu = gtk_menu_new();
@@ -2910,14 +3410,13 @@ thunar_action_manager_create_document_submenu_new (ThunarActionManager *action_m
   else
     {
       thunar_action_manager_create_document_submenu_templates (action_mgr, submenu, files);
-      thunar_g_list_free_full (files);
     }
 
   xfce_gtk_menu_append_separator (GTK_MENU_SHELL (submenu));
   xfce_gtk_image_menu_item_new_from_icon_name (_("_Empty File"), NULL, NULL, G_CALLBACK (thunar_action_manager_action_create_document),
                                                G_OBJECT (action_mgr), "text-x-generic", GTK_MENU_SHELL (submenu));
                                          
-  if (file_scan_limit == 0)
+  if (exceeded)
     {
         xfce_gtk_menu_append_separator (GTK_MENU_SHELL (submenu));
         xfce_gtk_image_menu_item_new_from_icon_name (("The maximum number of templates was exceeded.\n"
@@ -3001,6 +3500,8 @@ thunar_action_manager_action_paste_into_folder (ThunarActionManager *action_mgr)
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   if (!action_mgr->single_directory_to_process)
     return TRUE;
 
@@ -3244,6 +3745,8 @@ thunar_action_manager_append_open_section (ThunarActionManager *action_mgr,
 
   _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
 
+  thunar_action_manager_analyze_files (action_mgr);
+
   /* Usually it is not required to open the current directory */
   if (action_mgr->files_are_selected == FALSE && !force)
     return FALSE;
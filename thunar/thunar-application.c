@@ -51,10 +51,13 @@
 #include <thunar/thunar-gdk-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-metadata-writer.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-progress-dialog.h>
 #include <thunar/thunar-renamer-dialog.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-thumbnail-cache.h>
 #include <thunar/thunar-thumbnailer.h>
 #include <thunar/thunar-transfer-job.h>
@@ -73,6 +76,9 @@ static gboolean opt_version = FALSE;
  * and will be silently ignored on every other invocation */
 static gchar   *opt_sm_client_id = NULL;
 
+/* protects the creation of the I/O scheduler */
+G_LOCK_DEFINE_STATIC (io_scheduler);
+
 /* option entries */
 static const GOptionEntry option_entries[] =
 {
@@ -133,6 +139,7 @@ static gboolean       thunar_application_dbus_register          (GApplication
                                                                  const gchar            *object_path,
                                                                  GError                **error);
 static void           thunar_application_load_css               (void);
+static void           thunar_application_slow_threshold_changed (ThunarApplication      *application);
 static void           thunar_application_accel_map_changed      (ThunarApplication      *application);
 static gboolean       thunar_application_accel_map_save         (gpointer                user_data);
 static gboolean       thunar_application_accel_map_load         (gpointer                user_data);
@@ -176,6 +183,9 @@ static gboolean       thunar_application_show_dialogs           (gpointer
 static void           thunar_application_show_dialogs_destroy   (gpointer                user_data);
 static GtkWidget     *thunar_application_get_progress_dialog    (ThunarApplication      *application);
 static void           thunar_application_process_files          (ThunarApplication      *application);
+static void           thunar_application_queue_prebuilt_window  (ThunarApplication      *application);
+static gboolean       thunar_application_prebuilt_window_idle   (gpointer                user_data);
+static void           thunar_application_drop_prebuilt_window   (ThunarApplication      *application);
 
 
 
@@ -195,11 +205,19 @@ struct _ThunarApplication
 
   ThunarThumbnailCache           *thumbnail_cache;
   ThunarThumbnailer              *thumbnailer;
+  ThunarIoScheduler              *io_scheduler;
 
   ThunarDBusService              *dbus_service;
 
   gboolean                        daemon;
 
+  /* whether the transfers interrupted in an earlier instance were resumed */
+  gboolean                        transfers_resumed;
+
+  /* hidden window built in advance in daemon mode */
+  GtkWidget                      *prebuilt_window;
+  guint                           prebuilt_window_idle_id;
+
   guint                           accel_map_load_id;
   guint                           accel_map_save_id;
   GtkAccelMap                    *accel_map;
@@ -359,9 +377,18 @@ thunar_application_startup (GApplication *gapp)
   static const gchar *subsystems[] = { "block", "input", "usb", NULL };
 #endif
 
+  thunar_util_startup_trace ("application startup");
+
   /* initialize the application */
   application->preferences = thunar_preferences_get ();
 
+  thunar_util_startup_trace ("preferences loaded");
+
+  /* watch for slow main loop callbacks if asked to */
+  thunar_application_slow_threshold_changed (application);
+  g_signal_connect_object (G_OBJECT (application->preferences), "notify::misc-slow-callback-threshold",
+                           G_CALLBACK (thunar_application_slow_threshold_changed), application, G_CONNECT_SWAPPED);
+
 #ifdef HAVE_GUDEV
   /* establish connection with udev */
   application->udev_client = g_udev_client_new (subsystems);
@@ -370,19 +397,29 @@ thunar_application_startup (GApplication *gapp)
    * or disconnected from the computer */
   g_signal_connect (application->udev_client, "uevent",
                     G_CALLBACK (thunar_application_uevent), application);
+
+  thunar_util_startup_trace ("udev client created");
 #endif
 
   thunar_application_dbus_init (application);
 
+  thunar_util_startup_trace ("dbus services registered");
+
   G_APPLICATION_CLASS (thunar_application_parent_class)->startup (gapp);
 
+  thunar_util_startup_trace ("gtk initialized");
+
   /* connect to the session manager */
   application->session_client = thunar_session_client_new (opt_sm_client_id);
 
+  thunar_util_startup_trace ("session client connected");
+
   /* schedule accel map load and update windows when finished, this way empty but active accelerators are preserved */
   application->accel_map_load_id = gdk_threads_add_idle_full (G_PRIORITY_LOW, thunar_application_accel_map_load, application, NULL);
 
   thunar_application_load_css ();
+
+  thunar_util_startup_trace ("css loaded");
 }
 
 
@@ -395,6 +432,12 @@ thunar_application_shutdown (GApplication *gapp)
   /* unqueue all files waiting to be processed */
   thunar_g_list_free_full (application->files_to_launch);
 
+  /* write the view state collected for xfconf */
+  thunar_preferences_flush (application->preferences);
+
+  /* store the emblems and folder settings still queued */
+  thunar_metadata_writer_flush ();
+
   /* save the current accel map */
   if (G_UNLIKELY (application->accel_map_save_id != 0))
     {
@@ -428,6 +471,9 @@ thunar_application_shutdown (GApplication *gapp)
   if (G_UNLIKELY (application->show_dialogs_timer_id != 0))
     g_source_remove (application->show_dialogs_timer_id);
 
+  /* destroy the prebuilt window */
+  thunar_application_drop_prebuilt_window (application);
+
   /* drop ref on the thumbnailer */
   if (application->thumbnailer != NULL)
     g_object_unref (application->thumbnailer);
@@ -436,6 +482,9 @@ thunar_application_shutdown (GApplication *gapp)
   if (application->thumbnail_cache != NULL)
     g_object_unref (G_OBJECT (application->thumbnail_cache));
 
+  /* release the I/O scheduler */
+  g_clear_object (&application->io_scheduler);
+
   /* disconnect from the preferences */
   g_object_unref (G_OBJECT (application->preferences));
 
@@ -483,6 +532,20 @@ thunar_application_handle_local_options (GApplication *gapp,
 
 
 
+static void
+thunar_application_resume_transfers (ThunarApplication *application)
+{
+  GList *job_list;
+  GList *lp;
+
+  job_list = thunar_transfer_job_new_from_journals ();
+  for (lp = job_list; lp != NULL; lp = lp->next)
+    thunar_application_add_progress_job (application, NULL, lp->data, "edit-copy", _("Resuming file transfer..."));
+  thunar_g_list_free_full (job_list);
+}
+
+
+
 static int
 thunar_application_command_line (GApplication            *gapp,
                                  GApplicationCommandLine *command_line)
@@ -517,6 +580,13 @@ thunar_application_command_line (GApplication            *gapp,
         thunar_application_set_daemon (application, TRUE);
     }
 
+  /* take up the copies and moves left unfinished by an earlier instance */
+  if (G_UNLIKELY (!application->transfers_resumed))
+    {
+      application->transfers_resumed = TRUE;
+      thunar_application_resume_transfers (application);
+    }
+
   /* check if we should open the bulk rename dialog */
   if (G_UNLIKELY (bulk_rename))
     {
@@ -571,7 +641,7 @@ thunar_application_command_line (GApplication            *gapp,
                   ThunarFile *directory = thunar_file_get_for_uri (tabs_left[i], NULL);
                   if (G_LIKELY (directory != NULL) && thunar_file_is_directory (directory))
                     {
-                      thunar_window_notebook_add_new_tab (window, directory, TRUE);
+                      thunar_window_notebook_add_new_tab (window, directory, THUNAR_NEW_TAB_BEHAVIOR_DEFER);
                       n_tabs++;
                     }
                 }
@@ -596,7 +666,7 @@ thunar_application_command_line (GApplication            *gapp,
                   ThunarFile *directory = thunar_file_get_for_uri (tabs_right[i], NULL);
                   if (G_LIKELY (directory != NULL) && thunar_file_is_directory (directory))
                     {
-                      thunar_window_notebook_add_new_tab (window, directory, TRUE);
+                      thunar_window_notebook_add_new_tab (window, directory, THUNAR_NEW_TAB_BEHAVIOR_DEFER);
                       n_tabs++;
                     }
                 }
@@ -646,6 +716,17 @@ thunar_application_dbus_register (GApplication           *gapp,
 
 
 
+static void
+thunar_application_slow_threshold_changed (ThunarApplication *application)
+{
+  guint threshold;
+
+  g_object_get (G_OBJECT (application->preferences), "misc-slow-callback-threshold", &threshold, NULL);
+  thunar_stats_set_slow_threshold (threshold);
+}
+
+
+
 static void
 thunar_application_load_css (void)
 {
@@ -927,11 +1008,9 @@ thunar_application_launch (ThunarApplication     *application,
                            ThunarOperationLogMode log_mode,
                            GClosure              *new_files_closure)
 {
-  GtkWidget *dialog;
   GdkScreen *screen;
   ThunarJob *job;
   GList     *parent_folder_list = NULL;
-  gboolean   has_jobs;
 
   _thunar_return_if_fail (parent == NULL || GDK_IS_SCREEN (parent) || GTK_IS_WIDGET (parent));
 
@@ -957,36 +1036,8 @@ thunar_application_launch (ThunarApplication     *application,
   if (G_LIKELY (new_files_closure != NULL))
     g_signal_connect_closure (job, "new-files", new_files_closure, FALSE);
 
-  /* get the shared progress dialog */
-  dialog = thunar_application_get_progress_dialog (application);
-
-  /* place the dialog on the given screen */
-  if (screen != NULL)
-    gtk_window_set_screen (GTK_WINDOW (dialog), screen);
-
-  has_jobs = thunar_progress_dialog_has_jobs (THUNAR_PROGRESS_DIALOG (dialog));
-
-  /* add the job to the dialog */
-  thunar_progress_dialog_add_job (THUNAR_PROGRESS_DIALOG (dialog),
-                                  job, icon_name, title);
-
-  if (has_jobs)
-    {
-      /* show the dialog immediately */
-      thunar_application_show_dialogs (application);
-    }
-  else
-    {
-      /* Set up a timer to show the dialog, to make sure we don't
-       * just popup and destroy a dialog for a very short job.
-       */
-      if (G_LIKELY (application->show_dialogs_timer_id == 0))
-        {
-          application->show_dialogs_timer_id =
-            gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT, 750, thunar_application_show_dialogs,
-                                          application, thunar_application_show_dialogs_destroy);
-        }
-    }
+  /* show the progress of the job */
+  thunar_application_add_progress_job (application, screen, job, icon_name, title);
 
   /* drop our reference on the job */
   g_object_unref (job);
@@ -1271,9 +1322,15 @@ thunar_application_set_daemon (ThunarApplication *application,
       g_object_notify (G_OBJECT (application), "daemon");
 
       if (daemonize)
-        g_application_hold (G_APPLICATION (application));
+        {
+          g_application_hold (G_APPLICATION (application));
+          thunar_application_queue_prebuilt_window (application);
+        }
       else
-        g_application_release (G_APPLICATION (application));
+        {
+          thunar_application_drop_prebuilt_window (application);
+          g_application_release (G_APPLICATION (application));
+        }
     }
 }
 
@@ -1411,6 +1468,9 @@ thunar_application_open_window (ThunarApplication *application,
   gboolean   open_new_window_as_tab;
   gboolean   misc_open_new_windows_in_split_view;
   gboolean   restore_tabs;
+  gboolean   last_window_maximized;
+  gint       last_window_width;
+  gint       last_window_height;
 
   _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), NULL);
   _thunar_return_val_if_fail (directory == NULL || THUNAR_IS_FILE (directory), NULL);
@@ -1448,11 +1508,35 @@ thunar_application_open_window (ThunarApplication *application,
   /* generate a unique role for the new window (for session management) */
   role = g_strdup_printf ("Thunar-%u-%u", (guint) time (NULL), (guint) g_random_int ());
 
-  /* allocate the window */
-  window = g_object_new (THUNAR_TYPE_WINDOW,
-                         "role", role,
-                         "screen", screen,
-                         NULL);
+  if (application->prebuilt_window != NULL && gtk_widget_get_screen (application->prebuilt_window) == screen)
+    {
+      /* take over the window that was built in advance */
+      window = application->prebuilt_window;
+      g_signal_handlers_disconnect_by_func (window, gtk_widget_destroyed, &application->prebuilt_window);
+      application->prebuilt_window = NULL;
+
+      gtk_window_set_role (GTK_WINDOW (window), role);
+
+      /* another window may have been resized since this one was built */
+      g_object_get (G_OBJECT (application->preferences),
+                    "last-window-width", &last_window_width,
+                    "last-window-height", &last_window_height,
+                    "last-window-maximized", &last_window_maximized,
+                    NULL);
+      gtk_window_set_default_size (GTK_WINDOW (window), last_window_width, last_window_height);
+      if (last_window_maximized)
+        gtk_window_maximize (GTK_WINDOW (window));
+      else
+        gtk_window_unmaximize (GTK_WINDOW (window));
+    }
+  else
+    {
+      /* allocate the window */
+      window = g_object_new (THUNAR_TYPE_WINDOW,
+                             "role", role,
+                             "screen", screen,
+                             NULL);
+    }
 
   /* cleanup */
   g_free (role);
@@ -1478,11 +1562,76 @@ thunar_application_open_window (ThunarApplication *application,
   if (misc_open_new_windows_in_split_view && !restore_tabs)
     thunar_window_notebook_toggle_split_view (THUNAR_WINDOW (window));
 
+  /* have the next window ready in time */
+  thunar_application_queue_prebuilt_window (application);
+
   return window;
 }
 
 
 
+static void
+thunar_application_queue_prebuilt_window (ThunarApplication *application)
+{
+  gboolean prebuilt_window;
+
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+
+  if (!application->daemon || application->preferences == NULL)
+    return;
+
+  if (application->prebuilt_window != NULL || application->prebuilt_window_idle_id != 0)
+    return;
+
+  g_object_get (G_OBJECT (application->preferences), "misc-daemon-prebuilt-window", &prebuilt_window, NULL);
+  if (!prebuilt_window)
+    return;
+
+  /* build the window once the daemon has nothing else to do */
+  application->prebuilt_window_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_application_prebuilt_window_idle, application, NULL);
+}
+
+
+
+static gboolean
+thunar_application_prebuilt_window_idle (gpointer user_data)
+{
+  ThunarApplication *application = THUNAR_APPLICATION (user_data);
+
+  application->prebuilt_window_idle_id = 0;
+
+  /* the window stays out of the application until it is taken, so it does
+   * not keep the application alive and is never offered as a target */
+  application->prebuilt_window = g_object_new (THUNAR_TYPE_WINDOW,
+                                               "screen", gdk_screen_get_default (),
+                                               NULL);
+  g_signal_connect (application->prebuilt_window, "destroy", G_CALLBACK (gtk_widget_destroyed), &application->prebuilt_window);
+
+  /* realize the window, so only mapping is left when it is shown */
+  gtk_widget_realize (application->prebuilt_window);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_application_drop_prebuilt_window (ThunarApplication *application)
+{
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+
+  if (application->prebuilt_window_idle_id != 0)
+    {
+      g_source_remove (application->prebuilt_window_idle_id);
+      application->prebuilt_window_idle_id = 0;
+    }
+
+  if (application->prebuilt_window != NULL)
+    gtk_widget_destroy (application->prebuilt_window);
+}
+
+
+
 /**
  * thunar_application_bulk_rename:
  * @application       : a #ThunarApplication.
@@ -2699,12 +2848,13 @@ thunar_application_restore_files (ThunarApplication *application,
       /* TODO we might have to distinguish between URIs and paths here */
       target_path = g_file_new_for_commandline_arg (original_uri);
 
-      source_path_list = thunar_g_list_append_deep (source_path_list, thunar_file_get_file (lp->data));
-      target_path_list = thunar_g_list_append_deep (target_path_list, target_path);
-
-      g_object_unref (target_path);
+      source_path_list = thunar_g_list_prepend_deep (source_path_list, thunar_file_get_file (lp->data));
+      target_path_list = g_list_prepend (target_path_list, target_path);
     }
 
+  source_path_list = g_list_reverse (source_path_list);
+  target_path_list = g_list_reverse (target_path_list);
+
   if (G_UNLIKELY (err != NULL))
     {
       /* display an error dialog */
@@ -2739,3 +2889,91 @@ thunar_application_get_thumbnail_cache (ThunarApplication *application)
 }
 
 
+
+/**
+ * thunar_application_get_io_scheduler:
+ * @application : a #ThunarApplication.
+ *
+ * Returns the #ThunarIoScheduler shared by all jobs, which lets
+ * the operations on the same device wait for each other.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #ThunarIoScheduler of @application.
+ **/
+ThunarIoScheduler *
+thunar_application_get_io_scheduler (ThunarApplication *application)
+{
+  ThunarIoScheduler *io_scheduler;
+
+  _thunar_return_val_if_fail (THUNAR_IS_APPLICATION (application), NULL);
+
+  /* jobs ask for it from their threads */
+  G_LOCK (io_scheduler);
+  if (application->io_scheduler == NULL)
+    application->io_scheduler = thunar_io_scheduler_new ();
+  io_scheduler = g_object_ref (application->io_scheduler);
+  G_UNLOCK (io_scheduler);
+
+  return io_scheduler;
+}
+
+
+
+/**
+ * thunar_application_add_progress_job:
+ * @application : a #ThunarApplication.
+ * @screen      : the #GdkScreen on which to show the progress or %NULL.
+ * @job         : the #ThunarJob to monitor.
+ * @icon_name   : the icon name for the job.
+ * @title       : the title for the job.
+ *
+ * Adds @job to the shared progress dialog of @application, which
+ * shows up if the job does not finish within a short delay.
+ **/
+void
+thunar_application_add_progress_job (ThunarApplication *application,
+                                     GdkScreen         *screen,
+                                     ThunarJob         *job,
+                                     const gchar       *icon_name,
+                                     const gchar       *title)
+{
+  GtkWidget *dialog;
+  gboolean   has_jobs;
+
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+  _thunar_return_if_fail (screen == NULL || GDK_IS_SCREEN (screen));
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  /* get the shared progress dialog */
+  dialog = thunar_application_get_progress_dialog (application);
+
+  /* place the dialog on the given screen */
+  if (screen != NULL)
+    gtk_window_set_screen (GTK_WINDOW (dialog), screen);
+
+  has_jobs = thunar_progress_dialog_has_jobs (THUNAR_PROGRESS_DIALOG (dialog));
+
+  /* add the job to the dialog */
+  thunar_progress_dialog_add_job (THUNAR_PROGRESS_DIALOG (dialog),
+                                  job, icon_name, title);
+
+  if (has_jobs)
+    {
+      /* show the dialog immediately */
+      thunar_application_show_dialogs (application);
+    }
+  else
+    {
+      /* Set up a timer to show the dialog, to make sure we don't
+       * just popup and destroy a dialog for a very short job.
+       */
+      if (G_LIKELY (application->show_dialogs_timer_id == 0))
+        {
+          application->show_dialogs_timer_id =
+            gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT, 750, thunar_application_show_dialogs,
+                                          application, thunar_application_show_dialogs_destroy);
+        }
+    }
+}
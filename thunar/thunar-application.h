@@ -23,9 +23,11 @@
 #ifndef __THUNAR_APPLICATION_H__
 #define __THUNAR_APPLICATION_H__
 
+#include <thunar/thunar-job.h>
 #include <thunar/thunar-job-operation.h>
 #include <thunar/thunar-window.h>
 #include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-io-scheduler.h>
 
 G_BEGIN_DECLS;
 
@@ -175,6 +177,14 @@ void                  thunar_application_restore_files             (ThunarApplic
 
 ThunarThumbnailCache *thunar_application_get_thumbnail_cache       (ThunarApplication *application);
 
+ThunarIoScheduler    *thunar_application_get_io_scheduler          (ThunarApplication *application);
+
+void                  thunar_application_add_progress_job          (ThunarApplication *application,
+                                                                    GdkScreen         *screen,
+                                                                    ThunarJob         *job,
+                                                                    const gchar       *icon_name,
+                                                                    const gchar       *title);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_APPLICATION_H__ */
@@ -0,0 +1,332 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-checksum-job.h>
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-marshal.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* Signal identifiers */
+enum
+{
+  CHECKSUM_READY,
+  LAST_SIGNAL,
+};
+
+
+
+/* number of files hashed at the same time on local devices, on
+ * spinning disks and on remote locations */
+#define THUNAR_CHECKSUM_JOB_THREADS_MAX        8
+#define THUNAR_CHECKSUM_JOB_THREADS_ROTATIONAL 1
+#define THUNAR_CHECKSUM_JOB_THREADS_REMOTE     4
+
+
+
+typedef struct _ThunarChecksumResult ThunarChecksumResult;
+
+static void     thunar_checksum_job_finalize (GObject  *object);
+static gboolean thunar_checksum_job_execute  (ExoJob   *job,
+                                              GError  **error);
+
+
+
+struct _ThunarChecksumJobClass
+{
+  ThunarJobClass __parent__;
+
+  /* signals */
+  void (*checksum_ready) (ThunarChecksumJob *job,
+                          ThunarFile        *file,
+                          const gchar       *checksum,
+                          const gchar       *error_message);
+};
+
+struct _ThunarChecksumJob
+{
+  ThunarJob     __parent__;
+
+  GPtrArray    *files;
+  GChecksumType checksum_type;
+
+  /* the files are hashed by several threads, the job thread
+   * hands the results over to the main loop */
+  GMutex        mutex;
+  GCond         cond;
+  guint         next_file;
+  guint         n_running;
+  GQueue        results;
+};
+
+struct _ThunarChecksumResult
+{
+  ThunarFile *file;
+  gchar      *checksum;
+  GError     *error;
+};
+
+
+
+static guint checksum_signals[LAST_SIGNAL];
+
+
+
+G_DEFINE_TYPE (ThunarChecksumJob, thunar_checksum_job, THUNAR_TYPE_JOB)
+
+
+
+static void
+thunar_checksum_job_class_init (ThunarChecksumJobClass *klass)
+{
+  ThunarJobClass *job_class;
+  GObjectClass   *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_checksum_job_finalize;
+
+  job_class = THUNAR_JOB_CLASS (klass);
+  job_class->execute = thunar_checksum_job_execute;
+
+  /**
+   * ThunarChecksumJob::checksum-ready:
+   * @job           : a #ThunarChecksumJob.
+   * @file          : the #ThunarFile which was hashed.
+   * @checksum      : the checksum as hexadecimal string or %NULL.
+   * @error_message : the reason why @file could not be hashed or %NULL.
+   *
+   * Emitted by the @job for every file, in the order the files
+   * are done, which need not be the order they were passed in.
+   **/
+  checksum_signals[CHECKSUM_READY] =
+    g_signal_new ("checksum-ready",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS,
+                  G_STRUCT_OFFSET (ThunarChecksumJobClass, checksum_ready),
+                  NULL, NULL,
+                  _thunar_marshal_VOID__OBJECT_STRING_STRING,
+                  G_TYPE_NONE, 3,
+                  THUNAR_TYPE_FILE,
+                  G_TYPE_STRING,
+                  G_TYPE_STRING);
+}
+
+
+
+static void
+thunar_checksum_job_init (ThunarChecksumJob *job)
+{
+  job->checksum_type = G_CHECKSUM_SHA256;
+  g_mutex_init (&job->mutex);
+  g_cond_init (&job->cond);
+  g_queue_init (&job->results);
+}
+
+
+
+static void
+thunar_checksum_result_free (gpointer data)
+{
+  ThunarChecksumResult *result = data;
+
+  g_free (result->checksum);
+  if (result->error != NULL)
+    g_error_free (result->error);
+  g_slice_free (ThunarChecksumResult, result);
+}
+
+
+
+static void
+thunar_checksum_job_finalize (GObject *object)
+{
+  ThunarChecksumJob *job = THUNAR_CHECKSUM_JOB (object);
+
+  g_queue_clear_full (&job->results, thunar_checksum_result_free);
+  g_ptr_array_unref (job->files);
+  g_cond_clear (&job->cond);
+  g_mutex_clear (&job->mutex);
+
+  (*G_OBJECT_CLASS (thunar_checksum_job_parent_class)->finalize) (object);
+}
+
+
+
+static guint
+thunar_checksum_job_get_n_threads (ThunarChecksumJob *job)
+{
+  guint n_threads;
+
+  switch (thunar_io_scheduler_get_device_class (thunar_file_get_file (g_ptr_array_index (job->files, 0))))
+    {
+    case THUNAR_IO_DEVICE_REMOTE:
+      /* hide the latency of the server, without flooding it */
+      n_threads = THUNAR_CHECKSUM_JOB_THREADS_REMOTE;
+      break;
+
+    case THUNAR_IO_DEVICE_ROTATIONAL:
+      /* spinning disks read one file after the other best */
+      n_threads = THUNAR_CHECKSUM_JOB_THREADS_ROTATIONAL;
+      break;
+
+    default:
+      /* hashing is bound by the processor otherwise */
+      n_threads = CLAMP ((guint) g_get_num_processors (), 1, THUNAR_CHECKSUM_JOB_THREADS_MAX);
+      break;
+    }
+
+  return MIN (n_threads, job->files->len);
+}
+
+
+
+static gpointer
+thunar_checksum_job_thread (gpointer data)
+{
+  ThunarChecksumJob    *job = THUNAR_CHECKSUM_JOB (data);
+  ThunarChecksumResult *result;
+  GCancellable         *cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  ThunarFile           *file;
+
+  for (;;)
+    {
+      /* take the next file */
+      g_mutex_lock (&job->mutex);
+      if (job->next_file >= job->files->len || g_cancellable_is_cancelled (cancellable))
+        {
+          job->n_running--;
+          g_cond_signal (&job->cond);
+          g_mutex_unlock (&job->mutex);
+          break;
+        }
+      file = g_ptr_array_index (job->files, job->next_file++);
+      g_mutex_unlock (&job->mutex);
+
+      /* the same engine verifies the copies of the transfer job */
+      result = g_slice_new0 (ThunarChecksumResult);
+      result->file = file;
+      result->checksum = thunar_g_file_create_checksum (thunar_file_get_file (file), job->checksum_type,
+                                                        FALSE, cancellable, &result->error);
+
+      g_mutex_lock (&job->mutex);
+      g_queue_push_tail (&job->results, result);
+      g_cond_signal (&job->cond);
+      g_mutex_unlock (&job->mutex);
+    }
+
+  return NULL;
+}
+
+
+
+static gboolean
+thunar_checksum_job_execute (ExoJob  *job,
+                             GError **error)
+{
+  ThunarChecksumJob    *checksum_job = THUNAR_CHECKSUM_JOB (job);
+  ThunarChecksumResult *result;
+  GThread             **threads;
+  guint                 n_threads;
+  guint                 n_done = 0;
+  guint                 n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_CHECKSUM_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* don't start the job if it was already cancelled */
+  if (exo_job_set_error_if_cancelled (job, error))
+    return FALSE;
+
+  n_threads = thunar_checksum_job_get_n_threads (checksum_job);
+  checksum_job->n_running = n_threads;
+
+  threads = g_new0 (GThread *, n_threads);
+  for (n = 0; n < n_threads; ++n)
+    threads[n] = g_thread_new ("ThunarChecksumJob", thunar_checksum_job_thread, job);
+
+  /* only the job thread emits signals, as the files are done */
+  g_mutex_lock (&checksum_job->mutex);
+  for (;;)
+    {
+      while (g_queue_is_empty (&checksum_job->results) && checksum_job->n_running > 0)
+        g_cond_wait (&checksum_job->cond, &checksum_job->mutex);
+
+      result = g_queue_pop_head (&checksum_job->results);
+      if (result == NULL)
+        break;
+      g_mutex_unlock (&checksum_job->mutex);
+
+      if (!exo_job_is_cancelled (job))
+        {
+          exo_job_emit (job, checksum_signals[CHECKSUM_READY], 0, result->file, result->checksum,
+                        result->error != NULL ? result->error->message : NULL);
+          thunar_job_set_percent (THUNAR_JOB (job), (++n_done * 100.0) / checksum_job->files->len);
+        }
+      thunar_checksum_result_free (result);
+
+      g_mutex_lock (&checksum_job->mutex);
+    }
+  g_mutex_unlock (&checksum_job->mutex);
+
+  for (n = 0; n < n_threads; ++n)
+    g_thread_join (threads[n]);
+  g_free (threads);
+
+  return !exo_job_set_error_if_cancelled (job, error);
+}
+
+
+
+/**
+ * thunar_checksum_job_new:
+ * @files         : a #GList of regular #ThunarFile<!---->s.
+ * @checksum_type : the #GChecksumType to compute.
+ *
+ * Allocates a new #ThunarChecksumJob, which hashes the contents of
+ * the @files, several at a time where the device allows, and emits
+ * "checksum-ready" for each of them.
+ *
+ * Return value: the newly allocated #ThunarChecksumJob.
+ **/
+ThunarChecksumJob *
+thunar_checksum_job_new (GList         *files,
+                         GChecksumType  checksum_type)
+{
+  ThunarChecksumJob *job;
+  GList             *lp;
+
+  _thunar_return_val_if_fail (files != NULL, NULL);
+
+  job = g_object_new (THUNAR_TYPE_CHECKSUM_JOB, NULL);
+  job->checksum_type = checksum_type;
+  thunar_job_set_pool (THUNAR_JOB (job), THUNAR_JOB_POOL_CPU);
+  job->files = g_ptr_array_new_with_free_func (g_object_unref);
+  for (lp = files; lp != NULL; lp = lp->next)
+    g_ptr_array_add (job->files, g_object_ref (lp->data));
+
+  return job;
+}
@@ -0,0 +1,45 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_CHECKSUM_JOB_H__
+#define __THUNAR_CHECKSUM_JOB_H__
+
+#include <thunar/thunar-job.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarChecksumJobClass ThunarChecksumJobClass;
+typedef struct _ThunarChecksumJob      ThunarChecksumJob;
+
+#define THUNAR_TYPE_CHECKSUM_JOB            (thunar_checksum_job_get_type ())
+#define THUNAR_CHECKSUM_JOB(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_CHECKSUM_JOB, ThunarChecksumJob))
+#define THUNAR_CHECKSUM_JOB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_CHECKSUM_JOB, ThunarChecksumJobClass))
+#define THUNAR_IS_CHECKSUM_JOB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_CHECKSUM_JOB))
+#define THUNAR_IS_CHECKSUM_JOB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_CHECKSUM_JOB))
+#define THUNAR_CHECKSUM_JOB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_CHECKSUM_JOB, ThunarChecksumJobClass))
+
+GType              thunar_checksum_job_get_type (void) G_GNUC_CONST;
+
+ThunarChecksumJob *thunar_checksum_job_new      (GList         *files,
+                                                 GChecksumType  checksum_type) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_CHECKSUM_JOB_H__ */
@@ -0,0 +1,552 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <exo/exo.h>
+
+#include <thunar/thunar-checksum-job.h>
+#include <thunar/thunar-checksum-page.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-gtk-extensions.h>
+#include <thunar/thunar-pango-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* Property identifiers */
+enum
+{
+  PROP_0,
+  PROP_FILES,
+};
+
+/* Store columns */
+enum
+{
+  COLUMN_FILE,
+  COLUMN_NAME,
+  COLUMN_CHECKSUM,
+  COLUMN_WEIGHT,
+  N_COLUMNS,
+};
+
+
+
+static void     thunar_checksum_page_finalize         (GObject            *object);
+static void     thunar_checksum_page_get_property     (GObject            *object,
+                                                       guint               prop_id,
+                                                       GValue             *value,
+                                                       GParamSpec         *pspec);
+static void     thunar_checksum_page_set_property     (GObject            *object,
+                                                       guint               prop_id,
+                                                       const GValue       *value,
+                                                       GParamSpec         *pspec);
+static void     thunar_checksum_page_set_files        (ThunarChecksumPage *page,
+                                                       GList              *files);
+static void     thunar_checksum_page_compute          (ThunarChecksumPage *page);
+static void     thunar_checksum_page_compare          (ThunarChecksumPage *page);
+static void     thunar_checksum_page_job_cancel       (ThunarChecksumPage *page);
+static void     thunar_checksum_page_checksum_ready   (ThunarChecksumPage *page,
+                                                       ThunarFile         *file,
+                                                       const gchar        *checksum,
+                                                       const gchar        *error_message,
+                                                       ThunarChecksumJob  *job);
+static void     thunar_checksum_page_job_percent      (ThunarChecksumPage *page,
+                                                       gdouble             percent,
+                                                       ThunarChecksumJob  *job);
+
+
+
+struct _ThunarChecksumPageClass
+{
+  GtkBoxClass __parent__;
+};
+
+struct _ThunarChecksumPage
+{
+  GtkBox             __parent__;
+
+  GList             *files;
+  GtkListStore      *store;
+
+  GtkWidget         *type_combo;
+  GtkWidget         *compute_button;
+  GtkWidget         *compare_entry;
+  GtkWidget         *compare_label;
+  GtkWidget         *job_progress;
+
+  ThunarChecksumJob *job;
+};
+
+
+
+/* the algorithms offered, the id of the combo is the index here */
+static const struct
+{
+  GChecksumType type;
+  const gchar  *name;
+} checksum_types[] =
+{
+  { G_CHECKSUM_MD5,    "MD5"     },
+  { G_CHECKSUM_SHA1,   "SHA-1"   },
+  { G_CHECKSUM_SHA256, "SHA-256" },
+  { G_CHECKSUM_SHA512, "SHA-512" },
+};
+
+
+
+G_DEFINE_TYPE (ThunarChecksumPage, thunar_checksum_page, GTK_TYPE_BOX)
+
+
+
+static void
+thunar_checksum_page_class_init (ThunarChecksumPageClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_checksum_page_finalize;
+  gobject_class->get_property = thunar_checksum_page_get_property;
+  gobject_class->set_property = thunar_checksum_page_set_property;
+
+  /**
+   * ThunarChecksumPage:files:
+   *
+   * The #ThunarFile<!---->s whose regular files are hashed.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_FILES,
+                                   g_param_spec_boxed ("files", "files", "files",
+                                                       THUNARX_TYPE_FILE_INFO_LIST,
+                                                       EXO_PARAM_READWRITE));
+}
+
+
+
+static void
+thunar_checksum_page_init (ThunarChecksumPage *page)
+{
+  GtkTreeViewColumn *column;
+  GtkCellRenderer   *renderer;
+  GtkWidget         *tree_view;
+  GtkWidget         *button;
+  GtkWidget         *swin;
+  GtkWidget         *label;
+  GtkWidget         *hbox;
+  guint              n;
+
+  gtk_container_set_border_width (GTK_CONTAINER (page), 12);
+  gtk_orientable_set_orientation (GTK_ORIENTABLE (page), GTK_ORIENTATION_VERTICAL);
+  gtk_box_set_spacing (GTK_BOX (page), 6);
+
+  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_box_pack_start (GTK_BOX (page), hbox, FALSE, FALSE, 0);
+  gtk_widget_show (hbox);
+
+  label = gtk_label_new_with_mnemonic (_("_Algorithm:"));
+  gtk_label_set_attributes (GTK_LABEL (label), thunar_pango_attr_list_bold ());
+  gtk_box_pack_start (GTK_BOX (hbox), label, FALSE, FALSE, 0);
+  gtk_widget_show (label);
+
+  page->type_combo = gtk_combo_box_text_new ();
+  for (n = 0; n < G_N_ELEMENTS (checksum_types); ++n)
+    gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (page->type_combo), checksum_types[n].name);
+  gtk_combo_box_set_active (GTK_COMBO_BOX (page->type_combo), 2);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), page->type_combo);
+  thunar_gtk_label_set_a11y_relation (GTK_LABEL (label), page->type_combo);
+  gtk_box_pack_start (GTK_BOX (hbox), page->type_combo, FALSE, FALSE, 0);
+  gtk_widget_show (page->type_combo);
+
+  page->compute_button = gtk_button_new_with_mnemonic (_("C_ompute"));
+  gtk_widget_set_tooltip_text (page->compute_button, _("Compute the checksums of the selected files."));
+  g_signal_connect_swapped (G_OBJECT (page->compute_button), "clicked", G_CALLBACK (thunar_checksum_page_compute), page);
+  gtk_box_pack_end (GTK_BOX (hbox), page->compute_button, FALSE, FALSE, 0);
+  gtk_widget_show (page->compute_button);
+
+  /* the files and their checksums */
+  page->store = gtk_list_store_new (N_COLUMNS, THUNAR_TYPE_FILE, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT);
+
+  swin = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (swin), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (swin), GTK_SHADOW_IN);
+  gtk_box_pack_start (GTK_BOX (page), swin, TRUE, TRUE, 0);
+  gtk_widget_show (swin);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (page->store));
+  gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (tree_view), FALSE);
+  gtk_container_add (GTK_CONTAINER (swin), tree_view);
+  gtk_widget_show (tree_view);
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (G_OBJECT (renderer), "ellipsize", PANGO_ELLIPSIZE_MIDDLE, "width-chars", 12, NULL);
+  column = gtk_tree_view_column_new_with_attributes (_("Name"), renderer,
+                                                     "text", COLUMN_NAME,
+                                                     "weight", COLUMN_WEIGHT,
+                                                     NULL);
+  gtk_tree_view_column_set_resizable (column, TRUE);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+
+  /* editable only to let the user select and copy the checksum */
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (G_OBJECT (renderer), "family", "monospace", "editable", TRUE, NULL);
+  column = gtk_tree_view_column_new_with_attributes (_("Checksum"), renderer,
+                                                     "text", COLUMN_CHECKSUM,
+                                                     "weight", COLUMN_WEIGHT,
+                                                     NULL);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+
+  /* verification against a known checksum */
+  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_box_pack_start (GTK_BOX (page), hbox, FALSE, FALSE, 0);
+  gtk_widget_show (hbox);
+
+  label = gtk_label_new_with_mnemonic (_("Compare _with:"));
+  gtk_label_set_attributes (GTK_LABEL (label), thunar_pango_attr_list_bold ());
+  gtk_box_pack_start (GTK_BOX (hbox), label, FALSE, FALSE, 0);
+  gtk_widget_show (label);
+
+  page->compare_entry = gtk_entry_new ();
+  gtk_entry_set_placeholder_text (GTK_ENTRY (page->compare_entry), _("Paste a checksum here"));
+  g_signal_connect_swapped (G_OBJECT (page->compare_entry), "changed", G_CALLBACK (thunar_checksum_page_compare), page);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), page->compare_entry);
+  thunar_gtk_label_set_a11y_relation (GTK_LABEL (label), page->compare_entry);
+  gtk_box_pack_start (GTK_BOX (hbox), page->compare_entry, TRUE, TRUE, 0);
+  gtk_widget_show (page->compare_entry);
+
+  page->compare_label = gtk_label_new (NULL);
+  gtk_label_set_xalign (GTK_LABEL (page->compare_label), 0.0f);
+  gtk_label_set_ellipsize (GTK_LABEL (page->compare_label), PANGO_ELLIPSIZE_MIDDLE);
+  gtk_box_pack_start (GTK_BOX (page), page->compare_label, FALSE, FALSE, 0);
+  gtk_widget_show (page->compare_label);
+
+  /* the job control stuff */
+  hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 6);
+  gtk_box_pack_start (GTK_BOX (page), hbox, FALSE, FALSE, 0);
+
+  page->job_progress = gtk_progress_bar_new ();
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (page->job_progress), _("Please wait..."));
+  g_object_bind_property (G_OBJECT (page->job_progress), "visible",
+                          G_OBJECT (hbox), "visible",
+                          G_BINDING_SYNC_CREATE);
+  gtk_box_pack_start (GTK_BOX (hbox), page->job_progress, TRUE, TRUE, 0);
+
+  button = gtk_button_new_from_icon_name ("process-stop", GTK_ICON_SIZE_BUTTON);
+  gtk_widget_set_tooltip_text (button, _("Stop computing the checksums."));
+  g_signal_connect_swapped (G_OBJECT (button), "clicked", G_CALLBACK (thunar_checksum_page_job_cancel), page);
+  gtk_box_pack_start (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+  gtk_widget_show (button);
+}
+
+
+
+static void
+thunar_checksum_page_finalize (GObject *object)
+{
+  ThunarChecksumPage *page = THUNAR_CHECKSUM_PAGE (object);
+
+  /* cancel any pending job */
+  thunar_checksum_page_job_cancel (page);
+
+  /* drop the references on the files */
+  thunar_checksum_page_set_files (page, NULL);
+  g_object_unref (page->store);
+
+  (*G_OBJECT_CLASS (thunar_checksum_page_parent_class)->finalize) (object);
+}
+
+
+
+static void
+thunar_checksum_page_get_property (GObject    *object,
+                                   guint       prop_id,
+                                   GValue     *value,
+                                   GParamSpec *pspec)
+{
+  ThunarChecksumPage *page = THUNAR_CHECKSUM_PAGE (object);
+
+  switch (prop_id)
+    {
+    case PROP_FILES:
+      g_value_set_boxed (value, page->files);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+thunar_checksum_page_set_property (GObject      *object,
+                                   guint         prop_id,
+                                   const GValue *value,
+                                   GParamSpec   *pspec)
+{
+  ThunarChecksumPage *page = THUNAR_CHECKSUM_PAGE (object);
+
+  switch (prop_id)
+    {
+    case PROP_FILES:
+      thunar_checksum_page_set_files (page, g_value_get_boxed (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+thunar_checksum_page_set_files (ThunarChecksumPage *page,
+                                GList              *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+
+  if (G_UNLIKELY (page->files == files))
+    return;
+
+  /* the checksums of the previous files are useless now */
+  thunar_checksum_page_job_cancel (page);
+  gtk_list_store_clear (page->store);
+
+  thunar_g_list_free_full (page->files);
+  page->files = thunar_g_list_copy_deep (files);
+
+  /* only regular files have contents to hash */
+  for (lp = page->files; lp != NULL; lp = lp->next)
+    if (thunar_file_is_regular (THUNAR_FILE (lp->data)))
+      gtk_list_store_insert_with_values (page->store, NULL, -1,
+                                         COLUMN_FILE, lp->data,
+                                         COLUMN_NAME, thunar_file_get_display_name (THUNAR_FILE (lp->data)),
+                                         COLUMN_WEIGHT, PANGO_WEIGHT_NORMAL,
+                                         -1);
+
+  gtk_widget_set_sensitive (page->compute_button, gtk_tree_model_iter_n_children (GTK_TREE_MODEL (page->store), NULL) > 0);
+  thunar_checksum_page_compare (page);
+
+  g_object_notify (G_OBJECT (page), "files");
+}
+
+
+
+static void
+thunar_checksum_page_compute (ThunarChecksumPage *page)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (page->store);
+  GtkTreeIter   iter;
+  ThunarFile   *file;
+  GList        *files = NULL;
+  gint          active;
+
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+
+  thunar_checksum_page_job_cancel (page);
+
+  /* forget the checksums of the previous algorithm */
+  if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+      do
+        {
+          gtk_tree_model_get (model, &iter, COLUMN_FILE, &file, -1);
+          files = g_list_prepend (files, file);
+          gtk_list_store_set (page->store, &iter, COLUMN_CHECKSUM, NULL, -1);
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+  if (G_UNLIKELY (files == NULL))
+    return;
+
+  active = gtk_combo_box_get_active (GTK_COMBO_BOX (page->type_combo));
+  active = CLAMP (active, 0, (gint) G_N_ELEMENTS (checksum_types) - 1);
+
+  /* hash the files in the order they are listed */
+  files = g_list_reverse (files);
+  page->job = thunar_checksum_job_new (files, checksum_types[active].type);
+  g_list_free_full (files, g_object_unref);
+
+  g_signal_connect_swapped (page->job, "checksum-ready", G_CALLBACK (thunar_checksum_page_checksum_ready), page);
+  g_signal_connect_swapped (page->job, "percent", G_CALLBACK (thunar_checksum_page_job_percent), page);
+  g_signal_connect_swapped (page->job, "finished", G_CALLBACK (thunar_checksum_page_job_cancel), page);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (page->job_progress), 0.0);
+  gtk_widget_show (page->job_progress);
+  gtk_widget_set_sensitive (page->compute_button, FALSE);
+  thunar_checksum_page_compare (page);
+
+  thunar_job_launch (THUNAR_JOB (page->job));
+}
+
+
+
+static void
+thunar_checksum_page_compare (ThunarChecksumPage *page)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (page->store);
+  GtkTreeIter   iter;
+  const gchar  *text;
+  gboolean      matches;
+  gchar        *expected;
+  gchar        *checksum;
+  gchar        *name;
+  gchar        *match_name = NULL;
+  gchar        *message = NULL;
+  guint         n_matches = 0;
+
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+
+  /* checksums are pasted in either case, with surrounding blanks */
+  text = gtk_entry_get_text (GTK_ENTRY (page->compare_entry));
+  expected = g_ascii_strdown (text, -1);
+  g_strstrip (expected);
+
+  if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+      do
+        {
+          gtk_tree_model_get (model, &iter, COLUMN_NAME, &name, COLUMN_CHECKSUM, &checksum, -1);
+
+          matches = (*expected != '\0' && g_strcmp0 (checksum, expected) == 0);
+          gtk_list_store_set (page->store, &iter, COLUMN_WEIGHT, matches ? PANGO_WEIGHT_BOLD : PANGO_WEIGHT_NORMAL, -1);
+          if (matches && n_matches++ == 0)
+            match_name = g_steal_pointer (&name);
+
+          g_free (checksum);
+          g_free (name);
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+  /* only tell about the result once all files are hashed */
+  if (*expected == '\0' || page->job != NULL)
+    message = NULL;
+  else if (n_matches == 0)
+    message = g_strdup (_("No file matches the checksum."));
+  else if (n_matches == 1)
+    message = g_strdup_printf (_("\"%s\" matches the checksum."), match_name);
+  else
+    message = g_strdup_printf (ngettext ("%u file matches the checksum.",
+                                         "%u files match the checksum.",
+                                         n_matches), n_matches);
+  gtk_label_set_text (GTK_LABEL (page->compare_label), message);
+
+  g_free (message);
+  g_free (match_name);
+  g_free (expected);
+}
+
+
+
+static void
+thunar_checksum_page_job_cancel (ThunarChecksumPage *page)
+{
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+
+  if (page->job == NULL)
+    return;
+
+  /* cancel the job (if not already done) */
+  exo_job_cancel (EXO_JOB (page->job));
+
+  /* disconnect from the job */
+  g_signal_handlers_disconnect_matched (page->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, page);
+  g_object_unref (page->job);
+  page->job = NULL;
+
+  gtk_widget_hide (page->job_progress);
+  gtk_widget_set_sensitive (page->compute_button, TRUE);
+
+  /* the checksums are complete now */
+  thunar_checksum_page_compare (page);
+}
+
+
+
+static void
+thunar_checksum_page_checksum_ready (ThunarChecksumPage *page,
+                                     ThunarFile         *file,
+                                     const gchar        *checksum,
+                                     const gchar        *error_message,
+                                     ThunarChecksumJob  *job)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (page->store);
+  GtkTreeIter   iter;
+  ThunarFile   *row_file;
+  gboolean      found = FALSE;
+
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (page->job == job);
+
+  if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+      do
+        {
+          gtk_tree_model_get (model, &iter, COLUMN_FILE, &row_file, -1);
+          found = (row_file == file);
+          g_object_unref (row_file);
+        }
+      while (!found && gtk_tree_model_iter_next (model, &iter));
+    }
+
+  if (G_LIKELY (found))
+    gtk_list_store_set (page->store, &iter, COLUMN_CHECKSUM, checksum != NULL ? checksum : error_message, -1);
+}
+
+
+
+static void
+thunar_checksum_page_job_percent (ThunarChecksumPage *page,
+                                  gdouble             percent,
+                                  ThunarChecksumJob  *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_CHECKSUM_PAGE (page));
+  _thunar_return_if_fail (page->job == job);
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (page->job_progress), percent / 100.0);
+}
+
+
+
+/**
+ * thunar_checksum_page_new:
+ *
+ * Allocates a new #ThunarChecksumPage instance.
+ *
+ * Return value: the newly allocated #ThunarChecksumPage.
+ **/
+GtkWidget*
+thunar_checksum_page_new (void)
+{
+  return g_object_new (THUNAR_TYPE_CHECKSUM_PAGE, NULL);
+}
@@ -0,0 +1,44 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_CHECKSUM_PAGE_H__
+#define __THUNAR_CHECKSUM_PAGE_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarChecksumPageClass ThunarChecksumPageClass;
+typedef struct _ThunarChecksumPage      ThunarChecksumPage;
+
+#define THUNAR_TYPE_CHECKSUM_PAGE            (thunar_checksum_page_get_type ())
+#define THUNAR_CHECKSUM_PAGE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_CHECKSUM_PAGE, ThunarChecksumPage))
+#define THUNAR_CHECKSUM_PAGE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_CHECKSUM_PAGE, ThunarChecksumPageClass))
+#define THUNAR_IS_CHECKSUM_PAGE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_CHECKSUM_PAGE))
+#define THUNAR_IS_CHECKSUM_PAGE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_CHECKSUM_PAGE))
+#define THUNAR_CHECKSUM_PAGE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_CHECKSUM_PAGE, ThunarChecksumPageClass))
+
+GType      thunar_checksum_page_get_type (void) G_GNUC_CONST;
+
+GtkWidget *thunar_checksum_page_new      (void) G_GNUC_MALLOC;
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_CHECKSUM_PAGE_H__ */
@@ -90,6 +90,11 @@ static void        thunar_chooser_dialog_row_activated       (GtkTreeView
                                                               ThunarChooserDialog      *dialog);
 static void        thunar_chooser_dialog_selection_changed   (GtkTreeSelection         *selection,
                                                               ThunarChooserDialog      *dialog);
+static gboolean    thunar_chooser_dialog_search_equal        (GtkTreeModel             *model,
+                                                              gint                      column,
+                                                              const gchar              *key,
+                                                              GtkTreeIter              *iter,
+                                                              gpointer                  user_data);
 static ThunarFile *thunar_chooser_dialog_get_file            (ThunarChooserDialog *dialog);
 static void        thunar_chooser_dialog_set_file            (ThunarChooserDialog *dialog,
                                                               ThunarFile          *file);
@@ -246,6 +251,10 @@ thunar_chooser_dialog_init (ThunarChooserDialog *dialog)
                                        NULL);
   gtk_tree_view_append_column (GTK_TREE_VIEW (dialog->tree_view), column);
 
+  /* find applications by typing the start of their names */
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (dialog->tree_view), THUNAR_CHOOSER_MODEL_COLUMN_NAME);
+  gtk_tree_view_set_search_equal_func (GTK_TREE_VIEW (dialog->tree_view), thunar_chooser_dialog_search_equal, NULL, NULL);
+
   /* don't show the expanders */
   g_object_set (G_OBJECT (dialog->tree_view),
                 "level-indentation", 24,
@@ -1095,6 +1104,40 @@ thunar_chooser_dialog_popup_menu (GtkWidget           *tree_view,
 
 
 
+static gboolean
+thunar_chooser_dialog_search_equal (GtkTreeModel *model,
+                                    gint          column,
+                                    const gchar  *key,
+                                    GtkTreeIter  *iter,
+                                    gpointer      user_data)
+{
+  GAppInfo *app_info;
+  gchar    *normalized;
+  gchar    *casefolded;
+  gboolean  matches = FALSE;
+
+  /* only application rows can be found */
+  gtk_tree_model_get (model, iter, THUNAR_CHOOSER_MODEL_COLUMN_APPLICATION, &app_info, -1);
+  if (app_info == NULL)
+    return TRUE;
+
+  /* the names of the applications are normalized and casefolded once */
+  normalized = g_utf8_normalize (key, -1, G_NORMALIZE_ALL);
+  if (G_LIKELY (normalized != NULL))
+    {
+      casefolded = g_utf8_casefold (normalized, -1);
+      matches = g_str_has_prefix (thunar_chooser_model_get_search_key (app_info), casefolded);
+      g_free (casefolded);
+      g_free (normalized);
+    }
+  g_object_unref (app_info);
+
+  /* FALSE means the row matches */
+  return !matches;
+}
+
+
+
 static void
 thunar_chooser_dialog_row_activated (GtkTreeView         *treeview,
                                      GtkTreePath         *path,
@@ -57,6 +57,7 @@ static void     thunar_chooser_model_set_property   (GObject                  *o
                                                      const GValue             *value,
                                                      GParamSpec               *pspec);
 static void     thunar_chooser_model_reload         (ThunarChooserModel       *model);
+static void     thunar_chooser_model_refresh_applications (void);
 
 
 
@@ -72,6 +73,22 @@ struct _ThunarChooserModel
   gchar *content_type;
 };
 
+typedef struct
+{
+  gchar    *collate_key;
+  GAppInfo *app_info;
+} ThunarChooserModelSortItem;
+
+
+
+/* all installed applications that are shown, sorted by name and shared
+ * by the models. A refresh is loaded in a thread whenever GAppInfoMonitor
+ * reports a change, and replaces the list once it is done. */
+static GPtrArray *chooser_applications = NULL;
+static gboolean   chooser_applications_loading = FALSE;
+static gboolean   chooser_applications_stale = FALSE;
+static GQuark     chooser_search_key_quark;
+
 
 
 G_DEFINE_TYPE (ThunarChooserModel, thunar_chooser_model, GTK_TYPE_TREE_STORE)
@@ -276,14 +293,177 @@ sort_app_infos (gconstpointer a,
 
 
 
+static gint
+sort_items (gconstpointer a,
+            gconstpointer b,
+            gpointer      user_data)
+{
+  return strcmp (((const ThunarChooserModelSortItem *) a)->collate_key,
+                 ((const ThunarChooserModelSortItem *) b)->collate_key);
+}
+
+
+
+static gchar*
+thunar_chooser_model_make_search_key (const gchar *name)
+{
+  gchar *normalized;
+  gchar *key;
+
+  normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    return g_strdup ("");
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+
+
+static GPtrArray*
+thunar_chooser_model_load_applications (void)
+{
+  ThunarChooserModelSortItem *items;
+  GPtrArray                  *applications;
+  GList                      *all;
+  GList                      *lp;
+  guint                       n_items = 0;
+  guint                       n;
+
+  /* may run in a thread, so nothing in here must touch GTK */
+  all = g_app_info_get_all ();
+  items = g_new (ThunarChooserModelSortItem, g_list_length (all));
+  for (lp = all; lp != NULL; lp = lp->next)
+    {
+      if (!thunar_g_app_info_should_show (lp->data))
+        {
+          g_object_unref (lp->data);
+          continue;
+        }
+
+      /* the list is not shared yet, so the search keys can be attached here */
+      g_object_set_qdata_full (G_OBJECT (lp->data), chooser_search_key_quark,
+                               thunar_chooser_model_make_search_key (g_app_info_get_name (lp->data)),
+                               g_free);
+
+      items[n_items].collate_key = g_utf8_collate_key (g_app_info_get_name (lp->data), -1);
+      items[n_items].app_info = lp->data;
+      n_items++;
+    }
+  g_list_free (all);
+
+  /* compare the collation keys instead of collating the names again and again */
+  g_qsort_with_data (items, n_items, sizeof (*items), sort_items, NULL);
+
+  applications = g_ptr_array_new_full (n_items, g_object_unref);
+  for (n = 0; n < n_items; n++)
+    {
+      g_ptr_array_add (applications, items[n].app_info);
+      g_free (items[n].collate_key);
+    }
+  g_free (items);
+
+  return applications;
+}
+
+
+
+static void
+thunar_chooser_model_load_thread (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  g_task_return_pointer (task, thunar_chooser_model_load_applications (), (GDestroyNotify) g_ptr_array_unref);
+}
+
+
+
+static void
+thunar_chooser_model_load_finished (GObject      *source_object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  GPtrArray *applications;
+
+  applications = g_task_propagate_pointer (G_TASK (result), NULL);
+  chooser_applications_loading = FALSE;
+
+  /* models that are already shown keep their rows */
+  if (G_LIKELY (applications != NULL))
+    {
+      g_ptr_array_unref (chooser_applications);
+      chooser_applications = applications;
+    }
+
+  /* something changed again while loading */
+  if (chooser_applications_stale)
+    thunar_chooser_model_refresh_applications ();
+}
+
+
+
+static void
+thunar_chooser_model_refresh_applications (void)
+{
+  GTask *task;
+
+  if (chooser_applications_loading)
+    {
+      /* load again once this refresh is done */
+      chooser_applications_stale = TRUE;
+      return;
+    }
+
+  chooser_applications_loading = TRUE;
+  chooser_applications_stale = FALSE;
+
+  task = g_task_new (NULL, NULL, thunar_chooser_model_load_finished, NULL);
+  g_task_run_in_thread (task, thunar_chooser_model_load_thread);
+  g_object_unref (task);
+}
+
+
+
+static void
+thunar_chooser_model_applications_changed (GAppInfoMonitor *monitor,
+                                           gpointer         user_data)
+{
+  thunar_chooser_model_refresh_applications ();
+}
+
+
+
+static GPtrArray*
+thunar_chooser_model_get_applications (void)
+{
+  /* the first model loads the applications right away */
+  if (G_UNLIKELY (chooser_applications == NULL))
+    {
+      chooser_search_key_quark = g_quark_from_static_string ("thunar-chooser-search-key");
+      chooser_applications = thunar_chooser_model_load_applications ();
+
+      g_signal_connect (G_OBJECT (g_app_info_monitor_get ()), "changed",
+                        G_CALLBACK (thunar_chooser_model_applications_changed), NULL);
+    }
+
+  return chooser_applications;
+}
+
+
+
 static void
 thunar_chooser_model_reload (ThunarChooserModel *model)
 {
-  GList *all;
-  GList *lp;
-  GList *other = NULL;
-  GList *recommended;
-  GList *default_app = NULL;
+  GHashTable *recommended_ids;
+  GPtrArray  *applications;
+  GAppInfo   *app_info;
+  GList      *lp;
+  GList      *other = NULL;
+  GList      *recommended;
+  GList      *default_app = NULL;
+  guint       n;
 
   _thunar_return_if_fail (THUNAR_IS_CHOOSER_MODEL (model));
   _thunar_return_if_fail (model->content_type != NULL);
@@ -312,19 +492,27 @@ thunar_chooser_model_reload (ThunarChooserModel *model)
                                "org.xfce.settings.default-applications",
                                recommended);
 
-  all = g_app_info_get_all ();
-  for (lp = all; lp != NULL; lp = lp->next)
+  /* the ids of the recommended applications */
+  recommended_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  for (lp = recommended; lp != NULL; lp = lp->next)
+    if (G_LIKELY (g_app_info_get_id (lp->data) != NULL))
+      g_hash_table_add (recommended_ids, (gpointer) g_app_info_get_id (lp->data));
+
+  /* the shared list is sorted already */
+  applications = thunar_chooser_model_get_applications ();
+  for (n = applications->len; n > 0; n--)
     {
-      if (g_list_find_custom (recommended,
-                              lp->data,
-                              compare_app_infos) == NULL)
+      app_info = g_ptr_array_index (applications, n - 1);
+      if (g_app_info_get_id (app_info) != NULL
+          ? !g_hash_table_contains (recommended_ids, g_app_info_get_id (app_info))
+          : g_list_find_custom (recommended, app_info, compare_app_infos) == NULL)
         {
-          other = g_list_prepend (other, lp->data);
+          other = g_list_prepend (other, app_info);
         }
     }
+  g_hash_table_destroy (recommended_ids);
 
   /* append the other applications */
-  other = g_list_sort (other, sort_app_infos);
   thunar_chooser_model_append (model,
                                _("Other Applications"),
                                "gnome-applications",
@@ -335,8 +523,6 @@ thunar_chooser_model_reload (ThunarChooserModel *model)
   g_list_free (default_app);
 
   g_list_free_full (recommended, g_object_unref);
-  g_list_free_full (all, g_object_unref);
-
   g_list_free (other);
 }
 
@@ -377,6 +563,35 @@ thunar_chooser_model_get_content_type (ThunarChooserModel *model)
 
 
 
+/**
+ * thunar_chooser_model_get_search_key:
+ * @app_info : a #GAppInfo of a #ThunarChooserModel.
+ *
+ * Returns the normalized and casefolded name of @app_info, which
+ * is what the interactive search of the dialog compares against.
+ *
+ * Return value: the search key of @app_info.
+ **/
+const gchar *
+thunar_chooser_model_get_search_key (GAppInfo *app_info)
+{
+  gchar *key;
+
+  _thunar_return_val_if_fail (G_IS_APP_INFO (app_info), NULL);
+
+  /* the keys of the shared applications are made while loading them */
+  key = g_object_get_qdata (G_OBJECT (app_info), chooser_search_key_quark);
+  if (G_UNLIKELY (key == NULL))
+    {
+      key = thunar_chooser_model_make_search_key (g_app_info_get_name (app_info));
+      g_object_set_qdata_full (G_OBJECT (app_info), chooser_search_key_quark, key, g_free);
+    }
+
+  return key;
+}
+
+
+
 /**
  * thunar_chooser_model_remove:
  * @model  : a #ThunarChooserModel.
@@ -59,6 +59,7 @@ GType               thunar_chooser_model_get_type         (void) G_GNUC_CONST;
 
 ThunarChooserModel *thunar_chooser_model_new              (const gchar        *content_type) G_GNUC_MALLOC;
 const gchar        *thunar_chooser_model_get_content_type (ThunarChooserModel *model);
+const gchar        *thunar_chooser_model_get_search_key   (GAppInfo           *app_info);
 gboolean            thunar_chooser_model_remove           (ThunarChooserModel *model,
                                                            GtkTreeIter        *iter,
                                                            gboolean            delete,
@@ -57,8 +57,17 @@ enum
   TARGET_TEXT_URI_LIST,
   TARGET_GNOME_COPIED_FILES,
   TARGET_UTF8_STRING,
+  N_TARGETS,
 };
 
+typedef struct
+{
+  ThunarClipboardManager *manager;
+  GFile                  *target_file;
+  GtkWidget              *widget;
+  GClosure               *new_files_closure;
+} ThunarClipboardPasteRequest;
+
 
 
 static void thunar_clipboard_manager_finalize           (GObject                     *object);
@@ -72,6 +81,10 @@ static void thunar_clipboard_manager_file_destroyed     (ThunarFile
 static void thunar_clipboard_manager_owner_changed      (GtkClipboard                *clipboard,
                                                          GdkEventOwnerChange         *event,
                                                          ThunarClipboardManager      *manager);
+static void thunar_clipboard_manager_paste_request_free (ThunarClipboardPasteRequest *request);
+static void thunar_clipboard_manager_paste_file_list    (ThunarClipboardPasteRequest *request,
+                                                         GList                       *file_list,
+                                                         gboolean                     path_copy);
 static void thunar_clipboard_manager_contents_received  (GtkClipboard                *clipboard,
                                                          GtkSelectionData            *selection_data,
                                                          gpointer                     user_data);
@@ -87,6 +100,7 @@ static void thunar_clipboard_manager_clear_callback     (GtkClipboard
 static void thunar_clipboard_manager_transfer_files     (ThunarClipboardManager      *manager,
                                                          gboolean                     copy,
                                                          GList                       *files);
+static void thunar_clipboard_manager_reset_payloads     (ThunarClipboardManager      *manager);
 
 
 
@@ -107,15 +121,16 @@ struct _ThunarClipboardManager
 
   gboolean      files_cutted;
   GList        *files;
-};
 
-typedef struct
-{
-  ThunarClipboardManager *manager;
-  GFile                  *target_file;
-  GtkWidget              *widget;
-  GClosure               *new_files_closure;
-} ThunarClipboardPasteRequest;
+  /* maps every file in files to its list link, so the
+   * renderers can check the cut state in constant time */
+  GHashTable   *files_links;
+
+  /* the serialized files for each target, built on
+   * first request and dropped whenever files changes */
+  gchar        *payloads[N_TARGETS];
+  gsize         payload_lengths[N_TARGETS];
+};
 
 
 
@@ -181,6 +196,7 @@ static void
 thunar_clipboard_manager_init (ThunarClipboardManager *manager)
 {
   manager->x_special_gnome_copied_files = gdk_atom_intern_static_string ("x-special/gnome-copied-files");
+  manager->files_links = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 
@@ -219,6 +235,8 @@ thunar_clipboard_manager_finalize (GObject *object)
       g_object_unref (G_OBJECT (lp->data));
     }
   g_list_free (manager->files);
+  g_hash_table_destroy (manager->files_links);
+  thunar_clipboard_manager_reset_payloads (manager);
 
   /* disconnect from the clipboard */
   g_signal_handlers_disconnect_by_func (G_OBJECT (manager->clipboard), thunar_clipboard_manager_owner_changed, manager);
@@ -256,11 +274,18 @@ static void
 thunar_clipboard_manager_file_destroyed (ThunarFile             *file,
                                          ThunarClipboardManager *manager)
 {
+  GList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
-  _thunar_return_if_fail (g_list_find (manager->files, file) != NULL);
+
+  /* lookup the list link for the file */
+  lp = g_hash_table_lookup (manager->files_links, file);
+  _thunar_return_if_fail (lp != NULL);
 
   /* remove the file from our list */
-  manager->files = g_list_remove (manager->files, file);
+  g_hash_table_remove (manager->files_links, file);
+  manager->files = g_list_delete_link (manager->files, lp);
+  thunar_clipboard_manager_reset_payloads (manager);
 
   /* disconnect from the file */
   g_signal_handlers_disconnect_by_func (G_OBJECT (file), thunar_clipboard_manager_file_destroyed, manager);
@@ -291,39 +316,26 @@ thunar_clipboard_manager_owner_changed (GtkClipboard           *clipboard,
 
 
 static void
-thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
-                                            GtkSelectionData *selection_data,
-                                            gpointer          user_data)
+thunar_clipboard_manager_paste_request_free (ThunarClipboardPasteRequest *request)
 {
-  ThunarClipboardPasteRequest *request = user_data;
-  ThunarClipboardManager      *manager = THUNAR_CLIPBOARD_MANAGER (request->manager);
-  ThunarApplication           *application;
-  gboolean                     path_copy = TRUE;
-  GList                       *file_list = NULL;
-  gchar                       *data;
+  if (G_LIKELY (request->widget != NULL))
+    g_object_remove_weak_pointer (G_OBJECT (request->widget), (gpointer) &request->widget);
+  if (G_LIKELY (request->new_files_closure != NULL))
+    g_closure_unref (request->new_files_closure);
+  g_object_unref (G_OBJECT (request->manager));
+  g_object_unref (request->target_file);
+  g_slice_free (ThunarClipboardPasteRequest, request);
+}
 
-  /* check whether the retrieval worked */
-  if (G_LIKELY (gtk_selection_data_get_length (selection_data) > 0))
-    {
-      /* be sure the selection data is zero-terminated */
-      data = (gchar *) gtk_selection_data_get_data (selection_data);
-      data[gtk_selection_data_get_length (selection_data)] = '\0';
 
-      /* check whether to copy or move */
-      if (g_ascii_strncasecmp (data, "copy\n", 5) == 0)
-        {
-          path_copy = TRUE;
-          data += 5;
-        }
-      else if (g_ascii_strncasecmp (data, "cut\n", 4) == 0)
-        {
-          path_copy = FALSE;
-          data += 4;
-        }
 
-      /* determine the path list stored with the selection */
-      file_list = thunar_g_file_list_new_from_string (data);
-    }
+static void
+thunar_clipboard_manager_paste_file_list (ThunarClipboardPasteRequest *request,
+                                          GList                       *file_list,
+                                          gboolean                     path_copy)
+{
+  ThunarClipboardManager *manager = request->manager;
+  ThunarApplication      *application;
 
   /* perform the action if possible */
   if (G_LIKELY (file_list != NULL))
@@ -334,7 +346,6 @@ thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
       else
         thunar_application_move_into (application, request->widget, file_list, request->target_file, THUNAR_OPERATION_LOG_OPERATIONS, request->new_files_closure);
       g_object_unref (G_OBJECT (application));
-      thunar_g_list_free_full (file_list);
 
       /* clear the clipboard if it contained "cutted data"
        * (gtk_clipboard_clear takes care of not clearing
@@ -355,15 +366,48 @@ thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
       /* tell the user that we cannot paste */
       thunar_dialogs_show_error (request->widget, NULL, _("There is nothing on the clipboard to paste"));
     }
+}
+
+
+
+static void
+thunar_clipboard_manager_contents_received (GtkClipboard     *clipboard,
+                                            GtkSelectionData *selection_data,
+                                            gpointer          user_data)
+{
+  ThunarClipboardPasteRequest *request = user_data;
+  gboolean                     path_copy = TRUE;
+  GList                       *file_list = NULL;
+  gchar                       *data;
+
+  /* check whether the retrieval worked */
+  if (G_LIKELY (gtk_selection_data_get_length (selection_data) > 0))
+    {
+      /* be sure the selection data is zero-terminated */
+      data = (gchar *) gtk_selection_data_get_data (selection_data);
+      data[gtk_selection_data_get_length (selection_data)] = '\0';
+
+      /* check whether to copy or move */
+      if (g_ascii_strncasecmp (data, "copy\n", 5) == 0)
+        {
+          path_copy = TRUE;
+          data += 5;
+        }
+      else if (g_ascii_strncasecmp (data, "cut\n", 4) == 0)
+        {
+          path_copy = FALSE;
+          data += 4;
+        }
+
+      /* determine the path list stored with the selection */
+      file_list = thunar_g_file_list_new_from_string (data);
+    }
+
+  thunar_clipboard_manager_paste_file_list (request, file_list, path_copy);
+  thunar_g_list_free_full (file_list);
 
   /* free the request */
-  if (G_LIKELY (request->widget != NULL))
-    g_object_remove_weak_pointer (G_OBJECT (request->widget), (gpointer) &request->widget);
-  if (G_LIKELY (request->new_files_closure != NULL))
-    g_closure_unref (request->new_files_closure);
-  g_object_unref (G_OBJECT (request->manager));
-  g_object_unref (request->target_file);
-  g_slice_free (ThunarClipboardPasteRequest, request);
+  thunar_clipboard_manager_paste_request_free (request);
 }
 
 
@@ -408,37 +452,56 @@ thunar_clipboard_manager_targets_received (GtkClipboard     *clipboard,
 
 
 
-static gchar *
-thunar_clipboard_manager_g_file_list_to_string (GList       *list,
-                                                const gchar *prefix,
-                                                gboolean     format_for_text,
-                                                gsize       *len)
+static void
+thunar_clipboard_manager_reset_payloads (ThunarClipboardManager *manager)
+{
+  guint n;
+
+  for (n = 0; n < N_TARGETS; ++n)
+    {
+      g_free (manager->payloads[n]);
+      manager->payloads[n] = NULL;
+      manager->payload_lengths[n] = 0;
+    }
+}
+
+
+
+static void
+thunar_clipboard_manager_build_payload (ThunarClipboardManager *manager,
+                                        guint                   target_info)
 {
   GString *string;
-  gchar   *tmp;
+  GFile   *file;
   GList   *lp;
+  gchar   *tmp;
 
   /* allocate initial string */
-  string = g_string_new (prefix);
+  string = g_string_new (NULL);
+  if (target_info == TARGET_GNOME_COPIED_FILES)
+    string = g_string_append (string, manager->files_cutted ? "cut\n" : "copy\n");
 
-  for (lp = list; lp != NULL; lp = lp->next)
+  for (lp = manager->files; lp != NULL; lp = lp->next)
     {
-      if (format_for_text)
-        tmp = g_file_get_parse_name (G_FILE (lp->data));
+      file = thunar_file_get_file (THUNAR_FILE (lp->data));
+      if (target_info == TARGET_UTF8_STRING)
+        tmp = g_file_get_parse_name (file);
       else
-        tmp = g_file_get_uri (G_FILE (lp->data));
+        tmp = g_file_get_uri (file);
 
       string = g_string_append (string, tmp);
       g_free (tmp);
 
-      if (lp->next != NULL)
+      /* text/uri-list wants every line terminated by CRLF,
+       * the other targets separate the lines with LF */
+      if (target_info == TARGET_TEXT_URI_LIST)
+        string = g_string_append (string, "\r\n");
+      else if (lp->next != NULL)
         string = g_string_append_c (string, '\n');
     }
 
-  if (len != NULL)
-    *len = string->len;
-
-  return g_string_free (string, FALSE);
+  manager->payload_lengths[target_info] = string->len;
+  manager->payloads[target_info] = g_string_free (string, FALSE);
 }
 
 
@@ -449,47 +512,34 @@ thunar_clipboard_manager_get_callback (GtkClipboard     *clipboard,
                                        guint             target_info,
                                        gpointer          user_data)
 {
-  ThunarClipboardManager  *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
-  GList                   *file_list;
-  gchar                   *str;
-  gchar                  **uris;
-  const gchar             *prefix;
-  gsize                    len;
+  ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
 
   _thunar_return_if_fail (GTK_IS_CLIPBOARD (clipboard));
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
   _thunar_return_if_fail (manager->clipboard == clipboard);
+  _thunar_return_if_fail (target_info < N_TARGETS);
 
-  /* determine the path list from the file list */
-  file_list = thunar_file_list_to_thunar_g_file_list (manager->files);
+  /* serialize the files only once per clipboard contents */
+  if (manager->payloads[target_info] == NULL)
+    thunar_clipboard_manager_build_payload (manager, target_info);
 
   switch (target_info)
     {
     case TARGET_TEXT_URI_LIST:
-      uris = thunar_g_file_list_to_stringv (file_list);
-      gtk_selection_data_set_uris (selection_data, uris);
-      g_strfreev (uris);
-      break;
-
     case TARGET_GNOME_COPIED_FILES:
-      prefix = manager->files_cutted ? "cut\n" : "copy\n";
-      str = thunar_clipboard_manager_g_file_list_to_string (file_list, prefix, FALSE, &len);
-      gtk_selection_data_set (selection_data, gtk_selection_data_get_target (selection_data), 8, (guchar *) str, len);
-      g_free (str);
+      gtk_selection_data_set (selection_data, gtk_selection_data_get_target (selection_data), 8,
+                              (const guchar *) manager->payloads[target_info],
+                              manager->payload_lengths[target_info]);
       break;
 
     case TARGET_UTF8_STRING:
-      str = thunar_clipboard_manager_g_file_list_to_string (file_list, NULL, TRUE, &len);
-      gtk_selection_data_set_text (selection_data, str, len);
-      g_free (str);
+      gtk_selection_data_set_text (selection_data, manager->payloads[target_info],
+                                   manager->payload_lengths[target_info]);
       break;
 
     default:
       _thunar_assert_not_reached ();
     }
-
-  /* cleanup */
-  thunar_g_list_free_full (file_list);
 }
 
 
@@ -512,6 +562,8 @@ thunar_clipboard_manager_clear_callback (GtkClipboard *clipboard,
       g_object_unref (G_OBJECT (lp->data));
     }
   g_list_free (manager->files);
+  g_hash_table_remove_all (manager->files_links);
+  thunar_clipboard_manager_reset_payloads (manager);
   manager->files = NULL;
 }
 
@@ -532,6 +584,8 @@ thunar_clipboard_manager_transfer_files (ThunarClipboardManager *manager,
       g_object_unref (G_OBJECT (lp->data));
     }
   g_list_free (manager->files);
+  g_hash_table_remove_all (manager->files_links);
+  thunar_clipboard_manager_reset_payloads (manager);
 
   /* remember the transfer operation */
   manager->files_cutted = !copy;
@@ -541,6 +595,7 @@ thunar_clipboard_manager_transfer_files (ThunarClipboardManager *manager,
     {
       file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
       manager->files = g_list_prepend (manager->files, file);
+      g_hash_table_insert (manager->files_links, file, manager->files);
       g_signal_connect (G_OBJECT (file), "destroy", G_CALLBACK (thunar_clipboard_manager_file_destroyed), manager);
     }
 
@@ -646,7 +701,7 @@ thunar_clipboard_manager_has_cutted_file (ThunarClipboardManager *manager,
   _thunar_return_val_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
 
-  return (manager->files_cutted && g_list_find (manager->files, file) != NULL);
+  return (manager->files_cutted && g_hash_table_contains (manager->files_links, file));
 }
 
 
@@ -711,6 +766,7 @@ thunar_clipboard_manager_paste_files (ThunarClipboardManager *manager,
                                       GClosure               *new_files_closure)
 {
   ThunarClipboardPasteRequest *request;
+  GList                       *file_list;
 
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
   _thunar_return_if_fail (widget == NULL || GTK_IS_WIDGET (widget));
@@ -735,6 +791,18 @@ thunar_clipboard_manager_paste_files (ThunarClipboardManager *manager,
   if (G_LIKELY (request->widget != NULL))
     g_object_add_weak_pointer (G_OBJECT (request->widget), (gpointer) &request->widget);
 
+  /* if we own the clipboard ourselves, hand over our files
+   * directly instead of serializing and parsing them again */
+  if (gtk_clipboard_get_owner (manager->clipboard) == G_OBJECT (manager)
+      && manager->files != NULL)
+    {
+      file_list = thunar_file_list_to_thunar_g_file_list (manager->files);
+      thunar_clipboard_manager_paste_file_list (request, file_list, !manager->files_cutted);
+      thunar_g_list_free_full (file_list);
+      thunar_clipboard_manager_paste_request_free (request);
+      return;
+    }
+
   /* schedule the request */
   gtk_clipboard_request_contents (manager->clipboard, manager->x_special_gnome_copied_files,
                                   thunar_clipboard_manager_contents_received, request);
@@ -38,10 +38,16 @@
 #include <thunar/thunar-chooser-dialog.h>
 #include <thunar/thunar-dbus-service.h>
 #include <thunar/thunar-file.h>
+#include <thunar/thunar-folder.h>
 #include <thunar/thunar-gdk-extensions.h>
+#include <thunar/thunar-icon-factory.h>
+#include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-job-executor.h>
+#include <thunar/thunar-list-model.h>
 #include <thunar/thunar-preferences-dialog.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
@@ -60,6 +66,9 @@ typedef enum
   THUNAR_DBUS_TRANSFER_MODE_LINK_INTO,
 } ThunarDBusTransferMode;
 
+typedef struct _ThunarDBusBatch     ThunarDBusBatch;
+typedef struct _ThunarDBusBatchItem ThunarDBusBatchItem;
+
 
 static void     thunar_dbus_service_finalize                    (GObject                *object);
 static gboolean thunar_dbus_service_connect_trash_bin           (ThunarDBusService      *dbus_service,
@@ -228,6 +237,54 @@ static gboolean thunar_dbus_service_unlink_files                (ThunarDBusFileM
 static gboolean thunar_dbus_service_terminate                   (ThunarDBusThunar       *object,
                                                                  GDBusMethodInvocation  *invocation,
                                                                  ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_execute_batch               (ThunarDBusThunar       *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 const gchar            *working_directory,
+                                                                 GVariant               *operations,
+                                                                 gboolean                show_progress,
+                                                                 const gchar            *display,
+                                                                 const gchar            *startup_id,
+                                                                 ThunarDBusService      *dbus_service);
+static GList   *thunar_dbus_service_batch_parse_files           (const gchar            *working_directory,
+                                                                 const gchar * const    *filenames,
+                                                                 GError                **error);
+static ThunarJob *thunar_dbus_service_batch_create_job          (const gchar            *working_directory,
+                                                                 const gchar            *kind,
+                                                                 const gchar * const    *source_filenames,
+                                                                 const gchar * const    *target_filenames,
+                                                                 const gchar           **icon_name,
+                                                                 const gchar           **title,
+                                                                 GError                **error);
+static void     thunar_dbus_service_batch_free                  (ThunarDBusBatch        *batch);
+static void     thunar_dbus_service_batch_item_free             (gpointer                data);
+static ThunarJobResponse thunar_dbus_service_batch_ask          (ThunarJob              *job,
+                                                                 const gchar            *message,
+                                                                 ThunarJobResponse       choices,
+                                                                 ThunarDBusBatch        *batch);
+static void     thunar_dbus_service_batch_error                 (ThunarJob              *job,
+                                                                 GError                 *error,
+                                                                 ThunarDBusBatch        *batch);
+static void     thunar_dbus_service_batch_percent               (ThunarJob              *job,
+                                                                 gdouble                 percent,
+                                                                 ThunarDBusBatch        *batch);
+static void     thunar_dbus_service_batch_finished              (ThunarJob              *job,
+                                                                 ThunarDBusBatch        *batch);
+static gboolean thunar_dbus_service_get_statistics              (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_get_memory_census           (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_set_slow_callback_threshold (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 guint                   threshold,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_get_slow_callbacks          (ThunarDBusDebug        *object,
+                                                                 GDBusMethodInvocation  *invocation,
+                                                                 ThunarDBusService      *dbus_service);
+static gboolean thunar_dbus_service_batch_run                   (gpointer                user_data);
+static void     thunar_dbus_service_batch_item_done             (ThunarDBusBatch        *batch,
+                                                                 ThunarDBusBatchItem    *item);
 
 static gboolean thunar_dbus_freedesktop_show_folders            (ThunarOrgFreedesktopFileManager1 *object,
                                                                  GDBusMethodInvocation            *invocation,
@@ -258,9 +315,41 @@ struct _ThunarDBusService
   ThunarDBusFileManager            *file_manager;
   ThunarDBusTrash                  *trash;
   ThunarDBusThunar                 *thunar;
+  ThunarDBusDebug                  *debug;
   ThunarOrgFreedesktopFileManager1 *file_manager_fdo;
 
   ThunarFile      *trash_bin;
+
+  /* item count of the trash bin last sent to the clients, G_MAXUINT if none */
+  guint            trash_item_count;
+
+  /* identifier of the last batch started with ExecuteBatch */
+  guint            last_batch_id;
+};
+
+struct _ThunarDBusBatch
+{
+  ThunarDBusService *dbus_service;
+  guint              id;
+
+  /* the screen for the progress dialog, or %NULL to run without any dialogs */
+  GdkScreen         *screen;
+  gboolean           show_progress;
+
+  /* the operations, which are run one after another */
+  GPtrArray         *items;
+  guint              n_finished;
+  guint              n_failed;
+};
+
+struct _ThunarDBusBatchItem
+{
+  ThunarJob *job;
+  gchar     *icon_name;
+  gchar     *title;
+
+  /* the error message, if the operation failed */
+  gchar     *message;
 };
 
 
@@ -309,7 +398,9 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
   dbus_service->file_manager      = thunar_dbus_file_manager_skeleton_new ();
   dbus_service->trash             = thunar_dbus_trash_skeleton_new ();
   dbus_service->thunar            = thunar_dbus_thunar_skeleton_new ();
+  dbus_service->debug             = thunar_dbus_debug_skeleton_new ();
   dbus_service->file_manager_fdo  = thunar_org_freedesktop_file_manager1_skeleton_new ();
+  dbus_service->trash_item_count  = G_MAXUINT;
 
   connect_signals_multiple (dbus_service->file_manager, dbus_service,
                             "handle-display-chooser-dialog", thunar_dbus_service_display_chooser_dialog,
@@ -341,6 +432,14 @@ thunar_dbus_service_init (ThunarDBusService *dbus_service)
   connect_signals_multiple (dbus_service->thunar, dbus_service,
                             "handle-bulk-rename", thunar_dbus_service_bulk_rename,
                             "handle-terminate", thunar_dbus_service_terminate,
+                            "handle-execute-batch", thunar_dbus_service_execute_batch,
+                            NULL);
+
+  connect_signals_multiple (dbus_service->debug, dbus_service,
+                            "handle-get-statistics", thunar_dbus_service_get_statistics,
+                            "handle-get-memory-census", thunar_dbus_service_get_memory_census,
+                            "handle-set-slow-callback-threshold", thunar_dbus_service_set_slow_callback_threshold,
+                            "handle-get-slow-callbacks", thunar_dbus_service_get_slow_callbacks,
                             NULL);
 
   connect_signals_multiple (dbus_service->file_manager_fdo, dbus_service,
@@ -360,6 +459,7 @@ thunar_dbus_service_finalize (GObject *object)
   g_object_unref (dbus_service->file_manager);
   g_object_unref (dbus_service->trash);
   g_object_unref (dbus_service->thunar);
+  g_object_unref (dbus_service->debug);
   g_object_unref (dbus_service->file_manager_fdo);
 
   if (dbus_service->trash_bin)
@@ -431,11 +531,20 @@ static void
 thunar_dbus_service_trash_bin_changed (ThunarDBusService *dbus_service,
                                        ThunarFile        *trash_bin)
 {
+  guint item_count;
+
   _thunar_return_if_fail (THUNAR_IS_DBUS_SERVICE (dbus_service));
   _thunar_return_if_fail (dbus_service->trash_bin == trash_bin);
   _thunar_return_if_fail (THUNAR_IS_FILE (trash_bin));
 
-  /* emit the "trash-changed" signal with the new state */
+  /* the trash bin info carries the item count, only tell the clients if it changed */
+  item_count = thunar_file_get_item_count (trash_bin);
+  if (item_count == dbus_service->trash_item_count)
+    return;
+  dbus_service->trash_item_count = item_count;
+
+  /* emit the "trash-state-changed" and "trash-changed" signals with the new state */
+  thunar_dbus_trash_emit_trash_state_changed (dbus_service->trash, item_count > 0, item_count);
   thunar_dbus_trash_emit_trash_changed (dbus_service->trash);
 }
 
@@ -1544,6 +1653,583 @@ thunar_dbus_service_terminate (ThunarDBusThunar       *object,
 
 
 
+static GList *
+thunar_dbus_service_batch_parse_files (const gchar         *working_directory,
+                                       const gchar * const *filenames,
+                                       GError             **error)
+{
+  GError *err = NULL;
+  GFile  *file;
+  GList  *file_list = NULL;
+  gchar  *filename;
+  gchar  *cwd;
+  guint   n;
+
+  cwd = !xfce_str_is_empty (working_directory) ? g_strdup (working_directory) : g_get_current_dir ();
+
+  for (n = 0; err == NULL && filenames[n] != NULL; ++n)
+    {
+      filename = g_filename_from_utf8 (filenames[n], -1, NULL, NULL, &err);
+      if (filename != NULL)
+        {
+          file = g_file_new_for_commandline_arg_and_cwd (filename, cwd);
+          file_list = g_list_prepend (file_list, file);
+          g_free (filename);
+        }
+    }
+
+  g_free (cwd);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      thunar_g_list_free_full (file_list);
+      return NULL;
+    }
+
+  return g_list_reverse (file_list);
+}
+
+
+
+static ThunarJob *
+thunar_dbus_service_batch_create_job (const gchar         *working_directory,
+                                      const gchar         *kind,
+                                      const gchar * const *source_filenames,
+                                      const gchar * const *target_filenames,
+                                      const gchar        **icon_name,
+                                      const gchar        **title,
+                                      GError             **error)
+{
+  ThunarJob *job = NULL;
+  GList     *source_file_list;
+  GList     *target_file_list = NULL;
+  GList     *lp;
+  gchar     *basename;
+
+  if (*source_filenames == NULL)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("At least one source filename must be specified"));
+      return NULL;
+    }
+
+  source_file_list = thunar_dbus_service_batch_parse_files (working_directory, source_filenames, error);
+  if (source_file_list == NULL)
+    return NULL;
+
+  if (g_strcmp0 (kind, "Trash") == 0)
+    {
+      job = thunar_io_jobs_trash_files (source_file_list);
+      *icon_name = "user-trash-full";
+      *title = _("Moving files into the trash...");
+    }
+  else if (g_strcmp0 (kind, "Unlink") == 0)
+    {
+      job = thunar_io_jobs_unlink_files (source_file_list);
+      *icon_name = "edit-delete";
+      *title = _("Deleting files...");
+    }
+  else if (g_strcmp0 (kind, "CopyTo") == 0)
+    {
+      if (g_strv_length ((gchar **) source_filenames) != g_strv_length ((gchar **) target_filenames))
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("The number of source and target filenames must be the same"));
+        }
+      else
+        {
+          target_file_list = thunar_dbus_service_batch_parse_files (working_directory, target_filenames, error);
+          if (target_file_list != NULL)
+            job = thunar_io_jobs_copy_files (source_file_list, target_file_list);
+        }
+      *icon_name = "edit-copy";
+      *title = _("Copying files...");
+    }
+  else if (g_strcmp0 (kind, "CopyInto") == 0
+           || g_strcmp0 (kind, "MoveInto") == 0
+           || g_strcmp0 (kind, "LinkInto") == 0)
+    {
+      if (g_strv_length ((gchar **) target_filenames) != 1)
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       _("A destination directory must be specified"));
+        }
+      else
+        {
+          target_file_list = thunar_dbus_service_batch_parse_files (working_directory, target_filenames, error);
+          if (target_file_list != NULL)
+            {
+              /* the job expects the target of each source file */
+              lp = target_file_list;
+              target_file_list = NULL;
+              for (GList *sp = source_file_list; sp != NULL; sp = sp->next)
+                {
+                  basename = g_file_get_basename (sp->data);
+                  target_file_list = g_list_prepend (target_file_list, g_file_get_child (lp->data, basename));
+                  g_free (basename);
+                }
+              target_file_list = g_list_reverse (target_file_list);
+              thunar_g_list_free_full (lp);
+
+              if (*kind == 'C')
+                {
+                  job = thunar_io_jobs_copy_files (source_file_list, target_file_list);
+                  *icon_name = "edit-copy";
+                  *title = _("Copying files...");
+                }
+              else if (*kind == 'M')
+                {
+                  job = thunar_io_jobs_move_files (source_file_list, target_file_list);
+                  *icon_name = "stock_folder-move";
+                  *title = _("Moving files...");
+                }
+              else
+                {
+                  job = thunar_io_jobs_link_files (source_file_list, target_file_list);
+                  *icon_name = "insert-link";
+                  *title = _("Creating symbolic links...");
+                }
+            }
+        }
+    }
+  else
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   _("Unknown operation \"%s\""), kind);
+    }
+
+  thunar_g_list_free_full (source_file_list);
+  thunar_g_list_free_full (target_file_list);
+
+  if (job != NULL)
+    thunar_job_set_log_mode (job, THUNAR_OPERATION_LOG_NO_OPERATIONS);
+
+  return job;
+}
+
+
+
+static void
+thunar_dbus_service_batch_free (ThunarDBusBatch *batch)
+{
+  g_ptr_array_free (batch->items, TRUE);
+  if (batch->screen != NULL)
+    g_object_unref (batch->screen);
+  g_object_unref (batch->dbus_service);
+  g_slice_free (ThunarDBusBatch, batch);
+}
+
+
+
+static void
+thunar_dbus_service_batch_item_free (gpointer data)
+{
+  ThunarDBusBatchItem *item = data;
+
+  if (item->job != NULL)
+    g_object_unref (item->job);
+  g_free (item->icon_name);
+  g_free (item->title);
+  g_free (item->message);
+  g_slice_free (ThunarDBusBatchItem, item);
+}
+
+
+
+static ThunarJobResponse
+thunar_dbus_service_batch_ask (ThunarJob        *job,
+                               const gchar      *message,
+                               ThunarJobResponse choices,
+                               ThunarDBusBatch  *batch)
+{
+  /* without a progress dialog nobody could answer, so skip conflicting files */
+  if ((choices & THUNAR_JOB_RESPONSE_SKIP_ALL) != 0)
+    return THUNAR_JOB_RESPONSE_SKIP_ALL;
+  if ((choices & THUNAR_JOB_RESPONSE_SKIP) != 0)
+    return THUNAR_JOB_RESPONSE_SKIP;
+  if ((choices & THUNAR_JOB_RESPONSE_NO) != 0)
+    return THUNAR_JOB_RESPONSE_NO;
+  return THUNAR_JOB_RESPONSE_CANCEL;
+}
+
+
+
+static void
+thunar_dbus_service_batch_error (ThunarJob       *job,
+                                 GError          *error,
+                                 ThunarDBusBatch *batch)
+{
+  ThunarDBusBatchItem *item = g_ptr_array_index (batch->items, batch->n_finished);
+
+  /* remember the first error of the operation */
+  if (item->message == NULL)
+    item->message = g_strdup (error->message);
+}
+
+
+
+static void
+thunar_dbus_service_batch_percent (ThunarJob       *job,
+                                   gdouble          percent,
+                                   ThunarDBusBatch *batch)
+{
+  thunar_dbus_thunar_emit_batch_progress (batch->dbus_service->thunar, batch->id,
+                                          batch->n_finished, batch->items->len,
+                                          (batch->n_finished * 100.0 + CLAMP (percent, 0.0, 100.0)) / batch->items->len);
+}
+
+
+
+static void
+thunar_dbus_service_batch_finished (ThunarJob       *job,
+                                    ThunarDBusBatch *batch)
+{
+  ThunarDBusBatchItem *item = g_ptr_array_index (batch->items, batch->n_finished);
+
+  g_signal_handlers_disconnect_by_data (job, batch);
+
+  if (item->message == NULL && exo_job_is_cancelled (EXO_JOB (job)))
+    item->message = g_strdup (_("Operation cancelled"));
+
+  thunar_dbus_service_batch_item_done (batch, item);
+}
+
+
+
+static void
+thunar_dbus_service_batch_item_done (ThunarDBusBatch     *batch,
+                                     ThunarDBusBatchItem *item)
+{
+  if (item->message != NULL)
+    batch->n_failed++;
+
+  thunar_dbus_thunar_emit_batch_item_finished (batch->dbus_service->thunar, batch->id, batch->n_finished,
+                                               item->message == NULL, item->message != NULL ? item->message : "");
+
+  batch->n_finished++;
+
+  thunar_dbus_thunar_emit_batch_progress (batch->dbus_service->thunar, batch->id,
+                                          batch->n_finished, batch->items->len,
+                                          batch->n_finished * 100.0 / batch->items->len);
+
+  /* start the next operation once the job is done emitting */
+  g_idle_add (thunar_dbus_service_batch_run, batch);
+}
+
+
+
+static gboolean
+thunar_dbus_service_batch_run (gpointer user_data)
+{
+  ThunarDBusBatch     *batch = user_data;
+  ThunarDBusBatchItem *item;
+  ThunarApplication   *application;
+
+  /* release the job of the previous operation */
+  if (batch->n_finished > 0)
+    {
+      item = g_ptr_array_index (batch->items, batch->n_finished - 1);
+      g_clear_object (&item->job);
+    }
+
+  /* operations which could not be parsed fail right away */
+  while (batch->n_finished < batch->items->len)
+    {
+      item = g_ptr_array_index (batch->items, batch->n_finished);
+      if (item->job != NULL)
+        break;
+
+      batch->n_failed++;
+      thunar_dbus_thunar_emit_batch_item_finished (batch->dbus_service->thunar, batch->id, batch->n_finished,
+                                                   FALSE, item->message);
+      batch->n_finished++;
+    }
+
+  if (batch->n_finished == batch->items->len)
+    {
+      thunar_dbus_thunar_emit_batch_finished (batch->dbus_service->thunar, batch->id, batch->n_failed);
+      thunar_dbus_service_batch_free (batch);
+      return G_SOURCE_REMOVE;
+    }
+
+  g_signal_connect (item->job, "error", G_CALLBACK (thunar_dbus_service_batch_error), batch);
+  g_signal_connect (item->job, "percent", G_CALLBACK (thunar_dbus_service_batch_percent), batch);
+  g_signal_connect (item->job, "finished", G_CALLBACK (thunar_dbus_service_batch_finished), batch);
+
+  if (batch->show_progress)
+    {
+      application = thunar_application_get ();
+      thunar_application_add_progress_job (application, batch->screen, item->job, item->icon_name, item->title);
+      g_object_unref (application);
+    }
+  else
+    {
+      g_signal_connect (item->job, "ask", G_CALLBACK (thunar_dbus_service_batch_ask), batch);
+      thunar_job_launch (THUNAR_JOB (item->job));
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_execute_batch (ThunarDBusThunar       *object,
+                                   GDBusMethodInvocation  *invocation,
+                                   const gchar            *working_directory,
+                                   GVariant               *operations,
+                                   gboolean                show_progress,
+                                   const gchar            *display,
+                                   const gchar            *startup_id,
+                                   ThunarDBusService      *dbus_service)
+{
+  ThunarDBusBatchItem *item;
+  ThunarDBusBatch     *batch;
+  GVariantIter         iter;
+  const gchar         *kind;
+  const gchar         *icon_name;
+  const gchar         *title;
+  const gchar        **source_filenames;
+  const gchar        **target_filenames;
+  GdkScreen           *screen = NULL;
+  GError              *error = NULL;
+
+  if (g_variant_n_children (operations) == 0)
+    {
+      g_dbus_method_invocation_return_error (invocation, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                                             _("At least one operation must be specified"));
+      return TRUE;
+    }
+
+  if (show_progress)
+    {
+      /* try to open the screen for the display name */
+      screen = thunar_gdk_screen_open (display, &error);
+      if (screen == NULL)
+        {
+          g_dbus_method_invocation_take_error (invocation, error);
+          return TRUE;
+        }
+    }
+
+  batch = g_slice_new0 (ThunarDBusBatch);
+  batch->dbus_service = g_object_ref (dbus_service);
+  batch->id = ++dbus_service->last_batch_id;
+  batch->screen = screen;
+  batch->show_progress = show_progress;
+  batch->items = g_ptr_array_new_full (g_variant_n_children (operations), thunar_dbus_service_batch_item_free);
+
+  /* create all jobs upfront, so the next one is ready once the previous one finished */
+  g_variant_iter_init (&iter, operations);
+  while (g_variant_iter_next (&iter, "(&s^a&s^a&s)", &kind, &source_filenames, &target_filenames))
+    {
+      item = g_slice_new0 (ThunarDBusBatchItem);
+      item->job = thunar_dbus_service_batch_create_job (working_directory, kind, source_filenames, target_filenames,
+                                                        &icon_name, &title, &error);
+      if (item->job != NULL)
+        {
+          item->icon_name = g_strdup (icon_name);
+          item->title = g_strdup (title);
+        }
+      else
+        {
+          item->message = g_strdup (error->message);
+          g_clear_error (&error);
+        }
+      g_ptr_array_add (batch->items, item);
+
+      g_free (source_filenames);
+      g_free (target_filenames);
+    }
+
+  thunar_dbus_thunar_complete_execute_batch (object, invocation, batch->id);
+
+  /* start after the reply, so the caller knows the id before the first signal */
+  g_idle_add (thunar_dbus_service_batch_run, batch);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_statistics (ThunarDBusDebug       *object,
+                                    GDBusMethodInvocation *invocation,
+                                    ThunarDBusService     *dbus_service)
+{
+  GVariantBuilder counters;
+  GVariantBuilder histograms;
+  GVariantBuilder buckets;
+  guint64         values[THUNAR_STATS_N_BUCKETS];
+  guint64         count;
+  guint64         sum;
+  guint           n, m;
+  guint           n_running;
+  guint           n_queued;
+  guint           n_monitors;
+  guint           n_shared;
+  guint           n_polled;
+  gchar          *name;
+
+  g_variant_builder_init (&counters, G_VARIANT_TYPE ("a{st}"));
+  for (n = 0; n < THUNAR_STATS_N_COUNTERS; ++n)
+    g_variant_builder_add (&counters, "{st}", thunar_stats_counter_get_name (n), thunar_stats_counter_get_value (n));
+
+  /* gauges are sampled on request */
+  g_variant_builder_add (&counters, "{st}", "file-cache-size", (guint64) thunar_file_cache_get_size ());
+  g_variant_builder_add (&counters, "{st}", "file-watch-budget",
+                         (guint64) thunar_file_watch_get_state (&n_monitors, &n_shared, &n_polled));
+  g_variant_builder_add (&counters, "{st}", "file-watch-monitors", (guint64) n_monitors);
+  g_variant_builder_add (&counters, "{st}", "file-watch-shared", (guint64) n_shared);
+  g_variant_builder_add (&counters, "{st}", "file-watch-polled", (guint64) n_polled);
+  for (n = 0; n < THUNAR_JOB_N_POOLS; ++n)
+    {
+      thunar_job_executor_get_pool_state (n, &n_running, &n_queued);
+      name = g_strdup_printf ("job-pool-%s-running", thunar_job_executor_get_pool_name (n));
+      g_variant_builder_add (&counters, "{st}", name, (guint64) n_running);
+      g_free (name);
+      name = g_strdup_printf ("job-pool-%s-queued", thunar_job_executor_get_pool_name (n));
+      g_variant_builder_add (&counters, "{st}", name, (guint64) n_queued);
+      g_free (name);
+    }
+
+  g_variant_builder_init (&histograms, G_VARIANT_TYPE ("a{s(ttat)}"));
+  for (n = 0; n < THUNAR_STATS_N_HISTOGRAMS; ++n)
+    {
+      thunar_stats_histogram_get_values (n, &count, &sum, values);
+
+      g_variant_builder_init (&buckets, G_VARIANT_TYPE ("at"));
+      for (m = 0; m < THUNAR_STATS_N_BUCKETS; ++m)
+        g_variant_builder_add (&buckets, "t", values[m]);
+
+      g_variant_builder_add (&histograms, "{s(tt@at)}", thunar_stats_histogram_get_name (n),
+                             count, sum, g_variant_builder_end (&buckets));
+    }
+
+  thunar_dbus_debug_complete_get_statistics (object, invocation,
+                                             g_variant_builder_end (&counters),
+                                             g_variant_builder_end (&histograms));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_memory_census (ThunarDBusDebug       *object,
+                                       GDBusMethodInvocation *invocation,
+                                       ThunarDBusService     *dbus_service)
+{
+  ThunarIconFactory *icon_factory;
+  ThunarFileCensus  *census;
+  ThunarFileCensus   total = { 0, };
+  GVariantBuilder    totals;
+  GVariantBuilder    folders;
+  GHashTableIter     iter;
+  GHashTable        *files;
+  const gchar       *uri;
+  guint64            n_items;
+  guint64            bytes;
+  guint              n_objects;
+  guint              n_thumbnails;
+  guint64            thumbnail_bytes;
+  guint              n_running;
+  guint              n_queued;
+  guint64            n_jobs = 0;
+  guint              n;
+
+  /* the files by their folder */
+  g_variant_builder_init (&folders, G_VARIANT_TYPE ("a{s(tttt)}"));
+  files = thunar_file_cache_get_census ();
+  g_hash_table_iter_init (&iter, files);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &uri, (gpointer *) &census))
+    {
+      g_variant_builder_add (&folders, "{s(tttt)}", uri,
+                             census->n_files, census->file_bytes,
+                             census->n_infos, census->info_bytes);
+      total.n_files += census->n_files;
+      total.file_bytes += census->file_bytes;
+      total.n_infos += census->n_infos;
+      total.info_bytes += census->info_bytes;
+    }
+  g_hash_table_destroy (files);
+
+  g_variant_builder_init (&totals, G_VARIANT_TYPE ("a{s(tt)}"));
+  g_variant_builder_add (&totals, "{s(tt)}", "file", total.n_files, total.file_bytes);
+  g_variant_builder_add (&totals, "{s(tt)}", "file-info", total.n_infos, total.info_bytes);
+
+  thunar_folder_get_census (&n_objects, &n_items, &bytes);
+  g_variant_builder_add (&totals, "{s(tt)}", "folder", (guint64) n_objects, bytes);
+
+  icon_factory = thunar_icon_factory_get_default ();
+  thunar_icon_factory_get_census (icon_factory, &n_objects, &bytes, &n_thumbnails, &thumbnail_bytes);
+  g_object_unref (icon_factory);
+  g_variant_builder_add (&totals, "{s(tt)}", "icon", (guint64) n_objects, bytes);
+  g_variant_builder_add (&totals, "{s(tt)}", "thumbnail", (guint64) n_thumbnails, thumbnail_bytes);
+
+  thunar_list_model_get_census (&n_objects, &n_items, &bytes);
+  g_variant_builder_add (&totals, "{s(tt)}", "list-model", (guint64) n_objects, (guint64) 0);
+  g_variant_builder_add (&totals, "{s(tt)}", "list-model-row", n_items, bytes);
+
+  for (n = 0; n < THUNAR_JOB_N_POOLS; ++n)
+    {
+      thunar_job_executor_get_pool_state (n, &n_running, &n_queued);
+      n_jobs += n_queued;
+    }
+  g_variant_builder_add (&totals, "{s(tt)}", "job-queued", n_jobs, (guint64) 0);
+
+  thunar_dbus_debug_complete_get_memory_census (object, invocation,
+                                                g_variant_builder_end (&totals),
+                                                g_variant_builder_end (&folders));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_set_slow_callback_threshold (ThunarDBusDebug       *object,
+                                                 GDBusMethodInvocation *invocation,
+                                                 guint                  threshold,
+                                                 ThunarDBusService     *dbus_service)
+{
+  /* only for this instance, the preference is left alone */
+  thunar_stats_set_slow_threshold (threshold);
+
+  thunar_dbus_debug_complete_set_slow_callback_threshold (object, invocation);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_dbus_service_get_slow_callbacks (ThunarDBusDebug       *object,
+                                        GDBusMethodInvocation *invocation,
+                                        ThunarDBusService     *dbus_service)
+{
+  ThunarStatsSlowCallback callbacks[THUNAR_STATS_N_SLOW_CALLBACKS];
+  GVariantBuilder         builder;
+  guint                   n_callbacks;
+  guint                   n;
+
+  n_callbacks = thunar_stats_get_slow_callbacks (callbacks);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sxtu)"));
+  for (n = 0; n < n_callbacks; ++n)
+    g_variant_builder_add (&builder, "(sxtu)", callbacks[n].name, callbacks[n].start_time,
+                           callbacks[n].duration, callbacks[n].workload);
+
+  thunar_dbus_debug_complete_get_slow_callbacks (object, invocation,
+                                                 thunar_stats_get_slow_threshold (),
+                                                 g_variant_builder_end (&builder));
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_dbus_freedesktop_show_folders (ThunarOrgFreedesktopFileManager1 *object,
                                       GDBusMethodInvocation            *invocation,
@@ -1718,6 +2404,12 @@ gboolean thunar_dbus_service_export_on_connection (ThunarDBusService *service,
                                          error))
     goto fail;
 
+  if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (service->debug),
+                                         connection,
+                                         "/org/xfce/FileManager",
+                                         error))
+    goto fail;
+
   if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (service->file_manager_fdo),
                                          connection,
                                          "/org/freedesktop/FileManager1",
@@ -1731,6 +2423,7 @@ fail:
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->file_manager), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->trash), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->thunar), connection);
+  g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->debug), connection);
   g_dbus_interface_skeleton_unexport_from_connection (G_DBUS_INTERFACE_SKELETON (service->file_manager_fdo), connection);
   return FALSE;
 }
@@ -23,11 +23,28 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <glib.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 
+#include <thunar/thunar-application.h>
 #include <thunar/thunar-deep-count-job.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-scan-directory.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-size-cache.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-util.h>
@@ -48,9 +65,27 @@ enum
   G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
   G_FILE_ATTRIBUTE_ID_FILESYSTEM
 
+/* number of threads counting the folders below a job file on local
+ * devices, on spinning disks and on remote locations, and the number
+ * of folders which may wait for a thread before the threads descend
+ * into new subfolders themselves */
+#define THUNAR_DEEP_COUNT_JOB_THREADS_MAX        8
+#define THUNAR_DEEP_COUNT_JOB_THREADS_ROTATIONAL 2
+#define THUNAR_DEEP_COUNT_JOB_THREADS_REMOTE     4
+#define THUNAR_DEEP_COUNT_JOB_QUEUE_MAX          4096
+
+/* number of seconds the result of a shared job is reused */
+#define THUNAR_DEEP_COUNT_JOB_SHARED_TTL         5
+
+typedef struct _ThunarDeepCountWalk      ThunarDeepCountWalk;
+typedef struct _ThunarDeepCountDirectory ThunarDeepCountDirectory;
+
 static void     thunar_deep_count_job_finalize   (GObject                 *object);
 static gboolean thunar_deep_count_job_execute    (ExoJob                  *job,
                                                   GError                 **error);
+static gboolean thunar_deep_count_job_count_directory (ThunarDeepCountWalk     *walk,
+                                                       GFile                   *directory,
+                                                       GError                 **error);
 
 
 
@@ -76,16 +111,60 @@ struct _ThunarDeepCountJob
   /* the time of the last "status-update" emission */
   gint64              last_time;
 
-  /* status information */
+  /* status information, updated by several threads under the mutex */
+  GMutex              mutex;
   guint64             total_size;
   guint               file_count;
   guint               directory_count;
   guint               unreadable_directory_count;
+  gboolean            reported;   /* sizes taken from filesystem accounting */
+
+  /* the key of a shared job, while it can be acquired, the number of
+   * users and whether it has counted everything */
+  gchar              *shared_key;
+  guint               n_shared_users;
+  guint               shared_expire_id;
+  gboolean            shared_failed;
+  gboolean            done;
 };
 
+/* the folders below a job file, counted by several threads */
+struct _ThunarDeepCountWalk
+{
+  ThunarDeepCountJob *job;
+  const gchar        *toplevel_fs_id;
+  GThread            *job_thread;
 
+  /* local folders are read without GIO, the device of the
+   * toplevel file replaces the fs id then */
+  gboolean            local;
+  guint64             toplevel_device;
 
-static guint deep_count_signals[LAST_SIGNAL];
+  /* shares the devices with the other jobs */
+  ThunarIoScheduler  *io_scheduler;
+
+  GMutex              mutex;
+  GCond               cond;
+  GQueue              directories; /* the folders to count */
+  guint               n_busy;      /* number of threads counting a folder */
+};
+
+/* a local folder which is being counted */
+struct _ThunarDeepCountDirectory
+{
+  ThunarDeepCountWalk *walk;
+  GFile               *directory;
+  guint64              total_size;
+  guint                file_count;
+  GPtrArray           *subdirs;    /* names of the subfolders, for the size cache */
+};
+
+
+
+static guint       deep_count_signals[LAST_SIGNAL];
+
+/* the shared jobs, running or recently done, by their key */
+static GHashTable *deep_count_shared_jobs = NULL;
 
 
 
@@ -96,13 +175,13 @@ G_DEFINE_TYPE (ThunarDeepCountJob, thunar_deep_count_job, THUNAR_TYPE_JOB)
 static void
 thunar_deep_count_job_class_init (ThunarDeepCountJobClass *klass)
 {
-  ExoJobClass  *job_class;
-  GObjectClass *gobject_class;
+  ThunarJobClass *job_class;
+  GObjectClass   *gobject_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_deep_count_job_finalize;
 
-  job_class = EXO_JOB_CLASS (klass);
+  job_class = THUNAR_JOB_CLASS (klass);
   job_class->execute = thunar_deep_count_job_execute;
 
   /**
@@ -136,6 +215,7 @@ static void
 thunar_deep_count_job_init (ThunarDeepCountJob *job)
 {
   job->query_flags = G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS;
+  g_mutex_init (&job->mutex);
 }
 
 
@@ -145,7 +225,10 @@ thunar_deep_count_job_finalize (GObject *object)
 {
   ThunarDeepCountJob *job = THUNAR_DEEP_COUNT_JOB (object);
 
+  _thunar_assert (job->shared_key == NULL);
+
   g_list_free_full (job->files, g_object_unref);
+  g_mutex_clear (&job->mutex);
 
   (*G_OBJECT_CLASS (thunar_deep_count_job_parent_class)->finalize) (object);
 }
@@ -155,59 +238,466 @@ thunar_deep_count_job_finalize (GObject *object)
 static void
 thunar_deep_count_job_status_update (ThunarDeepCountJob *job)
 {
+  guint64 total_size;
+  guint   file_count;
+  guint   directory_count;
+  guint   unreadable_directory_count;
+
   _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
 
+  /* take a consistent snapshot of the counters */
+  g_mutex_lock (&job->mutex);
+  total_size = job->total_size;
+  file_count = job->file_count;
+  directory_count = job->directory_count;
+  unreadable_directory_count = job->unreadable_directory_count;
+  g_mutex_unlock (&job->mutex);
+
   exo_job_emit (EXO_JOB (job),
                 deep_count_signals[STATUS_UPDATE],
                 0,
-                job->total_size,
-                job->file_count,
-                job->directory_count,
-                job->unreadable_directory_count);
+                total_size,
+                file_count,
+                directory_count,
+                unreadable_directory_count);
+}
+
+
+
+static guint
+thunar_deep_count_job_get_n_threads (GFile *file)
+{
+  switch (thunar_io_scheduler_get_device_class (file))
+    {
+    case THUNAR_IO_DEVICE_REMOTE:
+      /* every request to a remote location has a latency, but servers
+       * do not like to be flooded with requests either */
+      return THUNAR_DEEP_COUNT_JOB_THREADS_REMOTE;
+
+    case THUNAR_IO_DEVICE_ROTATIONAL:
+      /* don't let the threads seek back and forth on spinning disks */
+      return THUNAR_DEEP_COUNT_JOB_THREADS_ROTATIONAL;
+
+    default:
+      break;
+    }
+
+  return CLAMP ((guint) g_get_num_processors (), 1, THUNAR_DEEP_COUNT_JOB_THREADS_MAX);
+}
+
+
+
+static void
+thunar_deep_count_job_status_update_maybe (ThunarDeepCountJob *job)
+{
+  gint64   real_time;
+  gboolean emit = FALSE;
+
+  /* emit status updates not more than four times per second */
+  g_mutex_lock (&job->mutex);
+  real_time = g_get_real_time ();
+  if (real_time >= job->last_time)
+    {
+      emit = (job->last_time != 0);
+      job->last_time = real_time + (G_USEC_PER_SEC / 4);
+    }
+  g_mutex_unlock (&job->mutex);
+
+  if (emit)
+    thunar_deep_count_job_status_update (job);
+}
+
+
+
+static void
+thunar_deep_count_job_add (ThunarDeepCountJob *job,
+                           guint64             total_size,
+                           guint               file_count,
+                           guint               directory_count,
+                           guint               unreadable_directory_count)
+{
+  g_mutex_lock (&job->mutex);
+  job->total_size += total_size;
+  job->file_count += file_count;
+  job->directory_count += directory_count;
+  job->unreadable_directory_count += unreadable_directory_count;
+  g_mutex_unlock (&job->mutex);
 }
 
 
 
 static gboolean
-thunar_deep_count_job_process (ExoJob       *job,
-                               GFile        *file,
-                               GFileInfo    *file_info,
-                               const gchar  *toplevel_fs_id,
-                               GError      **error)
+thunar_deep_count_job_walk_push (ThunarDeepCountWalk *walk,
+                                 GFile               *directory)
 {
-  ThunarDeepCountJob *count_job = THUNAR_DEEP_COUNT_JOB (job);
+  gboolean pushed = FALSE;
+
+  g_mutex_lock (&walk->mutex);
+
+  /* bound the number of waiting folders, the caller counts
+   * the folder itself if the queue is full */
+  if (walk->directories.length < THUNAR_DEEP_COUNT_JOB_QUEUE_MAX)
+    {
+      g_queue_push_tail (&walk->directories, g_object_ref (directory));
+      g_cond_signal (&walk->cond);
+      pushed = TRUE;
+    }
+
+  g_mutex_unlock (&walk->mutex);
+
+  return pushed;
+}
+
+
+
+static void
+thunar_deep_count_job_count_local_subdir (ThunarDeepCountWalk *walk,
+                                          GFile               *directory,
+                                          const gchar         *name)
+{
+  GFile *child;
+
+  child = g_file_get_child (directory, name);
+
+  /* leave the folder to the other threads, unless they are busy enough */
+  if (!thunar_deep_count_job_walk_push (walk, child)
+      && !thunar_deep_count_job_count_directory (walk, child, NULL))
+    thunar_deep_count_job_add (walk->job, 0, 0, 0, 1);
+
+  g_object_unref (child);
+}
+
+
+
+static gboolean
+thunar_deep_count_job_count_local_entry (const ThunarIoScanLocalEntry *entry,
+                                         gpointer                      user_data)
+{
+  ThunarDeepCountDirectory *dir = user_data;
+  ThunarDeepCountWalk      *walk = dir->walk;
+
+  /* only count files on the same device as the toplevel file */
+  if (entry->device != walk->toplevel_device)
+    return TRUE;
+
+  if (entry->type == G_FILE_TYPE_DIRECTORY)
+    {
+      g_ptr_array_add (dir->subdirs, g_strdup (entry->name));
+      thunar_deep_count_job_count_local_subdir (walk, dir->directory, entry->name);
+    }
+  else
+    {
+      /* we have a regular file or at least not a directory */
+      dir->file_count++;
+      dir->total_size += entry->size;
+    }
+
+  return !exo_job_is_cancelled (EXO_JOB (walk->job));
+}
+
+
+
+/* whether the subfolders still have the modification times in mtimes, if
+ * mtimes_return is given, their times are stored there instead. Returns
+ * FALSE if one of them can't be stat'ed */
+static gboolean
+thunar_deep_count_job_check_subdirs (GFile   *directory,
+                                     gchar  **subdirs,
+                                     gint64  *mtimes,
+                                     gint64  *mtimes_return)
+{
+  GStatBuf statb;
+  gchar   *path;
+  gboolean unchanged = TRUE;
+  guint    n;
+
+  for (n = 0; unchanged && subdirs[n] != NULL; ++n)
+    {
+      path = g_build_filename (g_file_peek_path (directory), subdirs[n], NULL);
+      unchanged = (g_stat (path, &statb) == 0);
+      g_free (path);
+
+      if (unchanged && mtimes_return != NULL)
+        mtimes_return[n] = statb.st_mtime;
+      else if (unchanged)
+        unchanged = (mtimes[n] == (gint64) statb.st_mtime);
+    }
+
+  return unchanged;
+}
+
+
+
+static gboolean
+thunar_deep_count_job_count_local_directory (ThunarDeepCountWalk *walk,
+                                             GFile               *directory,
+                                             GError             **error)
+{
+  ThunarDeepCountDirectory dir = { walk, directory, 0, 0, NULL };
+  ThunarIoScanLocalFlags   flags = THUNAR_IO_SCAN_LOCAL_NEED_SIZE | THUNAR_IO_SCAN_LOCAL_NEED_DEVICE;
+  GStatBuf                 statb;
+  gboolean                 cached;
+  gchar                  **subdirs;
+  gint64                  *subdir_mtimes;
+  guint                    n;
+
+  /* folders which can't be stat'ed are read without the cache */
+  cached = (g_stat (g_file_peek_path (directory), &statb) == 0);
+  if (cached)
+    {
+      /* subfolders may have become mount points meanwhile */
+      if ((guint64) statb.st_dev != walk->toplevel_device)
+        return TRUE;
+
+      /* reuse the contents of unchanged folders, whose subfolders did not change either */
+      if (thunar_size_cache_lookup (statb.st_dev, statb.st_ino, statb.st_mtime,
+                                    &dir.total_size, &dir.file_count, &subdirs, &subdir_mtimes))
+        {
+          if (thunar_deep_count_job_check_subdirs (directory, subdirs, subdir_mtimes, NULL))
+            {
+              for (n = 0; subdirs[n] != NULL && !exo_job_is_cancelled (EXO_JOB (walk->job)); ++n)
+                thunar_deep_count_job_count_local_subdir (walk, directory, subdirs[n]);
+              g_strfreev (subdirs);
+              g_free (subdir_mtimes);
+
+              thunar_deep_count_job_add (walk->job, dir.total_size, dir.file_count, 1, 0);
+              return TRUE;
+            }
+
+          /* read the folder again */
+          dir.total_size = 0;
+          dir.file_count = 0;
+          g_strfreev (subdirs);
+          g_free (subdir_mtimes);
+        }
+    }
+
+  if ((walk->job->query_flags & G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS) == 0)
+    flags |= THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS;
+
+  dir.subdirs = g_ptr_array_new_with_free_func (g_free);
+  if (!thunar_io_scan_local_directory (directory, flags, exo_job_get_cancellable (EXO_JOB (walk->job)),
+                                       thunar_deep_count_job_count_local_entry, &dir, error))
+    {
+      g_ptr_array_unref (dir.subdirs);
+      return FALSE;
+    }
+
+  /* remember complete folders, which don't follow symlinks out of them */
+  if (cached
+      && (flags & THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS) == 0
+      && !exo_job_is_cancelled (EXO_JOB (walk->job)))
+    {
+      g_ptr_array_add (dir.subdirs, NULL);
+      subdir_mtimes = g_new (gint64, dir.subdirs->len);
+      if (thunar_deep_count_job_check_subdirs (directory, (gchar **) dir.subdirs->pdata, NULL, subdir_mtimes))
+        thunar_size_cache_store (statb.st_dev, statb.st_ino, statb.st_mtime, dir.total_size, dir.file_count,
+                                 (const gchar *const *) dir.subdirs->pdata, subdir_mtimes);
+      g_free (subdir_mtimes);
+    }
+  g_ptr_array_unref (dir.subdirs);
+
+  /* directory was readable */
+  thunar_deep_count_job_add (walk->job, dir.total_size, dir.file_count, 1, 0);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_deep_count_job_read_directory (ThunarDeepCountWalk *walk,
+                                      GFile               *directory,
+                                      GError             **error)
+{
+  ThunarDeepCountJob *count_job = walk->job;
+  ExoJob             *job = EXO_JOB (walk->job);
   GFileEnumerator    *enumerator;
   GFileInfo          *child_info;
-  GFileInfo          *info;
-  gboolean            success = TRUE;
   GFile              *child;
-  gint64              real_time;
   const gchar        *fs_id;
-  gboolean            toplevel_file = (toplevel_fs_id == NULL);
+  guint64             total_size = 0;
+  guint               file_count = 0;
+
+  if (walk->local)
+    return thunar_deep_count_job_count_local_directory (walk, directory, error);
+
+  /* try to read from the directory */
+  enumerator = g_file_enumerate_children (directory,
+                                          DEEP_COUNT_FILE_INFO_NAMESPACE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                          count_job->query_flags,
+                                          exo_job_get_cancellable (job),
+                                          error);
+  if (enumerator == NULL)
+    return FALSE;
+
+  while (!exo_job_is_cancelled (job))
+    {
+      /* query next child info, errors are ignored */
+      child_info = g_file_enumerator_next_file (enumerator, exo_job_get_cancellable (job), NULL);
+
+      /* abort on invalid child info (iteration ends) */
+      if (child_info == NULL)
+        break;
+
+      /* only check files on the same filesystem so no remote mounts or
+       * dummy filesystems are counted */
+      fs_id = g_file_info_get_attribute_string (child_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+      if (g_strcmp0 (fs_id != NULL ? fs_id : "", walk->toplevel_fs_id) != 0)
+        {
+          g_object_unref (child_info);
+          continue;
+        }
+
+      if (g_file_info_get_file_type (child_info) == G_FILE_TYPE_DIRECTORY)
+        {
+          child = g_file_resolve_relative_path (directory, g_file_info_get_name (child_info));
+
+          /* leave the folder to the other threads, unless they are busy enough */
+          if (!thunar_deep_count_job_walk_push (walk, child)
+              && !thunar_deep_count_job_count_directory (walk, child, NULL))
+            thunar_deep_count_job_add (count_job, 0, 0, 0, 1);
+
+          g_object_unref (child);
+        }
+      else
+        {
+          /* we have a regular file or at least not a directory */
+          file_count++;
+          total_size += g_file_info_get_size (child_info);
+        }
+
+      g_object_unref (child_info);
+    }
+
+  g_object_unref (enumerator);
+
+  /* directory was readable */
+  thunar_deep_count_job_add (count_job, total_size, file_count, 1, 0);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_deep_count_job_count_directory (ThunarDeepCountWalk *walk,
+                                       GFile               *directory,
+                                       GError             **error)
+{
+  ThunarIoTicket *ticket;
+  gboolean        success;
+
+  /* share the device with the other jobs, the subfolders read
+   * by this thread within the folder don't wait again */
+  ticket = thunar_io_scheduler_acquire (walk->io_scheduler, directory, NULL, TRUE,
+                                        exo_job_get_cancellable (EXO_JOB (walk->job)));
+
+  /* counting can wait while the user navigates on the same disk */
+  thunar_io_ticket_yield (ticket, exo_job_get_cancellable (EXO_JOB (walk->job)));
+  success = thunar_deep_count_job_read_directory (walk, directory, error);
+  thunar_io_ticket_release (ticket);
+
+  return success;
+}
+
+
+
+static gpointer
+thunar_deep_count_job_walk_thread (gpointer data)
+{
+  ThunarDeepCountWalk *walk = data;
+  gboolean             is_job_thread = (g_thread_self () == walk->job_thread);
+  GFile               *directory;
+
+  g_mutex_lock (&walk->mutex);
+
+  for (;;)
+    {
+      /* wait for more folders, as long as another thread may still find some */
+      while (g_queue_is_empty (&walk->directories)
+             && walk->n_busy > 0
+             && !exo_job_is_cancelled (EXO_JOB (walk->job)))
+        {
+          if (!is_job_thread)
+            {
+              g_cond_wait (&walk->cond, &walk->mutex);
+              continue;
+            }
+
+          /* the job thread keeps the status up to date while it waits */
+          g_cond_wait_until (&walk->cond, &walk->mutex, g_get_monotonic_time () + G_USEC_PER_SEC / 4);
+          g_mutex_unlock (&walk->mutex);
+          thunar_deep_count_job_status_update_maybe (walk->job);
+          g_mutex_lock (&walk->mutex);
+        }
+
+      if (exo_job_is_cancelled (EXO_JOB (walk->job)))
+        break;
+
+      /* all threads are idle and there is nothing left to count */
+      directory = g_queue_pop_head (&walk->directories);
+      if (directory == NULL)
+        break;
+
+      walk->n_busy++;
+      g_mutex_unlock (&walk->mutex);
+
+      if (!thunar_deep_count_job_count_directory (walk, directory, NULL))
+        thunar_deep_count_job_add (walk->job, 0, 0, 0, 1);
+      g_object_unref (directory);
+
+      /* only the job thread emits signals */
+      if (is_job_thread)
+        thunar_deep_count_job_status_update_maybe (walk->job);
+
+      g_mutex_lock (&walk->mutex);
+      walk->n_busy--;
+      g_cond_broadcast (&walk->cond);
+    }
+
+  /* wake up the waiting threads, so they can quit too */
+  g_cond_broadcast (&walk->cond);
+  g_mutex_unlock (&walk->mutex);
+
+  return NULL;
+}
+
+
+
+static gboolean
+thunar_deep_count_job_process (ExoJob       *job,
+                               GFile        *file,
+                               GError      **error)
+{
+  ThunarDeepCountJob  *count_job = THUNAR_DEEP_COUNT_JOB (job);
+  ThunarDeepCountWalk  walk;
+  ThunarApplication   *application;
+  GFileInfo           *info;
+  gboolean             success = TRUE;
+  const gchar         *fs_id;
+  GThread            **threads;
+  guint                n_threads;
+  guint                n;
+  GStatBuf             statb;
+  guint64              reported_size;
+  guint64              n_inodes;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
-  _thunar_return_val_if_fail (file_info == NULL || G_IS_FILE_INFO (file_info), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   /* abort if job was already cancelled */
   if (exo_job_is_cancelled (job))
     return FALSE;
 
-  if (file_info != NULL)
-    {
-      /* use the enumerator info */
-      info = g_object_ref (file_info);
-    }
-  else
-    {
-      /* query size and type of the current file */
-      info = g_file_query_info (file,
-                                DEEP_COUNT_FILE_INFO_NAMESPACE,
-                                count_job->query_flags,
-                                exo_job_get_cancellable (job),
-                                error);
-    }
+  /* query size and type of the current file */
+  info = g_file_query_info (file,
+                            DEEP_COUNT_FILE_INFO_NAMESPACE,
+                            count_job->query_flags,
+                            exo_job_get_cancellable (job),
+                            error);
 
   /* abort on invalid info or cancellation */
   if (info == NULL)
@@ -220,113 +710,98 @@ thunar_deep_count_job_process (ExoJob       *job,
       return FALSE;
     }
 
-  /* only check files on the same filesystem so no remote mounts or
-   * dummy filesystems are counted */
-  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
-  if (fs_id == NULL)
-    fs_id = "";
-
-  if (toplevel_fs_id == NULL)
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
     {
-      /* first toplevel, so use this id */
-      toplevel_fs_id = fs_id;
+      /* we have a regular file or at least not a directory */
+      thunar_deep_count_job_add (count_job, g_file_info_get_size (info), 1, 0, 0);
+      g_object_unref (info);
+      return TRUE;
     }
-  else if (strcmp (fs_id, toplevel_fs_id) != 0)
+
+  /* the roots of filesystems and project quotas are accounted for by
+   * the filesystem, the walk only counts the other folders */
+  if ((count_job->query_flags & G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS) != 0
+      && thunar_g_file_get_reported_usage (file, &reported_size, &n_inodes))
     {
-      /* release the file info */
-      g_object_unref (info);
+      /* the inodes include the folder itself */
+      n_inodes = (n_inodes > 0) ? n_inodes - 1 : 0;
+      thunar_deep_count_job_add (count_job, reported_size, (guint) MIN (n_inodes, G_MAXUINT), 1, 0);
+
+      g_mutex_lock (&count_job->mutex);
+      count_job->reported = TRUE;
+      g_mutex_unlock (&count_job->mutex);
 
-      /* other filesystem, continue */
+      g_object_unref (info);
       return TRUE;
     }
 
-  /* recurse if we have a directory */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+  /* the fs id of the toplevel file, to only count files on the same filesystem */
+  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+
+  walk.job = count_job;
+  walk.toplevel_fs_id = (fs_id != NULL) ? fs_id : "";
+  walk.job_thread = g_thread_self ();
+  walk.local = FALSE;
+  walk.toplevel_device = 0;
+  walk.n_busy = 0;
+  g_mutex_init (&walk.mutex);
+
+  application = thunar_application_get ();
+  walk.io_scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+
+  g_cond_init (&walk.cond);
+  g_queue_init (&walk.directories);
+
+  /* read local folders directly, if the system allows it */
+  if (thunar_io_scan_local_supported (file)
+      && g_stat (g_file_peek_path (file), &statb) == 0)
+    {
+      walk.local = TRUE;
+      walk.toplevel_device = statb.st_dev;
+    }
+
+  /* read the toplevel directory first, the subfolders are queued for the threads */
+  if (!thunar_deep_count_job_count_directory (&walk, file, error))
     {
-      /* try to read from the directory */
-      enumerator = g_file_enumerate_children (file,
-                                              DEEP_COUNT_FILE_INFO_NAMESPACE ","
-                                              G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                              count_job->query_flags,
-                                              exo_job_get_cancellable (job),
-                                              error);
-
-      if (!exo_job_is_cancelled (job))
+      /* directory was unreadable */
+      thunar_deep_count_job_add (count_job, 0, 0, 0, 1);
+
+      if (g_list_length (count_job->files) < 2)
         {
-          if (enumerator == NULL)
-            {
-              /* directory was unreadable */
-              count_job->unreadable_directory_count++;
-
-              if (toplevel_file
-                  && g_list_length (count_job->files) < 2)
-                {
-                  /* we only bail out if the job file is unreadable */
-                  success = FALSE;
-                }
-              else
-                {
-                  /* ignore errors from files other than the job file */
-                  g_clear_error (error);
-                }
-            }
-          else
-            {
-              /* directory was readable */
-              count_job->directory_count++;
-
-              while (!exo_job_is_cancelled (job))
-                {
-                  /* query next child info */
-                  child_info = g_file_enumerator_next_file (enumerator,
-                                                            exo_job_get_cancellable (job),
-                                                            error);
-
-                  /* abort on invalid child info (iteration ends) or cancellation */
-                  if (child_info == NULL)
-                    break;
-
-                  if (!exo_job_is_cancelled (job))
-                    {
-                      /* generate a GFile for the child */
-                      child = g_file_resolve_relative_path (file, g_file_info_get_name (child_info));
-
-                      /* recurse unless the job was cancelled before */
-                      thunar_deep_count_job_process (job, child, child_info, toplevel_fs_id, error);
-
-                      /* free resources */
-                      g_object_unref (child);
-                    }
-
-                  g_object_unref (child_info);
-                }
-            }
+          /* we only bail out if the job file is unreadable */
+          success = FALSE;
         }
-
-      /* destroy the enumerator */
-      if (enumerator != NULL)
-        g_object_unref (enumerator);
-
-      /* emit status update whenever we've finished a directory,
-       * but not more than four times per second */
-      real_time = g_get_real_time ();
-      if (real_time >= count_job->last_time)
+      else
         {
-          if (count_job->last_time != 0)
-            thunar_deep_count_job_status_update (count_job);
-          count_job->last_time = real_time + (G_USEC_PER_SEC / 4);
+          /* ignore errors from files other than the job file */
+          g_clear_error (error);
         }
     }
-  else
+  else if (!g_queue_is_empty (&walk.directories))
     {
-      /* we have a regular file or at least not a directory */
-      count_job->file_count++;
+      /* the job thread takes part in the counting */
+      n_threads = thunar_deep_count_job_get_n_threads (file);
+      threads = g_new0 (GThread *, n_threads);
+      for (n = 1; n < n_threads; ++n)
+        threads[n] = g_thread_new ("ThunarDeepCountJob", thunar_deep_count_job_walk_thread, &walk);
 
-      /* add size of the file to the total size */
-      count_job->total_size += g_file_info_get_size (info);
+      thunar_deep_count_job_walk_thread (&walk);
+
+      for (n = 1; n < n_threads; ++n)
+        g_thread_join (threads[n]);
+      g_free (threads);
     }
 
-  /* destroy the file info */
+  thunar_deep_count_job_status_update_maybe (count_job);
+
+  /* drop the folders left over after a cancellation */
+  g_queue_clear_full (&walk.directories, g_object_unref);
+  g_cond_clear (&walk.cond);
+  g_mutex_clear (&walk.mutex);
+  g_object_unref (walk.io_scheduler);
+
+  /* destroy the file info, which owns the fs id */
   g_object_unref (info);
 
   /* we've succeeded if there was no error when loading information
@@ -358,13 +833,14 @@ thunar_deep_count_job_execute (ExoJob  *job,
   count_job->file_count = 0;
   count_job->directory_count = 0;
   count_job->unreadable_directory_count = 0;
+  count_job->reported = FALSE;
   count_job->last_time = 0;
 
   /* count files, directories and compute size of the job files */
   for (lp = count_job->files; lp != NULL; lp = lp->next)
     {
       gfile = thunar_file_get_file (THUNAR_FILE (lp->data));
-      success = thunar_deep_count_job_process (job, gfile, NULL, NULL, &err);
+      success = thunar_deep_count_job_process (job, gfile, &err);
       if (G_UNLIKELY (!success))
         break;
     }
@@ -388,10 +864,17 @@ thunar_deep_count_job_execute (ExoJob  *job,
     }
   else if (!exo_job_is_cancelled (job))
     {
+      g_mutex_lock (&count_job->mutex);
+      count_job->done = TRUE;
+      g_mutex_unlock (&count_job->mutex);
+
       /* emit final status update at the very end of the computation */
       thunar_deep_count_job_status_update (count_job);
     }
 
+  /* keep the folders counted this time for the next time */
+  thunar_size_cache_save ();
+
   return success;
 }
 
@@ -409,7 +892,258 @@ thunar_deep_count_job_new (GList               *files,
   job->files = g_list_copy (files);
   job->query_flags = flags;
 
+  /* walking a big tree should not hold back folder listings */
+  thunar_job_set_pool (THUNAR_JOB (job), THUNAR_JOB_POOL_BULK);
+
   g_list_foreach (job->files, (GFunc) (void (*)(void)) g_object_ref, NULL);
 
   return job;
 }
+
+
+
+static void
+thunar_deep_count_job_shared_remove (ThunarDeepCountJob *job)
+{
+  GList *lp;
+
+  /* already replaced by another job, or expired */
+  if (job->shared_key == NULL)
+    return;
+
+  for (lp = job->files; lp != NULL; lp = lp->next)
+    g_signal_handlers_disconnect_by_func (lp->data, thunar_deep_count_job_shared_remove, job);
+
+  if (job->shared_expire_id != 0)
+    {
+      g_source_remove (job->shared_expire_id);
+      job->shared_expire_id = 0;
+    }
+
+  g_hash_table_remove (deep_count_shared_jobs, job->shared_key);
+  g_free (job->shared_key);
+  job->shared_key = NULL;
+
+  g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, deep_count_shared_jobs);
+  g_object_unref (job);
+}
+
+
+
+static gboolean
+thunar_deep_count_job_shared_expire (gpointer data)
+{
+  ThunarDeepCountJob *job = THUNAR_DEEP_COUNT_JOB (data);
+
+  job->shared_expire_id = 0;
+  thunar_deep_count_job_shared_remove (job);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_deep_count_job_shared_error (ThunarDeepCountJob *job)
+{
+  job->shared_failed = TRUE;
+}
+
+
+
+static void
+thunar_deep_count_job_shared_finished (ThunarDeepCountJob *job)
+{
+  /* only complete results are worth reusing */
+  if (job->shared_failed || !job->done)
+    thunar_deep_count_job_shared_remove (job);
+  else if (job->shared_key != NULL)
+    job->shared_expire_id = g_timeout_add_seconds (THUNAR_DEEP_COUNT_JOB_SHARED_TTL, thunar_deep_count_job_shared_expire, job);
+}
+
+
+
+static gint
+thunar_deep_count_job_shared_compare (gconstpointer a,
+                                      gconstpointer b)
+{
+  return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+
+
+static gchar *
+thunar_deep_count_job_shared_key (GList               *files,
+                                  GFileQueryInfoFlags  flags)
+{
+  GPtrArray *uris;
+  GString   *key;
+  GList     *lp;
+  guint      n;
+
+  /* the same files count the same in any order */
+  uris = g_ptr_array_new_with_free_func (g_free);
+  for (lp = files; lp != NULL; lp = lp->next)
+    g_ptr_array_add (uris, thunar_file_dup_uri (THUNAR_FILE (lp->data)));
+  g_ptr_array_sort (uris, thunar_deep_count_job_shared_compare);
+
+  key = g_string_new (NULL);
+  g_string_append_printf (key, "%d", flags);
+  for (n = 0; n < uris->len; ++n)
+    {
+      g_string_append_c (key, '\n');
+      g_string_append (key, g_ptr_array_index (uris, n));
+    }
+  g_ptr_array_unref (uris);
+
+  return g_string_free (key, FALSE);
+}
+
+
+
+/**
+ * thunar_deep_count_job_acquire:
+ * @files : a #GList of #ThunarFile<!---->s.
+ * @flags : the #GFileQueryInfoFlags for the count.
+ *
+ * Returns a launched #ThunarDeepCountJob for the @files, which is
+ * shared with the other users counting the same files. A job which
+ * counted the @files a few seconds ago is returned as well, as long
+ * as none of the @files changed since; thunar_deep_count_job_get_status()
+ * tells whether the job is done already.
+ *
+ * The caller must give up the job using thunar_deep_count_job_release()
+ * and not cancel it.
+ *
+ * Return value: the #ThunarDeepCountJob for @files.
+ **/
+ThunarDeepCountJob *
+thunar_deep_count_job_acquire (GList               *files,
+                               GFileQueryInfoFlags  flags)
+{
+  ThunarDeepCountJob *job;
+  gchar              *key;
+  GList              *lp;
+
+  _thunar_return_val_if_fail (files != NULL, NULL);
+
+  if (G_UNLIKELY (deep_count_shared_jobs == NULL))
+    deep_count_shared_jobs = g_hash_table_new (g_str_hash, g_str_equal);
+
+  key = thunar_deep_count_job_shared_key (files, flags);
+  job = g_hash_table_lookup (deep_count_shared_jobs, key);
+  if (job != NULL)
+    {
+      g_free (key);
+
+      /* a done job stays around until it expires, not until it's released */
+      job->n_shared_users++;
+      return g_object_ref (job);
+    }
+
+  job = thunar_deep_count_job_new (files, flags);
+  job->shared_key = key;
+  job->n_shared_users = 1;
+  g_hash_table_insert (deep_count_shared_jobs, job->shared_key, job);
+
+  /* connected before any user, so the users see the final state */
+  g_signal_connect (job, "error", G_CALLBACK (thunar_deep_count_job_shared_error), deep_count_shared_jobs);
+  g_signal_connect (job, "finished", G_CALLBACK (thunar_deep_count_job_shared_finished), deep_count_shared_jobs);
+
+  /* a changed file needs a new count, the users of this job are
+   * told about the change by the file themselves */
+  for (lp = job->files; lp != NULL; lp = lp->next)
+    g_signal_connect_swapped (lp->data, "changed", G_CALLBACK (thunar_deep_count_job_shared_remove), job);
+
+  thunar_job_launch (THUNAR_JOB (job));
+
+  return g_object_ref (job);
+}
+
+
+
+/**
+ * thunar_deep_count_job_release:
+ * @job : a #ThunarDeepCountJob from thunar_deep_count_job_acquire().
+ *
+ * Gives up the @job, which is cancelled unless it is done or
+ * used elsewhere. The caller must have disconnected from the @job.
+ **/
+void
+thunar_deep_count_job_release (ThunarDeepCountJob *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
+  _thunar_return_if_fail (job->n_shared_users > 0);
+
+  if (--job->n_shared_users == 0 && !job->done)
+    {
+      exo_job_cancel (EXO_JOB (job));
+      thunar_deep_count_job_shared_remove (job);
+    }
+
+  g_object_unref (job);
+}
+
+
+
+/**
+ * thunar_deep_count_job_get_status:
+ * @job                        : a #ThunarDeepCountJob.
+ * @total_size                 : return location for the total size in bytes.
+ * @file_count                 : return location for the number of files.
+ * @directory_count            : return location for the number of directories.
+ * @unreadable_directory_count : return location for the number of unreadable directories.
+ *
+ * Looks up what the @job counted so far, for users which join
+ * a shared job after it emitted "status-update".
+ *
+ * Return value: %TRUE if the @job counted everything.
+ **/
+gboolean
+thunar_deep_count_job_get_status (ThunarDeepCountJob *job,
+                                  guint64            *total_size,
+                                  guint              *file_count,
+                                  guint              *directory_count,
+                                  guint              *unreadable_directory_count)
+{
+  gboolean done;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job), FALSE);
+
+  g_mutex_lock (&job->mutex);
+  *total_size = job->total_size;
+  *file_count = job->file_count;
+  *directory_count = job->directory_count;
+  *unreadable_directory_count = job->unreadable_directory_count;
+  done = job->done;
+  g_mutex_unlock (&job->mutex);
+
+  return done;
+}
+
+
+
+/**
+ * thunar_deep_count_job_is_reported:
+ * @job : a #ThunarDeepCountJob.
+ *
+ * Tells whether folders among the files of @job were not counted,
+ * but looked up in the accounting of their filesystem, see
+ * thunar_g_file_get_reported_usage(). Their size is the space used
+ * on the disk then, and their contents are all counted as files.
+ *
+ * Return value: %TRUE if the filesystem reported some of the sizes.
+ **/
+gboolean
+thunar_deep_count_job_is_reported (ThunarDeepCountJob *job)
+{
+  gboolean reported;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job), FALSE);
+
+  g_mutex_lock (&job->mutex);
+  reported = job->reported;
+  g_mutex_unlock (&job->mutex);
+
+  return reported;
+}
@@ -42,6 +42,13 @@ enum
 
 
 
+/* number of rows from which the details view switches to the fast
+ * layout, and the number of rows sampled to size its columns */
+#define THUNAR_DETAILS_VIEW_FAST_LAYOUT_MIN_ROWS 5000
+#define THUNAR_DETAILS_VIEW_FAST_LAYOUT_SAMPLE   256
+
+
+
 static void         thunar_details_view_finalize                (GObject                *object);
 static void         thunar_details_view_get_property            (GObject                *object,
                                                                  guint                   prop_id,
@@ -114,6 +121,17 @@ static void         thunar_details_view_append_menu_items       (ThunarStandardV
                                                                  GtkAccelGroup          *accel_group);
 static void         thunar_details_view_highlight_option_changed(ThunarDetailsView      *details_view);
 static void         thunar_details_view_queue_redraw            (ThunarStandardView     *standard_view);
+static void         thunar_details_view_fast_layout_changed     (ThunarDetailsView      *details_view);
+static void         thunar_details_view_queue_fast_layout       (ThunarDetailsView      *details_view);
+static void         thunar_details_view_queue_fast_layout_reset (ThunarDetailsView      *details_view);
+static void         thunar_details_view_queue_fast_layout_sample(ThunarDetailsView      *details_view);
+static void         thunar_details_view_fast_layout_measure     (ThunarDetailsView      *details_view,
+                                                                 GtkTreeModel           *model,
+                                                                 GtkTreeIter            *iter,
+                                                                 gint                   *widths);
+static gboolean     thunar_details_view_fast_layout_idle        (gpointer                data);
+static void         thunar_details_view_set_fast_layout         (ThunarDetailsView      *details_view,
+                                                                 gboolean                fast_layout);
 
 
 
@@ -143,6 +161,17 @@ struct _ThunarDetailsView
   /* event source id for thunar_details_view_zoom_level_changed_reload_fixed_height */
   guint idle_id;
 
+  /* for very large folders the rows get a fixed height and the columns
+   * are sized from the visible rows and a sample of the other rows, see
+   * thunar_details_view_fast_layout_idle(), instead of GtkTreeView
+   * measuring every single row.
+   */
+  gboolean           fast_layout_enabled;
+  gboolean           fast_layout;
+  gboolean           fast_layout_reset;
+  gboolean           fast_layout_sample;
+  guint              fast_layout_idle_id;
+
   GtkCellRenderer   *renderers[THUNAR_N_VISIBLE_COLUMNS];
 
   ExoTreeView       *tree_view;
@@ -244,6 +273,7 @@ thunar_details_view_init (ThunarDetailsView *details_view)
 
   /* configure general aspects of the details view */
   gtk_tree_view_set_enable_search (GTK_TREE_VIEW (details_view->tree_view), TRUE);
+  gtk_tree_view_set_search_equal_func (GTK_TREE_VIEW (details_view->tree_view), thunar_standard_view_search_equal, NULL, NULL);
 
   /* enable rubberbanding (if supported) */
   gtk_tree_view_set_rubber_banding (GTK_TREE_VIEW (details_view->tree_view), TRUE);
@@ -358,6 +388,19 @@ thunar_details_view_init (ThunarDetailsView *details_view)
                             G_CALLBACK (thunar_details_view_highlight_option_changed), details_view);
   thunar_details_view_highlight_option_changed (details_view);
 
+  /* switch to the fast layout whenever the folder gets large enough */
+  g_signal_connect_swapped (THUNAR_STANDARD_VIEW (details_view)->preferences, "notify::misc-details-view-fast-layout",
+                            G_CALLBACK (thunar_details_view_fast_layout_changed), details_view);
+  g_signal_connect_swapped (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "row-inserted",
+                            G_CALLBACK (thunar_details_view_queue_fast_layout_sample), details_view);
+  g_signal_connect_swapped (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "row-deleted",
+                            G_CALLBACK (thunar_details_view_queue_fast_layout), details_view);
+  g_signal_connect_swapped (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model), "notify::folder",
+                            G_CALLBACK (thunar_details_view_queue_fast_layout_reset), details_view);
+  g_signal_connect_object (G_OBJECT (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (details_view->tree_view))), "value-changed",
+                           G_CALLBACK (thunar_details_view_queue_fast_layout), details_view, G_CONNECT_SWAPPED);
+  thunar_details_view_fast_layout_changed (details_view);
+
   /* release the shared text renderers */
   g_object_unref (G_OBJECT (right_aligned_renderer));
   g_object_unref (G_OBJECT (left_aligned_renderer));
@@ -426,8 +469,15 @@ thunar_details_view_finalize (GObject *object)
   if (details_view->idle_id)
     g_source_remove (details_view->idle_id);
 
+  if (details_view->fast_layout_idle_id != 0)
+    g_source_remove (details_view->fast_layout_idle_id);
+
   g_signal_handlers_disconnect_by_func (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->preferences),
                                         thunar_details_view_highlight_option_changed, details_view);
+  g_signal_handlers_disconnect_by_func (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->preferences),
+                                        thunar_details_view_fast_layout_changed, details_view);
+  g_signal_handlers_disconnect_matched (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->model),
+                                        G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, details_view);
 
   (*G_OBJECT_CLASS (thunar_details_view_parent_class)->finalize) (object);
 }
@@ -667,6 +717,10 @@ thunar_details_view_notify_width (GtkTreeViewColumn *tree_view_column,
   /* for some reason gtk forgets the auto-expand state of the name column */
   gtk_tree_view_column_set_expand (details_view->columns[THUNAR_COLUMN_NAME], !details_view->fixed_columns);
 
+  /* the widths of the fast layout are sampled, not chosen by the user */
+  if (details_view->fast_layout)
+    return;
+
   /* lookup the column no for the given tree view column */
   for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
     if (details_view->columns[column] == tree_view_column)
@@ -972,7 +1026,7 @@ thunar_details_view_zoom_level_changed (ThunarDetailsView *details_view)
 
   _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
 
-  if (details_view->fixed_columns == TRUE)
+  if (details_view->fixed_columns == TRUE || details_view->fast_layout)
     {
       /* disable fixed_height_mode during resize, otherwise graphical glitches can appear*/
       gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (details_view))), FALSE);
@@ -985,7 +1039,11 @@ thunar_details_view_zoom_level_changed (ThunarDetailsView *details_view)
       gtk_tree_view_column_queue_resize (details_view->columns[column]);
     }
 
-  if (details_view->fixed_columns == TRUE)
+  /* the sampled widths of the fast layout depend on the icon size */
+  if (details_view->fast_layout)
+    thunar_details_view_queue_fast_layout_reset (details_view);
+
+  if (details_view->fixed_columns == TRUE || details_view->fast_layout)
     {
       /* Call when idle to ensure that gtk_tree_view_column_queue_resize got finished */
       details_view->idle_id = gdk_threads_add_idle (thunar_details_view_zoom_level_changed_reload_fixed_height, details_view);
@@ -1101,6 +1159,11 @@ thunar_details_view_set_fixed_columns (ThunarDetailsView *details_view,
       /* apply the new value */
       details_view->fixed_columns = fixed_columns;
 
+      /* the fixed columns replace the fast layout, which may
+       * be needed again once the fixed columns are disabled */
+      details_view->fast_layout = FALSE;
+      thunar_details_view_queue_fast_layout_reset (details_view);
+
       /* disable in reverse order, otherwise graphical glitches can appear*/
       if (!fixed_columns)
         gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (details_view))), FALSE);
@@ -1216,3 +1279,193 @@ thunar_details_view_queue_redraw (ThunarStandardView *standard_view)
 
   gtk_widget_queue_draw (GTK_WIDGET (details_view->tree_view));
 }
+
+
+
+static void
+thunar_details_view_fast_layout_changed (ThunarDetailsView *details_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
+
+  g_object_get (G_OBJECT (THUNAR_STANDARD_VIEW (details_view)->preferences),
+                "misc-details-view-fast-layout", &details_view->fast_layout_enabled, NULL);
+  thunar_details_view_queue_fast_layout_reset (details_view);
+}
+
+
+
+static void
+thunar_details_view_queue_fast_layout (ThunarDetailsView *details_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
+
+  /* run before GtkTreeView validates and redraws the rows */
+  if (details_view->fast_layout_idle_id == 0)
+    details_view->fast_layout_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_details_view_fast_layout_idle, details_view, NULL);
+}
+
+
+
+static void
+thunar_details_view_queue_fast_layout_reset (ThunarDetailsView *details_view)
+{
+  /* forget the widths of the previous folder */
+  details_view->fast_layout_reset = TRUE;
+  thunar_details_view_queue_fast_layout_sample (details_view);
+}
+
+
+
+static void
+thunar_details_view_queue_fast_layout_sample (ThunarDetailsView *details_view)
+{
+  /* rows were added, so measure a new sample of all rows */
+  details_view->fast_layout_sample = TRUE;
+  thunar_details_view_queue_fast_layout (details_view);
+}
+
+
+
+static void
+thunar_details_view_fast_layout_measure (ThunarDetailsView *details_view,
+                                         GtkTreeModel      *model,
+                                         GtkTreeIter       *iter,
+                                         gint              *widths)
+{
+  ThunarColumn column;
+  gint         width;
+
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    {
+      if (!gtk_tree_view_column_get_visible (details_view->columns[column]))
+        continue;
+
+      gtk_tree_view_column_cell_set_cell_data (details_view->columns[column], model, iter, FALSE, FALSE);
+      gtk_tree_view_column_cell_get_size (details_view->columns[column], NULL, NULL, NULL, &width, NULL);
+      widths[column] = MAX (widths[column], width);
+    }
+}
+
+
+
+static gboolean
+thunar_details_view_fast_layout_idle (gpointer data)
+{
+  ThunarDetailsView *details_view = THUNAR_DETAILS_VIEW (data);
+  GtkTreeModel      *model = GTK_TREE_MODEL (THUNAR_STANDARD_VIEW (details_view)->model);
+  GtkTreePath       *start_path;
+  GtkTreePath       *end_path;
+  GtkTreeIter        iter;
+  ThunarColumn       column;
+  gboolean           fast_layout;
+  gint               widths[THUNAR_N_VISIBLE_COLUMNS];
+  gint               separator;
+  gint               n_rows;
+  gint               stride;
+  gint               n;
+
+  details_view->fast_layout_idle_id = 0;
+
+  /* large folders use the fast layout, unless the columns are fixed anyway */
+  n_rows = gtk_tree_model_iter_n_children (model, NULL);
+  fast_layout = details_view->fast_layout_enabled
+             && !details_view->fixed_columns
+             && n_rows >= THUNAR_DETAILS_VIEW_FAST_LAYOUT_MIN_ROWS;
+  if (details_view->fast_layout != fast_layout)
+    thunar_details_view_set_fast_layout (details_view, fast_layout);
+
+  if (!details_view->fast_layout)
+    {
+      details_view->fast_layout_reset = FALSE;
+      details_view->fast_layout_sample = FALSE;
+      return FALSE;
+    }
+
+  /* columns only grow while the folder is shown, so they do not jump
+   * around while scrolling or while the folder is still loading */
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    widths[column] = details_view->fast_layout_reset ? 0 : gtk_tree_view_column_get_fixed_width (details_view->columns[column]);
+
+  /* measure the rows on screen */
+  if (gtk_tree_view_get_visible_range (GTK_TREE_VIEW (details_view->tree_view), &start_path, &end_path))
+    {
+      if (gtk_tree_model_get_iter (model, &iter, start_path))
+        {
+          do
+            {
+              thunar_details_view_fast_layout_measure (details_view, model, &iter, widths);
+              gtk_tree_path_next (start_path);
+            }
+          while (gtk_tree_path_compare (start_path, end_path) <= 0 && gtk_tree_model_iter_next (model, &iter));
+        }
+      gtk_tree_path_free (start_path);
+      gtk_tree_path_free (end_path);
+    }
+
+  /* and rows spread evenly over the whole folder, to
+   * catch long names or dates outside of the screen */
+  if (details_view->fast_layout_sample)
+    {
+      stride = MAX (n_rows / THUNAR_DETAILS_VIEW_FAST_LAYOUT_SAMPLE, 1);
+      for (n = 0; n < n_rows; n += stride)
+        if (gtk_tree_model_iter_nth_child (model, &iter, NULL, n))
+          thunar_details_view_fast_layout_measure (details_view, model, &iter, widths);
+    }
+
+  /* GtkTreeView puts the separator around the cells of a column */
+  gtk_widget_style_get (GTK_WIDGET (details_view->tree_view), "horizontal-separator", &separator, NULL);
+
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    if (gtk_tree_view_column_get_visible (details_view->columns[column])
+        && (details_view->fast_layout_reset || widths[column] > gtk_tree_view_column_get_fixed_width (details_view->columns[column])))
+      gtk_tree_view_column_set_fixed_width (details_view->columns[column], MAX (widths[column] + separator, 1));
+
+  details_view->fast_layout_reset = FALSE;
+  details_view->fast_layout_sample = FALSE;
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_details_view_set_fast_layout (ThunarDetailsView *details_view,
+                                     gboolean           fast_layout)
+{
+  GtkTreeView  *tree_view = GTK_TREE_VIEW (details_view->tree_view);
+  ThunarColumn  column;
+
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (details_view));
+
+  details_view->fast_layout = fast_layout;
+
+  /* disable in reverse order, otherwise graphical glitches can appear*/
+  if (!fast_layout)
+    gtk_tree_view_set_fixed_height_mode (tree_view, FALSE);
+
+  for (column = 0; column < THUNAR_N_VISIBLE_COLUMNS; ++column)
+    {
+      if (fast_layout)
+        {
+          /* the sampled width is applied by the caller */
+          gtk_tree_view_column_set_sizing (details_view->columns[column], GTK_TREE_VIEW_COLUMN_FIXED);
+        }
+      else
+        {
+          /* back to measuring all rows */
+          gtk_tree_view_column_set_sizing (details_view->columns[column], GTK_TREE_VIEW_COLUMN_GROW_ONLY);
+          gtk_tree_view_column_set_fixed_width (details_view->columns[column], -1);
+        }
+    }
+
+  /* the name column takes the remaining space in both modes */
+  gtk_tree_view_column_set_expand (details_view->columns[THUNAR_COLUMN_NAME], TRUE);
+
+  /* every row has the height of the first one */
+  if (fast_layout)
+    {
+      details_view->fast_layout_reset = TRUE;
+      details_view->fast_layout_sample = TRUE;
+      gtk_tree_view_set_fixed_height_mode (tree_view, TRUE);
+    }
+}
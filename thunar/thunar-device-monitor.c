@@ -36,6 +36,13 @@
 
 
 
+/* time (in ms) without further events before the changed devices are
+ * announced, and the longest a change is withheld while events keep coming */
+#define THUNAR_DEVICE_MONITOR_SETTLE_DELAY (150)
+#define THUNAR_DEVICE_MONITOR_SETTLE_MAX   (1000)
+
+
+
 /* signal identifiers */
 enum
 {
@@ -121,6 +128,11 @@ struct _ThunarDeviceMonitor
   /* user defined hidden volumes */
   ThunarPreferences  *preferences;
   gchar             **hidden_devices;
+
+  /* devices with a pending "device-changed", emitted once they settled */
+  GHashTable         *changed_devices;
+  guint               changed_timeout_id;
+  gint64              changed_since;
 };
 
 
@@ -205,6 +217,9 @@ thunar_device_monitor_init (ThunarDeviceMonitor *monitor)
   /* table for GVolume/GMount (key) -> ThunarDevice (value) */
   monitor->devices = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, g_object_unref);
 
+  /* set of devices waiting for their "device-changed" */
+  monitor->changed_devices = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
   /* gio volume monitor */
   monitor->volume_monitor = g_volume_monitor_get ();
 
@@ -251,6 +266,11 @@ thunar_device_monitor_finalize (GObject *object)
   g_signal_handlers_disconnect_matched (monitor->volume_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, monitor);
   g_object_unref (monitor->volume_monitor);
 
+  /* drop the pending changes */
+  if (monitor->changed_timeout_id != 0)
+    g_source_remove (monitor->changed_timeout_id);
+  g_hash_table_destroy (monitor->changed_devices);
+
   /* clear list of devices */
   g_hash_table_destroy (monitor->devices);
 
@@ -331,6 +351,71 @@ thunar_device_monitor_id_is_hidden (ThunarDeviceMonitor *monitor,
 
 
 
+static gboolean
+thunar_device_monitor_changed_timeout (gpointer user_data)
+{
+  ThunarDeviceMonitor *monitor = THUNAR_DEVICE_MONITOR (user_data);
+  GHashTable          *changed_devices;
+  GHashTableIter       iter;
+  gpointer             device;
+
+  monitor->changed_timeout_id = 0;
+
+  /* handlers may queue new changes while we emit */
+  changed_devices = monitor->changed_devices;
+  monitor->changed_devices = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  g_hash_table_iter_init (&iter, changed_devices);
+  while (g_hash_table_iter_next (&iter, &device, NULL))
+    g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+
+  g_hash_table_destroy (changed_devices);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_device_monitor_queue_changed (ThunarDeviceMonitor *monitor,
+                                     ThunarDevice        *device)
+{
+  gint64 now;
+
+  _thunar_return_if_fail (THUNAR_IS_DEVICE_MONITOR (monitor));
+  _thunar_return_if_fail (THUNAR_IS_DEVICE (device));
+
+  /* a device flapping through several states is announced once */
+  if (!g_hash_table_contains (monitor->changed_devices, device))
+    g_hash_table_add (monitor->changed_devices, g_object_ref (device));
+
+  /* wait until the burst of events, like a hub with several drives
+   * being plugged in, settled down */
+  now = g_get_monotonic_time ();
+  if (monitor->changed_timeout_id == 0)
+    monitor->changed_since = now;
+  else if (now - monitor->changed_since < THUNAR_DEVICE_MONITOR_SETTLE_MAX * 1000)
+    g_source_remove (monitor->changed_timeout_id);
+  else
+    return;
+
+  monitor->changed_timeout_id = g_timeout_add (THUNAR_DEVICE_MONITOR_SETTLE_DELAY, thunar_device_monitor_changed_timeout, monitor);
+}
+
+
+
+static void
+thunar_device_monitor_emit_removed (ThunarDeviceMonitor *monitor,
+                                    ThunarDevice        *device)
+{
+  /* the listeners forget the device, so do not bother them with its changes */
+  g_hash_table_remove (monitor->changed_devices, device);
+
+  g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_REMOVED], 0, device);
+}
+
+
+
 static void
 thunar_device_monitor_update_hidden (gpointer key,
                                      gpointer value,
@@ -349,7 +434,7 @@ thunar_device_monitor_update_hidden (gpointer key,
   if (thunar_device_get_hidden (device) != hidden)
     {
       g_object_set (G_OBJECT (device), "hidden", hidden, NULL);
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue_changed (monitor, device);
     }
 }
 
@@ -416,7 +501,7 @@ thunar_device_monitor_volume_removed (GVolumeMonitor      *volume_monitor,
         return;
 
       /* the device is not visble for the user */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_REMOVED], 0, device);
+      thunar_device_monitor_emit_removed (monitor, device);
 
       /* drop it */
       g_hash_table_remove (monitor->devices, volume);
@@ -475,7 +560,7 @@ thunar_device_monitor_volume_changed (GVolumeMonitor      *volume_monitor,
         return;
 
       /* the device changed */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue_changed (monitor, device);
     }
 }
 
@@ -559,7 +644,7 @@ thunar_device_monitor_mount_added (GVolumeMonitor      *volume_monitor,
           thunar_device_reload_file (device);
 
           /* notify */
-          g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+          thunar_device_monitor_queue_changed (monitor, device);
         }
 
       g_object_unref (volume);
@@ -587,7 +672,7 @@ thunar_device_monitor_mount_removed (GVolumeMonitor      *volume_monitor,
   if (device != NULL)
     {
       /* notify */
-      g_signal_emit (G_OBJECT (monitor),device_monitor_signals[DEVICE_REMOVED], 0, device);
+      thunar_device_monitor_emit_removed (monitor, device);
 
       /* drop it */
       g_hash_table_remove (monitor->devices, mount);
@@ -633,7 +718,7 @@ thunar_device_monitor_mount_changed (GVolumeMonitor      *volume_monitor,
   if (device != NULL)
     {
       /* notify */
-      g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
+      thunar_device_monitor_queue_changed (monitor, device);
     }
 }
 
@@ -744,8 +829,9 @@ thunar_device_monitor_set_hidden (ThunarDeviceMonitor *monitor,
   if (id == NULL)
     return;
 
-  /* update device */
+  /* update device, the user asked for it so this is not delayed */
   g_object_set (G_OBJECT (device), "hidden", hidden, NULL);
+  g_hash_table_remove (monitor->changed_devices, device);
   g_signal_emit (G_OBJECT (monitor), device_monitor_signals[DEVICE_CHANGED], 0, device);
 
   /* update the device list */
@@ -35,6 +35,11 @@
 
 
 
+/* number of dragged files checked for the drag-motion feedback */
+#define THUNAR_DND_ACCEPT_SAMPLE (64)
+
+
+
 static void
 dnd_action_selected (GtkWidget     *item,
                      GdkDragAction *dnd_action_return)
@@ -268,3 +273,85 @@ thunar_dnd_perform (GtkWidget    *widget,
 
 
 
+/**
+ * thunar_dnd_accepts_drop:
+ * @cache                   : the #ThunarDndAcceptCache of the drop site.
+ * @file                    : the #ThunarFile below the pointer.
+ * @file_list               : the list of #GFile<!---->s that are dragged.
+ * @context                 : the current #GdkDragContext.
+ * @suggested_action_return : return location for the suggested #GdkDragAction or %NULL.
+ *
+ * Drag-motion variant of thunar_file_accepts_drop(). Only a sample of
+ * @file_list is checked, and the result is reused for as long as the
+ * pointer stays on @file and the drag offers the same actions. The
+ * complete list must still be checked with thunar_file_accepts_drop()
+ * when the files are dropped.
+ *
+ * Return value: the #GdkDragAction<!---->s supported for the drop or
+ *               0 if no drop is possible.
+ **/
+GdkDragAction
+thunar_dnd_accepts_drop (ThunarDndAcceptCache *cache,
+                         ThunarFile           *file,
+                         GList                *file_list,
+                         GdkDragContext       *context,
+                         GdkDragAction        *suggested_action_return)
+{
+  GdkDragAction context_actions;
+  GdkDragAction context_suggested_action;
+
+  _thunar_return_val_if_fail (cache != NULL, 0);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
+  _thunar_return_val_if_fail (GDK_IS_DRAG_CONTEXT (context), 0);
+
+  /* the offered actions change with the modifier keys */
+  context_actions = gdk_drag_context_get_actions (context);
+  context_suggested_action = gdk_drag_context_get_suggested_action (context);
+
+  if (cache->context != context
+      || cache->file != file
+      || cache->context_actions != context_actions
+      || cache->context_suggested_action != context_suggested_action)
+    {
+      thunar_dnd_accept_cache_clear (cache);
+
+      cache->context = g_object_ref (context);
+      cache->file = g_object_ref (file);
+      cache->context_actions = context_actions;
+      cache->context_suggested_action = context_suggested_action;
+      cache->suggested_action = 0;
+      cache->actions = thunar_file_accepts_drop_sample (file, file_list, THUNAR_DND_ACCEPT_SAMPLE,
+                                                        context, &cache->suggested_action);
+    }
+
+  /* only set if thunar_file_accepts_drop_sample() would have */
+  if (suggested_action_return != NULL && cache->suggested_action != 0)
+    *suggested_action_return = cache->suggested_action;
+
+  return cache->actions;
+}
+
+
+
+/**
+ * thunar_dnd_accept_cache_clear:
+ * @cache : a #ThunarDndAcceptCache.
+ *
+ * Forgets the decision stored in @cache, which must be done whenever the
+ * drag leaves the drop site or its drop data is released.
+ **/
+void
+thunar_dnd_accept_cache_clear (ThunarDndAcceptCache *cache)
+{
+  _thunar_return_if_fail (cache != NULL);
+
+  if (cache->context != NULL)
+    g_object_unref (cache->context);
+  if (cache->file != NULL)
+    g_object_unref (cache->file);
+
+  cache->context = NULL;
+  cache->file = NULL;
+  cache->actions = 0;
+  cache->suggested_action = 0;
+}
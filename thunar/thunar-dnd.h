@@ -24,6 +24,21 @@
 
 G_BEGIN_DECLS;
 
+/* the decision of thunar_dnd_accepts_drop() for the last drop target,
+ * embedded in the drop site and cleared when the drag leaves it */
+typedef struct _ThunarDndAcceptCache ThunarDndAcceptCache;
+
+struct _ThunarDndAcceptCache
+{
+  GdkDragContext *context;
+  ThunarFile     *file;
+  GdkDragAction   context_actions;
+  GdkDragAction   context_suggested_action;
+
+  GdkDragAction   actions;
+  GdkDragAction   suggested_action;
+};
+
 GdkDragAction thunar_dnd_ask     (GtkWidget    *widget,
                                   ThunarFile   *folder,
                                   GList        *path_list,
@@ -35,6 +50,14 @@ gboolean      thunar_dnd_perform (GtkWidget    *widget,
                                   GdkDragAction action,
                                   GClosure     *new_files_closure);
 
+GdkDragAction thunar_dnd_accepts_drop     (ThunarDndAcceptCache *cache,
+                                           ThunarFile           *file,
+                                           GList                *file_list,
+                                           GdkDragContext       *context,
+                                           GdkDragAction        *suggested_action_return);
+
+void          thunar_dnd_accept_cache_clear (ThunarDndAcceptCache *cache);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_DND_H__ */
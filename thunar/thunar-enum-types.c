@@ -647,6 +647,32 @@ thunar_verify_file_get_type (void)
 
 
 
+GType
+thunar_transfer_conflict_policy_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      static const GEnumValue values[] =
+      {
+        { THUNAR_TRANSFER_CONFLICT_POLICY_ASK,              "THUNAR_TRANSFER_CONFLICT_POLICY_ASK",              N_("Ask"),},
+        { THUNAR_TRANSFER_CONFLICT_POLICY_SKIP,             "THUNAR_TRANSFER_CONFLICT_POLICY_SKIP",             N_("Skip"),},
+        { THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE,          "THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE",          N_("Replace"),},
+        { THUNAR_TRANSFER_CONFLICT_POLICY_RENAME,           "THUNAR_TRANSFER_CONFLICT_POLICY_RENAME",           N_("Rename"),},
+        { THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE_IF_NEWER, "THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE_IF_NEWER", N_("Replace if newer"),},
+        { THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL,   "THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL",   N_("Skip identical"),},
+        { 0,                                                NULL,                                               NULL,},
+      };
+
+      type = g_enum_register_static (I_("ThunarTransferConflictPolicy"), values);
+    }
+
+  return type;
+}
+
+
+
 /**
  * thunar_status_bar_info_toggle_bit:
  * @info   : a #guint.
@@ -731,6 +757,49 @@ thunar_operation_log_mode_get_type (void)
   return type;
 }
 
+GType
+thunar_job_priority_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      static const GEnumValue values[] =
+      {
+        { THUNAR_JOB_PRIORITY_INTERACTIVE, "THUNAR_JOB_PRIORITY_INTERACTIVE", "interactive" },
+        { THUNAR_JOB_PRIORITY_NORMAL,      "THUNAR_JOB_PRIORITY_NORMAL",      "normal"      },
+        { THUNAR_JOB_PRIORITY_BACKGROUND,  "THUNAR_JOB_PRIORITY_BACKGROUND",  "background"  },
+        { THUNAR_JOB_PRIORITY_IDLE,        "THUNAR_JOB_PRIORITY_IDLE",        "idle"        },
+        { 0,                               NULL,                              NULL          }
+      };
+
+      type = g_enum_register_static ("ThunarJobPriority", values);
+    }
+
+  return type;
+}
+
+GType
+thunar_job_pool_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      static const GEnumValue values[] =
+      {
+        { THUNAR_JOB_POOL_INTERACTIVE, "THUNAR_JOB_POOL_INTERACTIVE", "interactive" },
+        { THUNAR_JOB_POOL_BULK,        "THUNAR_JOB_POOL_BULK",        "bulk"        },
+        { THUNAR_JOB_POOL_CPU,         "THUNAR_JOB_POOL_CPU",         "cpu"         },
+        { 0,                           NULL,                          NULL          }
+      };
+
+      type = g_enum_register_static ("ThunarJobPool", values);
+    }
+
+  return type;
+}
+
 GType
 thunar_image_preview_mode_get_type (void)
 {
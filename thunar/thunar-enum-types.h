@@ -409,17 +409,49 @@ GType thunar_verify_file_get_type (void) G_GNUC_CONST;
 
 
 
+#define THUNAR_TYPE_TRANSFER_CONFLICT_POLICY (thunar_transfer_conflict_policy_get_type ())
+
+/**
+ * ThunarTransferConflictPolicy:
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_ASK              : ask the user about every existing target
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_SKIP             : keep the existing targets
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE          : replace the existing targets
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_RENAME           : copy next to the existing targets under a new name
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE_IF_NEWER : replace the existing targets which are older than the source
+ * @THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL   : keep the existing targets which are identical to the source,
+ *                                                    ask about the others
+ *
+ * How a copy handles files whose target already exists. Existing
+ * folders are merged unless the user is asked.
+ **/
+typedef enum
+{
+  THUNAR_TRANSFER_CONFLICT_POLICY_ASK,
+  THUNAR_TRANSFER_CONFLICT_POLICY_SKIP,
+  THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE,
+  THUNAR_TRANSFER_CONFLICT_POLICY_RENAME,
+  THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE_IF_NEWER,
+  THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL,
+} ThunarTransferConflictPolicy;
+
+GType thunar_transfer_conflict_policy_get_type (void) G_GNUC_CONST;
+
+
+
 /**
  * ThunarNewTabBehavior:
  * @THUNAR_NEW_TAB_BEHAVIOR_FOLLOW_PREFERENCE   : switching to the new tab or not is controlled by a preference.
  * @THUNAR_NEW_TAB_BEHAVIOR_SWITCH              : switch to the new tab.
  * @THUNAR_NEW_TAB_BEHAVIOR_STAY                : stay at the current tab.
+ * @THUNAR_NEW_TAB_BEHAVIOR_DEFER               : stay at the current tab and load the new tab
+ *                                                once it is shown.
  **/
 typedef enum
 {
     THUNAR_NEW_TAB_BEHAVIOR_FOLLOW_PREFERENCE,
     THUNAR_NEW_TAB_BEHAVIOR_SWITCH,
-    THUNAR_NEW_TAB_BEHAVIOR_STAY
+    THUNAR_NEW_TAB_BEHAVIOR_STAY,
+    THUNAR_NEW_TAB_BEHAVIOR_DEFER
 } ThunarNewTabBehavior;
 
 
@@ -475,6 +507,49 @@ typedef enum
 
 GType thunar_operation_log_mode_get_type (void) G_GNUC_CONST;
 
+/**
+ * ThunarJobPriority:
+ * @THUNAR_JOB_PRIORITY_INTERACTIVE : the user is waiting for the result, e.g. a folder listing.
+ * @THUNAR_JOB_PRIORITY_NORMAL      : default I/O and CPU share.
+ * @THUNAR_JOB_PRIORITY_BACKGROUND  : long running work like transfers, which should not slow down the UI.
+ * @THUNAR_JOB_PRIORITY_IDLE        : only do I/O when nobody else wants the disk.
+ *
+ * The I/O and CPU class of the worker thread running a #ThunarJob.
+ **/
+
+#define THUNAR_TYPE_JOB_PRIORITY (thunar_job_priority_get_type ())
+
+typedef enum
+{
+  THUNAR_JOB_PRIORITY_INTERACTIVE,
+  THUNAR_JOB_PRIORITY_NORMAL,
+  THUNAR_JOB_PRIORITY_BACKGROUND,
+  THUNAR_JOB_PRIORITY_IDLE,
+} ThunarJobPriority;
+
+GType thunar_job_priority_get_type (void) G_GNUC_CONST;
+
+/**
+ * ThunarJobPool:
+ * @THUNAR_JOB_POOL_INTERACTIVE : short jobs the user is waiting for, like folder listings.
+ * @THUNAR_JOB_POOL_BULK        : long running I/O, like transfers, deletions and deep counts.
+ * @THUNAR_JOB_POOL_CPU         : jobs bound by the processor, like computing checksums.
+ *
+ * The pool of the job executor a #ThunarJob is queued in.
+ **/
+
+#define THUNAR_TYPE_JOB_POOL (thunar_job_pool_get_type ())
+
+typedef enum
+{
+  THUNAR_JOB_POOL_INTERACTIVE,
+  THUNAR_JOB_POOL_BULK,
+  THUNAR_JOB_POOL_CPU,
+  THUNAR_JOB_N_POOLS,
+} ThunarJobPool;
+
+GType thunar_job_pool_get_type (void) G_GNUC_CONST;
+
 /**
  * ThunarImagePreviewMode:
  *
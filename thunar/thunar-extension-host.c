@@ -0,0 +1,685 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-extension-host.h>
+#include <thunar/thunar-extension-protocol.h>
+#include <thunar/thunar-private.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+
+
+/* number of times the helper may exit before we stop restarting it */
+#define THUNAR_EXTENSION_HOST_MAX_FAILURES (3)
+
+
+
+typedef struct
+{
+  ThunarExtensionHost *host;
+  GCancellable        *cancellable;  /* of the helper the data belongs to */
+  guint32              header;
+  guint8              *data;
+  gsize                size;
+  GBytes              *bytes;
+} ThunarExtensionHostIO;
+
+
+
+static void     thunar_extension_host_menu_provider_init            (ThunarxMenuProviderIface *iface);
+static void     thunar_extension_host_finalize                      (GObject                  *object);
+static GList   *thunar_extension_host_get_file_menu_items           (ThunarxMenuProvider      *provider,
+                                                                     GtkWidget                *window,
+                                                                     GList                    *files);
+static void     thunar_extension_host_get_file_menu_items_async     (ThunarxMenuProvider      *provider,
+                                                                     GtkWidget                *window,
+                                                                     GList                    *files,
+                                                                     GCancellable             *cancellable,
+                                                                     GAsyncReadyCallback       callback,
+                                                                     gpointer                  user_data);
+static GList   *thunar_extension_host_get_file_menu_items_finish    (ThunarxMenuProvider      *provider,
+                                                                     GAsyncResult             *result,
+                                                                     GError                  **error);
+static gboolean thunar_extension_host_spawn                         (ThunarExtensionHost      *host);
+static void     thunar_extension_host_stop                          (ThunarExtensionHost      *host);
+static void     thunar_extension_host_send                          (ThunarExtensionHost      *host,
+                                                                     guint32                   serial,
+                                                                     const gchar              *command,
+                                                                     GVariant                 *arguments);
+static void     thunar_extension_host_flush                         (ThunarExtensionHost      *host);
+static void     thunar_extension_host_read_header                   (ThunarExtensionHost      *host);
+static void     thunar_extension_host_io_free                       (ThunarExtensionHostIO    *io);
+
+
+
+struct _ThunarExtensionHostClass
+{
+  GObjectClass __parent__;
+};
+
+/**
+ * ThunarExtensionHost:
+ *
+ * Menu provider standing in for the menu providers of the modules installed
+ * in the "hosted" subdirectory of the extension directories. Those modules
+ * are not loaded into Thunar, but into the thunar-extension-host helper,
+ * which is spawned on the first request and receives snapshots of the
+ * selected files. A leaking, crashing or slow extension thus only takes
+ * the helper with it.
+ **/
+struct _ThunarExtensionHost
+{
+  GObject __parent__;
+
+  gchar        **modules;      /* module names relative to the extension directories */
+
+  GSubprocess   *subprocess;
+  GCancellable  *cancellable;  /* cancelled when the helper goes away */
+  GQueue         outgoing;     /* GBytes waiting to be written to the helper */
+  gboolean       writing;
+  GHashTable    *tasks;        /* serial -> GTask waiting for menu items */
+  guint32        next_serial;
+  guint          generation;   /* incremented for every spawned helper */
+  guint          n_failures;
+};
+
+
+
+static GQuark thunar_extension_host_id_quark;
+static GQuark thunar_extension_host_generation_quark;
+
+
+
+G_DEFINE_TYPE_WITH_CODE (ThunarExtensionHost, thunar_extension_host, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE (THUNARX_TYPE_MENU_PROVIDER, thunar_extension_host_menu_provider_init))
+
+
+
+static void
+thunar_extension_host_class_init (ThunarExtensionHostClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  thunar_extension_host_id_quark = g_quark_from_static_string ("thunar-extension-host-id");
+  thunar_extension_host_generation_quark = g_quark_from_static_string ("thunar-extension-host-generation");
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_extension_host_finalize;
+}
+
+
+
+static void
+thunar_extension_host_menu_provider_init (ThunarxMenuProviderIface *iface)
+{
+  iface->get_file_menu_items = thunar_extension_host_get_file_menu_items;
+  iface->get_file_menu_items_async = thunar_extension_host_get_file_menu_items_async;
+  iface->get_file_menu_items_finish = thunar_extension_host_get_file_menu_items_finish;
+}
+
+
+
+static void
+thunar_extension_host_init (ThunarExtensionHost *host)
+{
+  g_queue_init (&host->outgoing);
+  host->tasks = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
+}
+
+
+
+static void
+thunar_extension_host_finalize (GObject *object)
+{
+  ThunarExtensionHost *host = THUNAR_EXTENSION_HOST (object);
+
+  /* closing the pipes makes the helper exit */
+  thunar_extension_host_stop (host);
+
+  g_hash_table_destroy (host->tasks);
+  g_strfreev (host->modules);
+
+  (*G_OBJECT_CLASS (thunar_extension_host_parent_class)->finalize) (object);
+}
+
+
+
+static GList *
+thunar_extension_host_get_file_menu_items (ThunarxMenuProvider *provider,
+                                           GtkWidget           *window,
+                                           GList               *files)
+{
+  /* the hosted items are only available asynchronously */
+  return NULL;
+}
+
+
+
+static void
+thunar_extension_host_item_activated (ThunarxMenuItem     *item,
+                                      ThunarExtensionHost *host)
+{
+  guint generation;
+  guint id;
+
+  _thunar_return_if_fail (THUNAR_IS_EXTENSION_HOST (host));
+
+  /* items of a helper that exited in between can't be activated anymore */
+  generation = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (item), thunar_extension_host_generation_quark));
+  if (host->subprocess == NULL || generation != host->generation)
+    return;
+
+  id = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (item), thunar_extension_host_id_quark));
+  thunar_extension_host_send (host, 0, THUNAR_EXTENSION_PROTOCOL_ACTIVATE, g_variant_new_uint32 (id));
+}
+
+
+
+static ThunarxMenuItem *
+thunar_extension_host_item_new (ThunarExtensionHost *host,
+                                GVariant            *variant)
+{
+  ThunarxMenuItem *item;
+  ThunarxMenuItem *child_item;
+  ThunarxMenu     *menu;
+  GVariantIter     iter;
+  const gchar     *name, *label, *tooltip, *icon;
+  GVariant        *children;
+  GVariant        *child;
+  gboolean         sensitive;
+  gboolean         priority;
+  guint32          id;
+
+  g_variant_get (variant, "(u&s&s&s&sbb@av)", &id, &name, &label, &tooltip, &icon, &sensitive, &priority, &children);
+
+  item = thunarx_menu_item_new (name, label, *tooltip != '\0' ? tooltip : NULL, *icon != '\0' ? icon : NULL);
+  g_object_set (G_OBJECT (item), "sensitive", sensitive, "priority", priority, NULL);
+
+  /* remember where the item came from, so we can forward its activation */
+  g_object_set_qdata (G_OBJECT (item), thunar_extension_host_id_quark, GUINT_TO_POINTER (id));
+  g_object_set_qdata (G_OBJECT (item), thunar_extension_host_generation_quark, GUINT_TO_POINTER (host->generation));
+  g_signal_connect_object (G_OBJECT (item), "activate", G_CALLBACK (thunar_extension_host_item_activated), host, 0);
+
+  if (g_variant_n_children (children) > 0)
+    {
+      menu = thunarx_menu_new ();
+      g_variant_iter_init (&iter, children);
+      while (g_variant_iter_next (&iter, "v", &child))
+        {
+          if (g_variant_is_of_type (child, G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_ITEM)))
+            {
+              child_item = thunar_extension_host_item_new (host, child);
+              thunarx_menu_append_item (menu, child_item);
+              g_object_unref (child_item);
+            }
+          g_variant_unref (child);
+        }
+      thunarx_menu_item_set_menu (item, menu);
+      g_object_unref (menu);
+    }
+
+  g_variant_unref (children);
+
+  return item;
+}
+
+
+
+static void
+thunar_extension_host_get_file_menu_items_async (ThunarxMenuProvider *provider,
+                                                 GtkWidget           *window,
+                                                 GList               *files,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data)
+{
+  ThunarExtensionHost *host = THUNAR_EXTENSION_HOST (provider);
+  GVariantBuilder      builder;
+  GTask               *task;
+  GList               *lp;
+  gchar               *uri, *name, *mime_type;
+
+  task = g_task_new (provider, cancellable, callback, user_data);
+  g_task_set_source_tag (task, thunar_extension_host_get_file_menu_items_async);
+
+  /* the helper couldn't be started, there's nothing to offer */
+  if (!thunar_extension_host_spawn (host))
+    {
+      g_task_return_pointer (task, NULL, NULL);
+      g_object_unref (task);
+      return;
+    }
+
+  /* send a snapshot of the files in a single batch */
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_FILES));
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      uri = thunarx_file_info_get_uri (lp->data);
+      name = thunarx_file_info_get_name (lp->data);
+      mime_type = thunarx_file_info_get_mime_type (lp->data);
+      g_variant_builder_add (&builder, "(sssb)",
+                             uri != NULL ? uri : "",
+                             name != NULL ? name : "",
+                             mime_type != NULL ? mime_type : "",
+                             thunarx_file_info_is_directory (lp->data));
+      g_free (uri);
+      g_free (name);
+      g_free (mime_type);
+    }
+
+  /* serial 0 is reserved for requests without reply */
+  if (G_UNLIKELY (++host->next_serial == 0))
+    ++host->next_serial;
+
+  g_hash_table_insert (host->tasks, GUINT_TO_POINTER (host->next_serial), task);
+  thunar_extension_host_send (host, host->next_serial, THUNAR_EXTENSION_PROTOCOL_MENU, g_variant_builder_end (&builder));
+}
+
+
+
+static GList *
+thunar_extension_host_get_file_menu_items_finish (ThunarxMenuProvider *provider,
+                                                  GAsyncResult        *result,
+                                                  GError             **error)
+{
+  _thunar_return_val_if_fail (g_task_is_valid (result, provider), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+
+
+static gboolean
+thunar_extension_host_spawn (ThunarExtensionHost *host)
+{
+  GError  *error = NULL;
+  gchar  **argv;
+  guint    n_modules;
+  guint    n;
+
+  if (G_LIKELY (host->subprocess != NULL))
+    return TRUE;
+
+  if (host->n_failures >= THUNAR_EXTENSION_HOST_MAX_FAILURES)
+    return FALSE;
+
+  n_modules = g_strv_length (host->modules);
+  argv = g_new0 (gchar *, n_modules + 2);
+  argv[0] = g_build_filename (HELPERDIR, "Thunar", "thunar-extension-host", NULL);
+  for (n = 0; n < n_modules; ++n)
+    argv[n + 1] = host->modules[n];
+
+  host->subprocess = g_subprocess_newv ((const gchar * const *) argv, G_SUBPROCESS_FLAGS_STDIN_PIPE | G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error);
+
+  g_free (argv[0]);
+  g_free (argv);
+
+  if (G_UNLIKELY (host->subprocess == NULL))
+    {
+      /* no point in trying again */
+      g_warning ("Failed to start the extension host: %s", error->message);
+      host->n_failures = THUNAR_EXTENSION_HOST_MAX_FAILURES;
+      g_error_free (error);
+      return FALSE;
+    }
+
+  host->cancellable = g_cancellable_new ();
+  host->generation++;
+
+  thunar_extension_host_read_header (host);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_extension_host_stop (ThunarExtensionHost *host)
+{
+  GHashTableIter iter;
+  gpointer       task;
+
+  if (host->subprocess == NULL)
+    return;
+
+  /* pending callbacks of this helper must leave the host alone */
+  g_cancellable_cancel (host->cancellable);
+  g_clear_object (&host->cancellable);
+  g_clear_object (&host->subprocess);
+
+  g_queue_clear_full (&host->outgoing, (GDestroyNotify) g_bytes_unref);
+  host->writing = FALSE;
+
+  g_hash_table_iter_init (&iter, host->tasks);
+  while (g_hash_table_iter_next (&iter, NULL, &task))
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_BROKEN_PIPE, _("The extension host exited"));
+      g_hash_table_iter_remove (&iter);
+    }
+
+  host->n_failures++;
+}
+
+
+
+static void
+thunar_extension_host_io_free (ThunarExtensionHostIO *io)
+{
+  if (io->bytes != NULL)
+    g_bytes_unref (io->bytes);
+  g_object_unref (io->cancellable);
+  g_free (io->data);
+  g_slice_free (ThunarExtensionHostIO, io);
+}
+
+
+
+static void
+thunar_extension_host_write_ready (GObject      *object,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  ThunarExtensionHostIO *io = user_data;
+  ThunarExtensionHost   *host = io->host;
+  gboolean               succeed;
+
+  succeed = g_output_stream_write_all_finish (G_OUTPUT_STREAM (object), result, NULL, NULL);
+
+  if (G_UNLIKELY (g_cancellable_is_cancelled (io->cancellable)))
+    {
+      thunar_extension_host_io_free (io);
+      return;
+    }
+
+  thunar_extension_host_io_free (io);
+
+  if (G_UNLIKELY (!succeed))
+    {
+      thunar_extension_host_stop (host);
+      return;
+    }
+
+  host->writing = FALSE;
+  thunar_extension_host_flush (host);
+}
+
+
+
+static void
+thunar_extension_host_flush (ThunarExtensionHost *host)
+{
+  ThunarExtensionHostIO *io;
+  GOutputStream         *stream;
+
+  if (host->writing || g_queue_is_empty (&host->outgoing))
+    return;
+
+  io = g_slice_new0 (ThunarExtensionHostIO);
+  io->host = host;
+  io->cancellable = g_object_ref (host->cancellable);
+  io->bytes = g_queue_pop_head (&host->outgoing);
+
+  host->writing = TRUE;
+  stream = g_subprocess_get_stdin_pipe (host->subprocess);
+  g_output_stream_write_all_async (stream, g_bytes_get_data (io->bytes, NULL), g_bytes_get_size (io->bytes),
+                                   G_PRIORITY_DEFAULT, io->cancellable, thunar_extension_host_write_ready, io);
+}
+
+
+
+static void
+thunar_extension_host_send (ThunarExtensionHost *host,
+                            guint32              serial,
+                            const gchar         *command,
+                            GVariant            *arguments)
+{
+  GByteArray *message;
+  GVariant   *request;
+  guint32     size;
+
+  _thunar_return_if_fail (host->subprocess != NULL);
+
+  request = g_variant_ref_sink (g_variant_new (THUNAR_EXTENSION_PROTOCOL_REQUEST, serial, command, arguments));
+
+  /* prefix the serialized request with its size */
+  size = GUINT32_TO_LE (g_variant_get_size (request));
+  message = g_byte_array_sized_new (sizeof (size) + g_variant_get_size (request));
+  g_byte_array_append (message, (const guint8 *) &size, sizeof (size));
+  g_byte_array_append (message, g_variant_get_data (request), g_variant_get_size (request));
+  g_variant_unref (request);
+
+  g_queue_push_tail (&host->outgoing, g_byte_array_free_to_bytes (message));
+  thunar_extension_host_flush (host);
+}
+
+
+
+static void
+thunar_extension_host_read_body_ready (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  ThunarExtensionHostIO *io = user_data;
+  ThunarExtensionHost   *host = io->host;
+  GVariantIter           iter;
+  ThunarxMenuItem       *item;
+  GVariant              *reply;
+  GVariant              *items;
+  GVariant              *variant;
+  gboolean               succeed;
+  GTask                 *task;
+  GList                 *menu_items = NULL;
+  gsize                  bytes_read;
+  guint32                serial;
+
+  succeed = g_input_stream_read_all_finish (G_INPUT_STREAM (object), result, &bytes_read, NULL);
+
+  if (G_UNLIKELY (g_cancellable_is_cancelled (io->cancellable)))
+    {
+      thunar_extension_host_io_free (io);
+      return;
+    }
+
+  if (G_UNLIKELY (!succeed || bytes_read != io->size))
+    {
+      thunar_extension_host_io_free (io);
+      thunar_extension_host_stop (host);
+      return;
+    }
+
+  reply = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_REPLY),
+                                                       io->data, io->size, FALSE, g_free, io->data));
+  io->data = NULL;
+  thunar_extension_host_io_free (io);
+
+  g_variant_get (reply, "(uv)", &serial, &items);
+
+  if (g_hash_table_steal_extended (host->tasks, GUINT_TO_POINTER (serial), NULL, (gpointer *) &task))
+    {
+      if (g_variant_is_of_type (items, G_VARIANT_TYPE (THUNAR_EXTENSION_PROTOCOL_ITEMS)))
+        {
+          g_variant_iter_init (&iter, items);
+          while ((variant = g_variant_iter_next_value (&iter)) != NULL)
+            {
+              item = thunar_extension_host_item_new (host, variant);
+              menu_items = g_list_prepend (menu_items, item);
+              g_variant_unref (variant);
+            }
+        }
+
+      g_task_return_pointer (task, g_list_reverse (menu_items), (GDestroyNotify) thunarx_menu_item_list_free);
+      g_object_unref (task);
+    }
+
+  g_variant_unref (items);
+  g_variant_unref (reply);
+
+  thunar_extension_host_read_header (host);
+}
+
+
+
+static void
+thunar_extension_host_read_header_ready (GObject      *object,
+                                         GAsyncResult *result,
+                                         gpointer      user_data)
+{
+  ThunarExtensionHostIO *io = user_data;
+  ThunarExtensionHost   *host = io->host;
+  gboolean               succeed;
+  gsize                  bytes_read;
+
+  succeed = g_input_stream_read_all_finish (G_INPUT_STREAM (object), result, &bytes_read, NULL);
+
+  if (G_UNLIKELY (g_cancellable_is_cancelled (io->cancellable)))
+    {
+      thunar_extension_host_io_free (io);
+      return;
+    }
+
+  /* the helper exited or sent garbage */
+  if (G_UNLIKELY (!succeed || bytes_read != sizeof (io->header)
+                  || GUINT32_FROM_LE (io->header) > THUNAR_EXTENSION_PROTOCOL_MAX_SIZE))
+    {
+      thunar_extension_host_io_free (io);
+      thunar_extension_host_stop (host);
+      return;
+    }
+
+  io->size = GUINT32_FROM_LE (io->header);
+  io->data = g_malloc (io->size);
+  g_input_stream_read_all_async (G_INPUT_STREAM (object), io->data, io->size, G_PRIORITY_DEFAULT,
+                                 io->cancellable, thunar_extension_host_read_body_ready, io);
+}
+
+
+
+static void
+thunar_extension_host_read_header (ThunarExtensionHost *host)
+{
+  ThunarExtensionHostIO *io;
+
+  io = g_slice_new0 (ThunarExtensionHostIO);
+  io->host = host;
+  io->cancellable = g_object_ref (host->cancellable);
+
+  g_input_stream_read_all_async (g_subprocess_get_stdout_pipe (host->subprocess), &io->header, sizeof (io->header),
+                                 G_PRIORITY_DEFAULT, io->cancellable, thunar_extension_host_read_header_ready, io);
+}
+
+
+
+static gchar **
+thunar_extension_host_list_modules (void)
+{
+  const gchar *dirs_string = NULL;
+  const gchar *name;
+  GPtrArray   *modules;
+  gchar      **dirs;
+  gchar       *path;
+  gchar       *module;
+  GDir        *dp;
+  guint        n;
+
+  if (g_strcmp0 (THUNARX_ENABLE_CUSTOM_DIRS, "TRUE") == 0)
+    dirs_string = g_getenv ("THUNARX_DIRS");
+
+  if (dirs_string == NULL)
+    dirs_string = THUNARX_DIRECTORY;
+
+  modules = g_ptr_array_new ();
+
+  /* the provider factory doesn't descend into the "hosted" subdirectories */
+  dirs = g_strsplit (dirs_string, G_SEARCHPATH_SEPARATOR_S, 0);
+  for (n = 0; dirs[n] != NULL; ++n)
+    {
+      path = g_build_filename (dirs[n], "hosted", NULL);
+      dp = g_dir_open (path, 0, NULL);
+      g_free (path);
+
+      if (G_LIKELY (dp == NULL))
+        continue;
+
+      for (name = g_dir_read_name (dp); name != NULL; name = g_dir_read_name (dp))
+        {
+          if (!g_str_has_suffix (name, "." G_MODULE_SUFFIX))
+            continue;
+
+          /* the first directory containing a module wins, like for in-process modules */
+          module = g_build_filename ("hosted", name, NULL);
+          if (!g_ptr_array_find_with_equal_func (modules, module, g_str_equal, NULL))
+            g_ptr_array_add (modules, module);
+          else
+            g_free (module);
+        }
+
+      g_dir_close (dp);
+    }
+  g_strfreev (dirs);
+
+  if (modules->len == 0)
+    {
+      g_ptr_array_free (modules, TRUE);
+      return NULL;
+    }
+
+  g_ptr_array_add (modules, NULL);
+  return (gchar **) g_ptr_array_free (modules, FALSE);
+}
+
+
+
+/**
+ * thunar_extension_host_get_default:
+ *
+ * Returns a reference to the default #ThunarExtensionHost instance, or
+ * %NULL if no extension modules are installed to be hosted out of
+ * process. The caller is responsible to free the returned reference
+ * using g_object_unref() when no longer needed.
+ *
+ * Return value: reference to the default extension host or %NULL.
+ **/
+ThunarExtensionHost*
+thunar_extension_host_get_default (void)
+{
+  static ThunarExtensionHost *host = NULL;
+  gchar                     **modules;
+
+  if (G_UNLIKELY (host == NULL))
+    {
+      modules = thunar_extension_host_list_modules ();
+      if (modules == NULL)
+        return NULL;
+
+      host = g_object_new (THUNAR_TYPE_EXTENSION_HOST, NULL);
+      host->modules = modules;
+      g_object_add_weak_pointer (G_OBJECT (host), (gpointer) &host);
+    }
+  else
+    {
+      g_object_ref (G_OBJECT (host));
+    }
+
+  return host;
+}
@@ -0,0 +1,44 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_EXTENSION_HOST_H__
+#define __THUNAR_EXTENSION_HOST_H__
+
+#include <thunarx/thunarx.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarExtensionHostClass ThunarExtensionHostClass;
+typedef struct _ThunarExtensionHost      ThunarExtensionHost;
+
+#define THUNAR_TYPE_EXTENSION_HOST            (thunar_extension_host_get_type ())
+#define THUNAR_EXTENSION_HOST(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_EXTENSION_HOST, ThunarExtensionHost))
+#define THUNAR_EXTENSION_HOST_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_EXTENSION_HOST, ThunarExtensionHostClass))
+#define THUNAR_IS_EXTENSION_HOST(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_EXTENSION_HOST))
+#define THUNAR_IS_EXTENSION_HOST_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_EXTENSION_HOST))
+#define THUNAR_EXTENSION_HOST_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_EXTENSION_HOST, ThunarExtensionHostClass))
+
+GType                thunar_extension_host_get_type    (void) G_GNUC_CONST;
+
+ThunarExtensionHost *thunar_extension_host_get_default (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_EXTENSION_HOST_H__ */
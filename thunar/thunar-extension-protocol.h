@@ -0,0 +1,57 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_EXTENSION_PROTOCOL_H__
+#define __THUNAR_EXTENSION_PROTOCOL_H__
+
+/*
+ * Messages exchanged between Thunar and the thunar-extension-host helper,
+ * which runs the menu providers of the modules installed below the "hosted"
+ * subdirectory of the extension directories in a process of its own.
+ *
+ * Each message is a serialized GVariant in normal form, preceded by its
+ * size as a little-endian guint32. Thunar writes requests to the standard
+ * input of the helper, the helper answers "menu" requests on its standard
+ * output in the order they arrived.
+ */
+
+/* maximum size of a single message */
+#define THUNAR_EXTENSION_PROTOCOL_MAX_SIZE  (16 * 1024 * 1024)
+
+/* (serial, command, arguments) */
+#define THUNAR_EXTENSION_PROTOCOL_REQUEST   "(usv)"
+
+/* (serial, result) */
+#define THUNAR_EXTENSION_PROTOCOL_REPLY     "(uv)"
+
+/* snapshot of the selected files: (uri, name, mime type, is directory) */
+#define THUNAR_EXTENSION_PROTOCOL_FILES     "a(sssb)"
+
+/* (id, name, label, tooltip, icon, sensitive, priority, submenu items) */
+#define THUNAR_EXTENSION_PROTOCOL_ITEM      "(ussssbbav)"
+#define THUNAR_EXTENSION_PROTOCOL_ITEMS     "a" THUNAR_EXTENSION_PROTOCOL_ITEM
+
+/* arguments are THUNAR_EXTENSION_PROTOCOL_FILES, the result is THUNAR_EXTENSION_PROTOCOL_ITEMS */
+#define THUNAR_EXTENSION_PROTOCOL_MENU      "menu"
+
+/* arguments are the id ("u") of the item to activate, not answered */
+#define THUNAR_EXTENSION_PROTOCOL_ACTIVATE  "activate"
+
+#endif /* !__THUNAR_EXTENSION_PROTOCOL_H__ */
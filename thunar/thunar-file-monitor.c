@@ -48,11 +48,27 @@ struct _ThunarFileMonitor
   GObject __parent__;
 };
 
+typedef struct
+{
+  ThunarFileMonitorFunc func;
+  gpointer              user_data;
+} ThunarFileMonitorWatch;
+
 
 
 static ThunarFileMonitor *file_monitor_default;
 static guint              file_monitor_signals[LAST_SIGNAL];
 
+/* watches of single files (ThunarFile -> GSList of ThunarFileMonitorWatch)
+ * and of the children of directories (GFile -> GSList of ThunarFileMonitorWatch),
+ * so a change only reaches the ones interested in it. Removed watches are
+ * only cleared while a change is dispatched and dropped afterwards.
+ */
+static GHashTable        *file_monitor_file_watches;
+static GHashTable        *file_monitor_children_watches;
+static guint              file_monitor_dispatching;
+static gboolean           file_monitor_needs_purge;
+
 
 
 G_DEFINE_TYPE (ThunarFileMonitor, thunar_file_monitor, G_TYPE_OBJECT)
@@ -146,21 +162,163 @@ thunar_file_monitor_get_default (void)
 
 
 
+static void
+thunar_file_monitor_watch_add (GHashTable            *watches,
+                               gpointer               key,
+                               ThunarFileMonitorFunc  func,
+                               gpointer               user_data)
+{
+  ThunarFileMonitorWatch *watch;
+  GSList                 *list;
+
+  watch = g_slice_new (ThunarFileMonitorWatch);
+  watch->func = func;
+  watch->user_data = user_data;
+
+  /* added behind the head, so the list in the table stays the same */
+  list = g_hash_table_lookup (watches, key);
+  if (list != NULL)
+    list->next = g_slist_prepend (list->next, watch);
+  else
+    g_hash_table_insert (watches, g_object_ref (key), g_slist_prepend (NULL, watch));
+}
+
+
+
+static void
+thunar_file_monitor_watch_remove (GHashTable            *watches,
+                                  gpointer               key,
+                                  ThunarFileMonitorFunc  func,
+                                  gpointer               user_data)
+{
+  ThunarFileMonitorWatch *watch;
+  GSList                 *list;
+  GSList                 *lp;
+
+  list = g_hash_table_lookup (watches, key);
+  for (lp = list; lp != NULL; lp = lp->next)
+    {
+      watch = lp->data;
+      if (watch->func == func && watch->user_data == user_data)
+        break;
+    }
+
+  _thunar_return_if_fail (lp != NULL);
+
+  if (file_monitor_dispatching > 0)
+    {
+      /* the list may be walked right now */
+      watch->func = NULL;
+      file_monitor_needs_purge = TRUE;
+      return;
+    }
+
+  g_slice_free (ThunarFileMonitorWatch, watch);
+  list = g_slist_delete_link (list, lp);
+  if (list != NULL)
+    g_hash_table_insert (watches, g_object_ref (key), list);
+  else
+    g_hash_table_remove (watches, key);
+}
+
+
+
+static void
+thunar_file_monitor_watch_purge (GHashTable *watches)
+{
+  ThunarFileMonitorWatch *watch;
+  GHashTableIter          iter;
+  gpointer                value;
+  GSList                 *list;
+  GSList                 *lp, *lnext;
+
+  g_hash_table_iter_init (&iter, watches);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      for (list = value, lp = value; lp != NULL; lp = lnext)
+        {
+          lnext = lp->next;
+          watch = lp->data;
+          if (watch->func == NULL)
+            {
+              g_slice_free (ThunarFileMonitorWatch, watch);
+              list = g_slist_delete_link (list, lp);
+            }
+        }
+
+      if (list == NULL)
+        g_hash_table_iter_remove (&iter);
+      else if (list != value)
+        g_hash_table_iter_replace (&iter, list);
+    }
+}
+
+
+
+static void
+thunar_file_monitor_watch_dispatch (GHashTable *watches,
+                                    gpointer    key,
+                                    ThunarFile *file)
+{
+  ThunarFileMonitorWatch *watch;
+  GSList                 *lp;
+
+  for (lp = g_hash_table_lookup (watches, key); lp != NULL; lp = lp->next)
+    {
+      watch = lp->data;
+      if (watch->func != NULL)
+        (*watch->func) (file, watch->user_data);
+    }
+}
+
+
+
 /**
  * thunar_file_monitor_file_changed:
  * @file : a #ThunarFile.
  *
- * Emits the ::file-changed signal on the default
- * #ThunarFileMonitor (if any). This method should
- * only be used by #ThunarFile.
+ * Calls the watches of @file and of the children of its parent
+ * directory, then emits the ::file-changed signal on the default
+ * #ThunarFileMonitor (if any). This method should only be used
+ * by #ThunarFile.
  **/
 void
 thunar_file_monitor_file_changed (ThunarFile *file)
 {
+  GFile *parent;
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
+  g_object_ref (file);
+  file_monitor_dispatching++;
+
+  if (file_monitor_file_watches != NULL)
+    thunar_file_monitor_watch_dispatch (file_monitor_file_watches, file, file);
+
+  if (file_monitor_children_watches != NULL && g_hash_table_size (file_monitor_children_watches) > 0)
+    {
+      parent = g_file_get_parent (thunar_file_get_file (file));
+      if (parent != NULL)
+        {
+          thunar_file_monitor_watch_dispatch (file_monitor_children_watches, parent, file);
+          g_object_unref (parent);
+        }
+    }
+
+  if (--file_monitor_dispatching == 0 && file_monitor_needs_purge)
+    {
+      file_monitor_needs_purge = FALSE;
+      if (file_monitor_file_watches != NULL)
+        thunar_file_monitor_watch_purge (file_monitor_file_watches);
+      if (file_monitor_children_watches != NULL)
+        thunar_file_monitor_watch_purge (file_monitor_children_watches);
+    }
+
+  /* the listeners not tied to particular files */
   if (G_LIKELY (file_monitor_default != NULL))
     g_signal_emit (G_OBJECT (file_monitor_default), file_monitor_signals[FILE_CHANGED], 0, file);
+
+  g_object_unref (file);
 }
 
 
@@ -183,3 +341,95 @@ thunar_file_monitor_file_destroyed (ThunarFile *file)
 }
 
 
+
+/**
+ * thunar_file_monitor_watch_file:
+ * @file      : a #ThunarFile.
+ * @func      : the function called when @file changed.
+ * @user_data : the data passed to @func.
+ *
+ * Calls @func whenever @file changed, until the watch is removed with
+ * thunar_file_monitor_unwatch_file(). Unlike the ::file-changed signal,
+ * which reaches every listener for every file, @func only runs for @file.
+ * The watch keeps a reference on @file.
+ **/
+void
+thunar_file_monitor_watch_file (ThunarFile            *file,
+                                ThunarFileMonitorFunc  func,
+                                gpointer               user_data)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (func != NULL);
+
+  if (G_UNLIKELY (file_monitor_file_watches == NULL))
+    file_monitor_file_watches = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  thunar_file_monitor_watch_add (file_monitor_file_watches, file, func, user_data);
+}
+
+
+
+/**
+ * thunar_file_monitor_unwatch_file:
+ * @file      : a #ThunarFile.
+ * @func      : the function passed to thunar_file_monitor_watch_file().
+ * @user_data : the data passed to thunar_file_monitor_watch_file().
+ *
+ * Removes a watch added with thunar_file_monitor_watch_file().
+ **/
+void
+thunar_file_monitor_unwatch_file (ThunarFile            *file,
+                                  ThunarFileMonitorFunc  func,
+                                  gpointer               user_data)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (file_monitor_file_watches != NULL);
+
+  thunar_file_monitor_watch_remove (file_monitor_file_watches, file, func, user_data);
+}
+
+
+
+/**
+ * thunar_file_monitor_watch_children:
+ * @directory : a #GFile.
+ * @func      : the function called when a child of @directory changed.
+ * @user_data : the data passed to @func.
+ *
+ * Calls @func whenever a #ThunarFile directly inside @directory changed,
+ * until the watch is removed with thunar_file_monitor_unwatch_children().
+ **/
+void
+thunar_file_monitor_watch_children (GFile                 *directory,
+                                    ThunarFileMonitorFunc  func,
+                                    gpointer               user_data)
+{
+  _thunar_return_if_fail (G_IS_FILE (directory));
+  _thunar_return_if_fail (func != NULL);
+
+  if (G_UNLIKELY (file_monitor_children_watches == NULL))
+    file_monitor_children_watches = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+
+  thunar_file_monitor_watch_add (file_monitor_children_watches, directory, func, user_data);
+}
+
+
+
+/**
+ * thunar_file_monitor_unwatch_children:
+ * @directory : a #GFile.
+ * @func      : the function passed to thunar_file_monitor_watch_children().
+ * @user_data : the data passed to thunar_file_monitor_watch_children().
+ *
+ * Removes a watch added with thunar_file_monitor_watch_children().
+ **/
+void
+thunar_file_monitor_unwatch_children (GFile                 *directory,
+                                      ThunarFileMonitorFunc  func,
+                                      gpointer               user_data)
+{
+  _thunar_return_if_fail (G_IS_FILE (directory));
+  _thunar_return_if_fail (file_monitor_children_watches != NULL);
+
+  thunar_file_monitor_watch_remove (file_monitor_children_watches, directory, func, user_data);
+}
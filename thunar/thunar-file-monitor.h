@@ -27,6 +27,17 @@ G_BEGIN_DECLS;
 typedef struct _ThunarFileMonitorClass ThunarFileMonitorClass;
 typedef struct _ThunarFileMonitor      ThunarFileMonitor;
 
+/**
+ * ThunarFileMonitorFunc:
+ * @file      : the #ThunarFile that changed.
+ * @user_data : the data passed when the watch was added.
+ *
+ * Called for the changes of the files a watch was added for, see
+ * thunar_file_monitor_watch_file() and thunar_file_monitor_watch_children().
+ **/
+typedef void (*ThunarFileMonitorFunc) (ThunarFile *file,
+                                       gpointer    user_data);
+
 #define THUNAR_TYPE_FILE_MONITOR            (thunar_file_monitor_get_type ())
 #define THUNAR_FILE_MONITOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_FILE_MONITOR, ThunarFileMonitor))
 #define THUNAR_FILE_MONITOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_FILE_MONITOR, ThunarFileMonitorClass))
@@ -41,6 +52,19 @@ ThunarFileMonitor *thunar_file_monitor_get_default    (void);
 void               thunar_file_monitor_file_changed   (ThunarFile *file);
 void               thunar_file_monitor_file_destroyed (ThunarFile *file);
 
+void               thunar_file_monitor_watch_file       (ThunarFile            *file,
+                                                         ThunarFileMonitorFunc  func,
+                                                         gpointer               user_data);
+void               thunar_file_monitor_unwatch_file     (ThunarFile            *file,
+                                                         ThunarFileMonitorFunc  func,
+                                                         gpointer               user_data);
+void               thunar_file_monitor_watch_children   (GFile                 *directory,
+                                                         ThunarFileMonitorFunc  func,
+                                                         gpointer               user_data);
+void               thunar_file_monitor_unwatch_children (GFile                 *directory,
+                                                         ThunarFileMonitorFunc  func,
+                                                         gpointer               user_data);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_FILE_MONITOR_H__ */
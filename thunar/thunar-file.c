@@ -65,6 +65,7 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-io-jobs.h>
+#include <thunar/thunar-metadata-writer.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-user.h>
@@ -100,6 +101,8 @@ static gboolean           thunar_file_info_is_directory        (ThunarxFileInfo
 static GFileInfo         *thunar_file_info_get_file_info       (ThunarxFileInfo        *file_info);
 static GFileInfo         *thunar_file_info_get_filesystem_info (ThunarxFileInfo        *file_info);
 static GFile             *thunar_file_info_get_location        (ThunarxFileInfo        *file_info);
+static const gchar       *thunar_file_info_peek_name           (ThunarxFileInfo        *file_info);
+static const gchar       *thunar_file_info_peek_mime_type      (ThunarxFileInfo        *file_info);
 static void               thunar_file_info_changed             (ThunarxFileInfo        *file_info);
 static gboolean           thunar_file_denies_access_permission (const ThunarFile       *file,
                                                                 ThunarFileMode          usr_permissions,
@@ -120,19 +123,31 @@ static gboolean           thunar_file_same_filesystem          (const ThunarFile
 
 
 
-static GRecMutex G_LOCK_NAME (file_cache_mutex);
-G_LOCK_DEFINE_STATIC         (file_content_type_mutex);
-G_LOCK_DEFINE_STATIC         (file_rename_mutex);
+/* bit of ThunarFile:rename_lock, see g_bit_lock() */
+#define THUNAR_FILE_RENAME_LOCK_BIT 0
 
 
 
-#define G_REC_LOCK(name)   g_rec_mutex_lock   (&G_LOCK_NAME (name))
-#define G_REC_UNLOCK(name) g_rec_mutex_unlock (&G_LOCK_NAME (name))
+/* number of independently locked parts of the file cache */
+#define THUNAR_FILE_CACHE_N_SHARDS 16
+
+/* maximum number of folders counted by a single count job */
+#define THUNAR_FILE_COUNT_BATCH_SIZE 32
+
+/* maximum number of files reloaded by a single reload job */
+#define THUNAR_FILE_RELOAD_BATCH_SIZE 128
+
+/* share of the inotify watches of the user which is used for watched
+ * files, the rest is left for folders and other applications */
+#define THUNAR_FILE_WATCH_BUDGET_SHARE (4)
+#define THUNAR_FILE_WATCH_BUDGET_MIN   (64)
+
+/* interval in seconds in which watched files beyond the budget are reloaded */
+#define THUNAR_FILE_WATCH_POLL_INTERVAL (5)
 
 
 
 static ThunarUserManager *user_manager;
-static GHashTable        *file_cache;
 static guint32            effective_user_id;
 static GQuark             thunar_file_watch_quark;
 static guint              file_signals[LAST_SIGNAL];
@@ -154,9 +169,32 @@ typedef enum
   THUNAR_FILE_FLAG_THUMB_MASK     = 0x03,   /* storage for ThunarFileThumbState */
   THUNAR_FILE_FLAG_IN_DESTRUCTION = 1 << 2, /* for avoiding recursion during destroy */
   THUNAR_FILE_FLAG_IS_MOUNTED     = 1 << 3, /* whether this file is mounted */
+  THUNAR_FILE_FLAG_PARTIAL_INFO   = 1 << 4, /* whether the info only holds the fast attributes */
+  THUNAR_FILE_FLAG_DIR_SETTINGS   = 1 << 5, /* whether the info holds directory specific settings */
 }
 ThunarFileFlags;
 
+
+
+/* the metadata attributes of the settings, so they are not formatted for
+ * every lookup. The first ones are the directory specific settings */
+#define THUNAR_FILE_N_DIRECTORY_SETTINGS (4)
+
+static const struct
+{
+  const gchar *setting_name;
+  const gchar *attr_name;
+}
+thunar_file_metadata_attrs[] =
+{
+  { "view-type",                  "metadata::thunar-view-type" },
+  { "sort-column",                "metadata::thunar-sort-column" },
+  { "sort-order",                 "metadata::thunar-sort-order" },
+  { "zoom-level",                 "metadata::thunar-zoom-level" },
+  { "highlight-color-background", "metadata::thunar-highlight-color-background" },
+  { "highlight-color-foreground", "metadata::thunar-highlight-color-foreground" },
+};
+
 struct _ThunarFileClass
 {
   GObjectClass __parent__;
@@ -172,10 +210,16 @@ struct _ThunarFile
   /* storage for the file information */
   GFileInfo            *info;
   GFileInfo            *recent_info;
-  GFileType             kind;
   GFile                *gfile;
-  gchar                *content_type;
-  gchar                *icon_name;
+
+  /* the info of the latest listing of the parent folder, if the file was
+   * cached already, protected by the file cache lock of the file */
+  GFileInfo            *listed_info;
+  gboolean              listed_info_partial;
+
+  /* interned strings, shared by all files of the same type */
+  const gchar          *content_type;
+  const gchar          *icon_name;
 
   gchar                *custom_icon_name;
   gchar                *display_name;
@@ -187,6 +231,31 @@ struct _ThunarFile
   gchar                *collate_key;
   gchar                *collate_key_nocase;
 
+  /* single block holding the display name, the basename and the
+   * collation keys above, see thunar_file_pack_strings() */
+  gchar                *strings;
+
+  /* the first bytes of the collation keys, packed so that comparing
+   * them gives the same order as strcmp() on the keys */
+  guint64               collate_prefix;
+  guint64               collate_prefix_nocase;
+
+  /* the display name normalized for searching, created on demand */
+  gchar                *search_name;
+
+  /* the uri of the file and the length of the uri of its parent, created
+   * on demand for thunar_file_compare_by_type() */
+  gchar                *uri;
+  gsize                 uri_length;
+  gsize                 uri_parent_length;
+
+  /* attributes copied from the info, they are read very often
+   * while sorting and rendering the views */
+  guint64               size;
+  guint64               date_modified;
+  ThunarFileMode        mode;
+  GFileType             kind;
+
   /* flags for thumbnail state etc */
   ThunarFileFlags       flags;
 
@@ -199,15 +268,45 @@ struct _ThunarFile
   guint                 file_count;
   guint64               file_count_timestamp;
 
+  /* serializes renames of this file with its monitor events, a per file
+   * lock so a stalled rename does not block any other file */
+  gint                  rename_lock;
 };
 
+typedef enum
+{
+  THUNAR_FILE_WATCH_MONITOR, /* has its own file monitor */
+  THUNAR_FILE_WATCH_SHARED,  /* relies on the monitor of the parent folder */
+  THUNAR_FILE_WATCH_POLLED,  /* reloaded periodically */
+}
+ThunarFileWatchMode;
+
 typedef struct
 {
-  GFileMonitor  *monitor;
-  guint          watch_count;
+  ThunarFile         *file;
+  GFileMonitor       *monitor;
+  guint               watch_count;
+  ThunarFileWatchMode mode;
+
+  /* link in file_watch_monitored or file_watch_degraded, data is
+   * %NULL while the watch is in neither queue */
+  GList               link;
 }
 ThunarFileWatch;
 
+/* watched files with a monitor and those beyond the watch budget, both
+ * most recently watched first, main thread only */
+static GQueue     file_watch_monitored = G_QUEUE_INIT;
+static GQueue     file_watch_degraded = G_QUEUE_INIT;
+static guint      file_watch_n_polled = 0;
+static guint      file_watch_budget = 0;
+static guint      file_watch_poll_id = 0;
+
+/* directories monitored by a ThunarFolder, mapped to the number of
+ * monitors, and the files reloaded by the poll timer */
+static GHashTable *file_watch_directories = NULL;
+static GHashTable *file_watch_poll_pending = NULL;
+
 typedef struct
 {
   ThunarFileGetFunc  func;
@@ -216,6 +315,82 @@ typedef struct
 }
 ThunarFileGetData;
 
+typedef struct
+{
+  GRecMutex   mutex;
+  GHashTable *table;
+}
+ThunarFileCacheShard;
+
+/* the file cache is split by the hash of the GFile, so threads looking
+ * up different files rarely have to wait for each other */
+static ThunarFileCacheShard file_cache[THUNAR_FILE_CACHE_N_SHARDS];
+
+typedef struct
+{
+  ThunarFileCountFunc func;
+  GWeakRef            user_data;
+}
+ThunarFileCountWaiter;
+
+typedef struct
+{
+  GFile     *parent;
+  GQueue     pending;
+  GList     *running;
+  guint     *counts;
+  guint64    started;
+  ThunarJob *job;
+}
+ThunarFileCountGroup;
+
+/* folders waiting for their item count, mapped to their waiters, and
+ * the count groups of their parent folders, both main thread only */
+static GHashTable *file_count_waiters = NULL;
+static GHashTable *file_count_groups = NULL;
+
+typedef struct
+{
+  GList      *files;
+  GFileInfo **infos;
+  GError    **errors;
+  ThunarJob  *job;
+}
+ThunarFileReloadBatch;
+
+/* files waiting for a background reload and the running reload, main thread only */
+static GHashTable            *reload_queue = NULL;
+static guint                  reload_queue_id = 0;
+static ThunarFileReloadBatch *reload_batch = NULL;
+
+typedef struct
+{
+  guint64  date_modified;
+  guint64  size;
+  gchar   *icon_name;
+}
+ThunarFileDesktopEntry;
+
+/* custom icons parsed from .desktop files, mapped from their GFile, so
+ * reloads and reopened folders don't read unchanged key files again */
+#define THUNAR_FILE_DESKTOP_ENTRIES_MAX (4096)
+static GHashTable *desktop_entries = NULL;
+static GMutex      desktop_entries_mutex;
+
+typedef struct
+{
+  gchar   *description;
+  guint64  prefix;
+  guint64  prefix_nocase;
+}
+ThunarFileTypeDescription;
+
+/* the descriptions of the content types, interned for the whole process
+ * so the type column and sorting by type don't ask shared-mime-info for
+ * every file again, mapped from the interned content type */
+static GHashTable *type_descriptions = NULL;
+static GMutex      type_descriptions_mutex;
+
 static struct
 {
   GUserDirectory  type;
@@ -256,6 +431,64 @@ weak_ref_free (GWeakRef *ref)
 }
 
 
+
+/* locks the shard of the file cache responsible for @gfile, the
+ * lock is recursive, so thunar_file_cache_lookup() may be used while
+ * holding it */
+static ThunarFileCacheShard *
+thunar_file_cache_lock (const GFile *gfile)
+{
+  ThunarFileCacheShard *shard;
+
+  shard = &file_cache[g_file_hash (gfile) % THUNAR_FILE_CACHE_N_SHARDS];
+
+  g_rec_mutex_lock (&shard->mutex);
+
+  /* allocate the table on-demand */
+  if (G_UNLIKELY (shard->table == NULL))
+    {
+      shard->table = g_hash_table_new_full (g_file_hash,
+                                            (GEqualFunc) g_file_equal,
+                                            (GDestroyNotify) g_object_unref,
+                                            (GDestroyNotify) weak_ref_free);
+    }
+
+  return shard;
+}
+
+
+
+static inline void
+thunar_file_cache_unlock (ThunarFileCacheShard *shard)
+{
+  g_rec_mutex_unlock (&shard->mutex);
+}
+
+
+
+/* the shard must be locked and belong to the location of @file */
+static inline void
+thunar_file_cache_insert (ThunarFileCacheShard *shard,
+                          ThunarFile           *file)
+{
+  g_hash_table_insert (shard->table,
+                       g_object_ref (file->gfile),
+                       weak_ref_new (G_OBJECT (file)));
+}
+
+
+
+static inline void
+thunar_file_cache_remove (const GFile *gfile)
+{
+  ThunarFileCacheShard *shard;
+
+  shard = thunar_file_cache_lock (gfile);
+  g_hash_table_remove (shard->table, gfile);
+  thunar_file_cache_unlock (shard);
+}
+
+
 #ifdef G_ENABLE_DEBUG
 #ifdef HAVE_ATEXIT
 static gboolean thunar_file_atexit_registered = FALSE;
@@ -281,22 +514,29 @@ thunar_file_atexit_foreach (gpointer key,
 static void
 thunar_file_atexit (void)
 {
-  G_REC_LOCK (file_cache_mutex);
+  guint n_leaked = 0;
+  guint n;
 
-  if (file_cache == NULL || g_hash_table_size (file_cache) == 0)
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
     {
-      G_REC_UNLOCK (file_cache_mutex);
-      return;
+      g_rec_mutex_lock (&file_cache[n].mutex);
+      if (file_cache[n].table != NULL)
+        n_leaked += g_hash_table_size (file_cache[n].table);
     }
 
-  g_print ("--- Leaked a total of %u ThunarFile objects:\n",
-           g_hash_table_size (file_cache));
+  if (n_leaked > 0)
+    {
+      g_print ("--- Leaked a total of %u ThunarFile objects:\n", n_leaked);
 
-  g_hash_table_foreach (file_cache, thunar_file_atexit_foreach, NULL);
+      for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+        if (file_cache[n].table != NULL)
+          g_hash_table_foreach (file_cache[n].table, thunar_file_atexit_foreach, NULL);
 
-  g_print ("\n");
+      g_print ("\n");
+    }
 
-  G_REC_UNLOCK (file_cache_mutex);
+  for (n = THUNAR_FILE_CACHE_N_SHARDS; n > 0; --n)
+    g_rec_mutex_unlock (&file_cache[n - 1].mutex);
 }
 #endif
 #endif
@@ -321,19 +561,26 @@ thunar_file_cache_dump_foreach (gpointer gfile,
 static gboolean
 thunar_file_cache_dump (gpointer user_data)
 {
-  G_REC_LOCK (file_cache_mutex);
+  guint n_files = 0;
+  guint n;
 
-  if (file_cache != NULL)
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
     {
-      g_print ("--- %d ThunarFile objects in cache:\n",
-               g_hash_table_size (file_cache));
+      g_rec_mutex_lock (&file_cache[n].mutex);
+      if (file_cache[n].table != NULL)
+        n_files += g_hash_table_size (file_cache[n].table);
+    }
 
-      g_hash_table_foreach (file_cache, thunar_file_cache_dump_foreach, NULL);
+  g_print ("--- %u ThunarFile objects in cache:\n", n_files);
 
-      g_print ("\n");
-    }
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    if (file_cache[n].table != NULL)
+      g_hash_table_foreach (file_cache[n].table, thunar_file_cache_dump_foreach, NULL);
+
+  g_print ("\n");
 
-  G_REC_UNLOCK (file_cache_mutex);
+  for (n = THUNAR_FILE_CACHE_N_SHARDS; n > 0; --n)
+    g_rec_mutex_unlock (&file_cache[n - 1].mutex);
 
   return TRUE;
 }
@@ -414,6 +661,8 @@ thunar_file_info_init (ThunarxFileInfoIface *iface)
   iface->get_file_info = thunar_file_info_get_file_info;
   iface->get_filesystem_info = thunar_file_info_get_filesystem_info;
   iface->get_location = thunar_file_info_get_location;
+  iface->peek_name = thunar_file_info_peek_name;
+  iface->peek_mime_type = thunar_file_info_peek_mime_type;
   iface->changed = thunar_file_info_changed;
 }
 
@@ -441,7 +690,9 @@ thunar_file_dispose (GObject *object)
 static void
 thunar_file_finalize (GObject *object)
 {
-  ThunarFile *file = THUNAR_FILE (object);
+  ThunarFile           *file = THUNAR_FILE (object);
+  ThunarFile           *other;
+  ThunarFileCacheShard *shard;
 
   /* verify that nobody's watching the file anymore */
 #ifdef G_ENABLE_DEBUG
@@ -453,10 +704,16 @@ thunar_file_finalize (GObject *object)
     }
 #endif
 
-  /* drop the entry from the cache */
-  G_REC_LOCK (file_cache_mutex);
-  g_hash_table_remove (file_cache, file->gfile);
-  G_REC_UNLOCK (file_cache_mutex);
+  /* drop the entry from the cache, unless it belongs to another
+   * instance for the same location (our own weak ref is cleared) */
+  shard = thunar_file_cache_lock (file->gfile);
+  other = thunar_file_cache_lookup (file->gfile);
+  if (G_LIKELY (other == NULL))
+    g_hash_table_remove (shard->table, file->gfile);
+  thunar_file_cache_unlock (shard);
+
+  if (G_UNLIKELY (other != NULL))
+    g_object_unref (other);
 
   /* release file info */
   if (file->info != NULL)
@@ -466,21 +723,16 @@ thunar_file_finalize (GObject *object)
   if (file->recent_info != NULL)
     g_object_unref (file->recent_info);
 
+  if (file->listed_info != NULL)
+    g_object_unref (file->listed_info);
+
   /* free the custom icon name */
   g_free (file->custom_icon_name);
 
-  /* content type info */
-  g_free (file->content_type);
-  g_free (file->icon_name);
-
-  /* free display name and basename */
-  g_free (file->display_name);
-  g_free (file->basename);
-
-  /* free collate keys */
-  if (file->collate_key_nocase != file->collate_key)
-    g_free (file->collate_key_nocase);
-  g_free (file->collate_key);
+  /* free display name, basename and collate keys */
+  g_free (file->strings);
+  g_free (file->search_name);
+  g_free (file->uri);
 
   /* free the thumbnail path */
   g_free (file->thumbnail_path);
@@ -597,6 +849,22 @@ thunar_file_info_get_location (ThunarxFileInfo *file_info)
 
 
 
+static const gchar *
+thunar_file_info_peek_name (ThunarxFileInfo *file_info)
+{
+  return thunar_file_get_basename (THUNAR_FILE (file_info));
+}
+
+
+
+static const gchar *
+thunar_file_info_peek_mime_type (ThunarxFileInfo *file_info)
+{
+  return thunar_file_get_content_type (THUNAR_FILE (file_info));
+}
+
+
+
 static void
 thunar_file_info_changed (ThunarxFileInfo *file_info)
 {
@@ -701,9 +969,12 @@ thunar_file_monitor_update (GFile             *path,
     {
       switch (event_type)
         {
-        case G_FILE_MONITOR_EVENT_CREATED:
         case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
         case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+          thunar_file_reload_queue (file);
+          break;
+
+        case G_FILE_MONITOR_EVENT_CREATED:
         case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
         case G_FILE_MONITOR_EVENT_DELETED:
           thunar_file_reload (file);
@@ -743,7 +1014,8 @@ static void
 thunar_file_monitor_moved (ThunarFile *file,
                            GFile      *renamed_file)
 {
-  GFile *previous_file;
+  ThunarFileCacheShard *shard;
+  GFile                *previous_file;
 
   /* ref the old location */
   previous_file = G_FILE (g_object_ref (G_OBJECT (file->gfile)));
@@ -753,6 +1025,8 @@ thunar_file_monitor_moved (ThunarFile *file,
 
   /* set the new file */
   file->gfile = G_FILE (g_object_ref (G_OBJECT (renamed_file)));
+  g_free (file->uri);
+  file->uri = NULL;
 
   /* reload file information */
   thunar_file_load (file, NULL, NULL);
@@ -760,20 +1034,16 @@ thunar_file_monitor_moved (ThunarFile *file,
   /* need to re-register the monitor handle for the new uri */
   thunar_file_watch_reconnect (file);
 
-  G_REC_LOCK (file_cache_mutex);
-
   /* drop the previous entry from the cache */
-  g_hash_table_remove (file_cache, previous_file);
+  thunar_file_cache_remove (previous_file);
 
   /* drop the reference on the previous file */
   g_object_unref (previous_file);
 
   /* insert the new entry */
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-
-  G_REC_UNLOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (file->gfile);
+  thunar_file_cache_insert (shard, file);
+  thunar_file_cache_unlock (shard);
 }
 
 
@@ -826,9 +1096,9 @@ thunar_file_monitor (GFileMonitor     *monitor,
           event_type == G_FILE_MONITOR_EVENT_MOVED_IN ||
           event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
         {
-          G_LOCK (file_rename_mutex);
+          g_bit_lock (&file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
           thunar_file_monitor_moved (file, other_path);
-          G_UNLOCK (file_rename_mutex);
+          g_bit_unlock (&file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
           return;
         }
 
@@ -848,13 +1118,17 @@ thunar_file_monitor (GFileMonitor     *monitor,
           if (other_path == NULL)
             return;
 
-          G_LOCK (file_rename_mutex);
-
           other_file = thunar_file_cache_lookup (other_path);
           if (other_file)
+            {
+              g_bit_lock (&other_file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
               reload_ok = thunar_file_reload (other_file);
+              g_bit_unlock (&other_file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
+            }
           else
+            {
               other_file = thunar_file_get (other_path, NULL);
+            }
 
           if (reload_ok && other_file != NULL)
             {
@@ -866,221 +1140,952 @@ thunar_file_monitor (GFileMonitor     *monitor,
 
               g_object_unref (other_file);
             }
-
-          G_UNLOCK (file_rename_mutex);
         }
       return;
     }
 }
 
 
-static void
-thunar_file_watch_destroyed (gpointer data)
+static guint
+thunar_file_watch_get_budget (void)
 {
-  ThunarFileWatch *file_watch = data;
+  ThunarPreferences *preferences;
+  gchar             *contents;
+  guint64            max_user_watches;
 
-  if (G_LIKELY (file_watch->monitor != NULL))
+  if (G_LIKELY (file_watch_budget != 0))
+    return file_watch_budget;
+
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-file-watch-budget", &file_watch_budget, NULL);
+  g_object_unref (preferences);
+
+  if (file_watch_budget == 0)
     {
-      g_file_monitor_cancel (file_watch->monitor);
-      g_object_unref (file_watch->monitor);
+      /* without an inotify limit, e.g. on other platforms, every file gets a monitor */
+      file_watch_budget = G_MAXUINT;
+      if (g_file_get_contents ("/proc/sys/fs/inotify/max_user_watches", &contents, NULL, NULL))
+        {
+          max_user_watches = g_ascii_strtoull (contents, NULL, 10);
+          if (max_user_watches > 0)
+            file_watch_budget = (guint) MAX (MIN (max_user_watches / THUNAR_FILE_WATCH_BUDGET_SHARE, G_MAXUINT), THUNAR_FILE_WATCH_BUDGET_MIN);
+          g_free (contents);
+        }
     }
 
-  g_slice_free (ThunarFileWatch, file_watch);
+  return file_watch_budget;
 }
 
 
 
-static void
-thunar_file_watch_reconnect (ThunarFile *file)
+static gboolean
+thunar_file_watch_poll (gpointer user_data)
 {
   ThunarFileWatch *file_watch;
+  GList           *lp;
 
-  /* recreate the monitor without changing the watch_count for file renames */
-  file_watch = g_object_get_qdata (G_OBJECT (file), thunar_file_watch_quark);
-  if (file_watch != NULL)
+  if (file_watch_n_polled == 0)
     {
-      /* reset the old monitor */
-      if (G_LIKELY (file_watch->monitor != NULL))
-        {
-          g_file_monitor_cancel (file_watch->monitor);
-          g_object_unref (file_watch->monitor);
-        }
+      file_watch_poll_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  if (G_UNLIKELY (file_watch_poll_pending == NULL))
+    file_watch_poll_pending = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-      /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS | G_FILE_MONITOR_SEND_MOVED, NULL, NULL);
-      if (G_LIKELY (file_watch->monitor != NULL))
+  /* reload the polled files in the background, unchanged files are not
+   * announced, see thunar_file_reload_batch_finished() */
+  for (lp = file_watch_degraded.head; lp != NULL; lp = lp->next)
+    {
+      file_watch = lp->data;
+      if (file_watch->mode == THUNAR_FILE_WATCH_POLLED
+          && !g_hash_table_contains (file_watch_poll_pending, file_watch->file))
         {
-          /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
+          thunar_file_reload_queue (file_watch->file);
+          g_hash_table_add (file_watch_poll_pending, file_watch->file);
         }
     }
+
+  return G_SOURCE_CONTINUE;
 }
 
 
 
 static void
-thunar_file_set_emblem_names_ready (GObject      *source_object,
-                                    GAsyncResult *result,
-                                    gpointer      user_data)
+thunar_file_watch_set_degraded_mode (ThunarFileWatch    *file_watch,
+                                     ThunarFileWatchMode mode)
 {
-  ThunarFile *file = THUNAR_FILE (user_data);
-  GError     *error = NULL;
+  _thunar_return_if_fail (mode != THUNAR_FILE_WATCH_MONITOR);
 
-  if (!g_file_set_attributes_finish (G_FILE (source_object), result, NULL, &error))
-    {
-      g_warning ("Failed to set metadata: %s", error->message);
-      g_error_free (error);
+  if (file_watch->mode == THUNAR_FILE_WATCH_POLLED)
+    file_watch_n_polled--;
 
-      g_file_info_remove_attribute (file->info, "metadata::emblems");
-    }
+  file_watch->mode = mode;
 
-  thunar_file_changed (file);
+  if (mode == THUNAR_FILE_WATCH_POLLED)
+    {
+      file_watch_n_polled++;
+      if (file_watch_poll_id == 0)
+        file_watch_poll_id = g_timeout_add_seconds (THUNAR_FILE_WATCH_POLL_INTERVAL, thunar_file_watch_poll, NULL);
+    }
 }
 
 
 
-static void
-thunar_file_info_clear (ThunarFile *file)
+static ThunarFileWatchMode
+thunar_file_watch_get_degraded_mode (ThunarFileWatch *file_watch)
 {
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  GHashTableIter iter;
+  GFile         *directory;
 
-  /* release the current file info */
-  if (file->info != NULL)
+  /* the directory monitor of a folder open on the parent also reports
+   * changes of the file, so it does not need to be polled */
+  if (file_watch_directories != NULL)
     {
-      g_object_unref (file->info);
-      file->info = NULL;
+      g_hash_table_iter_init (&iter, file_watch_directories);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &directory, NULL))
+        if (g_file_has_parent (file_watch->file->gfile, directory))
+          return THUNAR_FILE_WATCH_SHARED;
     }
 
-  /* unset */
-  file->kind = G_FILE_TYPE_UNKNOWN;
+  return THUNAR_FILE_WATCH_POLLED;
+}
 
-  /* free the custom icon name */
-  g_free (file->custom_icon_name);
-  file->custom_icon_name = NULL;
 
-  /* free display name and basename */
-  g_free (file->display_name);
-  file->display_name = NULL;
 
-  g_free (file->basename);
-  file->basename = NULL;
+static gboolean
+thunar_file_watch_connect (ThunarFileWatch *file_watch,
+                           GError         **error)
+{
+  _thunar_return_val_if_fail (file_watch->monitor == NULL, FALSE);
 
-  /* content type */
-  g_free (file->content_type);
-  file->content_type = NULL;
-  g_free (file->icon_name);
-  file->icon_name = NULL;
+  /* create a file or directory monitor */
+  file_watch->monitor = g_file_monitor (file_watch->file->gfile, G_FILE_MONITOR_WATCH_MOUNTS |
+                                        G_FILE_MONITOR_WATCH_MOVES, NULL, error);
+  if (G_UNLIKELY (file_watch->monitor == NULL))
+    return FALSE;
 
-  /* device type */
-  file->device_type = NULL;
+  /* watch monitor for file changes */
+  g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file_watch->file);
 
-  /* free collate keys */
-  if (file->collate_key_nocase != file->collate_key)
-    g_free (file->collate_key_nocase);
-  file->collate_key_nocase = NULL;
+  return TRUE;
+}
 
-  g_free (file->collate_key);
-  file->collate_key = NULL;
 
-  /* free thumbnail path */
-  g_free (file->thumbnail_path);
-  file->thumbnail_path = NULL;
 
-  /* assume the file is mounted by default */
-  FLAG_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+static void
+thunar_file_watch_disconnect (ThunarFileWatch *file_watch)
+{
+  if (G_LIKELY (file_watch->monitor != NULL))
+    {
+      g_signal_handlers_disconnect_by_data (file_watch->monitor, file_watch->file);
+      g_file_monitor_cancel (file_watch->monitor);
+      g_object_unref (file_watch->monitor);
+      file_watch->monitor = NULL;
+    }
+}
 
-  /* set thumb state to unknown */
-  FLAG_SET_THUMB_STATE (file, THUNAR_FILE_THUMB_STATE_UNKNOWN);
+
+
+static void
+thunar_file_watch_unlink (ThunarFileWatch *file_watch)
+{
+  if (file_watch->link.data == NULL)
+    return;
+
+  if (file_watch->mode == THUNAR_FILE_WATCH_MONITOR)
+    g_queue_unlink (&file_watch_monitored, &file_watch->link);
+  else
+    g_queue_unlink (&file_watch_degraded, &file_watch->link);
+
+  file_watch->link.data = NULL;
 }
 
 
 
 static void
-thunar_file_info_reload (ThunarFile   *file,
-                         GCancellable *cancellable)
+thunar_file_watch_demote (ThunarFileWatch *file_watch)
 {
-  const gchar *target_uri;
-  GKeyFile    *key_file;
-  gchar       *p;
-  const gchar *display_name;
-  gchar       *casefold;
-  gchar       *path;
+  _thunar_return_if_fail (file_watch->mode == THUNAR_FILE_WATCH_MONITOR);
 
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
-  _thunar_return_if_fail (file->info == NULL || G_IS_FILE_INFO (file->info));
+  /* release the monitor and its inotify watch */
+  thunar_file_watch_unlink (file_watch);
+  thunar_file_watch_disconnect (file_watch);
 
-  if (G_LIKELY (file->info != NULL))
-    {
-      /* this is requested so often, cache it */
-      file->kind = g_file_info_get_file_type (file->info);
+  thunar_file_watch_set_degraded_mode (file_watch, thunar_file_watch_get_degraded_mode (file_watch));
+  file_watch->link.data = file_watch;
+  g_queue_push_head_link (&file_watch_degraded, &file_watch->link);
+}
 
-      if (file->kind == G_FILE_TYPE_MOUNTABLE)
-        {
-          target_uri = g_file_info_get_attribute_string (file->info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
-          if (target_uri != NULL
-              && !g_file_info_get_attribute_boolean (file->info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT))
-            FLAG_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-          else
-             FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-        }
-    }
 
-  /* determine the basename */
-  file->basename = g_file_get_basename (file->gfile);
-  _thunar_assert (file->basename != NULL);
 
-  /* problematic files with content type reading */
-  if (g_strcmp0 (file->basename, "kmsg") == 0
-      && g_file_is_native (file->gfile))
-    {
-      path = g_file_get_path (file->gfile);
-      if (g_strcmp0 (path, "/proc/kmsg") == 0)
-        file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
-      g_free (path);
-    }
+static gboolean
+thunar_file_watch_promote (ThunarFileWatch *file_watch)
+{
+  _thunar_return_val_if_fail (file_watch->mode != THUNAR_FILE_WATCH_MONITOR, FALSE);
 
-  /* check if this file is a desktop entry and we have the permission to execute it */
-  if (thunar_file_is_desktop_file (file) && thunar_file_can_execute (file))
-    {
-      /* determine the custom icon and display name for .desktop files */
+  if (!thunar_file_watch_connect (file_watch, NULL))
+    return FALSE;
 
-      /* query a key file for the .desktop file */
-      key_file = thunar_g_file_query_key_file (file->gfile, cancellable, NULL);
-      if (key_file != NULL)
-        {
-          /* read the icon name from the .desktop file */
-          file->custom_icon_name = g_key_file_get_string (key_file,
-                                                          G_KEY_FILE_DESKTOP_GROUP,
-                                                          G_KEY_FILE_DESKTOP_KEY_ICON,
-                                                          NULL);
+  thunar_file_watch_unlink (file_watch);
+  if (file_watch->mode == THUNAR_FILE_WATCH_POLLED)
+    file_watch_n_polled--;
 
-          if (G_UNLIKELY (xfce_str_is_empty (file->custom_icon_name)))
-            {
-              /* make sure we set null if the string is empty else the assertion in
-               * thunar_icon_factory_lookup_icon() will fail */
-              g_free (file->custom_icon_name);
-              file->custom_icon_name = NULL;
-            }
-          else
-            {
-              /* drop freedesktop.org supported suffixes from themed icons, if any */
-              if (!g_path_is_absolute (file->custom_icon_name))
-                {
-                  p = strrchr (file->custom_icon_name, '.');
-                  if(g_strcmp0(p, ".png") == 0 || g_strcmp0(p, ".xpm") == 0 || g_strcmp0(p, ".svg") == 0)
-                    *p = '\0';
-                }
-            }
-          /* free the key file */
-          g_key_file_free (key_file);
-        }
-    }
+  file_watch->mode = THUNAR_FILE_WATCH_MONITOR;
+  file_watch->link.data = file_watch;
+  g_queue_push_head_link (&file_watch_monitored, &file_watch->link);
 
-  /* determine the display name */
-  if (file->display_name == NULL)
-    {
-      if (G_UNLIKELY (thunar_file_is_trash (file)))
-        file->display_name = g_strdup (_("Trash"));
+  return TRUE;
+}
+
+
+
+static void
+thunar_file_watch_balance (void)
+{
+  guint budget = thunar_file_watch_get_budget ();
+
+  /* degrade the least recently watched files beyond the budget */
+  while (file_watch_monitored.length > budget)
+    thunar_file_watch_demote (file_watch_monitored.tail->data);
+
+  /* and give free monitors to the most recently watched degraded files */
+  while (file_watch_monitored.length < budget && file_watch_degraded.head != NULL)
+    if (!thunar_file_watch_promote (file_watch_degraded.head->data))
+      break;
+}
+
+
+
+static void
+thunar_file_watch_destroyed (gpointer data)
+{
+  ThunarFileWatch *file_watch = data;
+  gboolean         monitored = (file_watch->mode == THUNAR_FILE_WATCH_MONITOR && file_watch->link.data != NULL);
+
+  thunar_file_watch_unlink (file_watch);
+  thunar_file_watch_disconnect (file_watch);
+
+  if (file_watch->mode == THUNAR_FILE_WATCH_POLLED)
+    file_watch_n_polled--;
+
+  g_slice_free (ThunarFileWatch, file_watch);
+
+  /* the monitor can go to a degraded file */
+  if (monitored)
+    thunar_file_watch_balance ();
+}
+
+
+
+static void
+thunar_file_watch_reconnect (ThunarFile *file)
+{
+  ThunarFileWatch *file_watch;
+
+  /* recreate the monitor without changing the watch_count for file renames */
+  file_watch = g_object_get_qdata (G_OBJECT (file), thunar_file_watch_quark);
+  if (file_watch != NULL && file_watch->link.data != NULL)
+    {
+      if (file_watch->mode == THUNAR_FILE_WATCH_MONITOR)
+        {
+          /* reset the old monitor */
+          thunar_file_watch_disconnect (file_watch);
+          if (!thunar_file_watch_connect (file_watch, NULL))
+            {
+              /* poll the file from now on */
+              thunar_file_watch_unlink (file_watch);
+              thunar_file_watch_set_degraded_mode (file_watch, THUNAR_FILE_WATCH_POLLED);
+              file_watch->link.data = file_watch;
+              g_queue_push_head_link (&file_watch_degraded, &file_watch->link);
+            }
+        }
+      else
+        {
+          /* the file may have moved to another parent folder */
+          thunar_file_watch_set_degraded_mode (file_watch, thunar_file_watch_get_degraded_mode (file_watch));
+        }
+    }
+}
+
+
+
+/**
+ * thunar_file_watch_add_directory_monitor:
+ * @directory : the #GFile of a directory.
+ *
+ * Tells the watch budget that a #ThunarFolder monitors @directory,
+ * so watched files inside @directory, which are beyond the budget,
+ * rely on that monitor instead of being polled.
+ **/
+void
+thunar_file_watch_add_directory_monitor (GFile *directory)
+{
+  ThunarFileWatch *file_watch;
+  GList           *lp;
+  guint            n_monitors;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+
+  if (G_UNLIKELY (file_watch_directories == NULL))
+    file_watch_directories = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+
+  n_monitors = GPOINTER_TO_UINT (g_hash_table_lookup (file_watch_directories, directory));
+  g_hash_table_insert (file_watch_directories, g_object_ref (directory), GUINT_TO_POINTER (n_monitors + 1));
+  if (n_monitors > 0)
+    return;
+
+  for (lp = file_watch_degraded.head; lp != NULL; lp = lp->next)
+    {
+      file_watch = lp->data;
+      if (file_watch->mode == THUNAR_FILE_WATCH_POLLED
+          && g_file_has_parent (file_watch->file->gfile, directory))
+        thunar_file_watch_set_degraded_mode (file_watch, THUNAR_FILE_WATCH_SHARED);
+    }
+}
+
+
+
+/**
+ * thunar_file_watch_remove_directory_monitor:
+ * @directory : the #GFile of a directory.
+ *
+ * Counterpart of thunar_file_watch_add_directory_monitor(), watched
+ * files which relied on the monitor of @directory are polled again.
+ **/
+void
+thunar_file_watch_remove_directory_monitor (GFile *directory)
+{
+  ThunarFileWatch *file_watch;
+  GList           *lp;
+  guint            n_monitors;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+
+  if (G_UNLIKELY (file_watch_directories == NULL))
+    return;
+
+  n_monitors = GPOINTER_TO_UINT (g_hash_table_lookup (file_watch_directories, directory));
+  _thunar_return_if_fail (n_monitors > 0);
+  if (n_monitors > 1)
+    {
+      g_hash_table_insert (file_watch_directories, g_object_ref (directory), GUINT_TO_POINTER (n_monitors - 1));
+      return;
+    }
+
+  g_hash_table_remove (file_watch_directories, directory);
+
+  for (lp = file_watch_degraded.head; lp != NULL; lp = lp->next)
+    {
+      file_watch = lp->data;
+      if (file_watch->mode == THUNAR_FILE_WATCH_SHARED
+          && g_file_has_parent (file_watch->file->gfile, directory))
+        thunar_file_watch_set_degraded_mode (file_watch, THUNAR_FILE_WATCH_POLLED);
+    }
+}
+
+
+
+/**
+ * thunar_file_watch_get_state:
+ * @n_monitors : return location for the number of watched files with a monitor.
+ * @n_shared   : return location for the number of watched files relying on
+ *               the monitor of their parent folder.
+ * @n_polled   : return location for the number of polled watched files.
+ *
+ * Returns the state of the watch budget, see thunar_file_watch().
+ *
+ * Return value: the maximum number of monitors for watched files.
+ **/
+guint
+thunar_file_watch_get_state (guint *n_monitors,
+                             guint *n_shared,
+                             guint *n_polled)
+{
+  if (n_monitors != NULL)
+    *n_monitors = file_watch_monitored.length;
+  if (n_shared != NULL)
+    *n_shared = file_watch_degraded.length - file_watch_n_polled;
+  if (n_polled != NULL)
+    *n_polled = file_watch_n_polled;
+
+  return thunar_file_watch_get_budget ();
+}
+
+
+
+static const gchar *
+thunar_file_metadata_attr_name (const gchar *setting_name)
+{
+  const gchar *attr_name;
+  gchar       *tmp;
+  guint        n;
+
+  for (n = 0; n < G_N_ELEMENTS (thunar_file_metadata_attrs); ++n)
+    if (strcmp (thunar_file_metadata_attrs[n].setting_name, setting_name) == 0)
+      return thunar_file_metadata_attrs[n].attr_name;
+
+  /* not a known setting, intern it */
+  tmp = g_strdup_printf ("metadata::thunar-%s", setting_name);
+  attr_name = g_intern_string (tmp);
+  g_free (tmp);
+
+  return attr_name;
+}
+
+
+
+static void
+thunar_file_update_dir_settings_flag (ThunarFile *file)
+{
+  guint n;
+
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_DIR_SETTINGS);
+
+  if (file->info == NULL)
+    return;
+
+  for (n = 0; n < THUNAR_FILE_N_DIRECTORY_SETTINGS; ++n)
+    if (g_file_info_has_attribute (file->info, thunar_file_metadata_attrs[n].attr_name))
+      {
+        FLAG_SET (file, THUNAR_FILE_FLAG_DIR_SETTINGS);
+        break;
+      }
+}
+
+
+
+static void
+thunar_file_info_clear (ThunarFile *file)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  /* release the current file info */
+  if (file->info != NULL)
+    {
+      g_object_unref (file->info);
+      file->info = NULL;
+    }
+
+  /* unset */
+  file->kind = G_FILE_TYPE_UNKNOWN;
+  file->size = 0;
+  file->date_modified = 0;
+  file->mode = 0;
+
+  /* free the custom icon name */
+  g_free (file->custom_icon_name);
+  file->custom_icon_name = NULL;
+
+  /* free display name, basename and collate keys */
+  g_free (file->strings);
+  file->strings = NULL;
+  file->display_name = NULL;
+  file->basename = NULL;
+  file->collate_key = NULL;
+  file->collate_key_nocase = NULL;
+
+  /* content type, the strings are interned */
+  file->content_type = NULL;
+  file->icon_name = NULL;
+
+  /* device type */
+  file->device_type = NULL;
+
+  g_free (file->search_name);
+  file->search_name = NULL;
+
+  file->collate_prefix = 0;
+  file->collate_prefix_nocase = 0;
+
+  /* free thumbnail path */
+  g_free (file->thumbnail_path);
+  file->thumbnail_path = NULL;
+
+  /* assume the file is mounted by default */
+  FLAG_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_PARTIAL_INFO);
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_DIR_SETTINGS);
+
+  /* set thumb state to unknown */
+  FLAG_SET_THUMB_STATE (file, THUNAR_FILE_THUMB_STATE_UNKNOWN);
+}
+
+
+
+static void
+thunar_file_collate_key_append_text (GString     *key,
+                                     const gchar *text,
+                                     gsize        length)
+{
+  gchar  buffer[256];
+  gchar *segment;
+  gsize  offset;
+  gsize  size;
+
+  if (length == 0)
+    return;
+
+  /* strxfrm() needs a terminated string */
+  segment = (length < sizeof (buffer)) ? buffer : g_malloc (length + 1);
+  memcpy (segment, text, length);
+  segment[length] = '\0';
+
+  /* transform into the end of the key, growing it if the guess is too small */
+  offset = key->len;
+  size = 2 * length + 16;
+  for (;;)
+    {
+      g_string_set_size (key, offset + size);
+      length = strxfrm (key->str + offset, segment, size);
+      if (length < size)
+        break;
+      size = length + 1;
+    }
+  g_string_set_size (key, offset + length);
+
+  if (segment != buffer)
+    g_free (segment);
+}
+
+
+
+/* same key as g_utf8_collate_key_for_filename() for an ASCII @name in a
+ * UTF-8 locale: ASCII text is already normalized, so the text parts are
+ * transformed in place, without the Unicode normalization and the
+ * allocations of g_utf8_collate_key() for every part */
+static gchar *
+thunar_file_collate_key_for_ascii_filename (const gchar *name)
+{
+  const gchar *prev;
+  const gchar *p;
+  GString     *key;
+  GString     *append;
+  gint         digits;
+  gint         leading_zeros;
+
+  key = g_string_sized_new (3 * strlen (name) + 16);
+  append = g_string_new (NULL);
+
+  for (prev = p = name; *p != '\0'; p++)
+    {
+      if (*p == '.')
+        {
+          thunar_file_collate_key_append_text (key, prev, p - prev);
+          g_string_append (key, "\1\1\1\1");
+          prev = p + 1;
+        }
+      else if (g_ascii_isdigit (*p))
+        {
+          thunar_file_collate_key_append_text (key, prev, p - prev);
+          g_string_append (key, "\1\1\1\2");
+          prev = p;
+
+          /* numbers sort by their number of digits first, the leading zeros are appended */
+          leading_zeros = (*p == '0') ? 1 : 0;
+          digits = (*p == '0') ? 0 : 1;
+          while (*++p != '\0')
+            {
+              if (*p == '0' && digits == 0)
+                ++leading_zeros;
+              else if (g_ascii_isdigit (*p))
+                ++digits;
+              else
+                {
+                  /* an all-zero number counts as one digit plus leading zeros */
+                  if (digits == 0)
+                    {
+                      ++digits;
+                      --leading_zeros;
+                    }
+                  break;
+                }
+            }
+
+          for (; digits > 1; --digits)
+            g_string_append_c (key, ':');
+
+          if (leading_zeros > 0)
+            {
+              g_string_append_c (append, (gchar) leading_zeros);
+              prev += leading_zeros;
+            }
+
+          g_string_append_len (key, prev, p - prev);
+          prev = p;
+          --p;
+        }
+    }
+
+  thunar_file_collate_key_append_text (key, prev, p - prev);
+  g_string_append (key, append->str);
+  g_string_free (append, TRUE);
+
+  return g_string_free (key, FALSE);
+}
+
+
+
+static guint64
+thunar_file_collate_key_prefix (const gchar *key)
+{
+  guint64 prefix = 0;
+  guint   n;
+
+  /* big-endian, the bytes after the end of @key stay zero */
+  for (n = 0; key != NULL && n < sizeof (prefix) && key[n] != '\0'; ++n)
+    prefix |= ((guint64) (guchar) key[n]) << (8 * (sizeof (prefix) - 1 - n));
+
+  return prefix;
+}
+
+
+
+static const ThunarFileTypeDescription *
+thunar_file_type_description_lookup (const gchar *content_type)
+{
+  ThunarFileTypeDescription *type_description;
+  gchar                     *lower;
+
+  g_mutex_lock (&type_descriptions_mutex);
+
+  if (G_UNLIKELY (type_descriptions == NULL))
+    type_descriptions = g_hash_table_new (g_str_hash, g_str_equal);
+
+  type_description = g_hash_table_lookup (type_descriptions, content_type);
+  if (G_UNLIKELY (type_description == NULL))
+    {
+      /* never freed, there are only as many as content types in use */
+      type_description = g_slice_new (ThunarFileTypeDescription);
+      type_description->description = g_content_type_get_description (content_type);
+      type_description->prefix = thunar_file_collate_key_prefix (type_description->description);
+
+      /* strcasecmp() only folds the ASCII letters as well */
+      lower = g_ascii_strdown (type_description->description, -1);
+      type_description->prefix_nocase = thunar_file_collate_key_prefix (lower);
+      g_free (lower);
+
+      g_hash_table_insert (type_descriptions, (gpointer) g_intern_string (content_type), type_description);
+    }
+
+  g_mutex_unlock (&type_descriptions_mutex);
+
+  return type_description;
+}
+
+
+
+static gboolean
+thunar_file_is_ascii (const gchar *name)
+{
+  for (; *name != '\0'; ++name)
+    if ((guchar) *name >= 0x80)
+      return FALSE;
+  return TRUE;
+}
+
+
+
+static gpointer
+thunar_file_collate_key_check (gpointer data)
+{
+  static const gchar *const names[] =
+  {
+    "a", "A", "abc", "ABC", "aBc", "a.b", "a-.b", "aa.b", ".hidden", "file.", "..",
+    "file1", "file5", "file10", "file26", "file100", "file:foo", "file01", "file001",
+    "file0", "file00", "0", "000", "007", "10.2.3", "v1.10-rc2", "a b c", "a_b-c",
+    "README.md", "Makefile.am", "IMG_20240101_120000.jpg", "~backup~",
+    "#hash#", "@at", "x\1y", "9999999999999999999999", "name with  spaces.tar.gz",
+  };
+  gboolean identical = TRUE;
+  gchar   *expected;
+  gchar   *key;
+  guint    n;
+
+  /* only use the fast path if glib builds the same keys in this locale */
+  for (n = 0; n < G_N_ELEMENTS (names) && identical; ++n)
+    {
+      expected = g_utf8_collate_key_for_filename (names[n], -1);
+      key = thunar_file_collate_key_for_ascii_filename (names[n]);
+      identical = (strcmp (expected, key) == 0);
+      g_free (expected);
+      g_free (key);
+    }
+
+  return GINT_TO_POINTER (identical);
+}
+
+
+
+static gchar *
+thunar_file_collate_key_for_filename (const gchar *name)
+{
+  static GOnce ascii_once = G_ONCE_INIT;
+
+  if (g_get_charset (NULL)
+      && thunar_file_is_ascii (name)
+      && GPOINTER_TO_INT (g_once (&ascii_once, thunar_file_collate_key_check, NULL)))
+    return thunar_file_collate_key_for_ascii_filename (name);
+
+  return g_utf8_collate_key_for_filename (name, -1);
+}
+
+
+
+static gchar *
+thunar_file_casefold (const gchar *name)
+{
+  const gchar *p;
+
+  /* the case folding of ASCII is the lower case, NULL if @name is folded already */
+  for (p = name; *p != '\0'; ++p)
+    {
+      if ((guchar) *p >= 0x80)
+        return g_utf8_casefold (name, -1);
+      if (g_ascii_isupper (*p))
+        break;
+    }
+
+  if (*p == '\0')
+    return NULL;
+
+  if (!thunar_file_is_ascii (p))
+    return g_utf8_casefold (name, -1);
+
+  return g_ascii_strdown (name, -1);
+}
+
+
+
+static gchar *
+thunar_file_pack_string (gchar       **position,
+                         const gchar  *string,
+                         gsize         length)
+{
+  gchar *packed = *position;
+
+  memcpy (packed, string, length + 1);
+  *position += length + 1;
+
+  return packed;
+}
+
+
+
+/* moves the strings built by thunar_file_info_reload() into a single
+ * allocation, which saves the malloc overhead and fragmentation of
+ * several small blocks for every file of big folders. Identical
+ * strings are stored once. */
+static void
+thunar_file_pack_strings (ThunarFile *file)
+{
+  gchar   *display_name = file->display_name;
+  gchar   *basename = file->basename;
+  gchar   *collate_key = file->collate_key;
+  gchar   *collate_key_nocase = file->collate_key_nocase;
+  gchar   *position;
+  gsize    display_name_len;
+  gsize    basename_len;
+  gsize    collate_key_len;
+  gsize    collate_key_nocase_len = 0;
+  gboolean same_basename;
+  gboolean same_nocase;
+
+  _thunar_assert (file->strings == NULL);
+  _thunar_assert (display_name != NULL && basename != NULL && collate_key != NULL);
+
+  display_name_len = strlen (display_name);
+  basename_len = strlen (basename);
+  collate_key_len = strlen (collate_key);
+
+  same_basename = (strcmp (basename, display_name) == 0);
+  same_nocase = (collate_key_nocase == collate_key);
+  if (!same_nocase)
+    collate_key_nocase_len = strlen (collate_key_nocase);
+
+  file->strings = g_malloc (display_name_len + 1
+                            + (same_basename ? 0 : basename_len + 1)
+                            + collate_key_len + 1
+                            + (same_nocase ? 0 : collate_key_nocase_len + 1));
+
+  position = file->strings;
+  file->display_name = thunar_file_pack_string (&position, display_name, display_name_len);
+  file->basename = same_basename ? file->display_name : thunar_file_pack_string (&position, basename, basename_len);
+  file->collate_key = thunar_file_pack_string (&position, collate_key, collate_key_len);
+  file->collate_key_nocase = same_nocase ? file->collate_key : thunar_file_pack_string (&position, collate_key_nocase, collate_key_nocase_len);
+
+  g_free (display_name);
+  g_free (basename);
+  g_free (collate_key);
+  if (!same_nocase)
+    g_free (collate_key_nocase);
+}
+
+
+
+static void
+thunar_file_desktop_entry_free (gpointer data)
+{
+  ThunarFileDesktopEntry *entry = data;
+
+  g_free (entry->icon_name);
+  g_slice_free (ThunarFileDesktopEntry, entry);
+}
+
+
+
+static void
+thunar_file_desktop_entry_forget (ThunarFile *file)
+{
+  g_mutex_lock (&desktop_entries_mutex);
+  if (desktop_entries != NULL)
+    g_hash_table_remove (desktop_entries, file->gfile);
+  g_mutex_unlock (&desktop_entries_mutex);
+}
+
+
+
+/* returns the custom icon of the .desktop file, the key file is only
+ * read if it changed since it was read last. May run in job threads */
+static gchar*
+thunar_file_query_desktop_icon (ThunarFile   *file,
+                                GCancellable *cancellable)
+{
+  ThunarFileDesktopEntry *entry;
+  GKeyFile               *key_file;
+  gchar                  *icon_name = NULL;
+  gchar                  *p;
+
+  g_mutex_lock (&desktop_entries_mutex);
+  entry = desktop_entries != NULL ? g_hash_table_lookup (desktop_entries, file->gfile) : NULL;
+  if (entry != NULL && entry->date_modified == file->date_modified && entry->size == file->size)
+    {
+      icon_name = g_strdup (entry->icon_name);
+      g_mutex_unlock (&desktop_entries_mutex);
+      return icon_name;
+    }
+  g_mutex_unlock (&desktop_entries_mutex);
+
+  /* query a key file for the .desktop file */
+  key_file = thunar_g_file_query_key_file (file->gfile, cancellable, NULL);
+  if (key_file != NULL)
+    {
+      /* read the icon name from the .desktop file */
+      icon_name = g_key_file_get_string (key_file,
+                                         G_KEY_FILE_DESKTOP_GROUP,
+                                         G_KEY_FILE_DESKTOP_KEY_ICON,
+                                         NULL);
+
+      if (G_UNLIKELY (xfce_str_is_empty (icon_name)))
+        {
+          /* make sure we set null if the string is empty else the assertion in
+           * thunar_icon_factory_lookup_icon() will fail */
+          g_free (icon_name);
+          icon_name = NULL;
+        }
+      else
+        {
+          /* drop freedesktop.org supported suffixes from themed icons, if any */
+          if (!g_path_is_absolute (icon_name))
+            {
+              p = strrchr (icon_name, '.');
+              if(g_strcmp0(p, ".png") == 0 || g_strcmp0(p, ".xpm") == 0 || g_strcmp0(p, ".svg") == 0)
+                *p = '\0';
+            }
+        }
+      /* free the key file */
+      g_key_file_free (key_file);
+    }
+  else if (g_cancellable_is_cancelled (cancellable))
+    {
+      /* try again on the next reload */
+      return NULL;
+    }
+
+  entry = g_slice_new (ThunarFileDesktopEntry);
+  entry->date_modified = file->date_modified;
+  entry->size = file->size;
+  entry->icon_name = g_strdup (icon_name);
+
+  g_mutex_lock (&desktop_entries_mutex);
+  if (G_UNLIKELY (desktop_entries == NULL))
+    desktop_entries = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                             g_object_unref, thunar_file_desktop_entry_free);
+  else if (g_hash_table_size (desktop_entries) >= THUNAR_FILE_DESKTOP_ENTRIES_MAX)
+    g_hash_table_remove_all (desktop_entries);
+  g_hash_table_replace (desktop_entries, g_object_ref (file->gfile), entry);
+  g_mutex_unlock (&desktop_entries_mutex);
+
+  return icon_name;
+}
+
+
+
+static void
+thunar_file_info_reload (ThunarFile   *file,
+                         GCancellable *cancellable)
+{
+  const gchar *target_uri;
+  const gchar *display_name;
+  gchar       *casefold;
+  gchar       *path;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (file->info == NULL || G_IS_FILE_INFO (file->info));
+
+  if (G_LIKELY (file->info != NULL))
+    {
+      /* this is requested so often, cache it */
+      file->kind = g_file_info_get_file_type (file->info);
+      file->size = g_file_info_get_attribute_uint64 (file->info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+      file->date_modified = g_file_info_get_attribute_uint64 (file->info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+      if (g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_UNIX_MODE))
+        file->mode = g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_MODE);
+      else
+        file->mode = (file->kind == G_FILE_TYPE_DIRECTORY) ? 0777 : 0666;
+
+      /* checked on every folder change */
+      if (file->kind == G_FILE_TYPE_DIRECTORY)
+        thunar_file_update_dir_settings_flag (file);
+
+      if (file->kind == G_FILE_TYPE_MOUNTABLE)
+        {
+          target_uri = g_file_info_get_attribute_string (file->info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+          if (target_uri != NULL
+              && !g_file_info_get_attribute_boolean (file->info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT))
+            FLAG_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+          else
+             FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+        }
+    }
+
+  /* determine the basename */
+  file->basename = g_file_get_basename (file->gfile);
+  _thunar_assert (file->basename != NULL);
+
+  /* problematic files with content type reading */
+  if (g_strcmp0 (file->basename, "kmsg") == 0
+      && g_file_is_native (file->gfile))
+    {
+      path = g_file_get_path (file->gfile);
+      if (g_strcmp0 (path, "/proc/kmsg") == 0)
+        file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
+      g_free (path);
+    }
+
+  /* check if this file is a desktop entry and we have the permission to execute it */
+  if (thunar_file_is_desktop_file (file) && thunar_file_can_execute (file))
+    {
+      /* determine the custom icon for .desktop files */
+      file->custom_icon_name = thunar_file_query_desktop_icon (file, cancellable);
+    }
+
+  /* determine the display name */
+  if (file->display_name == NULL)
+    {
+      if (G_UNLIKELY (thunar_file_is_trash (file)))
+        file->display_name = g_strdup (_("Trash"));
       else if (G_LIKELY (file->info != NULL))
         {
           display_name = g_file_info_get_display_name (file->info);
@@ -1099,19 +2104,24 @@ thunar_file_info_reload (ThunarFile   *file,
     }
 
   /* create case sensitive collation key */
-  file->collate_key = g_utf8_collate_key_for_filename (file->display_name, -1);
+  file->collate_key = thunar_file_collate_key_for_filename (file->display_name);
 
   /* lowercase the display name */
-  casefold = g_utf8_casefold (file->display_name, -1);
+  casefold = thunar_file_casefold (file->display_name);
 
   /* if the lowercase name is equal, only peek the already hash key */
   if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
-    file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
+    file->collate_key_nocase = thunar_file_collate_key_for_filename (casefold);
   else
     file->collate_key_nocase = file->collate_key;
 
+  file->collate_prefix = thunar_file_collate_key_prefix (file->collate_key);
+  file->collate_prefix_nocase = thunar_file_collate_key_prefix (file->collate_key_nocase);
+
   /* cleanup */
   g_free (casefold);
+
+  thunar_file_pack_strings (file);
 }
 
 
@@ -1121,11 +2131,12 @@ thunar_file_get_async_finish (GObject      *object,
                               GAsyncResult *result,
                               gpointer      user_data)
 {
-  ThunarFileGetData *data = user_data;
-  ThunarFile        *file;
-  GFileInfo         *file_info;
-  GError            *error = NULL;
-  GFile             *location = G_FILE (object);
+  ThunarFileGetData    *data = user_data;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
+  GFileInfo            *file_info;
+  GError               *error = NULL;
+  GFile                *location = G_FILE (object);
 
   _thunar_return_if_fail (G_IS_FILE (location));
   _thunar_return_if_fail (G_IS_ASYNC_RESULT (result));
@@ -1152,30 +2163,73 @@ thunar_file_get_async_finish (GObject      *object,
       && error->code == G_IO_ERROR_NOT_MOUNTED)
    {
       FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-      g_clear_error (&error);
+      g_clear_error (&error);
+   }
+
+  /* insert the file into the cache */
+  shard = thunar_file_cache_lock (file->gfile);
+  thunar_file_cache_insert (shard, file);
+  thunar_file_cache_unlock (shard);
+
+  /* pass the loaded file and possible errors to the return function */
+  (data->func) (location, file, error, data->user_data);
+
+  /* release the file, see description in ThunarFileGetFunc */
+  g_object_unref (file);
+
+  /* free the error, if there is any */
+  if (error != NULL)
+    g_error_free (error);
+
+  /* release the get data */
+  if (data->cancellable != NULL)
+    g_object_unref (data->cancellable);
+  g_slice_free (ThunarFileGetData, data);
+}
+
+
+
+/* replaces the information of @file with the result of a query, @info
+ * and @err are taken over, the shard of @file must be locked */
+static gboolean
+thunar_file_load_from_info (ThunarFile           *file,
+                            ThunarFileCacheShard *shard,
+                            GFileInfo            *info,
+                            GError               *err,
+                            GCancellable         *cancellable,
+                            GError              **error)
+{
+  /* remove the file from cache */
+  g_hash_table_remove (shard->table, file->gfile);
+
+  /* reset the file, an earlier listing is outdated by now */
+  thunar_file_info_clear (file);
+  g_clear_object (&file->listed_info);
+  file->info = info;
+
+  /* update the mounted info */
+  if (err != NULL
+      && err->domain == G_IO_ERROR
+      && err->code == G_IO_ERROR_NOT_MOUNTED)
+   {
+      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+      g_clear_error (&err);
    }
 
-  /* insert the file into the cache */
-  G_REC_LOCK (file_cache_mutex);
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-  G_REC_UNLOCK (file_cache_mutex);
-
-  /* pass the loaded file and possible errors to the return function */
-  (data->func) (location, file, error, data->user_data);
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
 
-  /* release the file, see description in ThunarFileGetFunc */
-  g_object_unref (file);
+  /* update the file from the information */
+  thunar_file_info_reload (file, cancellable);
 
-  /* free the error, if there is any */
-  if (error != NULL)
-    g_error_free (error);
+  /* (re)insert the file into the cache */
+  if (file->kind != G_FILE_TYPE_UNKNOWN)
+    thunar_file_cache_insert (shard, file);
 
-  /* release the get data */
-  if (data->cancellable != NULL)
-    g_object_unref (data->cancellable);
-  g_slice_free (ThunarFileGetData, data);
+  return TRUE;
 }
 
 
@@ -1199,57 +2253,29 @@ thunar_file_load (ThunarFile   *file,
                   GCancellable *cancellable,
                   GError      **error)
 {
-  GError *err = NULL;
+  ThunarFileCacheShard *shard;
+  GFileInfo            *info;
+  GError               *err = NULL;
+  gboolean              succeed;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   _thunar_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (file->gfile), FALSE);
 
-  G_REC_LOCK (file_cache_mutex);
-
-  /* remove the file from cache */
-  g_hash_table_remove (file_cache, file->gfile);
-
-  /* reset the file */
-  thunar_file_info_clear (file);
+  shard = thunar_file_cache_lock (file->gfile);
 
   /* query a new file info */
-  file->info = g_file_query_info (file->gfile,
-                                  THUNARX_FILE_INFO_NAMESPACE,
-                                  G_FILE_QUERY_INFO_NONE,
-                                  cancellable, &err);
-
-  /* update the mounted info */
-  if (err != NULL
-      && err->domain == G_IO_ERROR
-      && err->code == G_IO_ERROR_NOT_MOUNTED)
-   {
-      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-      g_clear_error (&err);
-   }
-
-  if (err != NULL)
-    {
-      g_propagate_error (error, err);
-      G_REC_UNLOCK (file_cache_mutex);
-      return FALSE;
-    }
-
-  /* update the file from the information */
-  thunar_file_info_reload (file, cancellable);
+  info = g_file_query_info (file->gfile,
+                            THUNARX_FILE_INFO_NAMESPACE,
+                            G_FILE_QUERY_INFO_NONE,
+                            cancellable, &err);
 
-  /* (re)insert the file into the cache */
-  if (file->kind != G_FILE_TYPE_UNKNOWN)
-    {
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-    }
+  succeed = thunar_file_load_from_info (file, shard, info, err, cancellable, error);
 
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
-  return TRUE;
+  return succeed;
 }
 
 
@@ -1272,13 +2298,14 @@ ThunarFile*
 thunar_file_get (GFile   *gfile,
                  GError **error)
 {
-  ThunarFile *file;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
 
   _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
 
   /* both lookup and insert must happen in the same critical section
    * because the insert is contigent upon the lookup */
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (gfile);
 
   /* check if we already have a cached version of that file */
   file = thunar_file_cache_lookup (gfile);
@@ -1297,7 +2324,7 @@ thunar_file_get (GFile   *gfile,
         {
           /* Just check that it's been cached, if appropriate */
           if (file->kind != G_FILE_TYPE_UNKNOWN)
-            _thunar_assert (g_hash_table_contains (file_cache, file->gfile) == TRUE);
+            _thunar_assert (g_hash_table_contains (shard->table, file->gfile) == TRUE);
         }
       else
         {
@@ -1310,7 +2337,7 @@ thunar_file_get (GFile   *gfile,
     }
 
   /* finished related activity on the cache */
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   return file;
 }
@@ -1341,13 +2368,14 @@ thunar_file_get_with_info (GFile     *gfile,
                            GFileInfo *recent_info,
                            gboolean   not_mounted)
 {
-  ThunarFile *file;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
 
   _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
   _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
   /* all contingent lookups and inserts must happen in the same critical section */
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (gfile);
 
   /* check if we already have a cached version of that file */
   file = thunar_file_cache_lookup (gfile);
@@ -1376,13 +2404,11 @@ thunar_file_get_with_info (GFile     *gfile,
         FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
 
       /* insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
+      thunar_file_cache_insert (shard, file);
     }
 
   /* done reading and writing the cache for this file instance */
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   if (recent_info != NULL)
     file->recent_info = g_object_ref (recent_info);
@@ -1392,6 +2418,128 @@ thunar_file_get_with_info (GFile     *gfile,
 
 
 
+/**
+ * thunar_file_get_with_info_batch:
+ * @files        : array of #GFile<!---->s.
+ * @infos        : array of the #GFileInfo<!---->s for @files.
+ * @recent_infos : array of the recent #GFileInfo<!---->s for @files, entries may be %NULL.
+ * @not_mounted  : array of flags whether the @files are not mounted.
+ * @partial_info : array of flags whether the @infos only contain
+ *                 %THUNAR_FILE_INFO_FAST_NAMESPACE, or %NULL.
+ * @n_files      : number of items in the arrays.
+ * @listing      : whether @infos are the listing of the parent folder.
+ *
+ * Batched version of thunar_file_get_with_info(). The #ThunarFile<!---->s
+ * which are not cached yet are set up without holding any file cache
+ * lock, the cache is only locked for the lookups and the insertions.
+ *
+ * With @listing, the @infos of files which were cached already are kept
+ * aside, so the folder can compare them with the current information
+ * using thunar_file_apply_listed_info() once the listing is done.
+ *
+ * The new files with a @partial_info flag set are marked with
+ * thunar_file_has_partial_info(), until the complete info is
+ * set using thunar_file_update_info() or a reload.
+ *
+ * The caller is responsible to free the returned list using
+ * thunar_g_list_free_full() when done with it.
+ *
+ * Return value: the list of #ThunarFile<!---->s, in the order of @files.
+ **/
+GList *
+thunar_file_get_with_info_batch (GFile          **files,
+                                 GFileInfo      **infos,
+                                 GFileInfo      **recent_infos,
+                                 const gboolean  *not_mounted,
+                                 const gboolean  *partial_info,
+                                 guint            n_files,
+                                 gboolean         listing)
+{
+  ThunarFileCacheShard  *shard;
+  ThunarFile           **thunar_files;
+  ThunarFile            *file;
+  gboolean              *created;
+  GList                 *list = NULL;
+  guint                  n;
+
+  _thunar_return_val_if_fail (files != NULL || n_files == 0, NULL);
+  _thunar_return_val_if_fail (infos != NULL || n_files == 0, NULL);
+
+  thunar_files = g_new0 (ThunarFile *, n_files);
+  created = g_new0 (gboolean, n_files);
+
+  /* lookup the files we already know, which is the common case on reload */
+  for (n = 0; n < n_files; ++n)
+    thunar_files[n] = thunar_file_cache_lookup (files[n]);
+
+  /* setup the new files, they are not visible to anyone else yet */
+  for (n = 0; n < n_files; ++n)
+    {
+      if (thunar_files[n] != NULL)
+        continue;
+
+      file = g_object_new (THUNAR_TYPE_FILE, NULL);
+      file->gfile = g_object_ref (files[n]);
+      thunar_file_info_clear (file);
+      file->info = g_object_ref (infos[n]);
+
+      /* determines the display name, collate keys and kind */
+      thunar_file_info_reload (file, NULL);
+
+      if (not_mounted != NULL && not_mounted[n])
+        FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+
+      if (partial_info != NULL && partial_info[n])
+        FLAG_SET (file, THUNAR_FILE_FLAG_PARTIAL_INFO);
+
+      thunar_files[n] = file;
+      created[n] = TRUE;
+    }
+
+  /* insert the new files into the cache, unless another thread was faster */
+  for (n = 0; n < n_files; ++n)
+    {
+      if (!created[n])
+        {
+          if (listing)
+            {
+              shard = thunar_file_cache_lock (files[n]);
+              g_set_object (&thunar_files[n]->listed_info, infos[n]);
+              thunar_files[n]->listed_info_partial = partial_info != NULL && partial_info[n];
+              thunar_file_cache_unlock (shard);
+            }
+          continue;
+        }
+
+      shard = thunar_file_cache_lock (files[n]);
+      file = thunar_file_cache_lookup (files[n]);
+      if (G_UNLIKELY (file != NULL))
+        {
+          g_object_unref (thunar_files[n]);
+          thunar_files[n] = file;
+        }
+      else
+        {
+          thunar_file_cache_insert (shard, thunar_files[n]);
+        }
+      thunar_file_cache_unlock (shard);
+    }
+
+  for (n = n_files; n > 0; --n)
+    {
+      if (recent_infos != NULL && recent_infos[n - 1] != NULL)
+        g_set_object (&thunar_files[n - 1]->recent_info, recent_infos[n - 1]);
+      list = g_list_prepend (list, thunar_files[n - 1]);
+    }
+
+  g_free (thunar_files);
+  g_free (created);
+
+  return list;
+}
+
+
+
 /**
  * thunar_file_get_for_uri:
  * @uri   : an URI or an absolute filename.
@@ -1945,7 +3093,7 @@ thunar_file_rename (ThunarFile   *file,
   _thunar_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  G_LOCK (file_rename_mutex);
+  g_bit_lock (&file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
   /* try to rename the file */
   renamed_file = g_file_set_display_name (file->gfile, name, cancellable, error);
 
@@ -1962,41 +3110,24 @@ thunar_file_rename (ThunarFile   *file,
           /* emit the file changed signal */
           thunar_file_changed (file);
         }
-      G_UNLOCK (file_rename_mutex);
+      g_bit_unlock (&file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
       return TRUE;
     }
   else
     {
-      G_UNLOCK (file_rename_mutex);
+      g_bit_unlock (&file->rename_lock, THUNAR_FILE_RENAME_LOCK_BIT);
       return FALSE;
     }
 }
 
 
 
-/**
- * thunar_file_accepts_drop:
- * @file                    : a #ThunarFile instance.
- * @file_list               : the list of #GFile<!---->s that will be dropped.
- * @context                 : the current #GdkDragContext, which is used for the drop.
- * @suggested_action_return : return location for the suggested #GdkDragAction or %NULL.
- *
- * Checks whether @file can accept @file_list for the given @context and
- * returns the #GdkDragAction<!---->s that can be used or 0 if no actions
- * apply.
- *
- * If any #GdkDragAction<!---->s apply and @suggested_action_return is not
- * %NULL, the suggested #GdkDragAction for this drop will be stored to the
- * location pointed to by @suggested_action_return.
- *
- * Return value: the #GdkDragAction<!---->s supported for the drop or
- *               0 if no drop is possible.
- **/
-GdkDragAction
-thunar_file_accepts_drop (ThunarFile     *file,
-                          GList          *file_list,
-                          GdkDragContext *context,
-                          GdkDragAction  *suggested_action_return)
+static GdkDragAction
+thunar_file_accepts_drop_internal (ThunarFile     *file,
+                                   GList          *file_list,
+                                   guint           n_check,
+                                   GdkDragContext *context,
+                                   GdkDragAction  *suggested_action_return)
 {
   GdkDragAction suggested_action;
   GdkDragAction actions;
@@ -2004,6 +3135,7 @@ thunar_file_accepts_drop (ThunarFile     *file,
   GFile        *parent_file;
   ThunarFile   *parent_thunar_file;
   GList        *lp;
+  guint         n;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
   _thunar_return_val_if_fail (GDK_IS_DRAG_CONTEXT (context), 0);
@@ -2032,7 +3164,7 @@ thunar_file_accepts_drop (ThunarFile     *file,
       if (thunar_file_is_trash (file))
         actions &= ~(GDK_ACTION_COPY | GDK_ACTION_LINK);
 
-      for (lp = file_list; lp != NULL; lp = lp->next)
+      for (lp = file_list, n = 0; lp != NULL && (n_check == 0 || n < n_check); lp = lp->next, n++)
         {
           /* we cannot drop a file on itself */
           if (G_UNLIKELY (g_file_equal (file->gfile, lp->data)))
@@ -2065,7 +3197,7 @@ thunar_file_accepts_drop (ThunarFile     *file,
           /* default to move as suggested action */
           suggested_action = GDK_ACTION_MOVE;
 
-          for (lp = file_list; lp != NULL; lp = lp->next)
+          for (lp = file_list, n = 0; lp != NULL && (n_check == 0 || n < n_check); lp = lp->next, n++)
             {
               /* dropping from the trash always suggests move */
               if (G_UNLIKELY (thunar_g_file_is_trashed (lp->data)))
@@ -2134,6 +3266,64 @@ thunar_file_accepts_drop (ThunarFile     *file,
 
 
 
+/**
+ * thunar_file_accepts_drop:
+ * @file                    : a #ThunarFile instance.
+ * @file_list               : the list of #GFile<!---->s that will be dropped.
+ * @context                 : the current #GdkDragContext, which is used for the drop.
+ * @suggested_action_return : return location for the suggested #GdkDragAction or %NULL.
+ *
+ * Checks whether @file can accept @file_list for the given @context and
+ * returns the #GdkDragAction<!---->s that can be used or 0 if no actions
+ * apply.
+ *
+ * If any #GdkDragAction<!---->s apply and @suggested_action_return is not
+ * %NULL, the suggested #GdkDragAction for this drop will be stored to the
+ * location pointed to by @suggested_action_return.
+ *
+ * Return value: the #GdkDragAction<!---->s supported for the drop or
+ *               0 if no drop is possible.
+ **/
+GdkDragAction
+thunar_file_accepts_drop (ThunarFile     *file,
+                          GList          *file_list,
+                          GdkDragContext *context,
+                          GdkDragAction  *suggested_action_return)
+{
+  return thunar_file_accepts_drop_internal (file, file_list, 0, context, suggested_action_return);
+}
+
+
+
+/**
+ * thunar_file_accepts_drop_sample:
+ * @file                    : a #ThunarFile instance.
+ * @file_list               : the list of #GFile<!---->s that will be dropped.
+ * @n_sample                : the number of files of @file_list to check.
+ * @context                 : the current #GdkDragContext, which is used for the drop.
+ * @suggested_action_return : return location for the suggested #GdkDragAction or %NULL.
+ *
+ * Like thunar_file_accepts_drop(), but only looks at the first @n_sample
+ * files of @file_list. This is meant for the feedback during drag-motion,
+ * where huge drops would otherwise be checked on every pointer movement.
+ * The complete @file_list should be checked again when it is dropped.
+ *
+ * Return value: the #GdkDragAction<!---->s supported for the drop or
+ *               0 if no drop is possible.
+ **/
+GdkDragAction
+thunar_file_accepts_drop_sample (ThunarFile     *file,
+                                 GList          *file_list,
+                                 guint           n_sample,
+                                 GdkDragContext *context,
+                                 GdkDragAction  *suggested_action_return)
+{
+  _thunar_return_val_if_fail (n_sample > 0, 0);
+  return thunar_file_accepts_drop_internal (file, file_list, n_sample, context, suggested_action_return);
+}
+
+
+
 /**
  * thunar_file_get_date:
  * @file        : a #ThunarFile instance.
@@ -2168,8 +3358,7 @@ thunar_file_get_date (const ThunarFile  *file,
       attribute = G_FILE_ATTRIBUTE_TIME_CREATED;
       break;
     case THUNAR_FILE_DATE_MODIFIED:
-      attribute = G_FILE_ATTRIBUTE_TIME_MODIFIED;
-      break;
+      return file->date_modified;
     case THUNAR_FILE_DATE_DELETED:
       datetime = g_file_info_get_deletion_date (file->info);
       if (datetime == NULL)
@@ -2467,6 +3656,29 @@ thunar_file_get_user (const ThunarFile *file)
 
 
 
+/**
+ * thunar_file_prefetch_owner:
+ * @file : a #ThunarFile instance.
+ *
+ * Queues the names of the user and group of @file for a lookup
+ * in the background, so the views don't block on the name service
+ * when showing the owner or group of @file later.
+ **/
+void
+thunar_file_prefetch_owner (const ThunarFile *file)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  if (file->info == NULL)
+    return;
+
+  thunar_user_manager_prefetch (user_manager,
+                                g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_UID),
+                                g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_GID));
+}
+
+
+
 /**
  * thunar_file_get_content_type:
  * @file : a #ThunarFile.
@@ -2488,12 +3700,6 @@ thunar_file_get_content_type (ThunarFile *file)
 
   if (G_UNLIKELY (file->content_type == NULL))
     {
-      G_LOCK (file_content_type_mutex);
-
-      /* make sure we weren't waiting for a lock */
-      if (G_UNLIKELY (file->content_type != NULL))
-        goto bailout;
-
       /* make sure this is not loaded in the general info */
       _thunar_assert (file->info == NULL
           || !g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE));
@@ -2501,7 +3707,7 @@ thunar_file_get_content_type (ThunarFile *file)
       if (G_UNLIKELY (file->kind == G_FILE_TYPE_DIRECTORY))
         {
           /* this we known for sure */
-          file->content_type = g_strdup ("inode/directory");
+          content_type = g_intern_static_string ("inode/directory");
         }
       else
         {
@@ -2512,7 +3718,8 @@ thunar_file_get_content_type (ThunarFile *file)
           else
             gfile = g_object_ref (file->gfile);
 
-          /* async load the content-type */
+          /* the content type is queried without holding the lock, so other
+           * threads determining content types do not have to wait for this */
           if (G_LIKELY (gfile != NULL))
             {
               info = g_file_query_info (gfile,
@@ -2525,13 +3732,13 @@ thunar_file_get_content_type (ThunarFile *file)
 
           if (G_LIKELY (info != NULL))
             {
-              /* store the new content type */
+              /* take the new content type */
               content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
               if (G_UNLIKELY (content_type == NULL))
                 content_type = g_file_info_get_attribute_string (info,
                                                                  G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
               if (G_LIKELY (content_type != NULL))
-                file->content_type = g_strdup (content_type);
+                content_type = g_intern_string (content_type);
               g_object_unref (G_OBJECT (info));
             }
           else
@@ -2543,7 +3750,7 @@ thunar_file_get_content_type (ThunarFile *file)
                   /* The mime-type 'inode/symlink' is  only used for broken links.
                    * When the link is functional, the mime-type of the link target will be used */
                   if (G_LIKELY (is_symlink && err->code == G_IO_ERROR_NOT_FOUND))
-                    file->content_type = g_strdup ("inode/symlink");
+                    content_type = g_intern_static_string ("inode/symlink");
                   else
                     g_warning ("Content type loading failed for %s: %s",
                               thunar_file_get_display_name (file),
@@ -2554,54 +3761,145 @@ thunar_file_get_content_type (ThunarFile *file)
             }
 
           /* always provide a fallback */
-          if (file->content_type == NULL)
-            file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
+          if (content_type == NULL)
+            content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
         }
 
-      bailout:
+      /* keep the type if another thread was faster */
+      g_atomic_pointer_compare_and_exchange ((gpointer *) &file->content_type, NULL, (gpointer) content_type);
+    }
+
+  return g_atomic_pointer_get ((gpointer *) &file->content_type);
+}
+
 
-      G_UNLOCK (file_content_type_mutex);
+
+/**
+ * thunar_file_get_content_type_description:
+ * @file : a #ThunarFile.
+ *
+ * Returns the content type description of @file.
+ * Free the returned string with g_free().
+ *
+ * Return value: (non-nullable) (transfer full): content type description of @file.
+ **/
+gchar *
+thunar_file_get_content_type_desc (ThunarFile *file)
+{
+  const gchar *content_type;
+  gchar       *description;
+  gchar       *link_text;
+
+  if (G_LIKELY (!thunar_file_is_symlink (file)))
+    return g_strdup (thunar_file_peek_content_type_desc (file));
+
+  /* thunar_file_get_content_type always provides fallback, hence no NULL check needed */
+  content_type = thunar_file_get_content_type (file);
+
+  /* handle broken symlink */
+  if (G_UNLIKELY (g_content_type_equals (content_type, "inode/symlink")))
+    return g_strdup ("broken link");
+
+  /* append " (link to <target>)" to description if link is not broken */
+  link_text = g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file));
+  description = g_strdup_printf ("%s (%s)", thunar_file_type_description_lookup (content_type)->description, link_text);
+  g_free (link_text);
+  return description;
+}
+
+
+
+/**
+ * thunar_file_peek_content_type_desc:
+ * @file : a #ThunarFile.
+ *
+ * Returns the content type description of @file like
+ * thunar_file_get_content_type_desc(), but without copying it. All
+ * files of a content type share the same string, so two descriptions
+ * can be compared by their pointers. Symlinks have a description of
+ * their own and return %NULL here.
+ *
+ * Return value: (nullable) (transfer none): the interned content type
+ *               description of @file or %NULL for symlinks.
+ **/
+const gchar *
+thunar_file_peek_content_type_desc (ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+
+  if (G_UNLIKELY (thunar_file_is_symlink (file)))
+    return NULL;
+
+  return thunar_file_type_description_lookup (thunar_file_get_content_type (file))->description;
+}
+
+
+
+/**
+ * thunar_file_get_content_type_desc_prefix:
+ * @file           : a #ThunarFile.
+ * @case_sensitive : whether to keep the case of the description.
+ *
+ * Returns the first bytes of the content type description of @file as
+ * a number, ordered like strcmp() of the descriptions if @case_sensitive
+ * and like strcasecmp() otherwise, for sorting by type without looking
+ * at the descriptions themselves while the prefixes differ.
+ *
+ * Return value: the sort prefix of the description of @file.
+ **/
+guint64
+thunar_file_get_content_type_desc_prefix (ThunarFile *file,
+                                          gboolean    case_sensitive)
+{
+  const ThunarFileTypeDescription *type_description;
+  gchar                           *description;
+  gchar                           *lower;
+  guint64                          prefix;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
+
+  if (G_LIKELY (!thunar_file_is_symlink (file)))
+    {
+      type_description = thunar_file_type_description_lookup (thunar_file_get_content_type (file));
+      return case_sensitive ? type_description->prefix : type_description->prefix_nocase;
+    }
+
+  description = thunar_file_get_content_type_desc (file);
+  if (case_sensitive)
+    {
+      prefix = thunar_file_collate_key_prefix (description);
+    }
+  else
+    {
+      lower = g_ascii_strdown (description, MIN (strlen (description), sizeof (prefix)));
+      prefix = thunar_file_collate_key_prefix (lower);
+      g_free (lower);
     }
+  g_free (description);
 
-  return file->content_type;
+  return prefix;
 }
 
 
 
 /**
- * thunar_file_get_content_type_description:
+ * thunar_file_peek_content_type:
  * @file : a #ThunarFile.
  *
- * Returns the content type description of @file.
- * Free the returned string with g_free().
+ * Returns the content type of @file if it was already determined,
+ * unlike thunar_file_get_content_type() this never sniffs the file.
  *
- * Return value: (non-nullable) (transfer full): content type description of @file.
+ * Return value: (nullable): the content type of @file or %NULL.
  **/
-gchar *
-thunar_file_get_content_type_desc (ThunarFile *file)
+const gchar *
+thunar_file_peek_content_type (const ThunarFile *file)
 {
-  const gchar *content_type;
-  gchar       *description;
-  gchar       *type_text;
-  gchar       *link_text;
-
-  /* thunar_file_get_content_type always provides fallback, hence no NULL check needed */
-  content_type = thunar_file_get_content_type (file);
-
-  if (G_LIKELY (!thunar_file_is_symlink (file)))
-    return g_content_type_get_description (content_type);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
-  /* handle broken symlink */
-  if (G_UNLIKELY (g_content_type_equals (content_type, "inode/symlink")))
-    return g_strdup ("broken link");
+  if (file->kind == G_FILE_TYPE_DIRECTORY)
+    return "inode/directory";
 
-  /* append " (link to <target>)" to description if link is not broken */
-  type_text = g_content_type_get_description (content_type);
-  link_text = g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file));
-  description = g_strdup_printf ("%s (%s)", type_text, link_text);
-  g_free (link_text);
-  g_free (type_text);
-  return description;
+  return file->content_type;
 }
 
 
@@ -2621,6 +3919,27 @@ thunar_file_load_content_type (ThunarFile *file)
 
 
 
+/**
+ * thunar_file_set_content_type:
+ * @file         : a #ThunarFile.
+ * @content_type : the content type of @file.
+ *
+ * Stores the @content_type that was determined outside of @file,
+ * e.g. by a background job. Nothing happens if @file already knows
+ * its content type.
+ **/
+void
+thunar_file_set_content_type (ThunarFile  *file,
+                              const gchar *content_type)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (content_type != NULL);
+
+  g_atomic_pointer_compare_and_exchange ((gpointer *) &file->content_type, NULL, (gpointer) g_intern_string (content_type));
+}
+
+
+
 /**
  * thunar_file_get_symlink_target:
  * @file : a #ThunarFile.
@@ -2695,10 +4014,7 @@ thunar_file_get_size (const ThunarFile *file)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
 
-  if (file->info == NULL)
-    return 0;
-
-  return g_file_info_get_size (file->info);
+  return file->size;
 }
 
 
@@ -2789,14 +4105,7 @@ ThunarFileMode
 thunar_file_get_mode (const ThunarFile *file)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
-
-  if (file->info == NULL)
-    return 0;
-
-  if (g_file_info_has_attribute (file->info, G_FILE_ATTRIBUTE_UNIX_MODE))
-    return g_file_info_get_attribute_uint32 (file->info, G_FILE_ATTRIBUTE_UNIX_MODE);
-  else
-    return thunar_file_is_directory (file) ? 0777 : 0666;
+  return file->mode;
 }
 
 
@@ -3002,7 +4311,6 @@ thunar_file_can_execute (ThunarFile *file)
 {
   ThunarFile          *file_to_check;
   GFile               *link_target;
-  ThunarPreferences   *preferences;
   gboolean             exec_shell_scripts = FALSE;
   const gchar         *content_type;
   gboolean             exec_bit_set = FALSE;
@@ -3060,9 +4368,7 @@ thunar_file_can_execute (ThunarFile *file)
         }
 
       /* check if the shell scripts should be executed or opened by default */
-      preferences = thunar_preferences_get ();
-      g_object_get (preferences, "misc-exec-shell-scripts-by-default", &exec_shell_scripts, NULL);
-      g_object_unref (preferences);
+      exec_shell_scripts = thunar_preferences_get_snapshot ()->misc_exec_shell_scripts_by_default;
 
       if (g_content_type_is_a (content_type, "text/plain") && ! exec_shell_scripts)
         {
@@ -3514,81 +4820,242 @@ thunar_file_can_be_trashed (const ThunarFile *file)
 
 
 
+static void thunar_file_count_group_start (ThunarFileCountGroup *group);
+
+
+
+static void
+thunar_file_count_waiter_free (gpointer data)
+{
+  ThunarFileCountWaiter *waiter = data;
+
+  g_weak_ref_clear (&waiter->user_data);
+  g_slice_free (ThunarFileCountWaiter, waiter);
+}
+
+
+
+static void
+thunar_file_count_group_finished (ThunarJob            *job,
+                                  ThunarFileCountGroup *group)
+{
+  ThunarFileCountWaiter *waiter;
+  ThunarFile            *file;
+  gpointer               user_data;
+  GSList                *waiters;
+  GSList                *wp;
+  GList                 *lp;
+  guint                  n;
+
+  _thunar_return_if_fail (group->job == job);
+
+  /* store the results before anyone is told about them */
+  for (lp = group->running, n = 0; lp != NULL; lp = lp->next, n++)
+    {
+      file = THUNAR_FILE (lp->data);
+      if (group->counts[n] != G_MAXUINT)
+        file->file_count = group->counts[n];
+      file->file_count_timestamp = MAX (group->started, 1);
+    }
+
+  for (lp = group->running; lp != NULL; lp = lp->next)
+    {
+      if (!g_hash_table_steal_extended (file_count_waiters, lp->data, NULL, (gpointer *) &waiters))
+        continue;
+
+      for (wp = waiters; wp != NULL; wp = wp->next)
+        {
+          waiter = wp->data;
+          user_data = g_weak_ref_get (&waiter->user_data);
+          if (user_data != NULL)
+            {
+              (*waiter->func) (lp->data, user_data);
+              g_object_unref (user_data);
+            }
+        }
+
+      g_slist_free_full (waiters, thunar_file_count_waiter_free);
+    }
+
+  g_signal_handlers_disconnect_by_data (job, group);
+  g_object_unref (job);
+  group->job = NULL;
+
+  g_list_free_full (group->running, g_object_unref);
+  group->running = NULL;
+  g_free (group->counts);
+  group->counts = NULL;
+
+  /* continue with the folders queued meanwhile or drop the group */
+  if (g_queue_is_empty (&group->pending))
+    g_hash_table_remove (file_count_groups, group->parent);
+  else
+    thunar_file_count_group_start (group);
+}
+
+
+
+static void
+thunar_file_count_group_start (ThunarFileCountGroup *group)
+{
+  GList *file_list = NULL;
+  GList *lp;
+  guint  n;
+
+  _thunar_return_if_fail (group->job == NULL);
+
+  for (n = 0; n < THUNAR_FILE_COUNT_BATCH_SIZE && !g_queue_is_empty (&group->pending); n++)
+    group->running = g_list_prepend (group->running, g_queue_pop_head (&group->pending));
+  group->running = g_list_reverse (group->running);
+
+  for (lp = group->running; lp != NULL; lp = lp->next)
+    file_list = g_list_prepend (file_list, thunar_file_get_file (lp->data));
+  file_list = g_list_reverse (file_list);
+
+  /* counts newer than this are up to date, even if the folder changes while counting */
+  group->started = g_get_real_time () / G_USEC_PER_SEC;
+  group->counts = g_new (guint, n);
+
+  group->job = thunar_io_jobs_count_files (file_list, group->counts);
+  g_signal_connect (group->job, "finished", G_CALLBACK (thunar_file_count_group_finished), group);
+  thunar_job_set_priority (group->job, THUNAR_JOB_PRIORITY_BACKGROUND);
+  thunar_job_launch (group->job);
+
+  g_list_free (file_list);
+}
+
+
+
+static void
+thunar_file_count_group_free (gpointer data)
+{
+  ThunarFileCountGroup *group = data;
+
+  /* only idle groups are dropped */
+  _thunar_assert (group->job == NULL);
+
+  g_queue_clear_full (&group->pending, g_object_unref);
+  g_object_unref (group->parent);
+  g_slice_free (ThunarFileCountGroup, group);
+}
+
+
+
 /**
  * thunar_file_get_file_count
- * @file    : a #ThunarFile instance.
- * @callback: a #GCallback to be executed after the file count
- * @data    : a #gpointer containing user data to pass to the callback
+ * @file      : a #ThunarFile instance.
+ * @func      : a #ThunarFileCountFunc called once the count is known or %NULL.
+ * @user_data : a #GObject to pass to @func.
+ *
+ * Returns the number of items in the directory as known so far. If
+ * @func is not %NULL and the folder was modified since it was last
+ * counted, a recount is queued in the background and @func is called
+ * with @user_data once it is done. Only a weak reference is kept on
+ * @user_data, @func is not called anymore once it was finalized.
  *
- * Returns the number of items in the directory
- * Counts the number of files in the directory as fast as possible.
- * Will use cached data to do calculations only when the file has
- * been modified since the last time its contents were counted.
+ * Folders below the same parent are counted in shared batches by one
+ * job at a time, so rendering large listings does not block on I/O or
+ * start a job per visible row.
  *
  * Return value: Number of files in a folder
  **/
 guint
-thunar_file_get_file_count (ThunarFile   *file,
-                            GCallback     callback,
-                            gpointer      data)
-{
-  GError                    *err = NULL;
-  ThunarJob                 *job;
-  GFileInfo                 *info;
-  guint64                    last_modified;
+thunar_file_get_file_count (ThunarFile         *file,
+                            ThunarFileCountFunc func,
+                            gpointer            user_data)
+{
+  ThunarFileCountWaiter *waiter;
+  ThunarFileCountGroup  *group;
+  GSList                *waiters = NULL;
+  GSList                *wp;
+  GFile                 *parent;
+  gpointer               object;
+  gboolean               queued;
 
   _thunar_return_val_if_fail (thunar_file_is_directory (file), 0);
+  _thunar_return_val_if_fail (func == NULL || G_IS_OBJECT (user_data), 0);
 
-  /* Forcefully get cached values by passing NULL as the second argument */
-  if (file == NULL)
+  /* only the cached value is wanted */
+  if (func == NULL)
     return file->file_count;
 
-  info = g_file_query_info (thunar_file_get_file (file),
-                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
-                            G_FILE_QUERY_INFO_NONE,
-                            NULL,
-                            &err);
+  /* the cached value is current if counted after the last known modification */
+  if (G_LIKELY (file->file_count_timestamp != 0
+                && thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED) < file->file_count_timestamp))
+    return file->file_count;
 
-  if (err != NULL)
+  if (G_UNLIKELY (file_count_waiters == NULL))
     {
-      g_warning ("An error occured while trying to get file counts.");
-      return file->file_count;
+      file_count_waiters = g_hash_table_new (g_direct_hash, g_direct_equal);
+      file_count_groups = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, NULL, thunar_file_count_group_free);
     }
 
-  last_modified = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
-  g_object_unref (info);
+  /* every waiter is notified only once per count */
+  queued = g_hash_table_lookup_extended (file_count_waiters, file, NULL, (gpointer *) &waiters);
+  for (wp = waiters; queued && wp != NULL; wp = wp->next)
+    {
+      waiter = wp->data;
+      if (waiter->func == func)
+        {
+          object = g_weak_ref_get (&waiter->user_data);
+          if (object != NULL)
+            g_object_unref (object);
+          if (object == user_data)
+            return file->file_count;
+        }
+    }
 
-  /* return a cached value if last time that the file count was computed is later
-   * than the last time the file was modified */
-  if (G_LIKELY (last_modified < file->file_count_timestamp))
-    return file->file_count;
+  waiter = g_slice_new0 (ThunarFileCountWaiter);
+  waiter->func = func;
+  g_weak_ref_init (&waiter->user_data, user_data);
+  g_hash_table_insert (file_count_waiters, file, g_slist_prepend (waiters, waiter));
 
-  /* put the timestamp calculation at the *start* of the process to prevent another call to
-   * thunar_file_get_count starting another job on the same folder before one has ended.
-   * Divide by 1e6 to convert from microseconds to seconds */
-  file->file_count_timestamp = g_get_real_time () / (guint64) 1e6;
+  /* already queued or being counted */
+  if (queued)
+    return file->file_count;
 
-  /* set up a job to actually enumerate over the folder's contents and get its file count */
-  job = thunar_io_jobs_count_files (file);
+  parent = g_file_get_parent (thunar_file_get_file (file));
+  if (parent == NULL)
+    parent = g_object_ref (thunar_file_get_file (file));
 
-  /* set up the signal on finish to call the callback and keep a reference on the data */
-  if (callback != NULL)
+  group = g_hash_table_lookup (file_count_groups, parent);
+  if (group == NULL)
     {
-      g_signal_connect_data (job,
-                             "finished",
-                             G_CALLBACK (callback),
-                             data,
-                             (GClosureNotify) (void (*)(void)) g_object_unref,
-                             G_CONNECT_AFTER);
+      group = g_slice_new0 (ThunarFileCountGroup);
+      group->parent = g_object_ref (parent);
+      g_queue_init (&group->pending);
+      g_hash_table_insert (file_count_groups, group->parent, group);
     }
+  g_object_unref (parent);
 
-  exo_job_launch (EXO_JOB (job));
+  g_queue_push_tail (&group->pending, g_object_ref (file));
+  if (group->job == NULL)
+    thunar_file_count_group_start (group);
 
   return file->file_count;
 }
 
 
 
+/**
+ * thunar_file_has_file_count
+ * @file : a #ThunarFile instance.
+ *
+ * Whether the items of @file were counted at least once, i.e. whether
+ * the value of thunar_file_get_file_count() is more than a placeholder.
+ *
+ * Return value: %TRUE if the item count of @file is known.
+ **/
+gboolean
+thunar_file_has_file_count (const ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+
+  return file->file_count_timestamp != 0;
+}
+
+
+
 /**
  * thunar_file_set_file_count
  * @file: A #ThunarFileInstance
@@ -3692,7 +5159,6 @@ thunar_file_set_emblem_names (ThunarFile *file,
   GList      *lp;
   gchar     **emblems = NULL;
   gint        n;
-  GFileInfo  *info;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (G_IS_FILE_INFO (file->info));
@@ -3721,17 +5187,9 @@ thunar_file_set_emblem_names (ThunarFile *file,
   else
     g_file_info_set_attribute_stringv (file->info, "metadata::emblems", emblems);
 
-  /* send meta data to the daemon. this call is needed to store the new value of
+  /* queue the meta data for the daemon. this call is needed to store the new value of
    * the attribute in the file system */
-  info = g_file_info_new ();
-  g_file_info_set_attribute_stringv (info, "metadata::emblems", emblems);
-  g_file_set_attributes_async (file->gfile, info,
-                               G_FILE_QUERY_INFO_NONE,
-                               G_PRIORITY_DEFAULT,
-                               NULL,
-                               thunar_file_set_emblem_names_ready,
-                               file);
-  g_object_unref (G_OBJECT (info));
+  thunar_metadata_writer_set_attribute (file, "metadata::emblems", G_FILE_ATTRIBUTE_TYPE_STRINGV, emblems);
 
   g_strfreev (emblems);
 }
@@ -3769,6 +5227,9 @@ thunar_file_set_custom_icon (ThunarFile  *file,
   g_key_file_set_string (key_file, G_KEY_FILE_DESKTOP_GROUP,
                          G_KEY_FILE_DESKTOP_KEY_ICON, custom_icon);
 
+  /* the modification time may not change within the same second */
+  thunar_file_desktop_entry_forget (file);
+
   if (thunar_g_file_write_key_file (file->gfile, key_file, NULL, error))
     {
       /* tell everybody that we have changed */
@@ -4197,14 +5658,15 @@ thunar_file_get_icon_name (ThunarFile          *file,
     }
 
   /* store new name, fallback to legacy names, or empty string to avoid recursion */
-  g_free (file->icon_name);
   if (G_LIKELY (icon_name != NULL))
-    file->icon_name = icon_name;
+    file->icon_name = g_intern_string (icon_name);
   else if (file->kind == G_FILE_TYPE_DIRECTORY
            && gtk_icon_theme_has_icon (icon_theme, "folder"))
-    file->icon_name = g_strdup ("folder");
+    file->icon_name = g_intern_static_string ("folder");
   else
-    file->icon_name = g_strdup ("");
+    file->icon_name = g_intern_static_string ("");
+
+  g_free (icon_name);
 
   return thunar_file_get_icon_name_for_state (file->icon_name, icon_state);
 }
@@ -4249,6 +5711,11 @@ thunar_file_get_device_type (ThunarFile *file)
  * once. This also means that you MUST call thunar_file_unwatch()
  * for every thunar_file_watch() invokation, else the application
  * will abort.
+ *
+ * The number of file monitors is limited by a budget, see
+ * #ThunarPreferences:misc-file-watch-budget. Beyond it, the least
+ * recently watched files rely on the monitor of an open parent folder
+ * or are reloaded periodically, until a monitor becomes available.
  **/
 void
 thunar_file_watch (ThunarFile *file)
@@ -4261,14 +5728,12 @@ thunar_file_watch (ThunarFile *file)
   file_watch = g_object_get_qdata (G_OBJECT (file), thunar_file_watch_quark);
   if (file_watch == NULL)
     {
-      file_watch = g_slice_new (ThunarFileWatch);
+      file_watch = g_slice_new0 (ThunarFileWatch);
+      file_watch->file = file;
       file_watch->watch_count = 1;
+      file_watch->mode = THUNAR_FILE_WATCH_MONITOR;
 
-      /* create a file or directory monitor */
-      file_watch->monitor = g_file_monitor (file->gfile, G_FILE_MONITOR_WATCH_MOUNTS |
-                                            G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
-
-      if (G_UNLIKELY (file_watch->monitor == NULL))
+      if (G_UNLIKELY (!thunar_file_watch_connect (file_watch, &error)))
         {
           g_debug ("Failed to create file monitor: %s", error->message);
           g_error_free (error);
@@ -4276,8 +5741,10 @@ thunar_file_watch (ThunarFile *file)
         }
       else
         {
-          /* watch monitor for file changes */
-          g_signal_connect (file_watch->monitor, "changed", G_CALLBACK (thunar_file_monitor), file);
+          /* the most recent watch gets a monitor, which may degrade an older one */
+          file_watch->link.data = file_watch;
+          g_queue_push_head_link (&file_watch_monitored, &file_watch->link);
+          thunar_file_watch_balance ();
         }
 
       /* attach to file */
@@ -4286,8 +5753,18 @@ thunar_file_watch (ThunarFile *file)
   else if (G_LIKELY (!file->no_file_watch))
     {
       /* increase watch count */
-      _thunar_return_if_fail (G_IS_FILE_MONITOR (file_watch->monitor));
       file_watch->watch_count++;
+
+      /* watching again marks the file as recently used, e.g. a folder that is shown again */
+      if (file_watch->mode == THUNAR_FILE_WATCH_MONITOR)
+        {
+          g_queue_unlink (&file_watch_monitored, &file_watch->link);
+          g_queue_push_head_link (&file_watch_monitored, &file_watch->link);
+        }
+      else if (thunar_file_watch_promote (file_watch))
+        {
+          thunar_file_watch_balance ();
+        }
     }
 }
 
@@ -4349,26 +5826,324 @@ thunar_file_reload (ThunarFile *file)
 
   if (!thunar_file_load (file, NULL, NULL))
     {
-      /* destroy the file if we cannot query any file information */
-      thunar_file_destroy (file);
+      /* destroy the file if we cannot query any file information */
+      thunar_file_destroy (file);
+      return FALSE;
+    }
+
+  /* ... and tell others */
+  thunar_file_changed (file);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_file_has_partial_info:
+ * @file : a #ThunarFile instance.
+ *
+ * Whether the info of @file was loaded with the attributes of
+ * %THUNAR_FILE_INFO_FAST_NAMESPACE only, e.g. emblems, trash and
+ * preview attributes are missing.
+ *
+ * Return value: %TRUE if @file only has partial information.
+ **/
+gboolean
+thunar_file_has_partial_info (const ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  return FLAG_IS_SET (file, THUNAR_FILE_FLAG_PARTIAL_INFO);
+}
+
+
+
+/**
+ * thunar_file_update_info:
+ * @file : a #ThunarFile instance.
+ * @info : the complete #GFileInfo for @file.
+ *
+ * Replaces the information of @file with @info, which was queried
+ * for %THUNARX_FILE_INFO_NAMESPACE, and tells others about the
+ * change. This is used to complete files with partial information
+ * in the background.
+ **/
+void
+thunar_file_update_info (ThunarFile *file,
+                         GFileInfo  *info)
+{
+  ThunarFileCacheShard *shard;
+  gboolean              is_mounted;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
+
+  /* clear file pxmap cache */
+  thunar_icon_factory_clear_pixmap_cache (file);
+
+  /* the mount state is not part of the info */
+  is_mounted = FLAG_IS_SET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+
+  thunar_file_info_clear (file);
+  file->info = g_object_ref (info);
+  thunar_file_info_reload (file, NULL);
+
+  /* an earlier listing is outdated by now */
+  shard = thunar_file_cache_lock (file->gfile);
+  g_clear_object (&file->listed_info);
+  thunar_file_cache_unlock (shard);
+
+  if (!is_mounted)
+    FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+
+  /* ... and tell others */
+  thunar_file_changed (file);
+}
+
+
+
+/* whether @a and @b describe the same version of a file, i.e. the
+ * identity of the file, its type, size and modification time match */
+static gboolean
+thunar_file_info_same_version (GFileInfo *a,
+                               GFileInfo *b)
+{
+  static const gchar *attributes_uint32[] =
+  {
+    G_FILE_ATTRIBUTE_STANDARD_TYPE,
+    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+  };
+  static const gchar *attributes_uint64[] =
+  {
+    G_FILE_ATTRIBUTE_STANDARD_SIZE,
+    G_FILE_ATTRIBUTE_TIME_MODIFIED,
+    G_FILE_ATTRIBUTE_TIME_CHANGED,
+    G_FILE_ATTRIBUTE_UNIX_INODE,
+  };
+  guint n;
+
+  /* only compare what was queried for both */
+  for (n = 0; n < G_N_ELEMENTS (attributes_uint32); ++n)
+    if (g_file_info_has_attribute (a, attributes_uint32[n])
+        && g_file_info_has_attribute (b, attributes_uint32[n])
+        && g_file_info_get_attribute_uint32 (a, attributes_uint32[n]) != g_file_info_get_attribute_uint32 (b, attributes_uint32[n]))
+      return FALSE;
+
+  for (n = 0; n < G_N_ELEMENTS (attributes_uint64); ++n)
+    if (g_file_info_has_attribute (a, attributes_uint64[n])
+        && g_file_info_has_attribute (b, attributes_uint64[n])
+        && g_file_info_get_attribute_uint64 (a, attributes_uint64[n]) != g_file_info_get_attribute_uint64 (b, attributes_uint64[n]))
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_file_apply_listed_info:
+ * @file : a #ThunarFile instance.
+ *
+ * Compares the info of @file with the one seen by the latest listing
+ * of its parent folder, see thunar_file_get_with_info_batch(), and
+ * updates @file if they differ. This way reloading a folder only
+ * touches the files which genuinely changed. A listing with partial
+ * information queues a complete reload of @file instead.
+ *
+ * Return value: %TRUE if @file changed since it was loaded.
+ **/
+gboolean
+thunar_file_apply_listed_info (ThunarFile *file)
+{
+  ThunarFileCacheShard *shard;
+  GFileInfo            *info;
+  gboolean              partial;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+
+  shard = thunar_file_cache_lock (file->gfile);
+  info = g_steal_pointer (&file->listed_info);
+  partial = file->listed_info_partial;
+  thunar_file_cache_unlock (shard);
+
+  if (info == NULL)
+    return FALSE;
+
+  if (file->info != NULL && thunar_file_info_same_version (file->info, info))
+    {
+      g_object_unref (info);
+      return FALSE;
+    }
+
+  /* do not replace complete information with partial one */
+  if (partial && !thunar_file_has_partial_info (file))
+    thunar_file_reload_queue (file);
+  else
+    thunar_file_update_info (file, info);
+
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+
+
+static gboolean thunar_file_reload_queue_flush (gpointer user_data);
+
+
+
+static void
+thunar_file_reload_batch_finished (ThunarJob             *job,
+                                   ThunarFileReloadBatch *batch)
+{
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
+  gboolean              succeed;
+  gboolean              polled;
+  GList                *lp;
+  guint                 n;
+
+  _thunar_return_if_fail (reload_batch == batch);
+
+  for (lp = batch->files, n = 0; lp != NULL; lp = lp->next, n++)
+    {
+      file = THUNAR_FILE (lp->data);
+      polled = (file_watch_poll_pending != NULL && g_hash_table_remove (file_watch_poll_pending, file));
+
+      /* the job was cancelled before this one was queried */
+      if (batch->infos[n] == NULL && batch->errors[n] == NULL)
+        continue;
+
+      /* nothing to announce for watched files that did not change since the last poll */
+      if (polled && batch->infos[n] != NULL && file->info != NULL
+          && thunar_file_info_same_version (file->info, batch->infos[n]))
+        continue;
+
+      /* clear file pxmap cache */
+      thunar_icon_factory_clear_pixmap_cache (file);
+
+      shard = thunar_file_cache_lock (file->gfile);
+      succeed = thunar_file_load_from_info (file, shard, batch->infos[n], batch->errors[n], NULL, NULL);
+      thunar_file_cache_unlock (shard);
+
+      /* same as thunar_file_reload(), destroy the file if there is no information */
+      if (succeed)
+        thunar_file_changed (file);
+      else
+        thunar_file_destroy (file);
+    }
+
+  g_signal_handlers_disconnect_by_data (job, batch);
+  g_object_unref (job);
+
+  g_list_free_full (batch->files, g_object_unref);
+  g_free (batch->infos);
+  g_free (batch->errors);
+  g_slice_free (ThunarFileReloadBatch, batch);
+  reload_batch = NULL;
+
+  /* continue with the files queued meanwhile */
+  if (reload_queue != NULL && g_hash_table_size (reload_queue) > 0 && reload_queue_id == 0)
+    reload_queue_id = g_idle_add (thunar_file_reload_queue_flush, NULL);
+}
+
+
+
+static gboolean
+thunar_file_reload_queue_flush (gpointer user_data)
+{
+  ThunarFileReloadBatch *batch;
+  GHashTableIter         iter;
+  GHashTable            *siblings;
+  ThunarFile            *file;
+  GFile                 *parent;
+  GList                 *file_list = NULL;
+  GList                 *run;
+  GList                 *lp;
+  guint                  n = 0;
+
+  reload_queue_id = 0;
+
+  /* a single job at a time, so results are applied in the order they were queried */
+  if (reload_batch != NULL)
+    return FALSE;
+
+  /* take the next files from the queue, grouped by their parent folder */
+  siblings = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+  g_hash_table_iter_init (&iter, reload_queue);
+  while (n < THUNAR_FILE_RELOAD_BATCH_SIZE && g_hash_table_iter_next (&iter, (gpointer *) &file, NULL))
+    {
+      parent = g_file_get_parent (file->gfile);
+      if (parent == NULL)
+        parent = g_object_ref (file->gfile);
+
+      run = g_hash_table_lookup (siblings, parent);
+      g_hash_table_insert (siblings, parent, g_list_prepend (run, file));
+
+      /* the reference of the queue is passed on to the batch */
+      g_hash_table_iter_steal (&iter);
+      n++;
+    }
+
+  if (n == 0)
+    {
+      g_hash_table_destroy (siblings);
       return FALSE;
     }
 
-  /* ... and tell others */
-  thunar_file_changed (file);
+  batch = g_slice_new0 (ThunarFileReloadBatch);
 
-  return TRUE;
+  g_hash_table_iter_init (&iter, siblings);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &run))
+    batch->files = g_list_concat (run, batch->files);
+  g_hash_table_destroy (siblings);
+
+  for (lp = batch->files; lp != NULL; lp = lp->next)
+    file_list = g_list_prepend (file_list, THUNAR_FILE (lp->data)->gfile);
+  file_list = g_list_reverse (file_list);
+
+  batch->infos = g_new0 (GFileInfo *, n);
+  batch->errors = g_new0 (GError *, n);
+  batch->job = thunar_io_jobs_reload_files (file_list, batch->infos, batch->errors);
+  g_list_free (file_list);
+
+  reload_batch = batch;
+  g_signal_connect (batch->job, "finished", G_CALLBACK (thunar_file_reload_batch_finished), batch);
+  thunar_job_launch (batch->job);
+
+  return FALSE;
 }
 
 
 
-static gboolean
-thunar_file_reload_cb_once (gpointer user_data)
+/**
+ * thunar_file_reload_queue:
+ * @file : a #ThunarFile instance.
+ *
+ * Like thunar_file_reload() but the information is queried in the
+ * background, so it does not block on slow or remote file systems.
+ * Files queued multiple times are reloaded once, and files queued
+ * together are queried in batches, using a single enumeration of
+ * their parent folder if many siblings are reloaded at once. The
+ * ::changed signal is emitted once the new information was applied.
+ **/
+void
+thunar_file_reload_queue (ThunarFile *file)
 {
-  ThunarFile *file = user_data;
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  thunar_file_reload (file);
-  return FALSE;
+  if (G_UNLIKELY (reload_queue == NULL))
+    reload_queue = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  if (!g_hash_table_contains (reload_queue, file))
+    g_hash_table_add (reload_queue, g_object_ref (file));
+
+  /* an explicit reload always announces the file */
+  if (G_UNLIKELY (file_watch_poll_pending != NULL))
+    g_hash_table_remove (file_watch_poll_pending, file);
+
+  if (reload_queue_id == 0 && reload_batch == NULL)
+    reload_queue_id = g_idle_add (thunar_file_reload_queue_flush, NULL);
 }
 
 
@@ -4377,8 +6152,7 @@ thunar_file_reload_cb_once (gpointer user_data)
  * thunar_file_reload_idle:
  * @file : a #ThunarFile instance.
  *
- * Schedules a single reload of the @file by calling thunar_file_reload
- * when idle.
+ * Schedules a single reload of the @file, see thunar_file_reload_queue().
  *
  **/
 void
@@ -4386,7 +6160,7 @@ thunar_file_reload_idle (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add (thunar_file_reload_cb_once, file);
+  thunar_file_reload_queue (file);
 }
 
 
@@ -4395,9 +6169,8 @@ thunar_file_reload_idle (ThunarFile *file)
  * thunar_file_reload_idle_unref:
  * @file : a #ThunarFile instance.
  *
- * Schedules a reload of the @file by calling thunar_file_reload
- * when idle. When scheduled function returns @file object will be
- * unreferenced.
+ * Schedules a reload of the @file, see thunar_file_reload_queue(),
+ * and releases the reference of the caller on @file.
  *
  **/
 void
@@ -4405,10 +6178,8 @@ thunar_file_reload_idle_unref (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-                   thunar_file_reload_cb_once,
-                   file,
-                   (GDestroyNotify) g_object_unref);
+  thunar_file_reload_queue (file);
+  g_object_unref (file);
 }
 
 
@@ -4448,6 +6219,43 @@ thunar_file_destroy (ThunarFile *file)
 
 
 
+static void
+thunar_file_ensure_uri (ThunarFile *file)
+{
+  const gchar *slash;
+
+  if (G_LIKELY (file->uri != NULL))
+    return;
+
+  file->uri = g_file_get_uri (file->gfile);
+  file->uri_length = strlen (file->uri);
+
+  /* the parent ends before the last slash, except for the root of the
+   * location, whose uri ends with the slash, like "file:///" */
+  slash = strrchr (file->uri, '/');
+  if (slash == NULL || slash == file->uri)
+    file->uri_parent_length = 0;
+  else if (slash[-1] == '/')
+    file->uri_parent_length = slash - file->uri + 1;
+  else
+    file->uri_parent_length = slash - file->uri;
+}
+
+
+
+static gboolean
+thunar_file_uri_has_prefix (const ThunarFile *file,
+                            const gchar      *prefix,
+                            gsize             prefix_length)
+{
+  return prefix_length > 0
+      && prefix_length < file->uri_length
+      && strncmp (file->uri, prefix, prefix_length) == 0
+      && (prefix[prefix_length - 1] == '/' || file->uri[prefix_length] == '/');
+}
+
+
+
 /**
  * thunar_file_compare_by_type:
  * @a : the first #ThunarFile.
@@ -4463,17 +6271,13 @@ gint
 thunar_file_compare_by_type (ThunarFile *a,
                              ThunarFile *b)
 {
-  GFile *file_a;
-  GFile *file_b;
-  GFile *parent_a;
-  GFile *parent_b;
-  gint   ret = 0;
-
-  file_a = thunar_file_get_file (a);
-  file_b = thunar_file_get_file (b);
+  /* the uris are kept with the files, so sorting long lists of files
+   * does not ask for their parents in every comparison */
+  thunar_file_ensure_uri (a);
+  thunar_file_ensure_uri (b);
 
   /* check whether the files are equal */
-  if (g_file_equal (file_a, file_b))
+  if (a->uri_length == b->uri_length && strcmp (a->uri, b->uri) == 0)
     return 0;
 
   /* directories always come first */
@@ -4489,29 +6293,26 @@ thunar_file_compare_by_type (ThunarFile *a,
     }
 
   /* ancestors come first */
-  if (g_file_has_prefix (file_b, file_a))
+  if (thunar_file_uri_has_prefix (b, a->uri, a->uri_length))
     return -1;
-  if (g_file_has_prefix (file_a, file_b))
+  if (thunar_file_uri_has_prefix (a, b->uri, b->uri_length))
     return 1;
 
-  parent_a = g_file_get_parent (file_a);
-  parent_b = g_file_get_parent (file_b);
-
-  if (g_file_equal (parent_a, parent_b))
+  if (a->uri_parent_length == b->uri_parent_length
+      && strncmp (a->uri, b->uri, a->uri_parent_length) == 0)
     {
       /* compare siblings by their display name */
-      ret = g_utf8_collate (a->display_name,
-                            b->display_name);
+      return g_utf8_collate (a->display_name,
+                             b->display_name);
     }
+
   /* again, ancestors come first */
-  else if (g_file_has_prefix (file_b, parent_a))
-      ret = -1;
-  else if (g_file_has_prefix (file_a, parent_b))
-      ret = 1;
+  if (thunar_file_uri_has_prefix (b, a->uri, a->uri_parent_length))
+    return -1;
+  if (thunar_file_uri_has_prefix (a, b->uri, b->uri_parent_length))
+    return 1;
 
-  g_object_unref (parent_a);
-  g_object_unref (parent_b);
-  return ret;
+  return 0;
 }
 
 
@@ -4543,13 +6344,21 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_b), 0);
 #endif
 
-  /* case insensitive checking */
+  /* case insensitive checking, most names differ in the first bytes */
   if (G_LIKELY (!case_sensitive))
-    result = g_strcmp0 (file_a->collate_key_nocase, file_b->collate_key_nocase);
+    {
+      if (file_a->collate_prefix_nocase != file_b->collate_prefix_nocase)
+        return file_a->collate_prefix_nocase < file_b->collate_prefix_nocase ? -1 : 1;
+      result = g_strcmp0 (file_a->collate_key_nocase, file_b->collate_key_nocase);
+    }
 
   /* fall-back to case sensitive */
   if (result == 0)
-    result = g_strcmp0 (file_a->collate_key, file_b->collate_key);
+    {
+      if (file_a->collate_prefix != file_b->collate_prefix)
+        return file_a->collate_prefix < file_b->collate_prefix ? -1 : 1;
+      result = g_strcmp0 (file_a->collate_key, file_b->collate_key);
+    }
 
   /* this happens in the trash */
   if (result == 0)
@@ -4563,6 +6372,73 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
 
 
 
+/**
+ * thunar_file_get_collate_key:
+ * @file           : a #ThunarFile instance.
+ * @case_sensitive : whether the case sensitive key is requested.
+ *
+ * Returns the collation key which is compared first by
+ * thunar_file_compare_by_name() for the given @case_sensitive
+ * mode. The returned string is owned by @file.
+ *
+ * Return value: the collation key of @file, may be %NULL.
+ **/
+const gchar *
+thunar_file_get_collate_key (const ThunarFile *file,
+                             gboolean          case_sensitive)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+  return case_sensitive ? file->collate_key : file->collate_key_nocase;
+}
+
+
+
+/**
+ * thunar_file_get_collate_prefix:
+ * @file           : a #ThunarFile instance.
+ * @case_sensitive : whether the case sensitive key is requested.
+ *
+ * Returns the first bytes of thunar_file_get_collate_key() packed
+ * into an integer, so that comparing the prefixes of two files gives
+ * the same order as comparing the beginning of their keys.
+ *
+ * Return value: the collation key prefix of @file.
+ **/
+guint64
+thunar_file_get_collate_prefix (const ThunarFile *file,
+                                gboolean          case_sensitive)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), 0);
+  return case_sensitive ? file->collate_prefix : file->collate_prefix_nocase;
+}
+
+
+
+/**
+ * thunar_file_get_search_name:
+ * @file : a #ThunarFile instance.
+ *
+ * Returns the display name of @file normalized for searching, see
+ * thunar_g_utf8_normalize_for_search(). It is computed on the first
+ * call and kept until the info of @file changes, so filtering many
+ * files repeatedly does not normalize their names over and over.
+ * The returned string is owned by @file.
+ *
+ * Return value: the normalized display name of @file, may be %NULL.
+ **/
+const gchar *
+thunar_file_get_search_name (ThunarFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+
+  if (G_UNLIKELY (file->search_name == NULL && file->display_name != NULL))
+    file->search_name = thunar_g_utf8_normalize_for_search (file->display_name, TRUE, TRUE);
+
+  return file->search_name;
+}
+
+
+
 static gboolean
 thunar_file_same_filesystem (const ThunarFile *file_a,
                              const ThunarFile *file_b)
@@ -4610,36 +6486,173 @@ thunar_file_same_filesystem (const ThunarFile *file_a,
 ThunarFile *
 thunar_file_cache_lookup (const GFile *file)
 {
-  GWeakRef   *ref;
-  ThunarFile *cached_file;
+  ThunarFileCacheShard *shard;
+  GWeakRef             *ref;
+  ThunarFile           *cached_file;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  G_REC_LOCK (file_cache_mutex);
-
-  /* allocate the ThunarFile cache on-demand */
-  if (G_UNLIKELY (file_cache == NULL))
-    {
-      file_cache = g_hash_table_new_full (g_file_hash,
-                                          (GEqualFunc) g_file_equal,
-                                          (GDestroyNotify) g_object_unref,
-                                          (GDestroyNotify) weak_ref_free);
-    }
+  shard = thunar_file_cache_lock (file);
 
-  ref = g_hash_table_lookup (file_cache, file);
+  ref = g_hash_table_lookup (shard->table, file);
 
   if (ref == NULL)
     cached_file = NULL;
   else
     cached_file = g_weak_ref_get (ref);
 
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   return cached_file;
 }
 
 
 
+/**
+ * thunar_file_cache_get_size:
+ *
+ * Return value: the number of #ThunarFile<!---->s in the internal file cache.
+ **/
+guint
+thunar_file_cache_get_size (void)
+{
+  guint n_files = 0;
+  guint n;
+
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      g_rec_mutex_lock (&file_cache[n].mutex);
+      if (file_cache[n].table != NULL)
+        n_files += g_hash_table_size (file_cache[n].table);
+      g_rec_mutex_unlock (&file_cache[n].mutex);
+    }
+
+  return n_files;
+}
+
+
+
+/* a rough estimate of the memory held by @info */
+static guint64
+thunar_file_info_get_size (GFileInfo *info)
+{
+  gchar  **attributes;
+  guint64  size;
+  guint    n;
+
+  /* the attributes are small structs with the value inline, or
+   * pointing to a string which is about as long as the name */
+  attributes = g_file_info_list_attributes (info, NULL);
+  size = sizeof (GObject) + 2 * sizeof (gpointer);
+  for (n = 0; attributes[n] != NULL; ++n)
+    size += 3 * sizeof (gpointer) + 2 * strlen (attributes[n]);
+  g_strfreev (attributes);
+
+  return size;
+}
+
+
+
+static void
+thunar_file_census_add (GHashTable *census,
+                        ThunarFile *file)
+{
+  ThunarFileCensus *entry;
+  GFile            *parent;
+  gchar            *name;
+  GFileInfo        *infos[3] = { file->info, file->recent_info, file->listed_info };
+  guint             n;
+
+  /* files are counted per folder, the roots by themselves */
+  parent = g_file_get_parent (file->gfile);
+  name = g_file_get_uri (parent != NULL ? parent : file->gfile);
+  if (parent != NULL)
+    g_object_unref (parent);
+
+  entry = g_hash_table_lookup (census, name);
+  if (entry == NULL)
+    {
+      entry = g_new0 (ThunarFileCensus, 1);
+      g_hash_table_insert (census, name, entry);
+    }
+  else
+    {
+      g_free (name);
+    }
+
+  entry->n_files += 1;
+  entry->file_bytes += sizeof (ThunarFile);
+  if (file->strings != NULL)
+    entry->file_bytes += 2 * (strlen (file->display_name) + strlen (file->collate_key) + 2);
+  if (file->search_name != NULL)
+    entry->file_bytes += strlen (file->search_name) + 1;
+  if (file->uri != NULL)
+    entry->file_bytes += file->uri_length + 1;
+  if (file->thumbnail_path != NULL)
+    entry->file_bytes += strlen (file->thumbnail_path) + 1;
+
+  for (n = 0; n < G_N_ELEMENTS (infos); ++n)
+    if (infos[n] != NULL)
+      {
+        entry->n_infos += 1;
+        entry->info_bytes += thunar_file_info_get_size (infos[n]);
+      }
+}
+
+
+
+/**
+ * thunar_file_cache_get_census:
+ *
+ * Counts the #ThunarFile<!---->s in the internal file cache and their
+ * #GFileInfo<!---->s, with an estimate of the memory they hold, to find
+ * out what a long running instance keeps alive.
+ *
+ * Return value: (transfer full): a #GHashTable mapping the uris of the
+ *               folders to the #ThunarFileCensus of their files, free
+ *               it with g_hash_table_destroy().
+ **/
+GHashTable *
+thunar_file_cache_get_census (void)
+{
+  GHashTableIter iter;
+  GHashTable    *census;
+  GPtrArray     *files;
+  ThunarFile    *file;
+  gpointer       ref;
+  guint          n;
+
+  /* take the files out of the locks first, the uris of the parents
+   * are looked up afterwards */
+  files = g_ptr_array_new_with_free_func (g_object_unref);
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      g_rec_mutex_lock (&file_cache[n].mutex);
+      if (file_cache[n].table != NULL)
+        {
+          g_hash_table_iter_init (&iter, file_cache[n].table);
+          while (g_hash_table_iter_next (&iter, NULL, &ref))
+            {
+              file = g_weak_ref_get (ref);
+              if (file != NULL)
+                g_ptr_array_add (files, file);
+            }
+        }
+      g_rec_mutex_unlock (&file_cache[n].mutex);
+    }
+
+  census = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  for (n = 0; n < files->len; ++n)
+    thunar_file_census_add (census, g_ptr_array_index (files, n));
+
+  /* the last references may be released here and lock the cache again */
+  g_ptr_array_unref (files);
+
+  return census;
+}
+
+
+
 gchar *
 thunar_file_cached_display_name (const GFile *file)
 {
@@ -4674,6 +6687,70 @@ compare_app_infos (gconstpointer a,
 
 
 
+static void
+thunar_file_applications_free (gpointer data)
+{
+  g_list_free_full (data, g_object_unref);
+}
+
+
+
+static void
+thunar_file_applications_changed (GAppInfoMonitor *monitor,
+                                  GHashTable      *applications)
+{
+  /* the applications or their associations changed */
+  g_hash_table_remove_all (applications);
+}
+
+
+
+static GList*
+thunar_file_get_applications_for_type (const gchar *content_type)
+{
+  static GHashTable *type_applications = NULL;
+  GAppInfo          *default_application;
+  GList             *list;
+  GList             *ap;
+
+  /* the applications of each content type (interned), with the default application in
+   * front, are kept until the installed applications or the associations change */
+  if (G_UNLIKELY (type_applications == NULL))
+    {
+      type_applications = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, thunar_file_applications_free);
+      g_signal_connect (G_OBJECT (g_app_info_monitor_get ()), "changed",
+                        G_CALLBACK (thunar_file_applications_changed), type_applications);
+    }
+
+  content_type = g_intern_string (content_type);
+  if (g_hash_table_lookup_extended (type_applications, content_type, NULL, (gpointer) &list))
+    return list;
+
+  list = g_app_info_get_all_for_type (content_type);
+
+  /* move any default application in front of the list */
+  default_application = g_app_info_get_default_for_type (content_type, FALSE);
+  if (G_LIKELY (default_application != NULL))
+    {
+      for (ap = list; ap != NULL; ap = ap->next)
+        {
+          if (g_app_info_equal (ap->data, default_application))
+            {
+              g_object_unref (ap->data);
+              list = g_list_delete_link (list, ap);
+              break;
+            }
+        }
+      list = g_list_prepend (list, default_application);
+    }
+
+  g_hash_table_insert (type_applications, (gpointer) content_type, list);
+
+  return list;
+}
+
+
+
 /**
  * thunar_file_list_get_applications:
  * @file_list : a #GList of #ThunarFile<!---->s.
@@ -4692,59 +6769,59 @@ compare_app_infos (gconstpointer a,
 GList*
 thunar_file_list_get_applications (GList *file_list)
 {
+  GHashTable  *seen_types;
+  GHashTable  *app_ids;
   GList       *applications = NULL;
+  GList       *types = NULL;
   GList       *list;
   GList       *next;
   GList       *ap;
   GList       *lp;
-  GAppInfo    *default_application;
-  const gchar *previous_type = NULL;
+  GList       *tp;
   const gchar *current_type;
+  const gchar *id;
+  gboolean     has_type = TRUE;
 
-  /* determine the set of applications that can open all files */
+  /* every content type of the files only needs to be looked at once */
+  seen_types = g_hash_table_new (g_direct_hash, g_direct_equal);
   for (lp = file_list; lp != NULL; lp = lp->next)
     {
       current_type = thunar_file_get_content_type (lp->data);
-
-      /* no need to check anything if this file has the same mimetype as the previous file */
-      if (current_type != NULL && previous_type != NULL)
-        if (G_LIKELY (g_content_type_equals (previous_type, current_type)))
-          continue;
-
-      /* store the previous type */
-      previous_type = current_type;
-
-      /* determine the list of applications that can open this file */
-      if (G_UNLIKELY (current_type != NULL))
+      if (G_UNLIKELY (current_type == NULL))
         {
-          list = g_app_info_get_all_for_type (current_type);
-
-          /* move any default application in front of the list */
-          default_application = g_app_info_get_default_for_type (current_type, FALSE);
-          if (G_LIKELY (default_application != NULL))
-            {
-              for (ap = list; ap != NULL; ap = ap->next)
-                {
-                  if (g_app_info_equal (ap->data, default_application))
-                    {
-                      g_object_unref (ap->data);
-                      list = g_list_delete_link (list, ap);
-                      break;
-                    }
-                }
-              list = g_list_prepend (list, default_application);
-            }
+          /* no application is known to open this file */
+          has_type = FALSE;
+          break;
         }
-      else
-        list = NULL;
 
-      if (G_UNLIKELY (applications == NULL))
+      current_type = g_intern_string (current_type);
+      if (g_hash_table_add (seen_types, (gpointer) current_type))
+        types = g_list_prepend (types, (gpointer) current_type);
+    }
+  g_hash_table_destroy (seen_types);
+  types = g_list_reverse (types);
+
+  /* determine the set of applications that can open all files */
+  for (tp = has_type ? types : NULL; tp != NULL; tp = tp->next)
+    {
+      list = thunar_file_get_applications_for_type (tp->data);
+
+      if (G_UNLIKELY (tp == types))
         {
-          /* first file, so just use the applications list */
-          applications = list;
+          /* first type, so just use its applications */
+          applications = g_list_copy_deep (list, (GCopyFunc) (void (*)(void)) g_object_ref, NULL);
         }
       else
         {
+          /* the ids of the applications for this type */
+          app_ids = g_hash_table_new (g_str_hash, g_str_equal);
+          for (ap = list; ap != NULL; ap = ap->next)
+            {
+              id = g_app_info_get_id (ap->data);
+              if (G_LIKELY (id != NULL))
+                g_hash_table_add (app_ids, (gpointer) id);
+            }
+
           /* keep only the applications that are also present in list */
           for (ap = applications; ap != NULL; ap = next)
             {
@@ -4752,7 +6829,8 @@ thunar_file_list_get_applications (GList *file_list)
               next = ap->next;
 
               /* check if the application is present in list */
-              if (g_list_find_custom (list, ap->data, compare_app_infos) == NULL)
+              id = g_app_info_get_id (ap->data);
+              if (id != NULL ? !g_hash_table_contains (app_ids, id) : g_list_find_custom (list, ap->data, compare_app_infos) == NULL)
                 {
                   /* drop our reference on the application */
                   g_object_unref (G_OBJECT (ap->data));
@@ -4762,14 +6840,14 @@ thunar_file_list_get_applications (GList *file_list)
                 }
             }
 
-          /* release the list of applications for this file */
-          g_list_free_full (list, g_object_unref);
+          g_hash_table_destroy (app_ids);
         }
 
       /* check if the set is still not empty */
       if (G_LIKELY (applications == NULL))
         break;
     }
+  g_list_free (types);
 
   /* remove hidden applications */
   for (ap = applications; ap != NULL; ap = next)
@@ -4832,50 +6910,13 @@ const gchar*
 thunar_file_get_metadata_setting (ThunarFile  *file,
                                   const gchar *setting_name)
 {
-  gchar       *attr_name;
-  const gchar *attr_value;
-
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
   if (file->info == NULL)
     return NULL;
 
-  /* convert the setting name to an attribute name */
-  attr_name = g_strdup_printf ("metadata::thunar-%s", setting_name);
-
-  if (!g_file_info_has_attribute (file->info, attr_name))
-    {
-      g_free (attr_name);
-      return NULL;
-    }
-
-  attr_value = g_file_info_get_attribute_string (file->info, attr_name);
-  g_free (attr_name);
-
-  return attr_value;
-}
-
-
-
-static void
-thunar_file_set_metadata_setting_finish (GObject      *source_object,
-                                         GAsyncResult *result,
-                                         gpointer      user_data)
-{
-  ThunarFile *file = NULL;
-  GError     *error = NULL;
-
-  if (THUNAR_IS_FILE (user_data))
-    file = THUNAR_FILE (user_data);
-
-  if (!g_file_set_attributes_finish (G_FILE (source_object), result, NULL, &error))
-    {
-      g_warning ("Failed to set metadata: %s", error->message);
-      g_error_free (error);
-    }
-
-  if (file != NULL)
-    thunar_file_changed (file);
+  /* %NULL if the attribute is not set */
+  return g_file_info_get_attribute_string (file->info, thunar_file_metadata_attr_name (setting_name));
 }
 
 
@@ -4885,7 +6926,7 @@ thunar_file_set_metadata_setting_finish (GObject      *source_object,
  * @file          : a #ThunarFile instance.
  * @setting_name  : the name of the setting to set
  * @setting_value : the value to set
- * @async         : whether g_file_set_attributes_async or g_file_set_attributes_from_info should be used
+ * @async         : whether the value may be written behind or has to be stored before returning
  *
  * Sets the setting @setting_name of @file to @setting_value and stores it in
  * the @file<!---->s metadata.
@@ -4896,41 +6937,24 @@ thunar_file_set_metadata_setting (ThunarFile  *file,
                                   const gchar *setting_value,
                                   gboolean     async)
 {
-  GFileInfo *info;
-  gchar     *attr_name;
+  const gchar *attr_name;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (G_IS_FILE_INFO (file->info));
 
   /* convert the setting name to an attribute name */
-  attr_name = g_strdup_printf ("metadata::thunar-%s", setting_name);
+  attr_name = thunar_file_metadata_attr_name (setting_name);
 
   /* set the value in the current info. this call is needed to update the in-memory
    * GFileInfo structure to ensure that the new attribute value is available immediately */
   g_file_info_set_attribute_string (file->info, attr_name, setting_value);
+  thunar_file_update_dir_settings_flag (file);
 
-  /* send meta data to the daemon. this call is needed to store the new value of
+  /* queue the meta data for the daemon. this call is needed to store the new value of
    * the attribute in the file system */
-  info = g_file_info_new ();
-  g_file_info_set_attribute_string (info, attr_name, setting_value);
-  if (async)
-    {
-      g_file_set_attributes_async (file->gfile, info,
-                                   G_FILE_QUERY_INFO_NONE,
-                                   G_PRIORITY_DEFAULT,
-                                   NULL,
-                                   thunar_file_set_metadata_setting_finish,
-                                   file);
-    }
-  else
-    {
-      g_file_set_attributes_from_info (file->gfile, info,
-                                       G_FILE_QUERY_INFO_NONE,
-                                       NULL,
-                                       NULL);
-    }
-  g_free (attr_name);
-  g_object_unref (G_OBJECT (info));
+  thunar_metadata_writer_set_attribute (file, attr_name, G_FILE_ATTRIBUTE_TYPE_STRING, (gpointer) setting_value);
+  if (!async)
+    thunar_metadata_writer_flush ();
 }
 
 
@@ -4946,7 +6970,7 @@ void
 thunar_file_clear_metadata_setting (ThunarFile  *file,
                                      const gchar *setting_name)
 {
-  gchar     *attr_name;
+  const gchar *attr_name;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
@@ -4954,18 +6978,15 @@ thunar_file_clear_metadata_setting (ThunarFile  *file,
     return;
 
   /* convert the setting name to an attribute name */
-  attr_name = g_strdup_printf ("metadata::thunar-%s", setting_name);
+  attr_name = thunar_file_metadata_attr_name (setting_name);
 
   if (!g_file_info_has_attribute (file->info, attr_name))
-    {
-      g_free (attr_name);
-      return;
-    }
+    return;
 
   g_file_info_remove_attribute (file->info, attr_name);
-  g_file_set_attribute (file->gfile, attr_name, G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_free (attr_name);
+  thunar_file_update_dir_settings_flag (file);
+
+  thunar_metadata_writer_set_attribute (file, attr_name, G_FILE_ATTRIBUTE_TYPE_INVALID, NULL);
 }
 
 
@@ -4979,30 +7000,58 @@ thunar_file_clear_metadata_setting (ThunarFile  *file,
 void
 thunar_file_clear_directory_specific_settings (ThunarFile *file)
 {
+  guint n;
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   if (file->info == NULL)
     return;
 
-  g_file_info_remove_attribute (file->info, "metadata::thunar-view-type");
-  g_file_info_remove_attribute (file->info, "metadata::thunar-sort-column");
-  g_file_info_remove_attribute (file->info, "metadata::thunar-sort-order");
-  g_file_info_remove_attribute (file->info, "metadata::thunar-zoom-level");
+  for (n = 0; n < THUNAR_FILE_N_DIRECTORY_SETTINGS; ++n)
+    {
+      g_file_info_remove_attribute (file->info, thunar_file_metadata_attrs[n].attr_name);
+      thunar_metadata_writer_set_attribute (file, thunar_file_metadata_attrs[n].attr_name,
+                                            G_FILE_ATTRIBUTE_TYPE_INVALID, NULL);
+    }
 
-  g_file_set_attribute (file->gfile, "metadata::thunar-view-type", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_file_set_attribute (file->gfile, "metadata::thunar-sort-column", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_file_set_attribute (file->gfile, "metadata::thunar-sort-order", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  g_file_set_attribute (file->gfile, "metadata::thunar-zoom-level", G_FILE_ATTRIBUTE_TYPE_INVALID,
-                        NULL, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_DIR_SETTINGS);
 
   thunar_file_changed (file);
 }
 
 
 
+/**
+ * thunar_file_discard_metadata:
+ * @file       : a #ThunarFile instance.
+ * @attributes : a #GFileInfo with the attributes to discard.
+ *
+ * Removes the attributes listed in @attributes from the in-memory info
+ * of @file, after they could not be stored in the metadata daemon.
+ **/
+void
+thunar_file_discard_metadata (ThunarFile *file,
+                              GFileInfo  *attributes)
+{
+  gchar **names;
+  guint   n;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (attributes));
+
+  if (file->info == NULL)
+    return;
+
+  names = g_file_info_list_attributes (attributes, NULL);
+  for (n = 0; names != NULL && names[n] != NULL; ++n)
+    g_file_info_remove_attribute (file->info, names[n]);
+  g_strfreev (names);
+
+  thunar_file_update_dir_settings_flag (file);
+}
+
+
+
 /**
  * thunar_file_has_directory_specific_settings:
  * @file : a #ThunarFile instance.
@@ -5016,17 +7065,6 @@ thunar_file_has_directory_specific_settings (ThunarFile *file)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
 
-  if (file->info == NULL)
-    return FALSE;
-
-  if (g_file_info_has_attribute (file->info, "metadata::thunar-view-type"))
-    return TRUE;
-  if (g_file_info_has_attribute (file->info, "metadata::thunar-sort-column"))
-    return TRUE;
-  if (g_file_info_has_attribute (file->info, "metadata::thunar-sort-order"))
-    return TRUE;
-  if (g_file_info_has_attribute (file->info, "metadata::thunar-zoom-level"))
-    return TRUE;
-
-  return FALSE;
+  /* computed when the info is loaded */
+  return FLAG_IS_SET (file, THUNAR_FILE_FLAG_DIR_SETTINGS);
 }
@@ -105,6 +105,22 @@ typedef enum /*< flags >*/
 
 
 
+/* subset of THUNARX_FILE_INFO_NAMESPACE which is needed to display and
+ * sort the files, without the attributes that are slow to query on
+ * remote locations (metadata, previews and trash info) */
+#define THUNAR_FILE_INFO_FAST_NAMESPACE \
+  "access::*," \
+  "id::filesystem," \
+  "mountable::can-mount,standard::target-uri," \
+  "standard::type,standard::is-hidden,standard::is-backup," \
+  "standard::is-symlink,standard::name,standard::display-name," \
+  "standard::size,standard::symlink-target," \
+  "time::*," \
+  "recent::*," \
+  "unix::gid,unix::uid,unix::mode"
+
+
+
 /**
  * ThunarFileGetFunc:
  *
@@ -117,6 +133,32 @@ typedef void (*ThunarFileGetFunc) (GFile      *location,
                                    GError     *error,
                                    gpointer    user_data);
 
+/**
+ * ThunarFileCountFunc:
+ *
+ * Callback type to be notified when the item count of a folder,
+ * queued by thunar_file_get_file_count(), is known.
+ **/
+typedef void (*ThunarFileCountFunc) (ThunarFile *file,
+                                     gpointer    user_data);
+
+/**
+ * ThunarFileCensus:
+ * @n_files    : number of #ThunarFile<!---->s.
+ * @file_bytes : estimated memory held by the files themselves.
+ * @n_infos    : number of #GFileInfo<!---->s of the files.
+ * @info_bytes : estimated memory held by the infos.
+ *
+ * The files of a folder in the file cache, see thunar_file_cache_get_census().
+ **/
+typedef struct
+{
+  guint64 n_files;
+  guint64 file_bytes;
+  guint64 n_infos;
+  guint64 info_bytes;
+} ThunarFileCensus;
+
 
 
 GType             thunar_file_get_type                   (void) G_GNUC_CONST;
@@ -127,6 +169,13 @@ ThunarFile       *thunar_file_get_with_info              (GFile
                                                           GFileInfo              *info,
                                                           GFileInfo              *recent_info,
                                                           gboolean                not_mounted);
+GList            *thunar_file_get_with_info_batch        (GFile                 **files,
+                                                          GFileInfo             **infos,
+                                                          GFileInfo             **recent_infos,
+                                                          const gboolean         *not_mounted,
+                                                          const gboolean         *partial_info,
+                                                          guint                   n_files,
+                                                          gboolean                listing);
 ThunarFile       *thunar_file_get_for_uri                (const gchar            *uri,
                                                           GError                **error);
 void              thunar_file_get_async                  (GFile                  *location,
@@ -165,6 +214,11 @@ GdkDragAction     thunar_file_accepts_drop               (ThunarFile
                                                           GList                  *path_list,
                                                           GdkDragContext         *context,
                                                           GdkDragAction          *suggested_action_return);
+GdkDragAction     thunar_file_accepts_drop_sample        (ThunarFile             *file,
+                                                          GList                  *path_list,
+                                                          guint                   n_sample,
+                                                          GdkDragContext         *context,
+                                                          GdkDragAction          *suggested_action_return);
 
 guint64           thunar_file_get_date                   (const ThunarFile       *file,
                                                           ThunarFileDateType      date_type) G_GNUC_PURE;
@@ -185,10 +239,17 @@ GVolume          *thunar_file_get_volume                 (const ThunarFile
 
 ThunarGroup      *thunar_file_get_group                  (const ThunarFile       *file);
 ThunarUser       *thunar_file_get_user                   (const ThunarFile       *file);
+void              thunar_file_prefetch_owner             (const ThunarFile       *file);
 
 const gchar      *thunar_file_get_content_type           (ThunarFile             *file);
+const gchar      *thunar_file_peek_content_type          (const ThunarFile       *file);
 gchar            *thunar_file_get_content_type_desc      (ThunarFile             *file);
+const gchar      *thunar_file_peek_content_type_desc     (ThunarFile             *file);
+guint64           thunar_file_get_content_type_desc_prefix (ThunarFile             *file,
+                                                            gboolean                case_sensitive);
 gboolean          thunar_file_load_content_type          (ThunarFile             *file);
+void              thunar_file_set_content_type           (ThunarFile             *file,
+                                                          const gchar            *content_type);
 const gchar      *thunar_file_get_symlink_target         (const ThunarFile       *file);
 const gchar      *thunar_file_get_basename               (const ThunarFile       *file) G_GNUC_CONST;
 gboolean          thunar_file_is_symlink                 (const ThunarFile       *file);
@@ -236,8 +297,9 @@ gboolean          thunar_file_can_be_trashed             (const ThunarFile
 
 
 guint             thunar_file_get_file_count             (ThunarFile             *file,
-                                                          GCallback               callback,
-                                                          gpointer                data);
+                                                          ThunarFileCountFunc     func,
+                                                          gpointer                user_data);
+gboolean          thunar_file_has_file_count             (const ThunarFile       *file);
 void              thunar_file_set_file_count             (ThunarFile             *file,
                                                           const guint             count);
 
@@ -266,8 +328,18 @@ const gchar      *thunar_file_get_device_type            (ThunarFile
 
 void              thunar_file_watch                      (ThunarFile              *file);
 void              thunar_file_unwatch                    (ThunarFile              *file);
+void              thunar_file_watch_add_directory_monitor    (GFile                   *directory);
+void              thunar_file_watch_remove_directory_monitor (GFile                   *directory);
+guint             thunar_file_watch_get_state            (guint                   *n_monitors,
+                                                          guint                   *n_shared,
+                                                          guint                   *n_polled);
 
 gboolean          thunar_file_reload                     (ThunarFile              *file);
+gboolean          thunar_file_has_partial_info           (const ThunarFile        *file);
+void              thunar_file_update_info                (ThunarFile              *file,
+                                                          GFileInfo               *info);
+gboolean          thunar_file_apply_listed_info          (ThunarFile              *file);
+void              thunar_file_reload_queue               (ThunarFile              *file);
 void              thunar_file_reload_idle                (ThunarFile              *file);
 void              thunar_file_reload_idle_unref          (ThunarFile              *file);
 void              thunar_file_reload_parent              (ThunarFile              *file);
@@ -279,8 +351,15 @@ gint              thunar_file_compare_by_type            (ThunarFile
 gint              thunar_file_compare_by_name            (const ThunarFile        *file_a,
                                                           const ThunarFile        *file_b,
                                                           gboolean                 case_sensitive) G_GNUC_PURE;
+const gchar      *thunar_file_get_collate_key            (const ThunarFile        *file,
+                                                          gboolean                 case_sensitive) G_GNUC_PURE;
+guint64           thunar_file_get_collate_prefix         (const ThunarFile        *file,
+                                                          gboolean                 case_sensitive) G_GNUC_PURE;
+const gchar      *thunar_file_get_search_name            (ThunarFile              *file);
 
 ThunarFile       *thunar_file_cache_lookup               (const GFile             *file);
+guint             thunar_file_cache_get_size             (void);
+GHashTable       *thunar_file_cache_get_census           (void);
 gchar            *thunar_file_cached_display_name        (const GFile             *file);
 
 
@@ -298,6 +377,8 @@ void              thunar_file_set_metadata_setting       (ThunarFile
 void              thunar_file_clear_metadata_setting     (ThunarFile             *file,
                                                           const gchar            *setting_name);
 void              thunar_file_clear_directory_specific_settings (ThunarFile      *file);
+void              thunar_file_discard_metadata           (ThunarFile             *file,
+                                                          GFileInfo              *attributes);
 gboolean          thunar_file_has_directory_specific_settings   (ThunarFile      *file);
 
 /**
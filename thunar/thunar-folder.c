@@ -22,6 +22,10 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <libxfce4util/libxfce4util.h>
 
 #include <thunar/thunar-file-monitor.h>
@@ -29,10 +33,26 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-size-cache.h>
+#include <thunar/thunar-stats.h>
+#include <thunar/thunar-trace.h>
 
 #define DEBUG_FILE_CHANGES FALSE
 
+/* estimated memory of a folder and each of its files in the keep-alive pool */
+#define THUNAR_FOLDER_POOL_FOLDER_SIZE (4 * 1024)
+#define THUNAR_FOLDER_POOL_FILE_SIZE   (1024)
+
+/* the number of unused folders in the pool that keep their file monitor */
+#define THUNAR_FOLDER_POOL_MAX_MONITORS 16
+
+/* interval in seconds in which folders without reliable change notifications
+ * are checked, the interval grows while no Thunar window is focused */
+#define THUNAR_FOLDER_POLL_MIN_INTERVAL (2)
+#define THUNAR_FOLDER_POLL_MAX_INTERVAL (60)
+
 
 
 /* property identifiers */
@@ -40,6 +60,7 @@ enum
 {
   PROP_0,
   PROP_CORRESPONDING_FILE,
+  PROP_FOLDERS_ONLY,
   PROP_LOADING,
 };
 
@@ -74,9 +95,8 @@ static gboolean thunar_folder_files_ready                 (ThunarJob
                                                            ThunarFolder           *folder);
 static void     thunar_folder_finished                    (ExoJob                 *job,
                                                            ThunarFolder           *folder);
-static void     thunar_folder_file_changed                (ThunarFileMonitor      *file_monitor,
-                                                           ThunarFile             *file,
-                                                           ThunarFolder           *folder);
+static void     thunar_folder_file_changed                (ThunarFile             *file,
+                                                           gpointer                user_data);
 static void     thunar_folder_file_destroyed              (ThunarFileMonitor      *file_monitor,
                                                            ThunarFile             *file,
                                                            ThunarFolder           *folder);
@@ -85,6 +105,19 @@ static void     thunar_folder_monitor                     (GFileMonitor
                                                            GFile                  *other_file,
                                                            GFileMonitorEvent       event_type,
                                                            gpointer                user_data);
+static gboolean thunar_folder_monitor_flush               (gpointer                data);
+static void     thunar_folder_content_type_loader_stop    (ThunarFolder           *folder);
+static void     thunar_folder_info_loader_stop            (ThunarFolder           *folder);
+static void     thunar_folder_monitor_start               (ThunarFolder           *folder);
+static void     thunar_folder_monitor_stop                (ThunarFolder           *folder);
+static void     thunar_folder_pool_toggled                (gpointer                data,
+                                                           GObject                *object,
+                                                           gboolean                is_last_ref);
+static void     thunar_folder_pool_keep_alive             (ThunarFolder           *folder);
+static void     thunar_folder_page_stop                   (ThunarFolder           *folder);
+static void     thunar_folder_launch                      (ThunarFolder           *folder);
+static GQuark   thunar_folder_get_quark                   (gboolean                folders_only);
+static gboolean thunar_folder_is_discovery                (ThunarFile             *file);
 
 
 
@@ -108,25 +141,93 @@ struct _ThunarFolder
 
   ThunarJob         *job;
 
+  /* monotonic time at which the running job was started */
+  gint64             reload_time;
+
   ThunarFile        *corresponding_file;
   GList             *new_files;
-  GList             *files;
+  GHashTable        *new_files_map;
+  GPtrArray         *files;
+  GHashTable        *files_map;
   gboolean           reload_info;
+  gboolean           load_incremental;
+
+  /* only the sub folders are listed, see thunar_folder_get_folders_for_file() */
+  gboolean           folders_only;
 
-  GList             *content_type_ptr;
-  guint              content_type_idle_id;
+  /* determines the content types in the background */
+  ThunarJob         *content_type_job;
+
+  /* completes the info of files listed with partial info */
+  ThunarJob         *info_job;
 
   guint              in_destruction : 1;
 
   ThunarFileMonitor *file_monitor;
 
   GFileMonitor      *monitor;
+
+  /* pending monitor events, merged per file and applied in batches */
+  GQueue             monitor_events;
+  GHashTable        *monitor_events_map;
+  guint              monitor_interval;
+  guint              monitor_flush_id;
+  GList             *monitor_added;
+  GList             *monitor_removed;
+  guint              in_monitor_flush : 1;
+
+  /* checks the modification and change time of folders on file systems
+   * which do not report changes, e.g. NFS, SMB and FUSE mounts */
+  GCancellable      *poll_cancellable;
+  guint              poll_id;
+  guint              poll_interval;
+  guint64            poll_mtime;
+  guint64            poll_ctime;
+  guint              poll_stamped : 1;
+
+  /* link in the keep-alive pool, if the folder is pooled */
+  GList             *pool_link;
+
+  /* the pooled folder is referenced besides the pool */
+  guint              pool_in_use : 1;
+
+  /* the folder changed unnoticed while it was pooled */
+  guint              stale : 1;
+
+  /* the folder discovers network locations, see thunar_folder_is_discovery() */
+  guint              discovery : 1;
+
+  /* monotonic time at which the last listing finished */
+  gint64             listed_time;
+
+  /* lists the next page of a folder listed in pages, see thunar_folder_load_more() */
+  GFileEnumerator   *page_enumerator;
+  guint              page_size;
 };
 
+typedef struct
+{
+  GFile             *file;
+  GFile             *other_file;
+  GFileMonitorEvent  event_type;
+}
+ThunarFolderMonitorEvent;
+
 
 
 static guint  folder_signals[LAST_SIGNAL];
 static GQuark thunar_folder_quark;
+static GQuark thunar_folder_folders_quark;
+
+/* all folders alive, for thunar_folder_get_census() */
+static GHashTable *thunar_folders = NULL;
+
+/* folders kept alive after they are no longer used, most recent first */
+static GQueue folder_pool = G_QUEUE_INIT;
+
+/* the folders which discover network locations, kept alive with their
+ * last listing regardless of the pool budget */
+static GHashTable *discovery_folders = NULL;
 
 
 
@@ -138,18 +239,8 @@ static void
 thunar_folder_constructed (GObject *object)
 {
   ThunarFolder *folder = THUNAR_FOLDER (object);
-  GError       *error  = NULL;
-
-  folder->monitor = g_file_monitor_directory (thunar_file_get_file (folder->corresponding_file),
-                                              G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
 
-  if (G_LIKELY (folder->monitor != NULL))
-      g_signal_connect (folder->monitor, "changed", G_CALLBACK (thunar_folder_monitor), folder);
-  else
-    {
-      g_debug ("Could not create folder monitor: %s", error->message);
-      g_error_free (error);
-    }
+  thunar_folder_monitor_start (folder);
 
   G_OBJECT_CLASS (thunar_folder_parent_class)->constructed (object);
 }
@@ -185,6 +276,22 @@ thunar_folder_class_init (ThunarFolderClass *klass)
                                                         | G_PARAM_WRITABLE
                                                         | G_PARAM_CONSTRUCT_ONLY));
 
+  /**
+   * ThunarFolder::folders-only:
+   *
+   * Whether only the sub folders of the #ThunarFolder
+   * are listed.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_FOLDERS_ONLY,
+                                   g_param_spec_boolean ("folders-only",
+                                                         "folders-only",
+                                                         "folders-only",
+                                                         FALSE,
+                                                         G_PARAM_READABLE
+                                                         | G_PARAM_WRITABLE
+                                                         | G_PARAM_CONSTRUCT_ONLY));
+
   /**
    * ThunarFolder::loading:
    *
@@ -268,13 +375,45 @@ thunar_folder_class_init (ThunarFolderClass *klass)
 static void
 thunar_folder_init (ThunarFolder *folder)
 {
+  ThunarPreferences *preferences;
+
   /* connect to the ThunarFileMonitor instance */
   folder->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (G_OBJECT (folder->file_monitor), "file-changed", G_CALLBACK (thunar_folder_file_changed), folder);
   g_signal_connect (G_OBJECT (folder->file_monitor), "file-destroyed", G_CALLBACK (thunar_folder_file_destroyed), folder);
 
   folder->monitor = NULL;
   folder->reload_info = FALSE;
+
+  /* the files, in no particular order, and the lookup table to find
+   * their index in constant time */
+  folder->files = g_ptr_array_new_with_free_func (g_object_unref);
+  folder->files_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+  folder->new_files_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* setup the queue for the monitor events */
+  g_queue_init (&folder->monitor_events);
+  folder->monitor_events_map = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-folder-monitor-interval", &folder->monitor_interval, NULL);
+  g_object_unref (preferences);
+
+  if (G_UNLIKELY (thunar_folders == NULL))
+    thunar_folders = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_add (thunar_folders, folder);
+}
+
+
+
+static void
+thunar_folder_monitor_event_free (gpointer data)
+{
+  ThunarFolderMonitorEvent *event = data;
+
+  g_object_unref (event->file);
+  if (event->other_file != NULL)
+    g_object_unref (event->other_file);
+  g_slice_free (ThunarFolderMonitorEvent, event);
 }
 
 
@@ -291,6 +430,14 @@ thunar_folder_dispose (GObject *object)
       folder->in_destruction = FALSE;
     }
 
+  /* a destroyed folder is of no use for revisits */
+  if (folder->pool_link != NULL)
+    {
+      g_queue_delete_link (&folder_pool, folder->pool_link);
+      folder->pool_link = NULL;
+      g_object_remove_toggle_ref (G_OBJECT (folder), thunar_folder_pool_toggled, NULL);
+    }
+
   (*G_OBJECT_CLASS (thunar_folder_parent_class)->dispose) (object);
 }
 
@@ -301,20 +448,21 @@ thunar_folder_finalize (GObject *object)
 {
   ThunarFolder *folder = THUNAR_FOLDER (object);
 
+  g_hash_table_remove (thunar_folders, folder);
+
   if (folder->corresponding_file)
-    thunar_file_unwatch (folder->corresponding_file);
+    {
+      thunar_file_unwatch (folder->corresponding_file);
+      thunar_file_monitor_unwatch_file (folder->corresponding_file, thunar_folder_file_changed, folder);
+    }
 
   /* disconnect from the ThunarFileMonitor instance */
   g_signal_handlers_disconnect_matched (folder->file_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
   g_object_unref (folder->file_monitor);
 
-  /* disconnect from the file alteration monitor */
-  if (G_LIKELY (folder->monitor != NULL))
-    {
-      g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
-      g_file_monitor_cancel (folder->monitor);
-      g_object_unref (folder->monitor);
-    }
+  /* disconnect from the file alteration monitor and drop pending events */
+  thunar_folder_monitor_stop (folder);
+  g_hash_table_destroy (folder->monitor_events_map);
 
   /* cancel the pending job (if any) */
   if (G_UNLIKELY (folder->job != NULL))
@@ -328,19 +476,26 @@ thunar_folder_finalize (GObject *object)
   if (G_LIKELY (folder->corresponding_file != NULL))
     {
       /* drop the reference */
-      g_object_set_qdata (G_OBJECT (folder->corresponding_file), thunar_folder_quark, NULL);
+      g_object_set_qdata (G_OBJECT (folder->corresponding_file), thunar_folder_get_quark (folder->folders_only), NULL);
       g_object_unref (G_OBJECT (folder->corresponding_file));
     }
 
   /* stop metadata collector */
-  if (folder->content_type_idle_id != 0)
-    g_source_remove (folder->content_type_idle_id);
+  thunar_folder_content_type_loader_stop (folder);
+
+  /* stop completing the file infos */
+  thunar_folder_info_loader_stop (folder);
+
+  /* forget the rest of a folder listed in pages */
+  thunar_folder_page_stop (folder);
 
   /* release references to the new files */
+  g_hash_table_destroy (folder->new_files_map);
   thunar_g_list_free_full (folder->new_files);
 
   /* release references to the current files */
-  thunar_g_list_free_full (folder->files);
+  g_hash_table_destroy (folder->files_map);
+  g_ptr_array_unref (folder->files);
 
   (*G_OBJECT_CLASS (thunar_folder_parent_class)->finalize) (object);
 }
@@ -361,6 +516,10 @@ thunar_folder_get_property (GObject    *object,
       g_value_set_object (value, folder->corresponding_file);
       break;
 
+    case PROP_FOLDERS_ONLY:
+      g_value_set_boolean (value, folder->folders_only);
+      break;
+
     case PROP_LOADING:
       g_value_set_boolean (value, thunar_folder_get_loading (folder));
       break;
@@ -386,7 +545,16 @@ thunar_folder_set_property (GObject      *object,
     case PROP_CORRESPONDING_FILE:
       folder->corresponding_file = g_value_dup_object (value);
       if (folder->corresponding_file)
-        thunar_file_watch (folder->corresponding_file);
+        {
+          thunar_file_watch (folder->corresponding_file);
+
+          /* only this file matters, not the changes of all the others */
+          thunar_file_monitor_watch_file (folder->corresponding_file, thunar_folder_file_changed, folder);
+        }
+      break;
+
+    case PROP_FOLDERS_ONLY:
+      folder->folders_only = g_value_get_boolean (value);
       break;
 
     case PROP_LOADING:
@@ -423,14 +591,128 @@ thunar_folder_error (ExoJob       *job,
 
 
 
+/* appends @file to the files, which take over the reference */
+static void
+thunar_folder_files_add (ThunarFolder *folder,
+                         ThunarFile   *file)
+{
+  g_hash_table_insert (folder->files_map, file, GUINT_TO_POINTER (folder->files->len));
+  g_ptr_array_add (folder->files, file);
+}
+
+
+
+/* removes @file from the files and returns the reference of the files,
+ * or %NULL if @file is not a file of @folder */
+static ThunarFile *
+thunar_folder_files_steal (ThunarFolder *folder,
+                           ThunarFile   *file)
+{
+  gpointer index;
+  guint    n;
+
+  if (!g_hash_table_lookup_extended (folder->files_map, file, NULL, &index))
+    return NULL;
+
+  /* the last file moves into the gap */
+  n = GPOINTER_TO_UINT (index);
+  g_hash_table_remove (folder->files_map, file);
+  g_ptr_array_steal_index_fast (folder->files, n);
+  if (n < folder->files->len)
+    g_hash_table_insert (folder->files_map, folder->files->pdata[n], GUINT_TO_POINTER (n));
+
+  return file;
+}
+
+
+
+static ThunarFile *
+thunar_folder_files_lookup (ThunarFolder *folder,
+                            GFile        *gfile)
+{
+  ThunarFile *file;
+  ThunarFile *found = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
+
+  /* the file cache follows renames, so we can use it to resolve
+   * the location to a file, which is then looked up in our map */
+  file = thunar_file_cache_lookup (gfile);
+  if (G_LIKELY (file != NULL))
+    {
+      if (g_hash_table_contains (folder->files_map, file))
+        found = file;
+      g_object_unref (file);
+    }
+
+  return found;
+}
+
+
+
 static gboolean
 thunar_folder_files_ready (ThunarJob    *job,
                            GList        *files,
                            ThunarFolder *folder)
 {
+  GList *added = NULL;
+  GList *lp;
+
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
 
+  /* files which were known already are only updated if they changed */
+  for (lp = files; lp != NULL; lp = lp->next)
+    thunar_file_apply_listed_info (lp->data);
+
+  /* there is nothing to merge if the folder was empty when the
+   * loading started, so the files are shown as they arrive */
+  if (folder->load_incremental)
+    {
+      for (lp = files; lp != NULL; lp = lp->next)
+        {
+          if (G_UNLIKELY (g_hash_table_contains (folder->files_map, lp->data)))
+            {
+              g_object_unref (lp->data);
+              continue;
+            }
+
+          /* the files take over the reference */
+          thunar_folder_files_add (folder, lp->data);
+          added = g_list_prepend (added, lp->data);
+        }
+      g_list_free (files);
+
+      if (G_LIKELY (added != NULL))
+        {
+          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, added);
+          g_list_free (added);
+        }
+
+      return TRUE;
+    }
+
+  /* remember the new files for the merge in thunar_folder_finished() */
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      g_hash_table_add (folder->new_files_map, lp->data);
+
+      /* hosts and shares which showed up are shown right away, only
+       * the ones which are gone have to wait for the merge */
+      if (folder->discovery && !g_hash_table_contains (folder->files_map, lp->data))
+        {
+          thunar_folder_files_add (folder, g_object_ref (lp->data));
+          added = g_list_prepend (added, lp->data);
+        }
+    }
+
+  if (G_UNLIKELY (added != NULL))
+    {
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, added);
+      g_list_free (added);
+    }
+
   /* merge the list with the existing list of new files */
   folder->new_files = g_list_concat (folder->new_files, files);
 
@@ -440,58 +722,131 @@ thunar_folder_files_ready (ThunarJob    *job,
 
 
 
-static gboolean
-thunar_folder_content_type_loader_idle (gpointer data)
+static void
+thunar_folder_content_type_loader_stop (ThunarFolder *folder)
 {
-  ThunarFolder *folder;
-  GList        *lp;
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  if (folder->content_type_job != NULL)
+    {
+      g_signal_handlers_disconnect_matched (folder->content_type_job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      exo_job_cancel (EXO_JOB (folder->content_type_job));
+      g_object_unref (folder->content_type_job);
+      folder->content_type_job = NULL;
+    }
+}
+
+
+
+static void
+thunar_folder_content_type_loader_finished (ExoJob       *job,
+                                            ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->content_type_job == THUNAR_JOB (job));
+
+  thunar_folder_content_type_loader_stop (folder);
+}
+
 
-  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (data), FALSE);
 
-  folder = THUNAR_FOLDER (data);
+static void
+thunar_folder_content_type_loader (ThunarFolder *folder)
+{
+  ThunarFile *file;
+  GList      *files = NULL;
+  guint       n;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->content_type_job == NULL);
 
-  /* load another files content type */
-  for (lp = folder->content_type_ptr; lp != NULL; lp = lp->next)
-    if (thunar_file_load_content_type (lp->data))
-      {
-        /* if this was the last file, abort */
-        if (G_UNLIKELY (lp->next == NULL))
-          break;
+  /* symlinks are resolved by thunar_file_get_content_type() when needed,
+   * files added later are few and also determined on demand */
+  for (n = 0; n < folder->files->len; ++n)
+    {
+      file = g_ptr_array_index (folder->files, n);
+      if (thunar_file_peek_content_type (file) == NULL && !thunar_file_is_symlink (file))
+        files = g_list_prepend (files, thunar_file_get_file (file));
+    }
 
-        /* set pointer to next file for the next iteration */
-        folder->content_type_ptr = lp->next;
+  if (files == NULL)
+    return;
 
-        return TRUE;
-      }
+  /* sniff the content types in a worker thread, the job passes them to
+   * the files in batches and takes its own references on the files */
+  folder->content_type_job = thunar_io_jobs_content_types (files);
+  g_signal_connect (folder->content_type_job, "finished", G_CALLBACK (thunar_folder_content_type_loader_finished), folder);
+  thunar_job_launch (THUNAR_JOB (folder->content_type_job));
 
-  /* all content types loaded */
-  return FALSE;
+  g_list_free (files);
+}
+
+
+
+static void
+thunar_folder_info_loader_stop (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  if (folder->info_job != NULL)
+    {
+      g_signal_handlers_disconnect_matched (folder->info_job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      exo_job_cancel (EXO_JOB (folder->info_job));
+      g_object_unref (folder->info_job);
+      folder->info_job = NULL;
+    }
 }
 
 
 
 static void
-thunar_folder_content_type_loader_idle_destroyed (gpointer data)
+thunar_folder_info_loader_finished (ExoJob       *job,
+                                    ThunarFolder *folder)
 {
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (data));
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->info_job == THUNAR_JOB (job));
 
-  THUNAR_FOLDER (data)->content_type_idle_id = 0;
+  thunar_folder_info_loader_stop (folder);
 }
 
 
 
 static void
-thunar_folder_content_type_loader (ThunarFolder *folder)
+thunar_folder_info_loader (ThunarFolder *folder)
 {
+  ThunarFile *file;
+  GList      *directories = NULL;
+  GList      *others = NULL;
+  GList      *files;
+  guint       n;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (folder->content_type_idle_id == 0);
+  _thunar_return_if_fail (folder->info_job == NULL);
+
+  for (n = 0; n < folder->files->len; ++n)
+    {
+      file = g_ptr_array_index (folder->files, n);
+      if (!thunar_file_has_partial_info (file))
+        continue;
+
+      /* complete the directories first, their metadata contains
+       * the view settings used when they are opened */
+      if (thunar_file_is_directory (file))
+        directories = g_list_prepend (directories, thunar_file_get_file (file));
+      else
+        others = g_list_prepend (others, thunar_file_get_file (file));
+    }
 
-  /* set the pointer to the start of the list */
-  folder->content_type_ptr = folder->files;
+  files = g_list_concat (g_list_reverse (directories), g_list_reverse (others));
+  if (files == NULL)
+    return;
 
-  /* schedule idle */
-  folder->content_type_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_folder_content_type_loader_idle,
-                                                  folder, thunar_folder_content_type_loader_idle_destroyed);
+  /* the job takes its own references on the files */
+  folder->info_job = thunar_io_jobs_load_info (files);
+  g_signal_connect (folder->info_job, "finished", G_CALLBACK (thunar_folder_info_loader_finished), folder);
+  thunar_job_launch (THUNAR_JOB (folder->info_job));
+
+  g_list_free (files);
 }
 
 
@@ -503,25 +858,30 @@ thunar_folder_finished (ExoJob       *job,
   ThunarFile *file;
   GList      *files;
   GList      *lp;
+  guint       n;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
-  _thunar_return_if_fail (folder->content_type_idle_id == 0);
+  _thunar_return_if_fail (folder->content_type_job == NULL);
 
   /* check if we need to merge new files with existing files */
-  if (G_UNLIKELY (folder->files != NULL))
+  if (folder->load_incremental)
+    {
+      /* all files were added in thunar_folder_files_ready() */
+      folder->load_incremental = FALSE;
+    }
+  else if (G_UNLIKELY (folder->files->len > 0))
     {
       /* determine all added files (files on new_files, but not on files) */
       for (files = NULL, lp = folder->new_files; lp != NULL; lp = lp->next)
-        if (g_list_find (folder->files, lp->data) == NULL)
+        if (!g_hash_table_contains (folder->files_map, lp->data))
           {
             /* put the file on the added list */
             files = g_list_prepend (files, lp->data);
 
-            /* add to the internal files list */
-            folder->files = g_list_prepend (folder->files, lp->data);
-            g_object_ref (G_OBJECT (lp->data));
+            /* add to the internal files */
+            thunar_folder_files_add (folder, g_object_ref (lp->data));
           }
 
       /* check if any files were added */
@@ -534,23 +894,18 @@ thunar_folder_finished (ExoJob       *job,
           g_list_free (files);
         }
 
-      /* determine all removed files (files on files, but not on new_files) */
-      for (files = NULL, lp = folder->files; lp != NULL; )
+      /* determine all removed files (files on files, but not on new_files),
+       * backwards since a removed file is replaced by the last one */
+      for (files = NULL, n = folder->files->len; n > 0; --n)
         {
           /* determine the file */
-          file = THUNAR_FILE (lp->data);
-
-          /* determine the next list item */
-          lp = lp->next;
+          file = g_ptr_array_index (folder->files, n - 1);
 
           /* check if the file is not on new_files */
-          if (g_list_find (folder->new_files, file) == NULL)
+          if (!g_hash_table_contains (folder->new_files_map, file))
             {
               /* put the file on the removed list (owns the reference now) */
-              files = g_list_prepend (files, file);
-
-              /* remove from the internal files list */
-              folder->files = g_list_remove (folder->files, file);
+              files = g_list_prepend (files, thunar_folder_files_steal (folder, file));
             }
         }
 
@@ -565,36 +920,49 @@ thunar_folder_finished (ExoJob       *job,
         }
 
       /* drop the temporary new_files list */
+      g_hash_table_remove_all (folder->new_files_map);
       thunar_g_list_free_full (folder->new_files);
       folder->new_files = NULL;
     }
   else
     {
-      /* just use the new files for the files list */
-      folder->files = folder->new_files;
-      folder->new_files = NULL;
+      /* just use the new files for the files, which take over the references */
+      for (lp = folder->new_files; lp != NULL; lp = lp->next)
+        thunar_folder_files_add (folder, lp->data);
+      g_hash_table_remove_all (folder->new_files_map);
 
-      if (folder->files != NULL)
+      if (folder->new_files != NULL)
         {
           /* emit a "files-added" signal for the new files */
-          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->files);
+          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->new_files);
         }
+
+      g_list_free (folder->new_files);
+      folder->new_files = NULL;
+    }
+
+  /* the listing including the merge with the consumers of the folder */
+  thunar_stats_record_since (THUNAR_STATS_FOLDER_RELOAD, folder->reload_time);
+
+  /* a folder listed in pages keeps its place for the next page */
+  if (folder->page_size > 0 && !folder->folders_only)
+    {
+      thunar_folder_page_stop (folder);
+      folder->page_enumerator = thunar_io_jobs_list_directory_page_get_next (THUNAR_JOB (job));
     }
 
-  /* schedule a reload of the file information of all files if requested */
+  /* the files were compared with the listing in thunar_folder_files_ready()
+   * already, so only the folder information is left to be reloaded */
   if (folder->reload_info)
     {
       folder->reload_info = FALSE;
-      for (lp = folder->files; lp != NULL; lp = lp->next)
-        thunar_file_reload (lp->data);
-
-      /* reload folder information too */
       if (thunar_file_reload (folder->corresponding_file))
         return;
 
     }
 
   /* we did it, the folder is loaded */
+  folder->listed_time = g_get_monotonic_time ();
   if (G_LIKELY (folder->job != NULL))
     {
       g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
@@ -602,9 +970,12 @@ thunar_folder_finished (ExoJob       *job,
       folder->job = NULL;
     }
 
-  /* restart the content type idle loader */
+  /* determine the content types in the background */
   thunar_folder_content_type_loader (folder);
 
+  /* load the remaining info of files listed with partial info */
+  thunar_folder_info_loader (folder);
+
   /* tell the consumers that we have loaded the directory */
   g_object_notify (G_OBJECT (folder), "loading");
 }
@@ -612,13 +983,13 @@ thunar_folder_finished (ExoJob       *job,
 
 
 static void
-thunar_folder_file_changed (ThunarFileMonitor *file_monitor,
-                            ThunarFile        *file,
-                            ThunarFolder      *folder)
+thunar_folder_file_changed (ThunarFile *file,
+                            gpointer    user_data)
 {
+  ThunarFolder *folder = THUNAR_FOLDER (user_data);
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
 
   /* check if the corresponding file changed... */
   if (G_UNLIKELY (folder->corresponding_file == file))
@@ -637,7 +1008,6 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
 {
   GList     files;
   GList    *lp;
-  gboolean  restart = FALSE;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
@@ -652,26 +1022,34 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
     }
   else
     {
-      /* check if we have that file */
-      lp = g_list_find (folder->files, file);
-      if (G_LIKELY (lp != NULL))
+      /* check if we have that file, and remove it from our files (we keep the reference) */
+      if (G_LIKELY (thunar_folder_files_steal (folder, file) != NULL))
         {
-          if (folder->content_type_idle_id != 0)
-            restart = g_source_remove (folder->content_type_idle_id);
-
-          /* remove the file from our list */
-          folder->files = g_list_delete_link (folder->files, lp);
 
-          /* tell everybody that the file is gone */
-          files.data = file; files.next = files.prev = NULL;
-          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, &files);
-
-          /* drop our reference to the file */
-          g_object_unref (G_OBJECT (file));
+          if (folder->in_monitor_flush)
+            {
+              lp = g_list_find (folder->monitor_added, file);
+              if (G_UNLIKELY (lp != NULL))
+                {
+                  /* the file was never announced, so just forget about it */
+                  folder->monitor_added = g_list_delete_link (folder->monitor_added, lp);
+                  g_object_unref (G_OBJECT (file));
+                }
+              else
+                {
+                  /* announce the removal at the end of the batch (takes our reference) */
+                  folder->monitor_removed = g_list_prepend (folder->monitor_removed, file);
+                }
+            }
+          else
+            {
+              /* tell everybody that the file is gone */
+              files.data = file; files.next = files.prev = NULL;
+              g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, &files);
 
-          /* continue collecting the metadata */
-          if (restart)
-            thunar_folder_content_type_loader (folder);
+              /* drop our reference to the file */
+              g_object_unref (G_OBJECT (file));
+            }
         }
     }
 }
@@ -736,153 +1114,672 @@ thunar_file_infos_equal (ThunarFile *file,
 
 
 static void
-thunar_folder_monitor (GFileMonitor     *monitor,
-                       GFile            *event_file,
-                       GFile            *other_file,
-                       GFileMonitorEvent event_type,
-                       gpointer          user_data)
+thunar_folder_monitor_process (ThunarFolder     *folder,
+                               GFile            *event_file,
+                               GFile            *other_file,
+                               GFileMonitorEvent event_type)
 {
-  ThunarFolder *folder = THUNAR_FOLDER (user_data);
-  ThunarFile   *file;
-  ThunarFile   *other_parent;
-  GList        *lp;
-  GList         list;
-  gboolean      restart = FALSE;
+  ThunarFile *file;
+  ThunarFile *other_parent;
+  ThunarFile *known;
 
-  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (folder->monitor == monitor);
-  _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
-  _thunar_return_if_fail (G_IS_FILE (event_file));
+  /* check if we already ship the file */
+  known = thunar_folder_files_lookup (folder, event_file);
 
-  /* check on which file the event occurred */
-  if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
+  /* if we don't have it, add it if the event is not an "deleted" event */
+  if (G_UNLIKELY (known == NULL && event_type != G_FILE_MONITOR_EVENT_DELETED))
     {
-      /* check if we already ship the file */
-      for (lp = folder->files; lp != NULL; lp = lp->next)
-        if (g_file_equal (event_file, thunar_file_get_file (lp->data)))
-          break;
-
-      /* stop the content type collector */
-      if (folder->content_type_idle_id != 0)
-        restart = g_source_remove (folder->content_type_idle_id);
-
-      /* if we don't have it, add it if the event is not an "deleted" event */
-      if (G_UNLIKELY (lp == NULL && event_type != G_FILE_MONITOR_EVENT_DELETED))
+      /* allocate a file for the path */
+      file = thunar_file_get (event_file, NULL);
+      if (G_UNLIKELY (file != NULL && g_hash_table_contains (folder->files_map, file)))
         {
-          /* allocate a file for the path */
-          file = thunar_file_get (event_file, NULL);
-          if (G_UNLIKELY (file != NULL))
-            {
-              /* prepend it to our internal list */
-              folder->files = g_list_prepend (folder->files, file);
+          /* already known, e.g. if the file was not in the cache */
+          g_object_unref (file);
+        }
+      else if (file != NULL && folder->folders_only && !thunar_file_is_directory (file))
+        {
+          /* not listed in this folder */
+          g_object_unref (file);
+        }
+      else if (G_UNLIKELY (file != NULL))
+        {
+          /* add it to our internal files */
+          thunar_folder_files_add (folder, file);
 
-              /* tell others about the new file */
-              list.data = file; list.next = list.prev = NULL;
-              g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, &list);
+          /* tell others about the new file when the batch is complete */
+          folder->monitor_added = g_list_prepend (folder->monitor_added, file);
 
-              /* load the new file */
-              thunar_file_reload (file);
-            }
+          /* load the new file */
+          thunar_file_reload_queue (file);
         }
-      else if (lp != NULL)
+    }
+  else if (known != NULL)
+    {
+      if (event_type == G_FILE_MONITOR_EVENT_DELETED)
         {
-          if (event_type == G_FILE_MONITOR_EVENT_DELETED)
-            {
-              ThunarFile *destroyed;
+          ThunarFile *destroyed;
 
-              /* destroy the file */
-              thunar_file_destroy (lp->data);
+          /* destroy the file */
+          thunar_file_destroy (known);
 
-              /* if the file has not been destroyed by now, reload it to invalidate it */
-              destroyed = thunar_file_cache_lookup (event_file);
-              if (destroyed != NULL)
-                {
-                  thunar_file_reload (destroyed);
-                  g_object_unref (destroyed);
-                }
+          /* if the file has not been destroyed by now, reload it to invalidate it */
+          destroyed = thunar_file_cache_lookup (event_file);
+          if (destroyed != NULL)
+            {
+              thunar_file_reload (destroyed);
+              g_object_unref (destroyed);
             }
-          else if (event_type == G_FILE_MONITOR_EVENT_RENAMED ||
-                   event_type == G_FILE_MONITOR_EVENT_MOVED_IN ||
-                   event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
+        }
+      else if (event_type == G_FILE_MONITOR_EVENT_RENAMED ||
+               event_type == G_FILE_MONITOR_EVENT_MOVED_IN ||
+               event_type == G_FILE_MONITOR_EVENT_MOVED_OUT)
+        {
+          /* destroy the old file and update the new one */
+          thunar_file_destroy (known);
+          if (other_file != NULL)
             {
-              /* destroy the old file and update the new one */
-              thunar_file_destroy (lp->data);
-              if (other_file != NULL)
+              file = thunar_file_get(other_file, NULL);
+              if (file != NULL && THUNAR_IS_FILE (file))
                 {
-                  file = thunar_file_get(other_file, NULL);
-                  if (file != NULL && THUNAR_IS_FILE (file))
+                  if (thunar_file_reload (file))
                     {
-                      if (thunar_file_reload (file))
+                      /* if source and target folders are different, also tell
+                         the target folder to reload for the changes */
+                      if (thunar_file_has_parent (file))
                         {
-                          /* if source and target folders are different, also tell
-                             the target folder to reload for the changes */
-                          if (thunar_file_has_parent (file))
+                          other_parent = thunar_file_get_parent (file, NULL);
+                          if (other_parent &&
+                              !g_file_equal (thunar_file_get_file(folder->corresponding_file),
+                                             thunar_file_get_file(other_parent)))
                             {
-                              other_parent = thunar_file_get_parent (file, NULL);
-                              if (other_parent &&
-                                  !g_file_equal (thunar_file_get_file(folder->corresponding_file),
-                                                 thunar_file_get_file(other_parent)))
-                                {
-                                  thunar_file_reload (other_parent);
-                                  g_object_unref (other_parent);
-                                }
+                              thunar_file_reload (other_parent);
+                              g_object_unref (other_parent);
                             }
                         }
-
-                      /* drop reference on the other file */
-                      g_object_unref (file);
                     }
+
+                  /* drop reference on the other file */
+                  g_object_unref (file);
                 }
             }
-          else
-            {
-#if DEBUG_FILE_CHANGES
-              thunar_file_infos_equal (lp->data, event_file);
-#endif
-              thunar_file_reload (lp->data);
-            }
-        }
-
-      /* check if we need to restart the collector */
-      if (restart)
-        thunar_folder_content_type_loader (folder);
-    }
-  else
-    {
-      /* update/destroy the corresponding file */
-      if (event_type == G_FILE_MONITOR_EVENT_DELETED)
-        {
-          if (!thunar_file_exists (folder->corresponding_file))
-            thunar_file_destroy (folder->corresponding_file);
         }
       else
         {
-          thunar_file_reload (folder->corresponding_file);
+#if DEBUG_FILE_CHANGES
+          thunar_file_infos_equal (known, event_file);
+#endif
+          /* files changed in place leave the folder mtime alone */
+          if (event_type == G_FILE_MONITOR_EVENT_CHANGED || event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+            thunar_size_cache_invalidate (thunar_file_get_file (folder->corresponding_file));
+
+          /* do not block on the query, changes to many files are common */
+          thunar_file_reload_queue (known);
         }
     }
 }
 
 
 
-/**
- * thunar_folder_get_for_file:
- * @file : a #ThunarFile.
- *
- * Opens the specified @file as #ThunarFolder and
- * returns a reference to the folder.
- *
- * The caller is responsible to free the returned
- * object using g_object_unref() when no longer
- * needed.
- *
- * Return value: the #ThunarFolder which corresponds
- *               to @file.
- **/
-ThunarFolder*
-thunar_folder_get_for_file (ThunarFile *file)
+static void
+thunar_folder_monitor_flush_destroyed (gpointer data)
+{
+  THUNAR_FOLDER (data)->monitor_flush_id = 0;
+}
+
+
+
+static gboolean
+thunar_folder_monitor_flush (gpointer data)
+{
+  ThunarFolder             *folder = THUNAR_FOLDER (data);
+  ThunarFolderMonitorEvent *event;
+  gint64                    trace_begin;
+  gint64                    start_time;
+  guint                     n_events;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
+  _thunar_return_val_if_fail (!folder->in_monitor_flush, FALSE);
+
+  trace_begin = THUNAR_TRACE_BEGIN ();
+  start_time = g_get_monotonic_time ();
+  n_events = folder->monitor_events.length;
+
+  /* the handlers below might drop the last reference otherwise */
+  g_object_ref (G_OBJECT (folder));
+
+  /* apply the queued events in the order they arrived */
+  folder->in_monitor_flush = TRUE;
+  g_hash_table_remove_all (folder->monitor_events_map);
+  while ((event = g_queue_pop_head (&folder->monitor_events)) != NULL)
+    {
+      thunar_folder_monitor_process (folder, event->file, event->other_file, event->event_type);
+      thunar_folder_monitor_event_free (event);
+    }
+  folder->in_monitor_flush = FALSE;
+
+  /* tell others about the new files */
+  if (folder->monitor_added != NULL)
+    {
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->monitor_added);
+      g_list_free (folder->monitor_added);
+      folder->monitor_added = NULL;
+    }
+
+  /* tell others about the removed files */
+  if (folder->monitor_removed != NULL)
+    {
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, folder->monitor_removed);
+      thunar_g_list_free_full (folder->monitor_removed);
+      folder->monitor_removed = NULL;
+    }
+
+  THUNAR_TRACE_MARK (trace_begin, "folder-monitor", "%u events", n_events);
+  thunar_stats_record_callback ("thunar_folder_monitor_flush", start_time, n_events);
+
+  g_object_unref (G_OBJECT (folder));
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_folder_monitor_queue (ThunarFolder     *folder,
+                             GFile            *event_file,
+                             GFile            *other_file,
+                             GFileMonitorEvent event_type)
+{
+  ThunarFolderMonitorEvent *event;
+  GList                    *link = NULL;
+  gboolean                  is_move;
+
+  is_move = (event_type == G_FILE_MONITOR_EVENT_RENAMED
+             || event_type == G_FILE_MONITOR_EVENT_MOVED_IN
+             || event_type == G_FILE_MONITOR_EVENT_MOVED_OUT);
+
+  /* moves are never merged, later events for the same location
+   * have to be applied after the move */
+  if (is_move)
+    g_hash_table_remove (folder->monitor_events_map, event_file);
+  else
+    link = g_hash_table_lookup (folder->monitor_events_map, event_file);
+
+  if (link != NULL)
+    {
+      /* only the last event matters, so the pending event is updated
+       * in-place, e.g. a "created" followed by "deleted" is never visible */
+      event = link->data;
+      event->event_type = event_type;
+    }
+  else
+    {
+      event = g_slice_new0 (ThunarFolderMonitorEvent);
+      event->file = g_object_ref (event_file);
+      event->other_file = (other_file != NULL) ? g_object_ref (other_file) : NULL;
+      event->event_type = event_type;
+      g_queue_push_tail (&folder->monitor_events, event);
+
+      if (!is_move)
+        g_hash_table_insert (folder->monitor_events_map, event->file, folder->monitor_events.tail);
+    }
+
+  /* apply the events right away or schedule a flush */
+  if (folder->monitor_interval == 0)
+    {
+      if (!folder->in_monitor_flush)
+        thunar_folder_monitor_flush (folder);
+    }
+  else if (folder->monitor_flush_id == 0)
+    {
+      folder->monitor_flush_id = g_timeout_add_full (G_PRIORITY_DEFAULT, folder->monitor_interval,
+                                                     thunar_folder_monitor_flush, folder,
+                                                     thunar_folder_monitor_flush_destroyed);
+    }
+}
+
+
+
+static void
+thunar_folder_monitor (GFileMonitor     *monitor,
+                       GFile            *event_file,
+                       GFile            *other_file,
+                       GFileMonitorEvent event_type,
+                       gpointer          user_data)
+{
+  ThunarFolder *folder = THUNAR_FOLDER (user_data);
+
+  _thunar_return_if_fail (G_IS_FILE_MONITOR (monitor));
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->monitor == monitor);
+  _thunar_return_if_fail (THUNAR_IS_FILE (folder->corresponding_file));
+  _thunar_return_if_fail (G_IS_FILE (event_file));
+
+  /* check on which file the event occurred */
+  if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
+    {
+      /* queue the event for the next batch */
+      thunar_folder_monitor_queue (folder, event_file, other_file, event_type);
+    }
+  else
+    {
+      /* update/destroy the corresponding file */
+      if (event_type == G_FILE_MONITOR_EVENT_DELETED)
+        {
+          if (!thunar_file_exists (folder->corresponding_file))
+            thunar_file_destroy (folder->corresponding_file);
+        }
+      else
+        {
+          thunar_file_reload_queue (folder->corresponding_file);
+        }
+    }
+}
+
+
+
+static void thunar_folder_poll_schedule (ThunarFolder *folder,
+                                         guint         interval);
+
+
+
+static gboolean
+thunar_folder_poll_has_focus (void)
+{
+  GList    *windows;
+  GList    *lp;
+  gboolean  has_focus = FALSE;
+
+  windows = gtk_window_list_toplevels ();
+  for (lp = windows; lp != NULL && !has_focus; lp = lp->next)
+    has_focus = gtk_window_is_active (lp->data);
+  g_list_free (windows);
+
+  return has_focus;
+}
+
+
+
+static void
+thunar_folder_poll_ready (GObject      *source_object,
+                          GAsyncResult *result,
+                          gpointer      user_data)
 {
   ThunarFolder *folder;
+  GFileInfo    *info;
+  GError       *error = NULL;
+  guint64       mtime;
+  guint64       ctime;
+  guint         interval;
+
+  info = g_file_query_info_finish (G_FILE (source_object), result, &error);
+  if (info == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* the folder may be gone already */
+      g_error_free (error);
+      return;
+    }
+
+  folder = THUNAR_FOLDER (user_data);
+  interval = thunar_folder_poll_has_focus () ? THUNAR_FOLDER_POLL_MIN_INTERVAL
+                                             : MIN (folder->poll_interval * 2, THUNAR_FOLDER_POLL_MAX_INTERVAL);
+
+  if (G_UNLIKELY (info == NULL))
+    {
+      /* let the corresponding file find out whether the folder was deleted */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+        thunar_file_reload_queue (folder->corresponding_file);
+      g_error_free (error);
+      thunar_folder_poll_schedule (folder, interval);
+      return;
+    }
+
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+          + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  ctime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_CHANGED) * G_USEC_PER_SEC
+          + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_CHANGED_USEC);
+  g_object_unref (info);
+
+  if (folder->poll_stamped && (folder->poll_mtime != mtime || folder->poll_ctime != ctime))
+    {
+      /* a running listing may have missed the change, check again afterwards */
+      if (folder->job == NULL)
+        {
+          folder->poll_mtime = mtime;
+          folder->poll_ctime = ctime;
+
+          /* only the differences are reported, see thunar_folder_reload() */
+          thunar_folder_reload (folder, FALSE);
+        }
+
+      interval = THUNAR_FOLDER_POLL_MIN_INTERVAL;
+    }
+  else if (!folder->poll_stamped)
+    {
+      folder->poll_mtime = mtime;
+      folder->poll_ctime = ctime;
+      folder->poll_stamped = TRUE;
+    }
+
+  thunar_folder_poll_schedule (folder, interval);
+}
+
+
+
+static gboolean
+thunar_folder_poll (gpointer data)
+{
+  ThunarFolder *folder = THUNAR_FOLDER (data);
+
+  folder->poll_id = 0;
+
+  g_file_query_info_async (thunar_file_get_file (folder->corresponding_file),
+                           G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                           G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                           G_FILE_ATTRIBUTE_TIME_CHANGED ","
+                           G_FILE_ATTRIBUTE_TIME_CHANGED_USEC,
+                           G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW,
+                           folder->poll_cancellable,
+                           thunar_folder_poll_ready, folder);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_folder_poll_schedule (ThunarFolder *folder,
+                             guint         interval)
+{
+  _thunar_return_if_fail (folder->poll_id == 0);
+
+  folder->poll_interval = interval;
+  folder->poll_id = g_timeout_add_seconds (interval, thunar_folder_poll, folder);
+}
+
+
+
+static gboolean
+thunar_folder_poll_needed (GFileInfo *info)
+{
+  const gchar *fs_type;
+  guint        n;
+
+  /* file systems where changes by other hosts are not notified */
+  static const gchar *fs_types[] = { "9p", "afs", "ceph", "cifs", "fuse", "ncpfs", "nfs", "nfs4", "smb2", "smbfs" };
+
+  if (g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE))
+    return TRUE;
+
+  fs_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE);
+  if (fs_type == NULL)
+    return FALSE;
+
+  /* user space file systems, e.g. fuse.sshfs, except block devices */
+  if (g_str_has_prefix (fs_type, "fuse."))
+    return TRUE;
+
+  for (n = 0; n < G_N_ELEMENTS (fs_types); ++n)
+    if (g_strcmp0 (fs_type, fs_types[n]) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_folder_poll_filesystem_ready (GObject      *source_object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  ThunarFolder *folder;
+  GFileInfo    *info;
+
+  info = g_file_query_filesystem_info_finish (G_FILE (source_object), result, NULL);
+  if (info == NULL)
+    {
+      /* cancelled or unknown, the folder may be gone already */
+      return;
+    }
+
+  folder = THUNAR_FOLDER (user_data);
+  if (thunar_folder_poll_needed (info))
+    thunar_folder_poll_schedule (folder, THUNAR_FOLDER_POLL_MIN_INTERVAL);
+
+  g_object_unref (info);
+}
+
+
+
+static void
+thunar_folder_poll_start (ThunarFolder *folder)
+{
+  _thunar_return_if_fail (folder->poll_cancellable == NULL);
+
+  folder->poll_cancellable = g_cancellable_new ();
+  folder->poll_stamped = FALSE;
+
+  /* without a monitor, polling is the only way to notice changes */
+  if (folder->monitor == NULL)
+    {
+      thunar_folder_poll_schedule (folder, THUNAR_FOLDER_POLL_MIN_INTERVAL);
+      return;
+    }
+
+  g_file_query_filesystem_info_async (thunar_file_get_file (folder->corresponding_file),
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_TYPE ","
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_REMOTE,
+                                      G_PRIORITY_LOW, folder->poll_cancellable,
+                                      thunar_folder_poll_filesystem_ready, folder);
+}
+
+
+
+static void
+thunar_folder_poll_stop (ThunarFolder *folder)
+{
+  if (folder->poll_cancellable != NULL)
+    {
+      g_cancellable_cancel (folder->poll_cancellable);
+      g_clear_object (&folder->poll_cancellable);
+    }
+
+  if (folder->poll_id != 0)
+    {
+      g_source_remove (folder->poll_id);
+      folder->poll_id = 0;
+    }
+}
+
+
+
+static void
+thunar_folder_monitor_start (ThunarFolder *folder)
+{
+  GError *error = NULL;
+
+  _thunar_return_if_fail (folder->monitor == NULL);
+
+  /* a previous start may have polled without monitor */
+  thunar_folder_poll_stop (folder);
+
+  folder->monitor = g_file_monitor_directory (thunar_file_get_file (folder->corresponding_file),
+                                              G_FILE_MONITOR_WATCH_MOVES, NULL, &error);
+
+  if (G_LIKELY (folder->monitor != NULL))
+    {
+      g_signal_connect (folder->monitor, "changed", G_CALLBACK (thunar_folder_monitor), folder);
+
+      /* watched files in the folder can rely on this monitor */
+      thunar_file_watch_add_directory_monitor (thunar_file_get_file (folder->corresponding_file));
+    }
+  else
+    {
+      g_debug ("Could not create folder monitor: %s", error->message);
+      g_error_free (error);
+    }
+
+  /* check whether the file system reports changes */
+  thunar_folder_poll_start (folder);
+}
+
+
+
+static void
+thunar_folder_monitor_stop (ThunarFolder *folder)
+{
+  if (G_LIKELY (folder->monitor != NULL))
+    {
+      g_signal_handlers_disconnect_matched (folder->monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      g_file_monitor_cancel (folder->monitor);
+      g_object_unref (folder->monitor);
+      folder->monitor = NULL;
+      thunar_file_watch_remove_directory_monitor (thunar_file_get_file (folder->corresponding_file));
+    }
+
+  thunar_folder_poll_stop (folder);
+
+  /* drop pending monitor events */
+  g_clear_handle_id (&folder->monitor_flush_id, g_source_remove);
+  g_hash_table_remove_all (folder->monitor_events_map);
+  g_queue_clear_full (&folder->monitor_events, thunar_folder_monitor_event_free);
+}
+
+
+
+/* forgets the rest of a folder listed in pages */
+static void
+thunar_folder_page_stop (ThunarFolder *folder)
+{
+  if (folder->page_enumerator == NULL)
+    return;
+
+  /* don't block on remote locations */
+  g_file_enumerator_close_async (folder->page_enumerator, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+  g_clear_object (&folder->page_enumerator);
+}
+
+
+
+static void
+thunar_folder_pool_toggled (gpointer  data,
+                            GObject  *object,
+                            gboolean  is_last_ref)
+{
+  /* the pool holds the last reference */
+  THUNAR_FOLDER (object)->pool_in_use = !is_last_ref;
+}
+
+
+
+/* NOTE: the caller must hold a reference on the folder besides the pool */
+static void
+thunar_folder_pool_keep_alive (ThunarFolder *folder)
+{
+  ThunarPreferences *preferences;
+  ThunarFolder      *pooled;
+  GList             *lp;
+  GList             *lnext;
+  guint              budget;
+  guint64            size = 0;
+  guint              n_monitors = 0;
+
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-folder-keep-alive-budget", &budget, NULL);
+  g_object_unref (preferences);
+
+  /* move the folder to the front of the pool */
+  if (folder->pool_link != NULL)
+    {
+      g_queue_unlink (&folder_pool, folder->pool_link);
+      g_queue_push_head_link (&folder_pool, folder->pool_link);
+    }
+  else if (budget > 0)
+    {
+      g_object_add_toggle_ref (G_OBJECT (folder), thunar_folder_pool_toggled, NULL);
+      g_queue_push_head (&folder_pool, folder);
+      folder->pool_link = folder_pool.head;
+      folder->pool_in_use = TRUE;
+    }
+
+  /* release the least recently used folders beyond the budget and stop
+   * monitoring the unused ones beyond the monitor limit */
+  for (lp = folder_pool.head; lp != NULL; lp = lnext)
+    {
+      lnext = lp->next;
+      pooled = THUNAR_FOLDER (lp->data);
+
+      /* folders that are still used elsewhere cost nothing extra */
+      if (pooled->pool_in_use)
+        continue;
+
+      size += THUNAR_FOLDER_POOL_FOLDER_SIZE + (guint64) g_hash_table_size (pooled->files_map) * THUNAR_FOLDER_POOL_FILE_SIZE;
+      if (size > (guint64) budget * 1024 * 1024)
+        {
+          g_queue_delete_link (&folder_pool, lp);
+          pooled->pool_link = NULL;
+          g_object_remove_toggle_ref (G_OBJECT (pooled), thunar_folder_pool_toggled, NULL);
+        }
+      else if (pooled->monitor == NULL || ++n_monitors > THUNAR_FOLDER_POOL_MAX_MONITORS)
+        {
+          /* changes go unnoticed from here on */
+          thunar_folder_monitor_stop (pooled);
+          pooled->stale = TRUE;
+        }
+    }
+}
+
+
+
+static GQuark
+thunar_folder_get_quark (gboolean folders_only)
+{
+  /* determine the quarks on-demand */
+  if (G_UNLIKELY (thunar_folder_quark == 0))
+    {
+      thunar_folder_quark = g_quark_from_static_string ("thunar-folder");
+      thunar_folder_folders_quark = g_quark_from_static_string ("thunar-folder-folders");
+    }
+
+  return folders_only ? thunar_folder_folders_quark : thunar_folder_quark;
+}
+
+
+
+/* whether the folder lists network locations found by asking the network,
+ * i.e. network:/// and the SMB network, workgroups and hosts */
+static gboolean
+thunar_folder_is_discovery (ThunarFile *file)
+{
+  GFile       *gfile = thunar_file_get_file (file);
+  gchar       *uri;
+  const gchar *path;
+  gboolean     discovery = FALSE;
+
+  if (g_file_has_uri_scheme (gfile, "network"))
+    return TRUE;
+
+  if (g_file_has_uri_scheme (gfile, "smb"))
+    {
+      /* everything below a share is an ordinary folder */
+      uri = g_file_get_uri (gfile);
+      path = strchr (uri + strlen ("smb://"), '/');
+      discovery = (path == NULL || path[0] == '\0' || path[1] == '\0');
+      g_free (uri);
+    }
+
+  return discovery;
+}
+
+
+
+static ThunarFolder*
+thunar_folder_get_for_file_real (ThunarFile *file,
+                                 gboolean    folders_only)
+{
+  ThunarPreferences *preferences;
+  ThunarFolder      *folder;
+  guint              ttl;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
@@ -896,33 +1793,115 @@ thunar_folder_get_for_file (ThunarFile *file)
   if (!thunar_file_is_directory (file))
     return NULL;
 
-  /* determine the "thunar-folder" quark on-demand */
-  if (G_UNLIKELY (thunar_folder_quark == 0))
-    thunar_folder_quark = g_quark_from_static_string ("thunar-folder");
-
-  /* check if we already know that folder */
-  folder = g_object_get_qdata (G_OBJECT (file), thunar_folder_quark);
+  /* check if we already know that folder, a complete folder
+   * also serves the sub folders */
+  folder = g_object_get_qdata (G_OBJECT (file), thunar_folder_get_quark (FALSE));
+  if (folder == NULL && folders_only)
+    folder = g_object_get_qdata (G_OBJECT (file), thunar_folder_get_quark (TRUE));
   if (G_UNLIKELY (folder != NULL))
     {
       g_object_ref (G_OBJECT (folder));
+
+      /* the folder was pooled without file monitor, list it again and
+       * only apply the differences */
+      if (G_UNLIKELY (folder->stale))
+        {
+          folder->stale = FALSE;
+          if (folder->monitor == NULL)
+            thunar_folder_monitor_start (folder);
+          if (folder->job == NULL)
+            thunar_folder_reload (folder, FALSE);
+        }
+      else if (G_UNLIKELY (folder->discovery) && folder->job == NULL)
+        {
+          preferences = thunar_preferences_get ();
+          g_object_get (G_OBJECT (preferences), "misc-network-discovery-ttl", &ttl, NULL);
+          g_object_unref (preferences);
+
+          /* the last known hosts and shares are shown while the network is asked again */
+          if (g_get_monotonic_time () - folder->listed_time > (gint64) ttl * G_USEC_PER_SEC)
+            thunar_folder_reload (folder, FALSE);
+        }
     }
   else
     {
       /* allocate the new instance */
-      folder = g_object_new (THUNAR_TYPE_FOLDER, "corresponding-file", file, NULL);
+      folder = g_object_new (THUNAR_TYPE_FOLDER,
+                             "corresponding-file", file,
+                             "folders-only", folders_only,
+                             NULL);
 
       /* connect the folder to the file */
-      g_object_set_qdata (G_OBJECT (file), thunar_folder_quark, folder);
+      g_object_set_qdata (G_OBJECT (file), thunar_folder_get_quark (folders_only), folder);
+
+      /* network locations are slow to discover, keep their listing */
+      if (G_UNLIKELY (thunar_folder_is_discovery (file)))
+        {
+          folder->discovery = TRUE;
+          if (discovery_folders == NULL)
+            discovery_folders = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+          g_hash_table_add (discovery_folders, g_object_ref (folder));
+        }
 
       /* schedule the loading of the folder */
       thunar_folder_reload (folder, FALSE);
     }
 
+  /* keep the folder around for when it is opened again */
+  thunar_folder_pool_keep_alive (folder);
+
   return folder;
 }
 
 
 
+/**
+ * thunar_folder_get_for_file:
+ * @file : a #ThunarFile.
+ *
+ * Opens the specified @file as #ThunarFolder and
+ * returns a reference to the folder.
+ *
+ * The caller is responsible to free the returned
+ * object using g_object_unref() when no longer
+ * needed.
+ *
+ * Return value: the #ThunarFolder which corresponds
+ *               to @file.
+ **/
+ThunarFolder*
+thunar_folder_get_for_file (ThunarFile *file)
+{
+  return thunar_folder_get_for_file_real (file, FALSE);
+}
+
+
+
+/**
+ * thunar_folder_get_folders_for_file:
+ * @file : a #ThunarFile.
+ *
+ * Like thunar_folder_get_for_file(), but the returned #ThunarFolder
+ * only needs to list the sub folders of @file, which is cheap even
+ * for directories with lots of files. If @file is already open as
+ * complete folder, that folder is returned instead, so the caller
+ * still has to filter the files.
+ *
+ * The caller is responsible to free the returned
+ * object using g_object_unref() when no longer
+ * needed.
+ *
+ * Return value: a #ThunarFolder which lists at least the
+ *               sub folders of @file.
+ **/
+ThunarFolder*
+thunar_folder_get_folders_for_file (ThunarFile *file)
+{
+  return thunar_folder_get_for_file_real (file, TRUE);
+}
+
+
+
 /**
  * thunar_folder_get_corresponding_file:
  * @folder : a #ThunarFolder instance.
@@ -948,12 +1927,14 @@ thunar_folder_get_corresponding_file (const ThunarFolder *folder)
  * thunar_folder_get_files:
  * @folder : a #ThunarFolder instance.
  *
- * Returns the list of files currently known for @folder.
- * The returned list is owned by @folder and may not be freed!
+ * Returns the files currently known for @folder, in no particular
+ * order. The returned array is owned by @folder and may not be
+ * modified or freed! It is only valid until the next change of the
+ * files of @folder.
  *
- * Return value: the list of #ThunarFiles for @folder.
+ * Return value: the array of #ThunarFile<!---->s for @folder.
  **/
-GList*
+GPtrArray*
 thunar_folder_get_files (const ThunarFolder *folder)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), NULL);
@@ -997,6 +1978,39 @@ thunar_folder_has_folder_monitor (const ThunarFolder *folder)
 
 
 
+/**
+ * thunar_folder_is_stale:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Tells whether the @folder shows the last known network locations
+ * while it asks the network for them again.
+ *
+ * Return value: %TRUE if the files of @folder may be outdated.
+ **/
+gboolean
+thunar_folder_is_stale (const ThunarFolder *folder)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
+  return folder->discovery && folder->job != NULL && !folder->load_incremental;
+}
+
+
+
+static void
+thunar_folder_launch (ThunarFolder *folder)
+{
+  folder->reload_time = g_get_monotonic_time ();
+  thunar_job_launch (THUNAR_JOB (folder->job));
+  g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
+  g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_finished), folder);
+  g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_files_ready), folder);
+
+  /* tell all consumers that we're loading */
+  g_object_notify (G_OBJECT (folder), "loading");
+}
+
+
+
 /**
  * thunar_folder_reload:
  * @folder : a #ThunarFolder instance.
@@ -1004,19 +2018,29 @@ thunar_folder_has_folder_monitor (const ThunarFolder *folder)
  *
  * Tells the @folder object to reread the directory
  * contents from the underlying media.
+ *
+ * The new listing is compared with the current one, so only the files
+ * which were added, removed or changed according to their type, size,
+ * inode and modification time are reported to the consumers. A folder
+ * listed in pages starts over with its first page.
  **/
 void
 thunar_folder_reload (ThunarFolder *folder,
                       gboolean      reload_info)
 {
+  ThunarPreferences *preferences;
+  GFile             *file;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
 
   /* reload file info too? */
   folder->reload_info = reload_info;
 
   /* stop metadata collector */
-  if (folder->content_type_idle_id != 0)
-    g_source_remove (folder->content_type_idle_id);
+  thunar_folder_content_type_loader_stop (folder);
+
+  /* the new job lists the files again */
+  thunar_folder_info_loader_stop (folder);
 
   /* check if we are currently connect to a job */
   if (G_UNLIKELY (folder->job != NULL))
@@ -1028,16 +2052,120 @@ thunar_folder_reload (ThunarFolder *folder,
     }
 
   /* reset the new_files list */
+  g_hash_table_remove_all (folder->new_files_map);
   thunar_g_list_free_full (folder->new_files);
   folder->new_files = NULL;
 
+  /* files can be added right away if we don't need to merge */
+  folder->load_incremental = (folder->files->len == 0);
+
+  /* the listing starts over */
+  thunar_folder_page_stop (folder);
+
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-folder-page-size", &folder->page_size, NULL);
+  g_object_unref (preferences);
+
   /* start a new job */
-  folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
-  exo_job_launch (EXO_JOB (folder->job));
-  g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
-  g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_finished), folder);
-  g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_files_ready), folder);
+  file = thunar_file_get_file (folder->corresponding_file);
+  if (folder->folders_only)
+    folder->job = thunar_io_jobs_list_folders (file);
+  else if (folder->page_size > 0 && !g_file_has_uri_scheme (file, "recent"))
+    folder->job = thunar_io_jobs_list_directory_page (file, NULL, folder->page_size);
+  else
+    folder->job = thunar_io_jobs_list_directory (file);
+  thunar_folder_launch (folder);
+}
 
-  /* tell all consumers that we're loading */
-  g_object_notify (G_OBJECT (folder), "loading");
+
+
+/**
+ * thunar_folder_has_more:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Tells whether @folder is listed in pages and more files
+ * may be listed with thunar_folder_load_more().
+ *
+ * Return value: %TRUE if @folder may have more files.
+ **/
+gboolean
+thunar_folder_has_more (const ThunarFolder *folder)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
+  return (folder->page_enumerator != NULL);
+}
+
+
+
+/**
+ * thunar_folder_load_more:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Lists the next page of a @folder listed in pages, see the
+ * "misc-folder-page-size" preference. The files are added to
+ * the @folder as they are listed. Does nothing while @folder
+ * is loading or if it has no more files.
+ **/
+void
+thunar_folder_load_more (ThunarFolder *folder)
+{
+  GFileEnumerator *enumerator;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  if (folder->page_enumerator == NULL || folder->job != NULL)
+    return;
+
+  /* the loaders are started again for the new files once the page is listed */
+  thunar_folder_content_type_loader_stop (folder);
+  thunar_folder_info_loader_stop (folder);
+
+  /* the files of a page are new, there is nothing to merge */
+  folder->load_incremental = TRUE;
+
+  enumerator = folder->page_enumerator;
+  folder->page_enumerator = NULL;
+  folder->job = thunar_io_jobs_list_directory_page (thunar_file_get_file (folder->corresponding_file),
+                                                    enumerator, folder->page_size);
+  g_object_unref (enumerator);
+  thunar_folder_launch (folder);
+}
+
+
+
+/**
+ * thunar_folder_get_census:
+ * @n_folders : return location for the number of folders alive.
+ * @n_files   : return location for the number of files they list.
+ * @bytes     : return location for an estimate of the memory they hold,
+ *              without the files themselves.
+ *
+ * Determines how many folders are kept alive, by the views, the
+ * prefetcher or the folder pool.
+ **/
+void
+thunar_folder_get_census (guint   *n_folders,
+                          guint64 *n_files,
+                          guint64 *bytes)
+{
+  GHashTableIter iter;
+  ThunarFolder  *folder;
+
+  *n_folders = 0;
+  *n_files = 0;
+  *bytes = 0;
+
+  if (thunar_folders == NULL)
+    return;
+
+  /* the files are in the array, the lookup table and maybe the monitor events */
+  g_hash_table_iter_init (&iter, thunar_folders);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &folder, NULL))
+    {
+      *n_folders += 1;
+      *n_files += folder->files->len;
+      *bytes += sizeof (ThunarFolder)
+              + folder->files->len * 4 * sizeof (gpointer)
+              + g_queue_get_length (&folder->monitor_events) * 4 * sizeof (gpointer);
+    }
 }
@@ -37,14 +37,22 @@ typedef struct _ThunarFolder      ThunarFolder;
 GType         thunar_folder_get_type               (void) G_GNUC_CONST;
 
 ThunarFolder *thunar_folder_get_for_file           (ThunarFile         *file);
+ThunarFolder *thunar_folder_get_folders_for_file   (ThunarFile         *file);
 
 ThunarFile   *thunar_folder_get_corresponding_file (const ThunarFolder *folder);
-GList        *thunar_folder_get_files              (const ThunarFolder *folder);
+GPtrArray    *thunar_folder_get_files              (const ThunarFolder *folder);
 gboolean      thunar_folder_get_loading            (const ThunarFolder *folder);
 gboolean      thunar_folder_has_folder_monitor     (const ThunarFolder *folder);
+gboolean      thunar_folder_is_stale               (const ThunarFolder *folder);
 
 void          thunar_folder_reload                 (ThunarFolder       *folder,
                                                     gboolean            reload_info);
+gboolean      thunar_folder_has_more               (const ThunarFolder *folder);
+void          thunar_folder_load_more              (ThunarFolder       *folder);
+
+void          thunar_folder_get_census             (guint              *n_folders,
+                                                    guint64            *n_files,
+                                                    guint64            *bytes);
 
 G_END_DECLS;
 
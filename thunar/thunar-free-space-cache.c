@@ -0,0 +1,422 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-free-space-cache.h>
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* The cache remembers the usage of the file systems shown in the
+ * statusbar, the shortcuts pane and the properties dialog. Lookups
+ * never block: they return what is known and refresh outdated entries
+ * in the background, so a hung network file system only delays the
+ * numbers. The entries are keyed by the id::filesystem of the files,
+ * or by the URI for plain locations. */
+
+/* how long the usage of a file system is used before it is queried again */
+#define THUNAR_FREE_SPACE_CACHE_TTL         (10 * G_USEC_PER_SEC)
+
+/* seconds until a query of a file system is given up */
+#define THUNAR_FREE_SPACE_CACHE_TIMEOUT     5
+
+/* idle entries are dropped once the cache holds this many */
+#define THUNAR_FREE_SPACE_CACHE_MAX_ENTRIES 256
+
+
+
+/* Signal identifiers */
+enum
+{
+  CHANGED,
+  LAST_SIGNAL,
+};
+
+
+
+typedef struct
+{
+  guint64       fs_free;
+  guint64       fs_size;
+  gint64        time;
+  gboolean      valid;
+
+  /* set while a query is in flight */
+  GCancellable *cancellable;
+  guint         timeout_id;
+}
+ThunarFreeSpaceEntry;
+
+typedef struct
+{
+  ThunarFreeSpaceCache *cache;
+  gchar                *key;
+}
+ThunarFreeSpaceQuery;
+
+
+
+static void thunar_free_space_cache_finalize (GObject *object);
+
+
+
+struct _ThunarFreeSpaceCacheClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarFreeSpaceCache
+{
+  GObject     __parent__;
+
+  GHashTable *entries;
+};
+
+
+
+static ThunarFreeSpaceCache *free_space_cache_default;
+static guint                 free_space_cache_signals[LAST_SIGNAL];
+
+
+
+G_DEFINE_TYPE (ThunarFreeSpaceCache, thunar_free_space_cache, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_free_space_cache_class_init (ThunarFreeSpaceCacheClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_free_space_cache_finalize;
+
+  /**
+   * ThunarFreeSpaceCache::changed:
+   * @cache : the default #ThunarFreeSpaceCache.
+   *
+   * Emitted whenever the usage of a file system in the cache
+   * changed, so the consumers can look up their numbers again.
+   **/
+  free_space_cache_signals[CHANGED] =
+    g_signal_new (I_("changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+}
+
+
+
+static void
+thunar_free_space_cache_entry_free (gpointer data)
+{
+  ThunarFreeSpaceEntry *entry = data;
+
+  /* the queries hold a reference on the cache, so none is in flight here */
+  _thunar_assert (entry->cancellable == NULL);
+
+  g_slice_free (ThunarFreeSpaceEntry, entry);
+}
+
+
+
+static void
+thunar_free_space_cache_init (ThunarFreeSpaceCache *cache)
+{
+  cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_free_space_cache_entry_free);
+}
+
+
+
+static void
+thunar_free_space_cache_finalize (GObject *object)
+{
+  ThunarFreeSpaceCache *cache = THUNAR_FREE_SPACE_CACHE (object);
+
+  g_hash_table_destroy (cache->entries);
+
+  (*G_OBJECT_CLASS (thunar_free_space_cache_parent_class)->finalize) (object);
+}
+
+
+
+static gboolean
+thunar_free_space_cache_timeout (gpointer data)
+{
+  ThunarFreeSpaceEntry *entry = data;
+
+  /* give up, the query callback still runs and finishes the entry */
+  entry->timeout_id = 0;
+  g_cancellable_cancel (entry->cancellable);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_free_space_cache_query_finish (GObject      *object,
+                                      GAsyncResult *result,
+                                      gpointer      user_data)
+{
+  ThunarFreeSpaceQuery *query = user_data;
+  ThunarFreeSpaceEntry *entry;
+  GFileInfo            *info;
+  gboolean              valid;
+  guint64               fs_free = 0;
+  guint64               fs_size = 0;
+
+  info = g_file_query_filesystem_info_finish (G_FILE (object), result, NULL);
+  valid = (info != NULL
+           && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE)
+           && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE));
+  if (valid)
+    {
+      fs_free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+      fs_size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+    }
+
+  entry = g_hash_table_lookup (query->cache->entries, query->key);
+  _thunar_assert (entry != NULL && entry->cancellable != NULL);
+
+  if (entry->timeout_id != 0)
+    g_source_remove (entry->timeout_id);
+  entry->timeout_id = 0;
+  g_clear_object (&entry->cancellable);
+
+  /* failed queries are not repeated before the entry is outdated either */
+  entry->time = g_get_monotonic_time ();
+  if (entry->valid != valid || entry->fs_free != fs_free || entry->fs_size != fs_size)
+    {
+      entry->valid = valid;
+      entry->fs_free = fs_free;
+      entry->fs_size = fs_size;
+      g_signal_emit (G_OBJECT (query->cache), free_space_cache_signals[CHANGED], 0);
+    }
+
+  if (info != NULL)
+    g_object_unref (info);
+
+  g_object_unref (query->cache);
+  g_free (query->key);
+  g_slice_free (ThunarFreeSpaceQuery, query);
+}
+
+
+
+static void
+thunar_free_space_cache_trim (ThunarFreeSpaceCache *cache)
+{
+  GHashTableIter        iter;
+  ThunarFreeSpaceEntry *entry;
+
+  /* entries with a query in flight are needed by the callback */
+  g_hash_table_iter_init (&iter, cache->entries);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    if (entry->cancellable == NULL)
+      g_hash_table_iter_remove (&iter);
+}
+
+
+
+static gboolean
+thunar_free_space_cache_lookup_key (ThunarFreeSpaceCache *cache,
+                                    GFile                *location,
+                                    const gchar          *key,
+                                    guint64              *fs_free_return,
+                                    guint64              *fs_size_return)
+{
+  ThunarFreeSpaceEntry *entry;
+  ThunarFreeSpaceQuery *query;
+
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (G_UNLIKELY (entry == NULL))
+    {
+      if (g_hash_table_size (cache->entries) >= THUNAR_FREE_SPACE_CACHE_MAX_ENTRIES)
+        thunar_free_space_cache_trim (cache);
+
+      entry = g_slice_new0 (ThunarFreeSpaceEntry);
+      g_hash_table_insert (cache->entries, g_strdup (key), entry);
+    }
+
+  /* refresh outdated entries in the background, one query at a time */
+  if (entry->cancellable == NULL && (entry->time == 0 || g_get_monotonic_time () - entry->time > THUNAR_FREE_SPACE_CACHE_TTL))
+    {
+      entry->cancellable = g_cancellable_new ();
+      entry->timeout_id = g_timeout_add_seconds (THUNAR_FREE_SPACE_CACHE_TIMEOUT, thunar_free_space_cache_timeout, entry);
+
+      query = g_slice_new (ThunarFreeSpaceQuery);
+      query->cache = g_object_ref (cache);
+      query->key = g_strdup (key);
+
+      g_file_query_filesystem_info_async (location, THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                          G_PRIORITY_DEFAULT, entry->cancellable,
+                                          thunar_free_space_cache_query_finish, query);
+    }
+
+  if (!entry->valid)
+    return FALSE;
+
+  if (fs_free_return != NULL)
+    *fs_free_return = entry->fs_free;
+  if (fs_size_return != NULL)
+    *fs_size_return = entry->fs_size;
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_free_space_cache_get_default:
+ *
+ * Returns a reference to the default #ThunarFreeSpaceCache
+ * instance. The cache only lives as long as somebody holds
+ * a reference, so consumers keep theirs around.
+ *
+ * The caller is responsible to free the returned instance
+ * using g_object_unref() when no longer needed.
+ *
+ * Return value: the default #ThunarFreeSpaceCache instance.
+ **/
+ThunarFreeSpaceCache*
+thunar_free_space_cache_get_default (void)
+{
+  if (G_UNLIKELY (free_space_cache_default == NULL))
+    {
+      /* allocate the default cache */
+      free_space_cache_default = g_object_new (THUNAR_TYPE_FREE_SPACE_CACHE, NULL);
+      g_object_add_weak_pointer (G_OBJECT (free_space_cache_default),
+                                 (gpointer) &free_space_cache_default);
+    }
+  else
+    {
+      /* take a reference for the caller */
+      g_object_ref (G_OBJECT (free_space_cache_default));
+    }
+
+  return free_space_cache_default;
+}
+
+
+
+/**
+ * thunar_free_space_cache_lookup:
+ * @cache          : a #ThunarFreeSpaceCache.
+ * @location       : a #GFile on the file system.
+ * @fs_free_return : return location for the amount of free space or %NULL.
+ * @fs_size_return : return location for the total volume size or %NULL.
+ *
+ * Non-blocking variant of thunar_g_file_get_free_space(). If the usage of
+ * the file system of @location is not known yet or outdated, it is queried
+ * in the background and ::changed is emitted once it changed.
+ *
+ * Return value: %TRUE if the usage is known, else %FALSE.
+ **/
+gboolean
+thunar_free_space_cache_lookup (ThunarFreeSpaceCache *cache,
+                                GFile                *location,
+                                guint64              *fs_free_return,
+                                guint64              *fs_size_return)
+{
+  gboolean result;
+  gchar   *uri;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FREE_SPACE_CACHE (cache), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (location), FALSE);
+
+  uri = g_file_get_uri (location);
+  result = thunar_free_space_cache_lookup_key (cache, location, uri, fs_free_return, fs_size_return);
+  g_free (uri);
+
+  return result;
+}
+
+
+
+/**
+ * thunar_free_space_cache_lookup_file:
+ * @cache          : a #ThunarFreeSpaceCache.
+ * @file           : a #ThunarFile on the file system.
+ * @fs_free_return : return location for the amount of free space or %NULL.
+ * @fs_size_return : return location for the total volume size or %NULL.
+ *
+ * Like thunar_free_space_cache_lookup(), but all files on the same
+ * file system share their entry.
+ *
+ * Return value: %TRUE if the usage is known, else %FALSE.
+ **/
+gboolean
+thunar_free_space_cache_lookup_file (ThunarFreeSpaceCache *cache,
+                                     ThunarFile           *file,
+                                     guint64              *fs_free_return,
+                                     guint64              *fs_size_return)
+{
+  GFileInfo   *info;
+  const gchar *filesystem_id = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FREE_SPACE_CACHE (cache), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+
+  info = thunar_file_get_info (file);
+  if (G_LIKELY (info != NULL))
+    filesystem_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+
+  if (G_UNLIKELY (filesystem_id == NULL))
+    return thunar_free_space_cache_lookup (cache, thunar_file_get_file (file), fs_free_return, fs_size_return);
+
+  return thunar_free_space_cache_lookup_key (cache, thunar_file_get_file (file), filesystem_id,
+                                             fs_free_return, fs_size_return);
+}
+
+
+
+/**
+ * thunar_free_space_cache_get_string:
+ * @cache            : a #ThunarFreeSpaceCache.
+ * @location         : a #GFile on the file system.
+ * @file_size_binary : %TRUE to use binary units.
+ *
+ * Non-blocking variant of thunar_g_file_get_free_space_string(),
+ * see thunar_free_space_cache_lookup().
+ *
+ * Return value: the usage string, or %NULL if it is not known (yet).
+ **/
+gchar*
+thunar_free_space_cache_get_string (ThunarFreeSpaceCache *cache,
+                                    GFile                *location,
+                                    gboolean              file_size_binary)
+{
+  guint64 fs_free;
+  guint64 fs_size;
+
+  if (!thunar_free_space_cache_lookup (cache, location, &fs_free, &fs_size))
+    return NULL;
+
+  return thunar_g_format_free_space (fs_free, fs_size, file_size_binary);
+}
@@ -0,0 +1,58 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_FREE_SPACE_CACHE_H__
+#define __THUNAR_FREE_SPACE_CACHE_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarFreeSpaceCacheClass ThunarFreeSpaceCacheClass;
+typedef struct _ThunarFreeSpaceCache      ThunarFreeSpaceCache;
+
+#define THUNAR_TYPE_FREE_SPACE_CACHE            (thunar_free_space_cache_get_type ())
+#define THUNAR_FREE_SPACE_CACHE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_FREE_SPACE_CACHE, ThunarFreeSpaceCache))
+#define THUNAR_FREE_SPACE_CACHE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_FREE_SPACE_CACHE, ThunarFreeSpaceCacheClass))
+#define THUNAR_IS_FREE_SPACE_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_FREE_SPACE_CACHE))
+#define THUNAR_IS_FREE_SPACE_CACHE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_FREE_SPACE_CACHE))
+#define THUNAR_FREE_SPACE_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_FREE_SPACE_CACHE, ThunarFreeSpaceCacheClass))
+
+GType                 thunar_free_space_cache_get_type    (void) G_GNUC_CONST;
+
+ThunarFreeSpaceCache *thunar_free_space_cache_get_default (void);
+
+gboolean              thunar_free_space_cache_lookup      (ThunarFreeSpaceCache *cache,
+                                                           GFile                *location,
+                                                           guint64              *fs_free_return,
+                                                           guint64              *fs_size_return);
+
+gboolean              thunar_free_space_cache_lookup_file (ThunarFreeSpaceCache *cache,
+                                                           ThunarFile           *file,
+                                                           guint64              *fs_free_return,
+                                                           guint64              *fs_size_return);
+
+gchar                *thunar_free_space_cache_get_string  (ThunarFreeSpaceCache *cache,
+                                                           GFile                *location,
+                                                           gboolean              file_size_binary);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_FREE_SPACE_CACHE_H__ */
@@ -39,13 +39,10 @@
 
 
 
-static const cairo_user_data_key_t cairo_key;
-
-
-
 static cairo_surface_t *
 thunar_gdk_cairo_create_surface (const GdkPixbuf *pixbuf,
-                                 gint             scale_factor)
+                                 gint             scale_factor,
+                                 GdkWindow       *window)
 {
   gint             width;
   gint             height;
@@ -74,12 +71,24 @@ thunar_gdk_cairo_create_surface (const GdkPixbuf *pixbuf,
   else
     format = CAIRO_FORMAT_ARGB32;
 
-  /* prepare pixel data and surface */
-  cairo_stride = cairo_format_stride_for_width (format, width);
-  cairo_pixels = g_malloc_n (height, cairo_stride);
-  surface = cairo_image_surface_create_for_data (cairo_pixels, format,
-                                                 width, height, cairo_stride);
-  cairo_surface_set_user_data (surface, &cairo_key, cairo_pixels, g_free);
+  /* prepare the surface, preferably in the format that is
+   * fastest to draw on the window */
+  if (G_LIKELY (window != NULL))
+    {
+      surface = gdk_window_create_similar_image_surface (window, format, width, height, scale_factor);
+    }
+  else
+    {
+      surface = cairo_image_surface_create (format, width, height);
+      cairo_surface_set_device_scale (surface, scale_factor, scale_factor);
+    }
+
+  /* we write the pixels ourselves */
+  cairo_surface_flush (surface);
+  cairo_pixels = cairo_image_surface_get_data (surface);
+  cairo_stride = cairo_image_surface_get_stride (surface);
+  if (G_UNLIKELY (cairo_pixels == NULL))
+    return surface;
 
   /* convert format */
   if (G_UNLIKELY (n_channels == 3))
@@ -142,7 +151,7 @@ thunar_gdk_cairo_create_surface (const GdkPixbuf *pixbuf,
 #undef MULT
     }
 
-  cairo_surface_set_device_scale (surface, scale_factor, scale_factor);
+  cairo_surface_mark_dirty (surface);
 
   return surface;
 }
@@ -232,30 +241,36 @@ thunar_gdk_screen_open (const gchar *display_name,
  * pixbuf_x     : X coordinate of location to place upper left corner of pixbuf
  * pixbuf_y     : Y coordinate of location to place upper left corner of pixbuf
  * scale_factor : UI scaling factor
+ * window       : the GdkWindow that is drawn on, or %NULL
  *
  * Works like gdk_cairo_set_source_pixbuf but we try to cache the surface
  * on the pixbuf, which is efficient within Thunar because we also share
- * the pixbufs using the icon cache.
+ * the pixbufs using the icon cache. The surface is created in the format
+ * preferred by the window and only recreated if the scale factor changes.
  **/
 void
 thunar_gdk_cairo_set_source_pixbuf (cairo_t   *cr,
                                     GdkPixbuf *pixbuf,
                                     gdouble    pixbuf_x,
                                     gdouble    pixbuf_y,
-                                    gint       scale_factor)
+                                    gint       scale_factor,
+                                    GdkWindow *window)
 {
   cairo_surface_t *surface;
   static GQuark    surface_quark = 0;
+  gdouble          surface_scale = 0.0;
 
   if (G_UNLIKELY (surface_quark == 0))
     surface_quark = g_quark_from_static_string ("thunar-gdk-surface");
 
-  /* peek if there is already a surface */
+  /* peek if there is already a surface for this scale factor */
   surface = g_object_get_qdata (G_OBJECT (pixbuf), surface_quark);
-  if (surface == NULL)
+  if (G_LIKELY (surface != NULL))
+    cairo_surface_get_device_scale (surface, &surface_scale, NULL);
+  if (surface == NULL || surface_scale != scale_factor)
     {
       /* create a new surface */
-      surface = thunar_gdk_cairo_create_surface (pixbuf, scale_factor);
+      surface = thunar_gdk_cairo_create_surface (pixbuf, scale_factor, window);
 
       /* store the pixbuf on the pixbuf */
       g_object_set_qdata_full (G_OBJECT (pixbuf), surface_quark,
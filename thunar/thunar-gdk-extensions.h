@@ -32,7 +32,8 @@ void       thunar_gdk_cairo_set_source_pixbuf (cairo_t     *cr,
                                                GdkPixbuf   *pixbuf,
                                                gdouble      pixbuf_x,
                                                gdouble      pixbuf_y,
-                                               gint         scale_factor);
+                                               gint         scale_factor,
+                                               GdkWindow   *window);
 
 G_END_DECLS;
 
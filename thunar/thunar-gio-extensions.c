@@ -23,6 +23,7 @@
 #endif
 
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #ifdef HAVE_GIO_UNIX
 #include <gio/gunixmounts.h>
@@ -32,6 +33,45 @@
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h> /* realpath */
 #endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_SYSMACROS_H
+#include <sys/sysmacros.h> /* makedev */
+#endif
+#ifdef HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_QUOTA_H
+#include <sys/quota.h> /* quotactl */
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_VFS_H
+#include <sys/vfs.h> /* fstatfs */
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h> /* FICLONE */
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h> /* sscanf */
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #ifndef HAVE_REALPATH
 #define realpath(path, resolved_path) NULL
@@ -43,10 +83,46 @@
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
 
+/* number of files launched in one main loop iteration for applications
+ * which take a single file per process, see thunar_g_app_info_launch() */
+#define THUNAR_G_APP_INFO_LAUNCH_BATCH 8
+
+/* bytes copied by thunar_g_file_copy_native() between two progress
+ * reports, and the size of its buffer if the kernel can't copy */
+#define THUNAR_G_FILE_COPY_CHUNK_SIZE  (8 * 1024 * 1024)
+#define THUNAR_G_FILE_COPY_BUFFER_SIZE (1024 * 1024)
+
+/* files from this size on bypass the page cache while they are copied */
+#define THUNAR_G_FILE_COPY_UNCACHED_SIZE ((goffset) 1024 * 1024 * 1024)
+
+/* files from this size on are copied to file servers with several streams,
+ * which take ranges of this size in turn */
+#define THUNAR_G_FILE_COPY_STREAMS_SIZE  ((goffset) 1024 * 1024 * 1024)
+#define THUNAR_G_FILE_COPY_STREAM_RANGE  THUNAR_G_FILE_COPY_CHUNK_SIZE
+
+/* file systems of file servers, see statfs(2) */
+#define THUNAR_G_FILE_NFS_MAGIC  0x6969
+#define THUNAR_G_FILE_SMB_MAGIC  0x517b
+#define THUNAR_G_FILE_CIFS_MAGIC 0xff534d42
+#define THUNAR_G_FILE_SMB2_MAGIC 0xfe534d42
+#define THUNAR_G_FILE_CEPH_MAGIC 0x00c36400
+
+/* resumable copies record their progress every checkpoint, and compare
+ * the end of the data already copied before they continue */
+#define THUNAR_G_FILE_COPY_CHECKPOINT_SIZE (16 * 1024 * 1024)
+#define THUNAR_G_FILE_COPY_RESUME_WINDOW   (64 * 1024)
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+
 /* See : https://freedesktop.org/wiki/Specifications/icon-naming-spec/ */
 static struct
 {
@@ -636,74 +712,1406 @@ thunar_g_file_get_free_space (GFile   *file,
 
   _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
 
-  filesystem_info = g_file_query_filesystem_info (file,
-                                                  THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                                  NULL, NULL);
+  filesystem_info = g_file_query_filesystem_info (file,
+                                                  THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                                  NULL, NULL);
+
+  if (filesystem_info != NULL)
+    {
+      if (fs_free_return != NULL)
+        {
+          *fs_free_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+        }
+
+      if (fs_size_return != NULL)
+        {
+          *fs_size_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+        }
+
+      g_object_unref (filesystem_info);
+    }
+
+  return success;
+}
+
+
+
+gchar *
+thunar_g_file_get_free_space_string (GFile *file, gboolean file_size_binary)
+{
+  guint64 fs_size_free;
+  guint64 fs_size_total;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  if (thunar_g_file_get_free_space (file, &fs_size_free, &fs_size_total))
+    return thunar_g_format_free_space (fs_size_free, fs_size_total, file_size_binary);
+
+  return NULL;
+}
+
+
+
+/**
+ * thunar_g_format_free_space:
+ * @fs_free          : the amount of free space.
+ * @fs_size          : the total volume size.
+ * @file_size_binary : %TRUE to use binary units.
+ *
+ * Formats the usage of a volume like thunar_g_file_get_free_space_string(),
+ * for sizes that were determined already.
+ *
+ * Return value: the usage string, or %NULL if @fs_size is 0.
+ **/
+gchar *
+thunar_g_format_free_space (guint64  fs_free,
+                            guint64  fs_size,
+                            gboolean file_size_binary)
+{
+  gchar *fs_size_free_str;
+  gchar *fs_size_used_str;
+  gchar *free_space_string;
+
+  if (fs_size == 0)
+    return NULL;
+
+  fs_size_free_str = g_format_size_full (fs_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+  fs_size_used_str = g_format_size_full (fs_size - fs_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+
+  free_space_string = g_strdup_printf (_("%s used (%.0f%%)  |  %s free (%.0f%%)"),
+                                       fs_size_used_str, ((fs_size - fs_free) * 100.0 / fs_size),
+                                       fs_size_free_str, (fs_free * 100.0 / fs_size));
+
+  g_free (fs_size_free_str);
+  g_free (fs_size_used_str);
+
+  return free_space_string;
+}
+
+
+
+GType
+thunar_g_file_list_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      type = g_boxed_type_register_static (I_("ThunarGFileList"),
+                                           (GBoxedCopyFunc) thunar_g_list_copy_deep,
+                                           (GBoxedFreeFunc) thunar_g_list_free_full);
+    }
+
+  return type;
+}
+
+
+
+static gboolean
+thunar_g_file_copy_native_write (gint          dest_fd,
+                                 const gchar  *buffer,
+                                 gsize         length)
+{
+  gssize written;
+
+  while (length > 0)
+    {
+      written = write (dest_fd, buffer, length);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return FALSE;
+
+      buffer += written;
+      length -= written;
+    }
+
+  return TRUE;
+}
+
+
+
+/* reads and writes through a buffer, returns the number of bytes copied or -1
+ * with errno set and read_failed set if reading failed. Huge files are written out while they are copied and
+ * dropped from the page cache, so they don't push everything else out of it */
+static gint64
+thunar_g_file_copy_native_buffered (gint                  source_fd,
+                                    gint                  dest_fd,
+                                    goffset               size,
+                                    gboolean              uncached,
+                                    GChecksum            *checksum,
+                                    GCancellable         *cancellable,
+                                    GFileProgressCallback progress_callback,
+                                    gpointer              progress_callback_data,
+                                    gboolean             *read_failed)
+{
+  goffset copied = 0;
+  goffset flushed = 0;
+  gsize   buffer_size;
+  gssize  n;
+  gchar  *buffer;
+
+  if (uncached)
+    {
+#if defined(HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+      /* reserve the space at once, which also keeps the file in one piece */
+      fallocate (dest_fd, FALLOC_FL_KEEP_SIZE, 0, size);
+#endif
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_SEQUENTIAL)
+      /* let the kernel read ahead while the last chunk is written */
+      posix_fadvise (source_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+  buffer_size = uncached ? THUNAR_G_FILE_COPY_CHUNK_SIZE : THUNAR_G_FILE_COPY_BUFFER_SIZE;
+  buffer = g_malloc (buffer_size);
+
+  while (!g_cancellable_is_cancelled (cancellable))
+    {
+      n = read (source_fd, buffer, buffer_size);
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n < 0 || (n > 0 && !thunar_g_file_copy_native_write (dest_fd, buffer, n)))
+        {
+          *read_failed = (n < 0);
+          g_free (buffer);
+          return -1;
+        }
+
+      if (n == 0)
+        break;
+
+      if (checksum != NULL)
+        g_checksum_update (checksum, (const guchar *) buffer, n);
+
+      copied += n;
+
+      /* start writing out this chunk, then wait for the chunks before,
+       * which are written by now, and drop them on both ends */
+      if (uncached && copied - n > flushed)
+        {
+#ifdef HAVE_SYNC_FILE_RANGE
+          sync_file_range (dest_fd, copied - n, n, SYNC_FILE_RANGE_WRITE);
+          sync_file_range (dest_fd, flushed, copied - n - flushed,
+                           SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+          posix_fadvise (dest_fd, flushed, copied - n - flushed, POSIX_FADV_DONTNEED);
+          posix_fadvise (source_fd, flushed, copied - flushed, POSIX_FADV_DONTNEED);
+#endif
+          flushed = copied - n;
+        }
+
+      if (progress_callback != NULL)
+        progress_callback (copied, size, progress_callback_data);
+    }
+
+  g_free (buffer);
+
+  return copied;
+}
+
+
+
+#ifdef SEEK_DATA
+static gboolean
+thunar_g_file_copy_native_pwrite (gint          dest_fd,
+                                  const gchar  *buffer,
+                                  gsize         length,
+                                  goffset       offset)
+{
+  gssize written;
+
+  while (length > 0)
+    {
+      written = pwrite (dest_fd, buffer, length, offset);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return FALSE;
+
+      buffer += written;
+      length -= written;
+      offset += written;
+    }
+
+  return TRUE;
+}
+
+
+
+/* copies the range of data from start to end at the same offset, sets
+ * read_failed if reading failed */
+static gboolean
+thunar_g_file_copy_native_range (gint          source_fd,
+                                 gint          dest_fd,
+                                 goffset       start,
+                                 goffset       end,
+                                 gchar        *buffer,
+                                 GChecksum    *checksum,
+                                 GCancellable *cancellable,
+                                 gboolean     *kernel_copy,
+                                 gboolean     *read_failed)
+{
+  gssize n;
+#ifdef HAVE_COPY_FILE_RANGE
+  loff_t off_in;
+  loff_t off_out;
+#endif
+
+  while (start < end && !g_cancellable_is_cancelled (cancellable))
+    {
+#ifdef HAVE_COPY_FILE_RANGE
+      if (*kernel_copy && checksum == NULL)
+        {
+          off_in = off_out = start;
+          n = copy_file_range (source_fd, &off_in, dest_fd, &off_out,
+                               MIN (end - start, THUNAR_G_FILE_COPY_CHUNK_SIZE), 0);
+          if (n < 0 && errno == EINTR)
+            continue;
+
+          if (n > 0)
+            {
+              start += n;
+              continue;
+            }
+
+          if (n == 0)
+            {
+              /* the source was truncated meanwhile */
+              *read_failed = TRUE;
+              errno = EIO;
+              return FALSE;
+            }
+
+          if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP)
+            return FALSE;
+
+          /* copy through the buffer from now on */
+          *kernel_copy = FALSE;
+        }
+#endif
+
+      n = pread (source_fd, buffer, MIN (end - start, THUNAR_G_FILE_COPY_BUFFER_SIZE), start);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n == 0)
+        errno = EIO;
+      if (n <= 0)
+        {
+          *read_failed = TRUE;
+          return FALSE;
+        }
+      if (!thunar_g_file_copy_native_pwrite (dest_fd, buffer, n, start))
+        return FALSE;
+
+      if (checksum != NULL)
+        g_checksum_update (checksum, (const guchar *) buffer, n);
+
+      start += n;
+    }
+
+  return TRUE;
+}
+
+
+
+/* copies only the data of a sparse file and leaves its holes in place at
+ * the destination, returns the number of bytes copied, counting the holes,
+ * or -1 with errno set and read_failed set if reading failed. Sets
+ * unsupported if the file system can't tell where the holes are, before
+ * anything was copied */
+static gint64
+thunar_g_file_copy_native_sparse (gint                  source_fd,
+                                  gint                  dest_fd,
+                                  goffset               size,
+                                  GChecksum            *checksum,
+                                  GCancellable         *cancellable,
+                                  GFileProgressCallback progress_callback,
+                                  gpointer              progress_callback_data,
+                                  gboolean             *unsupported,
+                                  gboolean             *read_failed)
+{
+  goffset  offset = 0;
+  goffset  data;
+  goffset  hole;
+  goffset  n;
+  gboolean kernel_copy = TRUE;
+  gchar   *buffer;
+  gchar   *zeros = NULL;
+
+  *unsupported = FALSE;
+
+  buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+
+  while (offset < size && !g_cancellable_is_cancelled (cancellable))
+    {
+      data = lseek (source_fd, offset, SEEK_DATA);
+      if (data < 0 && errno == ENXIO)
+        {
+          /* only a hole is left */
+          data = size;
+        }
+      else if (data < 0)
+        {
+          *unsupported = (offset == 0 && errno == EINVAL);
+          *read_failed = TRUE;
+          offset = -1;
+          break;
+        }
+
+      hole = MIN (data, size);
+      if (data < size)
+        {
+          hole = lseek (source_fd, data, SEEK_HOLE);
+          if (hole < 0)
+            {
+              *read_failed = TRUE;
+              offset = -1;
+              break;
+            }
+          hole = MIN (hole, size);
+        }
+
+      /* a checksum covers the zeros of the hole too */
+      if (checksum != NULL && offset < data)
+        {
+          if (zeros == NULL)
+            zeros = g_malloc0 (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+          for (n = offset; n < MIN (data, size); n += THUNAR_G_FILE_COPY_BUFFER_SIZE)
+            g_checksum_update (checksum, (const guchar *) zeros, MIN (MIN (data, size) - n, THUNAR_G_FILE_COPY_BUFFER_SIZE));
+        }
+
+      if (data < hole && !thunar_g_file_copy_native_range (source_fd, dest_fd, data, hole, buffer,
+                                                           checksum, cancellable, &kernel_copy, read_failed))
+        {
+          offset = -1;
+          break;
+        }
+
+      offset = MAX (hole, offset);
+
+      /* progress is reported in logical bytes, a hole is copied at once */
+      if (progress_callback != NULL)
+        progress_callback (offset, size, progress_callback_data);
+    }
+
+  g_free (buffer);
+  g_free (zeros);
+
+  if (offset < 0)
+    return -1;
+
+  /* a trailing hole only exists as the length of the file */
+  if (!g_cancellable_is_cancelled (cancellable) && ftruncate (dest_fd, size) != 0)
+    return -1;
+
+  return offset;
+}
+
+
+/* the state shared by the streams of thunar_g_file_copy_native_parallel() */
+typedef struct
+{
+  gint          source_fd;
+  gint          dest_fd;
+  goffset       size;
+  GCancellable *cancellable;
+
+  GMutex        mutex;
+  GCond         cond;
+  goffset       next;       /* start of the next range to copy */
+  goffset       copied;     /* bytes copied by all streams */
+  guint         n_running;
+  gint          error;      /* errno of the first stream that failed, or 0 */
+  gboolean      read_failed; /* whether the first failure was reading */
+}
+ThunarGFileCopyStreams;
+
+
+
+static gboolean
+thunar_g_file_copy_native_is_remote (gint fd)
+{
+#ifdef HAVE_SYS_VFS_H
+  struct statfs statfsb;
+
+  if (fstatfs (fd, &statfsb) != 0)
+    return FALSE;
+
+  switch ((guint32) statfsb.f_type)
+    {
+    case THUNAR_G_FILE_NFS_MAGIC:
+    case THUNAR_G_FILE_SMB_MAGIC:
+    case THUNAR_G_FILE_CIFS_MAGIC:
+    case THUNAR_G_FILE_SMB2_MAGIC:
+    case THUNAR_G_FILE_CEPH_MAGIC:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+#else
+  return FALSE;
+#endif
+}
+
+
+
+static gpointer
+thunar_g_file_copy_native_stream (gpointer data)
+{
+  ThunarGFileCopyStreams *streams = data;
+  gboolean                kernel_copy = TRUE;
+  gboolean                read_failed;
+  gboolean                succeed;
+  goffset                 start;
+  goffset                 end;
+  gchar                  *buffer;
+  gint                    saved_errno;
+
+  buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+
+  g_mutex_lock (&streams->mutex);
+  while (streams->error == 0 && streams->next < streams->size
+         && !g_cancellable_is_cancelled (streams->cancellable))
+    {
+      /* take the next range */
+      start = streams->next;
+      end = MIN (start + THUNAR_G_FILE_COPY_STREAM_RANGE, streams->size);
+      streams->next = end;
+      g_mutex_unlock (&streams->mutex);
+
+      read_failed = FALSE;
+      succeed = thunar_g_file_copy_native_range (streams->source_fd, streams->dest_fd, start, end,
+                                                 buffer, NULL, streams->cancellable, &kernel_copy, &read_failed);
+      saved_errno = errno;
+
+      g_mutex_lock (&streams->mutex);
+      if (!succeed && streams->error == 0)
+        {
+          streams->error = (saved_errno != 0) ? saved_errno : EIO;
+          streams->read_failed = read_failed;
+        }
+      else if (succeed)
+        streams->copied += end - start;
+      g_cond_signal (&streams->cond);
+    }
+
+  streams->n_running--;
+  g_cond_signal (&streams->cond);
+  g_mutex_unlock (&streams->mutex);
+
+  g_free (buffer);
+
+  return NULL;
+}
+
+
+
+/* copies a huge file with n_streams positional writes at once, which keeps
+ * a file server busy where a single stream waits for every round trip.
+ * The calling thread reports the progress and hashes the source in order
+ * meanwhile, returns the number of bytes copied or -1 with errno set and
+ * read_failed set if reading failed */
+static gint64
+thunar_g_file_copy_native_parallel (gint                  source_fd,
+                                    gint                  dest_fd,
+                                    goffset               size,
+                                    guint                 n_streams,
+                                    GChecksum            *checksum,
+                                    GCancellable         *cancellable,
+                                    GFileProgressCallback progress_callback,
+                                    gpointer              progress_callback_data,
+                                    gboolean             *read_failed)
+{
+  ThunarGFileCopyStreams streams;
+  GThread              **threads;
+  goffset                hashed = 0;
+  goffset                copied;
+  goffset                reported = -1;
+  gssize                 n;
+  gchar                 *buffer = NULL;
+  gint                   error;
+  guint                  i;
+
+  /* the ranges are not written in order */
+  if (ftruncate (dest_fd, size) != 0)
+    return -1;
+
+  streams.source_fd = source_fd;
+  streams.dest_fd = dest_fd;
+  streams.size = size;
+  streams.cancellable = cancellable;
+  streams.next = 0;
+  streams.copied = 0;
+  streams.n_running = n_streams;
+  streams.error = 0;
+  streams.read_failed = FALSE;
+  g_mutex_init (&streams.mutex);
+  g_cond_init (&streams.cond);
+
+  threads = g_new (GThread *, n_streams);
+  for (i = 0; i < n_streams; ++i)
+    threads[i] = g_thread_new ("ThunarCopyStream", thunar_g_file_copy_native_stream, &streams);
+
+  if (checksum != NULL)
+    buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+
+  g_mutex_lock (&streams.mutex);
+  while (streams.n_running > 0 || (checksum != NULL && hashed < size && streams.error == 0))
+    {
+      if (checksum != NULL && hashed < size && streams.error == 0
+          && !g_cancellable_is_cancelled (cancellable))
+        {
+          /* the source is local, reading it a second time is cheap */
+          g_mutex_unlock (&streams.mutex);
+          n = pread (source_fd, buffer, MIN (size - hashed, THUNAR_G_FILE_COPY_BUFFER_SIZE), hashed);
+          error = (n < 0) ? errno : EIO;
+          g_mutex_lock (&streams.mutex);
+
+          if (n > 0)
+            {
+              g_checksum_update (checksum, (const guchar *) buffer, n);
+              hashed += n;
+            }
+          else if (error != EINTR && streams.error == 0)
+            {
+              streams.error = error;
+              streams.read_failed = TRUE;
+            }
+        }
+      else if (streams.n_running > 0)
+        {
+          g_cond_wait_until (&streams.cond, &streams.mutex, g_get_monotonic_time () + G_TIME_SPAN_SECOND / 10);
+        }
+      else
+        {
+          /* cancelled while hashing */
+          break;
+        }
+
+      copied = streams.copied;
+      if (progress_callback != NULL && copied != reported)
+        {
+          g_mutex_unlock (&streams.mutex);
+          progress_callback (copied, size, progress_callback_data);
+          g_mutex_lock (&streams.mutex);
+          reported = copied;
+        }
+    }
+  g_mutex_unlock (&streams.mutex);
+
+  for (i = 0; i < n_streams; ++i)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+  g_free (buffer);
+  g_cond_clear (&streams.cond);
+  g_mutex_clear (&streams.mutex);
+
+  if (streams.error != 0)
+    {
+      *read_failed = streams.read_failed;
+      errno = streams.error;
+      return -1;
+    }
+
+  return streams.copied;
+}
+#endif
+
+
+
+/* copies the contents of source_fd to dest_fd, returns the number of bytes
+ * copied or -1 with errno set and read_failed set if reading the source
+ * failed, the copy can be stopped with cancellable.
+ * sparse tells whether the source has holes, which are kept, and huge files
+ * go to file servers with up to n_streams writes at once */
+static gint64
+thunar_g_file_copy_native_data (gint                  source_fd,
+                                gint                  dest_fd,
+                                goffset               size,
+                                gboolean              sparse,
+                                guint                 n_streams,
+                                GChecksum            *checksum,
+                                GCancellable         *cancellable,
+                                GFileProgressCallback progress_callback,
+                                gpointer              progress_callback_data,
+                                gboolean             *read_failed)
+{
+  goffset  copied = 0;
+  gssize   n;
+  gboolean kernel_copy = FALSE;
+  gboolean uncached = (size >= THUNAR_G_FILE_COPY_UNCACHED_SIZE);
+#ifdef SEEK_DATA
+  gboolean unsupported;
+#endif
+
+#ifdef FICLONE
+  /* share the extents on copy-on-write file systems like btrfs and xfs,
+   * a checksum needs the data to pass through our buffer */
+  if (checksum == NULL && ioctl (dest_fd, FICLONE, source_fd) == 0)
+    {
+      if (progress_callback != NULL)
+        progress_callback (size, size, progress_callback_data);
+      return size;
+    }
+#endif
+
+#ifdef SEEK_DATA
+  /* skip the holes of sparse files, like disk images, instead of writing zeros */
+  if (sparse)
+    {
+      copied = thunar_g_file_copy_native_sparse (source_fd, dest_fd, size, checksum, cancellable,
+                                                 progress_callback, progress_callback_data, &unsupported,
+                                                 read_failed);
+      if (!unsupported)
+        {
+          if (copied >= 0 && g_cancellable_is_cancelled (cancellable))
+            {
+              errno = ECANCELED;
+              return -1;
+            }
+          return copied;
+        }
+      copied = 0;
+      *read_failed = FALSE;
+    }
+
+  /* a file server takes several streams at once, where one is bound by the round trips */
+  if (n_streams > 1 && size >= THUNAR_G_FILE_COPY_STREAMS_SIZE && thunar_g_file_copy_native_is_remote (dest_fd))
+    {
+      copied = thunar_g_file_copy_native_parallel (source_fd, dest_fd, size, n_streams, checksum, cancellable,
+                                                   progress_callback, progress_callback_data, read_failed);
+      if (copied >= 0 && g_cancellable_is_cancelled (cancellable))
+        {
+          errno = ECANCELED;
+          return -1;
+        }
+      return copied;
+    }
+#endif
+
+  /* a checksum needs the data to pass through our buffer */
+  if (checksum != NULL)
+    goto buffered;
+
+  /* the kernel copies go through the page cache */
+  if (uncached)
+    goto buffered;
+
+#ifdef HAVE_COPY_FILE_RANGE
+  /* let the kernel (or the file server) copy the data */
+  kernel_copy = TRUE;
+  while (kernel_copy && !g_cancellable_is_cancelled (cancellable))
+    {
+      n = copy_file_range (source_fd, NULL, dest_fd, NULL, THUNAR_G_FILE_COPY_CHUNK_SIZE, 0);
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n < 0)
+        {
+          /* try the other ways, unless the copy already started */
+          if (copied > 0 || (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP))
+            return -1;
+          kernel_copy = FALSE;
+          break;
+        }
+
+      /* some file systems, e.g. procfs, copy nothing at all */
+      if (n == 0 && copied == 0 && size > 0)
+        {
+          kernel_copy = FALSE;
+          break;
+        }
+
+      if (n == 0)
+        return copied;
+
+      copied += n;
+      if (progress_callback != NULL)
+        progress_callback (copied, size, progress_callback_data);
+    }
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+  /* avoid the copies into userspace at least */
+  kernel_copy = TRUE;
+  while (kernel_copy && !g_cancellable_is_cancelled (cancellable))
+    {
+      n = sendfile (dest_fd, source_fd, NULL, THUNAR_G_FILE_COPY_CHUNK_SIZE);
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n < 0)
+        {
+          if (copied > 0 || (errno != ENOSYS && errno != EINVAL))
+            return -1;
+          kernel_copy = FALSE;
+          break;
+        }
+
+      if (n == 0 && copied == 0 && size > 0)
+        {
+          kernel_copy = FALSE;
+          break;
+        }
+
+      if (n == 0)
+        return copied;
+
+      copied += n;
+      if (progress_callback != NULL)
+        progress_callback (copied, size, progress_callback_data);
+    }
+#endif
+
+buffered:
+  if (!kernel_copy)
+    {
+      /* read and write with a large buffer, the last resort */
+      copied = thunar_g_file_copy_native_buffered (source_fd, dest_fd, size, uncached, checksum, cancellable,
+                                                   progress_callback, progress_callback_data, read_failed);
+      if (copied < 0)
+        return -1;
+    }
+
+  if (g_cancellable_is_cancelled (cancellable))
+    {
+      errno = ECANCELED;
+      return -1;
+    }
+
+  return copied;
+}
+
+
+
+/**
+ * thunar_g_file_copy_native:
+ * @source                 : input #GFile
+ * @destination            : destination #GFile
+ * @flags                  : set of #GFileCopyFlags
+ * @n_streams              : the number of concurrent writes of a huge file to a file server
+ * @checksum               : (nullable): a #GChecksum to update with the copied data
+ * @cancellable            : (nullable): optional #GCancellable object
+ * @progress_callback      : (nullable) (scope call): function to callback with progress information
+ * @progress_callback_data : (clousure): user data to pass to @progress_callback
+ * @handled                : return location for whether the file was handled
+ * @error                  : (nullable): #GError to set on error
+ *
+ * Copies a local regular file to a new local destination, letting the
+ * kernel clone or copy the data where possible instead of reading it
+ * into a buffer. Huge files are copied without filling the page cache,
+ * or with @n_streams ranges at once to NFS, SMB and Ceph mounts, and the
+ * holes of sparse files are kept rather than filled with zeros.
+ * The attributes are copied like g_file_copy() does.
+ *
+ * Everything else, like existing destinations, symlinks or remote files,
+ * is left to g_file_copy(), which is indicated by @handled being %FALSE.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise.
+ **/
+static gboolean
+thunar_g_file_copy_native (GFile                *source,
+                           GFile                *destination,
+                           GFileCopyFlags        flags,
+                           guint                 n_streams,
+                           GChecksum            *checksum,
+                           GCancellable         *cancellable,
+                           GFileProgressCallback progress_callback,
+                           gpointer              progress_callback_data,
+                           gboolean             *handled,
+                           GError              **error)
+{
+  const gchar *source_path;
+  const gchar *dest_path;
+  struct stat  statb;
+  gint         source_fd;
+  gint         dest_fd;
+  gint         saved_errno;
+  gint64       copied;
+  gboolean     read_failed = FALSE;
+
+  *handled = FALSE;
+
+  if ((flags & G_FILE_COPY_BACKUP) != 0)
+    return FALSE;
+
+  source_path = g_file_peek_path (source);
+  dest_path = g_file_peek_path (destination);
+  if (source_path == NULL || dest_path == NULL
+      || !g_file_is_native (source) || !g_file_is_native (destination))
+    return FALSE;
+
+  /* only regular files, symlinks are copied as links with G_FILE_COPY_NOFOLLOW_SYMLINKS */
+  if (((flags & G_FILE_COPY_NOFOLLOW_SYMLINKS) ? lstat (source_path, &statb) : stat (source_path, &statb)) != 0
+      || !S_ISREG (statb.st_mode))
+    return FALSE;
+
+  source_fd = open (source_path, O_RDONLY | O_CLOEXEC);
+  if (source_fd < 0)
+    return FALSE;
+
+  /* g_file_copy() produces the proper errors for existing destinations */
+  dest_fd = open (dest_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+  if (dest_fd < 0)
+    {
+      close (source_fd);
+      return FALSE;
+    }
+
+  /* from here on, the copy is ours */
+  *handled = TRUE;
+
+  /* less space allocated than the length of the file means there are holes */
+  copied = thunar_g_file_copy_native_data (source_fd, dest_fd, statb.st_size,
+                                           (goffset) statb.st_blocks * 512 < statb.st_size,
+                                           n_streams, checksum, cancellable,
+                                           progress_callback, progress_callback_data, &read_failed);
+  saved_errno = errno;
+
+  close (source_fd);
+  if (close (dest_fd) != 0 && copied >= 0)
+    {
+      saved_errno = errno;
+      copied = -1;
+    }
+
+  if (copied < 0)
+    {
+      /* remove the incomplete file */
+      g_unlink (dest_path);
+
+      if (saved_errno == ECANCELED)
+        g_cancellable_set_error_if_cancelled (cancellable, error);
+      else if (read_failed)
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                     _("Error reading from file \"%s\": %s"), source_path, g_strerror (saved_errno));
+      else
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                     _("Error writing to file \"%s\": %s"), dest_path, g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  /* failure to copy the attributes is not fatal, like in g_file_copy() */
+  g_file_copy_attributes (source, destination, flags, cancellable, NULL);
+
+  return TRUE;
+}
+
+
+
+/* copies a regular file through streams, so the data can be hashed
+ * into checksum on the way, without reading the source a second time */
+static gboolean
+thunar_g_file_copy_checksum (GFile                *source,
+                             GFile                *destination,
+                             GFileCopyFlags        flags,
+                             GChecksum            *checksum,
+                             GCancellable         *cancellable,
+                             GFileProgressCallback progress_callback,
+                             gpointer              progress_callback_data,
+                             GError              **error)
+{
+  GFileInputStream  *input;
+  GFileOutputStream *output;
+  GFileInfo         *info;
+  goffset            size = 0;
+  goffset            copied = 0;
+  gssize             n;
+  guchar            *buffer;
+  gboolean           success = TRUE;
+  GCancellable      *abort_cancellable;
+  GError            *err = NULL;
+
+  input = g_file_read (source, cancellable, error);
+  if (input == NULL)
+    return FALSE;
+
+  info = g_file_input_stream_query_info (input, G_FILE_ATTRIBUTE_STANDARD_SIZE, cancellable, NULL);
+  if (info != NULL)
+    {
+      size = g_file_info_get_size (info);
+      g_object_unref (info);
+    }
+
+  if ((flags & G_FILE_COPY_OVERWRITE) != 0)
+    output = g_file_replace (destination, NULL, (flags & G_FILE_COPY_BACKUP) != 0,
+                             G_FILE_CREATE_REPLACE_DESTINATION, cancellable, error);
+  else
+    output = g_file_create (destination, G_FILE_CREATE_NONE, cancellable, error);
+
+  if (output == NULL)
+    {
+      g_object_unref (input);
+      return FALSE;
+    }
+
+  buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+  for (;;)
+    {
+      n = g_input_stream_read (G_INPUT_STREAM (input), buffer, THUNAR_G_FILE_COPY_BUFFER_SIZE, cancellable, &err);
+      if (n <= 0)
+        break;
+
+      g_checksum_update (checksum, buffer, n);
+
+      if (!g_output_stream_write_all (G_OUTPUT_STREAM (output), buffer, n, NULL, cancellable, &err))
+        break;
+
+      copied += n;
+      if (progress_callback != NULL)
+        progress_callback (copied, size, progress_callback_data);
+    }
+  g_free (buffer);
+
+  g_input_stream_close (G_INPUT_STREAM (input), NULL, NULL);
+  g_object_unref (input);
+
+  if (err != NULL)
+    {
+      /* closing with a cancelled cancellable drops the data written so
+       * far, so a replaced destination keeps its old contents */
+      abort_cancellable = g_cancellable_new ();
+      g_cancellable_cancel (abort_cancellable);
+      g_output_stream_close (G_OUTPUT_STREAM (output), abort_cancellable, NULL);
+      g_object_unref (abort_cancellable);
+      success = FALSE;
+    }
+  else if (!g_output_stream_close (G_OUTPUT_STREAM (output), cancellable, &err))
+    {
+      success = FALSE;
+    }
+  g_object_unref (output);
+
+  if (!success)
+    {
+      /* remove the incomplete file, unless it replaced an existing one */
+      if ((flags & G_FILE_COPY_OVERWRITE) == 0)
+        g_file_delete (destination, NULL, NULL);
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  /* failure to copy the attributes is not fatal, like in g_file_copy() */
+  g_file_copy_attributes (source, destination, flags, cancellable, NULL);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_g_file_copy_data (GFile                *source,
+                         GFile                *destination,
+                         GFileCopyFlags        flags,
+                         guint                 n_streams,
+                         GChecksum            *checksum,
+                         GCancellable         *cancellable,
+                         GFileProgressCallback progress_callback,
+                         gpointer              progress_callback_data,
+                         GError              **error)
+{
+  gboolean handled;
+  gboolean success;
+
+  success = thunar_g_file_copy_native (source, destination, flags, n_streams, checksum, cancellable,
+                                       progress_callback, progress_callback_data, &handled, error);
+  if (handled)
+    return success;
+
+  if (checksum != NULL)
+    return thunar_g_file_copy_checksum (source, destination, flags, checksum, cancellable,
+                                        progress_callback, progress_callback_data, error);
+
+  return g_file_copy (source, destination, flags, cancellable, progress_callback, progress_callback_data, error);
+}
+
+
+
+/* the progress of a thunar_g_file_copy(), which is passed on to its caller */
+typedef struct
+{
+  GFileProgressCallback callback;
+  gpointer              data;
+  goffset               copied;
+} ThunarGFileCopyProgress;
+
+
+
+static void
+thunar_g_file_copy_progress (goffset  current_num_bytes,
+                             goffset  total_num_bytes,
+                             gpointer user_data)
+{
+  ThunarGFileCopyProgress *progress = user_data;
+
+  progress->copied = current_num_bytes;
+  if (progress->callback != NULL)
+    (*progress->callback) (current_num_bytes, total_num_bytes, progress->data);
+}
+
+
+
+static gboolean
+thunar_g_file_copy_record (ThunarGFileCopyProgress *progress,
+                           gint64                   start_time,
+                           gboolean                 success)
+{
+  /* the throughput of the copies is the sum of the bytes over the sum of the times */
+  if (success)
+    {
+      thunar_stats_record_since (THUNAR_STATS_COPY_FILE, start_time);
+      thunar_stats_record (THUNAR_STATS_COPY_FILE_BYTES, MAX (progress->copied, 0));
+    }
+
+  return success;
+}
+
+
+
+/* the journal of a *.partial~ file, it tells which source the file was
+ * copied from and how much of it was written when the copy stopped */
+static gchar *
+thunar_g_file_copy_journal_path (GFile *partial)
+{
+  gchar *uri;
+  gchar *name;
+  gchar *spec;
+  gchar *path;
+
+  uri = g_file_get_uri (partial);
+  name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  spec = g_strconcat ("Thunar/transfers/", name, NULL);
+  path = xfce_resource_save_location (XFCE_RESOURCE_CACHE, spec, TRUE);
+  g_free (spec);
+  g_free (name);
+  g_free (uri);
+
+  return path;
+}
+
+
+
+static void
+thunar_g_file_copy_journal_save (GFile     *source,
+                                 GFile     *partial,
+                                 GFileInfo *info,
+                                 goffset    committed)
+{
+  GKeyFile *journal;
+  gchar    *path;
+  gchar    *uri;
+
+  path = thunar_g_file_copy_journal_path (partial);
+  if (path == NULL)
+    return;
+
+  uri = g_file_get_uri (source);
+  journal = g_key_file_new ();
+  g_key_file_set_string (journal, "Transfer", "Source", uri);
+  g_key_file_set_int64 (journal, "Transfer", "Size", g_file_info_get_size (info));
+  g_key_file_set_uint64 (journal, "Transfer", "MTime",
+                         g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+  g_key_file_set_int64 (journal, "Transfer", "Committed", committed);
+
+  /* a lost journal only means the copy starts over */
+  g_key_file_save_to_file (journal, path, NULL);
+
+  g_key_file_free (journal);
+  g_free (uri);
+  g_free (path);
+}
+
+
+
+static void
+thunar_g_file_copy_journal_remove (GFile *partial)
+{
+  gchar *path;
+
+  path = thunar_g_file_copy_journal_path (partial);
+  if (path != NULL)
+    g_unlink (path);
+  g_free (path);
+}
+
+
+
+/* returns the number of bytes of source already in partial, or 0 if
+ * partial is not an interrupted copy of this version of source */
+static goffset
+thunar_g_file_copy_journal_load (GFile        *source,
+                                 GFile        *partial,
+                                 GFileInfo    *info,
+                                 GCancellable *cancellable)
+{
+  GFileInputStream *streams[2] = { NULL, NULL };
+  GFileInfo        *partial_info;
+  GKeyFile         *journal;
+  goffset           committed = 0;
+  gsize             window;
+  gsize             n_read[2];
+  guint8           *buffers[2];
+  gchar            *source_uri;
+  gchar            *journal_uri;
+  gchar            *path;
+  guint             n;
+
+  path = thunar_g_file_copy_journal_path (partial);
+  if (path == NULL)
+    return 0;
+
+  journal = g_key_file_new ();
+  if (g_key_file_load_from_file (journal, path, G_KEY_FILE_NONE, NULL))
+    {
+      source_uri = g_file_get_uri (source);
+      journal_uri = g_key_file_get_string (journal, "Transfer", "Source", NULL);
+
+      /* the source must not have changed since the copy stopped */
+      if (g_strcmp0 (source_uri, journal_uri) == 0
+          && g_key_file_get_int64 (journal, "Transfer", "Size", NULL) == g_file_info_get_size (info)
+          && g_key_file_get_uint64 (journal, "Transfer", "MTime", NULL)
+             == g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+        committed = g_key_file_get_int64 (journal, "Transfer", "Committed", NULL);
+
+      g_free (journal_uri);
+      g_free (source_uri);
+    }
+  g_key_file_free (journal);
+  g_free (path);
+
+  if (committed <= 0 || committed > g_file_info_get_size (info))
+    return 0;
+
+  /* the partial file must hold at least the committed data */
+  partial_info = g_file_query_info (partial, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
+  if (partial_info == NULL)
+    return 0;
+  if (g_file_info_get_size (partial_info) < committed)
+    committed = 0;
+  g_object_unref (partial_info);
+
+  if (committed == 0)
+    return 0;
+
+  /* the data written last is the most likely to be lost in a crash,
+   * so it has to be the same in both files before the copy continues */
+  window = MIN (committed, THUNAR_G_FILE_COPY_RESUME_WINDOW);
+  buffers[0] = g_malloc (window);
+  buffers[1] = g_malloc (window);
+  streams[0] = g_file_read (source, cancellable, NULL);
+  streams[1] = g_file_read (partial, cancellable, NULL);
+  for (n = 0; n < 2; ++n)
+    {
+      if (streams[n] == NULL
+          || !g_seekable_seek (G_SEEKABLE (streams[n]), committed - window, G_SEEK_SET, cancellable, NULL)
+          || !g_input_stream_read_all (G_INPUT_STREAM (streams[n]), buffers[n], window, &n_read[n], cancellable, NULL)
+          || n_read[n] != window)
+        committed = 0;
+    }
+
+  if (committed > 0 && memcmp (buffers[0], buffers[1], window) != 0)
+    committed = 0;
+
+  for (n = 0; n < 2; ++n)
+    if (streams[n] != NULL)
+      {
+        g_input_stream_close (G_INPUT_STREAM (streams[n]), NULL, NULL);
+        g_object_unref (streams[n]);
+      }
+  g_free (buffers[0]);
+  g_free (buffers[1]);
+
+  return committed;
+}
+
+
+
+/* copies a regular file into partial, continuing an interrupted copy if
+ * the journal of partial allows it. Unlike the other copies, partial and
+ * its journal are left behind on failure, so the next copy can resume */
+static gboolean
+thunar_g_file_copy_resumable (GFile                *source,
+                              GFile                *partial,
+                              GFileCopyFlags        flags,
+                              GChecksum            *checksum,
+                              GCancellable         *cancellable,
+                              GFileProgressCallback progress_callback,
+                              gpointer              progress_callback_data,
+                              gboolean             *handled,
+                              GError              **error)
+{
+  GFileInputStream  *input;
+  GFileInputStream  *prefix;
+  GFileOutputStream *output;
+  GFileIOStream     *iostream = NULL;
+  GFileInfo         *info;
+  GError            *err = NULL;
+  gboolean           success = TRUE;
+  goffset            committed;
+  goffset            checkpoint;
+  goffset            copied;
+  goffset            size;
+  gssize             n;
+  guint8            *buffer;
+
+  *handled = FALSE;
+
+  info = g_file_query_info (source,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS) ? G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS : G_FILE_QUERY_INFO_NONE,
+                            cancellable, NULL);
+  if (info == NULL)
+    return FALSE;
+
+  size = g_file_info_get_size (info);
+  committed = thunar_g_file_copy_journal_load (source, partial, info, cancellable);
+
+  input = g_file_read (source, cancellable, NULL);
+  if (input == NULL || (committed > 0 && !g_seekable_seek (G_SEEKABLE (input), committed, G_SEEK_SET, cancellable, NULL)))
+    committed = 0;
+
+  if (committed > 0)
+    {
+      /* drop whatever was written after the last checkpoint */
+      iostream = g_file_open_readwrite (partial, cancellable, NULL);
+      if (iostream == NULL
+          || !g_seekable_truncate (G_SEEKABLE (iostream), committed, cancellable, NULL)
+          || !g_seekable_seek (G_SEEKABLE (iostream), committed, G_SEEK_SET, cancellable, NULL))
+        {
+          g_clear_object (&iostream);
+          committed = 0;
+        }
+    }
+
+  if (committed == 0 && input != NULL && g_seekable_tell (G_SEEKABLE (input)) != 0
+      && !g_seekable_seek (G_SEEKABLE (input), 0, G_SEEK_SET, cancellable, NULL))
+    g_clear_object (&input);
+
+  if (input == NULL)
+    {
+      /* let the other copies report the error */
+      g_object_unref (info);
+      return FALSE;
+    }
+
+  *handled = TRUE;
 
-  if (filesystem_info != NULL)
+  /* the verification needs the hash of the whole file, so the part that
+   * is not copied again is read once more */
+  if (committed > 0 && checksum != NULL)
     {
-      if (fs_free_return != NULL)
+      prefix = g_file_read (source, cancellable, &err);
+      buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+      for (copied = 0; prefix != NULL && copied < committed; copied += n)
         {
-          *fs_free_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
-          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+          n = g_input_stream_read (G_INPUT_STREAM (prefix), buffer,
+                                   MIN (committed - copied, THUNAR_G_FILE_COPY_BUFFER_SIZE),
+                                   cancellable, &err);
+          if (n <= 0)
+            break;
+          g_checksum_update (checksum, buffer, n);
         }
+      g_free (buffer);
 
-      if (fs_size_return != NULL)
+      if (prefix != NULL)
         {
-          *fs_size_return = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-          success = g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+          g_input_stream_close (G_INPUT_STREAM (prefix), NULL, NULL);
+          g_object_unref (prefix);
         }
 
-      g_object_unref (filesystem_info);
+      if (err == NULL && copied < committed)
+        err = g_error_new (G_IO_ERROR, G_IO_ERROR_FAILED, "Unexpected end of file \"%s\"", g_file_peek_path (source));
     }
 
-  return success;
-}
-
-
+  if (err != NULL)
+    output = NULL;
+  else if (iostream != NULL)
+    output = g_object_ref (G_FILE_OUTPUT_STREAM (g_io_stream_get_output_stream (G_IO_STREAM (iostream))));
+  else
+    output = g_file_replace (partial, NULL, FALSE, G_FILE_CREATE_NONE, cancellable, &err);
 
-gchar *
-thunar_g_file_get_free_space_string (GFile *file, gboolean file_size_binary)
-{
-  gchar             *fs_size_free_str;
-  gchar             *fs_size_used_str;
-  guint64            fs_size_free;
-  guint64            fs_size_total;
-  gchar             *free_space_string = NULL;
+  if (output == NULL)
+    {
+      g_clear_object (&iostream);
+      g_input_stream_close (G_INPUT_STREAM (input), NULL, NULL);
+      g_object_unref (input);
+      g_object_unref (info);
+      g_propagate_error (error, err);
+      return FALSE;
+    }
 
-  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  if (progress_callback != NULL && committed > 0)
+    progress_callback (committed, size, progress_callback_data);
 
-  if (thunar_g_file_get_free_space (file, &fs_size_free, &fs_size_total) && fs_size_total > 0)
+  copied = checkpoint = committed;
+  buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+  for (;;)
     {
-      fs_size_free_str = g_format_size_full (fs_size_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-      fs_size_used_str = g_format_size_full (fs_size_total - fs_size_free, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+      n = g_input_stream_read (G_INPUT_STREAM (input), buffer, THUNAR_G_FILE_COPY_BUFFER_SIZE, cancellable, &err);
+      if (n <= 0)
+        break;
 
-      free_space_string = g_strdup_printf (_("%s used (%.0f%%)  |  %s free (%.0f%%)"),
-                                   fs_size_used_str, ((fs_size_total - fs_size_free) * 100.0 / fs_size_total),
-                                   fs_size_free_str, (fs_size_free * 100.0 / fs_size_total));
+      if (checksum != NULL)
+        g_checksum_update (checksum, buffer, n);
 
-      g_free (fs_size_free_str);
-      g_free (fs_size_used_str);
-    }
+      if (!g_output_stream_write_all (G_OUTPUT_STREAM (output), buffer, n, NULL, cancellable, &err))
+        break;
 
-  return free_space_string;
-}
+      copied += n;
+      if (copied - checkpoint >= THUNAR_G_FILE_COPY_CHECKPOINT_SIZE
+          && g_output_stream_flush (G_OUTPUT_STREAM (output), cancellable, NULL))
+        {
+          thunar_g_file_copy_journal_save (source, partial, info, copied);
+          checkpoint = copied;
+        }
 
+      if (progress_callback != NULL)
+        progress_callback (copied, size, progress_callback_data);
+    }
+  g_free (buffer);
 
+  g_input_stream_close (G_INPUT_STREAM (input), NULL, NULL);
+  g_object_unref (input);
 
-GType
-thunar_g_file_list_get_type (void)
-{
-  static GType type = G_TYPE_INVALID;
+  if (err != NULL)
+    {
+      /* remember how far the copy got, even when it was cancelled */
+      if (g_output_stream_flush (G_OUTPUT_STREAM (output), NULL, NULL))
+        checkpoint = copied;
+      g_output_stream_close (G_OUTPUT_STREAM (output), NULL, NULL);
+      success = FALSE;
+    }
+  else if (!g_output_stream_close (G_OUTPUT_STREAM (output), cancellable, &err))
+    {
+      success = FALSE;
+    }
+  g_object_unref (output);
+  g_clear_object (&iostream);
 
-  if (G_UNLIKELY (type == G_TYPE_INVALID))
+  if (!success)
     {
-      type = g_boxed_type_register_static (I_("ThunarGFileList"),
-                                           (GBoxedCopyFunc) thunar_g_list_copy_deep,
-                                           (GBoxedFreeFunc) thunar_g_list_free_full);
+      if (checkpoint > 0)
+        thunar_g_file_copy_journal_save (source, partial, info, checkpoint);
+      g_object_unref (info);
+      g_propagate_error (error, err);
+      return FALSE;
     }
 
-  return type;
+  thunar_g_file_copy_journal_remove (partial);
+  g_object_unref (info);
+
+  /* failure to copy the attributes is not fatal, like in g_file_copy() */
+  g_file_copy_attributes (source, partial, flags, cancellable, NULL);
+
+  return TRUE;
 }
 
 
@@ -714,6 +2122,9 @@ thunar_g_file_list_get_type (void)
  * @destination            : destination #GFile
  * @flags                  : set of #GFileCopyFlags
  * @use_partial            : option to use *.partial~
+ * @resume_partial         : whether an interrupted copy to *.partial~ is continued
+ * @n_streams              : the number of ranges of a huge file written at once to a file server
+ * @checksum               : (nullable): a #GChecksum to update with the data of the copied regular file
  * @cancellable            : (nullable): optional #GCancellable object
  * @progress_callback      : (nullable) (scope call): function to callback with progress information
  * @progress_callback_data : (clousure): user data to pass to @progress_callback
@@ -721,7 +2132,19 @@ thunar_g_file_list_get_type (void)
  *
  * Calls g_file_copy() if @use_partial is not enabled.
  * If enabled, copies files to *.partial~ first and then
- * renames *.partial~ into its original name.
+ * renames *.partial~ into its original name. Local regular
+ * files are cloned or copied by the kernel where possible.
+ *
+ * With @resume_partial, a failed or cancelled copy keeps its
+ * *.partial~ file and records its progress in a journal, and
+ * copying the same unchanged @source again continues from there.
+ *
+ * With @n_streams above 1, a huge local file copied to an NFS, SMB or
+ * Ceph mount is split into ranges, which several threads write at once.
+ *
+ * If @checksum is given, @source must be a regular file. Its
+ * data is hashed while it is copied, so it can be compared with
+ * thunar_g_file_create_checksum() of @destination afterwards.
  *
  * Return value: %TRUE on success, %FALSE otherwise.
  **/
@@ -730,21 +2153,35 @@ thunar_g_file_copy (GFile                *source,
                     GFile                *destination,
                     GFileCopyFlags        flags,
                     gboolean              use_partial,
+                    gboolean              resume_partial,
+                    guint                 n_streams,
+                    GChecksum            *checksum,
                     GCancellable         *cancellable,
                     GFileProgressCallback progress_callback,
                     gpointer              progress_callback_data,
                     GError              **error)
 {
-  gboolean            success;
-  GFileQueryInfoFlags query_flags;
-  GFileInfo          *info = NULL;
-  GFile              *parent;
-  GFile              *partial;
-  gchar              *partial_name;
-  gchar              *base_name;
+  gboolean                success;
+  GFileQueryInfoFlags     query_flags;
+  GFileInfo              *info = NULL;
+  GFile                  *parent;
+  GFile                  *partial;
+  gchar                  *partial_name;
+  gchar                  *base_name;
+  gboolean                handled = FALSE;
+  gint64                  start_time;
+  ThunarGFileCopyProgress progress;
 
   _thunar_return_val_if_fail (g_file_has_parent (destination, NULL), FALSE);
 
+  /* follow the progress to know the number of bytes copied */
+  start_time = g_get_monotonic_time ();
+  progress.callback = progress_callback;
+  progress.data = progress_callback_data;
+  progress.copied = 0;
+  progress_callback = thunar_g_file_copy_progress;
+  progress_callback_data = &progress;
+
   if (use_partial)
     {
       query_flags = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS) ? G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS : G_FILE_QUERY_INFO_NONE;
@@ -768,8 +2205,8 @@ thunar_g_file_copy (GFile                *source,
 
   if (!use_partial)
     {
-      success = g_file_copy (source, destination, flags, cancellable, progress_callback, progress_callback_data, error);
-      return success;
+      success = thunar_g_file_copy_data (source, destination, flags, n_streams, checksum, cancellable, progress_callback, progress_callback_data, error);
+      return thunar_g_file_copy_record (&progress, start_time, success);
     }
 
   /* check destination */
@@ -811,12 +2248,20 @@ thunar_g_file_copy (GFile                *source,
   g_clear_object (&parent);
   g_free (partial_name);
 
-  /* check if partial file exists */
-  if (g_file_query_exists (partial, NULL))
-    g_file_delete (partial, NULL, error);
+  /* continue an interrupted copy, or start over */
+  if (resume_partial)
+    success = thunar_g_file_copy_resumable (source, partial, flags, checksum, cancellable,
+                                            progress_callback, progress_callback_data, &handled, error);
 
-  /* copy file to .partial */
-  success = g_file_copy (source, partial, flags, cancellable, progress_callback, progress_callback_data, error);
+  if (!handled)
+    {
+      /* check if partial file exists */
+      if (g_file_query_exists (partial, NULL))
+        g_file_delete (partial, NULL, error);
+
+      /* copy file to .partial */
+      success = thunar_g_file_copy_data (source, partial, flags, n_streams, checksum, cancellable, progress_callback, progress_callback_data, error);
+    }
 
   if (success)
     {
@@ -824,7 +2269,7 @@ thunar_g_file_copy (GFile                *source,
       success = (g_file_set_display_name (partial, base_name, NULL, error) != NULL);
     }
 
-  if (!success)
+  if (!success && !handled)
     {
       /* try to remove incomplete file. */
       /* failure is expected so error is ignored */
@@ -835,7 +2280,7 @@ thunar_g_file_copy (GFile                *source,
 
   g_clear_object (&partial);
   g_free (base_name);
-  return success;
+  return thunar_g_file_copy_record (&progress, start_time, success);
 }
 
 
@@ -860,6 +2305,7 @@ thunar_g_file_compare_checksum (GFile        *file_a,
   gchar   *str_a;
   gchar   *str_b;
   gboolean is_equal;
+  gint64   start_time = g_get_monotonic_time ();
 
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
@@ -871,11 +2317,100 @@ thunar_g_file_compare_checksum (GFile        *file_a,
   g_free (str_a);
   g_free (str_b);
 
+  thunar_stats_record_since (THUNAR_STATS_CHECKSUM_COMPARE, start_time);
+
   return is_equal;
 }
 
 
 
+/**
+ * thunar_g_file_create_checksum:
+ * @file          : a #GFile
+ * @checksum_type : the #GChecksumType to use
+ * @uncached      : whether to read the data from the disk
+ * @cancellable   : (nullable): optional #GCancellable object
+ * @error         : (nullable): optional #GError
+ *
+ * Computes the checksum of the contents of @file. If @uncached
+ * is %TRUE and @file is local, its pages are flushed and dropped
+ * from the page cache first, so a freshly written copy is really
+ * read back from the disk instead of from memory.
+ *
+ * The caller is responsible to free the returned string using g_free().
+ *
+ * Return value: the checksum as hexadecimal string, or %NULL on error.
+ **/
+gchar *
+thunar_g_file_create_checksum (GFile        *file,
+                               GChecksumType checksum_type,
+                               gboolean      uncached,
+                               GCancellable *cancellable,
+                               GError      **error)
+{
+  GFileInputStream *input;
+  GChecksum        *checksum;
+  guchar           *buffer;
+  gchar            *result = NULL;
+  gssize            n;
+  goffset           length = 0;
+  gint64            start_time = g_get_monotonic_time ();
+  GError           *err = NULL;
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+  const gchar      *path;
+  gint              fd;
+#endif
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+  /* only clean pages can be dropped, so write the data out first */
+  path = g_file_peek_path (file);
+  if (uncached && path != NULL && g_file_is_native (file))
+    {
+      fd = g_open (path, O_RDONLY | O_CLOEXEC, 0);
+      if (fd >= 0)
+        {
+          if (fdatasync (fd) == 0)
+            posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+          close (fd);
+        }
+    }
+#endif
+
+  input = g_file_read (file, cancellable, error);
+  if (input == NULL)
+    return NULL;
+
+  checksum = g_checksum_new (checksum_type);
+  buffer = g_malloc (THUNAR_G_FILE_COPY_BUFFER_SIZE);
+
+  while ((n = g_input_stream_read (G_INPUT_STREAM (input), buffer, THUNAR_G_FILE_COPY_BUFFER_SIZE, cancellable, &err)) > 0)
+    {
+      g_checksum_update (checksum, buffer, n);
+      length += n;
+    }
+
+  if (err == NULL)
+    {
+      result = g_strdup (g_checksum_get_string (checksum));
+      thunar_stats_record_since (THUNAR_STATS_CHECKSUM, start_time);
+      thunar_stats_record (THUNAR_STATS_CHECKSUM_BYTES, length);
+    }
+  else
+    g_propagate_error (error, err);
+
+  g_free (buffer);
+  g_checksum_free (checksum);
+  g_input_stream_close (G_INPUT_STREAM (input), NULL, NULL);
+  g_object_unref (input);
+
+  return result;
+}
+
+
+
 /**
  * thunar_g_file_list_new_from_string:
  * @string : a string representation of an URI list.
@@ -1028,6 +2563,147 @@ thunar_g_file_is_descendant (GFile *descendant,
 
 
 
+/* files of a launch which wait for their process, see thunar_g_app_info_launch() */
+typedef struct
+{
+  GAppInfo          *info;
+  GAppLaunchContext *context;
+  gchar             *working_directory;
+  GList             *path_list;
+  gint64             start_time;
+  gulong             launched_id;
+} ThunarGAppInfoLaunch;
+
+
+
+static gboolean
+thunar_g_app_info_takes_single_file (GAppInfo *info)
+{
+#ifdef HAVE_GIO_UNIX
+  const gchar *commandline;
+
+  if (!G_IS_DESKTOP_APP_INFO (info))
+    return FALSE;
+
+  /* GIO passes all files in one D-Bus call to activatable applications */
+  if (g_desktop_app_info_get_boolean (G_DESKTOP_APP_INFO (info), "DBusActivatable"))
+    return FALSE;
+
+  /* without %F or %U GIO starts one process per file, one after the other */
+  commandline = g_app_info_get_commandline (info);
+  return commandline != NULL && strstr (commandline, "%F") == NULL && strstr (commandline, "%U") == NULL;
+#else
+  return FALSE;
+#endif
+}
+
+
+
+static void
+thunar_g_app_info_launched (GAppLaunchContext    *context,
+                            GAppInfo             *info,
+                            GVariant             *platform_data,
+                            ThunarGAppInfoLaunch *launch)
+{
+  /* the time from the request until the process was spawned */
+  thunar_stats_record_since (THUNAR_STATS_LAUNCH_LATENCY, launch->start_time);
+}
+
+
+
+static void
+thunar_g_app_info_launch_free (gpointer data)
+{
+  ThunarGAppInfoLaunch *launch = data;
+
+  g_signal_handler_disconnect (launch->context, launch->launched_id);
+  g_object_unref (launch->context);
+  g_object_unref (launch->info);
+  thunar_g_list_free_full (launch->path_list);
+  g_free (launch->working_directory);
+  g_slice_free (ThunarGAppInfoLaunch, launch);
+}
+
+
+
+static gboolean
+thunar_g_app_info_launch_paths (ThunarGAppInfoLaunch *launch,
+                                GList                *path_list,
+                                GError              **error)
+{
+  gboolean  result;
+  gchar    *new_path;
+  gchar    *old_path = NULL;
+
+  /* switch to the desired working directory, remember that of Thunar itself */
+  if (launch->working_directory != NULL)
+    old_path = thunar_util_change_working_directory (launch->working_directory);
+
+  /* launch the paths with the specified app info */
+  result = g_app_info_launch (launch->info, path_list, launch->context, error);
+
+  /* check if we need to reset the working directory to the one Thunar was
+   * opened from */
+  if (old_path != NULL)
+    {
+      /* switch to Thunar's original working directory */
+      new_path = thunar_util_change_working_directory (old_path);
+
+      /* clean up */
+      g_free (new_path);
+      g_free (old_path);
+    }
+
+  return result;
+}
+
+
+
+static gboolean
+thunar_g_app_info_launch_idle (gpointer user_data)
+{
+  ThunarGAppInfoLaunch *launch = user_data;
+  GError               *error = NULL;
+  GList                *lp;
+  guint                 n;
+
+  /* start a few processes in each iteration, so the main loop keeps running */
+  for (n = 0; n < THUNAR_G_APP_INFO_LAUNCH_BATCH && launch->path_list != NULL; n++)
+    {
+      lp = launch->path_list;
+      launch->path_list = g_list_remove_link (launch->path_list, lp);
+
+      if (!thunar_g_app_info_launch_paths (launch, lp, &error))
+        {
+          g_warning ("Failed to launch \"%s\": %s", g_app_info_get_name (launch->info), error->message);
+          g_clear_error (&error);
+        }
+
+      thunar_g_list_free_full (lp);
+    }
+
+  return launch->path_list != NULL;
+}
+
+
+
+/**
+ * thunar_g_app_info_launch:
+ * @info              : a #GAppInfo.
+ * @working_directory : the working directory for the application, or %NULL.
+ * @path_list         : the #GFile<!---->s to open.
+ * @context           : a #GAppLaunchContext.
+ * @error             : return location for errors or %NULL.
+ *
+ * Opens the files in @path_list with @info and remembers @info as
+ * the last used application for their content types.
+ *
+ * Applications which only take a single file per process get the
+ * first file right away, and the others from the main loop a few
+ * at a time.
+ *
+ * Return value: %TRUE if @info was launched for the (first) file.
+ **/
 gboolean
 thunar_g_app_info_launch (GAppInfo          *info,
                           GFile             *working_directory,
@@ -1035,15 +2711,16 @@ thunar_g_app_info_launch (GAppInfo          *info,
                           GAppLaunchContext *context,
                           GError           **error)
 {
-  ThunarFile   *file;
-  GAppInfo     *default_app_info;
-  GList        *recommended_app_infos;
-  GList        *lp;
-  const gchar  *content_type;
-  gboolean      result = FALSE;
-  gchar        *new_path = NULL;
-  gchar        *old_path = NULL;
-  gboolean      skip_app_info_update;
+  ThunarGAppInfoLaunch *launch;
+  ThunarFile           *file;
+  GAppInfo             *default_app_info;
+  GHashTable           *content_types;
+  GList                *recommended_app_infos;
+  GList                *lp;
+  GList                 first;
+  const gchar          *content_type;
+  gboolean              result = FALSE;
+  gboolean              skip_app_info_update;
 
   _thunar_return_val_if_fail (G_IS_APP_INFO (info), FALSE);
   _thunar_return_val_if_fail (working_directory == NULL || G_IS_FILE (working_directory), FALSE);
@@ -1053,27 +2730,42 @@ thunar_g_app_info_launch (GAppInfo          *info,
 
   skip_app_info_update = (g_object_get_data (G_OBJECT (info), "skip-app-info-update") != NULL);
 
+  launch = g_slice_new0 (ThunarGAppInfoLaunch);
+  launch->info = g_object_ref (info);
+  launch->context = g_object_ref (context);
+  launch->start_time = g_get_monotonic_time ();
+  launch->launched_id = g_signal_connect (G_OBJECT (context), "launched", G_CALLBACK (thunar_g_app_info_launched), launch);
+
   /* check if we want to set the working directory of the spawned app */
   if (working_directory != NULL)
-    {
-      /* determine the working directory path */
-      new_path = g_file_get_path (working_directory);
-      if (new_path != NULL)
-        {
-          /* switch to the desired working directory, remember that of Thunar itself */
-          old_path = thunar_util_change_working_directory (new_path);
+    launch->working_directory = g_file_get_path (working_directory);
 
-          /* forget about the new working directory path */
-          g_free (new_path);
-        }
+  if (path_list->next != NULL && thunar_g_app_info_takes_single_file (info))
+    {
+      /* launch the first file now, to report errors, and queue the others */
+      first.data = path_list->data;
+      first.prev = first.next = NULL;
+      result = thunar_g_app_info_launch_paths (launch, &first, error);
+      if (result)
+        launch->path_list = thunar_g_list_copy_deep (path_list->next);
+    }
+  else
+    {
+      /* launch the paths with the specified app info */
+      result = thunar_g_app_info_launch_paths (launch, path_list, error);
     }
 
-  /* launch the paths with the specified app info */
-  result = g_app_info_launch (info, path_list, context, error);
+  if (launch->path_list != NULL)
+    g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, thunar_g_app_info_launch_idle, launch, thunar_g_app_info_launch_free);
+  else
+    thunar_g_app_info_launch_free (launch);
 
   /* if successful, remember the application as last used for the file types */
   if (result == TRUE)
     {
+      /* every content type only needs to be looked at once */
+      content_types = g_hash_table_new (g_str_hash, g_str_equal);
+
       for (lp = path_list; lp != NULL; lp = lp->next)
         {
           gboolean update_app_info = !skip_app_info_update;
@@ -1083,6 +2775,11 @@ thunar_g_app_info_launch (GAppInfo          *info,
             continue;
 
           content_type = thunar_file_get_content_type (file);
+          if (!g_hash_table_add (content_types, (gpointer) g_intern_string (content_type)))
+            {
+              g_object_unref (file);
+              continue;
+            }
 
           /* determine default application */
           default_app_info = thunar_file_get_default_handler (file);
@@ -1115,18 +2812,8 @@ thunar_g_app_info_launch (GAppInfo          *info,
 
           g_object_unref (file);
         }
-    }
-
-  /* check if we need to reset the working directory to the one Thunar was
-   * opened from */
-  if (old_path != NULL)
-    {
-      /* switch to Thunar's original working directory */
-      new_path = thunar_util_change_working_directory (old_path);
 
-      /* clean up */
-      g_free (new_path);
-      g_free (old_path);
+      g_hash_table_destroy (content_types);
     }
 
   return result;
@@ -1463,4 +3150,186 @@ thunar_g_file_get_resolved_path (GFile *file)
 
   g_free (path);
   return real_path;
-}
\ No newline at end of file
+}
+
+
+#if defined (__linux__) && defined (HAVE_SYS_VFS_H)
+static gboolean
+thunar_g_file_lookup_mount (const gchar *path,
+                            dev_t        device,
+                            gboolean    *is_root_return,
+                            gchar      **source_return)
+{
+  gchar    *contents;
+  gchar   **lines;
+  gchar   **fields;
+  gchar    *mount_point;
+  guint     major_number, minor_number;
+  guint     n, separator;
+  gboolean  found = FALSE;
+
+  *is_root_return = FALSE;
+  *source_return = NULL;
+
+  if (!g_file_get_contents ("/proc/self/mountinfo", &contents, NULL, NULL))
+    return FALSE;
+
+  /* "id parent major:minor root mount-point options [optional...] - type source super-options" */
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+  for (n = 0; lines[n] != NULL; ++n)
+    {
+      fields = g_strsplit (lines[n], " ", -1);
+      if (g_strv_length (fields) < 7
+          || sscanf (fields[2], "%u:%u", &major_number, &minor_number) != 2
+          || makedev (major_number, minor_number) != device)
+        {
+          g_strfreev (fields);
+          continue;
+        }
+
+      for (separator = 6; fields[separator] != NULL && strcmp (fields[separator], "-") != 0; ++separator)
+        ;
+
+      if (fields[separator] != NULL && fields[separator + 1] != NULL && fields[separator + 2] != NULL)
+        {
+          found = TRUE;
+          if (*source_return == NULL)
+            *source_return = g_strcompress (fields[separator + 2]);
+
+          /* only the whole filesystem mounted at the path is accounted for the path, not a bind mounted folder */
+          mount_point = g_strcompress (fields[4]);
+          if (strcmp (mount_point, path) == 0 && strcmp (fields[3], "/") == 0)
+            *is_root_return = TRUE;
+          g_free (mount_point);
+        }
+
+      g_strfreev (fields);
+    }
+  g_strfreev (lines);
+
+  return found;
+}
+
+
+
+#if defined (HAVE_SYS_QUOTA_H) && defined (HAVE_LINUX_FS_H) && defined (PRJQUOTA) && defined (FS_IOC_FSGETXATTR)
+static gboolean
+thunar_g_file_get_project_usage (gint         fd,
+                                 const gchar *path,
+                                 const gchar *source,
+                                 guint64     *size_return,
+                                 guint64     *n_inodes_return)
+{
+  struct fsxattr fsx;
+  struct fsxattr parent_fsx;
+  struct dqblk   dq;
+  gchar         *parent_path;
+  gint           parent_fd;
+
+  /* the folder must start a project, which its parent isn't part of */
+  if (ioctl (fd, FS_IOC_FSGETXATTR, &fsx) != 0
+      || fsx.fsx_projid == 0
+      || (fsx.fsx_xflags & FS_XFLAG_PROJINHERIT) == 0)
+    return FALSE;
+
+  parent_path = g_build_filename (path, "..", NULL);
+  parent_fd = g_open (parent_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+  g_free (parent_path);
+  if (parent_fd < 0)
+    return FALSE;
+  if (ioctl (parent_fd, FS_IOC_FSGETXATTR, &parent_fsx) != 0 || parent_fsx.fsx_projid == fsx.fsx_projid)
+    {
+      close (parent_fd);
+      return FALSE;
+    }
+  close (parent_fd);
+
+  /* reading the usage of a project may need privileges */
+  if (quotactl (QCMD (Q_GETQUOTA, PRJQUOTA), source, fsx.fsx_projid, (caddr_t) &dq) != 0
+      || (dq.dqb_valid & (QIF_SPACE | QIF_INODES)) != (QIF_SPACE | QIF_INODES))
+    return FALSE;
+
+  *size_return = dq.dqb_curspace;
+  *n_inodes_return = dq.dqb_curinodes;
+
+  return TRUE;
+}
+#endif
+#endif
+
+
+
+/**
+ * thunar_g_file_get_reported_usage:
+ * @file            : a #GFile for a local folder.
+ * @size_return     : return location for the bytes used below @file.
+ * @n_inodes_return : return location for the number of files and
+ *                    folders below @file, including @file.
+ *
+ * Looks up the disk usage of the tree below @file in the accounting
+ * of its filesystem, which is known right away if @file is the root
+ * of a mounted filesystem or of a project quota. Folders elsewhere
+ * and folders on file servers have to be counted instead.
+ *
+ * The size is the space allocated on the disk, which may differ from
+ * the sum of the file sizes.
+ *
+ * Return value: %TRUE if the filesystem reported the usage of @file.
+ **/
+gboolean
+thunar_g_file_get_reported_usage (GFile   *file,
+                                  guint64 *size_return,
+                                  guint64 *n_inodes_return)
+{
+#if defined (__linux__) && defined (HAVE_SYS_VFS_H)
+  struct statfs statfsb;
+  GStatBuf      statb;
+  const gchar  *path;
+  gboolean      is_root;
+  gboolean      reported = FALSE;
+  gchar        *source;
+  gint          fd;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  path = g_file_peek_path (file);
+  if (path == NULL || !g_path_is_absolute (path))
+    return FALSE;
+
+  fd = g_open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+  if (fd < 0)
+    return FALSE;
+
+  /* the usage reported by file servers covers their whole export */
+  if (fstat (fd, &statb) != 0
+      || fstatfs (fd, &statfsb) != 0
+      || thunar_g_file_copy_native_is_remote (fd)
+      || !thunar_g_file_lookup_mount (path, statb.st_dev, &is_root, &source))
+    {
+      close (fd);
+      return FALSE;
+    }
+
+  /* filesystems without a fixed number of inodes report none */
+  if (is_root && statfsb.f_files > statfsb.f_ffree)
+    {
+      *size_return = (guint64) (statfsb.f_blocks - statfsb.f_bfree) * statfsb.f_bsize;
+      *n_inodes_return = statfsb.f_files - statfsb.f_ffree;
+      reported = TRUE;
+    }
+#if defined (HAVE_SYS_QUOTA_H) && defined (HAVE_LINUX_FS_H) && defined (PRJQUOTA) && defined (FS_IOC_FSGETXATTR)
+  else if (source != NULL && g_path_is_absolute (source))
+    {
+      reported = thunar_g_file_get_project_usage (fd, path, source, size_return, n_inodes_return);
+    }
+#endif
+
+  g_free (source);
+  close (fd);
+
+  return reported;
+#else
+  return FALSE;
+#endif
+}
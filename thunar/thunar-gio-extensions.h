@@ -69,10 +69,21 @@ gboolean     thunar_g_file_get_free_space           (GFile                *file,
 gchar       *thunar_g_file_get_free_space_string    (GFile                *file,
                                                      gboolean              file_size_binary);
 
+gboolean     thunar_g_file_get_reported_usage       (GFile                *file,
+                                                     guint64              *size_return,
+                                                     guint64              *n_inodes_return);
+
+gchar       *thunar_g_format_free_space             (guint64               fs_free,
+                                                     guint64               fs_size,
+                                                     gboolean              file_size_binary);
+
 gboolean     thunar_g_file_copy                     (GFile                *source,
                                                      GFile                *destination,
                                                      GFileCopyFlags        flags,
                                                      gboolean              use_partial,
+                                                     gboolean              resume_partial,
+                                                     guint                 n_streams,
+                                                     GChecksum            *checksum,
                                                      GCancellable         *cancellable,
                                                      GFileProgressCallback progress_callback,
                                                      gpointer              progress_callback_data,
@@ -83,6 +94,12 @@ gboolean     thunar_g_file_compare_checksum         (GFile                *file_
                                                      GCancellable         *cancellable,
                                                      GError              **error);
 
+gchar       *thunar_g_file_create_checksum          (GFile                *file,
+                                                     GChecksumType         checksum_type,
+                                                     gboolean              uncached,
+                                                     GCancellable         *cancellable,
+                                                     GError              **error);
+
 /**
  * THUNAR_TYPE_G_FILE_LIST:
  *
@@ -203,8 +203,17 @@ thunar_g_utf8_normalize_for_search (const gchar *str,
                                     gboolean     strip_diacritics,
                                     gboolean     casefold)
 {
-  gchar *normalized;
-  gchar *folded;
+  gchar       *normalized;
+  gchar       *folded;
+  const gchar *p;
+
+  /* plain ASCII is left untouched by the normalization below and only
+   * needs its letters lowered for folding, which is by far the most
+   * common case for file names */
+  for (p = str; *p != '\0' && ((guchar) *p) < 0x80; p++)
+    ;
+  if (*p == '\0')
+    return casefold ? g_ascii_strdown (str, p - str) : g_strndup (str, p - str);
 
   /* g_utf8_normalize() and g_utf8_next_char() both require valid UTF-8 */
   if (g_utf8_validate (str, -1, NULL) == FALSE)
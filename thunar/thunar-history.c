@@ -727,6 +727,46 @@ thunar_history_peek_forward (ThunarHistory *history)
 
 
 
+/**
+ * thunar_history_peek_back_location:
+ * @history : a #ThunarHistory.
+ *
+ * Like thunar_history_peek_back(), but returns the location of the
+ * previous directory, without looking up its #ThunarFile.
+ *
+ * The returned #GFile is owned by @history.
+ *
+ * Return value: the previous location in the history or %NULL.
+ **/
+GFile *
+thunar_history_peek_back_location (ThunarHistory *history)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_HISTORY (history), NULL);
+  return (history->back_list != NULL) ? history->back_list->data : NULL;
+}
+
+
+
+/**
+ * thunar_history_peek_forward_location:
+ * @history : a #ThunarHistory.
+ *
+ * Like thunar_history_peek_forward(), but returns the location of the
+ * next directory, without looking up its #ThunarFile.
+ *
+ * The returned #GFile is owned by @history.
+ *
+ * Return value: the next location in the history or %NULL.
+ **/
+GFile *
+thunar_history_peek_forward_location (ThunarHistory *history)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_HISTORY (history), NULL);
+  return (history->forward_list != NULL) ? history->forward_list->data : NULL;
+}
+
+
+
 /**
  * thunar_history_add:
  * @history : a #ThunarHistory
@@ -58,6 +58,8 @@ gboolean        thunar_history_has_back         (ThunarHistory         *history)
 gboolean        thunar_history_has_forward      (ThunarHistory         *history);
 ThunarFile     *thunar_history_peek_back        (ThunarHistory         *history);
 ThunarFile     *thunar_history_peek_forward     (ThunarHistory         *history);
+GFile          *thunar_history_peek_back_location    (ThunarHistory    *history);
+GFile          *thunar_history_peek_forward_location (ThunarHistory    *history);
 void            thunar_history_action_back      (ThunarHistory         *history);
 void            thunar_history_action_forward   (ThunarHistory         *history);
 void            thunar_history_show_menu        (ThunarHistory         *history,
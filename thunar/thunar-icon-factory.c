@@ -30,10 +30,12 @@
 #include <string.h>
 #endif
 
+#include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
@@ -41,6 +43,11 @@
 /* the timeout until the sweeper is run (in seconds) */
 #define THUNAR_ICON_FACTORY_SWEEP_TIMEOUT (30)
 
+/* bytes of decoded thumbnails kept for rows that are scrolled back into
+ * view, and the number of threads decoding the thumbnails */
+#define THUNAR_ICON_FACTORY_THUMBNAIL_CACHE_SIZE (48 * 1024 * 1024)
+#define THUNAR_ICON_FACTORY_THUMBNAIL_THREADS    (2)
+
 
 
 /* Property identifiers */
@@ -56,7 +63,10 @@ enum
 
 
 
-typedef struct _ThunarIconKey ThunarIconKey;
+typedef struct _ThunarIconKey          ThunarIconKey;
+typedef struct _ThunarIconTypeKey      ThunarIconTypeKey;
+typedef struct _ThunarThumbnailEntry   ThunarThumbnailEntry;
+typedef struct _ThunarThumbnailRequest ThunarThumbnailRequest;
 
 
 
@@ -87,8 +97,17 @@ static guint      thunar_icon_key_hash                      (gconstpointer
 static gboolean   thunar_icon_key_equal                     (gconstpointer             a,
                                                              gconstpointer             b);
 static void       thunar_icon_key_free                      (gpointer                  data);
+static guint      thunar_icon_type_key_hash                 (gconstpointer             data);
+static gboolean   thunar_icon_type_key_equal                (gconstpointer             a,
+                                                             gconstpointer             b);
+static void       thunar_icon_type_key_free                 (gpointer                  data);
+static void       thunar_thumbnail_entry_free               (gpointer                  data);
 static GdkPixbuf *thunar_icon_factory_load_fallback         (ThunarIconFactory        *factory,
                                                              gint                      size);
+static GdkPixbuf *thunar_icon_factory_load_type_icon        (ThunarIconFactory        *factory,
+                                                             ThunarFile               *file,
+                                                             ThunarFileIconState       icon_state,
+                                                             gint                      icon_size);
 
 
 
@@ -105,6 +124,9 @@ struct _ThunarIconFactory
 
   GHashTable          *icon_cache;
 
+  /* icon names of files that get their icon from the content type */
+  GHashTable          *type_icon_names;
+
   GtkIconTheme        *icon_theme;
 
   ThunarThumbnailMode  thumbnail_mode;
@@ -118,6 +140,19 @@ struct _ThunarIconFactory
 
   guint                sweep_timer_id;
 
+  /* decoded thumbnails, the most recently used first in the queue */
+  GHashTable          *thumbnail_cache;
+  GQueue               thumbnail_lru;
+  gsize                thumbnail_cache_size;
+
+  /* the largest decoded thumbnail of each file version, scaled down
+   * while the thumbnail of another size is loaded, e.g. after zooming */
+  GHashTable          *thumbnail_largest;
+
+  /* thumbnails being decoded by the pool */
+  GHashTable          *thumbnail_pending;
+  GThreadPool         *thumbnail_pool;
+
   gulong               changed_hook_id;
 
   /* stamp that gets bumped when the theme changes */
@@ -130,6 +165,35 @@ struct _ThunarIconKey
   gint   size;
 };
 
+struct _ThunarIconTypeKey
+{
+  const gchar         *content_type; /* interned */
+  ThunarFileIconState  icon_state;
+};
+
+struct _ThunarThumbnailEntry
+{
+  gchar     *key;
+  gchar     *file_key; /* same for all sizes of a file version */
+  GList      link;
+
+  /* NULL if the thumbnail could not be loaded */
+  GdkPixbuf *pixbuf;
+  gsize      size;
+};
+
+struct _ThunarThumbnailRequest
+{
+  ThunarIconFactory *factory;
+  ThunarFile        *file;
+  gchar             *key;
+  gchar             *file_key;
+  gchar             *path;
+  gint               size;
+  gboolean           draw_frames;
+  GdkPixbuf         *pixbuf;
+};
+
 typedef struct
 {
   ThunarFileIconState   icon_state;
@@ -254,6 +318,16 @@ thunar_icon_factory_init (ThunarIconFactory *factory)
   /* allocate the hash table for the icon cache */
   factory->icon_cache = g_hash_table_new_full (thunar_icon_key_hash, thunar_icon_key_equal,
                                                thunar_icon_key_free, g_object_unref);
+
+  /* the icon names are interned strings */
+  factory->type_icon_names = g_hash_table_new_full (thunar_icon_type_key_hash, thunar_icon_type_key_equal,
+                                                    thunar_icon_type_key_free, NULL);
+
+  /* the entries own their keys */
+  factory->thumbnail_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, thunar_thumbnail_entry_free);
+  factory->thumbnail_pending = g_hash_table_new (g_str_hash, g_str_equal);
+  factory->thumbnail_largest = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&factory->thumbnail_lru);
 }
 
 
@@ -282,6 +356,14 @@ thunar_icon_factory_finalize (GObject *object)
 
   /* clear the icon cache hash table */
   g_hash_table_destroy (factory->icon_cache);
+  g_hash_table_destroy (factory->type_icon_names);
+
+  /* requests hold a reference on the factory, so none is pending now */
+  if (factory->thumbnail_pool != NULL)
+    g_thread_pool_free (factory->thumbnail_pool, FALSE, TRUE);
+  g_hash_table_destroy (factory->thumbnail_pending);
+  g_hash_table_destroy (factory->thumbnail_largest);
+  g_hash_table_destroy (factory->thumbnail_cache);
 
   /* remove the "changed" emission hook from the GtkIconTheme class */
   g_signal_remove_emission_hook (g_signal_lookup ("changed", GTK_TYPE_ICON_THEME), factory->changed_hook_id);
@@ -383,6 +465,7 @@ thunar_icon_factory_changed (GSignalInvocationHint *ihint,
 
   /* drop all items from the icon cache */
   g_hash_table_remove_all (factory->icon_cache);
+  g_hash_table_remove_all (factory->type_icon_names);
 
   /* bump the stamp so all file icons are reloaded */
   factory->theme_stamp++;
@@ -431,6 +514,23 @@ thunar_icon_factory_sweep_timer_destroy (gpointer user_data)
 
 
 
+/* whether the RGBA row of width pixels is fully opaque. The alpha values
+ * are and-ed without branching so the compiler can vectorize the loop */
+static inline gboolean
+thumbnail_row_is_opaque (const guchar *pixels,
+                         gint          width)
+{
+  guchar alpha = 255u;
+  gint   n;
+
+  for (n = 0; n < width; ++n)
+    alpha &= pixels[n * 4 + 3];
+
+  return alpha == 255u;
+}
+
+
+
 static inline gboolean
 thumbnail_needs_frame (const GdkPixbuf *thumbnail,
                        gint             width,
@@ -440,7 +540,7 @@ thumbnail_needs_frame (const GdkPixbuf *thumbnail,
   const guchar *pixels;
   gint          rowstride;
   gint          n;
-  guchar        alpha_threshold = 255u;   /* An alpha value of 255 means full opacity, 0 is fully transparent. */
+  guchar        alpha = 255u;   /* An alpha value of 255 means full opacity, 0 is fully transparent. */
 
   /* don't add frames to small thumbnails */
   if (size < THUNAR_ICON_SIZE_64 )
@@ -456,9 +556,8 @@ thumbnail_needs_frame (const GdkPixbuf *thumbnail,
   /* Data is stored in 4 channels (red, green, blue, alpha). We are only interested in channel 4 (alpha) */
 
   /* check if we have a transparent pixel on the first row */
-  for (n = width * 4; n > 0; n -= 4)
-    if (pixels[n - 1] < alpha_threshold)
-      return FALSE;
+  if (!thumbnail_row_is_opaque (pixels, width))
+    return FALSE;
 
   /* determine the rowstride */
   rowstride = gdk_pixbuf_get_rowstride (thumbnail);
@@ -468,15 +567,12 @@ thumbnail_needs_frame (const GdkPixbuf *thumbnail,
 
   /* check if we have a transparent pixel in the first or last column */
   for (n = height - 2; n > 0; --n, pixels += rowstride)
-    if (pixels[3] < alpha_threshold || pixels[width * 4 - 1] < alpha_threshold)
-      return FALSE;
+    alpha &= pixels[3] & pixels[width * 4 - 1];
+  if (alpha != 255u)
+    return FALSE;
 
   /* check if we have a transparent pixel on the last row */
-  for (n = width * 4; n > 0; n -= 4)
-    if (pixels[n - 1] < alpha_threshold)
-      return FALSE;
-
-  return TRUE;
+  return thumbnail_row_is_opaque (pixels, width);
 }
 
 
@@ -485,26 +581,31 @@ static GdkPixbuf*
 thunar_icon_factory_get_thumbnail_frame (void)
 {
   GInputStream *stream;
-  static GdkPixbuf *frame = NULL;
+  GdkPixbuf    *pixbuf = NULL;
+  static gsize  frame = 0;
 
-  if (G_LIKELY (frame != NULL))
-     return frame;
+  /* thumbnails are also framed by the decoding threads */
+  if (g_once_init_enter (&frame))
+    {
+      stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
+      if (G_UNLIKELY (stream != NULL)) {
+        pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
+        g_object_unref (stream);
+      }
 
-  stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
-  if (G_UNLIKELY (stream != NULL)) {
-    frame = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
-    g_object_unref (stream);
-  }
+      g_once_init_leave (&frame, (gsize) pixbuf + 1);
+    }
 
-  return frame;
+  return (GdkPixbuf *) (frame - 1);
 }
 
 
 
+/* loads and scales an image file, this is also done by the decoding threads */
 static GdkPixbuf*
-thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
-                                    const gchar       *path,
-                                    gint               size)
+thunar_icon_factory_load_image (const gchar *path,
+                                gint         size,
+                                gboolean     draw_frames)
 {
   GdkPixbuf *pixbuf;
   GdkPixbuf *frame;
@@ -515,8 +616,6 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
   gint       width;
   gint       height;
 
-  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
-
   /* try to load the image from the file */
   pixbuf = gdk_pixbuf_new_from_file (path, NULL);
   if (G_LIKELY (pixbuf != NULL))
@@ -526,7 +625,7 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
       height = gdk_pixbuf_get_height (pixbuf);
 
       needs_frame = FALSE;
-      if (factory->thumbnail_draw_frames)
+      if (draw_frames)
         {
           /* check if we want to add a frame to the image (we really don't
            * want to do this for icons displayed in the details view).
@@ -572,6 +671,237 @@ thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
 
 
 
+static GdkPixbuf*
+thunar_icon_factory_load_from_file (ThunarIconFactory *factory,
+                                    const gchar       *path,
+                                    gint               size)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
+
+  return thunar_icon_factory_load_image (path, size, factory->thumbnail_draw_frames);
+}
+
+
+
+static void
+thunar_thumbnail_entry_free (gpointer data)
+{
+  ThunarThumbnailEntry *entry = data;
+
+  if (entry->pixbuf != NULL)
+    g_object_unref (entry->pixbuf);
+  g_free (entry->key);
+  g_free (entry->file_key);
+  g_slice_free (ThunarThumbnailEntry, entry);
+}
+
+
+
+/* takes key, file_key and pixbuf, and drops the least recently used
+ * thumbnails until the cache fits into its size again */
+static void
+thunar_icon_factory_thumbnail_cache_insert (ThunarIconFactory *factory,
+                                            gchar             *key,
+                                            gchar             *file_key,
+                                            GdkPixbuf         *pixbuf)
+{
+  ThunarThumbnailEntry *entry;
+  ThunarThumbnailEntry *largest;
+
+  entry = g_slice_new0 (ThunarThumbnailEntry);
+  entry->key = key;
+  entry->file_key = file_key;
+  entry->link.data = entry;
+  entry->pixbuf = pixbuf;
+  entry->size = sizeof (ThunarThumbnailEntry);
+  if (pixbuf != NULL)
+    entry->size += gdk_pixbuf_get_byte_length (pixbuf);
+
+  g_hash_table_replace (factory->thumbnail_cache, key, entry);
+  g_queue_push_head_link (&factory->thumbnail_lru, &entry->link);
+  factory->thumbnail_cache_size += entry->size;
+
+  if (pixbuf != NULL)
+    {
+      largest = g_hash_table_lookup (factory->thumbnail_largest, file_key);
+      if (largest == NULL || gdk_pixbuf_get_width (largest->pixbuf) * gdk_pixbuf_get_height (largest->pixbuf)
+                             < gdk_pixbuf_get_width (pixbuf) * gdk_pixbuf_get_height (pixbuf))
+        g_hash_table_replace (factory->thumbnail_largest, file_key, entry);
+    }
+
+  while (factory->thumbnail_cache_size > THUNAR_ICON_FACTORY_THUMBNAIL_CACHE_SIZE
+         && factory->thumbnail_lru.length > 1)
+    {
+      entry = g_queue_peek_tail (&factory->thumbnail_lru);
+      g_queue_unlink (&factory->thumbnail_lru, &entry->link);
+      factory->thumbnail_cache_size -= entry->size;
+      if (g_hash_table_lookup (factory->thumbnail_largest, entry->file_key) == entry)
+        g_hash_table_remove (factory->thumbnail_largest, entry->file_key);
+      g_hash_table_remove (factory->thumbnail_cache, entry->key);
+    }
+}
+
+
+
+/* scales the largest decoded thumbnail of the file version down to @size,
+ * NULL if there is none or none larger than @size */
+static GdkPixbuf*
+thunar_icon_factory_scale_thumbnail (ThunarIconFactory *factory,
+                                     const gchar       *file_key,
+                                     gint               size)
+{
+  ThunarThumbnailEntry *entry;
+  gint                  width;
+  gint                  height;
+  gdouble               scale;
+
+  entry = g_hash_table_lookup (factory->thumbnail_largest, file_key);
+  if (entry == NULL)
+    return NULL;
+
+  width = gdk_pixbuf_get_width (entry->pixbuf);
+  height = gdk_pixbuf_get_height (entry->pixbuf);
+  if (MAX (width, height) <= size)
+    return NULL;
+
+  /* fit into @size like thunar_icon_factory_load_image() does */
+  scale = (gdouble) size / MAX (width, height);
+  width = MAX (1, (gint) (width * scale + 0.5));
+  height = MAX (1, (gint) (height * scale + 0.5));
+
+  return gdk_pixbuf_scale_simple (entry->pixbuf, width, height, GDK_INTERP_BILINEAR);
+}
+
+
+
+static gchar*
+thunar_icon_factory_thumbnail_file_key (ThunarIconFactory *factory,
+                                        ThunarFile        *file)
+{
+  gchar *uri;
+  gchar *file_key;
+
+  uri = thunar_file_dup_uri (file);
+  file_key = g_strdup_printf ("%s:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ":%d", uri,
+                              thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED),
+                              thunar_file_get_size (file), factory->thumbnail_draw_frames);
+  g_free (uri);
+
+  return file_key;
+}
+
+
+
+static gboolean
+thunar_icon_factory_thumbnail_ready (gpointer user_data)
+{
+  ThunarThumbnailRequest *request = user_data;
+  ThunarIconFactory      *factory = request->factory;
+
+THUNAR_THREADS_ENTER
+
+  g_hash_table_remove (factory->thumbnail_pending, request->key);
+  thunar_icon_factory_thumbnail_cache_insert (factory, request->key, request->file_key, request->pixbuf);
+
+  /* let the views load the icon again, it is in the cache now */
+  if (request->pixbuf != NULL)
+    thunar_file_monitor_file_changed (request->file);
+
+THUNAR_THREADS_LEAVE
+
+  g_object_unref (request->file);
+  g_free (request->path);
+  g_slice_free (ThunarThumbnailRequest, request);
+  g_object_unref (factory);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_icon_factory_thumbnail_thread (gpointer data,
+                                      gpointer user_data)
+{
+  ThunarThumbnailRequest *request = data;
+
+  request->pixbuf = thunar_icon_factory_load_image (request->path, request->size, request->draw_frames);
+
+  g_idle_add (thunar_icon_factory_thumbnail_ready, request);
+}
+
+
+
+/* returns a new reference of the decoded thumbnail at path, or with
+ * pending set if it has to be decoded first. In that case file is
+ * reported as changed once the thumbnail is in the cache, and a larger
+ * thumbnail of the file scaled down to size is returned meanwhile, if
+ * there is one, or NULL */
+static GdkPixbuf*
+thunar_icon_factory_lookup_thumbnail (ThunarIconFactory *factory,
+                                      ThunarFile        *file,
+                                      const gchar       *path,
+                                      gint               size,
+                                      gboolean          *pending)
+{
+  ThunarThumbnailRequest *request;
+  ThunarThumbnailEntry   *entry;
+  GdkPixbuf              *scaled;
+  gchar                  *file_key;
+  gchar                  *key;
+
+  *pending = FALSE;
+
+  key = g_strdup_printf ("%s:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT ":%d:%d:%d", path,
+                         thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED),
+                         thunar_file_get_size (file), size,
+                         factory->thumbnail_draw_frames, thunar_file_get_thumb_state (file));
+
+  entry = g_hash_table_lookup (factory->thumbnail_cache, key);
+  if (entry != NULL)
+    {
+      /* rows scrolled back into view get their thumbnail right away */
+      g_queue_unlink (&factory->thumbnail_lru, &entry->link);
+      g_queue_push_head_link (&factory->thumbnail_lru, &entry->link);
+      g_free (key);
+
+      return entry->pixbuf != NULL ? g_object_ref (entry->pixbuf) : NULL;
+    }
+
+  *pending = TRUE;
+
+  file_key = thunar_icon_factory_thumbnail_file_key (factory, file);
+  scaled = thunar_icon_factory_scale_thumbnail (factory, file_key, size);
+
+  if (g_hash_table_contains (factory->thumbnail_pending, key))
+    {
+      g_free (file_key);
+      g_free (key);
+      return scaled;
+    }
+
+  if (factory->thumbnail_pool == NULL)
+    factory->thumbnail_pool = g_thread_pool_new (thunar_icon_factory_thumbnail_thread, NULL,
+                                                 THUNAR_ICON_FACTORY_THUMBNAIL_THREADS, FALSE, NULL);
+
+  request = g_slice_new0 (ThunarThumbnailRequest);
+  request->factory = g_object_ref (factory);
+  request->file = g_object_ref (file);
+  request->key = key;
+  request->file_key = file_key;
+  request->path = g_strdup (path);
+  request->size = size;
+  request->draw_frames = factory->thumbnail_draw_frames;
+
+  /* the request owns the key until it is moved to the cache */
+  g_hash_table_add (factory->thumbnail_pending, key);
+  g_thread_pool_push (factory->thumbnail_pool, request, NULL);
+
+  return scaled;
+}
+
+
+
 static GdkPixbuf*
 thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
                                  const gchar       *name,
@@ -594,6 +924,8 @@ thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
   /* check if we already have a cached version of the icon */
   if (!g_hash_table_lookup_extended (factory->icon_cache, &lookup_key, NULL, (gpointer) &pixbuf))
     {
+      thunar_stats_count (THUNAR_STATS_ICON_CACHE_MISS);
+
       /* check if we have to load a file instead of a themed icon */
       if (G_UNLIKELY (g_path_is_absolute (name)))
         {
@@ -636,6 +968,10 @@ thunar_icon_factory_lookup_icon (ThunarIconFactory *factory,
       /* insert the new icon into the cache */
       g_hash_table_insert (factory->icon_cache, key, pixbuf);
     }
+  else
+    {
+      thunar_stats_count (THUNAR_STATS_ICON_CACHE_HIT);
+    }
 
   /* schedule the sweeper */
   if (G_UNLIKELY (factory->sweep_timer_id == 0))
@@ -695,6 +1031,38 @@ thunar_icon_key_free (gpointer data)
 
 
 
+static guint
+thunar_icon_type_key_hash (gconstpointer data)
+{
+  const ThunarIconTypeKey *key = data;
+
+  /* content types are interned, so the pointer is enough */
+  return g_direct_hash (key->content_type) ^ key->icon_state;
+}
+
+
+
+static gboolean
+thunar_icon_type_key_equal (gconstpointer a,
+                            gconstpointer b)
+{
+  const ThunarIconTypeKey *a_key = a;
+  const ThunarIconTypeKey *b_key = b;
+
+  return a_key->content_type == b_key->content_type
+      && a_key->icon_state == b_key->icon_state;
+}
+
+
+
+static void
+thunar_icon_type_key_free (gpointer data)
+{
+  g_slice_free (ThunarIconTypeKey, data);
+}
+
+
+
 static void
 thunar_icon_store_free (gpointer data)
 {
@@ -716,6 +1084,48 @@ thunar_icon_factory_load_fallback (ThunarIconFactory *factory,
 
 
 
+static GdkPixbuf*
+thunar_icon_factory_load_type_icon (ThunarIconFactory  *factory,
+                                    ThunarFile         *file,
+                                    ThunarFileIconState icon_state,
+                                    gint                icon_size)
+{
+  ThunarIconTypeKey  lookup_key;
+  ThunarIconTypeKey *key;
+  const gchar       *icon_name;
+
+  /* directories, mountables and network items may have an icon of their
+   * own, and files without info don't know their content type yet */
+  if (thunar_file_is_directory (file)
+      || thunar_file_is_mountable (file)
+      || thunar_file_get_info (file) == NULL
+      || thunar_file_has_uri_scheme (file, "network"))
+    {
+      icon_name = thunar_file_get_icon_name (file, icon_state, factory->icon_theme);
+      return thunar_icon_factory_load_icon (factory, icon_name, icon_size, TRUE);
+    }
+
+  /* all other files get the icon of their content type, so only
+   * ask for the name once for every type in the current theme */
+  lookup_key.content_type = thunar_file_get_content_type (file);
+  lookup_key.icon_state = icon_state;
+  icon_name = g_hash_table_lookup (factory->type_icon_names, &lookup_key);
+  if (G_UNLIKELY (icon_name == NULL))
+    {
+      icon_name = thunar_file_get_icon_name (file, icon_state, factory->icon_theme);
+      if (G_LIKELY (icon_name != NULL))
+        {
+          key = g_slice_new (ThunarIconTypeKey);
+          *key = lookup_key;
+          g_hash_table_insert (factory->type_icon_names, key, (gpointer) icon_name);
+        }
+    }
+
+  return thunar_icon_factory_load_icon (factory, icon_name, icon_size, TRUE);
+}
+
+
+
 /**
  * thunar_icon_factory_get_default:
  *
@@ -905,11 +1315,12 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
   GInputStream    *stream;
   GtkIconInfo     *icon_info;
   const gchar     *thumbnail_path;
+  gchar           *file_key;
   GdkPixbuf       *icon = NULL;
   GIcon           *gicon;
-  const gchar     *icon_name;
   const gchar     *custom_icon;
   ThunarIconStore *store;
+  gboolean         pending = FALSE;
 
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
@@ -996,8 +1407,17 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
               /* check if we have a valid path */
               if (thumbnail_path != NULL)
                 {
-                  /* try to load the thumbnail */
-                  icon = thunar_icon_factory_load_from_file (factory, thumbnail_path, icon_size);
+                  /* try to load the thumbnail, the file icon is used while it is decoded */
+                  icon = thunar_icon_factory_lookup_thumbnail (factory, file, thumbnail_path, icon_size, &pending);
+                }
+              else if (thunar_file_get_thumb_state (file) != THUNAR_FILE_THUMB_STATE_NONE)
+                {
+                  /* the thumbnail of this size is not generated yet, show a larger one
+                   * of another size meanwhile. The icon is looked up again once the
+                   * thumbnail is ready, since the thumb state changes */
+                  file_key = thunar_icon_factory_thumbnail_file_key (factory, file);
+                  icon = thunar_icon_factory_scale_thumbnail (factory, file_key, icon_size);
+                  g_free (file_key);
                 }
             }
         }
@@ -1006,11 +1426,11 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
   /* lookup the icon name for the icon in the given state and load the icon */
   if (G_LIKELY (icon == NULL))
     {
-      icon_name = thunar_file_get_icon_name (file, icon_state, factory->icon_theme);
-      icon = thunar_icon_factory_load_icon (factory, icon_name, icon_size, TRUE);
+      icon = thunar_icon_factory_load_type_icon (factory, file, icon_state, icon_size);
     }
 
-  if (G_LIKELY (icon != NULL))
+  /* don't keep the file icon if the thumbnail replaces it soon */
+  if (G_LIKELY (icon != NULL && !pending))
     {
       store = g_slice_new (ThunarIconStore);
       store->icon_size = icon_size;
@@ -1043,3 +1463,38 @@ thunar_icon_factory_clear_pixmap_cache (ThunarFile *file)
   if (thunar_icon_factory_store_quark != 0)
     g_object_set_qdata (G_OBJECT (file), thunar_icon_factory_store_quark, NULL);
 }
+
+
+
+/**
+ * thunar_icon_factory_get_census:
+ * @factory         : a #ThunarIconFactory.
+ * @n_icons         : return location for the number of cached icons.
+ * @icon_bytes      : return location for the memory of their pixels.
+ * @n_thumbnails    : return location for the number of decoded thumbnails.
+ * @thumbnail_bytes : return location for the memory of their pixels.
+ *
+ * Determines how much the caches of @factory hold.
+ **/
+void
+thunar_icon_factory_get_census (ThunarIconFactory *factory,
+                                guint             *n_icons,
+                                guint64           *icon_bytes,
+                                guint             *n_thumbnails,
+                                guint64           *thumbnail_bytes)
+{
+  GHashTableIter iter;
+  gpointer       pixbuf;
+
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
+
+  *n_icons = g_hash_table_size (factory->icon_cache);
+  *icon_bytes = 0;
+  g_hash_table_iter_init (&iter, factory->icon_cache);
+  while (g_hash_table_iter_next (&iter, NULL, &pixbuf))
+    if (G_LIKELY (pixbuf != NULL))
+      *icon_bytes += gdk_pixbuf_get_byte_length (pixbuf);
+
+  *n_thumbnails = g_hash_table_size (factory->thumbnail_cache);
+  *thumbnail_bytes = factory->thumbnail_cache_size;
+}
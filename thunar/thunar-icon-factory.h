@@ -56,6 +56,12 @@ GdkPixbuf             *thunar_icon_factory_load_file_icon     (ThunarIconFactory
 
 void                   thunar_icon_factory_clear_pixmap_cache (ThunarFile               *file);
 
+void                   thunar_icon_factory_get_census         (ThunarIconFactory        *factory,
+                                                               guint                    *n_icons,
+                                                               guint64                  *icon_bytes,
+                                                               guint                    *n_thumbnails,
+                                                               guint64                  *thumbnail_bytes);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_ICON_FACTORY_H__ */
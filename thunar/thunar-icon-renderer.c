@@ -27,6 +27,7 @@
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-icon-renderer.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
@@ -438,32 +439,224 @@ thunar_icon_renderer_color_lighten (cairo_t   *cr,
 
 
 
-static void
-thunar_icon_renderer_render (GtkCellRenderer     *renderer,
-                             cairo_t             *cr,
-                             GtkWidget           *widget,
-                             const GdkRectangle  *background_area,
-                             const GdkRectangle  *cell_area,
-                             GtkCellRendererState flags)
+static gdouble
+thunar_icon_renderer_get_alpha (ThunarIconRenderer *icon_renderer,
+                                GtkWidget          *widget)
 {
   ThunarClipboardManager *clipboard;
+  gdouble                 alpha;
+
+  /* use a translucent icon to represent cutted and hidden files to the user */
+  clipboard = thunar_clipboard_manager_get_for_display (gtk_widget_get_display (widget));
+  if (thunar_clipboard_manager_has_cutted_file (clipboard, icon_renderer->file) && thunar_file_is_writable (icon_renderer->file))
+    {
+      /* 50% translucent for cutted files */
+      alpha = 0.50;
+    }
+  else if (thunar_file_is_hidden (icon_renderer->file))
+    {
+      /* 75% translucent for hidden files */
+      alpha = 0.75;
+    }
+  else
+    {
+      alpha = 1.00;
+    }
+  g_object_unref (G_OBJECT (clipboard));
+
+  return alpha;
+}
+
+
+
+static cairo_surface_t*
+thunar_icon_renderer_get_composite (ThunarIconRenderer *icon_renderer,
+                                    GtkWidget          *widget,
+                                    ThunarIconFactory  *icon_factory,
+                                    GdkPixbuf          *icon,
+                                    GList              *emblems,
+                                    gdouble             alpha,
+                                    const GdkRectangle *cell_area,
+                                    const GdkRectangle *icon_area,
+                                    gint                scale_factor)
+{
+  static GQuark    composites_quark = 0;
+  cairo_surface_t *surface;
+  GHashTable      *composites;
+  GdkRectangle     emblem_area;
+  GdkRectangle     icon_rect;
+  GdkRectangle     cell_rect;
+  GdkPixbuf       *emblem;
+  GdkPixbuf       *temp;
+  GdkWindow       *window;
+  GString         *key;
+  cairo_t         *cr;
+  GList           *lp;
+  gint             max_emblems;
+  gint             position;
+  gint             emblem_size;
+
+  if (G_UNLIKELY (composites_quark == 0))
+    composites_quark = g_quark_from_static_string ("thunar-icon-renderer-composites");
+
+  /* the key holds everything that changes the composited pixels */
+  key = g_string_new (NULL);
+  g_string_append_printf (key, "%dx%d@%d:%d:%d", cell_area->width, cell_area->height,
+                          scale_factor, icon_renderer->size, (gint) (alpha * 100));
+  for (lp = emblems; lp != NULL; lp = lp->next)
+    {
+      g_string_append_c (key, ';');
+      g_string_append (key, lp->data);
+    }
+
+  /* the composites live on the icon, so they go away together
+   * with it, for example when the icon theme changes */
+  composites = g_object_get_qdata (G_OBJECT (icon), composites_quark);
+  if (G_UNLIKELY (composites == NULL))
+    {
+      composites = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) cairo_surface_destroy);
+      g_object_set_qdata_full (G_OBJECT (icon), composites_quark, composites, (GDestroyNotify) g_hash_table_destroy);
+    }
+
+  surface = g_hash_table_lookup (composites, key->str);
+  if (G_LIKELY (surface != NULL))
+    {
+      g_string_free (key, TRUE);
+      return surface;
+    }
+
+  /* create a surface in the format of the window, covering the cell */
+  window = gtk_widget_get_window (widget);
+  if (G_LIKELY (window != NULL))
+    {
+      surface = gdk_window_create_similar_surface (window, CAIRO_CONTENT_COLOR_ALPHA, cell_area->width, cell_area->height);
+    }
+  else
+    {
+      surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, cell_area->width * scale_factor, cell_area->height * scale_factor);
+      cairo_surface_set_device_scale (surface, scale_factor, scale_factor);
+    }
+
+  /* all coordinates are relative to the cell from here on */
+  cell_rect.x = cell_rect.y = 0;
+  cell_rect.width = cell_area->width;
+  cell_rect.height = cell_area->height;
+  icon_rect = *icon_area;
+  icon_rect.x -= cell_area->x;
+  icon_rect.y -= cell_area->y;
+
+  cr = cairo_create (surface);
+
+  /* the emblems are not affected by the translucency of the icon */
+  thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_rect.x, icon_rect.y, scale_factor, window);
+  cairo_paint_with_alpha (cr, alpha);
+
+  /* render up to four emblems for sizes from 48 onwards, else up to 2 emblems */
+  max_emblems = (icon_renderer->size < 48) ? 2 : 4;
+
+  /* calculate the emblem size */
+  emblem_size = MIN ((2 * icon_renderer->size) / 3, 32);
+
+  /* render the emblems */
+  for (lp = emblems, position = 0; lp != NULL && position < max_emblems; lp = lp->next)
+    {
+      /* check if we have the emblem in the icon theme */
+      emblem = thunar_icon_factory_load_icon (icon_factory, lp->data, emblem_size * scale_factor, FALSE);
+      if (G_UNLIKELY (emblem == NULL))
+        continue;
+
+      /* determine the dimensions of the emblem */
+      emblem_area.width = gdk_pixbuf_get_width (emblem) / scale_factor;
+      emblem_area.height = gdk_pixbuf_get_height (emblem) / scale_factor;
+
+      /* shrink insane emblems */
+      if (G_UNLIKELY (MAX (emblem_area.width, emblem_area.height) > emblem_size))
+        {
+          /* scale down the emblem */
+          temp = exo_gdk_pixbuf_scale_ratio (emblem, emblem_size * scale_factor);
+          g_object_unref (G_OBJECT (emblem));
+          emblem = temp;
+
+          /* determine the size again */
+          emblem_area.width = gdk_pixbuf_get_width (emblem) / scale_factor;
+          emblem_area.height = gdk_pixbuf_get_height (emblem) / scale_factor;
+        }
+
+      /* determine a good position for the emblem, depending on the position index */
+      switch (position)
+        {
+        case 0: /* right/bottom */
+          emblem_area.x = MIN (icon_rect.x + icon_rect.width - emblem_area.width / 2,
+                               cell_rect.width - emblem_area.width);
+          emblem_area.y = MIN (icon_rect.y + icon_rect.height - emblem_area.height / 2,
+                               cell_rect.height - emblem_area.height);
+          break;
+
+        case 1: /* left/bottom */
+          emblem_area.x = MAX (icon_rect.x - emblem_area.width / 2,
+                               cell_rect.x);
+          emblem_area.y = MIN (icon_rect.y + icon_rect.height - emblem_area.height / 2,
+                               cell_rect.height - emblem_area.height);
+          break;
+
+        case 2: /* left/top */
+          emblem_area.x = MAX (icon_rect.x - emblem_area.width / 2,
+                               cell_rect.x);
+          emblem_area.y = MAX (icon_rect.y - emblem_area.height / 2,
+                               cell_rect.y);
+          break;
+
+        case 3: /* right/top */
+          emblem_area.x = MIN (icon_rect.x + icon_rect.width - emblem_area.width / 2,
+                               cell_rect.width - emblem_area.width);
+          emblem_area.y = MAX (icon_rect.y - emblem_area.height / 2,
+                               cell_rect.y);
+          break;
+
+        default:
+          _thunar_assert_not_reached ();
+        }
+
+      /* render the emblem */
+      thunar_gdk_cairo_set_source_pixbuf (cr, emblem, emblem_area.x, emblem_area.y, scale_factor, window);
+      cairo_paint (cr);
+
+      /* release the emblem */
+      g_object_unref (G_OBJECT (emblem));
+
+      /* advance the position index */
+      ++position;
+    }
+
+  cairo_destroy (cr);
+
+  g_hash_table_insert (composites, g_string_free (key, FALSE), surface);
+
+  return surface;
+}
+
+
+
+static void
+thunar_icon_renderer_render_cell (GtkCellRenderer     *renderer,
+                                  cairo_t             *cr,
+                                  GtkWidget           *widget,
+                                  const GdkRectangle  *background_area,
+                                  const GdkRectangle  *cell_area,
+                                  GtkCellRendererState flags)
+{
   ThunarFileIconState     icon_state;
   ThunarIconRenderer     *icon_renderer = THUNAR_ICON_RENDERER (renderer);
   ThunarIconFactory      *icon_factory;
   GtkIconTheme           *icon_theme;
-  GdkRectangle            emblem_area;
+  cairo_surface_t        *surface;
   GdkRectangle            icon_area;
   GdkRectangle            clip_area;
-  GdkPixbuf              *emblem;
   GdkPixbuf              *icon;
   GdkPixbuf              *temp;
   GList                  *emblems;
-  GList                  *lp;
   gint                    scale_factor;
-  gint                    max_emblems;
-  gint                    position;
   gdouble                 alpha;
-  gint                    emblem_size;
   gboolean                color_selected;
   gboolean                color_lighten;
   gboolean                is_expanded;
@@ -525,30 +718,27 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
   color_selected = (flags & GTK_CELL_RENDERER_SELECTED) != 0 && icon_renderer->follow_state;
   color_lighten = (flags & GTK_CELL_RENDERER_PRELIT) != 0 && icon_renderer->follow_state;
 
+  /* the emblems are drawn together with the icon */
+  emblems = icon_renderer->emblems ? thunar_file_get_emblem_names (icon_renderer->file) : NULL;
+
   /* check whether the icon is affected by the expose event */
-  if (gdk_rectangle_intersect (&clip_area, &icon_area, NULL))
+  if (gdk_rectangle_intersect (&clip_area, (emblems != NULL) ? cell_area : &icon_area, NULL))
     {
-      /* use a translucent icon to represent cutted and hidden files to the user */
-      clipboard = thunar_clipboard_manager_get_for_display (gtk_widget_get_display (widget));
-      if (thunar_clipboard_manager_has_cutted_file (clipboard, icon_renderer->file) && thunar_file_is_writable (icon_renderer->file))
-        {
-          /* 50% translucent for cutted files */
-          alpha = 0.50;
-        }
-      else if (thunar_file_is_hidden (icon_renderer->file))
+      alpha = thunar_icon_renderer_get_alpha (icon_renderer, widget);
+
+      /* render the invalid parts of the icon */
+      if (G_LIKELY (emblems == NULL))
         {
-          /* 75% translucent for hidden files */
-          alpha = 0.75;
+          thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_area.x, icon_area.y, scale_factor, gtk_widget_get_window (widget));
+          cairo_paint_with_alpha (cr, alpha);
         }
       else
         {
-          alpha = 1.00;
+          surface = thunar_icon_renderer_get_composite (icon_renderer, widget, icon_factory, icon, emblems,
+                                                        alpha, cell_area, &icon_area, scale_factor);
+          cairo_set_source_surface (cr, surface, cell_area->x, cell_area->y);
+          cairo_paint (cr);
         }
-      g_object_unref (G_OBJECT (clipboard));
-
-      /* render the invalid parts of the icon */
-      thunar_gdk_cairo_set_source_pixbuf (cr, icon, icon_area.x, icon_area.y, scale_factor);
-      cairo_paint_with_alpha (cr, alpha);
 
       /* check if we should render an insensitive icon */
       if (G_UNLIKELY (gtk_widget_get_state_flags (widget) == GTK_STATE_FLAG_INSENSITIVE || !gtk_cell_renderer_get_sensitive (renderer)))
@@ -563,109 +753,9 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
         thunar_icon_renderer_color_selected (cr, widget);
     }
 
-  /* release the file's icon */
+  /* release the file's icon and the emblem name list */
   g_object_unref (G_OBJECT (icon));
-
-  /* check if we should render emblems as well */
-  if (G_LIKELY (icon_renderer->emblems))
-    {
-      /* display the primary emblem as well (if any) */
-      emblems = thunar_file_get_emblem_names (icon_renderer->file);
-      if (G_UNLIKELY (emblems != NULL))
-        {
-          /* render up to four emblems for sizes from 48 onwards, else up to 2 emblems */
-          max_emblems = (icon_renderer->size < 48) ? 2 : 4;
-
-          /* render the emblems */
-          for (lp = emblems, position = 0; lp != NULL && position < max_emblems; lp = lp->next)
-            {
-              /* calculate the emblem size */
-              emblem_size = MIN ((2 * icon_renderer->size) / 3, 32);
-
-              /* check if we have the emblem in the icon theme */
-              emblem = thunar_icon_factory_load_icon (icon_factory, lp->data, emblem_size * scale_factor, FALSE);
-              if (G_UNLIKELY (emblem == NULL))
-                continue;
-
-              /* determine the dimensions of the emblem */
-              emblem_area.width = gdk_pixbuf_get_width (emblem) / scale_factor;
-              emblem_area.height = gdk_pixbuf_get_height (emblem) / scale_factor;
-
-              /* shrink insane emblems */
-              if (G_UNLIKELY (MAX (emblem_area.width, emblem_area.height) > emblem_size))
-                {
-                  /* scale down the emblem */
-                  temp = exo_gdk_pixbuf_scale_ratio (emblem, emblem_size * scale_factor);
-                  g_object_unref (G_OBJECT (emblem));
-                  emblem = temp;
-
-                  /* determine the size again */
-                  emblem_area.width = gdk_pixbuf_get_width (emblem) / scale_factor;
-                  emblem_area.height = gdk_pixbuf_get_height (emblem) / scale_factor;
-                }
-
-              /* determine a good position for the emblem, depending on the position index */
-              switch (position)
-                {
-                case 0: /* right/bottom */
-                  emblem_area.x = MIN (icon_area.x + icon_area.width - emblem_area.width / 2,
-                                       cell_area->x + cell_area->width - emblem_area.width);
-                  emblem_area.y = MIN (icon_area.y + icon_area.height - emblem_area.height / 2,
-                                       cell_area->y + cell_area->height -emblem_area.height);
-                  break;
-
-                case 1: /* left/bottom */
-                  emblem_area.x = MAX (icon_area.x - emblem_area.width / 2,
-                                       cell_area->x);
-                  emblem_area.y = MIN (icon_area.y + icon_area.height - emblem_area.height / 2,
-                                       cell_area->y + cell_area->height -emblem_area.height);
-                  break;
-
-                case 2: /* left/top */
-                  emblem_area.x = MAX (icon_area.x - emblem_area.width / 2,
-                                       cell_area->x);
-                  emblem_area.y = MAX (icon_area.y - emblem_area.height / 2,
-                                       cell_area->y);
-                  break;
-
-                case 3: /* right/top */
-                  emblem_area.x = MIN (icon_area.x + icon_area.width - emblem_area.width / 2,
-                                       cell_area->x + cell_area->width - emblem_area.width);
-                  emblem_area.y = MAX (icon_area.y - emblem_area.height / 2,
-                                       cell_area->y);
-                  break;
-
-                default:
-                  _thunar_assert_not_reached ();
-                }
-
-              /* render the emblem */
-              if (gdk_rectangle_intersect (&clip_area, &emblem_area, NULL))
-                {
-                  /* render the invalid parts of the icon */
-                  thunar_gdk_cairo_set_source_pixbuf (cr, emblem, emblem_area.x, emblem_area.y, scale_factor);
-                  cairo_paint (cr);
-
-                  /* paint the lighten mask */
-                  if (color_lighten)
-                    thunar_icon_renderer_color_lighten (cr, widget);
-
-                  /* paint the selected mask */
-                  if (color_selected)
-                    thunar_icon_renderer_color_selected (cr, widget);
-                }
-
-              /* release the emblem */
-              g_object_unref (G_OBJECT (emblem));
-
-              /* advance the position index */
-              ++position;
-            }
-
-          /* release the emblem name list */
-          g_list_free (emblems);
-        }
-    }
+  g_list_free (emblems);
 
   /* release our reference on the icon factory */
   g_object_unref (G_OBJECT (icon_factory));
@@ -673,6 +763,22 @@ thunar_icon_renderer_render (GtkCellRenderer     *renderer,
 
 
 
+static void
+thunar_icon_renderer_render (GtkCellRenderer     *renderer,
+                             cairo_t             *cr,
+                             GtkWidget           *widget,
+                             const GdkRectangle  *background_area,
+                             const GdkRectangle  *cell_area,
+                             GtkCellRendererState flags)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  thunar_icon_renderer_render_cell (renderer, cr, widget, background_area, cell_area, flags);
+  thunar_stats_record_since (THUNAR_STATS_ICON_RENDERER, start_time);
+}
+
+
+
 /**
  * thunar_icon_renderer_new:
  *
@@ -54,9 +54,8 @@ static void thunar_image_set_property         (GObject           *object,
 static void thunar_image_scale_changed        (GObject           *object,
                                                GParamSpec        *pspec,
                                                gpointer           user_data);
-static void thunar_image_file_changed         (ThunarFileMonitor *monitor,
-                                               ThunarFile        *file,
-                                               ThunarImage       *image);
+static void thunar_image_file_changed         (ThunarFile        *file,
+                                               gpointer           user_data);
 static void thunar_image_update               (ThunarImage       *image);
 
 
@@ -75,7 +74,6 @@ struct _ThunarImage
 
 struct _ThunarImagePrivate
 {
-  ThunarFileMonitor *monitor;
   ThunarFile        *file;
 };
 
@@ -111,10 +109,6 @@ thunar_image_init (ThunarImage *image)
   image->priv = thunar_image_get_instance_private (image);
   image->priv->file = NULL;
 
-  image->priv->monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (image->priv->monitor, "file-changed",
-                    G_CALLBACK (thunar_image_file_changed), image);
-
   g_signal_connect (G_OBJECT (image), "notify::scale-factor", G_CALLBACK (thunar_image_scale_changed), NULL);
 }
 
@@ -125,10 +119,6 @@ thunar_image_finalize (GObject *object)
 {
   ThunarImage *image = THUNAR_IMAGE (object);
 
-  g_signal_handlers_disconnect_by_func (image->priv->monitor,
-                                        thunar_image_file_changed, image);
-  g_object_unref (image->priv->monitor);
-
   thunar_image_set_file (image, NULL);
 
   (*G_OBJECT_CLASS (thunar_image_parent_class)->finalize) (object);
@@ -222,11 +212,11 @@ thunar_image_update (ThunarImage *image)
 
 
 static void
-thunar_image_file_changed (ThunarFileMonitor *monitor,
-                           ThunarFile        *file,
-                           ThunarImage       *image)
+thunar_image_file_changed (ThunarFile *file,
+                           gpointer    user_data)
 {
-  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (monitor));
+  ThunarImage *image = THUNAR_IMAGE (user_data);
+
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
   _thunar_return_if_fail (THUNAR_IS_IMAGE (image));
 
@@ -255,13 +245,19 @@ thunar_image_set_file (ThunarImage *image,
       if (image->priv->file == file)
         return;
 
+      thunar_file_monitor_unwatch_file (image->priv->file, thunar_image_file_changed, image);
       g_object_unref (image->priv->file);
     }
 
   if (file != NULL)
-    image->priv->file = g_object_ref (file);
+    {
+      image->priv->file = g_object_ref (file);
+      thunar_file_monitor_watch_file (file, thunar_image_file_changed, image);
+    }
   else
-    image->priv->file = NULL;
+    {
+      image->priv->file = NULL;
+    }
 
   thunar_image_update (image);
 
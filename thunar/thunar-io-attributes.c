@@ -0,0 +1,470 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+
+#include <thunar/thunar-application.h>
+#include <thunar/thunar-io-attributes.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* number of folders walked at the same time, spinning disks
+ * are walked by a single thread so they don't seek */
+#define THUNAR_IO_ATTRIBUTES_THREADS           4
+
+/* microseconds between two progress updates */
+#define THUNAR_IO_ATTRIBUTES_PROGRESS_INTERVAL (100 * 1000)
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+
+
+typedef struct _ThunarIoAttributes    ThunarIoAttributes;
+typedef struct _ThunarIoAttributesDir ThunarIoAttributesDir;
+
+struct _ThunarIoAttributes
+{
+  ThunarJob   *job;
+  GThreadPool *pool;
+
+  GMutex       mutex;
+  GCond        cond;
+
+  /* all folders of the walk, they are released at the end */
+  GPtrArray   *dirs;
+
+  /* set if a file could not be changed or the job was cancelled */
+  gint         stop;
+  gboolean     done;
+
+  /* either the permissions or the owner and group are changed */
+  gboolean     change_mode;
+  mode_t       dir_mask;
+  mode_t       dir_mode;
+  mode_t       file_mask;
+  mode_t       file_mode;
+  gint         uid;
+  gint         gid;
+
+  /* number of processed files and folders, updated atomically */
+  gint         n_processed;
+};
+
+struct _ThunarIoAttributesDir
+{
+  ThunarIoAttributesDir *parent;
+  gchar                 *path;
+
+  /* the folder itself is changed last, so changing
+   * its permissions can't lock the walk out of it */
+  struct stat            statb;
+
+  /* subfolders not yet done, plus one while the folder is read */
+  gint                   n_pending;
+};
+
+
+
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT)
+static ThunarIoAttributesDir *
+thunar_io_attributes_dir_new (ThunarIoAttributes    *context,
+                              ThunarIoAttributesDir *parent,
+                              gchar                 *path,
+                              const struct stat     *statb)
+{
+  ThunarIoAttributesDir *dir;
+
+  dir = g_slice_new (ThunarIoAttributesDir);
+  dir->parent = parent;
+  dir->path = path;
+  dir->statb = *statb;
+  dir->n_pending = 1;
+
+  g_mutex_lock (&context->mutex);
+  g_ptr_array_add (context->dirs, dir);
+  g_mutex_unlock (&context->mutex);
+
+  return dir;
+}
+
+
+
+static void
+thunar_io_attributes_dir_free (gpointer data)
+{
+  ThunarIoAttributesDir *dir = data;
+
+  g_free (dir->path);
+  g_slice_free (ThunarIoAttributesDir, dir);
+}
+
+
+
+static void
+thunar_io_attributes_stop (ThunarIoAttributes *context)
+{
+  g_mutex_lock (&context->mutex);
+  g_atomic_int_set (&context->stop, TRUE);
+  g_cond_broadcast (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+/* changes name relative to dirfd, files that already
+ * have the requested attributes are left alone */
+static gboolean
+thunar_io_attributes_apply (ThunarIoAttributes *context,
+                            gint                dirfd,
+                            const gchar        *name,
+                            const struct stat  *statb)
+{
+  mode_t mask;
+  mode_t mode;
+
+  g_atomic_int_inc (&context->n_processed);
+
+  if (context->change_mode)
+    {
+      /* the permissions of symbolic links are not used */
+      if (S_ISLNK (statb->st_mode))
+        return TRUE;
+
+      if (S_ISDIR (statb->st_mode))
+        {
+          mask = context->dir_mask;
+          mode = context->dir_mode;
+        }
+      else
+        {
+          mask = context->file_mask;
+          mode = context->file_mode;
+        }
+
+      mode = ((statb->st_mode & ~mask) | mode) & 07777;
+      if (mode == (statb->st_mode & 07777))
+        return TRUE;
+
+      return fchmodat (dirfd, name, mode, 0) == 0;
+    }
+
+  if ((context->uid < 0 || statb->st_uid == (uid_t) context->uid)
+      && (context->gid < 0 || statb->st_gid == (gid_t) context->gid))
+    return TRUE;
+
+  return fchownat (dirfd, name, (uid_t) context->uid, (gid_t) context->gid, AT_SYMLINK_NOFOLLOW) == 0;
+}
+
+
+
+/* changes every folder whose contents are done, starting at dir */
+static void
+thunar_io_attributes_dir_finish (ThunarIoAttributes    *context,
+                                 ThunarIoAttributesDir *dir)
+{
+  for (; dir != NULL && g_atomic_int_dec_and_test (&dir->n_pending); dir = dir->parent)
+    {
+      if (!thunar_io_attributes_apply (context, AT_FDCWD, dir->path, &dir->statb))
+        {
+          thunar_io_attributes_stop (context);
+          return;
+        }
+
+      if (dir->parent == NULL)
+        {
+          /* the whole tree is changed */
+          g_mutex_lock (&context->mutex);
+          context->done = TRUE;
+          g_cond_broadcast (&context->cond);
+          g_mutex_unlock (&context->mutex);
+        }
+    }
+}
+
+
+
+static void
+thunar_io_attributes_thread (gpointer data,
+                             gpointer user_data)
+{
+  ThunarIoAttributesDir *dir = data;
+  ThunarIoAttributesDir *child;
+  ThunarIoAttributes    *context = user_data;
+  struct dirent         *entry;
+  struct stat            statb;
+  DIR                   *dp;
+  gint                   fd;
+
+  if (g_atomic_int_get (&context->stop))
+    return;
+
+  fd = open (dir->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  dp = (fd >= 0) ? fdopendir (fd) : NULL;
+  if (dp == NULL)
+    {
+      if (fd >= 0)
+        close (fd);
+      thunar_io_attributes_stop (context);
+      return;
+    }
+
+  while (!g_atomic_int_get (&context->stop) && (entry = readdir (dp)) != NULL)
+    {
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+      if (exo_job_is_cancelled (EXO_JOB (context->job)))
+        {
+          thunar_io_attributes_stop (context);
+          break;
+        }
+
+      /* the current attributes decide whether anything is changed */
+      if (fstatat (fd, entry->d_name, &statb, AT_SYMLINK_NOFOLLOW) < 0)
+        {
+          thunar_io_attributes_stop (context);
+          break;
+        }
+
+      if (S_ISDIR (statb.st_mode))
+        {
+          /* the subfolder is walked by the next free thread */
+          child = thunar_io_attributes_dir_new (context, dir, g_build_filename (dir->path, entry->d_name, NULL), &statb);
+          g_atomic_int_inc (&dir->n_pending);
+          g_thread_pool_push (context->pool, child, NULL);
+          continue;
+        }
+
+      if (!thunar_io_attributes_apply (context, fd, entry->d_name, &statb))
+        {
+          thunar_io_attributes_stop (context);
+          break;
+        }
+    }
+
+  closedir (dp);
+
+  if (!g_atomic_int_get (&context->stop))
+    thunar_io_attributes_dir_finish (context, dir);
+}
+
+
+
+static gboolean
+thunar_io_attributes_run (ThunarIoAttributes *context,
+                          GFile              *directory)
+{
+  ThunarApplication *application;
+  ThunarIoScheduler *scheduler;
+  ThunarIoTicket    *ticket;
+  struct stat        statb;
+  const gchar       *path;
+  gint64             end_time;
+  guint              n_processed;
+  guint              n_reported = 0;
+  gint               n_threads;
+
+  path = g_file_peek_path (directory);
+  if (path == NULL || lstat (path, &statb) < 0 || !S_ISDIR (statb.st_mode))
+    return FALSE;
+
+  if (thunar_io_scheduler_get_device_class (directory) == THUNAR_IO_DEVICE_ROTATIONAL)
+    n_threads = 1;
+  else
+    n_threads = THUNAR_IO_ATTRIBUTES_THREADS;
+
+  /* share the device with the other jobs */
+  application = thunar_application_get ();
+  scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+  ticket = thunar_io_scheduler_acquire (scheduler, directory, NULL, TRUE, exo_job_get_cancellable (EXO_JOB (context->job)));
+
+  context->dirs = g_ptr_array_new_with_free_func (thunar_io_attributes_dir_free);
+  context->stop = FALSE;
+  context->done = FALSE;
+  context->n_processed = 0;
+  g_mutex_init (&context->mutex);
+  g_cond_init (&context->cond);
+
+  context->pool = g_thread_pool_new (thunar_io_attributes_thread, context, n_threads, FALSE, NULL);
+  g_thread_pool_push (context->pool, thunar_io_attributes_dir_new (context, NULL, g_strdup (path), &statb), NULL);
+
+  /* only the job thread reports the progress */
+  g_mutex_lock (&context->mutex);
+  while (!context->done && !g_atomic_int_get (&context->stop))
+    {
+      end_time = g_get_monotonic_time () + THUNAR_IO_ATTRIBUTES_PROGRESS_INTERVAL;
+      if (g_cond_wait_until (&context->cond, &context->mutex, end_time))
+        continue;
+
+      g_mutex_unlock (&context->mutex);
+
+      n_processed = g_atomic_int_get (&context->n_processed);
+      if (n_processed != n_reported)
+        {
+          exo_job_info_message (EXO_JOB (context->job), ngettext ("Processed %u file", "Processed %u files", n_processed), n_processed);
+          n_reported = n_processed;
+        }
+
+      if (exo_job_is_cancelled (EXO_JOB (context->job)))
+        g_atomic_int_set (&context->stop, TRUE);
+
+      g_mutex_lock (&context->mutex);
+    }
+  g_mutex_unlock (&context->mutex);
+
+  /* let the threads run out, the queued folders are skipped */
+  g_thread_pool_free (context->pool, FALSE, TRUE);
+
+  if (ticket != NULL)
+    thunar_io_ticket_release (ticket);
+  g_object_unref (scheduler);
+
+  g_ptr_array_free (context->dirs, TRUE);
+  g_mutex_clear (&context->mutex);
+  g_cond_clear (&context->cond);
+
+  return context->done;
+}
+#endif
+
+
+
+/**
+ * thunar_io_attributes_change_mode:
+ * @job       : a #ThunarJob.
+ * @directory : a local #GFile of a folder.
+ * @dir_mask  : the permission bits to clear on folders.
+ * @dir_mode  : the permission bits to set on folders.
+ * @file_mask : the permission bits to clear on other files.
+ * @file_mode : the permission bits to set on other files.
+ *
+ * Changes the permissions of @directory and everything below it while
+ * the folders are walked, several at the same time. Files that already
+ * have the requested permissions and symbolic links are left alone.
+ * Stops at the first file that could not be changed, or when @job is
+ * cancelled.
+ *
+ * Return value: %TRUE if the whole tree was processed, %FALSE if
+ *               @directory is not a local folder, or parts of it
+ *               are left.
+ **/
+gboolean
+thunar_io_attributes_change_mode (ThunarJob      *job,
+                                  GFile          *directory,
+                                  ThunarFileMode  dir_mask,
+                                  ThunarFileMode  dir_mode,
+                                  ThunarFileMode  file_mask,
+                                  ThunarFileMode  file_mode)
+{
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT)
+  ThunarIoAttributes context;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+
+  context.job = job;
+  context.change_mode = TRUE;
+  context.dir_mask = dir_mask;
+  context.dir_mode = dir_mode;
+  context.file_mask = file_mask;
+  context.file_mode = file_mode;
+  context.uid = -1;
+  context.gid = -1;
+
+  return thunar_io_attributes_run (&context, directory);
+#else
+  return FALSE;
+#endif
+}
+
+
+
+/**
+ * thunar_io_attributes_change_owner:
+ * @job       : a #ThunarJob.
+ * @directory : a local #GFile of a folder.
+ * @uid       : the new owner, or -1 to keep it.
+ * @gid       : the new group, or -1 to keep it.
+ *
+ * Changes the owner and group of @directory and everything below it
+ * like thunar_io_attributes_change_mode() changes the permissions.
+ * Symbolic links are changed themselves, not followed.
+ *
+ * Return value: %TRUE if the whole tree was processed, %FALSE if
+ *               @directory is not a local folder, or parts of it
+ *               are left.
+ **/
+gboolean
+thunar_io_attributes_change_owner (ThunarJob *job,
+                                   GFile     *directory,
+                                   gint       uid,
+                                   gint       gid)
+{
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT)
+  ThunarIoAttributes context;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+
+  context.job = job;
+  context.change_mode = FALSE;
+  context.dir_mask = 0;
+  context.dir_mode = 0;
+  context.file_mask = 0;
+  context.file_mode = 0;
+  context.uid = uid;
+  context.gid = gid;
+
+  return thunar_io_attributes_run (&context, directory);
+#else
+  return FALSE;
+#endif
+}
@@ -28,16 +28,89 @@
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
 
+/* returns the names of the files in directory, listing it only the first
+ * time, the set is kept up to date by the jobs using names_by_dir */
+static GHashTable *
+thunar_io_jobs_util_lookup_names (ThunarJob  *job,
+                                  GHashTable *names_by_dir,
+                                  GFile      *directory,
+                                  GError    **error)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *info;
+  GHashTable      *names;
+  GError          *err = NULL;
+
+  names = g_hash_table_lookup (names_by_dir, directory);
+  if (names != NULL)
+    return names;
+
+  enumerator = g_file_enumerate_children (directory, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          exo_job_get_cancellable (EXO_JOB (job)),
+                                          error);
+  if (enumerator == NULL)
+    return NULL;
+
+  names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  while ((info = g_file_enumerator_next_file (enumerator, exo_job_get_cancellable (EXO_JOB (job)), &err)) != NULL)
+    {
+      g_hash_table_add (names, g_strdup (g_file_info_get_name (info)));
+      g_object_unref (info);
+    }
+
+  g_object_unref (enumerator);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      g_hash_table_unref (names);
+      return NULL;
+    }
+
+  g_hash_table_insert (names_by_dir, g_object_ref (directory), names);
+
+  return names;
+}
+
+
+
+/**
+ * thunar_io_jobs_util_names_new:
+ *
+ * Creates a cache for the names of the target folders of a job,
+ * to be passed to thunar_io_jobs_util_next_duplicate_file() and
+ * thunar_io_jobs_util_next_renamed_file(). Every folder is listed
+ * once and the names handed out for new files are added to it, so
+ * free names are found without asking the file system per candidate.
+ *
+ * The cache is only used by the thread of the job.
+ *
+ * Return value: a new #GHashTable, to be released with
+ *               g_hash_table_unref().
+ **/
+GHashTable *
+thunar_io_jobs_util_names_new (void)
+{
+  return g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                g_object_unref, (GDestroyNotify) g_hash_table_unref);
+}
+
+
+
 /**
  * thunar_io_jobs_util_next_duplicate_file:
- * @job        : a #ThunarJob.
- * @file       : the source #GFile.
- * @name_mode  : the naming mode to use (copy/link).
- * @error      : return location for errors or %NULL.
+ * @job          : a #ThunarJob.
+ * @file         : the source #GFile.
+ * @name_mode    : the naming mode to use (copy/link).
+ * @names_by_dir : the name cache of @job from thunar_io_jobs_util_names_new(),
+ *                 or %NULL to look at the folder of @file.
+ * @error        : return location for errors or %NULL.
  *
  * Determines the #GFile for the next copy/link of/to @file.
  *
@@ -56,14 +129,17 @@ GFile*
 thunar_io_jobs_util_next_duplicate_file (ThunarJob               *job,
                                          GFile                   *file,
                                          ThunarNextFileNameMode   name_mode,
+                                         GHashTable              *names_by_dir,
                                          GError                 **error)
 {
   GError      *err = NULL;
   GFile       *duplicate_file = NULL;
   GFile       *parent_file = NULL;
   ThunarFile  *thunar_parent_file;
-  const gchar *old_filename;
+  GHashTable  *names;
+  gchar       *old_filename;
   gchar       *filename;
+  gint64       start_time = g_get_monotonic_time ();
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
@@ -76,26 +152,49 @@ thunar_io_jobs_util_next_duplicate_file (ThunarJob               *job,
 
   parent_file = g_file_get_parent (file);
   old_filename = g_file_get_basename (file);
-  thunar_parent_file = thunar_file_get (parent_file, &err);
-  if (thunar_parent_file == NULL)
+
+  if (names_by_dir != NULL)
     {
-      g_object_unref (parent_file);
-      g_propagate_error (error, err);
-      return NULL;
+      names = thunar_io_jobs_util_lookup_names (job, names_by_dir, parent_file, &err);
+      if (names == NULL)
+        {
+          g_object_unref (parent_file);
+          g_free (old_filename);
+          g_propagate_error (error, err);
+          return NULL;
+        }
+
+      /* the name is taken from now on, whether the file is created or not */
+      filename = thunar_util_next_new_file_name_in (names, old_filename, name_mode);
+      g_hash_table_add (names, g_strdup (filename));
     }
+  else
+    {
+      thunar_parent_file = thunar_file_get (parent_file, &err);
+      if (thunar_parent_file == NULL)
+        {
+          g_object_unref (parent_file);
+          g_free (old_filename);
+          g_propagate_error (error, err);
+          return NULL;
+        }
 
-  filename = thunar_util_next_new_file_name (thunar_parent_file,
-                                             old_filename,
-                                             name_mode);
-  g_object_unref (thunar_parent_file);
+      filename = thunar_util_next_new_file_name (thunar_parent_file,
+                                                 old_filename,
+                                                 name_mode);
+      g_object_unref (thunar_parent_file);
+    }
 
   /* create the GFile for the copy/link */
   duplicate_file = g_file_get_child (parent_file, filename);
   g_object_unref (parent_file);
 
   /* free resources */
+  g_free (old_filename);
   g_free (filename);
 
+  thunar_stats_record_since (THUNAR_STATS_NEXT_FILE_NAME, start_time);
+
   return duplicate_file;
 }
 
@@ -103,15 +202,18 @@ thunar_io_jobs_util_next_duplicate_file (ThunarJob               *job,
 
 /**
  * thunar_io_jobs_util_next_renamed_file:
- * @job       : a #ThunarJob.
- * @src_file  : the source #GFile.
- * @tgt_file  : the target #GFile.
- * @n         : the @n<!---->th copy/move to create the #GFile for.
- * @error     : return location for errors or %NULL.
+ * @job          : a #ThunarJob.
+ * @src_file     : the source #GFile.
+ * @tgt_file     : the target #GFile.
+ * @n            : the @n<!---->th copy/move to create the #GFile for.
+ * @names_by_dir : the name cache of @job from thunar_io_jobs_util_names_new(),
+ *                 or %NULL.
+ * @error        : return location for errors or %NULL.
  *
  * Determines the #GFile for the next copy/move to @tgt_file.
  *
- * File named X will be renamed to "X (copy 1)".
+ * File named X will be renamed to "X (copy 1)". With @names_by_dir,
+ * numbers from @n on whose names are known to be taken are skipped.
  *
  * If there are errors or the job was cancelled, the return value
  * will be %NULL and @error will be set.
@@ -120,20 +222,24 @@ thunar_io_jobs_util_next_duplicate_file (ThunarJob               *job,
  *               of @tgt_file or %NULL on error/cancellation.
  **/
 GFile *
-thunar_io_jobs_util_next_renamed_file (ThunarJob *job,
-                                       GFile     *src_file,
-                                       GFile     *tgt_file,
-                                       guint      n,
-                                       GError   **error)
+thunar_io_jobs_util_next_renamed_file (ThunarJob  *job,
+                                       GFile      *src_file,
+                                       GFile      *tgt_file,
+                                       guint       n,
+                                       GHashTable *names_by_dir,
+                                       GError    **error)
 {
   GFileInfo   *info;
   GError      *err = NULL;
   GFile       *renamed_file = NULL;
   GFile       *parent_file = NULL;
-  const gchar *old_filename;
-  gchar       *filename;
-  gchar       *file_basename;
+  GHashTable  *names = NULL;
+  gchar       *old_filename;
+  gchar       *filename = NULL;
+  gchar       *file_basename = NULL;
   gchar       *extension = NULL;
+  guint        n_tries = 0;
+  gint64       start_time = g_get_monotonic_time ();
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
   _thunar_return_val_if_fail (G_IS_FILE (src_file), NULL);
@@ -160,32 +266,63 @@ thunar_io_jobs_util_next_renamed_file (ThunarJob *job,
       return NULL;
     }
 
+  parent_file = g_file_get_parent (tgt_file);
+
+  if (names_by_dir != NULL)
+    {
+      names = thunar_io_jobs_util_lookup_names (job, names_by_dir, parent_file, &err);
+      if (names == NULL)
+        {
+          g_object_unref (parent_file);
+          g_object_unref (info);
+          g_propagate_error (error, err);
+          return NULL;
+        }
+    }
+
   old_filename = g_file_get_basename (src_file);
   /* get file extension if file is not a directory */
   if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
     extension = thunar_util_str_get_extension (old_filename);
 
   if (extension != NULL)
+    file_basename = g_strndup (old_filename, extension - old_filename);
+
+  for (;; n++, n_tries++)
     {
-      file_basename = g_strndup (old_filename, extension - old_filename);
-      /* I18N: put " (copy #)" between basename and extension */
-      filename = g_strdup_printf (_("%s (copy %u)%s"), file_basename, n, extension);
-      g_free(file_basename);
-    }
-  else
-    {
-      /* I18N: put " (copy #)" after filename (for files without extension) */
-      filename = g_strdup_printf (_("%s (copy %u)"), old_filename, n);
+      g_free (filename);
+
+      if (extension != NULL)
+        {
+          /* I18N: put " (copy #)" between basename and extension */
+          filename = g_strdup_printf (_("%s (copy %u)%s"), file_basename, n, extension);
+        }
+      else
+        {
+          /* I18N: put " (copy #)" after filename (for files without extension) */
+          filename = g_strdup_printf (_("%s (copy %u)"), old_filename, n);
+        }
+
+      if (names == NULL || !g_hash_table_contains (names, filename))
+        break;
     }
 
+  /* the name is taken from now on, whether the file is created or not */
+  if (names != NULL)
+    g_hash_table_add (names, g_strdup (filename));
+
   /* create the GFile for the copy/move */
-  parent_file = g_file_get_parent (tgt_file);
   renamed_file = g_file_get_child (parent_file, filename);
   g_object_unref (parent_file);
 
   /* free resources */
   g_object_unref (info);
+  g_free (file_basename);
+  g_free (old_filename);
   g_free (filename);
 
+  thunar_stats_record_since (THUNAR_STATS_NEXT_FILE_NAME, start_time);
+  thunar_stats_record (THUNAR_STATS_NEXT_FILE_NAME_TRIES, n_tries + 1);
+
   return renamed_file;
 }
@@ -26,16 +26,20 @@
 
 G_BEGIN_DECLS
 
-GFile *thunar_io_jobs_util_next_duplicate_file (ThunarJob             *job,
-                                                GFile                 *file,
-                                                ThunarNextFileNameMode name_mode,
-                                                GError               **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
-
-GFile *thunar_io_jobs_util_next_renamed_file (ThunarJob *job,
-                                              GFile     *src_file,
-                                              GFile     *tgt_file,
-                                              guint      n,
-                                              GError   **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+GHashTable *thunar_io_jobs_util_names_new           (void) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
+GFile      *thunar_io_jobs_util_next_duplicate_file (ThunarJob             *job,
+                                                     GFile                 *file,
+                                                     ThunarNextFileNameMode name_mode,
+                                                     GHashTable            *names_by_dir,
+                                                     GError               **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
+GFile      *thunar_io_jobs_util_next_renamed_file   (ThunarJob             *job,
+                                                     GFile                 *src_file,
+                                                     GFile                 *tgt_file,
+                                                     guint                  n,
+                                                     GHashTable            *names_by_dir,
+                                                     GError               **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
 
@@ -25,17 +25,31 @@
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <gio/gio.h>
 #include <glib/gstdio.h>
 
+#include <libxfce4util/libxfce4util.h>
+
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-enum-types.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-attributes.h>
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-io-scan-directory.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-io-unlink.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-simple-job.h>
@@ -44,6 +58,23 @@
 
 
 
+/* number of completed infos passed to the main loop at once */
+#define THUNAR_IO_JOBS_LOAD_INFO_BATCH_SIZE 32
+
+/* minimum number of sibling files reloaded by enumerating their parent */
+#define THUNAR_IO_JOBS_RELOAD_ENUMERATE_MIN 8
+
+/* number of content types passed to the main loop at once */
+#define THUNAR_IO_JOBS_CONTENT_TYPE_BATCH_SIZE 256
+
+/* number of renamed files passed to the main loop at once */
+#define THUNAR_IO_JOBS_RENAME_BATCH_SIZE 256
+
+/* where the journals of running batch renames are kept */
+#define THUNAR_IO_JOBS_RENAME_JOURNAL_DIR "Thunar/rename-journals/"
+
+
+
 static GList *
 _tij_collect_nofollow (ThunarJob *job,
                        GList     *base_file_list,
@@ -262,6 +293,10 @@ _thunar_io_jobs_create (ThunarJob  *job,
 
           if (template_stream != NULL)
             {
+              /* every new file starts at the beginning of the template */
+              if (lp != file_list && g_seekable_can_seek (G_SEEKABLE (template_stream)))
+                g_seekable_seek (G_SEEKABLE (template_stream), 0, G_SEEK_SET, NULL, NULL);
+
               /* write the template into the new file */
               g_output_stream_splice (G_OUTPUT_STREAM (stream),
                                       G_INPUT_STREAM (template_stream),
@@ -491,6 +526,8 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
   GFileInfo            *info;
   GError               *err = NULL;
   GList                *file_list;
+  GList                *remaining_list = NULL;
+  GList                *trash_list = NULL;
   GList                *lp;
   gchar                *base_name;
   gchar                *display_name;
@@ -504,11 +541,35 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
   /* get the file list */
   file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
+  /* take a reference on the thumbnail cache */
+  application = thunar_application_get ();
+  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
+  g_object_unref (application);
+
+  /* local folders are deleted while they are walked, whatever is left
+   * of them after an error is deleted one by one below, asking the user */
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      /* the local trash folders are emptied at once, their former
+       * contents are deleted afterwards like any other folder */
+      if (thunar_g_file_is_trash (lp->data))
+        trash_list = g_list_concat (thunar_io_unlink_move_trash_aside (), trash_list);
+
+      if (thunar_g_file_is_root (lp->data) || !thunar_io_unlink_directory (job, lp->data, thumbnail_cache))
+        remaining_list = g_list_prepend (remaining_list, lp->data);
+    }
+  for (lp = trash_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    if (!thunar_io_unlink_directory (job, lp->data, thumbnail_cache))
+      remaining_list = g_list_prepend (remaining_list, lp->data);
+  remaining_list = g_list_reverse (remaining_list);
+
   /* tell the user that we're preparing to unlink the files */
   exo_job_info_message (EXO_JOB (job), _("Preparing..."));
 
   /* recursively collect files for removal, not following any symlinks */
-  file_list = _tij_collect_nofollow (job, file_list, TRUE, &err);
+  file_list = _tij_collect_nofollow (job, remaining_list, TRUE, &err);
+  g_list_free (remaining_list);
+  thunar_g_list_free_full (trash_list);
 
   /* free the file list and fail if there was an error or the job was cancelled */
   if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
@@ -519,17 +580,13 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
         g_propagate_error (error, err);
 
       thunar_g_list_free_full (file_list);
+      g_object_unref (thumbnail_cache);
       return FALSE;
     }
 
   /* we know the total list of files to process */
   thunar_job_set_total_files (THUNAR_JOB (job), file_list);
 
-  /* take a reference on the thumbnail cache */
-  application = thunar_application_get ();
-  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
-  g_object_unref (application);
-
   /* remove all the files */
   for (lp = file_list;
        lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
@@ -552,6 +609,12 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
            * be deleted now */
           thunar_thumbnail_cache_delete_file (thumbnail_cache, lp->data);
         }
+      else if (err->domain == G_IO_ERROR && err->code == G_IO_ERROR_NOT_FOUND)
+        {
+          /* the file is gone already, e.g. it is one of the entries
+           * GVfs still lists for a trash that was just emptied */
+          g_clear_error (&err);
+        }
       else
         {
           /* query the file info for the display name */
@@ -613,8 +676,15 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
 ThunarJob *
 thunar_io_jobs_unlink_files (GList *file_list)
 {
-  return thunar_simple_job_new (_thunar_io_jobs_unlink, 1,
-                                THUNAR_TYPE_G_FILE_LIST, file_list);
+  ThunarJob *job;
+
+  job = thunar_simple_job_new (_thunar_io_jobs_unlink, 1,
+                               THUNAR_TYPE_G_FILE_LIST, file_list);
+
+  /* deleting a tree can take as long as copying it */
+  thunar_job_set_pool (job, THUNAR_JOB_POOL_BULK);
+
+  return job;
 }
 
 
@@ -658,10 +728,11 @@ thunar_io_jobs_copy_files (GList *source_file_list,
 
 
 static GFile *
-_thunar_io_jobs_link_file (ThunarJob *job,
-                           GFile     *source_file,
-                           GFile     *target_file,
-                           GError   **error)
+_thunar_io_jobs_link_file (ThunarJob  *job,
+                           GFile      *source_file,
+                           GFile      *target_file,
+                           GHashTable *names_by_dir,
+                           GError    **error)
 {
   ThunarJobResponse  response;
   GError            *err = NULL;
@@ -683,7 +754,7 @@ _thunar_io_jobs_link_file (ThunarJob *job,
       if (!g_file_equal (source_file, target_file))
         symlink = g_object_ref (target_file);
       else
-        symlink = thunar_io_jobs_util_next_duplicate_file (job, source_file, THUNAR_NEXT_FILE_NAME_MODE_LINK, &err);
+        symlink = thunar_io_jobs_util_next_duplicate_file (job, source_file, THUNAR_NEXT_FILE_NAME_MODE_LINK, names_by_dir, &err);
       if (err == NULL)
         {
           /* try to create the symlink from the g_file */
@@ -749,6 +820,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
   ThunarApplication      *application;
   GError                 *err = NULL;
   GFile                  *real_target_file;
+  GHashTable             *names_by_dir;
   GList                  *new_files_list = NULL;
   GList                  *source_file_list;
   GList                  *sp;
@@ -779,6 +851,9 @@ _thunar_io_jobs_link (ThunarJob  *job,
   if (log_mode == THUNAR_OPERATION_LOG_OPERATIONS)
     operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_LINK);
 
+  /* names of the folders that get links to their own files */
+  names_by_dir = thunar_io_jobs_util_names_new ();
+
   /* process all files */
   for (sp = source_file_list, tp = target_file_list;
        err == NULL && sp != NULL && tp != NULL;
@@ -791,7 +866,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
       thunar_job_processing_file (THUNAR_JOB (job), sp, n_processed);
 
       /* try to create the symbolic link */
-      real_target_file = _thunar_io_jobs_link_file (job, sp->data, tp->data, &err);
+      real_target_file = _thunar_io_jobs_link_file (job, sp->data, tp->data, names_by_dir, &err);
       if (real_target_file != NULL)
         {
           /* queue the file for the folder update unless it was skipped */
@@ -815,6 +890,8 @@ _thunar_io_jobs_link (ThunarJob  *job,
         }
     }
 
+  g_hash_table_unref (names_by_dir);
+
   /* release the thumbnail cache */
   g_object_unref (thumbnail_cache);
 
@@ -868,6 +945,7 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   GError                 *err = NULL;
   GList                  *file_list;
   GList                  *lp;
+  GList                  *processed_list = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -912,10 +990,13 @@ _thunar_io_jobs_trash (ThunarJob  *job,
       if (err == NULL && log_mode != THUNAR_OPERATION_LOG_NO_OPERATIONS)
           thunar_job_operation_add (operation, lp->data, NULL);
 
-      /* update the thumbnail cache */
-      thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+      processed_list = g_list_prepend (processed_list, lp->data);
     }
 
+  /* update the thumbnail cache for all processed files at once */
+  thunar_thumbnail_cache_cleanup_files (thumbnail_cache, processed_list);
+  g_list_free (processed_list);
+
   /* release the thumbnail cache */
   g_object_unref (thumbnail_cache);
 
@@ -984,6 +1065,7 @@ _thunar_io_jobs_chown (ThunarJob  *job,
   gboolean          recursive;
   GError           *err = NULL;
   GList            *file_list;
+  GList            *remaining_list = NULL;
   GList            *lp;
   gint              uid;
   gint              gid;
@@ -1003,7 +1085,17 @@ _thunar_io_jobs_chown (ThunarJob  *job,
 
   /* collect the files for the chown operation */
   if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+    {
+      /* local folders are changed while they are walked, whatever is left
+       * of them after an error is changed one by one below, asking the user */
+      for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+        if (!thunar_io_attributes_change_owner (job, lp->data, uid, gid))
+          remaining_list = g_list_prepend (remaining_list, lp->data);
+      remaining_list = g_list_reverse (remaining_list);
+
+      file_list = _tij_collect_nofollow (job, remaining_list, FALSE, &err);
+      g_list_free (remaining_list);
+    }
   else
     file_list = thunar_g_list_copy_deep (file_list);
 
@@ -1121,6 +1213,7 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   gboolean          recursive;
   GError           *err = NULL;
   GList            *file_list;
+  GList            *remaining_list = NULL;
   GList            *lp;
   guint             n_processed = 0;
   ThunarFileMode    dir_mask;
@@ -1146,7 +1239,17 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
 
   /* collect the files for the chown operation */
   if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
+    {
+      /* local folders are changed while they are walked, whatever is left
+       * of them after an error is changed one by one below, asking the user */
+      for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+        if (!thunar_io_attributes_change_mode (job, lp->data, dir_mask, dir_mode, file_mask, file_mode))
+          remaining_list = g_list_prepend (remaining_list, lp->data);
+      remaining_list = g_list_reverse (remaining_list);
+
+      file_list = _tij_collect_nofollow (job, remaining_list, FALSE, &err);
+      g_list_free (remaining_list);
+    }
   else
     file_list = thunar_g_list_copy_deep (file_list);
 
@@ -1269,14 +1372,31 @@ thunar_io_jobs_change_mode (GList         *files,
 
 
 
+/* on remote locations, only query what is needed to show the files, the
+ * rest is loaded afterwards, see thunar_io_jobs_load_info(). The trash and
+ * recent files need their special attributes right away */
+static gboolean
+_thunar_io_jobs_ls_partial_info (GFile *directory)
+{
+  return !g_file_is_native (directory)
+         && !g_file_has_uri_scheme (directory, "trash")
+         && !g_file_has_uri_scheme (directory, "recent");
+}
+
+
+
 static gboolean
 _thunar_io_jobs_ls (ThunarJob  *job,
                     GArray     *param_values,
                     GError    **error)
 {
-  GError *err = NULL;
-  GFile  *directory;
-  GList  *file_list = NULL;
+  ThunarApplication *application;
+  ThunarIoScheduler *scheduler;
+  ThunarIoTicket    *ticket;
+  GError            *err = NULL;
+  GFile             *directory;
+  gboolean           partial_info;
+  gboolean           succeed;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1292,35 +1412,27 @@ _thunar_io_jobs_ls (ThunarJob  *job,
   /* make sure the object is valid */
   _thunar_assert (G_IS_FILE (directory));
 
-  /* collect directory contents (non-recursively) */
-  file_list = thunar_io_scan_directory (job, directory,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        FALSE, FALSE, TRUE, NULL, &err);
+  partial_info = _thunar_io_jobs_ls_partial_info (directory);
 
-  /* abort on errors or cancellation */
-  if (err != NULL)
-    {
-      g_propagate_error (error, err);
-      return FALSE;
-    }
-  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+  /* the user waits for this folder, the background jobs on its device hold still
+   * and the other listings on a remote location wait for their turn */
+  application = thunar_application_get ();
+  scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+  ticket = thunar_io_scheduler_acquire_listing (scheduler, directory, TRUE, exo_job_get_cancellable (EXO_JOB (job)));
+
+  /* report the directory contents (non-recursively) in batches */
+  succeed = thunar_io_scan_directory_report (job, directory, G_FILE_QUERY_INFO_NONE, partial_info, &err);
+
+  thunar_io_ticket_release (ticket);
+  g_object_unref (scheduler);
+
+  if (!succeed)
     {
       g_propagate_error (error, err);
       return FALSE;
     }
 
-  /* check if we have any files to report */
-  if (G_LIKELY (file_list != NULL))
-    {
-      /* emit the "files-ready" signal */
-      if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
-        {
-          /* none of the handlers took over the file list, so it's up to us
-           * to destroy it */
-          thunar_g_list_free_full (file_list);
-        }
-    }
-
   /* there should be no errors here */
   _thunar_assert (err == NULL);
 
@@ -1339,164 +1451,1186 @@ _thunar_io_jobs_ls (ThunarJob  *job,
 ThunarJob *
 thunar_io_jobs_list_directory (GFile *directory)
 {
+  ThunarJob *job;
+
   _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
 
-  return thunar_simple_job_new (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+  job = thunar_simple_job_new (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+
+  /* the user is waiting for the folder to show up */
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
 }
 
 
 
 static gboolean
-_thunar_io_jobs_rename_notify (gpointer user_data)
+_thunar_io_jobs_ls_page (ThunarJob  *job,
+                         GArray     *param_values,
+                         GError    **error)
 {
-  ThunarFile *file = user_data;
+  ThunarApplication *application;
+  ThunarIoScheduler *scheduler;
+  ThunarIoTicket    *ticket;
+  GFileEnumerator   *enumerator;
+  GFile             *directory;
+  gboolean           succeed;
+  guint              n_files;
 
-  /* tell the associated folder that the file was renamed */
-  thunarx_file_info_renamed (THUNARX_FILE_INFO (file));
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 3, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  /* emit the file changed signal */
-  thunar_file_changed (file);
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
 
-  return FALSE;
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  enumerator = g_value_dup_object (&g_array_index (param_values, GValue, 1));
+  n_files = g_value_get_uint (&g_array_index (param_values, GValue, 2));
+
+  /* make sure the object is valid */
+  _thunar_assert (G_IS_FILE (directory));
+
+  application = thunar_application_get ();
+  scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+  ticket = thunar_io_scheduler_acquire_listing (scheduler, directory, TRUE, exo_job_get_cancellable (EXO_JOB (job)));
+
+  /* report the files of this page in batches */
+  succeed = thunar_io_scan_directory_report_page (job, directory, &enumerator,
+                                                  _thunar_io_jobs_ls_partial_info (directory),
+                                                  n_files, error);
+
+  thunar_io_ticket_release (ticket);
+  g_object_unref (scheduler);
+
+  /* keep the place for the next page */
+  if (enumerator != NULL)
+    g_object_set_data_full (G_OBJECT (job), "thunar-io-jobs-enumerator", enumerator, g_object_unref);
+
+  return succeed;
+}
+
+
+
+/**
+ * thunar_io_jobs_list_directory_page:
+ * @directory  : the folder to list.
+ * @enumerator : the enumerator of the previous page, or %NULL for the first page.
+ * @n_files    : the number of files in a page.
+ *
+ * Like thunar_io_jobs_list_directory(), but lists at most @n_files files
+ * of @directory. If there may be more files, the finished job has the
+ * enumerator for the next page, see thunar_io_jobs_list_directory_page_get_next().
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_list_directory_page (GFile           *directory,
+                                    GFileEnumerator *enumerator,
+                                    guint            n_files)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+  _thunar_return_val_if_fail (enumerator == NULL || G_IS_FILE_ENUMERATOR (enumerator), NULL);
+  _thunar_return_val_if_fail (n_files > 0, NULL);
+
+  job = thunar_simple_job_new (_thunar_io_jobs_ls_page, 3,
+                               G_TYPE_FILE, directory,
+                               G_TYPE_FILE_ENUMERATOR, enumerator,
+                               G_TYPE_UINT, n_files);
+
+  /* the user is waiting for the folder to show up */
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
+}
+
+
+
+/**
+ * thunar_io_jobs_list_directory_page_get_next:
+ * @job : a finished #ThunarJob of thunar_io_jobs_list_directory_page().
+ *
+ * The caller is responsible to free the returned object
+ * using g_object_unref() when no longer needed.
+ *
+ * Return value: the #GFileEnumerator for the next page,
+ *               or %NULL if the folder is listed completely.
+ **/
+GFileEnumerator *
+thunar_io_jobs_list_directory_page_get_next (ThunarJob *job)
+{
+  GFileEnumerator *enumerator;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+
+  enumerator = g_object_get_data (G_OBJECT (job), "thunar-io-jobs-enumerator");
+  return (enumerator != NULL) ? g_object_ref (enumerator) : NULL;
 }
 
 
 
 static gboolean
-_thunar_io_jobs_rename (ThunarJob  *job,
-                        GArray     *param_values,
-                        GError    **error)
+_thunar_io_jobs_ls_folders (ThunarJob  *job,
+                            GArray     *param_values,
+                            GError    **error)
 {
-  const gchar           *display_name;
-  ThunarFile            *file;
-  GError                *err = NULL;
-  gchar                 *old_file_uri;
-  ThunarOperationLogMode log_mode;
-  ThunarJobOperation     *operation;
+  ThunarApplication *application;
+  ThunarIoScheduler *scheduler;
+  ThunarIoTicket    *ticket;
+  GFile             *directory;
+  gboolean           succeed;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 3, FALSE);
-  _thunar_return_val_if_fail (G_VALUE_HOLDS (&g_array_index (param_values, GValue, 0), THUNAR_TYPE_FILE), FALSE);
-  _thunar_return_val_if_fail (G_VALUE_HOLDS_STRING (&g_array_index (param_values, GValue, 1)), FALSE);
-  _thunar_return_val_if_fail (G_VALUE_HOLDS_ENUM (&g_array_index (param_values, GValue, 2)), FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
+  /* determine the directory to list */
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
 
-  /* determine the file, display name and log mode */
-  file = g_value_get_object (&g_array_index (param_values, GValue, 0));
-  display_name = g_value_get_string (&g_array_index (param_values, GValue, 1));
-  log_mode = g_value_get_enum (&g_array_index (param_values, GValue, 2));
+  /* make sure the object is valid */
+  _thunar_assert (G_IS_FILE (directory));
 
-  old_file_uri = g_file_get_uri (thunar_file_get_file (file));
+  /* the sub folders for the side panes are listed after the views */
+  application = thunar_application_get ();
+  scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+  ticket = thunar_io_scheduler_acquire_listing (scheduler, directory, FALSE, exo_job_get_cancellable (EXO_JOB (job)));
 
-  /* try to rename the file */
-  if (thunar_file_rename (file, display_name, exo_job_get_cancellable (EXO_JOB (job)), TRUE, &err))
-    {
-      exo_job_send_to_mainloop (EXO_JOB (job),
-                                _thunar_io_jobs_rename_notify,
-                                g_object_ref (file), g_object_unref);
+  /* report the sub folders in batches */
+  succeed = thunar_io_scan_directory_report_folders (job, directory, error);
 
-      if (log_mode == THUNAR_OPERATION_LOG_OPERATIONS)
-        {
-          operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_RENAME);
-          thunar_job_operation_add (operation, g_file_new_for_uri (old_file_uri), thunar_file_get_file (file));
-          thunar_job_operation_history_commit (operation);
-          g_object_unref (operation);
-        }
-    }
+  thunar_io_ticket_release (ticket);
+  g_object_unref (scheduler);
 
-  g_free (old_file_uri);
+  return succeed;
+}
 
-  /* abort on errors or cancellation */
-  if (err != NULL)
+
+
+ThunarJob *
+thunar_io_jobs_list_folders (GFile *directory)
+{
+  ThunarJob *job;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+
+  job = thunar_simple_job_new (_thunar_io_jobs_ls_folders, 1, G_TYPE_FILE, directory);
+
+  /* the user is waiting for the folder to show up */
+  thunar_job_set_priority (job, THUNAR_JOB_PRIORITY_INTERACTIVE);
+
+  return job;
+}
+
+
+
+typedef struct
+{
+  GPtrArray *files;
+  GPtrArray *infos;
+}
+ThunarIoJobsInfoBatch;
+
+
+
+static void
+_thunar_io_jobs_load_info_batch_free (gpointer user_data)
+{
+  ThunarIoJobsInfoBatch *batch = user_data;
+
+  g_ptr_array_unref (batch->files);
+  g_ptr_array_unref (batch->infos);
+  g_slice_free (ThunarIoJobsInfoBatch, batch);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_load_info_apply (gpointer user_data)
+{
+  ThunarIoJobsInfoBatch *batch = user_data;
+  ThunarFile            *file;
+  guint                  n;
+
+  for (n = 0; n < batch->files->len; ++n)
     {
-      g_propagate_error (error, err);
-      return FALSE;
+      /* skip files which were released or reloaded in the meantime */
+      file = thunar_file_cache_lookup (g_ptr_array_index (batch->files, n));
+      if (file == NULL)
+        continue;
+
+      if (thunar_file_has_partial_info (file))
+        thunar_file_update_info (file, g_ptr_array_index (batch->infos, n));
+
+      g_object_unref (file);
     }
 
-  return TRUE;
+  return FALSE;
 }
 
 
 
-ThunarJob *
-thunar_io_jobs_rename_file (ThunarFile            *file,
-                            const gchar           *display_name,
-                            ThunarOperationLogMode log_mode)
+static void
+_thunar_io_jobs_load_info_flush (ThunarJob              *job,
+                                 ThunarIoJobsInfoBatch **batch)
 {
-  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
-  _thunar_return_val_if_fail (g_utf8_validate (display_name, -1, NULL), NULL);
+  if (*batch == NULL)
+    return;
 
-  return thunar_simple_job_new (_thunar_io_jobs_rename, 3,
-                                THUNAR_TYPE_FILE, file,
-                                G_TYPE_STRING, display_name,
-                                THUNAR_TYPE_OPERATION_LOG_MODE, log_mode);
+  /* the files are updated in the main thread */
+  exo_job_send_to_mainloop (EXO_JOB (job), _thunar_io_jobs_load_info_apply,
+                            *batch, _thunar_io_jobs_load_info_batch_free);
+  *batch = NULL;
 }
 
 
 
 static gboolean
-_thunar_io_jobs_count (ThunarJob *job,
-                       GArray    *param_values,
-                       GError   **error)
+_thunar_io_jobs_load_info (ThunarJob  *job,
+                           GArray     *param_values,
+                           GError    **error)
 {
-  GError          *err = NULL;
-  ThunarFile      *file;
-  GFileEnumerator *enumerator;
-  guint            count;
+  ThunarIoJobsInfoBatch *batch = NULL;
+  GCancellable          *cancellable;
+  GFileInfo             *info;
+  GList                 *file_list;
+  GList                 *lp;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
   _thunar_return_val_if_fail (param_values->len == 1, FALSE);
-  _thunar_return_val_if_fail (G_VALUE_HOLDS (&g_array_index (param_values, GValue, 0), THUNAR_TYPE_FILE), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  file = THUNAR_FILE (g_value_get_object (&g_array_index (param_values, GValue, 0)));
-
-  if (file == NULL)
-    return FALSE;
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
 
-  enumerator = g_file_enumerate_children (thunar_file_get_file (file), NULL,
-                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                          NULL, &err);
-  if (err != NULL)
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
     {
-      g_propagate_error (error, err);
-      return FALSE;
-    }
+      /* files which are gone are handled by the folder monitor */
+      info = g_file_query_info (lp->data, THUNARX_FILE_INFO_NAMESPACE,
+                                G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+      if (G_UNLIKELY (info == NULL))
+        continue;
 
-  count = 0;
-  for (GFileInfo *child_info = g_file_enumerator_next_file (enumerator, NULL, &err);
-       child_info != NULL;
-       child_info = g_file_enumerator_next_file (enumerator, NULL, &err))
-    {
-      if (err != NULL)
+      if (batch == NULL)
         {
-          g_propagate_error (error, err);
-          return FALSE;
+          batch = g_slice_new (ThunarIoJobsInfoBatch);
+          batch->files = g_ptr_array_new_with_free_func (g_object_unref);
+          batch->infos = g_ptr_array_new_with_free_func (g_object_unref);
         }
 
-      count++;
-      g_object_unref (child_info);
+      g_ptr_array_add (batch->files, g_object_ref (lp->data));
+      g_ptr_array_add (batch->infos, info);
+
+      if (batch->files->len >= THUNAR_IO_JOBS_LOAD_INFO_BATCH_SIZE)
+        _thunar_io_jobs_load_info_flush (job, &batch);
     }
 
-  thunar_file_set_file_count (file, count);
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      if (batch != NULL)
+        _thunar_io_jobs_load_info_batch_free (batch);
+      return FALSE;
+    }
 
-  g_object_unref (enumerator);
+  _thunar_io_jobs_load_info_flush (job, &batch);
 
   return TRUE;
 }
 
 
 
+/**
+ * thunar_io_jobs_load_info:
+ * @file_list : a list of #GFile<!---->s.
+ *
+ * Queries the complete %THUNARX_FILE_INFO_NAMESPACE for the files in
+ * @file_list, in the order of the list, and sets it on their #ThunarFile<!---->s
+ * that still have partial information (see thunar_file_has_partial_info()).
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
 ThunarJob *
-thunar_io_jobs_count_files (ThunarFile *file)
+thunar_io_jobs_load_info (GList *file_list)
 {
-  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+  return thunar_simple_job_new (_thunar_io_jobs_load_info, 1,
+                                THUNAR_TYPE_G_FILE_LIST, file_list);
+}
+
+
 
-  return thunar_simple_job_new (_thunar_io_jobs_count, 1,
-                                THUNAR_TYPE_FILE, file);
+static gboolean
+_thunar_io_jobs_reload_enumerate (ThunarJob  *job,
+                                  GList      *first,
+                                  guint       offset,
+                                  guint       n_files,
+                                  GFileInfo **infos)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *info;
+  GHashTable      *names;
+  GFile           *parent;
+  GList           *lp;
+  gpointer         index;
+  gchar           *name;
+  guint            n;
+
+  parent = g_file_get_parent (first->data);
+  if (G_UNLIKELY (parent == NULL))
+    return FALSE;
+
+  enumerator = g_file_enumerate_children (parent, THUNARX_FILE_INFO_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  g_object_unref (parent);
+  if (enumerator == NULL)
+    return FALSE;
+
+  /* look the siblings up by name, indices are stored plus one to tell them from NULL */
+  names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (lp = first, n = 0; n < n_files; lp = lp->next, n++)
+    {
+      name = g_file_get_basename (lp->data);
+      g_hash_table_insert (names, name, GUINT_TO_POINTER (offset + n + 1));
+    }
+
+  for (info = g_file_enumerator_next_file (enumerator, NULL, NULL);
+       info != NULL;
+       info = g_file_enumerator_next_file (enumerator, NULL, NULL))
+    {
+      index = g_hash_table_lookup (names, g_file_info_get_name (info));
+      if (index != NULL && infos[GPOINTER_TO_UINT (index) - 1] == NULL)
+        infos[GPOINTER_TO_UINT (index) - 1] = info;
+      else
+        g_object_unref (info);
+    }
+
+  g_hash_table_destroy (names);
+  g_object_unref (enumerator);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_reload (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  GCancellable  *cancellable;
+  GFileInfo    **infos;
+  GError       **errors;
+  GFile         *parent;
+  GFile         *other;
+  GList         *file_list;
+  GList         *first;
+  GList         *lp;
+  guint          n_files;
+  guint          offset;
+  guint          n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 3, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  infos = g_value_get_pointer (&g_array_index (param_values, GValue, 1));
+  errors = g_value_get_pointer (&g_array_index (param_values, GValue, 2));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  /* a single enumeration is cheaper than querying many siblings one by one */
+  for (first = file_list, offset = 0; first != NULL; first = lp, offset += n_files)
+    {
+      parent = g_file_get_parent (first->data);
+      for (lp = first->next, n_files = 1; lp != NULL; lp = lp->next, n_files++)
+        {
+          other = g_file_get_parent (lp->data);
+          if (parent == NULL || other == NULL || !g_file_equal (parent, other))
+            {
+              if (other != NULL)
+                g_object_unref (other);
+              break;
+            }
+          g_object_unref (other);
+        }
+      if (parent != NULL)
+        g_object_unref (parent);
+
+      if (n_files >= THUNAR_IO_JOBS_RELOAD_ENUMERATE_MIN && !exo_job_is_cancelled (EXO_JOB (job)))
+        _thunar_io_jobs_reload_enumerate (job, first, offset, n_files, infos);
+    }
+
+  /* the remaining files, which also reports the errors of vanished files */
+  for (lp = file_list, n = 0; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next, n++)
+    if (infos[n] == NULL)
+      infos[n] = g_file_query_info (lp->data, THUNARX_FILE_INFO_NAMESPACE,
+                                    G_FILE_QUERY_INFO_NONE, cancellable, &errors[n]);
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
+
+
+
+/**
+ * thunar_io_jobs_reload_files:
+ * @file_list : a list of #GFile<!---->s, with siblings next to each other.
+ * @infos     : an array with one %NULL element per file in @file_list.
+ * @errors    : an array with one %NULL element per file in @file_list.
+ *
+ * Queries the %THUNARX_FILE_INFO_NAMESPACE of the files in @file_list
+ * and stores the result for each file in @infos or, if that failed, in
+ * @errors. Runs of many sibling files are read with a single enumeration
+ * of their parent folder. The arrays are written from the job's thread,
+ * so the caller must keep them alive and must not read them before the
+ * job finished.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_reload_files (GList      *file_list,
+                             GFileInfo **infos,
+                             GError    **errors)
+{
+  _thunar_return_val_if_fail (file_list != NULL, NULL);
+  _thunar_return_val_if_fail (infos != NULL, NULL);
+  _thunar_return_val_if_fail (errors != NULL, NULL);
+
+  return thunar_simple_job_new (_thunar_io_jobs_reload, 3,
+                                THUNAR_TYPE_G_FILE_LIST, file_list,
+                                G_TYPE_POINTER, infos,
+                                G_TYPE_POINTER, errors);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_get_files (ThunarJob  *job,
+                           GArray     *param_values,
+                           GError    **error)
+{
+  GCancellable *cancellable;
+  ThunarFile   *file;
+  GFileInfo    *info;
+  GList        *file_list;
+  GList        *ready;
+  GList        *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL && param_values->len == 1, FALSE);
+
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      /* query outside of the file cache lock, unlike thunar_file_get() */
+      info = g_file_query_info (lp->data, THUNARX_FILE_INFO_NAMESPACE,
+                                G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+      if (info == NULL)
+        continue;
+
+      file = thunar_file_get_with_info (lp->data, info, NULL, FALSE);
+      g_object_unref (info);
+      if (G_UNLIKELY (file == NULL))
+        continue;
+
+      /* each file is handed over as soon as it is known */
+      ready = g_list_prepend (NULL, file);
+      if (!thunar_job_files_ready (job, ready))
+        thunar_g_list_free_full (ready);
+    }
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
+
+
+
+/**
+ * thunar_io_jobs_get_files:
+ * @file_list : a list of #GFile<!---->s.
+ *
+ * Looks up the #ThunarFile<!---->s for the files in @file_list, in the
+ * order of the list, and emits "files-ready" with each one as soon as
+ * its information was queried. Files that can't be queried are left
+ * out. Unlike thunar_file_get(), the file cache is not locked while a
+ * slow remote location is queried.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_get_files (GList *file_list)
+{
+  return thunar_simple_job_new (_thunar_io_jobs_get_files, 1,
+                                THUNAR_TYPE_G_FILE_LIST, file_list);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_content_types_apply (gpointer user_data)
+{
+  ThunarIoJobsInfoBatch *batch = user_data;
+  ThunarFile            *file;
+  const gchar           *content_type;
+  guint                  n;
+
+  for (n = 0; n < batch->files->len; ++n)
+    {
+      /* skip files which were released in the meantime */
+      file = thunar_file_cache_lookup (g_ptr_array_index (batch->files, n));
+      if (file == NULL)
+        continue;
+
+      content_type = g_file_info_get_attribute_string (g_ptr_array_index (batch->infos, n),
+                                                       G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+      if (G_UNLIKELY (content_type == NULL))
+        content_type = g_file_info_get_attribute_string (g_ptr_array_index (batch->infos, n),
+                                                         G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+
+      /* files whose content type was determined in the meantime keep it,
+       * for the others nothing was derived from the type yet */
+      if (G_LIKELY (content_type != NULL))
+        thunar_file_set_content_type (file, content_type);
+
+      g_object_unref (file);
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_content_types (ThunarJob  *job,
+                               GArray     *param_values,
+                               GError    **error)
+{
+  ThunarIoJobsInfoBatch *batch = NULL;
+  GCancellable          *cancellable;
+  GFileInfo             *info;
+  GList                 *file_list;
+  GList                 *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      /* files that fail here are left to thunar_file_get_content_type() */
+      info = g_file_query_info (lp->data,
+                                G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE ","
+                                G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE,
+                                G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+      if (G_UNLIKELY (info == NULL))
+        continue;
+
+      if (batch == NULL)
+        {
+          batch = g_slice_new (ThunarIoJobsInfoBatch);
+          batch->files = g_ptr_array_new_with_free_func (g_object_unref);
+          batch->infos = g_ptr_array_new_with_free_func (g_object_unref);
+        }
+
+      g_ptr_array_add (batch->files, g_object_ref (lp->data));
+      g_ptr_array_add (batch->infos, info);
+
+      if (batch->files->len >= THUNAR_IO_JOBS_CONTENT_TYPE_BATCH_SIZE)
+        {
+          exo_job_send_to_mainloop (EXO_JOB (job), _thunar_io_jobs_content_types_apply,
+                                    batch, _thunar_io_jobs_load_info_batch_free);
+          batch = NULL;
+        }
+    }
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      if (batch != NULL)
+        _thunar_io_jobs_load_info_batch_free (batch);
+      return FALSE;
+    }
+
+  if (batch != NULL)
+    exo_job_send_to_mainloop (EXO_JOB (job), _thunar_io_jobs_content_types_apply,
+                              batch, _thunar_io_jobs_load_info_batch_free);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_jobs_content_types:
+ * @file_list : a list of #GFile<!---->s.
+ *
+ * Determines the content types of the files in @file_list, in the order
+ * of the list, and sets them on their #ThunarFile<!---->s that have no
+ * content type yet. The files must not be symbolic links.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_content_types (GList *file_list)
+{
+  return thunar_simple_job_new (_thunar_io_jobs_content_types, 1,
+                                THUNAR_TYPE_G_FILE_LIST, file_list);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_rename_notify (gpointer user_data)
+{
+  ThunarFile *file = user_data;
+
+  /* tell the associated folder that the file was renamed */
+  thunarx_file_info_renamed (THUNARX_FILE_INFO (file));
+
+  /* emit the file changed signal */
+  thunar_file_changed (file);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_rename (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  const gchar           *display_name;
+  ThunarFile            *file;
+  GError                *err = NULL;
+  gchar                 *old_file_uri;
+  ThunarOperationLogMode log_mode;
+  ThunarJobOperation     *operation;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 3, FALSE);
+  _thunar_return_val_if_fail (G_VALUE_HOLDS (&g_array_index (param_values, GValue, 0), THUNAR_TYPE_FILE), FALSE);
+  _thunar_return_val_if_fail (G_VALUE_HOLDS_STRING (&g_array_index (param_values, GValue, 1)), FALSE);
+  _thunar_return_val_if_fail (G_VALUE_HOLDS_ENUM (&g_array_index (param_values, GValue, 2)), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  /* determine the file, display name and log mode */
+  file = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  display_name = g_value_get_string (&g_array_index (param_values, GValue, 1));
+  log_mode = g_value_get_enum (&g_array_index (param_values, GValue, 2));
+
+  old_file_uri = g_file_get_uri (thunar_file_get_file (file));
+
+  /* try to rename the file */
+  if (thunar_file_rename (file, display_name, exo_job_get_cancellable (EXO_JOB (job)), TRUE, &err))
+    {
+      exo_job_send_to_mainloop (EXO_JOB (job),
+                                _thunar_io_jobs_rename_notify,
+                                g_object_ref (file), g_object_unref);
+
+      if (log_mode == THUNAR_OPERATION_LOG_OPERATIONS)
+        {
+          operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_RENAME);
+          thunar_job_operation_add (operation, g_file_new_for_uri (old_file_uri), thunar_file_get_file (file));
+          thunar_job_operation_history_commit (operation);
+          g_object_unref (operation);
+        }
+    }
+
+  g_free (old_file_uri);
+
+  /* abort on errors or cancellation */
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_rename_file (ThunarFile            *file,
+                            const gchar           *display_name,
+                            ThunarOperationLogMode log_mode)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (g_utf8_validate (display_name, -1, NULL), NULL);
+
+  return thunar_simple_job_new (_thunar_io_jobs_rename, 3,
+                                THUNAR_TYPE_FILE, file,
+                                G_TYPE_STRING, display_name,
+                                THUNAR_TYPE_OPERATION_LOG_MODE, log_mode);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_rename_files_notify (gpointer user_data)
+{
+  GList *lp;
+
+  for (lp = user_data; lp != NULL; lp = lp->next)
+    _thunar_io_jobs_rename_notify (lp->data);
+
+  return FALSE;
+}
+
+
+
+static void
+_tij_rename_flush (ThunarJob  *job,
+                   GList     **renamed_files)
+{
+  if (*renamed_files == NULL)
+    return;
+
+  /* the folders and views are updated in the main thread */
+  exo_job_send_to_mainloop (EXO_JOB (job), _thunar_io_jobs_rename_files_notify,
+                            *renamed_files, (GDestroyNotify) thunar_g_list_free_full);
+  *renamed_files = NULL;
+}
+
+
+
+static gboolean
+_tij_rename_step (GFile         *from,
+                  GFile         *to,
+                  GCancellable  *cancellable,
+                  GList        **renamed_files,
+                  GError       **error)
+{
+  ThunarFile *file;
+  gboolean    succeed;
+  gchar      *display_name;
+
+  /* files known to the application are renamed through the ThunarFile,
+   * so the cache and the views follow the new location */
+  file = thunar_file_cache_lookup (from);
+  if (file != NULL)
+    {
+      display_name = thunar_g_file_get_display_name (to);
+      succeed = thunar_file_rename (file, display_name, cancellable, TRUE, error);
+      g_free (display_name);
+
+      if (succeed && renamed_files != NULL)
+        *renamed_files = g_list_prepend (*renamed_files, file);
+      else
+        g_object_unref (file);
+
+      return succeed;
+    }
+
+  /* everything else is a plain rename(2), refusing to overwrite anything */
+  return g_file_move (from, to, G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_NO_FALLBACK_FOR_MOVE,
+                      cancellable, NULL, NULL, error);
+}
+
+
+
+static gchar *
+_tij_rename_journal_dir (void)
+{
+  return xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_IO_JOBS_RENAME_JOURNAL_DIR, TRUE);
+}
+
+
+
+static void
+_tij_rename_recover (void)
+{
+  const gchar  *name;
+  gchar       **lines;
+  gchar       **uris;
+  gchar        *contents;
+  gchar        *filename;
+  gchar        *dirname;
+  GFile        *from;
+  GFile        *to;
+  GDir         *dir;
+  glong         pid;
+  gint          n;
+
+  dirname = _tij_rename_journal_dir ();
+  if (G_UNLIKELY (dirname == NULL))
+    return;
+
+  dir = g_dir_open (dirname, 0, NULL);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      g_free (dirname);
+      return;
+    }
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      /* journals are named <pid>-<serial>, skip those of running instances */
+      pid = strtol (name, NULL, 10);
+      if (pid <= 0 || pid == getpid () || kill ((pid_t) pid, 0) == 0 || errno != ESRCH)
+        continue;
+
+      filename = g_build_filename (dirname, name, NULL);
+      if (g_file_get_contents (filename, &contents, NULL, NULL))
+        {
+          /* undo the steps in reverse order, but only those that happened */
+          lines = g_strsplit (contents, "\n", -1);
+          for (n = g_strv_length (lines) - 1; n >= 0; --n)
+            {
+              uris = g_strsplit (lines[n], "\t", 2);
+              if (*lines[n] != '#' && g_strv_length (uris) == 2)
+                {
+                  from = g_file_new_for_uri (uris[0]);
+                  to = g_file_new_for_uri (uris[1]);
+                  if (g_file_query_exists (to, NULL) && !g_file_query_exists (from, NULL))
+                    _tij_rename_step (to, from, NULL, NULL, NULL);
+                  g_object_unref (from);
+                  g_object_unref (to);
+                }
+              g_strfreev (uris);
+            }
+          g_strfreev (lines);
+          g_free (contents);
+        }
+
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+  g_free (dirname);
+}
+
+
+
+static gchar *
+_tij_rename_journal_write (GPtrArray *steps_from,
+                           GPtrArray *steps_to,
+                           GError   **error)
+{
+  static gint  serial = 0;
+  GString     *journal;
+  gchar       *filename;
+  gchar       *dirname;
+  gchar       *name;
+  gchar       *uri;
+  guint        n;
+
+  dirname = _tij_rename_journal_dir ();
+  if (G_UNLIKELY (dirname == NULL))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED, _("Failed to create the rename journal"));
+      return NULL;
+    }
+
+  /* one "from\tto" line per step, in execution order */
+  journal = g_string_sized_new (steps_from->len * 128);
+  g_string_append (journal, "# thunar rename journal\n");
+  for (n = 0; n < steps_from->len; ++n)
+    {
+      uri = g_file_get_uri (g_ptr_array_index (steps_from, n));
+      g_string_append (journal, uri);
+      g_string_append_c (journal, '\t');
+      g_free (uri);
+
+      uri = g_file_get_uri (g_ptr_array_index (steps_to, n));
+      g_string_append (journal, uri);
+      g_string_append_c (journal, '\n');
+      g_free (uri);
+    }
+
+  name = g_strdup_printf ("%ld-%d", (glong) getpid (), g_atomic_int_add (&serial, 1));
+  filename = g_build_filename (dirname, name, NULL);
+  g_free (dirname);
+  g_free (name);
+
+  /* the journal must be on disk before the first rename happens */
+  if (!g_file_set_contents_full (filename, journal->str, journal->len,
+                                 G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_DURABLE,
+                                 0600, error))
+    {
+      g_free (filename);
+      filename = NULL;
+    }
+
+  g_string_free (journal, TRUE);
+
+  return filename;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_rename_files (ThunarJob  *job,
+                              GArray     *param_values,
+                              GError    **error)
+{
+  ThunarOperationLogMode log_mode;
+  ThunarJobOperation    *operation;
+  GCancellable          *cancellable;
+  GHashTable            *sources;
+  GPtrArray             *steps_from;
+  GPtrArray             *steps_to;
+  GPtrArray             *temps;
+  GList                 *source_file_list;
+  GList                 *target_file_list;
+  GList                 *renamed_files = NULL;
+  GList                 *sp, *tp;
+  GError                *err = NULL;
+  GFile                 *parent;
+  GFile                 *temp;
+  gchar                 *journal;
+  gchar                 *name;
+  guint                  n_steps;
+  guint                  n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 3, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  source_file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  target_file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 1));
+  log_mode = g_value_get_enum (&g_array_index (param_values, GValue, 2));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  /* roll back batches that were interrupted by a crash */
+  _tij_rename_recover ();
+
+  /* remember which locations are vacated by the batch */
+  sources = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  for (sp = source_file_list; sp != NULL; sp = sp->next)
+    g_hash_table_add (sources, sp->data);
+
+  /* a file whose new name is still taken by another file of the batch
+   * (a->b, b->a) first moves to a temporary name in its folder, then
+   * all other files are renamed and finally the temporary ones */
+  steps_from = g_ptr_array_new ();
+  steps_to = g_ptr_array_new ();
+  temps = g_ptr_array_new_with_free_func (g_object_unref);
+  for (sp = source_file_list, tp = target_file_list; sp != NULL && tp != NULL; sp = sp->next, tp = tp->next)
+    {
+      if (g_file_equal (sp->data, tp->data) || !g_hash_table_contains (sources, tp->data))
+        continue;
+
+      parent = g_file_get_parent (sp->data);
+      name = g_strdup_printf (".thunar-rename-%ld-%u", (glong) getpid (), temps->len);
+      temp = g_file_get_child (parent, name);
+      g_object_unref (parent);
+      g_free (name);
+
+      g_ptr_array_add (steps_from, sp->data);
+      g_ptr_array_add (steps_to, temp);
+      g_ptr_array_add (temps, temp);
+    }
+  for (sp = source_file_list, tp = target_file_list; sp != NULL && tp != NULL; sp = sp->next, tp = tp->next)
+    {
+      if (g_file_equal (sp->data, tp->data) || g_hash_table_contains (sources, tp->data))
+        continue;
+
+      g_ptr_array_add (steps_from, sp->data);
+      g_ptr_array_add (steps_to, tp->data);
+    }
+  for (sp = source_file_list, tp = target_file_list, n = 0; sp != NULL && tp != NULL; sp = sp->next, tp = tp->next)
+    {
+      if (g_file_equal (sp->data, tp->data) || !g_hash_table_contains (sources, tp->data))
+        continue;
+
+      g_ptr_array_add (steps_from, g_ptr_array_index (temps, n++));
+      g_ptr_array_add (steps_to, tp->data);
+    }
+  g_hash_table_destroy (sources);
+
+  /* write the journal, so a crash can be rolled back */
+  journal = _tij_rename_journal_write (steps_from, steps_to, &err);
+
+  /* perform the renames */
+  for (n_steps = 0; err == NULL && n_steps < steps_from->len; ++n_steps)
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+        break;
+
+      if (!_tij_rename_step (g_ptr_array_index (steps_from, n_steps), g_ptr_array_index (steps_to, n_steps),
+                             cancellable, &renamed_files, &err))
+        break;
+
+      /* update the views and the progress every now and then */
+      if (((n_steps + 1) % THUNAR_IO_JOBS_RENAME_BATCH_SIZE) == 0)
+        {
+          _tij_rename_flush (job, &renamed_files);
+          exo_job_percent (EXO_JOB (job), ((n_steps + 1) * 100.0) / steps_from->len);
+        }
+    }
+
+  /* undo what was done so far if the batch failed, it is all or nothing */
+  if (G_UNLIKELY (err != NULL))
+    {
+      while (n_steps-- > 0)
+        _tij_rename_step (g_ptr_array_index (steps_to, n_steps), g_ptr_array_index (steps_from, n_steps),
+                          NULL, &renamed_files, NULL);
+    }
+  else if (log_mode == THUNAR_OPERATION_LOG_OPERATIONS && steps_from->len > 0)
+    {
+      /* register the whole batch as a single operation for undo */
+      operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_RENAME);
+      thunar_job_operation_add_files (operation, source_file_list, target_file_list);
+      thunar_job_operation_history_commit (operation);
+      g_object_unref (operation);
+    }
+
+  _tij_rename_flush (job, &renamed_files);
+
+  /* the batch is complete (or rolled back), drop the journal */
+  if (G_LIKELY (journal != NULL))
+    {
+      g_unlink (journal);
+      g_free (journal);
+    }
+
+  g_ptr_array_free (steps_from, TRUE);
+  g_ptr_array_free (steps_to, TRUE);
+  g_ptr_array_free (temps, TRUE);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_jobs_rename_files:
+ * @source_file_list : the #GFile<!---->s to rename.
+ * @target_file_list : the new location for each file in @source_file_list,
+ *                     in the same folder.
+ * @log_mode         : whether to register the batch for undo.
+ *
+ * Renames all files in a single job. Files may swap names or take over
+ * the name of another file in the batch. The steps are written to a
+ * journal first, and the batch is rolled back as a whole if any rename
+ * fails or the job is cancelled.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_rename_files (GList                 *source_file_list,
+                             GList                 *target_file_list,
+                             ThunarOperationLogMode log_mode)
+{
+  _thunar_return_val_if_fail (g_list_length (source_file_list) == g_list_length (target_file_list), NULL);
+
+  return thunar_simple_job_new (_thunar_io_jobs_rename_files, 3,
+                                THUNAR_TYPE_G_FILE_LIST, source_file_list,
+                                THUNAR_TYPE_G_FILE_LIST, target_file_list,
+                                THUNAR_TYPE_OPERATION_LOG_MODE, log_mode);
+}
+
+
+
+static gboolean
+_thunar_io_jobs_count (ThunarJob *job,
+                       GArray    *param_values,
+                       GError   **error)
+{
+  GError          *err = NULL;
+  GFileEnumerator *enumerator;
+  GFileInfo       *child_info;
+  GList           *file_list;
+  GList           *lp;
+  guint           *counts;
+  guint            count;
+  guint            n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
+  _thunar_return_val_if_fail (G_VALUE_HOLDS (&g_array_index (param_values, GValue, 0), THUNAR_TYPE_G_FILE_LIST), FALSE);
+  _thunar_return_val_if_fail (G_VALUE_HOLDS_POINTER (&g_array_index (param_values, GValue, 1)), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  counts = g_value_get_pointer (&g_array_index (param_values, GValue, 1));
+
+  /* a folder which cannot be read is marked and does not stop the others */
+  for (lp = file_list, n = 0; lp != NULL; lp = lp->next, n++)
+    {
+      counts[n] = G_MAXUINT;
+
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        continue;
+
+      /* the names are all we need to count the children */
+      enumerator = g_file_enumerate_children (lp->data, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                              exo_job_get_cancellable (EXO_JOB (job)), NULL);
+      if (enumerator == NULL)
+        continue;
+
+      count = 0;
+      for (child_info = g_file_enumerator_next_file (enumerator, NULL, &err);
+           child_info != NULL;
+           child_info = g_file_enumerator_next_file (enumerator, NULL, &err))
+        {
+          count++;
+          g_object_unref (child_info);
+        }
+
+      if (err == NULL)
+        counts[n] = count;
+      else
+        g_clear_error (&err);
+
+      g_object_unref (enumerator);
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_jobs_count_files:
+ * @file_list : a list of #GFile<!---->s of folders.
+ * @counts    : an array with one element per folder in @file_list.
+ *
+ * Counts the items in each folder of @file_list and stores the results
+ * in @counts, using %G_MAXUINT for folders which could not be read.
+ * The @counts are written from the job's thread, so the caller must
+ * keep them alive and must not read them before the job finished.
+ *
+ * Return value: the newly allocated #ThunarJob.
+ **/
+ThunarJob *
+thunar_io_jobs_count_files (GList *file_list,
+                            guint *counts)
+{
+  _thunar_return_val_if_fail (file_list != NULL, NULL);
+  _thunar_return_val_if_fail (counts != NULL, NULL);
+
+  return thunar_simple_job_new (_thunar_io_jobs_count, 2,
+                                THUNAR_TYPE_G_FILE_LIST, file_list,
+                                G_TYPE_POINTER, counts);
 }
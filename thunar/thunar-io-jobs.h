@@ -49,10 +49,25 @@ ThunarJob *thunar_io_jobs_change_mode      (GList                 *files,
                                             ThunarFileMode         file_mode,
                                             gboolean               recursive) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *thunar_io_jobs_list_directory   (GFile                 *directory) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_list_directory_page (GFile                 *directory,
+                                               GFileEnumerator       *enumerator,
+                                               guint                  n_files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+GFileEnumerator *thunar_io_jobs_list_directory_page_get_next (ThunarJob *job);
+ThunarJob *thunar_io_jobs_list_folders     (GFile                 *directory) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_load_info        (GList                 *file_list) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_content_types    (GList                 *file_list) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_reload_files     (GList                 *file_list,
+                                            GFileInfo            **infos,
+                                            GError               **errors) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_get_files        (GList                 *file_list) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *thunar_io_jobs_rename_file      (ThunarFile            *file,
                                             const gchar           *display_name,
                                             ThunarOperationLogMode log_mode) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
-ThunarJob *thunar_io_jobs_count_files      (ThunarFile            *file);
+ThunarJob *thunar_io_jobs_rename_files     (GList                 *source_file_list,
+                                            GList                 *target_file_list,
+                                            ThunarOperationLogMode log_mode) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_count_files      (GList                 *file_list,
+                                            guint                 *counts) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
 
@@ -22,6 +22,25 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
 
 #include <exo/exo.h>
@@ -32,6 +51,135 @@
 #include <thunar/thunar-io-scan-directory.h>
 
 
+/* number of #ThunarFile<!---->s which are set up (and reported) at once */
+#define THUNAR_IO_SCAN_DIRECTORY_BATCH_SIZE 256
+
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (HAVE_DIRENT_H)
+#define THUNAR_IO_SCAN_LOCAL 1
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+
+
+typedef struct
+{
+  GPtrArray *files;
+  GPtrArray *infos;
+  GPtrArray *recent_infos;
+  GArray    *not_mounted;
+  GArray    *partial_infos;
+
+  /* the batch lists a folder, see thunar_file_get_with_info_batch() */
+  gboolean   listing;
+}
+ThunarIoScanBatch;
+
+
+
+static void
+thunar_io_scan_batch_init (ThunarIoScanBatch *batch,
+                           gboolean           listing)
+{
+  batch->files = g_ptr_array_new_with_free_func (g_object_unref);
+  batch->infos = g_ptr_array_new_with_free_func (g_object_unref);
+  batch->recent_infos = g_ptr_array_new ();
+  batch->not_mounted = g_array_new (FALSE, FALSE, sizeof (gboolean));
+  batch->partial_infos = g_array_new (FALSE, FALSE, sizeof (gboolean));
+  batch->listing = listing;
+}
+
+
+
+static void
+thunar_io_scan_batch_add (ThunarIoScanBatch *batch,
+                          GFile             *file,
+                          GFileInfo         *info,
+                          GFileInfo         *recent_info,
+                          gboolean           not_mounted,
+                          gboolean           partial_info)
+{
+  g_ptr_array_add (batch->files, g_object_ref (file));
+  g_ptr_array_add (batch->infos, g_object_ref (info));
+  g_ptr_array_add (batch->recent_infos, recent_info != NULL ? g_object_ref (recent_info) : NULL);
+  g_array_append_val (batch->not_mounted, not_mounted);
+  g_array_append_val (batch->partial_infos, partial_info);
+}
+
+
+
+static GList *
+thunar_io_scan_batch_flush (ThunarIoScanBatch *batch)
+{
+  GList *files;
+  guint  n;
+
+  if (batch->files->len == 0)
+    return NULL;
+
+  files = thunar_file_get_with_info_batch ((GFile **) batch->files->pdata,
+                                           (GFileInfo **) batch->infos->pdata,
+                                           (GFileInfo **) batch->recent_infos->pdata,
+                                           (const gboolean *) batch->not_mounted->data,
+                                           (const gboolean *) batch->partial_infos->data,
+                                           batch->files->len,
+                                           batch->listing);
+
+  for (n = 0; n < batch->recent_infos->len; ++n)
+    if (batch->recent_infos->pdata[n] != NULL)
+      g_object_unref (batch->recent_infos->pdata[n]);
+
+  g_ptr_array_set_size (batch->files, 0);
+  g_ptr_array_set_size (batch->infos, 0);
+  g_ptr_array_set_size (batch->recent_infos, 0);
+  g_array_set_size (batch->not_mounted, 0);
+  g_array_set_size (batch->partial_infos, 0);
+
+  return files;
+}
+
+
+
+/* prepends the files of the batch to @files like single files are
+ * prepended, i.e. the last scanned file comes first */
+static GList *
+thunar_io_scan_batch_prepend (ThunarIoScanBatch *batch,
+                              GList             *files)
+{
+  return g_list_concat (g_list_reverse (thunar_io_scan_batch_flush (batch)), files);
+}
+
+
+
+static void
+thunar_io_scan_batch_clear (ThunarIoScanBatch *batch)
+{
+  thunar_g_list_free_full (thunar_io_scan_batch_flush (batch));
+  g_ptr_array_unref (batch->files);
+  g_ptr_array_unref (batch->infos);
+  g_ptr_array_unref (batch->recent_infos);
+  g_array_unref (batch->not_mounted);
+  g_array_unref (batch->partial_infos);
+}
+
+
+
+static GList *
+thunar_io_scan_directory_real (ThunarJob          *job,
+                               GFile              *file,
+                               GFileQueryInfoFlags flags,
+                               gboolean            recursively,
+                               gboolean            unlinking,
+                               gboolean            return_thunar_files,
+                               gboolean            report_files,
+                               gboolean            partial_info,
+                               guint              *n_files_max,
+                               GError            **error);
+
+
+
 /**
  * thunar_io_scan_directory:
  * @job                 : a #ThunarJob instance
@@ -57,6 +205,182 @@ thunar_io_scan_directory (ThunarJob          *job,
                           guint              *n_files_max,
                           GError            **error)
 {
+  return thunar_io_scan_directory_real (job, file, flags, recursively, unlinking,
+                                        return_thunar_files, FALSE, FALSE, n_files_max, error);
+}
+
+
+
+/**
+ * thunar_io_scan_directory_report:
+ * @job          : a #ThunarJob instance
+ * @file         : The folder to scan
+ * @flags        : @GFileQueryInfoFlags to consider during scan
+ * @partial_info : TRUE to only query %THUNAR_FILE_INFO_FAST_NAMESPACE
+ * @error        : Will be set on any error
+ *
+ * Scans the passed folder (non-recursively) and reports the #ThunarFile<!---->s
+ * in batches using thunar_job_files_ready() while the scan is running,
+ * so consumers can show the first files before the folder is fully read.
+ *
+ * With @partial_info, new files are marked using thunar_file_has_partial_info()
+ * and the remaining attributes have to be loaded later on.
+ *
+ * Return value: %TRUE on success, %FALSE if @error is set.
+ **/
+gboolean
+thunar_io_scan_directory_report (ThunarJob          *job,
+                                 GFile              *file,
+                                 GFileQueryInfoFlags flags,
+                                 gboolean            partial_info,
+                                 GError            **error)
+{
+  GError *err = NULL;
+  GList  *files;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+
+  files = thunar_io_scan_directory_real (job, file, flags, FALSE, FALSE,
+                                         TRUE, TRUE, partial_info, NULL, &err);
+
+  /* all files were reported already */
+  _thunar_assert (files == NULL);
+
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_io_scan_directory_report_files (ThunarJob *job,
+                                       GList     *files)
+{
+  if (files != NULL && !thunar_job_files_ready (job, files))
+    {
+      /* none of the handlers took over the file list, so it's
+       * up to us to destroy it */
+      thunar_g_list_free_full (files);
+    }
+}
+
+
+
+/**
+ * thunar_io_scan_directory_report_page:
+ * @job          : a #ThunarJob instance
+ * @file         : The folder to scan
+ * @enumerator   : the #GFileEnumerator of the previous page of @file, or
+ *                 a location holding %NULL for the first page.
+ * @partial_info : TRUE to only query %THUNAR_FILE_INFO_FAST_NAMESPACE
+ * @n_files      : the number of files in a page.
+ * @error        : Will be set on any error
+ *
+ * Like thunar_io_scan_directory_report(), but stops after @n_files files.
+ * If the folder may have more files, @enumerator is set to the enumerator
+ * which lists the next page, else it is released and set to %NULL.
+ *
+ * Return value: %TRUE on success, %FALSE if @error is set.
+ **/
+gboolean
+thunar_io_scan_directory_report_page (ThunarJob        *job,
+                                      GFile            *file,
+                                      GFileEnumerator **enumerator,
+                                      gboolean          partial_info,
+                                      guint             n_files,
+                                      GError          **error)
+{
+  ThunarIoScanBatch batch;
+  GCancellable     *cancellable;
+  GFileInfo        *info;
+  GFile            *child_file;
+  GError           *err = NULL;
+  gboolean          at_end = FALSE;
+  guint             n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (enumerator != NULL, FALSE);
+  _thunar_return_val_if_fail (n_files > 0, FALSE);
+
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  if (*enumerator == NULL)
+    {
+      *enumerator = g_file_enumerate_children (file,
+                                               partial_info ? THUNAR_FILE_INFO_FAST_NAMESPACE : THUNARX_FILE_INFO_NAMESPACE,
+                                               G_FILE_QUERY_INFO_NONE, cancellable, error);
+      if (*enumerator == NULL)
+        return FALSE;
+    }
+
+  thunar_io_scan_batch_init (&batch, TRUE);
+
+  for (n = 0; n < n_files && !exo_job_is_cancelled (EXO_JOB (job)); )
+    {
+      info = g_file_enumerator_next_file (*enumerator, cancellable, &err);
+      if (info == NULL)
+        {
+          /* ignore IO errors of single files, like the complete listing */
+          if (err != NULL && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_FAILED))
+            {
+              g_clear_error (&err);
+              continue;
+            }
+
+          at_end = (err == NULL);
+          break;
+        }
+
+      child_file = g_file_get_child (file, g_file_info_get_name (info));
+      thunar_io_scan_batch_add (&batch, child_file, info, NULL, FALSE, partial_info);
+      g_object_unref (child_file);
+      g_object_unref (info);
+
+      if (batch.files->len >= THUNAR_IO_SCAN_DIRECTORY_BATCH_SIZE)
+        thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+
+      ++n;
+    }
+
+  /* handle the remaining files of the batch */
+  if (err == NULL)
+    thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+  thunar_io_scan_batch_clear (&batch);
+
+  /* no next page */
+  if (at_end || err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
+    g_clear_object (enumerator);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
+
+
+
+static GList *
+thunar_io_scan_directory_real (ThunarJob          *job,
+                               GFile              *file,
+                               GFileQueryInfoFlags flags,
+                               gboolean            recursively,
+                               gboolean            unlinking,
+                               gboolean            return_thunar_files,
+                               gboolean            report_files,
+                               gboolean            partial_info,
+                               guint              *n_files_max,
+                               GError            **error)
+{
+  ThunarIoScanBatch batch;
   GFileEnumerator *enumerator;
   GFileInfo       *info;
   GFileInfo       *recent_info;
@@ -66,8 +390,9 @@ thunar_io_scan_directory (ThunarJob          *job,
   GList           *child_files = NULL;
   GList           *files = NULL;
   const gchar     *namespace;
-  ThunarFile      *thunar_file;
+  const gchar     *target_uri;
   gboolean         is_mounted;
+  gboolean         is_partial;
   GCancellable    *cancellable = NULL;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
@@ -104,7 +429,9 @@ thunar_io_scan_directory (ThunarJob          *job,
     return NULL;
 
   /* determine the namespace */
-  if (return_thunar_files)
+  if (return_thunar_files && partial_info)
+    namespace = THUNAR_FILE_INFO_FAST_NAMESPACE;
+  else if (return_thunar_files)
     namespace = THUNARX_FILE_INFO_NAMESPACE;
   else
     namespace = G_FILE_ATTRIBUTE_STANDARD_TYPE ","
@@ -121,6 +448,8 @@ thunar_io_scan_directory (ThunarJob          *job,
       return NULL;
     }
 
+  thunar_io_scan_batch_init (&batch, report_files);
+
   /* iterate over children one by one */
   while (job == NULL || !exo_job_is_cancelled (EXO_JOB (job)))
     {
@@ -169,20 +498,41 @@ thunar_io_scan_directory (ThunarJob          *job,
             }
         }
 
+      is_partial = partial_info;
+
       /* check if we are scanning `recent:///` */
       if (g_file_has_uri_scheme (file, "recent"))
         {
-          /* create Gfile using the target URI */
-          child_file = g_file_new_for_uri (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI));
+          target_uri = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+          if (G_UNLIKELY (target_uri == NULL))
+            {
+              g_object_unref (info);
+              continue;
+            }
 
-          /* create new file info using Gfile*/
+          /* create Gfile using the target URI */
+          child_file = g_file_new_for_uri (target_uri);
           recent_info = info;
-          info = g_file_query_info (child_file, namespace, flags, cancellable, &err);
 
-          if (G_UNLIKELY (info == NULL))
+          if (return_thunar_files && !g_file_is_native (child_file))
+            {
+              /* remote targets may be slow or unreachable, so they start out
+               * with what the recent list knows and are completed later on */
+              info = g_object_ref (recent_info);
+              is_partial = TRUE;
+            }
+          else
             {
-              g_object_unref (recent_info);
-              break;
+              /* create new file info using Gfile*/
+              info = g_file_query_info (child_file, namespace, flags, cancellable, NULL);
+
+              /* skip targets which are gone, instead of the rest of the list */
+              if (G_UNLIKELY (info == NULL))
+                {
+                  g_object_unref (child_file);
+                  g_object_unref (recent_info);
+                  continue;
+                }
             }
         }
       else
@@ -194,10 +544,15 @@ thunar_io_scan_directory (ThunarJob          *job,
 
       if (return_thunar_files)
         {
-          /* Prepend the ThunarFile */
-          thunar_file = thunar_file_get_with_info (child_file, info, recent_info, !is_mounted);
-          files = thunar_g_list_prepend_deep (files, thunar_file);
-          g_object_unref (G_OBJECT (thunar_file));
+          /* the ThunarFiles are set up in batches */
+          thunar_io_scan_batch_add (&batch, child_file, info, recent_info, !is_mounted, is_partial);
+          if (batch.files->len >= THUNAR_IO_SCAN_DIRECTORY_BATCH_SIZE)
+            {
+              if (report_files)
+                thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+              else
+                files = thunar_io_scan_batch_prepend (&batch, files);
+            }
         }
       else
         {
@@ -210,8 +565,13 @@ thunar_io_scan_directory (ThunarJob          *job,
           && is_mounted
           && g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
         {
-          child_files = thunar_io_scan_directory (job, child_file, flags, recursively,
-                                                  unlinking, return_thunar_files, n_files_max, &err);
+          /* the folder itself has to be in the list before its children */
+          if (return_thunar_files && !report_files)
+            files = thunar_io_scan_batch_prepend (&batch, files);
+
+          child_files = thunar_io_scan_directory_real (job, child_file, flags, recursively, unlinking,
+                                                       return_thunar_files, report_files, partial_info,
+                                                       n_files_max, &err);
 
           /* prepend children to the file list to make sure they're
            * processed first (required for unlinking) */
@@ -220,8 +580,17 @@ thunar_io_scan_directory (ThunarJob          *job,
 
       g_object_unref (child_file);
       g_object_unref (info);
+      if (recent_info != NULL)
+        g_object_unref (recent_info);
     }
 
+  /* handle the remaining files of the batch */
+  if (err == NULL && report_files)
+    thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+  else if (err == NULL)
+    files = thunar_io_scan_batch_prepend (&batch, files);
+  thunar_io_scan_batch_clear (&batch);
+
   /* release the enumerator */
   g_object_unref (enumerator);
 
@@ -240,3 +609,298 @@ thunar_io_scan_directory (ThunarJob          *job,
 
   return files;
 }
+
+
+
+static gboolean
+thunar_io_scan_directory_collect_folder (const ThunarIoScanLocalEntry *entry,
+                                         gpointer                      user_data)
+{
+  if (entry->type == G_FILE_TYPE_DIRECTORY)
+    g_ptr_array_add (user_data, g_strdup (entry->name));
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_scan_directory_report_folders:
+ * @job   : a #ThunarJob instance
+ * @file  : The folder to scan
+ * @error : Will be set on any error
+ *
+ * Like thunar_io_scan_directory_report(), but only the sub folders of
+ * @file are reported. Local folders are read with the entry types the
+ * file system keeps in the directory, so only the sub folders are queried
+ * and set up as #ThunarFile<!---->s, regardless of the number of other
+ * files in @file.
+ *
+ * Return value: %TRUE on success, %FALSE if @error is set.
+ **/
+gboolean
+thunar_io_scan_directory_report_folders (ThunarJob  *job,
+                                         GFile      *file,
+                                         GError    **error)
+{
+  ThunarIoScanBatch batch;
+  GFileEnumerator  *enumerator;
+  GCancellable     *cancellable;
+  GFileInfo        *info;
+  GPtrArray        *names;
+  GError           *err = NULL;
+  GFile            *child_file;
+  guint             n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  thunar_io_scan_batch_init (&batch, TRUE);
+
+  if (thunar_io_scan_local_supported (file))
+    {
+      /* collect the names of the folders, symlinks are only
+       * stat'ed to see if they point to a folder */
+      names = g_ptr_array_new_with_free_func (g_free);
+      if (thunar_io_scan_local_directory (file, THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS, cancellable,
+                                          thunar_io_scan_directory_collect_folder, names, &err))
+        {
+          for (n = 0; n < names->len && !exo_job_is_cancelled (EXO_JOB (job)); ++n)
+            {
+              child_file = g_file_get_child (file, g_ptr_array_index (names, n));
+
+              /* folders which vanished in the meantime are skipped */
+              info = g_file_query_info (child_file, THUNARX_FILE_INFO_NAMESPACE,
+                                        G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+              if (G_LIKELY (info != NULL))
+                {
+                  thunar_io_scan_batch_add (&batch, child_file, info, NULL, FALSE, FALSE);
+                  g_object_unref (info);
+                }
+              g_object_unref (child_file);
+
+              if (batch.files->len >= THUNAR_IO_SCAN_DIRECTORY_BATCH_SIZE)
+                thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+            }
+        }
+      g_ptr_array_unref (names);
+    }
+  else
+    {
+      /* remote locations send the infos along with the listing anyway,
+       * so only setting up the files is saved here */
+      enumerator = g_file_enumerate_children (file, THUNARX_FILE_INFO_NAMESPACE,
+                                              G_FILE_QUERY_INFO_NONE, cancellable, &err);
+      if (G_LIKELY (enumerator != NULL))
+        {
+          while (!exo_job_is_cancelled (EXO_JOB (job)))
+            {
+              info = g_file_enumerator_next_file (enumerator, cancellable, &err);
+              if (info == NULL)
+                break;
+
+              if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+                {
+                  child_file = g_file_get_child (file, g_file_info_get_name (info));
+                  thunar_io_scan_batch_add (&batch, child_file, info, NULL, FALSE, FALSE);
+                  g_object_unref (child_file);
+
+                  if (batch.files->len >= THUNAR_IO_SCAN_DIRECTORY_BATCH_SIZE)
+                    thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+                }
+              g_object_unref (info);
+            }
+          g_object_unref (enumerator);
+        }
+    }
+
+  /* handle the remaining folders of the batch */
+  if (err == NULL)
+    thunar_io_scan_directory_report_files (job, thunar_io_scan_batch_flush (&batch));
+  thunar_io_scan_batch_clear (&batch);
+
+  if (err == NULL)
+    exo_job_set_error_if_cancelled (EXO_JOB (job), &err);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+#ifdef THUNAR_IO_SCAN_LOCAL
+static GFileType
+thunar_io_scan_local_type_from_mode (mode_t mode)
+{
+  if (S_ISDIR (mode))
+    return G_FILE_TYPE_DIRECTORY;
+  else if (S_ISREG (mode))
+    return G_FILE_TYPE_REGULAR;
+  else if (S_ISLNK (mode))
+    return G_FILE_TYPE_SYMBOLIC_LINK;
+  else
+    return G_FILE_TYPE_SPECIAL;
+}
+
+
+
+static GFileType
+thunar_io_scan_local_type_from_dirent (const struct dirent *d)
+{
+#ifdef DT_UNKNOWN
+  switch (d->d_type)
+    {
+    case DT_UNKNOWN:
+      return G_FILE_TYPE_UNKNOWN;
+    case DT_DIR:
+      return G_FILE_TYPE_DIRECTORY;
+    case DT_REG:
+      return G_FILE_TYPE_REGULAR;
+    case DT_LNK:
+      return G_FILE_TYPE_SYMBOLIC_LINK;
+    default:
+      return G_FILE_TYPE_SPECIAL;
+    }
+#else
+  return G_FILE_TYPE_UNKNOWN;
+#endif
+}
+#endif
+
+
+
+/**
+ * thunar_io_scan_local_supported:
+ * @directory : a #GFile.
+ *
+ * Checks if thunar_io_scan_local_directory() can read @directory,
+ * which is the case for folders with a local path on systems that
+ * provide fdopendir() and fstatat().
+ *
+ * Return value: %TRUE if @directory can be read without GIO.
+ **/
+gboolean
+thunar_io_scan_local_supported (GFile *directory)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+
+#ifdef THUNAR_IO_SCAN_LOCAL
+  return g_file_is_native (directory) && g_file_peek_path (directory) != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+
+
+/**
+ * thunar_io_scan_local_directory:
+ * @directory   : a #GFile with a local path, see thunar_io_scan_local_supported().
+ * @flags       : what the callback needs to know about the entries.
+ * @cancellable : a #GCancellable or %NULL.
+ * @func        : the function called for each entry of @directory.
+ * @user_data   : data to pass to @func.
+ * @error       : return location for errors or %NULL.
+ *
+ * Reads the entries of @directory directly from the file system, without
+ * setting up a #GFileInfo for each of them. The entries are only stat'ed
+ * if @flags asks for their size or device, or if the file system leaves
+ * their type open. Entries which vanish while reading are skipped. The
+ * scan stops once @func returns %FALSE or @cancellable is cancelled.
+ *
+ * Return value: %FALSE if @directory could not be opened, %TRUE otherwise.
+ **/
+gboolean
+thunar_io_scan_local_directory (GFile                  *directory,
+                                ThunarIoScanLocalFlags  flags,
+                                GCancellable           *cancellable,
+                                ThunarIoScanLocalFunc   func,
+                                gpointer                user_data,
+                                GError                **error)
+{
+#ifdef THUNAR_IO_SCAN_LOCAL
+  ThunarIoScanLocalEntry  entry;
+  const gchar            *path;
+  struct dirent          *d;
+  struct stat             statb;
+  gboolean                need_stat;
+  gint                    saved_errno;
+  gint                    fd;
+  DIR                    *dp;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (func != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  path = g_file_peek_path (directory);
+  if (G_UNLIKELY (path == NULL))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, _("Operation not supported"));
+      return FALSE;
+    }
+
+  fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  dp = (fd >= 0) ? fdopendir (fd) : NULL;
+  if (G_UNLIKELY (dp == NULL))
+    {
+      saved_errno = errno;
+      if (fd >= 0)
+        close (fd);
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                   _("Failed to open directory: %s"), g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  while (!g_cancellable_is_cancelled (cancellable))
+    {
+      d = readdir (dp);
+      if (d == NULL)
+        break;
+
+      /* skip the "." and ".." entries */
+      if (d->d_name[0] == '.' && (d->d_name[1] == '\0' || (d->d_name[1] == '.' && d->d_name[2] == '\0')))
+        continue;
+
+      entry.name = d->d_name;
+      entry.type = thunar_io_scan_local_type_from_dirent (d);
+      entry.size = 0;
+      entry.device = 0;
+
+      /* only stat the entry if the callback needs more than the entry type */
+      need_stat = (flags & (THUNAR_IO_SCAN_LOCAL_NEED_SIZE | THUNAR_IO_SCAN_LOCAL_NEED_DEVICE)) != 0
+                  || entry.type == G_FILE_TYPE_UNKNOWN
+                  || (entry.type == G_FILE_TYPE_SYMBOLIC_LINK && (flags & THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS) != 0);
+      if (need_stat)
+        {
+          if (fstatat (dirfd (dp), d->d_name, &statb,
+                       (flags & THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS) != 0 ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+
+          entry.type = thunar_io_scan_local_type_from_mode (statb.st_mode);
+          entry.size = statb.st_size;
+          entry.device = statb.st_dev;
+        }
+
+      if (!func (&entry, user_data))
+        break;
+    }
+
+  /* closes the file descriptor too */
+  closedir (dp);
+
+  return TRUE;
+#else
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, _("Operation not supported"));
+  return FALSE;
+#endif
+}
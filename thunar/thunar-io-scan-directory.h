@@ -28,6 +28,34 @@
 
 G_BEGIN_DECLS
 
+typedef struct _ThunarIoScanLocalEntry ThunarIoScanLocalEntry;
+
+/**
+ * ThunarIoScanLocalFlags:
+ * @THUNAR_IO_SCAN_LOCAL_NEED_SIZE       : the entries must have their size.
+ * @THUNAR_IO_SCAN_LOCAL_NEED_DEVICE     : the entries must have their device.
+ * @THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS : report the targets of symlinks.
+ *
+ * Flags for thunar_io_scan_local_directory().
+ **/
+typedef enum /*< flags >*/
+{
+  THUNAR_IO_SCAN_LOCAL_NEED_SIZE       = 1 << 0,
+  THUNAR_IO_SCAN_LOCAL_NEED_DEVICE     = 1 << 1,
+  THUNAR_IO_SCAN_LOCAL_FOLLOW_SYMLINKS = 1 << 2,
+} ThunarIoScanLocalFlags;
+
+struct _ThunarIoScanLocalEntry
+{
+  const gchar *name;
+  GFileType    type;
+  guint64      size;   /* only set with THUNAR_IO_SCAN_LOCAL_NEED_SIZE */
+  guint64      device; /* only set with THUNAR_IO_SCAN_LOCAL_NEED_DEVICE */
+};
+
+typedef gboolean (*ThunarIoScanLocalFunc) (const ThunarIoScanLocalEntry *entry,
+                                           gpointer                      user_data);
+
 GList *thunar_io_scan_directory (ThunarJob          *job,
                                  GFile              *file,
                                  GFileQueryInfoFlags flags,
@@ -37,6 +65,32 @@ GList *thunar_io_scan_directory (ThunarJob          *job,
                                  guint              *n_files_max,
                                  GError            **error);
 
+gboolean thunar_io_scan_directory_report (ThunarJob          *job,
+                                          GFile              *file,
+                                          GFileQueryInfoFlags flags,
+                                          gboolean            partial_info,
+                                          GError            **error);
+
+gboolean thunar_io_scan_directory_report_page (ThunarJob        *job,
+                                               GFile            *file,
+                                               GFileEnumerator **enumerator,
+                                               gboolean          partial_info,
+                                               guint             n_files,
+                                               GError          **error);
+
+gboolean thunar_io_scan_directory_report_folders (ThunarJob  *job,
+                                                  GFile      *file,
+                                                  GError    **error);
+
+gboolean thunar_io_scan_local_supported  (GFile                  *directory);
+
+gboolean thunar_io_scan_local_directory  (GFile                  *directory,
+                                          ThunarIoScanLocalFlags  flags,
+                                          GCancellable           *cancellable,
+                                          ThunarIoScanLocalFunc   func,
+                                          gpointer                user_data,
+                                          GError                **error);
+
 G_END_DECLS
 
 #endif /* !__THUNAR_IO_SCAN_DIRECTORY_H__ */
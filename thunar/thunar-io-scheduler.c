@@ -0,0 +1,677 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_SYSMACROS_H
+#include <sys/sysmacros.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* number of operations using a device at the same time. Spinning disks
+ * are used by one operation at a time, so they don't seek back and forth
+ * between them, the others are shared like the threads of a single job */
+#define THUNAR_IO_SCHEDULER_SLOTS_SOLID      8
+#define THUNAR_IO_SCHEDULER_SLOTS_ROTATIONAL 1
+#define THUNAR_IO_SCHEDULER_SLOTS_REMOTE     8
+
+/* number of folders listed from a remote location at the same time, a
+ * server which enumerates many folders at once gets slower for all */
+#define THUNAR_IO_SCHEDULER_LISTINGS_REMOTE  3
+
+/* the longest time a background operation waits for the folders the
+ * user navigates to, so a hanging location doesn't stall it for good */
+#define THUNAR_IO_SCHEDULER_YIELD_MAX        (2 * G_USEC_PER_SEC)
+
+
+
+typedef struct _ThunarIoDevice ThunarIoDevice;
+
+
+
+static void thunar_io_scheduler_finalize (GObject *object);
+
+
+
+struct _ThunarIoSchedulerClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarIoScheduler
+{
+  GObject     __parent__;
+
+  GMutex      mutex;
+  GCond       cond;
+
+  /* device key -> ThunarIoDevice, the devices are never removed */
+  GHashTable *devices;
+};
+
+struct _ThunarIoDevice
+{
+  ThunarIoDeviceClass device_class;
+  guint               n_slots;
+  guint               n_active;
+  guint               n_foreground; /* folders being loaded for the user */
+  guint               n_listings;   /* folders being listed */
+  guint               n_urgent;     /* listings of the views waiting for their turn */
+};
+
+struct _ThunarIoTicket
+{
+  ThunarIoScheduler *scheduler;
+  ThunarIoDevice    *devices[2];
+  gboolean           owner[2];   /* in contrast to nested tickets of the same thread */
+  guint              n_devices;
+  gboolean           active;
+  gboolean           foreground;
+  gboolean           listing;
+};
+
+
+
+/* the devices used by the tickets of the current thread, mapped to the
+ * number of its tickets, so nested tickets don't wait for themselves */
+static GPrivate thunar_io_scheduler_thread_devices = G_PRIVATE_INIT ((GDestroyNotify) g_hash_table_unref);
+
+
+
+G_DEFINE_TYPE (ThunarIoScheduler, thunar_io_scheduler, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_io_scheduler_class_init (ThunarIoSchedulerClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_io_scheduler_finalize;
+}
+
+
+
+static void
+thunar_io_scheduler_init (ThunarIoScheduler *scheduler)
+{
+  g_mutex_init (&scheduler->mutex);
+  g_cond_init (&scheduler->cond);
+  scheduler->devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+
+
+static void
+thunar_io_scheduler_finalize (GObject *object)
+{
+  ThunarIoScheduler *scheduler = THUNAR_IO_SCHEDULER (object);
+
+  g_hash_table_destroy (scheduler->devices);
+  g_cond_clear (&scheduler->cond);
+  g_mutex_clear (&scheduler->mutex);
+
+  (*G_OBJECT_CLASS (thunar_io_scheduler_parent_class)->finalize) (object);
+}
+
+
+
+/* stats the file or, since copy targets don't exist yet,
+ * the closest existing folder above it */
+static gboolean
+thunar_io_scheduler_stat_closest (GFile    *file,
+                                  GStatBuf *statb)
+{
+  GFile   *current;
+  GFile   *parent;
+  gboolean found = FALSE;
+
+  if (!g_file_is_native (file) || g_file_peek_path (file) == NULL)
+    return FALSE;
+
+  for (current = g_object_ref (file); current != NULL; current = parent)
+    {
+      found = (g_stat (g_file_peek_path (current), statb) == 0);
+      parent = found ? NULL : g_file_get_parent (current);
+      g_object_unref (current);
+    }
+
+  return found;
+}
+
+
+
+static gchar *
+thunar_io_scheduler_get_device_key (GFile *file)
+{
+  GStatBuf statb;
+  gchar   *uri;
+  gchar   *authority;
+  gchar   *end;
+
+  if (thunar_io_scheduler_stat_closest (file, &statb))
+    return g_strdup_printf ("dev:%" G_GUINT64_FORMAT, (guint64) statb.st_dev);
+
+  /* remote locations are told apart by their scheme and host */
+  uri = g_file_get_uri (file);
+  authority = strstr (uri, "://");
+  if (authority != NULL)
+    {
+      end = strchr (authority + 3, '/');
+      if (end != NULL)
+        *end = '\0';
+    }
+
+  return uri;
+}
+
+
+
+static gboolean
+thunar_io_scheduler_is_rotational (GFile *file)
+{
+  gboolean rotational = FALSE;
+#ifdef HAVE_SYS_SYSMACROS_H
+  GStatBuf statb;
+  gchar   *filename;
+  gchar   *contents;
+
+  if (!thunar_io_scheduler_stat_closest (file, &statb))
+    return FALSE;
+
+  /* the queue of a partition is found at its parent device */
+  filename = g_strdup_printf ("/sys/dev/block/%u:%u/queue/rotational", major (statb.st_dev), minor (statb.st_dev));
+  if (!g_file_get_contents (filename, &contents, NULL, NULL))
+    {
+      g_free (filename);
+      filename = g_strdup_printf ("/sys/dev/block/%u:%u/../queue/rotational", major (statb.st_dev), minor (statb.st_dev));
+      if (!g_file_get_contents (filename, &contents, NULL, NULL))
+        contents = NULL;
+    }
+
+  if (contents != NULL)
+    {
+      rotational = (contents[0] == '1');
+      g_free (contents);
+    }
+  g_free (filename);
+#endif
+
+  return rotational;
+}
+
+
+
+static ThunarIoDevice *
+thunar_io_scheduler_lookup_device (ThunarIoScheduler *scheduler,
+                                   GFile             *file)
+{
+  ThunarIoDeviceClass device_class;
+  ThunarIoDevice     *device;
+  gchar              *key;
+
+  key = thunar_io_scheduler_get_device_key (file);
+
+  g_mutex_lock (&scheduler->mutex);
+  device = g_hash_table_lookup (scheduler->devices, key);
+  g_mutex_unlock (&scheduler->mutex);
+
+  if (device != NULL)
+    {
+      g_free (key);
+      return device;
+    }
+
+  /* classify the device outside the lock, it does I/O */
+  device_class = thunar_io_scheduler_get_device_class (file);
+
+  g_mutex_lock (&scheduler->mutex);
+  device = g_hash_table_lookup (scheduler->devices, key);
+  if (device == NULL)
+    {
+      device = g_new0 (ThunarIoDevice, 1);
+      device->device_class = device_class;
+      if (device_class == THUNAR_IO_DEVICE_ROTATIONAL)
+        device->n_slots = THUNAR_IO_SCHEDULER_SLOTS_ROTATIONAL;
+      else if (device_class == THUNAR_IO_DEVICE_REMOTE)
+        device->n_slots = THUNAR_IO_SCHEDULER_SLOTS_REMOTE;
+      else
+        device->n_slots = THUNAR_IO_SCHEDULER_SLOTS_SOLID;
+
+      g_hash_table_insert (scheduler->devices, key, device);
+      key = NULL;
+    }
+  g_mutex_unlock (&scheduler->mutex);
+
+  g_free (key);
+
+  return device;
+}
+
+
+
+static GHashTable *
+thunar_io_scheduler_get_thread_devices (void)
+{
+  GHashTable *thread_devices;
+
+  thread_devices = g_private_get (&thunar_io_scheduler_thread_devices);
+  if (thread_devices == NULL)
+    {
+      thread_devices = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_private_set (&thunar_io_scheduler_thread_devices, thread_devices);
+    }
+
+  return thread_devices;
+}
+
+
+
+/* must be called with the scheduler mutex held */
+static gboolean
+thunar_io_ticket_has_room (ThunarIoTicket *ticket)
+{
+  guint n;
+
+  for (n = 0; n < ticket->n_devices; ++n)
+    if (ticket->owner[n] && ticket->devices[n]->n_active >= ticket->devices[n]->n_slots)
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_io_ticket_take (ThunarIoTicket *ticket,
+                       gboolean        wait,
+                       GCancellable   *cancellable)
+{
+  ThunarIoScheduler *scheduler = ticket->scheduler;
+  guint              n;
+
+  g_mutex_lock (&scheduler->mutex);
+
+  /* all devices are taken at once, so two tickets never wait for each other */
+  while (!thunar_io_ticket_has_room (ticket))
+    {
+      /* a cancelled operation goes on without a slot, it stops soon anyway */
+      if (!wait || g_cancellable_is_cancelled (cancellable))
+        {
+          g_mutex_unlock (&scheduler->mutex);
+          return wait;
+        }
+
+      g_cond_wait_until (&scheduler->cond, &scheduler->mutex, g_get_monotonic_time () + G_USEC_PER_SEC / 4);
+    }
+
+  for (n = 0; n < ticket->n_devices; ++n)
+    if (ticket->owner[n])
+      ticket->devices[n]->n_active++;
+  ticket->active = TRUE;
+
+  g_mutex_unlock (&scheduler->mutex);
+
+  return TRUE;
+}
+
+
+
+/* must be called with the scheduler mutex held. Loading folders
+ * on solid devices doesn't suffer from the other operations */
+static gboolean
+thunar_io_ticket_has_foreground (ThunarIoTicket *ticket)
+{
+  guint n;
+
+  for (n = 0; n < ticket->n_devices; ++n)
+    if (ticket->devices[n]->n_foreground > 0 && ticket->devices[n]->device_class != THUNAR_IO_DEVICE_SOLID)
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_io_scheduler_new:
+ *
+ * Allocates a new #ThunarIoScheduler. There is usually only the one
+ * of thunar_application_get_io_scheduler().
+ *
+ * Return value: the newly allocated #ThunarIoScheduler.
+ **/
+ThunarIoScheduler *
+thunar_io_scheduler_new (void)
+{
+  return g_object_new (THUNAR_TYPE_IO_SCHEDULER, NULL);
+}
+
+
+
+/**
+ * thunar_io_scheduler_get_device_class:
+ * @file : a #GFile, which does not need to exist yet.
+ *
+ * Determines the kind of device @file is stored on. This does
+ * blocking I/O and should not be called from the main thread.
+ *
+ * Return value: the #ThunarIoDeviceClass of the device of @file.
+ **/
+ThunarIoDeviceClass
+thunar_io_scheduler_get_device_class (GFile *file)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (file), THUNAR_IO_DEVICE_SOLID);
+
+  if (!thunar_g_file_is_on_local_device (file))
+    return THUNAR_IO_DEVICE_REMOTE;
+
+  if (thunar_io_scheduler_is_rotational (file))
+    return THUNAR_IO_DEVICE_ROTATIONAL;
+
+  return THUNAR_IO_DEVICE_SOLID;
+}
+
+
+
+/**
+ * thunar_io_scheduler_acquire:
+ * @scheduler   : a #ThunarIoScheduler.
+ * @file_a      : the #GFile an operation reads or writes.
+ * @file_b      : (nullable): another #GFile of the operation, like the target of a copy.
+ * @wait        : whether to wait until the devices are available.
+ * @cancellable : (nullable): a #GCancellable to stop waiting.
+ *
+ * Reserves the devices of @file_a and @file_b for an operation, which
+ * releases them with thunar_io_ticket_release() when it is done. Tickets
+ * of a thread within another ticket of the same devices never wait.
+ *
+ * This does blocking I/O and must not be called from the main thread.
+ *
+ * Return value: a #ThunarIoTicket, or %NULL if @wait is %FALSE and the
+ *               devices are busy.
+ **/
+ThunarIoTicket *
+thunar_io_scheduler_acquire (ThunarIoScheduler *scheduler,
+                             GFile             *file_a,
+                             GFile             *file_b,
+                             gboolean           wait,
+                             GCancellable      *cancellable)
+{
+  ThunarIoTicket *ticket;
+  GHashTable     *thread_devices;
+  guint           n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_IO_SCHEDULER (scheduler), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (file_a), NULL);
+  _thunar_return_val_if_fail (file_b == NULL || G_IS_FILE (file_b), NULL);
+
+  ticket = g_slice_new0 (ThunarIoTicket);
+  ticket->scheduler = g_object_ref (scheduler);
+  ticket->devices[ticket->n_devices++] = thunar_io_scheduler_lookup_device (scheduler, file_a);
+  if (file_b != NULL)
+    {
+      ticket->devices[ticket->n_devices] = thunar_io_scheduler_lookup_device (scheduler, file_b);
+      if (ticket->devices[ticket->n_devices] != ticket->devices[0])
+        ticket->n_devices++;
+    }
+
+  thread_devices = thunar_io_scheduler_get_thread_devices ();
+  for (n = 0; n < ticket->n_devices; ++n)
+    ticket->owner[n] = !g_hash_table_contains (thread_devices, ticket->devices[n]);
+
+  if (!thunar_io_ticket_take (ticket, wait, cancellable))
+    {
+      g_object_unref (ticket->scheduler);
+      g_slice_free (ThunarIoTicket, ticket);
+      return NULL;
+    }
+
+  for (n = 0; n < ticket->n_devices; ++n)
+    g_hash_table_insert (thread_devices, ticket->devices[n],
+                         GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (thread_devices, ticket->devices[n])) + 1));
+
+  return ticket;
+}
+
+
+
+/**
+ * thunar_io_scheduler_acquire_listing:
+ * @scheduler   : a #ThunarIoScheduler.
+ * @file        : the folder which is listed.
+ * @urgent      : whether the folder is listed for a view.
+ * @cancellable : (nullable): a #GCancellable to stop waiting.
+ *
+ * Reserves one of the few listings which may run on a remote location
+ * at the same time, until the returned ticket is released with
+ * thunar_io_ticket_release(). The @urgent listings go first, the others
+ * wait for them. Local folders are listed right away.
+ *
+ * The @urgent ticket also tells the @scheduler that the user waits for
+ * @file to be loaded. It takes no slot on the device, but background
+ * operations on the same device hold still in thunar_io_ticket_yield()
+ * meanwhile.
+ *
+ * This does blocking I/O and must not be called from the main thread.
+ *
+ * Return value: a #ThunarIoTicket.
+ **/
+ThunarIoTicket *
+thunar_io_scheduler_acquire_listing (ThunarIoScheduler *scheduler,
+                                     GFile             *file,
+                                     gboolean           urgent,
+                                     GCancellable      *cancellable)
+{
+  ThunarIoTicket *ticket;
+  ThunarIoDevice *device;
+
+  _thunar_return_val_if_fail (THUNAR_IS_IO_SCHEDULER (scheduler), NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  ticket = g_slice_new0 (ThunarIoTicket);
+  ticket->scheduler = g_object_ref (scheduler);
+  ticket->devices[ticket->n_devices++] = thunar_io_scheduler_lookup_device (scheduler, file);
+  ticket->foreground = urgent;
+  ticket->listing = TRUE;
+
+  device = ticket->devices[0];
+
+  g_mutex_lock (&scheduler->mutex);
+
+  if (urgent)
+    device->n_foreground++;
+
+  if (device->device_class == THUNAR_IO_DEVICE_REMOTE)
+    {
+      if (urgent)
+        device->n_urgent++;
+
+      /* a cancelled listing goes on without waiting, it stops soon anyway */
+      while ((device->n_listings >= THUNAR_IO_SCHEDULER_LISTINGS_REMOTE || (!urgent && device->n_urgent > 0))
+             && !g_cancellable_is_cancelled (cancellable))
+        g_cond_wait_until (&scheduler->cond, &scheduler->mutex, g_get_monotonic_time () + G_USEC_PER_SEC / 4);
+
+      if (urgent)
+        device->n_urgent--;
+    }
+
+  device->n_listings++;
+
+  g_mutex_unlock (&scheduler->mutex);
+
+  return ticket;
+}
+
+
+
+/**
+ * thunar_io_ticket_yield:
+ * @ticket      : a #ThunarIoTicket of a background operation.
+ * @cancellable : (nullable): a #GCancellable to stop waiting.
+ *
+ * Waits while folders are loaded for the user from the spinning disks
+ * or remote locations of @ticket, see thunar_io_scheduler_acquire_listing().
+ * Background operations call this between their steps, so they don't
+ * slow down the navigation. Several threads may yield the same @ticket.
+ **/
+void
+thunar_io_ticket_yield (ThunarIoTicket *ticket,
+                        GCancellable   *cancellable)
+{
+  ThunarIoScheduler *scheduler;
+  gint64             end_time;
+
+  _thunar_return_if_fail (ticket != NULL);
+
+  if (ticket->listing)
+    return;
+
+  scheduler = ticket->scheduler;
+  end_time = g_get_monotonic_time () + THUNAR_IO_SCHEDULER_YIELD_MAX;
+
+  g_mutex_lock (&scheduler->mutex);
+  while (thunar_io_ticket_has_foreground (ticket)
+         && !g_cancellable_is_cancelled (cancellable)
+         && g_get_monotonic_time () < end_time)
+    g_cond_wait_until (&scheduler->cond, &scheduler->mutex,
+                       MIN (end_time, g_get_monotonic_time () + G_USEC_PER_SEC / 4));
+  g_mutex_unlock (&scheduler->mutex);
+}
+
+
+
+/**
+ * thunar_io_ticket_suspend:
+ * @ticket : a #ThunarIoTicket.
+ *
+ * Lets other operations use the devices of @ticket, for example
+ * while the operation of @ticket is paused by the user.
+ **/
+void
+thunar_io_ticket_suspend (ThunarIoTicket *ticket)
+{
+  ThunarIoScheduler *scheduler;
+  guint              n;
+
+  _thunar_return_if_fail (ticket != NULL);
+
+  if (!ticket->active)
+    return;
+
+  scheduler = ticket->scheduler;
+  g_mutex_lock (&scheduler->mutex);
+
+  for (n = 0; n < ticket->n_devices; ++n)
+    if (ticket->owner[n])
+      ticket->devices[n]->n_active--;
+  ticket->active = FALSE;
+
+  g_cond_broadcast (&scheduler->cond);
+  g_mutex_unlock (&scheduler->mutex);
+}
+
+
+
+/**
+ * thunar_io_ticket_resume:
+ * @ticket      : a #ThunarIoTicket.
+ * @cancellable : (nullable): a #GCancellable to stop waiting.
+ *
+ * Waits until the devices of a suspended @ticket are available again.
+ **/
+void
+thunar_io_ticket_resume (ThunarIoTicket *ticket,
+                         GCancellable   *cancellable)
+{
+  _thunar_return_if_fail (ticket != NULL);
+
+  if (!ticket->active)
+    thunar_io_ticket_take (ticket, TRUE, cancellable);
+}
+
+
+
+/**
+ * thunar_io_ticket_release:
+ * @ticket : a #ThunarIoTicket.
+ *
+ * Hands the devices of @ticket to the waiting operations
+ * and frees @ticket. Must be called from the thread which
+ * acquired it.
+ **/
+void
+thunar_io_ticket_release (ThunarIoTicket *ticket)
+{
+  GHashTable *thread_devices;
+  guint       n;
+  guint       count;
+
+  _thunar_return_if_fail (ticket != NULL);
+
+  if (ticket->listing)
+    {
+      /* let the background operations and the waiting listings go on */
+      g_mutex_lock (&ticket->scheduler->mutex);
+      if (ticket->foreground)
+        ticket->devices[0]->n_foreground--;
+      ticket->devices[0]->n_listings--;
+      g_cond_broadcast (&ticket->scheduler->cond);
+      g_mutex_unlock (&ticket->scheduler->mutex);
+
+      g_object_unref (ticket->scheduler);
+      g_slice_free (ThunarIoTicket, ticket);
+      return;
+    }
+
+  thunar_io_ticket_suspend (ticket);
+
+  thread_devices = thunar_io_scheduler_get_thread_devices ();
+  for (n = 0; n < ticket->n_devices; ++n)
+    {
+      count = GPOINTER_TO_UINT (g_hash_table_lookup (thread_devices, ticket->devices[n]));
+      if (count > 1)
+        g_hash_table_insert (thread_devices, ticket->devices[n], GUINT_TO_POINTER (count - 1));
+      else
+        g_hash_table_remove (thread_devices, ticket->devices[n]);
+    }
+
+  g_object_unref (ticket->scheduler);
+  g_slice_free (ThunarIoTicket, ticket);
+}
@@ -0,0 +1,80 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_IO_SCHEDULER_H__
+#define __THUNAR_IO_SCHEDULER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/**
+ * ThunarIoDeviceClass:
+ * @THUNAR_IO_DEVICE_SOLID      : a local device without seek times, like an SSD.
+ * @THUNAR_IO_DEVICE_ROTATIONAL : a local spinning disk, which is used by one operation at a time.
+ * @THUNAR_IO_DEVICE_REMOTE     : a network location, which is shared by a few operations.
+ *
+ * The kind of device a file is stored on.
+ **/
+typedef enum
+{
+  THUNAR_IO_DEVICE_SOLID,
+  THUNAR_IO_DEVICE_ROTATIONAL,
+  THUNAR_IO_DEVICE_REMOTE,
+} ThunarIoDeviceClass;
+
+#define THUNAR_TYPE_IO_SCHEDULER            (thunar_io_scheduler_get_type ())
+#define THUNAR_IO_SCHEDULER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_IO_SCHEDULER, ThunarIoScheduler))
+#define THUNAR_IO_SCHEDULER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_IO_SCHEDULER, ThunarIoSchedulerClass))
+#define THUNAR_IS_IO_SCHEDULER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_IO_SCHEDULER))
+#define THUNAR_IS_IO_SCHEDULER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_IO_SCHEDULER))
+#define THUNAR_IO_SCHEDULER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_IO_SCHEDULER, ThunarIoSchedulerClass))
+
+typedef struct _ThunarIoSchedulerClass ThunarIoSchedulerClass;
+typedef struct _ThunarIoScheduler      ThunarIoScheduler;
+typedef struct _ThunarIoTicket         ThunarIoTicket;
+
+GType               thunar_io_scheduler_get_type           (void) G_GNUC_CONST;
+
+ThunarIoScheduler  *thunar_io_scheduler_new                (void) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
+ThunarIoDeviceClass thunar_io_scheduler_get_device_class   (GFile             *file);
+
+ThunarIoTicket     *thunar_io_scheduler_acquire            (ThunarIoScheduler *scheduler,
+                                                            GFile             *file_a,
+                                                            GFile             *file_b,
+                                                            gboolean           wait,
+                                                            GCancellable      *cancellable);
+
+ThunarIoTicket     *thunar_io_scheduler_acquire_listing    (ThunarIoScheduler *scheduler,
+                                                            GFile             *file,
+                                                            gboolean           urgent,
+                                                            GCancellable      *cancellable);
+
+void                thunar_io_ticket_yield                 (ThunarIoTicket    *ticket,
+                                                            GCancellable      *cancellable);
+void                thunar_io_ticket_suspend               (ThunarIoTicket    *ticket);
+void                thunar_io_ticket_resume                (ThunarIoTicket    *ticket,
+                                                            GCancellable      *cancellable);
+void                thunar_io_ticket_release               (ThunarIoTicket    *ticket);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_IO_SCHEDULER_H__ */
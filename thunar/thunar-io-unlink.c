@@ -0,0 +1,529 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_GIO_UNIX
+#include <gio/gunixmounts.h>
+#endif
+
+#include <thunar/thunar-application.h>
+#include <thunar/thunar-io-scheduler.h>
+#include <thunar/thunar-io-unlink.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* number of folders emptied at the same time, spinning disks
+ * are walked by a single thread so they don't seek */
+#define THUNAR_IO_UNLINK_THREADS          4
+
+/* deleted files passed to the thumbnail cache at once */
+#define THUNAR_IO_UNLINK_THUMBNAIL_BATCH  512
+
+/* microseconds between two progress updates */
+#define THUNAR_IO_UNLINK_PROGRESS_INTERVAL (100 * 1000)
+
+/* prefix of the folders the contents of an emptied trash are moved to */
+#define THUNAR_IO_UNLINK_TRASH_ASIDE      "expunged-thunar-"
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+
+
+typedef struct _ThunarIoUnlink    ThunarIoUnlink;
+typedef struct _ThunarIoUnlinkDir ThunarIoUnlinkDir;
+
+struct _ThunarIoUnlink
+{
+  ThunarJob            *job;
+  ThunarThumbnailCache *thumbnail_cache;
+  GThreadPool          *pool;
+
+  GMutex                mutex;
+  GCond                 cond;
+
+  /* all folders of the walk, they are released at the end */
+  GPtrArray            *dirs;
+
+  /* set if a file could not be deleted or the job was cancelled */
+  gint                  stop;
+  gboolean              done;
+
+  /* the walk does not leave the file system of the folder */
+  dev_t                 device;
+
+  /* number of deleted files and folders, updated atomically */
+  gint                  n_deleted;
+};
+
+struct _ThunarIoUnlinkDir
+{
+  ThunarIoUnlinkDir *parent;
+  gchar             *path;
+
+  /* subfolders not yet removed, plus one while the folder is read */
+  gint               n_pending;
+};
+
+
+
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_UNLINKAT)
+static ThunarIoUnlinkDir *
+thunar_io_unlink_dir_new (ThunarIoUnlink    *context,
+                          ThunarIoUnlinkDir *parent,
+                          gchar             *path)
+{
+  ThunarIoUnlinkDir *dir;
+
+  dir = g_slice_new (ThunarIoUnlinkDir);
+  dir->parent = parent;
+  dir->path = path;
+  dir->n_pending = 1;
+
+  g_mutex_lock (&context->mutex);
+  g_ptr_array_add (context->dirs, dir);
+  g_mutex_unlock (&context->mutex);
+
+  return dir;
+}
+
+
+
+static void
+thunar_io_unlink_dir_free (gpointer data)
+{
+  ThunarIoUnlinkDir *dir = data;
+
+  g_free (dir->path);
+  g_slice_free (ThunarIoUnlinkDir, dir);
+}
+
+
+
+static void
+thunar_io_unlink_stop (ThunarIoUnlink *context)
+{
+  g_mutex_lock (&context->mutex);
+  g_atomic_int_set (&context->stop, TRUE);
+  g_cond_broadcast (&context->cond);
+  g_mutex_unlock (&context->mutex);
+}
+
+
+
+/* removes every folder whose contents are gone, starting at dir */
+static void
+thunar_io_unlink_dir_finish (ThunarIoUnlink    *context,
+                             ThunarIoUnlinkDir *dir)
+{
+  for (; dir != NULL && g_atomic_int_dec_and_test (&dir->n_pending); dir = dir->parent)
+    {
+      if (unlinkat (AT_FDCWD, dir->path, AT_REMOVEDIR) < 0)
+        {
+          thunar_io_unlink_stop (context);
+          return;
+        }
+
+      g_atomic_int_inc (&context->n_deleted);
+
+      if (dir->parent == NULL)
+        {
+          /* the whole tree is gone */
+          g_mutex_lock (&context->mutex);
+          context->done = TRUE;
+          g_cond_broadcast (&context->cond);
+          g_mutex_unlock (&context->mutex);
+        }
+    }
+}
+
+
+
+static void
+thunar_io_unlink_thread (gpointer data,
+                         gpointer user_data)
+{
+  ThunarIoUnlinkDir *dir = data;
+  ThunarIoUnlinkDir *child;
+  ThunarIoUnlink    *context = user_data;
+  struct dirent     *entry;
+  struct stat        statb;
+  gboolean           is_dir;
+  GList             *deleted = NULL;
+  guint              n_deleted = 0;
+  DIR               *dp;
+  gint               fd;
+
+  if (g_atomic_int_get (&context->stop))
+    return;
+
+  fd = open (dir->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+  dp = (fd >= 0 && fstat (fd, &statb) == 0 && statb.st_dev == context->device) ? fdopendir (fd) : NULL;
+  if (dp == NULL)
+    {
+      if (fd >= 0)
+        close (fd);
+      thunar_io_unlink_stop (context);
+      return;
+    }
+
+  while (!g_atomic_int_get (&context->stop) && (entry = readdir (dp)) != NULL)
+    {
+      if (strcmp (entry->d_name, ".") == 0 || strcmp (entry->d_name, "..") == 0)
+        continue;
+
+      if (exo_job_is_cancelled (EXO_JOB (context->job)))
+        {
+          thunar_io_unlink_stop (context);
+          break;
+        }
+
+#ifdef _DIRENT_HAVE_D_TYPE
+      if (entry->d_type != DT_UNKNOWN)
+        is_dir = (entry->d_type == DT_DIR);
+      else
+#endif
+        is_dir = fstatat (fd, entry->d_name, &statb, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR (statb.st_mode);
+
+      if (is_dir)
+        {
+          /* the subfolder is emptied by the next free thread */
+          child = thunar_io_unlink_dir_new (context, dir, g_build_filename (dir->path, entry->d_name, NULL));
+          g_atomic_int_inc (&dir->n_pending);
+          g_thread_pool_push (context->pool, child, NULL);
+          continue;
+        }
+
+      if (unlinkat (fd, entry->d_name, 0) < 0)
+        {
+          thunar_io_unlink_stop (context);
+          break;
+        }
+
+      g_atomic_int_inc (&context->n_deleted);
+
+      /* the thumbnails of the deleted files are dropped in batches */
+      deleted = g_list_prepend (deleted, g_file_new_build_filename (dir->path, entry->d_name, NULL));
+      if (++n_deleted == THUNAR_IO_UNLINK_THUMBNAIL_BATCH)
+        {
+          thunar_thumbnail_cache_delete_files (context->thumbnail_cache, deleted);
+          g_list_free_full (deleted, g_object_unref);
+          deleted = NULL;
+          n_deleted = 0;
+        }
+    }
+
+  closedir (dp);
+
+  thunar_thumbnail_cache_delete_files (context->thumbnail_cache, deleted);
+  g_list_free_full (deleted, g_object_unref);
+
+  if (!g_atomic_int_get (&context->stop))
+    thunar_io_unlink_dir_finish (context, dir);
+}
+#endif
+
+
+
+/**
+ * thunar_io_unlink_directory:
+ * @job             : a #ThunarJob.
+ * @directory       : a local #GFile of a folder.
+ * @thumbnail_cache : the #ThunarThumbnailCache to tell about deleted files.
+ *
+ * Deletes @directory and its contents, emptying several subfolders at
+ * the same time while they are walked. Symbolic links are deleted, not
+ * followed. Stops at the first file that could not be deleted, or when
+ * @job is cancelled.
+ *
+ * Return value: %TRUE if @directory was deleted, %FALSE if it is not a
+ *               local folder, or parts of it are left.
+ **/
+gboolean
+thunar_io_unlink_directory (ThunarJob            *job,
+                            GFile                *directory,
+                            ThunarThumbnailCache *thumbnail_cache)
+{
+#if defined (HAVE_FDOPENDIR) && defined (HAVE_UNLINKAT)
+  ThunarApplication *application;
+  ThunarIoScheduler *scheduler;
+  ThunarIoTicket    *ticket;
+  ThunarIoUnlink     context;
+  struct stat        statb;
+  const gchar       *path;
+  gint64             end_time;
+  guint              n_deleted;
+  guint              n_reported = 0;
+  gint               n_threads;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (thumbnail_cache), FALSE);
+
+  path = g_file_peek_path (directory);
+  if (path == NULL || lstat (path, &statb) < 0 || !S_ISDIR (statb.st_mode))
+    return FALSE;
+
+  if (thunar_io_scheduler_get_device_class (directory) == THUNAR_IO_DEVICE_ROTATIONAL)
+    n_threads = 1;
+  else
+    n_threads = THUNAR_IO_UNLINK_THREADS;
+
+  /* share the device with the other jobs */
+  application = thunar_application_get ();
+  scheduler = thunar_application_get_io_scheduler (application);
+  g_object_unref (application);
+  ticket = thunar_io_scheduler_acquire (scheduler, directory, NULL, TRUE, exo_job_get_cancellable (EXO_JOB (job)));
+
+  context.job = job;
+  context.thumbnail_cache = thumbnail_cache;
+  context.dirs = g_ptr_array_new_with_free_func (thunar_io_unlink_dir_free);
+  context.stop = FALSE;
+  context.done = FALSE;
+  context.n_deleted = 0;
+  context.device = statb.st_dev;
+  g_mutex_init (&context.mutex);
+  g_cond_init (&context.cond);
+
+  context.pool = g_thread_pool_new (thunar_io_unlink_thread, &context, n_threads, FALSE, NULL);
+  g_thread_pool_push (context.pool, thunar_io_unlink_dir_new (&context, NULL, g_strdup (path)), NULL);
+
+  /* only the job thread reports the progress */
+  g_mutex_lock (&context.mutex);
+  while (!context.done && !g_atomic_int_get (&context.stop))
+    {
+      end_time = g_get_monotonic_time () + THUNAR_IO_UNLINK_PROGRESS_INTERVAL;
+      if (g_cond_wait_until (&context.cond, &context.mutex, end_time))
+        continue;
+
+      g_mutex_unlock (&context.mutex);
+
+      n_deleted = g_atomic_int_get (&context.n_deleted);
+      if (n_deleted != n_reported)
+        {
+          exo_job_info_message (EXO_JOB (job), ngettext ("Deleted %u file", "Deleted %u files", n_deleted), n_deleted);
+          n_reported = n_deleted;
+        }
+
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        g_atomic_int_set (&context.stop, TRUE);
+
+      g_mutex_lock (&context.mutex);
+    }
+  g_mutex_unlock (&context.mutex);
+
+  /* let the threads run out, the queued folders are skipped */
+  g_thread_pool_free (context.pool, FALSE, TRUE);
+
+  if (ticket != NULL)
+    thunar_io_ticket_release (ticket);
+  g_object_unref (scheduler);
+
+  g_ptr_array_free (context.dirs, TRUE);
+  g_mutex_clear (&context.mutex);
+  g_cond_clear (&context.cond);
+
+  return context.done;
+#else
+  return FALSE;
+#endif
+}
+
+
+
+/* moves files/ and info/ of trash_dir into a new folder next to them,
+ * and prepends that folder and those left by earlier runs to aside_list */
+static GList *
+thunar_io_unlink_trash_dir_aside (const gchar *trash_dir,
+                                  GList       *aside_list)
+{
+  static const gchar *subdirs[] = { "files", "info" };
+  const gchar        *name;
+  gboolean            moved;
+  gchar              *aside;
+  gchar              *path;
+  gchar              *target;
+  guint               n;
+  GDir               *dp;
+
+  dp = g_dir_open (trash_dir, 0, NULL);
+  if (dp == NULL)
+    return aside_list;
+
+  /* an earlier run may not have finished deleting */
+  while ((name = g_dir_read_name (dp)) != NULL)
+    if (g_str_has_prefix (name, THUNAR_IO_UNLINK_TRASH_ASIDE))
+      aside_list = g_list_prepend (aside_list, g_file_new_build_filename (trash_dir, name, NULL));
+  g_dir_close (dp);
+
+  aside = g_build_filename (trash_dir, THUNAR_IO_UNLINK_TRASH_ASIDE "XXXXXX", NULL);
+  if (g_mkdtemp_full (aside, 0700) == NULL)
+    {
+      g_free (aside);
+      return aside_list;
+    }
+
+  /* the items are moved before their info files, so a failure
+   * never leaves a trashed file without its info file */
+  for (n = 0; n < G_N_ELEMENTS (subdirs); n++)
+    {
+      path = g_build_filename (trash_dir, subdirs[n], NULL);
+      target = g_build_filename (aside, subdirs[n], NULL);
+      moved = (g_rename (path, target) == 0);
+      if (moved)
+        g_mkdir (path, 0700);
+      g_free (target);
+      g_free (path);
+
+      if (!moved)
+        break;
+    }
+
+  /* the cached sizes of the trashed folders are gone as well */
+  path = g_build_filename (trash_dir, "directorysizes", NULL);
+  g_unlink (path);
+  g_free (path);
+
+  aside_list = g_list_prepend (aside_list, g_file_new_for_path (aside));
+  g_free (aside);
+
+  return aside_list;
+}
+
+
+
+#ifdef HAVE_GIO_UNIX
+/* returns the trash folder of the user in the mount at top_dir, if any */
+static gchar *
+thunar_io_unlink_trash_dir_for_mount (const gchar *top_dir)
+{
+  struct stat statb;
+  gchar      *shared_dir;
+  gchar      *trash_dir;
+  gchar      *name;
+
+  /* $topdir/.Trash/$uid, if .Trash is a sticky folder and no link */
+  shared_dir = g_build_filename (top_dir, ".Trash", NULL);
+  if (lstat (shared_dir, &statb) == 0 && S_ISDIR (statb.st_mode) && (statb.st_mode & S_ISVTX) != 0)
+    {
+      name = g_strdup_printf ("%u", (guint) getuid ());
+      trash_dir = g_build_filename (shared_dir, name, NULL);
+      g_free (name);
+
+      if (lstat (trash_dir, &statb) == 0 && S_ISDIR (statb.st_mode) && statb.st_uid == getuid ())
+        {
+          g_free (shared_dir);
+          return trash_dir;
+        }
+      g_free (trash_dir);
+    }
+  g_free (shared_dir);
+
+  /* $topdir/.Trash-$uid */
+  name = g_strdup_printf (".Trash-%u", (guint) getuid ());
+  trash_dir = g_build_filename (top_dir, name, NULL);
+  g_free (name);
+
+  if (lstat (trash_dir, &statb) == 0 && S_ISDIR (statb.st_mode) && statb.st_uid == getuid ())
+    return trash_dir;
+
+  g_free (trash_dir);
+  return NULL;
+}
+#endif
+
+
+
+/**
+ * thunar_io_unlink_move_trash_aside:
+ *
+ * Empties the local trash folders of the user at once, by moving
+ * their files/ and info/ folders into folders next to them. The
+ * returned folders are left to the caller to delete, possibly with
+ * thunar_io_unlink_directory(). Folders of that kind that an earlier
+ * call left behind are returned as well.
+ *
+ * Trash folders of mounts that are not in the mount table, like
+ * those of remote GVfs locations, are left alone.
+ *
+ * Return value: the list of #GFile<!---->s to delete, to be released
+ *               with thunar_g_list_free_full().
+ **/
+GList *
+thunar_io_unlink_move_trash_aside (void)
+{
+  GList *aside_list = NULL;
+  gchar *trash_dir;
+#ifdef HAVE_GIO_UNIX
+  GList *mounts;
+  GList *lp;
+#endif
+
+  trash_dir = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+  aside_list = thunar_io_unlink_trash_dir_aside (trash_dir, aside_list);
+  g_free (trash_dir);
+
+#ifdef HAVE_GIO_UNIX
+  mounts = g_unix_mounts_get (NULL);
+  for (lp = mounts; lp != NULL; lp = lp->next)
+    {
+      if (g_unix_mount_is_system_internal (lp->data))
+        continue;
+
+      trash_dir = thunar_io_unlink_trash_dir_for_mount (g_unix_mount_get_mount_path (lp->data));
+      if (trash_dir != NULL)
+        aside_list = thunar_io_unlink_trash_dir_aside (trash_dir, aside_list);
+      g_free (trash_dir);
+    }
+  g_list_free_full (mounts, (GDestroyNotify) g_unix_mount_free);
+#endif
+
+  return aside_list;
+}
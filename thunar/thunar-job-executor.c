@@ -0,0 +1,312 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-job-executor.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
+
+
+
+/**
+ * SECTION:thunar-job-executor
+ * @Short_description: Bounded pools for launching jobs
+ * @Title: ThunarJobExecutor
+ *
+ * Every #ThunarJob runs on a thread of the shared GIO worker pool. To
+ * keep a handful of slow network listings or a few big transfers from
+ * taking all of those threads, jobs are launched through one of three
+ * bounded pools: interactive jobs, bulk I/O and CPU bound work. A job
+ * waits in the queue of its pool until a slot is free, or until another
+ * pool has more than one slot idle, which it then borrows.
+ *
+ * The executor lives in the main thread, jobs are only launched and
+ * finished from there.
+ **/
+
+
+
+/* the slots of the interactive pool also cover listings hanging on
+ * unreachable network shares, bulk I/O is limited by the disks anyway */
+#define THUNAR_JOB_EXECUTOR_SLOTS_INTERACTIVE 8
+#define THUNAR_JOB_EXECUTOR_SLOTS_BULK        4
+#define THUNAR_JOB_EXECUTOR_SLOTS_CPU_MAX     8
+
+
+
+typedef struct
+{
+  const gchar          *name;
+  guint                 n_slots;
+  guint                 n_running;
+  GQueue                queue;
+  ThunarStatsHistogram  wait_histogram;
+} ThunarJobExecutorPool;
+
+typedef struct
+{
+  ThunarJob     *job;
+  ThunarJobPool  pool;    /* the pool the job was queued in */
+  ThunarJobPool  slot;    /* the pool whose slot the job runs on */
+  gint64         queue_time;
+  GCancellable  *cancellable;
+  gulong         cancelled_id;
+  gulong         finished_id;
+} ThunarJobExecutorItem;
+
+
+
+static void thunar_job_executor_start (ThunarJobExecutorItem *item,
+                                       ThunarJobPool          slot);
+
+
+
+static ThunarJobExecutorPool pools[THUNAR_JOB_N_POOLS];
+
+
+
+static void
+thunar_job_executor_init (void)
+{
+  static gboolean initialized = FALSE;
+
+  if (G_LIKELY (initialized))
+    return;
+
+  pools[THUNAR_JOB_POOL_INTERACTIVE].name = "interactive";
+  pools[THUNAR_JOB_POOL_INTERACTIVE].n_slots = THUNAR_JOB_EXECUTOR_SLOTS_INTERACTIVE;
+  pools[THUNAR_JOB_POOL_INTERACTIVE].wait_histogram = THUNAR_STATS_JOB_QUEUE_INTERACTIVE;
+
+  pools[THUNAR_JOB_POOL_BULK].name = "bulk";
+  pools[THUNAR_JOB_POOL_BULK].n_slots = THUNAR_JOB_EXECUTOR_SLOTS_BULK;
+  pools[THUNAR_JOB_POOL_BULK].wait_histogram = THUNAR_STATS_JOB_QUEUE_BULK;
+
+  pools[THUNAR_JOB_POOL_CPU].name = "cpu";
+  pools[THUNAR_JOB_POOL_CPU].n_slots = CLAMP (g_get_num_processors (), 2, THUNAR_JOB_EXECUTOR_SLOTS_CPU_MAX);
+  pools[THUNAR_JOB_POOL_CPU].wait_histogram = THUNAR_STATS_JOB_QUEUE_CPU;
+
+  g_queue_init (&pools[THUNAR_JOB_POOL_INTERACTIVE].queue);
+  g_queue_init (&pools[THUNAR_JOB_POOL_BULK].queue);
+  g_queue_init (&pools[THUNAR_JOB_POOL_CPU].queue);
+
+  initialized = TRUE;
+}
+
+
+
+static void
+thunar_job_executor_pump (void)
+{
+  ThunarJobExecutorItem *item;
+  gboolean               progress;
+  guint                  n, m;
+
+  do
+    {
+      progress = FALSE;
+
+      /* fill the own slots of each pool first */
+      for (n = 0; n < THUNAR_JOB_N_POOLS; ++n)
+        while (pools[n].n_running < pools[n].n_slots && !g_queue_is_empty (&pools[n].queue))
+          {
+            item = g_queue_pop_head (&pools[n].queue);
+            thunar_job_executor_start (item, n);
+          }
+
+      /* then let the waiting jobs steal from idle pools. A pool never
+       * lends its last free slot, so its own next job starts right away */
+      for (n = 0; n < THUNAR_JOB_N_POOLS; ++n)
+        for (m = 0; m < THUNAR_JOB_N_POOLS && !g_queue_is_empty (&pools[n].queue); ++m)
+          if (m != n && g_queue_is_empty (&pools[m].queue) && pools[m].n_running + 1 < pools[m].n_slots)
+            {
+              item = g_queue_pop_head (&pools[n].queue);
+              thunar_job_executor_start (item, m);
+              thunar_stats_count (THUNAR_STATS_JOB_POOL_STEAL);
+              progress = TRUE;
+            }
+    }
+  while (progress);
+}
+
+
+
+static void
+thunar_job_executor_finished (ThunarJob             *job,
+                              ThunarJobExecutorItem *item)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (item->job == job);
+  _thunar_return_if_fail (pools[item->slot].n_running > 0);
+
+  pools[item->slot].n_running--;
+
+  g_signal_handler_disconnect (job, item->finished_id);
+  g_object_unref (job);
+  g_slice_free (ThunarJobExecutorItem, item);
+
+  thunar_job_executor_pump ();
+}
+
+
+
+static void
+thunar_job_executor_start (ThunarJobExecutorItem *item,
+                           ThunarJobPool          slot)
+{
+  if (item->cancelled_id != 0)
+    g_cancellable_disconnect (item->cancellable, item->cancelled_id);
+  item->cancelled_id = 0;
+
+  thunar_stats_record_since (pools[item->pool].wait_histogram, item->queue_time);
+
+  item->slot = slot;
+  pools[slot].n_running++;
+
+  item->finished_id = g_signal_connect (item->job, "finished", G_CALLBACK (thunar_job_executor_finished), item);
+  exo_job_launch (EXO_JOB (item->job));
+}
+
+
+
+static gboolean
+thunar_job_executor_cancelled_idle (gpointer user_data)
+{
+  ThunarJobExecutorItem *item;
+  ThunarJob             *job = THUNAR_JOB (user_data);
+  GList                 *lp;
+  guint                  n;
+
+  /* a cancelled job must still run to emit "finished", but it returns
+   * right away, so it doesn't wait for a free slot */
+  for (n = 0; n < THUNAR_JOB_N_POOLS; ++n)
+    for (lp = pools[n].queue.head; lp != NULL; lp = lp->next)
+      {
+        item = lp->data;
+        if (item->job == job)
+          {
+            g_queue_delete_link (&pools[n].queue, lp);
+            thunar_job_executor_start (item, n);
+            return FALSE;
+          }
+      }
+
+  /* already started meanwhile */
+  return FALSE;
+}
+
+
+
+static void
+thunar_job_executor_cancelled (GCancellable *cancellable,
+                               ThunarJob    *job)
+{
+  /* may be called from any thread */
+  g_idle_add_full (G_PRIORITY_DEFAULT, thunar_job_executor_cancelled_idle,
+                   g_object_ref (job), g_object_unref);
+}
+
+
+
+/**
+ * thunar_job_executor_push:
+ * @job : a #ThunarJob, which was not launched yet.
+ *
+ * Queues @job in the pool returned by thunar_job_get_pool() and
+ * launches it as soon as a slot is free. The executor keeps a
+ * reference on @job until it emitted "finished".
+ **/
+void
+thunar_job_executor_push (ThunarJob *job)
+{
+  ThunarJobExecutorItem *item;
+  ThunarJobPool          pool;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  thunar_job_executor_init ();
+
+  pool = thunar_job_get_pool (job);
+  _thunar_return_if_fail (pool < THUNAR_JOB_N_POOLS);
+
+  item = g_slice_new0 (ThunarJobExecutorItem);
+  item->job = g_object_ref (job);
+  item->pool = pool;
+  item->queue_time = g_get_monotonic_time ();
+  item->cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  if (pools[pool].n_running < pools[pool].n_slots
+      || g_cancellable_is_cancelled (item->cancellable))
+    {
+      thunar_job_executor_start (item, pool);
+      return;
+    }
+
+  item->cancelled_id = g_cancellable_connect (item->cancellable, G_CALLBACK (thunar_job_executor_cancelled), job, NULL);
+  g_queue_push_tail (&pools[pool].queue, item);
+
+  /* maybe another pool has room */
+  thunar_job_executor_pump ();
+}
+
+
+
+/**
+ * thunar_job_executor_get_pool_name:
+ * @pool : a #ThunarJobPool.
+ *
+ * Return value: the name of @pool, used for its statistics.
+ **/
+const gchar *
+thunar_job_executor_get_pool_name (ThunarJobPool pool)
+{
+  _thunar_return_val_if_fail (pool < THUNAR_JOB_N_POOLS, NULL);
+
+  thunar_job_executor_init ();
+
+  return pools[pool].name;
+}
+
+
+
+/**
+ * thunar_job_executor_get_pool_state:
+ * @pool      : a #ThunarJobPool.
+ * @n_running : return location for the number of jobs running on the slots of @pool.
+ * @n_queued  : return location for the number of jobs waiting in @pool.
+ *
+ * Samples the current load of @pool.
+ **/
+void
+thunar_job_executor_get_pool_state (ThunarJobPool  pool,
+                                    guint         *n_running,
+                                    guint         *n_queued)
+{
+  _thunar_return_if_fail (pool < THUNAR_JOB_N_POOLS);
+
+  thunar_job_executor_init ();
+
+  if (n_running != NULL)
+    *n_running = pools[pool].n_running;
+  if (n_queued != NULL)
+    *n_queued = pools[pool].queue.length;
+}
@@ -16,6 +16,15 @@
  * this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-enum-types.h>
 #include <thunar/thunar-job-operation-history.h>
@@ -23,6 +32,7 @@
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <libxfce4ui/libxfce4ui.h>
+#include <libxfce4util/libxfce4util.h>
 
 /**
  * SECTION:thunar-job-operation-history
@@ -30,7 +40,19 @@
  * @Title: ThunarJobOperationHistory
  *
  * The single #ThunarJobOperationHistory instance stores all job operations in a #GList
- * and manages tools to manage the list and the next/previous operations which can be undone/redone */
+ * and manages tools to manage the list and the next/previous operations which can be undone/redone
+ *
+ * The history is persisted in an append-only log, one line per event, so it survives restarts:
+ * a line holding a serialized #ThunarJobOperation for every commit, "<" for an undo, ">" for
+ * a redo and "=" followed by the new timestamps for an update of the latest trash operation.
+ * On startup the log is mapped and only its tail is replayed. Once the log contains too many
+ * records which no longer matter, it is rewritten from the current list in a worker thread. */
+
+/* the log file, relative to the XDG data directory */
+#define THUNAR_JOB_OPERATION_HISTORY_LOG "Thunar/undo-history"
+
+/* number of log records above the current list length after which the log is compacted */
+#define THUNAR_JOB_OPERATION_HISTORY_LOG_SLACK (128)
 
 /* property identifiers */
 enum
@@ -46,6 +68,19 @@ static void thunar_job_operation_history_get_property (GObject    *object,
                                                        guint       prop_id,
                                                        GValue     *value,
                                                        GParamSpec *pspec);
+static void     thunar_job_operation_history_push          (ThunarJobOperationHistory *history,
+                                                            ThunarJobOperation        *job_operation);
+static void     thunar_job_operation_history_load          (ThunarJobOperationHistory *history);
+static void     thunar_job_operation_history_log           (ThunarJobOperationHistory *history,
+                                                            const gchar               *record);
+static gboolean thunar_job_operation_history_compact       (gpointer                   user_data);
+static void     thunar_job_operation_history_compact_write (GTask                     *task,
+                                                            gpointer                   source_object,
+                                                            gpointer                   task_data,
+                                                            GCancellable              *cancellable);
+static void     thunar_job_operation_history_compact_done  (GObject                   *source_object,
+                                                            GAsyncResult              *result,
+                                                            gpointer                   user_data);
 
 
 
@@ -53,8 +88,8 @@ struct _ThunarJobOperationHistory
 {
   GObject  __parent__;
 
-  /* List of job operations which were logged */
-  GList   *job_operation_list;
+  /* Queue of job operations which were logged, the oldest first */
+  GQueue   job_operation_list;
   gint     job_operation_list_max_size;
 
   /* since the job operation list, lp_undo and lp_redo all refer to the same memory locations,
@@ -66,6 +101,15 @@ struct _ThunarJobOperationHistory
 
   /* List pointer to the operation which can be redone */
   GList   *lp_redo;
+
+  /* the persistent log, its number of records and the records
+   * written while the log is rewritten by a compaction */
+  gchar   *log_path;
+  FILE    *log_file;
+  guint    log_records;
+  guint    log_compact_id;
+  gboolean log_compacting;
+  GString *log_pending;
 };
 
 static ThunarJobOperationHistory *job_operation_history;
@@ -107,7 +151,7 @@ thunar_job_operation_history_init (ThunarJobOperationHistory *self)
 {
   ThunarPreferences *preferences;
 
-  self->job_operation_list = NULL;
+  g_queue_init (&self->job_operation_list);
   self->lp_undo = NULL;
   self->lp_redo = NULL;
 
@@ -116,6 +160,12 @@ thunar_job_operation_history_init (ThunarJobOperationHistory *self)
   g_object_unref (preferences);
 
   g_mutex_init (&self->job_operation_list_mutex);
+
+  self->log_path = xfce_resource_save_location (XFCE_RESOURCE_DATA, THUNAR_JOB_OPERATION_HISTORY_LOG, TRUE);
+  self->log_pending = g_string_new (NULL);
+
+  /* restore the history of the previous sessions */
+  thunar_job_operation_history_load (self);
 }
 
 
@@ -127,7 +177,16 @@ thunar_job_operation_history_finalize (GObject *object)
 
   _thunar_return_if_fail (THUNAR_IS_JOB_OPERATION_HISTORY (history));
 
-  g_list_free_full (history->job_operation_list, g_object_unref);
+  if (history->log_compact_id != 0)
+    g_source_remove (history->log_compact_id);
+
+  if (history->log_file != NULL)
+    fclose (history->log_file);
+
+  g_string_free (history->log_pending, TRUE);
+  g_free (history->log_path);
+
+  g_queue_clear_full (&history->job_operation_list, g_object_unref);
 
   g_mutex_clear (&history->job_operation_list_mutex);
 
@@ -160,6 +219,294 @@ thunar_job_operation_history_get_property (GObject    *object,
 
 
 
+/* thunar_job_operation_history_push:
+ * @history:       a #ThunarJobOperationHistory
+ * @job_operation: a #ThunarJobOperation
+ *
+ * Adds @job_operation to the list, dropping the operations which were undone
+ * and the oldest ones beyond the maximum list size. Has to be called with the
+ * list mutex held.
+ **/
+static void
+thunar_job_operation_history_push (ThunarJobOperationHistory *history,
+                                   ThunarJobOperation        *job_operation)
+{
+  GQueue *list = &history->job_operation_list;
+
+  /* When a new operation is added, drop all previous operations which were undone from the list,
+   * these are exactly the ones behind the undo pointer */
+  if (history->lp_redo != NULL)
+    {
+      while (g_queue_peek_tail_link (list) != history->lp_undo)
+        g_object_unref (g_queue_pop_tail (list));
+    }
+
+  /* Add the new operation to our list */
+  g_queue_push_tail (list, g_object_ref (job_operation));
+
+  /* Limit the size of the list */
+  while (history->job_operation_list_max_size != -1 && list->length > (guint)(history->job_operation_list_max_size))
+    g_object_unref (g_queue_pop_head (list));
+
+  /* reset the undo pointer to latest operation and clear the redo pointer */
+  history->lp_undo = g_queue_peek_tail_link (list);
+  history->lp_redo = NULL;
+}
+
+
+
+/* thunar_job_operation_history_load:
+ * @history: a #ThunarJobOperationHistory
+ *
+ * Replays the tail of the persistent log into the list. Only the records
+ * which can still end up in the list are parsed, older ones are skipped
+ * and a compaction of the log is scheduled to drop them.
+ **/
+static void
+thunar_job_operation_history_load (ThunarJobOperationHistory *history)
+{
+  ThunarJobOperation *operation;
+  GMappedFile        *mapped_file;
+  const gchar        *contents;
+  const gchar        *start;
+  const gchar        *line;
+  const gchar        *end;
+  gchar             **timestamps;
+  gsize               length;
+  guint               n_operations = 0;
+
+  if (history->log_path == NULL || history->job_operation_list_max_size == 0)
+    return;
+
+  mapped_file = g_mapped_file_new (history->log_path, FALSE, NULL);
+  if (mapped_file == NULL)
+    return;
+
+  contents = g_mapped_file_get_contents (mapped_file);
+  length = g_mapped_file_get_length (mapped_file);
+
+  /* ignore a trailing record which was not completely written */
+  while (length > 0 && contents[length - 1] != '\n')
+    length--;
+
+  /* walk backwards to the first operation record which may still be in the list */
+  for (start = contents + length; start > contents; start = line)
+    {
+      for (line = start - 1; line > contents && line[-1] != '\n'; line--)
+        ;
+
+      if (*line != '<' && *line != '>' && *line != '=')
+        {
+          if (history->job_operation_list_max_size != -1
+              && n_operations == (guint) history->job_operation_list_max_size)
+            break;
+          n_operations++;
+        }
+    }
+
+  for (line = start; line < contents + length; line = end + 1)
+    {
+      end = memchr (line, '\n', contents + length - line);
+
+      if (*line == '<')
+        {
+          if (history->lp_undo != NULL)
+            {
+              history->lp_redo = history->lp_undo;
+              history->lp_undo = g_list_previous (history->lp_undo);
+            }
+        }
+      else if (*line == '>')
+        {
+          if (history->lp_redo != NULL)
+            {
+              history->lp_undo = history->lp_redo;
+              history->lp_redo = g_list_next (history->lp_redo);
+            }
+        }
+      else if (*line == '=')
+        {
+          gchar *record = g_strndup (line, end - line);
+
+          timestamps = g_strsplit (record, "\t", 3);
+          if (history->lp_undo != NULL && g_strv_length (timestamps) == 3)
+            {
+              thunar_job_operation_set_start_timestamp (history->lp_undo->data, g_ascii_strtoll (timestamps[1], NULL, 10));
+              thunar_job_operation_set_end_timestamp (history->lp_undo->data, g_ascii_strtoll (timestamps[2], NULL, 10));
+            }
+          g_strfreev (timestamps);
+          g_free (record);
+        }
+      else
+        {
+          operation = thunar_job_operation_new_from_record (line, end - line);
+          if (operation != NULL)
+            {
+              thunar_job_operation_history_push (history, operation);
+              g_object_unref (operation);
+            }
+        }
+
+      history->log_records++;
+    }
+
+  /* get rid of the skipped records */
+  if (start > contents)
+    history->log_compact_id = g_idle_add (thunar_job_operation_history_compact, history);
+
+  g_mapped_file_unref (mapped_file);
+}
+
+
+
+/* thunar_job_operation_history_log:
+ * @history: a #ThunarJobOperationHistory
+ * @record:  a newline terminated record
+ *
+ * Appends @record to the persistent log, or queues it while the log is
+ * compacted. Has to be called with the list mutex held.
+ **/
+static void
+thunar_job_operation_history_log (ThunarJobOperationHistory *history,
+                                  const gchar               *record)
+{
+  guint n_operations;
+
+  if (history->log_path == NULL || history->job_operation_list_max_size == 0)
+    return;
+
+  if (history->log_compacting)
+    {
+      g_string_append (history->log_pending, record);
+    }
+  else
+    {
+      if (history->log_file == NULL)
+        history->log_file = g_fopen (history->log_path, "a");
+
+      if (history->log_file != NULL)
+        {
+          fputs (record, history->log_file);
+          fflush (history->log_file);
+        }
+    }
+
+  history->log_records++;
+
+  /* rewrite the log once most of its records are obsolete, this may
+   * be called from a job thread, so schedule it in the main loop */
+  n_operations = history->job_operation_list.length;
+  if (history->log_records > 2 * n_operations + THUNAR_JOB_OPERATION_HISTORY_LOG_SLACK
+      && !history->log_compacting && history->log_compact_id == 0)
+    history->log_compact_id = g_idle_add (thunar_job_operation_history_compact, history);
+}
+
+
+
+static gboolean
+thunar_job_operation_history_compact (gpointer user_data)
+{
+  ThunarJobOperationHistory *history = THUNAR_JOB_OPERATION_HISTORY (user_data);
+  GString                   *contents;
+  GTask                     *task;
+  gchar                     *record;
+
+  g_mutex_lock (&history->job_operation_list_mutex);
+
+  history->log_compact_id = 0;
+  history->log_compacting = TRUE;
+  history->log_records = 0;
+
+  /* the new log holds all operations, followed by an undo record for each
+   * operation which was undone, which restores both list pointers */
+  contents = g_string_new (NULL);
+  for (GList *lp = history->job_operation_list.head; lp != NULL; lp = lp->next)
+    {
+      record = thunar_job_operation_to_record (lp->data);
+      g_string_append (contents, record);
+      g_free (record);
+      history->log_records++;
+    }
+  for (GList *lp = history->lp_redo; lp != NULL; lp = lp->next)
+    {
+      g_string_append (contents, "<\n");
+      history->log_records++;
+    }
+
+  /* records written from now on go to the new file */
+  if (history->log_file != NULL)
+    {
+      fclose (history->log_file);
+      history->log_file = NULL;
+    }
+
+  g_mutex_unlock (&history->job_operation_list_mutex);
+
+  task = g_task_new (history, NULL, thunar_job_operation_history_compact_done, NULL);
+  g_task_set_task_data (task, g_string_free (contents, FALSE), g_free);
+  g_task_run_in_thread (task, thunar_job_operation_history_compact_write);
+  g_object_unref (task);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_job_operation_history_compact_write (GTask        *task,
+                                            gpointer      source_object,
+                                            gpointer      task_data,
+                                            GCancellable *cancellable)
+{
+  ThunarJobOperationHistory *history = THUNAR_JOB_OPERATION_HISTORY (source_object);
+  GError                    *error = NULL;
+
+  if (!g_file_set_contents (history->log_path, task_data, -1, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+
+static void
+thunar_job_operation_history_compact_done (GObject      *source_object,
+                                           GAsyncResult *result,
+                                           gpointer      user_data)
+{
+  ThunarJobOperationHistory *history = THUNAR_JOB_OPERATION_HISTORY (source_object);
+  GError                    *error = NULL;
+
+  /* on failure the old log is untouched, so appending the pending records is still correct */
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_warning ("Failed to compact the undo history \"%s\": %s", history->log_path, error->message);
+      g_error_free (error);
+    }
+
+  g_mutex_lock (&history->job_operation_list_mutex);
+
+  history->log_compacting = FALSE;
+
+  if (history->log_pending->len > 0)
+    {
+      history->log_file = g_fopen (history->log_path, "a");
+      if (history->log_file != NULL)
+        {
+          fputs (history->log_pending->str, history->log_file);
+          fflush (history->log_file);
+        }
+      g_string_truncate (history->log_pending, 0);
+    }
+
+  g_mutex_unlock (&history->job_operation_list_mutex);
+}
+
+
+
 /**
  * thunar_job_operation_history_get_default:
  *
@@ -202,7 +549,7 @@ thunar_job_operation_history_get_default (void)
 void
 thunar_job_operation_history_commit (ThunarJobOperation *job_operation)
 {
-  GList* new_list = NULL;
+  gchar *record;
 
   _thunar_return_if_fail (THUNAR_IS_JOB_OPERATION (job_operation));
 
@@ -213,36 +560,17 @@ thunar_job_operation_history_commit (ThunarJobOperation *job_operation)
       thunar_job_operation_set_end_timestamp (job_operation, g_get_real_time () / (gint64) 1e6);
     }
 
-  g_mutex_lock (&job_operation_history->job_operation_list_mutex);
-
-  /* When a new operation is added, drop all previous operations which were undone from the list */
-  if (job_operation_history->lp_redo != NULL)
-    {
-      for (GList* lp = job_operation_history->job_operation_list;
-           lp != NULL && lp != job_operation_history->lp_redo;
-           lp = lp->next)
-        new_list = g_list_append (new_list, g_object_ref (lp->data));
-      g_list_free_full (job_operation_history->job_operation_list, g_object_unref);
-      job_operation_history->job_operation_list = new_list;
-    }
-
-  /* Add the new operation to our list */
-  job_operation_history->job_operation_list = g_list_append (job_operation_history->job_operation_list, g_object_ref (job_operation));
+  record = thunar_job_operation_to_record (job_operation);
 
-  /* reset the undo pointer to latest operation and clear the redo pointer */
-  job_operation_history->lp_undo = g_list_last (job_operation_history->job_operation_list);
-  job_operation_history->lp_redo = NULL;
+  g_mutex_lock (&job_operation_history->job_operation_list_mutex);
 
-  /* Limit the size of the list */
-  if (job_operation_history->job_operation_list_max_size != -1 && g_list_length (job_operation_history->job_operation_list) > (guint)(job_operation_history->job_operation_list_max_size))
-    {
-      GList* first = g_list_first (job_operation_history->job_operation_list);
-      job_operation_history->job_operation_list = g_list_remove_link (job_operation_history->job_operation_list, first);
-      g_list_free_full (first, g_object_unref);
-    }
+  thunar_job_operation_history_push (job_operation_history, job_operation);
+  thunar_job_operation_history_log (job_operation_history, record);
 
   g_mutex_unlock (&job_operation_history->job_operation_list_mutex);
 
+  g_free (record);
+
   /* Notify all subscribers of our properties */
   g_object_notify (G_OBJECT (job_operation_history), "can-undo");
   g_object_notify (G_OBJECT (job_operation_history), "can-redo");
@@ -277,6 +605,7 @@ thunar_job_operation_history_update_trash_timestamps (ThunarJobOperation *job_op
   if (thunar_job_operation_compare ( THUNAR_JOB_OPERATION (job_operation_history->lp_undo->data), job_operation) == 0)
     {
       gint64 start_timestamp, end_timestamp;
+      gchar *record;
 
       thunar_job_operation_get_timestamps (job_operation, &start_timestamp, &end_timestamp);
 
@@ -286,6 +615,10 @@ thunar_job_operation_history_update_trash_timestamps (ThunarJobOperation *job_op
 
       thunar_job_operation_set_start_timestamp (THUNAR_JOB_OPERATION (job_operation_history->lp_undo->data), start_timestamp);
       thunar_job_operation_set_end_timestamp (THUNAR_JOB_OPERATION (job_operation_history->lp_undo->data), end_timestamp);
+
+      record = g_strdup_printf ("=\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n", start_timestamp, end_timestamp);
+      thunar_job_operation_history_log (job_operation_history, record);
+      g_free (record);
     }
 
   g_mutex_unlock (&job_operation_history->job_operation_list_mutex);
@@ -328,6 +661,7 @@ thunar_job_operation_history_undo (void)
   /* fix position undo/redo pointers */
   job_operation_history->lp_redo = job_operation_history->lp_undo;
   job_operation_history->lp_undo = g_list_previous (job_operation_history->lp_undo);
+  thunar_job_operation_history_log (job_operation_history, "<\n");
 
   /* warn the user if the previous operation is empty, since then there is nothing to undo */
   if (thunar_job_operation_empty (operation_marker))
@@ -424,6 +758,7 @@ thunar_job_operation_history_redo (void)
   /* fix position undo/redo pointers */
   job_operation_history->lp_undo = job_operation_history->lp_redo;
   job_operation_history->lp_redo = g_list_next (job_operation_history->lp_redo);
+  thunar_job_operation_history_log (job_operation_history, ">\n");
 
   /* warn the user if the previous operation is empty, since then there is nothing to undo */
   if (thunar_job_operation_empty (operation_marker))
@@ -161,6 +161,39 @@ thunar_job_operation_add (ThunarJobOperation *job_operation,
 
 
 
+/**
+ * thunar_job_operation_add_files:
+ * @job_operation:    a #ThunarJobOperation
+ * @source_file_list: a #GList of #GFile<!---->s representing the source files
+ * @target_file_list: a #GList of #GFile<!---->s representing the target files
+ *
+ * Adds all pairs of @source_file_list and @target_file_list to the given
+ * job operation at once. Unlike thunar_job_operation_add(), descendants of
+ * files already in the operation are not filtered out, which keeps this
+ * linear for large batches of renames.
+ **/
+void
+thunar_job_operation_add_files (ThunarJobOperation *job_operation,
+                                GList              *source_file_list,
+                                GList              *target_file_list)
+{
+  GList *sources = NULL;
+  GList *targets = NULL;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB_OPERATION (job_operation));
+
+  for (GList *slp = source_file_list, *tlp = target_file_list; slp != NULL && tlp != NULL; slp = slp->next, tlp = tlp->next)
+    {
+      sources = g_list_prepend (sources, g_object_ref (slp->data));
+      targets = g_list_prepend (targets, g_object_ref (tlp->data));
+    }
+
+  job_operation->source_file_list = g_list_concat (job_operation->source_file_list, g_list_reverse (sources));
+  job_operation->target_file_list = g_list_concat (job_operation->target_file_list, g_list_reverse (targets));
+}
+
+
+
 /***
  * thunar_job_operation_overwrite:
  * @job_operation:    a #ThunarJobOperation
@@ -391,7 +424,6 @@ thunar_job_operation_execute (ThunarJobOperation *job_operation,
   ThunarJob         *job              = NULL;
   ThunarFile        *thunar_file;
   GFile             *parent_dir;
-  gchar             *display_name;
   GFile             *template_file;
   gboolean           operation_canceled = FALSE;
 
@@ -475,31 +507,10 @@ thunar_job_operation_execute (ThunarJobOperation *job_operation,
         break;
 
       case THUNAR_JOB_OPERATION_KIND_RENAME:
-        for (GList *slp = job_operation->source_file_list, *tlp = job_operation->target_file_list;
-             slp != NULL && tlp != NULL;
-             slp = slp->next, tlp = tlp->next)
-          {
-            display_name = thunar_g_file_get_display_name (tlp->data);
-            thunar_file = thunar_file_get (slp->data, &err);
-
-            if (err != NULL)
-              {
-                g_warning ("Error while renaming files: %s\n", err->message);
-                g_propagate_error (error, err);
-
-                g_free (display_name);
-                if (thunar_file)
-                  g_object_unref (thunar_file);
-
-                continue;
-              }
-
-            job = thunar_io_jobs_rename_file (thunar_file, display_name, THUNAR_OPERATION_LOG_NO_OPERATIONS);
-            exo_job_launch (EXO_JOB (job));
-
-            g_free (display_name);
-            g_object_unref (thunar_file);
-          }
+        /* a single batch, so files which swapped names can swap back */
+        job = thunar_io_jobs_rename_files (job_operation->source_file_list, job_operation->target_file_list,
+                                           THUNAR_OPERATION_LOG_NO_OPERATIONS);
+        thunar_job_launch (THUNAR_JOB (job));
         break;
 
       case THUNAR_JOB_OPERATION_KIND_RESTORE:
@@ -629,6 +640,167 @@ thunar_job_operation_compare (ThunarJobOperation *operation1,
 
 
 
+/**
+ * thunar_job_operation_to_record:
+ * @job_operation: a #ThunarJobOperation
+ *
+ * Serializes @job_operation into a single line, as stored in the
+ * persistent undo log. The line contains the operation kind, both
+ * timestamps and the URIs of all source, target and overwritten
+ * files, separated by tabs. See thunar_job_operation_new_from_record().
+ *
+ * Return value: (transfer full): the newly allocated, newline terminated record
+ **/
+gchar *
+thunar_job_operation_to_record (ThunarJobOperation *job_operation)
+{
+  GEnumClass *enum_class;
+  GEnumValue *enum_value;
+  GString    *record;
+  gchar      *uri;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB_OPERATION (job_operation), NULL);
+
+  /* use the untranslated enum name, the nick is translatable */
+  enum_class = g_type_class_ref (THUNAR_TYPE_JOB_OPERATION_KIND);
+  enum_value = g_enum_get_value (enum_class, job_operation->operation_kind);
+
+  record = g_string_new (enum_value->value_name);
+  g_string_append_printf (record, "\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT,
+                          job_operation->start_timestamp, job_operation->end_timestamp);
+
+  g_type_class_unref (enum_class);
+
+  for (GList *lp = job_operation->source_file_list; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (lp->data);
+      g_string_append_printf (record, "\ts%s", uri);
+      g_free (uri);
+    }
+
+  for (GList *lp = job_operation->target_file_list; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (lp->data);
+      g_string_append_printf (record, "\tt%s", uri);
+      g_free (uri);
+    }
+
+  for (GList *lp = job_operation->overwritten_files; lp != NULL; lp = lp->next)
+    {
+      uri = g_file_get_uri (lp->data);
+      g_string_append_printf (record, "\to%s", uri);
+      g_free (uri);
+    }
+
+  g_string_append_c (record, '\n');
+
+  return g_string_free (record, FALSE);
+}
+
+
+
+/**
+ * thunar_job_operation_new_from_record:
+ * @record: a record as returned by thunar_job_operation_to_record()
+ * @length: the length of @record, without the trailing newline
+ *
+ * Recreates a #ThunarJobOperation from a line of the persistent undo log.
+ * @record does not need to be nul-terminated.
+ *
+ * Return value: (transfer full): the newly created #ThunarJobOperation, or
+ *               %NULL if @record is malformed
+ **/
+ThunarJobOperation *
+thunar_job_operation_new_from_record (const gchar *record,
+                                      gsize        length)
+{
+  ThunarJobOperation *operation;
+  GEnumClass         *enum_class;
+  GEnumValue         *enum_value;
+  gchar             **fields;
+  gchar              *line;
+  gchar              *end;
+  gint64              start_timestamp;
+  gint64              end_timestamp;
+  GList              *sources = NULL;
+  GList              *targets = NULL;
+  GList              *overwritten = NULL;
+  GList             **list;
+  guint               n;
+
+  _thunar_return_val_if_fail (record != NULL, NULL);
+
+  line = g_strndup (record, length);
+  fields = g_strsplit (line, "\t", -1);
+  g_free (line);
+
+  if (g_strv_length (fields) < 3)
+    {
+      g_strfreev (fields);
+      return NULL;
+    }
+
+  enum_class = g_type_class_ref (THUNAR_TYPE_JOB_OPERATION_KIND);
+  enum_value = g_enum_get_value_by_name (enum_class, fields[0]);
+  g_type_class_unref (enum_class);
+
+  start_timestamp = g_ascii_strtoll (fields[1], &end, 10);
+  if (enum_value == NULL || *end != '\0')
+    {
+      g_strfreev (fields);
+      return NULL;
+    }
+
+  end_timestamp = g_ascii_strtoll (fields[2], &end, 10);
+  if (*end != '\0')
+    {
+      g_strfreev (fields);
+      return NULL;
+    }
+
+  for (n = 3; fields[n] != NULL; n++)
+    {
+      switch (fields[n][0])
+        {
+        case 's':
+          list = &sources;
+          break;
+
+        case 't':
+          list = &targets;
+          break;
+
+        case 'o':
+          list = &overwritten;
+          break;
+
+        default:
+          list = NULL;
+          break;
+        }
+
+      /* skip unknown or empty fields, which may come from a newer version */
+      if (list == NULL || fields[n][1] == '\0')
+        continue;
+
+      *list = g_list_prepend (*list, g_file_new_for_uri (fields[n] + 1));
+    }
+
+  g_strfreev (fields);
+
+  operation = g_object_new (THUNAR_TYPE_JOB_OPERATION, NULL);
+  operation->operation_kind = enum_value->value;
+  operation->start_timestamp = start_timestamp;
+  operation->end_timestamp = end_timestamp;
+  operation->source_file_list = g_list_reverse (sources);
+  operation->target_file_list = g_list_reverse (targets);
+  operation->overwritten_files = g_list_reverse (overwritten);
+
+  return operation;
+}
+
+
+
 /* thunar_job_operation_restore_from_trash::
  * @operation: operation containing the information for the files which must be restored
  * @error:     a GError instance for error handling
@@ -721,10 +893,21 @@ thunar_job_operation_restore_from_trash (ThunarJobOperation  *operation,
 
       /* get the original path of the file before deletion */
       original_path = g_file_info_get_attribute_byte_string (info, G_FILE_ATTRIBUTE_TRASH_ORIG_PATH);
+      if (G_UNLIKELY (original_path == NULL))
+        {
+          g_object_unref (info);
+          continue;
+        }
       original_file = g_file_new_for_path (original_path);
 
       /* get the deletion date reported by the file */
       date = g_file_info_get_deletion_date (info);
+      if (G_UNLIKELY (date == NULL))
+        {
+          g_object_unref (original_file);
+          g_object_unref (info);
+          continue;
+        }
       deletion_time = g_date_time_to_unix (date);
       g_date_time_unref (date);
 
@@ -737,12 +920,12 @@ thunar_job_operation_restore_from_trash (ThunarJobOperation  *operation,
         {
           trashed_file = g_file_get_child (trash, g_file_info_get_name (info));
 
-          source_file_list = thunar_g_list_append_deep (source_file_list, trashed_file);
-          target_file_list = thunar_g_list_append_deep (target_file_list, original_file);
-
+          source_file_list = g_list_prepend (source_file_list, trashed_file);
+          target_file_list = g_list_prepend (target_file_list, g_object_ref (original_file));
         }
 
       g_object_unref (original_file);
+      g_object_unref (info);
     }
 
   g_object_unref (trash);
@@ -750,6 +933,10 @@ thunar_job_operation_restore_from_trash (ThunarJobOperation  *operation,
 
   if (source_file_list != NULL && target_file_list != NULL)
     {
+      /* keep the order of the trash, the home trash is renamed from in one go */
+      source_file_list = g_list_reverse (source_file_list);
+      target_file_list = g_list_reverse (target_file_list);
+
       /* restore the lists asynchronously using a move operation */
       application = thunar_application_get ();
       thunar_application_move_files (application, NULL, source_file_list, target_file_list, THUNAR_OPERATION_LOG_NO_OPERATIONS, NULL);
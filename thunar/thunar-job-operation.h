@@ -31,6 +31,9 @@ ThunarJobOperation     *thunar_job_operation_new                   (ThunarJobOpe
 void                    thunar_job_operation_add                   (ThunarJobOperation    *job_operation,
                                                                     GFile                 *source_file,
                                                                     GFile                 *target_file);
+void                    thunar_job_operation_add_files             (ThunarJobOperation    *job_operation,
+                                                                    GList                 *source_file_list,
+                                                                    GList                 *target_file_list);
 void                    thunar_job_operation_overwrite             (ThunarJobOperation    *job_operation,
                                                                     GFile                 *overwritten_file);
 ThunarJobOperation     *thunar_job_operation_new_invert            (ThunarJobOperation    *job_operation);
@@ -49,6 +52,9 @@ const gchar            *thunar_job_operation_get_kind_nick         (ThunarJobOpe
 ThunarJobOperationKind  thunar_job_operation_get_kind              (ThunarJobOperation    *job_operation);
 const GList            *thunar_job_operation_get_overwritten_files (ThunarJobOperation    *job_operation);
 gboolean                thunar_job_operation_empty                 (ThunarJobOperation    *job_operation);
+gchar                  *thunar_job_operation_to_record             (ThunarJobOperation    *job_operation);
+ThunarJobOperation     *thunar_job_operation_new_from_record       (const gchar           *record,
+                                                                    gsize                  length);
 
 
 G_END_DECLS
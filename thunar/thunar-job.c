@@ -22,12 +22,24 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 #ifdef HAVE_MEMORY_H
 #include <memory.h>
 #endif
+#ifdef HAVE_SCHED_H
+#include <sched.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <exo/exo.h>
 
@@ -35,11 +47,28 @@
 
 #include <thunar/thunar-enum-types.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-job-executor.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-private.h>
 
 
 
+/* per-thread I/O and CPU classes only exist on Linux */
+#if defined (SYS_gettid) && defined (SYS_ioprio_set)
+#define THUNAR_JOB_HAVE_THREAD_PRIORITY 1
+
+/* see ioprio_set(2) */
+#define THUNAR_JOB_IOPRIO_WHO_PROCESS 1
+#define THUNAR_JOB_IOPRIO_VALUE(class, data) (((class) << 13) | (data))
+#endif
+
+
+
+/* the rate the progress of a running job is sampled in the main loop */
+#define THUNAR_JOB_PROGRESS_INTERVAL (100) /* ms */
+
+
+
 /* Signal identifiers */
 enum
 {
@@ -55,6 +84,10 @@ enum
 
 
 static void              thunar_job_finalize            (GObject            *object);
+static gboolean          thunar_job_progress_sample     (gpointer            user_data);
+static gboolean          thunar_job_progress_stop       (gpointer            user_data);
+static gboolean          thunar_job_execute             (ExoJob             *job,
+                                                         GError            **error);
 static ThunarJobResponse thunar_job_real_ask            (ThunarJob          *job,
                                                          const gchar        *message,
                                                          ThunarJobResponse   choices);
@@ -76,6 +109,22 @@ struct _ThunarJobPrivate
   gboolean                  paused; /* the job has been manually paused using the UI */
   gboolean                  frozen; /* the job has been automaticaly paused regarding some parallel copy behavior */
   ThunarOperationLogMode    log_mode;
+
+  /* the scheduling class, applied to the worker thread while the job runs */
+  GMutex                    priority_mutex;
+  ThunarJobPriority         priority;
+  gint                      thread_id;
+
+  /* the executor pool the job is launched in */
+  ThunarJobPool             pool;
+
+  /* progress published by the worker and sampled by a timeout in the
+   * main loop, so it is not emitted for every chunk or file */
+  gint                      progress_percent;  /* 1/100 %, -1 if unset */
+  gpointer                  progress_message;  /* gchar *, owned by the slot */
+  gint                      progress_sampling; /* the timeout was added */
+  guint                     progress_source_id;
+  gint                      sampled_percent;   /* main thread only */
 };
 
 
@@ -104,10 +153,14 @@ static void
 thunar_job_class_init (ThunarJobClass *klass)
 {
   GObjectClass *gobject_class;
+  ExoJobClass  *exojob_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_job_finalize;
 
+  exojob_class = EXO_JOB_CLASS (klass);
+  exojob_class->execute = thunar_job_execute;
+
   klass->ask = thunar_job_real_ask;
   klass->ask_replace = thunar_job_real_ask_replace;
 
@@ -249,6 +302,15 @@ thunar_job_init (ThunarJob *job)
   job->priv->pausable = FALSE;
   job->priv->paused = FALSE;
   job->priv->frozen = FALSE;
+  job->priv->priority = THUNAR_JOB_PRIORITY_NORMAL;
+  job->priv->thread_id = 0;
+  job->priv->pool = THUNAR_JOB_POOL_INTERACTIVE;
+  job->priv->progress_percent = -1;
+  job->priv->progress_message = NULL;
+  job->priv->progress_sampling = FALSE;
+  job->priv->progress_source_id = 0;
+  job->priv->sampled_percent = -1;
+  g_mutex_init (&job->priv->priority_mutex);
 }
 
 
@@ -256,11 +318,99 @@ thunar_job_init (ThunarJob *job)
 static void
 thunar_job_finalize (GObject *object)
 {
+  ThunarJob *job = THUNAR_JOB (object);
+
+  g_mutex_clear (&job->priv->priority_mutex);
+  g_free (job->priv->progress_message);
+
   (*G_OBJECT_CLASS (thunar_job_parent_class)->finalize) (object);
 }
 
 
 
+static void
+thunar_job_apply_priority (gint              thread_id,
+                           ThunarJobPriority priority)
+{
+#ifdef THUNAR_JOB_HAVE_THREAD_PRIORITY
+  struct sched_param param = { 0, };
+  gint               ioprio;
+
+  /* map the class to an I/O priority: best-effort level 0 for interactive
+   * jobs, "none" (follow the CPU nice value, like every other thread) for
+   * normal ones, best-effort level 7 for background and the idle class */
+  switch (priority)
+    {
+    case THUNAR_JOB_PRIORITY_INTERACTIVE:
+      ioprio = THUNAR_JOB_IOPRIO_VALUE (2, 0);
+      break;
+
+    case THUNAR_JOB_PRIORITY_BACKGROUND:
+      ioprio = THUNAR_JOB_IOPRIO_VALUE (2, 7);
+      break;
+
+    case THUNAR_JOB_PRIORITY_IDLE:
+      ioprio = THUNAR_JOB_IOPRIO_VALUE (3, 0);
+      break;
+
+    default:
+      ioprio = THUNAR_JOB_IOPRIO_VALUE (0, 0);
+      break;
+    }
+
+  if (syscall (SYS_ioprio_set, THUNAR_JOB_IOPRIO_WHO_PROCESS, thread_id, ioprio) < 0)
+    g_debug ("Failed to set the I/O priority of thread %d: %s", thread_id, g_strerror (errno));
+
+  /* the worker threads are shared, so do not touch the nice value: it can
+   * not be lowered again without privileges. SCHED_BATCH gives the same
+   * "don't preempt the UI" effect and switching back is always allowed */
+#ifdef SCHED_BATCH
+  if (sched_setscheduler (thread_id, priority >= THUNAR_JOB_PRIORITY_BACKGROUND ? SCHED_BATCH : SCHED_OTHER, &param) < 0)
+    g_debug ("Failed to set the scheduling policy of thread %d: %s", thread_id, g_strerror (errno));
+#endif
+#endif
+}
+
+
+
+static gboolean
+thunar_job_execute (ExoJob  *job,
+                    GError **error)
+{
+  ThunarJobPrivate *priv = THUNAR_JOB (job)->priv;
+  gboolean          success;
+
+  _thunar_return_val_if_fail (THUNAR_JOB_GET_CLASS (job)->execute != NULL, FALSE);
+
+#ifdef THUNAR_JOB_HAVE_THREAD_PRIORITY
+  /* remember the worker thread, so the class can be changed while we run */
+  g_mutex_lock (&priv->priority_mutex);
+  priv->thread_id = syscall (SYS_gettid);
+  if (priv->priority != THUNAR_JOB_PRIORITY_NORMAL)
+    thunar_job_apply_priority (priv->thread_id, priv->priority);
+  g_mutex_unlock (&priv->priority_mutex);
+#endif
+
+  success = (*THUNAR_JOB_GET_CLASS (job)->execute) (job, error);
+
+  /* deliver the last progress before the job finishes */
+  if (g_atomic_int_get (&priv->progress_sampling))
+    exo_job_send_to_mainloop (job, thunar_job_progress_stop, g_object_ref (job), g_object_unref);
+
+#ifdef THUNAR_JOB_HAVE_THREAD_PRIORITY
+  /* hand the thread back to the pool the way we found it */
+  g_mutex_lock (&priv->priority_mutex);
+  if (priv->priority != THUNAR_JOB_PRIORITY_NORMAL)
+    thunar_job_apply_priority (priv->thread_id, THUNAR_JOB_PRIORITY_NORMAL);
+  priv->thread_id = 0;
+  g_mutex_unlock (&priv->priority_mutex);
+#endif
+
+  return success;
+}
+
+
+
 static ThunarJobResponse
 thunar_job_real_ask (ThunarJob        *job,
                      const gchar      *message,
@@ -779,31 +929,160 @@ thunar_job_is_frozen (ThunarJob *job)
 
 
 
+static gpointer
+thunar_job_progress_swap_message (ThunarJob *job,
+                                  gchar     *message)
+{
+  gpointer old_message;
+
+  do
+    old_message = g_atomic_pointer_get (&job->priv->progress_message);
+  while (!g_atomic_pointer_compare_and_exchange (&job->priv->progress_message, old_message, message));
+
+  return old_message;
+}
+
+
+
+static gboolean
+thunar_job_progress_sample (gpointer user_data)
+{
+  ThunarJob *job = THUNAR_JOB (user_data);
+  gchar     *message;
+  gint       percent;
+
+  message = thunar_job_progress_swap_message (job, NULL);
+  if (message != NULL)
+    {
+      g_signal_emit_by_name (job, "info-message", message);
+      g_free (message);
+    }
+
+  percent = g_atomic_int_get (&job->priv->progress_percent);
+  if (percent >= 0 && percent != job->priv->sampled_percent)
+    {
+      job->priv->sampled_percent = percent;
+      g_signal_emit_by_name (job, "percent", percent / 100.0);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static gboolean
+thunar_job_progress_stop (gpointer user_data)
+{
+  ThunarJob *job = THUNAR_JOB (user_data);
+
+  if (job->priv->progress_source_id != 0)
+    {
+      g_source_remove (job->priv->progress_source_id);
+      job->priv->progress_source_id = 0;
+    }
+
+  thunar_job_progress_sample (job);
+
+  /* a relaunched job starts over */
+  g_atomic_int_set (&job->priv->progress_sampling, FALSE);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_job_progress_start (ThunarJob *job)
+{
+  if (G_LIKELY (g_atomic_int_get (&job->priv->progress_sampling)))
+    return;
+
+  if (g_atomic_int_compare_and_exchange (&job->priv->progress_sampling, FALSE, TRUE))
+    {
+      job->priv->progress_source_id = g_timeout_add_full (G_PRIORITY_DEFAULT, THUNAR_JOB_PROGRESS_INTERVAL,
+                                                          thunar_job_progress_sample,
+                                                          g_object_ref (job), g_object_unref);
+    }
+}
+
+
+
+/**
+ * thunar_job_set_percent:
+ * @job     : a #ThunarJob.
+ * @percent : the progress of @job, between 0.0 and 100.0.
+ *
+ * Publishes the progress of @job. Unlike exo_job_percent(), this does
+ * not wait for the main loop: the value is picked up by a timeout a few
+ * times a second and emitted as "percent" if it changed, so this can be
+ * called for every chunk of data.
+ *
+ * This function is thread-safe.
+ **/
+void
+thunar_job_set_percent (ThunarJob *job,
+                        gdouble    percent)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  g_atomic_int_set (&job->priv->progress_percent, (gint) (CLAMP (percent, 0.0, 100.0) * 100.0));
+  thunar_job_progress_start (job);
+}
+
+
+
+/**
+ * thunar_job_set_info_message:
+ * @job    : a #ThunarJob.
+ * @format : a printf-style format string.
+ * @...    : the arguments for @format.
+ *
+ * Publishes an info message for @job, like exo_job_info_message(). The
+ * message is emitted as "info-message" with the next progress sample,
+ * where a newer message replaces one which was not emitted yet.
+ *
+ * This function is thread-safe.
+ **/
+void
+thunar_job_set_info_message (ThunarJob   *job,
+                             const gchar *format,
+                             ...)
+{
+  va_list var_args;
+  gchar  *message;
+
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (format != NULL);
+
+  va_start (var_args, format);
+  message = g_strdup_vprintf (format, var_args);
+  va_end (var_args);
+
+  g_free (thunar_job_progress_swap_message (job, message));
+  thunar_job_progress_start (job);
+}
+
+
+
 void
 thunar_job_processing_file (ThunarJob *job,
                             GList     *current_file,
                             guint      n_processed)
 {
   gchar *base_name;
-  gchar *display_name;
 
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (current_file != NULL);
 
-  /* emit only if n_processed is a multiple of 8 */
-  if ((n_processed % 8) != 0)
-    return;
-
   base_name = g_file_get_basename (current_file->data);
-  display_name = g_filename_display_name (base_name);
+  g_free (thunar_job_progress_swap_message (job, g_filename_display_name (base_name)));
   g_free (base_name);
 
-  exo_job_info_message (EXO_JOB (job), "%s", display_name);
-  g_free (display_name);
-
   /* verify that we have total files set */
   if (G_LIKELY (job->priv->n_total_files > 0))
-    exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / job->priv->n_total_files);
+    g_atomic_int_set (&job->priv->progress_percent, (gint) ((n_processed * 10000.0) / job->priv->n_total_files));
+
+  thunar_job_progress_start (job);
 }
 
 
@@ -822,3 +1101,110 @@ thunar_job_get_log_mode (ThunarJob *job)
 {
   return job->priv->log_mode;
 }
+
+
+
+/**
+ * thunar_job_set_priority:
+ * @job      : a #ThunarJob.
+ * @priority : the new #ThunarJobPriority.
+ *
+ * Sets the I/O and CPU class of the thread running @job. This can be
+ * called before the job is launched or, e.g. when the user asks to run
+ * a transfer in the background, while it is running.
+ **/
+void
+thunar_job_set_priority (ThunarJob        *job,
+                         ThunarJobPriority priority)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  g_mutex_lock (&job->priv->priority_mutex);
+  if (job->priv->priority != priority)
+    {
+      job->priv->priority = priority;
+      if (job->priv->thread_id != 0)
+        thunar_job_apply_priority (job->priv->thread_id, priority);
+    }
+  g_mutex_unlock (&job->priv->priority_mutex);
+}
+
+
+
+/**
+ * thunar_job_get_priority:
+ * @job : a #ThunarJob.
+ *
+ * Return value: the #ThunarJobPriority of @job.
+ **/
+ThunarJobPriority
+thunar_job_get_priority (ThunarJob *job)
+{
+  ThunarJobPriority priority;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_PRIORITY_NORMAL);
+
+  g_mutex_lock (&job->priv->priority_mutex);
+  priority = job->priv->priority;
+  g_mutex_unlock (&job->priv->priority_mutex);
+
+  return priority;
+}
+
+
+
+/**
+ * thunar_job_set_pool:
+ * @job  : a #ThunarJob.
+ * @pool : the #ThunarJobPool to launch @job in.
+ *
+ * Sets the pool of the job executor, which @job waits in for
+ * a free slot when it is launched with thunar_job_launch().
+ **/
+void
+thunar_job_set_pool (ThunarJob    *job,
+                     ThunarJobPool pool)
+{
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (pool < THUNAR_JOB_N_POOLS);
+
+  job->priv->pool = pool;
+}
+
+
+
+/**
+ * thunar_job_get_pool:
+ * @job : a #ThunarJob.
+ *
+ * Return value: the #ThunarJobPool of @job.
+ **/
+ThunarJobPool
+thunar_job_get_pool (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), THUNAR_JOB_POOL_INTERACTIVE);
+
+  return job->priv->pool;
+}
+
+
+
+/**
+ * thunar_job_launch:
+ * @job : a #ThunarJob.
+ *
+ * Launches @job through the job executor, from the main thread. Unlike
+ * exo_job_launch(), the job may wait for a slot of its pool before it
+ * runs, but it emits its signals the same way.
+ *
+ * Return value: @job.
+ **/
+ThunarJob *
+thunar_job_launch (ThunarJob *job)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
+
+  thunar_job_executor_push (job);
+
+  return job;
+}
@@ -50,6 +50,10 @@ struct _ThunarJobClass
 
   /*< public >*/
 
+  /* virtual methods, run in the worker thread */
+  gboolean          (*execute)     (ExoJob           *job,
+                                    GError          **error);
+
   /* signals */
   ThunarJobResponse (*ask)         (ThunarJob        *job,
                                     const gchar      *message,
@@ -78,6 +82,11 @@ void              thunar_job_freeze                 (ThunarJob       *job);
 void              thunar_job_unfreeze               (ThunarJob       *job);
 gboolean          thunar_job_is_paused              (ThunarJob       *job);
 gboolean          thunar_job_is_frozen              (ThunarJob       *job);
+void              thunar_job_set_percent            (ThunarJob       *job,
+                                                     gdouble          percent);
+void              thunar_job_set_info_message       (ThunarJob       *job,
+                                                     const gchar     *format,
+                                                     ...) G_GNUC_PRINTF (2, 3);
 void              thunar_job_processing_file        (ThunarJob       *job,
                                                      GList           *current_file,
                                                      guint            n_processed);
@@ -109,6 +118,16 @@ void              thunar_job_new_files              (ThunarJob       *job,
 void                    thunar_job_set_log_mode     (ThunarJob              *job,
                                                      ThunarOperationLogMode  log_mode);
 ThunarOperationLogMode  thunar_job_get_log_mode     (ThunarJob *job);
+
+void                    thunar_job_set_priority     (ThunarJob              *job,
+                                                     ThunarJobPriority       priority);
+ThunarJobPriority       thunar_job_get_priority     (ThunarJob              *job);
+
+void                    thunar_job_set_pool         (ThunarJob              *job,
+                                                     ThunarJobPool           pool);
+ThunarJobPool           thunar_job_get_pool         (ThunarJob              *job);
+
+ThunarJob              *thunar_job_launch           (ThunarJob              *job);
 G_END_DECLS
 
 #endif /* !__THUNAR_JOB_H__ */
@@ -35,12 +35,15 @@
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-free-space-cache.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-list-model.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-search-backend.h>
 #include <thunar/thunar-user.h>
 #include <thunar/thunar-simple-job.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
@@ -66,20 +69,105 @@ enum
 {
   ERROR,
   SEARCH_DONE,
+  CHANGES_PENDING,
   LAST_SIGNAL,
 };
 
 
 
+/* minimum number of files, and the minimum ratio of rows to new
+ * files, for which thunar_list_model_insert_files() merges a sorted
+ * batch into the rows instead of inserting every file on its own */
+#define THUNAR_LIST_MODEL_BULK_INSERT_MIN   64
+#define THUNAR_LIST_MODEL_BULK_INSERT_RATIO 4
+
+/* number of rows from which sorting by a numeric key is split
+ * across (at most THUNAR_LIST_MODEL_SORT_THREADS_MAX) threads */
+#define THUNAR_LIST_MODEL_PARALLEL_SORT_MIN 20000
+#define THUNAR_LIST_MODEL_SORT_THREADS_MAX  8
+
+/* number of threads walking the folders of a recursive search, and the
+ * number of folders which may wait for a thread before the threads
+ * descend into new subfolders themselves */
+#define THUNAR_LIST_MODEL_SEARCH_THREADS_MAX 8
+#define THUNAR_LIST_MODEL_SEARCH_QUEUE_MAX   4096
+
+/* number of indexed search results passed to the model at once */
+#define THUNAR_LIST_MODEL_SEARCH_INDEX_BATCH 256
+
+/* interval (in ms) in which search results are moved into the model, the
+ * time (in us) each move may take and the number of files moved at once */
+#define THUNAR_LIST_MODEL_SEARCH_UPDATE_INTERVAL 50
+#define THUNAR_LIST_MODEL_SEARCH_UPDATE_BUDGET   8000
+#define THUNAR_LIST_MODEL_SEARCH_UPDATE_CHUNK    128
+
+/* size of the blocks in which file contents are searched, and the
+ * number of bytes at the start of a file checked for binary data */
+#define THUNAR_LIST_MODEL_SEARCH_CONTENTS_CHUNK 65536
+#define THUNAR_LIST_MODEL_SEARCH_CONTENTS_SNIFF 4096
+
+/* scores of a fuzzy match, see thunar_list_model_search_fuzzy_score(): every
+ * matched character scores, more so at the start of a word or right after the
+ * previously matched one, and the characters skipped in between cost a bit */
+#define THUNAR_LIST_MODEL_FUZZY_MATCH         16
+#define THUNAR_LIST_MODEL_FUZZY_BOUNDARY       8
+#define THUNAR_LIST_MODEL_FUZZY_CONSECUTIVE    6
+#define THUNAR_LIST_MODEL_FUZZY_GAP_START      3
+#define THUNAR_LIST_MODEL_FUZZY_GAP_EXTENSION  1
+
+/* number of queued changed files from which thunar_list_model_apply_changes()
+ * sorts all rows once, instead of moving every changed row on its own */
+#define THUNAR_LIST_MODEL_CHANGES_RESORT_MIN 64
+
+/* interval (in seconds) in which the cached strings of relative
+ * dates ("Today", "Yesterday", ...) are considered outdated */
+#define THUNAR_LIST_MODEL_FORMAT_INTERVAL 60
+
+/* minimum number of files of a folder for which the models share their
+ * orderings, and the number of orderings kept per folder */
+#define THUNAR_LIST_MODEL_INDEX_MIN        1024
+#define THUNAR_LIST_MODEL_INDEX_ORDERS_MAX 3
+
+
+
+/* string columns whose formatted values are cached per row */
+enum
+{
+  THUNAR_LIST_MODEL_CACHE_DATE_CREATED,
+  THUNAR_LIST_MODEL_CACHE_DATE_ACCESSED,
+  THUNAR_LIST_MODEL_CACHE_DATE_MODIFIED,
+  THUNAR_LIST_MODEL_CACHE_DATE_DELETED,
+  THUNAR_LIST_MODEL_CACHE_RECENCY,
+  THUNAR_LIST_MODEL_CACHE_GROUP,
+  THUNAR_LIST_MODEL_CACHE_OWNER,
+  THUNAR_LIST_MODEL_CACHE_PERMISSIONS,
+  THUNAR_LIST_MODEL_CACHE_SIZE,
+  THUNAR_LIST_MODEL_CACHE_SIZE_IN_BYTES,
+  THUNAR_LIST_MODEL_N_CACHED,
+};
+
+
+
+typedef struct _ThunarListModelRowCache ThunarListModelRowCache;
+typedef struct _ThunarListModelSummary  ThunarListModelSummary;
+
 typedef gint (*ThunarSortFunc) (const ThunarFile *a,
                                 const ThunarFile *b,
                                 gboolean          case_sensitive);
 
+typedef struct _ThunarListModelSortKey   ThunarListModelSortKey;
+typedef struct _ThunarListModelSortChunk ThunarListModelSortChunk;
+typedef struct _ThunarListModelIndex     ThunarListModelIndex;
+typedef struct _ThunarListModelOrder     ThunarListModelOrder;
+typedef struct _ThunarListModelSearchWalk ThunarListModelSearchWalk;
+typedef struct _ThunarListModelNameKey   ThunarListModelNameKey;
+
 static void               thunar_list_model_tree_model_init             (GtkTreeModelIface            *iface);
 static void               thunar_list_model_drag_dest_init              (GtkTreeDragDestIface         *iface);
 static void               thunar_list_model_sortable_init               (GtkTreeSortableIface         *iface);
 static void               thunar_list_model_dispose                     (GObject                      *object);
 static void               thunar_list_model_finalize                    (GObject                      *object);
+static void               thunar_list_model_name_keys_drop              (ThunarListModel              *store);
 static void               thunar_list_model_get_property                (GObject                      *object,
                                                                          guint                         prop_id,
                                                                          GValue                       *value,
@@ -142,10 +230,31 @@ static gboolean           thunar_list_model_has_default_sort_func       (GtkTree
 static gint               thunar_list_model_cmp_func                    (gconstpointer                 a,
                                                                          gconstpointer                 b,
                                                                          gpointer                      user_data);
+static gint               thunar_list_model_cmp_array_func              (gconstpointer                 a,
+                                                                         gconstpointer                 b,
+                                                                         gpointer                      user_data);
 static void               thunar_list_model_sort                        (ThunarListModel              *store);
-static void               thunar_list_model_file_changed                (ThunarFileMonitor            *file_monitor,
+static void               thunar_list_model_row_cache_free              (gpointer                      data);
+static gint               thunar_list_model_row_cache_slot              (ThunarListModel              *store,
+                                                                         ThunarFile                   *file,
+                                                                         gint                          column);
+static gboolean           thunar_list_model_format_timer                (gpointer                      user_data);
+static void               thunar_list_model_update_format_timer         (ThunarListModel              *store);
+static void               thunar_list_model_row_update                  (ThunarListModel              *store,
+                                                                         GSequenceIter                *row);
+static void               thunar_list_model_file_changed                (ThunarFile                   *file,
+                                                                         gpointer                      user_data);
+static void               thunar_list_model_monitor_file_changed        (ThunarFileMonitor            *file_monitor,
                                                                          ThunarFile                   *file,
                                                                          ThunarListModel              *store);
+static void               thunar_list_model_users_changed               (ThunarUserManager            *manager,
+                                                                          ThunarListModel              *store);
+static void               thunar_list_model_free_space_changed          (ThunarFreeSpaceCache         *cache,
+                                                                         ThunarListModel              *store);
+static void               thunar_list_model_summary_add                 (ThunarListModelSummary       *summary,
+                                                                         ThunarFile                   *file);
+static void               thunar_list_model_summary_remove              (ThunarListModel              *store,
+                                                                         ThunarFile                   *file);
 static void               thunar_list_model_folder_destroy              (ThunarFolder                 *folder,
                                                                          ThunarListModel              *store);
 static void               thunar_list_model_folder_error                (ThunarFolder                 *folder,
@@ -157,8 +266,13 @@ static void               thunar_list_model_files_added                 (ThunarF
 static void               thunar_list_model_files_removed               (ThunarFolder                 *folder,
                                                                          GList                        *files,
                                                                          ThunarListModel              *store);
+static void               thunar_list_model_insert_file_array           (ThunarListModel              *store,
+                                                                         gpointer                     *files,
+                                                                         guint                         n_files,
+                                                                         gboolean                      presorted);
 static void               thunar_list_model_insert_files                (ThunarListModel              *store,
-                                                                         GList                        *files);
+                                                                         GList                        *files,
+                                                                         gboolean                      presorted);
 static gint               sort_by_date                                  (const ThunarFile             *a,
                                                                          const ThunarFile             *b,
                                                                          gboolean                      case_sensitive,
@@ -225,12 +339,23 @@ static void               thunar_list_model_search_folder               (ThunarL
                                                                          gchar                        *uri,
                                                                          gchar                       **search_query_c_terms,
                                                                          enum ThunarListModelSearch    search_type,
-                                                                         gboolean                      show_hidden);
+                                                                         gboolean                      show_hidden,
+                                                                         gboolean                      search_contents,
+                                                                         gboolean                      fuzzy,
+                                                                         guint                         depth,
+                                                                         ThunarListModelSearchWalk    *walk);
 static void               thunar_list_model_cancel_search_job           (ThunarListModel              *model);
 static gchar**            thunar_list_model_split_search_query          (const gchar                  *search_query,
                                                                          GError                      **error);
 static gboolean           thunar_list_model_search_terms_match          (gchar                       **terms,
-                                                                         gchar                        *str);
+                                                                         gchar                        *str,
+                                                                         gboolean                      fuzzy);
+static gboolean           thunar_list_model_search_file_match           (gchar                       **terms,
+                                                                         ThunarFile                   *file,
+                                                                         gboolean                      fuzzy);
+static gint               thunar_list_model_search_name_score           (gchar                       **terms,
+                                                                         const gchar                  *name,
+                                                                         gboolean                      fuzzy);
 
 static void               thunar_list_model_search_error                (ThunarJob                    *job);
 static void               thunar_list_model_search_finished             (ThunarJob                    *job,
@@ -241,7 +366,7 @@ static gint               thunar_list_model_get_folder_item_count       (ThunarL
 static void               thunar_list_model_set_folder_item_count       (ThunarListModel              *store,
                                                                          ThunarFolderItemCount         count_as_dir_size);
 
-static void               thunar_list_model_file_count_callback         (ExoJob                       *job,
+static void               thunar_list_model_file_count_callback         (ThunarFile                   *file,
                                                                          gpointer                      model);
 
 struct _ThunarListModelClass
@@ -252,6 +377,17 @@ struct _ThunarListModelClass
   void (*error) (ThunarListModel *store,
                  const GError    *error);
   void (*search_done) (void);
+  void (*changes_pending) (ThunarListModel *store);
+};
+
+/* totals of a set of rows, see thunar_list_model_get_statusbar_text() */
+struct _ThunarListModelSummary
+{
+  gint        folder_count;
+  gint        non_folder_count;
+  guint64     size;
+  guint64     last_modified_date;
+  ThunarFile *last_modified_file;
 };
 
 struct _ThunarListModel
@@ -268,6 +404,13 @@ struct _ThunarListModel
 
   GSequence               *rows;
   GSList                  *hidden;
+
+  /* the row last looked up by position, the views mostly walk the
+   * rows in order, so the next lookup is usually its neighbour. It
+   * is reset by thunar_list_model_cursor_reset() on every change of
+   * the rows */
+  GSequenceIter           *cursor_row;
+  gint                     cursor_position;
   ThunarFolder            *folder;
   gboolean                 show_hidden : 1;
   ThunarFolderItemCount    folder_item_count;
@@ -275,17 +418,39 @@ struct _ThunarListModel
   ThunarDateStyle          date_style;
   char                    *date_custom_style;
 
-  /* Normalized current search terms.
+  /* the row of each file in the model (ThunarFile -> GSequenceIter) */
+  GHashTable              *file_rows;
+
+  /* formatted strings of the rows (ThunarFile -> ThunarListModelRowCache),
+   * an entry is only valid while its stamp matches format_stamp, which is
+   * bumped whenever the formatting options change and, for relative
+   * dates, every THUNAR_LIST_MODEL_FORMAT_INTERVAL seconds.
+   */
+  GHashTable              *row_cache;
+  guint                    format_stamp;
+  guint                    format_timer_id;
+
+  /* Normalized current search terms, and whether they match fuzzily.
    * NULL if not presenting a search's results.
    * Search job may have finished even if this is non-NULL.
    */
-  gchar **search_terms;
+  gchar   **search_terms;
+  gboolean  search_fuzzy;
 
   /* Use the shared ThunarFileMonitor instance, so we
    * do not need to connect "changed" handler to every
-   * file in the model.
+   * file in the model. Only the children of the folder are
+   * watched, search results listen to all changes.
    */
   ThunarFileMonitor *file_monitor;
+  GFile             *watched_directory;
+  gulong             file_changed_id;
+
+  /* the usage of the file systems shown for mountables */
+  ThunarFreeSpaceCache *free_space_cache;
+
+  /* resolves the owner and group names in the background */
+  ThunarUserManager    *user_manager;
 
   /* ids for the "row-inserted" and "row-deleted" signals
    * of GtkTreeModel to speed up folder changing.
@@ -301,20 +466,151 @@ struct _ThunarListModel
   /* searching runs in a separate thread which incrementally inserts results (files)
    * in the files_to_add list.
    * Periodically the main thread takes all the files in the files_to_add list
-   * and adds them in the model. The list is then emptied.
+   * and moves them to the files_pending list, which is appended to the model
+   * in chunks within a time budget. While the search is running the rows are
+   * not sorted (search_unsorted), they are sorted once the search finished.
    */
   ThunarJob     *recursive_search_job;
   GList         *files_to_add;
   GMutex         mutex_files_to_add;
+  GList         *files_pending;
+  gboolean       search_unsorted;
 
   /* used to stop the periodic call to thunar_list_model_add_search_files when the search is finished/canceled */
   guint          update_search_results_timeout_id;
+
+  /* the normalized query if the search results were filtered from the
+   * files of the folder in memory, NULL if they come from a search job */
+  gchar         *filter_query;
+  guint          filter_done_id;
+
+  /* totals of all rows for the statusbar, kept up to date while rows are
+   * added and removed. Changed files and removing the most recently
+   * modified file make them invalid until they are needed again.
+   */
+  ThunarListModelSummary summary;
+  gboolean               summary_valid;
+
+  /* while frozen, changed files are only queued here (with the set for
+   * looking them up) and applied later with thunar_list_model_apply_changes(),
+   * so a view can spread the re-sorting and redrawing over frames.
+   */
+  GQueue                 changed_queue;
+  GHashTable            *changed_files;
+  guint                  changes_frozen;
+
+  /* the casefolded names of the rows in sorted order, for the type-ahead
+   * find of the views, see thunar_list_model_has_name_prefix(). Built on
+   * the first lookup and dropped with any change of the rows. The files
+   * map to their position + 1, and the range of the last prefix looked up
+   * is kept for the rows the view tests one after another.
+   */
+  GArray                *name_keys;
+  GHashTable            *name_positions;
+  gchar                 *name_prefix;
+  guint                  name_first;
+  guint                  name_last;
+};
+
+
+
+/* cached strings of a row, see thunar_list_model_get_value() */
+struct _ThunarListModelRowCache
+{
+  guint  stamp;
+  gchar *strings[THUNAR_LIST_MODEL_N_CACHED];
+};
+
+/* the sorted files of a folder, shared by all models of the folder
+ * which sort the same way, see thunar_list_model_index_publish() */
+struct _ThunarListModelIndex
+{
+  GFile             *directory;
+  GQueue             orders;  /* most recently used first */
+};
+
+struct _ThunarListModelOrder
+{
+  ThunarSortFunc  sort_func;
+  gint            sort_sign;
+  gboolean        sort_folders_first;
+  gboolean        sort_case_sensitive;
+  GPtrArray      *files;
+};
+
+/* the casefolded name of a row, see thunar_list_model_has_name_prefix() */
+struct _ThunarListModelNameKey
+{
+  gchar      *key;
+  ThunarFile *file;
+};
+
+/* precomputed sort key of a row, see thunar_list_model_sort() */
+struct _ThunarListModelSortKey
+{
+  guint64        key;
+  ThunarFile    *file;
+  GSequenceIter *row;
+  gint           position;
+  gboolean       is_dir;
+};
+
+struct _ThunarListModelSortChunk
+{
+  ThunarListModel        *store;
+  ThunarListModelSortKey *keys;
+  guint                   n_keys;
+};
+
+/* state shared by the threads of a recursive search */
+struct _ThunarListModelSearchWalk
+{
+  ThunarListModel  *model;
+  ThunarJob        *job;
+  gchar           **search_query_c_terms;
+  gboolean          show_hidden;
+  gboolean          search_contents;
+  gboolean          fuzzy;
+
+  /* limits of the walk, see thunar_list_model_search_walk_descend() */
+  GPtrArray        *prune;       /* GPatternSpecs of folder names not to descend into */
+  guint             max_depth;   /* 0 for no limit */
+  guint             max_results; /* 0 for no limit */
+  gint              n_results;   /* atomic, number of results found so far */
+
+  /* the best ThunarListModelSearchResults as a min-heap, if a fuzzy walk
+   * with max_results keeps the best results instead of the first ones */
+  GArray           *results;
+  GMutex            results_mutex;
+
+  GMutex            mutex;
+  GCond             cond;
+  GQueue            directories; /* ThunarListModelSearchDirs of the folders to search */
+  guint             n_busy;      /* number of threads searching a folder */
 };
 
+typedef struct
+{
+  gchar *uri;
+  guint  depth;   /* number of levels below the folder the search started in */
+}
+ThunarListModelSearchDir;
+
+typedef struct
+{
+  gint   score;
+  GFile *file;
+}
+ThunarListModelSearchResult;
+
 
 
 static guint       list_model_signals[LAST_SIGNAL];
 static GParamSpec *list_model_props[N_PROPERTIES] = { NULL, };
+static GQuark      thunar_list_model_index_quark;
+
+/* all list models alive, for thunar_list_model_get_census() */
+static GHashTable *thunar_list_models = NULL;
 
 
 
@@ -336,6 +632,8 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
   gobject_class->get_property = thunar_list_model_get_property;
   gobject_class->set_property = thunar_list_model_set_property;
 
+  thunar_list_model_index_quark = g_quark_from_static_string ("thunar-list-model-index");
+
   /**
    * ThunarListModel:case-sensitive:
    *
@@ -481,6 +779,22 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
                     NULL, NULL,
                     NULL,
                     G_TYPE_NONE, 0);
+
+  /**
+   * ThunarListModel::changes-pending:
+   * @store : a #ThunarListModel.
+   *
+   * Emitted when the first changed file is queued while the
+   * changes of @store are frozen, see thunar_list_model_freeze_changes().
+   **/
+  list_model_signals[CHANGES_PENDING] =
+      g_signal_new (I_("changes-pending"),
+                    G_TYPE_FROM_CLASS (klass),
+                    G_SIGNAL_RUN_LAST,
+                    G_STRUCT_OFFSET (ThunarListModelClass, changes_pending),
+                    NULL, NULL,
+                    NULL,
+                    G_TYPE_NONE, 0);
 }
 
 
@@ -543,14 +857,32 @@ thunar_list_model_init (ThunarListModel *store)
   store->sort_sign = 1;
   store->sort_func = thunar_file_compare_by_name;
   store->rows = g_sequence_new (g_object_unref);
+  store->file_rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  if (G_UNLIKELY (thunar_list_models == NULL))
+    thunar_list_models = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_add (thunar_list_models, store);
+  store->row_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, thunar_list_model_row_cache_free);
+  store->format_stamp = 1;
+  store->summary_valid = TRUE;
+  store->changed_files = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_queue_init (&store->changed_queue);
+  thunar_list_model_update_format_timer (store);
   g_mutex_init (&store->mutex_files_to_add);
 
-  /* connect to the shared ThunarFileMonitor, so we don't need to
-   * connect "changed" to every single ThunarFile we own.
+  /* use the shared ThunarFileMonitor, so we don't need to
+   * connect "changed" to every single ThunarFile we own,
+   * see thunar_list_model_watch_files().
    */
   store->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (G_OBJECT (store->file_monitor), "file-changed",
-                    G_CALLBACK (thunar_list_model_file_changed), store);
+
+  store->free_space_cache = thunar_free_space_cache_get_default ();
+  g_signal_connect (G_OBJECT (store->free_space_cache), "changed",
+                    G_CALLBACK (thunar_list_model_free_space_changed), store);
+
+  store->user_manager = thunar_user_manager_get_default ();
+  g_signal_connect (G_OBJECT (store->user_manager), "changed",
+                    G_CALLBACK (thunar_list_model_users_changed), store);
 }
 
 
@@ -571,6 +903,8 @@ thunar_list_model_finalize (GObject *object)
 {
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
 
+  g_hash_table_remove (thunar_list_models, store);
+
   thunar_list_model_cancel_search_job (store);
 
   if (store->update_search_results_timeout_id > 0)
@@ -580,18 +914,45 @@ thunar_list_model_finalize (GObject *object)
     }
   thunar_g_list_free_full (store->files_to_add);
   store->files_to_add = NULL;
+  thunar_g_list_free_full (store->files_pending);
+  store->files_pending = NULL;
+
+  if (store->filter_done_id != 0)
+    g_source_remove (store->filter_done_id);
+  g_free (store->filter_query);
+
+  if (store->format_timer_id != 0)
+    g_source_remove (store->format_timer_id);
+  g_hash_table_destroy (store->row_cache);
 
   g_sequence_free (store->rows);
+  g_hash_table_destroy (store->file_rows);
+  g_hash_table_destroy (store->changed_files);
+  g_queue_clear_full (&store->changed_queue, g_object_unref);
   g_mutex_clear (&store->mutex_files_to_add);
 
   /* disconnect from the file monitor */
-  g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, store);
+  if (store->watched_directory != NULL)
+    {
+      thunar_file_monitor_unwatch_children (store->watched_directory, thunar_list_model_file_changed, store);
+      g_object_unref (store->watched_directory);
+    }
+  if (store->file_changed_id != 0)
+    g_signal_handler_disconnect (G_OBJECT (store->file_monitor), store->file_changed_id);
   g_object_unref (G_OBJECT (store->file_monitor));
 
+  g_signal_handlers_disconnect_by_func (G_OBJECT (store->free_space_cache), thunar_list_model_free_space_changed, store);
+  g_object_unref (G_OBJECT (store->free_space_cache));
+
+  g_signal_handlers_disconnect_by_func (G_OBJECT (store->user_manager), thunar_list_model_users_changed, store);
+  g_object_unref (G_OBJECT (store->user_manager));
+
   g_free (store->date_custom_style);
 
   g_strfreev (store->search_terms);
 
+  thunar_list_model_name_keys_drop (store);
+
   (*G_OBJECT_CLASS (thunar_list_model_parent_class)->finalize) (object);
 }
 
@@ -778,6 +1139,152 @@ thunar_list_model_get_column_type (GtkTreeModel *model,
 
 
 
+static void
+thunar_list_model_name_keys_drop (ThunarListModel *store)
+{
+  guint n;
+
+  if (store->name_keys == NULL)
+    return;
+
+  for (n = 0; n < store->name_keys->len; ++n)
+    g_free (g_array_index (store->name_keys, ThunarListModelNameKey, n).key);
+  g_array_free (store->name_keys, TRUE);
+  g_hash_table_destroy (store->name_positions);
+  g_free (store->name_prefix);
+
+  store->name_keys = NULL;
+  store->name_positions = NULL;
+  store->name_prefix = NULL;
+}
+
+
+
+static gint
+thunar_list_model_name_key_compare (gconstpointer a,
+                                    gconstpointer b)
+{
+  return strcmp (((const ThunarListModelNameKey *) a)->key, ((const ThunarListModelNameKey *) b)->key);
+}
+
+
+
+static void
+thunar_list_model_name_keys_build (ThunarListModel *store)
+{
+  ThunarListModelNameKey name_key;
+  GSequenceIter         *row;
+  guint                  n;
+
+  store->name_keys = g_array_sized_new (FALSE, FALSE, sizeof (ThunarListModelNameKey), g_sequence_get_length (store->rows));
+  for (row = g_sequence_get_begin_iter (store->rows); !g_sequence_iter_is_end (row); row = g_sequence_iter_next (row))
+    {
+      name_key.file = g_sequence_get (row);
+      name_key.key = g_utf8_casefold (thunar_file_get_display_name (name_key.file), -1);
+      g_array_append_val (store->name_keys, name_key);
+    }
+  g_array_sort (store->name_keys, thunar_list_model_name_key_compare);
+
+  store->name_positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (n = 0; n < store->name_keys->len; ++n)
+    g_hash_table_insert (store->name_positions,
+                         g_array_index (store->name_keys, ThunarListModelNameKey, n).file,
+                         GUINT_TO_POINTER (n + 1));
+}
+
+
+
+/* the position of the first sorted name whose first @length bytes compare
+ * above @bound against @prefix, i.e. -1 for the first match and 0 for the
+ * first name after the matches */
+static guint
+thunar_list_model_name_keys_search (ThunarListModel *store,
+                                    const gchar     *prefix,
+                                    gsize            length,
+                                    gint             bound)
+{
+  const gchar *key;
+  guint        lower = 0;
+  guint        upper = store->name_keys->len;
+  guint        middle;
+
+  while (lower < upper)
+    {
+      middle = lower + (upper - lower) / 2;
+      key = g_array_index (store->name_keys, ThunarListModelNameKey, middle).key;
+      if (strncmp (key, prefix, length) > bound)
+        upper = middle;
+      else
+        lower = middle + 1;
+    }
+
+  return lower;
+}
+
+
+
+static inline void
+thunar_list_model_cursor_reset (ThunarListModel *store)
+{
+  store->cursor_row = NULL;
+
+  /* the positions of the names are outdated as well */
+  thunar_list_model_name_keys_drop (store);
+}
+
+
+
+static GSequenceIter *
+thunar_list_model_row_at (ThunarListModel *store,
+                          gint             position)
+{
+  GSequenceIter *row;
+
+  /* step from the last row instead of searching the tree */
+  if (store->cursor_row == NULL || position < store->cursor_position - 1 || position > store->cursor_position + 1)
+    row = g_sequence_get_iter_at_pos (store->rows, position);
+  else if (position == store->cursor_position + 1)
+    row = g_sequence_iter_next (store->cursor_row);
+  else if (position == store->cursor_position - 1)
+    row = g_sequence_iter_prev (store->cursor_row);
+  else
+    row = store->cursor_row;
+
+  if (!g_sequence_iter_is_end (row))
+    {
+      store->cursor_row = row;
+      store->cursor_position = position;
+    }
+
+  return row;
+}
+
+
+
+static gint
+thunar_list_model_row_position (ThunarListModel *store,
+                                GSequenceIter   *row)
+{
+  if (store->cursor_row != NULL)
+    {
+      if (row == store->cursor_row)
+        return store->cursor_position;
+
+      if (row == g_sequence_iter_next (store->cursor_row))
+        {
+          store->cursor_row = row;
+          return ++store->cursor_position;
+        }
+    }
+
+  store->cursor_row = row;
+  store->cursor_position = g_sequence_iter_get_position (row);
+
+  return store->cursor_position;
+}
+
+
+
 static gboolean
 thunar_list_model_get_iter (GtkTreeModel *model,
                             GtkTreeIter  *iter,
@@ -792,7 +1299,7 @@ thunar_list_model_get_iter (GtkTreeModel *model,
 
   /* determine the row for the path */
   offset = gtk_tree_path_get_indices (path)[0];
-  row = g_sequence_get_iter_at_pos (store->rows, offset);
+  row = thunar_list_model_row_at (store, offset);
 
   if (!g_sequence_iter_is_end (row))
     {
@@ -814,7 +1321,7 @@ thunar_list_model_get_path (GtkTreeModel *model,
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (model), NULL);
   _thunar_return_val_if_fail (iter->stamp == THUNAR_LIST_MODEL (model)->stamp, NULL);
 
-  idx = g_sequence_iter_get_position (iter->user_data);
+  idx = thunar_list_model_row_position (THUNAR_LIST_MODEL (model), iter->user_data);
   if (G_LIKELY (idx >= 0))
     return gtk_tree_path_new_from_indices (idx, -1);
 
@@ -823,23 +1330,107 @@ thunar_list_model_get_path (GtkTreeModel *model,
 
 
 
+static void
+thunar_list_model_row_cache_free (gpointer data)
+{
+  ThunarListModelRowCache *cache = data;
+  guint                    n;
+
+  for (n = 0; n < THUNAR_LIST_MODEL_N_CACHED; ++n)
+    g_free (cache->strings[n]);
+  g_slice_free (ThunarListModelRowCache, cache);
+}
+
+
+
+static gint
+thunar_list_model_row_cache_slot (ThunarListModel *store,
+                                  ThunarFile      *file,
+                                  gint             column)
+{
+  switch (column)
+    {
+    case THUNAR_COLUMN_DATE_CREATED:  return THUNAR_LIST_MODEL_CACHE_DATE_CREATED;
+    case THUNAR_COLUMN_DATE_ACCESSED: return THUNAR_LIST_MODEL_CACHE_DATE_ACCESSED;
+    case THUNAR_COLUMN_DATE_MODIFIED: return THUNAR_LIST_MODEL_CACHE_DATE_MODIFIED;
+    case THUNAR_COLUMN_DATE_DELETED:  return THUNAR_LIST_MODEL_CACHE_DATE_DELETED;
+    case THUNAR_COLUMN_RECENCY:       return THUNAR_LIST_MODEL_CACHE_RECENCY;
+    case THUNAR_COLUMN_GROUP:         return THUNAR_LIST_MODEL_CACHE_GROUP;
+    case THUNAR_COLUMN_OWNER:         return THUNAR_LIST_MODEL_CACHE_OWNER;
+    case THUNAR_COLUMN_PERMISSIONS:   return THUNAR_LIST_MODEL_CACHE_PERMISSIONS;
+    case THUNAR_COLUMN_SIZE_IN_BYTES: return THUNAR_LIST_MODEL_CACHE_SIZE_IN_BYTES;
+
+    case THUNAR_COLUMN_SIZE:
+      /* free space of mountables and item counts of folders change
+       * without the file itself changing, so never cache those */
+      if (thunar_file_is_mountable (file) || thunar_file_is_directory (file))
+        return -1;
+      return THUNAR_LIST_MODEL_CACHE_SIZE;
+
+    default:
+      return -1;
+    }
+}
+
+
+
+static gboolean
+thunar_list_model_format_timer (gpointer user_data)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (user_data);
+
+  /* "Today" may have become "Yesterday", reformat on the next redraw */
+  store->format_stamp++;
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+
+static void
+thunar_list_model_update_format_timer (ThunarListModel *store)
+{
+  gboolean relative;
+
+  /* only the simple and short styles format dates relative to now */
+  relative = (store->date_style == THUNAR_DATE_STYLE_SIMPLE
+           || store->date_style == THUNAR_DATE_STYLE_SHORT
+           || store->date_style == THUNAR_DATE_STYLE_CUSTOM_SIMPLE);
+
+  if (relative && store->format_timer_id == 0)
+    {
+      store->format_timer_id = g_timeout_add_seconds (THUNAR_LIST_MODEL_FORMAT_INTERVAL, thunar_list_model_format_timer, store);
+    }
+  else if (!relative && store->format_timer_id != 0)
+    {
+      g_source_remove (store->format_timer_id);
+      store->format_timer_id = 0;
+    }
+}
+
+
+
 static void
 thunar_list_model_get_value (GtkTreeModel *model,
                              GtkTreeIter  *iter,
                              gint          column,
                              GValue       *value)
 {
-  ThunarGroup  *group;
-  const gchar  *device_type;
-  const gchar  *name;
-  const gchar  *real_name;
-  ThunarUser   *user;
-  ThunarFile   *file;
-  ThunarFolder *folder;
-  gchar        *str;
-  guint32       item_count;
-  GFile        *g_file;
-  GFile        *g_file_parent;
+  ThunarListModel         *store = THUNAR_LIST_MODEL (model);
+  ThunarListModelRowCache *cache = NULL;
+  ThunarGroup             *group;
+  const gchar             *device_type;
+  const gchar             *name;
+  const gchar             *real_name;
+  ThunarUser              *user;
+  ThunarFile              *file;
+  ThunarFolder            *folder;
+  gchar                   *str;
+  guint32                  item_count;
+  GFile                   *g_file;
+  GFile                   *g_file_parent;
+  gint                     slot;
+  guint                    i;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
   _thunar_return_if_fail (iter->stamp == (THUNAR_LIST_MODEL (model))->stamp);
@@ -847,6 +1438,37 @@ thunar_list_model_get_value (GtkTreeModel *model,
   file = g_sequence_get (iter->user_data);
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
+  thunar_stats_count (THUNAR_STATS_LIST_MODEL_GET_VALUE);
+
+  /* the views ask for the same strings on every redraw, so the
+   * formatted dates, sizes, permissions and owners are cached */
+  slot = thunar_list_model_row_cache_slot (store, file, column);
+  if (slot >= 0)
+    {
+      cache = g_hash_table_lookup (store->row_cache, file);
+      if (cache == NULL)
+        {
+          cache = g_slice_new0 (ThunarListModelRowCache);
+          cache->stamp = store->format_stamp;
+          g_hash_table_insert (store->row_cache, g_object_ref (file), cache);
+        }
+      else if (cache->stamp != store->format_stamp)
+        {
+          for (i = 0; i < THUNAR_LIST_MODEL_N_CACHED; ++i)
+            {
+              g_free (cache->strings[i]);
+              cache->strings[i] = NULL;
+            }
+          cache->stamp = store->format_stamp;
+        }
+      else if (cache->strings[slot] != NULL)
+        {
+          g_value_init (value, G_TYPE_STRING);
+          g_value_set_string (value, cache->strings[slot]);
+          return;
+        }
+    }
+
   switch (column)
     {
     case THUNAR_COLUMN_DATE_CREATED:
@@ -990,7 +1612,8 @@ thunar_list_model_get_value (GtkTreeModel *model,
           g_file = thunar_file_get_target_location (file);
           if (g_file == NULL)
             break;
-          g_value_take_string (value, thunar_g_file_get_free_space_string (g_file, THUNAR_LIST_MODEL (model)->file_size_binary));
+          g_value_take_string (value, thunar_free_space_cache_get_string (THUNAR_LIST_MODEL (model)->free_space_cache, g_file,
+                                                                          THUNAR_LIST_MODEL (model)->file_size_binary));
           g_object_unref (g_file);
           break;
         }
@@ -1003,8 +1626,11 @@ thunar_list_model_get_value (GtkTreeModel *model,
           /* If the option is set to always show folder sizes as item counts, then give the folder's item count */
           else if (THUNAR_LIST_MODEL (model)->folder_item_count == THUNAR_FOLDER_ITEM_COUNT_ALWAYS)
             {
-              item_count = thunar_file_get_file_count (file, G_CALLBACK (thunar_list_model_file_count_callback), model);
-              g_value_take_string (value, g_strdup_printf (ngettext ("%u item", "%u items", item_count), item_count));
+              item_count = thunar_file_get_file_count (file, thunar_list_model_file_count_callback, model);
+              if (thunar_file_has_file_count (file))
+                g_value_take_string (value, g_strdup_printf (ngettext ("%u item", "%u items", item_count), item_count));
+              else
+                g_value_set_static_string (value, "…");
             }
 
           /* If the option is set to always show folder sizes as item counts only for local files,
@@ -1013,8 +1639,11 @@ thunar_list_model_get_value (GtkTreeModel *model,
             {
               if (thunar_file_is_local (file))
                 {
-                  item_count = thunar_file_get_file_count (file, G_CALLBACK (thunar_list_model_file_count_callback), model);
-                  g_value_take_string (value, g_strdup_printf (ngettext ("%u item", "%u items", item_count), item_count));
+                  item_count = thunar_file_get_file_count (file, thunar_list_model_file_count_callback, model);
+                  if (thunar_file_has_file_count (file))
+                    g_value_take_string (value, g_strdup_printf (ngettext ("%u item", "%u items", item_count), item_count));
+                  else
+                    g_value_set_static_string (value, "…");
                 }
               else
                 g_value_take_string (value, thunar_file_get_size_string_formatted (file, THUNAR_LIST_MODEL (model)->file_size_binary));
@@ -1058,6 +1687,10 @@ thunar_list_model_get_value (GtkTreeModel *model,
       _thunar_assert_not_reached ();
       break;
     }
+
+  /* remember the formatted string for the next redraw */
+  if (slot >= 0)
+    cache->strings[slot] = g_value_dup_string (value);
 }
 
 
@@ -1131,7 +1764,7 @@ thunar_list_model_iter_nth_child (GtkTreeModel *model,
 
   if (G_LIKELY (parent == NULL))
     {
-      row = g_sequence_get_iter_at_pos (store->rows, n);
+      row = thunar_list_model_row_at (store, n);
       if (g_sequence_iter_is_end (row))
         return FALSE;
 
@@ -1367,959 +2000,2409 @@ thunar_list_model_cmp_func (gconstpointer a,
 
 
 
-static void
-thunar_list_model_sort (ThunarListModel *store)
+static gboolean
+thunar_list_model_sort_has_key (ThunarListModel *store)
 {
-  GtkTreePath    *path;
-  GSequenceIter **old_order;
-  gint           *new_order;
-  gint            n;
-  gint            length;
-  GSequenceIter  *row;
+  /* the sort functions which only compare a numeric value (or the
+   * name or type description) before falling back to the name */
+  return store->sort_func == sort_by_date_created
+      || store->sort_func == sort_by_date_accessed
+      || store->sort_func == sort_by_date_modified
+      || store->sort_func == sort_by_date_deleted
+      || store->sort_func == sort_by_recency
+      || store->sort_func == sort_by_permissions
+      || store->sort_func == sort_by_size
+      || store->sort_func == sort_by_size_in_bytes
+      || store->sort_func == sort_by_type
+      || store->sort_func == thunar_file_compare_by_name;
+}
 
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
-  length = g_sequence_get_length (store->rows);
-  if (G_UNLIKELY (length <= 1))
-    return;
 
-  /* be sure to not overuse the stack */
-  if (G_LIKELY (length < 2000))
-    {
-      old_order = g_newa (GSequenceIter *, length);
-      new_order = g_newa (gint, length);
-    }
-  else
-    {
-      old_order = g_new (GSequenceIter *, length);
-      new_order = g_new (gint, length);
-    }
+static guint64
+thunar_list_model_sort_get_key (ThunarListModel  *store,
+                                const ThunarFile *file)
+{
+  if (store->sort_func == sort_by_date_created)
+    return thunar_file_get_date (file, THUNAR_FILE_DATE_CREATED);
+  else if (store->sort_func == sort_by_date_accessed)
+    return thunar_file_get_date (file, THUNAR_FILE_DATE_ACCESSED);
+  else if (store->sort_func == sort_by_date_modified)
+    return thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+  else if (store->sort_func == sort_by_date_deleted)
+    return thunar_file_get_date (file, THUNAR_FILE_DATE_DELETED);
+  else if (store->sort_func == sort_by_recency)
+    return thunar_file_get_date (file, THUNAR_FILE_RECENCY);
+  else if (store->sort_func == sort_by_permissions)
+    return thunar_file_get_mode (file);
+  else if (store->sort_func == sort_by_size || store->sort_func == sort_by_size_in_bytes)
+    return thunar_file_get_size (file);
+  else if (store->sort_func == sort_by_type)
+    return thunar_file_get_content_type_desc_prefix (THUNAR_FILE (file), store->sort_case_sensitive);
+  else if (store->sort_func == thunar_file_compare_by_name)
+    return thunar_file_get_collate_prefix (file, store->sort_case_sensitive);
 
-  /* store old order */
-  row = g_sequence_get_begin_iter (store->rows);
-  for (n = 0; n < length; ++n)
-    {
-      old_order[n] = row;
-      row = g_sequence_iter_next (row);
-    }
+  return 0;
+}
 
-  /* sort */
-  g_sequence_sort (store->rows, thunar_list_model_cmp_func, store);
 
-  /* new_order[newpos] = oldpos */
-  for (n = 0; n < length; ++n)
-    new_order[g_sequence_iter_get_position (old_order[n])] = n;
 
-  /* tell the view about the new item order */
-  path = gtk_tree_path_new_first ();
-  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-  gtk_tree_path_free (path);
+static gint
+thunar_list_model_sort_key_cmp (gconstpointer a,
+                                gconstpointer b,
+                                gpointer      user_data)
+{
+  const ThunarListModelSortKey *key_a = a;
+  const ThunarListModelSortKey *key_b = b;
+  ThunarListModel              *store = THUNAR_LIST_MODEL (user_data);
 
-  /* clean up if we used the heap */
-  if (G_UNLIKELY (length >= 2000))
-    {
-      g_free (old_order);
-      g_free (new_order);
-    }
+  if (key_a->is_dir != key_b->is_dir)
+    return key_a->is_dir ? -1 : 1;
+
+  if (key_a->key != key_b->key)
+    return (key_a->key < key_b->key ? -1 : 1) * store->sort_sign;
+
+  /* equal keys, so the full comparison decides */
+  return thunar_list_model_cmp_func (key_a->file, key_b->file, store);
 }
 
 
 
-static void
-thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
-                                ThunarFile        *file,
-                                ThunarListModel   *store)
+static gpointer
+thunar_list_model_sort_thread (gpointer data)
 {
-  GSequenceIter *row;
-  GSequenceIter *end;
-  gint           pos_after;
-  gint           pos_before = 0;
-  gint          *new_order;
-  gint           length;
-  gint           i, j;
-  GtkTreePath   *path;
-  GtkTreeIter    iter;
+  ThunarListModelSortChunk *chunk = data;
 
-  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor) || file_monitor == NULL);
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
-  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  g_qsort_with_data (chunk->keys, chunk->n_keys, sizeof (ThunarListModelSortKey),
+                     thunar_list_model_sort_key_cmp, chunk->store);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  return NULL;
+}
 
-  while (row != end)
-    {
-      if (G_UNLIKELY (g_sequence_get (row) == file))
-        {
-          /* generate the iterator for this row */
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
 
-          _thunar_assert (pos_before == g_sequence_iter_get_position (row));
 
-          /* check if the sorting changed */
-          g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
-          pos_after = g_sequence_iter_get_position (row);
-          if (pos_after != pos_before)
-            {
-              /* do swap sorting here since its much faster than a complete sort */
-              length = g_sequence_get_length (store->rows);
-              if (G_LIKELY (length < 2000))
-                new_order = g_newa (gint, length);
-              else
-                new_order = g_new (gint, length);
+static void
+thunar_list_model_sort_keys (ThunarListModel        *store,
+                             ThunarListModelSortKey *keys,
+                             guint                   n_keys,
+                             gboolean                parallel)
+{
+  ThunarListModelSortChunk *chunks;
+  ThunarListModelSortKey   *buffer;
+  GThread                 **threads;
+  guint                    *bounds;
+  guint                     n_chunks;
+  guint                     n, i, j, k;
+  guint                     end_a, end_b;
+
+  /* only the numeric key comparisons are safe to run in other threads,
+   * the other sort functions use a couple of thread-unsafe caches */
+  n_chunks = MIN ((guint) g_get_num_processors (), THUNAR_LIST_MODEL_SORT_THREADS_MAX);
+  if (!parallel || n_keys < THUNAR_LIST_MODEL_PARALLEL_SORT_MIN || n_chunks < 2)
+    {
+      g_qsort_with_data (keys, n_keys, sizeof (ThunarListModelSortKey),
+                         thunar_list_model_sort_key_cmp, store);
+      return;
+    }
 
-              /* new_order[newpos] = oldpos */
-              for (i = 0, j = 0; i < length; ++i)
-                {
-                  if (G_UNLIKELY (i == pos_after))
-                    {
-                      new_order[i] = pos_before;
-                    }
-                  else
-                    {
-                      if (G_UNLIKELY (j == pos_before))
-                        j++;
-                      new_order[i] = j++;
-                    }
-                }
+  /* sort consecutive chunks of the keys in worker threads */
+  chunks = g_new (ThunarListModelSortChunk, n_chunks);
+  threads = g_new (GThread *, n_chunks);
+  bounds = g_new (guint, n_chunks + 1);
+  for (n = 0; n <= n_chunks; ++n)
+    bounds[n] = (guint) (((guint64) n_keys * n) / n_chunks);
+  for (n = 0; n < n_chunks; ++n)
+    {
+      chunks[n].store = store;
+      chunks[n].keys = keys + bounds[n];
+      chunks[n].n_keys = bounds[n + 1] - bounds[n];
+      threads[n] = g_thread_new ("ThunarListModelSort", thunar_list_model_sort_thread, &chunks[n]);
+    }
+  for (n = 0; n < n_chunks; ++n)
+    g_thread_join (threads[n]);
 
-              /* tell the view about the new item order */
-              path = gtk_tree_path_new_first ();
-              gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-              gtk_tree_path_free (path);
+  /* merge neighbouring runs until a single run is left */
+  buffer = g_new (ThunarListModelSortKey, n_keys);
+  for (; n_chunks > 1; n_chunks = (n_chunks + 1) / 2)
+    {
+      for (n = 0; n < n_chunks; n += 2)
+        {
+          i = k = bounds[n];
+          end_a = j = bounds[MIN (n + 1, n_chunks)];
+          end_b = bounds[MIN (n + 2, n_chunks)];
 
-              /* clean up if we used the heap */
-              if (G_UNLIKELY (length >= 2000))
-                g_free (new_order);
+          while (i < end_a && j < end_b)
+            {
+              if (thunar_list_model_sort_key_cmp (&keys[j], &keys[i], store) < 0)
+                buffer[k++] = keys[j++];
+              else
+                buffer[k++] = keys[i++];
             }
+          while (i < end_a)
+            buffer[k++] = keys[i++];
+          while (j < end_b)
+            buffer[k++] = keys[j++];
 
-          /* notify the view that it has to redraw the file */
-          path = gtk_tree_path_new_from_indices (pos_before, -1);
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-          break;
+          bounds[n / 2] = bounds[n];
         }
+      bounds[(n_chunks + 1) / 2] = n_keys;
 
-      row = g_sequence_iter_next (row);
-      pos_before++;
+      /* the merged runs are the input of the next pass */
+      memcpy (keys, buffer, sizeof (ThunarListModelSortKey) * n_keys);
     }
+
+  g_free (buffer);
+  g_free (bounds);
+  g_free (threads);
+  g_free (chunks);
 }
 
 
 
 static void
-thunar_list_model_folder_destroy (ThunarFolder    *folder,
-                                  ThunarListModel *store)
+thunar_list_model_order_free (gpointer data)
 {
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-
-  thunar_list_model_set_folder (store, NULL, NULL);
+  ThunarListModelOrder *order = data;
 
-  /* TODO: What to do when the folder is deleted? */
+  g_ptr_array_unref (order->files);
+  g_slice_free (ThunarListModelOrder, order);
 }
 
 
 
 static void
-thunar_list_model_folder_error (ThunarFolder    *folder,
-                                const GError    *error,
-                                ThunarListModel *store)
+thunar_list_model_index_clear (ThunarListModelIndex *index)
 {
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
-  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
-  _thunar_return_if_fail (error != NULL);
+  g_queue_clear_full (&index->orders, thunar_list_model_order_free);
+}
 
-  /* reset the current folder */
-  thunar_list_model_set_folder (store, NULL, NULL);
 
-  /* forward the error signal */
-  g_signal_emit (G_OBJECT (store), list_model_signals[ERROR], 0, error);
+
+static void
+thunar_list_model_index_file_changed (ThunarFile *file,
+                                      gpointer    user_data)
+{
+  ThunarListModelIndex *index = user_data;
+
+  /* a new name, size or date may move the file */
+  if (!g_queue_is_empty (&index->orders))
+    thunar_list_model_index_clear (index);
 }
 
 
 
 static void
-thunar_list_model_files_added (ThunarFolder    *folder,
-                               GList           *files,
-                               ThunarListModel *store)
+thunar_list_model_index_free (gpointer data)
 {
-  GList       *filtered;
-  GList       *lp;
-  ThunarFile  *file;
-  gboolean     matched;
-  gchar       *name_n;
+  ThunarListModelIndex *index = data;
 
-  /* pass the list directly if not currently showing search results */
-  if (store->search_terms == NULL)
-    {
-      thunar_list_model_insert_files (store, files);
-      return;
-    }
+  thunar_list_model_index_clear (index);
+  thunar_file_monitor_unwatch_children (index->directory, thunar_list_model_index_file_changed, index);
+  g_object_unref (index->directory);
+  g_slice_free (ThunarListModelIndex, index);
+}
 
-  /* otherwise, filter out files that don't match the current search terms */
-  filtered = NULL;
-  for (lp = files; lp != NULL; lp = lp->next)
+
+
+static ThunarListModelIndex*
+thunar_list_model_index_get (ThunarFolder *folder,
+                             gboolean      create)
+{
+  ThunarListModelIndex *index;
+
+  index = g_object_get_qdata (G_OBJECT (folder), thunar_list_model_index_quark);
+  if (index == NULL && create)
     {
-      /* take a reference on that file */
-      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
-      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+      index = g_slice_new0 (ThunarListModelIndex);
+      index->directory = g_object_ref (thunar_file_get_file (thunar_folder_get_corresponding_file (folder)));
+      g_queue_init (&index->orders);
 
-      name_n = (gchar *)thunar_file_get_display_name (file);
-      name_n = thunar_g_utf8_normalize_for_search (name_n, TRUE, TRUE);
-      matched = thunar_list_model_search_terms_match (store->search_terms, name_n);
-      g_free (name_n);
+      /* any added, removed or changed file outdates the orderings */
+      thunar_file_monitor_watch_children (index->directory, thunar_list_model_index_file_changed, index);
+      g_signal_connect_swapped (G_OBJECT (folder), "files-added", G_CALLBACK (thunar_list_model_index_clear), index);
+      g_signal_connect_swapped (G_OBJECT (folder), "files-removed", G_CALLBACK (thunar_list_model_index_clear), index);
 
-      if (! matched)
-        g_object_unref (file);
-      else
-        filtered = g_list_append (filtered, file);
+      /* lives as long as the folder */
+      g_object_set_qdata_full (G_OBJECT (folder), thunar_list_model_index_quark, index, thunar_list_model_index_free);
     }
-  thunar_list_model_insert_files (store, filtered);
-  thunar_g_list_free_full (filtered);
+
+  return index;
 }
 
 
-static void
-thunar_list_model_insert_files (ThunarListModel *store,
-                                GList           *files)
+
+static gboolean
+thunar_list_model_index_usable (ThunarListModel *store)
 {
-  GtkTreePath   *path;
-  GtkTreeIter    iter;
-  ThunarFile    *file;
-  gint          *indices;
-  GSequenceIter *row;
-  GList         *lp;
-  gboolean       has_handler;
-  gboolean       search_mode;
+  /* the owner names and the item counts arrive in the background,
+   * so an ordering by them gets outdated without any file changing */
+  return store->folder != NULL
+      && store->search_terms == NULL
+      && !store->search_unsorted
+      && store->sort_func != (ThunarSortFunc) sort_by_size_and_items_count
+      && store->sort_func != sort_by_owner
+      && store->sort_func != sort_by_group;
+}
 
-  /* we use a simple trick here to avoid allocating
-   * GtkTreePath's again and again, by simply accessing
-   * the indices directly and only modifying the first
-   * item in the integer array... looks a hack, eh?
-   */
-  path = gtk_tree_path_new_first ();
-  indices = gtk_tree_path_get_indices (path);
 
-  /* check if we have any handlers connected for "row-inserted" */
-  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
 
-  /* process all added files */
-  search_mode = (store->search_terms != NULL);
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      /* take a reference on that file */
-      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
-      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+static ThunarListModelOrder*
+thunar_list_model_index_lookup (ThunarListModel *store)
+{
+  ThunarListModelIndex *index;
+  ThunarListModelOrder *order;
+  GList                *lp;
 
-      /* check if the file should be stashed in the hidden list */
-      /* The ->hidden list is an optimization used by the model when
-       * it is not being used to store search results. In the search
-       * case, we simply restart the search, */
-      if (!store->show_hidden && thunar_file_is_hidden (file))
-        {
-          if (search_mode == FALSE)
-            store->hidden = g_slist_prepend (store->hidden, file);
-          else
-            g_object_unref (file);
-        }
-      else
-        {
-          /* insert the file */
-          row = g_sequence_insert_sorted (store->rows, file,
-                                          thunar_list_model_cmp_func, store);
+  if (!thunar_list_model_index_usable (store))
+    return NULL;
 
-          if (has_handler)
-            {
-              /* generate an iterator for the new item */
-              GTK_TREE_ITER_INIT (iter, store->stamp, row);
+  index = thunar_list_model_index_get (store->folder, FALSE);
+  if (index == NULL)
+    return NULL;
 
-              indices[0] = g_sequence_iter_get_position (row);
-              gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
-            }
+  for (lp = index->orders.head; lp != NULL; lp = lp->next)
+    {
+      order = lp->data;
+      if (order->sort_func == store->sort_func
+          && order->sort_sign == store->sort_sign
+          && order->sort_folders_first == store->sort_folders_first
+          && order->sort_case_sensitive == store->sort_case_sensitive)
+        {
+          /* keep the used orderings in front */
+          g_queue_unlink (&index->orders, lp);
+          g_queue_push_head_link (&index->orders, lp);
+          return order;
         }
     }
 
-  /* release the path */
-  gtk_tree_path_free (path);
-
-  /* number of visible files may have changed */
-  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+  return NULL;
 }
 
 
 
+/**
+ * thunar_list_model_index_publish:
+ * @store : a #ThunarListModel.
+ *
+ * Records the sorted rows of @store with the folder, if they cover all
+ * files of the folder. Other models of the folder, for example the other
+ * pane of a split-view, which sort the same way take their ordering from
+ * there instead of sorting again. Models hiding hidden files simply skip
+ * them, so their ordering is merged back in.
+ **/
 static void
-thunar_list_model_files_removed (ThunarFolder    *folder,
-                                 GList           *files,
-                                 ThunarListModel *store)
+thunar_list_model_index_publish (ThunarListModel *store)
 {
-  GList         *lp;
-  GSequenceIter *row;
-  GSequenceIter *end;
-  GSequenceIter *next;
-  GtkTreePath   *path;
-  gboolean       found;
-  gboolean       search_mode;
-
-  /* drop all the referenced files from the model */
-  search_mode = (store->search_terms != NULL);
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
-
-      found = FALSE;
-
-      while (row != end)
-        {
-          next = g_sequence_iter_next (row);
-
-          if (g_sequence_get (row) == lp->data)
-            {
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-
-              /* remove file from the model */
-              g_sequence_remove (row);
+  ThunarListModelIndex *index;
+  ThunarListModelOrder *order;
+  GSequenceIter        *row;
+  GSequenceIter        *end;
+  GPtrArray            *hidden;
+  GPtrArray            *files;
+  GSList               *lp;
+  guint                 n_rows;
+  guint                 n;
+
+  if (!thunar_list_model_index_usable (store) || thunar_folder_get_loading (store->folder))
+    return;
 
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
+  n_rows = g_sequence_get_length (store->rows);
+  if (n_rows + g_slist_length (store->hidden) < THUNAR_LIST_MODEL_INDEX_MIN
+      || n_rows + g_slist_length (store->hidden) != thunar_folder_get_files (store->folder)->len)
+    return;
 
-              /* no need to look in the hidden files */
-              found = TRUE;
+  if (thunar_list_model_index_lookup (store) != NULL)
+    return;
 
-              break;
-            }
+  /* the hidden files are not sorted yet */
+  hidden = g_ptr_array_new ();
+  for (lp = store->hidden; lp != NULL; lp = lp->next)
+    g_ptr_array_add (hidden, lp->data);
+  g_ptr_array_sort_with_data (hidden, thunar_list_model_cmp_array_func, store);
 
-          row = next;
+  /* merge them with the rows */
+  files = g_ptr_array_new_full (n_rows + hidden->len, g_object_unref);
+  row = g_sequence_get_begin_iter (store->rows);
+  end = g_sequence_get_end_iter (store->rows);
+  for (n = 0; row != end || n < hidden->len;)
+    {
+      if (row != end && (n >= hidden->len || thunar_list_model_cmp_func (g_sequence_get (row), hidden->pdata[n], store) <= 0))
+        {
+          g_ptr_array_add (files, g_object_ref (g_sequence_get (row)));
+          row = g_sequence_iter_next (row);
         }
-
-      /* check if the file was found */
-      if (!found)
+      else
         {
-          if (search_mode == FALSE)
-            {
-              /* file is hidden */
-              /* this only makes sense when not storing search results */
-              _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
-              store->hidden = g_slist_remove (store->hidden, lp->data);
-              g_object_unref (G_OBJECT (lp->data));
-            }
+          g_ptr_array_add (files, g_object_ref (hidden->pdata[n++]));
         }
     }
-
-  /* this probably changed */
-  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+  g_ptr_array_free (hidden, TRUE);
+
+  order = g_slice_new0 (ThunarListModelOrder);
+  order->sort_func = store->sort_func;
+  order->sort_sign = store->sort_sign;
+  order->sort_folders_first = store->sort_folders_first;
+  order->sort_case_sensitive = store->sort_case_sensitive;
+  order->files = files;
+
+  index = thunar_list_model_index_get (store->folder, TRUE);
+  g_queue_push_head (&index->orders, order);
+  while (index->orders.length > THUNAR_LIST_MODEL_INDEX_ORDERS_MAX)
+    thunar_list_model_order_free (g_queue_pop_tail (&index->orders));
 }
 
 
 
-static gint
-sort_by_date         (const ThunarFile *a,
-                      const ThunarFile *b,
-                      gboolean          case_sensitive,
-                      gint              type)
+static gboolean
+thunar_list_model_sort_by_order (ThunarListModel      *store,
+                                 ThunarListModelOrder *order)
 {
-  guint64 date_a;
-  guint64 date_b;
+  GSequenceIter **rows;
+  GSequenceIter  *row;
+  GSequenceIter  *end;
+  GtkTreePath    *path;
+  gint           *new_order;
+  gint            length;
+  gint            n;
+  guint           i;
 
-  date_a = thunar_file_get_date (a, type);
-  date_b = thunar_file_get_date (b, type);
+  length = g_sequence_get_length (store->rows);
+  rows = g_new (GSequenceIter *, length);
+  new_order = g_new (gint, length);
 
-  if (date_a < date_b)
-    return -1;
-  else if (date_a > date_b)
-    return 1;
+  /* pick the rows in the shared order, the hidden files are not in the rows */
+  for (i = 0, n = 0; i < order->files->len; ++i)
+    {
+      row = g_hash_table_lookup (store->file_rows, order->files->pdata[i]);
+      if (row == NULL)
+        continue;
 
-  return thunar_file_compare_by_name (a, b, case_sensitive);
-}
+      if (G_UNLIKELY (n == length))
+        break;
 
+      rows[n] = row;
+      new_order[n++] = g_sequence_iter_get_position (row);
+    }
 
+  /* some row is not a file of the folder, sort the usual way */
+  if (G_UNLIKELY (n != length || i != order->files->len))
+    {
+      g_free (new_order);
+      g_free (rows);
+      return FALSE;
+    }
 
-static gint
-sort_by_date_created (const ThunarFile *a,
-                      const ThunarFile *b,
-                      gboolean          case_sensitive)
-{
-  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_CREATED);
-}
+  end = g_sequence_get_end_iter (store->rows);
+  for (n = 0; n < length; ++n)
+    g_sequence_move (rows[n], end);
+  thunar_list_model_cursor_reset (store);
 
+  path = gtk_tree_path_new_first ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+  gtk_tree_path_free (path);
 
+  g_free (new_order);
+  g_free (rows);
 
-static gint
-sort_by_date_accessed (const ThunarFile *a,
-                       const ThunarFile *b,
-                       gboolean          case_sensitive)
-{
-  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_ACCESSED);
+  return TRUE;
 }
 
 
 
-static gint
-sort_by_date_modified (const ThunarFile *a,
-                       const ThunarFile *b,
-                       gboolean          case_sensitive)
+static void
+thunar_list_model_sort (ThunarListModel *store)
 {
-  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_MODIFIED);
-}
+  ThunarListModelSortKey *keys;
+  ThunarListModelOrder   *order;
+  GtkTreePath            *path;
+  GSequenceIter          *row;
+  GSequenceIter          *end;
+  gboolean                has_key;
+  gint                   *new_order;
+  gint                    n;
+  gint                    length;
+  gint64                  start_time;
 
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
+  length = g_sequence_get_length (store->rows);
+  if (G_UNLIKELY (length <= 1))
+    return;
 
-static gint
-sort_by_date_deleted (const ThunarFile *a,
-                      const ThunarFile *b,
-                      gboolean          case_sensitive)
-{
-  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_DELETED);
-}
+  start_time = g_get_monotonic_time ();
 
+  /* another model of the folder already sorted it this way */
+  order = thunar_list_model_index_lookup (store);
+  if (order != NULL && thunar_list_model_sort_by_order (store, order))
+    {
+      thunar_stats_count (THUNAR_STATS_LIST_MODEL_INDEX_HIT);
+      thunar_stats_record_since (THUNAR_STATS_LIST_MODEL_SORT, start_time);
+      return;
+    }
 
+  keys = g_new (ThunarListModelSortKey, length);
+  new_order = g_new (gint, length);
 
-static gint
-sort_by_recency      (const ThunarFile *a,
-                      const ThunarFile *b,
-                      gboolean          case_sensitive)
-{
-  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_RECENCY);
-}
+  /* extract the sort keys once, instead of querying
+   * the files again and again while comparing */
+  has_key = thunar_list_model_sort_has_key (store);
+  row = g_sequence_get_begin_iter (store->rows);
+  for (n = 0; n < length; ++n)
+    {
+      keys[n].row = row;
+      keys[n].file = g_sequence_get (row);
+      keys[n].position = n;
+      keys[n].is_dir = store->sort_folders_first && thunar_file_is_directory (keys[n].file);
+      keys[n].key = has_key ? thunar_list_model_sort_get_key (store, keys[n].file) : 0;
+      row = g_sequence_iter_next (row);
+    }
 
+  /* sort */
+  thunar_list_model_sort_keys (store, keys, length, has_key);
 
+  /* apply the new order to the rows, new_order[newpos] = oldpos */
+  end = g_sequence_get_end_iter (store->rows);
+  for (n = 0; n < length; ++n)
+    {
+      g_sequence_move (keys[n].row, end);
+      new_order[n] = keys[n].position;
+    }
+  thunar_list_model_cursor_reset (store);
 
-static gint
-sort_by_location (const ThunarFile *a,
-                  const ThunarFile *b,
-                  gboolean          case_sensitive)
-{
-  gchar *uri_a;
-  gchar *uri_b;
-  gchar *location_a;
-  gchar *location_b;
-  gint   result;
+  /* tell the view about the new item order */
+  path = gtk_tree_path_new_first ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+  gtk_tree_path_free (path);
 
-  uri_a = thunar_file_dup_uri (a);
-  uri_b = thunar_file_dup_uri (b);
+  g_free (new_order);
+  g_free (keys);
 
-  location_a = g_path_get_dirname (uri_a);
-  location_b = g_path_get_dirname (uri_b);
+  thunar_stats_record_since (THUNAR_STATS_LIST_MODEL_SORT, start_time);
 
-  result = strcasecmp (location_a, location_b);
+  /* let the other models of the folder reuse the order */
+  thunar_list_model_index_publish (store);
+}
 
-  g_free (uri_a);
-  g_free (uri_b);
-  g_free (location_a);
-  g_free (location_b);
 
-  return result;
+
+static void
+thunar_list_model_monitor_file_changed (ThunarFileMonitor *file_monitor,
+                                        ThunarFile        *file,
+                                        ThunarListModel   *store)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  thunar_list_model_file_changed (file, store);
 }
 
 
 
-static gint
-sort_by_group (const ThunarFile *a,
-               const ThunarFile *b,
-               gboolean          case_sensitive)
+static void
+thunar_list_model_watch_files (ThunarListModel *store)
 {
-  ThunarGroup *group_a;
-  ThunarGroup *group_b;
-  guint32      gid_a;
-  guint32      gid_b;
-  gint         result;
-  const gchar *name_a;
-  const gchar *name_b;
+  GFile    *directory = NULL;
+  gboolean  watch_all;
 
-  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
+  /* search results come from anywhere below the folder, unless filtered from its files */
+  watch_all = (store->folder != NULL && store->search_terms != NULL && store->filter_query == NULL);
+  if (store->folder != NULL && !watch_all)
+    directory = thunar_file_get_file (thunar_folder_get_corresponding_file (store->folder));
 
-  group_a = thunar_file_get_group (a);
-  group_b = thunar_file_get_group (b);
+  if (store->watched_directory != NULL
+      && (directory == NULL || !g_file_equal (directory, store->watched_directory)))
+    {
+      thunar_file_monitor_unwatch_children (store->watched_directory, thunar_list_model_file_changed, store);
+      g_object_unref (store->watched_directory);
+      store->watched_directory = NULL;
+    }
 
-  if (group_a != NULL && group_b != NULL)
+  if (directory != NULL && store->watched_directory == NULL)
     {
-      name_a = thunar_group_get_name (group_a);
-      name_b = thunar_group_get_name (group_b);
+      store->watched_directory = g_object_ref (directory);
+      thunar_file_monitor_watch_children (directory, thunar_list_model_file_changed, store);
+    }
 
-      if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
-      else
-        result = strcmp (name_a, name_b);
+  if (watch_all && store->file_changed_id == 0)
+    {
+      store->file_changed_id = g_signal_connect (G_OBJECT (store->file_monitor), "file-changed",
+                                                 G_CALLBACK (thunar_list_model_monitor_file_changed), store);
     }
-  else
+  else if (!watch_all && store->file_changed_id != 0)
     {
-      gid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
-      gid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
-
-      result = CLAMP ((gint) gid_a - (gint) gid_b, -1, 1);
+      g_signal_handler_disconnect (G_OBJECT (store->file_monitor), store->file_changed_id);
+      store->file_changed_id = 0;
     }
-
-  if (group_a != NULL)
-    g_object_unref (group_a);
-
-  if (group_b != NULL)
-    g_object_unref (group_b);
-
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
 }
 
 
 
-static gint
-sort_by_mime_type (const ThunarFile *a,
-                   const ThunarFile *b,
-                   gboolean          case_sensitive)
+static void
+thunar_list_model_file_changed (ThunarFile *file,
+                                gpointer    user_data)
 {
-  const gchar *content_type_a;
-  const gchar *content_type_b;
-  gint         result;
+  ThunarListModel *store = THUNAR_LIST_MODEL (user_data);
+  GSequenceIter   *row;
+  gchar           *key;
+  guint            position;
 
-  content_type_a = thunar_file_get_content_type (THUNAR_FILE (a));
-  content_type_b = thunar_file_get_content_type (THUNAR_FILE (b));
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  if (content_type_a == NULL)
-    content_type_a = "";
-  if (content_type_b == NULL)
-    content_type_b = "";
+  /* the cached strings of the file are outdated now */
+  g_hash_table_remove (store->row_cache, file);
 
-  result = strcasecmp (content_type_a, content_type_b);
+  /* a renamed file moves in the sorted names */
+  if (store->name_keys != NULL)
+    {
+      position = GPOINTER_TO_UINT (g_hash_table_lookup (store->name_positions, file));
+      if (position > 0)
+        {
+          key = g_utf8_casefold (thunar_file_get_display_name (file), -1);
+          if (strcmp (key, g_array_index (store->name_keys, ThunarListModelNameKey, position - 1).key) != 0)
+            thunar_list_model_name_keys_drop (store);
+          g_free (key);
+        }
+    }
 
-  if (result == 0)
-    result = thunar_file_compare_by_name (a, b, case_sensitive);
+  /* search results get the changes of all folders */
+  row = g_hash_table_lookup (store->file_rows, file);
+  if (row == NULL)
+    return;
 
-  return result;
+  /* the old size and date of the file are not known to update the totals */
+  store->summary_valid = FALSE;
+
+  /* leave the re-sorting and redrawing for later */
+  if (store->changes_frozen > 0)
+    {
+      if (g_hash_table_add (store->changed_files, file))
+        {
+          g_queue_push_tail (&store->changed_queue, g_object_ref (file));
+          if (store->changed_queue.length == 1)
+            g_signal_emit (G_OBJECT (store), list_model_signals[CHANGES_PENDING], 0);
+        }
+      return;
+    }
+
+  thunar_list_model_row_update (store, row);
 }
 
 
 
-static gint
-sort_by_owner (const ThunarFile *a,
-               const ThunarFile *b,
-               gboolean          case_sensitive)
+static void
+thunar_list_model_row_update (ThunarListModel *store,
+                              GSequenceIter   *row)
 {
-  const gchar *name_a;
-  const gchar *name_b;
-  ThunarUser  *user_a;
-  ThunarUser  *user_b;
-  guint32      uid_a;
-  guint32      uid_b;
-  gint         result;
-
-  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
+  gint           pos_after;
+  gint           pos_before;
+  gint          *new_order;
+  gint           length;
+  gint           i, j;
+  GtkTreePath   *path;
+  GtkTreeIter    iter;
 
-  user_a = thunar_file_get_user (a);
-  user_b = thunar_file_get_user (b);
+  /* generate the iterator for this row */
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
+  pos_before = g_sequence_iter_get_position (row);
 
-  if (user_a != NULL && user_b != NULL)
+  /* check if the sorting changed, unsorted search results
+   * are sorted as a whole when the search is done */
+  if (G_LIKELY (!store->search_unsorted))
     {
-      /* compare the system names */
-      name_a = thunar_user_get_name (user_a);
-      name_b = thunar_user_get_name (user_b);
-
-      if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
-      else
-        result = strcmp (name_a, name_b);
+      g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+      thunar_list_model_cursor_reset (store);
     }
-  else
+  pos_after = g_sequence_iter_get_position (row);
+  if (pos_after != pos_before)
     {
-      uid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
-      uid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
+      /* do swap sorting here since its much faster than a complete sort */
+      length = g_sequence_get_length (store->rows);
+      if (G_LIKELY (length < 2000))
+        new_order = g_newa (gint, length);
+      else
+        new_order = g_new (gint, length);
 
-      result = CLAMP ((gint) uid_a - (gint) uid_b, -1, 1);
+      /* new_order[newpos] = oldpos */
+      for (i = 0, j = 0; i < length; ++i)
+        {
+          if (G_UNLIKELY (i == pos_after))
+            {
+              new_order[i] = pos_before;
+            }
+          else
+            {
+              if (G_UNLIKELY (j == pos_before))
+                j++;
+              new_order[i] = j++;
+            }
+        }
+
+      /* tell the view about the new item order */
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+      gtk_tree_path_free (path);
+
+      /* clean up if we used the heap */
+      if (G_UNLIKELY (length >= 2000))
+        g_free (new_order);
     }
 
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
+  /* notify the view that it has to redraw the file */
+  path = gtk_tree_path_new_from_indices (pos_before, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
 
-static gint
-sort_by_permissions (const ThunarFile *a,
-                     const ThunarFile *b,
-                     gboolean          case_sensitive)
+static void
+thunar_list_model_users_changed (ThunarUserManager *manager,
+                                 ThunarListModel   *store)
 {
-  ThunarFileMode mode_a;
-  ThunarFileMode mode_b;
+  _thunar_return_if_fail (THUNAR_IS_USER_MANAGER (manager));
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
-  mode_a = thunar_file_get_mode (a);
-  mode_b = thunar_file_get_mode (b);
+  /* drop the owner and group names cached in the rows */
+  store->format_stamp++;
 
-  if (mode_a < mode_b)
-    return -1;
-  else if (mode_a > mode_b)
-    return 1;
+  /* the names are the sort keys of these columns */
+  if (store->sort_func == sort_by_owner || store->sort_func == sort_by_group)
+    thunar_list_model_sort (store);
 
-  return thunar_file_compare_by_name (a, b, case_sensitive);
+  /* emit a "changed" signal for each row, so the display is reloaded with the new names */
+  gtk_tree_model_foreach (GTK_TREE_MODEL (store),
+                          (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
+                          NULL);
 }
 
 
 
-static gint
-sort_by_size (const ThunarFile *a,
-              const ThunarFile *b,
-              gboolean          case_sensitive)
+static void
+thunar_list_model_free_space_changed (ThunarFreeSpaceCache *cache,
+                                      ThunarListModel      *store)
 {
-  guint64 size_a;
-  guint64 size_b;
+  GSequenceIter *row;
+  GSequenceIter *end;
+  GtkTreePath   *path;
+  GtkTreeIter    iter;
 
-  size_a = thunar_file_get_size (a);
-  size_b = thunar_file_get_size (b);
+  _thunar_return_if_fail (THUNAR_IS_FREE_SPACE_CACHE (cache));
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
-  if (size_a < size_b)
-    return -1;
-  else if (size_a > size_b)
-    return 1;
+  /* only the size column of mountables shows the usage */
+  end = g_sequence_get_end_iter (store->rows);
+  for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
+    {
+      if (G_LIKELY (!thunar_file_is_mountable (g_sequence_get (row))))
+        continue;
 
-  return thunar_file_compare_by_name (a, b, case_sensitive);
+      GTK_TREE_ITER_INIT (iter, store->stamp, row);
+      path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), &iter);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+      gtk_tree_path_free (path);
+    }
 }
 
 
 
-static gint
-sort_by_size_in_bytes (const ThunarFile *a,
-                       const ThunarFile *b,
-                       gboolean          case_sensitive)
+static void
+thunar_list_model_folder_destroy (ThunarFolder    *folder,
+                                  ThunarListModel *store)
 {
-  return sort_by_size (a, b, case_sensitive);
-}
-
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  thunar_list_model_set_folder (store, NULL, NULL);
+
+  /* TODO: What to do when the folder is deleted? */
+}
+
+
+
+static void
+thunar_list_model_folder_error (ThunarFolder    *folder,
+                                const GError    *error,
+                                ThunarListModel *store)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (error != NULL);
+
+  /* reset the current folder */
+  thunar_list_model_set_folder (store, NULL, NULL);
+
+  /* forward the error signal */
+  g_signal_emit (G_OBJECT (store), list_model_signals[ERROR], 0, error);
+}
+
+
+
+static void
+thunar_list_model_files_added (ThunarFolder    *folder,
+                               GList           *files,
+                               ThunarListModel *store)
+{
+  GList       *filtered;
+  GList       *lp;
+  ThunarFile  *file;
+  gboolean     matched;
+
+  /* pass the list directly if not currently showing search results */
+  if (store->search_terms == NULL)
+    {
+      thunar_list_model_insert_files (store, files, FALSE);
+      return;
+    }
+
+  /* otherwise, filter out files that don't match the current search terms */
+  filtered = NULL;
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* take a reference on that file */
+      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
+      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+      matched = thunar_list_model_search_file_match (store->search_terms, file, store->search_fuzzy);
+
+      if (! matched)
+        g_object_unref (file);
+      else
+        filtered = g_list_append (filtered, file);
+    }
+  thunar_list_model_insert_files (store, filtered, FALSE);
+  thunar_g_list_free_full (filtered);
+}
 
 
 static gint
-sort_by_size_and_items_count (ThunarFile *a,
-                              ThunarFile *b,
-                              gboolean    case_sensitive)
+thunar_list_model_cmp_array_func (gconstpointer a,
+                                  gconstpointer b,
+                                  gpointer      user_data)
 {
-  guint32       count_a;
-  guint32       count_b;
+  return thunar_list_model_cmp_func (*(ThunarFile **) a, *(ThunarFile **) b, user_data);
+}
 
-  if (thunar_file_is_directory (a) && thunar_file_is_directory (b))
-  {
-    count_a = thunar_file_get_file_count (a, NULL, NULL);
-    count_b = thunar_file_get_file_count (b, NULL, NULL);
 
-    if (count_a < count_b)
-      return -1;
-    else if (count_a > count_b)
-      return 1;
-    else
-      return thunar_file_compare_by_name (a, b, case_sensitive);
-  }
 
-  return sort_by_size(a, b, case_sensitive);
+static void
+thunar_list_model_insert_files_bulk (ThunarListModel *store,
+                                     GPtrArray       *files,
+                                     gboolean         has_handler)
+{
+  GtkTreePath    *path;
+  GtkTreeIter     iter;
+  GSequenceIter  *row;
+  GSequenceIter  *end;
+  GSequenceIter **new_rows;
+  gint           *new_positions;
+  gint           *indices;
+  gint            position;
+  guint           n;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* sort the new files once... */
+  g_ptr_array_sort_with_data (files, thunar_list_model_cmp_array_func, store);
+
+  new_rows = g_new (GSequenceIter *, files->len);
+  new_positions = g_new (gint, files->len);
+
+  /* ...and merge them into the rows in a single pass, the
+   * positions of the inserted rows are counted on the way */
+  row = g_sequence_get_begin_iter (store->rows);
+  end = g_sequence_get_end_iter (store->rows);
+  for (n = 0, position = 0; n < files->len; ++n)
+    {
+      while (row != end && thunar_list_model_cmp_func (g_sequence_get (row), files->pdata[n], store) <= 0)
+        {
+          row = g_sequence_iter_next (row);
+          position++;
+        }
+
+      new_rows[n] = g_sequence_insert_before (row, files->pdata[n]);
+      thunar_list_model_cursor_reset (store);
+      g_hash_table_insert (store->file_rows, files->pdata[n], new_rows[n]);
+      new_positions[n] = position++;
+    }
+
+  /* announcing the rows in ascending order is valid, since all the
+   * rows in front of a new row are either old or already announced */
+  if (has_handler)
+    {
+      path = gtk_tree_path_new_first ();
+      indices = gtk_tree_path_get_indices (path);
+
+      for (n = 0; n < files->len; ++n)
+        {
+          GTK_TREE_ITER_INIT (iter, store->stamp, new_rows[n]);
+          indices[0] = new_positions[n];
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+        }
+
+      gtk_tree_path_free (path);
+    }
+
+  g_free (new_rows);
+  g_free (new_positions);
+}
+
+
+
+static void
+thunar_list_model_insert_file_array (ThunarListModel *store,
+                                     gpointer        *files,
+                                     guint            n_files,
+                                     gboolean         presorted)
+{
+  GtkTreePath   *path;
+  GtkTreeIter    iter;
+  ThunarFile    *file;
+  gint          *indices;
+  GSequenceIter *row;
+  GPtrArray     *visible;
+  gboolean       has_handler;
+  gboolean       search_mode;
+  guint          n;
+
+  /* check if we have any handlers connected for "row-inserted" */
+  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
+
+  /* process all added files */
+  search_mode = (store->search_terms != NULL);
+  visible = g_ptr_array_new ();
+  for (n = 0; n < n_files; ++n)
+    {
+      /* take a reference on that file */
+      file = THUNAR_FILE (g_object_ref (G_OBJECT (files[n])));
+      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+      /* check if the file should be stashed in the hidden list */
+      /* The ->hidden list is an optimization used by the model when
+       * it is not being used to store search results. In the search
+       * case, we simply restart the search, */
+      if (!store->show_hidden && thunar_file_is_hidden (file))
+        {
+          if (search_mode == FALSE)
+            store->hidden = g_slist_prepend (store->hidden, file);
+          else
+            g_object_unref (file);
+        }
+      else
+        {
+          /* the rows take over the reference */
+          g_ptr_array_add (visible, file);
+
+          /* don't block on the name service for the owner columns */
+          thunar_file_prefetch_owner (file);
+        }
+    }
+
+  thunar_stats_record (THUNAR_STATS_LIST_MODEL_INSERT, n_files);
+
+  /* running searches append their results, they are sorted at the end,
+   * and files in the order of the rows are appended to an empty model */
+  if (store->search_unsorted || presorted)
+    {
+      path = gtk_tree_path_new_first ();
+      indices = gtk_tree_path_get_indices (path);
+
+      for (n = 0; n < visible->len; ++n)
+        {
+          row = g_sequence_append (store->rows, visible->pdata[n]);
+          thunar_list_model_cursor_reset (store);
+          g_hash_table_insert (store->file_rows, visible->pdata[n], row);
+
+          if (has_handler)
+            {
+              GTK_TREE_ITER_INIT (iter, store->stamp, row);
+              indices[0] = g_sequence_get_length (store->rows) - 1;
+              gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+            }
+        }
+
+      gtk_tree_path_free (path);
+    }
+  /* merging a sorted batch costs one walk over the existing rows, which
+   * pays off compared to sorted inserts if the batch is large enough */
+  else if (visible->len >= THUNAR_LIST_MODEL_BULK_INSERT_MIN
+      && visible->len * THUNAR_LIST_MODEL_BULK_INSERT_RATIO >= (guint) g_sequence_get_length (store->rows))
+    {
+      thunar_list_model_insert_files_bulk (store, visible, has_handler);
+    }
+  else if (visible->len > 0)
+    {
+      /* we use a simple trick here to avoid allocating
+       * GtkTreePath's again and again, by simply accessing
+       * the indices directly and only modifying the first
+       * item in the integer array... looks a hack, eh?
+       */
+      path = gtk_tree_path_new_first ();
+      indices = gtk_tree_path_get_indices (path);
+
+      for (n = 0; n < visible->len; ++n)
+        {
+          /* insert the file */
+          row = g_sequence_insert_sorted (store->rows, visible->pdata[n],
+                                          thunar_list_model_cmp_func, store);
+          thunar_list_model_cursor_reset (store);
+          g_hash_table_insert (store->file_rows, visible->pdata[n], row);
+
+          if (has_handler)
+            {
+              /* generate an iterator for the new item */
+              GTK_TREE_ITER_INIT (iter, store->stamp, row);
+
+              indices[0] = g_sequence_iter_get_position (row);
+              gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+            }
+        }
+
+      /* release the path */
+      gtk_tree_path_free (path);
+    }
+
+  /* account the new rows */
+  if (store->summary_valid)
+    for (n = 0; n < visible->len; ++n)
+      thunar_list_model_summary_add (&store->summary, visible->pdata[n]);
+
+  g_ptr_array_free (visible, TRUE);
+
+  /* number of visible files may have changed */
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+}
+
+
+
+static void
+thunar_list_model_insert_files (ThunarListModel *store,
+                                GList           *files,
+                                gboolean         presorted)
+{
+  GPtrArray *array;
+  GList     *lp;
+
+  array = g_ptr_array_new ();
+  for (lp = files; lp != NULL; lp = lp->next)
+    g_ptr_array_add (array, lp->data);
+
+  thunar_list_model_insert_file_array (store, array->pdata, array->len, presorted);
+
+  g_ptr_array_free (array, TRUE);
+}
+
+
+
+static gint
+thunar_list_model_row_cmp_reverse (gconstpointer a,
+                                   gconstpointer b)
+{
+  return g_sequence_iter_compare (*(GSequenceIter **) b, *(GSequenceIter **) a);
+}
+
+
+
+static void
+thunar_list_model_files_removed (ThunarFolder    *folder,
+                                 GList           *files,
+                                 ThunarListModel *store)
+{
+  GList         *lp;
+  GSList        *slp, *snext;
+  GSequenceIter *row;
+  GPtrArray     *rows;
+  GHashTable    *hidden = NULL;
+  GtkTreePath   *path;
+  ThunarFile    *file;
+  gboolean       search_mode;
+  gboolean       has_handler;
+  guint          n;
+
+  /* sort out the rows in the model and the hidden files */
+  search_mode = (store->search_terms != NULL);
+  rows = g_ptr_array_new ();
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      row = g_hash_table_lookup (store->file_rows, lp->data);
+      if (row != NULL)
+        {
+          g_ptr_array_add (rows, row);
+        }
+      else if (search_mode == FALSE)
+        {
+          /* file is hidden */
+          /* this only makes sense when not storing search results */
+          if (hidden == NULL)
+            hidden = g_hash_table_new (g_direct_hash, g_direct_equal);
+          g_hash_table_add (hidden, lp->data);
+        }
+    }
+
+  /* remove the rows from the last to the first, so the positions of
+   * the ones still to be removed stay valid for "row-deleted" */
+  if (rows->len > 1)
+    g_ptr_array_sort (rows, thunar_list_model_row_cmp_reverse);
+
+  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
+  for (n = 0; n < rows->len; n++)
+    {
+      row = g_ptr_array_index (rows, n);
+      file = g_sequence_get (row);
+
+      /* setup path for "row-deleted" */
+      path = has_handler ? gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1) : NULL;
+
+      /* remove file from the model */
+      g_hash_table_remove (store->row_cache, file);
+      g_hash_table_remove (store->file_rows, file);
+      thunar_list_model_summary_remove (store, file);
+      g_sequence_remove (row);
+      thunar_list_model_cursor_reset (store);
+
+      /* notify the view(s) */
+      if (G_LIKELY (path != NULL))
+        {
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+          gtk_tree_path_free (path);
+        }
+    }
+  g_ptr_array_free (rows, TRUE);
+
+  /* drop the hidden files in a single pass over the list */
+  if (hidden != NULL)
+    {
+      n = 0;
+      for (slp = store->hidden; slp != NULL; slp = snext)
+        {
+          snext = slp->next;
+          if (g_hash_table_contains (hidden, slp->data))
+            {
+              g_object_unref (G_OBJECT (slp->data));
+              store->hidden = g_slist_delete_link (store->hidden, slp);
+              n++;
+            }
+        }
+
+      _thunar_assert (n == g_hash_table_size (hidden));
+      g_hash_table_destroy (hidden);
+    }
+
+  /* this probably changed */
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+}
+
+
+
+static gint
+sort_by_date         (const ThunarFile *a,
+                      const ThunarFile *b,
+                      gboolean          case_sensitive,
+                      gint              type)
+{
+  guint64 date_a;
+  guint64 date_b;
+
+  date_a = thunar_file_get_date (a, type);
+  date_b = thunar_file_get_date (b, type);
+
+  if (date_a < date_b)
+    return -1;
+  else if (date_a > date_b)
+    return 1;
+
+  return thunar_file_compare_by_name (a, b, case_sensitive);
+}
+
+
+
+static gint
+sort_by_date_created (const ThunarFile *a,
+                      const ThunarFile *b,
+                      gboolean          case_sensitive)
+{
+  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_CREATED);
+}
+
+
+
+static gint
+sort_by_date_accessed (const ThunarFile *a,
+                       const ThunarFile *b,
+                       gboolean          case_sensitive)
+{
+  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_ACCESSED);
+}
+
+
+
+static gint
+sort_by_date_modified (const ThunarFile *a,
+                       const ThunarFile *b,
+                       gboolean          case_sensitive)
+{
+  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_MODIFIED);
+}
+
+
+
+static gint
+sort_by_date_deleted (const ThunarFile *a,
+                      const ThunarFile *b,
+                      gboolean          case_sensitive)
+{
+  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_DATE_DELETED);
+}
+
+
+
+static gint
+sort_by_recency      (const ThunarFile *a,
+                      const ThunarFile *b,
+                      gboolean          case_sensitive)
+{
+  return sort_by_date (a, b, case_sensitive, THUNAR_FILE_RECENCY);
+}
+
+
+
+static gint
+sort_by_location (const ThunarFile *a,
+                  const ThunarFile *b,
+                  gboolean          case_sensitive)
+{
+  gchar *uri_a;
+  gchar *uri_b;
+  gchar *location_a;
+  gchar *location_b;
+  gint   result;
+
+  uri_a = thunar_file_dup_uri (a);
+  uri_b = thunar_file_dup_uri (b);
+
+  location_a = g_path_get_dirname (uri_a);
+  location_b = g_path_get_dirname (uri_b);
+
+  result = strcasecmp (location_a, location_b);
+
+  g_free (uri_a);
+  g_free (uri_b);
+  g_free (location_a);
+  g_free (location_b);
+
+  return result;
+}
+
+
+
+static gint
+sort_by_group (const ThunarFile *a,
+               const ThunarFile *b,
+               gboolean          case_sensitive)
+{
+  ThunarGroup *group_a;
+  ThunarGroup *group_b;
+  guint32      gid_a;
+  guint32      gid_b;
+  gint         result;
+  const gchar *name_a;
+  const gchar *name_b;
+
+  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
+
+  group_a = thunar_file_get_group (a);
+  group_b = thunar_file_get_group (b);
+
+  if (group_a != NULL && group_b != NULL)
+    {
+      name_a = thunar_group_get_name (group_a);
+      name_b = thunar_group_get_name (group_b);
+
+      if (!case_sensitive)
+        result = strcasecmp (name_a, name_b);
+      else
+        result = strcmp (name_a, name_b);
+    }
+  else
+    {
+      gid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
+                                                G_FILE_ATTRIBUTE_UNIX_GID);
+      gid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
+                                                G_FILE_ATTRIBUTE_UNIX_GID);
+
+      result = CLAMP ((gint) gid_a - (gint) gid_b, -1, 1);
+    }
+
+  if (group_a != NULL)
+    g_object_unref (group_a);
+
+  if (group_b != NULL)
+    g_object_unref (group_b);
+
+  if (result == 0)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
+  else
+    return result;
+}
+
+
+
+static gint
+sort_by_mime_type (const ThunarFile *a,
+                   const ThunarFile *b,
+                   gboolean          case_sensitive)
+{
+  const gchar *content_type_a;
+  const gchar *content_type_b;
+  gint         result;
+
+  content_type_a = thunar_file_get_content_type (THUNAR_FILE (a));
+  content_type_b = thunar_file_get_content_type (THUNAR_FILE (b));
+
+  if (content_type_a == NULL)
+    content_type_a = "";
+  if (content_type_b == NULL)
+    content_type_b = "";
+
+  result = strcasecmp (content_type_a, content_type_b);
+
+  if (result == 0)
+    result = thunar_file_compare_by_name (a, b, case_sensitive);
+
+  return result;
+}
+
+
+
+static gint
+sort_by_owner (const ThunarFile *a,
+               const ThunarFile *b,
+               gboolean          case_sensitive)
+{
+  const gchar *name_a;
+  const gchar *name_b;
+  ThunarUser  *user_a;
+  ThunarUser  *user_b;
+  guint32      uid_a;
+  guint32      uid_b;
+  gint         result;
+
+  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
+
+  user_a = thunar_file_get_user (a);
+  user_b = thunar_file_get_user (b);
+
+  if (user_a != NULL && user_b != NULL)
+    {
+      /* compare the system names */
+      name_a = thunar_user_get_name (user_a);
+      name_b = thunar_user_get_name (user_b);
+
+      if (!case_sensitive)
+        result = strcasecmp (name_a, name_b);
+      else
+        result = strcmp (name_a, name_b);
+    }
+  else
+    {
+      uid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
+                                                G_FILE_ATTRIBUTE_UNIX_UID);
+      uid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
+                                                G_FILE_ATTRIBUTE_UNIX_UID);
+
+      result = CLAMP ((gint) uid_a - (gint) uid_b, -1, 1);
+    }
+
+  if (result == 0)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
+  else
+    return result;
+}
+
+
+
+static gint
+sort_by_permissions (const ThunarFile *a,
+                     const ThunarFile *b,
+                     gboolean          case_sensitive)
+{
+  ThunarFileMode mode_a;
+  ThunarFileMode mode_b;
+
+  mode_a = thunar_file_get_mode (a);
+  mode_b = thunar_file_get_mode (b);
+
+  if (mode_a < mode_b)
+    return -1;
+  else if (mode_a > mode_b)
+    return 1;
+
+  return thunar_file_compare_by_name (a, b, case_sensitive);
+}
+
+
+
+static gint
+sort_by_size (const ThunarFile *a,
+              const ThunarFile *b,
+              gboolean          case_sensitive)
+{
+  guint64 size_a;
+  guint64 size_b;
+
+  size_a = thunar_file_get_size (a);
+  size_b = thunar_file_get_size (b);
+
+  if (size_a < size_b)
+    return -1;
+  else if (size_a > size_b)
+    return 1;
+
+  return thunar_file_compare_by_name (a, b, case_sensitive);
+}
+
+
+
+static gint
+sort_by_size_in_bytes (const ThunarFile *a,
+                       const ThunarFile *b,
+                       gboolean          case_sensitive)
+{
+  return sort_by_size (a, b, case_sensitive);
+}
+
+
+
+static gint
+sort_by_size_and_items_count (ThunarFile *a,
+                              ThunarFile *b,
+                              gboolean    case_sensitive)
+{
+  guint32       count_a;
+  guint32       count_b;
+
+  if (thunar_file_is_directory (a) && thunar_file_is_directory (b))
+  {
+    /* only compare the cached counts, sorting must never wait for I/O */
+    count_a = thunar_file_get_file_count (a, NULL, NULL);
+    count_b = thunar_file_get_file_count (b, NULL, NULL);
+
+    if (count_a < count_b)
+      return -1;
+    else if (count_a > count_b)
+      return 1;
+    else
+      return thunar_file_compare_by_name (a, b, case_sensitive);
+  }
+
+  return sort_by_size(a, b, case_sensitive);
+}
+
+
+
+static gint
+sort_by_type (const ThunarFile *a,
+              const ThunarFile *b,
+              gboolean          case_sensitive)
+{
+  const gchar *interned_a;
+  const gchar *interned_b;
+  gchar       *description_a = NULL;
+  gchar       *description_b = NULL;
+  gint         result;
+
+  /* files of the same content type share their description, only
+   * symlinks have one of their own, see thunar_file_peek_content_type_desc() */
+  interned_a = thunar_file_peek_content_type_desc (THUNAR_FILE (a));
+  interned_b = thunar_file_peek_content_type_desc (THUNAR_FILE (b));
+  if (G_LIKELY (interned_a != NULL && interned_b != NULL))
+    {
+      if (interned_a == interned_b)
+        result = 0;
+      else if (!case_sensitive)
+        result = strcasecmp (interned_a, interned_b);
+      else
+        result = strcmp (interned_a, interned_b);
+
+      if (result == 0)
+        return thunar_file_compare_by_name (a, b, case_sensitive);
+      else
+        return result;
+    }
+
+  /* we alter the description of symlinks here because they are
+   * displayed as "... (link)" in the detailed list view as well */
+
+  /* fetch the content type description for @file(s) a & b */
+  description_a = thunar_file_get_content_type_desc (THUNAR_FILE (a));
+  description_b = thunar_file_get_content_type_desc (THUNAR_FILE (b));
+
+  /* avoid calling strcasecmp with NULL parameters */
+  if (description_a == NULL || description_b == NULL)
+    {
+      g_free (description_a);
+      g_free (description_b);
+
+      return 0;
+    }
+
+  if (!case_sensitive)
+    result = strcasecmp (description_a, description_b);
+  else
+    result = strcmp (description_a, description_b);
+
+  g_free (description_a);
+  g_free (description_b);
+
+  if (result == 0)
+    return thunar_file_compare_by_name (a, b, case_sensitive);
+  else
+    return result;
+}
+
+
+
+/**
+ * thunar_list_model_new:
+ *
+ * Allocates a new #ThunarListModel not associated with
+ * any #ThunarFolder.
+ *
+ * Return value: the newly allocated #ThunarListModel.
+ **/
+ThunarListModel*
+thunar_list_model_new (void)
+{
+  return g_object_new (THUNAR_TYPE_LIST_MODEL, NULL);
+}
+
+
+
+/**
+ * thunar_list_model_get_case_sensitive:
+ * @store : a valid #ThunarListModel object.
+ *
+ * Returns %TRUE if the sorting is done in a case-sensitive
+ * manner for @store.
+ *
+ * Return value: %TRUE if sorting is case-sensitive.
+ **/
+static gboolean
+thunar_list_model_get_case_sensitive (ThunarListModel *store)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
+  return store->sort_case_sensitive;
+}
+
+
+
+/**
+ * thunar_list_model_set_case_sensitive:
+ * @store          : a valid #ThunarListModel object.
+ * @case_sensitive : %TRUE to use case-sensitive sort for @store.
+ *
+ * If @case_sensitive is %TRUE the sorting in @store will be done
+ * in a case-sensitive manner.
+ **/
+static void
+thunar_list_model_set_case_sensitive (ThunarListModel *store,
+                                      gboolean         case_sensitive)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* normalize the setting */
+  case_sensitive = !!case_sensitive;
+
+  /* check if we have a new setting */
+  if (store->sort_case_sensitive != case_sensitive)
+    {
+      /* apply the new setting */
+      store->sort_case_sensitive = case_sensitive;
+
+      /* resort the model with the new setting */
+      thunar_list_model_sort (store);
+
+      /* notify listeners */
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_CASE_SENSITIVE]);
+
+      /* emit a "changed" signal for each row, so the display is
+         reloaded with the new case-sensitive setting */
+      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
+                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
+                              NULL);
+    }
+}
+
+
+
+/**
+ * thunar_list_model_get_date_style:
+ * @store : a valid #ThunarListModel object.
+ *
+ * Return value: the #ThunarDateStyle used to format dates in
+ *               the given @store.
+ **/
+static ThunarDateStyle
+thunar_list_model_get_date_style (ThunarListModel *store)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), THUNAR_DATE_STYLE_SIMPLE);
+  return store->date_style;
+}
+
+
+
+/**
+ * thunar_list_model_set_date_style:
+ * @store      : a valid #ThunarListModel object.
+ * @date_style : the #ThunarDateStyle that should be used to format
+ *               dates in the @store.
+ *
+ * Chances the style used to format dates in @store to the specified
+ * @date_style.
+ **/
+static void
+thunar_list_model_set_date_style (ThunarListModel *store,
+                                  ThunarDateStyle  date_style)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* check if we have a new setting */
+  if (store->date_style != date_style)
+    {
+      /* apply the new setting */
+      store->date_style = date_style;
+      store->format_stamp++;
+      thunar_list_model_update_format_timer (store);
+
+      /* notify listeners */
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_STYLE]);
+
+      /* emit a "changed" signal for each row, so the display is reloaded with the new date style */
+      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
+                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
+                              NULL);
+    }
+}
+
+
+
+/**
+ * thunar_list_model_get_date_custom_style:
+ * @store : a valid #ThunarListModel object.
+ *
+ * Return value: the style used to format customdates in the given @store.
+ **/
+static const char*
+thunar_list_model_get_date_custom_style (ThunarListModel *store)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+  return store->date_custom_style;
+}
+
+
+
+/**
+ * thunar_list_model_set_date_custom_style:
+ * @store             : a valid #ThunarListModel object.
+ * @date_custom_style : the style that should be used to format
+ *                      custom dates in the @store.
+ *
+ * Changes the style used to format custom dates in @store to the specified @date_custom_style.
+ **/
+static void
+thunar_list_model_set_date_custom_style (ThunarListModel *store,
+                                         const char      *date_custom_style)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* check if we have a new setting */
+  if (g_strcmp0 (store->date_custom_style, date_custom_style) != 0)
+    {
+      /* apply the new setting */
+      g_free (store->date_custom_style);
+      store->date_custom_style = g_strdup (date_custom_style);
+      store->format_stamp++;
+
+      /* notify listeners */
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_CUSTOM_STYLE]);
+
+      /* emit a "changed" signal for each row, so the display is reloaded with the new date style */
+      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
+                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
+                              NULL);
+    }
+}
+
+
+
+ThunarJob*
+thunar_list_model_get_job (ThunarListModel  *store)
+{
+  return store->recursive_search_job;
+}
+
+
+
+void
+thunar_list_model_set_job (ThunarListModel  *store,
+                           ThunarJob        *job)
+{
+  store->recursive_search_job = job;
+}
+
+
+
+static gboolean
+thunar_list_model_add_search_files (gpointer user_data)
+{
+  ThunarListModel *model = THUNAR_LIST_MODEL (user_data);
+  GList           *files;
+  GList           *chunk_end;
+  gint64           start_time = g_get_monotonic_time ();
+  gint64           deadline;
+  guint            n;
+  guint            n_files = 0;
+
+  /* only hold the lock while taking the new results */
+  g_mutex_lock (&model->mutex_files_to_add);
+  files = model->files_to_add;
+  model->files_to_add = NULL;
+  g_mutex_unlock (&model->mutex_files_to_add);
+
+  model->files_pending = g_list_concat (model->files_pending, files);
+
+  /* move the results to the model in chunks, until the time for this
+   * update is used up, so that the view stays responsive */
+  deadline = g_get_monotonic_time () + THUNAR_LIST_MODEL_SEARCH_UPDATE_BUDGET;
+  while (model->files_pending != NULL && g_get_monotonic_time () < deadline)
+    {
+      files = model->files_pending;
+      for (chunk_end = files, n = 1; chunk_end->next != NULL && n < THUNAR_LIST_MODEL_SEARCH_UPDATE_CHUNK; chunk_end = chunk_end->next, n++)
+        ;
+
+      /* split the chunk off the pending files */
+      model->files_pending = chunk_end->next;
+      if (chunk_end->next != NULL)
+        {
+          chunk_end->next->prev = NULL;
+          chunk_end->next = NULL;
+        }
+
+      thunar_list_model_insert_files (model, files, FALSE);
+      g_list_free (files);
+      n_files += n;
+    }
+
+  thunar_stats_record_callback ("thunar_list_model_add_search_files", start_time, n_files);
+
+  return TRUE;
+}
+
+
+/**
+ * thunar_list_model_split_search_query:
+ * @search_query: The search query to split.
+ * @error: Return location for regex compilation errors.
+ *
+ * Search terms are split on whitespace. Search queries must be
+ * normalized before passing to this function.
+ *
+ * See also: thunar_g_utf8_normalize_for_search().
+ *
+ * Return value: a list of search terms which must be freed with g_strfreev()
+ **/
+
+static gchar **
+thunar_list_model_split_search_query (const gchar  *search_query,
+                                      GError      **error)
+{
+  GRegex *whitespace_regex;
+  gchar **search_terms;
+
+  whitespace_regex = g_regex_new ("\\s+", 0, 0, error);
+  if (whitespace_regex == NULL)
+    return NULL;
+  search_terms = g_regex_split (whitespace_regex, search_query, 0);
+  g_regex_unref (whitespace_regex);
+  return search_terms;
+}
+
+
+
+static gboolean
+thunar_list_model_search_ascii_contains (const gchar *name,
+                                         gsize        name_len,
+                                         const gchar *term)
+{
+  gsize term_len = strlen (term);
+  gsize i, j;
+
+  if (term_len > name_len)
+    return FALSE;
+
+  for (i = 0; i + term_len <= name_len; i++)
+    {
+      /* terms are already folded, so only the name needs lowering */
+      for (j = 0; j < term_len; j++)
+        if (g_ascii_tolower (name[i + j]) != term[j])
+          break;
+      if (j == term_len)
+        return TRUE;
+    }
+
+  return FALSE;
 }
 
 
 
-static gint
-sort_by_type (const ThunarFile *a,
-              const ThunarFile *b,
-              gboolean          case_sensitive)
+static inline gboolean
+thunar_list_model_search_fuzzy_equal (const gchar *name_char,
+                                      gsize        name_char_len,
+                                      const gchar *term_char)
 {
-  gchar       *description_a = NULL;
-  gchar       *description_b = NULL;
-  gint         result;
+  /* terms are already folded, so only the name needs lowering */
+  if (((guchar) *term_char) < 0x80)
+    return g_ascii_tolower (*name_char) == *term_char;
 
-  /* we alter the description of symlinks here because they are
-   * displayed as "... (link)" in the detailed list view as well */
+  return name_char_len == (gsize) g_utf8_skip[(guchar) *term_char]
+      && memcmp (name_char, term_char, name_char_len) == 0;
+}
 
-  /* fetch the content type description for @file(s) a & b */
-  description_a = thunar_file_get_content_type_desc (THUNAR_FILE (a));
-  description_b = thunar_file_get_content_type_desc (THUNAR_FILE (b));
 
-  /* avoid calling strcasecmp with NULL parameters */
-  if (description_a == NULL || description_b == NULL)
+
+/**
+ * thunar_list_model_search_fuzzy_score:
+ * @name: The string to match against, normalized or plain ASCII.
+ * @name_len: The length of @name in bytes.
+ * @term: A search term, prepared with thunar_list_model_split_search_query().
+ *
+ * Matches the characters of @term against @name in order, but not
+ * necessarily in one piece. The shortest piece of @name which ends
+ * with the first complete match is scored, by the number of matched
+ * characters, how many of them start a word or follow each other,
+ * and how many characters are skipped between them.
+ *
+ * Return value: the score of the match, or -1 if @term does not match.
+ **/
+
+static gint
+thunar_list_model_search_fuzzy_score (const gchar *name,
+                                      gsize        name_len,
+                                      const gchar *term)
+{
+  const gchar *end = name + name_len;
+  const gchar *term_end;
+  const gchar *n;
+  const gchar *t;
+  const gchar *start;
+  const gchar *previous = NULL;
+  gsize        skip;
+  gint         score = 0;
+  glong        gap;
+
+  /* find the end of the first complete match */
+  for (n = name, t = term; n < end && *t != '\0'; n += skip)
     {
-      g_free (description_a);
-      g_free (description_b);
+      skip = g_utf8_skip[(guchar) *n];
+      if (thunar_list_model_search_fuzzy_equal (n, skip, t))
+        t += g_utf8_skip[(guchar) *t];
+    }
+  if (*t != '\0')
+    return -1;
 
-      return 0;
+  /* walk back from there to the last character where the match can start */
+  for (start = n, term_end = t; t > term;)
+    {
+      start = g_utf8_find_prev_char (name, start);
+      if (thunar_list_model_search_fuzzy_equal (start, g_utf8_skip[(guchar) *start], g_utf8_find_prev_char (term, t)))
+        t = g_utf8_find_prev_char (term, t);
     }
 
-  if (!case_sensitive)
-    result = strcasecmp (description_a, description_b);
-  else
-    result = strcmp (description_a, description_b);
+  for (; start < n && t < term_end; start += skip)
+    {
+      skip = g_utf8_skip[(guchar) *start];
+      if (!thunar_list_model_search_fuzzy_equal (start, skip, t))
+        continue;
 
-  g_free (description_a);
-  g_free (description_b);
+      score += THUNAR_LIST_MODEL_FUZZY_MATCH;
 
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
+      /* the start of the name or of a word, also in camel case */
+      if (start == name || strchr (" -_.+,()[]", start[-1]) != NULL
+          || (g_ascii_islower (start[-1]) && g_ascii_isupper (*start)))
+        score += THUNAR_LIST_MODEL_FUZZY_BOUNDARY;
+
+      if (previous != NULL)
+        {
+          gap = g_utf8_strlen (previous, start - previous) - 1;
+          if (gap == 0)
+            score += THUNAR_LIST_MODEL_FUZZY_CONSECUTIVE;
+          else
+            score -= THUNAR_LIST_MODEL_FUZZY_GAP_START + (gap - 1) * THUNAR_LIST_MODEL_FUZZY_GAP_EXTENSION;
+        }
+
+      previous = start;
+      t += g_utf8_skip[(guchar) *t];
+    }
+
+  return MAX (score, 0);
 }
 
 
 
 /**
- * thunar_list_model_new:
+ * thunar_list_model_search_terms_score:
+ * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
+ * @str: The string to match against, normalized or plain ASCII.
+ * @str_len: The length of @str in bytes.
+ * @fuzzy: Whether the terms match fuzzily, see thunar_list_model_search_fuzzy_score().
  *
- * Allocates a new #ThunarListModel not associated with
- * any #ThunarFolder.
+ * All search terms must match, as substrings of @str unless @fuzzy.
  *
- * Return value: the newly allocated #ThunarListModel.
+ * Return value: the sum of the scores of the terms, %0 unless @fuzzy,
+ *               or -1 if not all terms matched.
  **/
-ThunarListModel*
-thunar_list_model_new (void)
+
+static gint
+thunar_list_model_search_terms_score (gchar      **terms,
+                                      const gchar *str,
+                                      gsize        str_len,
+                                      gboolean     fuzzy)
 {
-  return g_object_new (THUNAR_TYPE_LIST_MODEL, NULL);
+  gint score = 0;
+  gint term_score;
+
+  for (gint i = 0; terms[i] != NULL; i++)
+    {
+      if (fuzzy)
+        term_score = thunar_list_model_search_fuzzy_score (str, str_len, terms[i]);
+      else
+        term_score = thunar_list_model_search_ascii_contains (str, str_len, terms[i]) ? 0 : -1;
+
+      if (term_score < 0)
+        return -1;
+      score += term_score;
+    }
+
+  return score;
 }
 
 
 
 /**
- * thunar_list_model_get_case_sensitive:
- * @store : a valid #ThunarListModel object.
+ * thunar_list_model_search_terms_match:
+ * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
+ * @str: The string which the search terms might be found in.
+ * @fuzzy: Whether the terms match fuzzily, see thunar_list_model_search_fuzzy_score().
  *
- * Returns %TRUE if the sorting is done in a case-sensitive
- * manner for @store.
+ * All search terms must match. Thunar uses simple substring matching
+ * for the broadest multilingual support, or matches the characters of
+ * the terms in order if @fuzzy. @str must be normalized before passing
+ * to this function.
  *
- * Return value: %TRUE if sorting is case-sensitive.
+ * See also: thunar_g_utf8_normalize_for_search().
+ *
+ * Return value: TRUE if all terms matched, FALSE otherwise.
  **/
+
 static gboolean
-thunar_list_model_get_case_sensitive (ThunarListModel *store)
+thunar_list_model_search_terms_match (gchar  **terms,
+                                      gchar   *str,
+                                      gboolean fuzzy)
 {
-  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
-  return store->sort_case_sensitive;
+  if (fuzzy)
+    return thunar_list_model_search_terms_score (terms, str, strlen (str), TRUE) >= 0;
+
+  for (gint i = 0; terms[i] != NULL; i++)
+    if (g_strrstr (str, terms[i]) == NULL)
+      return FALSE;
+  return TRUE;
 }
 
 
 
 /**
- * thunar_list_model_set_case_sensitive:
- * @store          : a valid #ThunarListModel object.
- * @case_sensitive : %TRUE to use case-sensitive sort for @store.
+ * thunar_list_model_search_name_score:
+ * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
+ * @name: The display name of a file, not normalized.
+ * @fuzzy: Whether the terms match fuzzily, see thunar_list_model_search_fuzzy_score().
  *
- * If @case_sensitive is %TRUE the sorting in @store will be done
- * in a case-sensitive manner.
+ * Like thunar_list_model_search_terms_match(), but normalizes @name
+ * itself. Names made of plain ASCII are matched in place, without
+ * allocating a normalized copy, since normalizing them only lowers
+ * their letters.
+ *
+ * Return value: the score of the match, %0 unless @fuzzy, or -1 if
+ *               not all terms matched.
  **/
-static void
-thunar_list_model_set_case_sensitive (ThunarListModel *store,
-                                      gboolean         case_sensitive)
-{
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
-  /* normalize the setting */
-  case_sensitive = !!case_sensitive;
+static gint
+thunar_list_model_search_name_score (gchar       **terms,
+                                     const gchar  *name,
+                                     gboolean      fuzzy)
+{
+  const gchar *p;
+  gchar       *name_n;
+  gint         score;
 
-  /* check if we have a new setting */
-  if (store->sort_case_sensitive != case_sensitive)
-    {
-      /* apply the new setting */
-      store->sort_case_sensitive = case_sensitive;
+  for (p = name; *p != '\0' && ((guchar) *p) < 0x80; p++)
+    ;
 
-      /* resort the model with the new setting */
-      thunar_list_model_sort (store);
+  if (G_LIKELY (*p == '\0'))
+    return thunar_list_model_search_terms_score (terms, name, p - name, fuzzy);
 
-      /* notify listeners */
-      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_CASE_SENSITIVE]);
+  /* fall back to the full unicode normalization */
+  name_n = thunar_g_utf8_normalize_for_search (name, TRUE, TRUE);
+  if (name_n == NULL)
+    return -1;
+  score = thunar_list_model_search_terms_score (terms, name_n, strlen (name_n), fuzzy);
+  g_free (name_n);
 
-      /* emit a "changed" signal for each row, so the display is
-         reloaded with the new case-sensitive setting */
-      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
-                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
-                              NULL);
-    }
+  return score;
 }
 
 
 
 /**
- * thunar_list_model_get_date_style:
- * @store : a valid #ThunarListModel object.
+ * thunar_list_model_search_file_match:
+ * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
+ * @file: A #ThunarFile.
+ * @fuzzy: Whether the terms match fuzzily, see thunar_list_model_search_fuzzy_score().
  *
- * Return value: the #ThunarDateStyle used to format dates in
- *               the given @store.
+ * Like thunar_list_model_search_name_score(), for the display name of
+ * @file, using the normalized name cached by @file. Only to be used in
+ * the main thread.
+ *
+ * Return value: TRUE if all terms matched, FALSE otherwise.
  **/
-static ThunarDateStyle
-thunar_list_model_get_date_style (ThunarListModel *store)
+
+static gboolean
+thunar_list_model_search_file_match (gchar     **terms,
+                                     ThunarFile *file,
+                                     gboolean    fuzzy)
 {
-  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), THUNAR_DATE_STYLE_SIMPLE);
-  return store->date_style;
+  const gchar *name;
+
+  name = thunar_file_get_search_name (file);
+  return name != NULL && thunar_list_model_search_terms_match (terms, (gchar *) name, fuzzy);
 }
 
 
 
-/**
- * thunar_list_model_set_date_style:
- * @store      : a valid #ThunarListModel object.
- * @date_style : the #ThunarDateStyle that should be used to format
- *               dates in the @store.
- *
- * Chances the style used to format dates in @store to the specified
- * @date_style.
- **/
 static void
-thunar_list_model_set_date_style (ThunarListModel *store,
-                                  ThunarDateStyle  date_style)
+thunar_list_model_search_dir_free (gpointer data)
 {
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  ThunarListModelSearchDir *dir = data;
 
-  /* check if we have a new setting */
-  if (store->date_style != date_style)
-    {
-      /* apply the new setting */
-      store->date_style = date_style;
+  g_free (dir->uri);
+  g_slice_free (ThunarListModelSearchDir, dir);
+}
 
-      /* notify listeners */
-      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_STYLE]);
 
-      /* emit a "changed" signal for each row, so the display is reloaded with the new date style */
-      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
-                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
-                              NULL);
-    }
+
+static gboolean
+thunar_list_model_search_walk_stopped (ThunarListModelSearchWalk *walk)
+{
+  /* enough results are shown, a ranked walk goes on for better ones */
+  return walk != NULL
+      && walk->max_results != 0
+      && walk->results == NULL
+      && (guint) g_atomic_int_get (&walk->n_results) >= walk->max_results;
+}
+
+
+
+static gboolean
+thunar_list_model_search_result_less (const ThunarListModelSearchResult *a,
+                                      const ThunarListModelSearchResult *b)
+{
+  return a->score < b->score;
+}
+
+
+
+static gint
+thunar_list_model_search_result_compare (gconstpointer a,
+                                         gconstpointer b)
+{
+  /* the best results first */
+  return ((const ThunarListModelSearchResult *) b)->score - ((const ThunarListModelSearchResult *) a)->score;
 }
 
 
 
 /**
- * thunar_list_model_get_date_custom_style:
- * @store : a valid #ThunarListModel object.
+ * thunar_list_model_search_walk_rank:
+ * @walk: The state of a ranked walk.
+ * @file: A file which matched the search terms.
+ * @score: The score of the match.
  *
- * Return value: the style used to format customdates in the given @store.
+ * Keeps @file in the results of @walk if it is among the best
+ * max_results found so far, replacing the worst one once there
+ * are enough. Ties keep the file found first.
  **/
-static const char*
-thunar_list_model_get_date_custom_style (ThunarListModel *store)
+
+static void
+thunar_list_model_search_walk_rank (ThunarListModelSearchWalk *walk,
+                                    GFile                     *file,
+                                    gint                       score)
 {
-  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
-  return store->date_custom_style;
+  ThunarListModelSearchResult *heap;
+  ThunarListModelSearchResult  result = { score, NULL };
+  ThunarListModelSearchResult  swap;
+  guint                        n, child;
+
+  g_mutex_lock (&walk->results_mutex);
+
+  if (walk->results->len < walk->max_results)
+    {
+      /* sift the new result up from the end */
+      result.file = g_object_ref (file);
+      g_array_append_val (walk->results, result);
+      heap = (ThunarListModelSearchResult *) (gpointer) walk->results->data;
+      for (n = walk->results->len - 1; n > 0 && thunar_list_model_search_result_less (&heap[n], &heap[(n - 1) / 2]); n = (n - 1) / 2)
+        {
+          swap = heap[n];
+          heap[n] = heap[(n - 1) / 2];
+          heap[(n - 1) / 2] = swap;
+        }
+    }
+  else if (score > g_array_index (walk->results, ThunarListModelSearchResult, 0).score)
+    {
+      /* replace the worst result and sift the new one down */
+      heap = (ThunarListModelSearchResult *) (gpointer) walk->results->data;
+      g_object_unref (heap[0].file);
+      heap[0].score = score;
+      heap[0].file = g_object_ref (file);
+      for (n = 0;; n = child)
+        {
+          child = 2 * n + 1;
+          if (child >= walk->results->len)
+            break;
+          if (child + 1 < walk->results->len && thunar_list_model_search_result_less (&heap[child + 1], &heap[child]))
+            child++;
+          if (!thunar_list_model_search_result_less (&heap[child], &heap[n]))
+            break;
+          swap = heap[n];
+          heap[n] = heap[child];
+          heap[child] = swap;
+        }
+    }
+
+  g_mutex_unlock (&walk->results_mutex);
 }
 
 
 
 /**
- * thunar_list_model_set_date_custom_style:
- * @store             : a valid #ThunarListModel object.
- * @date_custom_style : the style that should be used to format
- *                      custom dates in the @store.
+ * thunar_list_model_search_results_add:
+ * @model: The #ThunarListModel the results are for.
+ * @job: The search job.
+ * @results: An array of ThunarListModelSearchResults.
  *
- * Changes the style used to format custom dates in @store to the specified @date_custom_style.
+ * Passes the files of @results to @model, the best ones first and
+ * in batches, so they show up in that order while the files are
+ * loaded. The files are released, @results is left empty.
  **/
+
 static void
-thunar_list_model_set_date_custom_style (ThunarListModel *store,
-                                         const char      *date_custom_style)
+thunar_list_model_search_results_add (ThunarListModel *model,
+                                      ThunarJob       *job,
+                                      GArray          *results)
 {
-  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  ThunarListModelSearchResult *result;
+  ThunarFile                  *file;
+  GList                       *files_found = NULL;
+  guint                        n;
 
-  /* check if we have a new setting */
-  if (g_strcmp0 (store->date_custom_style, date_custom_style) != 0)
+  g_array_sort (results, thunar_list_model_search_result_compare);
+
+  for (n = 0; n < results->len; ++n)
     {
-      /* apply the new setting */
-      g_free (store->date_custom_style);
-      store->date_custom_style = g_strdup (date_custom_style);
+      result = &g_array_index (results, ThunarListModelSearchResult, n);
+      file = exo_job_is_cancelled (EXO_JOB (job)) ? NULL : thunar_file_get (result->file, NULL);
+      g_object_unref (result->file);
+      if (file != NULL)
+        files_found = g_list_prepend (files_found, file);
+
+      /* the model takes the results from the start of the list */
+      if ((n + 1) % THUNAR_LIST_MODEL_SEARCH_INDEX_BATCH == 0 || n + 1 == results->len)
+        {
+          g_mutex_lock (&model->mutex_files_to_add);
+          model->files_to_add = g_list_concat (model->files_to_add, g_list_reverse (files_found));
+          g_mutex_unlock (&model->mutex_files_to_add);
+          files_found = NULL;
+        }
+    }
 
-      /* notify listeners */
-      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_DATE_CUSTOM_STYLE]);
+  g_array_set_size (results, 0);
+}
 
-      /* emit a "changed" signal for each row, so the display is reloaded with the new date style */
-      gtk_tree_model_foreach (GTK_TREE_MODEL (store),
-                              (GtkTreeModelForeachFunc) (void (*)(void)) gtk_tree_model_row_changed,
-                              NULL);
+
+
+static gboolean
+thunar_list_model_search_walk_descend (ThunarListModelSearchWalk *walk,
+                                       const gchar               *name,
+                                       guint                      depth)
+{
+  guint n;
+
+  if (walk == NULL)
+    return TRUE;
+
+  if ((walk->max_depth != 0 && depth > walk->max_depth) || thunar_list_model_search_walk_stopped (walk))
+    return FALSE;
+
+  /* checked before the folder is read, pruned folders are never listed */
+  for (n = 0; n < walk->prune->len; ++n)
+    if (g_pattern_match_string (g_ptr_array_index (walk->prune, n), name))
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_list_model_search_walk_push (ThunarListModelSearchWalk *walk,
+                                    GFile                     *directory,
+                                    guint                      depth)
+{
+  ThunarListModelSearchDir *dir;
+  gboolean                  pushed = FALSE;
+
+  g_mutex_lock (&walk->mutex);
+
+  /* bound the number of waiting folders, the caller searches
+   * the folder itself if the queue is full */
+  if (walk->directories.length < THUNAR_LIST_MODEL_SEARCH_QUEUE_MAX)
+    {
+      dir = g_slice_new (ThunarListModelSearchDir);
+      dir->uri = g_file_get_uri (directory);
+      dir->depth = depth;
+      g_queue_push_tail (&walk->directories, dir);
+      g_cond_signal (&walk->cond);
+      pushed = TRUE;
     }
+
+  g_mutex_unlock (&walk->mutex);
+
+  return pushed;
 }
 
 
 
-ThunarJob*
-thunar_list_model_get_job (ThunarListModel  *store)
-{
-  return store->recursive_search_job;
-}
+static gpointer
+thunar_list_model_search_walk_thread (gpointer data)
+{
+  ThunarListModelSearchWalk *walk = data;
+  ThunarListModelSearchDir  *dir;
+
+  g_mutex_lock (&walk->mutex);
+
+  for (;;)
+    {
+      /* wait for more folders, as long as another thread may still find some */
+      while (g_queue_is_empty (&walk->directories)
+             && walk->n_busy > 0
+             && !exo_job_is_cancelled (EXO_JOB (walk->job))
+             && !thunar_list_model_search_walk_stopped (walk))
+        g_cond_wait (&walk->cond, &walk->mutex);
+
+      if (exo_job_is_cancelled (EXO_JOB (walk->job)) || thunar_list_model_search_walk_stopped (walk))
+        break;
+
+      /* all threads are idle and there is nothing left to search */
+      dir = g_queue_pop_head (&walk->directories);
+      if (dir == NULL)
+        break;
+
+      walk->n_busy++;
+      g_mutex_unlock (&walk->mutex);
+
+      /* the folder takes over the uri */
+      thunar_list_model_search_folder (walk->model, walk->job, g_steal_pointer (&dir->uri), walk->search_query_c_terms,
+                                       THUNAR_LIST_MODEL_SEARCH_RECURSIVE, walk->show_hidden,
+                                       walk->search_contents, walk->fuzzy, dir->depth, walk);
+      thunar_list_model_search_dir_free (dir);
 
+      g_mutex_lock (&walk->mutex);
+      walk->n_busy--;
+      g_cond_broadcast (&walk->cond);
+    }
 
+  /* wake up the waiting threads, so they can quit too */
+  g_cond_broadcast (&walk->cond);
+  g_mutex_unlock (&walk->mutex);
 
-void
-thunar_list_model_set_job (ThunarListModel  *store,
-                           ThunarJob        *job)
-{
-  store->recursive_search_job = job;
+  return NULL;
 }
 
 
 
-static gboolean
-thunar_list_model_add_search_files (gpointer user_data)
+static GPtrArray *
+thunar_list_model_search_prune_new (gchar **patterns,
+                                    gchar **overrides,
+                                    GFile  *directory)
 {
-  ThunarListModel *model = THUNAR_LIST_MODEL (user_data);
+  static const gchar *defaults[] = { ".git", ".hg", ".svn", ".bzr", "node_modules", "__pycache__", NULL };
+  const gchar *const *names;
+  const gchar        *separator;
+  GPtrArray          *prune;
+  gchar             **override = NULL;
+  gchar              *root_name;
+  GFile              *root;
+  GFile              *override_root = NULL;
+  guint               n;
+
+  names = (patterns != NULL) ? (const gchar *const *) patterns : defaults;
+
+  /* the innermost override for a folder containing the searched one wins */
+  for (n = 0; overrides != NULL && overrides[n] != NULL; ++n)
+    {
+      separator = strchr (overrides[n], '=');
+      if (separator == NULL || separator == overrides[n])
+        continue;
 
-  g_mutex_lock (&model->mutex_files_to_add);
+      root_name = g_strndup (overrides[n], separator - overrides[n]);
+      root = g_file_new_for_commandline_arg (root_name);
+      g_free (root_name);
 
-  thunar_list_model_insert_files (model, model->files_to_add);
-  g_list_free (model->files_to_add);
-  model->files_to_add = NULL;
+      if ((g_file_equal (root, directory) || g_file_has_prefix (directory, root))
+          && (override_root == NULL || g_file_has_prefix (root, override_root)))
+        {
+          if (override_root != NULL)
+            g_object_unref (override_root);
+          override_root = g_object_ref (root);
+          g_strfreev (override);
+          override = g_strsplit (separator + 1, ";", -1);
+        }
 
-  g_mutex_unlock (&model->mutex_files_to_add);
+      g_object_unref (root);
+    }
 
-  return TRUE;
+  if (override != NULL)
+    names = (const gchar *const *) override;
+
+  prune = g_ptr_array_new_with_free_func ((GDestroyNotify) g_pattern_spec_free);
+  for (n = 0; names[n] != NULL; ++n)
+    if (*names[n] != '\0')
+      g_ptr_array_add (prune, g_pattern_spec_new (names[n]));
+
+  g_strfreev (override);
+  if (override_root != NULL)
+    g_object_unref (override_root);
+
+  return prune;
 }
 
 
-/**
- * thunar_list_model_split_search_query:
- * @search_query: The search query to split.
- * @error: Return location for regex compilation errors.
- *
- * Search terms are split on whitespace. Search queries must be
- * normalized before passing to this function.
- *
- * See also: thunar_g_utf8_normalize_for_search().
- *
- * Return value: a list of search terms which must be freed with g_strfreev()
- **/
 
-static gchar **
-thunar_list_model_split_search_query (const gchar  *search_query,
-                                      GError      **error)
+static void
+thunar_list_model_search_walk (ThunarListModel *model,
+                               ThunarJob       *job,
+                               gchar           *uri,
+                               gchar          **search_query_c_terms,
+                               gboolean         show_hidden,
+                               gboolean         search_contents,
+                               gboolean         fuzzy,
+                               GPtrArray       *prune,
+                               guint            max_depth,
+                               guint            max_results)
 {
-  GRegex *whitespace_regex;
-  gchar **search_terms;
+  ThunarListModelSearchWalk walk;
+  ThunarListModelSearchDir *dir;
+  GThread                 **threads;
+  guint                     n_threads;
+  guint                     n;
+
+  walk.model = model;
+  walk.job = job;
+  walk.search_query_c_terms = search_query_c_terms;
+  walk.show_hidden = show_hidden;
+  walk.search_contents = search_contents;
+  walk.fuzzy = fuzzy;
+  walk.prune = prune;
+  walk.max_depth = max_depth;
+  walk.max_results = max_results;
+  walk.n_results = 0;
+  walk.results = (fuzzy && max_results != 0) ? g_array_new (FALSE, FALSE, sizeof (ThunarListModelSearchResult)) : NULL;
+  walk.n_busy = 0;
+  g_mutex_init (&walk.results_mutex);
+  g_mutex_init (&walk.mutex);
+  g_cond_init (&walk.cond);
+  g_queue_init (&walk.directories);
+
+  dir = g_slice_new (ThunarListModelSearchDir);
+  dir->uri = uri;
+  dir->depth = 0;
+  g_queue_push_tail (&walk.directories, dir);
+
+  /* the job thread takes part in the search */
+  n_threads = CLAMP ((guint) g_get_num_processors (), 1, THUNAR_LIST_MODEL_SEARCH_THREADS_MAX);
+  threads = g_new0 (GThread *, n_threads);
+  for (n = 1; n < n_threads; ++n)
+    threads[n] = g_thread_new ("ThunarListModelSearch", thunar_list_model_search_walk_thread, &walk);
+
+  thunar_list_model_search_walk_thread (&walk);
+
+  for (n = 1; n < n_threads; ++n)
+    g_thread_join (threads[n]);
+  g_free (threads);
+
+  /* the ranked results are known once all folders are searched */
+  if (walk.results != NULL)
+    {
+      thunar_list_model_search_results_add (model, job, walk.results);
+      g_array_free (walk.results, TRUE);
+    }
 
-  whitespace_regex = g_regex_new ("\\s+", 0, 0, error);
-  if (whitespace_regex == NULL)
-    return NULL;
-  search_terms = g_regex_split (whitespace_regex, search_query, 0);
-  g_regex_unref (whitespace_regex);
-  return search_terms;
+  /* drop the folders left over after a cancellation or with enough results */
+  g_queue_clear_full (&walk.directories, thunar_list_model_search_dir_free);
+  g_cond_clear (&walk.cond);
+  g_mutex_clear (&walk.mutex);
+  g_mutex_clear (&walk.results_mutex);
 }
 
 
 
-/**
- * thunar_list_model_search_terms_match:
- * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
- * @str: The string which the search terms might be found in.
- *
- * All search terms must match. Thunar uses simple substring matching
- * for the broadest multilingual support. @str must be normalized before
- * passing to this function.
- *
- * See also: thunar_g_utf8_normalize_for_search().
- *
- * Return value: TRUE if all terms matched, FALSE otherwise.
- **/
-
-static gboolean
-thunar_list_model_search_terms_match (gchar **terms,
-                                      gchar  *str)
+static void
+thunar_list_model_search_index_add (ThunarListModel *model,
+                                    ThunarJob       *job,
+                                    GList           *locations)
 {
-  for (gint i = 0; terms[i] != NULL; i++)
-    if (g_strrstr (str, terms[i]) == NULL)
-      return FALSE;
-  return TRUE;
+  ThunarFile *file;
+  GList      *files_found = NULL;
+  GList      *lp;
+  guint       n_found = 0;
+
+  for (lp = locations; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+    {
+      file = thunar_file_get (lp->data, NULL);
+      if (G_UNLIKELY (file == NULL))
+        continue;
+
+      files_found = g_list_prepend (files_found, file);
+
+      /* hand the results over in batches, so they show up while the files are loaded */
+      if (++n_found % THUNAR_LIST_MODEL_SEARCH_INDEX_BATCH == 0)
+        {
+          g_mutex_lock (&model->mutex_files_to_add);
+          model->files_to_add = g_list_concat (files_found, model->files_to_add);
+          g_mutex_unlock (&model->mutex_files_to_add);
+          files_found = NULL;
+        }
+    }
+
+  /* hand over the rest, the last locations might not have resolved */
+  if (files_found != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      g_mutex_lock (&model->mutex_files_to_add);
+      model->files_to_add = g_list_concat (files_found, model->files_to_add);
+      g_mutex_unlock (&model->mutex_files_to_add);
+      files_found = NULL;
+    }
+
+  thunar_g_list_free_full (files_found);
 }
 
 
@@ -2333,25 +4416,45 @@ _thunar_job_search_directory (ThunarJob  *job,
   ThunarFile                 *directory;
   const char                 *search_query_c;
   gchar                     **search_query_c_terms;
-  ThunarPreferences          *preferences;
+  const ThunarPreferencesSnapshot *preferences;
   gboolean                    is_source_device_local;
   ThunarRecursiveSearchMode   mode;
   enum ThunarListModelSearch  search_type;
   gboolean                    show_hidden;
+  gboolean                    search_contents;
+  gboolean                    fuzzy;
+  gchar                     **index_roots;
+  gchar                     **backends;
+  gchar                     **prune_patterns;
+  gchar                     **prune_overrides;
+  guint                       max_depth;
+  guint                       max_results;
+  GPtrArray                  *prune;
+  GList                      *locations = NULL;
 
   search_type = THUNAR_LIST_MODEL_SEARCH_NON_RECURSIVE;
 
-  /* grab a reference on the preferences */
-  preferences = thunar_preferences_get ();
-
   /* determine the current recursive search mode */
-  g_object_get (G_OBJECT (preferences), "misc-recursive-search", &mode, NULL);
-  g_object_get (G_OBJECT (preferences), "last-show-hidden", &show_hidden, NULL);
-
-  g_object_unref (preferences);
+  preferences = thunar_preferences_get_snapshot ();
+  mode = preferences->misc_recursive_search;
+  show_hidden = preferences->last_show_hidden;
+  index_roots = g_strdupv (preferences->misc_search_index_roots);
+  backends = g_strdupv (preferences->misc_search_backends);
+  search_contents = preferences->misc_search_contents;
+  fuzzy = preferences->misc_search_fuzzy;
+  prune_patterns = g_strdupv (preferences->misc_search_prune_patterns);
+  prune_overrides = g_strdupv (preferences->misc_search_prune_overrides);
+  max_depth = preferences->misc_search_max_depth;
+  max_results = preferences->misc_search_max_results;
 
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
+    {
+      g_strfreev (index_roots);
+      g_strfreev (backends);
+      g_strfreev (prune_patterns);
+      g_strfreev (prune_overrides);
+      return FALSE;
+    }
 
   model = g_value_get_object (&g_array_index (param_values, GValue, 0));
   search_query_c = g_value_get_string (&g_array_index (param_values, GValue, 1));
@@ -2359,15 +4462,42 @@ _thunar_job_search_directory (ThunarJob  *job,
 
   search_query_c_terms = thunar_list_model_split_search_query (search_query_c, error);
   if (search_query_c_terms == NULL)
-    return FALSE;
+    {
+      g_strfreev (index_roots);
+      g_strfreev (backends);
+      g_strfreev (prune_patterns);
+      g_strfreev (prune_overrides);
+      return FALSE;
+    }
 
   is_source_device_local = thunar_g_file_is_on_local_device (thunar_file_get_file (directory));
   if (mode == THUNAR_RECURSIVE_SEARCH_ALWAYS || (mode == THUNAR_RECURSIVE_SEARCH_LOCAL && is_source_device_local))
     search_type = THUNAR_LIST_MODEL_SEARCH_RECURSIVE;
 
-  thunar_list_model_search_folder (model, job, thunar_file_dup_uri (directory), search_query_c_terms, search_type, show_hidden);
+  /* the backends only know about file names, and match them in one piece */
+  if (search_type == THUNAR_LIST_MODEL_SEARCH_RECURSIVE && !search_contents && !fuzzy
+      && thunar_search_backend_lookup (job, (const gchar *const *) backends, (const gchar *const *) index_roots,
+                                       thunar_file_get_file (directory), search_query_c_terms, show_hidden, &locations))
+    {
+      /* a backend covers the folder, no need to walk the tree */
+      thunar_list_model_search_index_add (model, job, locations);
+      thunar_g_list_free_full (locations);
+    }
+  else if (search_type == THUNAR_LIST_MODEL_SEARCH_RECURSIVE)
+    {
+      prune = thunar_list_model_search_prune_new (prune_patterns, prune_overrides, thunar_file_get_file (directory));
+      thunar_list_model_search_walk (model, job, thunar_file_dup_uri (directory), search_query_c_terms, show_hidden, search_contents,
+                                     fuzzy, prune, max_depth, max_results);
+      g_ptr_array_unref (prune);
+    }
+  else
+    thunar_list_model_search_folder (model, job, thunar_file_dup_uri (directory), search_query_c_terms, search_type, show_hidden, search_contents, fuzzy, 0, NULL);
 
   g_strfreev (search_query_c_terms);
+  g_strfreev (index_roots);
+  g_strfreev (backends);
+  g_strfreev (prune_patterns);
+  g_strfreev (prune_overrides);
 
   return TRUE;
 }
@@ -2379,10 +4509,17 @@ thunar_list_model_job_search_directory (ThunarListModel *model,
                                         const gchar     *search_query_c,
                                         ThunarFile      *directory)
 {
-  return thunar_simple_job_new (_thunar_job_search_directory, 3,
-                                THUNAR_TYPE_LIST_MODEL, model,
-                                G_TYPE_STRING,          search_query_c,
-                                THUNAR_TYPE_FILE,       directory);
+  ThunarJob *job;
+
+  job = thunar_simple_job_new (_thunar_job_search_directory, 3,
+                               THUNAR_TYPE_LIST_MODEL, model,
+                               G_TYPE_STRING,          search_query_c,
+                               THUNAR_TYPE_FILE,       directory);
+
+  /* a recursive search walks whole trees */
+  thunar_job_set_pool (job, THUNAR_JOB_POOL_BULK);
+
+  return job;
 }
 
 
@@ -2424,34 +4561,147 @@ thunar_list_model_search_finished (ThunarJob       *job,
 
   if (store->update_search_results_timeout_id > 0)
     {
-      thunar_list_model_add_search_files (store);
       g_source_remove (store->update_search_results_timeout_id);
       store->update_search_results_timeout_id = 0;
+
+      /* move all remaining results at once */
+      g_mutex_lock (&store->mutex_files_to_add);
+      store->files_pending = g_list_concat (store->files_pending, store->files_to_add);
+      store->files_to_add = NULL;
+      g_mutex_unlock (&store->mutex_files_to_add);
+
+      thunar_list_model_insert_files (store, store->files_pending, FALSE);
+      g_list_free (store->files_pending);
+      store->files_pending = NULL;
     }
 
   thunar_g_list_free_full (store->files_to_add);
   store->files_to_add = NULL;
 
+  /* sort the results once, instead of with every insert */
+  if (store->search_unsorted)
+    {
+      store->search_unsorted = FALSE;
+      thunar_list_model_sort (store);
+    }
+
   g_signal_emit_by_name (store, "search-done");
 }
 
 
 
+/**
+ * thunar_list_model_search_contents_match:
+ * @file: The regular file to search in.
+ * @info: The #GFileInfo of @file, with the fast content type.
+ * @terms: The search terms to look for, prepared with thunar_list_model_split_search_query().
+ * @cancellable: A #GCancellable to stop reading @file.
+ *
+ * Checks if all @terms are found in the contents of @file. Since the
+ * terms are normalized, ASCII letters are matched regardless of their
+ * case, while other characters must appear in their normalized form.
+ * Files which are known not to be text, or which start with a NUL byte
+ * within their first few kilobytes, are skipped.
+ *
+ * Return value: TRUE if all terms were found, FALSE otherwise.
+ **/
+
+static gboolean
+thunar_list_model_search_contents_match (GFile        *file,
+                                         GFileInfo    *info,
+                                         gchar       **terms,
+                                         GCancellable *cancellable)
+{
+  GFileInputStream *stream;
+  const gchar      *content_type;
+  gboolean         *found;
+  gchar            *buffer;
+  gsize             n_terms;
+  gsize             n_found = 0;
+  gsize             max_len = 1;
+  gsize             overlap = 0;
+  gsize             length;
+  gssize            n_read;
+  gboolean          first = TRUE;
+  gsize             i;
+
+  /* skip the files which are known not to be text */
+  content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+  if (content_type != NULL
+      && !g_content_type_is_unknown (content_type)
+      && !g_content_type_is_a (content_type, "text/plain"))
+    return FALSE;
+
+  n_terms = g_strv_length (terms);
+  if (G_UNLIKELY (n_terms == 0))
+    return FALSE;
+  for (i = 0; i < n_terms; i++)
+    max_len = MAX (max_len, strlen (terms[i]));
+
+  stream = g_file_read (file, cancellable, NULL);
+  if (stream == NULL)
+    return FALSE;
+
+  buffer = g_malloc (THUNAR_LIST_MODEL_SEARCH_CONTENTS_CHUNK + max_len);
+  found = g_new0 (gboolean, n_terms);
+
+  for (;;)
+    {
+      n_read = g_input_stream_read (G_INPUT_STREAM (stream), buffer + overlap,
+                                    THUNAR_LIST_MODEL_SEARCH_CONTENTS_CHUNK, cancellable, NULL);
+      if (n_read <= 0)
+        break;
+
+      /* binary files are recognized by a NUL byte at their start */
+      if (first && memchr (buffer, '\0', MIN ((gsize) n_read, THUNAR_LIST_MODEL_SEARCH_CONTENTS_SNIFF)) != NULL)
+        break;
+      first = FALSE;
+
+      length = overlap + n_read;
+      for (i = 0; i < n_terms; i++)
+        if (!found[i] && thunar_list_model_search_ascii_contains (buffer, length, terms[i]))
+          {
+            found[i] = TRUE;
+            n_found++;
+          }
+
+      if (n_found == n_terms)
+        break;
+
+      /* keep the end of the block, a term may continue in the next one */
+      overlap = MIN (length, max_len - 1);
+      memmove (buffer, buffer + length - overlap, overlap);
+    }
+
+  g_free (found);
+  g_free (buffer);
+  g_object_unref (stream);
+
+  return (n_found == n_terms);
+}
+
+
+
 static void
 thunar_list_model_search_folder (ThunarListModel           *model,
                                  ThunarJob                 *job,
                                  gchar                     *uri,
                                  gchar                    **search_query_c_terms,
                                  enum ThunarListModelSearch search_type,
-                                 gboolean                   show_hidden)
+                                 gboolean                   show_hidden,
+                                 gboolean                   search_contents,
+                                 gboolean                   fuzzy,
+                                 guint                      depth,
+                                 ThunarListModelSearchWalk *walk)
 {
   GCancellable    *cancellable;
   GFileEnumerator *enumerator;
   GFile           *directory;
   GList           *files_found = NULL; /* contains the matching files in this folder only */
+  GArray          *scored = NULL;      /* the fuzzy matches in this folder, if not ranked by the walk */
   const gchar     *namespace;
   const gchar     *display_name;
-  gchar           *display_name_c; /* converted to ignore case */
+  const gchar     *target_uri;
 
   cancellable = exo_job_get_cancellable (EXO_JOB (job));
   directory = g_file_new_for_uri (uri);
@@ -2463,6 +4713,16 @@ thunar_list_model_search_folder (ThunarListModel           *model,
               G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
               G_FILE_ATTRIBUTE_STANDARD_NAME ", recent::*";
 
+  /* the content type tells which files are worth reading */
+  if (search_contents)
+    namespace = G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                G_FILE_ATTRIBUTE_STANDARD_TARGET_URI ","
+                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP ","
+                G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
+                G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE ","
+                G_FILE_ATTRIBUTE_STANDARD_NAME ", recent::*";
+
   /* The directory enumerator MUST NOT follow symlinks itself, meaning that any symlinks that
    * g_file_enumerator_next_file() emits are the actual symlink entries. This prevents one
    * possible source of infinitely deep recursion.
@@ -2474,11 +4734,12 @@ thunar_list_model_search_folder (ThunarListModel           *model,
     return;
 
   /* go through every file in the folder and check if it matches */
-  while (exo_job_is_cancelled (EXO_JOB (job)) == FALSE)
+  while (exo_job_is_cancelled (EXO_JOB (job)) == FALSE && !thunar_list_model_search_walk_stopped (walk))
     {
       GFile     *file;
       GFileInfo *info;
       GFileType  type;
+      gint       score;
 
       /* get GFile and GFileInfo */
       info = g_file_enumerator_next_file (enumerator, cancellable, NULL);
@@ -2487,11 +4748,28 @@ thunar_list_model_search_folder (ThunarListModel           *model,
 
       if (g_file_has_uri_scheme (directory, "recent"))
         {
-          file = g_file_new_for_uri (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI));
-          g_object_unref (info);
-          info = g_file_query_info (file, namespace, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
-          if (G_UNLIKELY (info == NULL))
-            break;
+          target_uri = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+          if (G_UNLIKELY (target_uri == NULL))
+            {
+              g_object_unref (info);
+              continue;
+            }
+
+          /* the recent list knows the names of remote targets, which may be
+           * slow or unreachable, only local targets are queried */
+          file = g_file_new_for_uri (target_uri);
+          if (g_file_is_native (file))
+            {
+              g_object_unref (info);
+              info = g_file_query_info (file, namespace, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
+
+              /* skip targets which are gone, instead of the rest of the list */
+              if (G_UNLIKELY (info == NULL))
+                {
+                  g_object_unref (file);
+                  continue;
+                }
+            }
         }
       else
         file = g_file_get_child (directory, g_file_info_get_name (info));
@@ -2511,22 +4789,42 @@ thunar_list_model_search_folder (ThunarListModel           *model,
 
       type = g_file_info_get_file_type (info);
 
-      /* handle directories */
-      if (type == G_FILE_TYPE_DIRECTORY && search_type == THUNAR_LIST_MODEL_SEARCH_RECURSIVE)
+      /* handle directories, unless they are pruned */
+      if (type == G_FILE_TYPE_DIRECTORY && search_type == THUNAR_LIST_MODEL_SEARCH_RECURSIVE
+          && thunar_list_model_search_walk_descend (walk, g_file_info_get_name (info), depth + 1))
         {
-          thunar_list_model_search_folder (model, job, g_file_get_uri (file), search_query_c_terms, search_type, show_hidden);
+          /* leave the folder to the other search threads, unless they are busy enough */
+          if (walk == NULL || !thunar_list_model_search_walk_push (walk, file, depth + 1))
+            thunar_list_model_search_folder (model, job, g_file_get_uri (file), search_query_c_terms, search_type, show_hidden, search_contents, fuzzy, depth + 1, walk);
         }
 
-      /* prepare entry display name */
+      /* search for all terms, in the name or optionally in the contents */
       display_name = g_file_info_get_display_name (info);
-      display_name_c = thunar_g_utf8_normalize_for_search (display_name, TRUE, TRUE);
+      score = thunar_list_model_search_name_score (search_query_c_terms, display_name, fuzzy);
+      if (score < 0 && search_contents && type == G_FILE_TYPE_REGULAR
+          && thunar_list_model_search_contents_match (file, info, search_query_c_terms, cancellable))
+        score = 0;
+
+      if (score >= 0 && walk != NULL && walk->results != NULL)
+        thunar_list_model_search_walk_rank (walk, file, score);
+      else if (score >= 0 && fuzzy)
+        {
+          /* handed over best first, once the folder is searched */
+          ThunarListModelSearchResult result = { score, g_object_ref (file) };
 
-      /* search for all substrings */
-      if (thunar_list_model_search_terms_match (search_query_c_terms, display_name_c))
-        files_found = g_list_prepend (files_found, thunar_file_get (file, NULL));
+          if (scored == NULL)
+            scored = g_array_new (FALSE, FALSE, sizeof (ThunarListModelSearchResult));
+          g_array_append_val (scored, result);
+        }
+      else if (score >= 0)
+        {
+          /* stop at the limit, the other threads may have found some meanwhile */
+          if (walk == NULL || walk->max_results == 0
+              || (guint) g_atomic_int_add (&walk->n_results, 1) < walk->max_results)
+            files_found = g_list_prepend (files_found, thunar_file_get (file, NULL));
+        }
 
       /* free memory */
-      g_free (display_name_c);
       g_object_unref (file);
       g_object_unref (info);
     }
@@ -2534,11 +4832,20 @@ thunar_list_model_search_folder (ThunarListModel           *model,
   g_object_unref (enumerator);
   g_object_unref (directory);
 
+  if (scored != NULL)
+    {
+      thunar_list_model_search_results_add (model, job, scored);
+      g_array_free (scored, TRUE);
+    }
+
   if (exo_job_is_cancelled (EXO_JOB (job)))
-    return;
+    {
+      thunar_g_list_free_full (files_found);
+      return;
+    }
 
   g_mutex_lock (&model->mutex_files_to_add);
-  model->files_to_add = g_list_concat (model->files_to_add, files_found);
+  model->files_to_add = g_list_concat (files_found, model->files_to_add);
   g_mutex_unlock (&model->mutex_files_to_add);
 }
 
@@ -2560,6 +4867,119 @@ thunar_list_model_get_folder (ThunarListModel *store)
 
 
 
+static gboolean
+thunar_list_model_search_in_memory (ThunarFolder *folder)
+{
+  const ThunarPreferencesSnapshot *preferences;
+  GFile                           *directory;
+
+  preferences = thunar_preferences_get_snapshot ();
+  directory = thunar_file_get_file (thunar_folder_get_corresponding_file (folder));
+
+  /* the contents of the files are not loaded, and recent:///
+   * is searched by the names of the targets of the items */
+  if (preferences->misc_search_contents || g_file_has_uri_scheme (directory, "recent"))
+    return FALSE;
+
+  if (preferences->misc_recursive_search == THUNAR_RECURSIVE_SEARCH_NEVER)
+    return TRUE;
+
+  /* telling local devices apart takes I/O, see _thunar_job_search_directory(),
+   * only locations outside of file:/// are known to be searched non-recursively */
+  return preferences->misc_recursive_search == THUNAR_RECURSIVE_SEARCH_LOCAL
+      && !g_file_has_uri_scheme (directory, "file");
+}
+
+
+
+static gboolean
+thunar_list_model_search_filter_done (gpointer user_data)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (user_data);
+
+  store->filter_done_id = 0;
+
+  /* same as for the search jobs, the caller expects it after setting the folder */
+  g_signal_emit_by_name (store, "search-done");
+
+  return FALSE;
+}
+
+
+
+static GPtrArray *
+thunar_list_model_search_filter (ThunarListModel *store,
+                                 GPtrArray       *files)
+{
+  GPtrArray *filtered;
+  guint      n;
+
+  filtered = g_ptr_array_new ();
+  for (n = 0; n < files->len; ++n)
+    if (thunar_list_model_search_file_match (store->search_terms, g_ptr_array_index (files, n), store->search_fuzzy))
+      g_ptr_array_add (filtered, g_ptr_array_index (files, n));
+
+  return filtered;
+}
+
+
+
+/* narrows the results of the in-memory filter, if @search_query_c only extends
+ * its query, every file matching it matched the previous query as well */
+static gboolean
+thunar_list_model_search_narrow (ThunarListModel *store,
+                                 const gchar     *search_query_c)
+{
+  GSequenceIter  *row;
+  GSequenceIter  *end;
+  GSList         *slp;
+  GSList         *snext;
+  GList          *removed = NULL;
+  gchar         **terms;
+
+  /* deleting characters or a new query filters all files again */
+  if (store->filter_query == NULL
+      || !g_str_has_prefix (search_query_c, store->filter_query)
+      || !thunar_list_model_search_in_memory (store->folder))
+    return FALSE;
+
+  terms = thunar_list_model_split_search_query (search_query_c, NULL);
+  if (G_UNLIKELY (terms == NULL))
+    return FALSE;
+
+  g_strfreev (store->search_terms);
+  store->search_terms = terms;
+  g_free (store->filter_query);
+  store->filter_query = g_strdup (search_query_c);
+
+  row = g_sequence_get_begin_iter (store->rows);
+  end = g_sequence_get_end_iter (store->rows);
+  for (; row != end; row = g_sequence_iter_next (row))
+    if (!thunar_list_model_search_file_match (terms, g_sequence_get (row), store->search_fuzzy))
+      removed = g_list_prepend (removed, g_sequence_get (row));
+
+  if (removed != NULL)
+    {
+      thunar_list_model_files_removed (store->folder, removed, store);
+      g_list_free (removed);
+    }
+
+  /* the hidden files are not known to the rows */
+  for (slp = store->hidden; slp != NULL; slp = snext)
+    {
+      snext = slp->next;
+      if (!thunar_list_model_search_file_match (terms, slp->data, store->search_fuzzy))
+        {
+          g_object_unref (slp->data);
+          store->hidden = g_slist_delete_link (store->hidden, slp);
+        }
+    }
+
+  return TRUE;
+}
+
+
+
 /**
  * thunar_list_model_set_folder:
  * @store                       : a valid #ThunarListModel.
@@ -2571,21 +4991,49 @@ thunar_list_model_set_folder (ThunarListModel *store,
                               ThunarFolder    *folder,
                               gchar           *search_query)
 {
-  GtkTreePath   *path;
-  gboolean       has_handler;
-  GList         *files;
-  GSequenceIter *row;
-  GSequenceIter *end;
-  GSequenceIter *next;
+  ThunarListModelOrder *order;
+  GtkTreePath          *path;
+  gboolean              has_handler;
+  GPtrArray            *files;
+  GPtrArray            *filtered = NULL;
+  GSequenceIter        *row;
+  GSequenceIter        *end;
+  GSequenceIter        *next;
+  gchar                *search_query_c;  /* normalized */
+  gboolean              narrowed;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (folder == NULL || THUNAR_IS_FOLDER (folder));
 
+  /* typing on in a filtered folder only removes the rows which stopped matching */
+  if (folder != NULL && folder == store->folder && search_query != NULL)
+    {
+      search_query_c = thunar_g_utf8_normalize_for_search (g_strstrip (search_query), TRUE, TRUE);
+      narrowed = (search_query_c != NULL && *search_query_c != '\0'
+                  && thunar_list_model_search_narrow (store, search_query_c));
+      g_free (search_query_c);
+
+      if (narrowed)
+        {
+          if (store->filter_done_id == 0)
+            store->filter_done_id = g_idle_add (thunar_list_model_search_filter_done, store);
+          return;
+        }
+    }
+
   /* unlink from the previously active folder (if any) */
   if (G_LIKELY (store->folder != NULL))
     {
       thunar_list_model_cancel_search_job (store);
 
+      if (store->filter_done_id != 0)
+        {
+          g_source_remove (store->filter_done_id);
+          store->filter_done_id = 0;
+        }
+      g_free (store->filter_query);
+      store->filter_query = NULL;
+
       if (store->update_search_results_timeout_id > 0)
         {
           g_source_remove (store->update_search_results_timeout_id);
@@ -2593,6 +5041,13 @@ thunar_list_model_set_folder (ThunarListModel *store,
         }
       thunar_g_list_free_full (store->files_to_add);
       store->files_to_add = NULL;
+      thunar_g_list_free_full (store->files_pending);
+      store->files_pending = NULL;
+      store->search_unsorted = FALSE;
+
+      /* the queued changes are about the old rows */
+      g_hash_table_remove_all (store->changed_files);
+      g_queue_clear_full (&store->changed_queue, g_object_unref);
 
       /* check if we have any handlers connected for "row-deleted" */
       has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
@@ -2607,6 +5062,7 @@ thunar_list_model_set_folder (ThunarListModel *store,
           /* remove the row from the list */
           next = g_sequence_iter_next (row);
           g_sequence_remove (row);
+          thunar_list_model_cursor_reset (store);
           row = next;
 
           /* notify the view(s) if they're actually
@@ -2616,6 +5072,12 @@ thunar_list_model_set_folder (ThunarListModel *store,
             gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
         }
       gtk_tree_path_free (path);
+      g_hash_table_remove_all (store->row_cache);
+      g_hash_table_remove_all (store->file_rows);
+
+      /* the model is empty now */
+      memset (&store->summary, 0, sizeof (store->summary));
+      store->summary_valid = TRUE;
 
       /* remove hidden entries */
       g_slist_free_full (store->hidden, g_object_unref);
@@ -2660,39 +5122,65 @@ thunar_list_model_set_folder (ThunarListModel *store,
         }
       else
         {
-          gchar *search_query_c;  /* normalized */
-
           search_query_c = thunar_g_utf8_normalize_for_search (search_query, TRUE, TRUE);
           g_strfreev (store->search_terms);
           store->search_terms = thunar_list_model_split_search_query (search_query_c, NULL);
-          if (store->search_terms != NULL)
+          store->search_fuzzy = thunar_preferences_get_snapshot ()->misc_search_fuzzy;
+          if (store->search_terms != NULL && thunar_list_model_search_in_memory (folder))
+            {
+              /* the folder has the files already, new ones are filtered in thunar_list_model_files_added() */
+              filtered = thunar_list_model_search_filter (store, thunar_folder_get_files (folder));
+              store->filter_query = g_strdup (search_query_c);
+              store->filter_done_id = g_idle_add (thunar_list_model_search_filter_done, store);
+            }
+          else if (store->search_terms != NULL)
             {
               /* search the current folder
                * start a new recursive_search_job */
               store->recursive_search_job = thunar_list_model_job_search_directory (store, search_query_c, thunar_folder_get_corresponding_file (folder));
-              exo_job_launch (EXO_JOB (store->recursive_search_job));
+              thunar_job_launch (THUNAR_JOB (store->recursive_search_job));
 
               g_signal_connect (store->recursive_search_job, "error", G_CALLBACK (thunar_list_model_search_error), NULL);
               g_signal_connect (store->recursive_search_job, "finished", G_CALLBACK (thunar_list_model_search_finished), store);
 
-              /* add new results to the model every X ms */
-              store->update_search_results_timeout_id = g_timeout_add (500, thunar_list_model_add_search_files, store);
+              /* append new results to the model every X ms, unsorted until the search is done */
+              store->search_unsorted = TRUE;
+              store->update_search_results_timeout_id = g_timeout_add (THUNAR_LIST_MODEL_SEARCH_UPDATE_INTERVAL, thunar_list_model_add_search_files, store);
             }
           g_free (search_query_c);
-          files = NULL;
+          files = filtered;
         }
 
-      /* insert the files */
-      if (files != NULL)
-        thunar_list_model_insert_files (store, files);
+      /* insert the files, in the order of another model of the folder if there is one */
+      order = (files != NULL && files->len > 0 && filtered == NULL) ? thunar_list_model_index_lookup (store) : NULL;
+      if (order != NULL)
+        {
+          thunar_list_model_insert_file_array (store, order->files->pdata, order->files->len, TRUE);
+
+          thunar_stats_count (THUNAR_STATS_LIST_MODEL_INDEX_HIT);
+        }
+      else if (filtered != NULL)
+        {
+          thunar_list_model_insert_file_array (store, filtered->pdata, filtered->len, FALSE);
+          g_ptr_array_free (filtered, TRUE);
+        }
+      else if (files != NULL && files->len > 0)
+        {
+          thunar_list_model_insert_file_array (store, files->pdata, files->len, FALSE);
+          thunar_list_model_index_publish (store);
+        }
 
       /* connect signals to the new folder */
       g_signal_connect (G_OBJECT (store->folder), "destroy", G_CALLBACK (thunar_list_model_folder_destroy), store);
       g_signal_connect (G_OBJECT (store->folder), "error", G_CALLBACK (thunar_list_model_folder_error), store);
       g_signal_connect (G_OBJECT (store->folder), "files-added", G_CALLBACK (thunar_list_model_files_added), store);
       g_signal_connect (G_OBJECT (store->folder), "files-removed", G_CALLBACK (thunar_list_model_files_removed), store);
+      g_signal_connect_swapped (G_OBJECT (store->folder), "notify::loading", G_CALLBACK (thunar_list_model_index_publish), store);
     }
 
+  /* follow the changes of the new rows */
+  thunar_list_model_watch_files (store);
+
   /* notify listeners that we have a new folder */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FOLDER]);
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
@@ -2773,12 +5261,14 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
                                    gboolean         show_hidden)
 {
   GtkTreePath   *path;
-  GtkTreeIter    iter;
   ThunarFile    *file;
   GSList        *lp;
+  GList         *files = NULL;
   GSequenceIter *row;
   GSequenceIter *next;
   GSequenceIter *end;
+  gboolean       has_handler;
+  gint          *indices;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
@@ -2790,29 +5280,26 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
 
   if (store->show_hidden)
     {
+      /* add the hidden files like a loaded batch, large batches are
+       * sorted once and merged into the rows in a single pass */
       for (lp = store->hidden; lp != NULL; lp = lp->next)
-        {
-          file = THUNAR_FILE (lp->data);
-
-          /* insert file in the sorted position */
-          row = g_sequence_insert_sorted (store->rows, file,
-                                          thunar_list_model_cmp_func, store);
-
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
-
-          /* tell the view about the new row */
-          path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-        }
-      g_slist_free (store->hidden);
+        files = g_list_prepend (files, lp->data);
+      thunar_list_model_insert_files (store, files, FALSE);
+      g_list_free (files);
+
+      g_slist_free_full (store->hidden, g_object_unref);
       store->hidden = NULL;
     }
   else
     {
       _thunar_assert (store->hidden == NULL);
 
-      /* remove all hidden files */
+      has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
+      path = gtk_tree_path_new_first ();
+      indices = gtk_tree_path_get_indices (path);
+
+      /* remove all hidden files in one walk, the position is counted on
+       * the way since the rows behind a removed one move up */
       row = g_sequence_get_begin_iter (store->rows);
       end = g_sequence_get_end_iter (store->rows);
 
@@ -2826,20 +5313,27 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
               /* store file in the list */
               store->hidden = g_slist_prepend (store->hidden, g_object_ref (file));
 
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-
               /* remove file from the model */
+              g_hash_table_remove (store->row_cache, file);
+              g_hash_table_remove (store->file_rows, file);
+              thunar_list_model_summary_remove (store, file);
               g_sequence_remove (row);
+              thunar_list_model_cursor_reset (store);
 
               /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
+              if (has_handler)
+                gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+            }
+          else
+            {
+              indices[0]++;
             }
 
           row = next;
           _thunar_assert (end == g_sequence_get_end_iter (store->rows));
         }
+
+      gtk_tree_path_free (path);
     }
 
   /* notify listeners about the new setting */
@@ -2891,6 +5385,7 @@ thunar_list_model_set_file_size_binary (ThunarListModel *store,
     {
       /* apply the new setting */
       store->file_size_binary = file_size_binary;
+      store->format_stamp++;
 
       /* resort the model with the new setting */
       thunar_list_model_sort (store);
@@ -2976,6 +5471,55 @@ thunar_list_model_get_file (ThunarListModel *store,
 
 
 
+/**
+ * thunar_list_model_has_name_prefix:
+ * @store : a #ThunarListModel.
+ * @iter  : a valid #GtkTreeIter for @store.
+ * @key   : the text typed into the interactive search.
+ *
+ * Checks whether the display name of the file at @iter starts with @key,
+ * ignoring the case. The names are kept sorted once for all rows, so
+ * the views can test row after row for the same @key with a lookup each
+ * instead of casefolding every name again per keystroke.
+ *
+ * Return value: %TRUE if the name of the file at @iter matches @key.
+ **/
+gboolean
+thunar_list_model_has_name_prefix (ThunarListModel *store,
+                                   GtkTreeIter     *iter,
+                                   const gchar     *key)
+{
+  gchar *prefix;
+  gsize  length;
+  guint  position;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
+  _thunar_return_val_if_fail (iter->stamp == store->stamp, FALSE);
+  _thunar_return_val_if_fail (key != NULL, FALSE);
+
+  if (store->name_keys == NULL)
+    thunar_list_model_name_keys_build (store);
+
+  /* look up the range of names with this prefix */
+  prefix = g_utf8_casefold (key, -1);
+  if (g_strcmp0 (prefix, store->name_prefix) != 0)
+    {
+      length = strlen (prefix);
+      store->name_first = thunar_list_model_name_keys_search (store, prefix, length, -1);
+      store->name_last = thunar_list_model_name_keys_search (store, prefix, length, 0);
+      g_free (store->name_prefix);
+      store->name_prefix = prefix;
+    }
+  else
+    g_free (prefix);
+
+  position = GPOINTER_TO_UINT (g_hash_table_lookup (store->name_positions, g_sequence_get (iter->user_data)));
+
+  return position > store->name_first && position <= store->name_last;
+}
+
+
+
 /**
  * thunar_list_model_get_num_files:
  * @store : a #ThunarListModel.
@@ -2997,12 +5541,12 @@ thunar_list_model_get_num_files (ThunarListModel *store)
 /**
  * thunar_list_model_get_paths_for_files:
  * @store : a #ThunarListModel instance.
- * @files : a list of #ThunarFile<!---->s.
+ * @files : a list of #ThunarFiles.
  *
- * Determines the list of #GtkTreePath<!---->s for the #ThunarFile<!---->s
+ * Determines the list of #GtkTreePaths for the #ThunarFiles
  * found in the @files list. If a #ThunarFile from the @files list is not
  * available in @store, no #GtkTreePath will be returned for it. So, in effect,
- * only #GtkTreePath<!---->s for the subset of @files available in @store will
+ * only #GtkTreePaths for the subset of @files available in @store will
  * be returned.
  *
  * The caller is responsible to free the returned list using:
@@ -3010,7 +5554,7 @@ thunar_list_model_get_num_files (ThunarListModel *store)
  * g_list_free_full (list, (GDestroyNotify) gtk_tree_path_free);
  * </programlisting></informalexample>
  *
- * Return value: the list of #GtkTreePath<!---->s for @files.
+ * Return value: the list of #GtkTreePaths for @files.
  **/
 GList*
 thunar_list_model_get_paths_for_files (ThunarListModel *store,
@@ -3018,28 +5562,180 @@ thunar_list_model_get_paths_for_files (ThunarListModel *store,
 {
   GList         *paths = NULL;
   GSequenceIter *row;
-  GSequenceIter *end;
-  gint           i = 0;
+  GList         *lp;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
-
   /* find the rows for the given files */
-  while (row != end)
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      row = g_hash_table_lookup (store->file_rows, lp->data);
+      if (row != NULL)
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1));
+    }
+
+  return paths;
+}
+
+
+
+/* compiled select-by-pattern pattern, the common globs like "*.jpg",
+ * "IMG_*" and "*foo*" are matched as plain strings without normalizing
+ * ASCII names, everything else goes through a GPatternSpec */
+typedef enum
+{
+  THUNAR_LIST_MODEL_MATCH_EXACT,
+  THUNAR_LIST_MODEL_MATCH_PREFIX,
+  THUNAR_LIST_MODEL_MATCH_SUFFIX,
+  THUNAR_LIST_MODEL_MATCH_CONTAINS,
+  THUNAR_LIST_MODEL_MATCH_GLOB,
+} ThunarListModelMatch;
+
+typedef struct
+{
+  ThunarListModelMatch kind;
+  gchar               *literal;
+  gsize                literal_len;
+  GPatternSpec        *pspec;
+  gboolean             casefold;
+  gboolean             strip_diacritics;
+} ThunarListModelPattern;
+
+
+
+static void
+thunar_list_model_pattern_init (ThunarListModelPattern *pattern,
+                                const gchar            *text,
+                                gboolean                case_sensitive,
+                                gboolean                match_diacritics)
+{
+  gchar *normalized;
+  gchar *start;
+  gchar *end;
+
+  pattern->casefold = !case_sensitive;
+  pattern->strip_diacritics = !match_diacritics;
+  pattern->pspec = NULL;
+  pattern->literal = NULL;
+  pattern->literal_len = 0;
+
+  normalized = thunar_g_utf8_normalize_for_search (text, pattern->strip_diacritics, pattern->casefold);
+
+  /* strip the leading and trailing stars */
+  for (start = normalized; *start == '*'; start++)
+    ;
+  for (end = start + strlen (start); end > start && end[-1] == '*'; end--)
+    ;
+
+  /* anything but stars around a literal needs the real glob matcher */
+  if (memchr (start, '*', end - start) != NULL || strchr (normalized, '?') != NULL)
+    {
+      pattern->kind = THUNAR_LIST_MODEL_MATCH_GLOB;
+      pattern->pspec = g_pattern_spec_new (normalized);
+      g_free (normalized);
+      return;
+    }
+
+  if (start > normalized && *end == '*')
+    pattern->kind = THUNAR_LIST_MODEL_MATCH_CONTAINS;
+  else if (start > normalized)
+    pattern->kind = THUNAR_LIST_MODEL_MATCH_SUFFIX;
+  else if (*end == '*')
+    pattern->kind = THUNAR_LIST_MODEL_MATCH_PREFIX;
+  else
+    pattern->kind = THUNAR_LIST_MODEL_MATCH_EXACT;
+
+  pattern->literal_len = end - start;
+  pattern->literal = g_strndup (start, pattern->literal_len);
+  g_free (normalized);
+}
+
+
+
+static void
+thunar_list_model_pattern_clear (ThunarListModelPattern *pattern)
+{
+  if (pattern->pspec != NULL)
+    g_pattern_spec_free (pattern->pspec);
+  g_free (pattern->literal);
+}
+
+
+
+static inline gboolean
+thunar_list_model_pattern_equal (const ThunarListModelPattern *pattern,
+                                 const gchar                  *str)
+{
+  /* the literal is folded already, so comparing case-insensitively
+   * matches the folding of ASCII names done by the normalization */
+  if (pattern->casefold)
+    return g_ascii_strncasecmp (str, pattern->literal, pattern->literal_len) == 0;
+  else
+    return memcmp (str, pattern->literal, pattern->literal_len) == 0;
+}
+
+
+
+static gboolean
+thunar_list_model_pattern_match (const ThunarListModelPattern *pattern,
+                                 const gchar                  *name)
+{
+  const gchar *p;
+  gchar       *normalized = NULL;
+  gboolean     matched = FALSE;
+  gsize        name_len;
+  gsize        n;
+
+  /* ASCII names are compared as they are, see thunar_g_utf8_normalize_for_search() */
+  for (p = name; *p != '\0' && ((guchar) *p) < 0x80; p++)
+    ;
+  if (*p != '\0' || pattern->kind == THUNAR_LIST_MODEL_MATCH_GLOB)
     {
-      if (g_list_find (files, g_sequence_get (row)) != NULL)
+      name = normalized = thunar_g_utf8_normalize_for_search (name, pattern->strip_diacritics, pattern->casefold);
+      if (G_UNLIKELY (name == NULL))
+        return FALSE;
+
+      if (pattern->kind == THUNAR_LIST_MODEL_MATCH_GLOB)
         {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
+          matched = g_pattern_match_string (pattern->pspec, name);
+          g_free (normalized);
+          return matched;
         }
 
-      row = g_sequence_iter_next (row);
-      i++;
+      /* only the literal comparison below folds the case of ASCII names */
+      p = name + strlen (name);
     }
+  name_len = p - name;
 
-  return paths;
+  if (name_len >= pattern->literal_len)
+    {
+      switch (pattern->kind)
+        {
+        case THUNAR_LIST_MODEL_MATCH_EXACT:
+          matched = (name_len == pattern->literal_len && thunar_list_model_pattern_equal (pattern, name));
+          break;
+
+        case THUNAR_LIST_MODEL_MATCH_PREFIX:
+          matched = thunar_list_model_pattern_equal (pattern, name);
+          break;
+
+        case THUNAR_LIST_MODEL_MATCH_SUFFIX:
+          matched = thunar_list_model_pattern_equal (pattern, name + name_len - pattern->literal_len);
+          break;
+
+        case THUNAR_LIST_MODEL_MATCH_CONTAINS:
+          for (n = 0; !matched && n + pattern->literal_len <= name_len; ++n)
+            matched = thunar_list_model_pattern_equal (pattern, name + n);
+          break;
+
+        default:
+          _thunar_assert_not_reached ();
+        }
+    }
+
+  g_free (normalized);
+
+  return matched;
 }
 
 
@@ -3052,14 +5748,14 @@ thunar_list_model_get_paths_for_files (ThunarListModel *store,
  * @match_diacritics : %TRUE to use case sensitive search.
  *
  * Looks up all rows in the @store that match @pattern and returns
- * a list of #GtkTreePath<!---->s corresponding to the rows.
+ * a list of #GtkTreePaths corresponding to the rows.
  *
  * The caller is responsible to free the returned list using:
  * <informalexample><programlisting>
  * g_list_free_full (list, (GDestroyNotify) gtk_tree_path_free);
  * </programlisting></informalexample>
  *
- * Return value: the list of #GtkTreePath<!---->s that match @pattern.
+ * Return value: the list of #GtkTreePaths that match @pattern.
  **/
 GList*
 thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
@@ -3067,24 +5763,17 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
                                          gboolean         case_sensitive,
                                          gboolean         match_diacritics)
 {
-  GPatternSpec  *pspec;
-  gchar         *normalized_pattern;
-  GList         *paths = NULL;
-  GSequenceIter *row;
-  GSequenceIter *end;
-  ThunarFile    *file;
-  const gchar   *display_name;
-  gchar         *normalized_display_name;
-  gboolean       name_matched;
-  gint           i = 0;
+  ThunarListModelPattern compiled;
+  GList                 *paths = NULL;
+  GSequenceIter         *row;
+  GSequenceIter         *end;
+  gint                   i = 0;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
   _thunar_return_val_if_fail (g_utf8_validate (pattern, -1, NULL), NULL);
 
   /* compile the pattern */
-  normalized_pattern = thunar_g_utf8_normalize_for_search (pattern, !match_diacritics, !case_sensitive);
-  pspec = g_pattern_spec_new (normalized_pattern);
-  g_free (normalized_pattern);
+  thunar_list_model_pattern_init (&compiled, pattern, case_sensitive, match_diacritics);
 
   row = g_sequence_get_begin_iter (store->rows);
   end = g_sequence_get_end_iter (store->rows);
@@ -3092,14 +5781,7 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
   /* find all rows that match the given pattern */
   while (row != end)
     {
-      file = g_sequence_get (row);
-      display_name = thunar_file_get_display_name (file);
-
-      normalized_display_name = thunar_g_utf8_normalize_for_search (display_name, !match_diacritics, !case_sensitive);
-      name_matched = g_pattern_match_string (pspec, normalized_display_name);
-      g_free (normalized_display_name);
-
-      if (name_matched)
+      if (thunar_list_model_pattern_match (&compiled, thunar_file_get_display_name (g_sequence_get (row))))
         {
           _thunar_assert (i == g_sequence_iter_get_position (row));
           paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
@@ -3110,7 +5792,7 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
     }
 
   /* release the pattern */
-  g_pattern_spec_free (pspec);
+  thunar_list_model_pattern_clear (&compiled);
 
   return paths;
 }
@@ -3118,65 +5800,222 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
 
 
 /**
- * thunar_list_model_get_statusbar_text_for_files:
- * @files                        : list of files for which a text is requested
+ * thunar_list_model_freeze_changes:
+ * @store : a #ThunarListModel.
+ *
+ * Stops @store from re-sorting and emitting "row-changed" for
+ * changed files right away. The files are queued instead and
+ * #ThunarListModel::changes-pending is emitted, the changes can
+ * then be applied with thunar_list_model_apply_changes().
+ **/
+void
+thunar_list_model_freeze_changes (ThunarListModel *store)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  store->changes_frozen++;
+}
+
+
+
+/**
+ * thunar_list_model_thaw_changes:
+ * @store : a #ThunarListModel.
+ *
+ * Reverts the effect of a previous call to thunar_list_model_freeze_changes(),
+ * and applies all queued changes once @store is no longer frozen.
+ **/
+void
+thunar_list_model_thaw_changes (ThunarListModel *store)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (store->changes_frozen > 0);
+
+  if (--store->changes_frozen == 0)
+    thunar_list_model_apply_changes (store, -1);
+}
+
+
+
+/**
+ * thunar_list_model_apply_changes:
+ * @store  : a #ThunarListModel.
+ * @budget : the time (in microseconds) the changes may take, or -1.
+ *
+ * Re-sorts the rows of the changed files queued while @store was frozen and
+ * emits "row-changed" for them, until @budget is used up. Large queues are
+ * applied at once with a single sort of all rows.
+ *
+ * Return value: %TRUE if changes are left in the queue.
+ **/
+gboolean
+thunar_list_model_apply_changes (ThunarListModel *store,
+                                 gint64           budget)
+{
+  GSequenceIter *row;
+  GtkTreePath   *path;
+  GtkTreeIter    tree_iter;
+  ThunarFile    *file;
+  gboolean       resort;
+  gint64         end_time;
+  guint          n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
+
+  if (g_queue_is_empty (&store->changed_queue))
+    return FALSE;
+
+  end_time = (budget >= 0) ? g_get_monotonic_time () + budget : G_MAXINT64;
+
+  /* moving every row on its own emits "rows-reordered" for each of them */
+  resort = store->changed_queue.length >= THUNAR_LIST_MODEL_CHANGES_RESORT_MIN;
+  if (resort && G_LIKELY (!store->search_unsorted))
+    thunar_list_model_sort (store);
+
+  /* files changed by the handlers of the signals are queued again */
+  for (n = store->changed_queue.length; n > 0; n--)
+    {
+      file = g_queue_pop_head (&store->changed_queue);
+      g_hash_table_remove (store->changed_files, file);
+
+      row = g_hash_table_lookup (store->file_rows, file);
+      if (G_LIKELY (row != NULL))
+        {
+          if (resort)
+            {
+              /* the row is already at its place */
+              GTK_TREE_ITER_INIT (tree_iter, store->stamp, row);
+              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+              gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &tree_iter);
+              gtk_tree_path_free (path);
+            }
+          else
+            {
+              thunar_list_model_row_update (store, row);
+            }
+        }
+      g_object_unref (file);
+
+      /* the rows were sorted for all queued files, finish them */
+      if (!resort && g_get_monotonic_time () >= end_time)
+        break;
+    }
+
+  return !g_queue_is_empty (&store->changed_queue);
+}
+
+
+
+static void
+thunar_list_model_summary_add (ThunarListModelSummary *summary,
+                               ThunarFile             *file)
+{
+  guint64 date;
+
+  if (thunar_file_is_directory (file))
+    {
+      summary->folder_count++;
+    }
+  else
+    {
+      summary->non_folder_count++;
+      if (thunar_file_is_regular (file))
+        summary->size += thunar_file_get_size (file);
+    }
+
+  date = thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+  if (summary->last_modified_date <= date)
+    {
+      summary->last_modified_date = date;
+      summary->last_modified_file = file;
+    }
+}
+
+
+
+static void
+thunar_list_model_summary_remove (ThunarListModel *store,
+                                  ThunarFile      *file)
+{
+  if (!store->summary_valid)
+    return;
+
+  /* the next most recently modified file is not known */
+  if (G_UNLIKELY (store->summary.last_modified_file == file))
+    {
+      store->summary_valid = FALSE;
+      return;
+    }
+
+  if (thunar_file_is_directory (file))
+    {
+      store->summary.folder_count--;
+    }
+  else
+    {
+      store->summary.non_folder_count--;
+      if (thunar_file_is_regular (file))
+        store->summary.size -= thunar_file_get_size (file);
+    }
+}
+
+
+
+static const ThunarListModelSummary *
+thunar_list_model_get_summary (ThunarListModel *store)
+{
+  GSequenceIter *row;
+  GSequenceIter *end;
+
+  if (G_UNLIKELY (!store->summary_valid))
+    {
+      memset (&store->summary, 0, sizeof (store->summary));
+
+      end = g_sequence_get_end_iter (store->rows);
+      for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
+        thunar_list_model_summary_add (&store->summary, g_sequence_get (row));
+
+      store->summary_valid = TRUE;
+    }
+
+  return &store->summary;
+}
+
+
+
+/**
+ * thunar_list_model_get_statusbar_text_for_summary:
+ * @summary                      : totals of the files for which a text is requested
  * @show_file_size_binary_format : weather the file size should be displayed in binary format
  *
- * Generates the statusbar text for the given @files.
+ * Generates the statusbar text for the files summed up in @summary.
  *
  * The caller is reponsible to free the returned text using
  * g_free() when it's no longer needed.
  *
- * Return value: the statusbar text for @store with the given @files.
+ * Return value: the statusbar text for @store with the given @summary.
  **/
 static gchar*
-thunar_list_model_get_statusbar_text_for_files (ThunarListModel *store,
-                                                GList           *files,
-                                                gboolean         show_file_size_binary_format)
+thunar_list_model_get_statusbar_text_for_summary (ThunarListModel              *store,
+                                                  const ThunarListModelSummary *summary,
+                                                  gboolean                      show_file_size_binary_format)
 {
-  guint64            size_summary       = 0;
-  gint               folder_count       = 0;
-  gint               non_folder_count   = 0;
-  GList             *lp;
+  guint64            size_summary       = summary->size;
+  gint               folder_count       = summary->folder_count;
+  gint               non_folder_count   = summary->non_folder_count;
   GList             *text_list          = NULL;
   gchar             *size_string        = NULL;
   gchar             *temp_string        = NULL;
   gchar             *folder_text        = NULL;
   gchar             *non_folder_text    = NULL;
-  ThunarPreferences *preferences;
   guint              active;
-  guint64            last_modified_date = 0;
-  guint64            temp_last_modified_date;
-  ThunarFile        *last_modified_file = NULL;
+  ThunarFile        *last_modified_file = summary->last_modified_file;
   gboolean           show_size, show_size_in_bytes, show_last_modified;
 
-  preferences = thunar_preferences_get ();
-  g_object_get (G_OBJECT (preferences), "misc-status-bar-active-info", &active, NULL);
+  active = thunar_preferences_get_snapshot ()->misc_status_bar_active_info;
   show_size = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_SIZE);
   show_size_in_bytes = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_SIZE_IN_BYTES);
   show_last_modified = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_LAST_MODIFIED);
-  g_object_unref (preferences);
-
-  /* analyze files */
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      if (thunar_file_is_directory (lp->data))
-        {
-          folder_count++;
-        }
-      else
-        {
-          non_folder_count++;
-          if (thunar_file_is_regular (lp->data))
-            size_summary += thunar_file_get_size (lp->data);
-        }
-      temp_last_modified_date = thunar_file_get_date (lp->data, THUNAR_FILE_DATE_MODIFIED);
-      if (last_modified_date <= temp_last_modified_date)
-        {
-          last_modified_date = temp_last_modified_date;
-          last_modified_file = lp->data;
-        }
-    }
 
   if (non_folder_count > 0)
     {
@@ -3264,19 +6103,14 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
   gchar             *text           = "";
   gint               height;
   gint               width;
-  GSequenceIter     *row;
-  GSequenceIter     *end;
-  ThunarPreferences *preferences;
   gboolean           show_image_size;
   gboolean           show_file_size_binary_format;
-  GList             *relevant_files = NULL;
   guint              active;
   gboolean           show_size, show_size_in_bytes, show_filetype, show_display_name, show_last_modified;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  preferences = thunar_preferences_get ();
-  g_object_get (G_OBJECT (preferences), "misc-status-bar-active-info", &active, NULL);
+  active = thunar_preferences_get_snapshot ()->misc_status_bar_active_info;
   show_size = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_SIZE);
   show_size_in_bytes = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_SIZE_IN_BYTES);
   show_filetype = thunar_status_bar_info_check_active (active, THUNAR_STATUS_BAR_INFO_FILETYPE);
@@ -3286,20 +6120,14 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
 
   if (selected_items == NULL) /* nothing selected */
     {
-      /* build a GList of all files */
-      end = g_sequence_get_end_iter (store->rows);
-      for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
-        {
-          relevant_files = g_list_append (relevant_files, g_sequence_get (row));
-        }
-
       /* try to determine a file for the current folder */
       file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
-      temp_string = thunar_list_model_get_statusbar_text_for_files (store, relevant_files, show_file_size_binary_format);
+      temp_string = thunar_list_model_get_statusbar_text_for_summary (store, thunar_list_model_get_summary (store),
+                                                                      show_file_size_binary_format);
       text_list = g_list_append (text_list, temp_string);
 
       /* check if we can determine the amount of free space for the volume */
-      if (G_LIKELY (file != NULL && thunar_g_file_get_free_space (thunar_file_get_file (file), &size, NULL)))
+      if (G_LIKELY (file != NULL && thunar_free_space_cache_lookup_file (store->free_space_cache, file, &size, NULL)))
         {
           /* humanize the free space */
           gchar *size_string = g_format_size_full (size, show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
@@ -3307,8 +6135,6 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
           text_list = g_list_append (text_list, temp_string);
           g_free (size_string);
         }
-
-      g_list_free (relevant_files);
     }
   else if (selected_items->next == NULL) /* only one item selected */
     {
@@ -3374,7 +6200,7 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
         {
           /* check if the size should be visible in the statusbar, disabled by
            * default to avoid high i/o  */
-          g_object_get (preferences, "misc-image-size-in-statusbar", &show_image_size, NULL);
+          show_image_size = thunar_preferences_get_snapshot ()->misc_image_size_in_statusbar;
           if (show_image_size)
             {
               /* check if we can determine the dimension of this file (only for image files) */
@@ -3399,40 +6225,91 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
     }
   else /* more than one item selected */
     {
-      gchar *selected_string;
-      /* build GList of files from selection */
-      for (lp = selected_items; lp != NULL; lp = lp->next)
+      gchar                        *selected_string;
+      const ThunarListModelSummary *summary;
+      ThunarListModelSummary        selection = { 0, };
+
+      /* selecting all rows uses the running totals of the model */
+      if (g_list_length (selected_items) == (guint) g_sequence_get_length (store->rows))
+        {
+          summary = thunar_list_model_get_summary (store);
+        }
+      else
         {
-          gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, lp->data);
-          relevant_files = g_list_append (relevant_files, g_sequence_get (iter.user_data));
+          /* sum up the selected files */
+          for (lp = selected_items; lp != NULL; lp = lp->next)
+            {
+              gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, lp->data);
+              thunar_list_model_summary_add (&selection, g_sequence_get (iter.user_data));
+            }
+          summary = &selection;
         }
-      selected_string = thunar_list_model_get_statusbar_text_for_files (store, relevant_files, show_file_size_binary_format);
+
+      selected_string = thunar_list_model_get_statusbar_text_for_summary (store, summary, show_file_size_binary_format);
       temp_string = g_strdup_printf (_("Selection: %s"), selected_string);
       text_list = g_list_append (text_list, temp_string);
-      g_list_free (relevant_files);
       g_free (selected_string);
     }
 
   text = thunar_util_strjoin_list (text_list, "  |  ");
   g_list_free_full (text_list, g_free);
-  g_object_unref (preferences);
   return text;
 }
 
 
 
 static void
-thunar_list_model_file_count_callback (ExoJob  *job,
-                                       gpointer model)
+thunar_list_model_file_count_callback (ThunarFile *file,
+                                       gpointer    model)
 {
-  GArray     *param_values;
-  ThunarFile *file;
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
+
+  thunar_list_model_file_changed (file, model);
+}
+
+
 
-  param_values = thunar_simple_job_get_param_values (THUNAR_SIMPLE_JOB (job));
-  file = THUNAR_FILE (g_value_get_object (&g_array_index (param_values, GValue, 0)));
+/**
+ * thunar_list_model_get_census:
+ * @n_models : return location for the number of list models alive.
+ * @n_rows   : return location for the number of their rows, hidden
+ *             files included.
+ * @bytes    : return location for an estimate of the memory they hold,
+ *             without the files themselves.
+ *
+ * Determines how much the list models of the views hold.
+ **/
+void
+thunar_list_model_get_census (guint   *n_models,
+                              guint64 *n_rows,
+                              guint64 *bytes)
+{
+  GHashTableIter   iter;
+  ThunarListModel *store;
+  guint            n_visible;
+  guint            n_hidden;
+
+  *n_models = 0;
+  *n_rows = 0;
+  *bytes = 0;
 
-  if (file == NULL)
+  if (thunar_list_models == NULL)
     return;
 
-  thunar_list_model_file_changed (NULL, file, THUNAR_LIST_MODEL (model));
+  /* a row is a sequence node and an entry of the lookup table, the
+   * cached strings of a row are about as long as the name */
+  g_hash_table_iter_init (&iter, thunar_list_models);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &store, NULL))
+    {
+      n_visible = g_sequence_get_length (store->rows);
+      n_hidden = g_slist_length (store->hidden);
+
+      *n_models += 1;
+      *n_rows += n_visible + n_hidden;
+      *bytes += sizeof (ThunarListModel)
+              + n_visible * 10 * sizeof (gpointer)
+              + n_hidden * 2 * sizeof (gpointer)
+              + g_hash_table_size (store->row_cache) * (sizeof (ThunarListModelRowCache) + THUNAR_LIST_MODEL_N_CACHED * 16);
+    }
 }
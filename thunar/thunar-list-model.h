@@ -63,6 +63,9 @@ void             thunar_list_model_set_file_size_binary   (ThunarListModel  *sto
 
 ThunarFile      *thunar_list_model_get_file               (ThunarListModel  *store,
                                                            GtkTreeIter      *iter);
+gboolean         thunar_list_model_has_name_prefix        (ThunarListModel  *store,
+                                                           GtkTreeIter      *iter,
+                                                           const gchar      *key);
 
 
 GList           *thunar_list_model_get_paths_for_files    (ThunarListModel  *store,
@@ -74,10 +77,19 @@ GList           *thunar_list_model_get_paths_for_pattern  (ThunarListModel  *sto
 
 gchar           *thunar_list_model_get_statusbar_text     (ThunarListModel  *store,
                                                            GList            *selected_items);
+void             thunar_list_model_freeze_changes         (ThunarListModel  *store);
+void             thunar_list_model_thaw_changes           (ThunarListModel  *store);
+gboolean         thunar_list_model_apply_changes          (ThunarListModel  *store,
+                                                           gint64            budget);
+
 ThunarJob       *thunar_list_model_get_job                (ThunarListModel  *store);
 void             thunar_list_model_set_job                (ThunarListModel  *store,
                                                            ThunarJob        *job);
 
+void             thunar_list_model_get_census             (guint            *n_models,
+                                                           guint64          *n_rows,
+                                                           guint64          *bytes);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_LIST_MODEL_H__ */
@@ -143,6 +143,9 @@ struct _ThunarLocationButton
   guint               drop_data_ready : 1;
   guint               drop_occurred : 1;
 
+  /* the location shown until the file is known */
+  GFile              *placeholder;
+
   /* public properties */
   ThunarFile         *file;
 };
@@ -288,6 +291,7 @@ thunar_location_button_finalize (GObject *object)
 
   /* disconnect from the file */
   thunar_location_button_set_file (location_button, NULL);
+  g_clear_object (&location_button->placeholder);
 
   (*G_OBJECT_CLASS (thunar_location_button_parent_class)->finalize) (object);
 }
@@ -919,6 +923,13 @@ thunar_location_button_set_file (ThunarLocationButton *location_button,
   /* connect to the new file */
   if (G_LIKELY (file != NULL))
     {
+      /* the placeholder is complete now */
+      if (location_button->placeholder != NULL)
+        {
+          g_clear_object (&location_button->placeholder);
+          gtk_widget_set_sensitive (GTK_WIDGET (location_button), TRUE);
+        }
+
       /* take a reference on the new file */
       g_object_ref (G_OBJECT (file));
 
@@ -939,6 +950,57 @@ thunar_location_button_set_file (ThunarLocationButton *location_button,
 
 
 
+/**
+ * thunar_location_button_set_placeholder:
+ * @location_button : a #ThunarLocationButton without a file.
+ * @location        : the #GFile the button stands for.
+ *
+ * Shows the name of @location on @location_button until its #ThunarFile
+ * is known and set with thunar_location_button_set_file(). The button
+ * is insensitive meanwhile, as there is no file to open or drop onto.
+ **/
+void
+thunar_location_button_set_placeholder (ThunarLocationButton *location_button,
+                                        GFile                *location)
+{
+  gchar *display_name;
+
+  _thunar_return_if_fail (THUNAR_IS_LOCATION_BUTTON (location_button));
+  _thunar_return_if_fail (location_button->file == NULL);
+  _thunar_return_if_fail (G_IS_FILE (location));
+
+  g_set_object (&location_button->placeholder, location);
+
+  /* the name from the path, the display name follows with the file */
+  display_name = thunar_g_file_get_display_name (location);
+  gtk_label_set_text (GTK_LABEL (location_button->label), display_name);
+  gtk_widget_show (location_button->label);
+  gtk_widget_hide (location_button->image);
+  g_free (display_name);
+
+  gtk_widget_set_sensitive (GTK_WIDGET (location_button), FALSE);
+}
+
+
+
+/**
+ * thunar_location_button_get_placeholder:
+ * @location_button : a #ThunarLocationButton.
+ *
+ * Returns the location @location_button shows until its file is known,
+ * see thunar_location_button_set_placeholder().
+ *
+ * Return value: the #GFile of the placeholder or %NULL.
+ **/
+GFile *
+thunar_location_button_get_placeholder (ThunarLocationButton *location_button)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LOCATION_BUTTON (location_button), NULL);
+  return location_button->placeholder;
+}
+
+
+
 /**
  * thunar_location_button_clicked:
  * @location_button : a #ThunarLocationButton.
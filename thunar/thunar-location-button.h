@@ -42,6 +42,10 @@ ThunarFile *thunar_location_button_get_file   (ThunarLocationButton *location_bu
 void        thunar_location_button_set_file   (ThunarLocationButton *location_button,
                                                ThunarFile           *file);
 
+void        thunar_location_button_set_placeholder (ThunarLocationButton *location_button,
+                                                    GFile                *location);
+GFile      *thunar_location_button_get_placeholder (ThunarLocationButton *location_button);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_LOCATION_BUTTON_H__ */
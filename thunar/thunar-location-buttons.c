@@ -32,6 +32,7 @@
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
+#include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-location-button.h>
 #include <thunar/thunar-location-buttons.h>
 #include <thunar/thunar-private.h>
@@ -123,6 +124,7 @@ static gboolean       thunar_location_buttons_context_menu                (Thuna
                                                                            ThunarLocationButtons      *buttons);
 static void           thunar_location_buttons_gone                        (ThunarLocationButton       *button,
                                                                            ThunarLocationButtons      *buttons);
+static void           thunar_location_buttons_cancel_ancestors            (ThunarLocationButtons      *buttons);
 
 
 
@@ -153,6 +155,9 @@ struct _ThunarLocationButtons
   GList               *last_visible_button;
 
   guint                scroll_timeout_id;
+
+  /* looks up the ancestors shown by placeholder buttons */
+  ThunarJob           *ancestors_job;
 };
 
 
@@ -310,6 +315,9 @@ thunar_location_buttons_finalize (GObject *object)
   /* be sure to cancel the scrolling */
   thunar_location_buttons_stop_scrolling (buttons);
 
+  /* stop looking up the ancestors */
+  thunar_location_buttons_cancel_ancestors (buttons);
+
   /* release from the current_directory */
   thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (buttons), NULL);
 
@@ -377,14 +385,77 @@ eglible_for_fake_root (ThunarFile *file)
 
 
 
+static gboolean
+thunar_location_buttons_ancestors_ready (ThunarJob             *job,
+                                         GList                 *files,
+                                         ThunarLocationButtons *buttons)
+{
+  GFile *placeholder;
+  GList *fp;
+  GList *lp;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LOCATION_BUTTONS (buttons), FALSE);
+  _thunar_return_val_if_fail (buttons->ancestors_job == job, FALSE);
+
+  /* fill in the placeholder buttons of the files */
+  for (fp = files; fp != NULL; fp = fp->next)
+    for (lp = buttons->list; lp != NULL; lp = lp->next)
+      {
+        placeholder = thunar_location_button_get_placeholder (lp->data);
+        if (placeholder != NULL && g_file_equal (placeholder, thunar_file_get_file (fp->data)))
+          {
+            thunar_location_button_set_file (lp->data, fp->data);
+
+            /* use 'Home' as fake root button */
+            if (!buttons->fake_root_button && eglible_for_fake_root (fp->data))
+              buttons->fake_root_button = lp;
+            break;
+          }
+      }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_location_buttons_ancestors_finished (ThunarJob             *job,
+                                            ThunarLocationButtons *buttons)
+{
+  _thunar_return_if_fail (THUNAR_IS_LOCATION_BUTTONS (buttons));
+  _thunar_return_if_fail (buttons->ancestors_job == job);
+
+  g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, buttons);
+  g_object_unref (job);
+  buttons->ancestors_job = NULL;
+}
+
+
+
+static void
+thunar_location_buttons_cancel_ancestors (ThunarLocationButtons *buttons)
+{
+  if (buttons->ancestors_job == NULL)
+    return;
+
+  g_signal_handlers_disconnect_matched (buttons->ancestors_job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, buttons);
+  exo_job_cancel (EXO_JOB (buttons->ancestors_job));
+  g_object_unref (buttons->ancestors_job);
+  buttons->ancestors_job = NULL;
+}
+
+
+
 static void
 thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
                                                ThunarFile      *current_directory)
 {
   ThunarLocationButtons *buttons = THUNAR_LOCATION_BUTTONS (navigator);
-  ThunarFile            *file_parent;
   ThunarFile            *file;
   GtkWidget             *button;
+  GFile                 *location;
+  GFile                 *parent;
+  GList                 *placeholders = NULL;
   GList                 *lp;
 
   _thunar_return_if_fail (current_directory == NULL || THUNAR_IS_FILE (current_directory));
@@ -404,6 +475,9 @@ thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
         }
     }
 
+  /* the placeholders of the previous directory are of no interest anymore */
+  thunar_location_buttons_cancel_ancestors (buttons);
+
   if (G_LIKELY (buttons->current_directory != NULL))
     {
       /* remove all buttons */
@@ -425,23 +499,47 @@ thunar_location_buttons_set_current_directory (ThunarNavigator *navigator,
     {
       g_object_ref (G_OBJECT (current_directory));
 
-      /* add the new buttons */
-      for (file = current_directory; file != NULL; file = file_parent)
+      /* add the new buttons, the ancestors which are not cached get a
+       * placeholder instead of blocking on a slow remote location */
+      file = g_object_ref (current_directory);
+      for (location = g_object_ref (thunar_file_get_file (current_directory)); location != NULL; location = parent)
         {
+          if (file == NULL)
+            file = thunar_file_cache_lookup (location);
+
           button = thunar_location_buttons_make_button (buttons, file);
           buttons->list = g_list_append (buttons->list, button);
           gtk_container_add (GTK_CONTAINER (buttons), button);
           gtk_widget_show (button);
 
-          /* use 'Home' as fake root button */
-          if (!buttons->fake_root_button && eglible_for_fake_root (file))
-            buttons->fake_root_button = g_list_last (buttons->list);
+          if (file == NULL)
+            {
+              thunar_location_button_set_placeholder (THUNAR_LOCATION_BUTTON (button), location);
+              placeholders = g_list_prepend (placeholders, g_object_ref (location));
+            }
+          else if (!buttons->fake_root_button && eglible_for_fake_root (file))
+            {
+              /* use 'Home' as fake root button */
+              buttons->fake_root_button = g_list_last (buttons->list);
+            }
 
           /* continue with the parent (if any) */
-          file_parent = thunar_file_get_parent (file, NULL);
+          parent = g_file_get_parent (location);
+          g_object_unref (location);
 
-          if (G_LIKELY (file != current_directory))
+          if (file != NULL)
             g_object_unref (G_OBJECT (file));
+          file = NULL;
+        }
+
+      /* look up all placeholders in one job, from the root on */
+      if (placeholders != NULL)
+        {
+          buttons->ancestors_job = thunar_io_jobs_get_files (placeholders);
+          g_signal_connect (buttons->ancestors_job, "files-ready", G_CALLBACK (thunar_location_buttons_ancestors_ready), buttons);
+          g_signal_connect (buttons->ancestors_job, "finished", G_CALLBACK (thunar_location_buttons_ancestors_finished), buttons);
+          thunar_job_launch (buttons->ancestors_job);
+          thunar_g_list_free_full (placeholders);
         }
     }
 
@@ -0,0 +1,357 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-metadata-writer.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
+
+
+
+/**
+ * SECTION:thunar-metadata-writer
+ * @Short_description: Coalesced writes of GVfs metadata
+ * @Title: ThunarMetadataWriter
+ *
+ * Emblems and per-folder view settings are stored as "metadata::"
+ * attributes, and every g_file_set_attributes_async() call is a round
+ * trip to the metadata daemon followed by a "changed" notification of
+ * the file. Instead the attributes are collected per file and per
+ * parent folder, and written from a worker thread once the main loop
+ * is idle. Several updates of the same attribute are merged into the
+ * last value, and every file is notified only once per commit.
+ *
+ * Only a single commit is in flight at any time, so the writes reach
+ * the daemon in the order they were made.
+ **/
+
+
+
+typedef struct
+{
+  ThunarFile *file;
+  GFileInfo  *info;
+  GError     *error;
+} ThunarMetadataWrite;
+
+typedef struct
+{
+  GFile      *directory;
+  GPtrArray  *writes;
+  GHashTable *lookup;  /* ThunarFile -> ThunarMetadataWrite, main thread only */
+} ThunarMetadataBatch;
+
+
+
+static void thunar_metadata_writer_schedule (void);
+
+
+
+/* batches waiting to be committed, in the order they were started */
+static GQueue      pending_batches = G_QUEUE_INIT;
+static GHashTable *pending_lookup = NULL;  /* GFile (directory) -> ThunarMetadataBatch */
+static guint       commit_idle_id = 0;
+static gboolean    committing = FALSE;
+
+
+
+static void
+thunar_metadata_write_free (gpointer data)
+{
+  ThunarMetadataWrite *write = data;
+
+  g_object_unref (write->file);
+  g_object_unref (write->info);
+  if (write->error != NULL)
+    g_error_free (write->error);
+  g_slice_free (ThunarMetadataWrite, write);
+}
+
+
+
+static void
+thunar_metadata_batch_free (gpointer data)
+{
+  ThunarMetadataBatch *batch = data;
+
+  g_object_unref (batch->directory);
+  g_ptr_array_unref (batch->writes);
+  if (batch->lookup != NULL)
+    g_hash_table_destroy (batch->lookup);
+  g_slice_free (ThunarMetadataBatch, batch);
+}
+
+
+
+static ThunarMetadataWrite *
+thunar_metadata_writer_lookup (ThunarFile *file)
+{
+  ThunarMetadataBatch *batch;
+  ThunarMetadataWrite *write;
+  GFile               *directory;
+
+  if (G_UNLIKELY (pending_lookup == NULL))
+    pending_lookup = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+  /* the root folder is grouped with itself */
+  directory = g_file_get_parent (thunar_file_get_file (file));
+  if (directory == NULL)
+    directory = g_object_ref (thunar_file_get_file (file));
+
+  batch = g_hash_table_lookup (pending_lookup, directory);
+  if (batch == NULL)
+    {
+      batch = g_slice_new0 (ThunarMetadataBatch);
+      batch->directory = g_object_ref (directory);
+      batch->writes = g_ptr_array_new_with_free_func (thunar_metadata_write_free);
+      batch->lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+      g_queue_push_tail (&pending_batches, batch);
+      g_hash_table_insert (pending_lookup, batch->directory, batch);
+    }
+  g_object_unref (directory);
+
+  write = g_hash_table_lookup (batch->lookup, file);
+  if (write == NULL)
+    {
+      write = g_slice_new0 (ThunarMetadataWrite);
+      write->file = g_object_ref (file);
+      write->info = g_file_info_new ();
+
+      g_ptr_array_add (batch->writes, write);
+      g_hash_table_insert (batch->lookup, file, write);
+    }
+
+  return write;
+}
+
+
+
+static GPtrArray *
+thunar_metadata_writer_take_pending (void)
+{
+  ThunarMetadataBatch *batch;
+  GPtrArray           *batches;
+
+  batches = g_ptr_array_new_with_free_func (thunar_metadata_batch_free);
+
+  while ((batch = g_queue_pop_head (&pending_batches)) != NULL)
+    {
+      /* the batch is not touched by the main thread anymore */
+      g_hash_table_destroy (batch->lookup);
+      batch->lookup = NULL;
+
+      g_ptr_array_add (batches, batch);
+    }
+
+  if (pending_lookup != NULL)
+    g_hash_table_remove_all (pending_lookup);
+
+  return batches;
+}
+
+
+
+static void
+thunar_metadata_writer_commit (GPtrArray *batches)
+{
+  ThunarMetadataBatch *batch;
+  ThunarMetadataWrite *write;
+  guint                n, m;
+
+  for (n = 0; n < batches->len; ++n)
+    {
+      batch = g_ptr_array_index (batches, n);
+      for (m = 0; m < batch->writes->len; ++m)
+        {
+          write = g_ptr_array_index (batch->writes, m);
+          g_file_set_attributes_from_info (thunar_file_get_file (write->file), write->info,
+                                           G_FILE_QUERY_INFO_NONE, NULL, &write->error);
+        }
+
+      thunar_stats_record (THUNAR_STATS_METADATA_BATCH, batch->writes->len);
+    }
+}
+
+
+
+static void
+thunar_metadata_writer_complete (GPtrArray *batches)
+{
+  ThunarMetadataBatch *batch;
+  ThunarMetadataWrite *write;
+  GHashTable          *notified;
+  guint                n, m;
+  guint                n_failed;
+
+  notified = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  for (n = 0; n < batches->len; ++n)
+    {
+      batch = g_ptr_array_index (batches, n);
+      n_failed = 0;
+
+      for (m = 0; m < batch->writes->len; ++m)
+        {
+          write = g_ptr_array_index (batch->writes, m);
+
+          /* drop the values which did not make it to the daemon, so the
+           * in-memory info matches what is actually stored */
+          if (write->error != NULL)
+            {
+              if (n_failed++ == 0)
+                g_warning ("Failed to set metadata: %s", write->error->message);
+              thunar_file_discard_metadata (write->file, write->info);
+            }
+
+          if (g_hash_table_add (notified, write->file))
+            thunar_file_changed (write->file);
+        }
+
+      if (G_UNLIKELY (n_failed > 1))
+        g_warning ("Failed to set metadata of %u more files", n_failed - 1);
+    }
+
+  g_hash_table_destroy (notified);
+}
+
+
+
+static void
+thunar_metadata_writer_thread (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+  thunar_metadata_writer_commit (task_data);
+  g_task_return_boolean (task, TRUE);
+}
+
+
+
+static void
+thunar_metadata_writer_ready (GObject      *source_object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  thunar_metadata_writer_complete (g_task_get_task_data (G_TASK (result)));
+
+  committing = FALSE;
+
+  /* commit what was queued in the meantime */
+  if (!g_queue_is_empty (&pending_batches))
+    thunar_metadata_writer_schedule ();
+}
+
+
+
+static gboolean
+thunar_metadata_writer_idle (gpointer user_data)
+{
+  GTask *task;
+
+  commit_idle_id = 0;
+
+  if (committing || g_queue_is_empty (&pending_batches))
+    return FALSE;
+
+  committing = TRUE;
+
+  task = g_task_new (NULL, NULL, thunar_metadata_writer_ready, NULL);
+  g_task_set_task_data (task, thunar_metadata_writer_take_pending (), (GDestroyNotify) g_ptr_array_unref);
+  g_task_run_in_thread (task, thunar_metadata_writer_thread);
+  g_object_unref (task);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_metadata_writer_schedule (void)
+{
+  if (commit_idle_id == 0 && !committing)
+    commit_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_metadata_writer_idle, NULL, NULL);
+}
+
+
+
+/**
+ * thunar_metadata_writer_set_attribute:
+ * @file      : a #ThunarFile instance.
+ * @attr_name : the name of a "metadata::" attribute.
+ * @type      : the type of the attribute, or %G_FILE_ATTRIBUTE_TYPE_INVALID
+ *              to unset it.
+ * @value_p   : pointer to the value, or %NULL to unset it.
+ *
+ * Queues storing @attr_name of @file in the metadata daemon. The caller
+ * is expected to have updated the in-memory info of @file already,
+ * @file will be notified once the write was committed.
+ **/
+void
+thunar_metadata_writer_set_attribute (ThunarFile         *file,
+                                      const gchar        *attr_name,
+                                      GFileAttributeType  type,
+                                      gpointer            value_p)
+{
+  ThunarMetadataWrite *write;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (attr_name != NULL);
+
+  /* a later value of the same attribute replaces the queued one */
+  write = thunar_metadata_writer_lookup (file);
+  g_file_info_set_attribute (write->info, attr_name, type, value_p);
+
+  thunar_metadata_writer_schedule ();
+}
+
+
+
+/**
+ * thunar_metadata_writer_flush:
+ *
+ * Writes all queued metadata right away, blocking until the daemon has
+ * stored it. Used where the value has to be on disk before continuing,
+ * and when the application shuts down.
+ **/
+void
+thunar_metadata_writer_flush (void)
+{
+  GPtrArray *batches;
+
+  if (g_queue_is_empty (&pending_batches))
+    return;
+
+  if (commit_idle_id != 0)
+    {
+      g_source_remove (commit_idle_id);
+      commit_idle_id = 0;
+    }
+
+  batches = thunar_metadata_writer_take_pending ();
+  thunar_metadata_writer_commit (batches);
+  thunar_metadata_writer_complete (batches);
+  g_ptr_array_unref (batches);
+}
@@ -0,0 +1,37 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __THUNAR_METADATA_WRITER_H__
+#define __THUNAR_METADATA_WRITER_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS
+
+void thunar_metadata_writer_set_attribute (ThunarFile         *file,
+                                           const gchar        *attr_name,
+                                           GFileAttributeType  type,
+                                           gpointer            value_p);
+void thunar_metadata_writer_flush         (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_METADATA_WRITER_H__ */
@@ -40,8 +40,6 @@
 
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
-#include <thunar/thunar-icon-renderer.h>
-#include <thunar/thunar-list-model.h>
 #include <thunar/thunar-path-entry.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-util.h>
@@ -59,6 +57,31 @@ enum
   PROP_CURRENT_FILE,
 };
 
+/* columns of the completion store */
+enum
+{
+  COMPLETION_COLUMN_NAME,
+  COMPLETION_COLUMN_ICON,
+  COMPLETION_COLUMN_IS_DIRECTORY,
+  COMPLETION_COLUMN_IS_HIDDEN,
+  COMPLETION_COLUMN_ROW,
+  COMPLETION_N_COLUMNS,
+};
+
+
+
+/* a name in the folder being completed, collected by the enumeration thread */
+typedef struct
+{
+  gchar    *name;
+  gchar    *key;
+  gchar    *collate_key;
+  GIcon    *icon;
+  gboolean  is_directory;
+  gboolean  is_hidden;
+  guint     row;
+} ThunarPathEntryName;
+
 
 
 static void     thunar_path_entry_editable_init                 (GtkEditableInterface *iface);
@@ -101,11 +124,22 @@ static void     thunar_path_entry_do_insert_text                (GtkEditable
                                                                  gint                  new_text_length,
                                                                  gint                 *position);
 static void     thunar_path_entry_clear_completion              (ThunarPathEntry      *path_entry);
+static void     thunar_path_entry_names_load                    (ThunarPathEntry      *path_entry,
+                                                                 ThunarFile           *folder);
+static void     thunar_path_entry_names_thread                  (GTask                *task,
+                                                                 gpointer              source_object,
+                                                                 gpointer              task_data,
+                                                                 GCancellable         *cancellable);
+static void     thunar_path_entry_names_ready                   (GObject              *object,
+                                                                 GAsyncResult         *result,
+                                                                 gpointer              user_data);
+static void     thunar_path_entry_names_match                   (ThunarPathEntry      *path_entry,
+                                                                 const gchar          *text);
 static void     thunar_path_entry_common_prefix_append          (ThunarPathEntry      *path_entry,
                                                                  gboolean              highlight);
 static void     thunar_path_entry_common_prefix_lookup          (ThunarPathEntry      *path_entry,
                                                                  gchar               **prefix_return,
-                                                                 ThunarFile          **file_return);
+                                                                 ThunarPathEntryName **name_return);
 static gboolean thunar_path_entry_match_func                    (GtkEntryCompletion   *completion,
                                                                  const gchar          *key,
                                                                  GtkTreeIter          *iter,
@@ -147,6 +181,19 @@ struct _ThunarPathEntry
   guint              has_completion : 1;
   guint              check_completion_idle_id;
 
+  /* the names of the current folder, enumerated in a thread; the
+   * names array is sorted by key, so the matches of the entered
+   * text are a range found by binary search, which is flagged per
+   * row of the completion store for the match function
+   */
+  GtkListStore      *completion_store;
+  GCancellable      *completion_cancellable;
+  GPtrArray         *completion_names;
+  guchar            *completion_matched;
+  gchar             *completion_match_text;
+  guint              completion_match_begin;
+  guint              completion_match_end;
+
   gboolean           search_mode;
 };
 
@@ -231,7 +278,6 @@ thunar_path_entry_init (ThunarPathEntry *path_entry)
 {
   GtkEntryCompletion *completion;
   GtkCellRenderer    *renderer;
-  ThunarListModel    *store;
 
   path_entry->check_completion_idle_id = 0;
   path_entry->working_directory = NULL;
@@ -243,22 +289,20 @@ thunar_path_entry_init (ThunarPathEntry *path_entry)
   g_signal_connect (G_OBJECT (completion), "match-selected", G_CALLBACK (thunar_path_entry_match_selected), path_entry);
 
   /* add the icon renderer to the entry completion */
-  renderer = g_object_new (THUNAR_TYPE_ICON_RENDERER, "size", 16, NULL);
+  renderer = g_object_new (GTK_TYPE_CELL_RENDERER_PIXBUF, "stock-size", GTK_ICON_SIZE_MENU, NULL);
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (completion), renderer, FALSE);
-  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (completion), renderer, "file", THUNAR_COLUMN_FILE);
+  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (completion), renderer, "gicon", COMPLETION_COLUMN_ICON);
 
   /* add the text renderer to the entry completion */
   renderer = gtk_cell_renderer_text_new ();
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (completion), renderer, TRUE);
-  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (completion), renderer, "text", THUNAR_COLUMN_NAME);
+  gtk_cell_layout_add_attribute (GTK_CELL_LAYOUT (completion), renderer, "text", COMPLETION_COLUMN_NAME);
 
-  /* allocate a new list mode for the completion */
-  store = thunar_list_model_new ();
-  thunar_list_model_set_show_hidden (store, TRUE);
-  thunar_list_model_set_folders_first (store, TRUE);
-  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), THUNAR_COLUMN_FILE_NAME, GTK_SORT_ASCENDING);
-  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
-  g_object_unref (G_OBJECT (store));
+  /* the completion only needs the names of the folder, which are
+   * enumerated in a thread instead of loading a full folder model */
+  path_entry->completion_store = gtk_list_store_new (COMPLETION_N_COLUMNS, G_TYPE_STRING, G_TYPE_ICON,
+                                                     G_TYPE_BOOLEAN, G_TYPE_BOOLEAN, G_TYPE_UINT);
+  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (path_entry->completion_store));
 
   /* need to connect the "key-press-event" before the GtkEntry class connects the completion signals, so
    * we get the Tab key before its handled as part of the completion stuff.
@@ -314,6 +358,18 @@ thunar_path_entry_finalize (GObject *object)
   if (G_UNLIKELY (path_entry->check_completion_idle_id != 0))
     g_source_remove (path_entry->check_completion_idle_id);
 
+  /* release the completion names */
+  if (path_entry->completion_cancellable != NULL)
+    {
+      g_cancellable_cancel (path_entry->completion_cancellable);
+      g_object_unref (path_entry->completion_cancellable);
+    }
+  if (path_entry->completion_names != NULL)
+    g_ptr_array_unref (path_entry->completion_names);
+  g_free (path_entry->completion_matched);
+  g_free (path_entry->completion_match_text);
+  g_object_unref (path_entry->completion_store);
+
   (*G_OBJECT_CLASS (thunar_path_entry_parent_class)->finalize) (object);
 }
 
@@ -572,10 +628,7 @@ thunar_path_entry_activate (GtkEntry *entry)
 static void
 thunar_path_entry_changed (GtkEditable *editable)
 {
-  GtkEntryCompletion *completion;
   ThunarPathEntry    *path_entry = THUNAR_PATH_ENTRY (editable);
-  ThunarFolder       *folder;
-  GtkTreeModel       *model;
   const gchar        *text;
   gchar              *scheme;
   ThunarFile         *current_folder;
@@ -644,9 +697,6 @@ thunar_path_entry_changed (GtkEditable *editable)
   current_folder = (folder_path != NULL) ? thunar_file_get (folder_path, NULL) : NULL;
   current_file = (file_path != NULL) ? thunar_file_get (file_path, NULL) : NULL;
 
-  /* determine the entry completion */
-  completion = gtk_entry_get_completion (GTK_ENTRY (path_entry));
-
   /* update the current folder if required */
   if (current_folder != path_entry->current_folder)
     {
@@ -657,26 +707,11 @@ thunar_path_entry_changed (GtkEditable *editable)
       if (G_LIKELY (current_folder != NULL))
         g_object_ref (G_OBJECT (current_folder));
 
-      /* try to open the current-folder file as folder */
+      /* collect the names of the new folder for the completion */
       if (current_folder != NULL && thunar_file_is_directory (current_folder))
-        folder = thunar_folder_get_for_file (current_folder);
+        thunar_path_entry_names_load (path_entry, current_folder);
       else
-        folder = NULL;
-
-      /* set the new folder for the completion model, but disconnect the model from the
-       * completion first, because GtkEntryCompletion has become very slow recently when
-       * updating the model being used (https://bugzilla.xfce.org/show_bug.cgi?id=1681).
-       */
-      model = gtk_entry_completion_get_model (completion);
-      g_object_ref (G_OBJECT (model));
-      gtk_entry_completion_set_model (completion, NULL);
-      thunar_list_model_set_folder (THUNAR_LIST_MODEL (model), folder, NULL);
-      gtk_entry_completion_set_model (completion, model);
-      g_object_unref (G_OBJECT (model));
-
-      /* cleanup */
-      if (G_LIKELY (folder != NULL))
-        g_object_unref (G_OBJECT (folder));
+        thunar_path_entry_names_load (path_entry, NULL);
 
       /* we most likely need a new icon */
       update_icon = TRUE;
@@ -805,36 +840,334 @@ thunar_path_entry_clear_completion (ThunarPathEntry *path_entry)
 
 
 
+static void
+thunar_path_entry_name_free (gpointer data)
+{
+  ThunarPathEntryName *name = data;
+
+  if (name->icon != NULL)
+    g_object_unref (name->icon);
+  g_free (name->collate_key);
+  g_free (name->key);
+  g_free (name->name);
+  g_slice_free (ThunarPathEntryName, name);
+}
+
+
+
+static gint
+thunar_path_entry_name_compare_key (gconstpointer a,
+                                    gconstpointer b)
+{
+  const ThunarPathEntryName *name_a = *((ThunarPathEntryName **) a);
+  const ThunarPathEntryName *name_b = *((ThunarPathEntryName **) b);
+
+  return strcmp (name_a->key, name_b->key);
+}
+
+
+
+static gint
+thunar_path_entry_name_compare_collate (gconstpointer a,
+                                        gconstpointer b)
+{
+  const ThunarPathEntryName *name_a = *((ThunarPathEntryName **) a);
+  const ThunarPathEntryName *name_b = *((ThunarPathEntryName **) b);
+
+  /* folders first */
+  if (name_a->is_directory != name_b->is_directory)
+    return name_a->is_directory ? -1 : 1;
+
+  return strcmp (name_a->collate_key, name_b->collate_key);
+}
+
+
+
+static gchar*
+thunar_path_entry_name_key (const gchar *name)
+{
+  gchar *normalized;
+  gchar *key;
+
+  /* compare UTF-8 normalized and case insensitive */
+  normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    return g_strdup (name);
+
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+
+
+static void
+thunar_path_entry_names_load (ThunarPathEntry *path_entry,
+                              ThunarFile      *folder)
+{
+  GtkEntryCompletion *completion;
+  GTask              *task;
+
+  /* cancel the enumeration of the previous folder */
+  if (path_entry->completion_cancellable != NULL)
+    {
+      g_cancellable_cancel (path_entry->completion_cancellable);
+      g_object_unref (path_entry->completion_cancellable);
+      path_entry->completion_cancellable = NULL;
+    }
+
+  /* forget the names of the previous folder, but disconnect the store from the
+   * completion first, because GtkEntryCompletion has become very slow recently when
+   * updating the model being used (https://bugzilla.xfce.org/show_bug.cgi?id=1681).
+   */
+  if (path_entry->completion_names != NULL)
+    {
+      completion = gtk_entry_get_completion (GTK_ENTRY (path_entry));
+      gtk_entry_completion_set_model (completion, NULL);
+      gtk_list_store_clear (path_entry->completion_store);
+      gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (path_entry->completion_store));
+
+      g_ptr_array_unref (path_entry->completion_names);
+      path_entry->completion_names = NULL;
+    }
+
+  g_free (path_entry->completion_matched);
+  path_entry->completion_matched = NULL;
+  g_free (path_entry->completion_match_text);
+  path_entry->completion_match_text = NULL;
+  path_entry->completion_match_begin = 0;
+  path_entry->completion_match_end = 0;
+
+  if (folder == NULL)
+    return;
+
+  /* collect the names of the new folder in a thread */
+  path_entry->completion_cancellable = g_cancellable_new ();
+  task = g_task_new (path_entry, path_entry->completion_cancellable, thunar_path_entry_names_ready, NULL);
+  g_task_set_task_data (task, g_object_ref (thunar_file_get_file (folder)), g_object_unref);
+  g_task_run_in_thread (task, thunar_path_entry_names_thread);
+  g_object_unref (task);
+}
+
+
+
+static void
+thunar_path_entry_names_thread (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  GFileEnumerator     *enumerator;
+  ThunarPathEntryName *name;
+  GFileInfo           *info;
+  GPtrArray           *names;
+  GError              *error = NULL;
+  guint                n;
+
+  enumerator = g_file_enumerate_children (G_FILE (task_data),
+                                          G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
+                                          G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP ","
+                                          G_FILE_ATTRIBUTE_STANDARD_ICON,
+                                          G_FILE_QUERY_INFO_NONE, cancellable, &error);
+  if (G_UNLIKELY (enumerator == NULL))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  names = g_ptr_array_new_with_free_func (thunar_path_entry_name_free);
+  while ((info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+    {
+      name = g_slice_new0 (ThunarPathEntryName);
+      name->name = g_strdup (g_file_info_get_display_name (info));
+      name->key = thunar_path_entry_name_key (name->name);
+      name->collate_key = g_utf8_collate_key_for_filename (name->name, -1);
+      name->is_directory = (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY);
+      name->is_hidden = g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info);
+      name->icon = g_file_info_get_icon (info);
+      if (G_LIKELY (name->icon != NULL))
+        g_object_ref (name->icon);
+      g_ptr_array_add (names, name);
+
+      g_object_unref (info);
+    }
+  g_object_unref (enumerator);
+
+  /* remember the order of the completion popup... */
+  g_ptr_array_sort (names, thunar_path_entry_name_compare_collate);
+  for (n = 0; n < names->len; ++n)
+    ((ThunarPathEntryName *) g_ptr_array_index (names, n))->row = n;
+
+  /* ...and sort the names for the prefix lookups */
+  g_ptr_array_sort (names, thunar_path_entry_name_compare_key);
+
+  g_task_return_pointer (task, names, (GDestroyNotify) g_ptr_array_unref);
+}
+
+
+
+static void
+thunar_path_entry_names_ready (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  ThunarPathEntry     *path_entry = THUNAR_PATH_ENTRY (object);
+  ThunarPathEntryName *name;
+  GtkEntryCompletion  *completion;
+  GPtrArray           *names;
+  GPtrArray           *rows;
+  guint                n;
+
+  /* nothing to do if the enumeration failed or a newer one replaced it */
+  names = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (names == NULL)
+    return;
+
+  g_clear_object (&path_entry->completion_cancellable);
+  path_entry->completion_names = names;
+  path_entry->completion_matched = g_new0 (guchar, names->len);
+
+  /* the rows of the store in the order of the popup */
+  rows = g_ptr_array_sized_new (names->len);
+  g_ptr_array_set_size (rows, names->len);
+  for (n = 0; n < names->len; ++n)
+    {
+      name = g_ptr_array_index (names, n);
+      g_ptr_array_index (rows, name->row) = name;
+    }
+
+  /* fill the store while disconnected from the completion, see thunar_path_entry_names_load() */
+  completion = gtk_entry_get_completion (GTK_ENTRY (path_entry));
+  gtk_entry_completion_set_model (completion, NULL);
+  for (n = 0; n < rows->len; ++n)
+    {
+      name = g_ptr_array_index (rows, n);
+      gtk_list_store_insert_with_values (path_entry->completion_store, NULL, -1,
+                                         COMPLETION_COLUMN_NAME, name->name,
+                                         COMPLETION_COLUMN_ICON, name->icon,
+                                         COMPLETION_COLUMN_IS_DIRECTORY, name->is_directory,
+                                         COMPLETION_COLUMN_IS_HIDDEN, name->is_hidden,
+                                         COMPLETION_COLUMN_ROW, n,
+                                         -1);
+    }
+  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (path_entry->completion_store));
+  g_ptr_array_free (rows, TRUE);
+
+  /* offer the completions if the user is already typing */
+  if (gtk_widget_has_focus (GTK_WIDGET (path_entry)))
+    gtk_entry_completion_complete (completion);
+}
+
+
+
+static void
+thunar_path_entry_names_match (ThunarPathEntry *path_entry,
+                               const gchar     *text)
+{
+  ThunarPathEntryName *name;
+  const gchar         *last_slash;
+  gchar               *key;
+  gsize                key_length;
+  guint                lower;
+  guint                upper;
+  guint                middle;
+  guint                n;
+
+  /* check if the matches are still up to date */
+  if (g_strcmp0 (path_entry->completion_match_text, text) == 0)
+    return;
+
+  g_free (path_entry->completion_match_text);
+  path_entry->completion_match_text = g_strdup (text);
+
+  /* unflag the previous matches */
+  for (n = path_entry->completion_match_begin; n < path_entry->completion_match_end; ++n)
+    {
+      name = g_ptr_array_index (path_entry->completion_names, n);
+      path_entry->completion_matched[name->row] = FALSE;
+    }
+  path_entry->completion_match_begin = 0;
+  path_entry->completion_match_end = 0;
+
+  if (path_entry->completion_names == NULL)
+    return;
+
+  /* the entered part of the file name */
+  last_slash = strrchr (text, G_DIR_SEPARATOR);
+  key = thunar_path_entry_name_key ((last_slash != NULL) ? last_slash + 1 : text);
+  key_length = strlen (key);
+
+  /* the first name not sorted before the key... */
+  lower = 0;
+  upper = path_entry->completion_names->len;
+  while (lower < upper)
+    {
+      middle = lower + (upper - lower) / 2;
+      name = g_ptr_array_index (path_entry->completion_names, middle);
+      if (strcmp (name->key, key) < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+  path_entry->completion_match_begin = lower;
+
+  /* ...starts the range of the names with the key as prefix */
+  upper = path_entry->completion_names->len;
+  while (lower < upper)
+    {
+      middle = lower + (upper - lower) / 2;
+      name = g_ptr_array_index (path_entry->completion_names, middle);
+      if (strncmp (name->key, key, key_length) == 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+  path_entry->completion_match_end = lower;
+
+  /* flag the new matches */
+  for (n = path_entry->completion_match_begin; n < path_entry->completion_match_end; ++n)
+    {
+      name = g_ptr_array_index (path_entry->completion_names, n);
+      path_entry->completion_matched[name->row] = TRUE;
+    }
+
+  g_free (key);
+}
+
+
+
 static void
 thunar_path_entry_common_prefix_append (ThunarPathEntry *path_entry,
                                         gboolean         highlight)
 {
-  const gchar *last_slash;
-  const gchar *text;
-  ThunarFile  *file;
-  gchar       *prefix;
-  gchar       *tmp;
-  gint         prefix_length;
-  gint         text_length;
-  gint         offset;
-  gint         base;
+  ThunarPathEntryName *name;
+  const gchar         *last_slash;
+  const gchar         *text;
+  gchar               *prefix;
+  gchar               *tmp;
+  gint                 prefix_length;
+  gint                 text_length;
+  gint                 offset;
+  gint                 base;
 
   /* determine the common prefix */
-  thunar_path_entry_common_prefix_lookup (path_entry, &prefix, &file);
+  thunar_path_entry_common_prefix_lookup (path_entry, &prefix, &name);
 
-  /* check if we should append a slash to the prefix */
-  if (G_LIKELY (file != NULL))
+  /* check if we should append a slash to the prefix, we only append slashes
+   * for directories and not if the name was entered completely already */
+  if (G_LIKELY (name != NULL && name->is_directory))
     {
-      /* we only append slashes for directories */
-      if (thunar_file_is_directory (file) && file != path_entry->current_file)
+      text = gtk_entry_get_text (GTK_ENTRY (path_entry));
+      last_slash = strrchr (text, G_DIR_SEPARATOR);
+      if (strcmp ((last_slash != NULL) ? last_slash + 1 : text, name->name) != 0)
         {
           tmp = g_strconcat (prefix, G_DIR_SEPARATOR_S, NULL);
           g_free (prefix);
           prefix = tmp;
         }
-
-      /* release the file */
-      g_object_unref (G_OBJECT (file));
     }
 
   /* check if we have a common prefix */
@@ -879,94 +1212,50 @@ thunar_path_entry_common_prefix_append (ThunarPathEntry *path_entry,
 
 
 
-static gboolean
-thunar_path_entry_has_prefix_casefolded (const gchar *string,
-                                         const gchar *prefix)
-{
-  gchar *string_casefolded;
-  gchar *prefix_casefolded;
-  gboolean has_prefix;
-
-  if (string == NULL || prefix == NULL)
-    return FALSE;
-
-  string_casefolded = g_utf8_casefold (string, -1);
-  prefix_casefolded = g_utf8_casefold (prefix, -1);
-
-  has_prefix = g_str_has_prefix (string_casefolded , prefix_casefolded);
-
-  g_free (string_casefolded);
-  g_free (prefix_casefolded);
-
-  return has_prefix;
-}
-
-
-
 static void
-thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
-                                        gchar          **prefix_return,
-                                        ThunarFile     **file_return)
+thunar_path_entry_common_prefix_lookup (ThunarPathEntry      *path_entry,
+                                        gchar               **prefix_return,
+                                        ThunarPathEntryName **name_return)
 {
-  GtkTreeModel *model;
-  GtkTreeIter   iter;
-  const gchar  *text;
-  const gchar  *s;
-  gchar        *name;
-  gchar        *t;
+  ThunarPathEntryName *name;
+  const gchar         *text;
+  const gchar         *s;
+  gchar               *t;
+  guint                n;
 
   *prefix_return = NULL;
-  *file_return = NULL;
+  *name_return = NULL;
 
   /* lookup the last slash character in the entry text */
   text = gtk_entry_get_text (GTK_ENTRY (path_entry));
   s = strrchr (text, G_DIR_SEPARATOR);
   if (G_UNLIKELY (s != NULL && s[1] == '\0'))
     return;
-  else if (G_LIKELY (s != NULL))
-    text = s + 1;
 
-  /* check all items in the model */
-  model = gtk_entry_completion_get_model (gtk_entry_get_completion (GTK_ENTRY (path_entry)));
-  if (gtk_tree_model_get_iter_first (model, &iter))
+  /* lookup the range of matching names */
+  thunar_path_entry_names_match (path_entry, text);
+
+  /* determine the common part of the matching names */
+  for (n = path_entry->completion_match_begin; n < path_entry->completion_match_end; ++n)
     {
-      do
-        {
-          /* determine the real file name for the iter */
-          gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
+      name = g_ptr_array_index (path_entry->completion_names, n);
 
-          /* check if we have a valid prefix here */
-          if (thunar_path_entry_has_prefix_casefolded (name, text))
-            {
-              /* check if we're the first to match */
-              if (*prefix_return == NULL)
-                {
-                  /* remember the prefix */
-                  *prefix_return = g_strdup (name);
-
-                  /* determine the file for the iter */
-                  gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE, file_return, -1);
-                }
-              else
-                {
-                  /* we already have another prefix, so determine the common part */
-                  for (s = name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
-                    ;
-                  *t = '\0';
-
-                  /* release the file, since it's not a unique match */
-                  if (G_LIKELY (*file_return != NULL))
-                    {
-                      g_object_unref (G_OBJECT (*file_return));
-                      *file_return = NULL;
-                    }
-                }
-            }
+      /* check if we're the first to match */
+      if (*prefix_return == NULL)
+        {
+          *prefix_return = g_strdup (name->name);
+          *name_return = name;
+        }
+      else
+        {
+          /* we already have another prefix, so determine the common part */
+          for (s = name->name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
+            ;
+          *t = '\0';
 
-          /* cleanup */
-          g_free (name);
+          /* it's not a unique match */
+          *name_return = NULL;
         }
-      while (gtk_tree_model_iter_next (model, &iter));
     }
 }
 
@@ -980,17 +1269,14 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
 {
   GtkTreeModel    *model;
   ThunarPathEntry *path_entry;
-  const gchar     *last_slash;
-  ThunarFile      *file;
+  const gchar     *text;
   gboolean         matched;
-  gchar           *text_normalized;
-  gchar           *name_normalized;
-  gchar           *name;
+  guint            row;
 
   /* determine the model from the completion */
   model = gtk_entry_completion_get_model (completion);
 
-  /* leave if the model is null, we do this in thunar_path_entry_changed() to speed
+  /* leave if the model is null, we do this in thunar_path_entry_names_ready() to speed
    * things up, but that causes https://bugzilla.xfce.org/show_bug.cgi?id=4847. */
   if (G_UNLIKELY (model == NULL))
     return FALSE;
@@ -1001,46 +1287,23 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
   if (G_UNLIKELY (path_entry->has_completion))
     return FALSE;
 
-  /* determine the current text (UTF-8 normalized) */
-  text_normalized = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (user_data)), -1, G_NORMALIZE_ALL);
-
-  /* lookup the last slash character in the key */
-  last_slash = strrchr (text_normalized, G_DIR_SEPARATOR);
-  if (G_UNLIKELY (last_slash != NULL && last_slash[1] == '\0'))
+  /* the function is called for every row, so the matching
+   * range is only looked up again if the text changed */
+  text = gtk_entry_get_text (GTK_ENTRY (path_entry));
+  if (G_UNLIKELY (g_str_has_suffix (text, G_DIR_SEPARATOR_S)))
     {
       /* check if the file is hidden */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
-      matched = !thunar_file_is_hidden (file);
-      g_object_unref (G_OBJECT (file));
+      gtk_tree_model_get (model, iter, COMPLETION_COLUMN_IS_HIDDEN, &matched, -1);
+      matched = !matched;
     }
   else
     {
-      if (G_UNLIKELY (last_slash == NULL))
-        last_slash = text_normalized;
-      else
-        last_slash += 1;
-
-      /* determine the real file name for the iter */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-      name_normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
-      if (G_LIKELY (name_normalized != NULL))
-        g_free (name);
-      else
-        name_normalized = name;
-
-      /* check if we have a match here */
-      if (name_normalized != NULL)
-        matched = thunar_path_entry_has_prefix_casefolded (name_normalized, last_slash);
-      else
-        matched = FALSE;
+      thunar_path_entry_names_match (path_entry, text);
 
-      /* cleanup */
-      g_free (name_normalized);
+      gtk_tree_model_get (model, iter, COMPLETION_COLUMN_ROW, &row, -1);
+      matched = (path_entry->completion_matched != NULL && path_entry->completion_matched[row]);
     }
 
-  /* cleanup */
-  g_free (text_normalized);
-
   return matched;
 }
 
@@ -1055,19 +1318,19 @@ thunar_path_entry_match_selected (GtkEntryCompletion *completion,
   ThunarPathEntry *path_entry = THUNAR_PATH_ENTRY (user_data);
   const gchar     *last_slash;
   const gchar     *text;
-  ThunarFile      *file;
+  gboolean         is_directory;
   gchar           *real_name;
   gchar           *tmp;
   gint             offset;
 
-  /* determine the file for the iterator */
-  gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
-
   /* determine the real name for the file */
-  gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE_NAME, &real_name, -1);
+  gtk_tree_model_get (model, iter,
+                      COMPLETION_COLUMN_NAME, &real_name,
+                      COMPLETION_COLUMN_IS_DIRECTORY, &is_directory,
+                      -1);
 
   /* append a slash if we have a folder here */
-  if (G_LIKELY (thunar_file_is_directory (file)))
+  if (G_LIKELY (is_directory))
     {
       tmp = g_strconcat (real_name, G_DIR_SEPARATOR_S, NULL);
       g_free (real_name);
@@ -1092,7 +1355,6 @@ thunar_path_entry_match_selected (GtkEntryCompletion *completion,
   gtk_editable_set_position (GTK_EDITABLE (path_entry), -1);
 
   /* cleanup */
-  g_object_unref (G_OBJECT (file));
   g_free (real_name);
 
   return TRUE;
@@ -733,7 +733,7 @@ thunar_permissions_chooser_change_group (ThunarPermissionsChooser *chooser,
   /* try to allocate the new job */
   file_list = thunar_permissions_chooser_get_file_list (chooser);
   job = thunar_io_jobs_change_group (file_list, gid, recursive);
-  exo_job_launch (EXO_JOB (job));
+  thunar_job_launch (THUNAR_JOB (job));
   thunar_permissions_chooser_job_start (chooser, job, recursive);
   g_list_free_full (file_list, g_object_unref);
   g_object_unref (job);
@@ -779,7 +779,7 @@ thunar_permissions_chooser_change_mode (ThunarPermissionsChooser *chooser,
   /* try to allocate the new job */
   file_list = thunar_permissions_chooser_get_file_list (chooser);
   job = thunar_io_jobs_change_mode (file_list, dir_mask, dir_mode, file_mask, file_mode, recursive);
-  exo_job_launch (EXO_JOB (job));
+  thunar_job_launch (THUNAR_JOB (job));
   thunar_permissions_chooser_job_start (chooser, job, recursive);
   g_list_free_full (file_list, g_object_unref);
   g_object_unref (job);
@@ -929,6 +929,11 @@ thunar_permissions_chooser_file_changed (ThunarPermissionsChooser *chooser)
         }
 
       n_files++;
+
+      /* the remaining files can't change anything once everything is mixed */
+      if (n_files > 1 && user == NULL && group == NULL
+          && modes[0] == 4 && modes[1] == 4 && modes[2] == 4)
+        break;
     }
 
   file = THUNAR_FILE (chooser->files->data);
@@ -1200,7 +1205,7 @@ thunar_permissions_chooser_fixperm_clicked (ThunarPermissionsChooser *chooser,
           /* try to allocate the new job */
           job = thunar_io_jobs_change_mode (&file_list,
                                             0511, mode, 0000, 0000, FALSE);
-          exo_job_launch (EXO_JOB (job));
+          thunar_job_launch (THUNAR_JOB (job));
 
           /* handle the job */
           thunar_permissions_chooser_job_start (chooser, job, FALSE);
@@ -191,6 +191,28 @@ transform_uint64_to_string (GBinding     *binding,
 
 
 
+static gboolean
+transform_strv_to_folder_list (GBinding     *binding,
+                               const GValue *src_value,
+                               GValue       *dst_value,
+                               gpointer      user_data)
+{
+  gchar **roots = g_value_get_boxed (src_value);
+  gchar  *string;
+
+  if (roots == NULL || roots[0] == NULL)
+    {
+      g_value_set_string (dst_value, _("None"));
+      return TRUE;
+    }
+
+  string = g_strjoinv ("\n", roots);
+  g_value_take_string (dst_value, string);
+  return TRUE;
+}
+
+
+
 static void
 thunar_preferences_dialog_class_init (ThunarPreferencesDialogClass *klass)
 {
@@ -241,6 +263,7 @@ thunar_preferences_dialog_init (ThunarPreferencesDialog *dialog)
   GtkWidget      *ibox;
   GtkWidget      *vbox;
   GtkWidget      *infobar;
+  GtkWidget      *roots;
   GEnumClass     *type;
   gchar          *date;
   gint            row = 0;
@@ -1168,6 +1191,48 @@ thunar_preferences_dialog_init (ThunarPreferencesDialog *dialog)
   gtk_label_set_mnemonic_widget (GTK_LABEL (label), combo);
   gtk_widget_show (combo);
 
+  /* next row */
+  row++;
+
+  label = gtk_label_new (_("Indexed folders:"));
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0f);
+  gtk_widget_set_valign (label, GTK_ALIGN_START);
+  gtk_grid_attach (GTK_GRID (grid), label, 0, row, 1, 1);
+  gtk_widget_show (label);
+
+  /* the folders are set in the misc-search-index-roots preference */
+  roots = gtk_label_new (NULL);
+  gtk_label_set_xalign (GTK_LABEL (roots), 0.0f);
+  gtk_label_set_selectable (GTK_LABEL (roots), TRUE);
+  gtk_widget_set_tooltip_text (roots, _("Recursive searches inside these folders use a filename index "
+                                        "instead of reading all subfolders"));
+  g_object_bind_property_full (G_OBJECT (dialog->preferences),
+                               "misc-search-index-roots",
+                               G_OBJECT (roots),
+                               "label",
+                               G_BINDING_SYNC_CREATE,
+                               transform_strv_to_folder_list,
+                               NULL, NULL, NULL);
+  gtk_widget_set_hexpand (roots, TRUE);
+  gtk_grid_attach (GTK_GRID (grid), roots, 1, row, 1, 1);
+  thunar_gtk_label_set_a11y_relation (GTK_LABEL (label), roots);
+  gtk_widget_show (roots);
+
+  /* next row */
+  row++;
+
+  button = gtk_check_button_new_with_mnemonic (_("Search file _contents"));
+  g_object_bind_property (G_OBJECT (dialog->preferences),
+                          "misc-search-contents",
+                          G_OBJECT (button),
+                          "active",
+                          G_BINDING_BIDIRECTIONAL | G_BINDING_SYNC_CREATE);
+  gtk_widget_set_tooltip_text (button,
+                               _("Select this option to also find text files which contain the search terms"));
+  gtk_widget_set_hexpand (button, TRUE);
+  gtk_grid_attach (GTK_GRID (grid), button, 0, row, 2, 1);
+  gtk_widget_show (button);
+
   frame = g_object_new (GTK_TYPE_FRAME, "border-width", 0, "shadow-type", GTK_SHADOW_NONE, NULL);
   gtk_box_pack_start (GTK_BOX (vbox), frame, FALSE, TRUE, 0);
   gtk_widget_show (frame);
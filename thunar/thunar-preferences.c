@@ -85,16 +85,22 @@ enum
   PROP_MISC_ALWAYS_SHOW_TABS,
   PROP_MISC_VOLUME_MANAGEMENT,
   PROP_MISC_CASE_SENSITIVE,
+  PROP_MISC_DAEMON_PREBUILT_WINDOW,
   PROP_MISC_DATE_STYLE,
   PROP_MISC_DATE_CUSTOM_STYLE,
+  PROP_MISC_DETAILS_VIEW_FAST_LAYOUT,
   PROP_EXEC_SHELL_SCRIPTS_BY_DEFAULT,
   PROP_MISC_FOLDERS_FIRST,
   PROP_MISC_FOLDER_ITEM_COUNT,
+  PROP_MISC_FOLDER_KEEP_ALIVE_BUDGET,
+  PROP_MISC_FOLDER_PAGE_SIZE,
   PROP_MISC_FULL_PATH_IN_TAB_TITLE,
   PROP_MISC_FULL_PATH_IN_WINDOW_TITLE,
   PROP_MISC_HORIZONTAL_WHEEL_NAVIGATES,
+  PROP_MISC_ICON_VIEW_FAST_LAYOUT,
   PROP_MISC_IMAGE_SIZE_IN_STATUSBAR,
   PROP_MISC_MIDDLE_CLICK_IN_TAB,
+  PROP_MISC_NETWORK_DISCOVERY_TTL,
   PROP_MISC_OPEN_NEW_WINDOW_AS_TAB,
   PROP_MISC_RECURSIVE_PERMISSIONS,
   PROP_MISC_RECURSIVE_SEARCH,
@@ -103,6 +109,7 @@ enum
   PROP_MISC_SHOW_DELETE_ACTION,
   PROP_MISC_SINGLE_CLICK,
   PROP_MISC_SINGLE_CLICK_TIMEOUT,
+  PROP_MISC_SLOW_CALLBACK_THRESHOLD,
   PROP_MISC_SMALL_TOOLBAR_ICONS,
   PROP_MISC_TAB_CLOSE_MIDDLE_CLICK,
   PROP_MISC_TEXT_BESIDE_ICONS,
@@ -116,6 +123,10 @@ enum
   PROP_MISC_WINDOW_ICON,
   PROP_MISC_TRANSFER_USE_PARTIAL,
   PROP_MISC_TRANSFER_VERIFY_FILE,
+  PROP_MISC_TRANSFER_CONFLICT_POLICY,
+  PROP_MISC_TRANSFER_VERIFY_FAST_CHECKSUM,
+  PROP_MISC_TRANSFER_RESUME_PARTIAL,
+  PROP_MISC_TRANSFER_PARALLEL_STREAMS,
   PROP_MISC_IMAGE_PREVIEW_FULL,
   PROP_SHORTCUTS_ICON_EMBLEMS,
   PROP_SHORTCUTS_ICON_SIZE,
@@ -128,6 +139,16 @@ enum
   PROP_MISC_HIGHLIGHTING_ENABLED,
   PROP_MISC_UNDO_REDO_HISTORY_SIZE,
   PROP_MISC_MAX_NUMBER_OF_TEMPLATES,
+  PROP_MISC_FOLDER_MONITOR_INTERVAL,
+  PROP_MISC_FILE_WATCH_BUDGET,
+  PROP_MISC_SEARCH_INDEX_ROOTS,
+  PROP_MISC_SEARCH_BACKENDS,
+  PROP_MISC_SEARCH_CONTENTS,
+  PROP_MISC_SEARCH_PRUNE_PATTERNS,
+  PROP_MISC_SEARCH_PRUNE_OVERRIDES,
+  PROP_MISC_SEARCH_MAX_DEPTH,
+  PROP_MISC_SEARCH_MAX_RESULTS,
+  PROP_MISC_SEARCH_FUZZY,
   N_PROPERTIES,
 };
 
@@ -147,6 +168,9 @@ static void     thunar_preferences_prop_changed       (XfconfChannel          *c
                                                        const GValue           *value,
                                                        ThunarPreferences      *preferences);
 static void     thunar_preferences_load_rc_file       (ThunarPreferences      *preferences);
+static void     thunar_preferences_update_snapshot    (ThunarPreferences      *preferences,
+                                                       GParamSpec             *pspec);
+static gboolean thunar_preferences_flush_timeout      (gpointer                user_data);
 
 
 
@@ -162,6 +186,10 @@ struct _ThunarPreferences
   XfconfChannel *channel;
 
   gulong         property_changed_id;
+
+  /* view state written behind, the property names mapped to their GValues */
+  GHashTable    *pending_writes;
+  guint          flush_source_id;
 };
 
 
@@ -169,6 +197,14 @@ struct _ThunarPreferences
 /* don't do anything in case xfconf_init() failed */
 static gboolean no_xfconf = FALSE;
 
+/* the published snapshot, and the time a replaced snapshot is kept
+ * for the threads which still read it */
+static ThunarPreferencesSnapshot *preferences_snapshot = NULL;
+#define THUNAR_PREFERENCES_SNAPSHOT_GRACE (10) /* s */
+
+/* the quiet period after which the view state is written to xfconf */
+#define THUNAR_PREFERENCES_FLUSH_DELAY (500) /* ms */
+
 
 
 G_DEFINE_TYPE (ThunarPreferences, thunar_preferences, G_TYPE_OBJECT)
@@ -636,6 +672,19 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-daemon-prebuilt-window:
+   *
+   * Whether a daemon keeps one hidden window built in advance, so
+   * that opening a new window only has to load the folder.
+   **/
+  preferences_props[PROP_MISC_DAEMON_PREBUILT_WINDOW] =
+      g_param_spec_boolean ("misc-daemon-prebuilt-window",
+                            "MiscDaemonPrebuiltWindow",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-date-style:
    *
@@ -661,6 +710,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                            "%Y-%m-%d %H:%M:%S",
                            EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-details-view-fast-layout:
+   *
+   * Whether the details view switches to rows of a fixed height and
+   * columns sized from a sample of rows for very large folders, instead
+   * of measuring every single row.
+   **/
+  preferences_props[PROP_MISC_DETAILS_VIEW_FAST_LAYOUT] =
+      g_param_spec_boolean ("misc-details-view-fast-layout",
+                            "MiscDetailsViewFastLayout",
+                            NULL,
+                            TRUE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-execute-shell-scripts-by-default:
    *
@@ -702,6 +765,37 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                          THUNAR_FOLDER_ITEM_COUNT_NEVER,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-folder-keep-alive-budget:
+   *
+   * The memory in MiB which folders that are no longer shown may
+   * keep, so they are not listed again when they are reopened.
+   * The memory is estimated from the number of files. Set to 0
+   * to release folders as soon as they are no longer shown.
+   **/
+  preferences_props[PROP_MISC_FOLDER_KEEP_ALIVE_BUDGET] =
+      g_param_spec_uint ("misc-folder-keep-alive-budget",
+                         "MiscFolderKeepAliveBudget",
+                         NULL,
+                         0, G_MAXUINT, 128,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-folder-page-size:
+   *
+   * The number of files which are listed at first when a folder is
+   * opened. Folders with more files are listed further in pages of
+   * this size while the view is scrolled to their end, so huge folders
+   * don't have to be read and kept completely. Set to 0 to always
+   * list folders completely.
+   **/
+  preferences_props[PROP_MISC_FOLDER_PAGE_SIZE] =
+      g_param_spec_uint ("misc-folder-page-size",
+                         "MiscFolderPageSize",
+                         NULL,
+                         0, G_MAXUINT, 0,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-full-path-in-tab-title:
    *
@@ -741,6 +835,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-icon-view-fast-layout:
+   *
+   * Whether the icon and compact views give every item the same size
+   * for very large folders, instead of measuring the name of every
+   * single item. Names longer than the item are cut off.
+   **/
+  preferences_props[PROP_MISC_ICON_VIEW_FAST_LAYOUT] =
+      g_param_spec_boolean ("misc-icon-view-fast-layout",
+                            "MiscIconViewFastLayout",
+                            NULL,
+                            TRUE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-image-size-in-statusbar:
    *
@@ -767,6 +875,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-network-discovery-ttl:
+   *
+   * The time in seconds for which the last listing of network:/// and
+   * of SMB workgroups and hosts is shown without asking the network
+   * again. An older listing is still shown while it is refreshed.
+   **/
+  preferences_props[PROP_MISC_NETWORK_DISCOVERY_TTL] =
+      g_param_spec_uint ("misc-network-discovery-ttl",
+                         "MiscNetworkDiscoveryTtl",
+                         NULL,
+                         0, G_MAXUINT, 300,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-open-new-window-as_tab:
    *
@@ -876,6 +998,21 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                          0u, G_MAXUINT, 500u,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-slow-callback-threshold:
+   *
+   * Main loop callbacks which take longer than this many milliseconds
+   * are remembered with their duration and workload, and can be read
+   * for bug reports with GetSlowCallbacks on the org.xfce.Thunar.Debug
+   * D-Bus interface. A value of %0 disables the watchdog.
+   **/
+  preferences_props[PROP_MISC_SLOW_CALLBACK_THRESHOLD] =
+      g_param_spec_uint ("misc-slow-callback-threshold",
+                         "MiscSlowCallbackThreshold",
+                         NULL,
+                         0u, G_MAXUINT, 0u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-small-toolbar-icons:
    *
@@ -1017,6 +1154,70 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                        THUNAR_VERIFY_FILE_MODE_DISABLED,
                        EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-transfer-conflict-policy:
+   *
+   * How a copy handles files whose target already exists. With any
+   * policy but asking, the existing files of every target folder are
+   * listed once and the conflicts are settled without trying to write
+   * to the existing targets first.
+   *
+   * Skipping identical files turns a repeated copy into an incremental
+   * one: targets with the same size and modification time are kept,
+   * confirmed by comparing samples of their contents if copies are
+   * verified, see #ThunarPreferences:misc-transfer-verify-file.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_CONFLICT_POLICY] =
+    g_param_spec_enum ("misc-transfer-conflict-policy",
+                       "MiscTransferConflictPolicy",
+                       NULL,
+                       THUNAR_TYPE_TRANSFER_CONFLICT_POLICY,
+                       THUNAR_TRANSFER_CONFLICT_POLICY_ASK,
+                       EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-verify-fast-checksum:
+   *
+   * Whether copied files are verified with MD5 instead of SHA-512. MD5
+   * is fast enough to keep up with local disks and still catches any
+   * corruption during the copy, but it does not protect against tampering.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_VERIFY_FAST_CHECKSUM] =
+    g_param_spec_boolean ("misc-transfer-verify-fast-checksum",
+                          "MiscTransferVerifyFastChecksum",
+                          NULL,
+                          FALSE,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-resume-partial:
+   *
+   * Whether an interrupted copy keeps its *.partial~ file, so copying the
+   * same file again continues where it stopped instead of starting over.
+   * Only used when *.partial~ files are used, see misc-transfer-use-partial.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_RESUME_PARTIAL] =
+    g_param_spec_boolean ("misc-transfer-resume-partial",
+                          "MiscTransferResumePartial",
+                          NULL,
+                          FALSE,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-transfer-parallel-streams:
+   *
+   * The number of ranges of a file of a gigabyte or more which are written
+   * at once when it is copied to an NFS, SMB or Ceph mount, 1 to copy it in
+   * a single stream. Several requests in flight can use the bandwidth of a
+   * file server that a single stream can't fill because of the round trips.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_PARALLEL_STREAMS] =
+      g_param_spec_uint ("misc-transfer-parallel-streams",
+                         "MiscTransferParallelStreams",
+                         NULL,
+                         1, 16, 1,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-image-preview-mode:
    *
@@ -1205,17 +1406,179 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                          100,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-folder-monitor-interval
+   *
+   * Time in milliseconds for which file monitor events of a folder
+   * are collected before they are merged and applied in one batch.
+   * A value of %0 applies each event immediately.
+   **/
+  preferences_props[PROP_MISC_FOLDER_MONITOR_INTERVAL] =
+      g_param_spec_uint ("misc-folder-monitor-interval",
+                         "MiscFolderMonitorInterval",
+                         NULL,
+                         0, 1000,
+                         80,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-file-watch-budget
+   *
+   * Maximum number of file monitors used for watched files, e.g. by the
+   * location bar, the side pane and properties dialogs. The least recently
+   * watched files beyond it are polled instead. A value of %0 derives the
+   * budget from the inotify watch limit of the system.
+   **/
+  preferences_props[PROP_MISC_FILE_WATCH_BUDGET] =
+      g_param_spec_uint ("misc-file-watch-budget",
+                         "MiscFileWatchBudget",
+                         NULL,
+                         0, G_MAXUINT,
+                         0,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-index-roots
+   *
+   * List of local folders (paths or file URIs) for which a filename
+   * index is kept in the cache directory. Recursive searches inside
+   * these folders use the index instead of reading the whole tree.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX_ROOTS] =
+      g_param_spec_boxed ("misc-search-index-roots",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-backends
+   *
+   * Ordered list of the backends which may answer a recursive search
+   * by file name without reading the folders: "index" for the index of
+   * the misc-search-index-roots, "locate" for the plocate or mlocate
+   * database. The folders are read if no backend covers the searched
+   * folder. If unset, only "index" is used.
+   **/
+  preferences_props[PROP_MISC_SEARCH_BACKENDS] =
+      g_param_spec_boxed ("misc-search-backends",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-contents
+   *
+   * Whether searches also list the text files which contain all the
+   * search terms, in addition to the files with matching names.
+   **/
+  preferences_props[PROP_MISC_SEARCH_CONTENTS] =
+      g_param_spec_boolean ("misc-search-contents",
+                            "MiscSearchContents",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-prune-patterns
+   *
+   * Glob patterns for the names of folders which a recursive search
+   * does not descend into, like version control or build directories.
+   * The folders themselves are still matched against the search terms.
+   * If unset, the metadata folders of version control systems,
+   * node_modules and __pycache__ are pruned, a list with a single empty
+   * pattern disables pruning.
+   **/
+  preferences_props[PROP_MISC_SEARCH_PRUNE_PATTERNS] =
+      g_param_spec_boxed ("misc-search-prune-patterns",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-prune-overrides
+   *
+   * Replaces the misc-search-prune-patterns for searches inside
+   * specific folders. Each entry has the form "folder=pattern;pattern",
+   * with the folder given as a path or URI. An entry without patterns
+   * disables pruning inside its folder. The innermost folder wins.
+   **/
+  preferences_props[PROP_MISC_SEARCH_PRUNE_OVERRIDES] =
+      g_param_spec_boxed ("misc-search-prune-overrides",
+                          NULL,
+                          NULL,
+                          G_TYPE_STRV,
+                          EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-max-depth
+   *
+   * Number of folder levels below the current folder which are
+   * searched by a recursive search, %0 for no limit.
+   **/
+  preferences_props[PROP_MISC_SEARCH_MAX_DEPTH] =
+      g_param_spec_uint ("misc-search-max-depth",
+                         "MiscSearchMaxDepth",
+                         NULL,
+                         0, G_MAXUINT,
+                         0,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-max-results
+   *
+   * Number of results after which a recursive search stops walking
+   * the folders, %0 for no limit.
+   **/
+  preferences_props[PROP_MISC_SEARCH_MAX_RESULTS] =
+      g_param_spec_uint ("misc-search-max-results",
+                         "MiscSearchMaxResults",
+                         NULL,
+                         0, G_MAXUINT,
+                         0,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-fuzzy
+   *
+   * Whether the search terms match names which contain their letters
+   * in order, not only in one piece. The results are ranked, names
+   * matching in fewer and earlier pieces first, and a recursive search
+   * with misc-search-max-results keeps the best results instead of
+   * stopping at the first ones.
+   **/
+  preferences_props[PROP_MISC_SEARCH_FUZZY] =
+      g_param_spec_boolean ("misc-search-fuzzy",
+                            "MiscSearchFuzzy",
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
   /* install all properties */
   g_object_class_install_properties (gobject_class, N_PROPERTIES, preferences_props);
 }
 
 
 
+static void
+thunar_preferences_value_free (gpointer data)
+{
+  g_value_unset (data);
+  g_slice_free (GValue, data);
+}
+
+
+
 static void
 thunar_preferences_init (ThunarPreferences *preferences)
 {
   const gchar check_prop[] = "/last-view";
 
+  preferences->pending_writes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, thunar_preferences_value_free);
+  preferences->flush_source_id = 0;
+
   /* don't set a channel if xfconf init failed */
   if (no_xfconf)
     return;
@@ -1237,6 +1600,8 @@ thunar_preferences_init (ThunarPreferences *preferences)
   preferences->property_changed_id =
     g_signal_connect (G_OBJECT (preferences->channel), "property-changed",
                       G_CALLBACK (thunar_preferences_prop_changed), preferences);
+
+  thunar_preferences_update_snapshot (preferences, NULL);
 }
 
 
@@ -1246,8 +1611,13 @@ thunar_preferences_finalize (GObject *object)
 {
   ThunarPreferences *preferences = THUNAR_PREFERENCES (object);
 
+  /* write the pending view state */
+  thunar_preferences_flush (preferences);
+  g_hash_table_destroy (preferences->pending_writes);
+
   /* disconnect from the updates */
-  g_signal_handler_disconnect (preferences->channel, preferences->property_changed_id);
+  if (preferences->channel != NULL)
+    g_signal_handler_disconnect (preferences->channel, preferences->property_changed_id);
 
   (*G_OBJECT_CLASS (thunar_preferences_parent_class)->finalize) (object);
 }
@@ -1262,6 +1632,7 @@ thunar_preferences_get_property (GObject    *object,
 {
   ThunarPreferences  *preferences = THUNAR_PREFERENCES (object);
   GValue              src = { 0, };
+  GValue             *pending;
   gchar               prop_name[64];
   gchar             **array;
 
@@ -1275,7 +1646,11 @@ thunar_preferences_get_property (GObject    *object,
   /* build property name */
   g_snprintf (prop_name, sizeof (prop_name), "/%s", g_param_spec_get_name (pspec));
 
-  if (G_VALUE_TYPE (value) == G_TYPE_STRV)
+  /* a value not written yet is the current one */
+  pending = g_hash_table_lookup (preferences->pending_writes, prop_name);
+  if (G_UNLIKELY (pending != NULL))
+    g_value_copy (pending, value);
+  else if (G_VALUE_TYPE (value) == G_TYPE_STRV)
     {
       /* handle arrays directly since we cannot transform those */
       array = xfconf_channel_get_string_list (preferences->channel, prop_name);
@@ -1299,22 +1674,12 @@ thunar_preferences_get_property (GObject    *object,
 
 
 static void
-thunar_preferences_set_property (GObject      *object,
-                                 guint         prop_id,
-                                 const GValue *value,
-                                 GParamSpec   *pspec)
+thunar_preferences_store (ThunarPreferences *preferences,
+                          const gchar       *prop_name,
+                          const GValue      *value)
 {
-  ThunarPreferences  *preferences = THUNAR_PREFERENCES (object);
-  GValue              dst = { 0, };
-  gchar               prop_name[64];
-  gchar             **array;
-
-  /* leave if the channel is not set */
-  if (G_UNLIKELY (preferences->channel == NULL))
-    return;
-
-  /* build property name */
-  g_snprintf (prop_name, sizeof (prop_name), "/%s", g_param_spec_get_name (pspec));
+  GValue   dst = { 0, };
+  gchar  **array;
 
   /* freeze */
   g_signal_handler_block (preferences->channel, preferences->property_changed_id);
@@ -1348,6 +1713,60 @@ thunar_preferences_set_property (GObject      *object,
 
 
 
+static void
+thunar_preferences_set_property (GObject      *object,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  ThunarPreferences *preferences = THUNAR_PREFERENCES (object);
+  GValue            *pending;
+  gchar              prop_name[64];
+
+  /* leave if the channel is not set */
+  if (G_UNLIKELY (preferences->channel == NULL))
+    return;
+
+  /* build property name */
+  g_snprintf (prop_name, sizeof (prop_name), "/%s", g_param_spec_get_name (pspec));
+
+  /* the view state (column widths, pane positions, zoom levels, window sizes...)
+   * changes many times while the user drags, so only the last value is
+   * written once things calm down, instead of a D-Bus call for each step */
+  if (g_str_has_prefix (prop_name, "/last-"))
+    {
+      pending = g_slice_new0 (GValue);
+      g_value_init (pending, G_VALUE_TYPE (value));
+      g_value_copy (value, pending);
+      g_hash_table_replace (preferences->pending_writes, g_strdup (prop_name), pending);
+
+      if (preferences->flush_source_id != 0)
+        g_source_remove (preferences->flush_source_id);
+      preferences->flush_source_id = g_timeout_add (THUNAR_PREFERENCES_FLUSH_DELAY, thunar_preferences_flush_timeout, preferences);
+    }
+  else
+    {
+      thunar_preferences_store (preferences, prop_name, value);
+    }
+
+  thunar_preferences_update_snapshot (preferences, pspec);
+}
+
+
+
+static gboolean
+thunar_preferences_flush_timeout (gpointer user_data)
+{
+  ThunarPreferences *preferences = THUNAR_PREFERENCES (user_data);
+
+  preferences->flush_source_id = 0;
+  thunar_preferences_flush (preferences);
+
+  return FALSE;
+}
+
+
+
 static void
 thunar_preferences_prop_changed (XfconfChannel     *channel,
                                  const gchar       *prop_name,
@@ -1356,10 +1775,84 @@ thunar_preferences_prop_changed (XfconfChannel     *channel,
 {
   GParamSpec *pspec;
 
+  /* a change from outside replaces the one we did not write yet */
+  g_hash_table_remove (preferences->pending_writes, prop_name);
+
   /* check if the property exists and emit change */
   pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (preferences), prop_name + 1);
   if (G_LIKELY (pspec != NULL))
-    g_object_notify_by_pspec (G_OBJECT (preferences), pspec);
+    {
+      thunar_preferences_update_snapshot (preferences, pspec);
+      g_object_notify_by_pspec (G_OBJECT (preferences), pspec);
+    }
+}
+
+
+
+static gboolean
+thunar_preferences_free_snapshot (gpointer user_data)
+{
+  ThunarPreferencesSnapshot *snapshot = user_data;
+
+  g_strfreev (snapshot->misc_search_index_roots);
+  g_strfreev (snapshot->misc_search_backends);
+  g_strfreev (snapshot->misc_search_prune_patterns);
+  g_strfreev (snapshot->misc_search_prune_overrides);
+  g_slice_free (ThunarPreferencesSnapshot, snapshot);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_preferences_update_snapshot (ThunarPreferences *preferences,
+                                    GParamSpec        *pspec)
+{
+  ThunarPreferencesSnapshot *snapshot;
+  ThunarPreferencesSnapshot *old_snapshot;
+
+  /* only rebuild for the properties in the snapshot, or initially */
+  if (pspec != NULL
+      && pspec != preferences_props[PROP_LAST_SHOW_HIDDEN]
+      && pspec != preferences_props[PROP_EXEC_SHELL_SCRIPTS_BY_DEFAULT]
+      && pspec != preferences_props[PROP_MISC_IMAGE_SIZE_IN_STATUSBAR]
+      && pspec != preferences_props[PROP_MISC_RECURSIVE_SEARCH]
+      && pspec != preferences_props[PROP_MISC_SEARCH_CONTENTS]
+      && pspec != preferences_props[PROP_MISC_SEARCH_INDEX_ROOTS]
+      && pspec != preferences_props[PROP_MISC_SEARCH_BACKENDS]
+      && pspec != preferences_props[PROP_MISC_SEARCH_PRUNE_PATTERNS]
+      && pspec != preferences_props[PROP_MISC_SEARCH_PRUNE_OVERRIDES]
+      && pspec != preferences_props[PROP_MISC_SEARCH_MAX_DEPTH]
+      && pspec != preferences_props[PROP_MISC_SEARCH_MAX_RESULTS]
+      && pspec != preferences_props[PROP_MISC_SEARCH_FUZZY]
+      && pspec != preferences_props[PROP_MISC_STATUS_BAR_ACTIVE_INFO])
+    return;
+
+  snapshot = g_slice_new0 (ThunarPreferencesSnapshot);
+  g_object_get (G_OBJECT (preferences),
+                "last-show-hidden", &snapshot->last_show_hidden,
+                "misc-exec-shell-scripts-by-default", &snapshot->misc_exec_shell_scripts_by_default,
+                "misc-image-size-in-statusbar", &snapshot->misc_image_size_in_statusbar,
+                "misc-recursive-search", &snapshot->misc_recursive_search,
+                "misc-search-contents", &snapshot->misc_search_contents,
+                "misc-search-index-roots", &snapshot->misc_search_index_roots,
+                "misc-search-backends", &snapshot->misc_search_backends,
+                "misc-search-prune-patterns", &snapshot->misc_search_prune_patterns,
+                "misc-search-prune-overrides", &snapshot->misc_search_prune_overrides,
+                "misc-search-max-depth", &snapshot->misc_search_max_depth,
+                "misc-search-max-results", &snapshot->misc_search_max_results,
+                "misc-search-fuzzy", &snapshot->misc_search_fuzzy,
+                "misc-status-bar-active-info", &snapshot->misc_status_bar_active_info,
+                NULL);
+
+  /* publish the complete snapshot at once. Readers don't hold it across
+   * a return to the main loop or a blocking operation, so the old one is
+   * released after a generous grace period instead of being counted */
+  old_snapshot = g_atomic_pointer_get (&preferences_snapshot);
+  g_atomic_pointer_set (&preferences_snapshot, snapshot);
+  if (old_snapshot != NULL)
+    g_timeout_add_seconds (THUNAR_PREFERENCES_SNAPSHOT_GRACE, thunar_preferences_free_snapshot, old_snapshot);
 }
 
 
@@ -1491,3 +1984,78 @@ thunar_preferences_xfconf_init_failed (void)
 {
   no_xfconf = TRUE;
 }
+
+
+
+/**
+ * thunar_preferences_flush:
+ * @preferences : a #ThunarPreferences.
+ *
+ * Writes the view state, which is collected for a short while
+ * before it goes to xfconf, right away. Called at shutdown so
+ * the last changes are not lost.
+ **/
+void
+thunar_preferences_flush (ThunarPreferences *preferences)
+{
+  GHashTableIter  iter;
+  gpointer        prop_name;
+  gpointer        value;
+
+  _thunar_return_if_fail (THUNAR_IS_PREFERENCES (preferences));
+
+  if (preferences->flush_source_id != 0)
+    {
+      g_source_remove (preferences->flush_source_id);
+      preferences->flush_source_id = 0;
+    }
+
+  if (preferences->channel == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, preferences->pending_writes);
+  while (g_hash_table_iter_next (&iter, &prop_name, &value))
+    {
+      thunar_preferences_store (preferences, prop_name, value);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+
+
+/**
+ * thunar_preferences_get_snapshot:
+ *
+ * Returns the preferences used on hot paths as plain fields, without
+ * going through the property machinery and xfconf. The snapshot is
+ * replaced when one of its preferences changes, so read it again
+ * instead of keeping it, and copy the strings which are used after
+ * a return to the main loop or a blocking operation.
+ *
+ * This function is thread-safe. Before the first #ThunarPreferences
+ * is created, the snapshot holds the defaults.
+ *
+ * Return value: the current #ThunarPreferencesSnapshot.
+ **/
+const ThunarPreferencesSnapshot *
+thunar_preferences_get_snapshot (void)
+{
+  static const ThunarPreferencesSnapshot defaults =
+  {
+    FALSE,
+    FALSE,
+    FALSE,
+    THUNAR_RECURSIVE_SEARCH_ALWAYS,
+    FALSE,
+    NULL,
+    THUNAR_STATUS_BAR_INFO_DISPLAY_NAME | THUNAR_STATUS_BAR_INFO_FILETYPE | THUNAR_STATUS_BAR_INFO_SIZE
+    | THUNAR_STATUS_BAR_INFO_SIZE_IN_BYTES,
+  };
+  const ThunarPreferencesSnapshot *snapshot;
+
+  snapshot = g_atomic_pointer_get (&preferences_snapshot);
+  if (G_UNLIKELY (snapshot == NULL))
+    return &defaults;
+
+  return snapshot;
+}
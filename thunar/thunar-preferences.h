@@ -20,12 +20,13 @@
 #ifndef __THUNAR_PREFERENCES_H__
 #define __THUNAR_PREFERENCES_H__
 
-#include <glib-object.h>
+#include <thunar/thunar-enum-types.h>
 
 G_BEGIN_DECLS;
 
 typedef struct _ThunarPreferencesClass ThunarPreferencesClass;
 typedef struct _ThunarPreferences      ThunarPreferences;
+typedef struct _ThunarPreferencesSnapshot ThunarPreferencesSnapshot;
 
 #define THUNAR_TYPE_PREFERENCES             (thunar_preferences_get_type ())
 #define THUNAR_PREFERENCES(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_PREFERENCES, ThunarPreferences))
@@ -34,12 +35,40 @@ typedef struct _ThunarPreferences      ThunarPreferences;
 #define THUNAR_IS_PREFERENCES_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_PREFERENCES))
 #define THUNAR_PREFERENCES_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_PREFERENCES, ThunarPreferencesClass))
 
+/**
+ * ThunarPreferencesSnapshot:
+ *
+ * Plain copies of the preferences read on hot paths, see
+ * thunar_preferences_get_snapshot(). The fields are named after
+ * the properties of #ThunarPreferences.
+ **/
+struct _ThunarPreferencesSnapshot
+{
+  gboolean                   last_show_hidden;
+  gboolean                   misc_exec_shell_scripts_by_default;
+  gboolean                   misc_image_size_in_statusbar;
+  ThunarRecursiveSearchMode  misc_recursive_search;
+  gboolean                   misc_search_contents;
+  gchar                    **misc_search_index_roots;
+  gchar                    **misc_search_backends;
+  gchar                    **misc_search_prune_patterns;
+  gchar                    **misc_search_prune_overrides;
+  guint                      misc_search_max_depth;
+  guint                      misc_search_max_results;
+  gboolean                   misc_search_fuzzy;
+  guint                      misc_status_bar_active_info;
+};
+
 GType              thunar_preferences_get_type           (void) G_GNUC_CONST;
 
 ThunarPreferences *thunar_preferences_get                (void);
 
 void               thunar_preferences_xfconf_init_failed (void);
 
+void               thunar_preferences_flush              (ThunarPreferences *preferences);
+
+const ThunarPreferencesSnapshot *thunar_preferences_get_snapshot (void);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_PREFERENCES_H__ */
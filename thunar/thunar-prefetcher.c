@@ -0,0 +1,335 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-file.h>
+#include <thunar/thunar-folder.h>
+#include <thunar/thunar-prefetcher.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
+
+
+
+/**
+ * SECTION:thunar-prefetcher
+ * @Short_description: Loads the folders the user is likely to open next
+ * @Title: ThunarPrefetcher
+ *
+ * While the main loop is idle, the folders next to the current one in
+ * the history, its parent and a folder the pointer rests on are loaded
+ * and kept for a while. Opening one of them then finds the listing in
+ * the #ThunarFolder already, instead of waiting for it.
+ *
+ * To stay out of the way of the folders the user actually opens, only
+ * a single folder is loaded at a time, only local folders are loaded,
+ * and only a few loaded folders are kept, each for a limited time.
+ **/
+
+
+
+/* time (in ms) the pointer has to rest on a folder */
+#define THUNAR_PREFETCHER_HOVER_DELAY 400
+
+/* number of locations waiting to be loaded */
+#define THUNAR_PREFETCHER_QUEUE_MAX 8
+
+/* number of loaded folders kept, and the time (in s) they are kept */
+#define THUNAR_PREFETCHER_WARM_MAX     6
+#define THUNAR_PREFETCHER_WARM_TIMEOUT 60
+
+
+
+typedef struct
+{
+  ThunarFolder *folder;
+  gint64        time;
+} ThunarPrefetcherEntry;
+
+
+
+static void thunar_prefetcher_schedule (void);
+
+
+
+static GQueue        pending = G_QUEUE_INIT;  /* GFile, most recent first */
+static GQueue        warm = G_QUEUE_INIT;     /* ThunarPrefetcherEntry, most recent first */
+static gboolean      busy = FALSE;            /* a location is being loaded */
+static GFile        *hover_location = NULL;
+static guint         idle_id = 0;
+static guint         hover_id = 0;
+static guint         expire_id = 0;
+
+
+
+static gboolean
+thunar_prefetcher_is_warm (GFile *location)
+{
+  ThunarPrefetcherEntry *entry;
+  GList                 *lp;
+
+  for (lp = warm.head; lp != NULL; lp = lp->next)
+    {
+      entry = lp->data;
+      if (g_file_equal (thunar_file_get_file (thunar_folder_get_corresponding_file (entry->folder)), location))
+        {
+          /* seen again, keep it longer */
+          entry->time = g_get_monotonic_time ();
+          g_queue_unlink (&warm, lp);
+          g_queue_push_head_link (&warm, lp);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_prefetcher_entry_free (gpointer data)
+{
+  ThunarPrefetcherEntry *entry = data;
+
+  g_object_unref (entry->folder);
+  g_slice_free (ThunarPrefetcherEntry, entry);
+}
+
+
+
+static gboolean
+thunar_prefetcher_expire (gpointer user_data)
+{
+  ThunarPrefetcherEntry *entry;
+  gint64                 now = g_get_monotonic_time ();
+
+  /* the oldest entries are at the tail */
+  while ((entry = g_queue_peek_tail (&warm)) != NULL
+         && now - entry->time > (gint64) THUNAR_PREFETCHER_WARM_TIMEOUT * G_USEC_PER_SEC)
+    thunar_prefetcher_entry_free (g_queue_pop_tail (&warm));
+
+  if (g_queue_is_empty (&warm))
+    {
+      expire_id = 0;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_prefetcher_keep (ThunarFolder *folder)
+{
+  ThunarPrefetcherEntry *entry;
+
+  entry = g_slice_new0 (ThunarPrefetcherEntry);
+  entry->folder = g_object_ref (folder);
+  entry->time = g_get_monotonic_time ();
+  g_queue_push_head (&warm, entry);
+
+  while (warm.length > THUNAR_PREFETCHER_WARM_MAX)
+    thunar_prefetcher_entry_free (g_queue_pop_tail (&warm));
+
+  if (expire_id == 0)
+    expire_id = g_timeout_add_seconds (THUNAR_PREFETCHER_WARM_TIMEOUT / 4, thunar_prefetcher_expire, NULL);
+}
+
+
+
+static void
+thunar_prefetcher_done (void)
+{
+  busy = FALSE;
+
+  if (!g_queue_is_empty (&pending))
+    thunar_prefetcher_schedule ();
+}
+
+
+
+static void
+thunar_prefetcher_loading_changed (ThunarFolder *folder)
+{
+  if (thunar_folder_get_loading (folder))
+    return;
+
+  g_signal_handlers_disconnect_by_func (folder, thunar_prefetcher_loading_changed, NULL);
+
+  thunar_prefetcher_keep (folder);
+  g_object_unref (folder);
+
+  thunar_prefetcher_done ();
+}
+
+
+
+static void
+thunar_prefetcher_file_ready (GFile      *location,
+                              ThunarFile *file,
+                              GError     *error,
+                              gpointer    user_data)
+{
+  ThunarFolder *folder;
+
+  if (file == NULL || !thunar_file_is_directory (file))
+    {
+      thunar_prefetcher_done ();
+      return;
+    }
+
+  /* an already loaded folder is just kept, a new one is loaded */
+  folder = thunar_folder_get_for_file (file);
+  if (thunar_folder_get_loading (folder))
+    {
+      thunar_stats_count (THUNAR_STATS_FOLDER_PREFETCH);
+
+      /* the folder is kept once it is loaded */
+      g_signal_connect (G_OBJECT (folder), "notify::loading", G_CALLBACK (thunar_prefetcher_loading_changed), NULL);
+      return;
+    }
+
+  thunar_prefetcher_keep (folder);
+  g_object_unref (folder);
+
+  thunar_prefetcher_done ();
+}
+
+
+
+static gboolean
+thunar_prefetcher_idle (gpointer user_data)
+{
+  GFile *location;
+
+  idle_id = 0;
+
+  if (busy)
+    return FALSE;
+
+  /* skip what is kept already */
+  while ((location = g_queue_pop_head (&pending)) != NULL)
+    {
+      if (!thunar_prefetcher_is_warm (location))
+        break;
+      g_object_unref (location);
+    }
+
+  if (location == NULL)
+    return FALSE;
+
+  busy = TRUE;
+  thunar_file_get_async (location, NULL, thunar_prefetcher_file_ready, NULL);
+  g_object_unref (location);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_prefetcher_schedule (void)
+{
+  if (idle_id == 0 && !busy)
+    idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_prefetcher_idle, NULL, NULL);
+}
+
+
+
+/**
+ * thunar_prefetcher_queue:
+ * @location : the #GFile of a folder.
+ *
+ * Queues loading the folder at @location once the main loop is idle, as
+ * it is likely to be opened soon. Only local folders are loaded.
+ **/
+void
+thunar_prefetcher_queue (GFile *location)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (G_IS_FILE (location));
+
+  if (!g_file_has_uri_scheme (location, "file"))
+    return;
+
+  /* move the location to the front if queued already */
+  for (lp = pending.head; lp != NULL; lp = lp->next)
+    if (g_file_equal (lp->data, location))
+      {
+        g_queue_unlink (&pending, lp);
+        g_queue_push_head_link (&pending, lp);
+        return;
+      }
+
+  g_queue_push_head (&pending, g_object_ref (location));
+  while (pending.length > THUNAR_PREFETCHER_QUEUE_MAX)
+    g_object_unref (g_queue_pop_tail (&pending));
+
+  thunar_prefetcher_schedule ();
+}
+
+
+
+static gboolean
+thunar_prefetcher_hover_timeout (gpointer user_data)
+{
+  hover_id = 0;
+
+  thunar_prefetcher_queue (hover_location);
+  g_clear_object (&hover_location);
+
+  return FALSE;
+}
+
+
+
+/**
+ * thunar_prefetcher_hover:
+ * @location : the #GFile of the folder under the pointer, or %NULL.
+ *
+ * Queues loading the folder at @location if the pointer stays on it
+ * for a moment.
+ **/
+void
+thunar_prefetcher_hover (GFile *location)
+{
+  _thunar_return_if_fail (location == NULL || G_IS_FILE (location));
+
+  if (hover_location != NULL && location != NULL && g_file_equal (hover_location, location))
+    return;
+
+  if (hover_id != 0)
+    {
+      g_source_remove (hover_id);
+      hover_id = 0;
+    }
+  g_clear_object (&hover_location);
+
+  if (location == NULL)
+    return;
+
+  hover_location = g_object_ref (location);
+  hover_id = g_timeout_add (THUNAR_PREFETCHER_HOVER_DELAY, thunar_prefetcher_hover_timeout, NULL);
+}
@@ -35,12 +35,16 @@
 
 #define SCROLLVIEW_THRESHOLD 5
 
+/* views beyond this number are folded into a summary row */
+#define FOLD_THRESHOLD 20
+
 
 
 static void     thunar_progress_dialog_dispose            (GObject              *object);
 static void     thunar_progress_dialog_finalize           (GObject              *object);
 static gboolean thunar_progress_dialog_closed             (ThunarProgressDialog *dialog);
 static gint     thunar_progress_dialog_n_views            (ThunarProgressDialog *dialog);
+static void     thunar_progress_dialog_update_summary     (ThunarProgressDialog *dialog);
 
 
 
@@ -56,6 +60,7 @@ struct _ThunarProgressDialog
   GtkWidget     *scrollwin;
   GtkWidget     *vbox;
   GtkWidget     *content_box;
+  GtkWidget     *summary;
 
   /* List of running views, type ThunarProgressView */
   GList         *views;
@@ -110,6 +115,13 @@ thunar_progress_dialog_init (ThunarProgressDialog *dialog)
   gtk_container_set_border_width (GTK_CONTAINER (dialog->content_box), 12);
   gtk_container_add (GTK_CONTAINER (dialog->vbox), dialog->content_box);
   gtk_widget_show (dialog->content_box);
+
+  /* expands to the views folded away with many parallel operations */
+  dialog->summary = gtk_expander_new (NULL);
+  gtk_container_set_border_width (GTK_CONTAINER (dialog->summary), 12);
+  gtk_box_pack_end (GTK_BOX (dialog->vbox), dialog->summary, FALSE, TRUE, 0);
+  g_signal_connect_swapped (dialog->summary, "notify::expanded",
+                            G_CALLBACK (thunar_progress_dialog_update_summary), dialog);
 }
 
 
@@ -166,6 +178,39 @@ thunar_progress_dialog_n_views (ThunarProgressDialog *dialog)
 
 
 
+/* shows the first FOLD_THRESHOLD views and folds the others into the
+ * summary row, unless it is expanded. Hidden views are not laid out
+ * and don't render their progress, which keeps hundreds of jobs cheap */
+static void
+thunar_progress_dialog_update_summary (ThunarProgressDialog *dialog)
+{
+  GList *children;
+  GList *lp;
+  gchar *text;
+  gint   n_views = 0;
+  gint   n_folded;
+
+  children = gtk_container_get_children (GTK_CONTAINER (dialog->content_box));
+  for (lp = children; lp != NULL; lp = lp->next, ++n_views)
+    gtk_widget_set_visible (lp->data, n_views < FOLD_THRESHOLD || gtk_expander_get_expanded (GTK_EXPANDER (dialog->summary)));
+  g_list_free (children);
+
+  n_folded = n_views - FOLD_THRESHOLD;
+  if (n_folded > 0)
+    {
+      text = g_strdup_printf (ngettext ("%d more operation", "%d more operations", n_folded), n_folded);
+      gtk_expander_set_label (GTK_EXPANDER (dialog->summary), text);
+      gtk_widget_show (dialog->summary);
+      g_free (text);
+    }
+  else
+    {
+      gtk_widget_hide (dialog->summary);
+    }
+}
+
+
+
 static void
 thunar_progress_dialog_view_needs_attention (ThunarProgressDialog *dialog,
                                              ThunarProgressView   *view)
@@ -173,7 +218,9 @@ thunar_progress_dialog_view_needs_attention (ThunarProgressDialog *dialog,
   _thunar_return_if_fail (THUNAR_IS_PROGRESS_DIALOG (dialog));
   _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
 
-  /* TODO scroll to the view */
+  /* move the view to the top, so it is not folded away */
+  gtk_box_reorder_child (GTK_BOX (dialog->content_box), GTK_WIDGET (view), 0);
+  thunar_progress_dialog_update_summary (dialog);
 
   /* raise the dialog */
   gtk_window_present (GTK_WINDOW (dialog));
@@ -263,6 +310,9 @@ thunar_progress_dialog_job_finished (ThunarProgressDialog *dialog,
   /* destroy the widget */
   gtk_widget_destroy (GTK_WIDGET (view));
 
+  /* show the next folded view, if any */
+  thunar_progress_dialog_update_summary (dialog);
+
   /* determine the number of views left */
   n_views = thunar_progress_dialog_n_views (dialog);
 
@@ -358,7 +408,6 @@ thunar_progress_dialog_add_job (ThunarProgressDialog *dialog,
   thunar_progress_view_set_icon_name (THUNAR_PROGRESS_VIEW (view), icon_name);
   thunar_progress_view_set_title (THUNAR_PROGRESS_VIEW (view), title);
   gtk_box_pack_start (GTK_BOX (dialog->content_box), view, FALSE, TRUE, 0);
-  gtk_widget_show (view);
 
   /* use the first job's icon-name for the dialog */
   if (dialog->views == NULL)
@@ -402,6 +451,9 @@ thunar_progress_dialog_add_job (ThunarProgressDialog *dialog,
 
     }
 
+  /* show the view, or fold it into the summary */
+  thunar_progress_dialog_update_summary (dialog);
+
   g_signal_connect_swapped (view, "need-attention",
                             G_CALLBACK (thunar_progress_dialog_view_needs_attention), dialog);
 
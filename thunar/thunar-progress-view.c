@@ -35,6 +35,11 @@
 
 
 
+/* interval in ms in which the progress of the job is rendered */
+#define THUNAR_PROGRESS_VIEW_UPDATE_INTERVAL (100)
+
+
+
 enum
 {
   PROP_0,
@@ -58,6 +63,7 @@ static void              thunar_progress_view_set_property (GObject            *
 static void              thunar_progress_view_pause_job    (ThunarProgressView *view);
 static void              thunar_progress_view_unpause_job  (ThunarProgressView *view);
 static void              thunar_progress_view_cancel_job   (ThunarProgressView *view);
+static void              thunar_progress_view_background_toggled (ThunarProgressView *view);
 static ThunarJobResponse thunar_progress_view_ask          (ThunarProgressView *view,
                                                             const gchar        *message,
                                                             ThunarJobResponse   choices,
@@ -81,6 +87,7 @@ static void              thunar_progress_view_frozen       (ThunarProgressView *
                                                             ExoJob             *job);
 static void              thunar_progress_view_unfrozen     (ThunarProgressView *view,
                                                             ExoJob             *job);
+static void              thunar_progress_view_schedule_update (ThunarProgressView *view);
 static void              thunar_progress_view_set_job      (ThunarProgressView *view,
                                                             ThunarJob          *job);
 
@@ -102,9 +109,16 @@ struct _ThunarProgressView
   GtkWidget *message_label;
   GtkWidget *pause_button;
   GtkWidget *unpause_button;
+  GtkWidget *background_button;
 
   gboolean   launched;
 
+  /* progress reported by the job, rendered at a fixed rate while mapped */
+  gdouble    percent;
+  gboolean   percent_changed;
+  gchar     *message;
+  guint      update_timer_id;
+
   gchar     *icon_name;
   gchar     *title;
 };
@@ -200,6 +214,9 @@ thunar_progress_view_init (ThunarProgressView *view)
 
   view->launched = FALSE;
 
+  /* render the progress reported while the view was not mapped */
+  g_signal_connect (G_OBJECT (view), "map", G_CALLBACK (thunar_progress_view_schedule_update), NULL);
+
   gtk_orientable_set_orientation (GTK_ORIENTABLE (view), GTK_ORIENTATION_VERTICAL);
 
   vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
@@ -247,6 +264,15 @@ thunar_progress_view_init (ThunarProgressView *view)
   gtk_widget_set_can_focus (view->unpause_button, FALSE);
   gtk_widget_hide (view->unpause_button);
 
+  view->background_button = gtk_toggle_button_new ();
+  gtk_button_set_image (GTK_BUTTON (view->background_button), gtk_image_new_from_icon_name ("go-bottom-symbolic", GTK_ICON_SIZE_BUTTON));
+  gtk_button_set_relief (GTK_BUTTON (view->background_button), GTK_RELIEF_NONE);
+  gtk_widget_set_tooltip_text (view->background_button, _("Run in background, giving disk and CPU time to other programs first"));
+  g_signal_connect_swapped (view->background_button, "toggled", G_CALLBACK (thunar_progress_view_background_toggled), view);
+  gtk_box_pack_start (GTK_BOX (hbox), view->background_button, FALSE, FALSE, 0);
+  gtk_widget_set_can_focus (view->background_button, FALSE);
+  gtk_widget_show (view->background_button);
+
   cancel_button = gtk_button_new_from_icon_name ("media-playback-stop-symbolic", GTK_ICON_SIZE_BUTTON);
   gtk_button_set_relief (GTK_BUTTON (cancel_button), GTK_RELIEF_NONE);
   g_signal_connect_swapped (cancel_button, "clicked", G_CALLBACK (thunar_progress_view_cancel_job), view);
@@ -287,6 +313,7 @@ thunar_progress_view_finalize (GObject *object)
 
   g_free (view->icon_name);
   g_free (view->title);
+  g_free (view->message);
 
   (*G_OBJECT_CLASS (thunar_progress_view_parent_class)->finalize) (object);
 }
@@ -298,6 +325,10 @@ thunar_progress_view_dispose (GObject *object)
 {
   ThunarProgressView *view = THUNAR_PROGRESS_VIEW (object);
 
+  /* stop rendering the progress */
+  if (view->update_timer_id != 0)
+    g_source_remove (view->update_timer_id);
+
   /* disconnect from the job (if any) */
   if (view->job != NULL)
     {
@@ -390,6 +421,22 @@ thunar_progress_view_pause_job (ThunarProgressView *view)
 
 
 
+static void
+thunar_progress_view_background_toggled (ThunarProgressView *view)
+{
+  _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
+
+  if (view->job != NULL)
+    {
+      if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (view->background_button)))
+        thunar_job_set_priority (view->job, THUNAR_JOB_PRIORITY_BACKGROUND);
+      else
+        thunar_job_set_priority (view->job, THUNAR_JOB_PRIORITY_NORMAL);
+    }
+}
+
+
+
 static void
 thunar_progress_view_unpause_job (ThunarProgressView *view)
 {
@@ -555,7 +602,9 @@ thunar_progress_view_info_message (ThunarProgressView *view,
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (view->job == THUNAR_JOB (job));
 
-  gtk_label_set_text (GTK_LABEL (view->message_label), message);
+  g_free (view->message);
+  view->message = g_strdup (message);
+  thunar_progress_view_schedule_update (view);
 }
 
 
@@ -565,24 +614,73 @@ thunar_progress_view_percent (ThunarProgressView *view,
                               gdouble             percent,
                               ExoJob             *job)
 {
-  gchar *text;
-
   _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
   _thunar_return_if_fail (percent >= 0.0 && percent <= 100.0);
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
   _thunar_return_if_fail (view->job == THUNAR_JOB (job));
 
-  /* update progressbar */
-  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (view->progress_bar), percent / 100.0);
+  view->percent = percent;
+  view->percent_changed = TRUE;
+  thunar_progress_view_schedule_update (view);
+}
 
-  /* set progress text */
-  if (THUNAR_IS_TRANSFER_JOB (job))
-    text = thunar_transfer_job_get_status (THUNAR_TRANSFER_JOB (job));
-  else
-    text = g_strdup_printf ("%.2f%%", percent);
 
-  gtk_label_set_text (GTK_LABEL (view->progress_label), text);
-  g_free (text);
+
+static gboolean
+thunar_progress_view_update (gpointer user_data)
+{
+  ThunarProgressView *view = THUNAR_PROGRESS_VIEW (user_data);
+  gchar              *text;
+
+  if (view->message != NULL)
+    {
+      gtk_label_set_text (GTK_LABEL (view->message_label), view->message);
+      g_free (view->message);
+      view->message = NULL;
+    }
+
+  if (view->percent_changed && view->job != NULL)
+    {
+      view->percent_changed = FALSE;
+
+      /* update progressbar */
+      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (view->progress_bar), view->percent / 100.0);
+
+      /* set progress text */
+      if (THUNAR_IS_TRANSFER_JOB (view->job))
+        text = thunar_transfer_job_get_status (THUNAR_TRANSFER_JOB (view->job));
+      else
+        text = g_strdup_printf ("%.2f%%", view->percent);
+
+      gtk_label_set_text (GTK_LABEL (view->progress_label), text);
+      g_free (text);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_progress_view_update_destroy (gpointer user_data)
+{
+  THUNAR_PROGRESS_VIEW (user_data)->update_timer_id = 0;
+}
+
+
+
+/* renders the latest progress of the job after a short delay, which
+ * coalesces frequent updates. Views that are not mapped, e.g. jobs
+ * folded into the summary of the progress dialog, render once mapped */
+static void
+thunar_progress_view_schedule_update (ThunarProgressView *view)
+{
+  if (view->update_timer_id == 0 && gtk_widget_get_mapped (GTK_WIDGET (view)))
+    {
+      view->update_timer_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, THUNAR_PROGRESS_VIEW_UPDATE_INTERVAL,
+                                                  thunar_progress_view_update, view,
+                                                  thunar_progress_view_update_destroy);
+    }
 }
 
 
@@ -713,6 +811,12 @@ thunar_progress_view_set_job (ThunarProgressView *view,
         {
           gtk_widget_show (view->unpause_button);
         }
+
+      /* reflect the class the job was created with, e.g. transfers already run in the background */
+      g_signal_handlers_block_by_func (view->background_button, thunar_progress_view_background_toggled, view);
+      gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (view->background_button),
+                                    thunar_job_get_priority (job) >= THUNAR_JOB_PRIORITY_BACKGROUND);
+      g_signal_handlers_unblock_by_func (view->background_button, thunar_progress_view_background_toggled, view);
     }
 
   g_object_notify (G_OBJECT (view), "job");
@@ -759,7 +863,7 @@ thunar_progress_view_launch_job (ThunarProgressView *view)
 {
   _thunar_return_if_fail (THUNAR_IS_PROGRESS_VIEW (view));
 
-  exo_job_launch (EXO_JOB (view->job));
+  thunar_job_launch (THUNAR_JOB (view->job));
 
   view->launched = TRUE;
 
@@ -39,9 +39,11 @@
 
 #include <thunar/thunar-abstract-dialog.h>
 #include <thunar/thunar-application.h>
+#include <thunar/thunar-checksum-page.h>
 #include <thunar/thunar-chooser-button.h>
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-emblem-chooser.h>
+#include <thunar/thunar-free-space-cache.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
@@ -55,6 +57,7 @@
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
+#include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-size-label.h>
 #include <thunar/thunar-thumbnailer.h>
 #include <thunar/thunar-util.h>
@@ -109,7 +112,9 @@ static gboolean thunar_properties_dialog_name_focus_out_event (GtkWidget
 static void     thunar_properties_dialog_icon_button_clicked  (GtkWidget                   *button,
                                                                ThunarPropertiesDialog      *dialog);
 static void     thunar_properties_dialog_update               (ThunarPropertiesDialog      *dialog);
+static void     thunar_properties_dialog_cancel_summary       (ThunarPropertiesDialog      *dialog);
 static void     thunar_properties_dialog_update_providers     (ThunarPropertiesDialog      *dialog);
+static void     thunar_properties_dialog_update_free_space    (ThunarPropertiesDialog      *dialog);
 static GList   *thunar_properties_dialog_get_files            (ThunarPropertiesDialog      *dialog);
 static void     thunar_properties_dialog_reset_highlight      (ThunarPropertiesDialog      *dialog);
 static void     thunar_properties_dialog_apply_highlight      (ThunarPropertiesDialog      *dialog);
@@ -148,6 +153,11 @@ struct _ThunarPropertiesDialog
   ThunarThumbnailer      *thumbnailer;
   guint                   thumbnail_request;
 
+  ThunarFreeSpaceCache   *free_space_cache;
+
+  /* looks up what the files have in common, see thunar_properties_dialog_update_multiple() */
+  ThunarJob              *summary_job;
+
   XfceFilenameInput      *name_entry;
 
   GtkWidget              *notebook;
@@ -173,6 +183,7 @@ struct _ThunarPropertiesDialog
   GtkWidget              *volume_image;
   GtkWidget              *volume_label;
   GtkWidget              *permissions_chooser;
+  GtkWidget              *checksum_page;
   GtkWidget              *content_label;
   GtkWidget              *content_value_label;
   GtkWidget              *color_chooser;
@@ -185,6 +196,29 @@ struct _ThunarPropertiesDialog
   gchar                  *background_color;
 };
 
+typedef enum
+{
+  THUNAR_PROPERTIES_SUMMARY_KIND     = 1 << 0,
+  THUNAR_PROPERTIES_SUMMARY_LOCATION = 1 << 1,
+  THUNAR_PROPERTIES_SUMMARY_VOLUME   = 1 << 2,
+  THUNAR_PROPERTIES_SUMMARY_TRASHED  = 1 << 3,
+  THUNAR_PROPERTIES_SUMMARY_ALL      = 0xf,
+} ThunarPropertiesSummaryFields;
+
+/* what the files shown by the dialog have in common, the fields are
+ * final as soon as they turn out to be mixed */
+typedef struct
+{
+  ThunarPropertiesDialog *dialog;   /* not referenced, the job is cancelled with the dialog */
+  ThunarJob              *job;
+  guint                   fields;   /* the fields known for all files */
+  const gchar            *content_type;
+  GFile                  *parent;
+  GVolume                *volume;
+  gboolean                has_trashed_files;
+}
+ThunarPropertiesSummary;
+
 
 
 G_DEFINE_TYPE (ThunarPropertiesDialog, thunar_properties_dialog, THUNAR_TYPE_ABSTRACT_DIALOG)
@@ -291,6 +325,11 @@ thunar_properties_dialog_init (ThunarPropertiesDialog *dialog)
   dialog->thumbnailer = thunar_thumbnailer_get ();
   dialog->thumbnail_request = 0;
 
+  /* the usage of the volume is looked up in the background */
+  dialog->free_space_cache = thunar_free_space_cache_get_default ();
+  g_signal_connect_swapped (G_OBJECT (dialog->free_space_cache), "changed",
+                            G_CALLBACK (thunar_properties_dialog_update_free_space), dialog);
+
   dialog->provider_factory = thunarx_provider_factory_get_default ();
 }
 
@@ -882,6 +921,18 @@ thunar_properties_dialog_constructed (GObject *object)
   gtk_notebook_append_page (GTK_NOTEBOOK (dialog->notebook), dialog->permissions_chooser, label);
   gtk_widget_show (dialog->permissions_chooser);
   gtk_widget_show (label);
+
+  /*
+     Checksums
+   */
+  label = gtk_label_new (_("Checksums"));
+  dialog->checksum_page = thunar_checksum_page_new ();
+  g_object_bind_property (G_OBJECT (dialog),                "files",
+                          G_OBJECT (dialog->checksum_page), "files",
+                          G_BINDING_SYNC_CREATE);
+  gtk_notebook_append_page (GTK_NOTEBOOK (dialog->notebook), dialog->checksum_page, label);
+  gtk_widget_show (dialog->checksum_page);
+  gtk_widget_show (label);
 }
 
 
@@ -920,6 +971,10 @@ thunar_properties_dialog_finalize (GObject *object)
   /* release the thumbnailer */
   g_object_unref (dialog->thumbnailer);
 
+  /* release the free space cache */
+  g_signal_handlers_disconnect_by_func (dialog->free_space_cache, thunar_properties_dialog_update_free_space, dialog);
+  g_object_unref (dialog->free_space_cache);
+
   /* release the provider property pages */
   g_list_free_full (dialog->provider_pages, g_object_unref);
 
@@ -1091,7 +1146,7 @@ thunar_properties_dialog_name_activate (GtkWidget              *entry,
   if (g_utf8_collate (new_name, old_name) != 0)
     {
       job = thunar_io_jobs_rename_file (file, new_name, THUNAR_OPERATION_LOG_OPERATIONS);
-      exo_job_launch (EXO_JOB (job));
+      thunar_job_launch (THUNAR_JOB (job));
       if (job != NULL)
         {
           g_signal_connect (job, "error", G_CALLBACK (thunar_properties_dialog_rename_error), dialog);
@@ -1217,6 +1272,51 @@ thunar_properties_dialog_update_providers (ThunarPropertiesDialog *dialog)
 
 
 
+static void
+thunar_properties_dialog_update_free_space (ThunarPropertiesDialog *dialog)
+{
+  ThunarFile *file;
+  guint64     fs_free;
+  guint64     fs_size;
+  gchar      *fs_string = NULL;
+  gchar      *capacity_str = NULL;
+
+  _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
+
+  /* the usage is only shown for a single file */
+  if (dialog->files == NULL || dialog->files->next != NULL)
+    return;
+
+  file = THUNAR_FILE (dialog->files->data);
+  if (thunar_free_space_cache_lookup_file (dialog->free_space_cache, file, &fs_free, &fs_size))
+    {
+      /* update the free space (only for folders) */
+      if (thunar_file_is_directory (file))
+        fs_string = thunar_g_format_free_space (fs_free, fs_size, dialog->file_size_binary);
+
+      /* update the capacity (space of containing volume) */
+      capacity_str = g_format_size_full (fs_size, dialog->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+    }
+
+  if (fs_string != NULL)
+    {
+      /* free disk space fraction */
+      gtk_label_set_text (GTK_LABEL (dialog->freespace_label), fs_string);
+      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (dialog->freespace_bar), (gdouble) (fs_size - fs_free) / fs_size);
+      gtk_widget_show (dialog->freespace_vbox);
+      g_free (fs_string);
+    }
+  else
+    {
+      gtk_widget_hide (dialog->freespace_vbox);
+    }
+
+  gtk_label_set_text (GTK_LABEL (dialog->capacity_label), capacity_str);
+  g_free (capacity_str);
+}
+
+
+
 static void
 thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
 {
@@ -1232,20 +1332,14 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
   gchar             *date_custom_style;
   gchar             *date;
   gchar             *display_name;
-  gchar             *fs_string;
   gchar             *str;
   gchar             *content_type_desc = NULL;
   gchar             *volume_name;
   gchar             *volume_id;
   gchar             *volume_label;
-  guint64            capacity = 0;
-  gchar             *capacity_str = NULL;
   ThunarFile        *file;
   ThunarFile        *parent_file;
   gboolean           show_chooser;
-  guint64            fs_free;
-  guint64            fs_size;
-  gdouble            fs_fraction = 0.0;
   const gchar       *background;
   const gchar       *foreground;
 
@@ -1432,39 +1526,8 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
       gtk_widget_hide (dialog->accessed_label);
     }
 
-  /* update the free space (only for folders) */
-  if (thunar_file_is_directory (file))
-    {
-      fs_string = thunar_g_file_get_free_space_string (thunar_file_get_file (file),
-                                                       dialog->file_size_binary);
-      if (thunar_g_file_get_free_space (thunar_file_get_file (file), &fs_free, &fs_size)
-          && fs_size > 0)
-        {
-          /* free disk space fraction */
-          fs_fraction = ((fs_size - fs_free) * 100 / fs_size);
-        }
-      if (fs_string != NULL)
-        {
-          gtk_label_set_text (GTK_LABEL (dialog->freespace_label), fs_string);
-          gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (dialog->freespace_bar), fs_fraction / 100);
-          gtk_widget_show (dialog->freespace_vbox);
-          g_free (fs_string);
-        }
-      else
-        {
-          gtk_widget_hide (dialog->freespace_vbox);
-        }
-    }
-  else
-    {
-      gtk_widget_hide (dialog->freespace_vbox);
-    }
-
-  /* update the capacity (space of containing volume) */
-  if (thunar_g_file_get_free_space (thunar_file_get_file (file), NULL, &capacity))
-    capacity_str = g_format_size_full (capacity, dialog->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-  gtk_label_set_text (GTK_LABEL (dialog->capacity_label), capacity_str);
-  g_free (capacity_str);
+  /* update the free space and the capacity */
+  thunar_properties_dialog_update_free_space (dialog);
 
   /* update the volume */
   volume = thunar_file_get_volume (file);
@@ -1505,6 +1568,263 @@ thunar_properties_dialog_update_single (ThunarPropertiesDialog *dialog)
 
 
 
+static void
+thunar_properties_dialog_summary_free (gpointer data)
+{
+  ThunarPropertiesSummary *summary = data;
+
+  g_clear_object (&summary->parent);
+  g_clear_object (&summary->volume);
+  g_object_unref (summary->job);
+  g_slice_free (ThunarPropertiesSummary, summary);
+}
+
+
+
+static gboolean
+thunar_properties_dialog_summary_apply (gpointer data)
+{
+  ThunarPropertiesSummary *summary = data;
+  ThunarPropertiesDialog  *dialog = summary->dialog;
+  GIcon                   *gicon;
+  gchar                   *str;
+  gchar                   *volume_name;
+  gchar                   *volume_id;
+
+  /* the dialog may be gone already */
+  if (exo_job_is_cancelled (EXO_JOB (summary->job)))
+    return FALSE;
+
+  _thunar_return_val_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog), FALSE);
+
+  /* hide the permissions chooser for trashed files */
+  if ((summary->fields & THUNAR_PROPERTIES_SUMMARY_TRASHED) != 0)
+    gtk_widget_set_visible (dialog->permissions_chooser, !summary->has_trashed_files);
+
+  /* update the content type */
+  if ((summary->fields & THUNAR_PROPERTIES_SUMMARY_KIND) != 0)
+    {
+      if (summary->content_type != NULL
+          && !g_content_type_equals (summary->content_type, "inode/symlink"))
+        {
+          str = g_content_type_get_description (summary->content_type);
+          gtk_widget_set_tooltip_text (dialog->kind_ebox, summary->content_type);
+          gtk_label_set_text (GTK_LABEL (dialog->kind_label), str);
+          g_free (str);
+        }
+      else
+        {
+          gtk_widget_set_tooltip_text (dialog->kind_ebox, NULL);
+          gtk_label_set_text (GTK_LABEL (dialog->kind_label), _("mixed"));
+        }
+    }
+
+  /* update the file or folder location (parent) */
+  if ((summary->fields & THUNAR_PROPERTIES_SUMMARY_LOCATION) != 0)
+    {
+      if (G_UNLIKELY (summary->parent != NULL))
+        {
+          str = g_file_get_parse_name (summary->parent);
+          gtk_label_set_text (GTK_LABEL (dialog->location_label), str);
+          gtk_widget_show (dialog->location_label);
+          g_free (str);
+        }
+      else
+        {
+          gtk_widget_hide (dialog->location_label);
+        }
+    }
+
+  /* update the volume */
+  if ((summary->fields & THUNAR_PROPERTIES_SUMMARY_VOLUME) != 0)
+    {
+      if (G_LIKELY (summary->volume != NULL))
+        {
+          gicon = g_volume_get_icon (summary->volume);
+          gtk_image_set_from_gicon (GTK_IMAGE (dialog->volume_image), gicon, GTK_ICON_SIZE_MENU);
+          if (G_LIKELY (gicon != NULL))
+            g_object_unref (gicon);
+
+          volume_name = g_volume_get_name (summary->volume);
+          volume_id = g_volume_get_identifier (summary->volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
+          str = g_strdup_printf ("%s (%s)", volume_name, volume_id);
+          gtk_label_set_text (GTK_LABEL (dialog->volume_label), str);
+          gtk_widget_show (dialog->volume_label);
+          g_free (volume_name);
+          g_free (volume_id);
+          g_free (str);
+        }
+      else
+        {
+          gtk_widget_hide (dialog->volume_label);
+        }
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_properties_dialog_summary_send (ThunarJob               *job,
+                                       ThunarPropertiesSummary *summary)
+{
+  ThunarPropertiesSummary *copy;
+
+  copy = g_slice_dup (ThunarPropertiesSummary, summary);
+  copy->job = g_object_ref (job);
+  if (copy->parent != NULL)
+    g_object_ref (copy->parent);
+  if (copy->volume != NULL)
+    g_object_ref (copy->volume);
+
+  exo_job_send_to_mainloop (EXO_JOB (job), thunar_properties_dialog_summary_apply,
+                            copy, thunar_properties_dialog_summary_free);
+}
+
+
+
+static gboolean
+thunar_properties_dialog_summarize (ThunarJob  *job,
+                                    GArray     *param_values,
+                                    GError    **error)
+{
+  ThunarPropertiesSummary summary = { NULL, };
+  ThunarFile             *file;
+  const gchar            *content_type;
+  GVolume                *volume;
+  GFile                  *parent;
+  gboolean                first_file = TRUE;
+  GList                  *files;
+  GList                  *lp;
+  guint                   fields;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL && param_values->len == 2, FALSE);
+
+  summary.dialog = g_value_get_pointer (&g_array_index (param_values, GValue, 0));
+  files = g_value_get_boxed (&g_array_index (param_values, GValue, 1));
+
+  /* a single pass over the files, which stops looking at a field once
+   * the files turned out to differ in it */
+  for (lp = files; lp != NULL && summary.fields != THUNAR_PROPERTIES_SUMMARY_ALL; lp = lp->next)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        break;
+
+      file = THUNAR_FILE (lp->data);
+      fields = summary.fields;
+
+      /* check the types match */
+      if ((summary.fields & THUNAR_PROPERTIES_SUMMARY_KIND) == 0)
+        {
+          content_type = thunar_file_get_content_type (file);
+          if (first_file)
+            summary.content_type = content_type;
+          else if (content_type != summary.content_type
+                   && (content_type == NULL || !g_content_type_equals (summary.content_type, content_type)))
+            summary.content_type = NULL;
+
+          if (summary.content_type == NULL)
+            summary.fields |= THUNAR_PROPERTIES_SUMMARY_KIND;
+        }
+
+      /* we only display the location if all files have the same parent */
+      if ((summary.fields & THUNAR_PROPERTIES_SUMMARY_LOCATION) == 0)
+        {
+          parent = g_file_get_parent (thunar_file_get_file (file));
+          if (first_file)
+            {
+              summary.parent = parent;
+              parent = NULL;
+            }
+          else if (parent != NULL && !g_file_equal (summary.parent, parent))
+            {
+              g_clear_object (&summary.parent);
+            }
+
+          if (parent != NULL)
+            g_object_unref (parent);
+          if (summary.parent == NULL)
+            summary.fields |= THUNAR_PROPERTIES_SUMMARY_LOCATION;
+        }
+
+      /* we only display information if the files are on the same volume */
+      if ((summary.fields & THUNAR_PROPERTIES_SUMMARY_VOLUME) == 0)
+        {
+          volume = thunar_file_get_volume (file);
+          if (first_file)
+            {
+              summary.volume = volume;
+              volume = NULL;
+            }
+          else if (volume != NULL && volume != summary.volume)
+            {
+              g_clear_object (&summary.volume);
+            }
+
+          if (volume != NULL)
+            g_object_unref (volume);
+          if (summary.volume == NULL)
+            summary.fields |= THUNAR_PROPERTIES_SUMMARY_VOLUME;
+        }
+
+      if ((summary.fields & THUNAR_PROPERTIES_SUMMARY_TRASHED) == 0 && thunar_file_is_trashed (file))
+        {
+          summary.has_trashed_files = TRUE;
+          summary.fields |= THUNAR_PROPERTIES_SUMMARY_TRASHED;
+        }
+
+      /* show the fields as soon as they are known */
+      if (summary.fields != fields)
+        thunar_properties_dialog_summary_send (job, &summary);
+
+      first_file = FALSE;
+    }
+
+  /* whatever is left is common to all files */
+  if (!exo_job_is_cancelled (EXO_JOB (job)) && summary.fields != THUNAR_PROPERTIES_SUMMARY_ALL)
+    {
+      summary.fields = THUNAR_PROPERTIES_SUMMARY_ALL;
+      thunar_properties_dialog_summary_send (job, &summary);
+    }
+
+  g_clear_object (&summary.parent);
+  g_clear_object (&summary.volume);
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+}
+
+
+
+static void
+thunar_properties_dialog_summary_finished (ThunarJob              *job,
+                                           ThunarPropertiesDialog *dialog)
+{
+  _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
+  _thunar_return_if_fail (dialog->summary_job == job);
+
+  g_signal_handlers_disconnect_by_data (job, dialog);
+  g_clear_object (&dialog->summary_job);
+}
+
+
+
+static void
+thunar_properties_dialog_cancel_summary (ThunarPropertiesDialog *dialog)
+{
+  _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
+
+  if (dialog->summary_job == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_data (dialog->summary_job, dialog);
+  exo_job_cancel (EXO_JOB (dialog->summary_job));
+  g_clear_object (&dialog->summary_job);
+}
+
+
+
 static void
 thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
 {
@@ -1512,19 +1832,6 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
   GString     *names_string;
   gboolean     first_file = TRUE;
   GList       *lp;
-  const gchar *content_type = NULL;
-  const gchar *tmp;
-  gchar       *str;
-  GVolume     *volume = NULL;
-  GVolume     *tmp_volume;
-  GIcon       *gicon;
-  gchar       *volume_name;
-  gchar       *volume_id;
-  gchar       *volume_label;
-  gchar       *display_name;
-  ThunarFile  *parent_file = NULL;
-  ThunarFile  *tmp_parent;
-  gboolean     has_trashed_files = FALSE;
 
   _thunar_return_if_fail (THUNAR_IS_PROPERTIES_DIALOG (dialog));
   _thunar_return_if_fail (g_list_length (dialog->files) > 1);
@@ -1544,7 +1851,7 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
 
   names_string = g_string_new (NULL);
 
-  /* collect data of the selected files */
+  /* collect the names of the selected files */
   for (lp = dialog->files; lp != NULL; lp = lp->next)
     {
       _thunar_assert (THUNAR_IS_FILE (lp->data));
@@ -1555,60 +1862,6 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
         g_string_append (names_string, ", ");
       g_string_append (names_string, thunar_file_get_display_name (file));
 
-      /* update the content type */
-      if (first_file)
-        {
-          content_type = thunar_file_get_content_type (file);
-        }
-      else if (content_type != NULL)
-        {
-          /* check the types match */
-          tmp = thunar_file_get_content_type (file);
-          if (tmp == NULL || !g_content_type_equals (content_type, tmp))
-            content_type = NULL;
-        }
-
-      /* check if all selected files are on the same volume */
-      tmp_volume = thunar_file_get_volume (file);
-      if (first_file)
-        {
-          volume = tmp_volume;
-        }
-      else if (tmp_volume != NULL)
-        {
-          /* we only display information if the files are on the same volume */
-          if (tmp_volume != volume)
-            {
-              if (volume != NULL)
-                g_object_unref (G_OBJECT (volume));
-              volume = NULL;
-            }
-
-          g_object_unref (G_OBJECT (tmp_volume));
-        }
-
-      /* check if all files have the same parent */
-      tmp_parent = thunar_file_get_parent (file, NULL);
-      if (first_file)
-        {
-          parent_file = tmp_parent;
-        }
-      else if (tmp_parent != NULL)
-        {
-          /* we only display the location if they are all equal */
-          if (!g_file_equal (thunar_file_get_file (parent_file), thunar_file_get_file (tmp_parent)))
-            {
-              if (parent_file != NULL)
-                g_object_unref (G_OBJECT (parent_file));
-              parent_file = NULL;
-            }
-
-          g_object_unref (G_OBJECT (tmp_parent));
-        }
-
-      if (thunar_file_is_trashed (file))
-        has_trashed_files = TRUE;
-
       first_file = FALSE;
     }
 
@@ -1617,60 +1870,18 @@ thunar_properties_dialog_update_multiple (ThunarPropertiesDialog *dialog)
   gtk_widget_set_tooltip_text (dialog->names_label, names_string->str);
   g_string_free (names_string, TRUE);
 
-  /* hide the permissions chooser for trashed files */
-  gtk_widget_set_visible (dialog->permissions_chooser, !has_trashed_files);
-
-  /* update the content type */
-  if (content_type != NULL
-      && !g_content_type_equals (content_type, "inode/symlink"))
-    {
-      str = g_content_type_get_description (content_type);
-      gtk_widget_set_tooltip_text (dialog->kind_ebox, content_type);
-      gtk_label_set_text (GTK_LABEL (dialog->kind_label), str);
-      g_free (str);
-    }
-  else
-    {
-      gtk_label_set_text (GTK_LABEL (dialog->kind_label), _("mixed"));
-    }
-
-  /* update the file or folder location (parent) */
-  if (G_UNLIKELY (parent_file != NULL))
-    {
-      display_name = g_file_get_parse_name (thunar_file_get_file (parent_file));
-      gtk_label_set_text (GTK_LABEL (dialog->location_label), display_name);
-      gtk_widget_show (dialog->location_label);
-      g_object_unref (G_OBJECT (parent_file));
-      g_free (display_name);
-    }
-  else
-    {
-      gtk_widget_hide (dialog->location_label);
-    }
-
-  /* update the volume */
-  if (G_LIKELY (volume != NULL))
-    {
-      gicon = g_volume_get_icon (volume);
-      gtk_image_set_from_gicon (GTK_IMAGE (dialog->volume_image), gicon, GTK_ICON_SIZE_MENU);
-      if (G_LIKELY (gicon != NULL))
-        g_object_unref (gicon);
-
-      volume_name = g_volume_get_name (volume);
-      volume_id = g_volume_get_identifier (volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-      volume_label = g_strdup_printf ("%s (%s)", volume_name, volume_id);
-      gtk_label_set_text (GTK_LABEL (dialog->volume_label), volume_label);
-      gtk_widget_show (dialog->volume_label);
-      g_free (volume_name);
-      g_free (volume_id);
-      g_free (volume_label);
-
-      g_object_unref (G_OBJECT (volume));
-    }
-  else
-    {
-      gtk_widget_hide (dialog->volume_label);
-    }
+  /* the content types, parents and volumes of many files take a while
+   * to compare, so they are filled in from a job as they are known */
+  thunar_properties_dialog_cancel_summary (dialog);
+  gtk_label_set_text (GTK_LABEL (dialog->kind_label), "");
+  gtk_widget_hide (dialog->location_label);
+  gtk_widget_hide (dialog->volume_label);
+
+  dialog->summary_job = thunar_simple_job_new (thunar_properties_dialog_summarize, 2,
+                                               G_TYPE_POINTER,              dialog,
+                                               THUNARX_TYPE_FILE_INFO_LIST, dialog->files);
+  g_signal_connect (dialog->summary_job, "finished", G_CALLBACK (thunar_properties_dialog_summary_finished), dialog);
+  thunar_job_launch (dialog->summary_job);
 }
 
 
@@ -1786,6 +1997,9 @@ thunar_properties_dialog_set_files (ThunarPropertiesDialog *dialog,
   if (G_UNLIKELY (dialog->files == files))
     return;
 
+  /* the summary of the previous files is not needed anymore */
+  thunar_properties_dialog_cancel_summary (dialog);
+
   /* disconnect from any previously set files */
   for (lp = dialog->files; lp != NULL; lp = lp->next)
     {
@@ -1914,9 +2128,9 @@ thunar_properties_dialog_apply_highlight (ThunarPropertiesDialog *dialog)
   for (lp = dialog->files; lp != NULL; lp = lp->next)
     {
       if (dialog->foreground_color != NULL)
-        thunar_file_set_metadata_setting (lp->data, "highlight-color-foreground", dialog->foreground_color, FALSE);
+        thunar_file_set_metadata_setting (lp->data, "highlight-color-foreground", dialog->foreground_color, TRUE);
       if (dialog->background_color != NULL)
-        thunar_file_set_metadata_setting (lp->data, "highlight-color-background", dialog->background_color, FALSE);
+        thunar_file_set_metadata_setting (lp->data, "highlight-color-background", dialog->background_color, TRUE);
     }
 
   thunar_properties_dialog_reload (dialog);
@@ -33,12 +33,19 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-renamer-model.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-util.h>
 
 
 
 #define THUNAR_RENAMER_MODEL_ITEM(item) ((ThunarRenamerModelItem *) (item))
 
+/* maximum time spent per run of the update idle source, in microseconds */
+#define THUNAR_RENAMER_MODEL_UPDATE_BUDGET (10 * 1000)
+
+/* number of items handed to the thread pool at once for thread-safe renamers */
+#define THUNAR_RENAMER_MODEL_PROCESS_BATCH (64)
+
 
 
 /* Property identifiers */
@@ -58,6 +65,13 @@ typedef struct
   GList *item;
 } SortTuple;
 
+typedef struct
+{
+  GList *item;
+  guint  idx;
+  gchar *name;
+} ProcessTuple;
+
 
 
 typedef struct _ThunarRenamerModelItem ThunarRenamerModelItem;
@@ -109,14 +123,31 @@ static void                    thunar_renamer_model_file_changed        (ThunarR
 static void                    thunar_renamer_model_file_destroyed      (ThunarRenamerModel      *renamer_model,
                                                                          ThunarFile              *file,
                                                                          ThunarFileMonitor       *file_monitor);
+static void                    thunar_renamer_model_delete_link         (ThunarRenamerModel      *renamer_model,
+                                                                         GList                   *lp);
 static void                    thunar_renamer_model_invalidate_all      (ThunarRenamerModel      *renamer_model);
 static void                    thunar_renamer_model_invalidate_item     (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_schedule_update     (ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_item_changed        (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
 static gboolean                thunar_renamer_model_conflict_item       (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_unindex_item        (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_clear_conflicts     (ThunarRenamerModel      *renamer_model);
 static gchar                  *thunar_renamer_model_process_item        (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item,
                                                                          guint                    idx);
+static void                    thunar_renamer_model_process_thread      (gpointer                 data,
+                                                                         gpointer                 user_data);
+static void                    thunar_renamer_model_process_batch       (ThunarRenamerModel      *renamer_model,
+                                                                         ProcessTuple            *tuples,
+                                                                         guint                    n_tuples);
+static void                    thunar_renamer_model_apply_item          (ThunarRenamerModel      *renamer_model,
+                                                                         GList                   *lp,
+                                                                         guint                    idx,
+                                                                         gchar                   *name);
 static gboolean                thunar_renamer_model_update_idle         (gpointer                 user_data);
 static void                    thunar_renamer_model_update_idle_destroy (gpointer                 user_data);
 static ThunarRenamerModelItem *thunar_renamer_model_item_new            (ThunarFile              *file) G_GNUC_MALLOC;
@@ -155,17 +186,36 @@ struct _ThunarRenamerModel
   ThunarxRenamer    *renamer;
   GList             *items;
 
+  /* ThunarFile -> link in items */
+  GHashTable        *links;
+
+  /* "parent uri/new name" -> list of the non-dirty items
+   * that will end up with that name, used to detect conflicts.
+   */
+  GHashTable        *conflicts;
+
   /* TRUE if the model is currently frozen */
   gboolean           frozen;
 
   /* the idle source used to update the model */
   guint              update_idle_id;
+
+  /* where the update idle source continues, NULL to start over */
+  GList             *update_cursor;
+  guint              update_cursor_idx;
+
+  /* workers used to compute the new names for thread-safe renamers */
+  GThreadPool       *process_pool;
+  GMutex             process_mutex;
+  GCond              process_cond;
+  guint              process_pending;
 };
 
 struct _ThunarRenamerModelItem
 {
   ThunarFile *file;
   gchar      *name;
+  gchar      *conflict_key; /* key in the conflicts table, if indexed */
   guint64     date_changed;
   guint       changed : 1;  /* if the file changed */
   guint       conflict : 1; /* if the item conflicts with another item */
@@ -276,6 +326,12 @@ thunar_renamer_model_init (ThunarRenamerModel *renamer_model)
   renamer_model->stamp = g_random_int ();
 #endif
 
+  renamer_model->links = g_hash_table_new (g_direct_hash, g_direct_equal);
+  renamer_model->conflicts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_mutex_init (&renamer_model->process_mutex);
+  g_cond_init (&renamer_model->process_cond);
+
   /* connect to the file monitor */
   renamer_model->file_monitor = thunar_file_monitor_get_default ();
   g_signal_connect_swapped (G_OBJECT (renamer_model->file_monitor), "file-changed",
@@ -294,8 +350,17 @@ thunar_renamer_model_finalize (GObject *object)
   /* reset the renamer property (must be first!) */
   thunar_renamer_model_set_renamer (renamer_model, NULL);
 
+  /* stop the worker threads, no batch can be running here */
+  if (renamer_model->process_pool != NULL)
+    g_thread_pool_free (renamer_model->process_pool, FALSE, TRUE);
+  g_mutex_clear (&renamer_model->process_mutex);
+  g_cond_clear (&renamer_model->process_cond);
+
   /* release all items */
+  thunar_renamer_model_clear_conflicts (renamer_model);
   g_list_free_full (renamer_model->items, thunar_renamer_model_item_free);
+  g_hash_table_destroy (renamer_model->conflicts);
+  g_hash_table_destroy (renamer_model->links);
 
   /* disconnect from the file monitor */
   g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->file_monitor), thunar_renamer_model_file_destroyed, renamer_model);
@@ -604,8 +669,6 @@ thunar_renamer_model_file_changed (ThunarRenamerModel *renamer_model,
                                    ThunarFileMonitor  *file_monitor)
 {
   ThunarRenamerModelItem *item;
-  GtkTreePath            *path;
-  GtkTreeIter             iter;
   GList                  *lp;
   guint64                 date_changed;
 
@@ -615,41 +678,35 @@ thunar_renamer_model_file_changed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (renamer_model->file_monitor == file_monitor);
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-
-        /* check if the file changed on disk, this is done to prevent
-         * excessive looping when some renamers are used
-         * (thunar-media-tags-plugin is an example) */
-        date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
-        if (item->date_changed == date_changed)
-          break;
+  lp = g_hash_table_lookup (renamer_model->links, file);
+  if (G_LIKELY (lp == NULL))
+    return;
+
+  item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+
+  /* check if the file changed on disk, this is done to prevent
+   * excessive looping when some renamers are used
+   * (thunar-media-tags-plugin is an example) */
+  date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
+  if (item->date_changed == date_changed)
+    return;
 
-        /* check if we're frozen */
-        if (G_LIKELY (!renamer_model->frozen))
-          {
-            /* the file changed */
-            item->changed = TRUE;
-
-            /* set the new mtime */
-            item->date_changed = date_changed;
-
-            /* invalidate the item */
-            thunar_renamer_model_invalidate_item (renamer_model, item);
-            break;
-          }
-
-        /* determine the iter for the item */
-        GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
-
-        /* emit "row-changed" to display up2date file name */
-        path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-        gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-        gtk_tree_path_free (path);
-        break;
-      }
+  /* check if we're frozen */
+  if (G_LIKELY (!renamer_model->frozen))
+    {
+      /* the file changed */
+      item->changed = TRUE;
+
+      /* set the new mtime */
+      item->date_changed = date_changed;
+
+      /* invalidate the item */
+      thunar_renamer_model_invalidate_item (renamer_model, item);
+      return;
+    }
+
+  /* emit "row-changed" to display up2date file name */
+  thunar_renamer_model_item_changed (renamer_model, item);
 }
 
 
@@ -669,27 +726,45 @@ thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   /* check if we have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      {
-        /* determine the idx of the item */
-        idx = g_list_position (renamer_model->items, lp);
-
-        /* free the item data */
-        thunar_renamer_model_item_free (lp->data);
-
-        /* drop the item from the list */
-        renamer_model->items = g_list_delete_link (renamer_model->items, lp);
-
-        /* tell the view that the item is gone */
-        path = gtk_tree_path_new_from_indices (idx, -1);
-        gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
-        gtk_tree_path_free (path);
-
-        /* invalidate all other items */
-        thunar_renamer_model_invalidate_all (renamer_model);
-        break;
-      }
+  lp = g_hash_table_lookup (renamer_model->links, file);
+  if (G_LIKELY (lp == NULL))
+    return;
+
+  /* determine the idx of the item */
+  idx = g_list_position (renamer_model->items, lp);
+
+  /* drop the item from the model */
+  thunar_renamer_model_delete_link (renamer_model, lp);
+
+  /* tell the view that the item is gone */
+  path = gtk_tree_path_new_from_indices (idx, -1);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
+  gtk_tree_path_free (path);
+
+  /* invalidate all other items */
+  thunar_renamer_model_invalidate_all (renamer_model);
+}
+
+
+
+static void
+thunar_renamer_model_delete_link (ThunarRenamerModel *renamer_model,
+                                  GList              *lp)
+{
+  ThunarRenamerModelItem *item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+
+  /* release the conflict state other items may have with this one */
+  thunar_renamer_model_unindex_item (renamer_model, item);
+  g_hash_table_remove (renamer_model->links, item->file);
+
+  /* free the item data */
+  thunar_renamer_model_item_free (item);
+
+  /* drop the item from the list */
+  renamer_model->items = g_list_delete_link (renamer_model->items, lp);
+
+  /* the update cursor may point to the link, start over */
+  renamer_model->update_cursor = NULL;
 }
 
 
@@ -699,9 +774,14 @@ thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 {
   GList *lp;
 
+  /* every item is dirty now, so no item is left in the conflicts table */
+  thunar_renamer_model_clear_conflicts (renamer_model);
+
   /* invalidate all items in the model */
   for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    thunar_renamer_model_invalidate_item (renamer_model, lp->data);
+    THUNAR_RENAMER_MODEL_ITEM (lp->data)->dirty = TRUE;
+
+  thunar_renamer_model_schedule_update (renamer_model);
 }
 
 
@@ -710,9 +790,23 @@ static void
 thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
                                       ThunarRenamerModelItem *item)
 {
+  /* dirty items are not checked for conflicts */
+  thunar_renamer_model_unindex_item (renamer_model, item);
+
   /* mark the item as dirty */
   item->dirty = TRUE;
 
+  thunar_renamer_model_schedule_update (renamer_model);
+}
+
+
+
+static void
+thunar_renamer_model_schedule_update (ThunarRenamerModel *renamer_model)
+{
+  /* rescan for dirty items from the start */
+  renamer_model->update_cursor = NULL;
+
   /* check if the update idle source is already running and not frozen */
   if (G_UNLIKELY (renamer_model->update_idle_id == 0 && !renamer_model->frozen))
     {
@@ -727,27 +821,20 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-trm_same_directory (ThunarFile *a,
-                    ThunarFile *b)
+static void
+thunar_renamer_model_item_changed (ThunarRenamerModel     *renamer_model,
+                                   ThunarRenamerModelItem *item)
 {
-  GFile    *parent_a;
-  GFile    *parent_b;
-  gboolean  result;
-
-  /* determine the parent paths for both files */
-  parent_a = g_file_get_parent (thunar_file_get_file (a));
-  parent_b = g_file_get_parent (thunar_file_get_file (b));
-
-  /* check if both files have the same parent */
-  result = (parent_a != NULL && parent_b != NULL && g_file_equal (parent_a, parent_b));
+  GtkTreePath *path;
+  GtkTreeIter  iter;
 
-  if (parent_a != NULL)
-    g_object_unref (parent_a);
-  if (parent_b != NULL)
-    g_object_unref (parent_b);
+  /* determine the iter for the item */
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_hash_table_lookup (renamer_model->links, item->file));
 
-  return result;
+  /* emit "row-changed" for the item */
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
@@ -757,45 +844,108 @@ thunar_renamer_model_conflict_item (ThunarRenamerModel     *renamer_model,
                                     ThunarRenamerModelItem *item)
 {
   ThunarRenamerModelItem *oitem;
-  GtkTreePath            *path;
-  GtkTreeIter             iter;
-  gboolean                conflict = FALSE;
+  GFile                  *parent;
+  GList                  *bucket;
   GList                  *lp;
+  gchar                  *uri;
 
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+  _thunar_assert (item->conflict_key == NULL);
+
+  /* items can only conflict if in same directory */
+  parent = g_file_get_parent (thunar_file_get_file (item->file));
+  if (G_UNLIKELY (parent == NULL))
+    return FALSE;
+
+  /* determine the key for the name the item will end up with */
+  uri = g_file_get_uri (parent);
+  item->conflict_key = g_strconcat (uri, "/", (item->name != NULL) ? item->name : thunar_file_get_display_name (item->file), NULL);
+  g_object_unref (parent);
+  g_free (uri);
+
+  /* all other items with that name conflict with this item */
+  bucket = g_hash_table_lookup (renamer_model->conflicts, item->conflict_key);
+  for (lp = bucket; lp != NULL; lp = lp->next)
     {
-      /* check if this item is dirty or the item we're about to check */
+      /* check if the other item is already in conflict state */
       oitem = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-      if (G_UNLIKELY (oitem == item || oitem->dirty))
-        continue;
-
-      /* check if this other item conflicts with the item in question (can only conflict if in same directory) */
-      if (trm_same_directory (item->file, oitem->file)
-          && ((item->name != NULL && oitem->name == NULL && strcmp (item->name, thunar_file_get_display_name (oitem->file)) == 0)
-           || (item->name == NULL && oitem->name != NULL && strcmp (thunar_file_get_display_name (item->file), oitem->name) == 0)
-           || (item->name != NULL && oitem->name != NULL && strcmp (item->name, oitem->name) == 0)))
+      if (G_LIKELY (!oitem->conflict))
         {
-          /* check if the other item is already in conflict state */
-          if (G_LIKELY (!oitem->conflict))
-            {
-              /* set to conflict state */
-              oitem->conflict = TRUE;
+          /* set to conflict state */
+          oitem->conflict = TRUE;
+
+          /* emit "row-changed" for the other item */
+          thunar_renamer_model_item_changed (renamer_model, oitem);
+        }
+    }
+
+  /* add the item to the table */
+  g_hash_table_insert (renamer_model->conflicts, g_strdup (item->conflict_key), g_list_prepend (bucket, item));
+
+  return (bucket != NULL);
+}
 
-              /* determine iter for other item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
 
-              /* emit "row-changed" for the other item */
-              path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
 
-          /* this item conflicts */
-          conflict = TRUE;
+static void
+thunar_renamer_model_unindex_item (ThunarRenamerModel     *renamer_model,
+                                   ThunarRenamerModelItem *item)
+{
+  ThunarRenamerModelItem *oitem;
+  GList                  *bucket;
+
+  if (item->conflict_key == NULL)
+    return;
+
+  /* drop the item from the table */
+  bucket = g_hash_table_lookup (renamer_model->conflicts, item->conflict_key);
+  bucket = g_list_remove (bucket, item);
+  if (bucket == NULL)
+    {
+      g_hash_table_remove (renamer_model->conflicts, item->conflict_key);
+    }
+  else
+    {
+      g_hash_table_insert (renamer_model->conflicts, g_strdup (item->conflict_key), bucket);
+
+      /* check if the last item with that name is no longer in conflict */
+      oitem = THUNAR_RENAMER_MODEL_ITEM (bucket->data);
+      if (bucket->next == NULL && oitem->conflict)
+        {
+          oitem->conflict = FALSE;
+          thunar_renamer_model_item_changed (renamer_model, oitem);
         }
     }
 
-  return conflict;
+  g_free (item->conflict_key);
+  item->conflict_key = NULL;
+}
+
+
+
+static gboolean
+thunar_renamer_model_free_bucket (gpointer key,
+                                  gpointer value,
+                                  gpointer user_data)
+{
+  GList *lp;
+
+  for (lp = value; lp != NULL; lp = lp->next)
+    {
+      g_free (THUNAR_RENAMER_MODEL_ITEM (lp->data)->conflict_key);
+      THUNAR_RENAMER_MODEL_ITEM (lp->data)->conflict_key = NULL;
+    }
+
+  g_list_free (value);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_renamer_model_clear_conflicts (ThunarRenamerModel *renamer_model)
+{
+  g_hash_table_foreach_remove (renamer_model->conflicts, thunar_renamer_model_free_bucket, NULL);
 }
 
 
@@ -886,85 +1036,210 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-thunar_renamer_model_update_idle (gpointer user_data)
+static void
+thunar_renamer_model_process_thread (gpointer data,
+                                     gpointer user_data)
 {
-  ThunarRenamerModelItem *item;
-  ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (user_data);
+  ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (user_data);
+  ProcessTuple       *tuple = data;
+
+  /* determine the new name, the main loop waits for us meanwhile */
+  tuple->name = thunar_renamer_model_process_item (renamer_model, tuple->item->data, tuple->idx);
+
+  /* wake up the main loop once the whole batch is done */
+  g_mutex_lock (&renamer_model->process_mutex);
+  if (--renamer_model->process_pending == 0)
+    g_cond_signal (&renamer_model->process_cond);
+  g_mutex_unlock (&renamer_model->process_mutex);
+}
+
+
+
+static void
+thunar_renamer_model_process_batch (ThunarRenamerModel *renamer_model,
+                                    ProcessTuple       *tuples,
+                                    guint               n_tuples)
+{
+  guint n;
+
+  if (G_UNLIKELY (n_tuples == 0))
+    return;
+
+  /* spawn the workers the first time they're needed */
+  if (G_UNLIKELY (renamer_model->process_pool == NULL))
+    {
+      renamer_model->process_pool = g_thread_pool_new (thunar_renamer_model_process_thread, renamer_model,
+                                                       g_get_num_processors (), FALSE, NULL);
+    }
+
+  g_mutex_lock (&renamer_model->process_mutex);
+  renamer_model->process_pending = n_tuples;
+  g_mutex_unlock (&renamer_model->process_mutex);
+
+  for (n = 0; n < n_tuples; ++n)
+    g_thread_pool_push (renamer_model->process_pool, &tuples[n], NULL);
+
+  /* block until every item has its new name, so the renamer
+   * settings and the files can't change while the workers run */
+  g_mutex_lock (&renamer_model->process_mutex);
+  while (renamer_model->process_pending > 0)
+    g_cond_wait (&renamer_model->process_cond, &renamer_model->process_mutex);
+  g_mutex_unlock (&renamer_model->process_mutex);
+}
+
+
+
+static void
+thunar_renamer_model_apply_item (ThunarRenamerModel *renamer_model,
+                                 GList              *lp,
+                                 guint               idx,
+                                 gchar              *name)
+{
+  ThunarRenamerModelItem *item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                changed = FALSE;
+  gboolean                changed;
   gboolean                conflict;
-  guint                   idx;
-  gchar                  *name;
-  GList                  *lp;
+
+  /* check if the file changed */
+  changed = item->changed;
+
+  /* mark as valid, since we're updating right now */
+  item->changed = FALSE;
+  item->dirty = FALSE;
+
+  /* check if the item got a new name */
+  if (g_strcmp0 (item->name, name) != 0)
+    {
+      /* apply new name */
+      g_free (item->name);
+      item->name = name;
+
+      /* the item changed */
+      changed = TRUE;
+    }
+  else
+    {
+      /* release temporary name */
+      g_free (name);
+    }
+
+  /* check if this item conflicts with any other item */
+  conflict = thunar_renamer_model_conflict_item (renamer_model, item);
+  if (item->conflict != conflict)
+    {
+      /* apply the new state */
+      item->conflict = conflict;
+
+      /* the item changed */
+      changed = TRUE;
+    }
+
+  /* check if the item changed */
+  if (G_LIKELY (changed))
+    {
+      /* generate the iter for the item */
+      GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+
+      /* emit "row-changed" for this item */
+      path = gtk_tree_path_new_from_indices (idx, -1);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+
+
+static gboolean
+thunar_renamer_model_update_idle (gpointer user_data)
+{
+  ThunarRenamerModel *renamer_model = THUNAR_RENAMER_MODEL (user_data);
+  ProcessTuple        tuples[THUNAR_RENAMER_MODEL_PROCESS_BATCH];
+  gboolean            parallel;
+  gboolean            more = FALSE;
+  gint64              start_time = g_get_monotonic_time ();
+  gint64              deadline;
+  guint               n_tuples;
+  guint               n_items = 0;
+  guint               idx;
+  guint               n;
+  GList              *lp;
 
 THUNAR_THREADS_ENTER
 
   /* don't do anything if the model is frozen */
   if (G_LIKELY (!renamer_model->frozen))
     {
-      /* process the first dirty item */
-      for (idx = 0, lp = renamer_model->items; !changed && lp != NULL; ++idx, lp = lp->next)
+      /* continue where the previous run stopped */
+      if (renamer_model->update_cursor == NULL)
         {
-          /* check if this item is dirty */
-          item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-          if (G_LIKELY (!item->dirty))
-            continue;
-
-          /* check if the file changed */
-          changed = item->changed;
+          renamer_model->update_cursor = renamer_model->items;
+          renamer_model->update_cursor_idx = 0;
+        }
 
-          /* mark as valid, since we're updating right now */
-          item->changed = FALSE;
-          item->dirty = FALSE;
+      /* spread the work over several threads if the renamer allows */
+      parallel = (renamer_model->renamer != NULL
+                  && thunarx_renamer_get_thread_safe (renamer_model->renamer)
+                  && g_get_num_processors () > 1);
 
-          /* determine the new name for the item */
-          name = thunar_renamer_model_process_item (renamer_model, item, idx);
-          if (g_strcmp0 (item->name, name) != 0)
+      /* process dirty items until the time slice is used up */
+      deadline = g_get_monotonic_time () + THUNAR_RENAMER_MODEL_UPDATE_BUDGET;
+      for (idx = renamer_model->update_cursor_idx, lp = renamer_model->update_cursor;
+           lp != NULL && g_get_monotonic_time () < deadline;)
+        {
+          if (parallel)
             {
-              /* apply new name */
-              g_free (item->name);
-              item->name = name;
-
-              /* the item changed */
-              changed = TRUE;
+              /* collect the next batch of dirty items */
+              for (n_tuples = 0; lp != NULL && n_tuples < THUNAR_RENAMER_MODEL_PROCESS_BATCH; ++idx, lp = lp->next)
+                if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->dirty)
+                  {
+                    tuples[n_tuples].item = lp;
+                    tuples[n_tuples].idx = idx;
+                    tuples[n_tuples].name = NULL;
+                    ++n_tuples;
+                  }
+
+              /* determine the new names and merge them in list order */
+              thunar_renamer_model_process_batch (renamer_model, tuples, n_tuples);
+              for (n = 0; n < n_tuples; ++n)
+                thunar_renamer_model_apply_item (renamer_model, tuples[n].item, tuples[n].idx, tuples[n].name);
             }
           else
             {
-              /* release temporary name */
-              g_free (name);
-            }
-
-          /* check if this item conflicts with any other item */
-          conflict = thunar_renamer_model_conflict_item (renamer_model, item);
-          if (item->conflict != conflict)
-            {
-              /* apply the new state */
-              item->conflict = conflict;
-
-              /* the item changed */
-              changed = TRUE;
+              /* process this item if it's dirty */
+              if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->dirty)
+                {
+                  thunar_renamer_model_apply_item (renamer_model, lp, idx,
+                                                   thunar_renamer_model_process_item (renamer_model, lp->data, idx));
+                }
+
+              ++idx;
+              lp = lp->next;
             }
+        }
 
-          /* check if the item changed */
-          if (G_LIKELY (changed))
-            {
-              /* generate the iter for the item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+      n_items = idx - renamer_model->update_cursor_idx;
 
-              /* emit "row-changed" for this item */
-              path = gtk_tree_path_new_from_indices (idx, -1);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
+      /* remember where to continue, unless an item was invalidated meanwhile */
+      if (G_LIKELY (renamer_model->update_cursor != NULL))
+        {
+          renamer_model->update_cursor = lp;
+          renamer_model->update_cursor_idx = idx;
+          more = (lp != NULL);
+        }
+      else
+        {
+          /* start over in the next run */
+          more = TRUE;
         }
     }
 
 THUNAR_THREADS_LEAVE
 
-  /* keep the idle source as long as any item changed */
-  return changed;
+  thunar_stats_record_callback ("thunar_renamer_model_update_idle", start_time, n_items);
+
+  /* keep the idle source as long as dirty items are left */
+  return more;
 }
 
 
@@ -1002,6 +1277,7 @@ thunar_renamer_model_item_free (gpointer data)
   ThunarRenamerModelItem *item = data;
 
   g_object_unref (G_OBJECT (item->file));
+  g_free (item->conflict_key);
   g_free (item->name);
   g_slice_free (ThunarRenamerModelItem, item);
 }
@@ -1303,18 +1579,19 @@ thunar_renamer_model_insert (ThunarRenamerModel *renamer_model,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   /* check if we already have that file */
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
-    if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->file == file)
-      return;
+  if (g_hash_table_contains (renamer_model->links, file))
+    return;
 
   /* allocate a new item for the file */
   item = thunar_renamer_model_item_new (file);
 
   /* append the item to the model */
   renamer_model->items = g_list_insert (renamer_model->items, item, position);
+  lp = g_list_find (renamer_model->items, item);
+  g_hash_table_insert (renamer_model->links, file, lp);
 
   /* determine the iterator for the new item */
-  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_list_find (renamer_model->items, item));
+  GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
 
   /* emit the "row-inserted" signal */
   path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
@@ -1461,6 +1738,11 @@ thunar_renamer_model_sort (ThunarRenamerModel *renamer_model,
 void
 thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
 {
+  GtkTreePath *path;
+  GList       *lp;
+  GList       *lprev;
+  gint         idx;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
 
   /* grab an additional reference on the model */
@@ -1469,14 +1751,23 @@ thunar_renamer_model_clear (ThunarRenamerModel *renamer_model)
   /* freeze notifications */
   g_object_freeze_notify (G_OBJECT (renamer_model));
 
-  /* delete all items from the model */
-  while (renamer_model->items != NULL)
+  /* delete all items from the model, starting at the end so
+   * no remaining item has to be renumbered or invalidated */
+  idx = g_list_length (renamer_model->items);
+  for (lp = g_list_last (renamer_model->items); lp != NULL; lp = lprev)
     {
-      /* just use the "file-destroyed" handler here to drop the first item */
-      thunar_renamer_model_file_destroyed (renamer_model, THUNAR_RENAMER_MODEL_ITEM (renamer_model->items->data)->file,
-                                           renamer_model->file_monitor);
+      lprev = lp->prev;
+      thunar_renamer_model_delete_link (renamer_model, lp);
+
+      /* tell the view that the item is gone */
+      path = gtk_tree_path_new_from_indices (--idx, -1);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
+      gtk_tree_path_free (path);
     }
 
+  /* nothing is left to rename */
+  g_object_notify (G_OBJECT (renamer_model), "can-rename");
+
   /* thaw notifications */
   g_object_thaw_notify (G_OBJECT (renamer_model));
 
@@ -1508,11 +1799,8 @@ thunar_renamer_model_remove (ThunarRenamerModel *renamer_model,
   if (G_UNLIKELY (lp == NULL))
     return;
 
-  /* free the item data */
-  thunar_renamer_model_item_free (lp->data);
-
-  /* drop the item from the list */
-  renamer_model->items = g_list_delete_link (renamer_model->items, lp);
+  /* drop the item from the model */
+  thunar_renamer_model_delete_link (renamer_model, lp);
 
   /* tell the view that the item is gone */
   gtk_tree_model_row_deleted (GTK_TREE_MODEL (renamer_model), path);
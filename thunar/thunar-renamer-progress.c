@@ -21,6 +21,8 @@
 #include <config.h>
 #endif
 
+#include <thunar/thunar-gio-extensions.h>
+#include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-renamer-progress.h>
 #include <thunar/thunar-util.h>
@@ -42,6 +44,13 @@ static gboolean thunar_renamer_progress_next_idle         (gpointer
 static void     thunar_renamer_progress_next_idle_destroy (gpointer               user_data);
 static void     thunar_renamer_progress_run_helper        (ThunarRenamerProgress *renamer_progress,
                                                            GList                 *pairs);
+static gboolean thunar_renamer_progress_run_job           (ThunarRenamerProgress *renamer_progress,
+                                                           GList                 *pairs);
+static void     thunar_renamer_progress_job_percent       (ThunarRenamerProgress *renamer_progress,
+                                                           gdouble                percent);
+static void     thunar_renamer_progress_job_error         (ThunarRenamerProgress *renamer_progress,
+                                                           GError                *error);
+static void     thunar_renamer_progress_job_finished      (ThunarRenamerProgress *renamer_progress);
 static void     thunar_renamer_progress_run_error_dialog  (ThunarRenamerProgress *renamer_progress,
                                                            ThunarRenamerPair     *pair,
                                                            GError                *error);
@@ -71,6 +80,11 @@ struct _ThunarRenamerProgress
   /* internal main loop for the _rename() method */
   guint        next_idle_id;
   GMainLoop   *next_idle_loop;
+
+  /* the batch rename job, tried before renaming pair by pair */
+  ThunarJob   *job;
+  gboolean     job_failed;
+  guint        job_n_total;
 };
 
 
@@ -326,8 +340,10 @@ thunar_renamer_progress_cancel (ThunarRenamerProgress *renamer_progress)
 {
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
-  /* exit the internal main loop (if any) */
-  if (G_UNLIKELY (renamer_progress->next_idle_loop != NULL))
+  /* a running batch is rolled back, the loop exits once the job finished */
+  if (G_UNLIKELY (renamer_progress->job != NULL))
+    exo_job_cancel (EXO_JOB (renamer_progress->job));
+  else if (G_UNLIKELY (renamer_progress->next_idle_loop != NULL))
     g_main_loop_quit (renamer_progress->next_idle_loop);
 
   renamer_progress->cancel_all_remaining_runs = TRUE;
@@ -412,6 +428,114 @@ thunar_renamer_progress_run_helper (ThunarRenamerProgress *renamer_progress,
 
 
 
+static void
+thunar_renamer_progress_job_percent (ThunarRenamerProgress *renamer_progress,
+                                     gdouble                percent)
+{
+  gchar text[128];
+  guint n_pairs_processed;
+
+  n_pairs_processed = (guint) (percent * renamer_progress->job_n_total / 100.0);
+
+  /* update the progress bar text */
+  g_snprintf (text, sizeof (text), "%d/%d", n_pairs_processed, renamer_progress->job_n_total);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
+
+  /* update the progress bar fraction */
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP (percent / 100.0, 0.0, 1.0));
+}
+
+
+
+static void
+thunar_renamer_progress_job_error (ThunarRenamerProgress *renamer_progress,
+                                   GError                *error)
+{
+  renamer_progress->job_failed = TRUE;
+}
+
+
+
+static void
+thunar_renamer_progress_job_finished (ThunarRenamerProgress *renamer_progress)
+{
+  g_main_loop_quit (renamer_progress->next_idle_loop);
+}
+
+
+
+/**
+ * thunar_renamer_progress_run_job:
+ * @renamer_progress : a #ThunarRenamerProgress.
+ * @pair_list        : a #GList of #ThunarRenamePair<!---->s.
+ *
+ * Renames all #ThunarRenamePair<!---->s in the specified @pair_list
+ * in a single batch job, which also takes care of files swapping
+ * their names and registers the batch for undo. If any file fails
+ * to rename, the whole batch is rolled back.
+ *
+ * Return value: %TRUE if all pairs were renamed.
+ **/
+static gboolean
+thunar_renamer_progress_run_job (ThunarRenamerProgress *renamer_progress,
+                                 GList                 *pairs)
+{
+  ThunarRenamerPair *pair;
+  GList             *source_file_list = NULL;
+  GList             *target_file_list = NULL;
+  GList             *lp;
+  GFile             *parent;
+  GFile             *target;
+
+  /* determine the new location of each file */
+  for (lp = pairs; lp != NULL; lp = lp->next)
+    {
+      pair = lp->data;
+      parent = g_file_get_parent (thunar_file_get_file (pair->file));
+      target = (parent != NULL) ? g_file_get_child_for_display_name (parent, pair->name, NULL) : NULL;
+      if (parent != NULL)
+        g_object_unref (parent);
+
+      /* leave invalid names to the pair by pair run, which reports them */
+      if (G_UNLIKELY (target == NULL))
+        {
+          thunar_g_list_free_full (source_file_list);
+          thunar_g_list_free_full (target_file_list);
+          return FALSE;
+        }
+
+      source_file_list = g_list_prepend (source_file_list, g_object_ref (thunar_file_get_file (pair->file)));
+      target_file_list = g_list_prepend (target_file_list, target);
+    }
+  source_file_list = g_list_reverse (source_file_list);
+  target_file_list = g_list_reverse (target_file_list);
+
+  renamer_progress->job_failed = FALSE;
+  renamer_progress->job_n_total = g_list_length (pairs);
+  renamer_progress->job = thunar_io_jobs_rename_files (source_file_list, target_file_list, THUNAR_OPERATION_LOG_OPERATIONS);
+  thunar_g_list_free_full (source_file_list);
+  thunar_g_list_free_full (target_file_list);
+
+  g_signal_connect_swapped (renamer_progress->job, "percent", G_CALLBACK (thunar_renamer_progress_job_percent), renamer_progress);
+  g_signal_connect_swapped (renamer_progress->job, "error", G_CALLBACK (thunar_renamer_progress_job_error), renamer_progress);
+  g_signal_connect_swapped (renamer_progress->job, "finished", G_CALLBACK (thunar_renamer_progress_job_finished), renamer_progress);
+
+  /* run the inner main loop until the job is done */
+  renamer_progress->next_idle_loop = g_main_loop_new (NULL, FALSE);
+  thunar_job_launch (THUNAR_JOB (renamer_progress->job));
+  g_main_loop_run (renamer_progress->next_idle_loop);
+  g_main_loop_unref (renamer_progress->next_idle_loop);
+  renamer_progress->next_idle_loop = NULL;
+
+  g_signal_handlers_disconnect_by_data (renamer_progress->job, renamer_progress);
+  g_object_unref (renamer_progress->job);
+  renamer_progress->job = NULL;
+
+  return !renamer_progress->job_failed;
+}
+
+
+
 /**
  * thunar_renamer_progress_run:
  * @renamer_progress : a #ThunarRenamerProgress.
@@ -420,8 +544,10 @@ thunar_renamer_progress_run_helper (ThunarRenamerProgress *renamer_progress,
  * Renames all #ThunarRenamePair<!---->s in the specified @pair_list
  * using the @renamer_progress.
  *
- * This method uses thunar_renamer_progress_run_helper function to
- * rename all the given pairs. It first tries to rename all the pairs
+ * This method first renames all pairs in a single batch job, see
+ * thunar_renamer_progress_run_job(). If that batch fails, it falls
+ * back to the thunar_renamer_progress_run_helper function to
+ * rename the given pairs one by one. It first tries to rename all the pairs
  * and stores all the failed pairs. Then it sorts the failed pairs in
  * ascending order and again tries to rename them. If still some pairs
  * are left then it sorts them in descending order and then tries to
@@ -450,6 +576,14 @@ thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
   thunar_renamer_pair_list_free (renamer_progress->pairs_renamed_all_runs);
   renamer_progress->pairs_renamed_all_runs = NULL;
 
+  /* the batch job handles the common case, unless the user cancelled it */
+  if (thunar_renamer_progress_run_job (renamer_progress, pairs)
+      || renamer_progress->cancel_all_remaining_runs)
+    {
+      g_object_unref (G_OBJECT (renamer_progress));
+      return;
+    }
+
   /* try to rename all the files for the first time */
   thunar_renamer_progress_run_helper (renamer_progress, pairs);
   pairs = NULL;
@@ -0,0 +1,378 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-search-backend.h>
+#include <thunar/thunar-search-index.h>
+
+
+
+/* configuration of updatedb, shared by mlocate and plocate */
+#define THUNAR_SEARCH_BACKEND_UPDATEDB_CONF "/etc/updatedb.conf"
+
+
+
+typedef gboolean (*ThunarSearchBackendLookup) (ThunarJob          *job,
+                                               const gchar *const *index_roots,
+                                               GFile              *directory,
+                                               gchar             **search_terms,
+                                               gboolean            show_hidden,
+                                               GList             **files_return);
+
+typedef struct
+{
+  const gchar              *name;
+  ThunarSearchBackendLookup lookup;
+}
+ThunarSearchBackend;
+
+/* a locate implementation and its database */
+typedef struct
+{
+  const gchar *program;
+  const gchar *database;
+}
+ThunarSearchBackendLocate;
+
+
+
+static gboolean thunar_search_backend_index_lookup  (ThunarJob          *job,
+                                                     const gchar *const *index_roots,
+                                                     GFile              *directory,
+                                                     gchar             **search_terms,
+                                                     gboolean            show_hidden,
+                                                     GList             **files_return);
+static gboolean thunar_search_backend_locate_lookup (ThunarJob          *job,
+                                                     const gchar *const *index_roots,
+                                                     GFile              *directory,
+                                                     gchar             **search_terms,
+                                                     gboolean            show_hidden,
+                                                     GList             **files_return);
+
+
+
+/* the backends by the names used in misc-search-backends */
+static const ThunarSearchBackend search_backends[] =
+{
+  { "index",  thunar_search_backend_index_lookup },
+  { "locate", thunar_search_backend_locate_lookup },
+};
+
+static const ThunarSearchBackendLocate search_backend_locates[] =
+{
+  { "plocate", "/var/lib/plocate/plocate.db" },
+  { "mlocate", "/var/lib/mlocate/mlocate.db" },
+  { "locate",  "/var/lib/mlocate/mlocate.db" },
+};
+
+
+
+static gboolean
+thunar_search_backend_index_lookup (ThunarJob          *job,
+                                    const gchar *const *index_roots,
+                                    GFile              *directory,
+                                    gchar             **search_terms,
+                                    gboolean            show_hidden,
+                                    GList             **files_return)
+{
+  return thunar_search_index_lookup (job, index_roots, directory, search_terms, show_hidden, files_return);
+}
+
+
+
+static gboolean
+thunar_search_backend_locate_is_pruned (const gchar *path)
+{
+  gboolean pruned = FALSE;
+  gchar   *contents;
+  gchar  **lines;
+  gchar  **prune_paths;
+  gchar   *value;
+  gsize    length;
+  guint    n, i;
+
+  /* a missing configuration prunes nothing */
+  if (!g_file_get_contents (THUNAR_SEARCH_BACKEND_UPDATEDB_CONF, &contents, NULL, NULL))
+    return FALSE;
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (n = 0; lines[n] != NULL && !pruned; ++n)
+    {
+      value = g_strstrip (lines[n]);
+      if (!g_str_has_prefix (value, "PRUNEPATHS"))
+        continue;
+
+      value = strchr (value, '=');
+      if (value == NULL)
+        continue;
+
+      /* PRUNEPATHS="/tmp /var/spool /media" */
+      value = g_strstrip (value + 1);
+      length = strlen (value);
+      if (length >= 2 && value[0] == '"' && value[length - 1] == '"')
+        {
+          value[length - 1] = '\0';
+          value++;
+        }
+
+      prune_paths = g_strsplit_set (value, " \t", -1);
+      for (i = 0; prune_paths[i] != NULL && !pruned; ++i)
+        {
+          length = strlen (prune_paths[i]);
+          pruned = length > 0
+                && strncmp (path, prune_paths[i], length) == 0
+                && (path[length] == '\0' || path[length] == G_DIR_SEPARATOR);
+        }
+      g_strfreev (prune_paths);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return pruned;
+}
+
+
+
+static gboolean
+thunar_search_backend_locate_match (const gchar *path,
+                                    gsize        root_length,
+                                    gchar      **search_terms,
+                                    gboolean     show_hidden)
+{
+  const gchar *name;
+  const gchar *p = NULL;
+  gboolean     matched;
+  gchar       *display_name;
+  gchar       *key;
+  guint        n;
+
+  /* only the files below the searched folder */
+  if (path[root_length] != G_DIR_SEPARATOR || path[root_length + 1] == '\0')
+    return FALSE;
+
+  /* like the recursive search, skip hidden and backup files and everything in hidden folders */
+  if (!show_hidden)
+    {
+      for (name = path + root_length + 1; name != NULL; name = (p != NULL) ? p + 1 : NULL)
+        {
+          p = strchr (name, G_DIR_SEPARATOR);
+          if (*name == '.' || (p != NULL ? (p > name && p[-1] == '~') : g_str_has_suffix (name, "~")))
+            return FALSE;
+        }
+    }
+
+  name = strrchr (path, G_DIR_SEPARATOR) + 1;
+  display_name = g_filename_display_name (name);
+  key = thunar_g_utf8_normalize_for_search (display_name, TRUE, TRUE);
+
+  matched = TRUE;
+  for (n = 0; search_terms[n] != NULL && matched; ++n)
+    matched = strstr (key, search_terms[n]) != NULL;
+
+  g_free (key);
+  g_free (display_name);
+
+  return matched;
+}
+
+
+
+static const gchar *
+thunar_search_backend_locate_pattern (gchar      **search_terms,
+                                      const gchar *root)
+{
+  const gchar *pattern = NULL;
+  const gchar *p;
+  guint        n;
+
+  /* locate matches case-insensitively but without the normalization
+   * of the search terms, so only plain ASCII terms narrow the query */
+  for (n = 0; search_terms[n] != NULL; ++n)
+    {
+      for (p = search_terms[n]; *p != '\0' && g_ascii_isalnum (*p); ++p)
+        ;
+
+      if (*p == '\0' && (pattern == NULL || strlen (search_terms[n]) > strlen (pattern)))
+        pattern = search_terms[n];
+    }
+
+  /* otherwise list everything in the folder and filter it here */
+  return (pattern != NULL) ? pattern : root;
+}
+
+
+
+static gboolean
+thunar_search_backend_locate_lookup (ThunarJob          *job,
+                                     const gchar *const *index_roots,
+                                     GFile              *directory,
+                                     gchar             **search_terms,
+                                     gboolean            show_hidden,
+                                     GList             **files_return)
+{
+  GDataInputStream *stream;
+  GCancellable     *cancellable;
+  GSubprocess      *subprocess;
+  const gchar      *pattern;
+  GList            *files = NULL;
+  gboolean          covered;
+  gchar            *program = NULL;
+  gchar            *path;
+  gchar            *line;
+  gsize             root_length;
+  gchar             c;
+  guint             n;
+
+  path = g_file_get_path (directory);
+  if (path == NULL)
+    return FALSE;
+
+  /* use the first locate implementation with a database */
+  for (n = 0; n < G_N_ELEMENTS (search_backend_locates) && program == NULL; ++n)
+    if (g_file_test (search_backend_locates[n].database, G_FILE_TEST_EXISTS))
+      program = g_find_program_in_path (search_backend_locates[n].program);
+
+  /* folders not scanned by updatedb are left to the other backends */
+  if (program == NULL || thunar_search_backend_locate_is_pruned (path))
+    {
+      g_free (program);
+      g_free (path);
+      return FALSE;
+    }
+
+  pattern = thunar_search_backend_locate_pattern (search_terms, path);
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  subprocess = g_subprocess_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE | G_SUBPROCESS_FLAGS_STDERR_PIPE, NULL,
+                                 program, "--null", "--ignore-case",
+                                 (pattern == path) ? "--wholename" : "--basename",
+                                 "--", pattern, NULL);
+  g_free (program);
+
+  if (subprocess == NULL)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* the results are not checked on disk here, files which vanished since
+   * the database was updated are skipped when they are loaded for the view */
+  root_length = strlen (path);
+  if (root_length == 1)
+    root_length = 0;
+
+  stream = g_data_input_stream_new (g_subprocess_get_stdout_pipe (subprocess));
+  while ((line = g_data_input_stream_read_upto (stream, "", 1, NULL, cancellable, NULL)) != NULL)
+    {
+      if (strncmp (line, path, root_length) == 0
+          && thunar_search_backend_locate_match (line, root_length, search_terms, show_hidden))
+        files = g_list_prepend (files, g_file_new_for_path (line));
+      g_free (line);
+
+      /* skip the NUL separator */
+      if (g_data_input_stream_read_byte (stream, cancellable, NULL) != '\0')
+        break;
+    }
+  g_object_unref (stream);
+
+  /* locate also fails if nothing matched, only an error message tells that the
+   * database could not be read and the folder must be walked after all */
+  covered = g_subprocess_wait (subprocess, cancellable, NULL)
+         && g_subprocess_get_if_exited (subprocess)
+         && (g_subprocess_get_exit_status (subprocess) == 0
+             || g_input_stream_read (g_subprocess_get_stderr_pipe (subprocess), &c, 1, NULL, NULL) == 0);
+
+  g_object_unref (subprocess);
+  g_free (path);
+
+  if (!covered)
+    {
+      thunar_g_list_free_full (files);
+      return FALSE;
+    }
+
+  *files_return = files;
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_search_backend_lookup:
+ * @job          : the #ThunarJob of the search.
+ * @backends     : %NULL-terminated list of backend names to try in order,
+ *                 or %NULL for the built-in filename index only.
+ * @index_roots  : the folders indexed by the "index" backend, see
+ *                 thunar_search_index_lookup().
+ * @directory    : the folder to search recursively.
+ * @search_terms : search terms, as used by thunar_list_model_search_folder().
+ * @show_hidden  : whether hidden files and folders should be searched.
+ * @files_return : return location for the list of matching #GFile<!---->s.
+ *
+ * Searches @directory and its subfolders by file name with the first
+ * of @backends which covers @directory, without reading the folders.
+ * Known backends are "index", the filename index kept by Thunar, and
+ * "locate", the database of plocate or mlocate. The results of
+ * "locate" may include files removed since the database was updated.
+ *
+ * The list in @files_return must be released with thunar_g_list_free_full().
+ *
+ * Return value: %FALSE if no backend covers @directory and the folders
+ *               must be walked, %TRUE if @files_return was set.
+ **/
+gboolean
+thunar_search_backend_lookup (ThunarJob          *job,
+                              const gchar *const *backends,
+                              const gchar *const *index_roots,
+                              GFile              *directory,
+                              gchar             **search_terms,
+                              gboolean            show_hidden,
+                              GList             **files_return)
+{
+  static const gchar *const default_backends[] = { "index", NULL };
+  guint                     n, i;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (search_terms != NULL, FALSE);
+  _thunar_return_val_if_fail (files_return != NULL, FALSE);
+
+  if (backends == NULL)
+    backends = default_backends;
+
+  for (n = 0; backends[n] != NULL && !exo_job_is_cancelled (EXO_JOB (job)); ++n)
+    for (i = 0; i < G_N_ELEMENTS (search_backends); ++i)
+      if (strcmp (backends[n], search_backends[i].name) == 0
+          && search_backends[i].lookup (job, index_roots, directory, search_terms, show_hidden, files_return))
+        return TRUE;
+
+  return FALSE;
+}
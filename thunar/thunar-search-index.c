@@ -0,0 +1,663 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-gobject-extensions.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-search-index.h>
+
+
+
+/* An index file holds a header, followed by the folder records, the
+ * entry records and the NUL-terminated strings. Folders are stored
+ * before their subfolders, starting with the indexed root, and the
+ * entries of each folder are stored consecutively. */
+#define THUNAR_SEARCH_INDEX_MAGIC     "THUNRIDX"
+#define THUNAR_SEARCH_INDEX_VERSION   1
+#define THUNAR_SEARCH_INDEX_NO_PARENT G_MAXUINT32
+
+/* attributes needed to index the folder contents */
+#define THUNAR_SEARCH_INDEX_NAMESPACE \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN
+
+
+
+enum
+{
+  THUNAR_SEARCH_INDEX_FLAG_HIDDEN    = 1 << 0, /* hidden or backup file */
+  THUNAR_SEARCH_INDEX_FLAG_DIRECTORY = 1 << 1, /* folder, not a symlink to one */
+};
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 n_dirs;
+  guint32 n_entries;
+  guint32 strings_size;
+}
+ThunarSearchIndexHeader;
+
+typedef struct
+{
+  gint64  mtime;       /* modification time of the folder when it was read */
+  guint32 parent;      /* index of the parent folder */
+  guint32 name;        /* offset of the folder name */
+  guint32 first_entry; /* index of the first entry of the folder */
+  guint32 n_entries;
+  guint32 flags;
+  guint32 padding;
+}
+ThunarSearchIndexDir;
+
+typedef struct
+{
+  guint32 name;        /* offset of the file name on disk */
+  guint32 key;         /* offset of the display name, normalized for search */
+  guint32 flags;
+}
+ThunarSearchIndexEntry;
+
+/* a mapped index file */
+typedef struct
+{
+  GMappedFile                   *mapped;
+  const ThunarSearchIndexHeader *header;
+  const ThunarSearchIndexDir    *dirs;
+  const ThunarSearchIndexEntry  *entries;
+  const gchar                   *strings;
+  gchar                        **paths;  /* absolute path of every folder */
+}
+ThunarSearchIndex;
+
+/* the contents of an index file, while it is built */
+typedef struct
+{
+  GArray     *dirs;
+  GArray     *entries;
+  GByteArray *strings;
+}
+ThunarSearchIndexBuilder;
+
+
+
+/* avoids building the same index in several threads */
+G_LOCK_DEFINE_STATIC (search_index);
+
+
+
+static gchar *
+thunar_search_index_get_filename (const gchar *root)
+{
+  gchar *checksum;
+  gchar *spec;
+  gchar *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, root, -1);
+  spec = g_strconcat ("Thunar/search-index/", checksum, NULL);
+  filename = xfce_resource_save_location (XFCE_RESOURCE_CACHE, spec, TRUE);
+  g_free (spec);
+  g_free (checksum);
+
+  return filename;
+}
+
+
+
+static void
+thunar_search_index_close (ThunarSearchIndex *index)
+{
+  if (index == NULL)
+    return;
+
+  g_strfreev (index->paths);
+  g_mapped_file_unref (index->mapped);
+  g_slice_free (ThunarSearchIndex, index);
+}
+
+
+
+static ThunarSearchIndex *
+thunar_search_index_open (const gchar *root,
+                          const gchar *filename)
+{
+  const ThunarSearchIndexHeader *header;
+  const ThunarSearchIndexDir    *dir;
+  const ThunarSearchIndexEntry  *entry;
+  ThunarSearchIndex             *index;
+  GMappedFile                   *mapped;
+  const gchar                   *data;
+  gsize                          length;
+  guint32                        n;
+
+  mapped = g_mapped_file_new (filename, FALSE, NULL);
+  if (mapped == NULL)
+    return NULL;
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  header = (const ThunarSearchIndexHeader *) data;
+
+  /* verify the header and the size of the file */
+  if (length < sizeof (ThunarSearchIndexHeader)
+      || memcmp (header->magic, THUNAR_SEARCH_INDEX_MAGIC, sizeof (header->magic)) != 0
+      || header->version != THUNAR_SEARCH_INDEX_VERSION
+      || header->n_dirs == 0
+      || header->strings_size == 0
+      || length != sizeof (ThunarSearchIndexHeader)
+                    + (gsize) header->n_dirs * sizeof (ThunarSearchIndexDir)
+                    + (gsize) header->n_entries * sizeof (ThunarSearchIndexEntry)
+                    + header->strings_size)
+    {
+      g_mapped_file_unref (mapped);
+      return NULL;
+    }
+
+  index = g_slice_new0 (ThunarSearchIndex);
+  index->mapped = mapped;
+  index->header = header;
+  index->dirs = (const ThunarSearchIndexDir *) (data + sizeof (ThunarSearchIndexHeader));
+  index->entries = (const ThunarSearchIndexEntry *) (index->dirs + header->n_dirs);
+  index->strings = (const gchar *) (index->entries + header->n_entries);
+
+  /* don't trust the offsets in the file, it could be truncated or corrupt */
+  if (index->strings[header->strings_size - 1] != '\0')
+    goto corrupt;
+
+  for (n = 0; n < header->n_entries; ++n)
+    {
+      entry = &index->entries[n];
+      if (entry->name >= header->strings_size || entry->key >= header->strings_size)
+        goto corrupt;
+    }
+
+  index->paths = g_new0 (gchar *, header->n_dirs + 1);
+  for (n = 0; n < header->n_dirs; ++n)
+    {
+      dir = &index->dirs[n];
+      if (dir->name >= header->strings_size
+          || (guint64) dir->first_entry + dir->n_entries > header->n_entries)
+        goto corrupt;
+
+      if (n == 0)
+        {
+          if (dir->parent != THUNAR_SEARCH_INDEX_NO_PARENT)
+            goto corrupt;
+          index->paths[n] = g_strdup (root);
+        }
+      else
+        {
+          /* parents are stored before their subfolders */
+          if (dir->parent >= n)
+            goto corrupt;
+          index->paths[n] = g_build_filename (index->paths[dir->parent], index->strings + dir->name, NULL);
+        }
+    }
+
+  return index;
+
+corrupt:
+  thunar_search_index_close (index);
+  return NULL;
+}
+
+
+
+static gboolean
+thunar_search_index_is_fresh (ThunarSearchIndex *index,
+                              ThunarJob         *job)
+{
+  GStatBuf statb;
+  guint32  n;
+
+  /* a folder changes its modification time when entries are added,
+   * removed or renamed, so every indexed folder needs a look */
+  for (n = 0; n < index->header->n_dirs; ++n)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        return FALSE;
+
+      if (g_stat (index->paths[n], &statb) != 0
+          || (gint64) statb.st_mtime != index->dirs[n].mtime)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static guint32
+thunar_search_index_builder_add_string (ThunarSearchIndexBuilder *builder,
+                                        const gchar              *str)
+{
+  guint32 offset = builder->strings->len;
+
+  g_byte_array_append (builder->strings, (const guint8 *) str, strlen (str) + 1);
+
+  return offset;
+}
+
+
+
+static void
+thunar_search_index_builder_add_entry (ThunarSearchIndexBuilder *builder,
+                                       const gchar              *name,
+                                       const gchar              *key,
+                                       guint32                   flags)
+{
+  ThunarSearchIndexEntry entry;
+
+  entry.name = thunar_search_index_builder_add_string (builder, name);
+  entry.key = thunar_search_index_builder_add_string (builder, key);
+  entry.flags = flags;
+  g_array_append_val (builder->entries, entry);
+}
+
+
+
+static void
+thunar_search_index_builder_scan (ThunarSearchIndexBuilder *builder,
+                                  ThunarJob                *job,
+                                  ThunarSearchIndex        *old_index,
+                                  GHashTable               *old_dirs,
+                                  const gchar              *path,
+                                  guint32                   parent,
+                                  const gchar              *name,
+                                  guint32                   flags)
+{
+  const ThunarSearchIndexEntry *old_entry;
+  const ThunarSearchIndexDir   *old_dir = NULL;
+  ThunarSearchIndexDir          dir;
+  GFileEnumerator              *enumerator;
+  GCancellable                 *cancellable;
+  GFileInfo                    *info;
+  GStatBuf                      statb;
+  GPtrArray                    *subdirs;
+  GArray                       *subdir_flags;
+  guint32                       entry_flags;
+  guint32                       index;
+  gpointer                      old;
+  GFile                        *file;
+  gchar                        *key;
+  gchar                        *subdir_path;
+  guint32                       n;
+
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    return;
+
+  if (g_stat (path, &statb) != 0)
+    return;
+
+  dir.mtime = statb.st_mtime;
+  dir.parent = parent;
+  dir.name = thunar_search_index_builder_add_string (builder, name);
+  dir.first_entry = builder->entries->len;
+  dir.n_entries = 0;
+  dir.flags = flags;
+  dir.padding = 0;
+
+  index = builder->dirs->len;
+  g_array_append_val (builder->dirs, dir);
+
+  subdirs = g_ptr_array_new_with_free_func (g_free);
+  subdir_flags = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  /* lookup the folder in the previous index */
+  if (old_dirs != NULL && g_hash_table_lookup_extended (old_dirs, path, NULL, &old))
+    old_dir = &old_index->dirs[GPOINTER_TO_UINT (old)];
+
+  if (old_dir != NULL && old_dir->mtime == dir.mtime)
+    {
+      /* the folder is unchanged, take its entries from the previous index */
+      for (n = 0; n < old_dir->n_entries; ++n)
+        {
+          old_entry = &old_index->entries[old_dir->first_entry + n];
+          thunar_search_index_builder_add_entry (builder,
+                                                 old_index->strings + old_entry->name,
+                                                 old_index->strings + old_entry->key,
+                                                 old_entry->flags);
+
+          if ((old_entry->flags & THUNAR_SEARCH_INDEX_FLAG_DIRECTORY) != 0)
+            {
+              g_ptr_array_add (subdirs, g_strdup (old_index->strings + old_entry->name));
+              g_array_append_val (subdir_flags, old_entry->flags);
+            }
+        }
+    }
+  else
+    {
+      cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+      /* like the recursive search, don't follow symlinks to avoid loops */
+      file = g_file_new_for_path (path);
+      enumerator = g_file_enumerate_children (file, THUNAR_SEARCH_INDEX_NAMESPACE,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                              cancellable, NULL);
+      g_object_unref (file);
+
+      while (enumerator != NULL
+             && (info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+        {
+          entry_flags = 0;
+          if (g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN)
+              || g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP))
+            entry_flags |= THUNAR_SEARCH_INDEX_FLAG_HIDDEN;
+          if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+            entry_flags |= THUNAR_SEARCH_INDEX_FLAG_DIRECTORY;
+
+          key = thunar_g_utf8_normalize_for_search (g_file_info_get_display_name (info), TRUE, TRUE);
+          thunar_search_index_builder_add_entry (builder, g_file_info_get_name (info), key, entry_flags);
+          g_free (key);
+
+          if ((entry_flags & THUNAR_SEARCH_INDEX_FLAG_DIRECTORY) != 0)
+            {
+              g_ptr_array_add (subdirs, g_strdup (g_file_info_get_name (info)));
+              g_array_append_val (subdir_flags, entry_flags);
+            }
+
+          g_object_unref (info);
+        }
+
+      if (enumerator != NULL)
+        g_object_unref (enumerator);
+    }
+
+  g_array_index (builder->dirs, ThunarSearchIndexDir, index).n_entries = builder->entries->len - dir.first_entry;
+
+  /* the subfolders are stored after their parent */
+  for (n = 0; n < subdirs->len; ++n)
+    {
+      subdir_path = g_build_filename (path, g_ptr_array_index (subdirs, n), NULL);
+      thunar_search_index_builder_scan (builder, job, old_index, old_dirs, subdir_path, index,
+                                        g_ptr_array_index (subdirs, n),
+                                        g_array_index (subdir_flags, guint32, n));
+      g_free (subdir_path);
+    }
+
+  g_ptr_array_unref (subdirs);
+  g_array_unref (subdir_flags);
+}
+
+
+
+static gboolean
+thunar_search_index_build (ThunarJob         *job,
+                           ThunarSearchIndex *old_index,
+                           const gchar       *root,
+                           const gchar       *filename)
+{
+  ThunarSearchIndexBuilder builder;
+  ThunarSearchIndexHeader  header;
+  GHashTable              *old_dirs = NULL;
+  GByteArray              *data;
+  gboolean                 succeed = FALSE;
+  guint32                  n;
+
+  /* the unchanged folders are taken over from the previous index */
+  if (old_index != NULL)
+    {
+      old_dirs = g_hash_table_new (g_str_hash, g_str_equal);
+      for (n = 0; n < old_index->header->n_dirs; ++n)
+        g_hash_table_insert (old_dirs, old_index->paths[n], GUINT_TO_POINTER (n));
+    }
+
+  builder.dirs = g_array_new (FALSE, FALSE, sizeof (ThunarSearchIndexDir));
+  builder.entries = g_array_new (FALSE, FALSE, sizeof (ThunarSearchIndexEntry));
+  builder.strings = g_byte_array_new ();
+
+  thunar_search_index_builder_scan (&builder, job, old_index, old_dirs, root,
+                                    THUNAR_SEARCH_INDEX_NO_PARENT, "", 0);
+
+  if (!exo_job_is_cancelled (EXO_JOB (job)) && builder.dirs->len > 0)
+    {
+      memset (&header, 0, sizeof (header));
+      memcpy (header.magic, THUNAR_SEARCH_INDEX_MAGIC, sizeof (header.magic));
+      header.version = THUNAR_SEARCH_INDEX_VERSION;
+      header.n_dirs = builder.dirs->len;
+      header.n_entries = builder.entries->len;
+      header.strings_size = builder.strings->len;
+
+      data = g_byte_array_sized_new (sizeof (header)
+                                     + builder.dirs->len * sizeof (ThunarSearchIndexDir)
+                                     + builder.entries->len * sizeof (ThunarSearchIndexEntry)
+                                     + builder.strings->len);
+      g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+      g_byte_array_append (data, (const guint8 *) builder.dirs->data, builder.dirs->len * sizeof (ThunarSearchIndexDir));
+      g_byte_array_append (data, (const guint8 *) builder.entries->data, builder.entries->len * sizeof (ThunarSearchIndexEntry));
+      g_byte_array_append (data, builder.strings->data, builder.strings->len);
+
+      /* replaced atomically, so other processes never map a partial index */
+      succeed = g_file_set_contents (filename, (const gchar *) data->data, data->len, NULL);
+
+      g_byte_array_unref (data);
+    }
+
+  g_array_unref (builder.dirs);
+  g_array_unref (builder.entries);
+  g_byte_array_unref (builder.strings);
+
+  if (old_dirs != NULL)
+    g_hash_table_destroy (old_dirs);
+
+  return succeed;
+}
+
+
+
+static gboolean
+thunar_search_index_terms_match (gchar      **terms,
+                                 const gchar *key)
+{
+  guint n;
+
+  for (n = 0; terms[n] != NULL; ++n)
+    if (strstr (key, terms[n]) == NULL)
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_search_index_query (ThunarSearchIndex *index,
+                           ThunarJob         *job,
+                           const gchar       *path,
+                           gchar            **search_terms,
+                           gboolean           show_hidden,
+                           GList            **files_return)
+{
+  const ThunarSearchIndexEntry *entry;
+  const ThunarSearchIndexDir   *dir;
+  gboolean                     *in_scope;
+  gboolean                      found = FALSE;
+  GList                        *files = NULL;
+  gchar                        *filename;
+  guint32                       n, i;
+
+  in_scope = g_new0 (gboolean, index->header->n_dirs);
+
+  for (n = 0; n < index->header->n_dirs; ++n)
+    {
+      if (G_UNLIKELY ((n % 1024) == 0) && exo_job_is_cancelled (EXO_JOB (job)))
+        break;
+
+      /* the search covers @path and its subfolders, hidden folders are
+       * skipped in the same way as the recursive search does */
+      dir = &index->dirs[n];
+      if (n > 0 && in_scope[dir->parent])
+        in_scope[n] = show_hidden || (dir->flags & THUNAR_SEARCH_INDEX_FLAG_HIDDEN) == 0;
+      else
+        found |= in_scope[n] = (strcmp (index->paths[n], path) == 0);
+
+      if (!in_scope[n])
+        continue;
+
+      for (i = dir->first_entry; i < dir->first_entry + dir->n_entries; ++i)
+        {
+          entry = &index->entries[i];
+
+          if (!show_hidden && (entry->flags & THUNAR_SEARCH_INDEX_FLAG_HIDDEN) != 0)
+            continue;
+
+          if (thunar_search_index_terms_match (search_terms, index->strings + entry->key))
+            {
+              filename = g_build_filename (index->paths[n], index->strings + entry->name, NULL);
+              files = g_list_prepend (files, g_file_new_for_path (filename));
+              g_free (filename);
+            }
+        }
+    }
+
+  g_free (in_scope);
+
+  *files_return = files;
+
+  return found;
+}
+
+
+
+/**
+ * thunar_search_index_lookup:
+ * @job          : the #ThunarJob of the search.
+ * @roots        : %NULL-terminated list of the indexed folders, or %NULL.
+ * @directory    : the folder to search recursively.
+ * @search_terms : search terms, as used by thunar_list_model_search_folder().
+ * @show_hidden  : whether hidden files and folders should be searched.
+ * @files_return : return location for the list of matching #GFile<!---->s.
+ *
+ * Searches @directory and its subfolders using the filename index of
+ * the first root in @roots containing @directory. The index is kept in
+ * the cache directory and built on first use. Folders which changed
+ * since the index was written are read again before the lookup, the
+ * unchanged folders are taken over from the previous index.
+ *
+ * The list in @files_return must be released with thunar_g_list_free_full().
+ *
+ * Return value: %FALSE if @directory is not indexed or the index could
+ *               not be written, %TRUE if @files_return was set.
+ **/
+gboolean
+thunar_search_index_lookup (ThunarJob          *job,
+                            const gchar *const *roots,
+                            GFile              *directory,
+                            gchar             **search_terms,
+                            gboolean            show_hidden,
+                            GList             **files_return)
+{
+  ThunarSearchIndex *index;
+  gboolean           found = FALSE;
+  GFile             *root_file;
+  gchar             *root = NULL;
+  gchar             *path;
+  gchar             *filename;
+  guint              n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (search_terms != NULL, FALSE);
+  _thunar_return_val_if_fail (files_return != NULL, FALSE);
+
+  /* only local folders can be indexed */
+  path = g_file_get_path (directory);
+  if (path == NULL)
+    return FALSE;
+
+  /* find the indexed root containing the folder */
+  for (n = 0; roots != NULL && roots[n] != NULL && root == NULL; ++n)
+    {
+      root_file = g_file_new_for_commandline_arg (roots[n]);
+      if (g_file_equal (root_file, directory) || g_file_has_prefix (directory, root_file))
+        root = g_file_get_path (root_file);
+      g_object_unref (root_file);
+    }
+
+  if (root == NULL)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  filename = thunar_search_index_get_filename (root);
+  if (filename == NULL)
+    {
+      g_free (root);
+      g_free (path);
+      return FALSE;
+    }
+
+  G_LOCK (search_index);
+
+  index = thunar_search_index_open (root, filename);
+  if (index == NULL || !thunar_search_index_is_fresh (index, job))
+    {
+      /* build a new index, based on the previous one */
+      if (!exo_job_is_cancelled (EXO_JOB (job))
+          && thunar_search_index_build (job, index, root, filename))
+        {
+          thunar_search_index_close (index);
+          index = thunar_search_index_open (root, filename);
+        }
+      else
+        {
+          thunar_search_index_close (index);
+          index = NULL;
+        }
+    }
+
+  G_UNLOCK (search_index);
+
+  if (index != NULL)
+    {
+      /* the folder may be missing from the index, e.g. if it is
+       * only reachable through a symlink */
+      found = thunar_search_index_query (index, job, path, search_terms, show_hidden, files_return);
+      if (!found)
+        {
+          thunar_g_list_free_full (*files_return);
+          *files_return = NULL;
+        }
+
+      thunar_search_index_close (index);
+    }
+
+  g_free (filename);
+  g_free (root);
+  g_free (path);
+
+  return found;
+}
@@ -196,8 +196,9 @@ thunar_sendto_model_event (GFileMonitor     *monitor,
       sendto_model->handlers = NULL;
     }
 
-  /* reload the handlers for the model */
-  thunar_sendto_model_load (sendto_model);
+  /* reload the handlers the next time they are needed, instead
+   * of once for every event of a changing .desktop file */
+  sendto_model->loaded = FALSE;
 }
 
 
@@ -252,16 +253,20 @@ GList*
 thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
                                   GList             *files)
 {
-  GFileMonitor *monitor;
-  GFile        *file;
-  gchar       **datadirs;
-  gchar        *dir;
-  GList        *handlers = NULL;
-  GList        *hp;
-  GList        *fp;
-  guint         n;
-  const gchar **mime_types;
-  const gchar  *content_type;
+  GFileMonitor  *monitor;
+  GFile         *file;
+  gchar        **datadirs;
+  gchar         *dir;
+  GList         *handlers = NULL;
+  GList         *hp;
+  GList         *fp;
+  guint          n;
+  const gchar  **mime_types;
+  const gchar   *content_type;
+  GHashTable    *content_types;
+  GHashTableIter iter;
+  gboolean       has_remote_files = FALSE;
+  gboolean       supported;
 
   _thunar_return_val_if_fail (THUNAR_IS_SENDTO_MODEL (sendto_model), NULL);
 
@@ -292,9 +297,23 @@ thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
           g_free (dir);
         }
       g_strfreev (datadirs);
+    }
 
-      /* load the model */
+  /* load the model, the handlers are kept until the directories change */
+  if (G_UNLIKELY (!sendto_model->loaded))
+    {
       thunar_sendto_model_load (sendto_model);
+      sendto_model->loaded = TRUE;
+    }
+
+  /* the handlers are tested against each content type once, no matter
+   * how many of the files share it */
+  content_types = g_hash_table_new (g_str_hash, g_str_equal);
+  for (fp = files; fp != NULL; fp = fp->next)
+    {
+      g_hash_table_add (content_types, (gpointer) thunar_file_get_content_type (fp->data));
+      if (!thunar_file_is_local (fp->data))
+        has_remote_files = TRUE;
     }
 
   /* test all handlers */
@@ -303,40 +322,29 @@ thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
       /* FIXME Ignore GAppInfos which don't support multiple file arguments */
 
       /* ignore the handler if it doesn't support URIs, but we don't have a local file */
-      if (!g_app_info_supports_uris (hp->data))
-        {
-          /* check if we have any non-local files */
-          for (fp = files; fp != NULL; fp = fp->next)
-            if (!thunar_file_is_local (fp->data))
-              break;
-
-          /* check if the test failed */
-          if (G_UNLIKELY (fp != NULL))
-            continue;
-        }
+      if (has_remote_files && !g_app_info_supports_uris (hp->data))
+        continue;
 
       /* check if we need to test mime types for this handler */
       mime_types = g_object_get_data (G_OBJECT (hp->data), "mime-types");
       if (mime_types != NULL)
         {
           /* each file must match atleast one of the specified mime types */
-          for (fp = files; fp != NULL; fp = fp->next)
+          supported = TRUE;
+          g_hash_table_iter_init (&iter, content_types);
+          while (supported && g_hash_table_iter_next (&iter, (gpointer *) &content_type, NULL))
             {
               /* each file must be supported by one of the mime types */
               for (n = 0; mime_types[n] != NULL; ++n)
-                {
-                  content_type = thunar_file_get_content_type (fp->data);
-                  if (g_content_type_equals (content_type, mime_types[n]))
-                    break;
-                }
+                if (g_content_type_equals (content_type, mime_types[n]))
+                  break;
 
               /* check if all mime types failed */
-              if (mime_types[n] == NULL)
-                break;
+              supported = (mime_types[n] != NULL);
             }
 
           /* check if the test failed */
-          if (G_UNLIKELY (fp != NULL))
+          if (G_UNLIKELY (!supported))
             continue;
         }
 
@@ -344,6 +352,8 @@ thunar_sendto_model_get_matching (ThunarSendtoModel *sendto_model,
       handlers = g_list_prepend (handlers, g_object_ref (G_OBJECT (hp->data)));
     }
 
+  g_hash_table_destroy (content_types);
+
   return handlers;
 }
 
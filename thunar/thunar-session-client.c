@@ -265,6 +265,8 @@ thunar_session_client_restore (ThunarSessionClient *session_client)
 {
   ThunarApplication *application;
   gchar            **uris;
+  gchar            **view_types;
+  gchar            **scroll_uris;
   GtkWidget         *window;
   XfceRc            *rc;
   gchar            **roles;
@@ -298,13 +300,17 @@ thunar_session_client_restore (ThunarSessionClient *session_client)
       /* active tab */
       active_tab = xfce_rc_read_int_entry (rc, "PAGE", -1);
 
+      /* view types and scroll positions of the tabs, missing in older sessions */
+      view_types = xfce_rc_read_list_entry (rc, "VIEW", ";");
+      scroll_uris = xfce_rc_read_list_entry (rc, "SCROLL", ";");
+
       /* open the new window */
       window = g_object_new (THUNAR_TYPE_WINDOW, "role", roles[n], NULL);
       thunar_application_take_window (application, GTK_WINDOW (window));
       gtk_widget_show (window);
 
       /* open tabs */
-      if (!thunar_window_set_directories (THUNAR_WINDOW (window), uris, active_tab))
+      if (!thunar_window_set_directories (THUNAR_WINDOW (window), uris, view_types, scroll_uris, active_tab))
         {
           /* no tabs were opened */
           gtk_widget_destroy (window);
@@ -312,6 +318,8 @@ thunar_session_client_restore (ThunarSessionClient *session_client)
 
       /* cleanup */
       g_strfreev (uris);
+      g_strfreev (view_types);
+      g_strfreev (scroll_uris);
     }
 
   /* cleanup */
@@ -347,6 +355,25 @@ thunar_session_client_save_complete (SmcConn              connection,
 
 
 
+static void
+thunar_session_client_write_list (FILE        *fp,
+                                  const gchar *key,
+                                  GList       *strings)
+{
+  GList *lp;
+
+  fprintf (fp, "%s=", key);
+  for (lp = strings; lp != NULL; lp = lp->next)
+    {
+      fprintf (fp, "%s", (const gchar *) lp->data);
+      if (G_LIKELY (lp->next != NULL))
+        fprintf (fp, ";");
+    }
+  fprintf (fp, "\n");
+}
+
+
+
 static void
 thunar_session_client_save_yourself (SmcConn              connection,
                                      ThunarSessionClient *session_client,
@@ -357,7 +384,9 @@ thunar_session_client_save_yourself (SmcConn              connection,
 {
   ThunarApplication *application;
   const gchar       *role;
-  GList             *uri, *uris; // list of uri strings
+  GList             *uris; // list of uri strings
+  GList             *view_types;
+  GList             *scroll_uris;
   GList             *windows;
   GList             *lp;
   FILE              *fp;
@@ -387,25 +416,24 @@ thunar_session_client_save_yourself (SmcConn              connection,
                     continue;
 
                   /* determine the directories for the window */
-                  uris = thunar_window_get_directories (lp->data, &active_page);
+                  view_types = NULL;
+                  scroll_uris = NULL;
+                  uris = thunar_window_get_directories (lp->data, &active_page, &view_types, &scroll_uris);
                   if (G_UNLIKELY (uris == NULL))
                     continue;
 
                   /* save the window */
                   fprintf (fp, "[%s]\n", role);
                   fprintf (fp, "PAGE=%d\n", active_page);
-                  fprintf (fp, "URI=");
-                  for (uri = uris; uri != NULL; uri = uri->next)
-                    {
-                      gchar* uri_string = uri->data;
-                      fprintf (fp, "%s", uri_string);
-                      if (G_LIKELY (uri->next != NULL))
-                        fprintf (fp, ";");
-                    }
-                  fprintf (fp, "\n\n");
+                  thunar_session_client_write_list (fp, "URI", uris);
+                  thunar_session_client_write_list (fp, "VIEW", view_types);
+                  thunar_session_client_write_list (fp, "SCROLL", scroll_uris);
+                  fprintf (fp, "\n");
 
                   /* cleanup */
                   g_list_free_full (uris, g_free);
+                  g_list_free_full (view_types, g_free);
+                  g_list_free_full (scroll_uris, g_free);
                 }
 
               /* cleanup */
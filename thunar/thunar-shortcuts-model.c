@@ -41,6 +41,7 @@
 
 #include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-file.h>
+#include <thunar/thunar-free-space-cache.h>
 #include <thunar/thunar-shortcuts-model.h>
 #include <thunar/thunar-device-monitor.h>
 #include <thunar/thunar-preferences.h>
@@ -50,12 +51,19 @@
 #define SPINNER_CYCLE_DURATION 1000
 #define SPINNER_NUM_STEPS      12
 
+/* seconds until a probe of a shortcut location is given up */
+#define THUNAR_SHORTCUTS_MODEL_PROBE_TIMEOUT 5
+
 
 
 #define THUNAR_SHORTCUT(obj) ((ThunarShortcut *) (obj))
 
 
 
+typedef struct _ThunarShortcutProbe ThunarShortcutProbe;
+
+
+
 typedef struct _ThunarShortcut ThunarShortcut;
 
 
@@ -150,6 +158,15 @@ static void               thunar_shortcuts_model_file_destroyed     (ThunarFileM
                                                                      ThunarShortcutsModel      *model);
 static void               thunar_shortcut_free                      (ThunarShortcut            *shortcut,
                                                                      ThunarShortcutsModel      *model);
+static GFile             *thunar_shortcut_get_root                  (ThunarShortcut            *shortcut);
+static ThunarShortcutProbe *thunar_shortcuts_model_probe_new        (ThunarShortcutsModel      *model,
+                                                                     GHashTable                *probes,
+                                                                     GFile                     *location);
+static void               thunar_shortcuts_model_probes_cancel      (GHashTable                *probes);
+static void               thunar_shortcuts_model_free_space_changed (ThunarFreeSpaceCache      *cache,
+                                                                     ThunarShortcutsModel      *model);
+static void               thunar_shortcuts_model_load_device_file   (ThunarShortcutsModel      *model,
+                                                                     ThunarShortcut            *shortcut);
 
 
 
@@ -185,6 +202,16 @@ struct _ThunarShortcutsModel
   guint                 bookmarks_idle_id;
 
   guint                 busy_timeout_id;
+
+  /* header visibility updated once per batch of device events */
+  guint                 header_idle_id;
+
+  /* in-flight probes of shortcut locations, mapping the
+   * location to its ThunarShortcutProbe */
+  GHashTable           *file_probes;
+
+  /* the usage of the file systems shown in the tooltips */
+  ThunarFreeSpaceCache *free_space_cache;
 };
 
 struct _ThunarShortcut
@@ -206,6 +233,17 @@ struct _ThunarShortcut
   guint                hidden : 1;
 };
 
+struct _ThunarShortcutProbe
+{
+  /* %NULL once the model is gone */
+  ThunarShortcutsModel *model;
+  GHashTable           *probes;
+
+  GFile                *location;
+  GCancellable         *cancellable;
+  guint                 timeout_id;
+};
+
 
 
 G_DEFINE_TYPE_WITH_CODE (ThunarShortcutsModel, thunar_shortcuts_model, G_TYPE_OBJECT,
@@ -284,6 +322,9 @@ thunar_shortcuts_model_init (ThunarShortcutsModel *model)
   model->stamp = g_random_int ();
 #endif
 
+  /* the probes own their location */
+  model->file_probes = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
   /* hidden bookmarks */
   model->preferences = thunar_preferences_get ();
   g_object_bind_property (model->preferences, "hidden-bookmarks",
@@ -308,6 +349,10 @@ thunar_shortcuts_model_init (ThunarShortcutsModel *model)
   model->file_monitor = thunar_file_monitor_get_default ();
   g_signal_connect (G_OBJECT (model->file_monitor), "file-changed", G_CALLBACK (thunar_shortcuts_model_file_changed), model);
   g_signal_connect (G_OBJECT (model->file_monitor), "file-destroyed", G_CALLBACK (thunar_shortcuts_model_file_destroyed), model);
+
+  /* connect to the free space cache */
+  model->free_space_cache = thunar_free_space_cache_get_default ();
+  g_signal_connect (G_OBJECT (model->free_space_cache), "changed", G_CALLBACK (thunar_shortcuts_model_free_space_changed), model);
 }
 
 
@@ -327,6 +372,13 @@ thunar_shortcuts_model_finalize (GObject *object)
   if (model->bookmarks_idle_id != 0)
     g_source_remove (model->bookmarks_idle_id);
 
+  /* stop the header visibility idle */
+  if (model->header_idle_id != 0)
+    g_source_remove (model->header_idle_id);
+
+  /* cancel the pending probes, their callbacks only release them */
+  thunar_shortcuts_model_probes_cancel (model->file_probes);
+
   /* free all shortcuts */
   g_list_foreach (model->shortcuts, (GFunc) (void (*)(void)) thunar_shortcut_free, model);
   g_list_free (model->shortcuts);
@@ -342,6 +394,10 @@ thunar_shortcuts_model_finalize (GObject *object)
   g_signal_handlers_disconnect_by_func (model->file_monitor, thunar_shortcuts_model_file_destroyed, model);
   g_object_unref (model->file_monitor);
 
+  /* disconnect from the free space cache */
+  g_signal_handlers_disconnect_by_func (model->free_space_cache, thunar_shortcuts_model_free_space_changed, model);
+  g_object_unref (model->free_space_cache);
+
   /* detach from the file monitor */
   if (model->bookmarks_monitor != NULL)
     {
@@ -574,7 +630,6 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
   ThunarShortcut *shortcut;
   GFile          *file;
   gboolean        can_eject;
-  gboolean        file_size_binary;
   gchar          *disk_usage;
   gchar          *device_name;
   gchar          *device_id;
@@ -657,8 +712,9 @@ thunar_shortcuts_model_get_value (GtkTreeModel *tree_model,
                   location = tmp;
                 }
 
-              file_size_binary = THUNAR_SHORTCUTS_MODEL (tree_model)->file_size_binary;
-              disk_usage = thunar_g_file_get_free_space_string (file, file_size_binary);
+              /* never query the file system here, a stalled mount would block the pane */
+              disk_usage = thunar_free_space_cache_get_string (THUNAR_SHORTCUTS_MODEL (tree_model)->free_space_cache, file,
+                                                               THUNAR_SHORTCUTS_MODEL (tree_model)->file_size_binary);
 
               if (disk_usage != NULL)
                 tooltip = g_strdup_printf ("%s\n%s", location, disk_usage);
@@ -990,6 +1046,30 @@ thunar_shortcuts_model_header_visibility (ThunarShortcutsModel *model)
 
 
 
+static gboolean
+thunar_shortcuts_model_header_visibility_idle (gpointer data)
+{
+  ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (data);
+
+  model->header_idle_id = 0;
+  thunar_shortcuts_model_header_visibility (model);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_shortcuts_model_header_visibility_queue (ThunarShortcutsModel *model)
+{
+  _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
+
+  if (model->header_idle_id == 0)
+    model->header_idle_id = g_idle_add (thunar_shortcuts_model_header_visibility_idle, model);
+}
+
+
+
 static void
 thunar_shortcuts_model_shortcut_devices (ThunarShortcutsModel *model)
 {
@@ -1410,20 +1490,61 @@ THUNAR_THREADS_LEAVE
 
 
 
+static void
+thunar_shortcuts_model_collect_line (GFile       *file_path,
+                                     const gchar *name,
+                                     gint         row_num,
+                                     gpointer     user_data)
+{
+  GQueue         *lines = user_data;
+  ThunarShortcut *line;
+
+  _thunar_return_if_fail (G_IS_FILE (file_path));
+
+  /* remember the line, the file and icon are only looked up for new bookmarks */
+  line = g_slice_new0 (ThunarShortcut);
+  line->group = THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS;
+  line->location = g_object_ref (file_path);
+  line->name = g_strdup (name);
+  line->sort_id = row_num;
+
+  g_queue_push_tail (lines, line);
+}
+
+
+
 static gboolean
 thunar_shortcuts_model_reload (gpointer data)
 {
   ThunarShortcutsModel *model = THUNAR_SHORTCUTS_MODEL (data);
   ThunarShortcut       *shortcut;
+  ThunarShortcut       *line;
   GtkTreePath          *path;
+  GtkTreeIter           iter;
+  GQueue                lines = G_QUEUE_INIT;
+  GList               **slots;
   GList                *lp;
+  GList                *li;
+  gpointer              swap;
+  gboolean              moved = FALSE;
+  gint                 *positions;
+  gint                 *order;
+  gint                  n_shortcuts;
+  gint                  n_bookmarks;
   gint                  idx;
+  gint                  i, j;
 
   _thunar_return_val_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model), FALSE);
 
 THUNAR_THREADS_ENTER
 
-  /* drop all existing user-defined shortcuts from the model */
+  /* parse the bookmarks */
+  thunar_util_load_bookmarks (model->bookmarks_file,
+                              thunar_shortcuts_model_collect_line,
+                              &lines);
+
+  /* keep the user-defined shortcuts that are still in the file, so
+   * their files are not looked up again, and drop the others */
   for (idx = 0, lp = model->shortcuts; lp != NULL; )
     {
       /* grab the shortcut */
@@ -1432,8 +1553,18 @@ THUNAR_THREADS_ENTER
       /* advance to the next list item */
       lp = g_list_next (lp);
 
-      /* drop the shortcut if it is user-defined */
-      if (shortcut->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+      if (shortcut->group != THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+        {
+          ++idx;
+          continue;
+        }
+
+      /* look for the first line with the same location */
+      for (li = lines.head; li != NULL && shortcut->location != NULL; li = li->next)
+        if (g_file_equal (THUNAR_SHORTCUT (li->data)->location, shortcut->location))
+          break;
+
+      if (li == NULL || shortcut->location == NULL)
         {
           /* unlink the shortcut from the model */
           model->shortcuts = g_list_remove (model->shortcuts, shortcut);
@@ -1445,17 +1576,85 @@ THUNAR_THREADS_ENTER
 
           /* actually free the shortcut */
           thunar_shortcut_free (shortcut, model);
+          continue;
         }
-      else
+
+      /* take over the position and name of the line */
+      line = THUNAR_SHORTCUT (li->data);
+      shortcut->sort_id = line->sort_id;
+      if (g_strcmp0 (shortcut->name, line->name) != 0)
         {
-          ++idx;
+          g_free (shortcut->name);
+          shortcut->name = g_steal_pointer (&line->name);
+
+          path = gtk_tree_path_new_from_indices (idx, -1);
+          gtk_tree_model_get_iter (GTK_TREE_MODEL (model), &iter, path);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+          gtk_tree_path_free (path);
         }
+
+      g_queue_delete_link (&lines, li);
+      thunar_shortcut_free (line, model);
+      ++idx;
     }
 
+  /* move the kept shortcuts into the order of the file, within the rows they occupy */
+  n_shortcuts = g_list_length (model->shortcuts);
+  order = g_new (gint, n_shortcuts);
+  slots = g_new (GList *, n_shortcuts);
+  positions = g_new (gint, n_shortcuts);
+  for (idx = 0, n_bookmarks = 0, lp = model->shortcuts; lp != NULL; ++idx, lp = lp->next)
+    {
+      order[idx] = idx;
+      if (THUNAR_SHORTCUT (lp->data)->group == THUNAR_SHORTCUT_GROUP_PLACES_BOOKMARKS)
+        {
+          slots[n_bookmarks] = lp;
+          positions[n_bookmarks++] = idx;
+        }
+    }
+
+  /* the rows are usually in order already, so an insertion sort does */
+  for (i = 1; i < n_bookmarks; ++i)
+    for (j = i; j > 0 && THUNAR_SHORTCUT (slots[j - 1]->data)->sort_id > THUNAR_SHORTCUT (slots[j]->data)->sort_id; --j)
+      {
+        swap = slots[j - 1]->data;
+        slots[j - 1]->data = slots[j]->data;
+        slots[j]->data = swap;
+
+        idx = order[positions[j - 1]];
+        order[positions[j - 1]] = order[positions[j]];
+        order[positions[j]] = idx;
+
+        moved = TRUE;
+      }
+
+  /* tell all listeners about the reordering just performed */
+  if (moved)
+    {
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model), path, NULL, order);
+      gtk_tree_path_free (path);
+    }
+
+  g_free (order);
+  g_free (slots);
+  g_free (positions);
+
+  /* add the bookmarks that are new in the file */
+  while ((line = g_queue_pop_head (&lines)) != NULL)
+    {
+      thunar_shortcuts_model_load_line (line->location, line->name, line->sort_id, model);
+      thunar_shortcut_free (line, model);
+    }
+
+  /* update the visibility */
+  thunar_shortcuts_model_header_visibility (model);
+
 THUNAR_THREADS_LEAVE
 
-  /* load new bookmarks */
-  return thunar_shortcuts_model_load (data);
+  model->bookmarks_idle_id = 0;
+
+  return FALSE;
 }
 
 
@@ -1556,7 +1755,6 @@ thunar_shortcuts_model_device_added (ThunarDeviceMonitor  *device_monitor,
                                      ThunarShortcutsModel *model)
 {
   ThunarShortcut *shortcut;
-  GFile          *mount_point;
 
   _thunar_return_if_fail (device_monitor == NULL || THUNAR_DEVICE_MONITOR (device_monitor));
   _thunar_return_if_fail (device_monitor == NULL || model->device_monitor == device_monitor);
@@ -1568,12 +1766,8 @@ thunar_shortcuts_model_device_added (ThunarDeviceMonitor  *device_monitor,
   shortcut->device = g_object_ref (device);
   shortcut->hidden = thunar_device_get_hidden (device);
 
-  mount_point = thunar_device_get_root (device);
-  if (mount_point != NULL)
-    {
-      shortcut->file = thunar_file_get (mount_point, NULL);
-      g_object_unref (mount_point);
-    }
+  /* determine the file for the mount point */
+  thunar_shortcuts_model_load_device_file (model, shortcut);
 
   switch (thunar_device_get_kind (device))
     {
@@ -1596,7 +1790,7 @@ thunar_shortcuts_model_device_added (ThunarDeviceMonitor  *device_monitor,
   /* header visibility if call is from monitor */
   if (device_monitor != NULL
       && !shortcut->hidden)
-    thunar_shortcuts_model_header_visibility (model);
+    thunar_shortcuts_model_header_visibility_queue (model);
 }
 
 
@@ -1639,7 +1833,6 @@ thunar_shortcuts_model_device_changed (ThunarDeviceMonitor  *device_monitor,
   gint            idx;
   GtkTreePath    *path;
   ThunarShortcut *shortcut;
-  GFile          *mount_point;
   gboolean        update_header = FALSE;
 
   _thunar_return_if_fail (THUNAR_DEVICE_MONITOR (device_monitor));
@@ -1665,14 +1858,7 @@ thunar_shortcuts_model_device_changed (ThunarDeviceMonitor  *device_monitor,
       shortcut->tooltip = NULL;
 
       if (shortcut->file == NULL)
-        {
-          mount_point = thunar_device_get_root (device);
-          if (mount_point != NULL)
-            {
-              shortcut->file = thunar_file_get (mount_point, NULL);
-              g_object_unref (mount_point);
-            }
-        }
+        thunar_shortcuts_model_load_device_file (model, shortcut);
 
       /* hidden state */
       if (shortcut->hidden != thunar_device_get_hidden (device))
@@ -1692,7 +1878,7 @@ thunar_shortcuts_model_device_changed (ThunarDeviceMonitor  *device_monitor,
 
   /* header visibility */
   if (update_header)
-    thunar_shortcuts_model_header_visibility (model);
+    thunar_shortcuts_model_header_visibility_queue (model);
 }
 
 
@@ -1811,6 +1997,216 @@ thunar_shortcut_free (ThunarShortcut       *shortcut,
 
 
 
+static GFile *
+thunar_shortcut_get_root (ThunarShortcut *shortcut)
+{
+  if (shortcut->device != NULL)
+    return thunar_device_get_root (shortcut->device);
+  else if (shortcut->file != NULL)
+    return g_object_ref (thunar_file_get_file (shortcut->file));
+  else
+    return NULL;
+}
+
+
+
+static void
+thunar_shortcuts_model_shortcut_changed (ThunarShortcutsModel *model,
+                                         GList                *lp)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+
+  GTK_TREE_ITER_INIT (iter, model->stamp, lp);
+
+  path = gtk_tree_path_new_from_indices (g_list_position (model->shortcuts, lp), -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+  gtk_tree_path_free (path);
+}
+
+
+
+static gboolean
+thunar_shortcuts_model_probe_timeout (gpointer data)
+{
+  ThunarShortcutProbe *probe = data;
+
+  /* give up on the location, the callback still runs and releases the probe */
+  probe->timeout_id = 0;
+  g_cancellable_cancel (probe->cancellable);
+
+  return FALSE;
+}
+
+
+
+static ThunarShortcutProbe *
+thunar_shortcuts_model_probe_new (ThunarShortcutsModel *model,
+                                  GHashTable           *probes,
+                                  GFile                *location)
+{
+  ThunarShortcutProbe *probe;
+
+  _thunar_return_val_if_fail (!g_hash_table_contains (probes, location), NULL);
+
+  probe = g_slice_new0 (ThunarShortcutProbe);
+  probe->model = model;
+  probe->probes = probes;
+  probe->location = g_object_ref (location);
+  probe->cancellable = g_cancellable_new ();
+  probe->timeout_id = g_timeout_add_seconds (THUNAR_SHORTCUTS_MODEL_PROBE_TIMEOUT,
+                                             thunar_shortcuts_model_probe_timeout, probe);
+
+  /* only one probe per location is in flight */
+  g_hash_table_insert (probes, probe->location, probe);
+
+  return probe;
+}
+
+
+
+static ThunarShortcutsModel *
+thunar_shortcuts_model_probe_finish (ThunarShortcutProbe *probe)
+{
+  ThunarShortcutsModel *model = probe->model;
+
+  if (model != NULL)
+    g_hash_table_remove (probe->probes, probe->location);
+
+  if (probe->timeout_id != 0)
+    g_source_remove (probe->timeout_id);
+
+  g_object_unref (probe->cancellable);
+  g_object_unref (probe->location);
+  g_slice_free (ThunarShortcutProbe, probe);
+
+  return model;
+}
+
+
+
+static void
+thunar_shortcuts_model_probes_cancel (GHashTable *probes)
+{
+  GHashTableIter       iter;
+  ThunarShortcutProbe *probe;
+
+  g_hash_table_iter_init (&iter, probes);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &probe))
+    {
+      probe->model = NULL;
+      g_cancellable_cancel (probe->cancellable);
+    }
+
+  g_hash_table_destroy (probes);
+}
+
+
+
+static void
+thunar_shortcuts_model_free_space_changed (ThunarFreeSpaceCache *cache,
+                                           ThunarShortcutsModel *model)
+{
+  GFile *root;
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_FREE_SPACE_CACHE (cache));
+  _thunar_return_if_fail (THUNAR_IS_SHORTCUTS_MODEL (model));
+
+  /* the tooltips of all shortcuts on a file system may be outdated */
+  for (lp = model->shortcuts; lp != NULL; lp = lp->next)
+    {
+      root = thunar_shortcut_get_root (lp->data);
+      if (root == NULL)
+        continue;
+
+      thunar_shortcuts_model_shortcut_changed (model, lp);
+      g_object_unref (root);
+    }
+}
+
+
+
+static void
+thunar_shortcuts_model_file_probe_finish (GObject      *object,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
+{
+  ThunarShortcutsModel *model;
+  ThunarShortcut       *shortcut;
+  ThunarFile           *file = NULL;
+  GFileInfo            *info;
+  GFile                *location = G_FILE (object);
+  GFile                *root;
+  GList                *lp;
+
+  info = g_file_query_info_finish (location, result, NULL);
+
+  model = thunar_shortcuts_model_probe_finish (user_data);
+  if (model != NULL && info != NULL)
+    file = thunar_file_get_with_info (location, info, NULL, FALSE);
+
+  if (file != NULL)
+    {
+      /* hand the file to the devices still waiting for it */
+      for (lp = model->shortcuts; lp != NULL; lp = lp->next)
+        {
+          shortcut = THUNAR_SHORTCUT (lp->data);
+          if (shortcut->device == NULL || shortcut->file != NULL)
+            continue;
+
+          root = thunar_device_get_root (shortcut->device);
+          if (root == NULL)
+            continue;
+
+          if (g_file_equal (root, location))
+            {
+              shortcut->file = g_object_ref (file);
+              thunar_shortcuts_model_shortcut_changed (model, lp);
+            }
+
+          g_object_unref (root);
+        }
+
+      g_object_unref (file);
+    }
+
+  if (info != NULL)
+    g_object_unref (info);
+}
+
+
+
+static void
+thunar_shortcuts_model_load_device_file (ThunarShortcutsModel *model,
+                                         ThunarShortcut       *shortcut)
+{
+  ThunarShortcutProbe *probe;
+  GFile               *mount_point;
+
+  _thunar_return_if_fail (shortcut->file == NULL);
+
+  mount_point = thunar_device_get_root (shortcut->device);
+  if (mount_point == NULL)
+    return;
+
+  /* a known file is used right away, otherwise the mount point is
+   * queried in the background, as a stalled server would block here */
+  shortcut->file = thunar_file_cache_lookup (mount_point);
+  if (shortcut->file == NULL && !g_hash_table_contains (model->file_probes, mount_point))
+    {
+      probe = thunar_shortcuts_model_probe_new (model, model->file_probes, mount_point);
+      g_file_query_info_async (mount_point, THUNARX_FILE_INFO_NAMESPACE,
+                               G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
+                               probe->cancellable,
+                               thunar_shortcuts_model_file_probe_finish, probe);
+    }
+
+  g_object_unref (mount_point);
+}
+
+
+
 static gboolean
 thunar_shortcuts_model_busy_timeout (gpointer data)
 {
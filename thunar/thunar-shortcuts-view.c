@@ -142,6 +142,7 @@ static GdkDragAction  thunar_shortcuts_view_compute_drop_actions         (Thunar
                                                                           GdkDragContext           *context,
                                                                           gint                      x,
                                                                           gint                      y,
+                                                                          gboolean                  validate,
                                                                           GtkTreePath             **path_return,
                                                                           GdkDragAction            *action_return,
                                                                           GtkTreeViewDropPosition  *position_return);
@@ -195,6 +196,10 @@ struct _ThunarShortcutsView
   guint  drop_occurred : 1;
   GList *drop_file_list;      /* the list of URIs that are contained in the drop data */
 
+  /* drag-motion feedback, valid until the drag leaves the view */
+  ThunarDndAcceptCache drop_accept_cache;
+  gint                 drop_directories; /* whether the dragged files are folders, -1 if unknown */
+
   /* id of the signal used to queue a resize on the
    * column whenever the shortcuts icon size is changed.
    */
@@ -295,6 +300,9 @@ thunar_shortcuts_view_init (ThunarShortcutsView *view)
   gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (view), FALSE);
   gtk_tree_view_set_tooltip_column (GTK_TREE_VIEW (view), THUNAR_SHORTCUTS_MODEL_COLUMN_TOOLTIP);
 
+  /* nothing dragged yet */
+  view->drop_directories = -1;
+
   /* grab a reference on the provider factory */
   view->provider_factory = thunarx_provider_factory_get_default ();
 
@@ -424,6 +432,7 @@ thunar_shortcuts_view_finalize (GObject *object)
 
   /* release drop path list (if drag_leave wasn't called) */
   thunar_g_list_free_full (view->drop_file_list);
+  thunar_dnd_accept_cache_clear (&view->drop_accept_cache);
 
   /* release the provider factory */
   g_object_unref (G_OBJECT (view->provider_factory));
@@ -750,7 +759,7 @@ thunar_shortcuts_view_drag_data_received (GtkWidget        *widget,
       if (G_LIKELY (info == TEXT_URI_LIST))
         {
           /* determine the drop actions */
-          actions = thunar_shortcuts_view_compute_drop_actions (view, context, x, y, &path, &action, &position);
+          actions = thunar_shortcuts_view_compute_drop_actions (view, context, x, y, TRUE, &path, &action, &position);
           if (G_LIKELY (actions != 0))
             {
               /* check if we should add a shortcut */
@@ -929,7 +938,7 @@ thunar_shortcuts_view_drag_motion (GtkWidget      *widget,
       else
         {
           /* compute the drop position */
-          thunar_shortcuts_view_compute_drop_actions (view, context, x, y, &path, &action, &position);
+          thunar_shortcuts_view_compute_drop_actions (view, context, x, y, FALSE, &path, &action, &position);
         }
     }
   else if (target == gdk_atom_intern_static_string ("GTK_TREE_MODEL_ROW"))
@@ -1004,8 +1013,12 @@ thunar_shortcuts_view_drag_leave (GtkWidget      *widget,
       thunar_g_list_free_full (view->drop_file_list);
       view->drop_data_ready = FALSE;
       view->drop_file_list = NULL;
+      view->drop_directories = -1;
     }
 
+  /* forget the accept decision of this drag */
+  thunar_dnd_accept_cache_clear (&view->drop_accept_cache);
+
   /* schedule a repaint to make sure the special drop icon for the target row
    * is reset to its default (https://bugzilla.xfce.org/show_bug.cgi?id=2498).
    */
@@ -1446,6 +1459,7 @@ thunar_shortcuts_view_compute_drop_actions (ThunarShortcutsView     *view,
                                             GdkDragContext          *context,
                                             gint                     x,
                                             gint                     y,
+                                            gboolean                 validate,
                                             GtkTreePath            **path_return,
                                             GdkDragAction           *action_return,
                                             GtkTreeViewDropPosition *position_return)
@@ -1478,8 +1492,12 @@ thunar_shortcuts_view_compute_drop_actions (ThunarShortcutsView     *view,
           gtk_tree_model_get (model, &iter, THUNAR_SHORTCUTS_MODEL_COLUMN_FILE, &file, -1);
           if (G_LIKELY (file != NULL))
             {
-              /* check if the file accepts the drop */
-              actions = thunar_file_accepts_drop (file, view->drop_file_list, context, action_return);
+              /* check if the file accepts the drop, only a sample of the
+               * dragged files is looked at until they are dropped */
+              if (validate)
+                actions = thunar_file_accepts_drop (file, view->drop_file_list, context, action_return);
+              else
+                actions = thunar_dnd_accepts_drop (&view->drop_accept_cache, file, view->drop_file_list, context, action_return);
               if (G_LIKELY (actions != 0))
                 {
                   /* we can drop into this location */
@@ -1504,28 +1522,37 @@ thunar_shortcuts_view_compute_drop_actions (ThunarShortcutsView     *view,
     {
       /* check if any of the paths is not directory but only up to 100, if
        * someone drags too many directories it may slowdown or even freeze
-       * Thunar while moving the cursor.
+       * Thunar while moving the cursor. The answer does not change during
+       * the drag, so it is only determined once.
        */
-      for (lp = view->drop_file_list, n = 0; lp != NULL && n < 100; lp = lp->next, ++n)
+      if (view->drop_directories < 0)
         {
-          GFileInfo *info;
-          gboolean   is_directory;
-
-          info = g_file_query_info (lp->data,
-                                    G_FILE_ATTRIBUTE_STANDARD_TYPE,
-                                    G_FILE_QUERY_INFO_NONE,
-                                    NULL, NULL);
+          view->drop_directories = TRUE;
+          for (lp = view->drop_file_list, n = 0; lp != NULL && n < 100; lp = lp->next, ++n)
+            {
+              GFileInfo *info;
+              gboolean   is_directory;
 
-          if (G_UNLIKELY (info == NULL))
-            return 0;
+              info = g_file_query_info (lp->data,
+                                        G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        NULL, NULL);
 
-          is_directory = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY;
-          g_object_unref (info);
+              is_directory = info != NULL && g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY;
+              if (info != NULL)
+                g_object_unref (info);
 
-          if (!is_directory)
-            return 0;
+              if (!is_directory)
+                {
+                  view->drop_directories = FALSE;
+                  break;
+                }
+            }
         }
 
+      if (!view->drop_directories)
+        return 0;
+
       /* check the action that should be performed */
       if (gdk_drag_context_get_suggested_action (context) == GDK_ACTION_LINK || (gdk_drag_context_get_actions (context) & GDK_ACTION_LINK) != 0)
         actions = GDK_ACTION_LINK;
@@ -35,9 +35,11 @@
 
 #include <gobject/gvaluecollector.h>
 
+#include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-simple-job.h>
+#include <thunar/thunar-trace.h>
 
 
 
@@ -69,14 +71,14 @@ G_DEFINE_TYPE (ThunarSimpleJob, thunar_simple_job, THUNAR_TYPE_JOB)
 static void
 thunar_simple_job_class_init (ThunarSimpleJobClass *klass)
 {
-  GObjectClass *gobject_class;
-  ExoJobClass  *exojob_class;
+  GObjectClass   *gobject_class;
+  ThunarJobClass *thunarjob_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_simple_job_finalize;
 
-  exojob_class = EXO_JOB_CLASS (klass);
-  exojob_class->execute = thunar_simple_job_execute;
+  thunarjob_class = THUNAR_JOB_CLASS (klass);
+  thunarjob_class->execute = thunar_simple_job_execute;
 }
 
 
@@ -111,13 +113,23 @@ thunar_simple_job_execute (ExoJob  *job,
   ThunarSimpleJob *simple_job = THUNAR_SIMPLE_JOB (job);
   gboolean         success = TRUE;
   GError          *err = NULL;
+  gint64           trace_begin;
 
   _thunar_return_val_if_fail (THUNAR_IS_SIMPLE_JOB (job), FALSE);
   _thunar_return_val_if_fail (simple_job->func != NULL, FALSE);
 
+  trace_begin = THUNAR_TRACE_BEGIN ();
+
   /* try to execute the job using the supplied function */
   success = (*simple_job->func) (THUNAR_JOB (job), simple_job->param_values, &err);
 
+  /* most simple jobs take their file list as first parameter */
+  THUNAR_TRACE_MARK (trace_begin, "simple-job", "%u files%s",
+                     (simple_job->param_values->len > 0
+                      && G_VALUE_HOLDS (&g_array_index (simple_job->param_values, GValue, 0), THUNAR_TYPE_G_FILE_LIST))
+                     ? g_list_length (g_value_get_boxed (&g_array_index (simple_job->param_values, GValue, 0))) : 0,
+                     success ? "" : ", failed");
+
   if (!success)
     {
       g_assert (err != NULL || exo_job_is_cancelled (job));
@@ -152,7 +164,7 @@ thunar_simple_job_execute (ExoJob  *job,
  * Allocates a new #ThunarSimpleJob, which executes the specified
  * @func with the specified parameters.
  *
- * Use exo_job_launch() to launch the returned job..
+ * Use thunar_job_launch() to launch the returned job..
  *
  * For example the listdir @func expects a #ThunarPath for the
  * folder to list, so the call to thunar_simple_job_new()
@@ -161,7 +173,7 @@ thunar_simple_job_execute (ExoJob  *job,
  * <informalexample><programlisting>
  * job = thunar_simple_job_new (_thunar_io_jobs_listdir, 1,
  *                              THUNAR_TYPE_PATH, path);
- * exo_job_launch (EXO_JOB (job));
+ * thunar_job_launch (job);
  * </programlisting></informalexample>
  *
  * The caller is responsible to release the returned object using
@@ -0,0 +1,448 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-size-cache.h>
+
+
+
+/* The cache remembers, for every local folder counted by a deep count
+ * job, the size and number of the files directly inside the folder and
+ * the names and modification times of its subfolders. An entry is valid
+ * as long as the modification time of the folder did not change, which
+ * happens when entries are added, removed or renamed, and neither did
+ * those of its subfolders. Files which are modified in place are caught
+ * by the folder monitors, see thunar_size_cache_invalidate().
+ *
+ * A cache file holds a header, followed by the records, each followed by
+ * the NUL-terminated names of the subfolders, every name followed by the
+ * modification time of the subfolder. */
+#define THUNAR_SIZE_CACHE_MAGIC       "THUNRDSZ"
+#define THUNAR_SIZE_CACHE_VERSION     2
+#define THUNAR_SIZE_CACHE_FILENAME    "Thunar/folder-sizes"
+
+/* the cache starts over once it holds this many folders */
+#define THUNAR_SIZE_CACHE_MAX_ENTRIES 500000
+
+/* folders modified within this many seconds are not cached, since
+ * another change in the same second would go unnoticed */
+#define THUNAR_SIZE_CACHE_RACY_TIME   2
+
+
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 n_entries;
+}
+ThunarSizeCacheHeader;
+
+typedef struct
+{
+  guint64 device;
+  guint64 inode;
+  gint64  mtime;
+  guint64 size;
+  guint32 n_files;
+  guint32 n_subdirs;
+}
+ThunarSizeCacheRecord;
+
+typedef struct
+{
+  ThunarSizeCacheRecord record;
+  gchar               **subdirs;
+  gint64               *subdir_mtimes;
+}
+ThunarSizeCacheEntry;
+
+
+
+/* the cache is used by several deep count jobs at once */
+G_LOCK_DEFINE_STATIC (size_cache);
+
+static GHashTable *size_cache = NULL;
+static GArray     *size_cache_invalidated = NULL; /* keys invalidated before the cache was loaded */
+static gboolean    size_cache_loaded = FALSE;
+static gboolean    size_cache_dirty = FALSE;
+
+
+
+static guint
+thunar_size_cache_hash (gconstpointer key)
+{
+  const ThunarSizeCacheRecord *record = key;
+
+  return (guint) (record->inode ^ (record->inode >> 32) ^ (record->device * 31));
+}
+
+
+
+static gboolean
+thunar_size_cache_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const ThunarSizeCacheRecord *record_a = a;
+  const ThunarSizeCacheRecord *record_b = b;
+
+  return record_a->inode == record_b->inode && record_a->device == record_b->device;
+}
+
+
+
+static void
+thunar_size_cache_entry_free (gpointer data)
+{
+  ThunarSizeCacheEntry *entry = data;
+
+  g_strfreev (entry->subdirs);
+  g_free (entry->subdir_mtimes);
+  g_slice_free (ThunarSizeCacheEntry, entry);
+}
+
+
+
+static void
+thunar_size_cache_insert (ThunarSizeCacheEntry *entry)
+{
+  if (g_hash_table_size (size_cache) >= THUNAR_SIZE_CACHE_MAX_ENTRIES)
+    g_hash_table_remove_all (size_cache);
+
+  /* the record is the key of the entry */
+  g_hash_table_replace (size_cache, &entry->record, entry);
+}
+
+
+
+static void
+thunar_size_cache_parse (const gchar *data,
+                         gsize        length)
+{
+  ThunarSizeCacheHeader  header;
+  ThunarSizeCacheEntry  *entry;
+  const gchar           *p = data + sizeof (header);
+  const gchar           *end = data + length;
+  const gchar           *name_end;
+  guint32                n, i;
+
+  if (length < sizeof (header))
+    return;
+
+  memcpy (&header, data, sizeof (header));
+  if (memcmp (header.magic, THUNAR_SIZE_CACHE_MAGIC, sizeof (header.magic)) != 0
+      || header.version != THUNAR_SIZE_CACHE_VERSION)
+    return;
+
+  for (n = 0; n < header.n_entries; ++n)
+    {
+      /* don't trust the file, it could be truncated or corrupt */
+      if ((gsize) (end - p) < sizeof (ThunarSizeCacheRecord))
+        return;
+
+      entry = g_slice_new (ThunarSizeCacheEntry);
+      memcpy (&entry->record, p, sizeof (ThunarSizeCacheRecord));
+      p += sizeof (ThunarSizeCacheRecord);
+
+      if (entry->record.n_subdirs > (gsize) (end - p))
+        {
+          g_slice_free (ThunarSizeCacheEntry, entry);
+          return;
+        }
+
+      entry->subdirs = g_new0 (gchar *, entry->record.n_subdirs + 1);
+      entry->subdir_mtimes = g_new0 (gint64, entry->record.n_subdirs);
+      for (i = 0; i < entry->record.n_subdirs; ++i)
+        {
+          name_end = memchr (p, '\0', end - p);
+          if (name_end == NULL || (gsize) (end - name_end - 1) < sizeof (gint64))
+            {
+              thunar_size_cache_entry_free (entry);
+              return;
+            }
+
+          entry->subdirs[i] = g_strndup (p, name_end - p);
+          memcpy (&entry->subdir_mtimes[i], name_end + 1, sizeof (gint64));
+          p = name_end + 1 + sizeof (gint64);
+        }
+
+      thunar_size_cache_insert (entry);
+    }
+}
+
+
+
+static void
+thunar_size_cache_load (void)
+{
+  gchar *filename;
+  gchar *data;
+  gsize  length;
+  guint  n;
+
+  if (G_LIKELY (size_cache_loaded))
+    return;
+
+  size_cache_loaded = TRUE;
+  size_cache = g_hash_table_new_full (thunar_size_cache_hash, thunar_size_cache_equal,
+                                      NULL, thunar_size_cache_entry_free);
+
+  filename = xfce_resource_lookup (XFCE_RESOURCE_CACHE, THUNAR_SIZE_CACHE_FILENAME);
+  if (filename != NULL && g_file_get_contents (filename, &data, &length, NULL))
+    {
+      thunar_size_cache_parse (data, length);
+      g_free (data);
+    }
+  g_free (filename);
+
+  /* apply the changes seen while the cache was not loaded */
+  if (size_cache_invalidated != NULL)
+    {
+      for (n = 0; n < size_cache_invalidated->len; ++n)
+        if (g_hash_table_remove (size_cache, &g_array_index (size_cache_invalidated, ThunarSizeCacheRecord, n)))
+          size_cache_dirty = TRUE;
+
+      g_array_free (size_cache_invalidated, TRUE);
+      size_cache_invalidated = NULL;
+    }
+}
+
+
+
+/**
+ * thunar_size_cache_lookup:
+ * @device               : the device of the folder.
+ * @inode                : the inode number of the folder.
+ * @mtime                : the current modification time of the folder.
+ * @size_return          : return location for the size of the files in the folder.
+ * @n_files_return       : return location for the number of files in the folder.
+ * @subdirs_return       : return location for the names of the subfolders.
+ * @subdir_mtimes_return : return location for the modification times of the subfolders.
+ *
+ * Looks up the contents of a folder, as they were stored with
+ * thunar_size_cache_store(). The files and subfolders are only those on
+ * the same device as the folder itself. The subfolders are not included
+ * in @size_return and @n_files_return, they have entries of their own.
+ * The caller has to compare the current modification times of the
+ * subfolders with @subdir_mtimes_return before using the entry.
+ *
+ * Return value: %TRUE if the folder is known and did not change since,
+ *               free @subdirs_return with g_strfreev() and
+ *               @subdir_mtimes_return with g_free() then.
+ **/
+gboolean
+thunar_size_cache_lookup (guint64   device,
+                          guint64   inode,
+                          gint64    mtime,
+                          guint64  *size_return,
+                          guint    *n_files_return,
+                          gchar  ***subdirs_return,
+                          gint64  **subdir_mtimes_return)
+{
+  ThunarSizeCacheRecord  key;
+  ThunarSizeCacheEntry  *entry;
+  gboolean               found = FALSE;
+
+  key.device = device;
+  key.inode = inode;
+
+  G_LOCK (size_cache);
+
+  thunar_size_cache_load ();
+
+  entry = g_hash_table_lookup (size_cache, &key);
+  if (entry != NULL && entry->record.mtime == mtime)
+    {
+      *size_return = entry->record.size;
+      *n_files_return = entry->record.n_files;
+      *subdirs_return = g_strdupv (entry->subdirs);
+      *subdir_mtimes_return = g_new (gint64, MAX (entry->record.n_subdirs, 1));
+      memcpy (*subdir_mtimes_return, entry->subdir_mtimes, entry->record.n_subdirs * sizeof (gint64));
+      found = TRUE;
+    }
+
+  G_UNLOCK (size_cache);
+
+  return found;
+}
+
+
+
+/**
+ * thunar_size_cache_store:
+ * @device        : the device of the folder.
+ * @inode         : the inode number of the folder.
+ * @mtime         : the modification time of the folder before it was read.
+ * @size          : the size of the files in the folder.
+ * @n_files       : the number of files in the folder.
+ * @subdirs       : the %NULL-terminated names of the subfolders.
+ * @subdir_mtimes : the modification times of the @subdirs.
+ *
+ * Remembers the contents of a folder for thunar_size_cache_lookup(),
+ * see there. Folders which were modified very recently are ignored.
+ * The cache is written to disk with thunar_size_cache_save().
+ **/
+void
+thunar_size_cache_store (guint64             device,
+                         guint64             inode,
+                         gint64              mtime,
+                         guint64             size,
+                         guint               n_files,
+                         const gchar *const *subdirs,
+                         const gint64       *subdir_mtimes)
+{
+  ThunarSizeCacheEntry *entry;
+
+  if (mtime > g_get_real_time () / G_USEC_PER_SEC - THUNAR_SIZE_CACHE_RACY_TIME)
+    return;
+
+  entry = g_slice_new (ThunarSizeCacheEntry);
+  entry->record.device = device;
+  entry->record.inode = inode;
+  entry->record.mtime = mtime;
+  entry->record.size = size;
+  entry->record.n_files = n_files;
+  entry->record.n_subdirs = g_strv_length ((gchar **) subdirs);
+  entry->subdirs = g_strdupv ((gchar **) subdirs);
+  entry->subdir_mtimes = g_new (gint64, MAX (entry->record.n_subdirs, 1));
+  memcpy (entry->subdir_mtimes, subdir_mtimes, entry->record.n_subdirs * sizeof (gint64));
+
+  G_LOCK (size_cache);
+
+  thunar_size_cache_load ();
+  thunar_size_cache_insert (entry);
+  size_cache_dirty = TRUE;
+
+  G_UNLOCK (size_cache);
+}
+
+
+
+/**
+ * thunar_size_cache_invalidate:
+ * @directory : a #GFile.
+ *
+ * Drops the cached contents of @directory, for example because one of
+ * its files was modified in place, which leaves the modification time
+ * of the folder untouched. Only the folder itself is invalidated, the
+ * cached entries of its parents do not include the files of @directory.
+ **/
+void
+thunar_size_cache_invalidate (GFile *directory)
+{
+  ThunarSizeCacheRecord key;
+  const gchar          *path;
+  GStatBuf              statb;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+
+  path = g_file_peek_path (directory);
+  if (path == NULL || g_stat (path, &statb) != 0)
+    return;
+
+  key.device = statb.st_dev;
+  key.inode = statb.st_ino;
+
+  G_LOCK (size_cache);
+
+  if (size_cache_loaded)
+    {
+      if (g_hash_table_remove (size_cache, &key))
+        size_cache_dirty = TRUE;
+    }
+  else
+    {
+      /* don't read the cache file for this, but remember the key */
+      if (size_cache_invalidated == NULL)
+        size_cache_invalidated = g_array_new (FALSE, FALSE, sizeof (ThunarSizeCacheRecord));
+      g_array_append_val (size_cache_invalidated, key);
+    }
+
+  G_UNLOCK (size_cache);
+}
+
+
+
+/**
+ * thunar_size_cache_save:
+ *
+ * Writes the cache to disk, if it changed since it was loaded.
+ **/
+void
+thunar_size_cache_save (void)
+{
+  ThunarSizeCacheHeader  header;
+  ThunarSizeCacheEntry  *entry;
+  GHashTableIter         iter;
+  GByteArray            *data;
+  gchar                 *filename;
+  guint                  n;
+
+  G_LOCK (size_cache);
+
+  if (!size_cache_dirty)
+    {
+      G_UNLOCK (size_cache);
+      return;
+    }
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, THUNAR_SIZE_CACHE_MAGIC, sizeof (header.magic));
+  header.version = THUNAR_SIZE_CACHE_VERSION;
+  header.n_entries = g_hash_table_size (size_cache);
+
+  data = g_byte_array_sized_new (sizeof (header) + header.n_entries * sizeof (ThunarSizeCacheRecord));
+  g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+
+  g_hash_table_iter_init (&iter, size_cache);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry))
+    {
+      g_byte_array_append (data, (const guint8 *) &entry->record, sizeof (ThunarSizeCacheRecord));
+      for (n = 0; n < entry->record.n_subdirs; ++n)
+        {
+          g_byte_array_append (data, (const guint8 *) entry->subdirs[n], strlen (entry->subdirs[n]) + 1);
+          g_byte_array_append (data, (const guint8 *) &entry->subdir_mtimes[n], sizeof (gint64));
+        }
+    }
+
+  size_cache_dirty = FALSE;
+
+  G_UNLOCK (size_cache);
+
+  /* replaced atomically, so other processes never read a partial cache */
+  filename = xfce_resource_save_location (XFCE_RESOURCE_CACHE, THUNAR_SIZE_CACHE_FILENAME, TRUE);
+  if (filename != NULL)
+    g_file_set_contents (filename, (const gchar *) data->data, data->len, NULL);
+  g_free (filename);
+
+  g_byte_array_unref (data);
+}
@@ -0,0 +1,50 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SIZE_CACHE_H__
+#define __THUNAR_SIZE_CACHE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean thunar_size_cache_lookup     (guint64             device,
+                                       guint64             inode,
+                                       gint64              mtime,
+                                       guint64            *size_return,
+                                       guint              *n_files_return,
+                                       gchar            ***subdirs_return,
+                                       gint64            **subdir_mtimes_return);
+
+void     thunar_size_cache_store      (guint64             device,
+                                       guint64             inode,
+                                       gint64              mtime,
+                                       guint64             size,
+                                       guint               n_files,
+                                       const gchar *const *subdirs,
+                                       const gint64       *subdir_mtimes);
+
+void     thunar_size_cache_invalidate (GFile              *directory);
+
+void     thunar_size_cache_save       (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_SIZE_CACHE_H__ */
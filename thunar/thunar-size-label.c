@@ -208,12 +208,11 @@ thunar_size_label_finalize (GObject *object)
 {
   ThunarSizeLabel *size_label = THUNAR_SIZE_LABEL (object);
 
-  /* cancel the pending job (if any) */
+  /* give up the pending job (if any) */
   if (G_UNLIKELY (size_label->job != NULL))
     {
       g_signal_handlers_disconnect_matched (G_OBJECT (size_label->job), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, size_label);
-      exo_job_cancel (EXO_JOB (size_label->job));
-      g_object_unref (size_label->job);
+      thunar_deep_count_job_release (size_label->job);
     }
 
   /* reset the file property */
@@ -295,12 +294,11 @@ thunar_size_label_button_press_event (GtkWidget       *ebox,
   /* left button press on the spinner cancels the calculation */
   if (G_LIKELY (event->button == 1))
     {
-      /* cancel the pending job (if any) */
+      /* give up the pending job (if any), it's cancelled unless other labels use it */
       if (G_UNLIKELY (size_label->job != NULL))
         {
           g_signal_handlers_disconnect_matched (size_label->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, size_label);
-          exo_job_cancel (EXO_JOB (size_label->job));
-          g_object_unref (size_label->job);
+          thunar_deep_count_job_release (size_label->job);
           size_label->job = NULL;
         }
 
@@ -325,17 +323,21 @@ thunar_size_label_files_changed (ThunarSizeLabel *size_label)
 {
   gchar             *size_string;
   guint64            size;
+  guint64            total_size;
+  guint              file_count;
+  guint              directory_count;
+  guint              unreadable_directory_count;
+  gboolean           done;
 
   _thunar_return_if_fail (THUNAR_IS_SIZE_LABEL (size_label));
   _thunar_return_if_fail (size_label->files != NULL);
   _thunar_return_if_fail (THUNAR_IS_FILE (size_label->files->data));
 
-  /* cancel the pending job (if any) */
+  /* give up the pending job (if any) */
   if (G_UNLIKELY (size_label->job != NULL))
     {
       g_signal_handlers_disconnect_matched (size_label->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, size_label);
-      exo_job_cancel (EXO_JOB (size_label->job));
-      g_object_unref (size_label->job);
+      thunar_deep_count_job_release (size_label->job);
       size_label->job = NULL;
     }
 
@@ -343,19 +345,36 @@ thunar_size_label_files_changed (ThunarSizeLabel *size_label)
   if (size_label->files->next != NULL
       || thunar_file_is_directory (THUNAR_FILE (size_label->files->data)))
     {
-      /* schedule a new job to determine the total size of the directory (not following symlinks) */
-      size_label->job = thunar_deep_count_job_new (size_label->files, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS);
+      /* determine the total size of the directory (not following symlinks), the
+       * job is shared with the other labels counting the same files */
+      size_label->job = thunar_deep_count_job_acquire (size_label->files, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS);
+      done = thunar_deep_count_job_get_status (size_label->job, &total_size, &file_count,
+                                               &directory_count, &unreadable_directory_count);
+      if (done)
+        {
+          /* counted a moment ago, show the result right away */
+          gtk_spinner_stop (GTK_SPINNER (size_label->spinner));
+          gtk_widget_hide (size_label->spinner);
+          thunar_size_label_status_update (size_label->job, total_size, file_count,
+                                           directory_count, unreadable_directory_count, size_label);
+
+          thunar_deep_count_job_release (size_label->job);
+          size_label->job = NULL;
+          return;
+        }
+
       g_signal_connect (size_label->job, "error", G_CALLBACK (thunar_size_label_error), size_label);
       g_signal_connect (size_label->job, "finished", G_CALLBACK (thunar_size_label_finished), size_label);
       g_signal_connect (size_label->job, "status-update", G_CALLBACK (thunar_size_label_status_update), size_label);
 
-      /* tell the user that we started calculation */
-      gtk_label_set_text (GTK_LABEL (size_label->label), _("Calculating..."));
+      /* tell the user that we started calculation, or what another label counted so far */
+      if (file_count + directory_count + unreadable_directory_count > 0)
+        thunar_size_label_status_update (size_label->job, total_size, file_count,
+                                         directory_count, unreadable_directory_count, size_label);
+      else
+        gtk_label_set_text (GTK_LABEL (size_label->label), _("Calculating..."));
       gtk_spinner_start (GTK_SPINNER (size_label->spinner));
       gtk_widget_show (size_label->spinner);
-
-      /* launch the job */
-      exo_job_launch (EXO_JOB (size_label->job));
     }
   else
     {
@@ -404,7 +423,7 @@ thunar_size_label_finished (ExoJob          *job,
 
   /* disconnect from the job */
   g_signal_handlers_disconnect_matched (size_label->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, size_label);
-  g_object_unref (size_label->job);
+  thunar_deep_count_job_release (size_label->job);
   size_label->job = NULL;
 }
 
@@ -424,6 +443,8 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
   gchar             *text;
   guint              n;
   gchar             *unreable_text;
+  gchar             *reported_text;
+  gboolean           reported;
 
   _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
   _thunar_return_if_fail (THUNAR_IS_SIZE_LABEL (size_label));
@@ -431,6 +452,7 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
 
   /* determine the total number of items */
   n = file_count + directory_count + unreadable_directory_count;
+  reported = thunar_deep_count_job_is_reported (job);
 
   if (G_LIKELY (n > unreadable_directory_count))
     {
@@ -442,6 +464,11 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
           gtk_label_set_text (GTK_LABEL (size_label->label), text);
           g_free (size_string);
         }
+      else if (reported)
+        {
+          /* the filesystem doesn't tell files and folders apart */
+          text = g_strdup_printf (ngettext ("%u item", "%u items", n), n);
+        }
       else /* if (size_label->type == THUNAR_SIZE_LABEL_CONTENT) */
         {
           folder_size_string = g_strdup_printf (ngettext ("%d folder", "%d folders", directory_count ), directory_count);
@@ -461,6 +488,15 @@ thunar_size_label_status_update (ThunarDeepCountJob *job,
           text = unreable_text;
         }
 
+      if (reported)
+        {
+          /* TRANSLATORS: this is shown if the deep count took the size of
+           * mount points or quota folders from their file system */
+          reported_text = g_strconcat (text, "\n", _("(as reported by the file system)"), NULL);
+          g_free (text);
+          text = reported_text;
+        }
+
       gtk_label_set_text (GTK_LABEL (size_label->label), text);
       g_free (text);
     }
@@ -522,7 +558,10 @@ thunar_size_label_set_files (ThunarSizeLabel *size_label,
       _thunar_assert (THUNAR_IS_FILE (lp->data));
 
       g_object_ref (G_OBJECT (lp->data));
-      g_signal_connect_swapped (G_OBJECT (lp->data), "changed", G_CALLBACK (thunar_size_label_files_changed), size_label);
+
+      /* after the shared deep count jobs dropped the changed file */
+      g_signal_connect_data (G_OBJECT (lp->data), "changed", G_CALLBACK (thunar_size_label_files_changed),
+                             size_label, NULL, G_CONNECT_SWAPPED | G_CONNECT_AFTER);
     }
 
   if (size_label->files != NULL)
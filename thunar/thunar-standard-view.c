@@ -40,6 +40,7 @@
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-dnd.h>
 #include <thunar/thunar-enum-types.h>
+#include <thunar/thunar-free-space-cache.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-gtk-extensions.h>
@@ -48,12 +49,15 @@
 #include <thunar/thunar-text-renderer.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-pango-extensions.h>
+#include <thunar/thunar-prefetcher.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-properties-dialog.h>
 #include <thunar/thunar-renamer-dialog.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-standard-view.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-thumbnailer.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-util.h>
 #include <thunar/thunar-details-view.h>
 
@@ -63,6 +67,13 @@
 
 
 
+/* share of a frame (1 / n) which applying the changed files of the
+ * model may take, and the frame length (in us) of unknown displays */
+#define THUNAR_STANDARD_VIEW_CHANGES_FRAME_SHARE 4
+#define THUNAR_STANDARD_VIEW_FRAME_INTERVAL      16667
+
+
+
 /* Property identifiers */
 enum
 {
@@ -166,6 +177,7 @@ static GdkDragAction        thunar_standard_view_get_dest_actions           (Thu
                                                                              gint                      x,
                                                                              gint                      y,
                                                                              guint                     timestamp,
+                                                                             gboolean                  validate,
                                                                              ThunarFile              **file_return);
 static ThunarFile          *thunar_standard_view_get_drop_file              (ThunarStandardView       *standard_view,
                                                                              gint                      x,
@@ -189,6 +201,13 @@ static void                 thunar_standard_view_new_files                  (Thu
 static gboolean             thunar_standard_view_button_release_event       (GtkWidget                *view,
                                                                              GdkEventButton           *event,
                                                                              ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_scroll_restore_stop        (ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_hover_motion_notify_event  (GtkWidget                *view,
+                                                                             GdkEventMotion           *event,
+                                                                             ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_hover_leave_notify_event   (GtkWidget                *view,
+                                                                             GdkEventCrossing         *event,
+                                                                             ThunarStandardView       *standard_view);
 static gboolean             thunar_standard_view_motion_notify_event        (GtkWidget                *view,
                                                                              GdkEventMotion           *event,
                                                                              ThunarStandardView       *standard_view);
@@ -254,6 +273,11 @@ static void                 thunar_standard_view_error                      (Thu
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_search_done                (ThunarListModel          *model,
                                                                              ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_changes_pending            (ThunarListModel          *model,
+                                                                             ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_apply_changes              (GtkWidget                *widget,
+                                                                             GdkFrameClock            *frame_clock,
+                                                                             gpointer                  user_data);
 static void                 thunar_standard_view_sort_column_changed        (GtkTreeSortable          *tree_sortable,
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_loading_unbound            (gpointer                  user_data);
@@ -275,6 +299,8 @@ static void                 thunar_standard_view_thumbnail_mode_toggled     (Thu
                                                                              ThunarIconFactory        *icon_factory);
 static void                 thunar_standard_view_scrolled                   (GtkAdjustment            *adjustment,
                                                                              ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_load_more                  (GtkAdjustment            *adjustment,
+                                                                             ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_size_allocate              (ThunarStandardView       *standard_view,
                                                                              GtkAllocation            *allocation);
 static void                 thunar_standard_view_connect_accelerators       (ThunarStandardView       *standard_view);
@@ -317,6 +343,15 @@ struct _ThunarStandardViewPrivate
   /* scroll_to_file support */
   GHashTable             *scroll_to_files;
 
+  /* scroll position restored while the folder is still loading */
+  GFile                  *scroll_restore_target;
+  ThunarFile             *scroll_restore_file;
+  gulong                  scroll_restore_id;
+  guint                   scroll_restore_idle_id;
+
+  /* folder of the parent directory, kept alive while browsing its children */
+  ThunarFolder           *parent_folder;
+
   /* statusbar */
   gchar                  *statusbar_text;
   guint                   statusbar_text_idle_id;
@@ -334,6 +369,7 @@ struct _ThunarStandardViewPrivate
   guint                   drop_highlight : 1;
   guint                   drop_occurred : 1;   /* whether the data was dropped */
   GList                  *drop_file_list;      /* the list of URIs that are contained in the drop data */
+  ThunarDndAcceptCache    drop_accept_cache;   /* accept decision shown during drag-motion */
 
   /* the "new-files" closure, which is used to select files whenever
    * new files are created by a ThunarJob associated with this view
@@ -359,16 +395,34 @@ struct _ThunarStandardViewPrivate
   GList                  *selected_files;
   guint                   restore_selection_idle_id;
 
+  /* inactive tabs release their folder, see thunar_standard_view_suspend() */
+  gboolean                suspended;
+  GList                  *suspended_selection;
+
   /* support for generating thumbnails */
   ThunarThumbnailer      *thumbnailer;
   guint                   thumbnail_request;
   guint                   thumbnail_source_id;
   gboolean                thumbnailing_scheduled;
 
+  /* the free space shown in the statusbar */
+  ThunarFreeSpaceCache   *free_space_cache;
+
+  /* range and scroll direction of the running thumbnail request */
+  gint                    thumbnail_first;
+  gint                    thumbnail_last;
+  gint                    thumbnail_direction;
+  gboolean                thumbnail_lazy;
+  gint                    thumbnail_scroll_direction;
+  gdouble                 thumbnail_scroll_value[2];
+
   /* row insert and delete signal IDs, for blocking/unblocking */
   gulong                  row_changed_id;
   gulong                  row_deleted_id;
 
+  /* tick callback applying the changed files of the model */
+  guint                   changes_tick_id;
+
   /* current sort column ID and it's fallback
    * the default is only relevant for directory specific settings */
   ThunarColumn            sort_column;
@@ -830,6 +884,10 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   g_signal_connect (G_OBJECT (standard_view->model), "rows-reordered", G_CALLBACK (thunar_standard_view_rows_reordered), standard_view);
   g_signal_connect (G_OBJECT (standard_view->model), "error", G_CALLBACK (thunar_standard_view_error), standard_view);
   g_signal_connect (G_OBJECT (standard_view->model), "search-done", G_CALLBACK (thunar_standard_view_search_done), standard_view);
+
+  /* apply changed files within a part of each frame, so busy folders do not stall drawing */
+  thunar_list_model_freeze_changes (standard_view->model);
+  g_signal_connect (G_OBJECT (standard_view->model), "changes-pending", G_CALLBACK (thunar_standard_view_changes_pending), standard_view);
   g_object_bind_property (G_OBJECT (standard_view->preferences), "misc-case-sensitive", G_OBJECT (standard_view->model), "case-sensitive", G_BINDING_SYNC_CREATE);
   g_object_bind_property (G_OBJECT (standard_view->preferences), "misc-date-style", G_OBJECT (standard_view->model), "date-style", G_BINDING_SYNC_CREATE);
   g_object_bind_property (G_OBJECT (standard_view->preferences), "misc-date-custom-style", G_OBJECT (standard_view->model), "date-custom-style", G_BINDING_SYNC_CREATE);
@@ -838,6 +896,7 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   g_object_bind_property (G_OBJECT (standard_view->preferences), "misc-folder-item-count", G_OBJECT (standard_view->model), "folder-item-count", G_BINDING_SYNC_CREATE);
 
   standard_view->priv->thumbnail_request = 0;
+  standard_view->priv->thumbnail_scroll_direction = 1;
 
   /* setup the icon renderer */
   standard_view->icon_renderer = thunar_icon_renderer_new ();
@@ -876,6 +935,10 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   /* be sure to update the statusbar text whenever the file-size-binary property changes */
   g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::file-size-binary", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
 
+  /* the free space in the statusbar is looked up in the background */
+  standard_view->priv->free_space_cache = thunar_free_space_cache_get_default ();
+  g_signal_connect_swapped (G_OBJECT (standard_view->priv->free_space_cache), "changed", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
+
   /* connect to size allocation signals for generating thumbnail requests */
   g_signal_connect_after (G_OBJECT (standard_view), "size-allocate",
                           G_CALLBACK (thunar_standard_view_size_allocate), NULL);
@@ -953,6 +1016,10 @@ thunar_standard_view_constructor (GType                  type,
   /* need to catch certain keys for the internal view widget */
   g_signal_connect (G_OBJECT (view), "key-press-event", G_CALLBACK (thunar_standard_view_key_press_event), object);
 
+  /* load a folder the pointer rests on ahead of time */
+  g_signal_connect (G_OBJECT (view), "motion-notify-event", G_CALLBACK (thunar_standard_view_hover_motion_notify_event), object);
+  g_signal_connect (G_OBJECT (view), "leave-notify-event", G_CALLBACK (thunar_standard_view_hover_leave_notify_event), object);
+
   /* setup the real view as drop site */
   gtk_drag_dest_set (view, 0, drop_targets, G_N_ELEMENTS (drop_targets), GDK_ACTION_ASK | GDK_ACTION_COPY | GDK_ACTION_LINK | GDK_ACTION_MOVE);
   g_signal_connect (G_OBJECT (view), "drag-drop", G_CALLBACK (thunar_standard_view_drag_drop), object);
@@ -971,9 +1038,13 @@ thunar_standard_view_constructor (GType                  type,
   adjustment = gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (standard_view));
   g_signal_connect (adjustment, "value-changed",
                     G_CALLBACK (thunar_standard_view_scrolled), object);
+  g_signal_connect (adjustment, "changed",
+                    G_CALLBACK (thunar_standard_view_load_more), object);
   adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view));
   g_signal_connect (adjustment, "value-changed",
                     G_CALLBACK (thunar_standard_view_scrolled), object);
+  g_signal_connect (adjustment, "changed",
+                    G_CALLBACK (thunar_standard_view_load_more), object);
 
   /* synchronise the "directory-specific-settings" property with the global "misc-directory-specific-settings" property */
   g_object_bind_property (standard_view->preferences, "misc-directory-specific-settings",
@@ -994,6 +1065,13 @@ thunar_standard_view_dispose (GObject *object)
   /* cancel pending thumbnail sources and requests */
   thunar_standard_view_cancel_thumbnailing (standard_view);
 
+  /* stop applying changed files */
+  if (standard_view->priv->changes_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (standard_view), standard_view->priv->changes_tick_id);
+      standard_view->priv->changes_tick_id = 0;
+    }
+
   /* unregister the "loading" binding */
   if (G_UNLIKELY (standard_view->loading_binding != NULL))
     {
@@ -1001,6 +1079,9 @@ thunar_standard_view_dispose (GObject *object)
       standard_view->loading_binding = NULL;
     }
 
+  /* stop following the restored scroll position */
+  thunar_standard_view_scroll_restore_stop (standard_view);
+
   /* be sure to cancel any pending drag autoscroll timer */
   if (G_UNLIKELY (standard_view->priv->drag_scroll_timer_id != 0))
     g_source_remove (standard_view->priv->drag_scroll_timer_id);
@@ -1046,18 +1127,28 @@ thunar_standard_view_finalize (GObject *object)
   g_signal_handlers_disconnect_by_func (standard_view->priv->thumbnailer, thunar_standard_view_finished_thumbnailing, standard_view);
   g_object_unref (standard_view->priv->thumbnailer);
 
+  /* release the free space cache */
+  g_signal_handlers_disconnect_by_func (standard_view->priv->free_space_cache, thunar_standard_view_update_statusbar_text, standard_view);
+  g_object_unref (standard_view->priv->free_space_cache);
+
   /* release the scroll_to_file reference (if any) */
   if (G_UNLIKELY (standard_view->priv->scroll_to_file != NULL))
     g_object_unref (G_OBJECT (standard_view->priv->scroll_to_file));
 
+  /* release the parent folder (if any) */
+  if (standard_view->priv->parent_folder != NULL)
+    g_object_unref (standard_view->priv->parent_folder);
+
   /* release the selected_files list (if any) */
   thunar_g_list_free_full (standard_view->priv->selected_files);
+  thunar_g_list_free_full (standard_view->priv->suspended_selection);
 
   /* release the drag path list (just in case the drag-end wasn't fired before) */
   thunar_g_list_free_full (standard_view->priv->drag_g_file_list);
 
   /* release the drop path list (just in case the drag-leave wasn't fired before) */
   thunar_g_list_free_full (standard_view->priv->drop_file_list);
+  thunar_dnd_accept_cache_clear (&standard_view->priv->drop_accept_cache);
 
   /* release the history */
   g_object_unref (standard_view->priv->history);
@@ -1332,11 +1423,17 @@ thunar_standard_view_draw (GtkWidget      *widget,
   gboolean result = FALSE;
   GtkAllocation a;
   GtkStyleContext *context;
+  gint64 start_time;
+  guint64 n_values;
 
-  /* let the scrolled window do it's work */
+  /* let the scrolled window do it's work, timing the frames of the views */
+  start_time = g_get_monotonic_time ();
+  n_values = thunar_stats_counter_get_value (THUNAR_STATS_LIST_MODEL_GET_VALUE);
   cairo_save (cr);
   result = (*GTK_WIDGET_CLASS (thunar_standard_view_parent_class)->draw) (widget, cr);
   cairo_restore (cr);
+  thunar_stats_record_since (THUNAR_STATS_VIEW_FRAME, start_time);
+  thunar_stats_record (THUNAR_STATS_VIEW_FRAME_VALUES, thunar_stats_counter_get_value (THUNAR_STATS_LIST_MODEL_GET_VALUE) - n_values);
 
   /* render the folder drop shadow */
   if (G_UNLIKELY (THUNAR_STANDARD_VIEW (widget)->priv->drop_highlight))
@@ -1481,6 +1578,226 @@ thunar_standard_view_scroll_position_save (ThunarStandardView *standard_view)
 
 
 
+static void
+thunar_standard_view_scroll_position_restore (ThunarStandardView *standard_view)
+{
+  ThunarFile *current_directory;
+  ThunarFile *file;
+  GFile      *first_file;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* look for a first visible file in the hash table */
+  current_directory = thunar_navigator_get_current_directory (THUNAR_NAVIGATOR (standard_view));
+  if (G_LIKELY (current_directory != NULL))
+    {
+      first_file = g_hash_table_lookup (standard_view->priv->scroll_to_files, thunar_file_get_file (current_directory));
+      if (G_LIKELY (first_file != NULL))
+        {
+          file = thunar_file_cache_lookup (first_file);
+          if (G_LIKELY (file != NULL))
+            {
+              thunar_view_scroll_to_file (THUNAR_VIEW (standard_view), file, FALSE, TRUE, 0.0f, 0.0f);
+              g_object_unref (file);
+            }
+        }
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_scroll_restore_idle (gpointer user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (user_data);
+  GList               files;
+  GList              *paths;
+
+  standard_view->priv->scroll_restore_idle_id = 0;
+
+  /* an explicit scroll_to_file request wins */
+  if (standard_view->priv->scroll_restore_file == NULL || standard_view->priv->scroll_to_file != NULL)
+    return G_SOURCE_REMOVE;
+
+  files.data = standard_view->priv->scroll_restore_file;
+  files.next = NULL;
+  files.prev = NULL;
+
+  paths = thunar_list_model_get_paths_for_files (standard_view->model, &files);
+  if (G_LIKELY (paths != NULL))
+    {
+      (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->scroll_to_path) (standard_view, paths->data, TRUE, 0.0f, 0.0f);
+      g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_standard_view_scroll_restore_row_inserted (ThunarListModel    *model,
+                                                  GtkTreePath        *path,
+                                                  GtkTreeIter        *iter,
+                                                  ThunarStandardView *standard_view)
+{
+  ThunarFile *file;
+
+  if (standard_view->priv->scroll_restore_file == NULL)
+    {
+      file = thunar_list_model_get_file (model, iter);
+      if (!g_file_equal (thunar_file_get_file (file), standard_view->priv->scroll_restore_target))
+        {
+          g_object_unref (file);
+          return;
+        }
+      standard_view->priv->scroll_restore_file = file;
+    }
+
+  /* rows sorted in before the file push it down, so follow it once per
+   * batch of inserted rows, ahead of the redraw of the view */
+  if (standard_view->priv->scroll_restore_idle_id == 0)
+    standard_view->priv->scroll_restore_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 15, thunar_standard_view_scroll_restore_idle, standard_view, NULL);
+}
+
+
+
+static void
+thunar_standard_view_scroll_restore_start (ThunarStandardView *standard_view)
+{
+  GFile      *first_file;
+  ThunarFile *file;
+  GList       files;
+  GList      *paths;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (THUNAR_IS_FILE (standard_view->priv->current_directory));
+
+  first_file = g_hash_table_lookup (standard_view->priv->scroll_to_files, thunar_file_get_file (standard_view->priv->current_directory));
+  if (first_file == NULL)
+    return;
+
+  standard_view->priv->scroll_restore_target = g_object_ref (first_file);
+
+  /* the file may already be among the rows the folder had so far */
+  file = thunar_file_cache_lookup (first_file);
+  if (file != NULL)
+    {
+      files.data = file;
+      files.next = NULL;
+      files.prev = NULL;
+
+      paths = thunar_list_model_get_paths_for_files (standard_view->model, &files);
+      if (paths != NULL)
+        {
+          standard_view->priv->scroll_restore_file = g_object_ref (file);
+          standard_view->priv->scroll_restore_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 15, thunar_standard_view_scroll_restore_idle, standard_view, NULL);
+          g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
+        }
+      g_object_unref (file);
+    }
+
+  /* only watched while loading, and connected after the folder was set so
+   * the model still inserts the initial rows without emitting row signals */
+  standard_view->priv->scroll_restore_id =
+    g_signal_connect_after (G_OBJECT (standard_view->model), "row-inserted",
+                            G_CALLBACK (thunar_standard_view_scroll_restore_row_inserted), standard_view);
+}
+
+
+
+static void
+thunar_standard_view_scroll_restore_stop (ThunarStandardView *standard_view)
+{
+  if (standard_view->priv->scroll_restore_id != 0)
+    {
+      g_signal_handler_disconnect (standard_view->model, standard_view->priv->scroll_restore_id);
+      standard_view->priv->scroll_restore_id = 0;
+    }
+
+  if (standard_view->priv->scroll_restore_idle_id != 0)
+    {
+      g_source_remove (standard_view->priv->scroll_restore_idle_id);
+      standard_view->priv->scroll_restore_idle_id = 0;
+    }
+
+  g_clear_object (&standard_view->priv->scroll_restore_target);
+  g_clear_object (&standard_view->priv->scroll_restore_file);
+}
+
+
+
+static void
+thunar_standard_view_keep_parent_folder (ThunarStandardView *standard_view,
+                                         ThunarFolder       *previous_folder)
+{
+  ThunarFile *current_directory = standard_view->priv->current_directory;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (previous_folder == NULL || THUNAR_IS_FOLDER (previous_folder));
+
+  /* descending into a child, keep the folder we came from so going up
+   * again does not enumerate it a second time */
+  if (previous_folder != NULL && current_directory != NULL
+      && thunar_file_is_parent (thunar_folder_get_corresponding_file (previous_folder), current_directory))
+    {
+      g_object_ref (previous_folder);
+      if (standard_view->priv->parent_folder != NULL)
+        g_object_unref (standard_view->priv->parent_folder);
+      standard_view->priv->parent_folder = previous_folder;
+      return;
+    }
+
+  /* only a single folder is kept, release it once it is no longer the parent */
+  if (standard_view->priv->parent_folder != NULL
+      && (current_directory == NULL
+          || !thunar_file_is_parent (thunar_folder_get_corresponding_file (standard_view->priv->parent_folder), current_directory)))
+    g_clear_object (&standard_view->priv->parent_folder);
+}
+
+
+
+static void
+thunar_standard_view_connect_folder (ThunarStandardView *standard_view)
+{
+  ThunarFolder *folder;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (THUNAR_IS_FILE (standard_view->priv->current_directory));
+
+  /* We drop the model from the view as a simple optimization to speed up
+   * the process of disconnecting the model data from the view.
+   */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
+
+  /* open the new directory as folder */
+  folder = thunar_folder_get_for_file (standard_view->priv->current_directory);
+
+  /* connect the "loading" binding */
+  standard_view->loading_binding =
+    g_object_bind_property_full (folder,        "loading",
+                                 standard_view, "loading",
+                                 G_BINDING_SYNC_CREATE,
+                                 NULL, NULL,
+                                 standard_view,
+                                 thunar_standard_view_loading_unbound);
+
+  /* apply the new folder, ignore removal of any old files */
+  g_signal_handler_block (standard_view->model, standard_view->priv->row_deleted_id);
+  thunar_list_model_set_folder (standard_view->model, folder, NULL);
+  g_signal_handler_unblock (standard_view->model, standard_view->priv->row_deleted_id);
+  g_object_unref (G_OBJECT (folder));
+
+  /* reconnect our model to the view */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
+
+  /* land on the previous scroll position as soon as its row is listed */
+  if (standard_view->loading)
+    thunar_standard_view_scroll_restore_start (standard_view);
+}
+
+
+
 static void
 thunar_standard_view_restore_selection_from_history (ThunarStandardView *standard_view)
 {
@@ -1533,12 +1850,40 @@ thunar_standard_view_restore_selection_from_history (ThunarStandardView *standar
 
 
 
+static void
+thunar_standard_view_prefetch_neighbours (ThunarStandardView *standard_view)
+{
+  GFile *location;
+  GFile *parent;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (THUNAR_IS_FILE (standard_view->priv->current_directory));
+
+  /* queued last is loaded first, going back is the most likely */
+  parent = g_file_get_parent (thunar_file_get_file (standard_view->priv->current_directory));
+  if (parent != NULL)
+    {
+      thunar_prefetcher_queue (parent);
+      g_object_unref (parent);
+    }
+
+  location = thunar_history_peek_forward_location (standard_view->priv->history);
+  if (location != NULL)
+    thunar_prefetcher_queue (location);
+
+  location = thunar_history_peek_back_location (standard_view->priv->history);
+  if (location != NULL)
+    thunar_prefetcher_queue (location);
+}
+
+
+
 static void
 thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
                                             ThunarFile      *current_directory)
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (navigator);
-  ThunarFolder       *folder;
+  ThunarFolder       *previous_folder;
 
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
   _thunar_return_if_fail (current_directory == NULL || THUNAR_IS_FILE (current_directory));
@@ -1550,6 +1895,14 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   /* cancel any pending thumbnail sources and requests */
   thunar_standard_view_cancel_thumbnailing (standard_view);
 
+  /* the scroll position of the previous directory is no longer followed */
+  thunar_standard_view_scroll_restore_stop (standard_view);
+
+  /* hold the previous folder until we know if it is the new parent */
+  previous_folder = thunar_list_model_get_folder (standard_view->model);
+  if (previous_folder != NULL)
+    g_object_ref (previous_folder);
+
   /* disconnect any previous "loading" binding */
   if (G_LIKELY (standard_view->loading_binding != NULL))
     {
@@ -1561,6 +1914,10 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   if (current_directory != NULL)
     thunar_standard_view_scroll_position_save (standard_view);
 
+  /* the selection kept while suspended belongs to the previous directory */
+  thunar_g_list_free_full (standard_view->priv->suspended_selection);
+  standard_view->priv->suspended_selection = NULL;
+
   /* release previous directory */
   if (standard_view->priv->current_directory != NULL)
     {
@@ -1587,6 +1944,10 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
       /* reconnect the model to the view */
       g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
 
+      thunar_standard_view_keep_parent_folder (standard_view, NULL);
+      if (previous_folder != NULL)
+        g_object_unref (previous_folder);
+
       /* and we're done */
       return;
     }
@@ -1607,31 +1968,13 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   if (standard_view->priv->directory_specific_settings)
     thunar_standard_view_apply_directory_specific_settings (standard_view, current_directory);
 
-  /* We drop the model from the view as a simple optimization to speed up
-   * the process of disconnecting the model data from the view.
-   */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
+  /* a suspended view opens the folder once it is resumed */
+  if (!standard_view->priv->suspended)
+    thunar_standard_view_connect_folder (standard_view);
 
-  /* open the new directory as folder */
-  folder = thunar_folder_get_for_file (current_directory);
-
-  /* connect the "loading" binding */
-  standard_view->loading_binding =
-    g_object_bind_property_full (folder,        "loading",
-                                 standard_view, "loading",
-                                 G_BINDING_SYNC_CREATE,
-                                 NULL, NULL,
-                                 standard_view,
-                                 thunar_standard_view_loading_unbound);
-
-  /* apply the new folder, ignore removal of any old files */
-  g_signal_handler_block (standard_view->model, standard_view->priv->row_deleted_id);
-  thunar_list_model_set_folder (standard_view->model, folder, NULL);
-  g_signal_handler_unblock (standard_view->model, standard_view->priv->row_deleted_id);
-  g_object_unref (G_OBJECT (folder));
-
-  /* reconnect our model to the view */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
+  thunar_standard_view_keep_parent_folder (standard_view, previous_folder);
+  if (previous_folder != NULL)
+    g_object_unref (previous_folder);
 
   /* schedule a thumbnail timeout */
   /* NOTE: quickly after this we always trigger a size allocate wich will handle this */
@@ -1644,7 +1987,11 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_FULL_PARSED_PATH]);
 
   /* restore the selection from the history */
-  thunar_standard_view_restore_selection_from_history (standard_view);
+  if (!standard_view->priv->suspended)
+    {
+      thunar_standard_view_restore_selection_from_history (standard_view);
+      thunar_standard_view_prefetch_neighbours (standard_view);
+    }
 }
 
 
@@ -1672,8 +2019,6 @@ thunar_standard_view_set_loading (ThunarStandardView *standard_view,
   ThunarFile *file;
   GList      *new_files_path_list;
   GList      *selected_files;
-  GFile      *first_file;
-  ThunarFile *current_directory;
 
   loading = !!loading;
 
@@ -1718,6 +2063,18 @@ thunar_standard_view_set_loading (ThunarStandardView *standard_view,
       thunar_g_list_free_full (selected_files);
     }
 
+  /* the restored scroll position was followed while loading, the
+   * details view applies it once more below */
+  if (!loading)
+    {
+      if (standard_view->priv->scroll_restore_idle_id != 0 && !THUNAR_IS_DETAILS_VIEW (standard_view))
+        {
+          g_source_remove (standard_view->priv->scroll_restore_idle_id);
+          thunar_standard_view_scroll_restore_idle (standard_view);
+        }
+      thunar_standard_view_scroll_restore_stop (standard_view);
+    }
+
   /* check if we're done loading and have a scheduled scroll_to_file
    * scrolling after loading circumvents the scroll caused by gtk_tree_view_set_cell */
   if (THUNAR_IS_DETAILS_VIEW (standard_view))
@@ -1742,21 +2099,7 @@ thunar_standard_view_set_loading (ThunarStandardView *standard_view,
             }
           else
             {
-              /* look for a first visible file in the hash table */
-              current_directory = thunar_navigator_get_current_directory (THUNAR_NAVIGATOR (standard_view));
-              if (G_LIKELY (current_directory != NULL))
-                {
-                  first_file = g_hash_table_lookup (standard_view->priv->scroll_to_files, thunar_file_get_file (current_directory));
-                  if (G_LIKELY (first_file != NULL))
-                    {
-                      file = thunar_file_cache_lookup (first_file);
-                      if (G_LIKELY (file != NULL))
-                        {
-                          thunar_view_scroll_to_file (THUNAR_VIEW (standard_view), file, FALSE, TRUE, 0.0f, 0.0f);
-                          g_object_unref (file);
-                        }
-                    }
-                }
+              thunar_standard_view_scroll_position_restore (standard_view);
             }
         }
     }
@@ -1785,6 +2128,7 @@ static const gchar*
 thunar_standard_view_get_statusbar_text (ThunarView *view)
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (view);
+  ThunarFolder       *folder;
   GList              *items;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), NULL);
@@ -1799,7 +2143,12 @@ thunar_standard_view_get_statusbar_text (ThunarView *view)
        * selected and the view is loading
        */
       if (items == NULL && standard_view->loading)
-        return _("Loading folder contents...");
+        {
+          folder = thunar_list_model_get_folder (standard_view->model);
+          if (folder != NULL && thunar_folder_is_stale (folder))
+            return _("Refreshing the last known network locations...");
+          return _("Loading folder contents...");
+        }
 
       standard_view->priv->statusbar_text = thunar_list_model_get_statusbar_text (standard_view->model, items);
       g_list_free_full (items, (GDestroyNotify) gtk_tree_path_free);
@@ -2129,6 +2478,7 @@ thunar_standard_view_get_dest_actions (ThunarStandardView *standard_view,
                                        gint                x,
                                        gint                y,
                                        guint               timestamp,
+                                       gboolean            validate,
                                        ThunarFile        **file_return)
 {
   GdkDragAction actions = 0;
@@ -2142,8 +2492,13 @@ thunar_standard_view_get_dest_actions (ThunarStandardView *standard_view,
   /* check if we can drop there */
   if (G_LIKELY (file != NULL) && G_LIKELY (standard_view->priv->search_query == NULL))
     {
-      /* determine the possible drop actions for the file (and the suggested action if any) */
-      actions = thunar_file_accepts_drop (file, standard_view->priv->drop_file_list, context, &action);
+      /* determine the possible drop actions for the file (and the suggested action if any),
+       * the pointer movement only checks a sample of the files, the drop checks all of them */
+      if (validate)
+        actions = thunar_file_accepts_drop (file, standard_view->priv->drop_file_list, context, &action);
+      else
+        actions = thunar_dnd_accepts_drop (&standard_view->priv->drop_accept_cache, file,
+                                           standard_view->priv->drop_file_list, context, &action);
       if (G_LIKELY (actions != 0))
         {
           /* tell the caller about the file (if it's interested) */
@@ -2693,6 +3048,50 @@ thunar_standard_view_button_release_event (GtkWidget          *view,
 
 
 
+static gboolean
+thunar_standard_view_hover_motion_notify_event (GtkWidget          *view,
+                                                GdkEventMotion     *event,
+                                                ThunarStandardView *standard_view)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+  ThunarFile  *file = NULL;
+  gint         x, y;
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  /* the event is relative to the bin window, the lookup expects widget coordinates */
+  gdk_window_get_device_position (gtk_widget_get_window (view), event->device, &x, &y, NULL);
+
+  path = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_path_at_pos) (standard_view, x, y);
+  if (path != NULL)
+    {
+      if (gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, path))
+        file = thunar_list_model_get_file (standard_view->model, &iter);
+      gtk_tree_path_free (path);
+    }
+
+  thunar_prefetcher_hover ((file != NULL && thunar_file_is_directory (file)) ? thunar_file_get_file (file) : NULL);
+
+  if (file != NULL)
+    g_object_unref (file);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_standard_view_hover_leave_notify_event (GtkWidget          *view,
+                                               GdkEventCrossing   *event,
+                                               ThunarStandardView *standard_view)
+{
+  thunar_prefetcher_hover (NULL);
+  return FALSE;
+}
+
+
+
 static gboolean
 thunar_standard_view_motion_notify_event (GtkWidget          *view,
                                           GdkEventMotion     *event,
@@ -3180,7 +3579,7 @@ thunar_standard_view_receive_text_uri_list (GdkDragContext     *context,
   GtkWidget    *source_view = NULL;
 
   /* determine the drop position */
-  actions = thunar_standard_view_get_dest_actions (standard_view, context, x, y, timestamp, &file);
+  actions = thunar_standard_view_get_dest_actions (standard_view, context, x, y, timestamp, TRUE, &file);
   if (G_LIKELY ((actions & (GDK_ACTION_COPY | GDK_ACTION_MOVE | GDK_ACTION_LINK)) != 0))
     {
       /* ask the user what to do with the drop data */
@@ -3293,6 +3692,9 @@ thunar_standard_view_drag_leave (GtkWidget          *widget,
       standard_view->priv->drop_data_ready = FALSE;
     }
 
+  /* forget the accept decision of this drag */
+  thunar_dnd_accept_cache_clear (&standard_view->priv->drop_accept_cache);
+
   /* disable the highlighting of the items in the view */
   (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->highlight_path) (standard_view, NULL);
 }
@@ -3373,7 +3775,7 @@ thunar_standard_view_drag_motion (GtkWidget          *view,
   else
     {
       /* check whether we can drop at (x,y) */
-      thunar_standard_view_get_dest_actions (standard_view, context, x, y, timestamp, NULL);
+      thunar_standard_view_get_dest_actions (standard_view, context, x, y, timestamp, FALSE, NULL);
     }
 
   /* start the drag autoscroll timer if not already running */
@@ -3640,6 +4042,44 @@ thunar_standard_view_search_done (ThunarListModel    *model,
 
 
 
+static void
+thunar_standard_view_changes_pending (ThunarListModel    *model,
+                                      ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (standard_view->model == model);
+
+  /* apply the changes at the start of the next frames */
+  if (standard_view->priv->changes_tick_id == 0)
+    standard_view->priv->changes_tick_id =
+      gtk_widget_add_tick_callback (GTK_WIDGET (standard_view), thunar_standard_view_apply_changes, NULL, NULL);
+}
+
+
+
+static gboolean
+thunar_standard_view_apply_changes (GtkWidget     *widget,
+                                    GdkFrameClock *frame_clock,
+                                    gpointer       user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (widget);
+  gint64              refresh_interval = 0;
+
+  /* leave most of the frame for the layout and drawing of the view */
+  gdk_frame_clock_get_refresh_info (frame_clock, gdk_frame_clock_get_frame_time (frame_clock), &refresh_interval, NULL);
+  if (refresh_interval <= 0)
+    refresh_interval = THUNAR_STANDARD_VIEW_FRAME_INTERVAL;
+
+  if (thunar_list_model_apply_changes (standard_view->model, refresh_interval / THUNAR_STANDARD_VIEW_CHANGES_FRAME_SHARE))
+    return G_SOURCE_CONTINUE;
+
+  standard_view->priv->changes_tick_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+
+
 static void
 thunar_standard_view_sort_column_changed (GtkTreeSortable    *tree_sortable,
                                           ThunarStandardView *standard_view)
@@ -3928,6 +4368,10 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
   ThunarFile  *file;
   gboolean     valid_iter;
   GList       *visible_files = NULL;
+  gint         first;
+  gint         last;
+  gint         index;
+  gint         n;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
@@ -3941,15 +4385,40 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
   if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
     return TRUE;
 
-  /* do nothing if we are already loading thumbnails */
-  if (standard_view->priv->thumbnail_request != 0)
-    return FALSE;
-
   /* compute visible item range */
   if ((*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view,
                                                                             &start_path,
                                                                             &end_path))
     {
+      first = gtk_tree_path_get_indices (start_path)[0];
+      last = gtk_tree_path_get_indices (end_path)[0];
+
+      if (standard_view->priv->thumbnail_request != 0)
+        {
+          /* do nothing if we are already loading thumbnails for this range */
+          if (first == standard_view->priv->thumbnail_first
+              && last == standard_view->priv->thumbnail_last
+              && standard_view->priv->thumbnail_direction == standard_view->priv->thumbnail_scroll_direction)
+            {
+              gtk_tree_path_free (start_path);
+              gtk_tree_path_free (end_path);
+              return FALSE;
+            }
+
+          /* a lazy request must not replace a full one */
+          lazy_request = lazy_request && standard_view->priv->thumbnail_lazy;
+
+          /* the files that scrolled out of view are dropped, unless tumbler has them already */
+          thunar_thumbnailer_dequeue (standard_view->priv->thumbnailer,
+                                      standard_view->priv->thumbnail_request);
+          standard_view->priv->thumbnail_request = 0;
+        }
+
+      standard_view->priv->thumbnail_first = first;
+      standard_view->priv->thumbnail_last = last;
+      standard_view->priv->thumbnail_direction = standard_view->priv->thumbnail_scroll_direction;
+      standard_view->priv->thumbnail_lazy = lazy_request;
+
       /* iterate over the range to collect all files */
       valid_iter = gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model),
                                             &iter, start_path);
@@ -3978,6 +4447,20 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
           gtk_tree_path_free (path);
         }
 
+      /* prefetch one screen ahead in the scroll direction, the nearest files first */
+      for (n = 1; n <= last - first + 1; ++n)
+        {
+          index = (standard_view->priv->thumbnail_scroll_direction < 0) ? first - n : last + n;
+          if (index < 0 || !gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (standard_view->model), &iter, NULL, index))
+            break;
+
+          file = thunar_list_model_get_file (standard_view->model, &iter);
+          visible_files = g_list_prepend (visible_files, file);
+        }
+
+      /* the thumbnailer handles the files in this order */
+      visible_files = g_list_reverse (visible_files);
+
       /* queue a thumbnail request */
       thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
                                       lazy_request, visible_files,
@@ -4000,7 +4483,17 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
 static gboolean
 thunar_standard_view_request_thumbnails (gpointer data)
 {
-  return thunar_standard_view_request_thumbnails_real (data, FALSE);
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (data);
+  gint64              trace_begin = THUNAR_TRACE_BEGIN ();
+  gint64              start_time = g_get_monotonic_time ();
+  gboolean            result;
+
+  result = thunar_standard_view_request_thumbnails_real (standard_view, FALSE);
+  THUNAR_TRACE_IDLE (trace_begin, "thunar_standard_view_request_thumbnails");
+  thunar_stats_record_callback ("thunar_standard_view_request_thumbnails", start_time,
+                                MAX (standard_view->priv->thumbnail_last - standard_view->priv->thumbnail_first + 1, 0));
+
+  return result;
 }
 
 
@@ -4008,7 +4501,17 @@ thunar_standard_view_request_thumbnails (gpointer data)
 static gboolean
 thunar_standard_view_request_thumbnails_lazy (gpointer data)
 {
-  return thunar_standard_view_request_thumbnails_real (data, TRUE);
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (data);
+  gint64              trace_begin = THUNAR_TRACE_BEGIN ();
+  gint64              start_time = g_get_monotonic_time ();
+  gboolean            result;
+
+  result = thunar_standard_view_request_thumbnails_real (standard_view, TRUE);
+  THUNAR_TRACE_IDLE (trace_begin, "thunar_standard_view_request_thumbnails_lazy");
+  thunar_stats_record_callback ("thunar_standard_view_request_thumbnails_lazy", start_time,
+                                MAX (standard_view->priv->thumbnail_last - standard_view->priv->thumbnail_first + 1, 0));
+
+  return result;
 }
 
 
@@ -4047,6 +4550,9 @@ static void
 thunar_standard_view_scrolled (GtkAdjustment      *adjustment,
                                ThunarStandardView *standard_view)
 {
+  gdouble value;
+  guint   n;
+
   _thunar_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
@@ -4054,8 +4560,54 @@ thunar_standard_view_scrolled (GtkAdjustment      *adjustment,
   if (thunar_view_get_loading (THUNAR_VIEW (standard_view)))
     return;
 
+  /* remember the scroll direction, thumbnails are prefetched in it */
+  n = (adjustment == gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view))) ? 1 : 0;
+  value = gtk_adjustment_get_value (adjustment);
+  if (value != standard_view->priv->thumbnail_scroll_value[n])
+    {
+      standard_view->priv->thumbnail_scroll_direction = (value < standard_view->priv->thumbnail_scroll_value[n]) ? -1 : 1;
+      standard_view->priv->thumbnail_scroll_value[n] = value;
+    }
+
   /* Try to load thumbnails for files which are now visible */
   thunar_standard_view_request_thumbnails_real (standard_view, TRUE);
+
+  thunar_standard_view_load_more (adjustment, standard_view);
+}
+
+
+
+static gboolean
+thunar_standard_view_near_end (GtkAdjustment *adjustment)
+{
+  return gtk_adjustment_get_value (adjustment) + 2 * gtk_adjustment_get_page_size (adjustment) >= gtk_adjustment_get_upper (adjustment);
+}
+
+
+
+/* lists the next page of a folder listed in pages once its end comes into
+ * sight, also when the rows of the last page don't fill the view. Views
+ * scroll through their rows either vertically or horizontally, the other
+ * direction is always at its end */
+static void
+thunar_standard_view_load_more (GtkAdjustment      *adjustment,
+                                ThunarStandardView *standard_view)
+{
+  ThunarFolder *folder;
+
+  _thunar_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (standard_view->model == NULL || standard_view->priv->suspended)
+    return;
+
+  folder = thunar_list_model_get_folder (standard_view->model);
+  if (folder == NULL || !thunar_folder_has_more (folder))
+    return;
+
+  if (thunar_standard_view_near_end (gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (standard_view)))
+      && thunar_standard_view_near_end (gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (standard_view))))
+    thunar_folder_load_more (folder);
 }
 
 
@@ -4221,6 +4773,7 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 {
   GtkTreeIter iter;
   GList      *lp, *selected_thunar_files;
+  gint64      start_time = g_get_monotonic_time ();
 
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
@@ -4261,6 +4814,11 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 
   /* emit notification for "selected-files" */
   g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_SELECTED_FILES]);
+
+  /* this includes the listeners of the selection, the files are
+   * only counted while the watchdog is enabled */
+  thunar_stats_record_callback ("thunar_standard_view_selection_changed", start_time,
+                                thunar_stats_get_slow_threshold () != 0 ? g_list_length (standard_view->priv->selected_files) : 0);
 }
 
 
@@ -4672,3 +5230,203 @@ thunar_standard_view_cell_layout_data_func (GtkCellLayout   *layout,
 
   g_object_unref (file);
 }
+
+
+
+/**
+ * thunar_standard_view_suspend:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Releases the folder of @standard_view, together with its file monitor
+ * and the rows of the model, while the view is not shown. The scroll
+ * position and the selection are kept and applied again by
+ * thunar_standard_view_resume(). If no directory is set yet, the folder
+ * is only opened once the view is resumed.
+ *
+ * Views which are loading or showing search results are not suspended.
+ **/
+void
+thunar_standard_view_suspend (ThunarStandardView *standard_view)
+{
+  GtkWidget *view;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (standard_view->priv->suspended)
+    return;
+
+  if (standard_view->priv->current_directory == NULL)
+    {
+      standard_view->priv->suspended = TRUE;
+      return;
+    }
+
+  if (standard_view->loading || standard_view->priv->active_search)
+    return;
+
+  standard_view->priv->suspended = TRUE;
+
+  /* remember where we were */
+  thunar_standard_view_scroll_position_save (standard_view);
+  standard_view->priv->suspended_selection = thunar_g_list_copy_deep (standard_view->priv->selected_files);
+
+  thunar_standard_view_cancel_thumbnailing (standard_view);
+
+  if (G_LIKELY (standard_view->loading_binding != NULL))
+    {
+      g_object_unref (standard_view->loading_binding);
+      standard_view->loading_binding = NULL;
+    }
+
+  /* an inactive tab has no use for its parent folder */
+  g_clear_object (&standard_view->priv->parent_folder);
+
+  /* drop the model from the view while the rows are removed */
+  view = gtk_bin_get_child (GTK_BIN (standard_view));
+  g_object_set (G_OBJECT (view), "model", NULL, NULL);
+  thunar_list_model_set_folder (standard_view->model, NULL, NULL);
+  g_object_set (G_OBJECT (view), "model", standard_view->model, NULL);
+}
+
+
+
+/**
+ * thunar_standard_view_resume:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Opens the folder of a suspended @standard_view again, restoring the
+ * scroll position and the selection once it has been loaded.
+ **/
+void
+thunar_standard_view_resume (ThunarStandardView *standard_view)
+{
+  GList *selected_files;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (!standard_view->priv->suspended)
+    return;
+
+  standard_view->priv->suspended = FALSE;
+
+  if (standard_view->priv->current_directory == NULL)
+    return;
+
+  thunar_standard_view_connect_folder (standard_view);
+
+  /* applied right away if the folder is still cached, after loading otherwise */
+  selected_files = standard_view->priv->suspended_selection;
+  standard_view->priv->suspended_selection = NULL;
+  if (selected_files != NULL)
+    thunar_component_set_selected_files (THUNAR_COMPONENT (standard_view), selected_files);
+  else
+    thunar_standard_view_restore_selection_from_history (standard_view);
+  thunar_g_list_free_full (selected_files);
+
+  if (!standard_view->loading)
+    thunar_standard_view_scroll_position_restore (standard_view);
+
+  thunar_standard_view_update_statusbar_text (standard_view);
+}
+
+
+
+/**
+ * thunar_standard_view_is_suspended:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Return value: %TRUE if @standard_view released its folder.
+ **/
+gboolean
+thunar_standard_view_is_suspended (ThunarStandardView *standard_view)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+  return standard_view->priv->suspended;
+}
+
+
+
+/**
+ * thunar_standard_view_get_scroll_file:
+ * @standard_view : a #ThunarStandardView.
+ *
+ * Returns the first visible file of the @standard_view, or the file the
+ * view will scroll to once its folder is loaded again. The caller is
+ * responsible to free the returned object using g_object_unref().
+ *
+ * Return value: the #GFile or %NULL if unknown.
+ **/
+GFile*
+thunar_standard_view_get_scroll_file (ThunarStandardView *standard_view)
+{
+  ThunarFile *first_file;
+  GFile      *gfile;
+
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), NULL);
+
+  if (standard_view->priv->current_directory == NULL)
+    return NULL;
+
+  if (!standard_view->priv->suspended && !standard_view->loading
+      && thunar_view_get_visible_range (THUNAR_VIEW (standard_view), &first_file, NULL))
+    {
+      gfile = g_object_ref (thunar_file_get_file (first_file));
+      g_object_unref (first_file);
+      return gfile;
+    }
+
+  gfile = g_hash_table_lookup (standard_view->priv->scroll_to_files, thunar_file_get_file (standard_view->priv->current_directory));
+  return (gfile != NULL) ? g_object_ref (gfile) : NULL;
+}
+
+
+
+/**
+ * thunar_standard_view_set_scroll_file:
+ * @standard_view : a #ThunarStandardView.
+ * @file          : the first visible #GFile.
+ *
+ * Makes @standard_view scroll to @file once its current folder
+ * is loaded, e.g. for a tab restored from the session.
+ **/
+void
+thunar_standard_view_set_scroll_file (ThunarStandardView *standard_view,
+                                      GFile              *file)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+  _thunar_return_if_fail (G_IS_FILE (file));
+
+  if (standard_view->priv->current_directory == NULL)
+    return;
+
+  g_hash_table_replace (standard_view->priv->scroll_to_files,
+                        g_object_ref (thunar_file_get_file (standard_view->priv->current_directory)),
+                        g_object_ref (file));
+}
+
+
+
+/**
+ * thunar_standard_view_search_equal:
+ * @model     : the #ThunarListModel of the view.
+ * @column    : the search column, unused.
+ * @key       : the text typed into the interactive search.
+ * @iter      : the row to test.
+ * @user_data : unused.
+ *
+ * The search equal func of the #GtkTreeView and #ExoIconView of the
+ * views, matching @key against the sorted names of the @model instead
+ * of casefolding the name of every row again for every keystroke.
+ *
+ * Return value: %FALSE if the row at @iter matches @key.
+ **/
+gboolean
+thunar_standard_view_search_equal (GtkTreeModel *model,
+                                   gint          column,
+                                   const gchar  *key,
+                                   GtkTreeIter  *iter,
+                                   gpointer      user_data)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (model), TRUE);
+  return !thunar_list_model_has_name_prefix (THUNAR_LIST_MODEL (model), iter, key);
+}
@@ -205,6 +205,19 @@ XfceGtkActionEntry *thunar_standard_view_get_action_entries (void);
 
 void                thunar_standard_view_queue_redraw          (ThunarStandardView       *standard_view);
 
+void                thunar_standard_view_suspend               (ThunarStandardView       *standard_view);
+void                thunar_standard_view_resume                (ThunarStandardView       *standard_view);
+gboolean            thunar_standard_view_is_suspended          (ThunarStandardView       *standard_view);
+GFile              *thunar_standard_view_get_scroll_file       (ThunarStandardView       *standard_view);
+void                thunar_standard_view_set_scroll_file       (ThunarStandardView       *standard_view,
+                                                                GFile                    *file);
+
+gboolean            thunar_standard_view_search_equal          (GtkTreeModel             *model,
+                                                                gint                      column,
+                                                                const gchar              *key,
+                                                                GtkTreeIter              *iter,
+                                                                gpointer                  user_data);
+
 
 G_END_DECLS;
 
@@ -0,0 +1,325 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
+
+
+
+/**
+ * SECTION:thunar-stats
+ * @Short_description: Lightweight counters and histograms for the hot paths
+ * @Title: ThunarStats
+ *
+ * The statistics are plain process-wide atomic integers, so recording a
+ * value is only an atomic add and can be done from any thread. They are
+ * exported on the org.xfce.Thunar.Debug D-Bus interface.
+ *
+ * Main loop callbacks report their duration with
+ * thunar_stats_record_callback(). Once a threshold is set, the
+ * callbacks that took longer are kept in a ring buffer, so a freeze
+ * can be traced back to its callback for a bug report.
+ **/
+
+
+
+typedef struct
+{
+  gsize count;
+  gsize sum;
+  gsize buckets[THUNAR_STATS_N_BUCKETS];
+} ThunarStatsHistogramData;
+
+
+
+static const gchar *counter_names[THUNAR_STATS_N_COUNTERS] =
+{
+  "icon-cache-hit",
+  "icon-cache-miss",
+  "job-pool-steal",
+  "list-model-index-hit",
+  "folder-prefetch",
+  "list-model-get-value",
+};
+
+static const gchar *histogram_names[THUNAR_STATS_N_HISTOGRAMS] =
+{
+  "folder-reload-usec",
+  "list-model-sort-usec",
+  "list-model-insert-files",
+  "thumbnail-latency-usec",
+  "launch-latency-usec",
+  "job-queue-interactive-usec",
+  "job-queue-bulk-usec",
+  "job-queue-cpu-usec",
+  "metadata-batch-files",
+  "view-frame-usec",
+  "view-frame-values",
+  "icon-renderer-usec",
+  "text-renderer-usec",
+  "copy-file-usec",
+  "copy-file-bytes",
+  "checksum-usec",
+  "checksum-bytes",
+  "checksum-compare-usec",
+  "next-file-name-usec",
+  "next-file-name-tries",
+};
+
+static gsize                    counters[THUNAR_STATS_N_COUNTERS];
+static ThunarStatsHistogramData histograms[THUNAR_STATS_N_HISTOGRAMS];
+
+/* the slow callbacks, the oldest one is overwritten once the buffer is full */
+G_LOCK_DEFINE_STATIC (slow_callbacks);
+static gint                     slow_threshold;
+static ThunarStatsSlowCallback  slow_callbacks[THUNAR_STATS_N_SLOW_CALLBACKS];
+static guint                    n_slow_callbacks;
+
+
+
+/**
+ * thunar_stats_count:
+ * @counter : a #ThunarStatsCounter.
+ *
+ * Increments @counter by one.
+ **/
+void
+thunar_stats_count (ThunarStatsCounter counter)
+{
+  _thunar_return_if_fail (counter < THUNAR_STATS_N_COUNTERS);
+
+  g_atomic_pointer_add (&counters[counter], 1);
+}
+
+
+
+/**
+ * thunar_stats_record:
+ * @histogram : a #ThunarStatsHistogram.
+ * @value     : the value to record.
+ *
+ * Adds @value to @histogram. The value lands in the bucket of its bit
+ * length, i.e. bucket n holds the values from 2^(n-1) to 2^n - 1.
+ **/
+void
+thunar_stats_record (ThunarStatsHistogram histogram,
+                     guint64              value)
+{
+  ThunarStatsHistogramData *data;
+  guint                     bucket;
+
+  _thunar_return_if_fail (histogram < THUNAR_STATS_N_HISTOGRAMS);
+
+  data = &histograms[histogram];
+  bucket = (value == 0) ? 0 : MIN (g_bit_storage (value), THUNAR_STATS_N_BUCKETS - 1);
+
+  g_atomic_pointer_add (&data->count, 1);
+  g_atomic_pointer_add (&data->sum, (gssize) value);
+  g_atomic_pointer_add (&data->buckets[bucket], 1);
+}
+
+
+
+/**
+ * thunar_stats_record_since:
+ * @histogram  : a #ThunarStatsHistogram.
+ * @start_time : a time returned by g_get_monotonic_time().
+ *
+ * Adds the microseconds elapsed since @start_time to @histogram.
+ **/
+void
+thunar_stats_record_since (ThunarStatsHistogram histogram,
+                           gint64               start_time)
+{
+  thunar_stats_record (histogram, MAX (g_get_monotonic_time () - start_time, 0));
+}
+
+
+
+/**
+ * thunar_stats_counter_get_name:
+ * @counter : a #ThunarStatsCounter.
+ *
+ * Return value: the name under which @counter is exported.
+ **/
+const gchar *
+thunar_stats_counter_get_name (ThunarStatsCounter counter)
+{
+  _thunar_return_val_if_fail (counter < THUNAR_STATS_N_COUNTERS, NULL);
+  return counter_names[counter];
+}
+
+
+
+/**
+ * thunar_stats_counter_get_value:
+ * @counter : a #ThunarStatsCounter.
+ *
+ * Return value: the current value of @counter.
+ **/
+guint64
+thunar_stats_counter_get_value (ThunarStatsCounter counter)
+{
+  _thunar_return_val_if_fail (counter < THUNAR_STATS_N_COUNTERS, 0);
+  return (gsize) g_atomic_pointer_get (&counters[counter]);
+}
+
+
+
+/**
+ * thunar_stats_histogram_get_name:
+ * @histogram : a #ThunarStatsHistogram.
+ *
+ * Return value: the name under which @histogram is exported.
+ **/
+const gchar *
+thunar_stats_histogram_get_name (ThunarStatsHistogram histogram)
+{
+  _thunar_return_val_if_fail (histogram < THUNAR_STATS_N_HISTOGRAMS, NULL);
+  return histogram_names[histogram];
+}
+
+
+
+/**
+ * thunar_stats_histogram_get_values:
+ * @histogram : a #ThunarStatsHistogram.
+ * @count     : return location for the number of recorded values.
+ * @sum       : return location for the sum of the recorded values.
+ * @buckets   : return location for the bucket counts.
+ *
+ * Reads the current state of @histogram. The values are read one by one
+ * while other threads may still record, which is fine for monitoring.
+ **/
+void
+thunar_stats_histogram_get_values (ThunarStatsHistogram histogram,
+                                   guint64             *count,
+                                   guint64             *sum,
+                                   guint64              buckets[THUNAR_STATS_N_BUCKETS])
+{
+  ThunarStatsHistogramData *data;
+  guint                     n;
+
+  _thunar_return_if_fail (histogram < THUNAR_STATS_N_HISTOGRAMS);
+
+  data = &histograms[histogram];
+
+  *count = (gsize) g_atomic_pointer_get (&data->count);
+  *sum = (gsize) g_atomic_pointer_get (&data->sum);
+  for (n = 0; n < THUNAR_STATS_N_BUCKETS; ++n)
+    buckets[n] = (gsize) g_atomic_pointer_get (&data->buckets[n]);
+}
+
+
+
+/**
+ * thunar_stats_set_slow_threshold:
+ * @threshold : the duration in milliseconds, or %0.
+ *
+ * Main loop callbacks which take longer than @threshold are remembered
+ * from now on. A @threshold of %0 disables the watchdog again.
+ **/
+void
+thunar_stats_set_slow_threshold (guint threshold)
+{
+  g_atomic_int_set (&slow_threshold, MIN (threshold, (guint) G_MAXINT));
+}
+
+
+
+/**
+ * thunar_stats_get_slow_threshold:
+ *
+ * Return value: the slow callback threshold in milliseconds, or %0
+ *               if the watchdog is disabled.
+ **/
+guint
+thunar_stats_get_slow_threshold (void)
+{
+  return g_atomic_int_get (&slow_threshold);
+}
+
+
+
+/**
+ * thunar_stats_record_callback:
+ * @name       : the name of the callback, a static string.
+ * @start_time : the time returned by g_get_monotonic_time() when the callback started.
+ * @workload   : the number of items the callback handled.
+ *
+ * Remembers the callback if it took longer than the slow callback
+ * threshold. This is one atomic read while the watchdog is disabled.
+ **/
+void
+thunar_stats_record_callback (const gchar *name,
+                              gint64       start_time,
+                              guint        workload)
+{
+  ThunarStatsSlowCallback *callback;
+  gint64                   duration;
+  gint                     threshold;
+
+  _thunar_return_if_fail (name != NULL);
+
+  threshold = g_atomic_int_get (&slow_threshold);
+  if (G_LIKELY (threshold == 0))
+    return;
+
+  duration = g_get_monotonic_time () - start_time;
+  if (G_LIKELY (duration < (gint64) threshold * 1000))
+    return;
+
+  G_LOCK (slow_callbacks);
+  callback = &slow_callbacks[n_slow_callbacks++ % THUNAR_STATS_N_SLOW_CALLBACKS];
+  callback->name = name;
+  callback->start_time = g_get_real_time () - duration;
+  callback->duration = duration;
+  callback->workload = workload;
+  G_UNLOCK (slow_callbacks);
+}
+
+
+
+/**
+ * thunar_stats_get_slow_callbacks:
+ * @callbacks : return location for the slow callbacks.
+ *
+ * Copies the remembered slow callbacks to @callbacks, the oldest first.
+ *
+ * Return value: the number of callbacks copied.
+ **/
+guint
+thunar_stats_get_slow_callbacks (ThunarStatsSlowCallback callbacks[THUNAR_STATS_N_SLOW_CALLBACKS])
+{
+  guint first;
+  guint n;
+
+  G_LOCK (slow_callbacks);
+  first = (n_slow_callbacks > THUNAR_STATS_N_SLOW_CALLBACKS) ? n_slow_callbacks - THUNAR_STATS_N_SLOW_CALLBACKS : 0;
+  for (n = 0; first + n < n_slow_callbacks; ++n)
+    callbacks[n] = slow_callbacks[(first + n) % THUNAR_STATS_N_SLOW_CALLBACKS];
+  G_UNLOCK (slow_callbacks);
+
+  return n;
+}
@@ -0,0 +1,150 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_STATS_H__
+#define __THUNAR_STATS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* number of power-of-two buckets of a histogram */
+#define THUNAR_STATS_N_BUCKETS (32)
+
+/* number of slow main loop callbacks remembered */
+#define THUNAR_STATS_N_SLOW_CALLBACKS (128)
+
+/**
+ * ThunarStatsCounter:
+ * @THUNAR_STATS_ICON_CACHE_HIT  : icon factory lookups served from the cache.
+ * @THUNAR_STATS_ICON_CACHE_MISS : icon factory lookups which loaded the icon.
+ * @THUNAR_STATS_JOB_POOL_STEAL  : jobs started on an idle slot of another pool.
+ * @THUNAR_STATS_LIST_MODEL_INDEX_HIT : list models which took the order of their
+ *                                     rows from another model of the folder.
+ * @THUNAR_STATS_FOLDER_PREFETCH      : folders loaded ahead of being opened.
+ * @THUNAR_STATS_LIST_MODEL_GET_VALUE : values the views asked a list model for.
+ *
+ * Monotonic event counters.
+ **/
+typedef enum
+{
+  THUNAR_STATS_ICON_CACHE_HIT,
+  THUNAR_STATS_ICON_CACHE_MISS,
+  THUNAR_STATS_JOB_POOL_STEAL,
+  THUNAR_STATS_LIST_MODEL_INDEX_HIT,
+  THUNAR_STATS_FOLDER_PREFETCH,
+  THUNAR_STATS_LIST_MODEL_GET_VALUE,
+  THUNAR_STATS_N_COUNTERS,
+} ThunarStatsCounter;
+
+/**
+ * ThunarStatsHistogram:
+ * @THUNAR_STATS_FOLDER_RELOAD      : duration of a folder reload, in microseconds.
+ * @THUNAR_STATS_LIST_MODEL_SORT    : duration of a list model sort, in microseconds.
+ * @THUNAR_STATS_LIST_MODEL_INSERT  : number of files inserted into a list model at once.
+ * @THUNAR_STATS_THUMBNAIL_LATENCY  : time until a slice of thumbnails was generated,
+ *                                    in microseconds.
+ * @THUNAR_STATS_LAUNCH_LATENCY     : time until the process of an application was
+ *                                    started for opening files, in microseconds.
+ * @THUNAR_STATS_JOB_QUEUE_INTERACTIVE : time a job waited in the interactive pool, in microseconds.
+ * @THUNAR_STATS_JOB_QUEUE_BULK        : time a job waited in the bulk I/O pool, in microseconds.
+ * @THUNAR_STATS_JOB_QUEUE_CPU         : time a job waited in the CPU pool, in microseconds.
+ * @THUNAR_STATS_METADATA_BATCH        : number of files whose metadata was written at once.
+ * @THUNAR_STATS_VIEW_FRAME            : time a view took to draw, in microseconds.
+ * @THUNAR_STATS_VIEW_FRAME_VALUES     : number of list model values asked for to draw a view.
+ * @THUNAR_STATS_ICON_RENDERER         : time the icon renderer took for a cell, in microseconds.
+ * @THUNAR_STATS_TEXT_RENDERER         : time the text renderer took for a cell, in microseconds.
+ * @THUNAR_STATS_COPY_FILE             : time thunar_g_file_copy() took for a file, in microseconds.
+ * @THUNAR_STATS_COPY_FILE_BYTES       : number of bytes thunar_g_file_copy() copied for a file.
+ * @THUNAR_STATS_CHECKSUM              : time a checksum of a copied file took, in microseconds.
+ * @THUNAR_STATS_CHECKSUM_BYTES        : number of bytes read for a checksum of a copied file.
+ * @THUNAR_STATS_CHECKSUM_COMPARE      : time comparing the checksums of two files took, in microseconds.
+ * @THUNAR_STATS_NEXT_FILE_NAME        : time finding a free name for a copy took, in microseconds.
+ * @THUNAR_STATS_NEXT_FILE_NAME_TRIES  : number of names tried until a free name for a copy was found.
+ *
+ * Distributions of values, in power-of-two buckets.
+ **/
+typedef enum
+{
+  THUNAR_STATS_FOLDER_RELOAD,
+  THUNAR_STATS_LIST_MODEL_SORT,
+  THUNAR_STATS_LIST_MODEL_INSERT,
+  THUNAR_STATS_THUMBNAIL_LATENCY,
+  THUNAR_STATS_LAUNCH_LATENCY,
+  THUNAR_STATS_JOB_QUEUE_INTERACTIVE,
+  THUNAR_STATS_JOB_QUEUE_BULK,
+  THUNAR_STATS_JOB_QUEUE_CPU,
+  THUNAR_STATS_METADATA_BATCH,
+  THUNAR_STATS_VIEW_FRAME,
+  THUNAR_STATS_VIEW_FRAME_VALUES,
+  THUNAR_STATS_ICON_RENDERER,
+  THUNAR_STATS_TEXT_RENDERER,
+  THUNAR_STATS_COPY_FILE,
+  THUNAR_STATS_COPY_FILE_BYTES,
+  THUNAR_STATS_CHECKSUM,
+  THUNAR_STATS_CHECKSUM_BYTES,
+  THUNAR_STATS_CHECKSUM_COMPARE,
+  THUNAR_STATS_NEXT_FILE_NAME,
+  THUNAR_STATS_NEXT_FILE_NAME_TRIES,
+  THUNAR_STATS_N_HISTOGRAMS,
+} ThunarStatsHistogram;
+
+/**
+ * ThunarStatsSlowCallback:
+ * @name       : the name of the callback.
+ * @start_time : the real time at which the callback started, in microseconds.
+ * @duration   : the time the callback took, in microseconds.
+ * @workload   : the number of items, usually files, the callback handled.
+ *
+ * A main loop callback which took longer than the slow callback threshold.
+ **/
+typedef struct
+{
+  const gchar *name;
+  gint64       start_time;
+  guint64      duration;
+  guint        workload;
+} ThunarStatsSlowCallback;
+
+void         thunar_stats_count                 (ThunarStatsCounter    counter);
+void         thunar_stats_record                (ThunarStatsHistogram  histogram,
+                                                 guint64               value);
+void         thunar_stats_record_since          (ThunarStatsHistogram  histogram,
+                                                 gint64                start_time);
+
+const gchar *thunar_stats_counter_get_name      (ThunarStatsCounter    counter);
+guint64      thunar_stats_counter_get_value     (ThunarStatsCounter    counter);
+
+const gchar *thunar_stats_histogram_get_name    (ThunarStatsHistogram  histogram);
+void         thunar_stats_histogram_get_values  (ThunarStatsHistogram  histogram,
+                                                 guint64              *count,
+                                                 guint64              *sum,
+                                                 guint64               buckets[THUNAR_STATS_N_BUCKETS]);
+
+void         thunar_stats_set_slow_threshold    (guint                 threshold);
+guint        thunar_stats_get_slow_threshold    (void);
+void         thunar_stats_record_callback       (const gchar          *name,
+                                                 gint64                start_time,
+                                                 guint                 workload);
+guint        thunar_stats_get_slow_callbacks    (ThunarStatsSlowCallback callbacks[THUNAR_STATS_N_SLOW_CALLBACKS]);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_STATS_H__ */
@@ -21,36 +21,93 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-text-renderer.h>
 #include <thunar/thunar-util.h>
 
 
 
+/* the number of shaped layouts kept for redrawing */
+#define THUNAR_TEXT_RENDERER_LAYOUT_CACHE_SIZE (1024)
+
+/* the number of measured text sizes kept for the layout of the views */
+#define THUNAR_TEXT_RENDERER_SIZE_CACHE_SIZE (65536)
+
+/* the for_width of the measured sizes without a given width */
+#define THUNAR_TEXT_SIZE_WIDTH  (-1)
+#define THUNAR_TEXT_SIZE_HEIGHT (-2)
+
+
+
+typedef struct _ThunarTextLayout ThunarTextLayout;
+typedef struct _ThunarTextSize   ThunarTextSize;
+
+
+
 enum
 {
   PROP_0,
   PROP_HIGHLIGHT_COLOR,
   PROP_ROUNDED_CORNERS,
   PROP_HIGHLIGHTING_ENABLED,
+  PROP_UNIFORM_LINES,
 };
 
 
 
-static void thunar_text_renderer_finalize       (GObject               *object);
-static void thunar_text_renderer_get_property   (GObject               *object,
-                                                 guint                  prop_id,
-                                                 GValue                *value,
-                                                 GParamSpec            *pspec);
-static void thunar_text_renderer_set_property   (GObject               *object,
-                                                 guint                  prop_id,
-                                                 const GValue          *value,
-                                                 GParamSpec            *pspec);
-static void thunar_text_renderer_render         (GtkCellRenderer       *renderer,
-                                                 cairo_t               *cr,
-                                                 GtkWidget             *widget,
-                                                 const GdkRectangle    *background_area,
-                                                 const GdkRectangle    *cell_area,
-                                                 GtkCellRendererState   flags);
+static void thunar_text_renderer_finalize                       (GObject              *object);
+static void thunar_text_renderer_get_property                   (GObject              *object,
+                                                                 guint                 prop_id,
+                                                                 GValue               *value,
+                                                                 GParamSpec           *pspec);
+static void thunar_text_renderer_set_property                   (GObject              *object,
+                                                                 guint                 prop_id,
+                                                                 const GValue         *value,
+                                                                 GParamSpec           *pspec);
+static void thunar_text_renderer_update_metrics                 (ThunarTextRenderer   *text_renderer,
+                                                                 GtkWidget            *widget);
+static guint thunar_text_layout_hash                            (gconstpointer         data);
+static gboolean thunar_text_layout_equal                        (gconstpointer         a,
+                                                                 gconstpointer         b);
+static void thunar_text_layout_free                             (gpointer              data);
+static guint thunar_text_size_hash                              (gconstpointer         data);
+static gboolean thunar_text_size_equal                          (gconstpointer         a,
+                                                                 gconstpointer         b);
+static void thunar_text_size_free                               (gpointer              data);
+static void thunar_text_renderer_measure                        (ThunarTextRenderer   *text_renderer,
+                                                                 GtkWidget            *widget,
+                                                                 gint                  for_width,
+                                                                 gint                 *minimum,
+                                                                 gint                 *natural);
+static void thunar_text_renderer_shape_layout                   (ThunarTextLayout     *entry,
+                                                                 GtkWidget            *widget);
+static ThunarTextLayout *thunar_text_renderer_get_layout        (ThunarTextRenderer   *text_renderer,
+                                                                 GtkWidget            *widget,
+                                                                 const GdkRectangle   *cell_area,
+                                                                 GtkCellRendererState  flags);
+static void thunar_text_renderer_get_preferred_width            (GtkCellRenderer      *renderer,
+                                                                 GtkWidget            *widget,
+                                                                 gint                 *minimum,
+                                                                 gint                 *natural);
+static void thunar_text_renderer_get_preferred_height           (GtkCellRenderer      *renderer,
+                                                                 GtkWidget            *widget,
+                                                                 gint                 *minimum,
+                                                                 gint                 *natural);
+static void thunar_text_renderer_get_preferred_height_for_width (GtkCellRenderer      *renderer,
+                                                                 GtkWidget            *widget,
+                                                                 gint                  width,
+                                                                 gint                 *minimum,
+                                                                 gint                 *natural);
+static void thunar_text_renderer_render                         (GtkCellRenderer      *renderer,
+                                                                 cairo_t              *cr,
+                                                                 GtkWidget            *widget,
+                                                                 const GdkRectangle   *background_area,
+                                                                 const GdkRectangle   *cell_area,
+                                                                 GtkCellRendererState  flags);
 
 
 
@@ -73,6 +130,70 @@ struct _ThunarTextRenderer
   gchar               *highlight_color;
   gboolean             rounded_corners;
   gboolean             highlighting_enabled;
+
+  /* if not 0, every cell is sized for this many lines of text without
+   * laying out the text, the font metrics are cached for the context */
+  gint                 uniform_lines;
+  PangoContext        *metrics_context;
+  guint                metrics_serial;
+  gint                 char_width;
+  gint                 line_height;
+
+  /* shaped layouts of recently drawn cells, the most recently used first
+   * in the queue, they are dropped when the font of the context changes */
+  GHashTable          *layouts;
+  GQueue               layouts_lru;
+  PangoContext        *layouts_context;
+  guint                layouts_serial;
+
+  /* measured sizes of the texts, so relayouts of the views only measure
+   * texts that changed, they are dropped when the font of the context changes */
+  GHashTable          *sizes;
+  GQueue               sizes_lru;
+  PangoContext        *sizes_context;
+  guint                sizes_serial;
+};
+
+struct _ThunarTextLayout
+{
+  /* everything the shaped layout depends on */
+  gchar               *text;
+  PangoAttrList       *attributes;
+  gint                 cell_width;
+  gint                 xpad;
+  gfloat               xalign;
+  gint                 wrap_width;
+  PangoWrapMode        wrap_mode;
+  PangoEllipsizeMode   ellipsize;
+  PangoAlignment       alignment;
+  GtkTextDirection     direction;
+  gboolean             foreground_set;
+  GdkRGBA              foreground;
+
+  /* the result */
+  PangoLayout         *layout;
+  gint                 x_offset;
+  gint                 height;
+  GList                link;
+};
+
+struct _ThunarTextSize
+{
+  /* everything the measured size depends on */
+  gchar               *text;
+  PangoAttrList       *attributes;
+  gint                 for_width;
+  gint                 xpad;
+  gint                 ypad;
+  gint                 wrap_width;
+  gint                 width_chars;
+  PangoWrapMode        wrap_mode;
+  PangoEllipsizeMode   ellipsize;
+
+  /* the result */
+  gint                 minimum;
+  gint                 natural;
+  GList                link;
 };
 
 
@@ -94,6 +215,9 @@ thunar_text_renderer_class_init (ThunarTextRendererClass *klass)
 
   klass->default_render_function = cell_class->render;
   cell_class->render = thunar_text_renderer_render;
+  cell_class->get_preferred_width = thunar_text_renderer_get_preferred_width;
+  cell_class->get_preferred_height = thunar_text_renderer_get_preferred_height;
+  cell_class->get_preferred_height_for_width = thunar_text_renderer_get_preferred_height_for_width;
 
   /**
    * ThunarTextRenderer:highlight-color:
@@ -132,6 +256,18 @@ thunar_text_renderer_class_init (ThunarTextRendererClass *klass)
                                    g_param_spec_boolean ("highlighting-enabled", "highlighting-enabled", "highlighting-enabled",
                                                          FALSE,
                                                          EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarTextRenderer:uniform-lines:
+   *
+   * If not 0, every cell gets the size of this many lines of text,
+   * without measuring the text itself. Longer texts are clipped.
+   **/
+  g_object_class_install_property (object_class,
+                                   PROP_UNIFORM_LINES,
+                                   g_param_spec_int ("uniform-lines", "uniform-lines", "uniform-lines",
+                                                     0, G_MAXINT, 0,
+                                                     EXO_PARAM_READWRITE));
 }
 
 
@@ -140,6 +276,13 @@ static void
 thunar_text_renderer_init (ThunarTextRenderer *text_renderer)
 {
   text_renderer->highlight_color = NULL;
+
+  /* the entries own their keys */
+  text_renderer->layouts = g_hash_table_new_full (thunar_text_layout_hash, thunar_text_layout_equal, NULL, thunar_text_layout_free);
+  g_queue_init (&text_renderer->layouts_lru);
+
+  text_renderer->sizes = g_hash_table_new_full (thunar_text_size_hash, thunar_text_size_equal, NULL, thunar_text_size_free);
+  g_queue_init (&text_renderer->sizes_lru);
 }
 
 
@@ -151,6 +294,17 @@ thunar_text_renderer_finalize (GObject *object)
 
   g_free (text_renderer->highlight_color);
 
+  if (text_renderer->metrics_context != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (text_renderer->metrics_context), (gpointer) &text_renderer->metrics_context);
+
+  g_hash_table_destroy (text_renderer->layouts);
+  if (text_renderer->layouts_context != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (text_renderer->layouts_context), (gpointer) &text_renderer->layouts_context);
+
+  g_hash_table_destroy (text_renderer->sizes);
+  if (text_renderer->sizes_context != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (text_renderer->sizes_context), (gpointer) &text_renderer->sizes_context);
+
   G_OBJECT_CLASS (thunar_text_renderer_parent_class)->finalize (object);
 }
 
@@ -178,6 +332,10 @@ thunar_text_renderer_get_property (GObject    *object,
       g_value_set_boolean (value, text_renderer->highlighting_enabled);
       break;
 
+    case PROP_UNIFORM_LINES:
+      g_value_set_int (value, text_renderer->uniform_lines);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -209,6 +367,10 @@ thunar_text_renderer_set_property (GObject      *object,
       text_renderer->highlighting_enabled = g_value_get_boolean (value);
       break;
 
+    case PROP_UNIFORM_LINES:
+      text_renderer->uniform_lines = g_value_get_int (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -253,13 +415,482 @@ thunar_text_renderer_clear_background (cairo_t   *cr,
 
 
 static void
-thunar_text_renderer_render (GtkCellRenderer      *cell,
-                             cairo_t              *cr,
-                             GtkWidget            *widget,
-                             const GdkRectangle   *background_area,
-                             const GdkRectangle   *cell_area,
-                             GtkCellRendererState  flags)
+thunar_text_renderer_update_metrics (ThunarTextRenderer *text_renderer,
+                                     GtkWidget          *widget)
+{
+  PangoFontMetrics *metrics;
+  PangoContext     *context;
+
+  /* the metrics only change with the font of the widget */
+  context = gtk_widget_get_pango_context (widget);
+  if (text_renderer->metrics_context == context
+      && text_renderer->metrics_serial == pango_context_get_serial (context))
+    return;
+
+  if (text_renderer->metrics_context != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (text_renderer->metrics_context), (gpointer) &text_renderer->metrics_context);
+  text_renderer->metrics_context = context;
+  g_object_add_weak_pointer (G_OBJECT (context), (gpointer) &text_renderer->metrics_context);
+  text_renderer->metrics_serial = pango_context_get_serial (context);
+
+  metrics = pango_context_get_metrics (context, pango_context_get_font_description (context), pango_context_get_language (context));
+  text_renderer->char_width = PANGO_PIXELS_CEIL (pango_font_metrics_get_approximate_char_width (metrics));
+  text_renderer->line_height = PANGO_PIXELS_CEIL (pango_font_metrics_get_ascent (metrics) + pango_font_metrics_get_descent (metrics));
+  pango_font_metrics_unref (metrics);
+}
+
+
+
+static void
+thunar_text_renderer_get_preferred_width (GtkCellRenderer *renderer,
+                                          GtkWidget       *widget,
+                                          gint            *minimum,
+                                          gint            *natural)
+{
+  ThunarTextRenderer *text_renderer = THUNAR_TEXT_RENDERER (renderer);
+  gint                wrap_width;
+  gint                width_chars;
+  gint                xpad;
+  gint                width;
+
+  g_object_get (G_OBJECT (renderer), "wrap-width", &wrap_width, "width-chars", &width_chars, NULL);
+
+  /* without a wrap width or a number of characters the width depends on the text */
+  if (text_renderer->uniform_lines == 0 || (wrap_width <= 0 && width_chars <= 0))
+    {
+      thunar_text_renderer_measure (text_renderer, widget, THUNAR_TEXT_SIZE_WIDTH, minimum, natural);
+      return;
+    }
+
+  thunar_text_renderer_update_metrics (text_renderer, widget);
+  gtk_cell_renderer_get_padding (renderer, &xpad, NULL);
+
+  width = (wrap_width > 0) ? wrap_width : width_chars * text_renderer->char_width;
+
+  if (G_LIKELY (minimum)) *minimum = xpad * 2 + width;
+  if (G_LIKELY (natural)) *natural = xpad * 2 + width;
+}
+
+
+
+static void
+thunar_text_renderer_get_preferred_height (GtkCellRenderer *renderer,
+                                           GtkWidget       *widget,
+                                           gint            *minimum,
+                                           gint            *natural)
+{
+  ThunarTextRenderer *text_renderer = THUNAR_TEXT_RENDERER (renderer);
+  gint                ypad;
+
+  if (text_renderer->uniform_lines == 0)
+    {
+      thunar_text_renderer_measure (text_renderer, widget, THUNAR_TEXT_SIZE_HEIGHT, minimum, natural);
+      return;
+    }
+
+  thunar_text_renderer_update_metrics (text_renderer, widget);
+  gtk_cell_renderer_get_padding (renderer, NULL, &ypad);
+
+  if (G_LIKELY (minimum)) *minimum = ypad * 2 + text_renderer->uniform_lines * text_renderer->line_height;
+  if (G_LIKELY (natural)) *natural = ypad * 2 + text_renderer->uniform_lines * text_renderer->line_height;
+}
+
+
+
+static void
+thunar_text_renderer_get_preferred_height_for_width (GtkCellRenderer *renderer,
+                                                     GtkWidget       *widget,
+                                                     gint             width,
+                                                     gint            *minimum,
+                                                     gint            *natural)
+{
+  /* the uniform height does not depend on the width */
+  if (THUNAR_TEXT_RENDERER (renderer)->uniform_lines != 0)
+    thunar_text_renderer_get_preferred_height (renderer, widget, minimum, natural);
+  else
+    thunar_text_renderer_measure (THUNAR_TEXT_RENDERER (renderer), widget, MAX (width, 0), minimum, natural);
+}
+
+
+
+static guint
+thunar_text_size_hash (gconstpointer data)
+{
+  const ThunarTextSize *entry = data;
+
+  return g_str_hash (entry->text) ^ (guint) entry->for_width ^ ((guint) entry->wrap_width << 16);
+}
+
+
+
+static gboolean
+thunar_text_size_equal (gconstpointer a,
+                        gconstpointer b)
+{
+  const ThunarTextSize *a_entry = a;
+  const ThunarTextSize *b_entry = b;
+
+  return a_entry->for_width == b_entry->for_width
+      && a_entry->xpad == b_entry->xpad
+      && a_entry->ypad == b_entry->ypad
+      && a_entry->wrap_width == b_entry->wrap_width
+      && a_entry->width_chars == b_entry->width_chars
+      && a_entry->wrap_mode == b_entry->wrap_mode
+      && a_entry->ellipsize == b_entry->ellipsize
+      && a_entry->attributes == b_entry->attributes
+      && strcmp (a_entry->text, b_entry->text) == 0;
+}
+
+
+
+static void
+thunar_text_size_free (gpointer data)
+{
+  ThunarTextSize *entry = data;
+
+  if (entry->attributes != NULL)
+    pango_attr_list_unref (entry->attributes);
+  g_free (entry->text);
+  g_slice_free (ThunarTextSize, entry);
+}
+
+
+
+static void
+thunar_text_renderer_measure (ThunarTextRenderer *text_renderer,
+                              GtkWidget          *widget,
+                              gint                for_width,
+                              gint               *minimum,
+                              gint               *natural)
+{
+  GtkCellRendererClass *parent_class = GTK_CELL_RENDERER_CLASS (thunar_text_renderer_parent_class);
+  GtkCellRenderer      *renderer = GTK_CELL_RENDERER (text_renderer);
+  ThunarTextSize        lookup;
+  ThunarTextSize       *entry;
+  PangoContext         *context;
+  gboolean              ellipsize_set;
+
+  /* sizes are measured with the font of the pango context of the
+   * widget, so start over once that or its scale changes */
+  context = gtk_widget_get_pango_context (widget);
+  if (text_renderer->sizes_context != context
+      || text_renderer->sizes_serial != pango_context_get_serial (context))
+    {
+      /* the links are embedded in the entries */
+      g_hash_table_remove_all (text_renderer->sizes);
+      g_queue_init (&text_renderer->sizes_lru);
+
+      if (text_renderer->sizes_context != NULL)
+        g_object_remove_weak_pointer (G_OBJECT (text_renderer->sizes_context), (gpointer) &text_renderer->sizes_context);
+      text_renderer->sizes_context = context;
+      g_object_add_weak_pointer (G_OBJECT (context), (gpointer) &text_renderer->sizes_context);
+      text_renderer->sizes_serial = pango_context_get_serial (context);
+    }
+
+  g_object_get (G_OBJECT (text_renderer),
+                "text", &lookup.text,
+                "attributes", &lookup.attributes,
+                "wrap-width", &lookup.wrap_width,
+                "width-chars", &lookup.width_chars,
+                "wrap-mode", &lookup.wrap_mode,
+                "ellipsize", &lookup.ellipsize,
+                "ellipsize-set", &ellipsize_set,
+                NULL);
+
+  if (!ellipsize_set)
+    lookup.ellipsize = PANGO_ELLIPSIZE_NONE;
+
+  entry = NULL;
+  if (G_LIKELY (lookup.text != NULL))
+    {
+      gtk_cell_renderer_get_padding (renderer, &lookup.xpad, &lookup.ypad);
+      lookup.for_width = for_width;
+      entry = g_hash_table_lookup (text_renderer->sizes, &lookup);
+    }
+
+  if (G_LIKELY (entry != NULL))
+    {
+      g_free (lookup.text);
+      if (lookup.attributes != NULL)
+        pango_attr_list_unref (lookup.attributes);
+
+      /* move the size to the front of the queue */
+      g_queue_unlink (&text_renderer->sizes_lru, &entry->link);
+      g_queue_push_head_link (&text_renderer->sizes_lru, &entry->link);
+
+      if (G_LIKELY (minimum)) *minimum = entry->minimum;
+      if (G_LIKELY (natural)) *natural = entry->natural;
+      return;
+    }
+
+  /* measure the text like GtkCellRendererText does */
+  if (for_width == THUNAR_TEXT_SIZE_WIDTH)
+    parent_class->get_preferred_width (renderer, widget, &lookup.minimum, &lookup.natural);
+  else if (for_width == THUNAR_TEXT_SIZE_HEIGHT)
+    parent_class->get_preferred_height (renderer, widget, &lookup.minimum, &lookup.natural);
+  else
+    parent_class->get_preferred_height_for_width (renderer, widget, for_width, &lookup.minimum, &lookup.natural);
+
+  if (G_LIKELY (minimum)) *minimum = lookup.minimum;
+  if (G_LIKELY (natural)) *natural = lookup.natural;
+
+  /* nothing worth remembering without a text */
+  if (G_UNLIKELY (lookup.text == NULL))
+    {
+      if (lookup.attributes != NULL)
+        pango_attr_list_unref (lookup.attributes);
+      return;
+    }
+
+  /* the entry takes over the key */
+  entry = g_slice_dup (ThunarTextSize, &lookup);
+  entry->link.data = entry;
+  entry->link.prev = entry->link.next = NULL;
+
+  g_hash_table_add (text_renderer->sizes, entry);
+  g_queue_push_head_link (&text_renderer->sizes_lru, &entry->link);
+
+  /* forget the least recently used sizes */
+  while (text_renderer->sizes_lru.length > THUNAR_TEXT_RENDERER_SIZE_CACHE_SIZE)
+    g_hash_table_remove (text_renderer->sizes, g_queue_pop_tail_link (&text_renderer->sizes_lru)->data);
+}
+
+
+
+static guint
+thunar_text_layout_hash (gconstpointer data)
+{
+  const ThunarTextLayout *entry = data;
+
+  return g_str_hash (entry->text) ^ (guint) entry->cell_width ^ ((guint) entry->wrap_width << 16);
+}
+
+
+
+static gboolean
+thunar_text_layout_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const ThunarTextLayout *a_entry = a;
+  const ThunarTextLayout *b_entry = b;
+
+  return a_entry->cell_width == b_entry->cell_width
+      && a_entry->xpad == b_entry->xpad
+      && a_entry->xalign == b_entry->xalign
+      && a_entry->wrap_width == b_entry->wrap_width
+      && a_entry->wrap_mode == b_entry->wrap_mode
+      && a_entry->ellipsize == b_entry->ellipsize
+      && a_entry->alignment == b_entry->alignment
+      && a_entry->direction == b_entry->direction
+      && a_entry->attributes == b_entry->attributes
+      && a_entry->foreground_set == b_entry->foreground_set
+      && (!a_entry->foreground_set || gdk_rgba_equal (&a_entry->foreground, &b_entry->foreground))
+      && strcmp (a_entry->text, b_entry->text) == 0;
+}
+
+
+
+static void
+thunar_text_layout_free (gpointer data)
+{
+  ThunarTextLayout *entry = data;
+
+  if (entry->layout != NULL)
+    g_object_unref (entry->layout);
+  if (entry->attributes != NULL)
+    pango_attr_list_unref (entry->attributes);
+  g_free (entry->text);
+  g_slice_free (ThunarTextLayout, entry);
+}
+
+
+
+static void
+thunar_text_renderer_shape_layout (ThunarTextLayout *entry,
+                                   GtkWidget        *widget)
+{
+  PangoAttrList  *attributes;
+  PangoAttribute *attribute;
+  PangoRectangle  rect;
+  gint            width;
+
+  /* this follows what GtkCellRendererText does for the properties used in thunar */
+  entry->layout = gtk_widget_create_pango_layout (widget, NULL);
+
+  attributes = (entry->attributes != NULL) ? pango_attr_list_copy (entry->attributes) : pango_attr_list_new ();
+  if (entry->foreground_set)
+    {
+      attribute = pango_attr_foreground_new (entry->foreground.red * 65535,
+                                             entry->foreground.green * 65535,
+                                             entry->foreground.blue * 65535);
+      attribute->start_index = 0;
+      attribute->end_index = G_MAXINT;
+      pango_attr_list_insert (attributes, attribute);
+
+      attribute = pango_attr_foreground_alpha_new (entry->foreground.alpha * 65535);
+      attribute->start_index = 0;
+      attribute->end_index = G_MAXINT;
+      pango_attr_list_insert (attributes, attribute);
+    }
+  pango_layout_set_attributes (entry->layout, attributes);
+  pango_attr_list_unref (attributes);
+
+  pango_layout_set_text (entry->layout, entry->text, -1);
+  pango_layout_set_ellipsize (entry->layout, entry->ellipsize);
+
+  if (entry->wrap_width != -1)
+    {
+      /* wrap at the cell width, but never make the layout wider than the text */
+      pango_layout_get_extents (entry->layout, NULL, &rect);
+      width = MIN ((entry->cell_width - entry->xpad * 2) * PANGO_SCALE, rect.width);
+      pango_layout_set_width (entry->layout, width);
+      pango_layout_set_wrap (entry->layout, entry->wrap_mode);
+    }
+  else
+    {
+      pango_layout_set_width (entry->layout, -1);
+      pango_layout_set_wrap (entry->layout, PANGO_WRAP_CHAR);
+    }
+
+  pango_layout_set_alignment (entry->layout, entry->alignment);
+
+  /* determine the horizontal position in the cell */
+  pango_layout_get_pixel_extents (entry->layout, NULL, &rect);
+  entry->height = rect.height;
+  rect.width = MIN (rect.width, entry->cell_width - 2 * entry->xpad);
+  if (entry->direction == GTK_TEXT_DIR_RTL)
+    entry->x_offset = (1.0 - entry->xalign) * (entry->cell_width - (rect.width + (2 * entry->xpad)));
+  else
+    entry->x_offset = entry->xalign * (entry->cell_width - (rect.width + (2 * entry->xpad)));
+  if (entry->ellipsize != PANGO_ELLIPSIZE_NONE || entry->wrap_width != -1)
+    entry->x_offset = MAX (entry->x_offset, 0);
+
+  /* ellipsize in the space that is left */
+  if (entry->ellipsize != PANGO_ELLIPSIZE_NONE)
+    pango_layout_set_width (entry->layout, (entry->cell_width - entry->x_offset - 2 * entry->xpad) * PANGO_SCALE);
+}
+
+
+
+static ThunarTextLayout*
+thunar_text_renderer_get_layout (ThunarTextRenderer  *text_renderer,
+                                 GtkWidget           *widget,
+                                 const GdkRectangle  *cell_area,
+                                 GtkCellRendererState flags)
 {
+  ThunarTextLayout  lookup;
+  ThunarTextLayout *entry;
+  PangoContext     *context;
+  GdkRGBA          *foreground = NULL;
+  gboolean          ellipsize_set;
+  gboolean          align_set;
+
+  /* layouts belong to the pango context of the widget, and are
+   * shaped for its font, so start over once that changes */
+  context = gtk_widget_get_pango_context (widget);
+  if (text_renderer->layouts_context != context
+      || text_renderer->layouts_serial != pango_context_get_serial (context))
+    {
+      /* the links are embedded in the entries */
+      g_hash_table_remove_all (text_renderer->layouts);
+      g_queue_init (&text_renderer->layouts_lru);
+
+      if (text_renderer->layouts_context != NULL)
+        g_object_remove_weak_pointer (G_OBJECT (text_renderer->layouts_context), (gpointer) &text_renderer->layouts_context);
+      text_renderer->layouts_context = context;
+      g_object_add_weak_pointer (G_OBJECT (context), (gpointer) &text_renderer->layouts_context);
+      text_renderer->layouts_serial = pango_context_get_serial (context);
+    }
+
+  g_object_get (G_OBJECT (text_renderer),
+                "text", &lookup.text,
+                "attributes", &lookup.attributes,
+                "wrap-width", &lookup.wrap_width,
+                "wrap-mode", &lookup.wrap_mode,
+                "ellipsize", &lookup.ellipsize,
+                "ellipsize-set", &ellipsize_set,
+                "alignment", &lookup.alignment,
+                "align-set", &align_set,
+                "foreground-set", &lookup.foreground_set,
+                "foreground-rgba", &foreground,
+                NULL);
+
+  /* nothing to draw, leave that to GtkCellRendererText */
+  if (G_UNLIKELY (lookup.text == NULL))
+    {
+      if (lookup.attributes != NULL)
+        pango_attr_list_unref (lookup.attributes);
+      if (foreground != NULL)
+        gdk_rgba_free (foreground);
+      return NULL;
+    }
+
+  gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (text_renderer), &lookup.xpad, NULL);
+  gtk_cell_renderer_get_alignment (GTK_CELL_RENDERER (text_renderer), &lookup.xalign, NULL);
+  lookup.cell_width = cell_area->width;
+  lookup.direction = gtk_widget_get_direction (widget);
+
+  if (!ellipsize_set)
+    lookup.ellipsize = PANGO_ELLIPSIZE_NONE;
+  if (!align_set)
+    lookup.alignment = (lookup.direction == GTK_TEXT_DIR_RTL) ? PANGO_ALIGN_RIGHT : PANGO_ALIGN_LEFT;
+
+  /* the foreground color is not used for selected cells */
+  lookup.foreground_set = lookup.foreground_set && foreground != NULL && (flags & GTK_CELL_RENDERER_SELECTED) == 0;
+  if (lookup.foreground_set)
+    lookup.foreground = *foreground;
+  if (foreground != NULL)
+    gdk_rgba_free (foreground);
+
+  entry = g_hash_table_lookup (text_renderer->layouts, &lookup);
+  if (G_LIKELY (entry != NULL))
+    {
+      g_free (lookup.text);
+      if (lookup.attributes != NULL)
+        pango_attr_list_unref (lookup.attributes);
+
+      /* move the layout to the front of the queue */
+      g_queue_unlink (&text_renderer->layouts_lru, &entry->link);
+      g_queue_push_head_link (&text_renderer->layouts_lru, &entry->link);
+
+      return entry;
+    }
+
+  /* shape a new layout, the entry takes over the key */
+  entry = g_slice_dup (ThunarTextLayout, &lookup);
+  entry->link.data = entry;
+  entry->link.prev = entry->link.next = NULL;
+  thunar_text_renderer_shape_layout (entry, widget);
+
+  g_hash_table_add (text_renderer->layouts, entry);
+  g_queue_push_head_link (&text_renderer->layouts_lru, &entry->link);
+
+  /* forget the least recently used layouts */
+  while (text_renderer->layouts_lru.length > THUNAR_TEXT_RENDERER_LAYOUT_CACHE_SIZE)
+    g_hash_table_remove (text_renderer->layouts, g_queue_pop_tail_link (&text_renderer->layouts_lru)->data);
+
+  return entry;
+}
+
+
+
+static void
+thunar_text_renderer_render_cell (GtkCellRenderer      *cell,
+                                  cairo_t              *cr,
+                                  GtkWidget            *widget,
+                                  const GdkRectangle   *background_area,
+                                  const GdkRectangle   *cell_area,
+                                  GtkCellRendererState  flags)
+{
+  ThunarTextLayout *entry;
+  GdkRGBA          *background;
+  gboolean          background_set;
+  gfloat            yalign;
+  gint              xpad;
+  gint              ypad;
+  gint              height;
+  gint              y_offset;
+
   if (THUNAR_TEXT_RENDERER (cell)->highlighting_enabled)
     {
       /* This should paint on top of the current surface. This should hide the highlight
@@ -271,8 +902,57 @@ thunar_text_renderer_render (GtkCellRenderer      *cell,
       thunar_util_clip_view_background (cell, cr, background_area, widget, flags);
     }
 
-  /* we only needed to manipulate the background_area, otherwise everything remains the same.
-     Hence, we are simply running the original render function now */
-  THUNAR_TEXT_RENDERER_GET_CLASS (THUNAR_TEXT_RENDERER (cell))
-    ->default_render_function (cell, cr, widget, background_area, cell_area, flags);
+  /* draw the text from the shaped layout of the last draw, if possible */
+  entry = thunar_text_renderer_get_layout (THUNAR_TEXT_RENDERER (cell), widget, cell_area, flags);
+  if (G_UNLIKELY (entry == NULL))
+    {
+      /* we only needed to manipulate the background_area, otherwise everything remains the same.
+         Hence, we are simply running the original render function now */
+      THUNAR_TEXT_RENDERER_GET_CLASS (THUNAR_TEXT_RENDERER (cell))
+        ->default_render_function (cell, cr, widget, background_area, cell_area, flags);
+      return;
+    }
+
+  /* paint the background like GtkCellRendererText does */
+  g_object_get (G_OBJECT (cell), "background-set", &background_set, NULL);
+  if (G_UNLIKELY (background_set && (flags & GTK_CELL_RENDERER_SELECTED) == 0))
+    {
+      g_object_get (G_OBJECT (cell), "background-rgba", &background, NULL);
+      gdk_cairo_rectangle (cr, background_area);
+      gdk_cairo_set_source_rgba (cr, background);
+      cairo_fill (cr);
+      gdk_rgba_free (background);
+    }
+
+  gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
+  gtk_cell_renderer_get_alignment (cell, NULL, &yalign);
+
+  /* position the text vertically in the cell */
+  height = MIN (entry->height, cell_area->height - 2 * ypad);
+  y_offset = MAX (yalign * (cell_area->height - (height + 2 * ypad)), 0);
+
+  cairo_save (cr);
+  gdk_cairo_rectangle (cr, cell_area);
+  cairo_clip (cr);
+  gtk_render_layout (gtk_widget_get_style_context (widget), cr,
+                     cell_area->x + entry->x_offset + xpad,
+                     cell_area->y + y_offset + ypad,
+                     entry->layout);
+  cairo_restore (cr);
+}
+
+
+
+static void
+thunar_text_renderer_render (GtkCellRenderer      *cell,
+                             cairo_t              *cr,
+                             GtkWidget            *widget,
+                             const GdkRectangle   *background_area,
+                             const GdkRectangle   *cell_area,
+                             GtkCellRendererState  flags)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  thunar_text_renderer_render_cell (cell, cr, widget, background_area, cell_area, flags);
+  thunar_stats_record_since (THUNAR_STATS_TEXT_RENDERER, start_time);
 }
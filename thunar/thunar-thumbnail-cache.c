@@ -35,9 +35,15 @@
 #define _thumbnail_cache_lock(cache)   g_mutex_lock (&((cache)->lock))
 #define _thumbnail_cache_unlock(cache) g_mutex_unlock (&((cache)->lock))
 
+/* maximum number of moved or copied files passed to the cache service in one call */
+#define THUNAR_THUMBNAIL_CACHE_CHUNK_SIZE 1000
 
 
-static void thunar_thumbnail_cache_finalize (GObject *object);
+
+static void     thunar_thumbnail_cache_finalize           (GObject                   *object);
+static void     thunar_thumbnail_cache_queue_clear        (ThunarThumbnailCacheQueue *queue);
+static gboolean thunar_thumbnail_cache_process_move_queue (gpointer                   user_data);
+static gboolean thunar_thumbnail_cache_process_copy_queue (gpointer                   user_data);
 
 
 
@@ -48,6 +54,22 @@ enum
   THUNAR_THUMBNAIL_CACHE_PROXY_FAILED
 };
 
+/* moved or copied files waiting to be passed to the cache service, the
+ * URIs are determined when the files are queued and sent from the arrays
+ * in chunks of THUNAR_THUMBNAIL_CACHE_CHUNK_SIZE, see
+ * thunar_thumbnail_cache_process_queue() */
+typedef struct
+{
+  GPtrArray *source_uris;
+  GPtrArray *target_uris;
+  GPtrArray *target_files;
+
+  /* number of files already passed to the cache service */
+  guint      n_sent;
+  gboolean   sending;
+  guint      idle_id;
+} ThunarThumbnailCacheQueue;
+
 struct _ThunarThumbnailCacheClass
 {
   GObjectClass __parent__;
@@ -60,13 +82,8 @@ struct _ThunarThumbnailCache
   ThunarThumbnailCacheDBus *cache_proxy;
   int                       proxy_state;
 
-  GList      *move_source_queue;
-  GList      *move_target_queue;
-  guint       move_queue_idle_id;
-
-  GList      *copy_source_queue;
-  GList      *copy_target_queue;
-  guint       copy_queue_idle_id;
+  ThunarThumbnailCacheQueue move_queue;
+  ThunarThumbnailCacheQueue copy_queue;
 
   GList      *delete_queue;
   guint       delete_queue_idle_id;
@@ -105,17 +122,9 @@ thunar_thumbnail_cache_finalize (GObject *object)
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
-  /* drop the move queue idle and all queued files */
-  if (cache->move_queue_idle_id > 0)
-    g_source_remove (cache->move_queue_idle_id);
-  g_list_free_full (cache->move_source_queue, g_object_unref);
-  g_list_free_full (cache->move_target_queue, g_object_unref);
-
-  /* drop the copy queue idle and all queued files */
-  if (cache->copy_queue_idle_id > 0)
-    g_source_remove (cache->copy_queue_idle_id);
-  g_list_free_full (cache->copy_source_queue, g_object_unref);
-  g_list_free_full (cache->copy_target_queue, g_object_unref);
+  /* drop the move and copy queue idles and all queued files */
+  thunar_thumbnail_cache_queue_clear (&cache->move_queue);
+  thunar_thumbnail_cache_queue_clear (&cache->copy_queue);
 
   /* drop the delete queue idle and all queued files */
   if (cache->delete_queue_idle_id > 0)
@@ -147,9 +156,10 @@ thunar_thumbnail_cache_copy_async_reply (ThunarThumbnailCacheDBus *proxy,
                                          GAsyncResult             *res,
                                          gpointer                  user_data)
 {
-  GList      *li;
+  GPtrArray  *target_files = user_data;
   ThunarFile *file;
   GError     *error = NULL;
+  guint       n;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE_DBUS (proxy));
 
@@ -159,9 +169,9 @@ thunar_thumbnail_cache_copy_async_reply (ThunarThumbnailCacheDBus *proxy,
     }
   g_clear_error (&error);
 
-  for (li = user_data; li != NULL; li = li->next)
+  for (n = 0; n < target_files->len; ++n)
     {
-      file = thunar_file_cache_lookup (G_FILE (li->data));
+      file = thunar_file_cache_lookup (G_FILE (g_ptr_array_index (target_files, n)));
 
       if (G_LIKELY (file != NULL))
         {
@@ -171,7 +181,7 @@ thunar_thumbnail_cache_copy_async_reply (ThunarThumbnailCacheDBus *proxy,
         }
     }
 
-  g_list_free_full (user_data, g_object_unref);
+  g_ptr_array_unref (target_files);
 }
 
 
@@ -181,9 +191,10 @@ thunar_thumbnail_cache_move_async_reply (ThunarThumbnailCacheDBus *proxy,
                                          GAsyncResult             *res,
                                          gpointer                  user_data)
 {
-  GList      *li;
+  GPtrArray  *target_files = user_data;
   ThunarFile *file;
   GError     *error = NULL;
+  guint       n;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE_DBUS (proxy));
 
@@ -193,9 +204,9 @@ thunar_thumbnail_cache_move_async_reply (ThunarThumbnailCacheDBus *proxy,
     }
   g_clear_error (&error);
 
-  for (li = user_data; li != NULL; li = li->next)
+  for (n = 0; n < target_files->len; ++n)
     {
-      file = thunar_file_cache_lookup (G_FILE (li->data));
+      file = thunar_file_cache_lookup (G_FILE (g_ptr_array_index (target_files, n)));
 
       if (G_LIKELY (file != NULL))
         {
@@ -205,7 +216,7 @@ thunar_thumbnail_cache_move_async_reply (ThunarThumbnailCacheDBus *proxy,
         }
     }
 
-  g_list_free_full (user_data, g_object_unref);
+  g_ptr_array_unref (target_files);
 }
 
 
@@ -279,88 +290,113 @@ thunar_thumbnail_cache_cleanup_async (ThunarThumbnailCache *cache,
 
 
 
+static void
+thunar_thumbnail_cache_queue_init (ThunarThumbnailCacheQueue *queue)
+{
+  queue->source_uris = g_ptr_array_new_with_free_func (g_free);
+  queue->target_uris = g_ptr_array_new_with_free_func (g_free);
+  queue->target_files = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+
+
+static void
+thunar_thumbnail_cache_queue_clear (ThunarThumbnailCacheQueue *queue)
+{
+  if (queue->idle_id > 0)
+    g_source_remove (queue->idle_id);
+  queue->idle_id = 0;
+
+  g_ptr_array_unref (queue->source_uris);
+  g_ptr_array_unref (queue->target_uris);
+  g_ptr_array_unref (queue->target_files);
+}
+
+
+
+static void
+thunar_thumbnail_cache_schedule_queue (ThunarThumbnailCache *cache,
+                                       gboolean              copy_async)
+{
+  ThunarThumbnailCacheQueue *queue = copy_async ? &cache->copy_queue : &cache->move_queue;
+
+  /* a queue being sent picks up the new files by itself */
+  if (queue->sending || queue->source_uris->len == 0)
+    return;
+
+  /* cancel any pending timeout to process the queue */
+  if (queue->idle_id > 0)
+    g_source_remove (queue->idle_id);
+
+  /* process the move queue in a 250ms and the copy queue in a 500ms timeout */
+  queue->idle_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, copy_async ? 500 : 250,
+                                       copy_async ? thunar_thumbnail_cache_process_copy_queue
+                                                  : thunar_thumbnail_cache_process_move_queue,
+                                       cache, NULL);
+}
+
+
+
 static gboolean
 thunar_thumbnail_cache_process_queue (ThunarThumbnailCache *cache,
                                       gboolean              copy_async)
 {
-  GList  *sp;
-  GList  *tp;
-  gchar **source_uris;
-  gchar **target_uris;
-  guint   n_uris;
-  guint   n;
-  GList  *source_queue;
-  GList  *target_queue;
+  ThunarThumbnailCacheQueue *queue;
+  const gchar               *source_uris[THUNAR_THUMBNAIL_CACHE_CHUNK_SIZE + 1];
+  const gchar               *target_uris[THUNAR_THUMBNAIL_CACHE_CHUNK_SIZE + 1];
+  GPtrArray                 *target_files;
+  guint                      n_uris;
+  guint                      n;
 
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache), FALSE);
 
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
-  /* steal the lists */
-  if (copy_async)
-    {
-      source_queue = cache->copy_source_queue;
-      cache->copy_source_queue = NULL;
-      target_queue = cache->copy_target_queue;
-      cache->copy_target_queue = NULL;
-    }
-  else
-    {
-      source_queue = cache->move_source_queue;
-      cache->move_source_queue = NULL;
-      target_queue = cache->move_target_queue;
-      cache->move_target_queue = NULL;
-    }
+  queue = copy_async ? &cache->copy_queue : &cache->move_queue;
+  queue->idle_id = 0;
 
-  /* compute how many URIs there are */
-  n_uris = g_list_length (source_queue);
-
-  /* allocate a string array for the URIs */
-  source_uris = g_new0 (gchar *, n_uris + 1);
-  target_uris = g_new0 (gchar *, n_uris + 1);
-
-  /* fill URI array with file URIs from the move queue */
-  for (n = 0,
-       sp = g_list_last (source_queue),
-       tp = g_list_last (target_queue);
-       sp != NULL && tp != NULL;
-       sp = sp->prev, tp = tp->prev, ++n)
+  /* pass the next chunk of the queue, the strings are copied by the call */
+  n_uris = MIN (queue->source_uris->len - queue->n_sent, THUNAR_THUMBNAIL_CACHE_CHUNK_SIZE);
+  target_files = g_ptr_array_new_full (n_uris, g_object_unref);
+  for (n = 0; n < n_uris; ++n)
     {
-      source_uris[n] = g_file_get_uri (sp->data);
-      target_uris[n] = g_file_get_uri (tp->data);
-
-      /* release the source object */
-      g_object_unref (sp->data);
+      source_uris[n] = g_ptr_array_index (queue->source_uris, queue->n_sent + n);
+      target_uris[n] = g_ptr_array_index (queue->target_uris, queue->n_sent + n);
+      g_ptr_array_add (target_files, g_object_ref (g_ptr_array_index (queue->target_files, queue->n_sent + n)));
     }
-
-  /* NULL-terminate the URI arrays */
   source_uris[n] = NULL;
   target_uris[n] = NULL;
+  queue->n_sent += n_uris;
 
   if (copy_async)
     {
       /* asynchronously copy the thumbnails */
-      thunar_thumbnail_cache_copy_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
+      thunar_thumbnail_cache_copy_async (cache, source_uris, target_uris, target_files);
     }
   else
     {
       /* asynchronously move the thumbnails */
-      thunar_thumbnail_cache_move_async (cache,
-                                         (const gchar **)source_uris,
-                                         (const gchar **)target_uris,
-                                         target_queue);
+      thunar_thumbnail_cache_move_async (cache, source_uris, target_uris, target_files);
     }
 
-  /* free the URI arrays */
-  g_strfreev (source_uris);
-  g_strfreev (target_uris);
-
-  /* release the move queue lists */
-  g_list_free (source_queue);
+  if (queue->n_sent < queue->source_uris->len)
+    {
+      /* pass the remaining files without delay */
+      queue->sending = TRUE;
+      queue->idle_id = g_idle_add (copy_async ? thunar_thumbnail_cache_process_copy_queue
+                                              : thunar_thumbnail_cache_process_move_queue,
+                                   cache);
+    }
+  else
+    {
+      /* the queue is empty, keep the arrays for the next files */
+      g_ptr_array_set_size (queue->source_uris, 0);
+      g_ptr_array_set_size (queue->target_uris, 0);
+      g_ptr_array_set_size (queue->target_files, 0);
+      queue->n_sent = 0;
+      queue->sending = FALSE;
+    }
 
   /* release the cache lock */
   _thumbnail_cache_unlock (cache);
@@ -378,14 +414,6 @@ thunar_thumbnail_cache_process_move_queue (gpointer user_data)
 
 
 
-static void
-thunar_thumbnail_cache_process_move_queue_destroy (gpointer user_data)
-{
-  THUNAR_THUMBNAIL_CACHE (user_data)->move_queue_idle_id = 0;
-}
-
-
-
 static gboolean
 thunar_thumbnail_cache_process_copy_queue (gpointer user_data)
 {
@@ -394,14 +422,6 @@ thunar_thumbnail_cache_process_copy_queue (gpointer user_data)
 
 
 
-static void
-thunar_thumbnail_cache_process_copy_queue_destroy (gpointer user_data)
-{
-  THUNAR_THUMBNAIL_CACHE (user_data)->copy_queue_idle_id = 0;
-}
-
-
-
 static gboolean
 thunar_thumbnail_cache_process_delete_queue (gpointer user_data)
 {
@@ -524,88 +544,112 @@ thunar_thumbnail_cache_new (void)
 
 
 
-void
-thunar_thumbnail_cache_move_file (ThunarThumbnailCache *cache,
-                                  GFile                *source_file,
-                                  GFile                *target_file)
+static void
+thunar_thumbnail_cache_queue_files (ThunarThumbnailCache *cache,
+                                    gboolean              copy_async,
+                                    GFile               **source_files,
+                                    GFile               **target_files,
+                                    guint                 n_files)
 {
+  ThunarThumbnailCacheQueue *queue;
+  gchar                    **source_uris;
+  gchar                    **target_uris;
+  guint                      n;
+
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
-  _thunar_return_if_fail (G_IS_FILE (source_file));
-  _thunar_return_if_fail (G_IS_FILE (target_file));
+
+  if (n_files == 0)
+    return;
+
+  /* determine the URIs before taking the lock */
+  source_uris = g_new (gchar *, n_files);
+  target_uris = g_new (gchar *, n_files);
+  for (n = 0; n < n_files; ++n)
+    {
+      source_uris[n] = g_file_get_uri (source_files[n]);
+      target_uris[n] = g_file_get_uri (target_files[n]);
+    }
 
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
   /* check if we have a valid proxy for the cache service */
+  queue = copy_async ? &cache->copy_queue : &cache->move_queue;
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the files to the move queue */
-      cache->move_source_queue = g_list_prepend (cache->move_source_queue,
-                                                 g_object_ref (source_file));
-      cache->move_target_queue = g_list_prepend (cache->move_target_queue,
-                                                 g_object_ref (target_file));
+      /* add the files to the queue, which takes over the URIs */
+      for (n = 0; n < n_files; ++n)
+        {
+          g_ptr_array_add (queue->source_uris, source_uris[n]);
+          g_ptr_array_add (queue->target_uris, target_uris[n]);
+          g_ptr_array_add (queue->target_files, g_object_ref (target_files[n]));
+        }
     }
-
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
+  else
     {
-      /* cancel any pending timeout to process the move queue */
-      if (cache->move_queue_idle_id > 0)
+      for (n = 0; n < n_files; ++n)
         {
-          g_source_remove (cache->move_queue_idle_id);
-          cache->move_queue_idle_id = 0;
+          g_free (source_uris[n]);
+          g_free (target_uris[n]);
         }
-
-      /* process the move queue in a 250ms timeout */
-      cache->move_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 250, thunar_thumbnail_cache_process_move_queue,
-                            cache, thunar_thumbnail_cache_process_move_queue_destroy);
     }
 
+  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
+    thunar_thumbnail_cache_schedule_queue (cache, copy_async);
+
   /* release the cache lock */
   _thumbnail_cache_unlock (cache);
+
+  g_free (source_uris);
+  g_free (target_uris);
 }
 
 
 
 void
-thunar_thumbnail_cache_copy_file (ThunarThumbnailCache *cache,
+thunar_thumbnail_cache_move_file (ThunarThumbnailCache *cache,
                                   GFile                *source_file,
                                   GFile                *target_file)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
   _thunar_return_if_fail (G_IS_FILE (source_file));
   _thunar_return_if_fail (G_IS_FILE (target_file));
 
-  /* acquire a cache lock */
-  _thumbnail_cache_lock (cache);
+  thunar_thumbnail_cache_queue_files (cache, FALSE, &source_file, &target_file, 1);
+}
 
-  /* check if we have a valid proxy for the cache service */
-  if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
-    {
-      /* add the files to the copy queues */
-      cache->copy_source_queue = g_list_prepend (cache->copy_source_queue,
-                                                 g_object_ref (source_file));
-      cache->copy_target_queue = g_list_prepend (cache->copy_target_queue,
-                                                 g_object_ref (target_file));
-    }
 
-  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
-    {
-      /* cancel any pending timeout to process the copy queue */
-      if (cache->copy_queue_idle_id > 0)
-        {
-          g_source_remove (cache->copy_queue_idle_id);
-          cache->copy_queue_idle_id = 0;
-        }
 
-      /* process the copy queue in a 250ms timeout */
-      cache->copy_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 500, thunar_thumbnail_cache_process_copy_queue,
-                            cache, thunar_thumbnail_cache_process_copy_queue_destroy);
-    }
+void
+thunar_thumbnail_cache_move_files (ThunarThumbnailCache *cache,
+                                   GFile               **source_files,
+                                   GFile               **target_files,
+                                   guint                 n_files)
+{
+  thunar_thumbnail_cache_queue_files (cache, FALSE, source_files, target_files, n_files);
+}
 
-  /* release the cache lock */
-  _thumbnail_cache_unlock (cache);
+
+
+void
+thunar_thumbnail_cache_copy_file (ThunarThumbnailCache *cache,
+                                  GFile                *source_file,
+                                  GFile                *target_file)
+{
+  _thunar_return_if_fail (G_IS_FILE (source_file));
+  _thunar_return_if_fail (G_IS_FILE (target_file));
+
+  thunar_thumbnail_cache_queue_files (cache, TRUE, &source_file, &target_file, 1);
+}
+
+
+
+void
+thunar_thumbnail_cache_copy_files (ThunarThumbnailCache *cache,
+                                   GFile               **source_files,
+                                   GFile               **target_files,
+                                   guint                 n_files)
+{
+  thunar_thumbnail_cache_queue_files (cache, TRUE, source_files, target_files, n_files);
 }
 
 
@@ -614,17 +658,35 @@ void
 thunar_thumbnail_cache_delete_file (ThunarThumbnailCache *cache,
                                     GFile                *file)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+  GList file_list = { file, NULL, NULL };
+
   _thunar_return_if_fail (G_IS_FILE (file));
 
+  thunar_thumbnail_cache_delete_files (cache, &file_list);
+}
+
+
+
+void
+thunar_thumbnail_cache_delete_files (ThunarThumbnailCache *cache,
+                                     GList                *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+
+  if (files == NULL)
+    return;
+
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
   /* check if we have a valid proxy for the cache service */
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the file to the delete queue */
-      cache->delete_queue = g_list_prepend (cache->delete_queue, g_object_ref (file));
+      /* add the files to the delete queue */
+      for (lp = files; lp != NULL; lp = lp->next)
+        cache->delete_queue = g_list_prepend (cache->delete_queue, g_object_ref (lp->data));
     }
 
   if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
@@ -651,17 +713,35 @@ void
 thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
                                      GFile                *file)
 {
-  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+  GList file_list = { file, NULL, NULL };
+
   _thunar_return_if_fail (G_IS_FILE (file));
 
+  thunar_thumbnail_cache_cleanup_files (cache, &file_list);
+}
+
+
+
+void
+thunar_thumbnail_cache_cleanup_files (ThunarThumbnailCache *cache,
+                                      GList                *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+
+  if (files == NULL)
+    return;
+
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
   /* check if we have a valid proxy for the cache service */
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the file to the cleanup queue */
-      cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (file));
+      /* add the files to the cleanup queue */
+      for (lp = files; lp != NULL; lp = lp->next)
+        cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (lp->data));
     }
 
   if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
@@ -709,17 +789,12 @@ thunar_thumbnail_cache_proxy_created (GObject      *source,
 
   g_clear_error (&error);
 
-  /* process the move queue in a 250ms timeout */
-  if (cache->move_source_queue)
-      cache->move_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 250, thunar_thumbnail_cache_process_move_queue,
-                            cache, thunar_thumbnail_cache_process_move_queue_destroy);
-
-  /* process the copy queue in a 250ms timeout */
-  if (cache->copy_source_queue)
-      cache->copy_queue_idle_id =
-        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 500, thunar_thumbnail_cache_process_copy_queue,
-                            cache, thunar_thumbnail_cache_process_copy_queue_destroy);
+  /* process the move and copy queues */
+  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
+    {
+      thunar_thumbnail_cache_schedule_queue (cache, FALSE);
+      thunar_thumbnail_cache_schedule_queue (cache, TRUE);
+    }
 
   /* process the delete queue in a 250ms timeout */
   if (cache->delete_queue)
@@ -745,6 +820,10 @@ thunar_thumbnail_cache_init (ThunarThumbnailCache *cache)
   /* create a new mutex for accessing the cache from different threads */
   g_mutex_init (&cache->lock);
 
+  /* prepare the move and copy queues */
+  thunar_thumbnail_cache_queue_init (&cache->move_queue);
+  thunar_thumbnail_cache_queue_init (&cache->copy_queue);
+
   /* add an additional reference to keep us alive while tre proxy initializes */
   g_object_ref (cache);
 
@@ -23,13 +23,19 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <libxfce4util/libxfce4util.h>
 
 #include <thunar/thunar-thumbnailer-proxy.h>
 #include <thunar/thunar-marshal.h>
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-stats.h>
 #include <thunar/thunar-thumbnailer.h>
+#include <thunar/thunar-trace.h>
 
 
 
@@ -59,6 +65,17 @@
  * the request and handle values in the job structure.
  *
  *
+ * Slices
+ * ======
+ *
+ * The files of a request are sent to tumbler in small slices, one at a
+ * time, in the order they were passed to thunar_thumbnailer_queue_files().
+ * The next slice is queued when the Finished signal of the previous one
+ * arrives. Callers pass the visible files first, so their thumbnails are
+ * not stuck behind the others, and a dequeued request only leaves the
+ * slice that was already sent to tumbler.
+ *
+ *
  * Ready / Error
  * =============
  *
@@ -66,6 +83,12 @@
  * the Ready idle function sets the thumb state of the corresponding
  * ThunarFile objects to _READY and the Error signal sets the state to _NONE.
  *
+ * Ready only carries URIs, the pixels always come from the PNG file tumbler
+ * wrote into the thumbnail folder: the org.freedesktop.thumbnails.Thumbnailer1
+ * interface has no method to hand out pixel buffers, so there is nothing like
+ * a memfd to receive them from. The PNG is decoded off the main thread by the
+ * icon factory, and the decoded thumbnail is kept in its cache.
+ *
  *
  * Finished
  * ========
@@ -77,6 +100,11 @@
 
 
 
+/* number of files sent to tumbler in a single Queue call */
+#define THUNAR_THUMBNAILER_SLICE_SIZE 16
+
+
+
 typedef enum
 {
   THUNAR_THUMBNAILER_IDLE_ERROR,
@@ -87,7 +115,8 @@ typedef enum
 
 typedef enum
 {
-  THUNAR_THUMBNAILER_PROXY_WAITING = 0,
+  THUNAR_THUMBNAILER_PROXY_NONE = 0,
+  THUNAR_THUMBNAILER_PROXY_WAITING,
   THUNAR_THUMBNAILER_PROXY_AVAILABLE,
   THUNAR_THUMBNAILER_PROXY_FAILED
 } ThunarThumbnailerProxyState;
@@ -174,6 +203,9 @@ struct _ThunarThumbnailer
   /* cached MIME types -> URI schemes for which thumbs can be generated */
   GHashTable *supported;
 
+  /* file name extensions -> the content types guessed from them */
+  GHashTable *extensions;
+
   /* last ThunarThumbnailer request ID */
   guint       last_request;
 
@@ -200,12 +232,19 @@ struct _ThunarThumbnailerJob
   /* If this is NULL, the request has been sent off. */
   GList             *files; /* element type: ThunarFile */
 
+  /* supported files waiting for the next slice, element type: ThunarFile */
+  GList             *pending;
+
   /* request number returned by ThunarThumbnailer */
   guint              request;
 
   /* handle returned by the tumbler dbus service */
   guint              handle;
 
+  /* monotonic time at which the current slice was queued and its size */
+  gint64             slice_time;
+  guint              slice_size;
+
   /* used to override the thumbnail size of ThunarThumbnailer */
   ThunarThumbnailSize thumbnail_size;
 };
@@ -339,6 +378,9 @@ thunar_thumbnailer_free_job (ThunarThumbnailerJob *job)
   if (job->files)
     g_list_free_full (job->files, g_object_unref);
 
+  if (job->pending)
+    g_list_free_full (job->pending, g_object_unref);
+
   if (job->thumbnailer && job->thumbnailer->thumbnailer_proxy && job->handle)
     thunar_thumbnailer_dbus_call_dequeue (job->thumbnailer->thumbnailer_proxy, job->handle, NULL, NULL, NULL);
 
@@ -403,24 +445,131 @@ thunar_thumbnailer_queue_async_reply (GObject      *proxy,
 
 
 
+/* NOTE: assumes that the lock is held by the caller */
+static const gchar *
+thunar_thumbnailer_file_get_content_type (ThunarThumbnailer *thumbnailer,
+                                          ThunarFile        *file)
+{
+  const gchar *content_type;
+  const gchar *basename;
+  const gchar *extension;
+  gboolean     uncertain;
+  gchar       *name;
+  gchar       *guess;
+
+  /* use the content type if the file was sniffed anyway */
+  content_type = thunar_file_peek_content_type (file);
+  if (content_type != NULL)
+    return content_type;
+
+  /* guess it from the extension otherwise, which needs no I/O */
+  basename = thunar_file_get_basename (file);
+  extension = strrchr (basename, '.');
+  if (extension != NULL && extension != basename && extension[1] != '\0')
+    {
+      if (!g_hash_table_lookup_extended (thumbnailer->extensions, extension, NULL, (gpointer *) &content_type))
+        {
+          name = g_strconcat ("x", extension, NULL);
+          guess = g_content_type_guess (name, NULL, 0, &uncertain);
+          content_type = uncertain ? NULL : g_intern_string (guess);
+          g_hash_table_insert (thumbnailer->extensions, g_strdup (extension), (gpointer) content_type);
+          g_free (guess);
+          g_free (name);
+        }
+
+      if (content_type != NULL)
+        return content_type;
+    }
+
+  /* only files without a known extension are sniffed */
+  return thunar_file_get_content_type (file);
+}
+
+
+
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_queue_slice (ThunarThumbnailer    *thumbnailer,
+                                ThunarThumbnailerJob *job)
+{
+  const gchar         **mime_hints;
+  gchar               **uris;
+  GList                *lp;
+  GList                *sent = NULL;
+  guint                 n;
+  ThunarThumbnailSize   thumbnail_size;
+
+  _thunar_return_if_fail (job->pending != NULL);
+
+  thumbnail_size = job->thumbnail_size == THUNAR_THUMBNAIL_SIZE_DEFAULT ? thumbnailer->thumbnail_size : job->thumbnail_size;
+
+  /* allocate arrays for URIs and mime hints */
+  uris = g_new0 (gchar *, THUNAR_THUMBNAILER_SLICE_SIZE + 1);
+  mime_hints = g_new0 (const gchar *, THUNAR_THUMBNAILER_SLICE_SIZE + 1);
+
+  /* fill URI and MIME hint arrays with the next pending files */
+  for (n = 0; job->pending != NULL && n < THUNAR_THUMBNAILER_SLICE_SIZE; ++n)
+    {
+      lp = job->pending;
+      job->pending = g_list_remove_link (job->pending, lp);
+
+      /* set the thumbnail state to loading */
+      thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_LOADING);
+
+      /* save URI and MIME hint in the arrays */
+      uris[n] = thunar_file_dup_uri (lp->data);
+      mime_hints[n] = thunar_thumbnailer_file_get_content_type (thumbnailer, lp->data);
+
+      sent = g_list_concat (lp, sent);
+    }
+
+  /* increase the reference count while the dbus call is running */
+  g_object_ref (thumbnailer);
+  job->slice_time = g_get_monotonic_time ();
+  job->slice_size = n;
+
+  /* queue the request - asynchronously, of course */
+  thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
+                                      (const gchar *const *)uris,
+                                      (const gchar *const *)mime_hints,
+                                      thunar_thumbnail_size_get_nick (thumbnail_size),
+                                      "foreground", 0,
+                                      NULL,
+                                      thunar_thumbnailer_queue_async_reply,
+                                      job);
+
+  /* free mime hints array */
+  g_free (mime_hints);
+  g_strfreev (uris);
+
+  /* the MIME hints belong to the files */
+  g_list_free_full (sent, g_object_unref);
+}
+
+
+
 /* NOTE: assumes that the lock is held by the caller */
 static gboolean
 thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
                               ThunarThumbnailerJob *job)
 {
   gboolean               success = FALSE;
-  const gchar          **mime_hints;
-  gchar                **uris;
   GList                 *lp;
   GList                 *supported_files = NULL;
-  guint                  n;
   guint                  n_items = 0;
   ThunarFileThumbState   thumb_state;
   const gchar           *thumbnail_path;
   gint                   request_no;
   ThunarThumbnailSize    thumbnail_size;
 
-  if (thumbnailer->proxy_state == THUNAR_THUMBNAILER_PROXY_WAITING)
+  if (thumbnailer->proxy_state == THUNAR_THUMBNAILER_PROXY_NONE)
+    {
+      /* the proxy is only created once the first thumbnail is requested, this
+       * keeps the activation of the thumbnail service out of the startup path */
+      thunar_thumbnailer_init_thumbnailer_proxy (thumbnailer);
+      return TRUE;
+    }
+  else if (thumbnailer->proxy_state == THUNAR_THUMBNAILER_PROXY_WAITING)
     {
       /* all pending jobs will be queued automatically once the proxy is available */
       return TRUE;
@@ -487,26 +636,6 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
   /* check if we have any supported files */
   if (n_items > 0)
     {
-      /* allocate arrays for URIs and mime hints */
-      uris = g_new0 (gchar *, n_items + 1);
-      mime_hints = g_new0 (const gchar *, n_items + 1);
-
-      /* fill URI and MIME hint arrays with items from the wait queue */
-      for (lp = supported_files, n = 0; lp != NULL; lp = lp->next, ++n)
-        {
-          /* set the thumbnail state to loading */
-          thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_LOADING);
-
-          /* save URI and MIME hint in the arrays */
-          uris[n] = thunar_file_dup_uri (lp->data);
-          mime_hints[n] = thunar_file_get_content_type (lp->data);
-        }
-
-      /* NULL-terminate both arrays */
-      uris[n] = NULL;
-      mime_hints[n] = NULL;
-
-      /* queue a thumbnail request for the URIs from the wait queue */
       /* compute the next request ID, making sure it's never 0 */
       request_no = thumbnailer->last_request + 1;
       request_no = MAX (request_no, 1);
@@ -517,30 +646,17 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
       /* save the request number */
       job->request = request_no;
 
-      /* increase the reference count while the dbus call is running */
-      g_object_ref (thumbnailer);
-
-      /* queue the request - asynchronously, of course */
-      thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
-                                          (const gchar *const *)uris,
-                                          (const gchar *const *)mime_hints,
-                                          thunar_thumbnail_size_get_nick (thumbnail_size),
-                                          "foreground", 0,
-                                          NULL,
-                                          thunar_thumbnailer_queue_async_reply,
-                                          job);
-
-      /* free mime hints array */
-      g_free (mime_hints);
-      g_strfreev (uris);
-
-      /* free the list of supported files */
-      g_list_free (supported_files);
+      /* keep the order of the caller, it sends the important files first */
+      job->pending = g_list_reverse (supported_files);
+      g_list_foreach (job->pending, (GFunc) (void (*)(void)) g_object_ref, NULL);
 
       /* free the list of files passed in */
       g_list_free_full (job->files, g_object_unref);
       job->files = NULL;
 
+      /* queue the first slice */
+      thunar_thumbnailer_queue_slice (thumbnailer, job);
+
       /* we assume success if we've come so far */
       success = TRUE;
     }
@@ -555,8 +671,8 @@ thunar_thumbnailer_init (ThunarThumbnailer *thumbnailer)
 {
   g_mutex_init (&thumbnailer->lock);
 
-  /* initialize the proxies */
-  thunar_thumbnailer_init_thumbnailer_proxy (thumbnailer);
+  /* the values are interned strings, or NULL if the type is uncertain */
+  thumbnailer->extensions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
   /* grab a reference on the preferences */
   thumbnailer->preferences = thunar_preferences_get ();
@@ -606,6 +722,7 @@ thunar_thumbnailer_finalize (GObject *object)
   /* free the cached URI schemes and MIME types table */
   if (thumbnailer->supported != NULL)
     g_hash_table_unref (thumbnailer->supported);
+  g_hash_table_unref (thumbnailer->extensions);
 
   /* release the thumbnailer lock */
   _thumbnailer_unlock (thumbnailer);
@@ -661,12 +778,13 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
                                              GAsyncResult           *result,
                                              ThunarThumbnailer      *thumbnailer)
 {
-  guint       n;
-  gchar     **schemes = NULL;
-  gchar     **types = NULL;
-  GPtrArray  *schemes_array;
-  GSList     *lp = NULL;
-  GError     *error = NULL;
+  guint                  n;
+  gchar                **schemes = NULL;
+  gchar                **types = NULL;
+  GPtrArray             *schemes_array;
+  GSList                *lp = NULL;
+  GError                *error = NULL;
+  ThunarThumbnailerJob  *job;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER_DBUS (proxy));
@@ -728,7 +846,8 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
   /* now start delayed jobs */
   for (lp = thumbnailer->jobs; lp; lp = lp->next)
     {
-      if (!thunar_thumbnailer_begin_job (thumbnailer, lp->data))
+      job = lp->data;
+      if (job->cancelled || !thunar_thumbnailer_begin_job (thumbnailer, job))
         {
           thunar_thumbnailer_free_job (lp->data);
           lp->data = NULL;
@@ -802,14 +921,16 @@ thunar_thumbnailer_proxy_created (GObject       *object,
 
 
 
+/* NOTE: assumes the lock is being held by the caller */
 static void
 thunar_thumbnailer_init_thumbnailer_proxy (ThunarThumbnailer *thumbnailer)
 {
-  _thumbnailer_lock (thumbnailer);
-
   thumbnailer->thumbnailer_proxy = NULL;
   thumbnailer->proxy_state = THUNAR_THUMBNAILER_PROXY_WAITING;
 
+  /* keep the thumbnailer alive until the proxy is set up */
+  g_object_ref (thumbnailer);
+
   /* create the thumbnailer proxy */
   thunar_thumbnailer_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
                                              G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES,
@@ -818,8 +939,6 @@ thunar_thumbnailer_init_thumbnailer_proxy (ThunarThumbnailer *thumbnailer)
                                              NULL,
                                              (GAsyncReadyCallback)thunar_thumbnailer_proxy_created,
                                              thumbnailer);
-
-  _thumbnailer_unlock (thumbnailer);
 }
 
 
@@ -841,7 +960,7 @@ thunar_thumbnailer_file_is_supported (ThunarThumbnailer *thumbnailer,
   _thunar_return_val_if_fail (thumbnailer->supported != NULL, FALSE);
 
   /* determine the content type of the passed file */
-  content_type = thunar_file_get_content_type (file);
+  content_type = thunar_thumbnailer_file_get_content_type (thumbnailer, file);
 
   /* abort if the content type is unknown */
   if (content_type == NULL)
@@ -928,8 +1047,17 @@ thunar_thumbnailer_thumbnailer_finished (GDBusProxy        *proxy,
 
       if (job->handle == handle)
         {
-          /* this job is finished, forget about the handle */
+          /* this slice is finished, forget about the handle */
           job->handle = 0;
+          thunar_stats_record_since (THUNAR_STATS_THUMBNAIL_LATENCY, job->slice_time);
+          THUNAR_TRACE_MARK (job->slice_time, "thumbnail-request", "%u files", job->slice_size);
+
+          /* continue with the next slice of the job */
+          if (job->pending != NULL)
+            {
+              thunar_thumbnailer_queue_slice (thumbnailer, job);
+              break;
+            }
 
           /* tell everybody we're done here */
           g_signal_emit (G_OBJECT (thumbnailer), thumbnailer_signals[REQUEST_FINISHED], 0, job->request);
@@ -1011,11 +1139,16 @@ thunar_thumbnailer_idle_func (gpointer user_data)
   ThunarThumbnailerIdle *idle = user_data;
   ThunarFile            *file;
   GFile                 *gfile;
+  gint64                 trace_begin;
+  gint64                 start_time;
   guint                  n;
 
   _thunar_return_val_if_fail (idle != NULL, FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (idle->thumbnailer), FALSE);
 
+  trace_begin = THUNAR_TRACE_BEGIN ();
+  start_time = g_get_monotonic_time ();
+
   /* iterate over all failed URIs */
   for (n = 0; idle->uris != NULL && idle->uris[n] != NULL; ++n)
     {
@@ -1052,6 +1185,9 @@ thunar_thumbnailer_idle_func (gpointer user_data)
   idle->thumbnailer->idles = g_slist_remove (idle->thumbnailer->idles, idle);
   _thumbnailer_unlock (idle->thumbnailer);
 
+  THUNAR_TRACE_IDLE (trace_begin, "thunar_thumbnailer_idle_func");
+  thunar_stats_record_callback ("thunar_thumbnailer_idle_func", start_time, n);
+
   /* remove the idle source, which also destroys the idle struct */
   return FALSE;
 }
@@ -1098,9 +1234,10 @@ thunar_thumbnailer_get (void)
     {
       thumbnailer = g_object_new (THUNAR_TYPE_THUMBNAILER, NULL);
       g_object_add_weak_pointer (G_OBJECT (thumbnailer), (gpointer) &thumbnailer);
+      return thumbnailer;
     }
 
-  return g_object_ref_sink (thumbnailer);
+  return g_object_ref (thumbnailer);
 }
 
 
@@ -0,0 +1,87 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_TRACE_H__
+#define __THUNAR_TRACE_H__
+
+#include <glib.h>
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* idle callbacks running longer than this (in microseconds, a quarter
+ * of a frame at 60Hz) are marked, shorter ones are not worth a mark */
+#define THUNAR_TRACE_IDLE_THRESHOLD (4000)
+
+/**
+ * THUNAR_TRACE_BEGIN:
+ *
+ * Returns the start time for a later THUNAR_TRACE_MARK(), in
+ * g_get_monotonic_time() units, or 0 if tracing is not compiled in.
+ **/
+
+/**
+ * THUNAR_TRACE_MARK:
+ * @begin : the start time returned by THUNAR_TRACE_BEGIN().
+ * @name  : the name of the mark.
+ * @...   : a printf-style format and its arguments, describing the workload.
+ *
+ * Emits a Sysprof mark from @begin until now. The arguments are not
+ * evaluated if tracing is not compiled in.
+ **/
+
+/**
+ * THUNAR_TRACE_IDLE:
+ * @begin : the start time returned by THUNAR_TRACE_BEGIN().
+ * @name  : the name of the idle or timeout callback.
+ *
+ * Emits a Sysprof mark for the callback @name if it ran for longer
+ * than %THUNAR_TRACE_IDLE_THRESHOLD.
+ **/
+#ifdef HAVE_SYSPROF
+#define THUNAR_TRACE_BEGIN() g_get_monotonic_time ()
+#define THUNAR_TRACE_MARK(begin, name, ...)                                                  \
+  sysprof_collector_mark_printf ((begin) * 1000, (g_get_monotonic_time () - (begin)) * 1000, \
+                                 "Thunar", (name), __VA_ARGS__)
+#define THUNAR_TRACE_IDLE(begin, name)                                       \
+  G_STMT_START {                                                             \
+    gint64 _thunar_trace_duration = g_get_monotonic_time () - (begin);       \
+    if (_thunar_trace_duration > THUNAR_TRACE_IDLE_THRESHOLD)                \
+      sysprof_collector_mark ((begin) * 1000, _thunar_trace_duration * 1000, \
+                              "Thunar", "idle", (name));                     \
+  } G_STMT_END
+#else
+#define THUNAR_TRACE_BEGIN()           G_GINT64_CONSTANT (0)
+#define THUNAR_TRACE_MARK(begin, name, ...)                  \
+  G_STMT_START {                                             \
+    /* never executed, but keeps the arguments referenced */ \
+    if (0)                                                   \
+      g_snprintf (NULL, 0, __VA_ARGS__);                     \
+    (void) (begin);                                          \
+  } G_STMT_END
+#define THUNAR_TRACE_IDLE(begin, name) G_STMT_START { (void) (begin); } G_STMT_END
+#endif
+
+G_END_DECLS
+
+#endif /* !__THUNAR_TRACE_H__ */
@@ -23,7 +23,30 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_RENAMEAT2
+#include <stdio.h> /* renameat2 */
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-gio-extensions.h>
@@ -34,6 +57,7 @@
 #include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-thumbnail-cache.h>
+#include <thunar/thunar-trace.h>
 #include <thunar/thunar-transfer-job.h>
 
 
@@ -41,6 +65,47 @@
 /* seconds before we show the transfer rate + remaining time */
 #define MINIMUM_TRANSFER_TIME (2 * G_USEC_PER_SEC) /* 2 seconds */
 
+/* number of files in a folder copied at the same time, if both
+ * locations are native or if one of them is remote */
+#define THUNAR_TRANSFER_JOB_POOL_THREADS_NATIVE 4
+#define THUNAR_TRANSFER_JOB_POOL_THREADS_REMOTE 8
+
+/* files up to this size are written in one go to remote targets, and
+ * their attributes are set after the whole folder was copied */
+#define THUNAR_TRANSFER_JOB_BATCH_FILE_SIZE     (64 * 1024)
+#define THUNAR_TRANSFER_JOB_BATCH_ATTRIBUTES    G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                                                G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+                                                G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
+                                                G_FILE_ATTRIBUTE_UNIX_MODE
+
+/* files renamed directly by a move between two progress updates */
+#define THUNAR_TRANSFER_JOB_BULK_MOVE_FILES     256
+
+/* attributes compared to settle a conflict with an existing target */
+#define THUNAR_TRANSFER_JOB_CONFLICT_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                                                G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                                                G_FILE_ATTRIBUTE_TIME_MODIFIED
+
+/* difference of modification times still considered identical, and the
+ * bytes compared at each of the samples of possibly identical files */
+#define THUNAR_TRANSFER_JOB_IDENTICAL_MTIME_SLACK 2
+#define THUNAR_TRANSFER_JOB_SAMPLE_SIZE           (64 * 1024)
+
+/* copied or removed files passed to the thumbnail cache at once */
+#define THUNAR_TRANSFER_JOB_THUMBNAIL_BATCH     512
+
+/* where the journals of running copies and moves are kept, below
+ * $XDG_STATE_HOME, so an interrupted transfer is resumed later */
+#define THUNAR_TRANSFER_JOB_JOURNAL_DIR         "Thunar/transfer-journals"
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
 
 
 /* Property identifiers */
@@ -56,6 +121,13 @@ enum
 
 
 typedef struct _ThunarTransferNode ThunarTransferNode;
+typedef struct _ThunarTransferPool ThunarTransferPool;
+
+
+
+/* the ticket of the file the current thread copies, so it can
+ * be suspended while the job is paused */
+static GPrivate ttj_copy_ticket;
 
 
 
@@ -73,6 +145,8 @@ static void     thunar_transfer_job_finalize     (GObject                *object
 static gboolean thunar_transfer_job_execute      (ExoJob                 *job,
                                                   GError                **error);
 static void     thunar_transfer_node_free        (gpointer                data);
+static gboolean thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
+                                                        GError            **error);
 
 
 
@@ -102,11 +176,54 @@ struct _ThunarTransferJob
   guint64                 file_progress;           /* byte */
   guint64                 transfer_rate;           /* byte/s */
 
+  /* the source tree of a copy is collected by another thread while
+   * the job thread copies, see thunar_transfer_job_collect_thread() */
+  gboolean                collect_async;
+  gint                    collect_stop;            /* atomic */
+  GThread                *collector;
+  GMutex                  collect_mutex;
+  GCond                   collect_cond;
+  gboolean                collect_done;
+  gboolean                collect_verified;
+  GError                 *collect_error;
+  guint64                 collected_size;          /* byte */
+  guint                   n_nodes_collected;
+  guint                   n_nodes_pending;
+
   ThunarPreferences      *preferences;
   gboolean                file_size_binary;
   ThunarParallelCopyMode  parallel_copy_mode;
   ThunarUsePartialMode    transfer_use_partial;
   ThunarVerifyFileMode    transfer_verify_file;
+  GChecksumType           transfer_verify_checksum;
+  gboolean                transfer_resume_partial;
+  guint                   transfer_parallel_streams;
+  ThunarTransferConflictPolicy conflict_policy;
+
+  /* thumbnail cache updates of the copied and removed files, which
+   * are passed on in batches, see thunar_transfer_job_thumbnail_copy() */
+  ThunarThumbnailCache   *thumbnail_cache;
+  GPtrArray              *thumbnail_sources;
+  GPtrArray              *thumbnail_targets;
+  GList                  *thumbnail_deleted;
+  guint                   n_thumbnail_deleted;
+
+  /* shares the devices with the other jobs */
+  ThunarIoScheduler      *io_scheduler;
+  GThread                *job_thread;
+
+  /* names of the target folders, for picking free copy names */
+  GHashTable             *names_by_dir;
+
+  /* copies whose target already exists, the user is asked about them
+   * once everything else was copied, see thunar_transfer_job_copy_file() */
+  gboolean                defer_conflicts;
+  GQueue                  conflicts;
+
+  /* the journal of the transfer, removed once the job is done, see
+   * thunar_transfer_job_new_from_journals() */
+  gchar                  *journal;
+  gboolean                journal_resumed;
 };
 
 struct _ThunarTransferNode
@@ -114,10 +231,49 @@ struct _ThunarTransferNode
   ThunarTransferNode *next;
   ThunarTransferNode *children;
   GFile              *source_file;
+  GFileType           file_type;      /* set by thunar_transfer_job_collect_node() */
+  gboolean            collected;      /* file_type and children are known */
+  GFile              *pooled_target;  /* set if the file was copied by the pool */
+  GFileInfo          *deferred_info;  /* attributes still to set on pooled_target */
   gboolean            replace_confirmed;
   gboolean            rename_confirmed;
 };
 
+/* files of a folder which are copied by several threads at once */
+struct _ThunarTransferPool
+{
+  ThunarTransferJob  *job;
+  GFile              *target_parent_file;
+  gboolean            batch_small_files;
+
+  GMutex              mutex;
+  GCond               cond;
+  GCond               queue_cond;
+  GQueue              nodes;      /* the nodes waiting for a thread */
+  gboolean            queuing;    /* more nodes are still to come */
+  guint               n_running;  /* number of threads still copying */
+  guint64             progress;   /* bytes copied, not yet added to the job */
+};
+
+/* a node deferred because its target exists, the nodes above it keep
+ * their children until the conflicts are resolved */
+typedef struct
+{
+  ThunarTransferNode *node;
+  GFile              *target_file;
+  GList             **target_file_list_return;
+}
+ThunarTransferConflict;
+
+/* the progress of a file copied by a pool thread */
+typedef struct
+{
+  ThunarTransferPool *pool;
+  guint64             file_progress;
+  gboolean            created;    /* whether the target was written by this copy */
+}
+ThunarTransferPoolCopy;
+
 
 
 G_DEFINE_TYPE (ThunarTransferJob, thunar_transfer_job, THUNAR_TYPE_JOB)
@@ -127,16 +283,16 @@ G_DEFINE_TYPE (ThunarTransferJob, thunar_transfer_job, THUNAR_TYPE_JOB)
 static void
 thunar_transfer_job_class_init (ThunarTransferJobClass *klass)
 {
-  GObjectClass *gobject_class;
-  ExoJobClass  *exojob_class;
+  GObjectClass   *gobject_class;
+  ThunarJobClass *thunarjob_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_transfer_job_finalize;
   gobject_class->get_property = thunar_transfer_job_get_property;
   gobject_class->set_property = thunar_transfer_job_set_property;
 
-  exojob_class = EXO_JOB_CLASS (klass);
-  exojob_class->execute = thunar_transfer_job_execute;
+  thunarjob_class = THUNAR_JOB_CLASS (klass);
+  thunarjob_class->execute = thunar_transfer_job_execute;
 
   /**
    * ThunarPropertiesDialog:file_size_binary:
@@ -200,6 +356,8 @@ thunar_transfer_job_class_init (ThunarTransferJobClass *klass)
 static void
 thunar_transfer_job_init (ThunarTransferJob *job)
 {
+  gboolean fast_checksum;
+
   job->preferences = thunar_preferences_get ();
   g_object_bind_property (job->preferences, "misc-file-size-binary",
                           job,              "file-size-binary",
@@ -214,6 +372,17 @@ thunar_transfer_job_init (ThunarTransferJob *job)
                           job,              "transfer-verify-file",
                           G_BINDING_SYNC_CREATE);
 
+  /* the checksum type is read once, so every file of the job uses the same */
+  g_object_get (job->preferences, "misc-transfer-verify-fast-checksum", &fast_checksum, NULL);
+  job->transfer_verify_checksum = fast_checksum ? G_CHECKSUM_MD5 : G_CHECKSUM_SHA512;
+  g_object_get (job->preferences, "misc-transfer-resume-partial", &job->transfer_resume_partial, NULL);
+  g_object_get (job->preferences, "misc-transfer-parallel-streams", &job->transfer_parallel_streams, NULL);
+  g_object_get (job->preferences, "misc-transfer-conflict-policy", &job->conflict_policy, NULL);
+
+  /* copying gigabytes should not make browsing the disk sluggish */
+  thunar_job_set_priority (THUNAR_JOB (job), THUNAR_JOB_PRIORITY_BACKGROUND);
+  thunar_job_set_pool (THUNAR_JOB (job), THUNAR_JOB_POOL_BULK);
+
   job->type = 0;
   job->source_node_list = NULL;
   job->source_device_fs_id = NULL;
@@ -228,6 +397,31 @@ thunar_transfer_job_init (ThunarTransferJob *job)
   job->last_total_progress = 0;
   job->transfer_rate = 0;
   job->start_time = 0;
+
+  job->thumbnail_sources = g_ptr_array_new_with_free_func (g_object_unref);
+  job->thumbnail_targets = g_ptr_array_new_with_free_func (g_object_unref);
+
+  job->names_by_dir = thunar_io_jobs_util_names_new ();
+
+  job->defer_conflicts = FALSE;
+  g_queue_init (&job->conflicts);
+
+  job->journal = NULL;
+  job->journal_resumed = FALSE;
+
+  g_mutex_init (&job->collect_mutex);
+  g_cond_init (&job->collect_cond);
+}
+
+
+
+static void
+thunar_transfer_conflict_free (gpointer data)
+{
+  ThunarTransferConflict *conflict = data;
+
+  g_object_unref (conflict->target_file);
+  g_slice_free (ThunarTransferConflict, conflict);
 }
 
 
@@ -246,6 +440,28 @@ thunar_transfer_job_finalize (GObject *object)
 
   g_object_unref (job->preferences);
 
+  g_clear_object (&job->io_scheduler);
+
+  g_clear_object (&job->thumbnail_cache);
+  g_ptr_array_unref (job->thumbnail_sources);
+  g_ptr_array_unref (job->thumbnail_targets);
+  g_list_free_full (job->thumbnail_deleted, g_object_unref);
+
+  g_hash_table_unref (job->names_by_dir);
+
+  g_queue_clear_full (&job->conflicts, thunar_transfer_conflict_free);
+
+  /* the transfer was completed, failed or cancelled by the user */
+  if (job->journal != NULL)
+    {
+      g_unlink (job->journal);
+      g_free (job->journal);
+    }
+
+  g_clear_error (&job->collect_error);
+  g_cond_clear (&job->collect_cond);
+  g_mutex_clear (&job->collect_mutex);
+
   (*G_OBJECT_CLASS (thunar_transfer_job_parent_class)->finalize) (object);
 }
 
@@ -314,51 +530,69 @@ thunar_transfer_job_set_property (GObject      *object,
 static void
 thunar_transfer_job_check_pause (ThunarTransferJob *job)
 {
+  ThunarIoTicket *ticket;
+
   _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+
+  if (!thunar_job_is_paused (THUNAR_JOB (job)))
+    return;
+
+  /* let the other jobs use the devices meanwhile */
+  ticket = g_private_get (&ttj_copy_ticket);
+  if (ticket != NULL)
+    thunar_io_ticket_suspend (ticket);
+
   while (thunar_job_is_paused (THUNAR_JOB (job)) && !exo_job_is_cancelled (EXO_JOB (job)))
     {
       g_usleep (500 * 1000); /* 500ms pause */
     }
+
+  if (ticket != NULL)
+    thunar_io_ticket_resume (ticket, exo_job_get_cancellable (EXO_JOB (job)));
 }
 
 
 
+/* updates the total size while the source tree is still being collected,
+ * the average size of the collected files is assumed for the pending ones.
+ * Must be called with the collect_mutex held */
 static void
-thunar_transfer_job_progress (goffset  current_num_bytes,
-                              goffset  total_num_bytes,
-                              gpointer user_data)
+thunar_transfer_job_estimate_total_size (ThunarTransferJob *job)
 {
-  ThunarTransferJob *job = user_data;
-  guint64            new_percentage;
-  gint64             current_time;
-  gint64             expired_time;
-  guint64            transfer_rate;
+  guint64 estimate = job->collected_size;
 
-  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+  if (!job->collect_done && job->n_nodes_collected > 0)
+    estimate += job->collected_size / job->n_nodes_collected * job->n_nodes_pending;
 
-  thunar_transfer_job_check_pause (job);
+  job->total_size = MAX (estimate, job->total_progress);
+}
 
-  if (G_LIKELY (job->total_size > 0))
-    {
-      /* update total progress */
-      job->total_progress += (current_num_bytes - job->file_progress);
 
-      /* update file progress */
-      job->file_progress = current_num_bytes;
 
-      /* compute the new percentage after the progress we've made */
-      new_percentage = (job->total_progress * 100.0) / job->total_size;
+static void
+thunar_transfer_job_emit_progress (ThunarTransferJob *job,
+                                   gboolean           force)
+{
+  gint64  current_time;
+  gint64  expired_time;
+  guint64 transfer_rate;
+
+  /* get current time */
+  current_time = g_get_real_time ();
+  expired_time = current_time - job->last_update_time;
 
-      /* get current time */
-      current_time = g_get_real_time ();
-      expired_time = current_time - job->last_update_time;
+  /* update the rate and the estimate not more then every 500ms, the
+   * published percentage is sampled by the main loop on its own pace */
+  if (expired_time > (500 * 1000) || force)
+    {
+      if (job->collect_async)
+        {
+          g_mutex_lock (&job->collect_mutex);
+          thunar_transfer_job_estimate_total_size (job);
+          g_mutex_unlock (&job->collect_mutex);
+        }
 
-      /* notify callers not more then every 500ms */
-      /* force update after transfer when it took more than (approx.) 500ms */
-      /* the actual code checks if (file size [byte]) > (transfer rate [byte/s]) * (0.5 [s]) */
-      /* which means that the file is bigger than what is transferred in 500ms on average */
-      if (expired_time > (500 * 1000)
-          || (current_num_bytes == total_num_bytes && total_num_bytes > (goffset) (job->transfer_rate / 2)))
+      if (G_LIKELY (job->total_size > 0))
         {
           /* calculate the transfer rate in the last expired time */
           transfer_rate = (job->total_progress - job->last_total_progress) / ((gfloat) expired_time / G_USEC_PER_SEC);
@@ -369,14 +603,43 @@ thunar_transfer_job_progress (goffset  current_num_bytes,
           else
             job->transfer_rate = transfer_rate;
 
-          /* emit the percent signal */
-          exo_job_percent (EXO_JOB (job), new_percentage);
-
           /* update internals */
           job->last_update_time = current_time;
           job->last_total_progress = job->total_progress;
         }
     }
+
+  if (G_LIKELY (job->total_size > 0))
+    thunar_job_set_percent (THUNAR_JOB (job), (job->total_progress * 100.0) / job->total_size);
+}
+
+
+
+static void
+thunar_transfer_job_progress (goffset  current_num_bytes,
+                              goffset  total_num_bytes,
+                              gpointer user_data)
+{
+  ThunarTransferJob *job = user_data;
+
+  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+
+  thunar_transfer_job_check_pause (job);
+
+  if (G_LIKELY (job->total_size > 0))
+    {
+      /* update total progress */
+      job->total_progress += (current_num_bytes - job->file_progress);
+
+      /* update file progress */
+      job->file_progress = current_num_bytes;
+
+      /* force update after transfer when it took more than (approx.) 500ms */
+      /* the actual code checks if (file size [byte]) > (transfer rate [byte/s]) * (0.5 [s]) */
+      /* which means that the file is bigger than what is transferred in 500ms on average */
+      thunar_transfer_job_emit_progress (job, current_num_bytes == total_num_bytes
+                                              && total_num_bytes > (goffset) (job->transfer_rate / 2));
+    }
 }
 
 
@@ -387,7 +650,11 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
                                   GError            **error)
 {
   ThunarTransferNode *child_node;
+  ThunarTransferNode *children = NULL;
   GFileInfo          *info;
+  GFileType           file_type;
+  guint64             size;
+  guint               n_children = 0;
   GError             *err = NULL;
   GList              *file_list;
   GList              *lp;
@@ -399,6 +666,13 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
+  /* the copy ended before the collection */
+  if (job->collect_async && g_atomic_int_get (&job->collect_stop))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CANCELLED, _("Operation was cancelled"));
+      return FALSE;
+    }
+
   info = g_file_query_info (node->source_file,
                             G_FILE_ATTRIBUTE_STANDARD_SIZE ","
                             G_FILE_ATTRIBUTE_STANDARD_TYPE,
@@ -407,43 +681,75 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
                             &err);
 
   if (G_UNLIKELY (info == NULL))
-    return FALSE;
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
 
-  job->total_size += g_file_info_get_size (info);
+  size = g_file_info_get_size (info);
+  file_type = g_file_info_get_file_type (info);
+
+  /* release file info */
+  g_object_unref (info);
 
   /* check if we have a directory here */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+  if (file_type == G_FILE_TYPE_DIRECTORY)
     {
       /* scan the directory for immediate children */
       file_list = thunar_io_scan_directory (THUNAR_JOB (job), node->source_file,
                                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                             FALSE, FALSE, FALSE, NULL, &err);
-
-      /* add children to the transfer node */
-      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+      if (G_UNLIKELY (err != NULL))
         {
-          thunar_transfer_job_check_pause (job);
+          g_propagate_error (error, err);
+          return FALSE;
+        }
 
-          /* allocate a new transfer node for the child */
+      /* allocate the transfer nodes for the children */
+      for (lp = file_list; lp != NULL; lp = lp->next, ++n_children)
+        {
           child_node = g_slice_new0 (ThunarTransferNode);
           child_node->source_file = g_object_ref (lp->data);
           child_node->replace_confirmed = node->replace_confirmed;
           child_node->rename_confirmed = FALSE;
 
           /* hook the child node into the child list */
-          child_node->next = node->children;
-          node->children = child_node;
-
-          /* collect the child node */
-          thunar_transfer_job_collect_node (job, child_node, &err);
+          child_node->next = children;
+          children = child_node;
         }
 
       /* release the child files */
       thunar_g_list_free_full (file_list);
     }
 
-  /* release file info */
-  g_object_unref (info);
+  /* hand the node over to the job thread, which may copy it from now on */
+  if (job->collect_async)
+    {
+      g_mutex_lock (&job->collect_mutex);
+      job->collected_size += size;
+      job->n_nodes_collected++;
+      job->n_nodes_pending += n_children;
+      job->n_nodes_pending--;
+    }
+  else
+    job->total_size += size;
+
+  node->file_type = file_type;
+  node->children = children;
+  node->collected = TRUE;
+
+  if (job->collect_async)
+    {
+      g_cond_broadcast (&job->collect_cond);
+      g_mutex_unlock (&job->collect_mutex);
+    }
+
+  /* collect the child nodes */
+  for (child_node = children; err == NULL && child_node != NULL; child_node = child_node->next)
+    {
+      thunar_transfer_job_check_pause (job);
+      thunar_transfer_job_collect_node (job, child_node, &err);
+    }
 
   if (G_UNLIKELY (err != NULL))
     {
@@ -456,31 +762,136 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
 
 
 
+static gpointer
+thunar_transfer_job_collect_thread (gpointer data)
+{
+  ThunarTransferJob *job = data;
+  GError            *err = NULL;
+  GList             *lp;
+
+  for (lp = job->source_node_list; err == NULL && lp != NULL; lp = lp->next)
+    thunar_transfer_job_collect_node (job, lp->data, &err);
+
+  g_mutex_lock (&job->collect_mutex);
+  job->collect_error = err;
+  job->collect_done = TRUE;
+  g_cond_broadcast (&job->collect_cond);
+  g_mutex_unlock (&job->collect_mutex);
+
+  return NULL;
+}
+
+
+
+static gboolean
+thunar_transfer_job_collect_done (ThunarTransferJob *job)
+{
+  gboolean done;
+
+  g_mutex_lock (&job->collect_mutex);
+  done = job->collect_done;
+  g_mutex_unlock (&job->collect_mutex);
+
+  return done;
+}
+
+
+
+/**
+ * thunar_transfer_job_wait_collected:
+ * @job   : a #ThunarTransferJob.
+ * @node  : the node about to be copied.
+ * @error : return location for errors or %NULL.
+ *
+ * Waits until the collector thread knows the type and the children of
+ * @node, which is usually the case already since the collector walks the
+ * tree in the same order as the copy. Once the whole tree is collected,
+ * the free space on the destination is checked for the rest of the copy.
+ *
+ * Return value: %FALSE if @node could not be collected or the job was
+ *               cancelled, %TRUE otherwise.
+ **/
 static gboolean
-ttj_copy_file (ThunarTransferJob  *job,
-               ThunarJobOperation *operation,
-               GFile              *source_file,
-               GFile              *target_file,
-               GFileCopyFlags      copy_flags,
-               GError            **error)
+thunar_transfer_job_wait_collected (ThunarTransferJob  *job,
+                                    ThunarTransferNode *node,
+                                    GError            **error)
 {
-  GFileInfo *info;
-  GFileType  source_type;
-  GFileType  target_type;
-  gboolean   target_exists;
-  gboolean   use_partial;
-  gboolean   verify_file;
-  gboolean   add_to_operation = TRUE;
-  GError    *err = NULL;
+  gboolean collected;
+  gboolean verify = FALSE;
+  GError  *err = NULL;
+
+  if (!job->collect_async)
+    return TRUE;
+
+  g_mutex_lock (&job->collect_mutex);
+  while (!node->collected && !job->collect_done)
+    g_cond_wait (&job->collect_cond, &job->collect_mutex);
+
+  collected = node->collected;
+  if (!collected && job->collect_error != NULL)
+    err = g_error_copy (job->collect_error);
+
+  if (job->collect_done && !job->collect_verified)
+    job->collect_verified = verify = TRUE;
+
+  thunar_transfer_job_estimate_total_size (job);
+  g_mutex_unlock (&job->collect_mutex);
+
+  if (!collected)
+    {
+      if (err == NULL)
+        return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  if (verify && !thunar_transfer_job_verify_destination (job, &err))
+    {
+      /* the user does not want to go on without enough space */
+      if (err == NULL)
+        {
+          exo_job_cancel (EXO_JOB (job));
+          return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+        }
+
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+ttj_copy_file (ThunarTransferJob     *job,
+               ThunarJobOperation    *operation,
+               GFile                 *source_file,
+               GFile                 *target_file,
+               GFileCopyFlags         copy_flags,
+               GFileProgressCallback  progress_callback,
+               gpointer               progress_data,
+               GError               **error)
+{
+  GFileInfo      *info;
+  GFileType       source_type;
+  GFileType       target_type;
+  gboolean        target_exists;
+  gboolean        use_partial;
+  gboolean        verify_file;
+  gboolean        add_to_operation = TRUE;
+  GChecksum      *checksum = NULL;
+  gchar          *target_checksum;
+  gchar          *display_name;
+  ThunarIoTicket *ticket;
+  GError         *err = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  /* reset the file progress */
-  job->file_progress = 0;
-
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
   thunar_transfer_job_check_pause (job);
@@ -522,11 +933,6 @@ ttj_copy_file (ThunarTransferJob  *job,
       use_partial = FALSE;
     }
 
-  /* try to copy the file */
-  thunar_g_file_copy (source_file, target_file, copy_flags, use_partial,
-                      exo_job_get_cancellable (EXO_JOB (job)),
-                      thunar_transfer_job_progress, job, &err);
-
   switch (job->transfer_verify_file)
     {
     case THUNAR_VERIFY_FILE_MODE_REMOTE_ONLY:
@@ -539,25 +945,61 @@ ttj_copy_file (ThunarTransferJob  *job,
       verify_file = FALSE;
     }
 
-  /* Only verify when the file is a regular file */
-  verify_file = verify_file && (g_file_query_file_type (source_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, exo_job_get_cancellable (EXO_JOB (job))) == G_FILE_TYPE_REGULAR);
+  /* Only verify when the file is a regular file, its data is hashed while copying */
+  if (verify_file && source_type == G_FILE_TYPE_REGULAR)
+    checksum = g_checksum_new (job->transfer_verify_checksum);
 
-  if (verify_file && err == NULL)
+  /* wait for the other jobs using the same devices, the job thread tells the user */
+  ticket = thunar_io_scheduler_acquire (job->io_scheduler, source_file, target_file, FALSE,
+                                        exo_job_get_cancellable (EXO_JOB (job)));
+  if (ticket == NULL)
     {
-      gboolean is_equal;
+      if (g_thread_self () == job->job_thread)
+        exo_job_info_message (EXO_JOB (job), _("Waiting for other operations on the same device..."));
+
+      ticket = thunar_io_scheduler_acquire (job->io_scheduler, source_file, target_file, TRUE,
+                                            exo_job_get_cancellable (EXO_JOB (job)));
+
+      if (g_thread_self () == job->job_thread)
+        {
+          display_name = thunar_g_file_get_display_name (source_file);
+          exo_job_info_message (EXO_JOB (job), "%s", display_name);
+          g_free (display_name);
+        }
+    }
+  g_private_set (&ttj_copy_ticket, ticket);
+
+  /* try to copy the file */
+  thunar_g_file_copy (source_file, target_file, copy_flags, use_partial,
+                      use_partial && job->transfer_resume_partial,
+                      job->transfer_parallel_streams, checksum,
+                      exo_job_get_cancellable (EXO_JOB (job)),
+                      progress_callback, progress_data, &err);
+
+  if (checksum != NULL && err == NULL)
+    {
+      /* only the copy needs to be read again, from the disk rather than from memory */
       exo_job_info_message (EXO_JOB (job), _("Comparing checksums..."));
-      is_equal = thunar_g_file_compare_checksum (source_file, target_file,
-                                                 exo_job_get_cancellable (EXO_JOB (job)), &err);
+      target_checksum = thunar_g_file_create_checksum (target_file, job->transfer_verify_checksum, TRUE,
+                                                       exo_job_get_cancellable (EXO_JOB (job)), &err);
 
       /* if the copied file is corrupted and yet no error*/
-      if (!is_equal && err == NULL)
+      if (err == NULL && g_strcmp0 (target_checksum, g_checksum_get_string (checksum)) != 0)
         {
           err = g_error_new (G_FILE_ERROR,
                              G_FILE_ERROR_AGAIN,
                              "Copied file does not match with the original");
         }
+
+      g_free (target_checksum);
     }
 
+  if (checksum != NULL)
+    g_checksum_free (checksum);
+
+  g_private_set (&ttj_copy_ticket, NULL);
+  thunar_io_ticket_release (ticket);
+
   /**
    * MR !127 notes:
    * (Discussion: https://gitlab.xfce.org/xfce/thunar/-/merge_requests/127)
@@ -657,7 +1099,7 @@ ttj_copy_file (ThunarTransferJob  *job,
     }
   else
     {
-      if (add_to_operation && thunar_job_get_log_mode (THUNAR_JOB (job)) == THUNAR_OPERATION_LOG_OPERATIONS)
+      if (add_to_operation && operation != NULL && thunar_job_get_log_mode (THUNAR_JOB (job)) == THUNAR_OPERATION_LOG_OPERATIONS)
         {
           if (copy_flags & G_FILE_COPY_OVERWRITE)
             thunar_job_operation_overwrite (operation, target_file);
@@ -670,6 +1112,241 @@ ttj_copy_file (ThunarTransferJob  *job,
 
 
 
+/* whether a copy from @source_file to @target_file is verified */
+static gboolean
+thunar_transfer_job_verifies (ThunarTransferJob *job,
+                              GFile             *source_file,
+                              GFile             *target_file)
+{
+  switch (job->transfer_verify_file)
+    {
+    case THUNAR_VERIFY_FILE_MODE_REMOTE_ONLY:
+      return !g_file_is_native (source_file) || !g_file_is_native (target_file);
+    case THUNAR_VERIFY_FILE_MODE_ALWAYS:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+
+
+/* whether the contents of @source_file and @target_file, both of @size
+ * bytes, are the same at the start, in the middle and at the end */
+static gboolean
+thunar_transfer_job_same_samples (ThunarTransferJob *job,
+                                  GFile             *source_file,
+                                  GFile             *target_file,
+                                  guint64            size)
+{
+  GCancellable     *cancellable = exo_job_get_cancellable (EXO_JOB (job));
+  GFileInputStream *source_stream;
+  GFileInputStream *target_stream = NULL;
+  guint64           offsets[3];
+  gsize             length;
+  gsize             source_read;
+  gsize             target_read;
+  gchar            *source_buffer;
+  gchar            *target_buffer;
+  gboolean          same = FALSE;
+  guint             n;
+
+  length = MIN (size, THUNAR_TRANSFER_JOB_SAMPLE_SIZE);
+  offsets[0] = 0;
+  offsets[1] = (size - length) / 2;
+  offsets[2] = size - length;
+
+  source_stream = g_file_read (source_file, cancellable, NULL);
+  if (source_stream != NULL)
+    target_stream = g_file_read (target_file, cancellable, NULL);
+  if (target_stream == NULL)
+    {
+      g_clear_object (&source_stream);
+      return FALSE;
+    }
+
+  source_buffer = g_malloc (length);
+  target_buffer = g_malloc (length);
+
+  for (n = 0; n < G_N_ELEMENTS (offsets); ++n)
+    {
+      same = g_seekable_seek (G_SEEKABLE (source_stream), offsets[n], G_SEEK_SET, cancellable, NULL)
+             && g_seekable_seek (G_SEEKABLE (target_stream), offsets[n], G_SEEK_SET, cancellable, NULL)
+             && g_input_stream_read_all (G_INPUT_STREAM (source_stream), source_buffer, length, &source_read, cancellable, NULL)
+             && g_input_stream_read_all (G_INPUT_STREAM (target_stream), target_buffer, length, &target_read, cancellable, NULL)
+             && source_read == length
+             && target_read == length
+             && memcmp (source_buffer, target_buffer, length) == 0;
+      if (!same)
+        break;
+    }
+
+  g_free (source_buffer);
+  g_free (target_buffer);
+  g_object_unref (source_stream);
+  g_object_unref (target_stream);
+
+  return same;
+}
+
+
+
+/* whether @target_info, the existing target of @source_file, describes a
+ * previous copy of the file */
+static gboolean
+thunar_transfer_job_is_identical (ThunarTransferJob *job,
+                                  GFile             *source_file,
+                                  GFileType          source_type,
+                                  GFileInfo         *source_info,
+                                  GFile             *target_file,
+                                  GFileInfo         *target_info)
+{
+  guint64 source_mtime;
+  guint64 target_mtime;
+  goffset size;
+
+  if (source_type != G_FILE_TYPE_REGULAR || g_file_info_get_file_type (target_info) != G_FILE_TYPE_REGULAR)
+    return FALSE;
+
+  size = g_file_info_get_size (source_info);
+  if (size != g_file_info_get_size (target_info))
+    return FALSE;
+
+  /* copies keep the modification time, FAT only stores it in steps of two seconds */
+  source_mtime = g_file_info_get_attribute_uint64 (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  target_mtime = g_file_info_get_attribute_uint64 (target_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  if (MAX (source_mtime, target_mtime) - MIN (source_mtime, target_mtime) > THUNAR_TRANSFER_JOB_IDENTICAL_MTIME_SLACK)
+    return FALSE;
+
+  /* if copies are verified, look at the contents too */
+  if (size > 0 && thunar_transfer_job_verifies (job, source_file, target_file))
+    return thunar_transfer_job_same_samples (job, source_file, target_file, size);
+
+  return TRUE;
+}
+
+
+
+/* the response of the conflict policy for copying @source_file of @source_type,
+ * described by @source_info, to the existing @target_file, or 0 to ask */
+static ThunarJobResponse
+thunar_transfer_job_conflict_response (ThunarTransferJob *job,
+                                       GFile             *source_file,
+                                       GFileType          source_type,
+                                       GFileInfo         *source_info,
+                                       GFile             *target_file,
+                                       GFileInfo         *target_info)
+{
+  if (job->conflict_policy == THUNAR_TRANSFER_CONFLICT_POLICY_ASK || job->type != THUNAR_TRANSFER_JOB_COPY)
+    return 0;
+
+  /* existing folders are merged */
+  if (source_type == G_FILE_TYPE_DIRECTORY && g_file_info_get_file_type (target_info) == G_FILE_TYPE_DIRECTORY)
+    return THUNAR_JOB_RESPONSE_REPLACE;
+
+  switch (job->conflict_policy)
+    {
+    case THUNAR_TRANSFER_CONFLICT_POLICY_SKIP:
+      return THUNAR_JOB_RESPONSE_SKIP;
+
+    case THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE:
+      return THUNAR_JOB_RESPONSE_REPLACE;
+
+    case THUNAR_TRANSFER_CONFLICT_POLICY_RENAME:
+      return THUNAR_JOB_RESPONSE_RENAME;
+
+    case THUNAR_TRANSFER_CONFLICT_POLICY_REPLACE_IF_NEWER:
+      if (g_file_info_get_attribute_uint64 (source_info, G_FILE_ATTRIBUTE_TIME_MODIFIED)
+          > g_file_info_get_attribute_uint64 (target_info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+        return THUNAR_JOB_RESPONSE_REPLACE;
+      return THUNAR_JOB_RESPONSE_SKIP;
+
+    case THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL:
+      if (thunar_transfer_job_is_identical (job, source_file, source_type, source_info, target_file, target_info))
+        return THUNAR_JOB_RESPONSE_SKIP;
+      return 0;
+
+    default:
+      return 0;
+    }
+}
+
+
+
+/* the conflict policy for @source_file and @target_file, which was found to
+ * exist, or 0 to ask */
+static ThunarJobResponse
+thunar_transfer_job_conflict_response_for_files (ThunarTransferJob *job,
+                                                 GFile             *source_file,
+                                                 GFile             *target_file)
+{
+  ThunarJobResponse response = 0;
+  GFileInfo        *source_info;
+  GFileInfo        *target_info;
+
+  if (job->conflict_policy == THUNAR_TRANSFER_CONFLICT_POLICY_ASK || job->type != THUNAR_TRANSFER_JOB_COPY)
+    return 0;
+
+  source_info = g_file_query_info (source_file, THUNAR_TRANSFER_JOB_CONFLICT_ATTRIBUTES,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  target_info = g_file_query_info (target_file, THUNAR_TRANSFER_JOB_CONFLICT_ATTRIBUTES,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, exo_job_get_cancellable (EXO_JOB (job)), NULL);
+
+  if (source_info != NULL && target_info != NULL)
+    response = thunar_transfer_job_conflict_response (job, source_file, g_file_info_get_file_type (source_info), source_info,
+                                                      target_file, target_info);
+
+  g_clear_object (&source_info);
+  g_clear_object (&target_info);
+
+  return response;
+}
+
+
+
+/**
+ * thunar_transfer_job_plan_folder:
+ * @job                : a #ThunarTransferJob.
+ * @target_parent_file : the folder the files are copied to.
+ *
+ * Lists the files which already exist in @target_parent_file, so the
+ * conflict policy is applied without trying to write each target first,
+ * which saves a round trip per conflict on remote locations.
+ *
+ * Return value: a #GHashTable mapping the names of the existing files to
+ *               their #GFileInfo, or %NULL if the user is asked about
+ *               conflicts or the folder could not be listed.
+ **/
+static GHashTable *
+thunar_transfer_job_plan_folder (ThunarTransferJob *job,
+                                 GFile             *target_parent_file)
+{
+  GFileEnumerator *enumerator;
+  GHashTable      *plan;
+  GFileInfo       *info;
+
+  if (job->conflict_policy == THUNAR_TRANSFER_CONFLICT_POLICY_ASK || job->type != THUNAR_TRANSFER_JOB_COPY)
+    return NULL;
+
+  enumerator = g_file_enumerate_children (target_parent_file,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          THUNAR_TRANSFER_JOB_CONFLICT_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (enumerator == NULL)
+    return NULL;
+
+  plan = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  while ((info = g_file_enumerator_next_file (enumerator, exo_job_get_cancellable (EXO_JOB (job)), NULL)) != NULL)
+    g_hash_table_insert (plan, g_strdup (g_file_info_get_name (info)), info);
+
+  g_object_unref (enumerator);
+
+  return plan;
+}
+
+
+
 /**
  * thunar_transfer_job_copy_file:
  * @job                : a #ThunarTransferJob.
@@ -677,6 +1354,7 @@ ttj_copy_file (ThunarTransferJob  *job,
  * @target_file        : the destination #GFile to copy to.
  * @replace_confirmed  : whether the user has already confirmed that this file should replace an existing one
  * @rename_confirmed   : whether the user has already confirmed that this file should be renamed to a new unique file name
+ * @deferred           : return location for whether the user is asked later, or %NULL.
  * @error              : return location for errors or %NULL.
  *
  * Tries to copy @source_file to @target_file. The real destination is the
@@ -684,7 +1362,9 @@ ttj_copy_file (ThunarTransferJob  *job,
  * the file "/foo/bar" into the same directory you'll end up with something
  * like "/foo/copy of bar" instead of "/foo/bar"). If an existing file would
  * be replaced, the user is asked to confirm replace or rename it unless
- * @replace_confirmed or @rename_confirmed is TRUE.
+ * @replace_confirmed or @rename_confirmed is TRUE. While the job defers
+ * conflicts, %NULL is returned instead of asking, with @deferred set to
+ * %TRUE and @error unset.
  *
  * The return value is guaranteed to be %NULL on errors and @error will
  * always be set in those cases. If the file is skipped, the return value
@@ -703,6 +1383,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob     *job,
                                GFile                 *target_file,
                                gboolean               replace_confirmed,
                                gboolean               rename_confirmed,
+                               gboolean              *deferred,
                                GError               **error)
 {
   ThunarJobResponse response;
@@ -730,12 +1411,17 @@ thunar_transfer_job_copy_file (ThunarTransferJob     *job,
       if (G_LIKELY (!g_file_equal (source_file, dest_file)))
         target = g_object_ref (dest_file);
       else
-        target = thunar_io_jobs_util_next_duplicate_file (THUNAR_JOB (job), source_file, THUNAR_NEXT_FILE_NAME_MODE_COPY, &err);
+        target = thunar_io_jobs_util_next_duplicate_file (THUNAR_JOB (job), source_file, THUNAR_NEXT_FILE_NAME_MODE_COPY,
+                                                          job->names_by_dir, &err);
 
       if (err == NULL)
         {
+          /* reset the file progress */
+          job->file_progress = 0;
+
           /* try to copy the file from source file to the duplicate file */
-          if (ttj_copy_file (job, operation, source_file, target, copy_flags, &err))
+          if (ttj_copy_file (job, operation, source_file, target, copy_flags,
+                             thunar_transfer_job_progress, job, &err))
             return target;
           else /* go to error case */
             g_object_unref (target);
@@ -753,8 +1439,21 @@ thunar_transfer_job_copy_file (ThunarTransferJob     *job,
           else if (rename_confirmed)
             response = THUNAR_JOB_RESPONSE_RENAME;
           else
-            response = thunar_job_ask_replace (THUNAR_JOB (job), source_file,
-                                               dest_file, &err);
+            {
+              /* the conflict policy may settle it without the user */
+              response = thunar_transfer_job_conflict_response_for_files (job, source_file, dest_file);
+              if (response == 0 && job->defer_conflicts && deferred != NULL)
+                {
+                  /* go on with the other files, the user is asked at the end */
+                  *deferred = TRUE;
+                  return NULL;
+                }
+              else if (response == 0)
+                {
+                  response = thunar_job_ask_replace (THUNAR_JOB (job), source_file,
+                                                     dest_file, &err);
+                }
+            }
 
           if (err != NULL)
             break;
@@ -772,7 +1471,8 @@ thunar_transfer_job_copy_file (ThunarTransferJob     *job,
               renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job),
                                                                     source_file,
                                                                     dest_file,
-                                                                    ++n_rename, &err);
+                                                                    ++n_rename,
+                                                                    job->names_by_dir, &err);
               if (renamed_file != NULL)
                 {
                   if (err != NULL)
@@ -800,6 +1500,369 @@ thunar_transfer_job_copy_file (ThunarTransferJob     *job,
 
 
 
+static void
+thunar_transfer_job_pool_progress (goffset  current_num_bytes,
+                                   goffset  total_num_bytes,
+                                   gpointer user_data)
+{
+  ThunarTransferPoolCopy *copy = user_data;
+
+  thunar_transfer_job_check_pause (copy->pool->job);
+
+  g_mutex_lock (&copy->pool->mutex);
+  copy->pool->progress += (current_num_bytes - copy->file_progress);
+  g_mutex_unlock (&copy->pool->mutex);
+
+  copy->file_progress = current_num_bytes;
+
+  /* the progress is only reported once data was written to the target */
+  copy->created = TRUE;
+}
+
+
+
+/* writes a small regular file to a remote target with as few round trips
+ * as possible, its attributes are returned to be set later. Returns
+ * FALSE with error unset if the file is too big for that */
+static gboolean
+thunar_transfer_job_pool_copy_small (ThunarTransferPoolCopy *copy,
+                                     GFile                  *source_file,
+                                     GFile                  *target_file,
+                                     GFileInfo             **info_return,
+                                     GError                **error)
+{
+  GCancellable      *cancellable = exo_job_get_cancellable (EXO_JOB (copy->pool->job));
+  GFileOutputStream *output;
+  GFileInfo         *info;
+  ThunarIoTicket    *ticket;
+  gchar             *contents;
+  gsize              length;
+  gboolean           success;
+
+  info = g_file_query_info (source_file, THUNAR_TRANSFER_JOB_BATCH_ATTRIBUTES,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
+  if (info == NULL || g_file_info_get_size (info) > THUNAR_TRANSFER_JOB_BATCH_FILE_SIZE)
+    {
+      g_clear_object (&info);
+      return FALSE;
+    }
+
+  /* an unreadable source is left to the usual copy, which reports it
+   * without touching a target which might already exist */
+  if (!g_file_load_contents (source_file, cancellable, &contents, &length, NULL, NULL))
+    {
+      g_object_unref (info);
+      return FALSE;
+    }
+
+  ticket = thunar_io_scheduler_acquire (copy->pool->job->io_scheduler, source_file, target_file, TRUE, cancellable);
+
+  /* fails with G_IO_ERROR_EXISTS like g_file_copy() without G_FILE_COPY_OVERWRITE */
+  output = g_file_create (target_file, G_FILE_CREATE_NONE, cancellable, error);
+  copy->created = (output != NULL);
+  success = output != NULL
+            && g_output_stream_write_all (G_OUTPUT_STREAM (output), contents, length, NULL, cancellable, error)
+            && g_output_stream_close (G_OUTPUT_STREAM (output), cancellable, error);
+
+  thunar_io_ticket_release (ticket);
+
+  if (output != NULL)
+    g_object_unref (output);
+  g_free (contents);
+
+  if (!success)
+    {
+      g_object_unref (info);
+      return FALSE;
+    }
+
+  thunar_transfer_job_pool_progress (length, length, copy);
+
+  /* the size is not an attribute to set */
+  g_file_info_remove_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+  *info_return = info;
+
+  return TRUE;
+}
+
+
+
+static gpointer
+thunar_transfer_job_pool_thread (gpointer data)
+{
+  ThunarTransferPool     *pool = data;
+  ThunarTransferPoolCopy  copy;
+  ThunarTransferNode     *node;
+  GError                 *err = NULL;
+  GFile                  *target_file;
+  gchar                  *base_name;
+
+  copy.pool = pool;
+
+  for (;;)
+    {
+      g_mutex_lock (&pool->mutex);
+      while (pool->queuing && g_queue_is_empty (&pool->nodes))
+        g_cond_wait (&pool->queue_cond, &pool->mutex);
+      node = g_queue_pop_head (&pool->nodes);
+      g_mutex_unlock (&pool->mutex);
+
+      if (node == NULL || exo_job_is_cancelled (EXO_JOB (pool->job)))
+        break;
+
+      base_name = g_file_get_basename (node->source_file);
+      target_file = g_file_get_child (pool->target_parent_file, base_name);
+      g_free (base_name);
+
+      copy.file_progress = 0;
+      copy.created = FALSE;
+      if ((pool->batch_small_files
+           && node->file_type == G_FILE_TYPE_REGULAR
+           && thunar_transfer_job_pool_copy_small (&copy, node->source_file, target_file, &node->deferred_info, &err))
+          || (err == NULL
+              && ttj_copy_file (pool->job, NULL, node->source_file, target_file, G_FILE_COPY_NOFOLLOW_SYMLINKS,
+                                thunar_transfer_job_pool_progress, &copy, &err)))
+        {
+          node->pooled_target = target_file;
+        }
+      else
+        {
+          /* remove what this copy wrote, a target which was there
+           * before or never created by us is left alone */
+          if (copy.created && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
+            g_file_delete (target_file, NULL, NULL);
+
+          /* take back the progress, the file is copied once more */
+          g_mutex_lock (&pool->mutex);
+          pool->progress -= copy.file_progress;
+          g_mutex_unlock (&pool->mutex);
+
+          g_clear_error (&err);
+          g_object_unref (target_file);
+        }
+    }
+
+  g_mutex_lock (&pool->mutex);
+  pool->n_running--;
+  g_cond_signal (&pool->cond);
+  g_mutex_unlock (&pool->mutex);
+
+  return NULL;
+}
+
+
+
+/**
+ * thunar_transfer_job_copy_pooled:
+ * @job                : a #ThunarTransferJob.
+ * @node               : the first of the sibling nodes to copy.
+ * @target_parent_file : the folder to copy the nodes to.
+ *
+ * Copies the files (not the folders) among @node and its siblings with
+ * several threads at once, which hides the latency of every single copy
+ * on remote locations. The nodes which were copied get their
+ * pooled_target set. All other nodes, including the files which failed
+ * or whose target already exists, are left to thunar_transfer_job_copy_node(),
+ * which asks the user how to go on. So are the files listed in @plan,
+ * whose targets are known to exist. The files are copied as soon as the
+ * collector knows them, not only once the whole folder is collected.
+ *
+ * Small files copied to remote locations are written in one request each
+ * and their attributes are only set once all files of the folder were
+ * written, so the copy is limited by the bandwidth rather than by the
+ * latency of the many round trips of g_file_copy().
+ **/
+static void
+thunar_transfer_job_copy_pooled (ThunarTransferJob  *job,
+                                 ThunarTransferNode *node,
+                                 GFile              *target_parent_file,
+                                 GHashTable         *plan)
+{
+  ThunarTransferPool  pool;
+  ThunarTransferNode *first = node;
+  ThunarTransferNode *pending = NULL;
+  GThread            *threads[MAX (THUNAR_TRANSFER_JOB_POOL_THREADS_NATIVE, THUNAR_TRANSFER_JOB_POOL_THREADS_REMOTE)];
+  guint               n_threads = 0;
+  guint               n_threads_max = 0;
+  guint               n_queued = 0;
+  guint               n;
+  gchar              *base_name;
+
+  pool.job = job;
+  pool.target_parent_file = target_parent_file;
+  pool.queuing = TRUE;
+  pool.n_running = 0;
+  pool.progress = 0;
+  g_queue_init (&pool.nodes);
+  g_mutex_init (&pool.mutex);
+  g_cond_init (&pool.cond);
+  g_cond_init (&pool.queue_cond);
+
+  /* the files are handed to the threads as soon as they are collected,
+   * while the collector is still busy with the rest of the folder */
+  for (; node != NULL && thunar_transfer_job_wait_collected (job, node, NULL); node = node->next)
+    {
+      if (node->file_type != G_FILE_TYPE_REGULAR && node->file_type != G_FILE_TYPE_SYMBOLIC_LINK)
+        continue;
+
+      /* conflicts are settled by the conflict policy */
+      if (plan != NULL)
+        {
+          base_name = g_file_get_basename (node->source_file);
+          if (g_hash_table_contains (plan, base_name))
+            {
+              g_free (base_name);
+              continue;
+            }
+          g_free (base_name);
+        }
+
+      /* a single file is copied the usual way, so the threads
+       * are only started once there is a second one */
+      if (n_threads_max == 0)
+        {
+          if (pending == NULL)
+            {
+              pending = node;
+              continue;
+            }
+
+          n_threads_max = (g_file_is_native (pending->source_file) && g_file_is_native (target_parent_file))
+                          ? THUNAR_TRANSFER_JOB_POOL_THREADS_NATIVE : THUNAR_TRANSFER_JOB_POOL_THREADS_REMOTE;
+
+          /* partial files are wanted to avoid incomplete targets, so they are copied the usual way */
+          pool.batch_small_files = !g_file_is_native (target_parent_file)
+                                   && job->transfer_use_partial == THUNAR_USE_PARTIAL_MODE_DISABLED;
+        }
+
+      g_mutex_lock (&pool.mutex);
+      if (pending != NULL)
+        {
+          g_queue_push_tail (&pool.nodes, pending);
+          pending = NULL;
+          n_queued++;
+        }
+      g_queue_push_tail (&pool.nodes, node);
+      g_cond_broadcast (&pool.queue_cond);
+      n_queued++;
+
+      /* one thread for every queued file, up to the limit */
+      for (; n_threads < n_threads_max && n_threads < n_queued; ++n_threads)
+        {
+          pool.n_running++;
+          threads[n_threads] = g_thread_new ("ThunarTransferJob", thunar_transfer_job_pool_thread, &pool);
+        }
+      g_mutex_unlock (&pool.mutex);
+    }
+
+  /* let the threads finish once the queue is empty */
+  g_mutex_lock (&pool.mutex);
+  pool.queuing = FALSE;
+  g_cond_broadcast (&pool.queue_cond);
+  g_mutex_unlock (&pool.mutex);
+
+  if (n_threads == 0)
+    {
+      g_cond_clear (&pool.queue_cond);
+      g_cond_clear (&pool.cond);
+      g_mutex_clear (&pool.mutex);
+      return;
+    }
+
+  /* the job thread only reports the progress of the threads */
+  g_mutex_lock (&pool.mutex);
+  while (pool.n_running > 0)
+    {
+      g_cond_wait_until (&pool.cond, &pool.mutex, g_get_monotonic_time () + G_USEC_PER_SEC / 2);
+
+      job->total_progress += pool.progress;
+      pool.progress = 0;
+
+      g_mutex_unlock (&pool.mutex);
+      thunar_transfer_job_emit_progress (job, FALSE);
+      g_mutex_lock (&pool.mutex);
+    }
+  g_mutex_unlock (&pool.mutex);
+
+  for (n = 0; n < n_threads; ++n)
+    g_thread_join (threads[n]);
+
+  job->total_progress += pool.progress;
+
+  /* set the attributes of the batched files, failures are ignored like in g_file_copy() */
+  for (node = first; node != NULL; node = node->next)
+    {
+      if (node->deferred_info == NULL)
+        continue;
+
+      if (!exo_job_is_cancelled (EXO_JOB (job)))
+        g_file_set_attributes_from_info (node->pooled_target, node->deferred_info, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                         exo_job_get_cancellable (EXO_JOB (job)), NULL);
+      g_clear_object (&node->deferred_info);
+    }
+
+  /* the nodes left over after a cancellation */
+  g_queue_clear (&pool.nodes);
+  g_cond_clear (&pool.queue_cond);
+  g_cond_clear (&pool.cond);
+  g_mutex_clear (&pool.mutex);
+}
+
+
+
+/* passes the queued copies and removals on to the thumbnail cache */
+static void
+thunar_transfer_job_thumbnail_flush (ThunarTransferJob *job)
+{
+  if (job->thumbnail_sources->len > 0)
+    {
+      thunar_thumbnail_cache_copy_files (job->thumbnail_cache,
+                                         (GFile **) job->thumbnail_sources->pdata,
+                                         (GFile **) job->thumbnail_targets->pdata,
+                                         job->thumbnail_sources->len);
+      g_ptr_array_set_size (job->thumbnail_sources, 0);
+      g_ptr_array_set_size (job->thumbnail_targets, 0);
+    }
+
+  if (job->thumbnail_deleted != NULL)
+    {
+      thunar_thumbnail_cache_delete_files (job->thumbnail_cache, job->thumbnail_deleted);
+      g_list_free_full (job->thumbnail_deleted, g_object_unref);
+      job->thumbnail_deleted = NULL;
+      job->n_thumbnail_deleted = 0;
+    }
+}
+
+
+
+/* queues a copy for the thumbnail cache, instead of taking
+ * the lock of the cache once for every single file */
+static void
+thunar_transfer_job_thumbnail_copy (ThunarTransferJob *job,
+                                    GFile             *source_file,
+                                    GFile             *target_file)
+{
+  g_ptr_array_add (job->thumbnail_sources, g_object_ref (source_file));
+  g_ptr_array_add (job->thumbnail_targets, g_object_ref (target_file));
+
+  if (job->thumbnail_sources->len >= THUNAR_TRANSFER_JOB_THUMBNAIL_BATCH)
+    thunar_transfer_job_thumbnail_flush (job);
+}
+
+
+
+static void
+thunar_transfer_job_thumbnail_delete (ThunarTransferJob *job,
+                                      GFile             *file)
+{
+  job->thumbnail_deleted = g_list_prepend (job->thumbnail_deleted, g_object_ref (file));
+
+  if (++job->n_thumbnail_deleted >= THUNAR_TRANSFER_JOB_THUMBNAIL_BATCH)
+    thunar_transfer_job_thumbnail_flush (job);
+}
+
+
+
 static void
 thunar_transfer_job_copy_node (ThunarTransferJob  *job,
                                ThunarJobOperation *operation,
@@ -810,8 +1873,6 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
                                GError            **error)
 {
   static const GRegex  *windows_reserved_name = NULL;
-  ThunarThumbnailCache *thumbnail_cache;
-  ThunarApplication    *application;
   ThunarJobResponse     response;
   GFileInfo            *info;
   GFileInfo            *fs_info;
@@ -821,6 +1882,16 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
   const gchar          *fs_type;
   gboolean              should_use_copy_name;
   gboolean              use_fat_name_scheme;
+  gboolean              verify_file;
+  gint64                trace_begin;
+  guint64               trace_progress;
+  guint                 trace_n_nodes = 0;
+  gboolean              deferred;
+  gboolean              replace_confirmed;
+  gboolean              rename_confirmed;
+  GHashTable           *plan = NULL;
+  GFileInfo            *target_info;
+  GFile                *renamed_file;
 
   _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
   _thunar_return_if_fail (node != NULL && G_IS_FILE (node->source_file));
@@ -828,6 +1899,9 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
   _thunar_return_if_fail ((target_file == NULL && target_parent_file != NULL) || (target_file != NULL && target_parent_file == NULL));
   _thunar_return_if_fail (error == NULL || *error == NULL);
 
+  trace_begin = THUNAR_TRACE_BEGIN ();
+  trace_progress = job->total_progress;
+
   /* The caller can either provide a target_file or a target_parent_file, but not both. The toplevel
    * transfer_nodes (for which next is NULL) should be called with target_file, to get proper behavior
    * wrt restoring files from the trash. Other transfer_nodes will be called with target_parent_file.
@@ -841,11 +1915,6 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
       windows_reserved_name = g_regex_new ("^((COM\\d)|(LPT\\d)|(CON)|(PRN)|(AUX)|(NUL))(\\..*)?$", G_REGEX_CASELESS, 0, NULL);
     }
 
-  /* take a reference on the thumbnail cache */
-  application = thunar_application_get ();
-  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
-  g_object_unref (application);
-
   should_use_copy_name = G_UNLIKELY (!g_file_is_native (node->source_file));
 
   if (target_parent_file == NULL)
@@ -874,11 +1943,59 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
       use_fat_name_scheme = FALSE;
     }
 
-  for (; err == NULL && node != NULL; node = node->next)
+  switch (job->transfer_verify_file)
     {
+    case THUNAR_VERIFY_FILE_MODE_REMOTE_ONLY:
+      verify_file = !g_file_is_native (node->source_file) || !g_file_is_native (target_parent_file);
+      break;
+    case THUNAR_VERIFY_FILE_MODE_ALWAYS:
+      verify_file = TRUE;
+      break;
+    default:
+      verify_file = FALSE;
+    }
+
+  /* copy the files of a folder with several threads, unless their target
+   * names have to be adjusted or the copies are verified, which reports
+   * to the user */
+  /* the existing files of a folder the nodes are merged into, toplevel
+   * nodes go to a single target and find out on their own */
+  if (target_file == NULL)
+    plan = thunar_transfer_job_plan_folder (job, target_parent_file);
+
+  if (job->type == THUNAR_TRANSFER_JOB_COPY
+      && target_file == NULL
+      && !should_use_copy_name
+      && !use_fat_name_scheme
+      && !verify_file)
+    thunar_transfer_job_copy_pooled (job, node, target_parent_file, plan);
+
+  for (; err == NULL && node != NULL; node = node->next, ++trace_n_nodes)
+    {
+      /* the node may still be collected by the collector thread */
+      if (!thunar_transfer_job_wait_collected (job, node, &err))
+        break;
+
+      /* the file was already copied by the pool */
+      if (node->pooled_target != NULL)
+        {
+          thunar_transfer_job_thumbnail_copy (job, node->source_file, node->pooled_target);
+
+          if (operation != NULL && thunar_job_get_log_mode (THUNAR_JOB (job)) == THUNAR_OPERATION_LOG_OPERATIONS)
+            thunar_job_operation_add (operation, node->source_file, node->pooled_target);
+
+          if (G_LIKELY (target_file_list_return != NULL))
+            *target_file_list_return = thunar_g_list_prepend_deep (*target_file_list_return, node->pooled_target);
+
+          g_clear_object (&node->pooled_target);
+          continue;
+        }
+
       /* query file info */
       info = g_file_query_info (node->source_file,
-                                G_FILE_ATTRIBUTE_STANDARD_COPY_NAME "," G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                                G_FILE_ATTRIBUTE_STANDARD_COPY_NAME ","
+                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                                THUNAR_TRANSFER_JOB_CONFLICT_ATTRIBUTES,
                                 G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                 exo_job_get_cancellable (EXO_JOB (job)),
                                 &err);
@@ -934,37 +2051,95 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
           /* avoid filename that ends with '.' */
           if (g_str_has_suffix (base_name, "."))
             {
-              gchar *tmp = base_name;
-              base_name = g_strconcat (tmp, "___", NULL);
-              g_free (tmp);
+              gchar *tmp = base_name;
+              base_name = g_strconcat (tmp, "___", NULL);
+              g_free (tmp);
+            }
+
+          target_file = g_file_get_child (target_parent_file, base_name);
+          g_free (base_name);
+        }
+
+      replace_confirmed = node->replace_confirmed;
+      rename_confirmed = node->rename_confirmed;
+
+      /* settle a known conflict without trying to write the target */
+      if (plan != NULL && !replace_confirmed && !rename_confirmed)
+        {
+          base_name = g_file_get_basename (target_file);
+          target_info = g_hash_table_lookup (plan, base_name);
+          g_free (base_name);
+
+          response = 0;
+          if (target_info != NULL)
+            response = thunar_transfer_job_conflict_response (job, node->source_file, node->file_type, info,
+                                                              target_file, target_info);
+
+          if (response == THUNAR_JOB_RESPONSE_SKIP)
+            {
+              /* the data of a kept file counts as transferred, e.g. for an incremental copy */
+              if (node->file_type == G_FILE_TYPE_REGULAR)
+                job->total_progress += g_file_info_get_size (info);
+
+              g_clear_object (&target_file);
+              g_object_unref (info);
+              continue;
+            }
+          else if (response == THUNAR_JOB_RESPONSE_REPLACE)
+            {
+              replace_confirmed = TRUE;
             }
+          else if (response == THUNAR_JOB_RESPONSE_RENAME)
+            {
+              renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job), node->source_file, target_file,
+                                                                    1, job->names_by_dir, &err);
+              if (G_UNLIKELY (err != NULL))
+                {
+                  g_clear_object (&renamed_file);
+                  g_clear_object (&target_file);
+                  g_object_unref (info);
+                  break;
+                }
 
-          target_file = g_file_get_child (target_parent_file, base_name);
-          g_free (base_name);
+              g_object_unref (target_file);
+              target_file = renamed_file;
+              rename_confirmed = TRUE;
+            }
         }
 
       /* update progress information */
-      exo_job_info_message (EXO_JOB (job), "%s", g_file_info_get_display_name (info));
+      thunar_job_set_info_message (THUNAR_JOB (job), "%s", g_file_info_get_display_name (info));
 
 retry_copy:
       thunar_transfer_job_check_pause (job);
 
       /* copy the item specified by this node (not recursively) */
+      deferred = FALSE;
       real_target_file = thunar_transfer_job_copy_file (job, operation,
                                                         node->source_file,
                                                         target_file,
-                                                        node->replace_confirmed,
-                                                        node->rename_confirmed,
+                                                        replace_confirmed,
+                                                        rename_confirmed,
+                                                        &deferred,
                                                         &err);
-      if (G_LIKELY (real_target_file != NULL))
+      if (G_UNLIKELY (deferred))
+        {
+          ThunarTransferConflict *conflict;
+
+          /* the node and its children are copied by thunar_transfer_job_resolve_conflicts() */
+          conflict = g_slice_new (ThunarTransferConflict);
+          conflict->node = node;
+          conflict->target_file = g_object_ref (target_file);
+          conflict->target_file_list_return = target_file_list_return;
+          g_queue_push_tail (&job->conflicts, conflict);
+        }
+      else if (G_LIKELY (real_target_file != NULL))
         {
           /* node->source_file == real_target_file means to skip the file */
           if (G_LIKELY (node->source_file != real_target_file))
             {
               /* notify the thumbnail cache of the copy operation */
-              thunar_thumbnail_cache_copy_file (thumbnail_cache,
-                                                node->source_file,
-                                                real_target_file);
+              thunar_transfer_job_thumbnail_copy (job, node->source_file, real_target_file);
 
               /* check if we have children to copy */
               if (node->children != NULL)
@@ -972,9 +2147,15 @@ retry_copy:
                   /* copy all children of this node */
                   thunar_transfer_job_copy_node (job, operation, node->children, NULL, real_target_file, NULL, &err);
 
-                  /* free resources allocted for the children */
-                  thunar_transfer_node_free (node->children);
-                  node->children = NULL;
+                  /* free resources allocted for the children, unless the
+                   * collector thread might still walk them or a deferred
+                   * conflict still points into them */
+                  if ((!job->collect_async || thunar_transfer_job_collect_done (job))
+                      && g_queue_is_empty (&job->conflicts))
+                    {
+                      thunar_transfer_node_free (node->children);
+                      node->children = NULL;
+                    }
                 }
 
               /* check if the child copy failed */
@@ -1005,8 +2186,7 @@ retry_remove:
                                      &err))
                     {
                       /* notify the thumbnail cache of the delete operation */
-                      thunar_thumbnail_cache_delete_file (thumbnail_cache,
-                                                          node->source_file);
+                      thunar_transfer_job_thumbnail_delete (job, node->source_file);
                     }
                   else
                     {
@@ -1056,8 +2236,12 @@ retry_remove:
   /* release filesystem info */
   g_clear_object (&fs_info);
 
-  /* release the thumbnail cache */
-  g_object_unref (thumbnail_cache);
+  if (plan != NULL)
+    g_hash_table_destroy (plan);
+
+  /* nested directories get their own marks, so the bytes include them */
+  THUNAR_TRACE_MARK (trace_begin, "copy-node", "%u nodes, %" G_GUINT64_FORMAT " bytes",
+                     trace_n_nodes, job->total_progress - trace_progress);
 
   /* propagate error if we failed or the job was cancelled */
   if (G_UNLIKELY (err != NULL))
@@ -1066,6 +2250,51 @@ retry_remove:
 
 
 
+/**
+ * thunar_transfer_job_resolve_conflicts:
+ * @job       : a #ThunarTransferJob.
+ * @operation : the #ThunarJobOperation of the copy or %NULL.
+ * @error     : return location for errors or %NULL.
+ *
+ * Copies the nodes whose target existed, which were put aside while
+ * the rest of the files were copied, so a long copy does not stop at
+ * the first conflict. The user is asked about them one after another,
+ * "Replace All" and "Skip All" settle the remaining ones at once.
+ **/
+static void
+thunar_transfer_job_resolve_conflicts (ThunarTransferJob  *job,
+                                       ThunarJobOperation *operation,
+                                       GError            **error)
+{
+  ThunarTransferConflict *conflict;
+  ThunarTransferNode      node;
+  GError                 *err = NULL;
+
+  job->defer_conflicts = FALSE;
+
+  while (err == NULL && (conflict = g_queue_pop_head (&job->conflicts)) != NULL)
+    {
+      /* copy the node alone, its siblings might still be walked by the
+       * collector thread, but the node itself is collected already */
+      node = *conflict->node;
+      node.next = NULL;
+      thunar_transfer_job_copy_node (job, operation, &node, conflict->target_file, NULL,
+                                     conflict->target_file_list_return, &err);
+
+      /* the copy frees the children it copied */
+      conflict->node->children = node.children;
+
+      thunar_transfer_conflict_free (conflict);
+    }
+
+  g_queue_clear_full (&job->conflicts, thunar_transfer_conflict_free);
+
+  if (G_UNLIKELY (err != NULL))
+    g_propagate_error (error, err);
+}
+
+
+
 static gboolean
 thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
                                         GError            **error)
@@ -1078,6 +2307,7 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
   gchar             *base_name;
   gboolean           succeed = TRUE;
   gchar             *size_string;
+  guint64            remaining_size;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (transfer_job), FALSE);
 
@@ -1085,8 +2315,11 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
   if (transfer_job->target_file_list == NULL)
     return TRUE;
 
+  /* the copy might have started before the source tree was collected */
+  remaining_size = transfer_job->total_size - MIN (transfer_job->total_progress, transfer_job->total_size);
+
   /* total size is nul, should be fine */
-  if (transfer_job->total_size == 0)
+  if (remaining_size == 0)
     return TRUE;
 
   /* for all actions in thunar use the same target directory so
@@ -1125,9 +2358,9 @@ thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
   if (g_file_info_has_attribute (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE))
     {
       free_space = g_file_info_get_attribute_uint64 (filesystem_info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
-      if (transfer_job->total_size > free_space)
+      if (remaining_size > free_space)
         {
-          size_string = g_format_size_full (transfer_job->total_size - free_space,
+          size_string = g_format_size_full (remaining_size - free_space,
                                             transfer_job->file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
           succeed = thunar_job_ask_no_size (THUNAR_JOB (transfer_job),
                                              _("Error while copying to \"%s\": %s more space is "
@@ -1260,7 +2493,9 @@ thunar_transfer_job_move_file_with_rename (ExoJob             *job,
       renamed_file = thunar_io_jobs_util_next_renamed_file (THUNAR_JOB (job),
                                                             node->source_file,
                                                             tp->data,
-                                                            n_rename++, error);
+                                                            n_rename++,
+                                                            THUNAR_TRANSFER_JOB (job)->names_by_dir,
+                                                            error);
       if (renamed_file == NULL)
           return FALSE;
 
@@ -1591,6 +2826,372 @@ thunar_transfer_job_can_start (ThunarTransferJob *transfer_job,
 
 
 
+#ifdef HAVE_RENAMEAT2
+/* returns a descriptor of the folder containing file, the one of the
+ * previous file is kept while the files are in the same folder */
+static gint
+thunar_transfer_job_open_parent (GFile  *file,
+                                 gchar **parent_path,
+                                 gint   *parent_fd)
+{
+  gchar *dirname;
+
+  dirname = g_path_get_dirname (g_file_peek_path (file));
+  if (*parent_path != NULL && strcmp (dirname, *parent_path) == 0)
+    {
+      g_free (dirname);
+      return *parent_fd;
+    }
+
+  if (*parent_fd >= 0)
+    close (*parent_fd);
+
+  g_free (*parent_path);
+  *parent_path = dirname;
+  *parent_fd = open (dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  return *parent_fd;
+}
+
+
+
+/* returns the file in the home trash folder that a toplevel item of
+ * trash:/// stands for, and the path of its trash info file. The
+ * items of the trash folders of other mounts are not found there */
+static GFile *
+thunar_transfer_job_home_trash_file (GFile        *file,
+                                     GFile        *trash_root,
+                                     const gchar  *trash_dir,
+                                     gchar       **info_path)
+{
+  GFile *trashed_file;
+  gchar *name;
+  gchar *info_name;
+  gchar *path;
+
+  if (!g_file_has_parent (file, trash_root))
+    return NULL;
+
+  name = g_file_get_basename (file);
+  if (G_UNLIKELY (name == NULL))
+    return NULL;
+
+  path = g_build_filename (trash_dir, "files", name, NULL);
+  trashed_file = g_file_new_for_path (path);
+  g_free (path);
+
+  info_name = g_strconcat (name, ".trashinfo", NULL);
+  *info_path = g_build_filename (trash_dir, "info", info_name, NULL);
+  g_free (info_name);
+  g_free (name);
+
+  return trashed_file;
+}
+#endif
+
+
+
+/* renames every toplevel file of a move that stays on its file system
+ * directly, without going through GIO one file at a time. Files in the
+ * home trash are renamed from the trash folder and their trash info
+ * is removed, so a large restore doesn't go through the trash backend
+ * file by file. The files that could not be renamed stay in the lists,
+ * for the regular move to handle them and to ask the user about conflicts */
+static void
+thunar_transfer_job_move_bulk (ThunarTransferJob    *job,
+                               ThunarJobOperation   *operation,
+                               ThunarThumbnailCache *thumbnail_cache,
+                               GList               **new_files_list_p)
+{
+#ifdef HAVE_RENAMEAT2
+  ThunarTransferNode *node;
+  GPtrArray          *source_files;
+  GPtrArray          *target_files;
+  GList              *snext;
+  GList              *sp;
+  GList              *tnext;
+  GList              *tp;
+  gchar              *source_dir = NULL;
+  gchar              *target_dir = NULL;
+  gchar              *source_name;
+  gchar              *target_name;
+  GFile              *source_file;
+  GFile              *trash_root = NULL;
+  gchar              *trash_dir = NULL;
+  gchar              *info_path = NULL;
+  gint                source_fd = -1;
+  gint                target_fd = -1;
+  gint                result;
+  guint               n_files;
+  guint               n_moved = 0;
+
+  n_files = g_list_length (job->source_node_list);
+  source_files = g_ptr_array_new_full (n_files, g_object_unref);
+  target_files = g_ptr_array_new_full (n_files, g_object_unref);
+  for (sp = job->source_node_list, tp = job->target_file_list;
+       sp != NULL && tp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       sp = snext, tp = tnext)
+    {
+      thunar_transfer_job_check_pause (job);
+
+      /* determine the next list items */
+      snext = sp->next;
+      tnext = tp->next;
+
+      node = sp->data;
+      if (!g_file_is_native (tp->data))
+        continue;
+
+      /* restore from the home trash folder directly */
+      if (thunar_g_file_is_trashed (node->source_file))
+        {
+          if (trash_root == NULL)
+            {
+              trash_root = g_file_new_for_uri ("trash:///");
+              trash_dir = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+            }
+          source_file = thunar_transfer_job_home_trash_file (node->source_file, trash_root, trash_dir, &info_path);
+          if (source_file == NULL)
+            continue;
+        }
+      else if (g_file_is_native (node->source_file))
+        {
+          source_file = g_object_ref (node->source_file);
+        }
+      else
+        {
+          continue;
+        }
+
+      if (thunar_transfer_job_open_parent (source_file, &source_dir, &source_fd) < 0
+          || thunar_transfer_job_open_parent (tp->data, &target_dir, &target_fd) < 0)
+        {
+          g_object_unref (source_file);
+          g_free (info_path);
+          info_path = NULL;
+          continue;
+        }
+
+      /* an existing target or another file system is left to the regular move */
+      source_name = g_file_get_basename (source_file);
+      target_name = g_file_get_basename (tp->data);
+      result = renameat2 (source_fd, source_name, target_fd, target_name, RENAME_NOREPLACE);
+      g_free (source_name);
+      g_free (target_name);
+      g_object_unref (source_file);
+
+      if (result < 0)
+        {
+          g_free (info_path);
+          info_path = NULL;
+
+          /* the kernel does not know renameat2 */
+          if (errno == ENOSYS)
+            break;
+          continue;
+        }
+
+      /* the file is no longer in the trash */
+      if (info_path != NULL)
+        {
+          g_unlink (info_path);
+          g_free (info_path);
+          info_path = NULL;
+        }
+
+      g_ptr_array_add (source_files, g_object_ref (node->source_file));
+      g_ptr_array_add (target_files, g_object_ref (tp->data));
+
+      if (operation != NULL)
+        thunar_job_operation_add (operation, node->source_file, tp->data);
+
+      /* add the target file to the new files list */
+      *new_files_list_p = thunar_g_list_prepend_deep (*new_files_list_p, tp->data);
+
+      /* release source and target files, and drop the matching list items */
+      thunar_transfer_node_free (node);
+      g_object_unref (tp->data);
+      job->source_node_list = g_list_delete_link (job->source_node_list, sp);
+      job->target_file_list = g_list_delete_link (job->target_file_list, tp);
+
+      if (++n_moved % THUNAR_TRANSFER_JOB_BULK_MOVE_FILES == 0)
+        thunar_job_set_percent (THUNAR_JOB (job), (n_moved * 100.0) / n_files);
+    }
+
+  if (source_fd >= 0)
+    close (source_fd);
+  if (target_fd >= 0)
+    close (target_fd);
+  g_free (source_dir);
+  g_free (target_dir);
+  g_free (trash_dir);
+  if (trash_root != NULL)
+    g_object_unref (trash_root);
+
+  /* notify the thumbnail cache of all moves at once */
+  thunar_thumbnail_cache_move_files (thumbnail_cache,
+                                     (GFile **) source_files->pdata,
+                                     (GFile **) target_files->pdata,
+                                     source_files->len);
+
+  g_ptr_array_unref (source_files);
+  g_ptr_array_unref (target_files);
+#endif
+}
+
+
+
+static gchar *
+thunar_transfer_job_journal_dir (void)
+{
+  const gchar *state_home;
+  gchar       *dirname;
+
+  /* g_get_user_state_dir() is not available before GLib 2.72 */
+  state_home = g_getenv ("XDG_STATE_HOME");
+  if (state_home != NULL && g_path_is_absolute (state_home))
+    dirname = g_build_filename (state_home, THUNAR_TRANSFER_JOB_JOURNAL_DIR, NULL);
+  else
+    dirname = g_build_filename (g_get_home_dir (), ".local", "state", THUNAR_TRANSFER_JOB_JOURNAL_DIR, NULL);
+
+  if (G_UNLIKELY (g_mkdir_with_parents (dirname, 0700) != 0))
+    {
+      g_free (dirname);
+      return NULL;
+    }
+
+  return dirname;
+}
+
+
+
+/* write the journal of a copy or move before its first file is touched,
+ * a "file" line for each source and target, and the conflict policy */
+static void
+thunar_transfer_job_journal_write (ThunarTransferJob *job)
+{
+  static gint  serial = 0;
+  GString     *journal;
+  GError      *err = NULL;
+  GList       *sp;
+  GList       *tp;
+  gchar       *filename;
+  gchar       *dirname;
+  gchar       *name;
+  gchar       *uri;
+
+  /* a resumed job goes on with the journal it was loaded from */
+  if (job->journal != NULL)
+    return;
+
+  dirname = thunar_transfer_job_journal_dir ();
+  if (G_UNLIKELY (dirname == NULL))
+    return;
+
+  journal = g_string_new ("# thunar transfer journal\n");
+  g_string_append_printf (journal, "type\t%s\n", job->type == THUNAR_TRANSFER_JOB_MOVE ? "move" : "copy");
+  g_string_append_printf (journal, "policy\t%d\n", job->conflict_policy);
+  for (sp = job->source_node_list, tp = job->target_file_list;
+       sp != NULL && tp != NULL;
+       sp = sp->next, tp = tp->next)
+    {
+      uri = g_file_get_uri (((ThunarTransferNode *) sp->data)->source_file);
+      g_string_append (journal, "file\t");
+      g_string_append (journal, uri);
+      g_free (uri);
+
+      uri = g_file_get_uri (tp->data);
+      g_string_append_c (journal, '\t');
+      g_string_append (journal, uri);
+      g_string_append_c (journal, '\n');
+      g_free (uri);
+    }
+
+  /* journals are named <pid>-<serial> like the rename journals */
+  name = g_strdup_printf ("%ld-%d", (glong) getpid (), g_atomic_int_add (&serial, 1));
+  filename = g_build_filename (dirname, name, NULL);
+  g_free (dirname);
+  g_free (name);
+
+  if (g_file_set_contents_full (filename, journal->str, journal->len,
+                                G_FILE_SET_CONTENTS_CONSISTENT, 0600, &err))
+    {
+      job->journal = filename;
+    }
+  else
+    {
+      /* the transfer itself does not depend on the journal */
+      g_warning ("Failed to write the transfer journal: %s", err->message);
+      g_error_free (err);
+      g_free (filename);
+    }
+
+  g_string_free (journal, TRUE);
+}
+
+
+
+/* append a "done" line for @source_file, which was copied as a whole */
+static void
+thunar_transfer_job_journal_checkpoint (ThunarTransferJob *job,
+                                        GFile             *source_file)
+{
+  gchar *line;
+  gchar *uri;
+  gint   fd;
+
+  if (job->journal == NULL)
+    return;
+
+  fd = g_open (job->journal, O_WRONLY | O_APPEND | O_CLOEXEC, 0);
+  if (G_UNLIKELY (fd < 0))
+    return;
+
+  uri = g_file_get_uri (source_file);
+  line = g_strconcat ("done\t", uri, "\n", NULL);
+  if (write (fd, line, strlen (line)) < 0)
+    g_debug ("Failed to update the transfer journal: %s", g_strerror (errno));
+  close (fd);
+
+  g_free (line);
+  g_free (uri);
+}
+
+
+
+/* drop the sources of a resumed job which are gone, a move removes every
+ * source it completed, so it does not need "done" lines */
+static void
+thunar_transfer_job_journal_prune (ThunarTransferJob *job,
+                                   GCancellable      *cancellable)
+{
+  ThunarTransferNode *node;
+  GList              *snext;
+  GList              *sp;
+  GList              *tnext;
+  GList              *tp;
+
+  for (sp = job->source_node_list, tp = job->target_file_list;
+       sp != NULL && tp != NULL;
+       sp = snext, tp = tnext)
+    {
+      snext = sp->next;
+      tnext = tp->next;
+      node = sp->data;
+
+      if (g_file_query_exists (node->source_file, cancellable))
+        continue;
+
+      job->source_node_list = g_list_delete_link (job->source_node_list, sp);
+      thunar_transfer_node_free (node);
+
+      g_object_unref (tp->data);
+      job->target_file_list = g_list_delete_link (job->target_file_list, tp);
+    }
+}
+
+
+
 static gboolean
 thunar_transfer_job_execute (ExoJob  *job,
                              GError **error)
@@ -1608,6 +3209,8 @@ thunar_transfer_job_execute (ExoJob  *job,
   GList                *tnext;
   GList                *tp;
   gboolean              log_operations;
+  gint64                trace_begin;
+  guint                 n_conflicts;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
@@ -1617,11 +3220,28 @@ thunar_transfer_job_execute (ExoJob  *job,
 
   exo_job_info_message (job, _("Collecting files..."));
 
+  /* keep a journal of copies and moves, so they survive a crash or logout */
+  if (transfer_job->type == THUNAR_TRANSFER_JOB_COPY || transfer_job->type == THUNAR_TRANSFER_JOB_MOVE)
+    {
+      if (transfer_job->journal_resumed)
+        {
+          thunar_transfer_job_journal_prune (transfer_job, exo_job_get_cancellable (job));
+          if (transfer_job->source_node_list == NULL)
+            return TRUE;
+        }
+
+      thunar_transfer_job_journal_write (transfer_job);
+    }
+
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
+  transfer_job->thumbnail_cache = g_object_ref (thumbnail_cache);
+  transfer_job->io_scheduler = thunar_application_get_io_scheduler (application);
   g_object_unref (application);
 
+  transfer_job->job_thread = g_thread_self ();
+
   /* whether or not we want to log operations to the undo list */
   if (thunar_job_get_log_mode (THUNAR_JOB (transfer_job)) == THUNAR_OPERATION_LOG_OPERATIONS)
     log_operations = TRUE;
@@ -1631,6 +3251,13 @@ thunar_transfer_job_execute (ExoJob  *job,
   if (log_operations && transfer_job->type == THUNAR_TRANSFER_JOB_MOVE)
     operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_MOVE);
 
+  /* copies start while the source tree is still being collected */
+  transfer_job->collect_async = (transfer_job->type == THUNAR_TRANSFER_JOB_COPY);
+
+  /* rename what stays on its file system in one go */
+  if (transfer_job->type == THUNAR_TRANSFER_JOB_MOVE)
+    thunar_transfer_job_move_bulk (transfer_job, operation, thumbnail_cache, &new_files_list);
+
   for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
        sp != NULL && tp != NULL && err == NULL;
        sp = snext, tp = tnext)
@@ -1671,23 +3298,24 @@ thunar_transfer_job_execute (ExoJob  *job,
                                               thumbnail_cache, &new_files_list, &err))
             break;
         }
-      else if (transfer_job->type == THUNAR_TRANSFER_JOB_COPY)
-        {
-          if (!thunar_transfer_job_collect_node (THUNAR_TRANSFER_JOB (job), node, &err))
-            break;
-        }
-
       g_object_unref (info);
     }
 
+  /* start collecting the source trees of a copy */
+  if (transfer_job->collect_async && err == NULL)
+    {
+      transfer_job->n_nodes_pending = g_list_length (transfer_job->source_node_list);
+      transfer_job->collector = g_thread_new ("ThunarTransferJob", thunar_transfer_job_collect_thread, transfer_job);
+    }
+
   /* release the thumbnail cache */
   g_object_unref (thumbnail_cache);
 
   /* continue if there were no errors yet */
   if (G_LIKELY (err == NULL))
     {
-      /* check destination */
-      if (!thunar_transfer_job_verify_destination (transfer_job, &err))
+      /* check destination, a copy does so once its source tree is collected */
+      if (!transfer_job->collect_async && !thunar_transfer_job_verify_destination (transfer_job, &err))
         {
           if (err != NULL)
             {
@@ -1707,16 +3335,43 @@ thunar_transfer_job_execute (ExoJob  *job,
       if (log_operations && transfer_job->type == THUNAR_TRANSFER_JOB_COPY)
         operation = thunar_job_operation_new (THUNAR_JOB_OPERATION_KIND_COPY);
 
+      /* a copy puts existing targets aside and asks about them at the end */
+      transfer_job->defer_conflicts = (transfer_job->type == THUNAR_TRANSFER_JOB_COPY);
+
       /* perform the copy recursively for all source transfer nodes */
+      trace_begin = THUNAR_TRACE_BEGIN ();
       for (sp = transfer_job->source_node_list, tp = transfer_job->target_file_list;
            sp != NULL && tp != NULL && err == NULL;
            sp = sp->next, tp = tp->next)
         {
+          n_conflicts = g_queue_get_length (&transfer_job->conflicts);
           thunar_transfer_job_copy_node (transfer_job, operation, sp->data, tp->data, NULL,
                                          &new_files_list, &err);
+
+          /* a source with deferred conflicts is not done yet */
+          if (err == NULL && transfer_job->type == THUNAR_TRANSFER_JOB_COPY
+              && g_queue_get_length (&transfer_job->conflicts) == n_conflicts)
+            thunar_transfer_job_journal_checkpoint (transfer_job, ((ThunarTransferNode *) sp->data)->source_file);
         }
+
+      if (G_LIKELY (err == NULL))
+        thunar_transfer_job_resolve_conflicts (transfer_job, operation, &err);
+      THUNAR_TRACE_MARK (trace_begin, "transfer-job", "%u files, %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " bytes",
+                         g_list_length (transfer_job->source_node_list),
+                         transfer_job->total_progress, transfer_job->total_size);
+    }
+
+  /* stop the collector if the copy ended early */
+  if (transfer_job->collector != NULL)
+    {
+      g_atomic_int_set (&transfer_job->collect_stop, TRUE);
+      g_thread_join (transfer_job->collector);
+      transfer_job->collector = NULL;
     }
 
+  /* pass the remaining thumbnail updates on */
+  thunar_transfer_job_thumbnail_flush (transfer_job);
+
   /* check if we failed */
   if (G_UNLIKELY (err != NULL))
     {
@@ -1759,6 +3414,8 @@ thunar_transfer_node_free (gpointer data)
 
       /* drop the source file of this node */
       g_object_unref (node->source_file);
+      g_clear_object (&node->pooled_target);
+      g_clear_object (&node->deferred_info);
 
       /* release the resources of this node */
       g_slice_free (ThunarTransferNode, node);
@@ -1819,6 +3476,154 @@ thunar_transfer_job_new (GList                *source_node_list,
 
 
 
+/**
+ * thunar_transfer_job_new_from_journals:
+ *
+ * Loads the journals of the copies and moves that an earlier instance
+ * did not finish, because it crashed or the session ended, and creates
+ * a job for each of them. A copy leaves out its sources that were done
+ * completely, partially copied files are taken up by the resume of the
+ * "misc-transfer-resume-partial" preference.
+ *
+ * The jobs keep the conflict policy of the interrupted transfer, but
+ * one that asked about every conflict skips the identical targets now,
+ * which are mostly the ones copied before the interruption.
+ *
+ * Return value: the list of #ThunarJob<!---->s to launch, free with
+ *               thunar_g_list_free_full().
+ **/
+GList *
+thunar_transfer_job_new_from_journals (void)
+{
+  ThunarTransferConflictPolicy policy;
+  ThunarTransferJobType        type;
+  ThunarTransferJob           *job;
+  const gchar                 *name;
+  GHashTable                  *done;
+  GList                       *job_list = NULL;
+  GList                       *source_file_list;
+  GList                       *target_file_list;
+  gchar                      **fields;
+  gchar                      **lines;
+  gchar                       *contents;
+  gchar                       *filename;
+  gchar                       *dirname;
+  GDir                        *dir;
+  glong                        pid;
+  gint                         valid;
+  guint                        n;
+
+  dirname = thunar_transfer_job_journal_dir ();
+  if (G_UNLIKELY (dirname == NULL))
+    return NULL;
+
+  dir = g_dir_open (dirname, 0, NULL);
+  if (G_UNLIKELY (dir == NULL))
+    {
+      g_free (dirname);
+      return NULL;
+    }
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      /* journals are named <pid>-<serial>, skip those of running instances */
+      pid = strtol (name, NULL, 10);
+      if (pid <= 0 || pid == getpid () || kill ((pid_t) pid, 0) == 0 || errno != ESRCH)
+        continue;
+
+      filename = g_build_filename (dirname, name, NULL);
+      if (!g_file_get_contents (filename, &contents, NULL, NULL))
+        {
+          g_free (filename);
+          continue;
+        }
+
+      type = THUNAR_TRANSFER_JOB_COPY;
+      policy = THUNAR_TRANSFER_CONFLICT_POLICY_ASK;
+      valid = 0;
+      source_file_list = NULL;
+      target_file_list = NULL;
+      done = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+      /* the header and the sources that were done, which follow the files */
+      lines = g_strsplit (contents, "\n", -1);
+      for (n = 0; lines[n] != NULL; ++n)
+        {
+          fields = g_strsplit (lines[n], "\t", 3);
+          if (g_strv_length (fields) == 2)
+            {
+              if (strcmp (fields[0], "type") == 0)
+                {
+                  type = (strcmp (fields[1], "move") == 0) ? THUNAR_TRANSFER_JOB_MOVE : THUNAR_TRANSFER_JOB_COPY;
+                  valid |= 1;
+                }
+              else if (strcmp (fields[0], "policy") == 0)
+                {
+                  policy = CLAMP (strtol (fields[1], NULL, 10),
+                                  THUNAR_TRANSFER_CONFLICT_POLICY_ASK,
+                                  THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL);
+                  valid |= 2;
+                }
+              else if (strcmp (fields[0], "done") == 0)
+                {
+                  g_hash_table_add (done, g_strdup (fields[1]));
+                }
+            }
+          g_strfreev (fields);
+        }
+
+      for (n = 0; valid == 3 && lines[n] != NULL; ++n)
+        {
+          fields = g_strsplit (lines[n], "\t", 3);
+          if (g_strv_length (fields) == 3 && strcmp (fields[0], "file") == 0
+              && !g_hash_table_contains (done, fields[1]))
+            {
+              source_file_list = g_list_prepend (source_file_list, g_file_new_for_uri (fields[1]));
+              target_file_list = g_list_prepend (target_file_list, g_file_new_for_uri (fields[2]));
+            }
+          g_strfreev (fields);
+        }
+
+      g_strfreev (lines);
+      g_hash_table_unref (done);
+      g_free (contents);
+
+      if (source_file_list != NULL)
+        {
+          source_file_list = g_list_reverse (source_file_list);
+          target_file_list = g_list_reverse (target_file_list);
+
+          job = THUNAR_TRANSFER_JOB (thunar_transfer_job_new (source_file_list, target_file_list, type));
+          thunar_job_set_pausable (THUNAR_JOB (job), TRUE);
+
+          if (policy == THUNAR_TRANSFER_CONFLICT_POLICY_ASK)
+            policy = THUNAR_TRANSFER_CONFLICT_POLICY_SKIP_IDENTICAL;
+          job->conflict_policy = policy;
+
+          /* the job removes the journal once it is done */
+          job->journal = filename;
+          job->journal_resumed = TRUE;
+
+          job_list = g_list_append (job_list, job);
+
+          thunar_g_list_free_full (source_file_list);
+          thunar_g_list_free_full (target_file_list);
+        }
+      else
+        {
+          /* nothing left to do */
+          g_unlink (filename);
+          g_free (filename);
+        }
+    }
+
+  g_dir_close (dir);
+  g_free (dirname);
+
+  return job_list;
+}
+
+
 gchar *
 thunar_transfer_job_get_status (ThunarTransferJob *job)
 {
@@ -55,6 +55,8 @@ ThunarJob *thunar_transfer_job_new        (GList                *source_file_lis
                                            GList                *target_file_list,
                                            ThunarTransferJobType type) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+GList     *thunar_transfer_job_new_from_journals (void) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
 gchar     *thunar_transfer_job_get_status (ThunarTransferJob    *job);
 
 gboolean   thunar_transfer_job_can_start  (ThunarTransferJob *transfer_job,
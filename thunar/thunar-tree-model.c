@@ -48,6 +48,10 @@
                                       && node->children->data == NULL \
                                       && node->children->next == NULL)
 
+/* batches of up to this many new folders are inserted at their
+ * sorted position, larger batches are sorted once at the end */
+#define THUNAR_TREE_MODEL_SORTED_INSERT_MAX 32
+
 
 
 /* Property identifiers */
@@ -111,6 +115,13 @@ static gint                 thunar_tree_model_cmp_array               (gconstpoi
                                                                        gpointer                user_data);
 static void                 thunar_tree_model_sort                    (ThunarTreeModel        *model,
                                                                        GNode                  *node);
+static GNode               *thunar_tree_model_sorted_sibling          (ThunarTreeModel        *model,
+                                                                       GNode                  *node,
+                                                                       ThunarFile             *file);
+static void                 thunar_tree_model_insert_child            (ThunarTreeModel        *model,
+                                                                       GNode                  *node,
+                                                                       ThunarFile             *file,
+                                                                       gboolean                sorted);
 static gboolean             thunar_tree_model_cleanup_idle            (gpointer                user_data);
 static void                 thunar_tree_model_cleanup_idle_destroy    (gpointer                user_data);
 static void                 thunar_tree_model_file_changed            (ThunarFileMonitor      *file_monitor,
@@ -135,6 +146,10 @@ static ThunarTreeModelItem *thunar_tree_model_item_new_with_device    (ThunarTre
                                                                        ThunarDevice           *device) G_GNUC_MALLOC;
 static void                 thunar_tree_model_item_free               (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_reset              (ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_set_node           (ThunarTreeModelItem    *item,
+                                                                       GNode                  *node);
+static void                 thunar_tree_model_item_index              (ThunarTreeModelItem    *item);
+static void                 thunar_tree_model_item_unindex            (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_load_folder        (ThunarTreeModelItem    *item);
 static void                 thunar_tree_model_item_files_added        (ThunarTreeModelItem    *item,
                                                                        GList                  *files,
@@ -153,8 +168,8 @@ static void                 thunar_tree_model_node_drop_dummy         (GNode
                                                                        ThunarTreeModel        *model);
 static gboolean             thunar_tree_model_node_traverse_cleanup   (GNode                  *node,
                                                                        gpointer                user_data);
-static gboolean             thunar_tree_model_node_traverse_changed   (GNode                  *node,
-                                                                       gpointer                user_data);
+static void                 thunar_tree_model_node_changed            (GNode                  *node,
+                                                                       ThunarTreeModel        *model);
 static gboolean             thunar_tree_model_node_traverse_remove    (GNode                  *node,
                                                                        gpointer                user_data);
 static gboolean             thunar_tree_model_node_traverse_sort      (GNode                  *node,
@@ -203,6 +218,9 @@ struct _ThunarTreeModel
   GNode                      *file_system;
   GNode                      *network;
 
+  /* maps each ThunarFile to the GSList of items showing it */
+  GHashTable                 *file_items;
+
   guint                       cleanup_idle_id;
 };
 
@@ -215,6 +233,9 @@ struct _ThunarTreeModelItem
   ThunarDevice    *device;
   ThunarTreeModel *model;
 
+  /* the node holding the item */
+  GNode           *node;
+
   /* list of children of this node that are
    * not visible in the treeview */
   GSList          *invisible_children;
@@ -309,6 +330,7 @@ thunar_tree_model_init (ThunarTreeModel *model)
 
   /* allocate the "virtual root node" */
   model->root = g_node_new (NULL);
+  model->file_items = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   /* initialize references to certain toplevel nodes */
   model->file_system = NULL;
@@ -357,6 +379,7 @@ thunar_tree_model_init (ThunarTreeModel *model)
           /* create and append the new node */
           item = thunar_tree_model_item_new_with_file (model, file);
           node = g_node_append_data (model->root, item);
+          thunar_tree_model_item_set_node (item, node);
 
           /* store reference to the "File System" node */
           if (thunar_file_has_uri_scheme (file, "file") && thunar_file_is_root (file))
@@ -407,6 +430,7 @@ thunar_tree_model_finalize (GObject *object)
   /* release all resources allocated to the model */
   g_node_traverse (model->root, G_POST_ORDER, G_TRAVERSE_ALL, -1, thunar_tree_model_node_traverse_free, NULL);
   g_node_destroy (model->root);
+  g_hash_table_destroy (model->file_items);
 
   /* disconnect from the volume monitor */
   g_signal_handlers_disconnect_matched (model->device_monitor, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, model);
@@ -935,6 +959,56 @@ thunar_tree_model_sort (ThunarTreeModel *model,
 
 
 
+static GNode*
+thunar_tree_model_sorted_sibling (ThunarTreeModel *model,
+                                  GNode           *node,
+                                  ThunarFile      *file)
+{
+  GNode  **children;
+  GNode   *child_node;
+  GNode   *sibling;
+  guint    n_children;
+  guint    lower;
+  guint    upper;
+  guint    n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TREE_MODEL (model), NULL);
+
+  n_children = g_node_n_children (node);
+  if (G_UNLIKELY (n_children == 0))
+    return NULL;
+
+  /* be sure to not overuse the stack */
+  if (G_LIKELY (n_children < 500))
+    children = g_newa (GNode *, n_children);
+  else
+    children = g_new (GNode *, n_children);
+
+  for (child_node = g_node_first_child (node), n = 0; n < n_children; child_node = g_node_next_sibling (child_node), ++n)
+    children[n] = child_node;
+
+  /* binary search for the first child sorting after the file, the
+   * children are sorted, so this only needs a few comparisons */
+  for (lower = 0, upper = n_children; lower < upper; )
+    {
+      n = lower + (upper - lower) / 2;
+      if (thunar_file_compare_by_name (file, THUNAR_TREE_MODEL_ITEM (children[n]->data)->file, model->sort_case_sensitive) < 0)
+        upper = n;
+      else
+        lower = n + 1;
+    }
+
+  sibling = (lower < n_children) ? children[lower] : NULL;
+
+  /* cleanup if we used the heap */
+  if (G_UNLIKELY (n_children >= 500))
+    g_free (children);
+
+  return sibling;
+}
+
+
+
 static gboolean
 thunar_tree_model_cleanup_idle (gpointer user_data)
 {
@@ -966,14 +1040,23 @@ thunar_tree_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarFile        *file,
                                 ThunarTreeModel   *model)
 {
+  GSList *items;
+  GSList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
   _thunar_return_if_fail (model->file_monitor == file_monitor);
   _thunar_return_if_fail (THUNAR_IS_TREE_MODEL (model));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  /* traverse the model and emit "row-changed" for the file's nodes */
-  if (thunar_file_is_directory (file))
-    g_node_traverse (model->root, G_PRE_ORDER, G_TRAVERSE_ALL, -1, thunar_tree_model_node_traverse_changed, file);
+  if (!thunar_file_is_directory (file))
+    return;
+
+  /* emit "row-changed" for the file's nodes, the handlers
+   * may alter the tree, so work on a copy of the list */
+  items = g_slist_copy (g_hash_table_lookup (model->file_items, file));
+  for (lp = items; lp != NULL; lp = lp->next)
+    thunar_tree_model_node_changed (THUNAR_TREE_MODEL_ITEM (lp->data)->node, model);
+  g_slist_free (items);
 }
 
 
@@ -1014,6 +1097,7 @@ thunar_tree_model_device_changed (ThunarDeviceMonitor *device_monitor,
         {
           /* try to determine the file for the mount point */
           item->file = thunar_file_get (mount_point, NULL);
+          thunar_tree_model_item_index (item);
 
           /* because the volume node is already reffed, we need to load the folder manually here */
           thunar_tree_model_item_load_folder (item);
@@ -1122,6 +1206,7 @@ thunar_tree_model_device_added (ThunarDeviceMonitor *device_monitor,
 
   /* insert the new node */
   node = g_node_insert_data_after (model->root, node, item);
+  thunar_tree_model_item_set_node (item, node);
 
   /* determine the iterator for the new node */
   GTK_TREE_ITER_INIT (iter, model->stamp, node);
@@ -1248,6 +1333,8 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
   /* disconnect from the file */
   if (G_LIKELY (item->file != NULL))
     {
+      thunar_tree_model_item_unindex (item);
+
       /* unwatch the trash */
       if (thunar_file_is_trash (item->file))
         thunar_file_unwatch (item->file);
@@ -1260,6 +1347,52 @@ thunar_tree_model_item_reset (ThunarTreeModelItem *item)
 
 
 
+static void
+thunar_tree_model_item_set_node (ThunarTreeModelItem *item,
+                                 GNode               *node)
+{
+  _thunar_return_if_fail (item->node == NULL);
+  _thunar_return_if_fail (node->data == item);
+
+  /* remember the node, so the item never has to search the tree */
+  item->node = node;
+  thunar_tree_model_item_index (item);
+}
+
+
+
+static void
+thunar_tree_model_item_index (ThunarTreeModelItem *item)
+{
+  GSList *items;
+
+  /* only items shown in the tree are indexed */
+  if (item->file == NULL || item->node == NULL)
+    return;
+
+  items = g_hash_table_lookup (item->model->file_items, item->file);
+  g_hash_table_insert (item->model->file_items, item->file, g_slist_prepend (items, item));
+}
+
+
+
+static void
+thunar_tree_model_item_unindex (ThunarTreeModelItem *item)
+{
+  GSList *items;
+
+  if (item->file == NULL || item->node == NULL)
+    return;
+
+  items = g_slist_remove (g_hash_table_lookup (item->model->file_items, item->file), item);
+  if (items != NULL)
+    g_hash_table_insert (item->model->file_items, item->file, items);
+  else
+    g_hash_table_remove (item->model->file_items, item->file);
+}
+
+
+
 static void
 thunar_tree_model_item_load_folder (ThunarTreeModelItem *item)
 {
@@ -1282,12 +1415,20 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
 {
   ThunarTreeModel     *model = THUNAR_TREE_MODEL (item->model);
   ThunarFile          *file;
-  GNode               *node = NULL;
+  GNode               *node = item->node;
   GList               *lp;
+  gboolean             sorted;
+  gboolean             needs_sort = FALSE;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (item->folder == folder);
   _thunar_return_if_fail (model->visible_func != NULL);
+  _thunar_return_if_fail (node != NULL);
+
+  /* insert a few folders between the sorted children right away, a
+   * full sort (and reorder of the view) is only worth it for bulk loads */
+  sorted = (node->children != NULL && !G_NODE_HAS_DUMMY (node)
+            && g_list_length (files) <= THUNAR_TREE_MODEL_SORTED_INSERT_MAX);
 
   /* process all specified files */
   for (lp = files; lp != NULL; lp = lp->next)
@@ -1306,16 +1447,12 @@ thunar_tree_model_item_files_added (ThunarTreeModelItem *item,
           continue;
         }
 
-      /* lookup the node for the item (on-demand) */
-      if (G_UNLIKELY (node == NULL))
-        node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
-      _thunar_return_if_fail (node != NULL);
-
-      thunar_tree_model_add_child (model, node, file);
+      thunar_tree_model_insert_child (model, node, file, sorted);
+      needs_sort = !sorted;
     }
 
-  /* sort the folders if any new ones were added */
-  if (G_LIKELY (node != NULL))
+  /* sort the folders if any new ones were appended */
+  if (needs_sort)
     thunar_tree_model_sort (model, node);
 }
 
@@ -1338,7 +1475,7 @@ thunar_tree_model_item_files_removed (ThunarTreeModelItem *item,
   _thunar_return_if_fail (item->folder == folder);
 
   /* determine the node for the folder */
-  node = g_node_find (model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+  node = item->node;
   _thunar_return_if_fail (node != NULL);
 
   /* check if the node has any visible children */
@@ -1406,7 +1543,7 @@ thunar_tree_model_item_notify_loading (ThunarTreeModelItem *item,
   if (G_LIKELY (!thunar_folder_get_loading (folder)))
     {
       /* lookup the node for the item... */
-      node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+      node = item->node;
       _thunar_return_if_fail (node != NULL);
 
       /* ...and drop the dummy for the node */
@@ -1422,7 +1559,9 @@ thunar_tree_model_item_load_idle (gpointer user_data)
 {
   ThunarTreeModelItem *item = user_data;
   GFile               *mount_point;
-  GList               *files;
+  GPtrArray           *folder_files;
+  GList               *files = NULL;
+  guint                n;
 #ifndef NDEBUG
   GNode               *node;
 #endif
@@ -1431,7 +1570,7 @@ thunar_tree_model_item_load_idle (gpointer user_data)
 
 #ifndef NDEBUG
       /* find the node in the tree */
-      node = g_node_find (item->model->root, G_POST_ORDER, G_TRAVERSE_ALL, item);
+      node = item->node;
 
       /* debug check to make sure the node is empty or contains a dummy node.
        * if this is not true, the node already contains sub folders which means
@@ -1449,6 +1588,7 @@ THUNAR_THREADS_ENTER
         {
           /* try to determine the file for the mount point */
           item->file = thunar_file_get (mount_point, NULL);
+          thunar_tree_model_item_index (item);
           g_object_unref (mount_point);
         }
     }
@@ -1456,8 +1596,8 @@ THUNAR_THREADS_ENTER
   /* verify that we have a file */
   if (G_LIKELY (item->file != NULL))
     {
-      /* open the folder for the item */
-      item->folder = thunar_folder_get_for_file (item->file);
+      /* open the folder for the item, only its sub folders are shown */
+      item->folder = thunar_folder_get_folders_for_file (item->file);
       if (G_LIKELY (item->folder != NULL))
         {
           /* connect signals */
@@ -1466,9 +1606,12 @@ THUNAR_THREADS_ENTER
           g_signal_connect_swapped (G_OBJECT (item->folder), "notify::loading", G_CALLBACK (thunar_tree_model_item_notify_loading), item);
 
           /* load the initial set of files (if any) */
-          files = thunar_folder_get_files (item->folder);
+          folder_files = thunar_folder_get_files (item->folder);
+          for (n = folder_files->len; n > 0; --n)
+            files = g_list_prepend (files, g_ptr_array_index (folder_files, n - 1));
           if (G_UNLIKELY (files != NULL))
             thunar_tree_model_item_files_added (item, files, item->folder);
+          g_list_free (files);
 
           /* notify for "loading" if already loaded */
           if (!thunar_folder_get_loading (item->folder))
@@ -1583,47 +1726,31 @@ thunar_tree_model_node_traverse_cleanup (GNode    *node,
 
 
 
-static gboolean
-thunar_tree_model_node_traverse_changed (GNode   *node,
-                                         gpointer user_data)
+static void
+thunar_tree_model_node_changed (GNode           *node,
+                                ThunarTreeModel *model)
 {
-  ThunarTreeModel     *model;
-  GtkTreePath         *path;
-  GtkTreeIter          iter;
-  ThunarFile          *file = THUNAR_FILE (user_data);
-  ThunarTreeModelItem *item = THUNAR_TREE_MODEL_ITEM (node->data);
-
-  /* check if the node's file is the file that changed */
-  if (G_UNLIKELY (item != NULL && item->file == file))
-    {
-      /* determine the tree model from the item */
-      model = THUNAR_TREE_MODEL_ITEM (node->data)->model;
-
-      /* determine the iterator for the node */
-      GTK_TREE_ITER_INIT (iter, model->stamp, node);
-
-      /* check if the changed node is not one of the root nodes */
-      if (G_LIKELY (node->parent != model->root))
-        {
-          /* need to re-sort as the name of the file may have changed */
-          thunar_tree_model_sort (model, node->parent);
-        }
+  GtkTreePath *path;
+  GtkTreeIter  iter;
 
-      /* determine the path for the node */
-      path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
-      if (G_LIKELY (path != NULL))
-        {
-          /* emit "row-changed" */
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
-          gtk_tree_path_free (path);
-        }
+  /* determine the iterator for the node */
+  GTK_TREE_ITER_INIT (iter, model->stamp, node);
 
-      /* stop traversing */
-      return TRUE;
+  /* check if the changed node is not one of the root nodes */
+  if (G_LIKELY (node->parent != model->root))
+    {
+      /* need to re-sort as the name of the file may have changed */
+      thunar_tree_model_sort (model, node->parent);
     }
 
-  /* continue traversing */
-  return FALSE;
+  /* determine the path for the node */
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), &iter);
+  if (G_LIKELY (path != NULL))
+    {
+      /* emit "row-changed" */
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+      gtk_tree_path_free (path);
+    }
 }
 
 
@@ -1751,6 +1878,7 @@ thunar_tree_model_node_traverse_visible (GNode    *node,
 
                   /* insert a new node for the child */
                   child_node = g_node_append_data (node, child);
+                  thunar_tree_model_item_set_node (child, child_node);
 
                   /* determine the tree iter for the child */
                   GTK_TREE_ITER_INIT (iter, model->stamp, child_node);
@@ -1918,19 +2046,11 @@ thunar_tree_model_node_has_dummy (ThunarTreeModel *model,
 
 
 
-/**
- * thunar_tree_model_add_child:
- * @model : a #ThunarTreeModel.
- * @node : GNode to add a child
- * @file : #ThunarFile to be added
- *
- * Creates a new #ThunarTreeModelItem as a child of @node and stores a reference to the passed @file
- * Automatically creates/removes dummy items if required
- **/
-void
-thunar_tree_model_add_child (ThunarTreeModel *model,
-                             GNode           *node,
-                             ThunarFile      *file)
+static void
+thunar_tree_model_insert_child (ThunarTreeModel *model,
+                                GNode           *node,
+                                ThunarFile      *file,
+                                gboolean         sorted)
 {
   ThunarTreeModelItem *child_item;
   GNode               *child_node;
@@ -1949,6 +2069,7 @@ thunar_tree_model_add_child (ThunarTreeModel *model,
       /* replace the dummy node with the new node */
       child_node = g_node_first_child (node);
       child_node->data = child_item;
+      thunar_tree_model_item_set_node (child_item, child_node);
 
       /* determine the tree iter for the child */
       GTK_TREE_ITER_INIT (child_iter, model->stamp, child_node);
@@ -1960,8 +2081,12 @@ thunar_tree_model_add_child (ThunarTreeModel *model,
     }
   else
     {
-      /* insert a new item for the child */
-      child_node = g_node_append_data (node, child_item);
+      /* insert a new item for the child, either at its sorted position or at the end */
+      if (sorted)
+        child_node = g_node_insert_data_before (node, thunar_tree_model_sorted_sibling (model, node, file), child_item);
+      else
+        child_node = g_node_append_data (node, child_item);
+      thunar_tree_model_item_set_node (child_item, child_node);
 
       /* determine the tree iter for the child */
       GTK_TREE_ITER_INIT (child_iter, model->stamp, child_node);
@@ -1985,3 +2110,22 @@ thunar_tree_model_default_visiblity (ThunarTreeModel *model,
 {
   return TRUE;
 }
+
+
+
+/**
+ * thunar_tree_model_add_child:
+ * @model : a #ThunarTreeModel.
+ * @node : GNode to add a child
+ * @file : #ThunarFile to be added
+ *
+ * Creates a new #ThunarTreeModelItem as a child of @node and stores a reference to the passed @file
+ * Automatically creates/removes dummy items if required
+ **/
+void
+thunar_tree_model_add_child (ThunarTreeModel *model,
+                             GNode           *node,
+                             ThunarFile      *file)
+{
+  thunar_tree_model_insert_child (model, node, file, FALSE);
+}
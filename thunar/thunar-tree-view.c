@@ -1718,7 +1718,7 @@ THUNAR_THREADS_ENTER
       file = THUNAR_FILE (lp->data);
 
       /* 3. Check if the contents of the corresponding folder is still being loaded */
-      folder = thunar_folder_get_for_file (file);
+      folder = thunar_folder_get_folders_for_file (file);
       if (folder != NULL && thunar_folder_get_loading (folder))
         {
           g_object_unref (folder);
@@ -27,6 +27,9 @@
 #include <sys/types.h>
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 #ifdef HAVE_GRP_H
 #include <grp.h>
 #endif
@@ -46,7 +49,7 @@
 #include <unistd.h>
 #endif
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 #include <exo/exo.h>
 
@@ -57,14 +60,20 @@
 
 
 
-/* the interval in which the user/group cache is flushed (in seconds) */
+/* the interval in which the user/group cache is revalidated (in seconds) */
 #define THUNAR_USER_MANAGER_FLUSH_INTERVAL (10 * 60)
 
 
 
+static gboolean     thunar_user_manager_group_pending (guint32 gid);
+static gboolean     thunar_user_manager_user_pending  (guint32 uid);
+
+
 
 static void         thunar_group_finalize   (GObject          *object);
 static ThunarGroup *thunar_group_new        (guint32           id);
+static gboolean     thunar_group_update     (ThunarGroup      *group,
+                                             const gchar      *gr_name);
 
 
 
@@ -79,6 +88,7 @@ struct _ThunarGroup
 
   guint32 id;
   gchar  *name;
+  guint   resolved : 1;
 };
 
 
@@ -131,6 +141,30 @@ thunar_group_new (guint32 id)
 
 
 
+static gboolean
+thunar_group_update (ThunarGroup *group,
+                     const gchar *gr_name)
+{
+  gboolean changed;
+  gchar   *name;
+
+  if (G_LIKELY (gr_name != NULL))
+    name = g_strdup (gr_name);
+  else
+    name = g_strdup_printf ("%u", (guint) group->id);
+
+  /* only report changes of names that were already handed out */
+  changed = (group->name != NULL && strcmp (group->name, name) != 0);
+
+  g_free (group->name);
+  group->name = name;
+  group->resolved = TRUE;
+
+  return changed;
+}
+
+
+
 /**
  * thunar_group_get_id:
  * @group : a #ThunarGroup.
@@ -166,13 +200,20 @@ thunar_group_get_name (ThunarGroup *group)
   g_return_val_if_fail (THUNAR_IS_GROUP (group), NULL);
 
   /* determine the name on-demand */
-  if (G_UNLIKELY (group->name == NULL))
+  if (G_UNLIKELY (!group->resolved))
     {
-      grp = getgrgid (group->id);
-      if (G_LIKELY (grp != NULL))
-        group->name = g_strdup (grp->gr_name);
+      /* while a background lookup for the group is running,
+       * show the group id instead of blocking on the lookup */
+      if (thunar_user_manager_group_pending (group->id))
+        {
+          if (group->name == NULL)
+            group->name = g_strdup_printf ("%u", (guint) group->id);
+        }
       else
-        group->name = g_strdup_printf ("%u", (guint) group->id);
+        {
+          grp = getgrgid (group->id);
+          thunar_group_update (group, (grp != NULL) ? grp->gr_name : NULL);
+        }
     }
 
   return group->name;
@@ -182,6 +223,11 @@ thunar_group_get_name (ThunarGroup *group)
 
 static void        thunar_user_finalize          (GObject         *object);
 static void        thunar_user_load              (ThunarUser      *user);
+static void        thunar_user_resolve           (ThunarUser      *user);
+static gboolean    thunar_user_update            (ThunarUser      *user,
+                                                  const gchar     *pw_name,
+                                                  const gchar     *pw_gecos,
+                                                  guint32          pw_gid);
 static ThunarUser *thunar_user_new               (guint32          id);
 static ThunarGroup*thunar_user_get_primary_group (ThunarUser      *user);
 
@@ -200,6 +246,7 @@ struct _ThunarUser
   guint32      id;
   gchar       *name;
   gchar       *real_name;
+  guint        resolved : 1;
 };
 
 
@@ -259,53 +306,113 @@ thunar_user_finalize (GObject *object)
 
 static void
 thunar_user_load (ThunarUser *user)
+{
+  g_return_if_fail (!user->resolved);
+
+  /* while a background lookup for the user is running,
+   * show the user id instead of blocking on the lookup */
+  if (thunar_user_manager_user_pending (user->id))
+    {
+      if (user->name == NULL)
+        user->name = g_strdup_printf ("%u", (guint) user->id);
+    }
+  else
+    {
+      thunar_user_resolve (user);
+    }
+}
+
+
+
+static void
+thunar_user_resolve (ThunarUser *user)
+{
+  struct passwd *pw;
+
+  pw = getpwuid (user->id);
+  if (G_LIKELY (pw != NULL))
+    thunar_user_update (user, pw->pw_name, pw->pw_gecos, pw->pw_gid);
+  else
+    thunar_user_update (user, NULL, NULL, 0);
+}
+
+
+
+static gboolean
+thunar_user_update (ThunarUser  *user,
+                    const gchar *pw_name,
+                    const gchar *pw_gecos,
+                    guint32      pw_gid)
 {
   ThunarUserManager *manager;
-  struct passwd     *pw;
+  ThunarGroup       *primary_group = NULL;
   const gchar       *s;
+  gchar             *real_name = NULL;
+  gchar             *account;
   gchar             *name;
   gchar             *t;
+  gboolean           changed;
 
-  g_return_if_fail (user->name == NULL);
-
-  pw = getpwuid (user->id);
-  if (G_LIKELY (pw != NULL))
+  if (G_LIKELY (pw_name != NULL))
     {
       manager = thunar_user_manager_get_default ();
 
       /* query name and primary group */
-      user->name = g_strdup (pw->pw_name);
-      user->primary_group = thunar_user_manager_get_group_by_id (manager, pw->pw_gid);
+      name = g_strdup (pw_name);
+      primary_group = thunar_user_manager_get_group_by_id (manager, pw_gid);
 
       /* try to figure out the real name */
-      s = strchr (pw->pw_gecos, ',');
+      s = strchr (pw_gecos, ',');
       if (s != NULL)
-        user->real_name = g_strndup (pw->pw_gecos, s - pw->pw_gecos);
-      else if (pw->pw_gecos[0] != '\0')
-        user->real_name = g_strdup (pw->pw_gecos);
+        real_name = g_strndup (pw_gecos, s - pw_gecos);
+      else if (pw_gecos[0] != '\0')
+        real_name = g_strdup (pw_gecos);
 
       /* substitute '&' in the real_name with the account name */
-      if (G_LIKELY (user->real_name != NULL && strchr (user->real_name, '&') != NULL))
+      if (G_LIKELY (real_name != NULL && strchr (real_name, '&') != NULL))
         {
           /* generate a version of the username with the first char upper'd */
-          name = g_strdup (user->name);
-          name[0] = g_ascii_toupper (name[0]);
+          account = g_strdup (name);
+          account[0] = g_ascii_toupper (account[0]);
 
           /* replace all occurances of '&' */
-          t = xfce_str_replace (user->real_name, "&", name);
-          g_free (user->real_name);
-          user->real_name = t;
+          t = xfce_str_replace (real_name, "&", account);
+          g_free (real_name);
+          real_name = t;
 
           /* clean up */
-          g_free (name);
+          g_free (account);
         }
 
       g_object_unref (G_OBJECT (manager));
     }
   else
     {
-      user->name = g_strdup_printf ("%u", (guint) user->id);
+      name = g_strdup_printf ("%u", (guint) user->id);
     }
+
+  /* only report changes of names that were already handed out */
+  changed = (user->name != NULL
+             && (strcmp (user->name, name) != 0 || g_strcmp0 (user->real_name, real_name) != 0));
+
+  /* the groups list starts with the primary group, so reload it on-demand */
+  if (G_UNLIKELY (user->resolved && user->primary_group != primary_group))
+    {
+      g_list_free_full (user->groups, g_object_unref);
+      user->groups = NULL;
+    }
+
+  if (user->primary_group != NULL)
+    g_object_unref (G_OBJECT (user->primary_group));
+  user->primary_group = primary_group;
+
+  g_free (user->real_name);
+  user->real_name = real_name;
+  g_free (user->name);
+  user->name = name;
+  user->resolved = TRUE;
+
+  return changed;
 }
 
 
@@ -327,9 +434,10 @@ thunar_user_get_primary_group (ThunarUser *user)
 {
   g_return_val_if_fail (THUNAR_IS_USER (user), NULL);
 
-  /* load the user data on-demand */
-  if (G_UNLIKELY (user->name == NULL))
-    thunar_user_load (user);
+  /* the groups are cached, so don't settle for the placeholder
+   * of a background lookup here */
+  if (G_UNLIKELY (!user->resolved))
+    thunar_user_resolve (user);
 
   return user->primary_group;
 }
@@ -417,7 +525,7 @@ thunar_user_get_name (ThunarUser *user)
   g_return_val_if_fail (THUNAR_IS_USER (user), 0);
 
   /* load the user's data on-demand */
-  if (G_UNLIKELY (user->name == NULL))
+  if (G_UNLIKELY (!user->resolved))
     thunar_user_load (user);
 
   return user->name;
@@ -441,7 +549,7 @@ thunar_user_get_real_name (ThunarUser *user)
   g_return_val_if_fail (THUNAR_IS_USER (user), 0);
 
   /* load the user's data on-demand */
-  if (G_UNLIKELY (user->name == NULL))
+  if (G_UNLIKELY (!user->resolved))
     thunar_user_load (user);
 
   return user->real_name;
@@ -469,9 +577,52 @@ thunar_user_is_me (ThunarUser *user)
 
 
 
+enum
+{
+  CHANGED,
+  LAST_SIGNAL,
+};
+
+
+
+typedef struct
+{
+  guint32  id;
+  gchar   *name;
+} ThunarGroupEntry;
+
+typedef struct
+{
+  guint32  id;
+  gchar   *name;
+  gchar   *gecos;
+  guint32  gid;
+} ThunarUserEntry;
+
+typedef struct
+{
+  GArray *groups;
+  GArray *users;
+} ThunarUserLookup;
+
+
+
 static void     thunar_user_manager_finalize            (GObject                *object);
 static gboolean thunar_user_manager_flush_timer         (gpointer                user_data);
 static void     thunar_user_manager_flush_timer_destroy (gpointer                user_data);
+static void     thunar_user_manager_queue_group         (ThunarUserManager      *manager,
+                                                         guint32                 gid);
+static void     thunar_user_manager_queue_user          (ThunarUserManager      *manager,
+                                                         guint32                 uid);
+static gboolean thunar_user_manager_lookup_idle         (gpointer                user_data);
+static void     thunar_user_manager_lookup_thread       (GTask                  *task,
+                                                         gpointer                source_object,
+                                                         gpointer                task_data,
+                                                         GCancellable           *cancellable);
+static void     thunar_user_manager_lookup_done         (GObject                *object,
+                                                         GAsyncResult           *result,
+                                                         gpointer                user_data);
+static void     thunar_user_manager_lookup_free         (gpointer                data);
 
 
 
@@ -487,11 +638,26 @@ struct _ThunarUserManager
   GHashTable *groups;
   GHashTable *users;
 
+  /* the ids queued for or running in a background lookup, the
+   * entities are kept for the whole session and only revalidated
+   * in the background every THUNAR_USER_MANAGER_FLUSH_INTERVAL
+   */
+  GHashTable *pending_groups;
+  GHashTable *pending_users;
+  GArray     *queued_gids;
+  GArray     *queued_uids;
+  guint       lookup_idle_id;
+
   guint       flush_timer_id;
 };
 
 
 
+static ThunarUserManager *user_manager_default;
+static guint              user_manager_signals[LAST_SIGNAL];
+
+
+
 G_DEFINE_TYPE (ThunarUserManager, thunar_user_manager, G_TYPE_OBJECT)
 
 
@@ -503,6 +669,22 @@ thunar_user_manager_class_init (ThunarUserManagerClass *klass)
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = thunar_user_manager_finalize;
+
+  /**
+   * ThunarUserManager::changed:
+   * @manager : the default #ThunarUserManager.
+   *
+   * Emitted when a background lookup changed the name of a
+   * user or group that was handed out before, so views can
+   * redraw the owner and group names.
+   **/
+  user_manager_signals[CHANGED] =
+    g_signal_new (I_("changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_NO_HOOKS,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
 }
 
 
@@ -512,6 +694,10 @@ thunar_user_manager_init (ThunarUserManager *manager)
 {
   manager->groups = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
   manager->users = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
+  manager->pending_groups = g_hash_table_new (g_direct_hash, g_direct_equal);
+  manager->pending_users = g_hash_table_new (g_direct_hash, g_direct_equal);
+  manager->queued_gids = g_array_new (FALSE, FALSE, sizeof (guint32));
+  manager->queued_uids = g_array_new (FALSE, FALSE, sizeof (guint32));
 
   /* keep the groups file in memory if possible */
 #ifdef HAVE_SETGROUPENT
@@ -540,6 +726,14 @@ thunar_user_manager_finalize (GObject *object)
   if (G_LIKELY (manager->flush_timer_id != 0))
     g_source_remove (manager->flush_timer_id);
 
+  /* drop a scheduled lookup (running lookups hold a reference) */
+  if (manager->lookup_idle_id != 0)
+    g_source_remove (manager->lookup_idle_id);
+  g_array_free (manager->queued_gids, TRUE);
+  g_array_free (manager->queued_uids, TRUE);
+  g_hash_table_destroy (manager->pending_groups);
+  g_hash_table_destroy (manager->pending_users);
+
   /* destroy the hash tables */
   g_hash_table_destroy (manager->groups);
   g_hash_table_destroy (manager->users);
@@ -559,22 +753,14 @@ static gboolean
 thunar_user_manager_flush_timer (gpointer user_data)
 {
   ThunarUserManager *manager = THUNAR_USER_MANAGER (user_data);
-  guint              size = 0;
+  GHashTableIter     iter;
+  ThunarGroup       *group;
+  ThunarUser        *user;
 
 THUNAR_THREADS_ENTER
 
-  /* drop all cached groups */
-  size += g_hash_table_foreach_remove (manager->groups,
-                                       (GHRFunc) (void (*)(void)) gtk_true,
-                                       NULL);
-
-  /* drop all cached users */
-  size += g_hash_table_foreach_remove (manager->users,
-                                       (GHRFunc) (void (*)(void)) gtk_true,
-                                       NULL);
-
   /* reload groups and passwd files if we had cached entities */
-  if (G_LIKELY (size > 0))
+  if (g_hash_table_size (manager->groups) + g_hash_table_size (manager->users) > 0)
     {
       endgrent ();
       endpwent ();
@@ -588,6 +774,20 @@ THUNAR_THREADS_ENTER
 #endif
     }
 
+  /* revalidate all cached groups and users in the background, the
+   * old names stay in use until the lookup finished, so this never
+   * blocks on slow name services (i.e. LDAP) in the main thread
+   */
+  g_hash_table_iter_init (&iter, manager->groups);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &group))
+    if (group->resolved)
+      thunar_user_manager_queue_group (manager, group->id);
+
+  g_hash_table_iter_init (&iter, manager->users);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &user))
+    if (user->resolved)
+      thunar_user_manager_queue_user (manager, user->id);
+
 THUNAR_THREADS_LEAVE
 
   return TRUE;
@@ -603,6 +803,257 @@ thunar_user_manager_flush_timer_destroy (gpointer user_data)
 
 
 
+static void
+thunar_user_manager_queue_group (ThunarUserManager *manager,
+                                 guint32            gid)
+{
+  if (g_hash_table_contains (manager->pending_groups, GUINT_TO_POINTER (gid)))
+    return;
+
+  g_hash_table_add (manager->pending_groups, GUINT_TO_POINTER (gid));
+  g_array_append_val (manager->queued_gids, gid);
+
+  /* collect the ids of one main loop iteration in a single lookup,
+   * scheduled before the next redraw to have the names early */
+  if (manager->lookup_idle_id == 0)
+    manager->lookup_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_user_manager_lookup_idle, manager, NULL);
+}
+
+
+
+static void
+thunar_user_manager_queue_user (ThunarUserManager *manager,
+                                guint32            uid)
+{
+  if (g_hash_table_contains (manager->pending_users, GUINT_TO_POINTER (uid)))
+    return;
+
+  g_hash_table_add (manager->pending_users, GUINT_TO_POINTER (uid));
+  g_array_append_val (manager->queued_uids, uid);
+
+  if (manager->lookup_idle_id == 0)
+    manager->lookup_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_user_manager_lookup_idle, manager, NULL);
+}
+
+
+
+static gboolean
+thunar_user_manager_lookup_idle (gpointer user_data)
+{
+  ThunarUserManager *manager = THUNAR_USER_MANAGER (user_data);
+  ThunarGroupEntry   group_entry = { 0, NULL };
+  ThunarUserEntry    user_entry = { 0, NULL, NULL, 0 };
+  ThunarUserLookup  *lookup;
+  GTask             *task;
+  guint              n;
+
+  manager->lookup_idle_id = 0;
+
+  /* hand the queued ids over to the lookup */
+  lookup = g_slice_new (ThunarUserLookup);
+  lookup->groups = g_array_sized_new (FALSE, FALSE, sizeof (ThunarGroupEntry), manager->queued_gids->len);
+  lookup->users = g_array_sized_new (FALSE, FALSE, sizeof (ThunarUserEntry), manager->queued_uids->len);
+
+  for (n = 0; n < manager->queued_gids->len; ++n)
+    {
+      group_entry.id = g_array_index (manager->queued_gids, guint32, n);
+      g_array_append_val (lookup->groups, group_entry);
+    }
+
+  for (n = 0; n < manager->queued_uids->len; ++n)
+    {
+      user_entry.id = g_array_index (manager->queued_uids, guint32, n);
+      g_array_append_val (lookup->users, user_entry);
+    }
+
+  g_array_set_size (manager->queued_gids, 0);
+  g_array_set_size (manager->queued_uids, 0);
+
+  /* resolve the ids in a worker thread */
+  task = g_task_new (manager, NULL, thunar_user_manager_lookup_done, NULL);
+  g_task_set_task_data (task, lookup, thunar_user_manager_lookup_free);
+  g_task_run_in_thread (task, thunar_user_manager_lookup_thread);
+  g_object_unref (task);
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_user_manager_lookup_thread (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  ThunarUserLookup *lookup = task_data;
+  ThunarGroupEntry  group_entry = { 0, NULL };
+  ThunarGroupEntry *group;
+  ThunarUserEntry  *user;
+  struct passwd     pwd;
+  struct passwd    *pw;
+  struct group      grd;
+  struct group     *gr;
+  GHashTable       *gids;
+  gchar            *buffer;
+  gsize             buffer_size = 1024;
+  gint              err;
+  guint             n;
+
+  buffer = g_malloc (buffer_size);
+
+  /* remember the queued groups, so the primary groups of
+   * the users are only added if not looking them up already */
+  gids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (n = 0; n < lookup->groups->len; ++n)
+    g_hash_table_add (gids, GUINT_TO_POINTER (g_array_index (lookup->groups, ThunarGroupEntry, n).id));
+
+  for (n = 0; n < lookup->users->len; ++n)
+    {
+      user = &g_array_index (lookup->users, ThunarUserEntry, n);
+
+      /* only the reentrant versions are safe outside the main thread */
+      while ((err = getpwuid_r (user->id, &pwd, buffer, buffer_size, &pw)) == ERANGE)
+        {
+          buffer_size *= 2;
+          buffer = g_realloc (buffer, buffer_size);
+        }
+
+      if (G_LIKELY (err == 0 && pw != NULL))
+        {
+          user->name = g_strdup (pw->pw_name);
+          user->gecos = g_strdup ((pw->pw_gecos != NULL) ? pw->pw_gecos : "");
+          user->gid = pw->pw_gid;
+
+          /* the primary group will be needed as well */
+          if (!g_hash_table_contains (gids, GUINT_TO_POINTER (pw->pw_gid)))
+            {
+              g_hash_table_add (gids, GUINT_TO_POINTER (pw->pw_gid));
+              group_entry.id = pw->pw_gid;
+              g_array_append_val (lookup->groups, group_entry);
+            }
+        }
+    }
+
+  for (n = 0; n < lookup->groups->len; ++n)
+    {
+      group = &g_array_index (lookup->groups, ThunarGroupEntry, n);
+
+      while ((err = getgrgid_r (group->id, &grd, buffer, buffer_size, &gr)) == ERANGE)
+        {
+          buffer_size *= 2;
+          buffer = g_realloc (buffer, buffer_size);
+        }
+
+      if (G_LIKELY (err == 0 && gr != NULL))
+        group->name = g_strdup (gr->gr_name);
+    }
+
+  g_hash_table_destroy (gids);
+  g_free (buffer);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+
+static void
+thunar_user_manager_lookup_done (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      user_data)
+{
+  ThunarUserManager *manager = THUNAR_USER_MANAGER (object);
+  ThunarUserLookup  *lookup = g_task_get_task_data (G_TASK (result));
+  ThunarGroupEntry  *group_entry;
+  ThunarUserEntry   *user_entry;
+  ThunarGroup       *group;
+  ThunarUser        *user;
+  gboolean           changed = FALSE;
+  guint              n;
+
+  /* apply the groups first, the users refer to their primary group */
+  for (n = 0; n < lookup->groups->len; ++n)
+    {
+      group_entry = &g_array_index (lookup->groups, ThunarGroupEntry, n);
+      g_hash_table_remove (manager->pending_groups, GUINT_TO_POINTER (group_entry->id));
+
+      group = g_hash_table_lookup (manager->groups, GUINT_TO_POINTER (group_entry->id));
+      if (group == NULL)
+        {
+          group = thunar_group_new (group_entry->id);
+          g_hash_table_insert (manager->groups, GUINT_TO_POINTER (group_entry->id), group);
+        }
+
+      if (thunar_group_update (group, group_entry->name))
+        changed = TRUE;
+    }
+
+  for (n = 0; n < lookup->users->len; ++n)
+    {
+      user_entry = &g_array_index (lookup->users, ThunarUserEntry, n);
+      g_hash_table_remove (manager->pending_users, GUINT_TO_POINTER (user_entry->id));
+
+      user = g_hash_table_lookup (manager->users, GUINT_TO_POINTER (user_entry->id));
+      if (user == NULL)
+        {
+          user = thunar_user_new (user_entry->id);
+          g_hash_table_insert (manager->users, GUINT_TO_POINTER (user_entry->id), user);
+        }
+
+      if (thunar_user_update (user, user_entry->name, user_entry->gecos, user_entry->gid))
+        changed = TRUE;
+    }
+
+  /* let the views pick up the names that were shown with
+   * a placeholder or have been changed in the meantime */
+  if (changed)
+    g_signal_emit (manager, user_manager_signals[CHANGED], 0);
+}
+
+
+
+static void
+thunar_user_manager_lookup_free (gpointer data)
+{
+  ThunarUserLookup *lookup = data;
+  ThunarUserEntry  *user_entry;
+  guint             n;
+
+  for (n = 0; n < lookup->groups->len; ++n)
+    g_free (g_array_index (lookup->groups, ThunarGroupEntry, n).name);
+
+  for (n = 0; n < lookup->users->len; ++n)
+    {
+      user_entry = &g_array_index (lookup->users, ThunarUserEntry, n);
+      g_free (user_entry->name);
+      g_free (user_entry->gecos);
+    }
+
+  g_array_free (lookup->groups, TRUE);
+  g_array_free (lookup->users, TRUE);
+  g_slice_free (ThunarUserLookup, lookup);
+}
+
+
+
+static gboolean
+thunar_user_manager_group_pending (guint32 gid)
+{
+  return (user_manager_default != NULL
+          && g_hash_table_contains (user_manager_default->pending_groups, GUINT_TO_POINTER (gid)));
+}
+
+
+
+static gboolean
+thunar_user_manager_user_pending (guint32 uid)
+{
+  return (user_manager_default != NULL
+          && g_hash_table_contains (user_manager_default->pending_users, GUINT_TO_POINTER (uid)));
+}
+
+
+
 /**
  * thunar_user_manager_get_default:
  *
@@ -615,19 +1066,17 @@ thunar_user_manager_flush_timer_destroy (gpointer user_data)
 ThunarUserManager*
 thunar_user_manager_get_default (void)
 {
-  static ThunarUserManager *manager = NULL;
-
-  if (G_UNLIKELY (manager == NULL))
+  if (G_UNLIKELY (user_manager_default == NULL))
     {
-      manager = g_object_new (THUNAR_TYPE_USER_MANAGER, NULL);
-      g_object_add_weak_pointer (G_OBJECT (manager), (gpointer) &manager);
+      user_manager_default = g_object_new (THUNAR_TYPE_USER_MANAGER, NULL);
+      g_object_add_weak_pointer (G_OBJECT (user_manager_default), (gpointer) &user_manager_default);
     }
   else
     {
-      g_object_ref (G_OBJECT (manager));
+      g_object_ref (G_OBJECT (user_manager_default));
     }
 
-  return manager;
+  return user_manager_default;
 }
 
 
@@ -746,3 +1195,36 @@ thunar_user_manager_get_all_groups (ThunarUserManager *manager)
 
   return groups;
 }
+
+
+
+/**
+ * thunar_user_manager_prefetch:
+ * @manager : a #ThunarUserManager.
+ * @uid     : a user id.
+ * @gid     : a group id.
+ *
+ * Queues the names of @uid and @gid for a lookup in the background,
+ * unless they are known already. Until the lookup is finished, the
+ * ids are used as names instead of blocking on the name service
+ * and ThunarUserManager::changed is emitted once the real names
+ * are available.
+ **/
+void
+thunar_user_manager_prefetch (ThunarUserManager *manager,
+                              guint32            uid,
+                              guint32            gid)
+{
+  ThunarGroup *group;
+  ThunarUser  *user;
+
+  g_return_if_fail (THUNAR_IS_USER_MANAGER (manager));
+
+  user = g_hash_table_lookup (manager->users, GUINT_TO_POINTER (uid));
+  if (user == NULL || !user->resolved)
+    thunar_user_manager_queue_user (manager, uid);
+
+  group = g_hash_table_lookup (manager->groups, GUINT_TO_POINTER (gid));
+  if (group == NULL || !group->resolved)
+    thunar_user_manager_queue_group (manager, gid);
+}
@@ -81,6 +81,10 @@ ThunarUser        *thunar_user_manager_get_user_by_id  (ThunarUserManager *manag
 
 GList             *thunar_user_manager_get_all_groups  (ThunarUserManager *manager) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+void               thunar_user_manager_prefetch        (ThunarUserManager *manager,
+                                                        guint32            uid,
+                                                        guint32            gid);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_USER_H__ */
@@ -397,23 +397,69 @@ thunar_util_expand_filename (const gchar  *filename,
 
 
 
-/**
- * thunar_util_humanize_file_time:
- * @file_time         : a #guint64 timestamp.
- * @date_style        : the #ThunarDateFormat used to humanize the @file_time.
- * @date_custom_style : custom style to apply, if @date_style is set to custom
- *
- * Returns a human readable date representation of the specified
- * @file_time. The caller is responsible to free the returned
- * string using g_free() when no longer needed.
- *
- * Return value: a human readable date representation of @file_time
- *               according to the @date_format.
- **/
-gchar*
-thunar_util_humanize_file_time (guint64          file_time,
-                                ThunarDateStyle  date_style,
-                                const gchar     *date_custom_style)
+/* the formatted dates, since the rows of a folder are drawn again and
+ * again and many share their time. The styles relative to the current
+ * day are dropped when the day changes, checked once a minute */
+#define THUNAR_UTIL_DATE_CACHE_MAX (4096)
+
+typedef struct
+{
+  guint64          file_time;
+  ThunarDateStyle  date_style;
+  const gchar     *date_custom_style; /* interned */
+}
+ThunarUtilDateKey;
+
+static GHashTable *date_cache = NULL;
+static gint64      date_cache_minute = 0;
+static guint32     date_cache_day = 0;
+static GMutex      date_cache_mutex;
+
+
+
+static guint
+thunar_util_date_key_hash (gconstpointer key)
+{
+  const ThunarUtilDateKey *date_key = key;
+
+  return g_int64_hash (&date_key->file_time) ^ (date_key->date_style << 24) ^ g_direct_hash (date_key->date_custom_style);
+}
+
+
+
+static gboolean
+thunar_util_date_key_equal (gconstpointer a,
+                            gconstpointer b)
+{
+  const ThunarUtilDateKey *date_key_a = a;
+  const ThunarUtilDateKey *date_key_b = b;
+
+  return date_key_a->file_time == date_key_b->file_time
+      && date_key_a->date_style == date_key_b->date_style
+      && date_key_a->date_custom_style == date_key_b->date_custom_style;
+}
+
+
+
+static gboolean
+thunar_util_date_key_is_relative (gpointer key,
+                                  gpointer value,
+                                  gpointer user_data)
+{
+  ThunarDateStyle date_style = ((const ThunarUtilDateKey *) key)->date_style;
+
+  return date_style == THUNAR_DATE_STYLE_SIMPLE
+      || date_style == THUNAR_DATE_STYLE_SHORT
+      || date_style == THUNAR_DATE_STYLE_CUSTOM_SIMPLE;
+}
+
+
+
+/* formats @file_time for thunar_util_humanize_file_time() */
+static gchar*
+thunar_util_format_file_time (guint64          file_time,
+                              ThunarDateStyle  date_style,
+                              const gchar     *date_custom_style)
 {
   const gchar *date_format;
   gchar       *time_str;
@@ -527,6 +573,75 @@ thunar_util_humanize_file_time (guint64          file_time,
 
 
 
+/**
+ * thunar_util_humanize_file_time:
+ * @file_time         : a #guint64 timestamp.
+ * @date_style        : the #ThunarDateFormat used to humanize the @file_time.
+ * @date_custom_style : custom style to apply, if @date_style is set to custom
+ *
+ * Returns a human readable date representation of the specified
+ * @file_time. The caller is responsible to free the returned
+ * string using g_free() when no longer needed.
+ *
+ * Return value: a human readable date representation of @file_time
+ *               according to the @date_format.
+ **/
+gchar*
+thunar_util_humanize_file_time (guint64          file_time,
+                                ThunarDateStyle  date_style,
+                                const gchar     *date_custom_style)
+{
+  ThunarUtilDateKey  key;
+  ThunarUtilDateKey *new_key;
+  gchar             *time_str;
+  GDate              dnow;
+  gint64             minute;
+
+  key.file_time = file_time;
+  key.date_style = date_style;
+  key.date_custom_style = g_intern_string (date_custom_style);
+
+  g_mutex_lock (&date_cache_mutex);
+
+  if (G_UNLIKELY (date_cache == NULL))
+    date_cache = g_hash_table_new_full (thunar_util_date_key_hash, thunar_util_date_key_equal, g_free, g_free);
+
+  /* "Today" and "Yesterday" are wrong once the day is over */
+  minute = g_get_real_time () / (G_USEC_PER_SEC * 60);
+  if (G_UNLIKELY (minute != date_cache_minute))
+    {
+      date_cache_minute = minute;
+      g_date_clear (&dnow, 1);
+      g_date_set_time_t (&dnow, time (NULL));
+      if (g_date_get_julian (&dnow) != date_cache_day)
+        {
+          date_cache_day = g_date_get_julian (&dnow);
+          g_hash_table_foreach_remove (date_cache, thunar_util_date_key_is_relative, NULL);
+        }
+    }
+
+  time_str = g_strdup (g_hash_table_lookup (date_cache, &key));
+
+  g_mutex_unlock (&date_cache_mutex);
+
+  if (time_str != NULL)
+    return time_str;
+
+  time_str = thunar_util_format_file_time (file_time, date_style, date_custom_style);
+
+  g_mutex_lock (&date_cache_mutex);
+  if (g_hash_table_size (date_cache) >= THUNAR_UTIL_DATE_CACHE_MAX)
+    g_hash_table_remove_all (date_cache);
+  new_key = g_new (ThunarUtilDateKey, 1);
+  *new_key = key;
+  g_hash_table_replace (date_cache, new_key, g_strdup (time_str));
+  g_mutex_unlock (&date_cache_mutex);
+
+  return time_str;
+}
+
+
+
 /**
  * thunar_util_parse_parent:
  * @parent        : a #GtkWidget, a #GdkScreen or %NULL.
@@ -713,10 +828,48 @@ thunar_util_next_new_file_name (ThunarFile            *dir,
                                 const gchar           *file_name,
                                 ThunarNextFileNameMode name_mode)
 {
-  ThunarFolder   *folder          = thunar_folder_get_for_file (dir);
+  ThunarFolder *folder = thunar_folder_get_for_file (dir);
+  GHashTable   *names;
+  GPtrArray    *files;
+  gchar        *new_name;
+  guint         n;
+
+  /* collect the names of the folder once, instead of once per candidate */
+  names = g_hash_table_new (g_str_hash, g_str_equal);
+  files = thunar_folder_get_files (folder);
+  for (n = 0; n < files->len; ++n)
+    g_hash_table_add (names, (gpointer) thunar_file_get_basename (g_ptr_array_index (files, n)));
+
+  new_name = thunar_util_next_new_file_name_in (names, file_name, name_mode);
+
+  g_hash_table_destroy (names);
+  g_object_unref (G_OBJECT (folder));
+
+  return new_name;
+}
+
+
+
+/**
+ * thunar_util_next_new_file_name_in
+ * @names : a set of the file names already taken
+ * @file_name : the filename which will be used as the basis/default
+ * @ThunarNextFileNameMode: To decide if the naming should follow "file copy","file link" or "new file" syntax
+ *
+ * Like thunar_util_next_new_file_name(), but looks up the names in @names, a
+ * #GHashTable set of strings, instead of the files of a folder.
+ *
+ * The caller is responsible to free the returned string using g_free() when no longer needed.
+ *
+ * Return value: pointer to the new filename.
+**/
+gchar*
+thunar_util_next_new_file_name_in (GHashTable            *names,
+                                   const gchar           *file_name,
+                                   ThunarNextFileNameMode name_mode)
+{
   unsigned long   file_name_size  = strlen (file_name);
   unsigned        count           = 0;
-  gboolean        found_duplicate = FALSE;
   gchar          *extension       = NULL;
   gchar          *new_name        = g_strdup (file_name);
 
@@ -727,26 +880,9 @@ thunar_util_next_new_file_name (ThunarFile            *dir,
   if (extension != NULL)
     file_name_size -= strlen (extension);
 
-  /* loop through the directory until new_name is unique */
-  while (TRUE)
+  /* loop until new_name is unique */
+  while (g_hash_table_contains (names, new_name))
     {
-      found_duplicate = FALSE;
-      for (GList *files = thunar_folder_get_files (folder); files != NULL; files = files->next)
-        {
-          ThunarFile  *file = files->data;
-          gchar       *name = g_file_get_basename (thunar_file_get_file (file));
-
-          if (g_strcmp0 (new_name, name) == 0)
-            {
-              found_duplicate = TRUE;
-              g_free (name);
-              break;
-            }
-          g_free (name);
-        }
-
-      if (!found_duplicate)
-        break;
       g_free (new_name);
       if (name_mode == THUNAR_NEXT_FILE_NAME_MODE_NEW)
         new_name = g_strdup_printf (_("%.*s %u%s"), (int) file_name_size, file_name, ++count, extension ? extension : "");
@@ -767,7 +903,6 @@ thunar_util_next_new_file_name (ThunarFile            *dir,
       else
         g_assert("should not be reached");
     }
-  g_object_unref (G_OBJECT (folder));
 
   return new_name;
 }
@@ -998,3 +1133,37 @@ thunar_util_clip_view_background (GtkCellRenderer      *cell,
   g_free (highlight_color);
   cairo_restore (cr);
 }
+
+
+
+/**
+ * thunar_util_startup_trace:
+ * @phase : a short description of the startup phase that just finished
+ *
+ * Prints the time elapsed since the first call and since the previous call
+ * to stderr, if the THUNAR_STARTUP_TRACE environment variable is set. This
+ * is meant to find the expensive parts of the application and window setup.
+ **/
+void
+thunar_util_startup_trace (const gchar *phase)
+{
+  static gsize   enabled = 0;
+  static gint64  start_time = 0;
+  static gint64  last_time = 0;
+  gint64         now;
+
+  if (g_once_init_enter (&enabled))
+    g_once_init_leave (&enabled, g_getenv ("THUNAR_STARTUP_TRACE") != NULL ? 2 : 1);
+
+  if (G_LIKELY (enabled != 2))
+    return;
+
+  now = g_get_monotonic_time ();
+  if (start_time == 0)
+    start_time = last_time = now;
+
+  g_printerr ("thunar-startup: %8.2f ms (+%7.2f ms) %s\n",
+              (now - start_time) / 1000.0, (now - last_time) / 1000.0, phase);
+
+  last_time = now;
+}
@@ -77,6 +77,9 @@ void       thunar_setup_display_cb              (gpointer        data);
 gchar*     thunar_util_next_new_file_name       (ThunarFile            *dir,
                                                  const gchar           *file_name,
                                                  ThunarNextFileNameMode name_mode);
+gchar*     thunar_util_next_new_file_name_in    (GHashTable            *names,
+                                                 const gchar           *file_name,
+                                                 ThunarNextFileNameMode name_mode);
 gboolean   thunar_util_is_a_search_query        (const gchar    *string);
 gchar*     thunar_util_strjoin_list             (GList       *string_list,
                                                  const gchar *separator);
@@ -86,6 +89,8 @@ void       thunar_util_clip_view_background     (GtkCellRenderer      *cell,
                                                  GtkWidget            *widget,
                                                  GtkCellRendererState  flags);
 
+void       thunar_util_startup_trace            (const gchar    *phase);
+
 extern const char *SEARCH_PREFIX;
 
 G_END_DECLS;
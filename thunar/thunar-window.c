@@ -168,8 +168,11 @@ static GtkWidget*thunar_window_notebook_insert_page       (ThunarWindow
                                                            ThunarFile             *directory,
                                                            GType                   view_type,
                                                            gint                    position,
-                                                           ThunarHistory          *history);
+                                                           ThunarHistory          *history,
+                                                           gboolean                deferred);
 static void      thunar_window_notebook_select_current_page(ThunarWindow           *window);
+static void      thunar_window_tab_schedule_suspend       (GtkWidget              *view);
+static void      thunar_window_tab_resume                 (GtkWidget              *view);
 
 static GtkWidget*thunar_window_paned_notebooks_add        (ThunarWindow           *window);
 static void      thunar_window_paned_notebooks_switch     (ThunarWindow           *window);
@@ -356,12 +359,23 @@ static GtkWidget* thunar_window_create_toolbar_toggle_item_from_action   (Thunar
                                                                           gboolean                active,
                                                                           guint                   item_order);
 static gboolean   thunar_window_image_preview_mode_changed               (ThunarWindow           *window);
+static void       thunar_window_preview_free                             (gpointer                data);
+static void       thunar_window_preview_load                             (ThunarWindow           *window,
+                                                                          ThunarFile             *file);
 static void       image_preview_update                                   (GtkWidget              *parent,
                                                                           GtkAllocation          *allocation,
                                                                           GtkWidget              *image);
 
 
 
+typedef struct
+{
+  gchar     *key;
+  GdkPixbuf *pixbuf;
+} ThunarWindowPreview;
+
+
+
 struct _ThunarWindowClass
 {
   GtkWindowClass __parent__;
@@ -383,6 +397,7 @@ struct _ThunarWindow
   /* support for custom preferences actions */
   ThunarxProviderFactory    *provider_factory;
   GList                     *thunarx_preferences_providers;
+  gboolean                   thunarx_preferences_providers_loaded;
 
   GFile                     *bookmark_file;
   GList                     *bookmarks;
@@ -478,6 +493,11 @@ struct _ThunarWindow
   guint                      thumbnail_request;
   GdkPixbuf                 *preview_image_pixbuf;
 
+  /* the preview being decoded, and recently shown previews, most recent first */
+  GCancellable              *preview_cancellable;
+  gchar                     *preview_key;
+  GQueue                     preview_cache;
+
   /* Reference to the global job operation history */
   ThunarJobOperationHistory *job_operation_history;
 };
@@ -555,6 +575,12 @@ static XfceGtkActionEntry thunar_window_action_entries[] =
     { 0,                                                   "<Actions>/ThunarWindow/open-file-menu",                  "F10",                  0,                        NULL,                          NULL,                                                                                NULL,                      G_CALLBACK (thunar_window_action_open_file_menu),      },
 };
 
+/* an inactive tab releases its folder after this many seconds */
+#define THUNAR_WINDOW_TAB_SUSPEND_DELAY (300)
+
+/* number of decoded previews kept for moving back and forth in the selection */
+#define THUNAR_WINDOW_PREVIEW_CACHE_SIZE (8)
+
 #define get_action_entry(id) xfce_gtk_get_action_entry_by_id(thunar_window_action_entries,G_N_ELEMENTS(thunar_window_action_entries),id)
 
 
@@ -778,9 +804,13 @@ thunar_window_init (ThunarWindow *window)
   /* unset the view type */
   window->view_type = G_TYPE_NONE;
 
-  /* grab a reference on the provider factory and load the providers*/
+  thunar_util_startup_trace ("window init");
+
+  /* grab a reference on the provider factory, the preferences providers
+   * are only loaded once the edit menu is opened for the first time */
   window->provider_factory = thunarx_provider_factory_get_default ();
-  window->thunarx_preferences_providers = thunarx_provider_factory_list_providers (window->provider_factory, THUNARX_TYPE_PREFERENCES_PROVIDER);
+  window->thunarx_preferences_providers = NULL;
+  window->thunarx_preferences_providers_loaded = FALSE;
 
   /* grab a reference on the preferences */
   window->preferences = thunar_preferences_get ();
@@ -970,6 +1000,7 @@ thunar_window_init (ThunarWindow *window)
   g_signal_connect_swapped (window->preferences, "notify::misc-image-preview-mode", G_CALLBACK (thunar_window_image_preview_mode_changed), window);
 
   window->preview_image_pixbuf = NULL;
+  g_queue_init (&window->preview_cache);
 
   /* split view: Create panes where the two notebooks */
   window->paned_notebooks = gtk_paned_new (GTK_ORIENTATION_HORIZONTAL);
@@ -980,6 +1011,8 @@ thunar_window_init (ThunarWindow *window)
   gtk_paned_pack1 (GTK_PANED (window->paned_right), window->view_box, TRUE, FALSE);
   gtk_widget_show (window->view_box);
 
+  thunar_util_startup_trace ("window panes created");
+
   gtk_widget_add_events (window->paned_notebooks, GDK_ENTER_NOTIFY_MASK | GDK_LEAVE_NOTIFY_MASK | GDK_BUTTON_PRESS_MASK);
   gtk_grid_attach (GTK_GRID (window->view_box), window->paned_notebooks, 0, 0, 1, 1);
   gtk_widget_show (window->paned_notebooks);
@@ -995,12 +1028,16 @@ thunar_window_init (ThunarWindow *window)
   /* add first notebook and select it*/
   window->notebook_selected = thunar_window_paned_notebooks_add(window);
 
+  thunar_util_startup_trace ("window notebook created");
+
   /* get a reference of the global job operation history */
   window->job_operation_history = thunar_job_operation_history_get_default ();
 
   window->location_toolbar = NULL;
   thunar_window_location_toolbar_create (window);
 
+  thunar_util_startup_trace ("window location toolbar created");
+
   uca_path = xfce_resource_save_location (XFCE_RESOURCE_CONFIG, "Thunar/uca.xml", TRUE);
   window->uca_file         = g_file_new_for_path (uca_path);
   window->uca_file_monitor = g_file_monitor_file (window->uca_file, G_FILE_MONITOR_NONE, NULL, NULL);
@@ -1025,6 +1062,8 @@ thunar_window_init (ThunarWindow *window)
   thunar_window_install_sidepane (window, type);
   g_free (last_side_pane);
 
+  thunar_util_startup_trace ("window side pane installed");
+
   /* synchronise the "directory-specific-settings" property with the global "misc-directory-specific-settings" property */
   g_object_bind_property (G_OBJECT (window->preferences), "misc-directory-specific-settings", G_OBJECT (window), "directory-specific-settings", G_BINDING_SYNC_CREATE);
 
@@ -1086,6 +1125,8 @@ thunar_window_init (ThunarWindow *window)
 
   window->search_query = NULL;
   window->reset_view_type_idle_id = 0;
+
+  thunar_util_startup_trace ("window init done");
 }
 
 
@@ -1334,6 +1375,11 @@ thunar_window_update_edit_menu (ThunarWindow *window,
                                               | THUNAR_MENU_SECTION_RESTORE);
 
   /* determine the available preferences providers */
+  if (G_UNLIKELY (!window->thunarx_preferences_providers_loaded))
+    {
+      window->thunarx_preferences_providers = thunarx_provider_factory_list_providers (window->provider_factory, THUNARX_TYPE_PREFERENCES_PROVIDER);
+      window->thunarx_preferences_providers_loaded = TRUE;
+    }
   if (G_LIKELY (window->thunarx_preferences_providers != NULL))
     {
       /* add menu items from all providers */
@@ -1577,6 +1623,13 @@ thunar_window_dispose (GObject *object)
   /* disconnect from the current-directory */
   thunar_window_set_current_directory (window, NULL);
 
+  /* stop decoding the image preview */
+  if (window->preview_cancellable != NULL)
+    {
+      g_cancellable_cancel (window->preview_cancellable);
+      g_clear_object (&window->preview_cancellable);
+    }
+
   (*G_OBJECT_CLASS (thunar_window_parent_class)->dispose) (object);
 }
 
@@ -1625,6 +1678,12 @@ thunar_window_finalize (GObject *object)
   g_signal_handlers_disconnect_by_data (window->thumbnailer, window);
   g_object_unref (window->thumbnailer);
 
+  /* release the image previews */
+  if (window->preview_image_pixbuf != NULL)
+    g_object_unref (window->preview_image_pixbuf);
+  g_queue_clear_full (&window->preview_cache, thunar_window_preview_free);
+  g_free (window->preview_key);
+
   /* disconnect signal from GtkRecentManager */
   g_signal_handlers_disconnect_by_data (G_OBJECT (gtk_recent_manager_get_default()), window);
 
@@ -2117,11 +2176,19 @@ thunar_window_notebook_switch_page (GtkWidget    *notebook,
   GSList        *view_bindings;
   ThunarFile    *current_directory;
   ThunarHistory *history;
+  GtkWidget     *current_page;
 
   _thunar_return_if_fail (THUNAR_IS_WINDOW (window));
   _thunar_return_if_fail (GTK_IS_NOTEBOOK (notebook));
   _thunar_return_if_fail (THUNAR_IS_VIEW (page));
 
+  /* the page which is hidden now may be suspended later on, the page which is
+   * shown is loaded again. this has to happen for both notebooks of a split-view */
+  current_page = gtk_notebook_get_nth_page (GTK_NOTEBOOK (notebook), gtk_notebook_get_current_page (GTK_NOTEBOOK (notebook)));
+  if (current_page != NULL && current_page != page)
+    thunar_window_tab_schedule_suspend (current_page);
+  thunar_window_tab_resume (page);
+
   /* leave if nothing changed or tab from other split-view is selected as
    * thunar_window_notebook_select_current_page() is going to take care of that */
   if ((window->view == page) || (window->notebook_selected != notebook))
@@ -2318,6 +2385,9 @@ thunar_window_notebook_page_removed (GtkWidget    *notebook,
   /* drop connected signals */
   g_signal_handlers_disconnect_matched (page, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, window);
 
+  /* the page is closed or moves to another window */
+  g_object_set_data (G_OBJECT (page), "thunar-tab-suspend-id", NULL);
+
   n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (notebook));
   if (n_pages == 0)
     {
@@ -2531,7 +2601,8 @@ thunar_window_notebook_insert_page (ThunarWindow  *window,
                                     ThunarFile    *directory,
                                     GType          view_type,
                                     gint           position,
-                                    ThunarHistory *history)
+                                    ThunarHistory *history,
+                                    gboolean       deferred)
 {
   GtkWidget      *view;
   GtkWidget      *label;
@@ -2553,10 +2624,20 @@ thunar_window_notebook_insert_page (ThunarWindow  *window,
   else
     g_object_get (window->view, "sort-column", &sort_column, "sort-order", &sort_order, NULL);
 
-  /* allocate and setup a new view */
-  view = g_object_new (view_type, "current-directory", directory,
-                                  "sort-column-default", sort_column,
-                                  "sort-order-default", sort_order, NULL);
+  /* allocate and setup a new view, a deferred view opens its folder once it is shown */
+  if (deferred)
+    {
+      view = g_object_new (view_type, "sort-column-default", sort_column,
+                                      "sort-order-default", sort_order, NULL);
+      thunar_standard_view_suspend (THUNAR_STANDARD_VIEW (view));
+      thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (view), directory);
+    }
+  else
+    {
+      view = g_object_new (view_type, "current-directory", directory,
+                                      "sort-column-default", sort_column,
+                                      "sort-order-default", sort_order, NULL);
+    }
   thunar_view_set_show_hidden (THUNAR_VIEW (view), window->show_hidden);
 
   gtk_widget_show (view);
@@ -2641,6 +2722,58 @@ thunar_window_notebook_select_current_page (ThunarWindow *window)
 
 
 
+static void
+thunar_window_tab_suspend_cancel (gpointer data)
+{
+  g_source_remove (GPOINTER_TO_UINT (data));
+}
+
+
+
+static gboolean
+thunar_window_tab_suspend_timeout (gpointer user_data)
+{
+  GtkWidget *view = GTK_WIDGET (user_data);
+
+  /* the source is gone once we return */
+  g_object_steal_data (G_OBJECT (view), "thunar-tab-suspend-id");
+
+  thunar_standard_view_suspend (THUNAR_STANDARD_VIEW (view));
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_window_tab_schedule_suspend (GtkWidget *view)
+{
+  guint id;
+
+  if (!THUNAR_IS_STANDARD_VIEW (view)
+      || thunar_standard_view_is_suspended (THUNAR_STANDARD_VIEW (view))
+      || g_object_get_data (G_OBJECT (view), "thunar-tab-suspend-id") != NULL)
+    return;
+
+  /* the timeout is removed together with the data */
+  id = g_timeout_add_seconds (THUNAR_WINDOW_TAB_SUSPEND_DELAY, thunar_window_tab_suspend_timeout, view);
+  g_object_set_data_full (G_OBJECT (view), "thunar-tab-suspend-id", GUINT_TO_POINTER (id), thunar_window_tab_suspend_cancel);
+}
+
+
+
+static void
+thunar_window_tab_resume (GtkWidget *view)
+{
+  if (!THUNAR_IS_STANDARD_VIEW (view))
+    return;
+
+  g_object_set_data (G_OBJECT (view), "thunar-tab-suspend-id", NULL);
+  thunar_standard_view_resume (THUNAR_STANDARD_VIEW (view));
+}
+
+
+
 static GtkWidget*
 thunar_window_paned_notebooks_add (ThunarWindow *window)
 {
@@ -2803,7 +2936,8 @@ thunar_window_notebook_add_new_tab (ThunarWindow        *window,
 
   /* insert the new view */
   page_num = gtk_notebook_get_current_page (GTK_NOTEBOOK (window->notebook_selected));
-  view = thunar_window_notebook_insert_page (window, directory, view_type, page_num + 1, history);
+  view = thunar_window_notebook_insert_page (window, directory, view_type, page_num + 1, history,
+                                             behavior == THUNAR_NEW_TAB_BEHAVIOR_DEFER);
 
   /* switch to the new view */
   g_object_get (G_OBJECT (window->preferences), "misc-switch-to-new-tab", &switch_to_new_tab, NULL);
@@ -3651,7 +3785,7 @@ thunar_window_action_toggle_split_view (ThunarWindow *window)
 
       /* insert the new view */
       page_num = gtk_notebook_get_current_page (GTK_NOTEBOOK (window->notebook_selected));
-      thunar_window_notebook_insert_page (window, directory, view_type, page_num+1, history);
+      thunar_window_notebook_insert_page (window, directory, view_type, page_num+1, history, FALSE);
 
       /* Prevent notebook expand on tab creation */
       g_object_get (G_OBJECT (window->preferences), "last-splitview-separator-position", &last_splitview_separator_position, NULL);
@@ -4055,7 +4189,7 @@ thunar_window_replace_view (ThunarWindow *window,
     page_num = -1;
 
   /* insert the new view */
-  new_view = thunar_window_notebook_insert_page (window, current_directory, view_type, page_num + 1, history);
+  new_view = thunar_window_notebook_insert_page (window, current_directory, view_type, page_num + 1, history, FALSE);
 
   /* if we are replacing the active view, make the new view the active view */
   if (is_current_view)
@@ -5266,13 +5400,16 @@ thunar_window_set_current_directory (ThunarWindow *window,
 
 GList*
 thunar_window_get_directories (ThunarWindow *window,
-                               gint         *active_page)
+                               gint         *active_page,
+                               GList       **view_types,
+                               GList       **scroll_uris)
 {
   gint         n;
   gint         n_pages;
   GList       *uris = NULL;
   GtkWidget   *view;
   ThunarFile  *directory;
+  GFile       *scroll_file;
 
   _thunar_return_val_if_fail (THUNAR_IS_WINDOW (window), NULL);
 
@@ -5293,6 +5430,17 @@ thunar_window_get_directories (ThunarWindow *window,
         continue;
 
       uris = g_list_append (uris, thunar_file_dup_uri (directory));
+
+      /* the view type and the scroll position, empty if unknown */
+      if (view_types != NULL)
+        *view_types = g_list_append (*view_types, g_strdup (G_OBJECT_TYPE_NAME (view)));
+      if (scroll_uris != NULL)
+        {
+          scroll_file = THUNAR_IS_STANDARD_VIEW (view) ? thunar_standard_view_get_scroll_file (THUNAR_STANDARD_VIEW (view)) : NULL;
+          *scroll_uris = g_list_append (*scroll_uris, (scroll_file != NULL) ? g_file_get_uri (scroll_file) : g_strdup (""));
+          if (scroll_file != NULL)
+            g_object_unref (scroll_file);
+        }
     }
 
   /* selected tab */
@@ -5304,19 +5452,55 @@ thunar_window_get_directories (ThunarWindow *window,
 
 
 
+/**
+ * thunar_window_set_directories:
+ * @window      : a #ThunarWindow.
+ * @uris        : the URIs of the folders to open in tabs.
+ * @view_types  : the names of the view types for the tabs, or %NULL.
+ * @scroll_uris : the URIs of the first visible files of the tabs, or %NULL.
+ * @active_page : the tab to show.
+ *
+ * Opens the tabs saved with thunar_window_get_directories(). Only the
+ * tab which is shown loads its folder, the other tabs just remember
+ * their folder, view type and scroll position until they are shown.
+ * Missing or empty @view_types and @scroll_uris entries are fine.
+ *
+ * Return value: %TRUE if tabs were opened.
+ **/
 gboolean
 thunar_window_set_directories (ThunarWindow   *window,
                                gchar         **uris,
+                               gchar         **view_types,
+                               gchar         **scroll_uris,
                                gint            active_page)
 {
   ThunarFile *directory;
-  guint       n;
+  GtkWidget  *view;
+  GtkWidget  *active_view = NULL;
+  GFile      *scroll_file;
+  GType       view_type;
+  guint       n_uris;
+  guint       n_view_types;
+  guint       n_scroll_uris;
+  guint       n_before = 0;
+  guint       first;
+  guint       k, n;
 
   _thunar_return_val_if_fail (THUNAR_IS_WINDOW (window), FALSE);
   _thunar_return_val_if_fail (uris != NULL, FALSE);
 
-  for (n = 0; uris[n] != NULL; n++)
+  n_uris = g_strv_length (uris);
+  n_view_types = (view_types != NULL) ? g_strv_length (view_types) : 0;
+  n_scroll_uris = (scroll_uris != NULL) ? g_strv_length (scroll_uris) : 0;
+
+  /* open the shown tab first, otherwise the notebook would show
+   * (and load) the first of the other tabs meanwhile */
+  first = (active_page >= 0 && (guint) active_page < n_uris) ? (guint) active_page : 0;
+
+  for (k = 0; k < n_uris; k++)
     {
+      n = (k == 0) ? first : (k <= first ? k - 1 : k);
+
       /* check if the string looks like an uri */
       if (!g_uri_is_valid (uris[n], G_URI_FLAGS_NONE, NULL))
         continue;
@@ -5326,20 +5510,49 @@ thunar_window_set_directories (ThunarWindow   *window,
       if (G_UNLIKELY (directory == NULL))
         continue;
 
-      /* open the directory in a new notebook */
-      if (thunar_file_is_directory (directory))
+      if (!thunar_file_is_directory (directory))
         {
-          if (gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected)) == 0)
-            thunar_window_set_current_directory (window, directory);
-          else
-            thunar_window_notebook_open_new_tab (window, directory);
+          g_object_unref (G_OBJECT (directory));
+          continue;
+        }
+
+      view_type = (n < n_view_types) ? g_type_from_name (view_types[n]) : G_TYPE_INVALID;
+      if (gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected)) == 0
+          && !g_type_is_a (view_type, THUNAR_TYPE_STANDARD_VIEW))
+        {
+          /* a new window starts with the default view */
+          thunar_window_set_current_directory (window, directory);
+          view = window->view;
+        }
+      else
+        {
+          if (!g_type_is_a (view_type, THUNAR_TYPE_STANDARD_VIEW))
+            view_type = thunar_window_view_type_for_directory (window, directory);
+
+          /* the tabs in front of the shown one keep their order */
+          view = thunar_window_notebook_insert_page (window, directory, view_type, (n < first) ? (gint) n_before : -1,
+                                                     NULL, n != first);
+          if (n < first)
+            n_before++;
+        }
+
+      if (n == first)
+        active_view = view;
+
+      /* restored once the folder is loaded */
+      if (THUNAR_IS_STANDARD_VIEW (view) && n < n_scroll_uris && *scroll_uris[n] != '\0')
+        {
+          scroll_file = g_file_new_for_uri (scroll_uris[n]);
+          thunar_standard_view_set_scroll_file (THUNAR_STANDARD_VIEW (view), scroll_file);
+          g_object_unref (scroll_file);
         }
 
       g_object_unref (G_OBJECT (directory));
     }
 
   /* select the page */
-  thunar_window_notebook_set_current_tab (window, active_page);
+  if (active_view != NULL)
+    thunar_window_notebook_set_current_tab (window, gtk_notebook_page_num (GTK_NOTEBOOK (window->notebook_selected), active_view));
 
   /* we succeeded if new pages have been opened */
   return gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook_selected)) > 0;
@@ -5738,6 +5951,142 @@ static void thunar_window_update_standalone_image_preview (ThunarWindow *window)
 
 
 
+static void
+thunar_window_preview_free (gpointer data)
+{
+  ThunarWindowPreview *preview = data;
+
+  g_object_unref (preview->pixbuf);
+  g_free (preview->key);
+  g_slice_free (ThunarWindowPreview, preview);
+}
+
+
+
+static void
+thunar_window_preview_show (ThunarWindow *window,
+                            GdkPixbuf    *pixbuf)
+{
+  if (window->preview_image_pixbuf != NULL)
+    g_object_unref (window->preview_image_pixbuf);
+  window->preview_image_pixbuf = g_object_ref (pixbuf);
+
+  thunar_window_update_embedded_image_preview (window);
+  thunar_window_update_standalone_image_preview (window);
+}
+
+
+
+static void
+thunar_window_preview_decoded (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  ThunarWindow        *window = THUNAR_WINDOW (user_data);
+  ThunarWindowPreview *preview;
+  GdkPixbuf           *pixbuf;
+
+  /* NULL if a newer selection cancelled this one, or on errors */
+  pixbuf = gdk_pixbuf_new_from_stream_finish (result, NULL);
+  if (pixbuf != NULL)
+    {
+      g_clear_object (&window->preview_cancellable);
+
+      /* remember the preview, dropping the least recently shown one */
+      preview = g_slice_new (ThunarWindowPreview);
+      preview->key = g_steal_pointer (&window->preview_key);
+      preview->pixbuf = pixbuf;
+      g_queue_push_head (&window->preview_cache, preview);
+      if (window->preview_cache.length > THUNAR_WINDOW_PREVIEW_CACHE_SIZE)
+        thunar_window_preview_free (g_queue_pop_tail (&window->preview_cache));
+
+      thunar_window_preview_show (window, pixbuf);
+    }
+
+  g_object_unref (window);
+}
+
+
+
+static void
+thunar_window_preview_read (GObject      *object,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+  ThunarWindow     *window = THUNAR_WINDOW (user_data);
+  GFileInputStream *stream;
+
+  stream = g_file_read_finish (G_FILE (object), result, NULL);
+  if (stream == NULL)
+    {
+      g_object_unref (window);
+      return;
+    }
+
+  /* decode in a thread, the window reference is passed on */
+  if (window->preview_cancellable != NULL && !g_cancellable_is_cancelled (window->preview_cancellable))
+    gdk_pixbuf_new_from_stream_async (G_INPUT_STREAM (stream), window->preview_cancellable,
+                                      thunar_window_preview_decoded, window);
+  else
+    g_object_unref (window);
+
+  g_object_unref (stream);
+}
+
+
+
+/* shows the large thumbnail of file in the image previews, right away if
+ * it was shown recently, otherwise once it is decoded in the background */
+static void
+thunar_window_preview_load (ThunarWindow *window,
+                            ThunarFile   *file)
+{
+  ThunarWindowPreview *preview;
+  GList               *lp;
+  GFile               *gfile;
+  gchar               *path;
+  gchar               *key;
+
+  path = thunar_file_get_thumbnail_path_forced (file, THUNAR_THUMBNAIL_SIZE_XX_LARGE);
+  if (path == NULL)
+    return;
+
+  /* the thumbnail is replaced when the file changes */
+  key = g_strdup_printf ("%s:%" G_GUINT64_FORMAT, path, thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED));
+
+  for (lp = window->preview_cache.head; lp != NULL; lp = lp->next)
+    {
+      preview = lp->data;
+      if (strcmp (preview->key, key) == 0)
+        {
+          g_queue_unlink (&window->preview_cache, lp);
+          g_queue_push_head_link (&window->preview_cache, lp);
+          thunar_window_preview_show (window, preview->pixbuf);
+          g_free (key);
+          g_free (path);
+          return;
+        }
+    }
+
+  if (window->preview_cancellable != NULL)
+    {
+      g_cancellable_cancel (window->preview_cancellable);
+      g_object_unref (window->preview_cancellable);
+    }
+  window->preview_cancellable = g_cancellable_new ();
+
+  g_free (window->preview_key);
+  window->preview_key = key;
+
+  gfile = g_file_new_for_path (path);
+  g_file_read_async (gfile, G_PRIORITY_DEFAULT, window->preview_cancellable,
+                     thunar_window_preview_read, g_object_ref (window));
+  g_object_unref (gfile);
+  g_free (path);
+}
+
+
+
 /**
  * thunar_window_selection_changed:
  * @window      : a #ThunarWindow instance.
@@ -5752,7 +6101,7 @@ thunar_window_selection_changed (ThunarWindow *window)
   GList    *selected_files = thunar_view_get_selected_files (THUNAR_VIEW (window->view));
 
   /* butttons specific to the Trash location */
-  if (g_list_length (selected_files) > 0)
+  if (selected_files != NULL)
     gtk_widget_set_sensitive (window->trash_infobar_restore_button, TRUE);
   else
     gtk_widget_set_sensitive (window->trash_infobar_restore_button, FALSE);
@@ -5766,6 +6115,13 @@ thunar_window_selection_changed (ThunarWindow *window)
       window->thumbnail_request = 0;
     }
 
+  /* the newest selection wins, stop decoding the previous preview */
+  if (window->preview_cancellable != NULL)
+    {
+      g_cancellable_cancel (window->preview_cancellable);
+      g_clear_object (&window->preview_cancellable);
+    }
+
   /* clear image previews */
   if (window->preview_image_pixbuf != NULL)
     {
@@ -5779,13 +6135,13 @@ thunar_window_selection_changed (ThunarWindow *window)
                 NULL);
 
   /* get or request a thumbnail */
-  if ((last_image_preview_visible == TRUE) && (g_list_length (selected_files) == 1))
+  if ((last_image_preview_visible == TRUE) && (selected_files != NULL && selected_files->next == NULL))
     {
       gchar *path = thunar_file_get_thumbnail_path_forced (selected_files->data, THUNAR_THUMBNAIL_SIZE_XX_LARGE);
       if (path == NULL) /* request the creation of the thumbnail if it doesn't exist */
         thunar_thumbnailer_queue_file (window->thumbnailer, selected_files->data, &window->thumbnail_request, THUNAR_THUMBNAIL_SIZE_XX_LARGE);
-      else /* display the thumbnail */
-        window->preview_image_pixbuf = gdk_pixbuf_new_from_file (path, NULL);
+      else /* display the thumbnail, the previews are updated again once it is decoded */
+        thunar_window_preview_load (window, selected_files->data);
       g_free (path);
     }
 
@@ -5812,16 +6168,14 @@ thunar_window_finished_thumbnailing (ThunarWindow       *window,
 
   /* update image previews */
   selected_files = thunar_view_get_selected_files (THUNAR_VIEW (window->view));
-  if (g_list_length (selected_files) == 1)
+  if (selected_files != NULL && selected_files->next == NULL)
     {
       /* there is no guarantee that the thumbnail will exist, the type of the selected file might be unsupported by the thumbnailer */
       gchar *path = thunar_file_get_thumbnail_path_forced (selected_files->data, THUNAR_THUMBNAIL_SIZE_XX_LARGE);
       if (path == NULL)
         return;
 
-      window->preview_image_pixbuf = gdk_pixbuf_new_from_file (path, NULL);
-      thunar_window_update_embedded_image_preview (window);
-      thunar_window_update_standalone_image_preview (window);
+      thunar_window_preview_load (window, selected_files->data);
 
       g_free (path);
     }
@@ -112,9 +112,13 @@ ThunarFile               *thunar_window_get_current_directory               (Thu
 void                      thunar_window_set_current_directory               (ThunarWindow        *window,
                                                                              ThunarFile          *current_directory);
 GList                    *thunar_window_get_directories                     (ThunarWindow        *window,
-                                                                             gint                *active_page);
+                                                                             gint                *active_page,
+                                                                             GList              **view_types,
+                                                                             GList              **scroll_uris);
 gboolean                  thunar_window_set_directories                     (ThunarWindow        *window,
                                                                              gchar              **uris,
+                                                                             gchar              **view_types,
+                                                                             gchar              **scroll_uris,
                                                                              gint                 active_page);
 void                      thunar_window_update_directories                  (ThunarWindow        *window,
                                                                              ThunarFile          *old_directory,
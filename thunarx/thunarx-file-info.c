@@ -23,6 +23,8 @@
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include <libxfce4util/libxfce4util.h>
 
 #include <thunarx/thunarx-file-info.h>
@@ -40,6 +42,30 @@ enum
 
 
 
+/* offset of a string missing from a snapshot */
+#define THUNARX_FILE_INFO_SNAPSHOT_NONE (G_MAXSIZE)
+
+
+
+typedef struct
+{
+  gsize    uri;          /* offsets into the arena */
+  gsize    name;
+  gsize    mime_type;
+  gsize    path;
+  gboolean is_directory;
+} ThunarxFileInfoSnapshotEntry;
+
+struct _ThunarxFileInfoSnapshot
+{
+  gint                          ref_count;
+  guint                         n_files;
+  ThunarxFileInfoSnapshotEntry *entries;
+  gchar                        *arena;   /* all strings, nul-terminated one after another */
+};
+
+
+
 static guint file_info_signals[LAST_SIGNAL];
 
 /**
@@ -446,3 +472,299 @@ thunarx_file_info_list_free (GList *file_infos)
 {
   g_list_free_full (file_infos, g_object_unref);
 }
+
+
+
+GType
+thunarx_file_info_snapshot_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      type = g_boxed_type_register_static (I_("ThunarxFileInfoSnapshot"),
+                                           (GBoxedCopyFunc) thunarx_file_info_snapshot_ref,
+                                           (GBoxedFreeFunc) thunarx_file_info_snapshot_unref);
+    }
+
+  return type;
+}
+
+
+
+static gsize
+thunarx_file_info_snapshot_append (GString     *arena,
+                                   const gchar *string)
+{
+  gsize offset;
+
+  if (string == NULL)
+    return THUNARX_FILE_INFO_SNAPSHOT_NONE;
+
+  offset = arena->len;
+  g_string_append_len (arena, string, strlen (string) + 1);
+
+  return offset;
+}
+
+
+
+static const gchar *
+thunarx_file_info_snapshot_lookup (const ThunarxFileInfoSnapshot *snapshot,
+                                   gsize                          offset)
+{
+  if (offset == THUNARX_FILE_INFO_SNAPSHOT_NONE)
+    return NULL;
+
+  return snapshot->arena + offset;
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_new:
+ * @file_infos: (element-type ThunarxFileInfo): a #GList of #ThunarxFileInfo<!---->s.
+ *
+ * Takes an immutable snapshot of the URI, name, MIME type, local path and
+ * directory flag of every file in @file_infos. All strings of the snapshot
+ * live in a single block, so extensions which look at many files avoid the
+ * copy made by every thunarx_file_info_get_uri() and similar call.
+ *
+ * The caller is responsible to free the returned snapshot using
+ * thunarx_file_info_snapshot_unref() when no longer needed.
+ *
+ * Returns: (transfer full): the snapshot of @file_infos.
+ *
+ * Since: 4.20
+ **/
+ThunarxFileInfoSnapshot*
+thunarx_file_info_snapshot_new (GList *file_infos)
+{
+  ThunarxFileInfoSnapshotEntry *entry;
+  ThunarxFileInfoSnapshot      *snapshot;
+  ThunarxFileInfoIface         *iface;
+  ThunarxFileInfo              *file_info;
+  GString                      *arena;
+  GFile                        *location;
+  GList                        *lp;
+  gchar                        *string;
+
+  snapshot = g_slice_new (ThunarxFileInfoSnapshot);
+  snapshot->ref_count = 1;
+  snapshot->n_files = g_list_length (file_infos);
+  snapshot->entries = g_new (ThunarxFileInfoSnapshotEntry, snapshot->n_files);
+
+  arena = g_string_sized_new (snapshot->n_files * 128);
+
+  for (lp = file_infos, entry = snapshot->entries; lp != NULL; lp = lp->next, ++entry)
+    {
+      g_return_val_if_fail (THUNARX_IS_FILE_INFO (lp->data), NULL);
+
+      file_info = THUNARX_FILE_INFO (lp->data);
+      iface = THUNARX_FILE_INFO_GET_IFACE (file_info);
+
+      string = (*iface->get_uri) (file_info);
+      entry->uri = thunarx_file_info_snapshot_append (arena, string);
+      g_free (string);
+
+      if (iface->peek_name != NULL)
+        {
+          entry->name = thunarx_file_info_snapshot_append (arena, (*iface->peek_name) (file_info));
+        }
+      else
+        {
+          string = (*iface->get_name) (file_info);
+          entry->name = thunarx_file_info_snapshot_append (arena, string);
+          g_free (string);
+        }
+
+      if (iface->peek_mime_type != NULL)
+        {
+          entry->mime_type = thunarx_file_info_snapshot_append (arena, (*iface->peek_mime_type) (file_info));
+        }
+      else
+        {
+          string = (*iface->get_mime_type) (file_info);
+          entry->mime_type = thunarx_file_info_snapshot_append (arena, string);
+          g_free (string);
+        }
+
+      location = (*iface->get_location) (file_info);
+      entry->path = thunarx_file_info_snapshot_append (arena, g_file_peek_path (location));
+      g_object_unref (location);
+
+      entry->is_directory = (*iface->is_directory) (file_info);
+    }
+
+  snapshot->arena = g_string_free (arena, FALSE);
+
+  return snapshot;
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_ref:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ *
+ * Increases the reference count on @snapshot.
+ *
+ * Returns: (transfer full): @snapshot.
+ *
+ * Since: 4.20
+ **/
+ThunarxFileInfoSnapshot*
+thunarx_file_info_snapshot_ref (ThunarxFileInfoSnapshot *snapshot)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  g_atomic_int_inc (&snapshot->ref_count);
+
+  return snapshot;
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_unref:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ *
+ * Decreases the reference count on @snapshot and frees
+ * it once the last reference is dropped.
+ *
+ * Since: 4.20
+ **/
+void
+thunarx_file_info_snapshot_unref (ThunarxFileInfoSnapshot *snapshot)
+{
+  g_return_if_fail (snapshot != NULL);
+
+  if (g_atomic_int_dec_and_test (&snapshot->ref_count))
+    {
+      g_free (snapshot->entries);
+      g_free (snapshot->arena);
+      g_slice_free (ThunarxFileInfoSnapshot, snapshot);
+    }
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_get_n_files:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ *
+ * Returns: the number of files in @snapshot.
+ *
+ * Since: 4.20
+ **/
+guint
+thunarx_file_info_snapshot_get_n_files (const ThunarxFileInfoSnapshot *snapshot)
+{
+  g_return_val_if_fail (snapshot != NULL, 0);
+  return snapshot->n_files;
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_get_uri:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ * @n        : the index of the file.
+ *
+ * Returns: the URI of the @n<!---->th file, like thunarx_file_info_get_uri().
+ *          It is owned by @snapshot.
+ *
+ * Since: 4.20
+ **/
+const gchar*
+thunarx_file_info_snapshot_get_uri (const ThunarxFileInfoSnapshot *snapshot,
+                                    guint                          n)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (n < snapshot->n_files, NULL);
+  return thunarx_file_info_snapshot_lookup (snapshot, snapshot->entries[n].uri);
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_get_name:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ * @n        : the index of the file.
+ *
+ * Returns: the real name of the @n<!---->th file, like
+ *          thunarx_file_info_get_name(). It is owned by @snapshot.
+ *
+ * Since: 4.20
+ **/
+const gchar*
+thunarx_file_info_snapshot_get_name (const ThunarxFileInfoSnapshot *snapshot,
+                                     guint                          n)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (n < snapshot->n_files, NULL);
+  return thunarx_file_info_snapshot_lookup (snapshot, snapshot->entries[n].name);
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_get_mime_type:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ * @n        : the index of the file.
+ *
+ * Returns: (nullable): the MIME type of the @n<!---->th file, like
+ *          thunarx_file_info_get_mime_type(). It is owned by @snapshot.
+ *
+ * Since: 4.20
+ **/
+const gchar*
+thunarx_file_info_snapshot_get_mime_type (const ThunarxFileInfoSnapshot *snapshot,
+                                          guint                          n)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (n < snapshot->n_files, NULL);
+  return thunarx_file_info_snapshot_lookup (snapshot, snapshot->entries[n].mime_type);
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_get_path:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ * @n        : the index of the file.
+ *
+ * Returns: (nullable): the local path of the @n<!---->th file, or %NULL
+ *          if it has none. It is owned by @snapshot.
+ *
+ * Since: 4.20
+ **/
+const gchar*
+thunarx_file_info_snapshot_get_path (const ThunarxFileInfoSnapshot *snapshot,
+                                     guint                          n)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (n < snapshot->n_files, NULL);
+  return thunarx_file_info_snapshot_lookup (snapshot, snapshot->entries[n].path);
+}
+
+
+
+/**
+ * thunarx_file_info_snapshot_is_directory:
+ * @snapshot : a #ThunarxFileInfoSnapshot.
+ * @n        : the index of the file.
+ *
+ * Returns: %TRUE if the @n<!---->th file was a directory, like
+ *          thunarx_file_info_is_directory().
+ *
+ * Since: 4.20
+ **/
+gboolean
+thunarx_file_info_snapshot_is_directory (const ThunarxFileInfoSnapshot *snapshot,
+                                         guint                          n)
+{
+  g_return_val_if_fail (snapshot != NULL, FALSE);
+  g_return_val_if_fail (n < snapshot->n_files, FALSE);
+  return snapshot->entries[n].is_directory;
+}
@@ -82,6 +82,11 @@ typedef struct _ThunarxFileInfo      ThunarxFileInfo;
  * @get_file_info: See thunarx_file_info_get_file_info().
  * @get_filesystem_info: See thunarx_filesystem_info_get_filesystem_info().
  * @get_location: See thunarx_location_get_location().
+ * @peek_name: Returns the name like @get_name, without copying it. Optional,
+ *             used by thunarx_file_info_snapshot_new(). Since: 4.20
+ * @peek_mime_type: Returns the MIME type like @get_mime_type, without copying
+ *                  it. Optional, used by thunarx_file_info_snapshot_new().
+ *                  Since: 4.20
  * @changed: See thunarx_file_info_changed().
  * @renamed: See thunarx_file_info_renamed().
  *
@@ -113,9 +118,10 @@ struct _ThunarxFileInfoIface
   GFileInfo *(*get_filesystem_info) (ThunarxFileInfo *file_info);
   GFile     *(*get_location)        (ThunarxFileInfo *file_info);
 
+  const gchar *(*peek_name)         (ThunarxFileInfo *file_info);
+  const gchar *(*peek_mime_type)    (ThunarxFileInfo *file_info);
+
   /*< private >*/
-  void (*reserved0) (void);
-  void (*reserved1) (void);
   void (*reserved2) (void);
   void (*reserved3) (void);
   void (*reserved4) (void);
@@ -162,6 +168,29 @@ GType      thunarx_file_info_list_get_type       (void) G_GNUC_CONST;
 GList     *thunarx_file_info_list_copy           (GList           *file_infos);
 void       thunarx_file_info_list_free           (GList           *file_infos);
 
+
+typedef struct _ThunarxFileInfoSnapshot ThunarxFileInfoSnapshot;
+
+#define THUNARX_TYPE_FILE_INFO_SNAPSHOT (thunarx_file_info_snapshot_get_type ())
+
+GType                    thunarx_file_info_snapshot_get_type      (void) G_GNUC_CONST;
+
+ThunarxFileInfoSnapshot *thunarx_file_info_snapshot_new           (GList                         *file_infos) G_GNUC_MALLOC;
+ThunarxFileInfoSnapshot *thunarx_file_info_snapshot_ref           (ThunarxFileInfoSnapshot       *snapshot);
+void                     thunarx_file_info_snapshot_unref         (ThunarxFileInfoSnapshot       *snapshot);
+
+guint                    thunarx_file_info_snapshot_get_n_files   (const ThunarxFileInfoSnapshot *snapshot);
+const gchar             *thunarx_file_info_snapshot_get_uri       (const ThunarxFileInfoSnapshot *snapshot,
+                                                                   guint                          n);
+const gchar             *thunarx_file_info_snapshot_get_name      (const ThunarxFileInfoSnapshot *snapshot,
+                                                                   guint                          n);
+const gchar             *thunarx_file_info_snapshot_get_mime_type (const ThunarxFileInfoSnapshot *snapshot,
+                                                                   guint                          n);
+const gchar             *thunarx_file_info_snapshot_get_path      (const ThunarxFileInfoSnapshot *snapshot,
+                                                                   guint                          n);
+gboolean                 thunarx_file_info_snapshot_is_directory  (const ThunarxFileInfoSnapshot *snapshot,
+                                                                   guint                          n);
+
 G_END_DECLS
 
 #endif /* !__THUNARX_FILE_INFO_H__ */
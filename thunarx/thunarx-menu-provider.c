@@ -24,6 +24,7 @@
 
 #include <libxfce4util/libxfce4util.h>
 
+#include <thunarx/thunarx-menu.h>
 #include <thunarx/thunarx-menu-provider.h>
 #include <thunarx/thunarx-private.h>
 
@@ -53,6 +54,13 @@
  * menu items and menu items provided by other extensions. For example, the menu item provided
  * by the <systemitem class="library">ThunarOpenTerminal</systemitem> extension should be
  * called <literal>ThunarOpenTerminal::open-terminal</literal>.
+ *
+ * Extensions that can't avoid blocking work to find their file menu items,
+ * e.g. asking a version control system about the state of the files, can
+ * implement the <function>get_file_menu_items_async</function> and
+ * <function>get_file_menu_items_finish</function> methods instead. The file
+ * manager shows the menu right away and adds their menu items once they are
+ * ready, or leaves them out if they take too long.
  */
 
 GType
@@ -254,3 +262,97 @@ thunarx_menu_provider_get_dnd_menu_items (ThunarxMenuProvider *provider,
 
   return items;
 }
+
+
+
+/**
+ * thunarx_menu_provider_get_file_menu_items_async: (skip)
+ * @provider    : a #ThunarxMenuProvider.
+ * @window      : the #GtkWindow within which the menu items will be used.
+ * @files       : (element-type ThunarxFileInfo): the list of #ThunarxFileInfo<!---->s
+ *                to which the menu items will be applied.
+ * @cancellable : a #GCancellable or %NULL.
+ * @callback    : the function to call when the menu items are ready.
+ * @user_data   : data to pass to @callback.
+ *
+ * Asynchronous version of thunarx_menu_provider_get_file_menu_items(). Call
+ * thunarx_menu_provider_get_file_menu_items_finish() from @callback to get
+ * the menu items.
+ *
+ * Providers that only implement the synchronous method are queried right
+ * away and @callback is invoked from the main loop.
+ *
+ * Since: 4.20
+ **/
+void
+thunarx_menu_provider_get_file_menu_items_async (ThunarxMenuProvider *provider,
+                                                 GtkWidget           *window,
+                                                 GList               *files,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (THUNARX_IS_MENU_PROVIDER (provider));
+  g_return_if_fail (GTK_IS_WINDOW (window));
+  g_return_if_fail (files != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  if (THUNARX_MENU_PROVIDER_GET_IFACE (provider)->get_file_menu_items_async != NULL)
+    {
+      (*THUNARX_MENU_PROVIDER_GET_IFACE (provider)->get_file_menu_items_async) (provider, window, files,
+                                                                             cancellable, callback, user_data);
+    }
+  else
+    {
+      task = g_task_new (provider, cancellable, callback, user_data);
+      g_task_set_source_tag (task, thunarx_menu_provider_get_file_menu_items_async);
+      g_task_return_pointer (task, thunarx_menu_provider_get_file_menu_items (provider, window, files),
+                             (GDestroyNotify) thunarx_menu_item_list_free);
+      g_object_unref (task);
+    }
+}
+
+
+
+/**
+ * thunarx_menu_provider_get_file_menu_items_finish: (skip)
+ * @provider : a #ThunarxMenuProvider.
+ * @result   : the #GAsyncResult passed to the callback.
+ * @error    : return location for errors or %NULL.
+ *
+ * Finishes a call to thunarx_menu_provider_get_file_menu_items_async().
+ * Like thunarx_menu_provider_get_file_menu_items(), this takes a reference
+ * on @provider for every returned #ThunarxMenuItem.
+ *
+ * Returns: (transfer full) (element-type ThunarxMenuItem): the list of #ThunarxMenuItem<!---->s
+ *          that @provider has to offer, or %NULL if @error is set.
+ *
+ * Since: 4.20
+ **/
+GList*
+thunarx_menu_provider_get_file_menu_items_finish (ThunarxMenuProvider *provider,
+                                                  GAsyncResult        *result,
+                                                  GError             **error)
+{
+  GList *items;
+
+  g_return_val_if_fail (THUNARX_IS_MENU_PROVIDER (provider), NULL);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  /* the fallback already took the references */
+  if (g_async_result_is_tagged (result, thunarx_menu_provider_get_file_menu_items_async))
+    return g_task_propagate_pointer (G_TASK (result), error);
+
+  g_return_val_if_fail (THUNARX_MENU_PROVIDER_GET_IFACE (provider)->get_file_menu_items_finish != NULL, NULL);
+
+  /* collect the menu items from the implementation */
+  items = (*THUNARX_MENU_PROVIDER_GET_IFACE (provider)->get_file_menu_items_finish) (provider, result, error);
+
+  /* take a reference on the provider for each menu item */
+  thunarx_object_list_take_reference (items, provider);
+
+  return items;
+}
@@ -22,6 +22,10 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <gdk/gdk.h>
 
 #include <thunarx/thunarx-private.h>
@@ -72,10 +76,9 @@ struct _ThunarxProviderFactory
   ThunarxProviderInfo *infos;     /* provider types and cached provider references */
   gint                 n_infos;   /* number of items in the infos array */
 
-  guint                timer_id;  /* GSource timer to cleanup cached providers */
-
-  gint                 initialized;
+  GList               *modules;   /* modules whose types are in the infos array */
 
+  guint                timer_id;  /* GSource timer to cleanup cached providers */
 };
 
 static gboolean thunarx_provider_modules_created = FALSE;
@@ -102,7 +105,6 @@ thunarx_provider_factory_class_init (ThunarxProviderFactoryClass *klass)
 static void
 thunarx_provider_factory_init (ThunarxProviderFactory *factory)
 {
-  factory->initialized = FALSE;
 }
 
 
@@ -122,6 +124,7 @@ thunarx_provider_factory_finalize (GObject *object)
     if (factory->infos[n].provider != NULL)
       g_object_unref (factory->infos[n].provider);
   g_free (factory->infos);
+  g_list_free (factory->modules);
 
   (*G_OBJECT_CLASS (thunarx_provider_factory_parent_class)->finalize) (object);
 }
@@ -150,6 +153,35 @@ thunarx_provider_factory_add (ThunarxProviderFactory *factory,
 
 
 
+/* returns the interface names listed in the manifest of the plugin
+ * file name in directory, or NULL if it has no manifest */
+static gchar**
+thunarx_provider_factory_read_manifest (const gchar *directory,
+                                        const gchar *name)
+{
+  GKeyFile *key_file;
+  gchar    *basename;
+  gchar    *path;
+  gchar   **interfaces;
+
+  basename = g_strndup (name, strlen (name) - strlen ("." G_MODULE_SUFFIX));
+  path = g_strconcat (directory, G_DIR_SEPARATOR_S, basename, ".thunarx-plugin", NULL);
+
+  key_file = g_key_file_new ();
+  if (g_key_file_load_from_file (key_file, path, G_KEY_FILE_NONE, NULL))
+    interfaces = g_key_file_get_string_list (key_file, "Thunarx Plugin", "Interfaces", NULL, NULL);
+  else
+    interfaces = NULL;
+
+  g_key_file_free (key_file);
+  g_free (basename);
+  g_free (path);
+
+  return interfaces;
+}
+
+
+
 static void
 thunarx_provider_factory_create_modules (ThunarxProviderFactory *factory)
 {
@@ -198,6 +230,7 @@ thunarx_provider_factory_create_modules (ThunarxProviderFactory *factory)
 
                   /* allocate the new module and add it to our lists */
                   module = thunarx_provider_module_new (name);
+                  thunarx_provider_module_set_interfaces (module, thunarx_provider_factory_read_manifest (dirs[i], name));
                   thunarx_provider_modules = g_list_prepend (thunarx_provider_modules, module);
                 }
             }
@@ -299,48 +332,68 @@ GList*
 thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
                                          GType                   type)
 {
-  ThunarxProviderInfo *info;
-  GList               *providers = NULL;
-  GList               *lp;
-  gint                 n;
+  ThunarxProviderModule *module;
+  ThunarxProviderInfo   *info;
+  GList                 *providers = NULL;
+  GList                 *used = NULL;
+  GList                 *lp;
+  gint                   n;
 
   /* create all available modules */
   if (thunarx_provider_modules_created == FALSE)
     {
       thunarx_provider_factory_create_modules (factory);
+      thunarx_provider_modules_created = TRUE;
+    }
+
+  for (lp = thunarx_provider_modules; lp != NULL; lp = lp->next)
+    {
+      module = THUNARX_PROVIDER_MODULE (lp->data);
+
+      /* plugins with a manifest are only loaded once one of their interfaces is requested */
+      if (!thunarx_provider_module_provides (module, type))
+        continue;
 
-      /* On the first call, we need to load all modules once, since only when loaded, we can tell if they are persistent or volatile */
-      for (lp = thunarx_provider_modules; lp != NULL; lp = lp->next)
+      if (g_list_find (thunarx_persistent_provider_modules, module) != NULL)
+        {
+          /* persistent modules stay loaded */
+        }
+      else if (g_list_find (thunarx_volatile_provider_modules, module) != NULL)
+        {
+          /* volatile modules are reloaded on each call */
+          g_type_module_use (G_TYPE_MODULE (module));
+        }
+      else
         {
-          g_type_module_use (G_TYPE_MODULE (lp->data));
-          if (thunarx_provider_plugin_get_resident (THUNARX_PROVIDER_PLUGIN (lp->data)))
-              thunarx_persistent_provider_modules = g_list_prepend (thunarx_persistent_provider_modules, lp->data);
+          /* load the module once, since only when loaded, we can tell if it is persistent or volatile */
+          if (!g_type_module_use (G_TYPE_MODULE (module)))
+            {
+              /* don't try broken plugins again */
+              thunarx_provider_module_set_interfaces (module, g_new0 (gchar *, 1));
+              continue;
+            }
+          if (thunarx_provider_plugin_get_resident (THUNARX_PROVIDER_PLUGIN (module)))
+            thunarx_persistent_provider_modules = g_list_prepend (thunarx_persistent_provider_modules, module);
           else
-              thunarx_volatile_provider_modules = g_list_prepend (thunarx_volatile_provider_modules, lp->data);
+            thunarx_volatile_provider_modules = g_list_prepend (thunarx_volatile_provider_modules, module);
         }
 
-      thunarx_provider_modules_created = TRUE;
-    }
-  else
-    {
-      /* volatile modules are reloaded on each call */
-      for (lp = thunarx_volatile_provider_modules; lp != NULL; lp = lp->next)
-        g_type_module_use (G_TYPE_MODULE (lp->data));
+      /* add the types of the module on first use */
+      if (g_list_find (factory->modules, module) == NULL)
+        {
+          thunarx_provider_factory_add (factory, module);
+          factory->modules = g_list_prepend (factory->modules, module);
+        }
+
+      used = g_list_prepend (used, module);
     }
 
-  if (factory->initialized == FALSE)
+  if (G_UNLIKELY (factory->timer_id == 0))
     {
-      for (lp = thunarx_provider_modules; lp != NULL; lp = lp->next)
-        thunarx_provider_factory_add (factory, THUNARX_PROVIDER_MODULE (lp->data));
-
-      if (G_UNLIKELY (factory->timer_id == 0))
-        {
-          /* start the "provider cache" cleanup timer */
-          factory->timer_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNARX_PROVIDER_FACTORY_INTERVAL,
-                                                          thunarx_provider_factory_timer, factory,
-                                                          thunarx_provider_factory_timer_destroy);
-        }
-      factory->initialized = TRUE;
+      /* start the "provider cache" cleanup timer */
+      factory->timer_id = g_timeout_add_seconds_full (G_PRIORITY_LOW, THUNARX_PROVIDER_FACTORY_INTERVAL,
+                                                      thunarx_provider_factory_timer, factory,
+                                                      thunarx_provider_factory_timer_destroy);
     }
 
   /* determine all available providers for the type */
@@ -362,9 +415,65 @@ thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
         providers = g_list_append (providers, info->provider);
       }
 
-  /* unload all volatile modules */
-  for (lp = thunarx_volatile_provider_modules; lp != NULL; lp = lp->next)
-    g_type_module_unuse (G_TYPE_MODULE (lp->data));
+  /* unload the volatile modules used above */
+  for (lp = used; lp != NULL; lp = lp->next)
+    if (g_list_find (thunarx_volatile_provider_modules, lp->data) != NULL)
+      g_type_module_unuse (G_TYPE_MODULE (lp->data));
+  g_list_free (used);
+
+  return providers;
+}
+
+
+
+/**
+ * thunarx_provider_factory_load_module:
+ * @factory : a #ThunarxProviderFactory instance.
+ * @name    : the file name of the module, relative to the extension directories.
+ * @type    : the provider #GType.
+ *
+ * Loads the module @name, which does not have to be one of the modules
+ * returned by thunarx_provider_factory_list_providers(), e.g. a module
+ * in a subdirectory of the extension directories, and creates its
+ * providers of the given @type. The module stays loaded for the
+ * lifetime of the process.
+ *
+ * The caller is responsible to release the returned
+ * list of providers using code like this:
+ * <informalexample><programlisting>
+ * g_list_free_full (list, g_object_unref);
+ * </programlisting></informalexample>
+ *
+ * Returns: (transfer full) (element-type GObject): the providers for
+ *          @type of the module, or %NULL if it could not be loaded.
+ *
+ * Since: 4.20
+ **/
+GList*
+thunarx_provider_factory_load_module (ThunarxProviderFactory *factory,
+                                      const gchar            *name,
+                                      GType                   type)
+{
+  ThunarxProviderModule *module;
+  const GType           *types;
+  GList                 *providers = NULL;
+  gint                   n_types;
+
+  g_return_val_if_fail (THUNARX_IS_PROVIDER_FACTORY (factory), NULL);
+  g_return_val_if_fail (name != NULL, NULL);
+
+  module = thunarx_provider_module_new (name);
+  if (!g_type_module_use (G_TYPE_MODULE (module)))
+    {
+      g_object_unref (module);
+      return NULL;
+    }
+
+  /* the module is never unused, its types have to stay registered */
+  thunarx_provider_module_list_types (module, &types, &n_types);
+  for (; n_types-- > 0; ++types)
+    if (g_type_is_a (*types, type))
+      providers = g_list_append (providers, g_object_new (*types, NULL));
 
   return providers;
 }
@@ -46,6 +46,10 @@ ThunarxProviderFactory *thunarx_provider_factory_get_default    (void);
 GList                  *thunarx_provider_factory_list_providers (ThunarxProviderFactory *factory,
                                                                  GType                   type) G_GNUC_MALLOC;
 
+GList                  *thunarx_provider_factory_load_module    (ThunarxProviderFactory *factory,
+                                                                 const gchar            *name,
+                                                                 GType                   type) G_GNUC_MALLOC;
+
 G_END_DECLS
 
 #endif /* !__THUNARX_PROVIDER_FACTORY_H__ */
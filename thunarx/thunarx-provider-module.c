@@ -40,6 +40,7 @@ enum
 
 
 static void     thunarx_provider_module_plugin_init   (ThunarxProviderPluginIface  *iface);
+static void     thunarx_provider_module_finalize      (GObject                     *object);
 static void     thunarx_provider_module_get_property  (GObject                     *object,
                                                        guint                        prop_id,
                                                        GValue                      *value,
@@ -68,6 +69,9 @@ struct _ThunarxProviderModule
   GModule *library;
   gboolean resident;
 
+  /* interface names from the manifest of the plugin, NULL if it has none */
+  gchar  **interfaces;
+
   void (*initialize) (ThunarxProviderModule *module);
   void (*shutdown)   (void);
   void (*list_types) (const GType **types,
@@ -88,6 +92,7 @@ thunarx_provider_module_class_init (ThunarxProviderModuleClass *klass)
   GObjectClass     *gobject_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunarx_provider_module_finalize;
   gobject_class->get_property = thunarx_provider_module_get_property;
   gobject_class->set_property = thunarx_provider_module_set_property;
 
@@ -110,6 +115,17 @@ thunarx_provider_module_init (ThunarxProviderModule *module)
 
 
 
+static void
+thunarx_provider_module_finalize (GObject *object)
+{
+  ThunarxProviderModule *module = THUNARX_PROVIDER_MODULE (object);
+
+  g_strfreev (module->interfaces);
+
+  (*G_OBJECT_CLASS (thunarx_provider_module_parent_class)->finalize) (object);
+}
+
+
 
 static void
 thunarx_provider_module_plugin_init (ThunarxProviderPluginIface *iface)
@@ -318,3 +334,50 @@ thunarx_provider_module_list_types (const ThunarxProviderModule *module,
 
   (*module->list_types) (types, n_types);
 }
+
+
+
+/**
+ * thunarx_provider_module_set_interfaces:
+ * @module     : a #ThunarxProviderModule.
+ * @interfaces : (transfer full): %NULL-terminated array of interface
+ *               type names, or %NULL.
+ *
+ * Sets the names of the provider interfaces implemented by @module,
+ * as read from the manifest installed next to the plugin. Until one
+ * of them is requested, the plugin does not have to be loaded.
+ **/
+void
+thunarx_provider_module_set_interfaces (ThunarxProviderModule *module,
+                                        gchar                **interfaces)
+{
+  g_return_if_fail (THUNARX_IS_PROVIDER_MODULE (module));
+
+  g_strfreev (module->interfaces);
+  module->interfaces = interfaces;
+}
+
+
+
+/**
+ * thunarx_provider_module_provides:
+ * @module : a #ThunarxProviderModule.
+ * @type   : a provider interface #GType.
+ *
+ * Determines whether @module may provide types implementing @type.
+ * This is always the case for plugins without a manifest.
+ *
+ * Return value: %TRUE if @module has to be loaded to list the
+ *               providers of @type.
+ **/
+gboolean
+thunarx_provider_module_provides (const ThunarxProviderModule *module,
+                                  GType                        type)
+{
+  g_return_val_if_fail (THUNARX_IS_PROVIDER_MODULE (module), FALSE);
+
+  if (module->interfaces == NULL)
+    return TRUE;
+
+  return g_strv_contains ((const gchar * const *) module->interfaces, g_type_name (type));
+}
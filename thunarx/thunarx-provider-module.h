@@ -45,4 +45,9 @@ void                   thunarx_provider_module_list_types (const ThunarxProvider
                                                            const GType                **types,
                                                            gint                        *n_types);
 
+void                   thunarx_provider_module_set_interfaces (ThunarxProviderModule   *module,
+                                                               gchar                  **interfaces);
+gboolean               thunarx_provider_module_provides       (const ThunarxProviderModule *module,
+                                                               GType                        type);
+
 #endif /* !__THUNARX_PROVIDER_MODULE_H__ */
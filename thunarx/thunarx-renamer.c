@@ -37,6 +37,7 @@ enum
   PROP_0,
   PROP_HELP_URL,
   PROP_NAME,
+  PROP_THREAD_SAFE,
 };
 
 /* Signal identifiers */
@@ -102,8 +103,9 @@ static GList   *thunarx_renamer_real_get_menu_items  (ThunarxRenamer         *re
 
 struct _ThunarxRenamerPrivate
 {
-  gchar *help_url;
-  gchar *name;
+  gchar    *help_url;
+  gchar    *name;
+  gboolean  thread_safe;
 };
 
 
@@ -168,6 +170,23 @@ thunarx_renamer_class_init (ThunarxRenamerClass *klass)
                                                         NULL,
                                                         G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
 
+  /**
+   * ThunarxRenamer:thread-safe:
+   *
+   * Whether thunarx_renamer_process() may be invoked from
+   * several threads at the same time. Derived classes whose
+   * process method only reads the settings of the renamer and
+   * the #ThunarxFileInfo can set this property, so the file
+   * manager can compute the preview in parallel.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_THREAD_SAFE,
+                                   g_param_spec_boolean ("thread-safe",
+                                                         _("Thread safe"),
+                                                         _("Whether the renamer can process files from several threads"),
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
+
   /**
    * ThunarxRenamer::changed:
    * @renamer : a #ThunarxRenamer.
@@ -257,6 +276,10 @@ thunarx_renamer_get_property (GObject    *object,
       g_value_set_string (value, thunarx_renamer_get_name (renamer));
       break;
 
+    case PROP_THREAD_SAFE:
+      g_value_set_boolean (value, thunarx_renamer_get_thread_safe (renamer));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -283,6 +306,10 @@ thunarx_renamer_set_property (GObject      *object,
       thunarx_renamer_set_name (renamer, g_value_get_string (value));
       break;
 
+    case PROP_THREAD_SAFE:
+      thunarx_renamer_set_thread_safe (renamer, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -509,6 +536,58 @@ thunarx_renamer_set_name (ThunarxRenamer *renamer,
 
 
 
+/**
+ * thunarx_renamer_get_thread_safe:
+ * @renamer : a #ThunarxRenamer.
+ *
+ * Returns %TRUE if thunarx_renamer_process() may be
+ * invoked for @renamer from several threads at once.
+ *
+ * Return value: %TRUE if @renamer is thread-safe.
+ **/
+gboolean
+thunarx_renamer_get_thread_safe (ThunarxRenamer *renamer)
+{
+  g_return_val_if_fail (THUNARX_IS_RENAMER (renamer), FALSE);
+  return renamer->priv->thread_safe;
+}
+
+
+
+/**
+ * thunarx_renamer_set_thread_safe:
+ * @renamer     : a #ThunarxRenamer.
+ * @thread_safe : %TRUE if @renamer is thread-safe.
+ *
+ * Derived classes can call this method to declare that their
+ * process method may be invoked from several threads at once.
+ * The file manager never changes the settings of @renamer while
+ * such calls are running, but the method must not touch any
+ * widgets or other state that is not safe to share between
+ * threads.
+ **/
+void
+thunarx_renamer_set_thread_safe (ThunarxRenamer *renamer,
+                                 gboolean        thread_safe)
+{
+  g_return_if_fail (THUNARX_IS_RENAMER (renamer));
+
+  /* normalize the value */
+  thread_safe = !!thread_safe;
+
+  /* check if we have a new value */
+  if (G_LIKELY (renamer->priv->thread_safe != thread_safe))
+    {
+      /* apply the new value */
+      renamer->priv->thread_safe = thread_safe;
+
+      /* notify listeners */
+      g_object_notify (G_OBJECT (renamer), "thread-safe");
+    }
+}
+
+
+
 /**
  * thunarx_renamer_process:
  * @renamer : a #ThunarxRenamer.
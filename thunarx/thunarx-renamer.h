@@ -64,17 +64,17 @@ struct _ThunarxRenamerClass
   /*< public >*/
 
   /* virtual methods */
-  gchar *(*process)        (ThunarxRenamer  *renamer,
+  gchar *(*process)        (ThunarxRenamer   *renamer,
                             ThunarxFileInfo *file,
                             const gchar     *text,
                             guint            index);
 
-  void   (*load)           (ThunarxRenamer  *renamer,
+  void   (*load)           (ThunarxRenamer   *renamer,
                             GHashTable      *settings);
-  void   (*save)           (ThunarxRenamer  *renamer,
+  void   (*save)           (ThunarxRenamer   *renamer,
                             GHashTable      *settings);
 
-  GList *(*get_menu_items) (ThunarxRenamer  *renamer,
+  GList *(*get_menu_items) (ThunarxRenamer   *renamer,
                             GtkWindow       *window,
                             GList           *files);
 
@@ -104,31 +104,35 @@ struct _ThunarxRenamer
   ThunarxRenamerPrivate *priv;
 };
 
-GType        thunarx_renamer_get_type       (void) G_GNUC_CONST;
+GType        thunarx_renamer_get_type        (void) G_GNUC_CONST;
 
-const gchar *thunarx_renamer_get_help_url   (ThunarxRenamer   *renamer);
-void         thunarx_renamer_set_help_url   (ThunarxRenamer   *renamer,
-                                             const gchar      *help_url);
+const gchar *thunarx_renamer_get_help_url    (ThunarxRenamer   *renamer);
+void         thunarx_renamer_set_help_url    (ThunarxRenamer   *renamer,
+                                              const gchar      *help_url);
 
-const gchar *thunarx_renamer_get_name       (ThunarxRenamer   *renamer);
-void         thunarx_renamer_set_name       (ThunarxRenamer   *renamer,
-                                             const gchar      *name);
+const gchar *thunarx_renamer_get_name        (ThunarxRenamer   *renamer);
+void         thunarx_renamer_set_name        (ThunarxRenamer   *renamer,
+                                              const gchar      *name);
 
-gchar       *thunarx_renamer_process        (ThunarxRenamer   *renamer,
-                                             ThunarxFileInfo  *file,
-                                             const gchar      *text,
-                                             guint             index) G_GNUC_MALLOC;
+gboolean     thunarx_renamer_get_thread_safe (ThunarxRenamer   *renamer);
+void         thunarx_renamer_set_thread_safe (ThunarxRenamer   *renamer,
+                                              gboolean          thread_safe);
 
-void         thunarx_renamer_load           (ThunarxRenamer   *renamer,
-                                             GHashTable       *settings);
-void         thunarx_renamer_save           (ThunarxRenamer   *renamer,
-                                             GHashTable       *settings);
+gchar       *thunarx_renamer_process         (ThunarxRenamer   *renamer,
+                                              ThunarxFileInfo  *file,
+                                              const gchar      *text,
+                                              guint             index) G_GNUC_MALLOC;
 
-GList       *thunarx_renamer_get_menu_items (ThunarxRenamer   *renamer,
-                                             GtkWindow        *window,
-                                             GList            *files) G_GNUC_MALLOC;
+void         thunarx_renamer_load            (ThunarxRenamer   *renamer,
+                                              GHashTable       *settings);
+void         thunarx_renamer_save            (ThunarxRenamer   *renamer,
+                                              GHashTable       *settings);
 
-void         thunarx_renamer_changed        (ThunarxRenamer   *renamer);
+GList       *thunarx_renamer_get_menu_items  (ThunarxRenamer   *renamer,
+                                              GtkWindow        *window,
+                                              GList            *files) G_GNUC_MALLOC;
+
+void         thunarx_renamer_changed         (ThunarxRenamer   *renamer);
 
 G_END_DECLS
 